@@ -38,6 +38,7 @@
 #include "mx-enum-types.h"
 #include "mx-marshal.h"
 #include "mx-private.h"
+#include "mx-worker-pool.h"
 
 G_DEFINE_TYPE (MxActorManager, mx_actor_manager, G_TYPE_OBJECT)
 
@@ -77,23 +78,56 @@ typedef enum
   MX_ACTOR_MANAGER_UNREF
 } MxActorManagerOperationType;
 
+typedef struct _MxActorManagerPrepareJob MxActorManagerPrepareJob;
+
 typedef struct
 {
   MxActorManager              *manager;
   gulong                       id;
   MxActorManagerOperationType  type;
+  gint                         priority;
 
   MxActorManagerCreateFunc     create_func;
   gpointer                     userdata;
+  GDestroyNotify               destroy_func;
 
   ClutterActor                *actor;
   ClutterActor                *container;
+
+  /* the links to the operation in the queues of @actor and @container in
+   * actor_op_links */
+  GList                       *actor_link;
+  GList                       *container_link;
+
+  /* set while the prepare function of a creation runs */
+  MxActorManagerPrepareJob    *prepare_job;
 } MxActorManagerOperation;
 
+/* The preparation of a creation on a worker thread. When the operation is
+ * freed before it completes, the job takes over its user data and frees it
+ * once the worker is done with it. */
+struct _MxActorManagerPrepareJob
+{
+  MxActorManager            *manager;
+  MxActorManagerOperation   *op;
+
+  MxActorManagerPrepareFunc  prepare_func;
+  gpointer                   userdata;
+  GDestroyNotify             destroy_func;
+
+  GCancellable              *cancellable;
+  guint                      worker_id;
+};
+
 struct _MxActorManagerPrivate
 {
   GQueue       *ops;
 
+  /* the links in @ops, by operation id */
+  GHashTable   *op_ids;
+
+  /* a queue of the links in @ops of the operations on each actor, as the
+   * actor or the container */
   GHashTable   *actor_op_links;
 
   guint         source;
@@ -102,6 +136,10 @@ struct _MxActorManagerPrivate
   GTimer       *timer;
   guint         time_slice;
 
+  /* when the stage last started painting while operations were pending */
+  gint64        frame_start;
+  gulong        next_id;
+
   ClutterStage *stage;
 
   guint         quark_set   : 1;
@@ -111,15 +149,20 @@ static guint signals[LAST_SIGNAL] = { 0, };
 
 static void mx_actor_manager_handle_op (MxActorManager *manager);
 
-static guint mx_actor_manager_increment_count (MxActorManager *manager,
-                                               gpointer        actor,
-                                               GList          *op_link);
+static GList *mx_actor_manager_increment_count (MxActorManager *manager,
+                                                gpointer        actor,
+                                                GList          *op_link);
 static guint mx_actor_manager_decrement_count (MxActorManager *manager,
                                                gpointer        actor,
-                                               GList          *op_link);
+                                               GList          *actor_link);
 
 static void mx_actor_manager_ensure_processing (MxActorManager *manager);
 
+/* The time kept free before the next frame is due, and the least spent on
+ * operations after a frame however late it is, in ms */
+#define MX_ACTOR_MANAGER_FRAME_MARGIN 2
+#define MX_ACTOR_MANAGER_MIN_SLICE    1
+
 static void
 mx_actor_manager_get_property (GObject    *object,
                                guint       property_id,
@@ -222,23 +265,13 @@ mx_actor_manager_dispose (GObject *object)
   G_OBJECT_CLASS (mx_actor_manager_parent_class)->dispose (object);
 }
 
-static void
-mx_actor_manager_free_op_links (gpointer key,
-                                gpointer value,
-                                gpointer userdata)
-{
-  g_list_free (value);
-}
-
 static void
 mx_actor_manager_finalize (GObject *object)
 {
   MxActorManagerPrivate *priv = MX_ACTOR_MANAGER (object)->priv;
 
   g_queue_free (priv->ops);
-  g_hash_table_foreach (priv->actor_op_links,
-                        mx_actor_manager_free_op_links,
-                        NULL);
+  g_hash_table_unref (priv->op_ids);
   g_hash_table_unref (priv->actor_op_links);
   g_timer_destroy (priv->timer);
 
@@ -267,7 +300,7 @@ mx_actor_manager_class_init (MxActorManagerClass *klass)
 
   pspec = g_param_spec_uint ("time-slice",
                              "Time slice",
-                             "The amount of time to spend performing "
+                             "The most time to spend performing "
                              "operations, per frame, in ms",
                              0, G_MAXUINT, 5,
                              MX_PARAM_READWRITE);
@@ -430,7 +463,9 @@ mx_actor_manager_init (MxActorManager *self)
   MxActorManagerPrivate *priv = self->priv = ACTOR_MANAGER_PRIVATE (self);
 
   priv->ops = g_queue_new ();
-  priv->actor_op_links = g_hash_table_new (NULL, NULL);
+  priv->op_ids = g_hash_table_new (NULL, NULL);
+  priv->actor_op_links = g_hash_table_new_full (NULL, NULL, NULL,
+                                                (GDestroyNotify) g_queue_free);
   priv->timer = g_timer_new ();
   priv->time_slice = 5;
 }
@@ -507,43 +542,48 @@ mx_actor_manager_get_stage (MxActorManager *manager)
   return manager->priv->stage;
 }
 
-static guint
+/* adds @op_link to the operations on @actor, and returns its link there */
+static GList *
 mx_actor_manager_increment_count (MxActorManager *manager,
                                   gpointer        actor,
                                   GList          *op_link)
 {
-  GList *op_links;
+  GQueue *op_links;
   MxActorManagerPrivate *priv = manager->priv;
 
   op_links = g_hash_table_lookup (priv->actor_op_links, actor);
-  op_links = g_list_prepend (op_links, op_link);
+  if (!op_links)
+    {
+      op_links = g_queue_new ();
+      g_hash_table_insert (priv->actor_op_links, actor, op_links);
+    }
 
-  g_hash_table_insert (priv->actor_op_links, actor, op_links);
+  g_queue_push_head (op_links, op_link);
 
-  return g_list_length (op_links);
+  return g_queue_peek_head_link (op_links);
 }
 
+/* removes @actor_link from the operations on @actor, and returns the
+ * number of them left */
 static guint
 mx_actor_manager_decrement_count (MxActorManager *manager,
                                   gpointer        actor,
-                                  GList          *op_link)
+                                  GList          *actor_link)
 {
   guint count;
-  GList *op_links;
+  GQueue *op_links;
   MxActorManagerPrivate *priv = manager->priv;
 
   op_links = g_hash_table_lookup (priv->actor_op_links, actor);
-  op_links = g_list_remove (op_links, op_link);
+  g_queue_delete_link (op_links, actor_link);
 
-  count = g_list_length (op_links);
+  count = g_queue_get_length (op_links);
 
   if (count == 0)
     {
       g_hash_table_remove (priv->actor_op_links, actor);
       g_signal_emit (manager, signals[ACTOR_FINISHED], 0, actor);
     }
-  else
-    g_hash_table_insert (priv->actor_op_links, actor, op_links);
 
   return count;
 }
@@ -570,6 +610,30 @@ mx_actor_manager_container_destroyed (gpointer  data,
   op->container = NULL;
 }
 
+/* inserts @op_link in the queue after the operations of the same or a
+ * higher priority. The link itself is kept, as it is what the actors
+ * refer to in actor_op_links */
+static void
+mx_actor_manager_queue_op_link (MxActorManager *manager,
+                                GList          *op_link)
+{
+  MxActorManagerPrivate *priv = manager->priv;
+  MxActorManagerOperation *op = op_link->data;
+  GList *l;
+  gint n;
+
+  n = g_queue_get_length (priv->ops);
+  for (l = g_queue_peek_tail_link (priv->ops); l; l = l->prev, n--)
+    {
+      MxActorManagerOperation *queued = l->data;
+
+      if (queued->priority <= op->priority)
+        break;
+    }
+
+  g_queue_push_nth_link (priv->ops, n, op_link);
+}
+
 static MxActorManagerOperation *
 mx_actor_manager_op_new (MxActorManager              *manager,
                          MxActorManagerOperationType  type,
@@ -584,26 +648,31 @@ mx_actor_manager_op_new (MxActorManager              *manager,
 
   op->manager = manager;
 
-  if (g_queue_peek_tail (priv->ops))
-    op->id = ((MxActorManagerOperation *)g_queue_peek_tail (priv->ops))->id + 1;
-  else
-    op->id = 1;
+  /* the queue is ordered by priority, so the last operation does not
+   * always have the highest id */
+  op->id = ++priv->next_id;
+  if (G_UNLIKELY (op->id == 0))
+    op->id = ++priv->next_id;
 
   op->type = type;
+  op->priority = G_PRIORITY_DEFAULT;
   op->create_func = create_func;
   op->userdata = userdata;
   op->actor = actor;
   op->container = container;
 
-  g_queue_push_tail (priv->ops, op);
-  op_link = g_queue_peek_tail_link (priv->ops);
+  op_link = g_list_alloc ();
+  op_link->data = op;
+  mx_actor_manager_queue_op_link (manager, op_link);
+  g_hash_table_insert (priv->op_ids, GSIZE_TO_POINTER (op->id), op_link);
 
   if (actor)
     {
       g_object_weak_ref (G_OBJECT (actor),
                          mx_actor_manager_actor_destroyed,
                          op);
-      mx_actor_manager_increment_count (manager, actor, op_link);
+      op->actor_link =
+        mx_actor_manager_increment_count (manager, actor, op_link);
 
       if (type == MX_ACTOR_MANAGER_ADD)
         g_object_ref_sink (actor);
@@ -614,7 +683,8 @@ mx_actor_manager_op_new (MxActorManager              *manager,
       g_object_weak_ref (G_OBJECT (container),
                          mx_actor_manager_container_destroyed,
                          op);
-      mx_actor_manager_increment_count (manager, container, op_link);
+      op->container_link =
+        mx_actor_manager_increment_count (manager, container, op_link);
     }
 
   return op;
@@ -630,7 +700,7 @@ mx_actor_manager_op_free (MxActorManager *manager,
 
   if (op->actor)
     {
-      mx_actor_manager_decrement_count (manager, op->actor, op_link);
+      mx_actor_manager_decrement_count (manager, op->actor, op->actor_link);
       g_object_weak_unref (G_OBJECT (op->actor),
                            mx_actor_manager_actor_destroyed,
                            op);
@@ -641,12 +711,29 @@ mx_actor_manager_op_free (MxActorManager *manager,
 
   if (op->container)
     {
-      mx_actor_manager_decrement_count (manager, op->container, op_link);
+      mx_actor_manager_decrement_count (manager, op->container,
+                                        op->container_link);
       g_object_weak_unref (G_OBJECT (op->container),
                            mx_actor_manager_container_destroyed,
                            op);
     }
 
+  g_hash_table_remove (priv->op_ids, GSIZE_TO_POINTER (op->id));
+
+  if (op->prepare_job)
+    {
+      MxActorManagerPrepareJob *job = op->prepare_job;
+
+      job->op = NULL;
+      job->destroy_func = op->destroy_func;
+      op->destroy_func = NULL;
+
+      g_cancellable_cancel (job->cancellable);
+    }
+
+  if (op->destroy_func)
+    op->destroy_func (op->userdata);
+
   if (_remove)
     g_queue_delete_link (priv->ops, op_link);
 
@@ -662,9 +749,13 @@ mx_actor_manager_handle_op (MxActorManager *manager)
   GError *error = NULL;
   MxActorManagerPrivate *priv = manager->priv;
   GList *op_link = g_queue_peek_head_link (priv->ops);
+  MX_TRACE_BEGIN (mx_actor_manager_handle_op);
 
   if (!op_link)
-    return;
+    {
+      MX_TRACE_END (mx_actor_manager_handle_op);
+      return;
+    }
 
   op = op_link->data;
 
@@ -766,6 +857,8 @@ mx_actor_manager_handle_op (MxActorManager *manager)
     g_object_unref (op->container);
 
   mx_actor_manager_op_free (manager, op_link, TRUE);
+
+  MX_TRACE_END (mx_actor_manager_handle_op);
 }
 
 static void
@@ -777,38 +870,108 @@ mx_actor_manager_post_paint_cb (ClutterActor   *stage,
   g_signal_handler_disconnect (stage, priv->post_paint_handler);
   priv->post_paint_handler = 0;
 
+  /* the idle runs once the frame is painted and presented, so the time
+   * since this is what the frame cost */
+  priv->frame_start = g_get_monotonic_time ();
+
   mx_actor_manager_ensure_processing (manager);
 }
 
+/* Returns the time that may be spent on operations now, in ms: the time
+ * slice, reduced to what is left before the next frame is due when
+ * processing after a frame that was painted */
+static gdouble
+mx_actor_manager_get_budget (MxActorManager *manager)
+{
+  MxActorManagerPrivate *priv = manager->priv;
+  gdouble frame_time, spent, budget;
+  MxWindow *window;
+  gint64 interval;
+  guint rate;
+
+  if (!priv->frame_start)
+    return priv->time_slice;
+
+  /* prefer the rate the window system is really presenting at */
+  window = priv->stage ? mx_window_get_for_stage (priv->stage) : NULL;
+  interval = window ? _mx_window_get_frame_interval (window) : 0;
+
+  if (interval > 0)
+    frame_time = interval / 1000.0;
+  else
+    {
+      rate = clutter_get_default_frame_rate ();
+      frame_time = 1000.0 / MAX (1, rate);
+    }
+  spent = (g_get_monotonic_time () - priv->frame_start) / 1000.0;
+  priv->frame_start = 0;
+
+  budget = frame_time - spent - MX_ACTOR_MANAGER_FRAME_MARGIN;
+
+  return CLAMP (budget, MIN (MX_ACTOR_MANAGER_MIN_SLICE, priv->time_slice),
+                priv->time_slice);
+}
+
+/* whether the next operation is waiting for its preparation */
+static gboolean
+mx_actor_manager_is_preparing (MxActorManager *manager)
+{
+  MxActorManagerOperation *op = g_queue_peek_head (manager->priv->ops);
+
+  return op && op->prepare_job;
+}
+
 static gboolean
 mx_actor_manager_process_operations (MxActorManager *manager)
 {
   MxActorManagerPrivate *priv = manager->priv;
+  gdouble budget;
+  gint64 start;
 
   priv->source = 0;
 
+  budget = mx_actor_manager_get_budget (manager);
+
+  start = _mx_frame_stats_begin (MX_FRAME_STATS_ACTOR_MANAGER);
   g_timer_start (priv->timer);
 
   while (!g_queue_is_empty (priv->ops))
     {
+      /* operations are performed in order, so the rest waits until the
+       * preparation completes, which resumes processing */
+      if (mx_actor_manager_is_preparing (manager))
+        break;
+
       mx_actor_manager_handle_op (manager);
 
       if (priv->stage &&
-          g_timer_elapsed (priv->timer, NULL) * 1000 >= priv->time_slice)
+          g_timer_elapsed (priv->timer, NULL) * 1000 >= budget)
         break;
     }
 
   g_timer_stop (priv->timer);
+  _mx_frame_stats_end (MX_FRAME_STATS_ACTOR_MANAGER, start);
 
-  if (!g_queue_is_empty (priv->ops))
+  /* operations queued by the ones handled above wait for the next frame
+   * too, rather than for another idle */
+  if (priv->source)
     {
+      g_source_remove (priv->source);
+      priv->source = 0;
+    }
+
+  if (!g_queue_is_empty (priv->ops) &&
+      !mx_actor_manager_is_preparing (manager))
+    {
+      /* the rest is handled after the next frame has been painted, so that
+       * each frame only spends the time slice on them */
       if (!priv->post_paint_handler)
         priv->post_paint_handler =
           g_signal_connect (priv->stage, "paint",
                             G_CALLBACK (mx_actor_manager_post_paint_cb),
                             manager);
 
-      return TRUE;
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (priv->stage));
     }
 
   return FALSE;
@@ -861,6 +1024,93 @@ mx_actor_manager_create_actor (MxActorManager           *manager,
                                 userdata,
                                 NULL,
                                 NULL);
+  op->destroy_func = destroy_func;
+
+  mx_actor_manager_ensure_processing (manager);
+
+  return op->id;
+}
+
+static void
+mx_actor_manager_prepare_thread_func (MxActorManagerPrepareJob *job)
+{
+  job->prepare_func (job->userdata);
+}
+
+static void
+mx_actor_manager_prepare_complete_func (MxActorManagerPrepareJob *job)
+{
+  if (job->op)
+    {
+      job->op->prepare_job = NULL;
+      mx_actor_manager_ensure_processing (job->manager);
+    }
+  else if (job->destroy_func)
+    job->destroy_func (job->userdata);
+
+  g_object_unref (job->cancellable);
+  g_slice_free (MxActorManagerPrepareJob, job);
+}
+
+/**
+ * mx_actor_manager_create_actor_prepared:
+ * @manager: A #MxActorManager
+ * @prepare_func: (scope notified): A function to run on a worker thread
+ *   before @create_func
+ * @create_func: (scope notified): A #ClutterActor creation function
+ * @userdata: data to be passed to the functions, or %NULL
+ * @destroy_func: callback to invoke before the operation is removed
+ *
+ * Creates a #ClutterActor as mx_actor_manager_create_actor() does, but
+ * first runs @prepare_func on a worker thread of the default
+ * #MxWorkerPool, so that the work that does not involve actors, such as
+ * parsing or decoding, is done off the main thread. @prepare_func stores
+ * its result in @userdata, where @create_func finds it.
+ *
+ * The preparation starts straight away; operations are still performed
+ * in order, so those queued after this one wait for its preparation.
+ * @destroy_func is never called while @prepare_func runs, even if the
+ * operation is cancelled.
+ *
+ * Returns: The ID for this operation.
+ *
+ * Since: 2.0
+ */
+gulong
+mx_actor_manager_create_actor_prepared (MxActorManager            *manager,
+                                        MxActorManagerPrepareFunc  prepare_func,
+                                        MxActorManagerCreateFunc   create_func,
+                                        gpointer                   userdata,
+                                        GDestroyNotify             destroy_func)
+{
+  MxActorManagerOperation *op;
+  MxActorManagerPrepareJob *job;
+
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  g_return_val_if_fail (prepare_func != NULL, 0);
+  g_return_val_if_fail (create_func != NULL, 0);
+
+  op = mx_actor_manager_op_new (manager,
+                                MX_ACTOR_MANAGER_CREATE,
+                                create_func,
+                                userdata,
+                                NULL,
+                                NULL);
+  op->destroy_func = destroy_func;
+
+  job = g_slice_new0 (MxActorManagerPrepareJob);
+  job->manager = manager;
+  job->op = op;
+  job->prepare_func = prepare_func;
+  job->userdata = userdata;
+  job->cancellable = g_cancellable_new ();
+  op->prepare_job = job;
+
+  job->worker_id =
+    mx_worker_pool_push (mx_worker_pool_get_default (), op->priority,
+                         (MxWorkerFunc) mx_actor_manager_prepare_thread_func,
+                         (MxWorkerFunc) mx_actor_manager_prepare_complete_func,
+                         job, job->cancellable);
 
   mx_actor_manager_ensure_processing (manager);
 
@@ -949,6 +1199,100 @@ mx_actor_manager_remove_actor (MxActorManager   *manager,
   return op->id;
 }
 
+/**
+ * mx_actor_manager_add_actors:
+ * @manager: A #MxActorManager
+ * @container: A #ClutterActor
+ * @actors: (element-type Clutter.Actor): a list of #ClutterActor<!-- -->s
+ *
+ * Adds each of @actors to @container, in order, as
+ * mx_actor_manager_add_actor() would. The operations are given
+ * consecutive IDs, starting with the one returned.
+ *
+ * Returns: The ID for the operation on the first actor, or 0 if @actors is
+ *   empty.
+ *
+ * Since: 2.0
+ */
+gulong
+mx_actor_manager_add_actors (MxActorManager *manager,
+                             ClutterActor   *container,
+                             GList          *actors)
+{
+  gulong first_id = 0;
+  GList *l;
+
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  g_return_val_if_fail (CLUTTER_IS_CONTAINER (container), 0);
+
+  for (l = actors; l; l = l->next)
+    {
+      MxActorManagerOperation *op;
+
+      g_return_val_if_fail (CLUTTER_IS_ACTOR (l->data), first_id);
+
+      op = mx_actor_manager_op_new (manager,
+                                    MX_ACTOR_MANAGER_ADD,
+                                    NULL,
+                                    NULL,
+                                    l->data,
+                                    container);
+      if (!first_id)
+        first_id = op->id;
+    }
+
+  mx_actor_manager_ensure_processing (manager);
+
+  return first_id;
+}
+
+/**
+ * mx_actor_manager_remove_actors:
+ * @manager: A #MxActorManager
+ * @container: A #ClutterActor
+ * @actors: (element-type Clutter.Actor): a list of #ClutterActor<!-- -->s
+ *
+ * Removes each of @actors from @container, in order, as
+ * mx_actor_manager_remove_actor() would. The operations are given
+ * consecutive IDs, starting with the one returned.
+ *
+ * Returns: The ID for the operation on the first actor, or 0 if @actors is
+ *   empty.
+ *
+ * Since: 2.0
+ */
+gulong
+mx_actor_manager_remove_actors (MxActorManager *manager,
+                                ClutterActor   *container,
+                                GList          *actors)
+{
+  gulong first_id = 0;
+  GList *l;
+
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  g_return_val_if_fail (CLUTTER_IS_CONTAINER (container), 0);
+
+  for (l = actors; l; l = l->next)
+    {
+      MxActorManagerOperation *op;
+
+      g_return_val_if_fail (CLUTTER_IS_ACTOR (l->data), first_id);
+
+      op = mx_actor_manager_op_new (manager,
+                                    MX_ACTOR_MANAGER_REMOVE,
+                                    NULL,
+                                    NULL,
+                                    l->data,
+                                    container);
+      if (!first_id)
+        first_id = op->id;
+    }
+
+  mx_actor_manager_ensure_processing (manager);
+
+  return first_id;
+}
+
 /**
  * mx_actor_manager_remove_container:
  * @manager: A #MxActorManager
@@ -1010,16 +1354,6 @@ mx_actor_manager_remove_container (MxActorManager *manager,
   mx_actor_manager_ensure_processing (manager);
 }
 
-static gint
-mx_actor_manager_find_by_id (gconstpointer a,
-                             gconstpointer b)
-{
-  const MxActorManagerOperation *op = a;
-  const gulong *id = b;
-
-  return (op->id == *id) ? 0 : -1;
-}
-
 /**
  * mx_actor_manager_cancel_operation:
  * @manager: A #MxActorManager
@@ -1043,7 +1377,7 @@ mx_actor_manager_cancel_operation (MxActorManager *manager,
 
   priv = manager->priv;
 
-  op_link = g_queue_find_custom (priv->ops, &id, mx_actor_manager_find_by_id);
+  op_link = g_hash_table_lookup (priv->op_ids, GSIZE_TO_POINTER (id));
 
   if (!op_link)
     {
@@ -1064,7 +1398,11 @@ mx_actor_manager_cancel_operation (MxActorManager *manager,
  * @manager: A #MxActorManager
  * @actor: A #ClutterActor
  *
- * Cancels all operations associated with the given actor.
+ * Cancels all operations associated with the given actor, whether as the
+ * actor or as the container they operate on; for example, cancelling the
+ * operations of a container cancels all the additions to it that are
+ * still queued. Only those operations are looked at, however long the
+ * queue is.
  *
  * Since: 1.2
  */
@@ -1072,7 +1410,7 @@ void
 mx_actor_manager_cancel_operations (MxActorManager *manager,
                                     ClutterActor   *actor)
 {
-  GList *op_links;
+  GQueue *op_links;
   MxActorManagerPrivate *priv;
 
   g_return_if_fail (MX_IS_ACTOR_MANAGER (manager));
@@ -1080,14 +1418,12 @@ mx_actor_manager_cancel_operations (MxActorManager *manager,
 
   priv = manager->priv;
 
-  op_links = g_hash_table_lookup (priv->actor_op_links, actor);
-  while (op_links)
+  /* freeing the last operation on @actor removes its queue */
+  while ((op_links = g_hash_table_lookup (priv->actor_op_links, actor)))
     {
-      GList *op_link = op_links->data;
+      GList *op_link = g_queue_peek_head (op_links);
       MxActorManagerOperation *op = op_link->data;
 
-      op_links = op_links->next;
-
       g_queue_unlink (priv->ops, op_link);
 
       g_signal_emit (manager, signals[OP_CANCELLED], 0, op->id);
@@ -1097,13 +1433,63 @@ mx_actor_manager_cancel_operations (MxActorManager *manager,
     }
 }
 
+/**
+ * mx_actor_manager_set_priority:
+ * @manager: A #MxActorManager
+ * @id: An operation ID
+ * @priority: the priority of the operation, as for #GSource priorities
+ *
+ * Sets the priority of the given operation, if it exists. Operations
+ * with a lower value are performed first, so that for example the actors
+ * that can be seen are created before the others. Operations of the same
+ * priority are performed in the order they were queued, and all
+ * operations start with %G_PRIORITY_DEFAULT.
+ *
+ * Since: 2.0
+ */
+void
+mx_actor_manager_set_priority (MxActorManager *manager,
+                               gulong          id,
+                               gint            priority)
+{
+  MxActorManagerOperation *op;
+  MxActorManagerPrivate *priv;
+  GList *op_link;
+
+  g_return_if_fail (MX_IS_ACTOR_MANAGER (manager));
+  g_return_if_fail (id > 0);
+
+  priv = manager->priv;
+
+  op_link = g_hash_table_lookup (priv->op_ids, GSIZE_TO_POINTER (id));
+
+  if (!op_link)
+    {
+      g_warning (G_STRLOC ": Unknown operation (%lu)", id);
+      return;
+    }
+
+  op = op_link->data;
+  if (op->priority == priority)
+    return;
+
+  g_queue_unlink (priv->ops, op_link);
+  op->priority = priority;
+  mx_actor_manager_queue_op_link (manager, op_link);
+
+  if (op->prepare_job)
+    mx_worker_pool_set_priority (mx_worker_pool_get_default (),
+                                 op->prepare_job->worker_id, priority);
+}
+
 /**
  * mx_actor_manager_set_time_slice:
  * @manager: A #MxActorManager
  * @msecs: A time, in milliseconds
  *
- * Sets the amount of time the actor manager will spend performing operations,
- * before yielding to allow any necessary redrawing to occur.
+ * Sets the most time the actor manager will spend performing operations,
+ * before yielding to allow any necessary redrawing to occur. After a frame
+ * is painted, less than that is spent if the next frame is due sooner.
  *
  * Lower times will lead to smoother performance, but will increase the amount
  * of time it takes for operations to complete.
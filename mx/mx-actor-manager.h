@@ -57,6 +57,18 @@ typedef struct _MxActorManagerPrivate MxActorManagerPrivate;
 typedef ClutterActor * (*MxActorManagerCreateFunc) (MxActorManager *manager,
                                                     gpointer        userdata);
 
+/**
+ * MxActorManagerPrepareFunc:
+ * @userdata: the data passed to mx_actor_manager_create_actor_prepared()
+ *
+ * The type of the functions that prepare the creation of an actor on a
+ * worker thread, storing what they produce in @userdata. They must not
+ * touch any actors or textures.
+ *
+ * Since: 2.0
+ */
+typedef void (*MxActorManagerPrepareFunc) (gpointer userdata);
+
 typedef enum
 {
   MX_ACTOR_MANAGER_CONTAINER_DESTROYED,
@@ -121,6 +133,12 @@ gulong mx_actor_manager_create_actor (MxActorManager           *manager,
                                       gpointer                  userdata,
                                       GDestroyNotify            destroy_func);
 
+gulong mx_actor_manager_create_actor_prepared (MxActorManager            *manager,
+                                               MxActorManagerPrepareFunc  prepare_func,
+                                               MxActorManagerCreateFunc   create_func,
+                                               gpointer                   userdata,
+                                               GDestroyNotify             destroy_func);
+
 gulong mx_actor_manager_add_actor (MxActorManager *manager,
                                    ClutterActor   *container,
                                    ClutterActor   *actor);
@@ -129,6 +147,13 @@ gulong mx_actor_manager_remove_actor (MxActorManager *manager,
                                       ClutterActor   *container,
                                       ClutterActor   *actor);
 
+gulong mx_actor_manager_add_actors    (MxActorManager *manager,
+                                      ClutterActor   *container,
+                                      GList          *actors);
+gulong mx_actor_manager_remove_actors (MxActorManager *manager,
+                                      ClutterActor   *container,
+                                      GList          *actors);
+
 void mx_actor_manager_remove_container (MxActorManager *manager,
                                         ClutterActor   *container);
 
@@ -138,6 +163,10 @@ void mx_actor_manager_cancel_operation (MxActorManager *manager,
 void mx_actor_manager_cancel_operations (MxActorManager *manager,
                                          ClutterActor   *actor);
 
+void mx_actor_manager_set_priority (MxActorManager *manager,
+                                    gulong          id,
+                                    gint            priority);
+
 void  mx_actor_manager_set_time_slice (MxActorManager *manager,
                                        guint           msecs);
 guint mx_actor_manager_get_time_slice (MxActorManager *manager);
@@ -55,6 +55,11 @@ struct _MxAdjustmentPrivate
   guint clamp_value     : 1;
   guint elastic         : 1;
 
+  /* Set while mx_adjustment_set_values() changes several values, so that
+   * changed-immediate is emitted once for all of them */
+  guint in_set_values   : 1;
+  guint values_changed  : 1;
+
   gdouble  lower;
   gdouble  upper;
   gdouble  value;
@@ -62,17 +67,18 @@ struct _MxAdjustmentPrivate
   gdouble  page_increment;
   gdouble  page_size;
 
-  /* For signal emission/notification */
-  guint lower_source;
-  guint upper_source;
-  guint value_source;
-  guint step_inc_source;
-  guint page_inc_source;
-  guint page_size_source;
-  guint changed_source;
+  /* For signal emission/notification: the properties to notify and
+   * whether to emit MxAdjustment::changed, all at once from an idle */
+  guint pending;
+  guint pending_source;
 
-  /* For interpolation */
+  /* For interpolation: the timeline is never started, it only maps the
+   * elapsed time to the progress of the animation mode. The time is
+   * advanced by the clock shared by all the adjustments. */
   ClutterTimeline *interpolation;
+  guint            interpolation_elapsed;
+  guint            interpolation_backward : 1;
+  guint            interpolation_active   : 1;
   gdouble          old_position;
   gdouble          new_position;
 };
@@ -103,6 +109,20 @@ enum
 
 static guint signals[LAST_SIGNAL] = { 0, };
 
+enum
+{
+  PENDING_VALUE     = 1 << 0,
+  PENDING_LOWER     = 1 << 1,
+  PENDING_UPPER     = 1 << 2,
+  PENDING_STEP_INC  = 1 << 3,
+  PENDING_PAGE_INC  = 1 << 4,
+  PENDING_PAGE_SIZE = 1 << 5,
+  PENDING_CHANGED   = 1 << 6
+};
+
+static void mx_adjustment_queue (MxAdjustment *adjustment,
+                                 guint         pending);
+
 static gboolean _mx_adjustment_set_lower          (MxAdjustment *adjustment,
                                                    gdouble       lower);
 static gboolean _mx_adjustment_set_upper          (MxAdjustment *adjustment,
@@ -234,26 +254,94 @@ mx_adjustment_set_property (GObject      *gobject,
     }
 }
 
+/* A single timeline drives the interpolations of all the adjustments, so
+ * that a frame steps every one of them in one pass rather than dispatching
+ * a timeline per adjustment. It runs while there is anything to step. */
+static ClutterTimeline *interpolation_clock = NULL;
+static GList *interpolations = NULL;
+
+static void interpolation_step (MxAdjustment *adjustment,
+                                guint         delta);
+
 static void
-stop_interpolation (MxAdjustment *adjustment)
+interpolation_clock_new_frame_cb (ClutterTimeline *timeline,
+                                  guint            msecs,
+                                  gpointer         user_data)
+{
+  GList *active, *l;
+  const gchar *reason;
+  guint delta;
+
+  delta = clutter_timeline_get_delta (timeline);
+  reason = _mx_debug_redraw_reason_push ("animation");
+
+  /* Stepping an adjustment may start or stop others */
+  active = g_list_copy (interpolations);
+  g_list_foreach (active, (GFunc) g_object_ref, NULL);
+
+  for (l = active; l; l = l->next)
+    {
+      MxAdjustment *adjustment = l->data;
+
+      if (adjustment->priv->interpolation_active)
+        interpolation_step (adjustment, delta);
+
+      g_object_unref (adjustment);
+    }
+
+  g_list_free (active);
+
+  _mx_debug_redraw_reason_pop (reason);
+}
+
+static void
+interpolation_clock_add (MxAdjustment *adjustment)
 {
   MxAdjustmentPrivate *priv = adjustment->priv;
 
-  if (priv->interpolation)
+  if (priv->interpolation_active)
+    return;
+
+  priv->interpolation_active = TRUE;
+  interpolations = g_list_prepend (interpolations, adjustment);
+
+  if (!interpolation_clock)
     {
-      clutter_timeline_stop (priv->interpolation);
-      g_object_unref (priv->interpolation);
-      priv->interpolation = NULL;
+      interpolation_clock = clutter_timeline_new (1000);
+      clutter_timeline_set_repeat_count (interpolation_clock, -1);
+      g_signal_connect (interpolation_clock, "new-frame",
+                        G_CALLBACK (interpolation_clock_new_frame_cb), NULL);
     }
+
+  if (!clutter_timeline_is_playing (interpolation_clock))
+    clutter_timeline_start (interpolation_clock);
 }
 
 static void
-mx_adjustment_remove_idle (guint *source)
+interpolation_clock_remove (MxAdjustment *adjustment)
 {
-  if (*source)
+  MxAdjustmentPrivate *priv = adjustment->priv;
+
+  if (!priv->interpolation_active)
+    return;
+
+  priv->interpolation_active = FALSE;
+  interpolations = g_list_remove (interpolations, adjustment);
+
+  if (!interpolations)
+    clutter_timeline_stop (interpolation_clock);
+}
+
+static void
+stop_interpolation (MxAdjustment *adjustment)
+{
+  MxAdjustmentPrivate *priv = adjustment->priv;
+
+  if (priv->interpolation)
     {
-      g_source_remove (*source);
-      *source = 0;
+      interpolation_clock_remove (adjustment);
+      g_object_unref (priv->interpolation);
+      priv->interpolation = NULL;
     }
 }
 
@@ -264,14 +352,13 @@ mx_adjustment_dispose (GObject *object)
 
   stop_interpolation (MX_ADJUSTMENT (object));
 
-  /* Remove idle handlers */
-  mx_adjustment_remove_idle (&priv->value_source);
-  mx_adjustment_remove_idle (&priv->lower_source);
-  mx_adjustment_remove_idle (&priv->upper_source);
-  mx_adjustment_remove_idle (&priv->page_inc_source);
-  mx_adjustment_remove_idle (&priv->step_inc_source);
-  mx_adjustment_remove_idle (&priv->page_size_source);
-  mx_adjustment_remove_idle (&priv->changed_source);
+  /* Remove idle handler */
+  if (priv->pending_source)
+    {
+      g_source_remove (priv->pending_source);
+      priv->pending_source = 0;
+      priv->pending = 0;
+    }
 
   G_OBJECT_CLASS (mx_adjustment_parent_class)->dispose (object);
 }
@@ -488,81 +575,60 @@ mx_adjustment_get_value (MxAdjustment *adjustment)
 }
 
 static gboolean
-mx_adjustment_value_notify_cb (MxAdjustment *adjustment)
-{
-  MxAdjustmentPrivate *priv = adjustment->priv;
-
-  priv->value_source = 0;
-
-  g_object_notify (G_OBJECT (adjustment), "value");
-
-  return FALSE;
-}
-
-static gboolean
-mx_adjustment_lower_notify_cb (MxAdjustment *adjustment)
-{
-  MxAdjustmentPrivate *priv = adjustment->priv;
-
-  priv->lower_source = 0;
-  g_object_notify (G_OBJECT (adjustment), "lower");
-
-  return FALSE;
-}
-
-static gboolean
-mx_adjustment_upper_notify_cb (MxAdjustment *adjustment)
+mx_adjustment_pending_cb (MxAdjustment *adjustment)
 {
   MxAdjustmentPrivate *priv = adjustment->priv;
+  GObject *object = G_OBJECT (adjustment);
+  guint pending;
 
-  priv->upper_source = 0;
-  g_object_notify (G_OBJECT (adjustment), "upper");
+  pending = priv->pending;
+  priv->pending = 0;
+  priv->pending_source = 0;
 
-  return FALSE;
-}
+  g_object_ref (adjustment);
 
-static gboolean
-mx_adjustment_step_inc_notify_cb (MxAdjustment *adjustment)
-{
-  MxAdjustmentPrivate *priv = adjustment->priv;
+  g_object_freeze_notify (object);
 
-  priv->step_inc_source = 0;
-  g_object_notify (G_OBJECT (adjustment), "step-increment");
+  if (pending & PENDING_VALUE)
+    g_object_notify (object, "value");
+  if (pending & PENDING_LOWER)
+    g_object_notify (object, "lower");
+  if (pending & PENDING_UPPER)
+    g_object_notify (object, "upper");
+  if (pending & PENDING_STEP_INC)
+    g_object_notify (object, "step-increment");
+  if (pending & PENDING_PAGE_INC)
+    g_object_notify (object, "page-increment");
+  if (pending & PENDING_PAGE_SIZE)
+    g_object_notify (object, "page-size");
 
-  return FALSE;
-}
+  g_object_thaw_notify (object);
 
-static gboolean
-mx_adjustment_page_inc_notify_cb (MxAdjustment *adjustment)
-{
-  MxAdjustmentPrivate *priv = adjustment->priv;
+  if (pending & PENDING_CHANGED)
+    g_signal_emit (adjustment, signals[CHANGED], 0);
 
-  priv->page_inc_source = 0;
-  g_object_notify (G_OBJECT (adjustment), "page-increment");
+  g_object_unref (adjustment);
 
   return FALSE;
 }
 
-static gboolean
-mx_adjustment_page_size_notify_cb (MxAdjustment *adjustment)
-{
-  MxAdjustmentPrivate *priv = adjustment->priv;
-
-  priv->page_size_source = 0;
-  g_object_notify (G_OBJECT (adjustment), "page-size");
-
-  return FALSE;
-}
-
-static gboolean
-mx_adjustment_emit_changed_cb (MxAdjustment *adjustment)
+/* Queues the notifications in @pending to be made at the next iteration of
+ * the main loop, before the frame is drawn. However many values change
+ * before then, each is only notified once. */
+static void
+mx_adjustment_queue (MxAdjustment *adjustment,
+                     guint         pending)
 {
   MxAdjustmentPrivate *priv = adjustment->priv;
 
-  priv->changed_source = 0;
-  g_signal_emit (adjustment, signals[CHANGED], 0);
+  priv->pending |= pending;
 
-  return FALSE;
+  if (!priv->pending_source)
+    priv->pending_source =
+      g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
+                       (GSourceFunc)mx_adjustment_pending_cb,
+                       adjustment,
+                       NULL);
 }
 
 /**
@@ -594,12 +660,16 @@ mx_adjustment_set_value (MxAdjustment *adjustment,
 
   if (priv->value != value)
     {
+      const gchar *reason;
+
       stop_interpolation (adjustment);
 
       priv->value = value;
 
+      reason = _mx_debug_redraw_reason_push ("adjustment");
       g_object_notify (G_OBJECT (adjustment), "value");
       mx_adjustment_emit_changed (adjustment);
+      _mx_debug_redraw_reason_pop (reason);
     }
 }
 
@@ -632,12 +702,8 @@ mx_adjustment_clamp_page (MxAdjustment *adjustment,
       changed = TRUE;
     }
 
-  if (changed && !priv->value_source)
-    priv->value_source =
-      g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                       (GSourceFunc)mx_adjustment_value_notify_cb,
-                       adjustment,
-                       NULL);
+  if (changed)
+    mx_adjustment_queue (adjustment, PENDING_VALUE);
 }
 
 static void
@@ -645,14 +711,16 @@ mx_adjustment_emit_changed (MxAdjustment *adjustment)
 {
   MxAdjustmentPrivate *priv = adjustment->priv;
 
+  /* mx_adjustment_set_values() emits once it has set all the values */
+  if (priv->in_set_values)
+    {
+      priv->values_changed = TRUE;
+      return;
+    }
+
   g_signal_emit (adjustment, signals[CHANGED_IMMEDIATE], 0);
 
-  if (!priv->changed_source)
-    priv->changed_source =
-      g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                       (GSourceFunc)mx_adjustment_emit_changed_cb,
-                       adjustment,
-                       NULL);
+  mx_adjustment_queue (adjustment, PENDING_CHANGED);
 }
 
 static gboolean
@@ -667,12 +735,7 @@ _mx_adjustment_set_lower (MxAdjustment *adjustment,
 
       mx_adjustment_emit_changed (adjustment);
 
-      if (!priv->lower_source)
-        priv->lower_source =
-          g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                           (GSourceFunc)mx_adjustment_lower_notify_cb,
-                           adjustment,
-                           NULL);
+      mx_adjustment_queue (adjustment, PENDING_LOWER);
 
       /* Defer clamp until after construction. */
       if (!priv->is_constructing && priv->clamp_value)
@@ -726,12 +789,7 @@ _mx_adjustment_set_upper (MxAdjustment *adjustment,
 
       mx_adjustment_emit_changed (adjustment);
 
-      if (!priv->upper_source)
-        priv->upper_source =
-          g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                           (GSourceFunc)mx_adjustment_upper_notify_cb,
-                           adjustment,
-                           NULL);
+      mx_adjustment_queue (adjustment, PENDING_UPPER);
 
       /* Defer clamp until after construction. */
       if (!priv->is_constructing && priv->clamp_value)
@@ -785,12 +843,7 @@ _mx_adjustment_set_step_increment (MxAdjustment *adjustment,
 
       mx_adjustment_emit_changed (adjustment);
 
-      if (!priv->step_inc_source)
-        priv->step_inc_source =
-          g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                           (GSourceFunc)mx_adjustment_step_inc_notify_cb,
-                           adjustment,
-                           NULL);
+      mx_adjustment_queue (adjustment, PENDING_STEP_INC);
 
       return TRUE;
     }
@@ -840,12 +893,7 @@ _mx_adjustment_set_page_increment (MxAdjustment *adjustment,
 
       mx_adjustment_emit_changed (adjustment);
 
-      if (!priv->page_inc_source)
-        priv->page_inc_source =
-          g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                           (GSourceFunc)mx_adjustment_page_inc_notify_cb,
-                           adjustment,
-                           NULL);
+      mx_adjustment_queue (adjustment, PENDING_PAGE_INC);
 
       return TRUE;
     }
@@ -895,12 +943,7 @@ _mx_adjustment_set_page_size (MxAdjustment *adjustment,
 
       mx_adjustment_emit_changed (adjustment);
 
-      if (!priv->page_size_source)
-        priv->page_size_source =
-          g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                           (GSourceFunc)mx_adjustment_page_size_notify_cb,
-                           adjustment,
-                           NULL);
+      mx_adjustment_queue (adjustment, PENDING_PAGE_SIZE);
 
       /* Well explicitely clamp after construction. */
       if (!priv->is_constructing && priv->clamp_value)
@@ -954,6 +997,10 @@ mx_adjustment_get_page_size (MxAdjustment *adjustment)
  *
  * Set the various properties of MxAdjustment.
  *
+ * This is cheaper than setting the properties one at a time: the
+ * property notifications and #MxAdjustment::changed-immediate are emitted
+ * once for all of them.
+ *
  */
 void
 mx_adjustment_set_values (MxAdjustment *adjustment,
@@ -965,7 +1012,6 @@ mx_adjustment_set_values (MxAdjustment *adjustment,
                           gdouble       page_size)
 {
   MxAdjustmentPrivate *priv;
-  gboolean emit_changed = FALSE;
 
   g_return_if_fail (MX_IS_ADJUSTMENT (adjustment));
   g_return_if_fail (page_size >= 0 && page_size <= G_MAXDOUBLE);
@@ -974,27 +1020,29 @@ mx_adjustment_set_values (MxAdjustment *adjustment,
 
   priv = adjustment->priv;
 
-  emit_changed = FALSE;
-
   g_object_freeze_notify (G_OBJECT (adjustment));
 
-  emit_changed |= _mx_adjustment_set_lower (adjustment, lower);
-  emit_changed |= _mx_adjustment_set_upper (adjustment, upper);
-  emit_changed |= _mx_adjustment_set_step_increment (adjustment,
-                                                     step_increment);
-  emit_changed |= _mx_adjustment_set_page_increment (adjustment,
-                                                     page_increment);
-  emit_changed |= _mx_adjustment_set_page_size (adjustment, page_size);
+  /* changed-immediate is emitted once for all the values, and the deferred
+   * notifications and MxAdjustment::changed once per frame */
+  priv->in_set_values = TRUE;
+  priv->values_changed = FALSE;
+
+  _mx_adjustment_set_lower (adjustment, lower);
+  _mx_adjustment_set_upper (adjustment, upper);
+  _mx_adjustment_set_step_increment (adjustment, step_increment);
+  _mx_adjustment_set_page_increment (adjustment, page_increment);
+  _mx_adjustment_set_page_size (adjustment, page_size);
+
+  mx_adjustment_set_value (adjustment, value);
+
+  priv->in_set_values = FALSE;
 
-  if (value != priv->value)
+  if (priv->values_changed)
     {
-      mx_adjustment_set_value (adjustment, value);
-      emit_changed = TRUE;
+      priv->values_changed = FALSE;
+      mx_adjustment_emit_changed (adjustment);
     }
 
-  if (emit_changed)
-    mx_adjustment_emit_changed (adjustment);
-
   g_object_thaw_notify (G_OBJECT (adjustment));
 }
 
@@ -1046,54 +1094,25 @@ mx_adjustment_get_values (MxAdjustment *adjustment,
 }
 
 static void
-interpolation_new_frame_cb (ClutterTimeline *timeline,
-                            guint            msecs,
-                            MxAdjustment    *adjustment)
-{
-  gdouble new_value;
-  MxAdjustmentPrivate *priv = adjustment->priv;
-
-  new_value = priv->old_position +
-    (priv->new_position - priv->old_position) *
-    clutter_timeline_get_progress (priv->interpolation);
-
-  priv->interpolation = NULL;
-  mx_adjustment_set_value (adjustment, new_value);
-  priv->interpolation = timeline;
-
-  /* Stop the interpolation if we've reached the end of the adjustment */
-  if (!priv->elastic && priv->clamp_value &&
-      ((new_value < priv->lower) ||
-       (new_value > (priv->upper - priv->page_size))))
-    stop_interpolation (adjustment);
-}
-
-static void
-interpolation_completed_cb (ClutterTimeline *timeline,
-                            MxAdjustment    *adjustment)
+interpolation_completed (MxAdjustment *adjustment)
 {
   MxAdjustmentPrivate *priv = adjustment->priv;
 
   if (priv->elastic && priv->clamp_value)
     {
-      if (clutter_timeline_get_direction (priv->interpolation) ==
-            CLUTTER_TIMELINE_FORWARD)
+      if (!priv->interpolation_backward)
         {
-          clutter_timeline_set_direction (priv->interpolation,
-                                          CLUTTER_TIMELINE_BACKWARD);
+          /* Bounce back from the edge */
+          priv->interpolation_backward = TRUE;
+          priv->interpolation_elapsed = 0;
           clutter_timeline_set_duration (priv->interpolation, 250);
-          clutter_timeline_rewind (priv->interpolation);
 
           if (priv->new_position < priv->lower)
-            {
-              priv->old_position = priv->lower;
-              clutter_timeline_start (priv->interpolation);
-            }
+            priv->old_position = priv->lower;
           else if (priv->new_position > (priv->upper - priv->page_size))
-            {
-              priv->old_position = priv->upper - priv->page_size;
-              clutter_timeline_start (priv->interpolation);
-            }
+            priv->old_position = priv->upper - priv->page_size;
+          else
+            interpolation_clock_remove (adjustment);
         }
       else
         {
@@ -1110,6 +1129,40 @@ interpolation_completed_cb (ClutterTimeline *timeline,
   g_signal_emit (adjustment, signals[INTERPOLATION_COMPLETED], 0);
 }
 
+static void
+interpolation_step (MxAdjustment *adjustment,
+                    guint         delta)
+{
+  MxAdjustmentPrivate *priv = adjustment->priv;
+  ClutterTimeline *timeline = priv->interpolation;
+  guint duration;
+  gdouble new_value;
+
+  duration = clutter_timeline_get_duration (timeline);
+  priv->interpolation_elapsed = MIN (priv->interpolation_elapsed + delta,
+                                     duration);
+
+  clutter_timeline_advance (timeline, priv->interpolation_backward ?
+                            duration - priv->interpolation_elapsed :
+                            priv->interpolation_elapsed);
+
+  new_value = priv->old_position +
+    (priv->new_position - priv->old_position) *
+    clutter_timeline_get_progress (timeline);
+
+  priv->interpolation = NULL;
+  mx_adjustment_set_value (adjustment, new_value);
+  priv->interpolation = timeline;
+
+  /* Stop the interpolation if we've reached the end of the adjustment */
+  if (!priv->elastic && priv->clamp_value &&
+      ((new_value < priv->lower) ||
+       (new_value > (priv->upper - priv->page_size))))
+    stop_interpolation (adjustment);
+  else if (priv->interpolation_elapsed >= duration)
+    interpolation_completed (adjustment);
+}
+
 /**
  * mx_adjustment_interpolate:
  * @adjustment: A #MxAdjustment
@@ -1140,33 +1193,20 @@ mx_adjustment_interpolate (MxAdjustment *adjustment,
   priv->old_position = priv->value;
   priv->new_position = value;
 
+  /* Extend the animation if it gets interrupted, otherwise frequent calls
+   * to this function will end up with no advancements until the calls
+   * finish (as the animation never gets a chance to start).
+   */
   if (!priv->interpolation)
-    {
-      priv->interpolation = clutter_timeline_new (duration);
-
-      g_signal_connect (priv->interpolation,
-                        "new-frame",
-                        G_CALLBACK (interpolation_new_frame_cb),
-                        adjustment);
-      g_signal_connect (priv->interpolation,
-                        "completed",
-                        G_CALLBACK (interpolation_completed_cb),
-                        adjustment);
-    }
+    priv->interpolation = clutter_timeline_new (duration);
   else
-    {
-      /* Extend the animation if it gets interrupted, otherwise frequent calls
-       * to this function will end up with no advancements until the calls
-       * finish (as the animation never gets a chance to start).
-       */
-      clutter_timeline_set_direction (priv->interpolation,
-                                      CLUTTER_TIMELINE_FORWARD);
-      clutter_timeline_rewind (priv->interpolation);
-      clutter_timeline_set_duration (priv->interpolation, duration);
-    }
+    clutter_timeline_set_duration (priv->interpolation, duration);
   clutter_timeline_set_progress_mode (priv->interpolation, mode);
 
-  clutter_timeline_start (priv->interpolation);
+  priv->interpolation_elapsed = 0;
+  priv->interpolation_backward = FALSE;
+
+  interpolation_clock_add (adjustment);
 }
 
 /**
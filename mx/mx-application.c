@@ -433,6 +433,10 @@ mx_application_get_windows (MxApplication *application)
  * Creates a new #MxWindow and adds it to MxApplication. The application must be
  * registered before this function is run.
  *
+ * The stages of all the windows render with the same Cogl context, so the
+ * textures, icons and glyphs cached by Mx are shared between them rather
+ * than loaded again for each window.
+ *
  * Returns: (transfer none): The newly created MxWindow
  */
 MxWindow*
@@ -0,0 +1,201 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-box-array.c: Packed allocations of the children of a container
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "mx-box-array.h"
+
+/* The boxes are tested a vector at a time where the compiler has vector
+ * comparisons and the machine SSE or NEON, one at a time otherwise */
+#if ((defined (__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))) || \
+     defined (__clang__)) && \
+    (defined (__SSE2__) || defined (__ARM_NEON) || defined (__ARM_NEON__))
+#define MX_BOX_ARRAY_USE_VECTORS 1
+
+#ifdef __AVX__
+#define MX_BOX_ARRAY_LANES 8
+#else
+#define MX_BOX_ARRAY_LANES 4
+#endif
+
+typedef gfloat MxBoxVector
+  __attribute__ ((vector_size (MX_BOX_ARRAY_LANES * sizeof (gfloat))));
+typedef gint32 MxBoxMask
+  __attribute__ ((vector_size (MX_BOX_ARRAY_LANES * sizeof (gint32))));
+#endif
+
+struct _MxBoxArray
+{
+  guint          length;
+  guint          size;
+
+  ClutterActor **actors;
+  gfloat        *x1;
+  gfloat        *y1;
+  gfloat        *x2;
+  gfloat        *y2;
+
+  /* the indices of the boxes found by the last cull */
+  guint         *visible;
+};
+
+MxBoxArray *
+_mx_box_array_new (void)
+{
+  return g_slice_new0 (MxBoxArray);
+}
+
+void
+_mx_box_array_free (MxBoxArray *array)
+{
+  g_free (array->actors);
+  g_free (array->x1);
+  g_free (array->y1);
+  g_free (array->x2);
+  g_free (array->y2);
+  g_free (array->visible);
+
+  g_slice_free (MxBoxArray, array);
+}
+
+/* Drops the boxes from @length on; the array can only be shortened */
+void
+_mx_box_array_set_length (MxBoxArray *array,
+                          guint       length)
+{
+  array->length = MIN (array->length, length);
+}
+
+guint
+_mx_box_array_get_length (MxBoxArray *array)
+{
+  return array->length;
+}
+
+void
+_mx_box_array_append (MxBoxArray            *array,
+                      ClutterActor          *actor,
+                      const ClutterActorBox *box)
+{
+  guint i;
+
+  if (G_UNLIKELY (array->length == array->size))
+    {
+      array->size = MAX (16, array->size * 2);
+
+      array->actors = g_renew (ClutterActor *, array->actors, array->size);
+      array->x1 = g_renew (gfloat, array->x1, array->size);
+      array->y1 = g_renew (gfloat, array->y1, array->size);
+      array->x2 = g_renew (gfloat, array->x2, array->size);
+      array->y2 = g_renew (gfloat, array->y2, array->size);
+      array->visible = g_renew (guint, array->visible, array->size);
+    }
+
+  i = array->length++;
+
+  array->actors[i] = actor;
+  array->x1[i] = box->x1;
+  array->y1[i] = box->y1;
+  array->x2[i] = box->x2;
+  array->y2[i] = box->y2;
+}
+
+ClutterActor *
+_mx_box_array_get_actor (MxBoxArray *array,
+                         guint       index_)
+{
+  g_return_val_if_fail (index_ < array->length, NULL);
+
+  return array->actors[index_];
+}
+
+/* Finds the boxes from @first up to @last that reach into @area. @visible
+ * is set to their indices, in order, and stays valid until the array
+ * changes or is culled again. Returns the number of boxes found. */
+guint
+_mx_box_array_cull (MxBoxArray             *array,
+                    guint                   first,
+                    guint                   last,
+                    const ClutterActorBox  *area,
+                    const guint           **visible)
+{
+  guint i, n_visible = 0;
+
+  last = MIN (last, array->length);
+  i = first;
+
+#ifdef MX_BOX_ARRAY_USE_VECTORS
+  {
+    MxBoxVector area_x1, area_y1, area_x2, area_y2;
+    gint lane;
+
+    for (lane = 0; lane < MX_BOX_ARRAY_LANES; lane++)
+      {
+        area_x1[lane] = area->x1;
+        area_y1[lane] = area->y1;
+        area_x2[lane] = area->x2;
+        area_y2[lane] = area->y2;
+      }
+
+    for (; i + MX_BOX_ARRAY_LANES <= last; i += MX_BOX_ARRAY_LANES)
+      {
+        MxBoxVector x1, y1, x2, y2;
+        MxBoxMask in;
+        gint32 any = 0;
+
+        /* the boxes start anywhere, so they are copied rather than
+         * loaded as aligned vectors */
+        memcpy (&x1, array->x1 + i, sizeof (MxBoxVector));
+        memcpy (&y1, array->y1 + i, sizeof (MxBoxVector));
+        memcpy (&x2, array->x2 + i, sizeof (MxBoxVector));
+        memcpy (&y2, array->y2 + i, sizeof (MxBoxVector));
+
+        in = (x1 < area_x2) & (x2 > area_x1) & (y1 < area_y2) & (y2 > area_y1);
+
+        for (lane = 0; lane < MX_BOX_ARRAY_LANES; lane++)
+          any |= in[lane];
+        if (!any)
+          continue;
+
+        for (lane = 0; lane < MX_BOX_ARRAY_LANES; lane++)
+          if (in[lane])
+            array->visible[n_visible++] = i + lane;
+      }
+  }
+#endif
+
+  for (; i < last; i++)
+    {
+      if (array->x1[i] < area->x2 && array->x2[i] > area->x1 &&
+          array->y1[i] < area->y2 && array->y2[i] > area->y1)
+        array->visible[n_visible++] = i;
+    }
+
+  *visible = array->visible;
+
+  return n_visible;
+}
@@ -0,0 +1,63 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-box-array.h: Packed allocations of the children of a container
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _MX_BOX_ARRAY_H
+#define _MX_BOX_ARRAY_H
+
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+/*
+ * An MxBoxArray keeps the allocations of the children of a container, in
+ * the order the container paints them, as one array for each edge, so
+ * that the boxes can be tested against the area being painted several at
+ * a time rather than each through clutter_actor_get_allocation_box().
+ *
+ * Containers append the children as they allocate them. The array is only
+ * as current as the last allocation, which is all painting needs.
+ */
+
+typedef struct _MxBoxArray MxBoxArray;
+
+MxBoxArray   *_mx_box_array_new        (void);
+void          _mx_box_array_free       (MxBoxArray            *array);
+
+void          _mx_box_array_set_length (MxBoxArray            *array,
+                                        guint                  length);
+guint         _mx_box_array_get_length (MxBoxArray            *array);
+
+void          _mx_box_array_append     (MxBoxArray            *array,
+                                        ClutterActor          *actor,
+                                        const ClutterActorBox *box);
+ClutterActor *_mx_box_array_get_actor  (MxBoxArray            *array,
+                                        guint                  index_);
+
+guint         _mx_box_array_cull       (MxBoxArray            *array,
+                                        guint                  first,
+                                        guint                  last,
+                                        const ClutterActorBox *area,
+                                        const guint          **visible);
+
+G_END_DECLS
+
+#endif /* _MX_BOX_ARRAY_H */
@@ -59,6 +59,8 @@
 #include "mx-scrollable.h"
 #include "mx-box-layout-child.h"
 #include "mx-focusable.h"
+#include "mx-tile-cache.h"
+#include "mx-box-array.h"
 
 
 static void mx_box_container_iface_init (ClutterContainerIface *iface);
@@ -89,9 +91,20 @@ enum {
   PROP_VADJUST,
 
   PROP_ENABLE_ANIMATIONS,
-  PROP_SCROLL_TO_FOCUSED
+  PROP_SCROLL_TO_FOCUSED,
+  PROP_PREFETCH_TEXT_SIZES
 };
 
+/* Where a child is along the orientation, as allocated last. start and end
+ * also cover the children after it (for start) and before it (for end), so
+ * both only ever increase. */
+typedef struct
+{
+  ClutterActor *child;
+  gfloat        start;
+  gfloat        end;
+} MxBoxLayoutOffset;
+
 struct _MxBoxLayoutPrivate
 {
   guint         ignore_css_spacing : 1; /* Should we ignore spacing from
@@ -108,13 +121,37 @@ struct _MxBoxLayoutPrivate
   guint            enable_animations : 1;
   guint            scroll_to_focused : 1;
 
+  /* whether the texts of the labels are measured on worker threads, and
+   * whether they were since the last relayout */
+  guint            prefetch_text_sizes : 1;
+  guint            text_prefetched : 1;
+
   MxOrientation orientation;
 
   MxFocusable *last_focus;
+
+  /* the visible children in paint order, for culling, and their
+   * allocations in the same order */
+  GArray      *offsets;
+  MxBoxArray  *boxes;
+
+  /* the last preferred sizes, kept for the allocation that follows until
+   * a relayout is queued */
+  guint        width_valid : 1;
+  guint        height_valid : 1;
+  gfloat       width_for_height, min_width, natural_width;
+  gfloat       height_for_width, min_height, natural_height;
 };
 
 void _mx_box_layout_finish_animation (MxBoxLayout *box);
 
+void
+_mx_box_layout_invalidate_offsets (MxBoxLayout *box)
+{
+  g_array_set_size (box->priv->offsets, 0);
+  _mx_box_array_set_length (box->priv->boxes, 0);
+}
+
 void
 _mx_box_layout_start_animation (MxBoxLayout *box)
 {
@@ -128,21 +165,27 @@ _mx_box_layout_start_animation (MxBoxLayout *box)
 
   priv->is_animating = TRUE;
 
+  /* the children are allocated where they end up once, and moved there
+   * from where they were when painting */
   priv->timeline = clutter_timeline_new (300);
   g_signal_connect_swapped (priv->timeline, "new-frame",
-                            G_CALLBACK (clutter_actor_queue_relayout), box);
+                            G_CALLBACK (clutter_actor_queue_redraw), box);
   g_signal_connect_swapped (priv->timeline, "completed",
                             G_CALLBACK (_mx_box_layout_finish_animation), box);
 
   clutter_timeline_set_progress_mode (priv->timeline, CLUTTER_EASE_OUT_CUBIC);
 
   clutter_timeline_start (priv->timeline);
+
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (box));
 }
 
 void
 _mx_box_layout_finish_animation (MxBoxLayout *box)
 {
   MxBoxLayoutPrivate *priv = box->priv;
+  ClutterActorIter iter;
+  ClutterActor *child;
 
   if (priv->timeline)
     {
@@ -150,7 +193,26 @@ _mx_box_layout_finish_animation (MxBoxLayout *box)
       priv->timeline = NULL;
     }
 
+  if (!priv->is_animating)
+    return;
+
   priv->is_animating = FALSE;
+
+  /* the next animation starts from where the children are now */
+  clutter_actor_iter_init (&iter, CLUTTER_ACTOR (box));
+  while (clutter_actor_iter_next (&iter, &child))
+    {
+      ClutterActorBox child_box;
+
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      clutter_actor_get_allocation_box (child, &child_box);
+      g_hash_table_insert (priv->start_allocations, child,
+                           g_boxed_copy (CLUTTER_TYPE_ACTOR_BOX, &child_box));
+    }
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (box));
 }
 
 /*
@@ -326,6 +388,8 @@ mx_box_container_actor_removed (ClutterContainer *container,
   if ((ClutterActor *)priv->last_focus == actor)
     priv->last_focus = NULL;
 
+  _mx_box_layout_invalidate_offsets (MX_BOX_LAYOUT (container));
+
   if (priv->enable_animations)
     _mx_box_layout_start_animation (MX_BOX_LAYOUT (container));
   else
@@ -398,17 +462,14 @@ mx_box_layout_move_focus (MxFocusable      *focusable,
                           MxFocusable      *from)
 {
   MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (focusable)->priv;
-  GList *l, *childlink, *children;
+  ClutterActor *child = NULL;
   MxFocusHint hint;
   MxFocusable *focused = NULL;
 
-
   /* find the current focus */
-  children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
-  childlink = g_list_find (children, from);
-
-  if (!childlink)
-    goto out;
+  if (clutter_actor_get_parent (CLUTTER_ACTOR (from)) !=
+      CLUTTER_ACTOR (focusable))
+    return NULL;
 
   priv->last_focus = from;
 
@@ -433,43 +494,32 @@ mx_box_layout_move_focus (MxFocusable      *focusable,
   /* find the next widget to focus */
   if (direction == MX_FOCUS_DIRECTION_NEXT)
     {
-      for (l = childlink->next; l; l = g_list_next (l))
+      for (child = clutter_actor_get_next_sibling (CLUTTER_ACTOR (from));
+           child;
+           child = clutter_actor_get_next_sibling (child))
         {
-          MxFocusable *child = (MxFocusable *) l->data;
-
-          if (MX_IS_FOCUSABLE (child))
-            {
-              focused = mx_focusable_accept_focus (child, hint);
-
-              if (focused)
-                {
-                  update_adjustments (MX_BOX_LAYOUT (focusable), child);
-                  goto out;
-                }
-            }
+          if (MX_IS_FOCUSABLE (child) &&
+              (focused = mx_focusable_accept_focus (MX_FOCUSABLE (child),
+                                                    hint)))
+            break;
         }
     }
   else if (direction == MX_FOCUS_DIRECTION_PREVIOUS)
     {
-      for (l = g_list_previous (childlink); l; l = g_list_previous (l))
+      for (child = clutter_actor_get_previous_sibling (CLUTTER_ACTOR (from));
+           child;
+           child = clutter_actor_get_previous_sibling (child))
         {
-          MxFocusable *child = (MxFocusable *) l->data;
-
-          if (MX_IS_FOCUSABLE (child))
-            {
-              focused = mx_focusable_accept_focus (child, hint);
-
-              if (focused)
-                {
-                  update_adjustments (MX_BOX_LAYOUT (focusable), child);
-                  goto out;
-                }
-            }
+          if (MX_IS_FOCUSABLE (child) &&
+              (focused = mx_focusable_accept_focus (MX_FOCUSABLE (child),
+                                                    hint)))
+            break;
         }
     }
 
-out:
-  g_list_free (children);
+  if (focused)
+    update_adjustments (MX_BOX_LAYOUT (focusable), MX_FOCUSABLE (child));
+
   return focused;
 }
 
@@ -477,14 +527,13 @@ static MxFocusable*
 mx_box_layout_accept_focus (MxFocusable *focusable, MxFocusHint hint)
 {
   MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (focusable)->priv;
+  ClutterActor *self = CLUTTER_ACTOR (focusable);
   MxFocusable *return_focusable;
   MxFocusHint modified_hint;
-  GList* list, *l, *children;
+  ClutterActor *child;
 
   return_focusable = NULL;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
-
   /* Transform the hint based on our orientation */
   modified_hint = hint;
   if (priv->orientation == MX_ORIENTATION_HORIZONTAL)
@@ -506,43 +555,41 @@ mx_box_layout_accept_focus (MxFocusable *focusable, MxFocusHint hint)
   switch (modified_hint)
     {
     case MX_FOCUS_HINT_LAST:
-      list = g_list_reverse (g_list_copy (children));
+      child = clutter_actor_get_last_child (self);
       break;
 
     default:
     case MX_FOCUS_HINT_PRIOR:
       if (priv->last_focus)
         {
-          list = g_list_copy (g_list_find (children, priv->last_focus));
-          if (list)
-            break;
+          child = CLUTTER_ACTOR (priv->last_focus);
+          break;
         }
       /* This intentionally runs into the next case */
 
     case MX_FOCUS_HINT_FIRST:
-      list = g_list_copy (children);
+      child = clutter_actor_get_first_child (self);
       break;
     }
 
-  for (l = list; l; l = g_list_next (l))
+  for (; child; child = (modified_hint == MX_FOCUS_HINT_LAST) ?
+         clutter_actor_get_previous_sibling (child) :
+         clutter_actor_get_next_sibling (child))
     {
-      if (MX_IS_FOCUSABLE (l->data))
+      if (MX_IS_FOCUSABLE (child))
         {
-          MxFocusable *child = MX_FOCUSABLE (l->data);
-
-          return_focusable = mx_focusable_accept_focus (child, hint);
+          return_focusable = mx_focusable_accept_focus (MX_FOCUSABLE (child),
+                                                        hint);
 
           if (return_focusable)
             {
-              update_adjustments (MX_BOX_LAYOUT (focusable), child);
+              update_adjustments (MX_BOX_LAYOUT (focusable),
+                                  MX_FOCUSABLE (child));
               break;
             }
         }
     }
 
-  g_list_free (list);
-  g_list_free (children);
-
   return return_focusable;
 }
 
@@ -601,6 +648,10 @@ mx_box_layout_get_property (GObject    *object,
       g_value_set_boolean (value, priv->scroll_to_focused);
       break;
 
+    case PROP_PREFETCH_TEXT_SIZES:
+      g_value_set_boolean (value, priv->prefetch_text_sizes);
+      break;
+
     case PROP_HADJUST:
       scrollable_get_adjustments (MX_SCROLLABLE (object), &adjustment, NULL);
       g_value_set_object (value, adjustment);
@@ -638,6 +689,10 @@ mx_box_layout_set_property (GObject      *object,
       mx_box_layout_set_enable_animations (box, g_value_get_boolean (value));
       break;
 
+    case PROP_PREFETCH_TEXT_SIZES:
+      mx_box_layout_set_prefetch_text_sizes (box, g_value_get_boolean (value));
+      break;
+
     case PROP_HADJUST:
       scrollable_set_adjustments (MX_SCROLLABLE (object),
                                   g_value_get_object (value),
@@ -693,9 +748,26 @@ mx_box_layout_finalize (GObject *object)
       priv->start_allocations = NULL;
     }
 
+  g_array_free (priv->offsets, TRUE);
+  _mx_box_array_free (priv->boxes);
+
   G_OBJECT_CLASS (mx_box_layout_parent_class)->finalize (object);
 }
 
+/* measures the texts under @box on worker threads, once after each
+ * relayout, before the children are asked for their size */
+static void
+mx_box_layout_prefetch_text_sizes (MxBoxLayout *box)
+{
+  MxBoxLayoutPrivate *priv = box->priv;
+
+  if (!priv->prefetch_text_sizes || priv->text_prefetched)
+    return;
+
+  priv->text_prefetched = TRUE;
+  _mx_label_prefetch_text_sizes (CLUTTER_ACTOR (box));
+}
+
 static void
 mx_box_layout_get_preferred_width (ClutterActor *actor,
                                    gfloat        for_height,
@@ -707,14 +779,18 @@ mx_box_layout_get_preferred_width (ClutterActor *actor,
   gint n_children = 0;
   ClutterActorIter iter;
   ClutterActor *child;
+  gfloat min_width, natural_width;
+
+  if (priv->width_valid && priv->width_for_height == for_height)
+    goto out;
+
+  mx_box_layout_prefetch_text_sizes (MX_BOX_LAYOUT (actor));
 
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
-  if (min_width_p)
-    *min_width_p = 0;
+  min_width = natural_width = 0;
 
-  if (natural_width_p)
-    *natural_width_p = 0;
+  priv->width_for_height = for_height;
 
   if (for_height > 0)
     for_height = MAX (0, for_height - padding.top - padding.bottom);
@@ -742,38 +818,33 @@ mx_box_layout_get_preferred_width (ClutterActor *actor,
 
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
         {
-          if (min_width_p)
-            *min_width_p = MAX (child_min, *min_width_p);
-
-          if (natural_width_p)
-            *natural_width_p = MAX (child_nat, *natural_width_p);
+          min_width = MAX (child_min, min_width);
+          natural_width = MAX (child_nat, natural_width);
         }
       else
         {
-          if (min_width_p)
-            *min_width_p += child_min;
-
-          if (natural_width_p)
-            *natural_width_p += child_nat;
-
+          min_width += child_min;
+          natural_width += child_nat;
         }
     }
 
 
   if (priv->orientation == MX_ORIENTATION_HORIZONTAL && n_children > 1)
     {
-      if (min_width_p)
-        *min_width_p += priv->spacing * (n_children - 1);
-
-      if (natural_width_p)
-        *natural_width_p += priv->spacing * (n_children - 1);
+      min_width += priv->spacing * (n_children - 1);
+      natural_width += priv->spacing * (n_children - 1);
     }
 
+  priv->min_width = min_width + padding.left + padding.right;
+  priv->natural_width = natural_width + padding.left + padding.right;
+  priv->width_valid = TRUE;
+
+out:
   if (min_width_p)
-    *min_width_p += padding.left + padding.right;
+    *min_width_p = priv->min_width;
 
   if (natural_width_p)
-    *natural_width_p += padding.left + padding.right;
+    *natural_width_p = priv->natural_width;
 }
 
 static void
@@ -787,15 +858,18 @@ mx_box_layout_get_preferred_height (ClutterActor *actor,
   gint n_children = 0;
   ClutterActor *child;
   ClutterActorIter iter;
+  gfloat min_height, natural_height;
 
-  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+  if (priv->height_valid && priv->height_for_width == for_width)
+    goto out;
 
+  mx_box_layout_prefetch_text_sizes (MX_BOX_LAYOUT (actor));
 
-  if (min_height_p)
-    *min_height_p = 0;
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
-  if (natural_height_p)
-    *natural_height_p = 0;
+  min_height = natural_height = 0;
+
+  priv->height_for_width = for_width;
 
   if (for_width > 0)
     for_width = MAX (0, for_width - padding.left - padding.right);
@@ -824,36 +898,44 @@ mx_box_layout_get_preferred_height (ClutterActor *actor,
 
       if (priv->orientation == MX_ORIENTATION_HORIZONTAL)
         {
-          if (min_height_p)
-            *min_height_p = MAX (child_min, *min_height_p);
-
-          if (natural_height_p)
-            *natural_height_p = MAX (child_nat, *natural_height_p);
+          min_height = MAX (child_min, min_height);
+          natural_height = MAX (child_nat, natural_height);
         }
       else
         {
-          if (min_height_p)
-            *min_height_p += child_min;
-
-          if (natural_height_p)
-            *natural_height_p += child_nat;
+          min_height += child_min;
+          natural_height += child_nat;
         }
     }
 
   if (priv->orientation == MX_ORIENTATION_VERTICAL && n_children > 1)
     {
-      if (min_height_p)
-        *min_height_p += priv->spacing * (n_children - 1);
-
-      if (natural_height_p)
-        *natural_height_p += priv->spacing * (n_children - 1);
+      min_height += priv->spacing * (n_children - 1);
+      natural_height += priv->spacing * (n_children - 1);
     }
 
+  priv->min_height = min_height + padding.top + padding.bottom;
+  priv->natural_height = natural_height + padding.top + padding.bottom;
+  priv->height_valid = TRUE;
+
+out:
   if (min_height_p)
-    *min_height_p += padding.top + padding.bottom;
+    *min_height_p = priv->min_height;
 
   if (natural_height_p)
-    *natural_height_p += padding.top + padding.bottom;
+    *natural_height_p = priv->natural_height;
+}
+
+static void
+mx_box_layout_queue_relayout (ClutterActor *actor)
+{
+  MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
+
+  priv->width_valid = FALSE;
+  priv->height_valid = FALSE;
+  priv->text_prefetched = FALSE;
+
+  CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->queue_relayout (actor);
 }
 
 static void
@@ -985,29 +1067,36 @@ mx_box_layout_allocate (ClutterActor          *actor,
   gfloat actual_size = 0;
   ClutterActor *child;
   ClutterActorIter iter;
-  gint n_expand_children, n_children;
+  gint n_expand_children, n_children, i;
+  guint child_index;
   GList *boxes = NULL, *l;
+  MX_TRACE_BEGIN (mx_box_layout_allocate);
 
   CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->allocate (actor, box,
                                                               flags);
 
+  _mx_box_layout_invalidate_offsets (MX_BOX_LAYOUT (actor));
+
   if (clutter_actor_get_n_children (actor) == 0)
-    return;
+    {
+      MX_TRACE_END (mx_box_layout_allocate);
+      return;
+    }
 
   /* count the number of children with expand set to TRUE and the
    * amount of visible children.
    */
   n_children = n_expand_children = 0;
   clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
+  for (child_index = 0; clutter_actor_iter_next (&iter, &child); child_index++)
     {
       if (CLUTTER_ACTOR_IS_VISIBLE (child))
         {
           MxBoxLayoutChild *meta;
 
           meta = (MxBoxLayoutChild*)
-            clutter_container_get_child_meta ((ClutterContainer *) actor,
-                                              child);
+            _mx_container_get_child_meta_at ((ClutterContainer *) actor,
+                                             child, child_index);
           n_children++;
 
           if (meta->expand)
@@ -1017,7 +1106,10 @@ mx_box_layout_allocate (ClutterActor          *actor,
 
   /* We have no visible children, so bail out */
   if (n_children == 0)
-    return;
+    {
+      MX_TRACE_END (mx_box_layout_allocate);
+      return;
+    }
 
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
 
@@ -1093,9 +1185,10 @@ mx_box_layout_allocate (ClutterActor          *actor,
     position = padding.left;
 
   clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
+  for (child_index = 0; clutter_actor_iter_next (&iter, &child); child_index++)
     {
       ClutterActorBox child_box, old_child_box;
+      MxMeasuredSize measured = { 0, };
       gfloat child_nat, child_min;
       MxBoxLayoutChild *meta;
 
@@ -1103,13 +1196,19 @@ mx_box_layout_allocate (ClutterActor          *actor,
         continue;
 
       meta = (MxBoxLayoutChild*)
-        clutter_container_get_child_meta ((ClutterContainer *) actor, child);
+        _mx_container_get_child_meta_at ((ClutterContainer *) actor, child,
+                                         child_index);
 
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
         {
           clutter_actor_get_preferred_height (child, avail_width,
                                               &child_min, &child_nat);
 
+          measured.has_height = TRUE;
+          measured.height_for_width = avail_width;
+          measured.min_height = child_min;
+          measured.natural_height = child_nat;
+
           child_box.y1 = position;
 
           if (allocate_pref && meta->expand)
@@ -1125,6 +1224,11 @@ mx_box_layout_allocate (ClutterActor          *actor,
           clutter_actor_get_preferred_width (child, avail_height,
                                              &child_min, &child_nat);
 
+          measured.has_width = TRUE;
+          measured.width_for_height = avail_height;
+          measured.min_width = child_min;
+          measured.natural_width = child_nat;
+
           child_box.x1 = position;
 
           if (allocate_pref && meta->expand)
@@ -1141,64 +1245,25 @@ mx_box_layout_allocate (ClutterActor          *actor,
 
       /* Adjust the box for alignment/fill */
       old_child_box = child_box;
-      mx_allocate_align_fill (child, &child_box, meta->x_align, meta->y_align,
-                              meta->x_fill, meta->y_fill);
-
-      if (priv->is_animating)
-        {
-          ClutterActorBox *start, *end, now;
-          gdouble alpha;
-
-          start = g_hash_table_lookup (priv->start_allocations, child);
-          end = &child_box;
-          alpha = clutter_timeline_get_progress (priv->timeline);
-
-          if (!start)
-            {
-              /* don't know where this actor was from (possibly recently
-               * added), so just allocate the end co-ordinates */
-              boxes = g_list_prepend (boxes,
-                                      mx_box_layout_child_info_new (child,
-                                                                    child_nat,
-                                                                    child_min,
-                                                                    end));
-              goto next;
-            }
-
-          now.x1 = (int) (start->x1 + (end->x1 - start->x1) * alpha);
-          now.x2 = (int) (start->x2 + (end->x2 - start->x2) * alpha);
-          now.y1 = (int) (start->y1 + (end->y1 - start->y1) * alpha);
-          now.y2 = (int) (start->y2 + (end->y2 - start->y2) * alpha);
-
-          boxes = g_list_prepend (boxes,
-                                  mx_box_layout_child_info_new (child,
-                                                                child_nat,
-                                                                child_min,
-                                                                &now));
-        }
-      else
-        {
-          /* store the allocations in case an animation is needed soon */
-          ClutterActorBox *copy;
-
-          /* update the value in the hash table */
-          if (priv->enable_animations)
-            {
-              copy = g_boxed_copy (CLUTTER_TYPE_ACTOR_BOX, &child_box);
-              g_hash_table_insert (priv->start_allocations, child, copy);
-            }
-          else
-            {
-              copy = &child_box;
-            }
+      _mx_allocate_align_fill_measured (child, &child_box,
+                                        meta->x_align, meta->y_align,
+                                        meta->x_fill, meta->y_fill,
+                                        &measured);
+
+      /* store the allocations in case an animation is needed soon; while
+       * animating, the children are allocated where they end up, and
+       * moved from where they started when painting */
+      if (!priv->is_animating && priv->enable_animations)
+        g_hash_table_insert (priv->start_allocations, child,
+                             g_boxed_copy (CLUTTER_TYPE_ACTOR_BOX,
+                                           &child_box));
+
+      boxes = g_list_prepend (boxes,
+                              mx_box_layout_child_info_new (child,
+                                                            child_nat,
+                                                            child_min,
+                                                            &child_box));
 
-          boxes = g_list_prepend (boxes,
-                                  mx_box_layout_child_info_new (child,
-                                                                child_nat,
-                                                                child_min,
-                                                                copy));
-        }
-next:
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
         position += (old_child_box.y2 - old_child_box.y1) + priv->spacing;
       else
@@ -1226,7 +1291,7 @@ next:
 
 
       /* the number of children that are still able to be reduced in size */
-      n_children_remaining = g_list_length (boxes);
+      n_children_remaining = n_children;
 
 
       while (actual_size > avail_size && n_children_remaining > 0)
@@ -1295,15 +1360,61 @@ next:
         }
     }
 
-  /* finally, allocate the children */
+  /* finally, allocate the children, and keep where they are for culling */
+  g_array_set_size (priv->offsets, n_children);
+  i = n_children;
   for (l = boxes; l; l = g_list_next (l))
     {
       MxBoxLayoutChildInfo *info = l->data;
+      MxBoxLayoutOffset *offset;
 
       clutter_actor_allocate (info->child, info->box, flags);
+
+      offset = &g_array_index (priv->offsets, MxBoxLayoutOffset, --i);
+      offset->child = info->child;
+
+      if (priv->orientation == MX_ORIENTATION_VERTICAL)
+        {
+          offset->start = info->box->y1;
+          offset->end = info->box->y2;
+        }
+      else
+        {
+          offset->start = info->box->x1;
+          offset->end = info->box->x2;
+        }
+    }
+
+  /* children can overlap while animating, or be made smaller by their
+   * alignment */
+  for (i = 1; i < n_children; i++)
+    {
+      MxBoxLayoutOffset *offset =
+        &g_array_index (priv->offsets, MxBoxLayoutOffset, i);
+
+      offset->end = MAX (offset->end, (offset - 1)->end);
+    }
+  for (i = n_children - 2; i >= 0; i--)
+    {
+      MxBoxLayoutOffset *offset =
+        &g_array_index (priv->offsets, MxBoxLayoutOffset, i);
+
+      offset->start = MIN (offset->start, (offset + 1)->start);
+    }
+
+  for (i = 0; i < n_children; i++)
+    {
+      ClutterActor *child =
+        g_array_index (priv->offsets, MxBoxLayoutOffset, i).child;
+      ClutterActorBox child_box;
+
+      clutter_actor_get_allocation_box (child, &child_box);
+      _mx_box_array_append (priv->boxes, child, &child_box);
     }
 
   g_list_free_full (boxes, (GDestroyNotify) mx_box_layout_child_info_free);
+
+  MX_TRACE_END (mx_box_layout_allocate);
 }
 
 static void
@@ -1351,67 +1462,72 @@ mx_box_layout_get_paint_volume (ClutterActor       *actor,
   return TRUE;
 }
 
+/* Paints @child if it is in @box_b. While animating, the child is moved
+ * and scaled from where it was to its allocation. */
 static void
-mx_box_layout_paint (ClutterActor *actor)
+mx_box_layout_paint_child (ClutterActor          *actor,
+                           ClutterActor          *child,
+                           const ClutterActorBox *box_b)
 {
   MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
-  gdouble x, y;
-  ClutterActorBox child_b;
-  ClutterActorBox box_b;
-  ClutterActor *child;
-  ClutterActorIter iter;
+  ClutterActorBox child_b, now, *start = NULL;
 
-  CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->paint (actor);
+  clutter_actor_get_allocation_box (child, &child_b);
 
-  if (clutter_actor_get_n_children (actor) == 0)
-    return;
+  if (priv->is_animating)
+    start = g_hash_table_lookup (priv->start_allocations, child);
 
-  if (priv->hadjustment)
-    x = mx_adjustment_get_value (priv->hadjustment);
-  else
-    x = 0;
+  if (start)
+    {
+      gdouble alpha = clutter_timeline_get_progress (priv->timeline);
 
-  if (priv->vadjustment)
-    y = mx_adjustment_get_value (priv->vadjustment);
+      now.x1 = (int) (start->x1 + (child_b.x1 - start->x1) * alpha);
+      now.x2 = (int) (start->x2 + (child_b.x2 - start->x2) * alpha);
+      now.y1 = (int) (start->y1 + (child_b.y1 - start->y1) * alpha);
+      now.y2 = (int) (start->y2 + (child_b.y2 - start->y2) * alpha);
+    }
   else
-    y = 0;
+    now = child_b;
 
-  clutter_actor_get_allocation_box (actor, &box_b);
-  box_b.x2 = (box_b.x2 - box_b.x1) + x;
-  box_b.x1 = x;
-  box_b.y2 = (box_b.y2 - box_b.y1) + y;
-  box_b.y1 = y;
+  if (!((now.x1 < box_b->x2) &&
+        (now.x2 > box_b->x1) &&
+        (now.y1 < box_b->y2) &&
+        (now.y2 > box_b->y1)))
+    return;
 
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
+  if (!start)
     {
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
+      clutter_actor_paint (child);
+      return;
+    }
 
-      clutter_actor_get_allocation_box (child, &child_b);
+  cogl_push_matrix ();
 
-      if ((child_b.x1 < box_b.x2) &&
-          (child_b.x2 > box_b.x1) &&
-          (child_b.y1 < box_b.y2) &&
-          (child_b.y2 > box_b.y1))
-        {
-          clutter_actor_paint (child);
-        }
-    }
+  cogl_translate (now.x1, now.y1, 0);
+  if (child_b.x2 > child_b.x1 && child_b.y2 > child_b.y1)
+    cogl_scale ((now.x2 - now.x1) / (child_b.x2 - child_b.x1),
+                (now.y2 - now.y1) / (child_b.y2 - child_b.y1),
+                1);
+  cogl_translate (-child_b.x1, -child_b.y1, 0);
+
+  clutter_actor_paint (child);
+
+  cogl_pop_matrix ();
 }
 
+/* Paints the visible children that are in the scrolled area, starting
+ * from the first one that reaches into it */
 static void
-mx_box_layout_pick (ClutterActor       *actor,
-                    const ClutterColor *color)
+mx_box_layout_paint_children (ClutterActor *actor)
 {
   MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
-  ClutterActor *child;
-  ClutterActorIter iter;
   gdouble x, y;
-  ClutterActorBox child_b;
   ClutterActorBox box_b;
-
-  CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->pick (actor, color);
+  ClutterActor *child;
+  ClutterActorIter iter;
+  gfloat start, end;
+  guint first, last, low, i, n_visible;
+  const guint *visible;
 
   if (clutter_actor_get_n_children (actor) == 0)
     return;
@@ -1426,28 +1542,95 @@ mx_box_layout_pick (ClutterActor       *actor,
   else
     y = 0;
 
-  clutter_actor_get_allocation_box (actor, &box_b);
-  box_b.x2 = (box_b.x2 - box_b.x1) + x;
-  box_b.x1 = x;
-  box_b.y2 = (box_b.y2 - box_b.y1) + y;
-  box_b.y1 = y;
-
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
+  /* paint the children in the tile being rendered instead of the visible
+   * ones, when rendering a tile of the content */
+  if (!_mx_tile_cache_get_render_area (actor, &box_b))
     {
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
-
-      clutter_actor_get_allocation_box (child, &child_b);
+      clutter_actor_get_allocation_box (actor, &box_b);
+      box_b.x2 = (box_b.x2 - box_b.x1) + x;
+      box_b.x1 = x;
+      box_b.y2 = (box_b.y2 - box_b.y1) + y;
+      box_b.y1 = y;
+    }
 
-      if ((child_b.x1 < box_b.x2)
-          && (child_b.x2 > box_b.x1)
-          && (child_b.y1 < box_b.y2)
-          && (child_b.y2 > box_b.y1))
+  /* without an index from the last allocation, or while the children
+   * are away from their allocation, look at every child */
+  if (!priv->offsets->len || priv->is_animating)
+    {
+      clutter_actor_iter_init (&iter, actor);
+      while (clutter_actor_iter_next (&iter, &child))
         {
-          clutter_actor_paint (child);
+          if (CLUTTER_ACTOR_IS_VISIBLE (child))
+            mx_box_layout_paint_child (actor, child, &box_b);
         }
+
+      return;
+    }
+
+  if (priv->orientation == MX_ORIENTATION_VERTICAL)
+    {
+      start = box_b.y1;
+      end = box_b.y2;
     }
+  else
+    {
+      start = box_b.x1;
+      end = box_b.x2;
+    }
+
+  /* find the first child that ends after the start of the area */
+  first = 0;
+  last = priv->offsets->len;
+  while (first < last)
+    {
+      guint middle = (first + last) / 2;
+
+      if (g_array_index (priv->offsets, MxBoxLayoutOffset, middle).end > start)
+        last = middle;
+      else
+        first = middle + 1;
+    }
+
+  /* and the first one after it that starts after the end */
+  low = first;
+  last = priv->offsets->len;
+  while (low < last)
+    {
+      guint middle = (low + last) / 2;
+
+      if (g_array_index (priv->offsets, MxBoxLayoutOffset, middle).start < end)
+        low = middle + 1;
+      else
+        last = middle;
+    }
+
+  /* the children in between are only sorted along the orientation, so
+   * each is tested across it too */
+  n_visible = _mx_box_array_cull (priv->boxes, first, last, &box_b, &visible);
+  for (i = 0; i < n_visible; i++)
+    {
+      child = _mx_box_array_get_actor (priv->boxes, visible[i]);
+
+      if (CLUTTER_ACTOR_IS_VISIBLE (child))
+        clutter_actor_paint (child);
+    }
+}
+
+static void
+mx_box_layout_paint (ClutterActor *actor)
+{
+  CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->paint (actor);
+
+  mx_box_layout_paint_children (actor);
+}
+
+static void
+mx_box_layout_pick (ClutterActor       *actor,
+                    const ClutterColor *color)
+{
+  CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->pick (actor, color);
+
+  mx_box_layout_paint_children (actor);
 }
 
 static void
@@ -1467,6 +1650,7 @@ mx_box_layout_class_init (MxBoxLayoutClass *klass)
   actor_class->allocate = mx_box_layout_allocate;
   actor_class->get_preferred_width = mx_box_layout_get_preferred_width;
   actor_class->get_preferred_height = mx_box_layout_get_preferred_height;
+  actor_class->queue_relayout = mx_box_layout_queue_relayout;
   actor_class->apply_transform = mx_box_layout_apply_transform;
   actor_class->get_paint_volume = mx_box_layout_get_paint_volume;
 
@@ -1496,6 +1680,27 @@ mx_box_layout_class_init (MxBoxLayoutClass *klass)
                                 MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, PROP_ENABLE_ANIMATIONS, pspec);
 
+  /**
+   * MxBoxLayout:prefetch-text-sizes:
+   *
+   * Whether to measure the texts of the #MxLabel<!-- -->s inside the box
+   * on worker threads before it is laid out, rather than one after the
+   * other while it is. This is worth it for boxes of many items that each
+   * hold labels, on machines with several processors. The measurements
+   * are shared with the labels through their size cache, so labels that
+   * end up asked for other sizes are measured as usual.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("prefetch-text-sizes",
+                                "Prefetch text sizes",
+                                "Whether to measure the texts of the labels"
+                                " on worker threads",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_PREFETCH_TEXT_SIZES,
+                                   pspec);
+
   pspec = g_param_spec_boolean ("scroll-to-focused",
                                 "Scroll to focused",
                                 "Automatically scroll to the focused actor",
@@ -1553,6 +1758,9 @@ mx_box_layout_init (MxBoxLayout *self)
                                                          (GDestroyNotify)
                                                          mx_box_layout_free_allocation);
 
+  self->priv->offsets = g_array_new (FALSE, FALSE, sizeof (MxBoxLayoutOffset));
+  self->priv->boxes = _mx_box_array_new ();
+
   g_signal_connect (self, "style-changed",
                     G_CALLBACK (mx_box_layout_style_changed), NULL);
 
@@ -1702,6 +1910,49 @@ mx_box_layout_get_enable_animations (MxBoxLayout *box)
   return box->priv->enable_animations;
 }
 
+/**
+ * mx_box_layout_set_prefetch_text_sizes:
+ * @box: A #MxBoxLayout
+ * @prefetch: %TRUE to measure the texts of labels on worker threads
+ *
+ * Sets whether the texts of the labels inside @box are measured on worker
+ * threads before it is laid out. See #MxBoxLayout:prefetch-text-sizes.
+ *
+ * Since: 2.0
+ */
+void
+mx_box_layout_set_prefetch_text_sizes (MxBoxLayout *box,
+                                       gboolean     prefetch)
+{
+  g_return_if_fail (MX_IS_BOX_LAYOUT (box));
+
+  if (box->priv->prefetch_text_sizes != prefetch)
+    {
+      box->priv->prefetch_text_sizes = prefetch;
+      box->priv->text_prefetched = FALSE;
+
+      g_object_notify (G_OBJECT (box), "prefetch-text-sizes");
+    }
+}
+
+/**
+ * mx_box_layout_get_prefetch_text_sizes:
+ * @box: A #MxBoxLayout
+ *
+ * Get the value of the #MxBoxLayout:prefetch-text-sizes property.
+ *
+ * Returns: %TRUE if the texts of labels are measured on worker threads
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_box_layout_get_prefetch_text_sizes (MxBoxLayout *box)
+{
+  g_return_val_if_fail (MX_IS_BOX_LAYOUT (box), FALSE);
+
+  return box->priv->prefetch_text_sizes;
+}
+
 static inline void
 mx_box_layout_set_property_valist (MxBoxLayout  *box,
                                    ClutterActor *actor,
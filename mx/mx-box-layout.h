@@ -115,6 +115,10 @@ void         mx_box_layout_set_scroll_to_focused (MxBoxLayout *box,
                                                   gboolean     scroll_to_focused);
 gboolean     mx_box_layout_get_scroll_to_focused (MxBoxLayout *box);
 
+void         mx_box_layout_set_prefetch_text_sizes (MxBoxLayout *box,
+                                                    gboolean     prefetch);
+gboolean     mx_box_layout_get_prefetch_text_sizes (MxBoxLayout *box);
+
 G_END_DECLS
 
 #endif /* _MX_BOX_LAYOUT_H */
@@ -33,7 +33,14 @@ G_DEFINE_TYPE (MxButtonGroup, mx_button_group, G_TYPE_INITIALLY_UNOWNED)
 struct _MxButtonGroupPrivate
 {
   MxButton *active_button;
-  GSList *children;
+
+  /* the buttons, most recently added first, with the link of each */
+  GQueue      children;
+  GHashTable *links;
+
+  /* the list given out by mx_button_group_get_buttons(), built when it is
+   * asked for */
+  GSList     *buttons;
 
   guint allow_no_active : 1;
 };
@@ -90,16 +97,25 @@ mx_button_group_set_property (GObject      *object,
     }
 }
 
+/* drops the list given out by mx_button_group_get_buttons() */
+static void
+mx_button_group_buttons_changed (MxButtonGroup *group)
+{
+  g_slist_free (group->priv->buttons);
+  group->priv->buttons = NULL;
+}
+
 static void
 mx_button_group_dispose (GObject *object)
 {
   MxButtonGroupPrivate *priv = MX_BUTTON_GROUP (object)->priv;
 
-  if (priv->children)
+  if (priv->children.head)
     {
-      g_slist_foreach (priv->children, (GFunc) g_object_unref, NULL);
-      g_slist_free (priv->children);
-      priv->children = NULL;
+      g_queue_foreach (&priv->children, (GFunc) g_object_unref, NULL);
+      g_queue_clear (&priv->children);
+      g_hash_table_remove_all (priv->links);
+      mx_button_group_buttons_changed (MX_BUTTON_GROUP (object));
     }
 
   priv->active_button = NULL;
@@ -110,6 +126,11 @@ mx_button_group_dispose (GObject *object)
 static void
 mx_button_group_finalize (GObject *object)
 {
+  MxButtonGroupPrivate *priv = MX_BUTTON_GROUP (object)->priv;
+
+  g_hash_table_unref (priv->links);
+  g_slist_free (priv->buttons);
+
   G_OBJECT_CLASS (mx_button_group_parent_class)->finalize (object);
 }
 
@@ -145,6 +166,9 @@ static void
 mx_button_group_init (MxButtonGroup *self)
 {
   self->priv = BUTTON_GROUP_PRIVATE (self);
+
+  g_queue_init (&self->priv->children);
+  self->priv->links = g_hash_table_new (NULL, NULL);
 }
 
 /**
@@ -182,25 +206,21 @@ button_click_intercept (MxButton      *button,
     return FALSE;
 }
 
+/* takes @button out of the group, and finds another button to make active
+ * if it was the active one */
 static void
-button_weak_notify (MxButtonGroup *group,
-                    MxButton      *button)
+mx_button_group_unlink (MxButtonGroup *group,
+                        MxButton      *button,
+                        GList         *link)
 {
   MxButtonGroupPrivate *priv = group->priv;
-  GSList *l, *prev = NULL, *next = NULL;
+  GList *prev, *next;
 
-  for (l = priv->children; l; l = g_slist_next (l))
-    {
-      if ((MxButton *) l->data == button)
-        {
-
-          next = g_slist_next (l);
-          group->priv->children = g_slist_remove (priv->children,
-                                                  button);
-          break;
-        }
-      prev = l;
-    }
+  prev = link->prev;
+  next = link->next;
+  g_queue_delete_link (&priv->children, link);
+  g_hash_table_remove (priv->links, button);
+  mx_button_group_buttons_changed (group);
 
   if (priv->active_button == button)
     {
@@ -219,11 +239,6 @@ button_weak_notify (MxButtonGroup *group,
         {
           mx_button_group_set_active_button (group, (MxButton *) next->data);
         }
-      else if (priv->children)
-        {
-          mx_button_group_set_active_button (group,
-                                             (MxButton *) priv->children->data);
-        }
       else
         {
           mx_button_group_set_active_button (group, NULL);
@@ -231,6 +246,16 @@ button_weak_notify (MxButtonGroup *group,
     }
 }
 
+static void
+button_weak_notify (MxButtonGroup *group,
+                    MxButton      *button)
+{
+  GList *link = g_hash_table_lookup (group->priv->links, button);
+
+  if (link)
+    mx_button_group_unlink (group, button, link);
+}
+
 /**
  * mx_button_group_add:
  * @group: A #MxButtonGroup
@@ -250,7 +275,12 @@ mx_button_group_add (MxButtonGroup   *group,
 
   priv = group->priv;
 
-  priv->children = g_slist_prepend (priv->children, button);
+  if (g_hash_table_lookup (priv->links, button))
+    return;
+
+  g_queue_push_head (&priv->children, button);
+  g_hash_table_insert (priv->links, button, priv->children.head);
+  mx_button_group_buttons_changed (group);
 
   g_signal_connect (button, "notify::toggled",
                     G_CALLBACK (button_toggled_notify_cb), group);
@@ -280,9 +310,8 @@ void
 mx_button_group_remove (MxButtonGroup   *group,
                         MxButton        *button)
 {
-  GSList *l, *prev = NULL, *next;
   MxButtonGroupPrivate *priv;
-  gboolean found;
+  GList *link;
 
   g_return_if_fail (MX_IS_BUTTON_GROUP (group));
   g_return_if_fail (MX_IS_BUTTON (button));
@@ -290,22 +319,10 @@ mx_button_group_remove (MxButtonGroup   *group,
   priv = group->priv;
 
   /* check the button exists in this group */
-  found = FALSE;
-  for (l = priv->children; l; l = g_slist_next (l))
-    {
-      if ((MxButton*) l->data == button)
-        {
-          found = TRUE;
-          break;
-        }
-      prev = l;
-    }
-  if (!found)
+  link = g_hash_table_lookup (priv->links, button);
+  if (!link)
     return;
 
-  next = g_slist_next (l);
-  priv->children = g_slist_remove (priv->children, button);
-
   g_signal_handlers_disconnect_by_func (button, button_toggled_notify_cb,
                                         group);
   g_signal_handlers_disconnect_by_func (button, button_click_intercept, group);
@@ -313,33 +330,7 @@ mx_button_group_remove (MxButtonGroup   *group,
   g_object_weak_unref (G_OBJECT (button), (GWeakNotify) button_weak_notify,
                        group);
 
-  if (priv->active_button == button)
-    {
-      /* Try and select another button if the one we've removed is active.
-       * But we shouldn't do this in the case where we allow no active button.
-       */
-      if (priv->allow_no_active)
-        {
-          mx_button_group_set_active_button (group, NULL);
-        }
-      else if (prev)
-        {
-          mx_button_group_set_active_button (group, (MxButton *) prev->data);
-        }
-      else if (next)
-        {
-          mx_button_group_set_active_button (group, (MxButton *) next->data);
-        }
-      else if (priv->children)
-        {
-          mx_button_group_set_active_button (group,
-                                             (MxButton *) priv->children->data);
-        }
-      else
-        {
-          mx_button_group_set_active_button (group, NULL);
-        }
-    }
+  mx_button_group_unlink (group, button, link);
 }
 
 /**
@@ -359,7 +350,7 @@ mx_button_group_foreach (MxButtonGroup   *group,
   g_return_if_fail (MX_IS_BUTTON_GROUP (group));
   g_return_if_fail (callback != NULL);
 
-  g_slist_foreach (group->priv->children, (GFunc) callback, userdata);
+  g_queue_foreach (&group->priv->children, (GFunc) callback, userdata);
 }
 
 /**
@@ -466,7 +457,16 @@ mx_button_group_get_allow_no_active (MxButtonGroup *group)
 const GSList *
 mx_button_group_get_buttons (MxButtonGroup *group)
 {
+  MxButtonGroupPrivate *priv;
+  GList *l;
+
   g_return_val_if_fail (MX_IS_BUTTON_GROUP (group), NULL);
 
-  return group->priv->children;
+  priv = group->priv;
+
+  if (!priv->buttons)
+    for (l = priv->children.tail; l; l = l->prev)
+      priv->buttons = g_slist_prepend (priv->buttons, l->data);
+
+  return priv->buttons;
 }
@@ -104,6 +104,9 @@ struct _MxButtonPrivate
   guint       icon_visible : 1;
   guint       label_visible : 1;
 
+  /* the icon position the icon and label were last arranged for, or -1 */
+  gint        arranged_position;
+
   ClutterActor *hbox;
   ClutterActor *icon;
   ClutterActor *label;
@@ -810,11 +813,14 @@ mx_button_update_contents (MxButton *self)
   /* ensure the hbox is visible */
   clutter_actor_show (priv->hbox);
 
+  /* The hidden child takes no space, so the arrangement for both is kept
+   * when only one of them is shown; showing and hiding the children is
+   * cheap, rearranging them queues a relayout for each child property.
+   */
   if (icon_visible && !label_visible)
     {
       clutter_actor_show (priv->icon);
       clutter_actor_hide (priv->label);
-      clutter_actor_set_child_below_sibling (priv->hbox, priv->icon, NULL);
       return;
     }
 
@@ -822,7 +828,6 @@ mx_button_update_contents (MxButton *self)
     {
       clutter_actor_hide (priv->icon);
       clutter_actor_show (priv->label);
-      clutter_actor_set_child_below_sibling (priv->hbox, priv->label, NULL);
       return;
     }
 
@@ -830,6 +835,11 @@ mx_button_update_contents (MxButton *self)
   clutter_actor_show (priv->icon);
   clutter_actor_show (priv->label);
 
+  if (priv->arranged_position == priv->icon_position)
+    return;
+
+  priv->arranged_position = priv->icon_position;
+
   switch (priv->icon_position)
     {
     case MX_POSITION_TOP:
@@ -997,6 +1007,8 @@ mx_button_init (MxButton *button)
 
   priv = button->priv = MX_BUTTON_GET_PRIVATE (button);
 
+  priv->arranged_position = -1;
+
   clutter_actor_set_reactive ((ClutterActor *) button, TRUE);
 
   g_signal_connect (button, "style-changed",
@@ -1096,17 +1108,23 @@ mx_button_set_label (MxButton    *button,
                      const gchar *text)
 {
   MxButtonPrivate *priv;
+  gchar *old_text;
 
   g_return_if_fail (MX_IS_BUTTON (button));
 
   priv = button->priv;
 
-  g_free (priv->text);
+  if (!text)
+    text = "";
 
-  if (text)
-    priv->text = g_strdup (text);
-  else
-    priv->text = g_strdup ("");
+  /* the label may show the name of an action instead */
+  if (!g_strcmp0 (priv->text, text) &&
+      !g_strcmp0 (clutter_text_get_text (CLUTTER_TEXT (priv->label)), text))
+    return;
+
+  old_text = priv->text;
+  priv->text = g_strdup (text);
+  g_free (old_text);
 
   clutter_text_set_text (CLUTTER_TEXT (priv->label), priv->text);
 
@@ -1261,6 +1279,14 @@ mx_button_get_action (MxButton *button)
   return button->priv->action;
 }
 
+/* the ClutterText showing the label of @button, for measuring text in its
+ * font */
+ClutterActor *
+_mx_button_get_label (MxButton *button)
+{
+  return button->priv->label;
+}
+
 /**
  * mx_button_set_icon_position:
  * @button: A #MxButton
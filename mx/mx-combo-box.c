@@ -449,7 +449,7 @@ mx_combo_box_action_activated_cb (ClutterActor *menu,
 {
   gint index;
 
-  index = GPOINTER_TO_INT (g_object_get_data ((GObject*) action, "index"));
+  index = g_slist_index (box->priv->actions, action);
   mx_combo_box_set_index (box, index);
 
   /* reset the combobox style */
@@ -457,28 +457,26 @@ mx_combo_box_action_activated_cb (ClutterActor *menu,
 }
 
 static void
-mx_combo_box_update_menu (MxComboBox *box)
+mx_combo_box_insert_action (MxComboBox *box,
+                            MxAction   *action,
+                            gint        position)
 {
   MxComboBoxPrivate *priv = box->priv;
-  GSList *l;
-  gint index;
   MxMenu *menu;
 
+  if (position < 0 || position > g_slist_length (priv->actions))
+    position = -1;
+
+  priv->actions = g_slist_insert (priv->actions,
+                                  g_object_ref_sink (action),
+                                  position);
+
+  /* only the new item is added to the menu */
   menu = mx_widget_get_menu (MX_WIDGET (box));
   if (!menu)
     return;
 
-  mx_menu_remove_all (menu);
-
-  for (index = 0, l = priv->actions; l; l = g_slist_next (l), index++)
-    {
-      MxAction *action;
-
-      action = (MxAction *)l->data;
-      g_object_set_data ((GObject*) action, "index", GINT_TO_POINTER (index));
-
-      mx_menu_add_action (menu, action);
-    }
+  mx_menu_insert_action (menu, action, position);
 
   /* queue a relayout so the combobox size can match the new menu */
   clutter_actor_queue_relayout ((ClutterActor*) box);
@@ -643,6 +641,9 @@ mx_combo_box_init (MxComboBox *self)
   menu = mx_menu_new ();
   mx_widget_set_menu (MX_WIDGET (self), MX_MENU (menu));
 
+  /* the menu is opened often, so it is kept styled while it is hidden */
+  mx_menu_prepare (MX_MENU (menu));
+
   g_signal_connect (menu, "action-activated",
                     G_CALLBACK (mx_combo_box_action_activated_cb),
                     self);
@@ -721,10 +722,7 @@ mx_combo_box_insert_text (MxComboBox  *box,
   action = mx_action_new ();
   mx_action_set_display_name (action, text);
 
-  box->priv->actions = g_slist_insert (box->priv->actions,
-                                       g_object_ref_sink (action),
-                                       position);
-  mx_combo_box_update_menu (box);
+  mx_combo_box_insert_action (box, action, position);
 }
 
 /**
@@ -751,10 +749,7 @@ mx_combo_box_insert_text_with_icon (MxComboBox  *box,
   mx_action_set_display_name (action, text);
   mx_action_set_icon (action, icon);
 
-  box->priv->actions = g_slist_insert (box->priv->actions,
-                                       g_object_ref_sink (action),
-                                       position);
-  mx_combo_box_update_menu (box);
+  mx_combo_box_insert_action (box, action, position);
 }
 
 /**
@@ -806,19 +801,26 @@ mx_combo_box_remove_text (MxComboBox *box,
                           gint        position)
 {
   GSList *item;
+  MxMenu *menu;
 
   g_return_if_fail (MX_IS_COMBO_BOX (box));
   g_return_if_fail (position >= 0);
 
-  /* find the item, free the string and remove it from the list */
+  /* find the item, remove it from the menu and the list */
   item = g_slist_nth (box->priv->actions, position);
 
   if (!item)
     return;
 
+  menu = mx_widget_get_menu (MX_WIDGET (box));
+  if (menu)
+    {
+      mx_menu_remove_action (menu, item->data);
+      clutter_actor_queue_relayout ((ClutterActor*) box);
+    }
+
   g_object_unref (G_OBJECT (item->data));
   box->priv->actions = g_slist_delete_link (box->priv->actions, item);
-  mx_combo_box_update_menu (box);
 }
 
 /**
@@ -834,9 +836,17 @@ mx_combo_box_remove_all (MxComboBox *box)
 {
   MxComboBoxPrivate *priv = box->priv;
   GSList *l;
+  MxMenu *menu;
 
   g_return_if_fail (MX_IS_COMBO_BOX (box));
 
+  menu = mx_widget_get_menu (MX_WIDGET (box));
+  if (menu)
+    {
+      mx_menu_remove_all (menu);
+      clutter_actor_queue_relayout ((ClutterActor*) box);
+    }
+
   l = priv->actions;
   while (l)
     {
@@ -844,8 +854,52 @@ mx_combo_box_remove_all (MxComboBox *box)
       l = g_slist_delete_link (l, l);
     }
   priv->actions = NULL;
+}
+
+/**
+ * mx_combo_box_set_items:
+ * @box: A #MxComboBox
+ * @items: (array zero-terminated=1): a %NULL-terminated array of item names
+ *
+ * Replace the items of @box with @items. This is quicker than appending
+ * each of them in turn when filling a long list.
+ *
+ * Since: 2.0
+ */
+void
+mx_combo_box_set_items (MxComboBox          *box,
+                        const gchar * const *items)
+{
+  MxComboBoxPrivate *priv;
+  MxMenu *menu;
+  GSList *actions = NULL;
+  gint i;
+
+  g_return_if_fail (MX_IS_COMBO_BOX (box));
+
+  priv = box->priv;
+
+  mx_combo_box_remove_all (box);
+
+  if (!items)
+    return;
+
+  menu = mx_widget_get_menu (MX_WIDGET (box));
+
+  for (i = 0; items[i]; i++)
+    {
+      MxAction *action;
+
+      action = mx_action_new ();
+      mx_action_set_display_name (action, items[i]);
+
+      actions = g_slist_prepend (actions, g_object_ref_sink (action));
+
+      if (menu)
+        mx_menu_add_action (menu, action);
+    }
 
-  mx_combo_box_update_menu (box);
+  priv->actions = g_slist_reverse (actions);
 }
 
 /**
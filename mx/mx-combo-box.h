@@ -106,6 +106,8 @@ void mx_combo_box_prepend_text (MxComboBox  *box,
 void mx_combo_box_remove_text  (MxComboBox  *box,
                                 gint         position);
 void mx_combo_box_remove_all   (MxComboBox *box);
+void mx_combo_box_set_items    (MxComboBox          *box,
+                                const gchar * const *items);
 
 void         mx_combo_box_set_active_text (MxComboBox  *box,
                                            const gchar *text);
@@ -2,7 +2,7 @@
 /*
  * makecache.c: creating a texture cache
  *
- * Copyright 2009 Intel Corporation.
+ * Copyright 2009, 2013 Intel Corporation.
  *
  * This program is free software; you can redistribute it and/or modify it
  * under the terms and conditions of the GNU General Public License,
@@ -19,455 +19,606 @@
  * Boston, MA 02111-1307, USA.
  *
  */
-#define _GNU_SOURCE
+
+/*
+ * Every image of up to 256x256 pixels found under the given directory is
+ * packed into one or more pages, written to /var/cache/mx, and described
+ * by DIRECTORY/mx.cache for mx_texture_cache_load_cache().
+ */
+
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
-#include <sys/types.h>
-#include <dirent.h>
 #include <string.h>
-#include <assert.h>
-#include <stdint.h>
+#include <unistd.h>
 
 #include <glib.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
+#include "mx-texture-cache-file.h"
 
-#ifndef PATH_MAX
-#define PATH_MAX 1024
-#endif
+/* we don't want to do files > 256x256 */
+#define MAX_IMAGE_SIZE 256
+#define PAGE_SIZE 1024
+/* images are surrounded by a copy of their edges, so that filtering
+ * doesn't pick up their neighbours */
+#define PADDING 1
+
+typedef struct
+{
+  gint x, y;
+  gint width, height;
+} Rect;
+
+typedef struct
+{
+  gchar     *filename;
+  GdkPixbuf *pixbuf;
+
+  gint       page;
+  gint       x, y;
+} Image;
+
+typedef struct
+{
+  /* the maximal free rectangles */
+  GArray    *free_rects;
+  gint       width, height;
+  gint       used_area;
+} Page;
+
+static void
+find_images (const gchar *directory,
+             GPtrArray   *images)
+{
+  GDir *dir;
+  const gchar *name;
+  GError *error = NULL;
 
-struct imgcache_element {
-  char  filename[256];
-  int   width, height;
-  int   posX, posY;
-  void *ptr;
-};
+  dir = g_dir_open (directory, 0, &error);
+  if (!dir)
+    {
+      g_printerr ("Error opening %s: %s\n", directory, error->message);
+      g_clear_error (&error);
+      return;
+    }
 
-GList *images;
+  while ((name = g_dir_read_name (dir)))
+    {
+      gchar *fullpath;
 
-int totalarea = 0;
+      if (name[0] == '.')
+        continue;
 
+      fullpath = g_build_filename (directory, name, NULL);
 
-int sizes[] = { 0, 256, 384, 512, 640, 768, 896, 1024, 1280, 1536, 1792,  2048, -1};
+      if (g_file_test (fullpath, G_FILE_TEST_IS_DIR))
+        find_images (fullpath, images);
+      else if (g_file_test (fullpath, G_FILE_TEST_IS_REGULAR))
+        {
+          Image *image = g_slice_new0 (Image);
 
+          image->filename = fullpath;
+          g_ptr_array_add (images, image);
+          continue;
+        }
 
-static gint sort_by_size(gconstpointer a,
-                         gconstpointer b)
-{
-  const struct imgcache_element *A=a, *B=b;
-  if (A->height > B->height)
-    return -1;
-  if (A->height < B->height)
-    return 1;
-  if (A->width > B->width)
-    return -1;
-  if (A->width < B->width)
-    return 1;
-  return 0;
+      g_free (fullpath);
+    }
 
+  g_dir_close (dir);
 }
-static void do_one_file(char *filename)
-{
-  GdkPixbuf *image;
-  struct imgcache_element *element;
 
-  if (strlen(filename) >= 256)
-    return;
+/* runs on a worker thread; each image is only touched by one of them */
+static void
+decode_image (gpointer data,
+              gpointer user_data)
+{
+  Image *image = data;
+  GdkPixbuf *pixbuf;
 
-  image = gdk_pixbuf_new_from_file(filename, NULL);
-  if (!image)
+  pixbuf = gdk_pixbuf_new_from_file (image->filename, NULL);
+  if (!pixbuf)
     return;
 
-  /* we don't want to do files > 256x256 */
-
-  if (gdk_pixbuf_get_width(image) > 256) {
-      gdk_pixbuf_unref(image);
-      return;
-    }
-  if (gdk_pixbuf_get_height(image) > 256) {
-      gdk_pixbuf_unref(image);
-      return;
-    }
-  element = malloc(sizeof(struct imgcache_element));
-  if (!element) {
-      gdk_pixbuf_unref(image);
+  if (gdk_pixbuf_get_width (pixbuf) > MAX_IMAGE_SIZE ||
+      gdk_pixbuf_get_height (pixbuf) > MAX_IMAGE_SIZE)
+    {
+      g_object_unref (pixbuf);
       return;
     }
 
-  memset(element, 0, sizeof(struct imgcache_element));
-  element->width = gdk_pixbuf_get_width(image);
-  element->height = gdk_pixbuf_get_height(image);
-  element->posX = -1;
-  element->posY = -1;
-  element->ptr = image;
-  totalarea += element->width * element->height;
-  strncpy(element->filename, filename, 256);
-
-  if (element->width > sizes[0])
-    sizes[0] = element->width;
-
-  images = g_list_append(images, element);
+  if (!gdk_pixbuf_get_has_alpha (pixbuf))
+    {
+      image->pixbuf = gdk_pixbuf_add_alpha (pixbuf, FALSE, 0, 0, 0);
+      g_object_unref (pixbuf);
+    }
+  else
+    image->pixbuf = pixbuf;
 }
 
-static int get_effective_Y(int X1,
-                           int X2)
+static void
+decode_images (GPtrArray *images)
 {
-  int Y = 0;
-  GList *item;
-  struct imgcache_element *element;
-  item = g_list_first(images);
-  while (item) {
-      element = item->data;
-      item = g_list_next(item);
-      if (element->posX == -1)
-        continue;
-      if (element->posX >= X2)
-        continue;
-      if (element->posX + element->width <= X1)
-        continue;
-      /* at this point we know the element overlaps our range */
-      if (element->posY + element->height > Y)
-        Y = element->posY + element->height;
+  GThreadPool *pool;
+  guint i;
+
+  pool = g_thread_pool_new (decode_image, NULL,
+#ifdef _SC_NPROCESSORS_ONLN
+                            sysconf (_SC_NPROCESSORS_ONLN),
+#else
+                            1,
+#endif
+                            FALSE, NULL);
+
+  for (i = 0; i < images->len; i++)
+    {
+      if (pool)
+        g_thread_pool_push (pool, images->pdata[i], NULL);
+      else
+        decode_image (images->pdata[i], NULL);
     }
-  return Y;
 
+  if (pool)
+    g_thread_pool_free (pool, FALSE, TRUE);
 }
 
-static inline uint32_t get_pixel(struct imgcache_element *element,
-                                 int                      X,
-                                 int                      Y)
+static void
+image_free (Image *image)
 {
-  GdkPixbuf *buf;
-  unsigned char *p;
-  buf = element->ptr;
-
-  p = gdk_pixbuf_get_pixels(buf);
-  p += Y * gdk_pixbuf_get_rowstride(buf);
-  p += X * 4;
+  g_free (image->filename);
+  if (image->pixbuf)
+    g_object_unref (image->pixbuf);
 
-  return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+  g_slice_free (Image, image);
 }
 
-static int can_scooch(struct imgcache_element *one,
-                      struct imgcache_element *two)
+static gint
+sort_by_size (gconstpointer a,
+              gconstpointer b)
 {
-  int i,x,y;
+  const Image *A = *(const Image **) a;
+  const Image *B = *(const Image **) b;
+  gint width_a, height_a, width_b, height_b;
 
-  if (!one)
-    return 0;
-  if (!two)
-    return 0;
+  width_a = gdk_pixbuf_get_width (A->pixbuf);
+  height_a = gdk_pixbuf_get_height (A->pixbuf);
+  width_b = gdk_pixbuf_get_width (B->pixbuf);
+  height_b = gdk_pixbuf_get_height (B->pixbuf);
 
-  if (one->posY != two->posY)
-    return 0;
-  if (one->height != two->height)
-    return 0;
-  if (one->posX + one->width != two->posX)
-    return 0;
+  /* longest side first, then biggest */
+  if (MAX (width_a, height_a) != MAX (width_b, height_b))
+    return MAX (width_b, height_b) - MAX (width_a, height_a);
 
-
-  i = 0;
-
-  while (i < one->width && i < two->width) {
-      i ++;
-      for (y = 0; y < one->height; y++) {
-          for (x = 0; x < i; x++ ) {
-              int p1, p2;
-
-              p1 = get_pixel(one, one->width - i + x,y);
-              p2 = get_pixel(two, x, y);
-              if ( p1 != p2)
-                return i-1;
-            }
-        }
-    }
-  return i;
+  return width_b * height_b - width_a * height_a;
 }
-static int do_placement(int maxX)
+
+static Page *
+page_new (void)
 {
-  int maxY;
-  int X, Y, baseY;
-  int tempY, tempX, biggestX = -1;
-  struct imgcache_element *element, *element2, *prev = NULL;
-  GList *item, *item2;
-  int workdone = 1;
+  Page *page = g_slice_new0 (Page);
+  Rect rect = { 0, 0, PAGE_SIZE, PAGE_SIZE };
 
-  maxY = 0;
+  page->free_rects = g_array_new (FALSE, FALSE, sizeof (Rect));
+  g_array_append_val (page->free_rects, rect);
 
-  X = 0;
-  Y = 0;
+  return page;
+}
 
+static void
+page_free (Page *page)
+{
+  g_array_free (page->free_rects, TRUE);
+  g_slice_free (Page, page);
+}
 
-  while (workdone) {
-      workdone = 0;
+/* MaxRects, best short side fit: returns the score of the best place for
+ * a @width x @height rectangle on @page, the lower the better, or
+ * G_MAXINT if it doesn't fit */
+static gint
+page_find (Page *page,
+           gint  width,
+           gint  height,
+           gint *x,
+           gint *y)
+{
+  gint best = G_MAXINT;
+  guint i;
 
-      X = 0;
-      item = g_list_first(images);
-      while (item) {
-          int sc;
-          element = item->data;
-          item = g_list_next(item);
+  for (i = 0; i < page->free_rects->len; i++)
+    {
+      Rect *rect = &g_array_index (page->free_rects, Rect, i);
+      gint score;
 
-          if (element->posX != -1)               /* already placed */
-            continue;
+      if (rect->width < width || rect->height < height)
+        continue;
 
-          /* first, check if we fit */
-          if (X + element->width > maxX)
-            continue;
+      score = MIN (rect->width - width, rect->height - height);
+      if (score < best)
+        {
+          best = score;
+          *x = rect->x;
+          *y = rect->y;
+        }
+    }
 
-          tempY = get_effective_Y(X, X + element->width);
+  return best;
+}
 
-          element->posX = X;
-          element->posY = tempY;
-          workdone ++;
+static gboolean
+rect_contains (const Rect *a,
+               const Rect *b)
+{
+  return b->x >= a->x && b->y >= a->y &&
+    b->x + b->width <= a->x + a->width &&
+    b->y + b->height <= a->y + a->height;
+}
 
+static void
+page_place (Page       *page,
+            const Rect *used)
+{
+  GArray *rects = page->free_rects;
+  guint i, j, n_rects;
+
+  /* split every free rectangle overlapping the used one into the (up to
+   * four) maximal rectangles around it */
+  n_rects = rects->len;
+  for (i = 0; i < n_rects; )
+    {
+      Rect free_rect = g_array_index (rects, Rect, i);
+      Rect rect;
+
+      if (used->x >= free_rect.x + free_rect.width ||
+          used->x + used->width <= free_rect.x ||
+          used->y >= free_rect.y + free_rect.height ||
+          used->y + used->height <= free_rect.y)
+        {
+          i++;
+          continue;
+        }
 
-          sc = can_scooch(prev, element);
+      if (used->x > free_rect.x)
+        {
+          rect = free_rect;
+          rect.width = used->x - free_rect.x;
+          g_array_append_val (rects, rect);
+        }
 
-          element->posX -= sc;
+      if (used->x + used->width < free_rect.x + free_rect.width)
+        {
+          rect = free_rect;
+          rect.x = used->x + used->width;
+          rect.width = free_rect.x + free_rect.width - rect.x;
+          g_array_append_val (rects, rect);
+        }
 
-          if (element->posY + element->height > maxY)
-            maxY = element->posY + element->height;
+      if (used->y > free_rect.y)
+        {
+          rect = free_rect;
+          rect.height = used->y - free_rect.y;
+          g_array_append_val (rects, rect);
+        }
 
-          prev = element;
+      if (used->y + used->height < free_rect.y + free_rect.height)
+        {
+          rect = free_rect;
+          rect.y = used->y + used->height;
+          rect.height = free_rect.y + free_rect.height - rect.y;
+          g_array_append_val (rects, rect);
+        }
 
+      /* keep the order, so the new rectangles stay after the ones left
+       * to split */
+      g_array_remove_index (rects, i);
+      n_rects--;
+    }
 
-          /* shortcut .. find other icons that fit us without expanding vertically*/
+  /* drop the rectangles contained in others */
+  for (i = 0; i < rects->len; )
+    {
+      gboolean redundant = FALSE;
 
-          tempX = X;
-          tempY += element->height;
-repeat:
-          biggestX = -1;
-          item2 = item;
-          baseY = element->posY + element->height;
-          while (item2 && !sc) {
-              element2 = item2->data;
-              item2 = g_list_next(item2);
-              if (element2->posX != -1)
-                continue;
-              if (tempX + element2->width > X + element->width)
-                continue;
-              if (element2->height > maxY - baseY)
-                continue;
+      for (j = 0; j < rects->len && !redundant; j++)
+        redundant = (j != i &&
+                     rect_contains (&g_array_index (rects, Rect, j),
+                                    &g_array_index (rects, Rect, i)));
 
-              tempY = get_effective_Y(tempX, tempX+element2->width);
+      if (redundant)
+        g_array_remove_index_fast (rects, i);
+      else
+        i++;
+    }
 
-              if (element2->height > maxY - tempY)
-                continue;
-              element2->posX = tempX;
-              element2->posY = tempY;
+  page->width = MAX (page->width, used->x + used->width);
+  page->height = MAX (page->height, used->y + used->height);
+  page->used_area += used->width * used->height;
+}
 
-              if (element2->posX + element2->width > biggestX && element2->width != element->width)
-                biggestX = element2->posX + element2->width;
-              if (element2->width == element->width)
-                biggestX = -1;
-              workdone++;
-              prev = NULL;
-            }
-          if (biggestX > 0) {
-              tempX = biggestX;
-              goto repeat;
+static GPtrArray *
+place_images (GPtrArray *images)
+{
+  GPtrArray *pages;
+  guint i, j;
+
+  pages = g_ptr_array_new_with_free_func ((GDestroyNotify) page_free);
+
+  for (i = 0; i < images->len; i++)
+    {
+      Image *image = images->pdata[i];
+      gint best = G_MAXINT, best_page = -1, x, y;
+      Rect used;
+
+      used.width = gdk_pixbuf_get_width (image->pixbuf) + 2 * PADDING;
+      used.height = gdk_pixbuf_get_height (image->pixbuf) + 2 * PADDING;
+
+      for (j = 0; j < pages->len; j++)
+        {
+          gint score = page_find (pages->pdata[j], used.width, used.height,
+                                  &x, &y);
+
+          if (score < best)
+            {
+              best = score;
+              best_page = j;
+              used.x = x;
+              used.y = y;
             }
-          X = element->posX +  element->width;
         }
-    }
 
-  X = 0;
-  Y = 0;
-  /* find the bounding box */
-  item = g_list_first(images);
-  while (item) {
-      element = item->data;
-      item = g_list_next(item);
-      if (element->posX + element->width > X)
-        X = element->posX + element->width;
-      if (element->posY + element->height > Y)
-        Y = element->posY + element->height;
+      /* start a new page when the image doesn't fit on any */
+      if (best_page == -1)
+        {
+          g_ptr_array_add (pages, page_new ());
+          best_page = pages->len - 1;
+          page_find (pages->pdata[best_page], used.width, used.height,
+                     &used.x, &used.y);
+        }
+
+      page_place (pages->pdata[best_page], &used);
+
+      image->page = best_page;
+      image->x = used.x + PADDING;
+      image->y = used.y + PADDING;
     }
 
-  /* penalties for getting too big for a texture */
-  if (X > 2048)
-    X *= 4;
-  if (Y > 2048)
-    Y *= 4;
-  return X * Y;
+  return pages;
 }
 
-static void clear_placement(void)
+static void
+copy_image (Image     *image,
+            GdkPixbuf *page)
 {
-  struct imgcache_element *element;
-  GList *item;
-
-  /* find the bounding box */
-  item = g_list_first(images);
-  while (item) {
-      element = item->data;
-      item = g_list_next(item);
-      element->posX = -1;
-      element->posY = -1;
-    }
+  gint width = gdk_pixbuf_get_width (image->pixbuf);
+  gint height = gdk_pixbuf_get_height (image->pixbuf);
+  gint x = image->x, y = image->y;
+
+  gdk_pixbuf_copy_area (image->pixbuf, 0, 0, width, height, page, x, y);
+
+  /* extrude the edges into the padding, rows first so the corners are
+   * filled by the columns */
+  gdk_pixbuf_copy_area (page, x, y, width, 1, page, x, y - 1);
+  gdk_pixbuf_copy_area (page, x, y + height - 1, width, 1,
+                        page, x, y + height);
+  gdk_pixbuf_copy_area (page, x, y - 1, 1, height + 2, page, x - 1, y - 1);
+  gdk_pixbuf_copy_area (page, x + width - 1, y - 1, 1, height + 2,
+                        page, x + width, y - 1);
 }
 
-static void optimal_placement(void)
+static gboolean
+write_pages (GPtrArray  *images,
+             GPtrArray  *pages,
+             gchar     **page_files)
 {
-  int bestX = -1;
-  int best_score = INT_MAX;
-  int score;
-  int i;
-  int minX;
-  i = 0;
-
-  /* skip X values that would lead to a too large Y dimension */
-  minX = totalarea / 2048;
-
-  if (minX > 1000)
-    minX = 0;
-  while (sizes[i] > 0) {
-      if (sizes[i] < minX) {
-          i++;
-          continue;
-        }
-      score = do_placement(sizes[i]);
-      if (score < best_score) {
-          bestX = sizes[i];
-          best_score = score;
-        }
-      clear_placement();
-      i++;
-    }
+  guint i, j;
 
-  do_placement(bestX);
-  printf("Best score is %i, %0.1f %% waste\n", best_score, (100.0*best_score / totalarea) -100.0);
-}
+  for (i = 0; i < pages->len; i++)
+    {
+      Page *page = pages->pdata[i];
+      GdkPixbuf *pixbuf;
+      GError *error = NULL;
+      gboolean saved;
 
-static int make_final_image(char *filename)
-{
-  int maxX = 0, maxY = 0;
-  struct imgcache_element *element;
-  GList *item;
-  GdkPixbuf *final;
-
-  /* find the bounding box */
-  item = g_list_first(images);
-  while (item) {
-      element = item->data;
-      item = g_list_next(item);
-      if (element->posX + element->width > maxX)
-        maxX = element->posX + element->width;
-      if (element->posY + element->height > maxY)
-        maxY = element->posY + element->height;
-    }
+      pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8,
+                               page->width, page->height);
+      gdk_pixbuf_fill (pixbuf, 0);
 
-  printf("Final image is %ix%i\n", maxX, maxY);
+      for (j = 0; j < images->len; j++)
+        {
+          Image *image = images->pdata[j];
 
-  if (!maxX)
-    return 0;
-  if (!maxY)
-    return 0;
-  final = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, maxX, maxY);
-  assert(final != NULL);
+          if (image->page == (gint) i)
+            copy_image (image, pixbuf);
+        }
 
-  item = g_list_first(images);
-  while (item) {
-      element = item->data;
-      item = g_list_next(item);
-      if (element->posX == -1)
-        continue;
-      gdk_pixbuf_copy_area(element->ptr, 0, 0, element->width, element->height, final, element->posX, element->posY);
+      saved = gdk_pixbuf_save (pixbuf, page_files[i], "png", &error, NULL);
+      g_object_unref (pixbuf);
+
+      if (!saved)
+        {
+          g_printerr ("Cannot write %s: %s\n", page_files[i], error->message);
+          g_error_free (error);
+          return FALSE;
+        }
+
+      printf ("Page %u is %ix%i, %0.1f %% waste\n", i, page->width,
+              page->height,
+              100.0 - (100.0 * page->used_area) /
+              (page->width * page->height));
     }
 
-  gdk_pixbuf_save(final, filename, "png", NULL, NULL);
-  return 1;
+  return TRUE;
 }
 
-static void makecache(char *directory,
-                      int   recurse)
+/* writes the index, in the format described in mx-texture-cache-file.h */
+static gboolean
+write_cache_file (const gchar  *directory,
+                  GPtrArray    *images,
+                  GPtrArray    *pages,
+                  gchar       **page_files)
 {
-  GDir *dir;
+  MxTextureCacheFileHeader header;
+  MxTextureCacheFilePage *page_table;
+  MxTextureCacheFileEntry *entries;
+  guint32 *buckets;
+  GString *strings;
+  GByteArray *data;
   GError *error = NULL;
-
-  dir = g_dir_open (directory, 0, &error);
-  if (!dir) {
-      printf("Error opening %s: %s\n", directory, error->message);
-      g_clear_error (&error);
-      return;
+  guint n_entries, n_buckets, i;
+  gchar *filename;
+  gboolean result;
+
+  n_buckets = MAX (images->len, 1);
+  buckets = g_new (guint32, n_buckets);
+  for (i = 0; i < n_buckets; i++)
+    buckets[i] = GUINT32_TO_LE (MX_TEXTURE_CACHE_FILE_NONE);
+
+  strings = g_string_new (NULL);
+
+  page_table = g_new0 (MxTextureCacheFilePage, pages->len);
+  for (i = 0; i < pages->len; i++)
+    {
+      Page *page = pages->pdata[i];
+
+      page_table[i].path = GUINT32_TO_LE (strings->len);
+      page_table[i].width = GUINT32_TO_LE (page->width);
+      page_table[i].height = GUINT32_TO_LE (page->height);
+      g_string_append_len (strings, page_files[i],
+                           strlen (page_files[i]) + 1);
     }
 
-  while (TRUE) {
-      const char *name = g_dir_read_name (dir);
-      char *fullpath = g_build_filename (directory, name, NULL);
+  entries = g_new0 (MxTextureCacheFileEntry, images->len);
+  for (i = 0, n_entries = 0; i < images->len; i++)
+    {
+      Image *image = images->pdata[i];
+      guint32 hash, bucket;
+      gchar *uri;
 
-      if (!name)
-        break;
-      if (name[0] == '.')
+      uri = g_filename_to_uri (image->filename, NULL, NULL);
+      if (!uri)
         continue;
-      if (recurse && g_file_test (fullpath, G_FILE_TEST_IS_DIR)) {
-          makecache(fullpath, recurse);
-        }
 
-      if (recurse && g_file_test (fullpath, G_FILE_TEST_IS_REGULAR)) {
-          do_one_file(fullpath);
-        }
+      hash = mx_texture_cache_file_hash (uri);
+      bucket = hash % n_buckets;
+
+      entries[n_entries].uri = GUINT32_TO_LE (strings->len);
+      entries[n_entries].hash = GUINT32_TO_LE (hash);
+      entries[n_entries].next = buckets[bucket];
+      entries[n_entries].page = GUINT32_TO_LE (image->page);
+      entries[n_entries].x = GUINT32_TO_LE (image->x);
+      entries[n_entries].y = GUINT32_TO_LE (image->y);
+      entries[n_entries].width =
+        GUINT32_TO_LE (gdk_pixbuf_get_width (image->pixbuf));
+      entries[n_entries].height =
+        GUINT32_TO_LE (gdk_pixbuf_get_height (image->pixbuf));
+      buckets[bucket] = GUINT32_TO_LE (n_entries);
+      n_entries++;
+
+      g_string_append_len (strings, uri, strlen (uri) + 1);
+      g_free (uri);
+    }
 
-      g_free (fullpath);
-  }
+  memset (&header, 0, sizeof (header));
+
+  data = g_byte_array_new ();
+  g_byte_array_append (data, (guint8 *) &header, sizeof (header));
+  g_byte_array_append (data, (guint8 *) page_table,
+                       pages->len * sizeof (MxTextureCacheFilePage));
+  g_byte_array_append (data, (guint8 *) entries,
+                       n_entries * sizeof (MxTextureCacheFileEntry));
+  g_byte_array_append (data, (guint8 *) buckets, n_buckets * sizeof (guint32));
+  g_byte_array_append (data, (guint8 *) strings->str, strings->len);
+
+  memcpy (header.magic, MX_TEXTURE_CACHE_FILE_MAGIC, sizeof (header.magic));
+  header.version = GUINT32_TO_LE (MX_TEXTURE_CACHE_FILE_VERSION);
+  header.n_pages = GUINT32_TO_LE (pages->len);
+  header.n_entries = GUINT32_TO_LE (n_entries);
+  header.n_buckets = GUINT32_TO_LE (n_buckets);
+  header.strings_size = GUINT32_TO_LE (strings->len);
+  header.checksum =
+    GUINT32_TO_LE (mx_texture_cache_file_checksum (data->data + sizeof (header),
+                                                   data->len - sizeof (header)));
+  memcpy (data->data, &header, sizeof (header));
+
+  filename = g_build_filename (directory, "mx.cache", NULL);
+  result = g_file_set_contents (filename, (gchar *) data->data, data->len,
+                                &error);
+  if (!result)
+    {
+      g_printerr ("Cannot write cache file: %s\n", error->message);
+      g_error_free (error);
+    }
 
-  g_dir_close (dir);
+  g_free (filename);
+  g_byte_array_unref (data);
+  g_string_free (strings, TRUE);
+  g_free (entries);
+  g_free (page_table);
+  g_free (buckets);
 
-  images = g_list_sort(images, sort_by_size);
+  return result;
 }
 
-static void write_cache_file(char *directory,
-                             char *pngfile)
+int
+main (int    argc,
+      char **argv)
 {
-  FILE *file;
-  char *filename = NULL;
-  struct imgcache_element element;
-  struct imgcache_element *elm;
-  GList *item;
+  GPtrArray *images, *pages;
+  gchar *directory, **page_files;
+  guint i;
+  gint status = EXIT_SUCCESS;
+
+  if (argc <= 1)
+    {
+      printf ("Usage:\n\t\tmakecache <directory>\n");
+      return EXIT_FAILURE;
+    }
+
+  g_type_init ();
 
-  memset(&element, 0, sizeof(element));
+  /* the URIs in the cache must be absolute */
+  if (g_path_is_absolute (argv[1]))
+    directory = g_strdup (argv[1]);
+  else
+    {
+      gchar *cwd = g_get_current_dir ();
+      directory = g_build_filename (cwd, argv[1], NULL);
+      g_free (cwd);
+    }
 
-  strcpy(&element.filename[0], pngfile);
+  images = g_ptr_array_new_with_free_func ((GDestroyNotify) image_free);
+  find_images (directory, images);
+  decode_images (images);
 
-  filename = g_strdup_printf("%s/mx.cache", directory);
+  /* keep the images that could be decoded and are small enough */
+  for (i = 0; i < images->len; )
+    {
+      Image *image = images->pdata[i];
 
-  file = fopen(filename, "w");
-  if (!file) {
-      fprintf(stderr, "Cannot write cache file: %s\n", filename);
-      g_free (filename);
-      return;
+      if (image->pixbuf)
+        i++;
+      else
+        g_ptr_array_remove_index_fast (images, i);
     }
-  fwrite(&element, 1, sizeof(element), file);
-
-  item = g_list_first(images);
-  while (item) {
-      elm = item->data;
-      item = g_list_next(item);
-      elm->ptr = NULL;
-      fwrite(elm, 1, sizeof(element), file);
-    }
-  g_free (filename);
-  fclose(file);
 
-}
+  g_ptr_array_sort (images, sort_by_size);
+  pages = place_images (images);
 
-int main(int    argc,
-         char **argv)
-{
-  char *image_file = NULL;
+  g_mkdir_with_parents ("/var/cache/mx", 0755);
 
-  if (argc <= 1) {
-      printf("Usage:\n\t\tmakecache <directory>\n");
-      return EXIT_FAILURE;
-    }
-  g_type_init();
-  makecache(argv[1], 1);
-  optimal_placement();
-  image_file = g_strdup_printf("/var/cache/mx/%08x.png", g_str_hash(argv[1]));
-  if (make_final_image(image_file))
-    write_cache_file(argv[1], image_file);
-  g_free (image_file);
-  return EXIT_SUCCESS;
+  page_files = g_new0 (gchar *, pages->len + 1);
+  for (i = 0; i < pages->len; i++)
+    page_files[i] = g_strdup_printf ("/var/cache/mx/%08x-%u.png",
+                                     g_str_hash (directory), i);
+
+  if (!pages->len ||
+      !write_pages (images, pages, page_files) ||
+      !write_cache_file (directory, images, pages, page_files))
+    status = EXIT_FAILURE;
+
+  g_strfreev (page_files);
+  g_ptr_array_unref (pages);
+  g_ptr_array_unref (images);
+  g_free (directory);
+
+  return status;
 }
@@ -19,26 +19,125 @@
  */
 #include "mx-css.h"
 #include <clutter/clutter.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <unistd.h>
 #include <fcntl.h>
 
+#ifdef G_OS_UNIX
+#include <signal.h>
+#include <glib-unix.h>
+#endif
+
 #include "mx-private.h"
 
 struct _MxStyleSheet
 {
   GList *selectors;
   GList *filenames;
+
+  /* Rule index: each selector in @selectors is also filed in exactly one
+   * bucket, chosen by the most specific part of its rightmost simple
+   * selector (id, then class, then type). Selectors with none of those are
+   * kept in @universal_rules.
+   */
+  GHashTable *id_rules;
+  GHashTable *class_rules;
+  GHashTable *type_rules;
+  GList      *universal_rules;
+
+  /* GMappedFiles of compiled style sheets, by id; the selectors loaded from
+   * them point into the mapping */
+  GHashTable *mapped_files;
+
+  /* what the selectors in a parent or ancestor position (everything but the
+   * rightmost compound selector) test for, so that a change to a node that
+   * none of them look at does not need to restyle its descendants. These
+   * are rebuilt on demand after the rules change */
+  gboolean    dependencies_dirty;
+  GHashTable *ancestor_ids;
+  GHashTable *ancestor_classes;
+  guint64     ancestor_pseudo_class_mask;
+  gboolean    ancestor_pseudo_class_unmasked;
+
+  /* matches made on worker threads with mx_style_sheet_match_nodes() hold
+   * the lock for reading; changes to the rule index hold it for writing,
+   * and count as a new generation. Only the main thread changes the sheet,
+   * so its own matches go without the lock */
+  GRWLock     lock;
+  guint       generation;
+};
+
+/* A Bloom filter of the types, ids and classes found on a set of nodes.
+ * Each name sets two of the bits, so a filter missing either bit of a name
+ * proves that none of the nodes has it. */
+#define CSS_BLOOM_WORDS 4
+
+typedef struct
+{
+  guint64 bits[CSS_BLOOM_WORDS];
+} MxCssBloom;
+
+typedef enum
+{
+  CSS_BLOOM_TYPE,
+  CSS_BLOOM_ID,
+  CSS_BLOOM_CLASS
+} MxCssBloomKind;
+
+/* What matching needs to know of a type, built once per type and kept as
+ * type data: the score a type selector for the name of the type or of one
+ * of its ancestors contributes, and a filter of those names */
+typedef struct
+{
+  GHashTable *depths;
+  MxCssBloom  bloom;
+} MxCssType;
+
+/* The matching state of a stylable, gathered once per lookup. A lookup uses
+ * an array of these, starting at the stylable itself and followed by each of
+ * its stylable ancestors, so that parent and ancestor selectors can be tested
+ * without querying the actors again.
+ */
+typedef struct
+{
+  GHashTable  *type_depths;
+  const MxCssBloom *type_bloom;
+  GQuark       id;
+  GQuark       class;
+  guint64      pseudo_class_mask;
+  const gchar *pseudo_class;
+
+  /* the types, ids and classes of all the nodes after this one */
+  MxCssBloom   ancestors;
+} MxCssNode;
+
+/* A chain of MxCssNode captured to be matched later, possibly on another
+ * thread; the pseudo-class strings are interned so that they outlive the
+ * stylables */
+struct _MxStyleSheetNodes
+{
+  GArray *chain;
 };
 
+static GQuark quark_type_depths = 0;
+
 typedef struct _MxSelector MxSelector;
 struct _MxSelector
 {
-  gchar *type;
-  gchar *id;
-  gchar *class;
+  /* type, id and class are interned at parse time so that matching is an
+   * integer comparison; a type of 0 is the universal selector */
+  GQuark type;
+  GQuark id;
+  GQuark class;
   gchar *pseudo_class;
+  guint64 pseudo_class_mask;
+  guint n_pseudo_classes;
+  /* set if a pseudo-class could not be given a bit in the mask, in which
+   * case the string must be checked too */
+  gboolean pseudo_class_unmasked;
   MxSelector *parent;
   MxSelector *ancestor;
   GHashTable *style;
@@ -46,23 +145,137 @@ struct _MxSelector
   guint line;
   guint position;
   gint priority;
+  /* the part of the score that does not depend on the node: ids, classes
+   * and pseudo-classes */
+  gint specificity;
+  /* the types, ids and classes the parent and ancestor selectors need to
+   * find among the ancestors of a node, recursively */
+  MxCssBloom ancestor_filter;
+
+  /* only counted with MX_DEBUG=css-profile */
+  guint  profile_attempts;
+  guint  profile_matches;
+  gint64 profile_time;
 };
 
 
 /* MxStyleSheetValue */
 
+GQuark
+mx_style_sheet_error_quark (void)
+{
+  return g_quark_from_static_string ("mx-style-sheet-error-quark");
+}
+
 static MxStyleSheetValue *
-mx_style_sheet_value_new ()
+mx_style_sheet_value_new (const gchar *string,
+                          const gchar *source,
+                          gboolean     owns_string)
 {
-  return g_slice_new0 (MxStyleSheetValue);
+  MxStyleSheetValue *value = g_slice_new0 (MxStyleSheetValue);
+
+  value->string = string;
+  value->source = source;
+  value->owns_string = owns_string;
+
+  /* do the numeric conversions once, rather than every time the value is
+   * read */
+  if (string)
+    {
+      value->int_value = atoi (string);
+      value->float_value = g_ascii_strtod (string, NULL);
+      value->is_pt = g_str_has_suffix (string, "pt");
+    }
+
+  return value;
 }
 
+typedef struct
+{
+  GType   type;
+  gdouble resolution;
+  GValue  value;
+} MxStyleSheetCachedValue;
+
 static void
 mx_style_sheet_value_free (MxStyleSheetValue *value)
 {
+  GSList *l;
+
+  if (value->owns_string)
+    g_free ((gchar *) value->string);
+
+  for (l = value->cached_values; l; l = l->next)
+    {
+      MxStyleSheetCachedValue *cached = l->data;
+
+      g_value_unset (&cached->value);
+      g_slice_free (MxStyleSheetCachedValue, cached);
+    }
+  g_slist_free (value->cached_values);
+
   g_slice_free (MxStyleSheetValue, value);
 }
 
+/*
+ * mx_style_sheet_value_get_cached:
+ * @value: a #MxStyleSheetValue
+ * @type: the type @value is read as
+ * @resolution: the resolution point sizes are converted with, or 0
+ *
+ * Returns: the value previously stored with mx_style_sheet_value_set_cached()
+ *   for @type and @resolution, or %NULL
+ */
+const GValue *
+mx_style_sheet_value_get_cached (MxStyleSheetValue *value,
+                                 GType              type,
+                                 gdouble            resolution)
+{
+  GSList *l;
+
+  for (l = value->cached_values; l; l = l->next)
+    {
+      MxStyleSheetCachedValue *cached = l->data;
+
+      if (cached->type == type)
+        return (cached->resolution == resolution) ? &cached->value : NULL;
+    }
+
+  return NULL;
+}
+
+void
+mx_style_sheet_value_set_cached (MxStyleSheetValue *value,
+                                 gdouble            resolution,
+                                 const GValue      *gvalue)
+{
+  MxStyleSheetCachedValue *cached = NULL;
+  GType type = G_VALUE_TYPE (gvalue);
+  GSList *l;
+
+  /* only keep the latest value for each type */
+  for (l = value->cached_values; l; l = l->next)
+    {
+      if (((MxStyleSheetCachedValue *) l->data)->type == type)
+        {
+          cached = l->data;
+          g_value_unset (&cached->value);
+          break;
+        }
+    }
+
+  if (!cached)
+    {
+      cached = g_slice_new0 (MxStyleSheetCachedValue);
+      cached->type = type;
+      value->cached_values = g_slist_prepend (value->cached_values, cached);
+    }
+
+  cached->resolution = resolution;
+  g_value_init (&cached->value, type);
+  g_value_copy (gvalue, &cached->value);
+}
+
 
 static gchar*
 append (gchar *str1, const gchar *str2)
@@ -203,7 +416,10 @@ css_parse_style (GScanner *scanner, GHashTable *table)
       if (token != G_TOKEN_NONE)
         return token;
 
-      g_hash_table_insert (table, key, value);
+      g_hash_table_insert (table, key,
+                           mx_style_sheet_value_new (value,
+                                                     scanner->input_name,
+                                                     TRUE));
 
       token = g_scanner_peek_next_token (scanner);
     }
@@ -223,6 +439,8 @@ css_parse_simple_selector (GScanner      *scanner,
 {
   guint token;
   gchar *tmp;
+  guint64 bit;
+  gboolean complete;
 
   /* parse optional type (either '*' or an identifier) */
   token = g_scanner_peek_next_token (scanner);
@@ -230,11 +448,11 @@ css_parse_simple_selector (GScanner      *scanner,
     {
     case '*':
       g_scanner_get_next_token (scanner);
-      selector->type = g_strdup ("*");
+      selector->type = 0;
       break;
     case G_TOKEN_IDENTIFIER:
       g_scanner_get_next_token (scanner);
-      selector->type = g_strdup (scanner->value.v_identifier);
+      selector->type = g_quark_from_string (scanner->value.v_identifier);
       break;
     default:
       break;
@@ -252,7 +470,7 @@ css_parse_simple_selector (GScanner      *scanner,
           token = g_scanner_get_next_token (scanner);
           if (token != G_TOKEN_IDENTIFIER)
             return G_TOKEN_IDENTIFIER;
-          selector->id = g_strdup (scanner->value.v_identifier);
+          selector->id = g_quark_from_string (scanner->value.v_identifier);
           break;
           /* class */
         case '.':
@@ -260,7 +478,7 @@ css_parse_simple_selector (GScanner      *scanner,
           token = g_scanner_get_next_token (scanner);
           if (token != G_TOKEN_IDENTIFIER)
             return G_TOKEN_IDENTIFIER;
-          selector->class = g_strdup (scanner->value.v_identifier);
+          selector->class = g_quark_from_string (scanner->value.v_identifier);
           break;
           /* pseudo-class */
         case ':':
@@ -269,6 +487,13 @@ css_parse_simple_selector (GScanner      *scanner,
           if (token != G_TOKEN_IDENTIFIER)
             return G_TOKEN_IDENTIFIER;
 
+          bit = _mx_stylable_pseudo_class_to_mask (scanner->value.v_identifier,
+                                                   &complete);
+          selector->pseudo_class_mask |= bit;
+          selector->n_pseudo_classes++;
+          if (!complete)
+            selector->pseudo_class_unmasked = TRUE;
+
           tmp = selector->pseudo_class;
 
           if (selector->pseudo_class)
@@ -315,11 +540,14 @@ selector_to_string (MxSelector *selector)
   g_free (tmp);
 
   string = g_strdup_printf ("%s%s%s%s%s%s%s",
-                            (selector->type) ?  selector->type : "",
+                            (selector->type)
+                            ? g_quark_to_string (selector->type) : "",
                             (selector->class) ? "." : "",
-                            (selector->class) ? selector->class : "",
+                            (selector->class)
+                            ? g_quark_to_string (selector->class) : "",
                             (selector->id) ? "#" : "",
-                            (selector->id) ? selector->id : "",
+                            (selector->id)
+                            ? g_quark_to_string (selector->id) : "",
                             (selector->pseudo_class) ? ":" : "",
                             (selector->pseudo_class)
                             ? selector->pseudo_class : "");
@@ -373,18 +601,35 @@ mx_selector_free (MxSelector *selector)
   if (!selector)
     return;
 
-  g_free (selector->type);
-  g_free (selector->id);
-  g_free (selector->class);
   g_free (selector->pseudo_class);
 
-  g_hash_table_unref (selector->style);
+  /* only the key selector of a rule has a style */
+  if (selector->style)
+    g_hash_table_unref (selector->style);
 
   mx_selector_free (selector->parent);
+  mx_selector_free (selector->ancestor);
 
   g_slice_free (MxSelector, selector);
 }
 
+static void
+mx_selector_update_specificity (MxSelector *selector)
+{
+  gint a, b;
+
+  if (!selector)
+    return;
+
+  a = (selector->id) ? 10 : 0;
+  b = (10 * selector->n_pseudo_classes) + ((selector->class) ? 10 : 0);
+
+  selector->specificity = (a * 10000) + (b * 100);
+
+  mx_selector_update_specificity (selector->parent);
+  mx_selector_update_specificity (selector->ancestor);
+}
+
 static GTokenType
 css_parse_ruleset (GScanner *scanner, GList **selectors)
 {
@@ -497,7 +742,7 @@ css_parse_block (GScanner *scanner, GList **selectors)
 
 
   /* create a hash table for the properties */
-  table = g_hash_table_new_full (g_str_hash, g_direct_equal, g_free,
+  table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
                                  (GDestroyNotify) mx_style_sheet_value_free);
 
   token = css_parse_style (scanner, table);
@@ -518,11 +763,186 @@ css_parse_block (GScanner *scanner, GList **selectors)
 }
 
 
+static inline void
+css_bloom_add (MxCssBloom     *bloom,
+               MxCssBloomKind  kind,
+               GQuark          name)
+{
+  guint32 hash;
+
+  if (!name)
+    return;
+
+  hash = (((guint32) name << 2) | kind) * 0x9e3779b1;
+
+  bloom->bits[(hash >> 6) % CSS_BLOOM_WORDS] |=
+    G_GUINT64_CONSTANT (1) << (hash & 63);
+  bloom->bits[(hash >> 22) % CSS_BLOOM_WORDS] |=
+    G_GUINT64_CONSTANT (1) << ((hash >> 16) & 63);
+}
+
+static inline void
+css_bloom_union (MxCssBloom       *bloom,
+                 const MxCssBloom *other)
+{
+  gint i;
+
+  for (i = 0; i < CSS_BLOOM_WORDS; i++)
+    bloom->bits[i] |= other->bits[i];
+}
+
+/* whether @bloom may hold everything in @required */
+static inline gboolean
+css_bloom_contains (const MxCssBloom *bloom,
+                    const MxCssBloom *required)
+{
+  gint i;
+
+  for (i = 0; i < CSS_BLOOM_WORDS; i++)
+    {
+      if (required->bits[i] & ~bloom->bits[i])
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* adds what the parent and ancestor selectors of @selector look for, and
+ * what they require of their own ancestors, to @filter */
+static void
+mx_selector_add_ancestor_filter (MxSelector *selector,
+                                 MxCssBloom *filter)
+{
+  MxSelector *above[2];
+  guint i;
+
+  above[0] = selector->parent;
+  above[1] = selector->ancestor;
+
+  for (i = 0; i < G_N_ELEMENTS (above); i++)
+    {
+      if (!above[i])
+        continue;
+
+      css_bloom_add (filter, CSS_BLOOM_TYPE, above[i]->type);
+      css_bloom_add (filter, CSS_BLOOM_ID, above[i]->id);
+      css_bloom_add (filter, CSS_BLOOM_CLASS, above[i]->class);
+      css_bloom_union (filter, &above[i]->ancestor_filter);
+    }
+}
+
+static void
+mx_selector_update_ancestor_filter (MxSelector *selector)
+{
+  if (!selector)
+    return;
+
+  mx_selector_update_ancestor_filter (selector->parent);
+  mx_selector_update_ancestor_filter (selector->ancestor);
+
+  memset (&selector->ancestor_filter, 0, sizeof (MxCssBloom));
+  mx_selector_add_ancestor_filter (selector, &selector->ancestor_filter);
+}
+
+static GHashTable *
+mx_style_sheet_get_bucket (MxStyleSheet *sheet,
+                           MxSelector   *selector,
+                           gpointer     *key)
+{
+  if (selector->id)
+    {
+      *key = GUINT_TO_POINTER (selector->id);
+      return sheet->id_rules;
+    }
+  else if (selector->class)
+    {
+      *key = GUINT_TO_POINTER (selector->class);
+      return sheet->class_rules;
+    }
+  else if (selector->type)
+    {
+      *key = GUINT_TO_POINTER (selector->type);
+      return sheet->type_rules;
+    }
+
+  *key = NULL;
+  return NULL;
+}
+
+static void
+mx_style_sheet_index_selector (MxStyleSheet *sheet,
+                               MxSelector   *selector)
+{
+  GHashTable *bucket;
+  gpointer key;
+  GList *rules;
+
+  sheet->dependencies_dirty = TRUE;
+
+  /* the selector is not visible to matches on other threads yet */
+  mx_selector_update_ancestor_filter (selector);
+
+  bucket = mx_style_sheet_get_bucket (sheet, selector, &key);
+
+  g_rw_lock_writer_lock (&sheet->lock);
+  sheet->generation ++;
+
+  if (!bucket)
+    {
+      sheet->universal_rules = g_list_prepend (sheet->universal_rules,
+                                               selector);
+    }
+  else
+    {
+      rules = g_hash_table_lookup (bucket, key);
+      rules = g_list_prepend (rules, selector);
+      g_hash_table_insert (bucket, key, rules);
+    }
+
+  g_rw_lock_writer_unlock (&sheet->lock);
+}
+
+static void
+mx_style_sheet_unindex_selector (MxStyleSheet *sheet,
+                                 MxSelector   *selector)
+{
+  GHashTable *bucket;
+  gpointer key;
+  GList *rules;
+
+  sheet->dependencies_dirty = TRUE;
+
+  bucket = mx_style_sheet_get_bucket (sheet, selector, &key);
+
+  g_rw_lock_writer_lock (&sheet->lock);
+  sheet->generation ++;
+
+  if (!bucket)
+    {
+      sheet->universal_rules = g_list_remove (sheet->universal_rules,
+                                              selector);
+    }
+  else
+    {
+      rules = g_hash_table_lookup (bucket, key);
+      rules = g_list_remove (rules, selector);
+
+      if (rules)
+        g_hash_table_insert (bucket, key, rules);
+      else
+        g_hash_table_remove (bucket, key);
+    }
+
+  g_rw_lock_writer_unlock (&sheet->lock);
+}
+
+/* parses @filename, or @data, into a list of new selectors; on a parse
+ * error, the selectors parsed so far are still returned */
 static gboolean
-css_parse_file (MxStyleSheet *sheet,
-                gchar        *filename,
-                const gchar  *data,
-                gint          priority)
+css_parse_selectors (gchar        *filename,
+                     const gchar  *data,
+                     gint          priority,
+                     GList       **selectors)
 {
   GScanner *scanner;
   int fd;
@@ -558,7 +978,7 @@ css_parse_file (MxStyleSheet *sheet,
   token = g_scanner_peek_next_token (scanner);
   while (token != G_TOKEN_EOF)
     {
-      token = css_parse_block (scanner, &sheet->selectors);
+      token = css_parse_block (scanner, selectors);
       if (token != G_TOKEN_NONE)
         break;
 
@@ -579,6 +999,29 @@ css_parse_file (MxStyleSheet *sheet,
     return FALSE;
 }
 
+static gboolean
+css_parse_file (MxStyleSheet *sheet,
+                gchar        *filename,
+                const gchar  *data,
+                gint          priority)
+{
+  GList *l, *selectors = NULL;
+  gboolean result;
+
+  result = css_parse_selectors (filename, data, priority, &selectors);
+
+  /* file the new selectors in the rule index before making them visible in
+   * the sheet */
+  for (l = selectors; l; l = l->next)
+    {
+      mx_selector_update_specificity (l->data);
+      mx_style_sheet_index_selector (sheet, l->data);
+    }
+  sheet->selectors = g_list_concat (sheet->selectors, selectors);
+
+  return result;
+}
+
 static gboolean
 list_contains (const gchar *needle,
                gint         needle_len,
@@ -618,61 +1061,168 @@ list_contains (const gchar *needle,
   return FALSE;
 }
 
-static gint
-css_node_matches_selector (MxSelector *selector,
-                           MxStylable *stylable)
+/* Returns the matching data of @type, which maps the name of @type and each
+ * of its ancestors to the score a type selector for that name contributes
+ * when matching an instance of @type. It is built once per type and kept
+ * as type data.
+ */
+static MxCssType *
+css_type_get (GType type)
 {
-  gint score;
-  gint a, b, c;
+  MxCssType *css_type;
+  GType type_id;
+  gint depth;
+
+  css_type = g_type_get_qdata (type, quark_type_depths);
+  if (G_LIKELY (css_type))
+    return css_type;
+
+  css_type = g_new0 (MxCssType, 1);
+  css_type->depths = g_hash_table_new (NULL, NULL);
+
+  /* the closer the matching type is to the node's type, the higher the
+   * score */
+  depth = 10;
+  for (type_id = type; type_id; type_id = g_type_parent (type_id))
+    {
+      GQuark name = g_quark_from_string (g_type_name (type_id));
+
+      g_hash_table_insert (css_type->depths, GUINT_TO_POINTER (name),
+                           GINT_TO_POINTER (depth));
+      css_bloom_add (&css_type->bloom, CSS_BLOOM_TYPE, name);
+
+      if (depth > 1)
+        depth--;
+    }
+
+  g_type_set_qdata (type, quark_type_depths, css_type);
+
+  return css_type;
+}
+
+static GHashTable *
+css_type_get_depths (GType type)
+{
+  return css_type_get (type)->depths;
+}
 
-  const gchar *type = "*";
-  const gchar *class, *pseudo_class;
-  const gchar *id;
+static GArray *
+css_node_chain_new (MxStylable *stylable)
+{
+  GArray *chain;
   ClutterActor *actor;
-  MxStylable *parent;
+  guint i;
 
-  a = 0;
-  b = 0;
-  c = 0;
+  if (G_UNLIKELY (!quark_type_depths))
+    quark_type_depths = g_quark_from_static_string ("mx-css-type-depths");
 
-  /* get properties for this stylable */
-  id = clutter_actor_get_name (CLUTTER_ACTOR (stylable));
-  class = mx_stylable_get_style_class (stylable);
-  pseudo_class = mx_stylable_get_style_pseudo_class (stylable);
+  chain = g_array_sized_new (FALSE, FALSE, sizeof (MxCssNode), 16);
 
-  /* check type */
-  if (selector->type == NULL || selector->type[0] == '*')
+  /* gather the stylable and its stylable ancestors, stopping at the first
+   * parent that is not stylable */
+  for (actor = CLUTTER_ACTOR (stylable);
+       actor && MX_IS_STYLABLE (actor);
+       actor = clutter_actor_get_parent (actor))
     {
-      /* NULL or universal selector match, but are ignored for score */
+      MxStylable *node_stylable = MX_STYLABLE (actor);
+      MxCssNode node;
+      MxCssType *css_type;
+      const gchar *string;
+
+      css_type = css_type_get (G_OBJECT_TYPE (actor));
+      node.type_depths = css_type->depths;
+      node.type_bloom = &css_type->bloom;
+
+      /* strings that have not been interned cannot appear in any selector,
+       * so there is no need to intern them here */
+      string = clutter_actor_get_name (actor);
+      node.id = (string) ? g_quark_try_string (string) : 0;
+
+      string = mx_stylable_get_style_class (node_stylable);
+      node.class = (string) ? g_quark_try_string (string) : 0;
+
+      node.pseudo_class = mx_stylable_get_style_pseudo_class (node_stylable);
+      node.pseudo_class_mask =
+        _mx_stylable_get_style_pseudo_class_mask (node_stylable);
+
+      memset (&node.ancestors, 0, sizeof (MxCssBloom));
+
+      g_array_append_val (chain, node);
     }
-  else
+
+  /* the filter of each node is that of its parent, with the parent added */
+  for (i = chain->len - 1; i > 0; i--)
     {
-      GType type_id;
-      gint matched;
-      gint depth;
+      MxCssNode *parent = &g_array_index (chain, MxCssNode, i);
+      MxCssNode *node = &g_array_index (chain, MxCssNode, i - 1);
 
-      type_id = G_OBJECT_CLASS_TYPE (G_OBJECT_GET_CLASS (stylable));
-      type = g_type_name (type_id);
-      matched = FALSE;
+      node->ancestors = parent->ancestors;
+      css_bloom_union (&node->ancestors, parent->type_bloom);
+      css_bloom_add (&node->ancestors, CSS_BLOOM_ID, parent->id);
+      css_bloom_add (&node->ancestors, CSS_BLOOM_CLASS, parent->class);
+    }
 
-      depth = 10;
-      while (type)
-        {
-          if (!strcmp (selector->type, type))
-            {
-              matched = depth;
-              break;
-            }
-          else
-            {
-              type_id = g_type_parent (type_id);
-              type = g_type_name (type_id);
-              if (depth > 1)
-                depth--;
-            }
-        }
+  return chain;
+}
+
+/* Checks each pseudo-class of @needles appears in @haystack. This is only
+ * needed for pseudo-classes that have no bit in the mask */
+static gboolean
+css_pseudo_classes_contained (const gchar *needles,
+                              const gchar *haystack)
+{
+  const gchar *needle;
+
+  /* if no pseudo class is supplied on the node, return instantly */
+  if (!haystack)
+    return FALSE;
+
+  for (needle = needles; needle; needle = strchr (needle, ':'))
+    {
+      gint needle_len;
+      const gchar *next;
+
+      /* move beyond ':' */
+      if (needle[0] == ':')
+        needle++;
+
+      /* calculate the length of this needle */
+      next = strchr (needle, ':');
+      if (next)
+        needle_len = next - needle;
+      else
+        needle_len = strlen (needle);
+
+      /* if the pseudo-class from the selector does not appear in the
+       * list of pseudo-classes from the node, then this is not a
+       * match */
+      if (!list_contains (needle, needle_len, haystack, ':'))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gint
+css_node_matches_selector (MxSelector *selector,
+                           GArray     *chain,
+                           guint       index)
+{
+  gint c;
+  MxCssNode *node;
+
+  c = 0;
+
+  node = &g_array_index (chain, MxCssNode, index);
+
+  /* check type */
+  if (selector->type)
+    {
+      gint depth;
 
-      if (!matched)
+      depth = GPOINTER_TO_INT (g_hash_table_lookup (node->type_depths,
+                                                    GUINT_TO_POINTER (selector->type)));
+      if (!depth)
         return -1;
       else
         c += depth;
@@ -681,81 +1231,47 @@ css_node_matches_selector (MxSelector *selector,
   /* check id */
   if (selector->id)
     {
-      if (!id || strcmp (selector->id, id))
+      if (selector->id != node->id)
         return -1;
-      else
-        a += 10;
     }
 
-  /* check pseudo_class */
+  /* check pseudo_class: the selector pseudo-class list must be a subset of
+   * the node's pseudo-class list */
   if (selector->pseudo_class)
     {
-      gchar *needle;
-      gint n_matches;
-
-      /* if no pseudo class is supplied on the node, return instantly */
-      if (!pseudo_class)
+      if ((node->pseudo_class_mask & selector->pseudo_class_mask)
+          != selector->pseudo_class_mask)
         return -1;
 
-      /* check that each pseudo-class from the selector appears in the
-       * pseudo-classes from the node, i.e. the selector pseudo-class list
-       * is a subset of the node's pseudo-class list */
-      n_matches = 0;
-      for (needle = selector->pseudo_class;
-           needle; needle = strchr (needle, ':'))
-        {
-          gint needle_len;
-          gchar *next;
-
-          /* move beyond ':' */
-          if (needle[0] == ':')
-            needle++;
-
-          /* calculate the length of this needle */
-          next = strchr (needle, ':');
-          if (next)
-            needle_len = next - needle;
-          else
-            needle_len = strlen (needle);
-
-          /* if the pseudo-class from the selector does not appear in the
-           * list of pseudo-classes from the node, then this is not a
-           * match */
-          if (!list_contains (needle, needle_len, pseudo_class, ':'))
-            return -1;
-          else
-            n_matches++;
-        }
-
-      /* increase the 'b' score by the number of pseudo-classes in the
-       * selector */
-      b = b + (10 * n_matches);
+      if (G_UNLIKELY (selector->pseudo_class_unmasked) &&
+          !css_pseudo_classes_contained (selector->pseudo_class,
+                                         node->pseudo_class))
+        return -1;
     }
 
   /* check class */
   if (selector->class)
     {
-      if (!class || strcmp (selector->class, class))
+      if (selector->class != node->class)
         return -1;
-      else
-        b += 10;
     }
 
-  /* check parent */
-  actor = clutter_actor_get_parent (CLUTTER_ACTOR (stylable));
-  if (MX_IS_STYLABLE (actor))
-    parent = MX_STYLABLE (actor);
-  else
-    parent = NULL;
+  /* reject the rule before walking up the chain if something the parent
+   * or ancestor selectors need is on none of the ancestors */
+  if ((selector->parent || selector->ancestor) &&
+      !css_bloom_contains (&node->ancestors, &selector->ancestor_filter))
+    return -1;
 
+  /* check parent */
   if (selector->parent)
     {
       gint parent_matches;
 
-      if (!parent)
+      if (index + 1 >= chain->len)
         return -1;
 
-      parent_matches = css_node_matches_selector (selector->parent, parent);
+      parent_matches = css_node_matches_selector (selector->parent, chain,
+                                                  index + 1);
       if (parent_matches < 0)
         return -1;
 
@@ -766,47 +1282,29 @@ css_node_matches_selector (MxSelector *selector,
   /* check ancestor */
   if (selector->ancestor)
     {
-      gint ancestor_matches;
-      MxStylable *pparent, *ancestor;
-      ClutterActor *parent_actor;
-
-      if (!parent)
-        return -1;
+      gint ancestor_matches = -1;
+      guint i;
 
-      ancestor = parent;
-      while (ancestor)
+      for (i = index + 1; i < chain->len; i++)
         {
-          parent_actor = clutter_actor_get_parent (CLUTTER_ACTOR (ancestor));
-          if (MX_IS_STYLABLE (parent_actor))
-            pparent = MX_STYLABLE (parent_actor);
-          else
-            pparent = NULL;
-
-
           ancestor_matches = css_node_matches_selector (selector->ancestor,
-                                                        ancestor);
+                                                        chain, i);
 
           /* if one of the ancestors match, stop search and increase 'c' score
            */
           if (ancestor_matches >= 0)
-            {
-              c += ancestor_matches;
-              break;
-            }
-
-          ancestor = pparent;
-          if (!ancestor || !MX_IS_STYLABLE (ancestor))
-            return -1;
+            break;
         }
-    }
 
+      if (ancestor_matches < 0)
+        return -1;
 
-  a = a * 10000;
-  b = b * 100;
-
-  score = a + b + c;
+      c += ancestor_matches;
+    }
 
-  return score;
+  /* the id, class and pseudo-class ('a' and 'b') part of the score was
+   * computed when the selector was created */
+  return selector->specificity + c;
 }
 
 typedef struct _SelectorMatch
@@ -836,30 +1334,119 @@ compare_selector_matches (SelectorMatch *a,
     return 0;
 }
 
-struct _css_table_copy_data
+static void
+css_table_copy (gpointer    key,
+                gpointer    value,
+                GHashTable *table)
 {
-  GHashTable *table;
-  const gchar *filename;
-};
+  g_hash_table_insert (table, key, value);
+}
+
+static void
+free_selector_match (SelectorMatch *data)
+{
+  g_slice_free (SelectorMatch, data);
+}
 
 static void
-css_table_copy (gpointer                    *key,
-                gpointer                    *value,
-                struct _css_table_copy_data *data)
+css_match_rules (GList       *rules,
+                 GArray      *chain,
+                 gboolean     debug,
+                 GList      **matching_selectors)
 {
-  MxStyleSheetValue *css_value;
+  GList *l;
+
+  for (l = rules; l; l = l->next)
+    {
+      gint score;
+
+      if (G_UNLIKELY (debug && _mx_debug (MX_DEBUG_CSS_PROFILE)))
+        {
+          MxSelector *selector = l->data;
+          gint64 start = g_get_monotonic_time ();
+
+          score = css_node_matches_selector (selector, chain, 0);
 
-  css_value = mx_style_sheet_value_new ();
-  css_value->source = data->filename;
-  css_value->string = (gchar*) value;
+          /* the clock is too coarse for a single match, but the error
+           * averages out over many */
+          selector->profile_time += g_get_monotonic_time () - start;
+          selector->profile_attempts ++;
+          if (score >= 0)
+            selector->profile_matches ++;
+        }
+      else
+        score = css_node_matches_selector (l->data, chain, 0);
+
+      if (score >= 0)
+        {
+          SelectorMatch *selector_match = g_slice_new (SelectorMatch);
 
-  g_hash_table_insert (data->table, key, css_value);
+          selector_match->selector = l->data;
+          selector_match->score = score;
+          *matching_selectors = g_list_prepend (*matching_selectors,
+                                                selector_match);
+        }
+    }
 }
 
-static void
-free_selector_match (SelectorMatch *data)
+/* Collects the properties of the rules of @sheet that match the node at the
+ * start of @chain. With @debug, the matches are printed and profiled as
+ * MX_DEBUG asks, which only the main thread may do. */
+static GHashTable *
+css_match_chain (MxStyleSheet *sheet,
+                 GArray       *chain,
+                 gboolean      debug)
 {
-  g_slice_free (SelectorMatch, data);
+  GList *l, *matching_selectors = NULL;
+  GHashTable *result;
+  MxCssNode *css_node;
+  GHashTableIter iter;
+  gpointer type_quark;
+
+  /* find matching selectors, only testing the rules from the buckets that
+   * could apply to this node */
+  css_node = &g_array_index (chain, MxCssNode, 0);
+
+  if (css_node->id)
+    css_match_rules (g_hash_table_lookup (sheet->id_rules,
+                                          GUINT_TO_POINTER (css_node->id)),
+                     chain, debug, &matching_selectors);
+
+  if (css_node->class)
+    css_match_rules (g_hash_table_lookup (sheet->class_rules,
+                                          GUINT_TO_POINTER (css_node->class)),
+                     chain, debug, &matching_selectors);
+
+  /* type selectors also match subclasses, so check the whole ancestry */
+  g_hash_table_iter_init (&iter, css_node->type_depths);
+  while (g_hash_table_iter_next (&iter, &type_quark, NULL))
+    css_match_rules (g_hash_table_lookup (sheet->type_rules, type_quark),
+                     chain, debug, &matching_selectors);
+
+  css_match_rules (sheet->universal_rules, chain, debug, &matching_selectors);
+
+  /* score the selectors by their score */
+  matching_selectors = g_list_sort (matching_selectors,
+                                    (GCompareFunc) compare_selector_matches);
+
+  /* get properties from selector's styles; the values are owned by the
+   * selectors */
+  result = g_hash_table_new (g_str_hash, g_str_equal);
+  for (l = matching_selectors; l; l = l->next)
+    {
+      SelectorMatch *match = l->data;
+
+      g_hash_table_foreach (match->selector->style, (GHFunc) css_table_copy,
+                            result);
+
+      if (debug && _mx_debug (MX_DEBUG_CSS))
+        print_selector (match->selector, match->score);
+    }
+
+  g_list_foreach (matching_selectors, (GFunc) free_selector_match, NULL);
+  g_list_free (matching_selectors);
+
+  return result;
 }
 
 GHashTable *
@@ -867,9 +1454,9 @@ mx_style_sheet_get_properties (MxStyleSheet *sheet,
                                MxStylable   *node)
 {
   GTimer *timer = NULL;
-  GList *l, *matching_selectors = NULL;
-  SelectorMatch *selector_match = NULL;
   GHashTable *result;
+  GArray *chain;
+  MX_TRACE_BEGIN (mx_style_sheet_get_properties);
 
   if (_mx_debug (MX_DEBUG_CSS))
     {
@@ -891,76 +1478,379 @@ mx_style_sheet_get_properties (MxStyleSheet *sheet,
       g_print ("\x1b[22m");
     }
 
-  /* find matching selectors */
-  for (l = sheet->selectors; l; l = l->next)
+  chain = css_node_chain_new (node);
+  result = css_match_chain (sheet, chain, TRUE);
+  g_array_free (chain, TRUE);
+
+  if (_mx_debug (MX_DEBUG_CSS))
     {
-      gint score;
+      g_print ("\x1b[2m");
+      MX_NOTE (CSS, "%fs", g_timer_elapsed (timer, NULL));
+      g_print ("\x1b[0m");
+      g_timer_destroy (timer);
+    }
 
-      score = css_node_matches_selector (l->data, node);
+  MX_TRACE_END (mx_style_sheet_get_properties);
 
-      if (score >= 0)
-        {
-          selector_match = g_slice_new (SelectorMatch);
-          selector_match->selector = l->data;
-          selector_match->score = score;
-          matching_selectors = g_list_prepend (matching_selectors,
-                                               selector_match);
-        }
-    }
+  return result;
+}
 
-  /* score the selectors by their score */
-  matching_selectors = g_list_sort (matching_selectors,
-                                    (GCompareFunc) compare_selector_matches);
+/*
+ * mx_style_sheet_nodes_capture:
+ * @node: a #MxStylable
+ *
+ * Takes a copy of what rules are matched against for @node and its
+ * stylable ancestors, so that they can be matched later on any thread with
+ * mx_style_sheet_match_nodes(). This must be called on the main thread.
+ *
+ * Returns: the captured nodes, to free with mx_style_sheet_nodes_free()
+ */
+MxStyleSheetNodes *
+mx_style_sheet_nodes_capture (MxStylable *node)
+{
+  MxStyleSheetNodes *nodes;
+  guint i;
 
-  /* get properties from selector's styles */
-  result = g_hash_table_new_full (g_str_hash,
-                                  g_str_equal,
-                                  NULL,
-                                  (GDestroyNotify)mx_style_sheet_value_free);
-  for (l = matching_selectors; l; l = l->next)
+  g_return_val_if_fail (MX_IS_STYLABLE (node), NULL);
+
+  nodes = g_slice_new (MxStyleSheetNodes);
+  nodes->chain = css_node_chain_new (node);
+
+  /* the style key of a stylable interns its pseudo-class already, so this
+   * only looks it up */
+  for (i = 0; i < nodes->chain->len; i++)
     {
-      SelectorMatch *match = l->data;
-      struct _css_table_copy_data copy_data;
+      MxCssNode *css_node = &g_array_index (nodes->chain, MxCssNode, i);
 
-      copy_data.filename = match->selector->filename;
-      copy_data.table = result;
+      css_node->pseudo_class = g_intern_string (css_node->pseudo_class);
+    }
 
-      g_hash_table_foreach (match->selector->style, (GHFunc) css_table_copy,
-                            &copy_data);
+  return nodes;
+}
 
-      if (_mx_debug (MX_DEBUG_CSS))
-        print_selector (match->selector, match->score);
+void
+mx_style_sheet_nodes_free (MxStyleSheetNodes *nodes)
+{
+  if (!nodes)
+    return;
+
+  g_array_free (nodes->chain, TRUE);
+  g_slice_free (MxStyleSheetNodes, nodes);
+}
+
+/*
+ * mx_style_sheet_match_nodes:
+ * @sheet: a #MxStyleSheet
+ * @nodes: nodes from mx_style_sheet_nodes_capture()
+ *
+ * Like mx_style_sheet_get_properties(), for the stylable @nodes were
+ * captured from, but safe to call from any thread. The values of the
+ * result belong to the rules of @sheet, so they are only valid while
+ * mx_style_sheet_get_generation() stays the same.
+ *
+ * Returns: the matched properties, by name
+ */
+GHashTable *
+mx_style_sheet_match_nodes (MxStyleSheet      *sheet,
+                            MxStyleSheetNodes *nodes)
+{
+  GHashTable *result;
+
+  g_return_val_if_fail (sheet != NULL, NULL);
+  g_return_val_if_fail (nodes != NULL, NULL);
+
+  g_rw_lock_reader_lock (&sheet->lock);
+  result = css_match_chain (sheet, nodes->chain, FALSE);
+  g_rw_lock_reader_unlock (&sheet->lock);
+
+  return result;
+}
+
+/*
+ * mx_style_sheet_get_generation:
+ * @sheet: a #MxStyleSheet
+ *
+ * Returns: a number that changes whenever rules are added to or removed
+ *   from @sheet, or reordered
+ */
+guint
+mx_style_sheet_get_generation (MxStyleSheet *sheet)
+{
+  g_return_val_if_fail (sheet != NULL, 0);
+
+  return sheet->generation;
+}
+
+static void
+mx_style_sheet_destroy_bucket (GHashTable *bucket)
+{
+  GHashTableIter iter;
+  gpointer rules;
+
+  /* the buckets have no value destroy function, since replacing the head of
+   * a rule list must not free the list */
+  g_hash_table_iter_init (&iter, bucket);
+  while (g_hash_table_iter_next (&iter, NULL, &rules))
+    g_list_free (rules);
+
+  g_hash_table_destroy (bucket);
+}
+
+/*
+ * Profiling
+ *
+ * With MX_DEBUG=css-profile, the time spent matching each selector is
+ * recorded along with how many stylables of each type were restyled and how
+ * often the style caches were hit. A report sorted by the most expensive
+ * selectors is printed on exit, or whenever the process receives SIGUSR1.
+ */
+
+static GList      *profile_sheets = NULL;
+static GHashTable *profile_restyles = NULL;
+static guint       profile_cache_hits = 0;
+static guint       profile_cache_misses = 0;
+
+void
+mx_style_sheet_profile_restyle (GType type)
+{
+  gpointer count;
+
+  if (!profile_restyles)
+    profile_restyles = g_hash_table_new (NULL, NULL);
+
+  count = g_hash_table_lookup (profile_restyles, GSIZE_TO_POINTER (type));
+  g_hash_table_insert (profile_restyles, GSIZE_TO_POINTER (type),
+                       GUINT_TO_POINTER (GPOINTER_TO_UINT (count) + 1));
+}
+
+void
+mx_style_sheet_profile_cache_lookup (gboolean hit)
+{
+  if (hit)
+    profile_cache_hits ++;
+  else
+    profile_cache_misses ++;
+}
+
+static gint
+mx_style_sheet_profile_compare_time (gconstpointer a,
+                                     gconstpointer b)
+{
+  const MxSelector *selector_a = *(MxSelector **) a;
+  const MxSelector *selector_b = *(MxSelector **) b;
+
+  if (selector_a->profile_time != selector_b->profile_time)
+    return (selector_a->profile_time < selector_b->profile_time) ? 1 : -1;
+
+  return (gint) selector_b->profile_attempts -
+    (gint) selector_a->profile_attempts;
+}
+
+static gint
+mx_style_sheet_profile_compare_restyles (gconstpointer a,
+                                         gconstpointer b)
+{
+  return GPOINTER_TO_UINT (g_hash_table_lookup (profile_restyles,
+                                                *(gpointer *) b)) -
+    GPOINTER_TO_UINT (g_hash_table_lookup (profile_restyles,
+                                           *(gpointer *) a));
+}
+
+/* the selectors of @sheets that were tried, most expensive first */
+static GPtrArray *
+mx_style_sheet_profile_get_selectors (GList *sheets)
+{
+  GPtrArray *selectors;
+  GList *s, *l;
+
+  selectors = g_ptr_array_new ();
+  for (s = sheets; s; s = s->next)
+    for (l = ((MxStyleSheet *) s->data)->selectors; l; l = l->next)
+      if (((MxSelector *) l->data)->profile_attempts)
+        g_ptr_array_add (selectors, l->data);
+  g_ptr_array_sort (selectors, mx_style_sheet_profile_compare_time);
+
+  return selectors;
+}
+
+static gchar *
+mx_style_sheet_profile_format_selector (MxSelector *selector)
+{
+  gchar *string, *result;
+
+  string = selector_to_string (selector);
+  result = g_strdup_printf ("%10.3f  %10u  %10u  %s (%s:%u)",
+                            selector->profile_time / 1000.0,
+                            selector->profile_attempts,
+                            selector->profile_matches,
+                            string,
+                            (selector->filename) ? selector->filename : "?",
+                            selector->line);
+  g_free (string);
+
+  return result;
+}
+
+/* Returns one line per selector of @sheet, as printed by the profile
+ * report, for at most @max_selectors of the most expensive ones. The array
+ * is empty unless MX_DEBUG=css-profile is set. */
+gchar **
+mx_style_sheet_profile_get_report (MxStyleSheet *sheet,
+                                   guint         max_selectors)
+{
+  GPtrArray *selectors, *lines;
+  GList sheets = { sheet, NULL, NULL };
+  guint i;
+
+  selectors = mx_style_sheet_profile_get_selectors (&sheets);
+
+  lines = g_ptr_array_new ();
+  for (i = 0; i < MIN (selectors->len, max_selectors); i++)
+    g_ptr_array_add (lines,
+                     mx_style_sheet_profile_format_selector (
+                       g_ptr_array_index (selectors, i)));
+  g_ptr_array_add (lines, NULL);
+
+  g_ptr_array_free (selectors, TRUE);
+
+  return (gchar **) g_ptr_array_free (lines, FALSE);
+}
+
+void
+mx_style_sheet_profile_report (void)
+{
+  GPtrArray *selectors, *types;
+  GHashTableIter iter;
+  gpointer type;
+  guint lookups, i;
+
+  g_printerr ("Mx CSS profile\n");
+
+  /* style caches */
+  lookups = profile_cache_hits + profile_cache_misses;
+  g_printerr ("\n  Style cache: %u hits, %u misses (%.1f%% hit rate)\n",
+              profile_cache_hits, profile_cache_misses,
+              (lookups) ? 100.0 * profile_cache_hits / lookups : 0.0);
+
+  /* restyles by type */
+  types = g_ptr_array_new ();
+  if (profile_restyles)
+    {
+      g_hash_table_iter_init (&iter, profile_restyles);
+      while (g_hash_table_iter_next (&iter, &type, NULL))
+        g_ptr_array_add (types, type);
     }
+  g_ptr_array_sort (types, mx_style_sheet_profile_compare_restyles);
 
-  g_list_foreach (matching_selectors, (GFunc) free_selector_match, NULL);
-  g_list_free (matching_selectors);
+  g_printerr ("\n  Restyles by type:\n");
+  for (i = 0; i < types->len; i++)
+    {
+      type = g_ptr_array_index (types, i);
+      g_printerr ("  %10u  %s\n",
+                  GPOINTER_TO_UINT (g_hash_table_lookup (profile_restyles,
+                                                         type)),
+                  g_type_name (GPOINTER_TO_SIZE (type)));
+    }
+  g_ptr_array_free (types, TRUE);
 
-  if (_mx_debug (MX_DEBUG_CSS))
+  /* selectors, most expensive first */
+  selectors = mx_style_sheet_profile_get_selectors (profile_sheets);
+
+  g_printerr ("\n  Selectors by time spent matching:\n"
+              "  %10s  %10s  %10s  %s\n",
+              "time (ms)", "attempts", "matches", "selector");
+  for (i = 0; i < selectors->len; i++)
     {
-      g_print ("\x1b[2m");
-      MX_NOTE (CSS, "%fs", g_timer_elapsed (timer, NULL));
-      g_print ("\x1b[0m");
-      g_timer_destroy (timer);
+      gchar *line;
+
+      line = mx_style_sheet_profile_format_selector (
+        g_ptr_array_index (selectors, i));
+      g_printerr ("  %s\n", line);
+      g_free (line);
     }
+  g_ptr_array_free (selectors, TRUE);
+}
 
-  return result;
+#ifdef G_OS_UNIX
+static gboolean
+mx_style_sheet_profile_signal_cb (gpointer data)
+{
+  mx_style_sheet_profile_report ();
+
+  return TRUE;
+}
+#endif
+
+static void
+mx_style_sheet_profile_init (void)
+{
+  static gboolean initialised = FALSE;
+
+  if (initialised)
+    return;
+
+  initialised = TRUE;
+
+  atexit (mx_style_sheet_profile_report);
+#ifdef G_OS_UNIX
+  g_unix_signal_add (SIGUSR1, mx_style_sheet_profile_signal_cb, NULL);
+#endif
 }
 
 MxStyleSheet *
 mx_style_sheet_new ()
 {
-  return g_new0 (MxStyleSheet, 1);
+  MxStyleSheet *sheet = g_new0 (MxStyleSheet, 1);
+
+  sheet->id_rules = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                           NULL, NULL);
+  sheet->class_rules = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                              NULL, NULL);
+  sheet->type_rules = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                             NULL, NULL);
+
+  sheet->mapped_files =
+    g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                           (GDestroyNotify) g_mapped_file_unref);
+
+  sheet->ancestor_ids = g_hash_table_new (NULL, NULL);
+  sheet->ancestor_classes = g_hash_table_new (NULL, NULL);
+
+  g_rw_lock_init (&sheet->lock);
+
+  if (G_UNLIKELY (_mx_debug (MX_DEBUG_CSS_PROFILE)))
+    {
+      mx_style_sheet_profile_init ();
+      profile_sheets = g_list_prepend (profile_sheets, sheet);
+    }
+
+  return sheet;
 }
 
 void
 mx_style_sheet_destroy (MxStyleSheet *sheet)
 {
+  mx_style_sheet_destroy_bucket (sheet->id_rules);
+  mx_style_sheet_destroy_bucket (sheet->class_rules);
+  mx_style_sheet_destroy_bucket (sheet->type_rules);
+  g_list_free (sheet->universal_rules);
+
   g_list_foreach (sheet->selectors, (GFunc) mx_selector_free, NULL);
   g_list_free (sheet->selectors);
 
   g_list_foreach (sheet->filenames, (GFunc) g_free, NULL);
   g_list_free (sheet->filenames);
 
+  /* the selectors may point into the mappings, so release these last */
+  g_hash_table_destroy (sheet->mapped_files);
+
+  g_hash_table_destroy (sheet->ancestor_ids);
+  g_hash_table_destroy (sheet->ancestor_classes);
+
+  g_rw_lock_clear (&sheet->lock);
+
+  profile_sheets = g_list_remove (profile_sheets, sheet);
+
   g_free (sheet);
 }
 
@@ -1004,32 +1894,1169 @@ mx_style_sheet_add_from_data (MxStyleSheet  *sheet,
   return result;
 }
 
-void
-mx_style_sheet_remove (MxStyleSheet *sheet,
-                       const gchar  *id)
+struct _MxStyleSheetParseJob
+{
+  gchar    *filename;
+  gint      priority;
+  GList    *selectors;
+  gboolean  result;
+};
+
+static void
+mx_style_sheet_parse_job_run (MxStyleSheetParseJob *job,
+                              gpointer              user_data)
 {
   GList *l;
 
-  l = sheet->selectors;
+  job->result = css_parse_selectors (job->filename, NULL, job->priority,
+                                     &job->selectors);
 
-  while (l)
+  for (l = job->selectors; l; l = l->next)
+    mx_selector_update_specificity (l->data);
+}
+
+/*
+ * mx_style_sheet_add_from_files:
+ * @sheet: a #MxStyleSheet
+ * @filenames: a %NULL-terminated array of file names
+ * @error: return location for a #GError, or %NULL
+ *
+ * Like calling mx_style_sheet_add_from_file() on each of @filenames in
+ * turn, but the files are read and parsed concurrently, on worker threads.
+ * The rules are only added to @sheet once all of the files are parsed, in
+ * the order of @filenames, so later files still take priority.
+ *
+ * Returns: %FALSE if any of the files could not be parsed, in which case
+ *   @error names the first
+ */
+gboolean
+mx_style_sheet_add_from_files (MxStyleSheet  *sheet,
+                               const gchar  **filenames,
+                               GError       **error)
+{
+  MxStyleSheetParseJob *jobs;
+  GThreadPool *pool;
+  gboolean result = TRUE;
+  guint i, n_files;
+
+  g_return_val_if_fail (sheet != NULL, FALSE);
+  g_return_val_if_fail (filenames != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  n_files = g_strv_length ((gchar **) filenames);
+  jobs = g_new0 (MxStyleSheetParseJob, n_files);
+
+  pool = g_thread_pool_new ((GFunc) mx_style_sheet_parse_job_run, NULL,
+                            -1, FALSE, NULL);
+
+  for (i = 0; i < n_files; i++)
     {
-      MxSelector *selector = l->data;
-      GList *link_to_delete = NULL;
+      jobs[i].filename = g_strdup (filenames[i]);
+      jobs[i].priority = g_list_length (sheet->filenames) + i;
 
-      if (!g_strcmp0 (id, selector->filename))
-        {
-          link_to_delete = l;
-        }
+      /* the last file is parsed here rather than left waiting */
+      if (!pool || i == n_files - 1)
+        mx_style_sheet_parse_job_run (&jobs[i], NULL);
+      else
+        g_thread_pool_push (pool, &jobs[i], NULL);
+    }
 
-      l = g_list_next (l);
+  /* wait for the workers to finish */
+  if (pool)
+    g_thread_pool_free (pool, FALSE, TRUE);
 
-      if (link_to_delete)
-        {
-          sheet->selectors = g_list_delete_link (sheet->selectors,
-                                                 link_to_delete);
+  for (i = 0; i < n_files; i++)
+    {
+      GList *l;
 
-          mx_selector_free (selector);
+      for (l = jobs[i].selectors; l; l = l->next)
+        mx_style_sheet_index_selector (sheet, l->data);
+      sheet->selectors = g_list_concat (sheet->selectors, jobs[i].selectors);
+      sheet->filenames = g_list_prepend (sheet->filenames, jobs[i].filename);
+
+      if (!jobs[i].result && result)
+        {
+          g_set_error (error, MX_STYLE_SHEET_ERROR,
+                       MX_STYLE_SHEET_ERROR_INVALID,
+                       "Could not parse '%s'", jobs[i].filename);
+          result = FALSE;
         }
     }
+
+  g_free (jobs);
+
+  return result;
+}
+
+/*
+ * mx_style_sheet_parse_file:
+ * @filename: the file name of a style sheet
+ * @error: return location for a #GError, or %NULL
+ *
+ * Parses @filename without adding it to a style sheet, so that it can be
+ * done on any thread. The result is added to a sheet with
+ * mx_style_sheet_add_parsed().
+ *
+ * Returns: the parsed style sheet, or %NULL if it could not be parsed
+ */
+MxStyleSheetParseJob *
+mx_style_sheet_parse_file (const gchar  *filename,
+                           GError      **error)
+{
+  MxStyleSheetParseJob *job;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  job = g_slice_new0 (MxStyleSheetParseJob);
+  job->filename = g_strdup (filename);
+
+  mx_style_sheet_parse_job_run (job, NULL);
+
+  if (!job->result)
+    {
+      g_set_error (error, MX_STYLE_SHEET_ERROR, MX_STYLE_SHEET_ERROR_INVALID,
+                   "Could not parse '%s'", filename);
+      mx_style_sheet_parse_job_free (job);
+      return NULL;
+    }
+
+  return job;
+}
+
+static void
+mx_selector_set_priority (MxSelector *selector,
+                          gint        priority)
+{
+  if (!selector)
+    return;
+
+  selector->priority = priority;
+  mx_selector_set_priority (selector->parent, priority);
+  mx_selector_set_priority (selector->ancestor, priority);
+}
+
+/*
+ * mx_style_sheet_add_parsed:
+ * @sheet: a #MxStyleSheet
+ * @job: (transfer full): a style sheet from mx_style_sheet_parse_file()
+ *
+ * Adds the rules of @job to @sheet, with priority over the files already
+ * in it, as if @sheet had parsed the file itself.
+ */
+void
+mx_style_sheet_add_parsed (MxStyleSheet         *sheet,
+                           MxStyleSheetParseJob *job)
+{
+  gint priority;
+  GList *l;
+
+  g_return_if_fail (sheet != NULL);
+  g_return_if_fail (job != NULL);
+
+  priority = g_list_length (sheet->filenames);
+
+  for (l = job->selectors; l; l = l->next)
+    {
+      mx_selector_set_priority (l->data, priority);
+      mx_style_sheet_index_selector (sheet, l->data);
+    }
+  sheet->selectors = g_list_concat (sheet->selectors, job->selectors);
+  sheet->filenames = g_list_prepend (sheet->filenames, job->filename);
+
+  g_slice_free (MxStyleSheetParseJob, job);
+}
+
+void
+mx_style_sheet_parse_job_free (MxStyleSheetParseJob *job)
+{
+  if (!job)
+    return;
+
+  g_list_foreach (job->selectors, (GFunc) mx_selector_free, NULL);
+  g_list_free (job->selectors);
+  g_free (job->filename);
+
+  g_slice_free (MxStyleSheetParseJob, job);
+}
+
+/*
+ * mx_style_sheet_get_styles:
+ * @sheet: a #MxStyleSheet
+ *
+ * Returns: (transfer container): the declarations of each rule in @sheet,
+ *   as hash tables of #MxStyleSheetValue by property name
+ */
+GList *
+mx_style_sheet_get_styles (MxStyleSheet *sheet)
+{
+  GList *styles = NULL, *l;
+
+  for (l = sheet->selectors; l; l = l->next)
+    {
+      MxSelector *selector = l->data;
+
+      if (selector->style)
+        styles = g_list_prepend (styles, selector->style);
+    }
+
+  return g_list_reverse (styles);
+}
+
+void
+mx_style_sheet_remove (MxStyleSheet *sheet,
+                       const gchar  *id)
+{
+  GList *l;
+
+  l = sheet->selectors;
+
+  while (l)
+    {
+      MxSelector *selector = l->data;
+      GList *link_to_delete = NULL;
+
+      if (!g_strcmp0 (id, selector->filename))
+        {
+          link_to_delete = l;
+        }
+
+      l = g_list_next (l);
+
+      if (link_to_delete)
+        {
+          sheet->selectors = g_list_delete_link (sheet->selectors,
+                                                 link_to_delete);
+
+          mx_style_sheet_unindex_selector (sheet, selector);
+          mx_selector_free (selector);
+        }
+    }
+
+  g_hash_table_remove (sheet->mapped_files, id);
+}
+
+static void
+mx_style_sheet_add_dependencies (MxStyleSheet *sheet,
+                                 MxSelector   *selector)
+{
+  if (!selector)
+    return;
+
+  if (selector->id)
+    g_hash_table_add (sheet->ancestor_ids, GUINT_TO_POINTER (selector->id));
+  if (selector->class)
+    g_hash_table_add (sheet->ancestor_classes,
+                      GUINT_TO_POINTER (selector->class));
+
+  sheet->ancestor_pseudo_class_mask |= selector->pseudo_class_mask;
+  if (selector->pseudo_class_unmasked)
+    sheet->ancestor_pseudo_class_unmasked = TRUE;
+
+  mx_style_sheet_add_dependencies (sheet, selector->parent);
+  mx_style_sheet_add_dependencies (sheet, selector->ancestor);
+}
+
+static void
+mx_style_sheet_update_dependencies (MxStyleSheet *sheet)
+{
+  GList *l;
+
+  if (!sheet->dependencies_dirty)
+    return;
+
+  g_hash_table_remove_all (sheet->ancestor_ids);
+  g_hash_table_remove_all (sheet->ancestor_classes);
+  sheet->ancestor_pseudo_class_mask = 0;
+  sheet->ancestor_pseudo_class_unmasked = FALSE;
+
+  /* only the non-rightmost compound selectors of each rule */
+  for (l = sheet->selectors; l; l = l->next)
+    {
+      MxSelector *selector = l->data;
+
+      mx_style_sheet_add_dependencies (sheet, selector->parent);
+      mx_style_sheet_add_dependencies (sheet, selector->ancestor);
+    }
+
+  sheet->dependencies_dirty = FALSE;
+}
+
+/*
+ * mx_style_sheet_affects_descendants:
+ * @sheet: a #MxStyleSheet
+ * @id: an id that a node gained or lost, or 0
+ * @class: a style class that a node gained or lost, or 0
+ * @pseudo_class_mask: the mask of the pseudo-classes a node gained or lost
+ * @pseudo_class_unmasked: whether the node gained or lost pseudo-classes
+ *   that have no bit in the mask
+ *
+ * Returns: whether any selector could match a descendant of the node
+ *   differently after the change, by testing the changed properties in a
+ *   parent or ancestor position
+ */
+gboolean
+mx_style_sheet_affects_descendants (MxStyleSheet *sheet,
+                                    GQuark        id,
+                                    GQuark        class,
+                                    guint64       pseudo_class_mask,
+                                    gboolean      pseudo_class_unmasked)
+{
+  mx_style_sheet_update_dependencies (sheet);
+
+  if (id && g_hash_table_contains (sheet->ancestor_ids,
+                                   GUINT_TO_POINTER (id)))
+    return TRUE;
+
+  if (class && g_hash_table_contains (sheet->ancestor_classes,
+                                      GUINT_TO_POINTER (class)))
+    return TRUE;
+
+  if (pseudo_class_mask & sheet->ancestor_pseudo_class_mask)
+    return TRUE;
+
+  /* unmasked pseudo-classes are not told apart, any of them may match */
+  if (pseudo_class_unmasked && sheet->ancestor_pseudo_class_unmasked)
+    return TRUE;
+
+  return FALSE;
+}
+
+struct _MxStyleSheetChange
+{
+  /* the index keys of the rules that were added or removed */
+  GHashTable *ids;
+  GHashTable *classes;
+  GHashTable *types;
+  gboolean    universal;
+};
+
+static void
+mx_style_sheet_change_add_selector (MxStyleSheetChange *change,
+                                    MxSelector         *selector)
+{
+  /* use the same key as the rule index, since a node can only match a rule
+   * if it has that key */
+  if (selector->id)
+    g_hash_table_add (change->ids, GUINT_TO_POINTER (selector->id));
+  else if (selector->class)
+    g_hash_table_add (change->classes, GUINT_TO_POINTER (selector->class));
+  else if (selector->type)
+    g_hash_table_add (change->types, GUINT_TO_POINTER (selector->type));
+  else
+    change->universal = TRUE;
+}
+
+static gint
+css_compare_strings (gconstpointer a,
+                     gconstpointer b)
+{
+  return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+/* a string that is the same for two rules exactly when they would style
+ * nodes in the same way */
+static gchar *
+mx_selector_get_signature (MxSelector *selector)
+{
+  GHashTableIter iter;
+  GPtrArray *names;
+  GString *string;
+  gpointer name;
+  gchar *tmp;
+  guint i;
+
+  tmp = selector_to_string (selector);
+  string = g_string_new (tmp);
+  g_free (tmp);
+
+  /* the declarations, in a stable order */
+  names = g_ptr_array_new ();
+  g_hash_table_iter_init (&iter, selector->style);
+  while (g_hash_table_iter_next (&iter, &name, NULL))
+    g_ptr_array_add (names, name);
+  g_ptr_array_sort (names, css_compare_strings);
+
+  g_string_append_c (string, '{');
+  for (i = 0; i < names->len; i++)
+    {
+      MxStyleSheetValue *value;
+
+      value = g_hash_table_lookup (selector->style, names->pdata[i]);
+      g_string_append_printf (string, "%s:%s;", (gchar *) names->pdata[i],
+                              value->string);
+    }
+  g_string_append_c (string, '}');
+
+  g_ptr_array_free (names, TRUE);
+
+  return g_string_free (string, FALSE);
+}
+
+/*
+ * mx_style_sheet_reload_file:
+ * @sheet: a #MxStyleSheet
+ * @filename: the id of a style sheet added with mx_style_sheet_add_from_file()
+ * @change: (out): return location for the rules that changed, or %NULL
+ *   when they could not be determined
+ *
+ * Re-reads @filename, keeping the rules that did not change. Values looked
+ * up from the unchanged rules stay valid.
+ *
+ * Returns: %FALSE if there was an error parsing the file
+ */
+gboolean
+mx_style_sheet_reload_file (MxStyleSheet        *sheet,
+                            const gchar         *filename,
+                            MxStyleSheetChange **change)
+{
+  GHashTable *old_rules;
+  GHashTableIter iter;
+  GList *l, *selectors = NULL;
+  gchar *input_name = NULL;
+  gpointer rules;
+  gboolean result;
+  gint priority;
+
+  g_return_val_if_fail (sheet != NULL, FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (change != NULL, FALSE);
+
+  *change = NULL;
+
+  /* reuse the original name, since the selectors of the file point to it,
+   * and its priority, which is its position in the list */
+  for (l = sheet->filenames; l; l = l->next)
+    {
+      if (!g_strcmp0 (l->data, filename))
+        {
+          input_name = l->data;
+          break;
+        }
+    }
+
+  if (!input_name || g_hash_table_lookup (sheet->mapped_files, filename))
+    {
+      mx_style_sheet_remove (sheet, filename);
+      return mx_style_sheet_add_from_file (sheet, filename, NULL);
+    }
+
+  priority = g_list_length (l) - 1;
+
+  result = css_parse_selectors (input_name, NULL, priority, &selectors);
+
+  /* gather the current rules from the file, there may be duplicates */
+  old_rules = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  for (l = sheet->selectors; l; l = l->next)
+    {
+      MxSelector *selector = l->data;
+      gchar *signature;
+
+      if (selector->filename != input_name)
+        continue;
+
+      signature = mx_selector_get_signature (selector);
+      rules = g_hash_table_lookup (old_rules, signature);
+      g_hash_table_insert (old_rules, signature,
+                           g_list_prepend (rules, selector));
+    }
+
+  *change = g_slice_new0 (MxStyleSheetChange);
+  (*change)->ids = g_hash_table_new (NULL, NULL);
+  (*change)->classes = g_hash_table_new (NULL, NULL);
+  (*change)->types = g_hash_table_new (NULL, NULL);
+
+  /* keep the rules that are still there, with their new position, and add
+   * the new ones */
+  for (l = selectors; l; l = l->next)
+    {
+      MxSelector *selector = l->data;
+      gchar *signature;
+      GList *old;
+
+      signature = mx_selector_get_signature (selector);
+      old = g_hash_table_lookup (old_rules, signature);
+
+      if (old)
+        {
+          MxSelector *old_selector = old->data;
+
+          /* the position decides between rules of the same score */
+          g_rw_lock_writer_lock (&sheet->lock);
+          sheet->generation ++;
+          old_selector->line = selector->line;
+          old_selector->position = selector->position;
+          g_rw_lock_writer_unlock (&sheet->lock);
+
+          g_hash_table_insert (old_rules, g_strdup (signature),
+                               g_list_delete_link (old, old));
+          mx_selector_free (selector);
+        }
+      else
+        {
+          mx_selector_update_specificity (selector);
+          mx_style_sheet_index_selector (sheet, selector);
+          sheet->selectors = g_list_prepend (sheet->selectors, selector);
+          mx_style_sheet_change_add_selector (*change, selector);
+        }
+
+      g_free (signature);
+    }
+  g_list_free (selectors);
+
+  /* remove the rules that have gone */
+  g_hash_table_iter_init (&iter, old_rules);
+  while (g_hash_table_iter_next (&iter, NULL, &rules))
+    {
+      for (l = rules; l; l = l->next)
+        {
+          MxSelector *selector = l->data;
+
+          sheet->selectors = g_list_remove (sheet->selectors, selector);
+          mx_style_sheet_unindex_selector (sheet, selector);
+          mx_style_sheet_change_add_selector (*change, selector);
+          mx_selector_free (selector);
+        }
+      g_list_free (rules);
+    }
+  g_hash_table_destroy (old_rules);
+
+  return result;
+}
+
+/*
+ * mx_style_sheet_change_affects:
+ * @change: a #MxStyleSheetChange
+ * @type: the type of a node
+ * @id: the interned name of the node, or 0
+ * @class: the interned style class of the node, or 0
+ *
+ * Returns: whether a node with the given properties could match any of the
+ *   rules in @change
+ */
+gboolean
+mx_style_sheet_change_affects (MxStyleSheetChange *change,
+                               GType               type,
+                               GQuark              id,
+                               GQuark              class)
+{
+  GHashTableIter iter;
+  GHashTable *depths;
+  gpointer type_quark;
+
+  if (change->universal)
+    return TRUE;
+
+  if (id && g_hash_table_contains (change->ids, GUINT_TO_POINTER (id)))
+    return TRUE;
+
+  if (class &&
+      g_hash_table_contains (change->classes, GUINT_TO_POINTER (class)))
+    return TRUE;
+
+  if (G_UNLIKELY (!quark_type_depths))
+    quark_type_depths = g_quark_from_static_string ("mx-css-type-depths");
+
+  depths = css_type_get_depths (type);
+  g_hash_table_iter_init (&iter, change->types);
+  while (g_hash_table_iter_next (&iter, &type_quark, NULL))
+    {
+      if (g_hash_table_contains (depths, type_quark))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+void
+mx_style_sheet_change_free (MxStyleSheetChange *change)
+{
+  if (!change)
+    return;
+
+  g_hash_table_destroy (change->ids);
+  g_hash_table_destroy (change->classes);
+  g_hash_table_destroy (change->types);
+  g_slice_free (MxStyleSheetChange, change);
+}
+
+/*
+ * Compiled style sheets
+ *
+ * A compiled style sheet is the parsed form of a CSS file, laid out so that
+ * it can be mapped into memory and used without running the parser. All
+ * values are in host byte order, so compiled files are not portable between
+ * architectures. The file is:
+ *
+ *   header | declarations | selectors | styles | strings
+ *
+ * Strings are stored as offsets into the string table, where 0 is the
+ * leading empty string and means NULL. Selectors refer to their parent,
+ * ancestor and style by index, with -1 for none; the parent and ancestor
+ * of a selector always come before it.
+ */
+
+#define MX_CSS_COMPILED_MAGIC      "MXCSSBIN"
+#define MX_CSS_COMPILED_VERSION    1
+#define MX_CSS_COMPILED_BYTE_ORDER 0x01020304
+
+#define MX_CSS_COMPILED_FLAG_PT    (1 << 0)
+
+typedef struct
+{
+  gchar   magic[8];
+  guint32 version;
+  guint32 byte_order;
+  gint64  source_mtime;
+  guint64 source_size;
+  guint32 source;
+  guint32 n_declarations;
+  guint32 declarations;
+  guint32 n_selectors;
+  guint32 selectors;
+  guint32 n_styles;
+  guint32 styles;
+  guint32 strings;
+  guint32 strings_size;
+  guint32 padding;
+} MxCssCompiledHeader;
+
+typedef struct
+{
+  guint32 name;
+  guint32 value;
+  gint32  int_value;
+  guint32 flags;
+  gdouble float_value;
+} MxCssCompiledDeclaration;
+
+typedef struct
+{
+  guint32 type;
+  guint32 id;
+  guint32 class;
+  guint32 pseudo_class;
+  gint32  parent;
+  gint32  ancestor;
+  gint32  style;
+  guint32 line;
+  guint32 position;
+  gint32  specificity;
+} MxCssCompiledSelector;
+
+typedef struct
+{
+  guint32 first_declaration;
+  guint32 n_declarations;
+} MxCssCompiledStyle;
+
+static gboolean
+css_compiled_section_valid (gsize   length,
+                            guint32 offset,
+                            guint32 n_items,
+                            gsize   item_size)
+{
+  return ((guint64) offset + (guint64) n_items * item_size) <= length;
+}
+
+static const gchar *
+css_compiled_string (const gchar *strings,
+                     guint32      offset)
+{
+  return (offset) ? strings + offset : NULL;
+}
+
+static gboolean
+css_compiled_validate (const gchar  *filename,
+                       const gchar  *contents,
+                       gsize         length,
+                       GError      **error)
+{
+  const MxCssCompiledHeader *header;
+  const MxCssCompiledDeclaration *declarations;
+  const MxCssCompiledSelector *selectors;
+  const MxCssCompiledStyle *styles;
+  guint8 *referenced;
+  gboolean valid;
+  guint32 i;
+
+  header = (const MxCssCompiledHeader *) contents;
+
+  if (length < sizeof (MxCssCompiledHeader) ||
+      memcmp (header->magic, MX_CSS_COMPILED_MAGIC, sizeof (header->magic)))
+    {
+      g_set_error (error, MX_STYLE_SHEET_ERROR, MX_STYLE_SHEET_ERROR_INVALID,
+                   "'%s' is not a compiled style sheet", filename);
+      return FALSE;
+    }
+
+  if (header->version != MX_CSS_COMPILED_VERSION ||
+      header->byte_order != MX_CSS_COMPILED_BYTE_ORDER)
+    {
+      g_set_error (error, MX_STYLE_SHEET_ERROR, MX_STYLE_SHEET_ERROR_INVALID,
+                   "'%s' was compiled for a different version or "
+                   "architecture", filename);
+      return FALSE;
+    }
+
+  if (!css_compiled_section_valid (length, header->declarations,
+                                   header->n_declarations,
+                                   sizeof (MxCssCompiledDeclaration)) ||
+      (header->declarations % sizeof (gdouble)) ||
+      !css_compiled_section_valid (length, header->selectors,
+                                   header->n_selectors,
+                                   sizeof (MxCssCompiledSelector)) ||
+      (header->selectors % sizeof (guint32)) ||
+      !css_compiled_section_valid (length, header->styles, header->n_styles,
+                                   sizeof (MxCssCompiledStyle)) ||
+      (header->styles % sizeof (guint32)) ||
+      !css_compiled_section_valid (length, header->strings,
+                                   header->strings_size, 1) ||
+      header->strings_size == 0 ||
+      contents[header->strings] != '\0' ||
+      contents[header->strings + header->strings_size - 1] != '\0' ||
+      header->source >= header->strings_size)
+    goto corrupt;
+
+  declarations = (const MxCssCompiledDeclaration *)
+    (contents + header->declarations);
+  selectors = (const MxCssCompiledSelector *) (contents + header->selectors);
+  styles = (const MxCssCompiledStyle *) (contents + header->styles);
+
+  for (i = 0; i < header->n_declarations; i++)
+    {
+      if (!declarations[i].name ||
+          declarations[i].name >= header->strings_size ||
+          declarations[i].value >= header->strings_size)
+        goto corrupt;
+    }
+
+  for (i = 0; i < header->n_styles; i++)
+    {
+      if (!css_compiled_section_valid (header->n_declarations,
+                                       styles[i].first_declaration,
+                                       styles[i].n_declarations, 1))
+        goto corrupt;
+    }
+
+  /* every selector must either be the key of a rule, with a style, or be
+   * the parent or ancestor of exactly one other selector; anything else
+   * would lead to leaks or double frees when the sheet is released */
+  valid = TRUE;
+  referenced = g_new0 (guint8, header->n_selectors);
+
+  for (i = 0; valid && i < header->n_selectors; i++)
+    {
+      const MxCssCompiledSelector *s = &selectors[i];
+
+      if (s->type >= header->strings_size ||
+          s->id >= header->strings_size ||
+          s->class >= header->strings_size ||
+          s->pseudo_class >= header->strings_size ||
+          s->style < -1 || s->style >= (gint64) header->n_styles ||
+          s->parent < -1 || s->parent >= (gint64) i ||
+          s->ancestor < -1 || s->ancestor >= (gint64) i)
+        valid = FALSE;
+      else if (s->parent >= 0 && referenced[s->parent]++)
+        valid = FALSE;
+      else if (s->ancestor >= 0 && referenced[s->ancestor]++)
+        valid = FALSE;
+    }
+
+  for (i = 0; valid && i < header->n_selectors; i++)
+    {
+      if (referenced[i] != (selectors[i].style == -1))
+        valid = FALSE;
+    }
+
+  g_free (referenced);
+
+  if (valid)
+    return TRUE;
+
+corrupt:
+  g_set_error (error, MX_STYLE_SHEET_ERROR, MX_STYLE_SHEET_ERROR_INVALID,
+               "Compiled style sheet '%s' is corrupt", filename);
+  return FALSE;
+}
+
+static GHashTable *
+css_compiled_style_new (const gchar               *strings,
+                        const MxCssCompiledHeader *header,
+                        const MxCssCompiledStyle  *style,
+                        const gchar               *source)
+{
+  const MxCssCompiledDeclaration *declarations;
+  GHashTable *table;
+  guint32 i;
+
+  declarations = (const MxCssCompiledDeclaration *)
+    ((const gchar *) header + header->declarations);
+
+  /* both the names and the values point into the mapping */
+  table = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                 (GDestroyNotify) mx_style_sheet_value_free);
+
+  for (i = 0; i < style->n_declarations; i++)
+    {
+      const MxCssCompiledDeclaration *decl;
+      MxStyleSheetValue *value;
+
+      decl = &declarations[style->first_declaration + i];
+
+      value = mx_style_sheet_value_new (NULL, source, FALSE);
+      value->string = css_compiled_string (strings, decl->value);
+      value->int_value = decl->int_value;
+      value->float_value = decl->float_value;
+      value->is_pt = (decl->flags & MX_CSS_COMPILED_FLAG_PT) != 0;
+
+      g_hash_table_insert (table,
+                           (gpointer) css_compiled_string (strings, decl->name),
+                           value);
+    }
+
+  return table;
+}
+
+gboolean
+mx_style_sheet_add_from_compiled_file (MxStyleSheet  *sheet,
+                                       const gchar   *filename,
+                                       gchar        **source,
+                                       GError       **error)
+{
+  const MxCssCompiledHeader *header;
+  const MxCssCompiledSelector *compiled;
+  GHashTable **styles;
+  MxSelector **selectors;
+  GList *l, *rules = NULL;
+  GMappedFile *mapped;
+  const gchar *contents, *strings, *source_name;
+  gchar *input_name;
+  struct stat st;
+  gint priority;
+  gsize length;
+  guint32 i;
+
+  g_return_val_if_fail (sheet != NULL, FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (source)
+    *source = NULL;
+
+  mapped = g_mapped_file_new (filename, FALSE, error);
+  if (!mapped)
+    return FALSE;
+
+  contents = g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+
+  if (!css_compiled_validate (filename, contents, length, error))
+    {
+      g_mapped_file_unref (mapped);
+      return FALSE;
+    }
+
+  header = (const MxCssCompiledHeader *) contents;
+  strings = contents + header->strings;
+  source_name = css_compiled_string (strings, header->source);
+
+  if (source)
+    *source = g_strdup (source_name);
+
+  /* if the original file is still around, it must be the one that was
+   * compiled; a missing source is fine, so compiled files can be installed
+   * on their own */
+  if (source_name && g_stat (source_name, &st) == 0 &&
+      ((gint64) st.st_mtime != header->source_mtime ||
+       (guint64) st.st_size != header->source_size))
+    {
+      g_set_error (error, MX_STYLE_SHEET_ERROR, MX_STYLE_SHEET_ERROR_STALE,
+                   "Compiled style sheet '%s' is older than '%s'",
+                   filename, source_name);
+      g_mapped_file_unref (mapped);
+      return FALSE;
+    }
+
+  /* the sheet is known by its source, so that it can be removed and
+   * reloaded in the same way as a parsed one */
+  input_name = g_strdup ((source_name) ? source_name : filename);
+  priority = g_list_length (sheet->filenames);
+
+  styles = g_new0 (GHashTable *, header->n_styles);
+  for (i = 0; i < header->n_styles; i++)
+    {
+      const MxCssCompiledStyle *style;
+
+      style = (const MxCssCompiledStyle *) (contents + header->styles) + i;
+      styles[i] = css_compiled_style_new (strings, header, style, input_name);
+    }
+
+  compiled = (const MxCssCompiledSelector *) (contents + header->selectors);
+  selectors = g_new0 (MxSelector *, header->n_selectors);
+  for (i = 0; i < header->n_selectors; i++)
+    {
+      const MxCssCompiledSelector *c = &compiled[i];
+      MxSelector *selector;
+      const gchar *string;
+      gboolean complete;
+
+      selector = mx_selector_new (input_name, priority, c->line, c->position);
+      selector->specificity = c->specificity;
+
+      if ((string = css_compiled_string (strings, c->type)))
+        selector->type = g_quark_from_string (string);
+      if ((string = css_compiled_string (strings, c->id)))
+        selector->id = g_quark_from_string (string);
+      if ((string = css_compiled_string (strings, c->class)))
+        selector->class = g_quark_from_string (string);
+
+      if ((string = css_compiled_string (strings, c->pseudo_class)))
+        {
+          const gchar *p;
+
+          selector->pseudo_class = g_strdup (string);
+          selector->pseudo_class_mask =
+            _mx_stylable_pseudo_class_to_mask (string, &complete);
+          selector->pseudo_class_unmasked = !complete;
+
+          selector->n_pseudo_classes = 1;
+          for (p = string; (p = strchr (p, ':')); p++)
+            selector->n_pseudo_classes++;
+        }
+
+      if (c->parent >= 0)
+        selector->parent = selectors[c->parent];
+      if (c->ancestor >= 0)
+        selector->ancestor = selectors[c->ancestor];
+
+      if (c->style >= 0)
+        {
+          selector->style = g_hash_table_ref (styles[c->style]);
+          rules = g_list_prepend (rules, selector);
+        }
+
+      selectors[i] = selector;
+    }
+
+  for (i = 0; i < header->n_styles; i++)
+    g_hash_table_unref (styles[i]);
+  g_free (styles);
+  g_free (selectors);
+
+  rules = g_list_reverse (rules);
+  for (l = rules; l; l = l->next)
+    mx_style_sheet_index_selector (sheet, l->data);
+  sheet->selectors = g_list_concat (sheet->selectors, rules);
+
+  g_hash_table_insert (sheet->mapped_files, g_strdup (input_name), mapped);
+  sheet->filenames = g_list_prepend (sheet->filenames, input_name);
+
+  return TRUE;
+}
+
+typedef struct
+{
+  GArray     *declarations;
+  GArray     *selectors;
+  GArray     *styles;
+  GString    *strings;
+  GHashTable *string_offsets;
+  GHashTable *style_indices;
+} MxCssCompileData;
+
+static guint32
+css_compile_string (MxCssCompileData *data,
+                    const gchar      *string)
+{
+  gpointer offset;
+
+  if (!string)
+    return 0;
+
+  if (g_hash_table_lookup_extended (data->string_offsets, string, NULL,
+                                    &offset))
+    return GPOINTER_TO_UINT (offset);
+
+  offset = GUINT_TO_POINTER (data->strings->len);
+  g_string_append_len (data->strings, string, strlen (string) + 1);
+  g_hash_table_insert (data->string_offsets, (gpointer) string, offset);
+
+  return GPOINTER_TO_UINT (offset);
+}
+
+static gint32
+css_compile_style (MxCssCompileData *data,
+                   GHashTable       *table)
+{
+  MxCssCompiledStyle style;
+  GHashTableIter iter;
+  gpointer key, value, index;
+
+  /* the selectors of a group share their style */
+  index = g_hash_table_lookup (data->style_indices, table);
+  if (index)
+    return GPOINTER_TO_INT (index) - 1;
+
+  style.first_declaration = data->declarations->len;
+  style.n_declarations = g_hash_table_size (table);
+
+  g_hash_table_iter_init (&iter, table);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      MxStyleSheetValue *css_value = value;
+      MxCssCompiledDeclaration decl = { 0, };
+
+      decl.name = css_compile_string (data, key);
+      decl.value = css_compile_string (data, css_value->string);
+      decl.int_value = css_value->int_value;
+      decl.float_value = css_value->float_value;
+      if (css_value->is_pt)
+        decl.flags |= MX_CSS_COMPILED_FLAG_PT;
+
+      g_array_append_val (data->declarations, decl);
+    }
+
+  g_array_append_val (data->styles, style);
+  g_hash_table_insert (data->style_indices, table,
+                       GINT_TO_POINTER (data->styles->len));
+
+  return data->styles->len - 1;
+}
+
+static gint32
+css_compile_selector (MxCssCompileData *data,
+                      MxSelector       *selector)
+{
+  MxCssCompiledSelector compiled = { 0, };
+
+  if (!selector)
+    return -1;
+
+  /* emit the parent and ancestor first, so the loader can link them up in
+   * a single pass */
+  compiled.parent = css_compile_selector (data, selector->parent);
+  compiled.ancestor = css_compile_selector (data, selector->ancestor);
+
+  compiled.type = css_compile_string (data, g_quark_to_string (selector->type));
+  compiled.id = css_compile_string (data, g_quark_to_string (selector->id));
+  compiled.class = css_compile_string (data,
+                                       g_quark_to_string (selector->class));
+  compiled.pseudo_class = css_compile_string (data, selector->pseudo_class);
+  compiled.style = (selector->style)
+    ? css_compile_style (data, selector->style) : -1;
+  compiled.line = selector->line;
+  compiled.position = selector->position;
+  compiled.specificity = selector->specificity;
+
+  g_array_append_val (data->selectors, compiled);
+
+  return data->selectors->len - 1;
+}
+
+gboolean
+mx_style_sheet_compile_file (const gchar  *source,
+                             const gchar  *filename,
+                             GError      **error)
+{
+  MxCssCompiledHeader header = { { 0, }, };
+  MxCssCompileData data;
+  MxStyleSheet *sheet;
+  gchar *source_path;
+  GString *contents;
+  struct stat st;
+  gboolean result;
+  GList *l;
+
+  g_return_val_if_fail (source != NULL, FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* the loader checks the source from wherever it runs */
+  if (g_path_is_absolute (source))
+    source_path = g_strdup (source);
+  else
+    {
+      gchar *cwd = g_get_current_dir ();
+      source_path = g_build_filename (cwd, source, NULL);
+      g_free (cwd);
+    }
+
+  if (g_stat (source_path, &st) != 0)
+    {
+      g_set_error (error, MX_STYLE_SHEET_ERROR, MX_STYLE_SHEET_ERROR_INVALID,
+                   "Could not read '%s'", source_path);
+      g_free (source_path);
+      return FALSE;
+    }
+
+  sheet = mx_style_sheet_new ();
+  if (!mx_style_sheet_add_from_file (sheet, source_path, NULL))
+    {
+      g_set_error (error, MX_STYLE_SHEET_ERROR, MX_STYLE_SHEET_ERROR_INVALID,
+                   "Could not parse '%s'", source_path);
+      mx_style_sheet_destroy (sheet);
+      g_free (source_path);
+      return FALSE;
+    }
+
+  data.declarations = g_array_new (FALSE, FALSE,
+                                   sizeof (MxCssCompiledDeclaration));
+  data.selectors = g_array_new (FALSE, FALSE, sizeof (MxCssCompiledSelector));
+  data.styles = g_array_new (FALSE, FALSE, sizeof (MxCssCompiledStyle));
+  data.strings = g_string_new_len ("", 1);
+  data.string_offsets = g_hash_table_new (g_str_hash, g_str_equal);
+  data.style_indices = g_hash_table_new (NULL, NULL);
+
+  header.source = css_compile_string (&data, source_path);
+  for (l = sheet->selectors; l; l = l->next)
+    css_compile_selector (&data, l->data);
+
+  memcpy (header.magic, MX_CSS_COMPILED_MAGIC, sizeof (header.magic));
+  header.version = MX_CSS_COMPILED_VERSION;
+  header.byte_order = MX_CSS_COMPILED_BYTE_ORDER;
+  header.source_mtime = st.st_mtime;
+  header.source_size = st.st_size;
+
+  /* every section is a multiple of eight bytes except the strings, which
+   * come last, so all the records stay aligned */
+  header.n_declarations = data.declarations->len;
+  header.declarations = sizeof (MxCssCompiledHeader);
+  header.n_selectors = data.selectors->len;
+  header.selectors = header.declarations +
+    header.n_declarations * sizeof (MxCssCompiledDeclaration);
+  header.n_styles = data.styles->len;
+  header.styles = header.selectors +
+    header.n_selectors * sizeof (MxCssCompiledSelector);
+  header.strings = header.styles +
+    header.n_styles * sizeof (MxCssCompiledStyle);
+  header.strings_size = data.strings->len;
+
+  contents = g_string_sized_new (header.strings + header.strings_size);
+  g_string_append_len (contents, (const gchar *) &header, sizeof (header));
+  g_string_append_len (contents, data.declarations->data,
+                       header.n_declarations *
+                       sizeof (MxCssCompiledDeclaration));
+  g_string_append_len (contents, data.selectors->data,
+                       header.n_selectors * sizeof (MxCssCompiledSelector));
+  g_string_append_len (contents, data.styles->data,
+                       header.n_styles * sizeof (MxCssCompiledStyle));
+  g_string_append_len (contents, data.strings->str, data.strings->len);
+
+  result = g_file_set_contents (filename, contents->str, contents->len,
+                                error);
+
+  g_string_free (contents, TRUE);
+  g_array_free (data.declarations, TRUE);
+  g_array_free (data.selectors, TRUE);
+  g_array_free (data.styles, TRUE);
+  g_string_free (data.strings, TRUE);
+  g_hash_table_destroy (data.string_offsets);
+  g_hash_table_destroy (data.style_indices);
+
+  /* the string offsets table borrows from the sheet */
+  mx_style_sheet_destroy (sheet);
+  g_free (source_path);
+
+  return result;
 }
@@ -27,13 +27,37 @@
 
 typedef struct _MxStyleSheetValue MxStyleSheetValue;
 typedef struct _MxStyleSheet MxStyleSheet;
+typedef struct _MxStyleSheetChange MxStyleSheetChange;
+typedef struct _MxStyleSheetParseJob MxStyleSheetParseJob;
+typedef struct _MxStyleSheetNodes MxStyleSheetNodes;
+
+#define MX_STYLE_SHEET_ERROR (mx_style_sheet_error_quark ())
+
+typedef enum
+{
+  MX_STYLE_SHEET_ERROR_INVALID,
+  MX_STYLE_SHEET_ERROR_STALE
+} MxStyleSheetError;
 
 struct _MxStyleSheetValue
 {
   const gchar *string;
   const gchar *source;
+
+  /* @string pre-parsed as a number, as atoi() and strtod() would */
+  gint         int_value;
+  gdouble      float_value;
+  guint        is_pt : 1;
+
+  /*< private >*/
+  guint        owns_string : 1;
+
+  /* the value transformed to each type it has been read as */
+  GSList      *cached_values;
 };
 
+GQuark         mx_style_sheet_error_quark    (void);
+
 MxStyleSheet*  mx_style_sheet_new            ();
 void           mx_style_sheet_destroy        ();
 gboolean       mx_style_sheet_add_from_file  (MxStyleSheet  *sheet,
@@ -43,9 +67,59 @@ gboolean       mx_style_sheet_add_from_data  (MxStyleSheet  *sheet,
                                               const gchar   *id,
                                               const gchar   *data,
                                               GError       **error);
+gboolean       mx_style_sheet_add_from_files (MxStyleSheet  *sheet,
+                                              const gchar  **filenames,
+                                              GError       **error);
+MxStyleSheetParseJob *mx_style_sheet_parse_file (const gchar  *filename,
+                                                 GError      **error);
+void           mx_style_sheet_add_parsed     (MxStyleSheet          *sheet,
+                                              MxStyleSheetParseJob  *job);
+void           mx_style_sheet_parse_job_free (MxStyleSheetParseJob  *job);
 GHashTable*    mx_style_sheet_get_properties (MxStyleSheet *sheet,
                                               MxStylable   *node);
+MxStyleSheetNodes *mx_style_sheet_nodes_capture (MxStylable        *node);
+void           mx_style_sheet_nodes_free     (MxStyleSheetNodes *nodes);
+GHashTable*    mx_style_sheet_match_nodes    (MxStyleSheet      *sheet,
+                                              MxStyleSheetNodes *nodes);
+guint          mx_style_sheet_get_generation (MxStyleSheet      *sheet);
 void           mx_style_sheet_remove         (MxStyleSheet *sheet,
                                               const gchar  *id);
+GList*         mx_style_sheet_get_styles     (MxStyleSheet *sheet);
+
+const GValue  *mx_style_sheet_value_get_cached (MxStyleSheetValue *value,
+                                               GType              type,
+                                               gdouble            resolution);
+void           mx_style_sheet_value_set_cached (MxStyleSheetValue *value,
+                                               gdouble            resolution,
+                                               const GValue      *gvalue);
+
+gboolean       mx_style_sheet_affects_descendants (MxStyleSheet *sheet,
+                                                   GQuark        id,
+                                                   GQuark        class,
+                                                   guint64       pseudo_class_mask,
+                                                   gboolean      pseudo_class_unmasked);
+
+gboolean       mx_style_sheet_reload_file    (MxStyleSheet        *sheet,
+                                              const gchar         *filename,
+                                              MxStyleSheetChange **change);
+gboolean       mx_style_sheet_change_affects (MxStyleSheetChange  *change,
+                                              GType                type,
+                                              GQuark               id,
+                                              GQuark               class);
+void           mx_style_sheet_change_free    (MxStyleSheetChange  *change);
+
+gboolean       mx_style_sheet_add_from_compiled_file (MxStyleSheet  *sheet,
+                                                      const gchar   *filename,
+                                                      gchar        **source,
+                                                      GError       **error);
+gboolean       mx_style_sheet_compile_file   (const gchar  *source,
+                                              const gchar  *filename,
+                                              GError      **error);
+
+void           mx_style_sheet_profile_restyle      (GType    type);
+void           mx_style_sheet_profile_cache_lookup (gboolean hit);
+void           mx_style_sheet_profile_report       (void);
+gchar        **mx_style_sheet_profile_get_report   (MxStyleSheet *sheet,
+                                                    guint         max_selectors);
 
 #endif /* MX_CSS_H */
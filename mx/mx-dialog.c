@@ -33,6 +33,10 @@
  * It also allows actions to be added to it, which will be represented as
  * buttons, using #MxButton.
  *
+ * As the actors beneath a dialog are covered by it, they can be painted
+ * from a snapshot taken when the dialog maps instead, see
+ * mx_dialog_set_snapshot_parent().
+ *
  * Since: 1.2
  */
 
@@ -54,6 +58,17 @@ G_DEFINE_TYPE_WITH_CODE (MxDialog, mx_dialog, MX_TYPE_WIDGET,
 #define DIALOG_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_DIALOG, MxDialogPrivate))
 
+/* how much smaller a blurred snapshot of the parent is rendered */
+#define MX_DIALOG_BLUR_SCALE 4
+
+enum
+{
+  PROP_0,
+
+  PROP_SNAPSHOT_PARENT,
+  PROP_BLUR_PARENT
+};
+
 typedef struct {
   MxAction     *action;
   ClutterActor *button;
@@ -65,12 +80,24 @@ struct _MxDialogPrivate
 
   guint visible          : 1;
   guint child_has_focus  : 1;
+  guint snapshot_parent  : 1;
+  guint blur_parent      : 1;
+  guint painting_parent  : 1;
 
   guint  transition_time;
   gfloat angle;
 
   ClutterTimeline *timeline;
   gfloat           zoom;
+  gfloat           fade;
+  CoglHandle       snapshot;
+
+  /* The content of the transient parent, painted instead of it */
+  ClutterActor    *painted_parent;
+  gulong           parent_paint_id;
+  CoglHandle       parent_snapshot;
+  gfloat           parent_width;
+  gfloat           parent_height;
 
   /* Dialog-specific variables */
   ClutterActor  *background;
@@ -81,6 +108,7 @@ struct _MxDialogPrivate
 
 static void mx_dialog_show (ClutterActor *self);
 static void mx_dialog_hide (ClutterActor *self);
+static void mx_dialog_update_parent_snapshot (MxDialog *dialog);
 
 static MxFocusable *
 mx_dialog_move_focus (MxFocusable      *focusable,
@@ -201,6 +229,52 @@ mx_stylable_iface_init (MxStylableIface *iface)
     }
 }
 
+static void
+mx_dialog_set_property (GObject      *object,
+                        guint         prop_id,
+                        const GValue *value,
+                        GParamSpec   *pspec)
+{
+  MxDialog *dialog = MX_DIALOG (object);
+
+  switch (prop_id)
+    {
+    case PROP_SNAPSHOT_PARENT:
+      mx_dialog_set_snapshot_parent (dialog, g_value_get_boolean (value));
+      break;
+
+    case PROP_BLUR_PARENT:
+      mx_dialog_set_blur_parent (dialog, g_value_get_boolean (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+mx_dialog_get_property (GObject    *object,
+                        guint       prop_id,
+                        GValue     *value,
+                        GParamSpec *pspec)
+{
+  MxDialogPrivate *priv = MX_DIALOG (object)->priv;
+
+  switch (prop_id)
+    {
+    case PROP_SNAPSHOT_PARENT:
+      g_value_set_boolean (value, priv->snapshot_parent);
+      break;
+
+    case PROP_BLUR_PARENT:
+      g_value_set_boolean (value, priv->blur_parent);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
 static void
 mx_dialog_dispose (GObject *object)
 {
@@ -219,6 +293,26 @@ mx_dialog_dispose (GObject *object)
       priv->button_box = NULL;
     }
 
+  if (priv->snapshot)
+    {
+      cogl_handle_unref (priv->snapshot);
+      priv->snapshot = NULL;
+    }
+
+  if (priv->parent_paint_id)
+    {
+      g_signal_handler_disconnect (priv->painted_parent,
+                                   priv->parent_paint_id);
+      priv->parent_paint_id = 0;
+      priv->painted_parent = NULL;
+    }
+
+  if (priv->parent_snapshot)
+    {
+      cogl_handle_unref (priv->parent_snapshot);
+      priv->parent_snapshot = NULL;
+    }
+
   G_OBJECT_CLASS (mx_dialog_parent_class)->dispose (object);
 }
 
@@ -365,6 +459,13 @@ mx_dialog_allocate (ClutterActor           *actor,
   CLUTTER_ACTOR_CLASS (mx_dialog_parent_class)->
     allocate (actor, box, flags);
 
+  /* The content is rendered again if it is laid out during the transition */
+  if (priv->snapshot)
+    {
+      cogl_handle_unref (priv->snapshot);
+      priv->snapshot = NULL;
+    }
+
   /* Get the available space */
   mx_widget_get_available_area (MX_WIDGET (actor), box, &avail_box);
 
@@ -442,16 +543,138 @@ mx_dialog_allocate (ClutterActor           *actor,
     }
 }
 
+static void
+mx_dialog_paint_content (gpointer user_data)
+{
+  MxDialogPrivate *priv = MX_DIALOG (user_data)->priv;
+
+  clutter_actor_paint (priv->background);
+
+  if (priv->child)
+    clutter_actor_paint (priv->child);
+
+  if (priv->actions)
+    clutter_actor_paint (priv->button_box);
+}
+
+/* Paints the content of the transient parent, without the dialog */
+static void
+mx_dialog_paint_parent_content (gpointer user_data)
+{
+  MxDialogPrivate *priv = MX_DIALOG (user_data)->priv;
+  ClutterActor *parent = priv->painted_parent;
+
+  if (priv->blur_parent)
+    cogl_scale (1.f / MX_DIALOG_BLUR_SCALE, 1.f / MX_DIALOG_BLUR_SCALE, 1.f);
+
+  priv->painting_parent = TRUE;
+  CLUTTER_ACTOR_GET_CLASS (parent)->paint (parent);
+  priv->painting_parent = FALSE;
+}
+
+/* Paints the transient parent from a snapshot of its content, taken the
+ * first time it is painted, and the dialog over it. A blurred snapshot is
+ * rendered smaller and stretched over the parent again. */
+static void
+mx_dialog_parent_paint_cb (ClutterActor *parent,
+                           MxDialog     *dialog)
+{
+  MxDialogPrivate *priv = dialog->priv;
+  ClutterActorBox box;
+  gfloat width, height;
+
+  clutter_actor_get_size (parent, &width, &height);
+
+  if (priv->parent_snapshot &&
+      (priv->parent_width != width || priv->parent_height != height))
+    {
+      cogl_handle_unref (priv->parent_snapshot);
+      priv->parent_snapshot = NULL;
+    }
+
+  if (!priv->parent_snapshot)
+    {
+      box.x1 = 0;
+      box.y1 = 0;
+      box.x2 = width;
+      box.y2 = height;
+
+      if (priv->blur_parent)
+        {
+          box.x2 = MAX (1, width / MX_DIALOG_BLUR_SCALE);
+          box.y2 = MAX (1, height / MX_DIALOG_BLUR_SCALE);
+        }
+
+      priv->parent_snapshot =
+        _mx_render_to_texture (&box, mx_dialog_paint_parent_content, dialog);
+      priv->parent_width = width;
+      priv->parent_height = height;
+
+      /* Fall back to painting the parent itself */
+      if (!priv->parent_snapshot)
+        return;
+    }
+
+  _mx_paint_texture_with_opacity (priv->parent_snapshot, 0xff,
+                                  0, 0, width, height);
+
+  clutter_actor_paint (CLUTTER_ACTOR (dialog));
+
+  g_signal_stop_emission_by_name (parent, "paint");
+}
+
+/* Paints the transient parent from a snapshot while the dialog is mapped
+ * over it, if it is meant to */
+static void
+mx_dialog_update_parent_snapshot (MxDialog *dialog)
+{
+  MxDialogPrivate *priv = dialog->priv;
+  ClutterActor *actor = CLUTTER_ACTOR (dialog);
+  ClutterActor *parent = clutter_actor_get_parent (actor);
+
+  if (priv->painted_parent &&
+      (!priv->snapshot_parent || !CLUTTER_ACTOR_IS_MAPPED (actor) ||
+       priv->painted_parent != parent))
+    {
+      g_signal_handler_disconnect (priv->painted_parent,
+                                   priv->parent_paint_id);
+      clutter_actor_queue_redraw (priv->painted_parent);
+      priv->parent_paint_id = 0;
+      priv->painted_parent = NULL;
+
+      if (priv->parent_snapshot)
+        {
+          cogl_handle_unref (priv->parent_snapshot);
+          priv->parent_snapshot = NULL;
+        }
+    }
+
+  if (!priv->painted_parent && parent &&
+      priv->snapshot_parent && CLUTTER_ACTOR_IS_MAPPED (actor))
+    {
+      priv->painted_parent = parent;
+      priv->parent_paint_id =
+        g_signal_connect (parent, "paint",
+                          G_CALLBACK (mx_dialog_parent_paint_cb), dialog);
+      clutter_actor_queue_redraw (parent);
+    }
+}
+
 static void
 mx_dialog_paint (ClutterActor *actor)
 {
   gfloat width, height;
   MxDialogPrivate *priv = MX_DIALOG (actor)->priv;
 
+  /* The snapshot of the parent is taken without the dialog */
+  if (priv->painting_parent)
+    return;
+
   clutter_actor_get_size (actor, &width, &height);
 
   cogl_set_source_color4ub (0, 0, 0,
-                            0x7b * (clutter_actor_get_opacity (actor) / 255.0));
+                            0x7b * (clutter_actor_get_opacity (actor) / 255.0)
+                            * priv->fade);
   cogl_rectangle (0, 0, width, height);
 
   cogl_translate (width/2, height/2, 0);
@@ -459,13 +682,31 @@ mx_dialog_paint (ClutterActor *actor)
   cogl_rotate (priv->angle, 0, 0, 1);
   cogl_translate (-width/2, -height/2, 0);
 
-  clutter_actor_paint (priv->background);
+  /* While showing or hiding, the content is rendered once, the first time
+   * it is painted, and that is then zoomed and faded */
+  if (clutter_timeline_is_playing (priv->timeline))
+    {
+      ClutterActorBox box;
 
-  if (priv->child)
-    clutter_actor_paint (priv->child);
+      clutter_actor_get_allocation_box (priv->background, &box);
 
-  if (priv->actions)
-    clutter_actor_paint (priv->button_box);
+      if (!priv->snapshot)
+        priv->snapshot = _mx_render_to_texture (&box,
+                                                mx_dialog_paint_content,
+                                                actor);
+
+      if (priv->snapshot)
+        {
+          _mx_paint_texture_with_opacity (priv->snapshot,
+                                          (guint8)(priv->fade * 255.f),
+                                          box.x1, box.y1,
+                                          box.x2 - box.x1,
+                                          box.y2 - box.y1);
+          return;
+        }
+    }
+
+  mx_dialog_paint_content (actor);
 }
 
 static void
@@ -535,6 +776,8 @@ mx_dialog_map (ClutterActor *actor)
           mx_dialog_angle_cb (G_OBJECT (window), NULL, self);
         }
     }
+
+  mx_dialog_update_parent_snapshot (self);
 }
 
 static void
@@ -557,6 +800,8 @@ mx_dialog_unmap (ClutterActor *actor)
   clutter_actor_unmap (priv->background);
 
   CLUTTER_ACTOR_CLASS (mx_dialog_parent_class)->unmap (actor);
+
+  mx_dialog_update_parent_snapshot (MX_DIALOG (actor));
 }
 
 static void
@@ -564,9 +809,12 @@ mx_dialog_class_init (MxDialogClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
+  GParamSpec *pspec;
 
   g_type_class_add_private (klass, sizeof (MxDialogPrivate));
 
+  object_class->set_property = mx_dialog_set_property;
+  object_class->get_property = mx_dialog_get_property;
   object_class->dispose = mx_dialog_dispose;
   object_class->finalize = mx_dialog_finalize;
 
@@ -579,6 +827,37 @@ mx_dialog_class_init (MxDialogClass *klass)
   actor_class->unmap = mx_dialog_unmap;
   actor_class->show = mx_dialog_show;
   actor_class->hide = mx_dialog_hide;
+
+  /**
+   * MxDialog:snapshot-parent:
+   *
+   * Whether the transient parent is painted from a snapshot of its
+   * content, taken when the dialog maps, until the dialog is closed.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("snapshot-parent",
+                                "Snapshot parent",
+                                "Paint the parent from a snapshot while "
+                                "the dialog is shown",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_SNAPSHOT_PARENT, pspec);
+
+  /**
+   * MxDialog:blur-parent:
+   *
+   * Whether the snapshot of the transient parent is blurred. This has no
+   * effect unless #MxDialog:snapshot-parent is set.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("blur-parent",
+                                "Blur parent",
+                                "Blur the snapshot of the parent",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_BLUR_PARENT, pspec);
 }
 
 static void
@@ -591,6 +870,13 @@ mx_dialog_completed_cb (ClutterTimeline *timeline,
 
   priv->zoom = 1.f;
 
+  /* Go back to painting the content itself */
+  if (priv->snapshot)
+    {
+      cogl_handle_unref (priv->snapshot);
+      priv->snapshot = NULL;
+    }
+
   /* Reverse the direction and rewind the timeline. This means that when
    * a timeline finishes, its progress stays at 1.0, or 0.0 and it is
    * ready to start again.
@@ -617,13 +903,16 @@ mx_dialog_new_frame_cb (ClutterTimeline *timeline,
   MxDialog *frame = MX_DIALOG (self);
   MxDialogPrivate *priv = frame->priv;
   ClutterActor *parent = clutter_actor_get_parent (self);
-  gfloat opacity = clutter_timeline_get_progress (priv->timeline);
+  gfloat progress = clutter_timeline_get_progress (priv->timeline);
 
-  priv->zoom = 1.0f + (1.f - opacity) / 2.f;
-  clutter_actor_set_opacity (self, (guint8)(opacity * 255.f));
+  /* Only the way the content is painted changes, so there is no need to
+   * lay it out, nor to paint it through an offscreen buffer as changing the
+   * opacity of the dialog would */
+  priv->zoom = 1.0f + (1.f - progress) / 2.f;
+  priv->fade = progress;
 
   /* Queue a redraw on the parent, as having our hidden flag set will
-   * short-circuit the redraw queued on ourselves via set_opacity.
+   * short-circuit a redraw queued on ourselves.
    */
   if (parent)
     clutter_actor_queue_redraw (parent);
@@ -678,6 +967,8 @@ mx_dialog_init (MxDialog *self)
   MxDialogPrivate *priv = self->priv = DIALOG_PRIVATE (self);
 
   priv->transition_time = 250;
+  priv->zoom = 1.f;
+  priv->fade = 1.f;
   priv->timeline = clutter_timeline_new (priv->transition_time);
   clutter_timeline_set_progress_mode (priv->timeline,
                                       CLUTTER_EASE_OUT_QUAD);
@@ -793,7 +1084,7 @@ mx_dialog_show (ClutterActor *self)
           return;
         }
 
-      clutter_actor_set_opacity (self, 0x00);
+      priv->fade = 0.f;
       CLUTTER_ACTOR_CLASS (mx_dialog_parent_class)->show (self);
       clutter_timeline_set_progress_mode (priv->timeline, CLUTTER_EASE_OUT_QUAD);
       clutter_timeline_start (priv->timeline);
@@ -849,6 +1140,111 @@ mx_dialog_hide (ClutterActor *self)
     }
 }
 
+/**
+ * mx_dialog_set_snapshot_parent:
+ * @dialog: A #MxDialog
+ * @snapshot: %TRUE to paint the parent from a snapshot
+ *
+ * Sets whether the transient parent of @dialog is painted from a snapshot
+ * of its content while @dialog is shown over it. The snapshot is taken
+ * when @dialog maps and dropped when it is closed, so the actors beneath
+ * the dialog are not painted again in the meantime, and changes to them
+ * are not seen until it is closed.
+ *
+ * Since: 2.0
+ */
+void
+mx_dialog_set_snapshot_parent (MxDialog *dialog,
+                               gboolean  snapshot)
+{
+  MxDialogPrivate *priv;
+
+  g_return_if_fail (MX_IS_DIALOG (dialog));
+
+  priv = dialog->priv;
+
+  if (priv->snapshot_parent != snapshot)
+    {
+      priv->snapshot_parent = snapshot;
+      mx_dialog_update_parent_snapshot (dialog);
+
+      g_object_notify (G_OBJECT (dialog), "snapshot-parent");
+    }
+}
+
+/**
+ * mx_dialog_get_snapshot_parent:
+ * @dialog: A #MxDialog
+ *
+ * Gets whether the transient parent of @dialog is painted from a snapshot
+ * while @dialog is shown over it.
+ *
+ * Returns: %TRUE if the parent is painted from a snapshot
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_dialog_get_snapshot_parent (MxDialog *dialog)
+{
+  g_return_val_if_fail (MX_IS_DIALOG (dialog), FALSE);
+
+  return dialog->priv->snapshot_parent;
+}
+
+/**
+ * mx_dialog_set_blur_parent:
+ * @dialog: A #MxDialog
+ * @blur: %TRUE to blur the snapshot of the parent
+ *
+ * Sets whether the snapshot of the transient parent of @dialog is
+ * blurred. See mx_dialog_set_snapshot_parent().
+ *
+ * Since: 2.0
+ */
+void
+mx_dialog_set_blur_parent (MxDialog *dialog,
+                           gboolean  blur)
+{
+  MxDialogPrivate *priv;
+
+  g_return_if_fail (MX_IS_DIALOG (dialog));
+
+  priv = dialog->priv;
+
+  if (priv->blur_parent != blur)
+    {
+      priv->blur_parent = blur;
+
+      /* Take the snapshot again */
+      if (priv->parent_snapshot)
+        {
+          cogl_handle_unref (priv->parent_snapshot);
+          priv->parent_snapshot = NULL;
+          clutter_actor_queue_redraw (priv->painted_parent);
+        }
+
+      g_object_notify (G_OBJECT (dialog), "blur-parent");
+    }
+}
+
+/**
+ * mx_dialog_get_blur_parent:
+ * @dialog: A #MxDialog
+ *
+ * Gets whether the snapshot of the transient parent of @dialog is blurred.
+ *
+ * Returns: %TRUE if the snapshot of the parent is blurred
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_dialog_get_blur_parent (MxDialog *dialog)
+{
+  g_return_val_if_fail (MX_IS_DIALOG (dialog), FALSE);
+
+  return dialog->priv->blur_parent;
+}
+
 /**
  * mx_dialog_add_action:
  * @dialog: A #MxDialog
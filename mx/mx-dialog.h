@@ -82,6 +82,13 @@ ClutterActor *mx_dialog_new (void);
 void mx_dialog_set_transient_parent (MxDialog     *dialog,
                                      ClutterActor *actor);
 
+void     mx_dialog_set_snapshot_parent (MxDialog *dialog,
+                                        gboolean  snapshot);
+gboolean mx_dialog_get_snapshot_parent (MxDialog *dialog);
+void     mx_dialog_set_blur_parent     (MxDialog *dialog,
+                                        gboolean  blur);
+gboolean mx_dialog_get_blur_parent     (MxDialog *dialog);
+
 void   mx_dialog_add_action    (MxDialog *dialog,
                                 MxAction *action);
 void   mx_dialog_remove_action (MxDialog *dialog,
@@ -30,6 +30,7 @@
 #include "mx-enum-types.h"
 #include "mx-marshal.h"
 #include "mx-private.h"
+#include "mx-widget.h"
 
 typedef struct _DragContext DragContext;
 
@@ -39,6 +40,10 @@ struct _DragContext
   ClutterActor       *stage;
   ClutterActor       *actor;
 
+  /* the snapshot of the draggable made at the start of the drag, when it
+   * is used as the drag actor */
+  ClutterActor       *snapshot;
+
   guint               threshold;
 
   MxDragAxis          axis;
@@ -56,8 +61,15 @@ struct _DragContext
   gfloat              last_x;
   gfloat              last_y;
 
+  /* the last motion, on the stage, delivered before the next frame is
+   * painted when motion is compressed */
+  gfloat              pending_x;
+  gfloat              pending_y;
+  guint               motion_id;
+
   guint               emit_delayed_press : 1;
   guint               in_drag            : 1;
+  guint               compress_motion    : 1;
 };
 
 enum
@@ -70,11 +82,83 @@ enum
 };
 
 static GQuark quark_draggable_context = 0;
+static GQuark quark_draggable_no_compress = 0;
+static GQuark quark_draggable_snapshot = 0;
 static guint draggable_signals[LAST_SIGNAL] = { 0, };
 
 static gboolean on_stage_capture (ClutterActor *stage,
                                   ClutterEvent *event,
                                   DragContext  *context);
+static gboolean draggable_motion (DragContext *context,
+                                  gfloat       event_x,
+                                  gfloat       event_y);
+
+/* Makes the snapshot of the draggable its drag actor, if it is to be
+ * dragged as a snapshot and has no drag actor of its own. Implementations
+ * that don't take drag actors from outside keep dragging what they did */
+static void
+draggable_begin_snapshot (DragContext *context)
+{
+  ClutterActor *self = CLUTTER_ACTOR (context->draggable);
+  ClutterActor *actor = NULL;
+
+  if (context->actor || !mx_draggable_get_drag_snapshot (context->draggable))
+    return;
+
+  if (MX_IS_WIDGET (self))
+    context->snapshot = _mx_widget_get_dnd_clone (MX_WIDGET (self));
+  else
+    context->snapshot = clutter_clone_new (self);
+  g_object_ref_sink (context->snapshot);
+
+  g_object_set (G_OBJECT (context->draggable),
+                "drag-actor", context->snapshot,
+                NULL);
+  g_object_get (G_OBJECT (context->draggable), "drag-actor", &actor, NULL);
+
+  if (actor == context->snapshot)
+    context->actor = actor;
+  else
+    {
+      if (actor)
+        g_object_unref (actor);
+
+      clutter_actor_destroy (context->snapshot);
+      g_object_unref (context->snapshot);
+      context->snapshot = NULL;
+    }
+}
+
+static void
+draggable_end_snapshot (DragContext *context)
+{
+  if (!context->snapshot)
+    return;
+
+  g_object_set (G_OBJECT (context->draggable), "drag-actor", NULL, NULL);
+
+  if (context->actor == context->snapshot)
+    {
+      g_object_unref (context->actor);
+      context->actor = NULL;
+    }
+
+  clutter_actor_destroy (context->snapshot);
+  g_object_unref (context->snapshot);
+  context->snapshot = NULL;
+}
+
+static void
+draggable_begin (DragContext *context)
+{
+  draggable_begin_snapshot (context);
+
+  g_signal_emit (context->draggable, draggable_signals[DRAG_BEGIN], 0,
+                 context->press_x,
+                 context->press_y,
+                 context->press_button,
+                 context->press_modifiers);
+}
 
 static gboolean
 draggable_release (DragContext        *context,
@@ -88,6 +172,14 @@ draggable_release (DragContext        *context,
   if (!context->in_drag)
     return FALSE;
 
+  /* the motion up to the release is delivered first */
+  if (context->motion_id)
+    {
+      clutter_threads_remove_repaint_func (context->motion_id);
+      context->motion_id = 0;
+      draggable_motion (context, context->pending_x, context->pending_y);
+    }
+
   event_x = event->x;
   event_y = event->y;
   actor_x = 0;
@@ -116,9 +208,13 @@ draggable_release (DragContext        *context,
                                         context);
 
   if (!context->emit_delayed_press)
-    g_signal_emit (context->draggable, draggable_signals[DRAG_END], 0,
-                   context->last_x,
-                   context->last_y);
+    {
+      g_signal_emit (context->draggable, draggable_signals[DRAG_END], 0,
+                     context->last_x,
+                     context->last_y);
+
+      draggable_end_snapshot (context);
+    }
 
   g_object_set_data (G_OBJECT (stage), "mx-drag-actor", NULL);
 
@@ -126,10 +222,10 @@ draggable_release (DragContext        *context,
 }
 
 static gboolean
-draggable_motion (DragContext        *context,
-                  ClutterMotionEvent *event)
+draggable_motion (DragContext *context,
+                  gfloat       event_x,
+                  gfloat       event_y)
 {
-  gfloat event_x, event_y;
   gfloat actor_x, actor_y;
   gfloat delta_x, delta_y;
   ClutterActor *actor;
@@ -138,8 +234,6 @@ draggable_motion (DragContext        *context,
   if (!context->in_drag)
     return FALSE;
 
-  event_x = event->x;
-  event_y = event->y;
   actor_x = 0;
   actor_y = 0;
 
@@ -181,11 +275,7 @@ draggable_motion (DragContext        *context,
 
           context->emit_delayed_press = FALSE;
 
-          g_signal_emit (context->draggable, draggable_signals[DRAG_BEGIN], 0,
-                         context->press_x,
-                         context->press_y,
-                         context->press_button,
-                         context->press_modifiers);
+          draggable_begin (context);
 
           actor = CLUTTER_ACTOR (context->draggable);
           stage = clutter_actor_get_stage (actor);
@@ -202,6 +292,44 @@ draggable_motion (DragContext        *context,
   return FALSE;
 }
 
+static gboolean
+draggable_flush_motion (gpointer data)
+{
+  DragContext *context = data;
+
+  context->motion_id = 0;
+  draggable_motion (context, context->pending_x, context->pending_y);
+
+  return FALSE;
+}
+
+/* Keeps only the last motion of each frame, to be delivered before the
+ * frame is painted, so that the handlers of ::drag-motion move the drag
+ * actor once a frame however often the pointer reports its position */
+static gboolean
+draggable_queue_motion (DragContext        *context,
+                        ClutterMotionEvent *event)
+{
+  if (!context->compress_motion)
+    return draggable_motion (context, event->x, event->y);
+
+  context->pending_x = event->x;
+  context->pending_y = event->y;
+
+  if (!context->motion_id)
+    {
+      context->motion_id =
+        clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+                                               draggable_flush_motion,
+                                               context, NULL);
+
+      /* make sure there is a frame to deliver the motion in */
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (context->draggable));
+    }
+
+  return FALSE;
+}
+
 static gboolean
 on_stage_capture (ClutterActor *stage,
                   ClutterEvent *event,
@@ -220,7 +348,8 @@ on_stage_capture (ClutterActor *stage,
           if (!(mevent->modifier_state & CLUTTER_BUTTON1_MASK))
             return draggable_release (context, (ClutterButtonEvent *) event);
           else
-            return draggable_motion (context, (ClutterMotionEvent *) event);
+            return draggable_queue_motion (context,
+                                           (ClutterMotionEvent *) event);
         }
       break;
 
@@ -267,6 +396,13 @@ on_draggable_press (ClutterActor       *actor,
   context->press_button = event->button;
   context->press_modifiers = event->modifier_state;
   context->emit_delayed_press = FALSE;
+  context->compress_motion = mx_draggable_get_compress_motion (draggable);
+
+  if (context->actor)
+    {
+      g_object_unref (context->actor);
+      context->actor = NULL;
+    }
 
   g_object_get (G_OBJECT (draggable),
                 "drag-threshold", &context->threshold,
@@ -280,11 +416,7 @@ on_draggable_press (ClutterActor       *actor,
 
   if (context->threshold == 0)
     {
-      g_signal_emit (draggable, draggable_signals[DRAG_BEGIN], 0,
-                     context->press_x,
-                     context->press_y,
-                     context->press_button,
-                     context->press_modifiers);
+      draggable_begin (context);
 
       g_object_set_data (G_OBJECT (stage), "mx-drag-actor", actor);
     }
@@ -308,6 +440,9 @@ drag_context_free (gpointer data)
     {
       DragContext *context = data;
 
+      if (context->motion_id)
+        clutter_threads_remove_repaint_func (context->motion_id);
+
       /* disconnect any signal handlers we may have installed */
       g_signal_handlers_disconnect_by_func (context->draggable,
                                             G_CALLBACK (on_draggable_press),
@@ -325,6 +460,13 @@ drag_context_free (gpointer data)
           g_object_unref (G_OBJECT (context->actor));
           context->actor = NULL;
         }
+
+      if (context->snapshot)
+        {
+          clutter_actor_destroy (context->snapshot);
+          g_object_unref (context->snapshot);
+          context->snapshot = NULL;
+        }
 #if 0
       if (context->containment_area)
         g_boxed_free (CLUTTER_TYPE_ACTOR_BOX, context->containment_area);
@@ -352,6 +494,9 @@ drag_context_create (MxDraggable *draggable)
   context->emit_delayed_press = FALSE;
   context->stage = NULL;
   context->actor = NULL;
+  context->snapshot = NULL;
+  context->motion_id = 0;
+  context->compress_motion = TRUE;
 
   /* attach the context to the draggable */
   g_object_set_qdata_full (G_OBJECT (draggable), quark_draggable_context,
@@ -427,6 +572,10 @@ mx_draggable_base_init (gpointer g_iface)
 
       quark_draggable_context =
         g_quark_from_static_string ("mx-draggable-context");
+      quark_draggable_no_compress =
+        g_quark_from_static_string ("mx-draggable-no-compress");
+      quark_draggable_snapshot =
+        g_quark_from_static_string ("mx-draggable-snapshot");
 
       pspec = g_param_spec_boolean ("drag-enabled",
                                     "Drag Enabled",
@@ -685,6 +834,99 @@ mx_draggable_get_drag_actor (MxDraggable *draggable)
   return actor;
 }
 
+/**
+ * mx_draggable_set_compress_motion:
+ * @draggable: a #MxDraggable
+ * @compress: %TRUE to compress the motion of drags
+ *
+ * Sets whether the motion of drags is compressed. When it is, which is
+ * the default, only the last motion event of each frame is delivered, as
+ * a #MxDraggable::drag-motion emission before the frame is painted.
+ * Turning it off delivers each motion event as it comes, for drags that
+ * follow the whole path of the pointer, such as drawing.
+ *
+ * The setting is used from the next drag on.
+ *
+ * Since: 2.0
+ */
+void
+mx_draggable_set_compress_motion (MxDraggable *draggable,
+                                  gboolean     compress)
+{
+  g_return_if_fail (MX_IS_DRAGGABLE (draggable));
+
+  g_object_set_qdata (G_OBJECT (draggable), quark_draggable_no_compress,
+                      compress ? NULL : GINT_TO_POINTER (TRUE));
+}
+
+/**
+ * mx_draggable_get_compress_motion:
+ * @draggable: a #MxDraggable
+ *
+ * Gets whether the motion of drags is compressed to one
+ * #MxDraggable::drag-motion emission a frame. See
+ * mx_draggable_set_compress_motion().
+ *
+ * Return value: %TRUE if the motion of drags is compressed
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_draggable_get_compress_motion (MxDraggable *draggable)
+{
+  g_return_val_if_fail (MX_IS_DRAGGABLE (draggable), TRUE);
+
+  return !g_object_get_qdata (G_OBJECT (draggable),
+                              quark_draggable_no_compress);
+}
+
+/**
+ * mx_draggable_set_drag_snapshot:
+ * @draggable: a #MxDraggable
+ * @snapshot: %TRUE to drag a snapshot of @draggable
+ *
+ * Sets whether drags of @draggable move a snapshot of it, when it has no
+ * #MxDraggable:drag-actor of its own. The snapshot is an actor that is
+ * set as the #MxDraggable:drag-actor for the length of the drag, and that
+ * paints @draggable, as it was when the drag began, from a texture: moving
+ * it costs a textured rectangle a frame, however complex @draggable is.
+ *
+ * The snapshot is only used by implementations that take their drag
+ * actor from the #MxDraggable:drag-actor property. It is off by default,
+ * and the setting is used from the next drag on.
+ *
+ * Since: 2.0
+ */
+void
+mx_draggable_set_drag_snapshot (MxDraggable *draggable,
+                                gboolean     snapshot)
+{
+  g_return_if_fail (MX_IS_DRAGGABLE (draggable));
+
+  g_object_set_qdata (G_OBJECT (draggable), quark_draggable_snapshot,
+                      snapshot ? GINT_TO_POINTER (TRUE) : NULL);
+}
+
+/**
+ * mx_draggable_get_drag_snapshot:
+ * @draggable: a #MxDraggable
+ *
+ * Gets whether drags of @draggable move a snapshot of it. See
+ * mx_draggable_set_drag_snapshot().
+ *
+ * Return value: %TRUE if a snapshot of @draggable is dragged
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_draggable_get_drag_snapshot (MxDraggable *draggable)
+{
+  g_return_val_if_fail (MX_IS_DRAGGABLE (draggable), FALSE);
+
+  return g_object_get_qdata (G_OBJECT (draggable),
+                             quark_draggable_snapshot) != NULL;
+}
+
 void
 mx_draggable_enable (MxDraggable *draggable)
 {
@@ -128,6 +128,14 @@ void              mx_draggable_set_drag_actor       (MxDraggable       *draggabl
                                                      ClutterActor      *actor);
 ClutterActor *    mx_draggable_get_drag_actor       (MxDraggable       *draggable);
 
+void              mx_draggable_set_compress_motion  (MxDraggable       *draggable,
+                                                     gboolean           compress);
+gboolean          mx_draggable_get_compress_motion  (MxDraggable       *draggable);
+
+void              mx_draggable_set_drag_snapshot    (MxDraggable       *draggable,
+                                                     gboolean           snapshot);
+gboolean          mx_draggable_get_drag_snapshot    (MxDraggable       *draggable);
+
 void              mx_draggable_disable              (MxDraggable       *draggable);
 void              mx_draggable_enable               (MxDraggable       *draggable);
 gboolean          mx_draggable_is_enabled           (MxDraggable       *draggable);
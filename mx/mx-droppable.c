@@ -26,6 +26,8 @@
 #include "config.h"
 #endif
 
+#include <math.h>
+
 #include "mx-droppable.h"
 #include "mx-enum-types.h"
 #include "mx-marshal.h"
@@ -45,6 +47,17 @@ enum
 static guint droppable_signals[LAST_SIGNAL] = { 0, };
 static GQuark quark_drop_context = 0;
 
+/* the targets are put in bands of this many pixels down the stage */
+#define DROP_INDEX_BAND_HEIGHT 64
+
+typedef struct
+{
+  MxDroppable     *droppable;
+
+  /* the bounds of the transformed droppable, on the stage */
+  ClutterActorBox  box;
+} DropTarget;
+
 struct _DropContext
 {
   ClutterActor *stage;
@@ -53,49 +66,236 @@ struct _DropContext
 
   MxDroppable  *last_target;
 
+  /* what is being dragged; it moving doesn't move the targets */
+  MxDraggable  *draggable;
+  ClutterActor *drag_actor;
+
+  /* the mapped targets, and the ones in each band of the stage, gathered
+   * again when anything but what is being dragged is redrawn */
+  GArray       *boxes;
+  GPtrArray    *bands;
+
+  guint         index_valid : 1;
   guint         is_over : 1;
 };
 
+static void drop_context_remove_target (DropContext *context,
+                                        MxDroppable *droppable);
+
+static void
+drop_context_set_draggable (DropContext *context,
+                            MxDraggable *draggable)
+{
+  ClutterActor *drag_actor = NULL;
+
+  if (context->draggable == draggable)
+    return;
+
+  if (context->draggable)
+    g_object_remove_weak_pointer (G_OBJECT (context->draggable),
+                                  (gpointer *) &context->draggable);
+  if (context->drag_actor)
+    g_object_remove_weak_pointer (G_OBJECT (context->drag_actor),
+                                  (gpointer *) &context->drag_actor);
+
+  context->draggable = draggable;
+  context->drag_actor = NULL;
+
+  if (!draggable)
+    return;
+
+  g_object_add_weak_pointer (G_OBJECT (draggable),
+                             (gpointer *) &context->draggable);
+
+  g_object_get (G_OBJECT (draggable), "drag-actor", &drag_actor, NULL);
+  if (drag_actor)
+    {
+      context->drag_actor = drag_actor;
+      g_object_add_weak_pointer (G_OBJECT (drag_actor),
+                                 (gpointer *) &context->drag_actor);
+      g_object_unref (drag_actor);
+    }
+}
+
 static gboolean
-on_stage_capture (ClutterActor *actor,
-                  ClutterEvent *event,
-                  DropContext  *context)
+drop_context_is_dragged (DropContext  *context,
+                         ClutterActor *actor)
 {
-  MxDroppable *droppable;
-  MxDraggable *draggable;
-  ClutterActor *target;
-  gfloat event_x, event_y;
-  gboolean draggable_reactive;
+  return ((context->draggable &&
+           clutter_actor_contains (CLUTTER_ACTOR (context->draggable),
+                                   actor)) ||
+          (context->drag_actor &&
+           clutter_actor_contains (context->drag_actor, actor)));
+}
 
-  if (!(event->type == CLUTTER_MOTION ||
-        event->type == CLUTTER_BUTTON_RELEASE))
-    return FALSE;
+static void
+on_stage_queue_redraw (ClutterActor *stage,
+                       ClutterActor *origin,
+                       DropContext  *context)
+{
+  if (!context->index_valid || drop_context_is_dragged (context, origin))
+    return;
 
-  draggable = g_object_get_data (G_OBJECT (actor), "mx-drag-actor");
-  if (G_UNLIKELY (draggable == NULL))
-    return FALSE;
+  context->index_valid = FALSE;
+}
+
+static void
+drop_context_ensure_index (DropContext *context)
+{
+  gfloat stage_width, stage_height;
+  guint i, n_bands;
+  GSList *l;
+
+  if (context->index_valid)
+    return;
+
+  context->index_valid = TRUE;
+
+  clutter_actor_get_size (context->stage, &stage_width, &stage_height);
+  n_bands = MAX (1, (guint) ceilf (stage_height / DROP_INDEX_BAND_HEIGHT));
+
+  while (context->bands->len < n_bands)
+    g_ptr_array_add (context->bands, g_array_new (FALSE, FALSE,
+                                                  sizeof (guint)));
+  g_ptr_array_set_size (context->bands, n_bands);
+  for (i = 0; i < n_bands; i++)
+    g_array_set_size (g_ptr_array_index (context->bands, i), 0);
+
+  g_array_set_size (context->boxes, 0);
+
+  for (l = context->targets; l; l = l->next)
+    {
+      ClutterActor *actor = l->data;
+      ClutterVertex verts[4];
+      DropTarget target;
+      gint band, first, last;
+
+      if (!clutter_actor_is_mapped (actor))
+        continue;
+
+      clutter_actor_get_abs_allocation_vertices (actor, verts);
+
+      target.droppable = l->data;
+      target.box.x1 = MIN (MIN (verts[0].x, verts[1].x),
+                           MIN (verts[2].x, verts[3].x));
+      target.box.y1 = MIN (MIN (verts[0].y, verts[1].y),
+                           MIN (verts[2].y, verts[3].y));
+      target.box.x2 = MAX (MAX (verts[0].x, verts[1].x),
+                           MAX (verts[2].x, verts[3].x));
+      target.box.y2 = MAX (MAX (verts[0].y, verts[1].y),
+                           MAX (verts[2].y, verts[3].y));
+
+      if (target.box.y2 < 0 || target.box.y1 >= stage_height)
+        continue;
+
+      first = CLAMP ((gint) floorf (target.box.y1 / DROP_INDEX_BAND_HEIGHT),
+                     0, (gint) n_bands - 1);
+      last = CLAMP ((gint) floorf (target.box.y2 / DROP_INDEX_BAND_HEIGHT),
+                    0, (gint) n_bands - 1);
+
+      for (band = first; band <= last; band++)
+        g_array_append_val (g_ptr_array_index (context->bands, band),
+                            context->boxes->len);
+
+      g_array_append_val (context->boxes, target);
+    }
+}
+
+/* Finds the droppable under the given point of the stage from the boxes
+ * of the targets, or returns %FALSE when that is left to picking: where
+ * targets that don't contain one another overlap */
+static gboolean
+drop_context_find_target (DropContext  *context,
+                          MxDraggable  *draggable,
+                          gfloat        x,
+                          gfloat        y,
+                          MxDroppable **droppable)
+{
+  ClutterActor *deepest = NULL, *actor;
+  GArray *band;
+  guint i;
+  gint n;
+
+  drop_context_ensure_index (context);
+
+  *droppable = NULL;
+
+  n = (gint) floorf (y / DROP_INDEX_BAND_HEIGHT);
+  if (n < 0 || n >= (gint) context->bands->len)
+    return TRUE;
+
+  band = g_ptr_array_index (context->bands, n);
+  for (i = 0; i < band->len; i++)
+    {
+      DropTarget *target = &g_array_index (context->boxes, DropTarget,
+                                           g_array_index (band, guint, i));
+      gfloat local_x, local_y, width, height;
+
+      if (!clutter_actor_box_contains (&target->box, x, y))
+        continue;
+
+      actor = CLUTTER_ACTOR (target->droppable);
+      if (drop_context_is_dragged (context, actor))
+        continue;
+
+      /* the box is only the bounds of the transformed droppable */
+      clutter_actor_get_size (actor, &width, &height);
+      if (!clutter_actor_transform_stage_point (actor, x, y,
+                                                &local_x, &local_y) ||
+          local_x < 0 || local_y < 0 || local_x >= width || local_y >= height)
+        continue;
+
+      if (!deepest || clutter_actor_contains (deepest, actor))
+        deepest = actor;
+      else if (!clutter_actor_contains (actor, deepest))
+        return FALSE;
+    }
+
+  /* as when picking, the drag is over the nearest droppable up from the
+   * deepest target that accepts the drop */
+  for (actor = deepest; actor; actor = clutter_actor_get_parent (actor))
+    {
+      if (MX_IS_DROPPABLE (actor) &&
+          mx_droppable_accept_drop (MX_DROPPABLE (actor), draggable))
+        {
+          *droppable = MX_DROPPABLE (actor);
+          break;
+        }
+    }
+
+  return TRUE;
+}
+
+/* Finds the droppable under the given point of the stage by picking, or
+ * returns %FALSE when nothing is there */
+static gboolean
+drop_context_pick_target (DropContext  *context,
+                          MxDraggable  *draggable,
+                          gfloat        x,
+                          gfloat        y,
+                          MxDroppable **droppable)
+{
+  ClutterActor *target;
+  gboolean draggable_reactive;
 
   /* get the actor currently under the cursor; we set the draggable
    * unreactive so that it does not intefere with get_actor_at_pos();
    * the paint that get_actor_at_pos() performs is in the back buffer
    * so the hide/show cycle will not be visible on screen
    */
-  clutter_event_get_coords (event, &event_x, &event_y);
-
   draggable_reactive = clutter_actor_get_reactive (CLUTTER_ACTOR (draggable));
   clutter_actor_set_reactive (CLUTTER_ACTOR (draggable), FALSE);
 
-  target = clutter_stage_get_actor_at_pos (CLUTTER_STAGE (actor),
+  target = clutter_stage_get_actor_at_pos (CLUTTER_STAGE (context->stage),
                                            CLUTTER_PICK_REACTIVE,
-                                           event_x,
-                                           event_y);
+                                           x, y);
 
   clutter_actor_set_reactive (CLUTTER_ACTOR (draggable), draggable_reactive);
 
   if (G_UNLIKELY (target == NULL))
     return FALSE;
 
-  droppable = NULL;
+  *droppable = NULL;
   if (!MX_IS_DROPPABLE (target))
     {
       ClutterActor *parent = target;
@@ -108,7 +308,7 @@ on_stage_capture (ClutterActor *actor,
               MX_IS_DROPPABLE (parent) &&
               mx_droppable_accept_drop (MX_DROPPABLE (parent), draggable))
             {
-              droppable = MX_DROPPABLE (parent);
+              *droppable = MX_DROPPABLE (parent);
               break;
             }
         }
@@ -116,9 +316,40 @@ on_stage_capture (ClutterActor *actor,
   else
     {
       if (mx_droppable_accept_drop (MX_DROPPABLE (target), draggable))
-        droppable = MX_DROPPABLE (target);
+        *droppable = MX_DROPPABLE (target);
     }
 
+  return TRUE;
+}
+
+static gboolean
+on_stage_capture (ClutterActor *actor,
+                  ClutterEvent *event,
+                  DropContext  *context)
+{
+  MxDroppable *droppable;
+  MxDraggable *draggable;
+  gfloat event_x, event_y;
+
+  if (!(event->type == CLUTTER_MOTION ||
+        event->type == CLUTTER_BUTTON_RELEASE))
+    return FALSE;
+
+  draggable = g_object_get_data (G_OBJECT (actor), "mx-drag-actor");
+  if (G_UNLIKELY (draggable == NULL))
+    return FALSE;
+
+  clutter_event_get_coords (event, &event_x, &event_y);
+
+  drop_context_set_draggable (context, draggable);
+
+  /* the targets are only picked for when their boxes aren't enough */
+  if (!drop_context_find_target (context, draggable, event_x, event_y,
+                                 &droppable) &&
+      !drop_context_pick_target (context, draggable, event_x, event_y,
+                                 &droppable))
+    return FALSE;
+
   /* we are on a new target, so emit ::over-out and unset the last target */
   if (context->last_target && droppable != context->last_target)
     {
@@ -171,37 +402,84 @@ on_stage_capture (ClutterActor *actor,
   return FALSE;
 }
 
+static void
+on_target_destroy (ClutterActor *actor,
+                   DropContext  *context)
+{
+  drop_context_remove_target (context, MX_DROPPABLE (actor));
+}
+
 static void
 drop_context_destroy (gpointer data)
 {
   if (G_LIKELY (data != NULL))
     {
       DropContext *context = data;
+      GSList *l;
+
+      for (l = context->targets; l; l = l->next)
+        g_signal_handlers_disconnect_by_func (l->data,
+                                              G_CALLBACK (on_target_destroy),
+                                              context);
+
+      drop_context_set_draggable (context, NULL);
 
       g_slist_free (context->targets);
+      g_array_free (context->boxes, TRUE);
+      g_ptr_array_free (context->bands, TRUE);
       g_object_unref (context->stage);
       g_slice_free (DropContext, context);
     }
 }
 
 static void
-drop_context_update (DropContext *context,
-                     MxDroppable *droppable)
+drop_context_add_target (DropContext *context,
+                         MxDroppable *droppable)
 {
   context->targets = g_slist_prepend (context->targets, droppable);
+  context->index_valid = FALSE;
+
+  g_signal_connect (droppable, "destroy",
+                    G_CALLBACK (on_target_destroy), context);
+}
+
+static void
+drop_context_remove_target (DropContext *context,
+                            MxDroppable *droppable)
+{
+  g_signal_handlers_disconnect_by_func (droppable,
+                                        G_CALLBACK (on_target_destroy),
+                                        context);
+
+  context->targets = g_slist_remove (context->targets, droppable);
+  context->index_valid = FALSE;
+
+  if (context->last_target == droppable)
+    context->last_target = NULL;
+
+  if (context->targets == NULL)
+    {
+      g_signal_handlers_disconnect_by_func (context->stage,
+                                            G_CALLBACK (on_stage_capture),
+                                            context);
+      g_signal_handlers_disconnect_by_func (context->stage,
+                                            G_CALLBACK (on_stage_queue_redraw),
+                                            context);
+
+      g_object_set_qdata (G_OBJECT (context->stage), quark_drop_context, NULL);
+    }
 }
 
 static DropContext *
-drop_context_create (ClutterActor *stage,
-                     MxDroppable  *droppable)
+drop_context_create (ClutterActor *stage)
 {
   DropContext *retval;
 
-  retval = g_slice_new (DropContext);
+  retval = g_slice_new0 (DropContext);
   retval->stage = g_object_ref (stage);
-  retval->targets = g_slist_prepend (NULL, droppable);
-  retval->last_target = NULL;
-  retval->is_over = FALSE;
+  retval->boxes = g_array_new (FALSE, FALSE, sizeof (DropTarget));
+  retval->bands = g_ptr_array_new_with_free_func ((GDestroyNotify)
+                                                  g_array_unref);
 
   g_object_set_qdata_full (G_OBJECT (stage), quark_drop_context,
                            retval,
@@ -227,14 +505,17 @@ mx_droppable_real_enable (MxDroppable *droppable)
   context = g_object_get_qdata (G_OBJECT (stage), quark_drop_context);
   if (context == NULL)
     {
-      context = drop_context_create (stage, droppable);
+      context = drop_context_create (stage);
 
       g_signal_connect_after (stage, "captured-event",
                               G_CALLBACK (on_stage_capture),
                               context);
+      g_signal_connect (stage, "queue-redraw",
+                        G_CALLBACK (on_stage_queue_redraw),
+                        context);
     }
-  else
-    drop_context_update (context, droppable);
+
+  drop_context_add_target (context, droppable);
 }
 
 static void
@@ -251,15 +532,7 @@ mx_droppable_real_disable (MxDroppable *droppable)
   if (G_UNLIKELY (context == NULL))
     return;
 
-  context->targets = g_slist_remove (context->targets, droppable);
-  if (context->targets == NULL)
-    {
-      g_signal_handlers_disconnect_by_func (stage,
-                                            G_CALLBACK (on_stage_capture),
-                                            context);
-
-      g_object_set_qdata (G_OBJECT (stage), quark_drop_context, NULL);
-    }
+  drop_context_remove_target (context, droppable);
 }
 
 static gboolean
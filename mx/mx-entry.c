@@ -94,7 +94,8 @@ enum
   PROP_PASSWORD_CHAR,
   PROP_ICON_HIGHLIGHT_SUFFIX,
   PROP_PRIMARY_ICON_TOOLTIP_TEXT,
-  PROP_SECONDARY_ICON_TOOLTIP_TEXT
+  PROP_SECONDARY_ICON_TOOLTIP_TEXT,
+  PROP_UNDO_LIMIT
 };
 
 /* signals */
@@ -109,6 +110,20 @@ enum
 #define MX_ENTRY_GET_PRIVATE(obj)     (G_TYPE_INSTANCE_GET_PRIVATE ((obj), MX_TYPE_ENTRY, MxEntryPrivate))
 #define MX_ENTRY_PRIV(x) ((MxEntry *) x)->priv
 
+#define MX_ENTRY_UNDO_STEPS 20
+#define MX_ENTRY_DEFAULT_UNDO_LIMIT (64 * 1024)
+
+/* A step of the undo history: the text at @position was replaced by
+ * @inserted. Only the edited range is kept, so that a step costs the size
+ * of the edit rather than that of the whole text. */
+typedef struct
+{
+  gsize  position;
+  gchar *deleted;
+  gchar *inserted;
+  gsize  size;
+} MxEntryUndoStep;
+
 
 struct _MxEntryPrivate
 {
@@ -133,6 +148,9 @@ struct _MxEntryPrivate
   gunichar password_char;
 
   GQueue   *undo_history;
+  GString  *undo_text;
+  gsize     undo_size;
+  guint     undo_limit;
   gulong    undo_timeout_source;
 
   guint pause_undo : 1;
@@ -156,6 +174,14 @@ G_DEFINE_TYPE_WITH_CODE (MxEntry, mx_entry, MX_TYPE_WIDGET,
                          G_IMPLEMENT_INTERFACE (MX_TYPE_FOCUSABLE,
                                                 mx_focusable_iface_init));
 
+static void
+mx_entry_undo_step_free (MxEntryUndoStep *step)
+{
+  g_free (step->deleted);
+  g_free (step->inserted);
+  g_slice_free (MxEntryUndoStep, step);
+}
+
 static void
 mx_entry_set_property (GObject      *gobject,
                        guint         prop_id,
@@ -193,6 +219,10 @@ mx_entry_set_property (GObject      *gobject,
                                                 g_value_get_string (value));
       break;
 
+    case PROP_UNDO_LIMIT:
+      mx_entry_set_undo_limit (entry, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -242,6 +272,10 @@ mx_entry_get_property (GObject    *gobject,
                             mx_tooltip_get_text (priv->secondary_icon_tooltip));
       break;
 
+    case PROP_UNDO_LIMIT:
+      g_value_set_uint (value, priv->undo_limit);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -256,11 +290,18 @@ mx_entry_dispose (GObject *object)
 
   if (priv->undo_history)
     {
-      g_queue_foreach (priv->undo_history, (GFunc) g_free, NULL);
+      g_queue_foreach (priv->undo_history, (GFunc) mx_entry_undo_step_free,
+                       NULL);
       g_queue_free (priv->undo_history);
       priv->undo_history = NULL;
     }
 
+  if (priv->undo_text)
+    {
+      g_string_free (priv->undo_text, TRUE);
+      priv->undo_text = NULL;
+    }
+
   if (priv->undo_timeout_source)
     {
       g_source_remove (priv->undo_timeout_source);
@@ -929,24 +970,36 @@ mx_entry_key_press_event (ClutterActor    *actor,
   if ((event->modifier_state & CLUTTER_CONTROL_MASK)
       && event->keyval == CLUTTER_KEY_z)
     {
-      gchar *str;
+      MxEntryUndoStep *step;
+
+      if (!priv->undo_text)
+        return TRUE;
 
-      /* pop the current value off the undo history stack and set the text to
-       * the new value */
-      if (priv->undo_timeout_source == 0)
+      /* changes that have not been stored yet are reverted to the last
+       * stored text, otherwise the last step is popped off the undo history
+       * stack and reverted */
+      if (priv->undo_timeout_source)
         {
-          str = g_queue_pop_head (priv->undo_history);
-          g_free (str);
+          g_source_remove (priv->undo_timeout_source);
+          priv->undo_timeout_source = 0;
         }
+      else if ((step = g_queue_pop_head (priv->undo_history)))
+        {
+          g_string_erase (priv->undo_text, step->position,
+                          strlen (step->inserted));
+          g_string_insert (priv->undo_text, step->position, step->deleted);
+
+          priv->undo_size -= step->size;
+          mx_entry_undo_step_free (step);
+        }
+      else
+        return TRUE;
 
       /* prevent storing the value just restored */
       priv->pause_undo = TRUE;
 
-      if (priv->undo_history)
-        {
-          clutter_text_set_text (CLUTTER_TEXT (priv->entry),
-                                 (gchar*) g_queue_peek_head (priv->undo_history));
-        }
+      clutter_text_set_text (CLUTTER_TEXT (priv->entry), priv->undo_text->str);
+
       return TRUE;
     }
 
@@ -1110,6 +1163,21 @@ mx_entry_class_init (MxEntryClass *klass)
                                    PROP_SECONDARY_ICON_TOOLTIP_TEXT,
                                    pspec);
 
+  /**
+   * MxEntry:undo-limit:
+   *
+   * The number of bytes the undo history may use. The oldest steps are
+   * forgotten when the edits kept go over it.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_uint ("undo-limit",
+                             "Undo limit",
+                             "The number of bytes the undo history may use",
+                             0, G_MAXUINT, MX_ENTRY_DEFAULT_UNDO_LIMIT,
+                             G_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_UNDO_LIMIT, pspec);
+
   /* signals */
   /**
    * MxEntry::primary-icon-clicked:
@@ -1140,36 +1208,81 @@ mx_entry_class_init (MxEntryClass *klass)
 }
 
 
+static void
+mx_entry_trim_undo_history (MxEntry *entry)
+{
+  MxEntryPrivate *priv = entry->priv;
+  MxEntryUndoStep *step;
+
+  if (!priv->undo_history)
+    return;
+
+  /* keep the undo history to only 20 steps and within the byte limit,
+   * forgetting the oldest ones */
+  while (g_queue_get_length (priv->undo_history) > MX_ENTRY_UNDO_STEPS ||
+         (priv->undo_size > priv->undo_limit &&
+          !g_queue_is_empty (priv->undo_history)))
+    {
+      step = g_queue_pop_tail (priv->undo_history);
+
+      priv->undo_size -= step->size;
+      mx_entry_undo_step_free (step);
+    }
+}
+
 static gboolean
 mx_entry_store_undo_timeout (MxEntry *entry)
 {
-  const gchar *str;
   MxEntryPrivate *priv = entry->priv;
+  gsize old_len, new_len, prefix, suffix, max;
+  MxEntryUndoStep *step;
+  const gchar *str;
+  gchar *old;
 
   priv->undo_timeout_source = 0;
 
   str = mx_entry_get_text (entry);
+  if (!str)
+    str = "";
 
   if (!priv->undo_history)
     priv->undo_history = g_queue_new ();
 
+  if (!priv->undo_text)
+    priv->undo_text = g_string_new (NULL);
+
+  /* find the range that changed since the text was last stored */
+  old = priv->undo_text->str;
+  old_len = priv->undo_text->len;
+  new_len = strlen (str);
+  max = MIN (old_len, new_len);
+
+  for (prefix = 0; prefix < max && old[prefix] == str[prefix]; prefix++);
+
   /* prevent duplicated */
-  if (!g_strcmp0 (str, (gchar*) g_queue_peek_head (priv->undo_history)))
-    {
-      return FALSE;
-    }
+  if (prefix == old_len && prefix == new_len)
+    return FALSE;
 
-  g_queue_push_head (priv->undo_history, g_strdup (str));
+  for (suffix = 0;
+       suffix < max - prefix &&
+       old[old_len - suffix - 1] == str[new_len - suffix - 1];
+       suffix++);
 
-  /* keep the undo history to only 20 items */
-  if (g_queue_get_length (priv->undo_history) > 20)
-    {
-      gpointer *tmp;
+  step = g_slice_new (MxEntryUndoStep);
+  step->position = prefix;
+  step->deleted = g_strndup (old + prefix, old_len - prefix - suffix);
+  step->inserted = g_strndup (str + prefix, new_len - prefix - suffix);
+  step->size = sizeof (MxEntryUndoStep) + (old_len - prefix - suffix) +
+    (new_len - prefix - suffix);
 
-      tmp = g_queue_pop_tail (priv->undo_history);
+  g_queue_push_head (priv->undo_history, step);
+  priv->undo_size += step->size;
 
-      g_free (tmp);
-    }
+  /* bring the stored text up to date */
+  g_string_erase (priv->undo_text, prefix, old_len - prefix - suffix);
+  g_string_insert (priv->undo_text, prefix, step->inserted);
+
+  mx_entry_trim_undo_history (entry);
 
   return FALSE;
 }
@@ -1279,6 +1392,8 @@ mx_entry_init (MxEntry *entry)
 
   priv = entry->priv = MX_ENTRY_GET_PRIVATE (entry);
 
+  priv->undo_limit = MX_ENTRY_DEFAULT_UNDO_LIMIT;
+
 #ifdef HAVE_CLUTTER_IMCONTEXT
   priv->entry = g_object_new (CLUTTER_TYPE_IMTEXT,
 #else
@@ -1501,6 +1616,54 @@ mx_entry_get_password_char (MxEntry *entry)
   return entry->priv->password_char;
 }
 
+/**
+ * mx_entry_set_undo_limit:
+ * @entry: a #MxEntry
+ * @limit: the number of bytes the undo history may use
+ *
+ * Sets the number of bytes the undo history of @entry may use. Each step
+ * only keeps the text it changed, so the oldest steps are forgotten when
+ * the edits kept go over @limit.
+ *
+ * Since: 2.0
+ */
+void
+mx_entry_set_undo_limit (MxEntry *entry,
+                         guint    limit)
+{
+  MxEntryPrivate *priv;
+
+  g_return_if_fail (MX_IS_ENTRY (entry));
+
+  priv = entry->priv;
+
+  if (priv->undo_limit != limit)
+    {
+      priv->undo_limit = limit;
+      mx_entry_trim_undo_history (entry);
+
+      g_object_notify (G_OBJECT (entry), "undo-limit");
+    }
+}
+
+/**
+ * mx_entry_get_undo_limit:
+ * @entry: a #MxEntry
+ *
+ * Gets the number of bytes the undo history of @entry may use.
+ *
+ * Return value: the limit, in bytes
+ *
+ * Since: 2.0
+ */
+guint
+mx_entry_get_undo_limit (MxEntry *entry)
+{
+  g_return_val_if_fail (MX_IS_ENTRY (entry), 0);
+
+  return entry->priv->undo_limit;
+}
+
 static gboolean
 _mx_entry_icon_press_cb (ClutterActor       *actor,
                          ClutterButtonEvent *event,
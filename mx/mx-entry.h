@@ -92,6 +92,10 @@ void                  mx_entry_set_password_char (MxEntry  *entry,
                                                   gunichar  password_char);
 gunichar              mx_entry_get_password_char (MxEntry  *entry);
 
+void                  mx_entry_set_undo_limit (MxEntry *entry,
+                                               guint    limit);
+guint                 mx_entry_get_undo_limit (MxEntry *entry);
+
 void mx_entry_set_primary_icon_from_file   (MxEntry     *entry,
                                             const gchar *filename);
 void mx_entry_set_primary_icon_tooltip_text (MxEntry     *entry,
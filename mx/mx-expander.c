@@ -78,6 +78,7 @@ struct _MxExpanderPrivate {
 
   ClutterTimeline *timeline;
   gdouble          progress;
+  CoglHandle       snapshot;
 
   guint            expanded : 1;
 
@@ -149,6 +150,12 @@ mx_expander_dispose (GObject *object)
       priv->timeline = NULL;
     }
 
+  if (priv->snapshot)
+    {
+      cogl_handle_unref (priv->snapshot);
+      priv->snapshot = NULL;
+    }
+
   G_OBJECT_CLASS (mx_expander_parent_class)->dispose (object);
 }
 
@@ -162,10 +169,17 @@ static void
 timeline_complete (ClutterTimeline *timeline,
                    ClutterActor    *expander)
 {
-  guchar opacity;
   MxExpanderPrivate *priv = MX_EXPANDER (expander)->priv;
 
-  g_signal_emit (expander, expander_signals[EXPAND_COMPLETE], 0);
+  /* go back to painting the child itself, and allocate it the space the
+   * expander has for it */
+  if (priv->snapshot)
+    {
+      cogl_handle_unref (priv->snapshot);
+      priv->snapshot = NULL;
+    }
+
+  clutter_actor_queue_relayout (expander);
 
   /* if the expander is now closed, update the style */
   if (!priv->expanded)
@@ -173,34 +187,11 @@ timeline_complete (ClutterTimeline *timeline,
       clutter_actor_set_name (priv->arrow, "mx-expander-arrow-closed");
       mx_stylable_set_style_class (MX_STYLABLE (expander), "closed-expander");
 
-      clutter_actor_queue_relayout (expander);
-    }
-
-  if (!priv->child)
-    return;
-
-  /* continue only if we are "opening" */
-  if (!priv->expanded)
-    return;
-
-  /* we can't do an animation if there is already one in progress,
-   * because we cannot get the actors original opacity */
-  if (clutter_actor_get_transition (priv->child, "opacity"))
-    {
-      clutter_actor_show (priv->child);
-      return;
+      if (priv->child)
+        clutter_actor_hide (priv->child);
     }
 
-  opacity = clutter_actor_get_opacity (priv->child);
-  clutter_actor_set_opacity (priv->child, 0);
-
-  clutter_actor_show (priv->child);
-
-  clutter_actor_save_easing_state (priv->child);
-  clutter_actor_set_easing_mode (priv->child, CLUTTER_EASE_IN_SINE);
-  clutter_actor_set_easing_duration (priv->child, 100);
-  clutter_actor_set_opacity (priv->child, opacity);
-  clutter_actor_restore_easing_state (priv->child);
+  g_signal_emit (expander, expander_signals[EXPAND_COMPLETE], 0);
 }
 
 static void
@@ -230,19 +221,27 @@ mx_expander_update (MxExpander *expander)
   if (!priv->child)
     return;
 
-  /* setup and start the expansion animation */
+  /* setup and start the expansion animation. The child stays visible while
+   * the expander closes, and is shown as it opens, so that it can be
+   * revealed or covered */
   if (!priv->expanded)
     {
-      clutter_actor_hide (priv->child);
       clutter_timeline_set_direction (priv->timeline,
                                       CLUTTER_TIMELINE_BACKWARD);
     }
   else
     {
+      clutter_actor_show (priv->child);
       clutter_timeline_set_direction (priv->timeline,
                                       CLUTTER_TIMELINE_FORWARD);
     }
 
+  if (priv->snapshot)
+    {
+      cogl_handle_unref (priv->snapshot);
+      priv->snapshot = NULL;
+    }
+
 
   if (!clutter_timeline_is_playing (priv->timeline))
     clutter_timeline_rewind (priv->timeline);
@@ -376,6 +375,7 @@ mx_expander_allocate (ClutterActor          *actor,
 {
   MxExpanderPrivate *priv = MX_EXPANDER (actor)->priv;
   ClutterActorBox child_box;
+  MxMeasuredSize measured = { 0, };
   MxPadding padding;
   gfloat label_w, label_h;
   gfloat available_w, available_h, min_w, min_h, arrow_h, arrow_w;
@@ -411,6 +411,13 @@ mx_expander_allocate (ClutterActor          *actor,
 
   clutter_actor_get_preferred_height (priv->label,
                                       label_w, &min_h, &label_h);
+
+  /* the label is usually given the height for the same width again */
+  measured.has_height = TRUE;
+  measured.height_for_width = label_w;
+  measured.min_height = min_h;
+  measured.natural_height = label_h;
+
   label_h = CLAMP (label_h, min_h, available_h);
 
   /* TODO: make a style property for padding between arrow and label */
@@ -418,37 +425,100 @@ mx_expander_allocate (ClutterActor          *actor,
   child_box.x2 = child_box.x1 + label_w;
   child_box.y1 = padding.top;
   child_box.y2 = child_box.y1 + MAX (label_h, arrow_h);
-  mx_allocate_align_fill (priv->label, &child_box, MX_ALIGN_START,
-                          MX_ALIGN_MIDDLE, FALSE, FALSE);
+  _mx_allocate_align_fill_measured (priv->label, &child_box, MX_ALIGN_START,
+                                    MX_ALIGN_MIDDLE, FALSE, FALSE, &measured);
   clutter_actor_allocate (priv->label, &child_box, flags);
 
   /* remove label height and spacing for child calculations */
   available_h -= MAX (label_h, arrow_h) + priv->spacing;
 
   /* child */
-  if (priv->expanded && priv->child && CLUTTER_ACTOR_IS_VISIBLE (priv->child))
+  if (priv->child && CLUTTER_ACTOR_IS_VISIBLE (priv->child))
     {
       child_box.x1 = padding.left;
       child_box.x2 = child_box.x1 + available_w;
       child_box.y1 = padding.top + priv->spacing + MAX (label_h, arrow_h);
-      child_box.y2 = child_box.y1 + available_h;
+
+      /* while opening or closing, the child keeps the size it has when
+       * open, so that it is laid out once, and is cropped when painted */
+      if (clutter_timeline_is_playing (priv->timeline))
+        {
+          gfloat child_h;
+
+          clutter_actor_get_preferred_height (priv->child, available_w,
+                                              NULL, &child_h);
+          child_box.y2 = child_box.y1 + child_h;
+        }
+      else
+        child_box.y2 = child_box.y1 + available_h;
 
       clutter_actor_allocate (priv->child, &child_box, flags);
     }
 }
 
+static void
+mx_expander_paint_child (gpointer user_data)
+{
+  MxExpanderPrivate *priv = MX_EXPANDER (user_data)->priv;
+
+  clutter_actor_paint (priv->child);
+}
+
 static void
 mx_expander_paint (ClutterActor *actor)
 {
   MxExpanderPrivate *priv = ((MxExpander* ) actor)->priv;
+  ClutterActorBox box, child_box;
+  MxPadding padding;
+  gfloat height;
 
   CLUTTER_ACTOR_CLASS (mx_expander_parent_class)->paint (actor);
 
   clutter_actor_paint (priv->label);
   clutter_actor_paint (priv->arrow);
 
-  if (priv->expanded)
-    clutter_actor_paint (priv->child);
+  if (!priv->child || !CLUTTER_ACTOR_IS_VISIBLE (priv->child))
+    return;
+
+  if (!clutter_timeline_is_playing (priv->timeline))
+    {
+      if (priv->expanded)
+        clutter_actor_paint (priv->child);
+      return;
+    }
+
+  /* While opening or closing, the child is rendered once and the part of
+   * it that fits in the expander is painted from that */
+  clutter_actor_get_allocation_box (actor, &box);
+  clutter_actor_get_allocation_box (priv->child, &child_box);
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  height = MIN (child_box.y2,
+                box.y2 - box.y1 - padding.bottom) - child_box.y1;
+  if (height <= 0)
+    return;
+
+  if (!priv->snapshot)
+    priv->snapshot = _mx_render_to_texture (&child_box,
+                                            mx_expander_paint_child,
+                                            actor);
+
+  if (priv->snapshot)
+    {
+      cogl_set_source_texture (priv->snapshot);
+      cogl_rectangle_with_texture_coords (child_box.x1, child_box.y1,
+                                          child_box.x2, child_box.y1 + height,
+                                          0, 0,
+                                          1, height / (child_box.y2 -
+                                                       child_box.y1));
+    }
+  else
+    {
+      cogl_clip_push_rectangle (child_box.x1, child_box.y1,
+                                child_box.x2, child_box.y1 + height);
+      clutter_actor_paint (priv->child);
+      cogl_clip_pop ();
+    }
 }
 
 static void
@@ -459,7 +529,7 @@ mx_expander_pick (ClutterActor       *actor,
 
   CLUTTER_ACTOR_CLASS (mx_expander_parent_class)->pick (actor, color);
 
-  if (priv->expanded)
+  if (priv->expanded && !clutter_timeline_is_playing (priv->timeline))
     clutter_actor_paint (priv->child);
 }
 
@@ -57,7 +57,9 @@ enum
 
   PROP_COLOR,
 
-  PROP_FREEZE_UPDATE
+  PROP_FREEZE_UPDATE,
+
+  PROP_OVERLAY_COLOR
 };
 
 struct _MxFadeEffectPrivate
@@ -69,6 +71,7 @@ struct _MxFadeEffectPrivate
 
   guint         border[4];
   ClutterColor  color;
+  ClutterColor  overlay_color;
   gfloat        width;
   gfloat        height;
 
@@ -85,8 +88,16 @@ struct _MxFadeEffectPrivate
 
   guint         update_vbo    : 1;
   guint         freeze_update : 1;
+
+  /* whether the vbo has the colors of the overlay or of the mask */
+  guint         vbo_overlay   : 1;
 };
 
+/* With an opaque overlay color, the borders are faded by painting
+ * gradients of that color over the actor, as painted directly, rather than
+ * by redirecting the actor offscreen */
+#define MX_FADE_EFFECT_USE_OVERLAY(priv) ((priv)->overlay_color.alpha == 0xff)
+
 static void
 mx_fade_effect_get_property (GObject    *object,
                              guint       property_id,
@@ -137,6 +148,10 @@ mx_fade_effect_get_property (GObject    *object,
       g_value_set_boolean (value, priv->freeze_update);
       break;
 
+    case PROP_OVERLAY_COLOR:
+      clutter_value_set_color (value, &priv->overlay_color);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -193,6 +208,11 @@ mx_fade_effect_set_property (GObject      *object,
       priv->freeze_update = g_value_get_boolean (value);
       return;
 
+    case PROP_OVERLAY_COLOR:
+      mx_fade_effect_set_overlay_color (effect,
+                                        clutter_value_get_color (value));
+      return;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       return;
@@ -404,12 +424,30 @@ mx_fade_effect_update_vbo (MxFadeEffect *self)
 
   MxFadeEffectPrivate *priv = self->priv;
 
-  cogl_color_init_from_4ub (&opaque, 0xff, 0xff, 0xff, 0xff);
-  cogl_color_init_from_4ub (&color,
-                            priv->color.red,
-                            priv->color.green,
-                            priv->color.blue,
-                            priv->color.alpha);
+  if (priv->vbo_overlay)
+    {
+      /* Painted over the actor, the overlay has to cover it with the
+       * background where the mask would have faded it to transparent:
+       * where the mask is opaque, the overlay is transparent. The vertex
+       * colors are premultiplied. */
+      guint8 alpha = 0xff - priv->color.alpha;
+
+      cogl_color_init_from_4ub (&opaque, 0, 0, 0, 0);
+      cogl_color_init_from_4ub (&color,
+                                priv->overlay_color.red * alpha / 0xff,
+                                priv->overlay_color.green * alpha / 0xff,
+                                priv->overlay_color.blue * alpha / 0xff,
+                                alpha);
+    }
+  else
+    {
+      cogl_color_init_from_4ub (&opaque, 0xff, 0xff, 0xff, 0xff);
+      cogl_color_init_from_4ub (&color,
+                                priv->color.red,
+                                priv->color.green,
+                                priv->color.blue,
+                                priv->color.alpha);
+    }
 
   /* Validate the bounds */
   x1 = priv->x;
@@ -620,8 +658,11 @@ mx_fade_effect_paint_target (ClutterOffscreenEffect *effect)
   MxFadeEffect *self = MX_FADE_EFFECT (effect);
   MxFadeEffectPrivate *priv = self->priv;
 
-  if (priv->update_vbo)
-    mx_fade_effect_update_vbo (self);
+  if (priv->update_vbo || priv->vbo_overlay)
+    {
+      priv->vbo_overlay = FALSE;
+      mx_fade_effect_update_vbo (self);
+    }
 
   if (!priv->vbo || !priv->indices || !material)
     return;
@@ -662,6 +703,62 @@ mx_fade_effect_paint_target (ClutterOffscreenEffect *effect)
                                     priv->n_quads * 6);
 }
 
+/* Paints the actor directly, clipped to the bounds, then the overlay */
+static void
+mx_fade_effect_paint_overlay (MxFadeEffect *self)
+{
+  MxFadeEffectPrivate *priv = self->priv;
+  ClutterActor *actor;
+  gfloat width, height, x2, y2;
+
+  actor = clutter_actor_meta_get_actor (CLUTTER_ACTOR_META (self));
+
+  clutter_actor_get_size (actor, &width, &height);
+  if (width != priv->width || height != priv->height || !priv->vbo_overlay)
+    {
+      priv->width = width;
+      priv->height = height;
+      priv->vbo_overlay = TRUE;
+      priv->update_vbo = TRUE;
+    }
+
+  x2 = priv->x + (priv->bounds_width ? priv->bounds_width : width);
+  y2 = priv->y + (priv->bounds_height ? priv->bounds_height : height);
+
+  cogl_clip_push_rectangle (MAX (priv->x, 0), MAX (priv->y, 0),
+                            MIN (x2, width), MIN (y2, height));
+  clutter_actor_continue_paint (actor);
+  cogl_clip_pop ();
+
+  if (priv->update_vbo)
+    mx_fade_effect_update_vbo (self);
+
+  if (!priv->vbo || !priv->indices)
+    return;
+
+  /* the vertex colors are the overlay, the material is only white */
+  cogl_set_source_color4ub (0xff, 0xff, 0xff, 0xff);
+  cogl_vertex_buffer_draw_elements (priv->vbo,
+                                    COGL_VERTICES_MODE_TRIANGLES,
+                                    priv->indices,
+                                    0,
+                                    (priv->n_quads * 4) - 1,
+                                    0,
+                                    priv->n_quads * 6);
+}
+
+static void
+mx_fade_effect_paint (ClutterEffect           *effect,
+                      ClutterEffectPaintFlags  flags)
+{
+  MxFadeEffect *self = MX_FADE_EFFECT (effect);
+
+  if (MX_FADE_EFFECT_USE_OVERLAY (self->priv))
+    mx_fade_effect_paint_overlay (self);
+  else
+    CLUTTER_EFFECT_CLASS (mx_fade_effect_parent_class)->paint (effect, flags);
+}
+
 static void
 mx_fade_effect_class_init (MxFadeEffectClass *klass)
 {
@@ -680,6 +777,7 @@ mx_fade_effect_class_init (MxFadeEffectClass *klass)
   object_class->dispose = mx_fade_effect_dispose;
   object_class->finalize = mx_fade_effect_finalize;
 
+  effect_class->paint = mx_fade_effect_paint;
   effect_class->pre_paint = mx_fade_effect_pre_paint;
   effect_class->post_paint = mx_fade_effect_post_paint;
 
@@ -757,6 +855,27 @@ mx_fade_effect_class_init (MxFadeEffectClass *klass)
                                 MX_PARAM_READWRITE |
                                 MX_PARAM_TRANSLATEABLE);
   g_object_class_install_property (object_class, PROP_FREEZE_UPDATE, pspec);
+
+  /**
+   * MxFadeEffect:overlay-color:
+   *
+   * The color of what is behind the actor, when it is known to be uniform
+   * and opaque. When this is opaque, the actor is painted as usual and the
+   * borders are faded by painting gradients of this color over it, which
+   * avoids rendering the actor offscreen on every change. Otherwise, the
+   * actor is faded through an offscreen buffer.
+   *
+   * Since: 2.0
+   */
+  pspec = clutter_param_spec_color ("overlay-color",
+                                    "Overlay color",
+                                    "Color of what is behind the actor, to "
+                                    "fade the borders to without an "
+                                    "offscreen buffer",
+                                    &transparent,
+                                    MX_PARAM_READWRITE |
+                                    MX_PARAM_TRANSLATEABLE);
+  g_object_class_install_property (object_class, PROP_OVERLAY_COLOR, pspec);
 }
 
 static void
@@ -921,6 +1040,62 @@ mx_fade_effect_get_color (MxFadeEffect *effect,
     *color = priv->color;
 }
 
+/**
+ * mx_fade_effect_set_overlay_color:
+ * @effect: A #MxFadeEffect
+ * @color: A #ClutterColor
+ *
+ * Sets the #MxFadeEffect:overlay-color property. With an opaque color, the
+ * borders are faded by painting over the actor rather than through an
+ * offscreen buffer. That is only correct when what is behind the actor is
+ * of that uniform color.
+ *
+ * Since: 2.0
+ */
+void
+mx_fade_effect_set_overlay_color (MxFadeEffect       *effect,
+                                  const ClutterColor *color)
+{
+  MxFadeEffectPrivate *priv;
+  ClutterActor *actor;
+
+  g_return_if_fail (MX_IS_FADE_EFFECT (effect));
+  g_return_if_fail (color != NULL);
+
+  priv = effect->priv;
+  if (!clutter_color_equal (&priv->overlay_color, color))
+    {
+      priv->overlay_color = *color;
+      priv->update_vbo = TRUE;
+
+      /* paint the actor again rather than from the offscreen buffer */
+      actor = clutter_actor_meta_get_actor (CLUTTER_ACTOR_META (effect));
+      if (actor)
+        clutter_actor_queue_redraw (actor);
+
+      g_object_notify (G_OBJECT (effect), "overlay-color");
+    }
+}
+
+/**
+ * mx_fade_effect_get_overlay_color:
+ * @effect: A #MxFadeEffect
+ * @color: (out): A #ClutterColor to store the color in
+ *
+ * Retrieves the #MxFadeEffect:overlay-color property.
+ *
+ * Since: 2.0
+ */
+void
+mx_fade_effect_get_overlay_color (MxFadeEffect *effect,
+                                  ClutterColor *color)
+{
+  g_return_if_fail (MX_IS_FADE_EFFECT (effect));
+
+  if (color)
+    *color = effect->priv->overlay_color;
+}
+
 /**
  * mx_fade_effect_set_bounds:
  * @effect: A #MxFadeEffect
@@ -98,6 +98,11 @@ void mx_fade_effect_set_color (MxFadeEffect       *effect,
 void mx_fade_effect_get_color (MxFadeEffect       *effect,
                                ClutterColor       *color);
 
+void mx_fade_effect_set_overlay_color (MxFadeEffect       *effect,
+                                       const ClutterColor *color);
+void mx_fade_effect_get_overlay_color (MxFadeEffect       *effect,
+                                       ClutterColor       *color);
+
 G_END_DECLS
 
 #endif /* _MX_FADE_EFFECT_H */
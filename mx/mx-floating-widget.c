@@ -20,6 +20,8 @@
  *
  */
 
+#include <math.h>
+
 #include "mx-floating-widget.h"
 
 G_DEFINE_ABSTRACT_TYPE (MxFloatingWidget, mx_floating_widget, MX_TYPE_WIDGET)
@@ -33,9 +35,6 @@ struct _MxFloatingWidgetPrivate
 
   CoglMatrix paint_matrix;
   CoglMatrix pick_matrix;
-
-  gulong pick_handler;
-  gulong paint_handler;
 };
 
 
@@ -71,6 +70,33 @@ mx_floating_widget_finalize (GObject *object)
   G_OBJECT_CLASS (mx_floating_widget_parent_class)->finalize (object);
 }
 
+/* The floating widgets mapped on a stage are painted and picked by the
+ * layer of the stage, above everything else. As the stage is painted, the
+ * layer keeps what is painted under the floating widgets, so that frames
+ * where only the floating widgets changed, like the frames of a menu or
+ * a tooltip fading in, paint that instead of the content of the stage.
+ *
+ * The underlay is read back from the framebuffer, which waits for the
+ * frame to be rendered, so it is only read in frames where a floating
+ * widget changed, and dropped as soon as anything else changes */
+typedef struct
+{
+  ClutterActor          *stage;
+
+  /* the mapped floating widgets, in the order they are painted in */
+  GList                 *widgets;
+
+  CoglHandle             underlay;
+  cairo_rectangle_int_t  underlay_box;
+
+  /* the origins of the redraws queued since the last frame */
+  guint                  floating_redraws : 1;
+  guint                  other_redraws    : 1;
+
+  /* whether the frame being painted may read the underlay back */
+  guint                  capture          : 1;
+} MxFloatingLayer;
+
 static void
 stage_weak_notify (MxFloatingWidget *widget,
                    ClutterStage     *stage)
@@ -79,97 +105,306 @@ stage_weak_notify (MxFloatingWidget *widget,
 }
 
 static void
-mx_floating_widget_pick_from_stage (ClutterActor       *stage,
-                                    const ClutterColor *color,
-                                    MxFloatingWidget   *widget)
+mx_floating_layer_drop_underlay (MxFloatingLayer *layer)
 {
-  MxFloatingWidgetClass *klass;
-  MxFloatingWidgetPrivate *priv = widget->priv;
-  gboolean has_clip;
+  if (layer->underlay)
+    {
+      cogl_handle_unref (layer->underlay);
+      layer->underlay = NULL;
+    }
+}
 
-  if (!CLUTTER_ACTOR_IS_REACTIVE (widget))
-    return;
+/* Gets the part of the stage the floating widgets cover, in pixels */
+static gboolean
+mx_floating_layer_get_box (MxFloatingLayer       *layer,
+                           cairo_rectangle_int_t *rect)
+{
+  ClutterActorBox box = { 0, }, paint_box;
+  gboolean has_box = FALSE;
+  gfloat width, height;
+  GList *l;
 
-  klass = MX_FLOATING_WIDGET_CLASS (G_OBJECT_GET_CLASS (widget));
+  for (l = layer->widgets; l; l = l->next)
+    {
+      ClutterActor *actor = l->data;
+
+      if (!CLUTTER_ACTOR_IS_VISIBLE (actor))
+        continue;
+
+      if (!clutter_actor_get_paint_box (actor, &paint_box))
+        return FALSE;
+
+      if (has_box)
+        clutter_actor_box_union (&box, &paint_box, &box);
+      else
+        box = paint_box;
+      has_box = TRUE;
+    }
 
-  cogl_push_matrix ();
+  if (!has_box)
+    return FALSE;
 
-  cogl_set_modelview_matrix (&(priv->pick_matrix));
+  clutter_actor_get_size (layer->stage, &width, &height);
+  box.x1 = MAX (0, floorf (box.x1));
+  box.y1 = MAX (0, floorf (box.y1));
+  box.x2 = MIN (width, ceilf (box.x2));
+  box.y2 = MIN (height, ceilf (box.y2));
 
-  has_clip = clutter_actor_has_clip (CLUTTER_ACTOR (widget));
+  if (box.x2 <= box.x1 || box.y2 <= box.y1)
+    return FALSE;
 
-  if (has_clip)
+  rect->x = box.x1;
+  rect->y = box.y1;
+  rect->width = box.x2 - box.x1;
+  rect->height = box.y2 - box.y1;
+
+  return TRUE;
+}
+
+static gboolean
+mx_floating_layer_box_contains (const cairo_rectangle_int_t *outer,
+                                const cairo_rectangle_int_t *inner)
+{
+  return inner->x >= outer->x && inner->y >= outer->y &&
+    inner->x + inner->width <= outer->x + outer->width &&
+    inner->y + inner->height <= outer->y + outer->height;
+}
+
+static void
+mx_floating_layer_paint_widgets (MxFloatingLayer *layer)
+{
+  GList *l;
+
+  for (l = layer->widgets; l; l = l->next)
     {
-      gfloat x, y, w, h;
-      clutter_actor_get_clip (CLUTTER_ACTOR (widget), &x, &y, &w, &h);
-      cogl_clip_push_rectangle (x, y, x + w, y + h);
+      MxFloatingWidget *widget = l->data;
+      MxFloatingWidgetClass *klass;
+      gboolean has_clip;
+
+      klass = MX_FLOATING_WIDGET_GET_CLASS (widget);
+
+      cogl_push_matrix ();
+
+      cogl_set_modelview_matrix (&(widget->priv->paint_matrix));
+
+      has_clip = clutter_actor_has_clip (CLUTTER_ACTOR (widget));
+
+      if (has_clip)
+        {
+          gfloat x, y, w, h;
+          clutter_actor_get_clip (CLUTTER_ACTOR (widget), &x, &y, &w, &h);
+          cogl_clip_push_rectangle (x, y, x + w, y + h);
+        }
+
+      if (klass->floating_paint)
+        klass->floating_paint (CLUTTER_ACTOR (widget));
+
+      if (has_clip)
+        cogl_clip_pop ();
+
+      cogl_pop_matrix ();
     }
+}
 
-  if (klass->floating_pick)
-    klass->floating_pick (CLUTTER_ACTOR (widget), color);
+static void
+mx_floating_layer_queue_redraw (ClutterActor    *stage,
+                                ClutterActor    *origin,
+                                MxFloatingLayer *layer)
+{
+  ClutterActor *actor;
 
-  if (has_clip)
-    cogl_clip_pop ();
+  for (actor = origin; actor; actor = clutter_actor_get_parent (actor))
+    if (MX_IS_FLOATING_WIDGET (actor))
+      {
+        layer->floating_redraws = TRUE;
+        return;
+      }
 
-  cogl_pop_matrix ();
+  layer->other_redraws = TRUE;
 }
 
+/* When only floating widgets changed since the last frame and they cover
+ * what they did then, what is under them is painted from the underlay and
+ * the content of the stage is skipped */
 static void
-mx_floating_widget_paint_from_stage (ClutterActor     *stage,
-                                     MxFloatingWidget *widget)
+mx_floating_layer_paint_under (ClutterActor    *stage,
+                               MxFloatingLayer *layer)
 {
-  MxFloatingWidgetClass *klass;
-  MxFloatingWidgetPrivate *priv = widget->priv;
-  gboolean has_clip;
+  cairo_rectangle_int_t box, clip;
+  gboolean floating_only;
+  CoglHandle material;
 
-  klass = MX_FLOATING_WIDGET_CLASS (G_OBJECT_GET_CLASS (widget));
+  floating_only = layer->floating_redraws && !layer->other_redraws;
 
-  cogl_push_matrix ();
+  if (layer->other_redraws)
+    mx_floating_layer_drop_underlay (layer);
 
-  cogl_set_modelview_matrix (&(priv->paint_matrix));
+  layer->capture = layer->floating_redraws;
+  layer->floating_redraws = FALSE;
+  layer->other_redraws = FALSE;
 
-  has_clip = clutter_actor_has_clip (CLUTTER_ACTOR (widget));
+  if (!floating_only || !layer->underlay)
+    return;
 
-  if (has_clip)
+  if (!mx_floating_layer_get_box (layer, &box) ||
+      box.x != layer->underlay_box.x || box.y != layer->underlay_box.y ||
+      box.width != layer->underlay_box.width ||
+      box.height != layer->underlay_box.height)
     {
-      gfloat x, y, w, h;
-      clutter_actor_get_clip (CLUTTER_ACTOR (widget), &x, &y, &w, &h);
-      cogl_clip_push_rectangle (x, y, x + w, y + h);
+      mx_floating_layer_drop_underlay (layer);
+      return;
     }
 
-  if (klass->floating_paint)
-    klass->floating_paint (CLUTTER_ACTOR (widget));
+  clutter_stage_get_redraw_clip_bounds (CLUTTER_STAGE (stage), &clip);
+  if (!mx_floating_layer_box_contains (&box, &clip))
+    return;
+
+  /* the underlay replaces what was there, rather than blending over it */
+  material = cogl_material_new ();
+  cogl_material_set_layer (material, 0, layer->underlay);
+  cogl_material_set_blend (material, "RGBA = ADD (SRC_COLOR, 0)", NULL);
+  cogl_set_source (material);
+  cogl_rectangle (box.x, box.y, box.x + box.width, box.y + box.height);
+  cogl_handle_unref (material);
 
-  if (has_clip)
-    cogl_clip_pop ();
+  mx_floating_layer_paint_widgets (layer);
+
+  g_signal_stop_emission_by_name (stage, "paint");
+}
+
+static void
+mx_floating_layer_paint (ClutterActor    *stage,
+                         MxFloatingLayer *layer)
+{
+  cairo_rectangle_int_t box, clip;
+
+  if (layer->capture &&
+      mx_floating_layer_get_box (layer, &box))
+    {
+      clutter_stage_get_redraw_clip_bounds (CLUTTER_STAGE (stage), &clip);
+
+      if (mx_floating_layer_box_contains (&clip, &box))
+        {
+          guint8 *pixels = g_malloc (box.width * box.height * 4);
+
+          mx_floating_layer_drop_underlay (layer);
+
+          cogl_read_pixels (box.x, box.y, box.width, box.height,
+                            COGL_READ_PIXELS_COLOR_BUFFER,
+                            COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                            pixels);
+          layer->underlay =
+            cogl_texture_new_from_data (box.width, box.height,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                        COGL_PIXEL_FORMAT_ANY,
+                                        box.width * 4,
+                                        pixels);
+          layer->underlay_box = box;
+
+          g_free (pixels);
+        }
+    }
+
+  layer->capture = FALSE;
+
+  mx_floating_layer_paint_widgets (layer);
+}
+
+static void
+mx_floating_layer_pick (ClutterActor       *stage,
+                        const ClutterColor *color,
+                        MxFloatingLayer    *layer)
+{
+  GList *l;
 
-  cogl_pop_matrix ();
+  for (l = layer->widgets; l; l = l->next)
+    {
+      MxFloatingWidget *widget = l->data;
+      MxFloatingWidgetClass *klass;
+      gboolean has_clip;
+
+      if (!CLUTTER_ACTOR_IS_REACTIVE (widget))
+        continue;
+
+      klass = MX_FLOATING_WIDGET_GET_CLASS (widget);
+
+      cogl_push_matrix ();
+
+      cogl_set_modelview_matrix (&(widget->priv->pick_matrix));
+
+      has_clip = clutter_actor_has_clip (CLUTTER_ACTOR (widget));
+
+      if (has_clip)
+        {
+          gfloat x, y, w, h;
+          clutter_actor_get_clip (CLUTTER_ACTOR (widget), &x, &y, &w, &h);
+          cogl_clip_push_rectangle (x, y, x + w, y + h);
+        }
+
+      if (klass->floating_pick)
+        klass->floating_pick (CLUTTER_ACTOR (widget), color);
+
+      if (has_clip)
+        cogl_clip_pop ();
+
+      cogl_pop_matrix ();
+    }
+}
+
+static void
+mx_floating_layer_free (MxFloatingLayer *layer)
+{
+  mx_floating_layer_drop_underlay (layer);
+  g_list_free (layer->widgets);
+  g_slice_free (MxFloatingLayer, layer);
+}
+
+static MxFloatingLayer *
+mx_floating_layer_get (ClutterActor *stage,
+                       gboolean      create)
+{
+  MxFloatingLayer *layer;
+
+  layer = g_object_get_data (G_OBJECT (stage), "mx-floating-layer");
+  if (layer || !create)
+    return layer;
+
+  layer = g_slice_new0 (MxFloatingLayer);
+  layer->stage = stage;
+
+  g_object_set_data_full (G_OBJECT (stage), "mx-floating-layer", layer,
+                          (GDestroyNotify) mx_floating_layer_free);
+
+  /* the underlay is painted before the content of the stage, and the
+   * widgets after the paint and pick handlers connected so far, so that
+   * they are painted and picked above everything else */
+  g_signal_connect (stage, "paint",
+                    G_CALLBACK (mx_floating_layer_paint_under), layer);
+  g_signal_connect_after (stage, "paint",
+                          G_CALLBACK (mx_floating_layer_paint), layer);
+  g_signal_connect_after (stage, "pick",
+                          G_CALLBACK (mx_floating_layer_pick), layer);
+  g_signal_connect (stage, "queue-redraw",
+                    G_CALLBACK (mx_floating_layer_queue_redraw), layer);
+
+  return layer;
 }
 
 static void
 mx_floating_widget_map (ClutterActor *actor)
 {
   MxFloatingWidgetPrivate *priv = MX_FLOATING_WIDGET (actor)->priv;
+  MxFloatingLayer *layer;
 
   CLUTTER_ACTOR_CLASS (mx_floating_widget_parent_class)->map (actor);
 
-  /* connect after the paint and pick signals on the stage have run, so that
-   * we can be sure to be painted and picked above all other actors else */
   priv->stage = clutter_actor_get_stage (actor);
   g_object_weak_ref (G_OBJECT (priv->stage), (GWeakNotify) stage_weak_notify,
                      actor);
 
-  priv->paint_handler =
-    g_signal_connect_after (priv->stage,
-                            "paint",
-                            G_CALLBACK (mx_floating_widget_paint_from_stage),
-                            actor);
-
-  priv->pick_handler =
-    g_signal_connect_after (priv->stage,
-                            "pick",
-                            G_CALLBACK (mx_floating_widget_pick_from_stage),
-                            actor);
+  layer = mx_floating_layer_get (priv->stage, TRUE);
+  layer->widgets = g_list_append (layer->widgets, actor);
 }
 
 static void
@@ -181,11 +416,13 @@ mx_floating_widget_unmap (ClutterActor *actor)
 
   if (priv->stage)
     {
-      g_signal_handler_disconnect (priv->stage, priv->paint_handler);
-      priv->paint_handler = 0;
+      MxFloatingLayer *layer = mx_floating_layer_get (priv->stage, FALSE);
 
-      g_signal_handler_disconnect (priv->stage, priv->pick_handler);
-      priv->pick_handler = 0;
+      if (layer)
+        {
+          layer->widgets = g_list_remove (layer->widgets, actor);
+          mx_floating_layer_drop_underlay (layer);
+        }
 
       g_object_weak_unref (G_OBJECT (priv->stage),
                            (GWeakNotify) stage_weak_notify,
@@ -0,0 +1,440 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-focus-index.c: Spatial index of the focusable children of a container
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "mx-focus-index.h"
+
+/* Cells grow past the average size of a child rather than there being
+ * more than this many */
+#define MX_FOCUS_INDEX_MAX_CELLS 4096
+
+/* How much being out of line with the focus counts against a child,
+ * relative to its distance in the direction of the move */
+#define MX_FOCUS_INDEX_MISALIGNMENT 2.0f
+
+typedef struct
+{
+  ClutterActor    *actor;
+  ClutterActorBox  box;
+
+  /* the last search that looked at the entry, and the last move it
+   * refused the focus in */
+  guint            visited;
+  guint            refused;
+} MxFocusIndexEntry;
+
+struct _MxFocusIndex
+{
+  ClutterActor *container;
+
+  gboolean      valid;
+
+  GArray       *entries;
+
+  /* indices of the entries each cell holds, cell after cell, with the
+   * first for each cell in cell_starts */
+  GArray       *cell_entries;
+  GArray       *cell_starts;
+
+  gfloat        x;
+  gfloat        y;
+  gfloat        cell_width;
+  gfloat        cell_height;
+  gint          n_cols;
+  gint          n_rows;
+
+  guint         serial;
+};
+
+MxFocusIndex *
+_mx_focus_index_new (ClutterActor *container)
+{
+  MxFocusIndex *index = g_slice_new0 (MxFocusIndex);
+
+  index->container = container;
+  index->entries = g_array_new (FALSE, FALSE, sizeof (MxFocusIndexEntry));
+  index->cell_entries = g_array_new (FALSE, FALSE, sizeof (guint));
+  index->cell_starts = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  return index;
+}
+
+void
+_mx_focus_index_free (MxFocusIndex *index)
+{
+  g_array_free (index->entries, TRUE);
+  g_array_free (index->cell_entries, TRUE);
+  g_array_free (index->cell_starts, TRUE);
+
+  g_slice_free (MxFocusIndex, index);
+}
+
+void
+_mx_focus_index_invalidate (MxFocusIndex *index)
+{
+  index->valid = FALSE;
+}
+
+static void
+mx_focus_index_get_cells (MxFocusIndex          *index,
+                          const ClutterActorBox *box,
+                          gint                  *col1,
+                          gint                  *row1,
+                          gint                  *col2,
+                          gint                  *row2)
+{
+  *col1 = CLAMP ((gint) floorf ((box->x1 - index->x) / index->cell_width),
+                 0, index->n_cols - 1);
+  *col2 = CLAMP ((gint) floorf ((box->x2 - index->x) / index->cell_width),
+                 0, index->n_cols - 1);
+  *row1 = CLAMP ((gint) floorf ((box->y1 - index->y) / index->cell_height),
+                 0, index->n_rows - 1);
+  *row2 = CLAMP ((gint) floorf ((box->y2 - index->y) / index->cell_height),
+                 0, index->n_rows - 1);
+}
+
+static void
+mx_focus_index_build (MxFocusIndex *index)
+{
+  ClutterActorBox bounds = { G_MAXFLOAT, G_MAXFLOAT,
+                             -G_MAXFLOAT, -G_MAXFLOAT };
+  gfloat total_width = 0, total_height = 0;
+  ClutterActorIter iter;
+  ClutterActor *child;
+  guint i, n_cells, *starts;
+  gint col, row;
+
+  g_array_set_size (index->entries, 0);
+  g_array_set_size (index->cell_entries, 0);
+  index->valid = TRUE;
+
+  clutter_actor_iter_init (&iter, index->container);
+  while (clutter_actor_iter_next (&iter, &child))
+    {
+      MxFocusIndexEntry entry = { child, };
+
+      if (!MX_IS_FOCUSABLE (child) || !CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      clutter_actor_get_allocation_box (child, &entry.box);
+      g_array_append_val (index->entries, entry);
+
+      bounds.x1 = MIN (bounds.x1, entry.box.x1);
+      bounds.y1 = MIN (bounds.y1, entry.box.y1);
+      bounds.x2 = MAX (bounds.x2, entry.box.x2);
+      bounds.y2 = MAX (bounds.y2, entry.box.y2);
+      total_width += entry.box.x2 - entry.box.x1;
+      total_height += entry.box.y2 - entry.box.y1;
+    }
+
+  if (!index->entries->len)
+    {
+      index->n_cols = index->n_rows = 0;
+      return;
+    }
+
+  /* cells are the size of an average child, or bigger if there would be
+   * too many of them */
+  index->x = bounds.x1;
+  index->y = bounds.y1;
+  index->cell_width = MAX (1.0f, total_width / index->entries->len);
+  index->cell_height = MAX (1.0f, total_height / index->entries->len);
+
+  while (TRUE)
+    {
+      index->n_cols = MAX (1, (gint) ceilf ((bounds.x2 - bounds.x1) /
+                                            index->cell_width));
+      index->n_rows = MAX (1, (gint) ceilf ((bounds.y2 - bounds.y1) /
+                                            index->cell_height));
+
+      if (index->n_cols * index->n_rows <= MX_FOCUS_INDEX_MAX_CELLS)
+        break;
+
+      index->cell_width *= 1.5f;
+      index->cell_height *= 1.5f;
+    }
+
+  /* count the entries of each cell, then fill them in */
+  n_cells = index->n_cols * index->n_rows;
+  g_array_set_size (index->cell_starts, n_cells + 1);
+  starts = (guint *) index->cell_starts->data;
+  memset (starts, 0, (n_cells + 1) * sizeof (guint));
+
+  for (i = 0; i < index->entries->len; i++)
+    {
+      MxFocusIndexEntry *entry =
+        &g_array_index (index->entries, MxFocusIndexEntry, i);
+      gint col1, row1, col2, row2;
+
+      mx_focus_index_get_cells (index, &entry->box, &col1, &row1, &col2, &row2);
+
+      for (row = row1; row <= row2; row++)
+        for (col = col1; col <= col2; col++)
+          starts[row * index->n_cols + col + 1]++;
+    }
+
+  for (i = 0; i < n_cells; i++)
+    starts[i + 1] += starts[i];
+
+  g_array_set_size (index->cell_entries, starts[n_cells]);
+
+  for (i = 0; i < index->entries->len; i++)
+    {
+      MxFocusIndexEntry *entry =
+        &g_array_index (index->entries, MxFocusIndexEntry, i);
+      gint col1, row1, col2, row2;
+
+      mx_focus_index_get_cells (index, &entry->box, &col1, &row1, &col2, &row2);
+
+      /* starts[cell] is used as the fill position, and ends up at the
+       * start of the next cell */
+      for (row = row1; row <= row2; row++)
+        for (col = col1; col <= col2; col++)
+          g_array_index (index->cell_entries, guint,
+                         starts[row * index->n_cols + col]++) = i;
+    }
+
+  for (i = n_cells; i > 0; i--)
+    starts[i] = starts[i - 1];
+  starts[0] = 0;
+}
+
+/* Scores @box as the destination of a move in @direction from @from, the
+ * lower the better, or returns %FALSE when it is not in that direction */
+static gboolean
+mx_focus_index_score (const ClutterActorBox *from,
+                      const ClutterActorBox *box,
+                      MxFocusDirection       direction,
+                      gfloat                *score)
+{
+  gfloat distance, gap, offset;
+
+  switch (direction)
+    {
+    case MX_FOCUS_DIRECTION_LEFT:
+      if (box->x1 + box->x2 >= from->x1 + from->x2 || box->x1 >= from->x1)
+        return FALSE;
+      distance = from->x1 - box->x2;
+      break;
+
+    case MX_FOCUS_DIRECTION_RIGHT:
+      if (box->x1 + box->x2 <= from->x1 + from->x2 || box->x2 <= from->x2)
+        return FALSE;
+      distance = box->x1 - from->x2;
+      break;
+
+    case MX_FOCUS_DIRECTION_UP:
+      if (box->y1 + box->y2 >= from->y1 + from->y2 || box->y1 >= from->y1)
+        return FALSE;
+      distance = from->y1 - box->y2;
+      break;
+
+    case MX_FOCUS_DIRECTION_DOWN:
+      if (box->y1 + box->y2 <= from->y1 + from->y2 || box->y2 <= from->y2)
+        return FALSE;
+      distance = box->y1 - from->y2;
+      break;
+
+    default:
+      return FALSE;
+    }
+
+  /* the gap across the direction of the move, and the offset between
+   * centres to break ties between children level with @from */
+  if (direction == MX_FOCUS_DIRECTION_LEFT ||
+      direction == MX_FOCUS_DIRECTION_RIGHT)
+    {
+      gap = MAX (box->y1, from->y1) - MIN (box->y2, from->y2);
+      offset = (box->y1 + box->y2 - from->y1 - from->y2) / 2;
+    }
+  else
+    {
+      gap = MAX (box->x1, from->x1) - MIN (box->x2, from->x2);
+      offset = (box->x1 + box->x2 - from->x1 - from->x2) / 2;
+    }
+
+  *score = MAX (distance, 0) +
+           MX_FOCUS_INDEX_MISALIGNMENT * MAX (gap, 0) +
+           ABS (offset) / 100.0f;
+
+  return TRUE;
+}
+
+static void
+mx_focus_index_search_cell (MxFocusIndex          *index,
+                            gint                   col,
+                            gint                   row,
+                            ClutterActor          *from,
+                            const ClutterActorBox *from_box,
+                            MxFocusDirection       direction,
+                            guint                  move,
+                            MxFocusIndexEntry    **best,
+                            gfloat                *best_score)
+{
+  guint cell = row * index->n_cols + col;
+  guint i, end;
+
+  end = g_array_index (index->cell_starts, guint, cell + 1);
+  for (i = g_array_index (index->cell_starts, guint, cell); i < end; i++)
+    {
+      MxFocusIndexEntry *entry =
+        &g_array_index (index->entries, MxFocusIndexEntry,
+                        g_array_index (index->cell_entries, guint, i));
+      gfloat score;
+
+      if (entry->visited == index->serial)
+        continue;
+      entry->visited = index->serial;
+
+      if (entry->actor == from || entry->refused == move)
+        continue;
+
+      if (mx_focus_index_score (from_box, &entry->box, direction, &score) &&
+          score < *best_score)
+        {
+          *best = entry;
+          *best_score = score;
+        }
+    }
+}
+
+/* Looks at the cells in rings around those of @from_box until no child
+ * further out could score better than the best found */
+static MxFocusIndexEntry *
+mx_focus_index_search (MxFocusIndex          *index,
+                       ClutterActor          *from,
+                       const ClutterActorBox *from_box,
+                       MxFocusDirection       direction,
+                       guint                  move)
+{
+  MxFocusIndexEntry *best = NULL;
+  gfloat best_score = G_MAXFLOAT;
+  gint col1, row1, col2, row2, ring, row, col;
+
+  index->serial++;
+
+  mx_focus_index_get_cells (index, from_box, &col1, &row1, &col2, &row2);
+
+  for (ring = 0; ; ring++)
+    {
+      gint first_col = col1 - ring, last_col = col2 + ring;
+      gint first_row = row1 - ring, last_row = row2 + ring;
+
+      /* anything not found yet is at least ring - 1 cells away */
+      if (best && best_score <= (ring - 1) * MIN (index->cell_width,
+                                                  index->cell_height))
+        break;
+
+      if (first_col < 0 && first_row < 0 &&
+          last_col >= index->n_cols && last_row >= index->n_rows)
+        break;
+
+      /* only look at the cells on the side of the move */
+      if (direction == MX_FOCUS_DIRECTION_LEFT)
+        last_col = col2;
+      else if (direction == MX_FOCUS_DIRECTION_RIGHT)
+        first_col = col1;
+      else if (direction == MX_FOCUS_DIRECTION_UP)
+        last_row = row2;
+      else
+        first_row = row1;
+
+      for (row = MAX (first_row, 0);
+           row <= MIN (last_row, index->n_rows - 1);
+           row++)
+        {
+          gboolean edge_row = (ring == 0 ||
+                               row == row1 - ring || row == row2 + ring);
+
+          for (col = MAX (first_col, 0);
+               col <= MIN (last_col, index->n_cols - 1);
+               col++)
+            {
+              /* inner rows of the ring only have their end cells */
+              if (!edge_row && col != col1 - ring && col != col2 + ring)
+                continue;
+
+              mx_focus_index_search_cell (index, col, row, from, from_box,
+                                          direction, move, &best, &best_score);
+            }
+        }
+    }
+
+  return best;
+}
+
+/* Moves the focus from @from, a child of the container, to the nearest
+ * child in @direction that accepts it. Only the directions on the screen
+ * are dealt with; the child the focus moved to is put in @child. */
+MxFocusable *
+_mx_focus_index_move_focus (MxFocusIndex      *index,
+                            ClutterActor      *from,
+                            MxFocusDirection   direction,
+                            ClutterActor     **child)
+{
+  static guint moves = 0;
+  MxFocusIndexEntry *entry;
+  ClutterActorBox from_box;
+  MxFocusHint hint;
+  guint move;
+
+  if (direction != MX_FOCUS_DIRECTION_UP &&
+      direction != MX_FOCUS_DIRECTION_DOWN &&
+      direction != MX_FOCUS_DIRECTION_LEFT &&
+      direction != MX_FOCUS_DIRECTION_RIGHT)
+    return NULL;
+
+  if (!index->valid)
+    mx_focus_index_build (index);
+
+  if (!index->entries->len)
+    return NULL;
+
+  clutter_actor_get_allocation_box (from, &from_box);
+  hint = mx_focus_hint_from_direction (direction);
+  move = ++moves;
+
+  while ((entry = mx_focus_index_search (index, from, &from_box,
+                                         direction, move)))
+    {
+      MxFocusable *focused =
+        mx_focusable_accept_focus (MX_FOCUSABLE (entry->actor), hint);
+
+      if (focused)
+        {
+          if (child)
+            *child = entry->actor;
+
+          return focused;
+        }
+
+      entry->refused = move;
+    }
+
+  return NULL;
+}
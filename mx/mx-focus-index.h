@@ -0,0 +1,56 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-focus-index.h: Spatial index of the focusable children of a container
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _MX_FOCUS_INDEX_H
+#define _MX_FOCUS_INDEX_H
+
+#include <clutter/clutter.h>
+#include "mx-focusable.h"
+
+G_BEGIN_DECLS
+
+/*
+ * An MxFocusIndex buckets the allocations of the visible, focusable
+ * children of a container in a uniform grid of cells about the size of an
+ * average child, so that finding the nearest child in a direction only
+ * looks at the cells around the one the focus is moving from.
+ *
+ * The index is built the first time it is queried and dropped by
+ * _mx_focus_index_invalidate(), which the container calls when it is
+ * allocated or its children change.
+ */
+
+typedef struct _MxFocusIndex MxFocusIndex;
+
+MxFocusIndex *_mx_focus_index_new        (ClutterActor      *container);
+void          _mx_focus_index_free       (MxFocusIndex      *index);
+
+void          _mx_focus_index_invalidate (MxFocusIndex      *index);
+
+MxFocusable  *_mx_focus_index_move_focus (MxFocusIndex      *index,
+                                          ClutterActor      *from,
+                                          MxFocusDirection   direction,
+                                          ClutterActor     **child);
+
+G_END_DECLS
+
+#endif /* _MX_FOCUS_INDEX_H */
@@ -262,30 +262,26 @@ static void
 mx_focus_manager_start_focus (MxFocusManager *manager, MxFocusHint hint)
 {
   MxFocusManagerPrivate *priv = manager->priv;
-  MxFocusable *focusable, *new_focused;
-
-  GList *children, *l;
-
-  children = clutter_actor_get_children (priv->stage);
-  focusable = NULL;
-
-  if (hint == MX_FOCUS_HINT_LAST)
-    children = g_list_reverse (children);
-
-  for (l = children; l; l = g_list_next (l))
+  MxFocusable *new_focused;
+  ClutterActor *child;
+
+  for (child = (hint == MX_FOCUS_HINT_LAST) ?
+         clutter_actor_get_last_child (priv->stage) :
+         clutter_actor_get_first_child (priv->stage);
+       child;
+       child = (hint == MX_FOCUS_HINT_LAST) ?
+         clutter_actor_get_previous_sibling (child) :
+         clutter_actor_get_next_sibling (child))
     {
-      if (MX_IS_FOCUSABLE (l->data))
+      if (MX_IS_FOCUSABLE (child))
         {
-          focusable = MX_FOCUSABLE (l->data);
-          new_focused = mx_focusable_accept_focus (focusable, hint);
+          new_focused = mx_focusable_accept_focus (MX_FOCUSABLE (child), hint);
           mx_focus_manager_set_focused (manager, new_focused);
 
           if (new_focused)
             break;
         }
     }
-
-  g_list_free (children);
 }
 
 static gboolean
@@ -110,47 +110,41 @@ mx_focusable_move_focus (MxFocusable      *focusable,
       ((direction == MX_FOCUS_DIRECTION_NEXT) ||
        (direction == MX_FOCUS_DIRECTION_PREVIOUS)))
     {
-      GList *children, *l;
-      GList *child_link;
+      ClutterActor *child;
 
-      children = clutter_actor_get_children (parent);
-
-      /* find the current focused widget */
-      child_link = g_list_find (children, actor);
-
-      if (child_link)
+      /* @actor is the child of the stage the focus is in */
+      if (direction == MX_FOCUS_DIRECTION_NEXT)
         {
-          if (direction == MX_FOCUS_DIRECTION_NEXT)
+          /* find the next widget to focus */
+          for (child = clutter_actor_get_next_sibling (actor);
+               child;
+               child = clutter_actor_get_next_sibling (child))
             {
-              /* find the next widget to focus */
-              for (l = child_link->next; l; l = g_list_next (l))
+              if (MX_IS_FOCUSABLE (child))
                 {
-                  if (MX_IS_FOCUSABLE (l->data))
-                    {
-                      moved = mx_focusable_accept_focus (l->data,
-                                                         MX_FOCUS_HINT_FIRST);
-                      if (moved)
-                        break;
-                    }
+                  moved = mx_focusable_accept_focus (MX_FOCUSABLE (child),
+                                                     MX_FOCUS_HINT_FIRST);
+                  if (moved)
+                    break;
                 }
             }
-          else if (direction == MX_FOCUS_DIRECTION_PREVIOUS)
+        }
+      else
+        {
+          /* find the previous widget to focus */
+          for (child = clutter_actor_get_previous_sibling (actor);
+               child;
+               child = clutter_actor_get_previous_sibling (child))
             {
-              /* find the previous widget to focus */
-              for (l = child_link->prev; l; l = g_list_previous (l))
+              if (MX_IS_FOCUSABLE (child))
                 {
-                  if (MX_IS_FOCUSABLE (l->data))
-                    {
-                      moved = mx_focusable_accept_focus (l->data,
-                                                         MX_FOCUS_HINT_LAST);
-                      if (moved)
-                        break;
-                    }
+                  moved = mx_focusable_accept_focus (MX_FOCUSABLE (child),
+                                                     MX_FOCUS_HINT_LAST);
+                  if (moved)
+                    break;
                 }
             }
         }
-
-      g_list_free (children);
     }
 
 found:
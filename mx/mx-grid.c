@@ -103,9 +103,57 @@
 #include "mx-focusable.h"
 #include "mx-enum-types.h"
 #include "mx-private.h"
+#include "mx-tile-cache.h"
+#include "mx-focus-index.h"
+#include "mx-box-array.h"
 
 typedef struct _MxGridActorData MxGridActorData;
 
+/* A line of children, a row or a column depending on the orientation, as
+ * laid out by the last allocation. start and end are where the children of
+ * the line and the lines before it (for end), or after it (for start),
+ * begin and end across the lines, so both only ever increase. */
+typedef struct
+{
+  ClutterActor *first_child;
+  guint         first_box;
+  gfloat        line_start;
+  gfloat        start;
+  gfloat        end;
+} MxGridLine;
+
+/* Where a line starts in a layout, and the extents of the lines before it,
+ * to go on laying out from that line */
+typedef struct
+{
+  ClutterActor *first_child;
+  gint          position;
+  gfloat        current_b;
+  gfloat        next_b;
+  gfloat        extent_width, extent_height;
+  gfloat        extent_min_width, extent_min_height;
+} MxGridLineState;
+
+/* The lines of a layout for a given size and settings; there is one for
+ * the preferred width and one for the height or the allocation */
+typedef struct
+{
+  gfloat         a_wrap;
+  MxPadding      padding;
+  gfloat         agap, bgap;
+  gdouble        balign;
+  MxOrientation  orientation;
+  gint           max_stride;
+
+  /* the lines from dirty_line on need laying out, and the children from
+   * alloc_dirty_line on need allocating */
+  GArray        *lines;
+  guint          dirty_line;
+  guint          alloc_dirty_line;
+  guint          serial;
+  guint          age;
+} MxGridLayoutCache;
+
 static void mx_grid_finalize            (GObject *object);
 
 static void mx_grid_set_property        (GObject      *object,
@@ -123,9 +171,6 @@ static void mx_grid_actor_added          (ClutterContainer *container,
 static void mx_grid_actor_removed        (ClutterContainer *container,
                                           ClutterActor     *actor);
 
-static void
-mx_grid_free_actor_data (gpointer data);
-
 static void mx_grid_paint (ClutterActor *actor);
 
 static void mx_grid_pick (ClutterActor       *actor,
@@ -147,6 +192,8 @@ static void mx_grid_allocate (ClutterActor          *self,
                               const ClutterActorBox *box,
                               ClutterAllocationFlags flags);
 
+static void mx_grid_queue_relayout (ClutterActor *self);
+
 static void
 mx_grid_do_allocate (ClutterActor          *self,
                      const ClutterActorBox *box,
@@ -178,7 +225,9 @@ G_DEFINE_TYPE_WITH_CODE (MxGrid, mx_grid,
 
 struct _MxGridPrivate
 {
-  GHashTable   *hash_table;
+  /* the layout data of the children, in their order as of the last
+   * layout, see mx_grid_get_child_data() */
+  GArray       *child_data;
 
   gboolean      homogenous_rows;
   gboolean      homogenous_columns;
@@ -196,11 +245,37 @@ struct _MxGridPrivate
 
   gint          max_stride;
 
+  /* when set, the background colors and border images of the children
+   * are painted together; the batch is only kept while painting */
+  gboolean      batch_backgrounds;
+
+  /* whether the texts of the labels are measured on worker threads, and
+   * whether they were since the last relayout */
+  guint         prefetch_text_sizes : 1;
+  guint         text_prefetched : 1;
+  MxBackgroundBatch *background_batch;
+
   MxAdjustment *hadjustment;
   MxAdjustment *vadjustment;
 
   MxFocusable  *last_focus;
 
+  /* positions of the focusable children, for moving the focus up, down,
+   * left and right; rebuilt after they are allocated again */
+  MxFocusIndex *focus_index;
+
+  /* lines of the last allocation, used to only paint and pick the
+   * children that can be seen; dropped when the children change */
+  GArray       *lines;
+  guint         lines_serial;
+
+  /* the allocations of the children of the lines, in the same order */
+  MxBoxArray   *boxes;
+
+  MxGridLayoutCache layout_caches[2];
+  guint         layout_serial;
+  guint         layout_age;
+
   guint ignore_css_col_spacing : 1;
   guint ignore_css_row_spacing : 1;
 };
@@ -219,13 +294,21 @@ enum
   PROP_HADJUST,
   PROP_VADJUST,
   PROP_MAX_STRIDE,
+  PROP_BATCH_BACKGROUNDS,
+  PROP_PREFETCH_TEXT_SIZES,
 };
 
 struct _MxGridActorData
 {
-  gboolean xpos_set,   ypos_set;
-  gfloat   xpos,       ypos;
-  gfloat   pref_width, pref_height;
+  /* the child laid out at the position of the data */
+  ClutterActor   *actor;
+
+  /* as laid out last, to tell whether it changed since */
+  gboolean        visible;
+  gfloat          min_width, min_height;
+  gfloat          natural_width, natural_height;
+  ClutterActorBox box;
+  guint           box_serial;
 };
 
 static void
@@ -475,6 +558,7 @@ mx_grid_class_init (MxGridClass *klass)
   actor_class->get_preferred_width  = mx_grid_get_preferred_width;
   actor_class->get_preferred_height = mx_grid_get_preferred_height;
   actor_class->allocate             = mx_grid_allocate;
+  actor_class->queue_relayout       = mx_grid_queue_relayout;
   actor_class->apply_transform      = mx_grid_apply_transform;
   actor_class->get_paint_volume     = mx_grid_get_paint_volume;
 
@@ -558,6 +642,47 @@ mx_grid_class_init (MxGridClass *klass)
                             G_PARAM_READWRITE|G_PARAM_CONSTRUCT);
   g_object_class_install_property (gobject_class, PROP_MAX_STRIDE, pspec);
 
+  /**
+   * MxGrid:batch-backgrounds:
+   *
+   * Whether to paint the background colors and border images of the
+   * children together, before any of the children, with one call for each
+   * color or texture. This is much cheaper for grids of many similar
+   * widgets, but is only correct when the children do not overlap and
+   * paint their background by chaining up to #MxWidget. Children that are
+   * scaled, rotated, clipped or have effects paint their own backgrounds.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("batch-backgrounds",
+                                "Batch backgrounds",
+                                "Whether to paint the backgrounds of the"
+                                " children together",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_BATCH_BACKGROUNDS,
+                                   pspec);
+
+  /**
+   * MxGrid:prefetch-text-sizes:
+   *
+   * Whether to measure the texts of the #MxLabel<!-- -->s inside the grid
+   * on worker threads before it is laid out, rather than one after the
+   * other while it is. This is worth it for grids of many items that each
+   * hold labels, on machines with several processors. See
+   * #MxBoxLayout:prefetch-text-sizes.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("prefetch-text-sizes",
+                                "Prefetch text sizes",
+                                "Whether to measure the texts of the labels"
+                                " on worker threads",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_TEXT_SIZES,
+                                   pspec);
+
   g_object_class_override_property (gobject_class,
                                     PROP_HADJUST,
                                     "horizontal-adjustment");
@@ -626,119 +751,100 @@ mx_grid_move_focus (MxFocusable      *focusable,
                     MxFocusable      *from)
 {
   MxGridPrivate *priv = MX_GRID (focusable)->priv;
-  GList *l, *childlink, *children;
-
-  /* find the current focus */
-  children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
-  childlink = g_list_find (children, from);
+  ClutterActor *child = NULL;
+  MxFocusable *focused = NULL;
 
-  if (!childlink)
-    {
-      g_list_free (children);
-      return NULL;
-    }
+  /* only direct children are dealt with */
+  if (clutter_actor_get_parent (CLUTTER_ACTOR (from)) !=
+      CLUTTER_ACTOR (focusable))
+    return NULL;
 
   priv->last_focus = from;
 
   /* find the next widget to focus */
   if (direction == MX_FOCUS_DIRECTION_NEXT)
     {
-      for (l = childlink->next; l; l = g_list_next (l))
+      for (child = clutter_actor_get_next_sibling (CLUTTER_ACTOR (from));
+           child;
+           child = clutter_actor_get_next_sibling (child))
         {
-          MxFocusable *child = (MxFocusable *) l->data;
-
-          if (MX_IS_FOCUSABLE (child))
-            {
-              MxFocusable *focused =
-                mx_focusable_accept_focus (child, MX_FOCUS_HINT_FIRST);
-
-              if (focused)
-                {
-                  update_adjustments (MX_GRID (focusable), child);
-                  g_list_free (children);
-                  return focused;
-                }
-            }
+          if (MX_IS_FOCUSABLE (child) &&
+              (focused = mx_focusable_accept_focus (MX_FOCUSABLE (child),
+                                                    MX_FOCUS_HINT_FIRST)))
+            break;
         }
     }
   else if (direction == MX_FOCUS_DIRECTION_PREVIOUS)
     {
-      for (l = g_list_previous (childlink); l; l = g_list_previous (l))
+      for (child = clutter_actor_get_previous_sibling (CLUTTER_ACTOR (from));
+           child;
+           child = clutter_actor_get_previous_sibling (child))
         {
-          MxFocusable *child = (MxFocusable *) l->data;
-
-          if (MX_IS_FOCUSABLE (child))
-            {
-              MxFocusable *focused =
-                mx_focusable_accept_focus (child, MX_FOCUS_HINT_LAST);
-
-              if (focused)
-                {
-                  update_adjustments (MX_GRID (focusable), child);
-                  g_list_free (children);
-                  return focused;
-                }
-            }
+          if (MX_IS_FOCUSABLE (child) &&
+              (focused = mx_focusable_accept_focus (MX_FOCUSABLE (child),
+                                                    MX_FOCUS_HINT_LAST)))
+            break;
         }
     }
+  else
+    focused = _mx_focus_index_move_focus (priv->focus_index,
+                                          CLUTTER_ACTOR (from),
+                                          direction, &child);
 
+  if (focused)
+    update_adjustments (MX_GRID (focusable), MX_FOCUSABLE (child));
 
-  g_list_free (children);
-  return NULL;
+  return focused;
 }
 
 static MxFocusable*
 mx_grid_accept_focus (MxFocusable *focusable, MxFocusHint hint)
 {
   MxGridPrivate *priv = MX_GRID (focusable)->priv;
+  ClutterActor *self = CLUTTER_ACTOR (focusable);
   MxFocusable *return_focusable;
-  GList* list, *l, *children;
+  ClutterActor *child;
 
   return_focusable = NULL;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
-
   /* find the first/last focusable widget */
   switch (hint)
     {
     case MX_FOCUS_HINT_LAST:
-      list = g_list_reverse (g_list_copy (children));
+      child = clutter_actor_get_last_child (self);
       break;
 
     case MX_FOCUS_HINT_PRIOR:
       if (priv->last_focus)
         {
-          list = g_list_copy (g_list_find (children, priv->last_focus));
-          if (list)
-            break;
+          child = CLUTTER_ACTOR (priv->last_focus);
+          break;
         }
       /* This intentionally runs into the next case */
 
     default:
     case MX_FOCUS_HINT_FIRST:
-      list = g_list_copy (children);
+      child = clutter_actor_get_first_child (self);
       break;
     }
 
-  for (l = list; l; l = g_list_next (l))
+  for (; child; child = (hint == MX_FOCUS_HINT_LAST) ?
+         clutter_actor_get_previous_sibling (child) :
+         clutter_actor_get_next_sibling (child))
     {
-      MxFocusable *child = (MxFocusable *) l->data;
-
       if (MX_IS_FOCUSABLE (child))
         {
-          return_focusable = mx_focusable_accept_focus (child, hint);
+          return_focusable = mx_focusable_accept_focus (MX_FOCUSABLE (child),
+                                                        hint);
 
           if (return_focusable)
             {
-              update_adjustments (MX_GRID (focusable), child);
+              update_adjustments (MX_GRID (focusable), MX_FOCUSABLE (child));
               break;
             }
         }
     }
 
-  g_list_free (list);
-  g_list_free (children);
-
   return return_focusable;
 }
 
@@ -754,17 +860,19 @@ static void
 mx_grid_init (MxGrid *self)
 {
   MxGridPrivate *priv;
+  guint i;
 
   self->priv = priv = MX_GRID_GET_PRIVATE (self);
 
-  /* do not unref in the hashtable, the reference is for now kept by the list
-   * (double bookkeeping sucks)
-   */
-  priv->hash_table
-    = g_hash_table_new_full (g_direct_hash,
-                             g_direct_equal,
-                             NULL,
-                             mx_grid_free_actor_data);
+  priv->child_data = g_array_new (FALSE, TRUE, sizeof (MxGridActorData));
+
+  priv->lines = g_array_new (FALSE, FALSE, sizeof (MxGridLine));
+  priv->boxes = _mx_box_array_new ();
+  for (i = 0; i < G_N_ELEMENTS (priv->layout_caches); i++)
+    priv->layout_caches[i].lines =
+      g_array_new (FALSE, FALSE, sizeof (MxGridLineState));
+
+  priv->focus_index = _mx_focus_index_new (CLUTTER_ACTOR (self));
 
   g_signal_connect (self, "style-changed",
                     G_CALLBACK (mx_grid_style_changed), NULL);
@@ -775,8 +883,15 @@ mx_grid_finalize (GObject *object)
 {
   MxGrid *self = (MxGrid *) object;
   MxGridPrivate *priv = self->priv;
+  guint i;
 
-  g_hash_table_destroy (priv->hash_table);
+  g_array_free (priv->child_data, TRUE);
+  g_array_free (priv->lines, TRUE);
+  _mx_box_array_free (priv->boxes);
+  _mx_background_batch_free (priv->background_batch);
+  for (i = 0; i < G_N_ELEMENTS (priv->layout_caches); i++)
+    g_array_free (priv->layout_caches[i].lines, TRUE);
+  _mx_focus_index_free (priv->focus_index);
 
   G_OBJECT_CLASS (mx_grid_parent_class)->finalize (object);
 }
@@ -1014,6 +1129,96 @@ mx_grid_get_max_stride (MxGrid *self)
   return self->priv->max_stride;
 }
 
+/**
+ * mx_grid_set_batch_backgrounds:
+ * @self: An #MxGrid
+ * @value: %TRUE to paint the backgrounds of the children together
+ *
+ * Sets the value of the #MxGrid:batch-backgrounds property.
+ *
+ * Since: 2.0
+ */
+void
+mx_grid_set_batch_backgrounds (MxGrid   *self,
+                               gboolean  value)
+{
+  MxGridPrivate *priv;
+
+  g_return_if_fail (MX_IS_GRID (self));
+
+  priv = self->priv;
+
+  if (priv->batch_backgrounds != value)
+    {
+      priv->batch_backgrounds = value;
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
+      g_object_notify (G_OBJECT (self), "batch-backgrounds");
+    }
+}
+
+/**
+ * mx_grid_get_batch_backgrounds:
+ * @self: An #MxGrid
+ *
+ * Gets the value of the #MxGrid:batch-backgrounds property.
+ *
+ * Returns: %TRUE if the backgrounds of the children are painted together
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_grid_get_batch_backgrounds (MxGrid *self)
+{
+  g_return_val_if_fail (MX_IS_GRID (self), FALSE);
+
+  return self->priv->batch_backgrounds;
+}
+
+/**
+ * mx_grid_set_prefetch_text_sizes:
+ * @self: An #MxGrid
+ * @value: %TRUE to measure the texts of labels on worker threads
+ *
+ * Sets the value of the #MxGrid:prefetch-text-sizes property.
+ *
+ * Since: 2.0
+ */
+void
+mx_grid_set_prefetch_text_sizes (MxGrid   *self,
+                                 gboolean  value)
+{
+  MxGridPrivate *priv;
+
+  g_return_if_fail (MX_IS_GRID (self));
+
+  priv = self->priv;
+
+  if (priv->prefetch_text_sizes != value)
+    {
+      priv->prefetch_text_sizes = value;
+      priv->text_prefetched = FALSE;
+      g_object_notify (G_OBJECT (self), "prefetch-text-sizes");
+    }
+}
+
+/**
+ * mx_grid_get_prefetch_text_sizes:
+ * @self: An #MxGrid
+ *
+ * Gets the value of the #MxGrid:prefetch-text-sizes property.
+ *
+ * Returns: %TRUE if the texts of labels are measured on worker threads
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_grid_get_prefetch_text_sizes (MxGrid *self)
+{
+  g_return_val_if_fail (MX_IS_GRID (self), FALSE);
+
+  return self->priv->prefetch_text_sizes;
+}
+
 static void
 mx_grid_set_property (GObject      *object,
                       guint         prop_id,
@@ -1065,6 +1270,13 @@ mx_grid_set_property (GObject      *object,
     case PROP_MAX_STRIDE:
       mx_grid_set_max_stride (grid, g_value_get_int (value));
       break;
+    case PROP_BATCH_BACKGROUNDS:
+      mx_grid_set_batch_backgrounds (grid, g_value_get_boolean (value));
+      break;
+
+    case PROP_PREFETCH_TEXT_SIZES:
+      mx_grid_set_prefetch_text_sizes (grid, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1117,6 +1329,13 @@ mx_grid_get_property (GObject    *object,
     case PROP_MAX_STRIDE:
       g_value_set_int (value, mx_grid_get_max_stride (grid));
       break;
+    case PROP_BATCH_BACKGROUNDS:
+      g_value_set_boolean (value, mx_grid_get_batch_backgrounds (grid));
+      break;
+
+    case PROP_PREFETCH_TEXT_SIZES:
+      g_value_set_boolean (value, mx_grid_get_prefetch_text_sizes (grid));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1124,12 +1343,6 @@ mx_grid_get_property (GObject    *object,
 }
 
 
-static void
-mx_grid_free_actor_data (gpointer data)
-{
-  g_slice_free (MxGridActorData, data);
-}
-
 ClutterActor *
 mx_grid_new (void)
 {
@@ -1138,20 +1351,140 @@ mx_grid_new (void)
   return (ClutterActor*) self;
 }
 
+static void
+mx_grid_queue_relayout (ClutterActor *self)
+{
+  MX_GRID (self)->priv->text_prefetched = FALSE;
+
+  CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->queue_relayout (self);
+}
+
+/* drops the lines of the last allocation from @n_lines on, with the boxes
+ * of their children */
+static void
+mx_grid_set_n_lines (MxGrid *grid,
+                     guint   n_lines)
+{
+  MxGridPrivate *priv = grid->priv;
+
+  if (n_lines < priv->lines->len)
+    {
+      _mx_box_array_set_length (priv->boxes,
+                                g_array_index (priv->lines, MxGridLine,
+                                               n_lines).first_box);
+      g_array_set_size (priv->lines, n_lines);
+    }
+}
+
+static void
+mx_grid_invalidate_layout (MxGrid *grid)
+{
+  MxGridPrivate *priv = grid->priv;
+  guint i;
+
+  mx_grid_set_n_lines (grid, 0);
+  for (i = 0; i < G_N_ELEMENTS (priv->layout_caches); i++)
+    g_array_set_size (priv->layout_caches[i].lines, 0);
+}
+
+/* Returns the index of the data of @actor, or -1 */
+static gint
+mx_grid_find_child_data (MxGrid       *grid,
+                         ClutterActor *actor)
+{
+  GArray *child_data = grid->priv->child_data;
+  guint i;
+
+  for (i = 0; i < child_data->len; i++)
+    if (g_array_index (child_data, MxGridActorData, i).actor == actor)
+      return i;
+
+  return -1;
+}
+
+/* The data of the children is kept in an array in their order, so that the
+ * layout goes through it as it goes through the children, rather than
+ * looking each one up. The array is kept in step as children are added and
+ * removed; when they are reordered, the data at a position is for another
+ * child, and is taken over by the child now there. Returns %NULL if
+ * @create is %FALSE and there is no data for @child at @position. */
+static MxGridActorData *
+mx_grid_get_child_data (MxGrid       *grid,
+                        ClutterActor *child,
+                        gint          position,
+                        gboolean      create)
+{
+  GArray *child_data = grid->priv->child_data;
+  MxGridActorData *data;
+
+  if ((guint) position >= child_data->len)
+    {
+      if (!create)
+        return NULL;
+      g_array_set_size (child_data, position + 1);
+    }
+
+  data = &g_array_index (child_data, MxGridActorData, position);
+  if (data->actor != child)
+    {
+      if (!create)
+        return NULL;
+
+      memset (data, 0, sizeof (MxGridActorData));
+      data->actor = child;
+    }
+
+  return data;
+}
+
 static void
 mx_grid_actor_added (ClutterContainer *container,
                      ClutterActor     *actor)
 {
   MxGridPrivate *priv;
-  MxGridActorData *data;
+  MxGridActorData data = { 0, };
+  ClutterActor *prev;
+  gint index;
+  guint i;
 
   g_return_if_fail (MX_IS_GRID (container));
 
   priv = MX_GRID (container)->priv;
 
-  data = g_slice_alloc0 (sizeof (MxGridActorData));
+  data.actor = actor;
+
+  /* the data goes after the data of the previous child, when it has some */
+  prev = clutter_actor_get_previous_sibling (actor);
+  if (!prev)
+    g_array_prepend_val (priv->child_data, data);
+  else if (prev == (priv->child_data->len ?
+                    g_array_index (priv->child_data, MxGridActorData,
+                                   priv->child_data->len - 1).actor : NULL))
+    g_array_append_val (priv->child_data, data);
+  else if ((index = mx_grid_find_child_data (MX_GRID (container), prev)) >= 0)
+    g_array_insert_val (priv->child_data, index + 1, data);
 
-  g_hash_table_insert (priv->hash_table, actor, data);
+  _mx_focus_index_invalidate (priv->focus_index);
+
+  /* appended children are laid out from the last line, anything else
+   * from the start */
+  if (clutter_actor_get_last_child (CLUTTER_ACTOR (container)) == actor)
+    {
+      for (i = 0; i < G_N_ELEMENTS (priv->layout_caches); i++)
+        {
+          MxGridLayoutCache *cache = &priv->layout_caches[i];
+
+          if (cache->lines->len)
+            {
+              cache->dirty_line = MIN (cache->dirty_line,
+                                       cache->lines->len - 1);
+              cache->alloc_dirty_line = MIN (cache->alloc_dirty_line,
+                                             cache->dirty_line);
+            }
+        }
+    }
+  else
+    mx_grid_invalidate_layout (MX_GRID (container));
 }
 
 static void
@@ -1160,8 +1493,153 @@ mx_grid_actor_removed (ClutterContainer *container,
 {
   MxGrid *layout = MX_GRID (container);
   MxGridPrivate *priv = layout->priv;
+  gint index;
+
+  index = mx_grid_find_child_data (layout, actor);
+  if (index >= 0)
+    g_array_remove_index (priv->child_data, index);
+  _mx_focus_index_invalidate (priv->focus_index);
+
+  if ((ClutterActor *) priv->last_focus == actor)
+    priv->last_focus = NULL;
+
+  mx_grid_invalidate_layout (layout);
+}
+
+/* Lines are across the orientation: rows, going down, for horizontal
+ * grids, and columns, going right, for vertical ones */
+static void
+mx_grid_get_line_range (MxGrid                *grid,
+                        const ClutterActorBox *box,
+                        gfloat                *start,
+                        gfloat                *end)
+{
+  if (grid->priv->orientation == MX_ORIENTATION_VERTICAL)
+    {
+      *start = box->x1;
+      *end = box->x2;
+    }
+  else
+    {
+      *start = box->y1;
+      *end = box->y2;
+    }
+}
+
+/* Gets the range of the boxes of the lines that reach into @visible_box.
+ * The lines are sorted by where they start and end, but the children in
+ * them need not be, so each box in the range is tested. */
+static void
+mx_grid_get_visible_boxes (MxGrid                *grid,
+                           const ClutterActorBox *visible_box,
+                           guint                 *first,
+                           guint                 *last)
+{
+  MxGridPrivate *priv = grid->priv;
+  GArray *lines = priv->lines;
+  gfloat start, end;
+  guint low, high;
+
+  mx_grid_get_line_range (grid, visible_box, &start, &end);
+
+  /* the first line that ends after the start */
+  low = 0;
+  high = lines->len;
+  while (low < high)
+    {
+      guint middle = (low + high) / 2;
+
+      if (g_array_index (lines, MxGridLine, middle).end <= start)
+        low = middle + 1;
+      else
+        high = middle;
+    }
 
-  g_hash_table_remove (priv->hash_table, actor);
+  if (low == lines->len)
+    {
+      *first = *last = 0;
+      return;
+    }
+
+  *first = g_array_index (lines, MxGridLine, low).first_box;
+
+  /* and the first one after it that starts after the end */
+  high = lines->len;
+  while (low < high)
+    {
+      guint middle = (low + high) / 2;
+
+      if (g_array_index (lines, MxGridLine, middle).start < end)
+        low = middle + 1;
+      else
+        high = middle;
+    }
+
+  if (low == lines->len)
+    *last = _mx_box_array_get_length (priv->boxes);
+  else
+    *last = g_array_index (lines, MxGridLine, low).first_box;
+}
+
+/* Paints the children that reach into @grid_b or, when @batch is given,
+ * adds their backgrounds to it instead */
+static void
+mx_grid_paint_visible (MxGrid                *layout,
+                       const ClutterActorBox *grid_b,
+                       MxBackgroundBatch     *batch)
+{
+  MxGridPrivate *priv = layout->priv;
+  const guint *visible;
+  guint i, first, last, n_visible;
+
+  /* before the first allocation, look at every child */
+  if (!priv->lines->len)
+    {
+      ClutterActor *child;
+
+      for (child = clutter_actor_get_first_child (CLUTTER_ACTOR (layout));
+           child;
+           child = clutter_actor_get_next_sibling (child))
+        {
+          ClutterActorBox child_b;
+
+          /* ensure the child is "on screen" */
+          clutter_actor_get_allocation_box (child, &child_b);
+
+          if ((child_b.x1 < grid_b->x2)
+              && (child_b.x2 > grid_b->x1)
+              && (child_b.y1 < grid_b->y2)
+              && (child_b.y2 > grid_b->y1)
+              && CLUTTER_ACTOR_IS_VISIBLE (child))
+            {
+              if (batch)
+                _mx_background_batch_add (batch, CLUTTER_ACTOR (layout),
+                                          child);
+              else
+                clutter_actor_paint (child);
+            }
+        }
+
+      return;
+    }
+
+  mx_grid_get_visible_boxes (layout, grid_b, &first, &last);
+  n_visible = _mx_box_array_cull (priv->boxes, first, last, grid_b,
+                                  &visible);
+
+  for (i = 0; i < n_visible; i++)
+    {
+      ClutterActor *child = _mx_box_array_get_actor (priv->boxes,
+                                                     visible[i]);
+
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      if (batch)
+        _mx_background_batch_add (batch, CLUTTER_ACTOR (layout), child);
+      else
+        clutter_actor_paint (child);
+    }
 }
 
 static void
@@ -1171,8 +1649,6 @@ mx_grid_paint (ClutterActor *actor)
   MxGridPrivate *priv = layout->priv;
   gfloat x, y;
   ClutterActorBox grid_b;
-  ClutterActorIter iter;
-  ClutterActor *child;
 
   if (priv->hadjustment)
     x = mx_adjustment_get_value (priv->hadjustment);
@@ -1186,31 +1662,30 @@ mx_grid_paint (ClutterActor *actor)
 
   CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->paint (actor);
 
-  clutter_actor_get_allocation_box (actor, &grid_b);
-  grid_b.x2 = (grid_b.x2 - grid_b.x1) + x;
-  grid_b.x1 = x;
-  grid_b.y2 = (grid_b.y2 - grid_b.y1) + y;
-  grid_b.y1 = y;
+  /* paint the children in the tile being rendered instead of the visible
+   * ones, when rendering a tile of the content */
+  if (!_mx_tile_cache_get_render_area (actor, &grid_b))
+    {
+      clutter_actor_get_allocation_box (actor, &grid_b);
+      grid_b.x2 = (grid_b.x2 - grid_b.x1) + x;
+      grid_b.x1 = x;
+      grid_b.y2 = (grid_b.y2 - grid_b.y1) + y;
+      grid_b.y1 = y;
+    }
 
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
+  if (priv->batch_backgrounds)
     {
-      ClutterActorBox child_b;
+      if (!priv->background_batch)
+        priv->background_batch = _mx_background_batch_new ();
 
-      g_assert (child != NULL);
+      mx_grid_paint_visible (layout, &grid_b, priv->background_batch);
+      _mx_background_batch_paint (priv->background_batch);
+    }
 
-      /* ensure the child is "on screen" */
-      clutter_actor_get_allocation_box (CLUTTER_ACTOR (child), &child_b);
+  mx_grid_paint_visible (layout, &grid_b, NULL);
 
-      if ((child_b.x1 < grid_b.x2)
-          && (child_b.x2 > grid_b.x1)
-          && (child_b.y1 < grid_b.y2)
-          && (child_b.y2 > grid_b.y1)
-          && CLUTTER_ACTOR_IS_VISIBLE (child))
-        {
-          clutter_actor_paint (child);
-        }
-    }
+  if (priv->background_batch)
+    _mx_background_batch_end (priv->background_batch);
 }
 
 static void
@@ -1221,8 +1696,6 @@ mx_grid_pick (ClutterActor       *actor,
   MxGridPrivate *priv = layout->priv;
   gfloat x, y;
   ClutterActorBox grid_b;
-  ClutterActorIter iter;
-  ClutterActor *child;
 
   if (priv->hadjustment)
     x = mx_adjustment_get_value (priv->hadjustment);
@@ -1244,25 +1717,7 @@ mx_grid_pick (ClutterActor       *actor,
   grid_b.y2 = (grid_b.y2 - grid_b.y1) + y;
   grid_b.y1 = y;
 
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
-    {
-      ClutterActorBox child_b;
-
-      g_assert (child != NULL);
-
-      /* ensure the child is "on screen" */
-      clutter_actor_get_allocation_box (CLUTTER_ACTOR (child), &child_b);
-
-      if ((child_b.x1 < grid_b.x2)
-          && (child_b.x2 > grid_b.x1)
-          && (child_b.y1 < grid_b.y2)
-          && (child_b.y2 > grid_b.y1)
-          && CLUTTER_ACTOR_IS_VISIBLE (child))
-        {
-          clutter_actor_paint (child);
-        }
-    }
+  mx_grid_paint_visible (layout, &grid_b, NULL);
 }
 
 static void
@@ -1430,6 +1885,330 @@ compute_row_start (ClutterActor     *container,
   return (priv->a_wrap - current_a);
 }
 
+/* Checks that the children before @line are laid out as they were, and
+ * gives them their allocation again, so that the layout can go on from
+ * @line. Returns %FALSE if everything has to be laid out. */
+static gboolean
+mx_grid_check_lines (MxGrid                 *grid,
+                     MxGridLayoutCache      *cache,
+                     guint                   line,
+                     gboolean                calculate_extents_only,
+                     ClutterAllocationFlags  flags)
+{
+  MxGridLineState *state;
+  ClutterActor *child;
+  gint position;
+
+  state = &g_array_index (cache->lines, MxGridLineState, line);
+
+  for (child = clutter_actor_get_first_child (CLUTTER_ACTOR (grid)),
+       position = 0;
+       child && child != state->first_child;
+       child = clutter_actor_get_next_sibling (child), position++)
+    {
+      MxGridActorData *data;
+      gfloat min_width, min_height, natural_width, natural_height;
+
+      /* no data at the position means the children moved */
+      data = mx_grid_get_child_data (grid, child, position, FALSE);
+      if (!data || data->visible != !!CLUTTER_ACTOR_IS_VISIBLE (child))
+        return FALSE;
+
+      if (!data->visible)
+        continue;
+
+      clutter_actor_get_preferred_size (child, &min_width, &min_height,
+                                        &natural_width, &natural_height);
+      if (min_width != data->min_width || min_height != data->min_height ||
+          natural_width != data->natural_width ||
+          natural_height != data->natural_height)
+        return FALSE;
+
+      if (!calculate_extents_only)
+        {
+          if (data->box_serial != cache->serial)
+            return FALSE;
+
+          clutter_actor_allocate (child, &data->box, flags);
+        }
+    }
+
+  return child && position == state->position;
+}
+
+/* Returns the cached layout for the given arguments, or the one that has
+ * been used the least recently, emptied for them */
+static MxGridLayoutCache *
+mx_grid_get_layout_cache (MxGrid          *grid,
+                          const MxPadding *padding,
+                          gfloat           agap,
+                          gfloat           bgap,
+                          gdouble          balign)
+{
+  MxGridPrivate *priv = grid->priv;
+  MxGridLayoutCache *cache = NULL;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (priv->layout_caches); i++)
+    {
+      MxGridLayoutCache *c = &priv->layout_caches[i];
+
+      if (c->lines->len &&
+          c->a_wrap == priv->a_wrap &&
+          !memcmp (&c->padding, padding, sizeof (MxPadding)) &&
+          c->agap == agap && c->bgap == bgap && c->balign == balign &&
+          c->orientation == priv->orientation &&
+          c->max_stride == priv->max_stride)
+        {
+          cache = c;
+          break;
+        }
+
+      if (!cache || c->age < cache->age)
+        cache = c;
+    }
+
+  if (i == G_N_ELEMENTS (priv->layout_caches))
+    {
+      g_array_set_size (cache->lines, 0);
+      cache->a_wrap = priv->a_wrap;
+      cache->padding = *padding;
+      cache->agap = agap;
+      cache->bgap = bgap;
+      cache->balign = balign;
+      cache->orientation = priv->orientation;
+      cache->max_stride = priv->max_stride;
+      cache->serial = ++priv->layout_serial;
+    }
+
+  cache->age = ++priv->layout_age;
+
+  return cache;
+}
+
+/* Adds the allocation of @child to the paint index, in a new line if
+ * @new_line is set */
+static void
+mx_grid_index_child (MxGrid                *grid,
+                     ClutterActor          *child,
+                     const ClutterActorBox *child_box,
+                     gboolean               new_line)
+{
+  MxGridPrivate *priv = grid->priv;
+  MxGridLine *line;
+  gfloat start, end;
+
+  mx_grid_get_line_range (grid, child_box, &start, &end);
+
+  if (new_line)
+    {
+      MxGridLine paint_line = { child, 0, start, start, end };
+
+      paint_line.first_box = _mx_box_array_get_length (priv->boxes);
+
+      if (priv->lines->len)
+        paint_line.end =
+          MAX (end, g_array_index (priv->lines, MxGridLine,
+                                   priv->lines->len - 1).end);
+
+      g_array_append_val (priv->lines, paint_line);
+    }
+  else
+    {
+      line = &g_array_index (priv->lines, MxGridLine, priv->lines->len - 1);
+      line->line_start = MIN (line->line_start, start);
+      line->end = MAX (line->end, end);
+    }
+
+  _mx_box_array_append (priv->boxes, child, child_box);
+}
+
+/* Children may hang out of their line, so a line is taken to start no
+ * later than the ones after it */
+static void
+mx_grid_finish_index (MxGrid *grid)
+{
+  GArray *lines = grid->priv->lines;
+  gint i;
+
+  for (i = (gint) lines->len - 1; i >= 0; i--)
+    {
+      MxGridLine *line = &g_array_index (lines, MxGridLine, i);
+
+      line->start = line->line_start;
+
+      if (i + 1 < (gint) lines->len)
+        line->start = MIN (line->start,
+                           g_array_index (lines, MxGridLine, i + 1).start);
+    }
+}
+
+/* When both rows and columns are homogenous and the stride is fixed, the
+ * children are all given the size of the largest one, and the place of
+ * each follows from its index: the children only need measuring once, and
+ * lines are a fixed distance apart. Returns %FALSE if the layout does not
+ * fit that case, when the largest child is wider than the grid. */
+static gboolean
+mx_grid_do_allocate_homogenous (MxGrid                 *grid,
+                                const MxPadding        *padding,
+                                ClutterAllocationFlags  flags,
+                                gboolean                calculate_extents_only,
+                                gfloat                  agap,
+                                gfloat                  bgap,
+                                gdouble                 aalign,
+                                gdouble                 balign,
+                                gfloat                 *actual_width,
+                                gfloat                 *actual_height,
+                                gfloat                 *min_width,
+                                gfloat                 *min_height)
+{
+  MxGridPrivate *priv = grid->priv;
+  ClutterActor *self = CLUTTER_ACTOR (grid);
+  ClutterActorIter iter;
+  ClutterActor *child;
+  GArray *sizes;
+  gfloat extent_width, extent_height, extent_min_width, extent_min_height;
+  gfloat row_start, a;
+  gint per_line, n;
+  guint i;
+
+  /* min and natural sizes of the visible children, along and across the
+   * lines */
+  sizes = g_array_sized_new (FALSE, FALSE, sizeof (gfloat) * 4,
+                             clutter_actor_get_n_children (self));
+
+  priv->max_extent_a = 0;
+  priv->max_extent_b = 0;
+
+  for (child = clutter_actor_get_first_child (self); child;
+       child = clutter_actor_get_next_sibling (child))
+    {
+      gfloat size[4];
+
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      if (priv->orientation == MX_ORIENTATION_VERTICAL)
+        clutter_actor_get_preferred_size (child, &size[1], &size[0],
+                                          &size[3], &size[2]);
+      else
+        clutter_actor_get_preferred_size (child, &size[0], &size[1],
+                                          &size[2], &size[3]);
+
+      priv->max_extent_a = MAX (priv->max_extent_a, size[2]);
+      priv->max_extent_b = MAX (priv->max_extent_b, size[3]);
+
+      g_array_append_vals (sizes, size, 1);
+    }
+
+  if (priv->max_extent_a > priv->a_wrap)
+    {
+      g_array_free (sizes, TRUE);
+      return FALSE;
+    }
+
+  /* the lines all start the same way, and hold as many children as the
+   * first one */
+  row_start = 0;
+  if (priv->line_alignment)
+    {
+      clutter_actor_iter_init (&iter, self);
+      row_start = compute_row_start (self, iter, 0, priv);
+    }
+
+  for (per_line = 1, a = row_start + priv->max_extent_a + agap;
+       per_line < priv->max_stride && a + priv->max_extent_a <= priv->a_wrap;
+       per_line++, a += priv->max_extent_a + agap);
+
+  /* the layout caches are for the general case, and would not see the
+   * changes to the children from here */
+  for (i = 0; i < G_N_ELEMENTS (priv->layout_caches); i++)
+    g_array_set_size (priv->layout_caches[i].lines, 0);
+
+  if (!calculate_extents_only)
+    {
+      mx_grid_set_n_lines (grid, 0);
+      priv->lines_serial = 0;
+    }
+
+  extent_width = extent_height = extent_min_width = extent_min_height = 0;
+
+  for (child = clutter_actor_get_first_child (self), n = 0; child;
+       child = clutter_actor_get_next_sibling (child))
+    {
+      ClutterActorBox child_box, min_child_box;
+      gfloat *size;
+
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      size = &g_array_index (sizes, gfloat, n * 4);
+
+      child_box.x1 = row_start + (n % per_line) * (priv->max_extent_a + agap)
+        + (priv->max_extent_a - size[2]) * aalign;
+      child_box.x2 = child_box.x1 + size[2];
+      child_box.y1 = (n / per_line) * (priv->max_extent_b + bgap)
+        + (priv->max_extent_b - size[3]) * balign;
+      child_box.y2 = child_box.y1 + size[3];
+
+      min_child_box.x1 = 0;
+      min_child_box.y1 = 0;
+      min_child_box.x2 = size[0];
+      min_child_box.y2 = size[1];
+
+      if (priv->orientation == MX_ORIENTATION_VERTICAL)
+        {
+          gfloat temp = child_box.x1;
+          child_box.x1 = child_box.y1;
+          child_box.y1 = temp;
+
+          temp = child_box.x2;
+          child_box.x2 = child_box.y2;
+          child_box.y2 = temp;
+
+          min_child_box.x2 = size[1];
+          min_child_box.y2 = size[0];
+        }
+
+      /* account for padding and pixel-align */
+      child_box.x1 = (int)(child_box.x1 + padding->left);
+      child_box.y1 = (int)(child_box.y1 + padding->top);
+      child_box.x2 = (int)(child_box.x2 + padding->left);
+      child_box.y2 = (int)(child_box.y2 + padding->top);
+
+      if (!calculate_extents_only)
+        {
+          clutter_actor_allocate (child, &child_box, flags);
+          mx_grid_index_child (grid, child, &child_box, n % per_line == 0);
+        }
+
+      extent_width = MAX (extent_width, child_box.x2 + padding->right);
+      extent_height = MAX (extent_height, child_box.y2 + padding->bottom);
+      extent_min_width = MAX (extent_min_width, padding->left
+                              + min_child_box.x2 + padding->right);
+      extent_min_height = MAX (extent_min_height, padding->top
+                               + min_child_box.y2 + padding->bottom);
+
+      n++;
+    }
+
+  g_array_free (sizes, TRUE);
+
+  if (actual_width)
+    *actual_width = extent_width;
+  if (actual_height)
+    *actual_height = extent_height;
+  if (min_width)
+    *min_width = extent_min_width;
+  if (min_height)
+    *min_height = extent_min_height;
+
+  if (!calculate_extents_only)
+    mx_grid_finish_index (grid);
+
+  return TRUE;
+}
+
 static void
 mx_grid_do_allocate (ClutterActor          *self,
                      const ClutterActorBox *box,
@@ -1458,20 +2237,23 @@ mx_grid_do_allocate (ClutterActor          *self,
 
   ClutterActorIter iter;
   ClutterActor *child;
+  MxGridLayoutCache *cache;
+  gboolean new_line, resumed;
+  gfloat extent_width, extent_height, extent_min_width, extent_min_height;
+  gint position;
+  MX_TRACE_BEGIN (mx_grid_do_allocate);
+
+  /* measure the texts under the grid on worker threads, once after each
+   * relayout, before the children are asked for their size */
+  if (priv->prefetch_text_sizes && !priv->text_prefetched)
+    {
+      priv->text_prefetched = TRUE;
+      _mx_label_prefetch_text_sizes (self);
+    }
 
   mx_widget_get_padding (MX_WIDGET (self), &padding);
 
-  if (actual_width)
-    *actual_width = 0;
-
-  if (actual_height)
-    *actual_height = 0;
-
-  if (min_width)
-    *min_width = 0;
-
-  if (min_height)
-    *min_height = 0;
+  extent_width = extent_height = extent_min_width = extent_min_height = 0;
 
   current_a = current_b = next_b = 0;
 
@@ -1496,6 +2278,17 @@ mx_grid_do_allocate (ClutterActor          *self,
       bgap          = priv->row_spacing;
     }
 
+  if (homogenous_a && homogenous_b && priv->max_stride > 0 &&
+      mx_grid_do_allocate_homogenous (layout, &padding, flags,
+                                      calculate_extents_only,
+                                      agap, bgap, aalign, balign,
+                                      actual_width, actual_height,
+                                      min_width, min_height))
+    {
+      MX_TRACE_END (mx_grid_do_allocate);
+      return;
+    }
+
   priv->max_extent_a = 0;
   priv->max_extent_b = 0;
 
@@ -1520,7 +2313,7 @@ mx_grid_do_allocate (ClutterActor          *self,
           if (natural_width > priv->max_extent_a)
             priv->max_extent_a = natural_width;
           if (natural_height > priv->max_extent_b)
-            priv->max_extent_b = natural_width;
+            priv->max_extent_b = natural_height;
         }
     }
 
@@ -1531,15 +2324,79 @@ mx_grid_do_allocate (ClutterActor          *self,
       priv->max_extent_b = temp;
     }
 
-  current_stride = 0;
+  /* The layout of a line only depends on the lines before it, unless the
+   * children are homogenous or the lines aligned, as the sizes of all the
+   * children are needed then. So when children were appended, or the size
+   * of ones in the last lines changed, the layout goes on from the first
+   * line that may have changed, as laid out in the cache. */
+  cache = mx_grid_get_layout_cache (layout, &padding, agap, bgap, balign);
+  child = clutter_actor_get_first_child (self);
+  position = 0;
+  resumed = FALSE;
+
+  if (!homogenous_a && !homogenous_b && !priv->line_alignment &&
+      cache->lines->len &&
+      (calculate_extents_only || priv->lines_serial == cache->serial))
+    {
+      MxGridLineState *state;
+      guint from = MIN (cache->dirty_line, cache->lines->len - 1);
+
+      if (!calculate_extents_only)
+        from = MIN (from, MIN (cache->alloc_dirty_line, priv->lines->len));
+
+      if (from > 0 &&
+          mx_grid_check_lines (layout, cache, from, calculate_extents_only,
+                               flags))
+        {
+          state = &g_array_index (cache->lines, MxGridLineState, from);
+
+          child = state->first_child;
+          position = state->position;
+          current_b = state->current_b;
+          next_b = state->next_b;
+          extent_width = state->extent_width;
+          extent_height = state->extent_height;
+          extent_min_width = state->extent_min_width;
+          extent_min_height = state->extent_min_height;
+
+          g_array_set_size (cache->lines, from);
+          if (!calculate_extents_only)
+            mx_grid_set_n_lines (layout, from);
+          else
+            cache->alloc_dirty_line = MIN (cache->alloc_dirty_line, from);
+
+          resumed = TRUE;
+        }
+    }
+
+  if (!resumed)
+    {
+      g_array_set_size (cache->lines, 0);
+      if (!calculate_extents_only)
+        mx_grid_set_n_lines (layout, 0);
+      else
+        cache->alloc_dirty_line = 0;
+    }
+
+  if (!calculate_extents_only)
+    priv->lines_serial = cache->serial;
+
+  /* only used by compute_row_start(), which starts from the first child */
   clutter_actor_iter_init (&iter, self);
-  while (clutter_actor_iter_next (&iter, &child))
+
+  new_line = TRUE;
+  current_stride = 0;
+  for (; child; child = clutter_actor_get_next_sibling (child), position++)
     {
+      MxGridActorData *data;
       gfloat natural_a;
       gfloat natural_b;
       gfloat min_a;
       gfloat min_b;
 
+      data = mx_grid_get_child_data (layout, child, position, TRUE);
+      data->visible = !!CLUTTER_ACTOR_IS_VISIBLE (child);
+
       if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
 
@@ -1548,6 +2405,11 @@ mx_grid_do_allocate (ClutterActor          *self,
                                         &min_a, &min_b,
                                         &natural_a, &natural_b);
 
+      data->min_width = min_a;
+      data->min_height = min_b;
+      data->natural_width = natural_a;
+      data->natural_height = natural_b;
+
       /* swap axes around if column is major */
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
         {
@@ -1561,9 +2423,15 @@ mx_grid_do_allocate (ClutterActor          *self,
         }
 
       /* if the child is overflowing, or the max-stride has been reached,
-       * we wrap to next line */
+       * we wrap to next line; the line the layout goes on from starts
+       * where it did */
       current_stride++;
-      if ((priv->max_stride > 0 && current_stride > priv->max_stride)
+      if (resumed)
+        {
+          current_stride = 1;
+          resumed = FALSE;
+        }
+      else if ((priv->max_stride > 0 && current_stride > priv->max_stride)
           || (current_a + natural_a > priv->a_wrap
               || (homogenous_a && current_a + priv->max_extent_a > priv->a_wrap)))
         {
@@ -1572,6 +2440,23 @@ mx_grid_do_allocate (ClutterActor          *self,
           next_b = current_b + bgap;
           priv->first_of_batch = TRUE;
           current_stride = 1;
+          new_line = TRUE;
+        }
+
+      if (new_line)
+        {
+          MxGridLineState state;
+
+          state.first_child = child;
+          state.position = position;
+          state.current_b = current_b;
+          state.next_b = next_b;
+          state.extent_width = extent_width;
+          state.extent_height = extent_height;
+          state.extent_min_width = extent_min_width;
+          state.extent_min_height = extent_min_height;
+
+          g_array_append_val (cache->lines, state);
         }
 
       if (priv->line_alignment &&
@@ -1644,29 +2529,36 @@ mx_grid_do_allocate (ClutterActor          *self,
         child_box.x2 = (int)(child_box.x2 + padding.left);
         child_box.y2 = (int)(child_box.y2 + padding.top);
 
-        /* update the allocation */
+        /* update the allocation, and the lines for painting */
         if (!calculate_extents_only)
-          clutter_actor_allocate (CLUTTER_ACTOR (child),
-                                  &child_box,
-                                  flags);
+          {
+            clutter_actor_allocate (CLUTTER_ACTOR (child),
+                                    &child_box,
+                                    flags);
+
+            data->box = child_box;
+            data->box_serial = cache->serial;
+
+            mx_grid_index_child (layout, child, &child_box, new_line);
+          }
+
+        new_line = FALSE;
 
         /* update extents */
-        if (actual_width && (child_box.x2 + padding.right) > *actual_width)
-          *actual_width = child_box.x2 + padding.right;
+        if ((child_box.x2 + padding.right) > extent_width)
+          extent_width = child_box.x2 + padding.right;
 
-        if (actual_height && (child_box.y2 + padding.bottom) > *actual_height)
-          *actual_height = child_box.y2 + padding.bottom;
+        if ((child_box.y2 + padding.bottom) > extent_height)
+          extent_height = child_box.y2 + padding.bottom;
 
-        if (min_width &&
-            padding.left + min_child_box.x2 + padding.right > *min_width)
+        if (padding.left + min_child_box.x2 + padding.right > extent_min_width)
           {
-            *min_width = padding.left + min_child_box.x2 + padding.right;
+            extent_min_width = padding.left + min_child_box.x2 + padding.right;
           }
 
-        if (min_height &&
-            padding.top + min_child_box.y2 + padding.bottom > *min_height)
+        if (padding.top + min_child_box.y2 + padding.bottom > extent_min_height)
           {
-            *min_height = padding.left + min_child_box.y2 + padding.right;
+            extent_min_height = padding.top + min_child_box.y2 + padding.bottom;
           }
 
         if (homogenous_a)
@@ -1679,6 +2571,24 @@ mx_grid_do_allocate (ClutterActor          *self,
           }
       }
     }
+
+  cache->dirty_line = G_MAXUINT;
+  if (!calculate_extents_only)
+    cache->alloc_dirty_line = G_MAXUINT;
+
+  if (actual_width)
+    *actual_width = extent_width;
+  if (actual_height)
+    *actual_height = extent_height;
+  if (min_width)
+    *min_width = extent_min_width;
+  if (min_height)
+    *min_height = extent_min_height;
+
+  if (!calculate_extents_only)
+    mx_grid_finish_index (layout);
+
+  MX_TRACE_END (mx_grid_do_allocate);
 }
 
 static void
@@ -1766,6 +2676,8 @@ mx_grid_allocate (ClutterActor          *self,
 
   mx_grid_do_allocate (self, &alloc_box, flags, FALSE, NULL, NULL,
       NULL, NULL);
+
+  _mx_focus_index_invalidate (priv->focus_index);
 }
 
 
@@ -119,6 +119,14 @@ void mx_grid_set_max_stride (MxGrid *self,
                              gint    value);
 gint mx_grid_get_max_stride (MxGrid *self);
 
+void     mx_grid_set_batch_backgrounds (MxGrid   *self,
+                                        gboolean  value);
+gboolean mx_grid_get_batch_backgrounds (MxGrid   *self);
+
+void     mx_grid_set_prefetch_text_sizes (MxGrid   *self,
+                                          gboolean  value);
+gboolean mx_grid_get_prefetch_text_sizes (MxGrid   *self);
+
 G_END_DECLS
 
 #endif /* __MX_GRID_H__ */
@@ -23,14 +23,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
 #include "mx-icon-theme.h"
 #include "mx-marshal.h"
 #include "mx-texture-cache.h"
 #include "mx-private.h"
 #include "mx-settings.h"
+#include "mx-worker-pool.h"
 
 G_DEFINE_TYPE (MxIconTheme, mx_icon_theme, G_TYPE_OBJECT)
 
+static MxIconTheme *default_icon_theme = NULL;
+
 enum
 {
   CHANGED,
@@ -62,6 +67,10 @@ struct _MxIconThemePrivate
 {
   guint       override_theme : 1;
 
+  /* the theme descriptions are read from the search paths when an icon is
+   * first looked up, not when the theme is set */
+  guint       loaded         : 1;
+
   GList      *search_paths;
   GHashTable *icon_hash;
   GHashTable *theme_path_hash;
@@ -71,8 +80,52 @@ struct _MxIconThemePrivate
   GList      *theme_fallbacks;
 
   GKeyFile   *hicolor_file;
+
+  /* theme directory in a search path -> MxIconThemeIndex */
+  GHashTable *index_hash;
+
+  /* "<size>:<icon name>" -> the texture of the icon, or %NULL when there
+   * is none, shared by all the icons showing it. Only used from the main
+   * thread, and emptied whenever the icons looked up may have changed. */
+  GHashTable *texture_hash;
+
+  /* Protects the theme and the caches above, which asynchronous lookups
+   * use from worker threads. Only the main thread changes the theme and
+   * the search paths. */
+  GMutex      lock;
 };
 
+/* The icons a theme has in each of its directories, read from the
+ * icon-theme.cache file gtk-update-icon-cache writes when it's up to date,
+ * or else from a listing of each directory, so that finding an icon doesn't
+ * take a stat() per directory and file type.
+ */
+typedef struct
+{
+  MxIconTheme *theme;
+  gchar       *path;
+
+  /* Watches the theme directory, and each directory that has been listed,
+   * so that only the icons that change need to be looked up again. */
+  GFileMonitor *monitor;
+  GHashTable   *dir_monitors;
+
+  /* icon-theme.cache, and its directory name -> 1 + directory index */
+  GMappedFile *cache;
+  GHashTable  *cache_dirs;
+
+  /* directory name -> (icon name -> MxIconSuffix flags) */
+  GHashTable  *dirs;
+} MxIconThemeIndex;
+
+/* the flags of icon-theme.cache images */
+typedef enum
+{
+  MX_ICON_SUFFIX_XPM = 1 << 0,
+  MX_ICON_SUFFIX_SVG = 1 << 1,
+  MX_ICON_SUFFIX_PNG = 1 << 2
+} MxIconSuffix;
+
 enum
 {
   PROP_0,
@@ -147,6 +200,10 @@ mx_icon_theme_finalize (GObject *object)
   if (priv->hicolor_file)
     g_key_file_free (priv->hicolor_file);
 
+  g_hash_table_unref (priv->index_hash);
+  g_hash_table_unref (priv->texture_hash);
+  g_mutex_clear (&priv->lock);
+
   G_OBJECT_CLASS (mx_icon_theme_parent_class)->finalize (object);
 }
 
@@ -322,6 +379,70 @@ mx_icon_theme_load_fallbacks (MxIconTheme *theme,
     }
 }
 
+/* Frees the descriptions of the theme and its fallbacks, which are read
+ * again when next needed. Called with the lock held. */
+static void
+mx_icon_theme_unload (MxIconTheme *theme)
+{
+  MxIconThemePrivate *priv = theme->priv;
+
+  g_hash_table_remove_all (priv->icon_hash);
+  g_hash_table_remove_all (priv->texture_hash);
+
+  if (priv->theme_file)
+    {
+      g_hash_table_remove (priv->theme_path_hash, priv->theme_file);
+      g_key_file_free (priv->theme_file);
+      priv->theme_file = NULL;
+    }
+
+  while (priv->theme_fallbacks)
+    {
+      g_hash_table_remove (priv->theme_path_hash, priv->theme_fallbacks->data);
+      g_key_file_free ((GKeyFile *)priv->theme_fallbacks->data);
+      priv->theme_fallbacks = g_list_delete_link (priv->theme_fallbacks,
+                                                  priv->theme_fallbacks);
+    }
+
+  priv->loaded = FALSE;
+}
+
+/* Reads the descriptions of hicolor, the theme and its fallbacks from the
+ * search paths, if that hasn't been done since they last changed. Called
+ * with the lock held. */
+static void
+mx_icon_theme_ensure_loaded (MxIconTheme *theme)
+{
+  MxIconThemePrivate *priv = theme->priv;
+  gint64 start;
+
+  if (G_LIKELY (priv->loaded))
+    return;
+
+  priv->loaded = TRUE;
+
+  start = _mx_startup_trace_begin ();
+
+  if (!priv->hicolor_file)
+    {
+      priv->hicolor_file = mx_icon_theme_load_theme (theme, "hicolor");
+      if (!priv->hicolor_file)
+        g_warning ("Error loading fallback icon theme");
+    }
+
+  if (priv->theme)
+    {
+      priv->theme_file = mx_icon_theme_load_theme (theme, priv->theme);
+
+      if (priv->theme_file)
+        mx_icon_theme_load_fallbacks (theme, priv->theme_file, TRUE);
+      else
+        g_warning ("Error loading \"%s\" icon theme", priv->theme);
+    }
+
+  _mx_startup_trace_end ("icon-theme", start);
+}
+
 static void
 mx_icon_theme_changed_cb (MxSettings  *settings,
                           GParamSpec  *pspec,
@@ -339,6 +460,358 @@ mx_icon_theme_changed_cb (MxSettings  *settings,
   self->priv->override_theme = FALSE;
 }
 
+static guint32
+mx_icon_theme_cache_get_uint32 (MxIconThemeIndex *index,
+                                guint32           offset)
+{
+  const guchar *data;
+
+  data = (const guchar *) g_mapped_file_get_contents (index->cache);
+
+  if ((gsize) offset + 4 > g_mapped_file_get_length (index->cache))
+    return G_MAXUINT32;
+
+  return ((guint32) data[offset] << 24) | ((guint32) data[offset + 1] << 16) |
+         ((guint32) data[offset + 2] << 8) | data[offset + 3];
+}
+
+static guint16
+mx_icon_theme_cache_get_uint16 (MxIconThemeIndex *index,
+                                guint32           offset)
+{
+  const guchar *data;
+
+  data = (const guchar *) g_mapped_file_get_contents (index->cache);
+
+  if ((gsize) offset + 2 > g_mapped_file_get_length (index->cache))
+    return G_MAXUINT16;
+
+  return ((guint16) data[offset] << 8) | data[offset + 1];
+}
+
+/* A nul-terminated string in the cache, or %NULL */
+static const gchar *
+mx_icon_theme_cache_get_string (MxIconThemeIndex *index,
+                                guint32           offset)
+{
+  const gchar *data = g_mapped_file_get_contents (index->cache);
+  gsize length = g_mapped_file_get_length (index->cache);
+
+  if (offset >= length || !memchr (data + offset, '\0', length - offset))
+    return NULL;
+
+  return data + offset;
+}
+
+/* the hash function of icon-theme.cache */
+static guint32
+mx_icon_theme_cache_hash (const gchar *name)
+{
+  const signed char *p = (const signed char *) name;
+  guint32 hash = *p;
+
+  if (hash)
+    for (p += 1; *p; p++)
+      hash = (hash << 5) - hash + *p;
+
+  return hash;
+}
+
+/* Maps the icon-theme.cache of the theme directory @index is for, if
+ * it's newer than the directory, as GTK+ does */
+static void
+mx_icon_theme_index_load_cache (MxIconThemeIndex *index)
+{
+  struct stat dir_stat, cache_stat;
+  guint32 dirs_offset, n_dirs, i;
+  gchar *cache_path;
+
+  cache_path = g_build_filename (index->path, "icon-theme.cache", NULL);
+
+  if (g_stat (index->path, &dir_stat) == 0 &&
+      g_stat (cache_path, &cache_stat) == 0 &&
+      cache_stat.st_mtime >= dir_stat.st_mtime)
+    index->cache = g_mapped_file_new (cache_path, FALSE, NULL);
+
+  g_free (cache_path);
+
+  if (!index->cache)
+    return;
+
+  dirs_offset = mx_icon_theme_cache_get_uint32 (index, 8);
+  n_dirs = mx_icon_theme_cache_get_uint32 (index, dirs_offset);
+
+  /* only version 1.0 is known, directories are listed instead of using
+   * anything else */
+  if (mx_icon_theme_cache_get_uint16 (index, 0) != 1 ||
+      mx_icon_theme_cache_get_uint16 (index, 2) != 0 ||
+      n_dirs == G_MAXUINT32)
+    {
+      g_mapped_file_unref (index->cache);
+      index->cache = NULL;
+      return;
+    }
+
+  index->cache_dirs = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < n_dirs; i++)
+    {
+      guint32 name_offset =
+        mx_icon_theme_cache_get_uint32 (index, dirs_offset + 4 + 4 * i);
+      const gchar *name = mx_icon_theme_cache_get_string (index, name_offset);
+
+      if (!name)
+        break;
+
+      g_hash_table_insert (index->cache_dirs, (gpointer) name,
+                           GUINT_TO_POINTER (i + 1));
+    }
+}
+
+static void mx_icon_theme_dir_changed_cb (GFileMonitor      *monitor,
+                                          GFile             *file,
+                                          GFile             *other_file,
+                                          GFileMonitorEvent  event,
+                                          MxIconThemeIndex  *index);
+
+static GFileMonitor *
+mx_icon_theme_index_monitor (MxIconThemeIndex *index,
+                             const gchar      *dir)
+{
+  GFileMonitor *monitor;
+  GFile *file;
+  gchar *path;
+
+  path = g_build_filename (index->path, dir, NULL);
+  file = g_file_new_for_path (path);
+  monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, NULL);
+  g_object_unref (file);
+  g_free (path);
+
+  if (!monitor)
+    return NULL;
+
+  /* the directory of the theme itself is "" */
+  g_object_set_data_full (G_OBJECT (monitor), "mx-icon-theme-dir",
+                          g_strdup (dir), g_free);
+  g_signal_connect (monitor, "changed",
+                    G_CALLBACK (mx_icon_theme_dir_changed_cb), index);
+
+  return monitor;
+}
+
+static void
+mx_icon_theme_monitor_free (GFileMonitor *monitor)
+{
+  g_signal_handlers_disconnect_matched (monitor, G_SIGNAL_MATCH_FUNC, 0, 0,
+                                        NULL, mx_icon_theme_dir_changed_cb,
+                                        NULL);
+  g_file_monitor_cancel (monitor);
+  g_object_unref (monitor);
+}
+
+static MxIconThemeIndex *
+mx_icon_theme_index_new (MxIconTheme *theme,
+                         const gchar *path)
+{
+  MxIconThemeIndex *index = g_slice_new0 (MxIconThemeIndex);
+
+  index->theme = theme;
+  index->path = g_strdup (path);
+  index->dirs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                       (GDestroyNotify) g_hash_table_unref);
+  index->dir_monitors = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free,
+                                               (GDestroyNotify)
+                                               mx_icon_theme_monitor_free);
+  mx_icon_theme_index_load_cache (index);
+
+  if (g_file_test (path, G_FILE_TEST_IS_DIR))
+    index->monitor = mx_icon_theme_index_monitor (index, "");
+
+  return index;
+}
+
+static void
+mx_icon_theme_index_free (MxIconThemeIndex *index)
+{
+  if (index->monitor)
+    mx_icon_theme_monitor_free (index->monitor);
+  g_hash_table_unref (index->dir_monitors);
+
+  if (index->cache_dirs)
+    g_hash_table_unref (index->cache_dirs);
+  if (index->cache)
+    g_mapped_file_unref (index->cache);
+
+  g_hash_table_unref (index->dirs);
+  g_free (index->path);
+  g_slice_free (MxIconThemeIndex, index);
+}
+
+static MxIconSuffix
+mx_icon_theme_index_lookup_cache (MxIconThemeIndex *index,
+                                  const gchar      *dir,
+                                  const gchar      *icon)
+{
+  guint32 hash_offset, n_buckets, chain_offset;
+  guint dir_index;
+
+  dir_index = GPOINTER_TO_UINT (g_hash_table_lookup (index->cache_dirs, dir));
+  if (!dir_index)
+    return 0;
+  dir_index--;
+
+  hash_offset = mx_icon_theme_cache_get_uint32 (index, 4);
+  n_buckets = mx_icon_theme_cache_get_uint32 (index, hash_offset);
+  if (n_buckets == 0 || n_buckets == G_MAXUINT32)
+    return 0;
+
+  chain_offset = mx_icon_theme_cache_get_uint32 (index, hash_offset + 4 +
+                   4 * (mx_icon_theme_cache_hash (icon) % n_buckets));
+
+  while (chain_offset != G_MAXUINT32)
+    {
+      const gchar *name;
+      guint32 name_offset, images_offset, n_images, i;
+
+      name_offset = mx_icon_theme_cache_get_uint32 (index, chain_offset + 4);
+      name = mx_icon_theme_cache_get_string (index, name_offset);
+
+      if (name && g_str_equal (name, icon))
+        {
+          images_offset = mx_icon_theme_cache_get_uint32 (index,
+                                                          chain_offset + 8);
+          n_images = mx_icon_theme_cache_get_uint32 (index, images_offset);
+          if (n_images == G_MAXUINT32)
+            return 0;
+
+          for (i = 0; i < n_images; i++)
+            {
+              guint32 image_offset = images_offset + 4 + 8 * i;
+
+              if (mx_icon_theme_cache_get_uint16 (index, image_offset) ==
+                  dir_index)
+                return mx_icon_theme_cache_get_uint16 (index,
+                                                       image_offset + 2) &
+                       (MX_ICON_SUFFIX_XPM | MX_ICON_SUFFIX_SVG |
+                        MX_ICON_SUFFIX_PNG);
+            }
+
+          return 0;
+        }
+
+      chain_offset = mx_icon_theme_cache_get_uint32 (index, chain_offset);
+    }
+
+  return 0;
+}
+
+/* Lists @dir the first time it's needed, instead of testing for each icon */
+static GHashTable *
+mx_icon_theme_index_read_dir (MxIconThemeIndex *index,
+                              const gchar      *dir)
+{
+  GHashTable *icons;
+  const gchar *file;
+  gchar *path;
+  GDir *gdir;
+
+  icons = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_hash_table_insert (index->dirs, g_strdup (dir), icons);
+
+  path = g_build_filename (index->path, dir, NULL);
+  gdir = g_dir_open (path, 0, NULL);
+  g_free (path);
+
+  if (!gdir)
+    return icons;
+
+  /* listings are kept up to date once they're read */
+  if (!g_hash_table_lookup (index->dir_monitors, dir))
+    {
+      GFileMonitor *monitor = mx_icon_theme_index_monitor (index, dir);
+
+      if (monitor)
+        g_hash_table_insert (index->dir_monitors, g_strdup (dir), monitor);
+    }
+
+  while ((file = g_dir_read_name (gdir)))
+    {
+      const gchar *suffix = strrchr (file, '.');
+      MxIconSuffix flag;
+      gchar *name;
+
+      if (!suffix)
+        continue;
+
+      if (g_str_equal (suffix, ".png"))
+        flag = MX_ICON_SUFFIX_PNG;
+      else if (g_str_equal (suffix, ".svg"))
+        flag = MX_ICON_SUFFIX_SVG;
+      else if (g_str_equal (suffix, ".xpm"))
+        flag = MX_ICON_SUFFIX_XPM;
+      else
+        continue;
+
+      name = g_strndup (file, suffix - file);
+      flag |= GPOINTER_TO_UINT (g_hash_table_lookup (icons, name));
+      g_hash_table_insert (icons, name, GUINT_TO_POINTER (flag));
+    }
+
+  g_dir_close (gdir);
+
+  return icons;
+}
+
+/* The types of file @icon has in @dir */
+static MxIconSuffix
+mx_icon_theme_index_lookup (MxIconThemeIndex *index,
+                            const gchar      *dir,
+                            const gchar      *icon)
+{
+  GHashTable *icons;
+
+  if (index->cache)
+    return mx_icon_theme_index_lookup_cache (index, dir, icon);
+
+  icons = g_hash_table_lookup (index->dirs, dir);
+  if (!icons)
+    icons = mx_icon_theme_index_read_dir (index, dir);
+
+  return GPOINTER_TO_UINT (g_hash_table_lookup (icons, icon));
+}
+
+static MxIconThemeIndex *
+mx_icon_theme_get_index (MxIconTheme *self,
+                         const gchar *search_path,
+                         const gchar *theme)
+{
+  MxIconThemePrivate *priv = self->priv;
+  MxIconThemeIndex *index;
+  gchar *path;
+
+  path = g_build_filename (search_path, theme, NULL);
+  index = g_hash_table_lookup (priv->index_hash, path);
+
+  if (!index)
+    {
+      index = mx_icon_theme_index_new (self, path);
+      g_hash_table_insert (priv->index_hash, index->path, index);
+    }
+
+  g_free (path);
+
+  return index;
+}
+
+static void
+mx_icon_theme_texture_free (gpointer texture)
+{
+  if (texture)
+    cogl_handle_unref (texture);
+}
+
 static void
 mx_icon_theme_init (MxIconTheme *self)
 {
@@ -383,9 +856,13 @@ mx_icon_theme_init (MxIconTheme *self)
                                                  NULL,
                                                  g_free);
 
-  priv->hicolor_file = mx_icon_theme_load_theme (self, "hicolor");
-  if (!priv->hicolor_file)
-    g_warning ("Error loading fallback icon theme");
+  priv->index_hash = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                            (GDestroyNotify)
+                                            mx_icon_theme_index_free);
+
+  priv->texture_hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                              mx_icon_theme_texture_free);
+  g_mutex_init (&priv->lock);
 
   theme = g_getenv ("MX_ICON_THEME");
   if (theme)
@@ -424,14 +901,73 @@ mx_icon_theme_new (void)
 MxIconTheme *
 mx_icon_theme_get_default (void)
 {
-  static MxIconTheme *default_icon_theme = NULL;
-
   if (!default_icon_theme)
-    default_icon_theme = mx_icon_theme_new ();
+    {
+      default_icon_theme = mx_icon_theme_new ();
+      _mx_memory_monitor_init ();
+    }
 
   return default_icon_theme;
 }
 
+/* An estimate of the icon lookups kept by the default theme: the found
+ * files, or the absence of any, of each icon looked up */
+gsize
+_mx_icon_theme_get_memory_usage (void)
+{
+  MxIconThemePrivate *priv;
+  GHashTableIter iter;
+  gpointer value;
+  gsize bytes = 0;
+
+  if (!default_icon_theme)
+    return 0;
+
+  priv = default_icon_theme->priv;
+
+  g_mutex_lock (&priv->lock);
+
+  g_hash_table_iter_init (&iter, priv->icon_hash);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      GList *l;
+
+      /* the entry and its GThemedIcon key */
+      bytes += 4 * sizeof (gpointer) + 64;
+
+      for (l = value; l; l = l->next)
+        {
+          MxIconData *data = l->data;
+
+          bytes += sizeof (GList) + sizeof (MxIconData) +
+            (data->path ? strlen (data->path) + 1 : 0);
+        }
+    }
+
+  g_mutex_unlock (&priv->lock);
+
+  return bytes;
+}
+
+/* Forgets the icons looked up by the default theme, which are looked up
+ * again in the theme indexes when next needed */
+void
+_mx_icon_theme_trim_memory (MxMemoryTrimLevel level)
+{
+  MxIconThemePrivate *priv;
+
+  if (!default_icon_theme)
+    return;
+
+  priv = default_icon_theme->priv;
+
+  g_mutex_lock (&priv->lock);
+  g_hash_table_remove_all (priv->icon_hash);
+  g_mutex_unlock (&priv->lock);
+
+  g_hash_table_remove_all (priv->texture_hash);
+}
+
 /**
  * mx_icon_theme_get_theme_name:
  * @theme: A #MxIconTheme
@@ -497,39 +1033,129 @@ mx_icon_theme_set_theme_name (MxIconTheme *theme,
   if (priv->theme && g_str_equal (priv->theme, theme_name))
     return;
 
-  /* Clear old data */
-  g_hash_table_remove_all (priv->icon_hash);
+  g_mutex_lock (&priv->lock);
+
+  /* Clear old data, the new theme is read when an icon is looked up */
+  mx_icon_theme_unload (theme);
 
   g_free (priv->theme);
+  priv->theme = g_strdup (theme_name);
 
-  if (priv->theme_file)
-    {
-      g_hash_table_remove (priv->theme_path_hash, priv->theme_file);
-      g_key_file_free (priv->theme_file);
-    }
+  g_mutex_unlock (&priv->lock);
 
-  while (priv->theme_fallbacks)
+  g_object_notify (G_OBJECT (theme), "theme-name");
+}
+
+static gboolean
+mx_icon_theme_remove_name_cb (gpointer key,
+                              gpointer value,
+                              gpointer user_data)
+{
+  const gchar * const *names = g_themed_icon_get_names (G_THEMED_ICON (key));
+  gint i;
+
+  for (i = 0; names[i]; i++)
+    if (g_str_equal (names[i], user_data))
+      return TRUE;
+
+  return FALSE;
+}
+
+/* Re-reads the theme, keeping the directory indexes that are still valid */
+static void
+mx_icon_theme_reload (MxIconTheme *theme)
+{
+  MxIconThemePrivate *priv = theme->priv;
+  gboolean override_theme = priv->override_theme;
+  gchar *name = priv->theme;
+
+  priv->theme = NULL;
+  mx_icon_theme_set_theme_name (theme, name);
+  priv->override_theme = override_theme;
+  g_free (name);
+}
+
+static void
+mx_icon_theme_dir_changed_cb (GFileMonitor      *monitor,
+                              GFile             *file,
+                              GFile             *other_file,
+                              GFileMonitorEvent  event,
+                              MxIconThemeIndex  *index)
+{
+  MxIconTheme *theme = index->theme;
+  MxIconThemePrivate *priv = theme->priv;
+  const gchar *dir, *suffix;
+  gchar *basename, *name;
+
+  if (event != G_FILE_MONITOR_EVENT_CREATED &&
+      event != G_FILE_MONITOR_EVENT_DELETED &&
+      event != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT)
+    return;
+
+  dir = g_object_get_data (G_OBJECT (monitor), "mx-icon-theme-dir");
+  basename = g_file_get_basename (file);
+
+  if (!*dir)
     {
-      g_hash_table_remove (priv->theme_path_hash, priv->theme_fallbacks->data);
-      g_key_file_free ((GKeyFile *)priv->theme_fallbacks->data);
-      priv->theme_fallbacks = g_list_delete_link (priv->theme_fallbacks,
-                                                  priv->theme_fallbacks);
-    }
+      gboolean reload = FALSE;
 
-  /* Load new theme file */
-  priv->theme = g_strdup (theme_name);
-  priv->theme_file = mx_icon_theme_load_theme (theme, theme_name);
+      /* Only the descriptions of the loaded themes and the caches matter
+       * here. The index the cache is in has to go, and any icon may have
+       * changed.
+       */
+      if (g_str_equal (basename, "index.theme"))
+        {
+          gchar *theme_name = g_path_get_basename (index->path);
+
+          reload = g_hash_table_find (priv->theme_path_hash,
+                                      mx_icon_theme_find_name_cb,
+                                      theme_name) != NULL;
+          g_free (theme_name);
+        }
+
+      if (g_str_equal (basename, "icon-theme.cache"))
+        {
+          g_mutex_lock (&priv->lock);
+          g_hash_table_remove (priv->index_hash, index->path);
+          g_hash_table_remove_all (priv->icon_hash);
+          g_mutex_unlock (&priv->lock);
+
+          g_hash_table_remove_all (priv->texture_hash);
+        }
+
+      g_free (basename);
 
-  if (!priv->theme_file)
+      if (reload)
+        mx_icon_theme_reload (theme);
+
+      return;
+    }
+
+  suffix = strrchr (basename, '.');
+  if (!suffix || (!g_str_equal (suffix, ".png") &&
+                  !g_str_equal (suffix, ".svg") &&
+                  !g_str_equal (suffix, ".xpm")))
     {
-      g_warning ("Error loading \"%s\" icon theme", priv->theme);
+      g_free (basename);
       return;
     }
 
-  /* Load fallbacks */
-  mx_icon_theme_load_fallbacks (theme, priv->theme_file, TRUE);
+  /* The directory is listed again when it's next needed, and only the
+   * icons that could be this file are looked up again.
+   */
+  name = g_strndup (basename, suffix - basename);
 
-  g_object_notify (G_OBJECT (theme), "theme-name");
+  g_mutex_lock (&priv->lock);
+  g_hash_table_remove (index->dirs, dir);
+  g_hash_table_foreach_remove (priv->icon_hash, mx_icon_theme_remove_name_cb,
+                               name);
+  g_mutex_unlock (&priv->lock);
+
+  /* any icon may fall back to this one */
+  g_hash_table_remove_all (priv->texture_hash);
+
+  g_free (name);
+  g_free (basename);
 }
 
 static void
@@ -689,50 +1315,37 @@ mx_icon_theme_theme_load_icon (MxIconTheme *self,
           for (p = priv->search_paths; p; p = p->next)
             {
               gchar *file;
+              const gchar *suffix;
+              MxIconSuffix suffixes;
 
               MxIconData *icon_data = NULL;
               const gchar *search_path = p->data;
-              gchar *path = g_build_filename (search_path,
-                                              theme,
-                                              dir,
-                                              NULL);
+              MxIconThemeIndex *index = mx_icon_theme_get_index (self,
+                                                                 search_path,
+                                                                 theme);
 
               /* Try png first, then svg and xpm */
-              file = g_strconcat (path, G_DIR_SEPARATOR_S, icon, ".png", NULL);
-              if (!g_file_test (file, G_FILE_TEST_EXISTS |
-                                      G_FILE_TEST_IS_REGULAR))
-                {
-                  g_free (file);
-                  file = g_strconcat (path, G_DIR_SEPARATOR_S, icon, ".svg",
-                                      NULL);
-                  if (!g_file_test (file, G_FILE_TEST_EXISTS |
-                                          G_FILE_TEST_IS_REGULAR))
-                    {
-                      g_free (file);
-                      file = g_strconcat (path, G_DIR_SEPARATOR_S, icon, ".xpm",
-                                          NULL);
-                      if (!g_file_test (file, G_FILE_TEST_EXISTS |
-                                              G_FILE_TEST_IS_REGULAR))
-                        {
-                          g_free (file);
-                          file = NULL;
-                        }
-                    }
-                }
+              suffixes = mx_icon_theme_index_lookup (index, dir, icon);
+              if (suffixes & MX_ICON_SUFFIX_PNG)
+                suffix = ".png";
+              else if (suffixes & MX_ICON_SUFFIX_SVG)
+                suffix = ".svg";
+              else if (suffixes & MX_ICON_SUFFIX_XPM)
+                suffix = ".xpm";
+              else
+                continue;
 
-              if (file)
-                {
-                  icon_data = mx_icon_theme_icon_data_new (size,
-                                                           file,
-                                                           type,
-                                                           min,
-                                                           max,
-                                                           threshold);
-                  g_free (file);
-
-                  data = g_list_prepend (data, icon_data);
-                }
-              g_free (path);
+              file = g_strconcat (index->path, G_DIR_SEPARATOR_S, dir,
+                                  G_DIR_SEPARATOR_S, icon, suffix, NULL);
+              icon_data = mx_icon_theme_icon_data_new (size,
+                                                       file,
+                                                       type,
+                                                       min,
+                                                       max,
+                                                       threshold);
+              g_free (file);
+
+              data = g_list_prepend (data, icon_data);
             }
         }
       g_free (dirs);
@@ -811,6 +1424,8 @@ mx_icon_theme_get_icons (MxIconTheme *theme,
   const gchar * const *names = NULL;
   MxIconThemePrivate *priv = theme->priv;
 
+  mx_icon_theme_ensure_loaded (theme);
+
   /* Load the icon, or a fallback */
   icon = g_themed_icon_new_with_default_fallbacks (icon_name);
   names = g_themed_icon_get_names (G_THEMED_ICON (icon));
@@ -917,13 +1532,168 @@ mx_icon_theme_lookup_internal (MxIconTheme *theme,
   return best_match;
 }
 
+/* the sizes scalable icons are rasterized at, the smallest one that
+ * covers the requested size is used */
+static const gint mx_icon_theme_raster_sizes[] = {
+  16, 22, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512
+};
+
+/* Rasterizes the scalable icon at @svg_path once per size bucket, and keeps
+ * the result in the user's cache directory, keyed by the file and its
+ * modification time, so that they're loaded as PNGs from then on. Returns
+ * %NULL if the icon should be loaded as it is.
+ */
+static gchar *
+mx_icon_theme_get_raster (const gchar *svg_path,
+                          gint         size)
+{
+  struct stat svg_stat;
+  gchar *checksum, *basename, *dir, *path;
+  GdkPixbuf *pixbuf;
+  gchar *buffer;
+  gsize length;
+  guint i;
+
+  if (g_stat (svg_path, &svg_stat) != 0)
+    return NULL;
+
+  for (i = 0; i < G_N_ELEMENTS (mx_icon_theme_raster_sizes); i++)
+    if (mx_icon_theme_raster_sizes[i] >= size)
+      break;
+
+  if (i < G_N_ELEMENTS (mx_icon_theme_raster_sizes))
+    size = mx_icon_theme_raster_sizes[i];
+  else
+    size = (size + 255) / 256 * 256;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, svg_path, -1);
+  basename = g_strdup_printf ("%s-%" G_GINT64_FORMAT "-%d.png", checksum,
+                              (gint64) svg_stat.st_mtime, size);
+  dir = g_build_filename (g_get_user_cache_dir (), "mx", "icons", NULL);
+  path = g_build_filename (dir, basename, NULL);
+  g_free (basename);
+  g_free (checksum);
+
+  if (g_file_test (path, G_FILE_TEST_EXISTS))
+    {
+      g_free (dir);
+      return path;
+    }
+
+  pixbuf = gdk_pixbuf_new_from_file_at_size (svg_path, size, size, NULL);
+  if (!pixbuf)
+    {
+      g_free (dir);
+      g_free (path);
+      return NULL;
+    }
+
+  /* the file is written atomically, lookups from other threads and
+   * processes see either all of it or nothing */
+  if (g_mkdir_with_parents (dir, 0700) != 0 ||
+      !gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &length, "png", NULL,
+                                  NULL))
+    {
+      g_object_unref (pixbuf);
+      g_free (dir);
+      g_free (path);
+      return NULL;
+    }
+
+  if (!g_file_set_contents (path, buffer, length, NULL))
+    {
+      g_free (path);
+      path = NULL;
+    }
+
+  g_free (buffer);
+  g_object_unref (pixbuf);
+  g_free (dir);
+
+  return path;
+}
+
+/* The file of the best match for the icon, looked up with the lock held,
+ * as the icon data can be freed once it's released */
+static gchar *
+mx_icon_theme_lookup_path (MxIconTheme *theme,
+                           const gchar *icon_name,
+                           gint         size)
+{
+  MxIconData *icon_data;
+  gboolean scalable = FALSE;
+  gchar *path = NULL;
+
+  g_mutex_lock (&theme->priv->lock);
+
+  icon_data = mx_icon_theme_lookup_internal (theme, icon_name, size);
+  if (icon_data)
+    {
+      path = g_strdup (icon_data->path);
+      scalable = (icon_data->type == MX_SCALABLE);
+    }
+
+  g_mutex_unlock (&theme->priv->lock);
+
+  if (scalable && g_str_has_suffix (path, ".svg"))
+    {
+      gchar *raster = mx_icon_theme_get_raster (path, size);
+
+      if (raster)
+        {
+          g_free (path);
+          path = raster;
+        }
+    }
+
+  return path;
+}
+
+/* Finds the texture the icon was last looked up as, which every icon with
+ * the same name and size shares. Returns %FALSE if it has yet to be looked
+ * up; otherwise @texture is a new reference, or %NULL if there is no such
+ * icon. */
+static gboolean
+mx_icon_theme_lookup_texture (MxIconTheme *theme,
+                              const gchar *icon_name,
+                              gint         size,
+                              CoglHandle  *texture)
+{
+  gpointer value;
+  gboolean found;
+  gchar *key;
+
+  key = g_strdup_printf ("%d:%s", size, icon_name);
+  found = g_hash_table_lookup_extended (theme->priv->texture_hash, key, NULL,
+                                        &value);
+  g_free (key);
+
+  if (found)
+    *texture = (value) ? cogl_handle_ref (value) : NULL;
+
+  return found;
+}
+
+static void
+mx_icon_theme_add_texture (MxIconTheme *theme,
+                           const gchar *icon_name,
+                           gint         size,
+                           CoglHandle   texture)
+{
+  g_hash_table_insert (theme->priv->texture_hash,
+                       g_strdup_printf ("%d:%s", size, icon_name),
+                       (texture) ? cogl_handle_ref (texture) : NULL);
+}
+
 /**
  * mx_icon_theme_lookup:
  * @theme: an #MxIconTheme
  * @icon_name: The name of the icon
  * @size: The desired size of the icon
  *
- * If the icon is available, returns a #CoglHandle of the icon.
+ * If the icon is available, returns a #CoglHandle of the icon. Scalable
+ * icons are rasterized at about @size, and kept in the user's cache
+ * directory for the next time.
  *
  * Return value: (transfer none): a #CoglHandle of the icon, or %NULL.
  */
@@ -933,27 +1703,243 @@ mx_icon_theme_lookup (MxIconTheme *theme,
                       gint         size)
 {
   MxTextureCache *texture_cache;
-  MxIconData *icon_data;
+  CoglHandle texture;
+  gchar *path;
 
   g_return_val_if_fail (MX_IS_ICON_THEME (theme), NULL);
   g_return_val_if_fail (icon_name, NULL);
   g_return_val_if_fail (size > 0, NULL);
 
-  if (!(icon_data = mx_icon_theme_lookup_internal (theme, icon_name, size)))
+  if (mx_icon_theme_lookup_texture (theme, icon_name, size, &texture))
+    return texture;
+
+  if ((path = mx_icon_theme_lookup_path (theme, icon_name, size)))
+    {
+      texture_cache = mx_texture_cache_get_default ();
+      texture = mx_texture_cache_get_cogl_texture (texture_cache, path);
+      g_free (path);
+    }
+  else
+    texture = NULL;
+
+  mx_icon_theme_add_texture (theme, icon_name, size, texture);
+
+  return texture;
+}
+
+typedef struct
+{
+  GSimpleAsyncResult *simple;
+  GCancellable       *cancellable;
+  gchar              *icon_name;
+  gint                size;
+  gchar              *path;
+} MxIconThemeLookup;
+
+static void
+mx_icon_theme_lookup_free (MxIconThemeLookup *lookup)
+{
+  g_object_unref (lookup->simple);
+  if (lookup->cancellable)
+    g_object_unref (lookup->cancellable);
+  g_free (lookup->icon_name);
+  g_free (lookup->path);
+  g_slice_free (MxIconThemeLookup, lookup);
+}
+
+/* runs on a worker thread */
+static void
+mx_icon_theme_lookup_thread (gpointer user_data)
+{
+  MxIconThemeLookup *lookup = user_data;
+  GObject *theme;
+
+  theme = g_async_result_get_source_object (G_ASYNC_RESULT (lookup->simple));
+  lookup->path = mx_icon_theme_lookup_path (MX_ICON_THEME (theme),
+                                            lookup->icon_name, lookup->size);
+  g_object_unref (theme);
+}
+
+static void
+mx_icon_theme_lookup_texture_cb (GObject      *source,
+                                 GAsyncResult *result,
+                                 gpointer      user_data)
+{
+  MxIconThemeLookup *lookup = user_data;
+  GSimpleAsyncResult *simple = lookup->simple;
+  GError *error = NULL;
+  CoglHandle texture;
+
+  texture = mx_texture_cache_get_cogl_texture_finish (MX_TEXTURE_CACHE (source),
+                                                      result, &error);
+  if (texture)
+    {
+      GObject *theme = g_async_result_get_source_object (G_ASYNC_RESULT (simple));
+
+      mx_icon_theme_add_texture (MX_ICON_THEME (theme), lookup->icon_name,
+                                 lookup->size, texture);
+      g_object_unref (theme);
+
+      g_simple_async_result_set_op_res_gpointer (simple, texture,
+                                                 cogl_handle_unref);
+    }
+  else
+    g_simple_async_result_take_error (simple, error);
+
+  g_simple_async_result_complete (simple);
+  mx_icon_theme_lookup_free (lookup);
+}
+
+/* back in the main loop, with the file the icon is in */
+static void
+mx_icon_theme_lookup_ready (gpointer user_data)
+{
+  MxIconThemeLookup *lookup = user_data;
+
+  if (g_cancellable_is_cancelled (lookup->cancellable))
+    g_simple_async_result_complete (lookup->simple);
+  else if (!lookup->path)
+    {
+      GObject *theme;
+
+      theme = g_async_result_get_source_object (G_ASYNC_RESULT (lookup->simple));
+      mx_icon_theme_add_texture (MX_ICON_THEME (theme), lookup->icon_name,
+                                 lookup->size, NULL);
+      g_object_unref (theme);
+
+      g_simple_async_result_set_error (lookup->simple, G_IO_ERROR,
+                                       G_IO_ERROR_NOT_FOUND,
+                                       "Icon \"%s\" not found",
+                                       lookup->icon_name);
+      g_simple_async_result_complete (lookup->simple);
+    }
+  else
+    {
+      /* the texture is added to the theme's when it's loaded */
+      mx_texture_cache_get_cogl_texture_async (mx_texture_cache_get_default (),
+                                               lookup->path,
+                                               lookup->cancellable,
+                                               mx_icon_theme_lookup_texture_cb,
+                                               lookup);
+      return;
+    }
+
+  mx_icon_theme_lookup_free (lookup);
+}
+
+/**
+ * mx_icon_theme_lookup_async:
+ * @theme: an #MxIconTheme
+ * @icon_name: The name of the icon
+ * @size: The desired size of the icon
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the icon
+ *   is ready
+ * @user_data: (closure): data to pass to @callback
+ *
+ * Asynchronous version of mx_icon_theme_lookup(). The icon is looked up in
+ * the theme on a worker thread, where scalable icons are rasterized if
+ * needed, and then loaded with mx_texture_cache_get_cogl_texture_async().
+ *
+ * When the icon is ready, @callback is called; call
+ * mx_icon_theme_lookup_finish() from it to get the icon.
+ *
+ * Since: 2.0
+ */
+void
+mx_icon_theme_lookup_async (MxIconTheme         *theme,
+                            const gchar         *icon_name,
+                            gint                 size,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data)
+{
+  MxIconThemeLookup *lookup;
+  CoglHandle texture;
+
+  g_return_if_fail (MX_IS_ICON_THEME (theme));
+  g_return_if_fail (icon_name);
+  g_return_if_fail (size > 0);
+
+  lookup = g_slice_new0 (MxIconThemeLookup);
+  lookup->simple = g_simple_async_result_new (G_OBJECT (theme), callback,
+                                              user_data,
+                                              mx_icon_theme_lookup_async);
+  g_simple_async_result_set_check_cancellable (lookup->simple, cancellable);
+
+  /* an icon that was already looked up doesn't go through the worker or
+   * the texture cache again */
+  if (mx_icon_theme_lookup_texture (theme, icon_name, size, &texture))
+    {
+      if (texture)
+        g_simple_async_result_set_op_res_gpointer (lookup->simple, texture,
+                                                   cogl_handle_unref);
+      else
+        g_simple_async_result_set_error (lookup->simple, G_IO_ERROR,
+                                         G_IO_ERROR_NOT_FOUND,
+                                         "Icon \"%s\" not found",
+                                         icon_name);
+
+      g_simple_async_result_complete_in_idle (lookup->simple);
+      mx_icon_theme_lookup_free (lookup);
+      return;
+    }
+
+  lookup->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+  lookup->icon_name = g_strdup (icon_name);
+  lookup->size = size;
+
+  mx_worker_pool_push (mx_worker_pool_get_default (), G_PRIORITY_DEFAULT,
+                       mx_icon_theme_lookup_thread, mx_icon_theme_lookup_ready,
+                       lookup, cancellable);
+}
+
+/**
+ * mx_icon_theme_lookup_finish:
+ * @theme: an #MxIconTheme
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes an operation started with mx_icon_theme_lookup_async().
+ *
+ * Returns: (transfer full): a #CoglHandle of the icon, or %NULL if it
+ *   couldn't be found or loaded, or the operation was cancelled
+ *
+ * Since: 2.0
+ */
+CoglHandle
+mx_icon_theme_lookup_finish (MxIconTheme   *theme,
+                             GAsyncResult  *result,
+                             GError       **error)
+{
+  GSimpleAsyncResult *simple;
+
+  g_return_val_if_fail (g_simple_async_result_is_valid (result,
+                                                        G_OBJECT (theme),
+                                                        mx_icon_theme_lookup_async),
+                        NULL);
+
+  simple = G_SIMPLE_ASYNC_RESULT (result);
+  if (g_simple_async_result_propagate_error (simple, error))
     return NULL;
 
-  texture_cache = mx_texture_cache_get_default ();
-  return mx_texture_cache_get_cogl_texture (texture_cache, icon_data->path);
+  return cogl_handle_ref (g_simple_async_result_get_op_res_gpointer (simple));
 }
 
 gboolean
 mx_icon_theme_has_icon (MxIconTheme *theme,
                         const gchar *icon_name)
 {
+  GList *data;
+
   g_return_val_if_fail (MX_IS_ICON_THEME (theme), FALSE);
   g_return_val_if_fail (icon_name, FALSE);
 
-  if (mx_icon_theme_get_icons (theme, icon_name))
+  g_mutex_lock (&theme->priv->lock);
+  data = mx_icon_theme_get_icons (theme, icon_name);
+  g_mutex_unlock (&theme->priv->lock);
+
+  if (data)
     return TRUE;
   else
     return FALSE;
@@ -994,6 +1980,9 @@ mx_icon_theme_set_search_paths (MxIconTheme *theme,
   g_return_if_fail (MX_IS_ICON_THEME (theme));
 
   priv = theme->priv;
+
+  g_mutex_lock (&priv->lock);
+
   while (priv->search_paths)
     {
       g_free (priv->search_paths->data);
@@ -1004,4 +1993,18 @@ mx_icon_theme_set_search_paths (MxIconTheme *theme,
   priv->search_paths = g_list_copy ((GList *)paths);
   for (p = priv->search_paths; p; p = p->next)
     p->data = g_strdup ((const gchar *)p->data);
+
+  /* the directories of the old search paths are no longer needed, and the
+   * themes may be found elsewhere */
+  g_hash_table_remove_all (priv->index_hash);
+
+  mx_icon_theme_unload (theme);
+  if (priv->hicolor_file)
+    {
+      g_hash_table_remove (priv->theme_path_hash, priv->hicolor_file);
+      g_key_file_free (priv->hicolor_file);
+      priv->hicolor_file = NULL;
+    }
+
+  g_mutex_unlock (&priv->lock);
 }
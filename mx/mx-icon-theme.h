@@ -28,6 +28,7 @@
 #define _MX_ICON_THEME_H
 
 #include <glib-object.h>
+#include <gio/gio.h>
 #include <clutter/clutter.h>
 #include <cogl/cogl.h>
 
@@ -99,6 +100,16 @@ CoglHandle      mx_icon_theme_lookup (MxIconTheme *theme,
                                       const gchar *icon_name,
                                       gint         size);
 
+void            mx_icon_theme_lookup_async  (MxIconTheme         *theme,
+                                             const gchar         *icon_name,
+                                             gint                 size,
+                                             GCancellable        *cancellable,
+                                             GAsyncReadyCallback  callback,
+                                             gpointer             user_data);
+CoglHandle      mx_icon_theme_lookup_finish (MxIconTheme   *theme,
+                                             GAsyncResult  *result,
+                                             GError       **error);
+
 gboolean        mx_icon_theme_has_icon (MxIconTheme *theme,
                                         const gchar *icon_name);
 
@@ -41,7 +41,8 @@ enum
   PROP_0,
 
   PROP_ICON_NAME,
-  PROP_ICON_SIZE
+  PROP_ICON_SIZE,
+  PROP_LOAD_ASYNC
 };
 
 static void mx_stylable_iface_init (MxStylableIface *iface);
@@ -58,9 +59,13 @@ struct _MxIconPrivate
   guint         icon_set         : 1;
   guint         size_set         : 1;
   guint         is_content_image : 1;
+  guint         load_async       : 1;
 
   CoglTexture  *icon_texture;
 
+  /* the asynchronous lookup in progress, if any */
+  GCancellable *cancellable;
+
   gchar        *icon_name;
   gchar        *icon_suffix;
   gint          icon_size;
@@ -127,6 +132,10 @@ mx_icon_set_property (GObject      *gobject,
       mx_icon_set_icon_size (icon, g_value_get_int (value));
       break;
 
+    case PROP_LOAD_ASYNC:
+      mx_icon_set_load_async (icon, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -151,6 +160,10 @@ mx_icon_get_property (GObject    *gobject,
       g_value_set_int (value, mx_icon_get_icon_size (icon));
       break;
 
+    case PROP_LOAD_ASYNC:
+      g_value_set_boolean (value, mx_icon_get_load_async (icon));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -165,9 +178,24 @@ mx_icon_notify_theme_name_cb (MxIconTheme *theme,
   mx_icon_update (self);
 }
 
+static void
+mx_icon_cancel_load (MxIcon *icon)
+{
+  MxIconPrivate *priv = icon->priv;
+
+  if (priv->cancellable)
+    {
+      g_cancellable_cancel (priv->cancellable);
+      g_object_unref (priv->cancellable);
+      priv->cancellable = NULL;
+    }
+}
+
 static void
 mx_icon_dispose (GObject *gobject)
 {
+  mx_icon_cancel_load (MX_ICON (gobject));
+
   if (mx_icon_theme_get_default ())
     {
       g_signal_handlers_disconnect_by_func (mx_icon_theme_get_default (),
@@ -323,6 +351,74 @@ mx_icon_class_init (MxIconClass *klass)
                             1, G_MAXINT, 48,
                             MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, PROP_ICON_SIZE, pspec);
+
+  pspec = g_param_spec_boolean ("load-async",
+                                "Load Asynchronously",
+                                "Whether to look up and load icons "
+                                "asynchronously",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_LOAD_ASYNC, pspec);
+}
+
+static void
+mx_icon_set_texture (MxIcon     *icon,
+                     CoglHandle  texture)
+{
+  MxIconPrivate *priv = icon->priv;
+
+  g_object_unref (priv->cancellable);
+  priv->cancellable = NULL;
+
+  priv->icon_texture = texture;
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (icon));
+}
+
+static void
+mx_icon_missing_lookup_cb (GObject      *source,
+                           GAsyncResult *result,
+                           gpointer      user_data)
+{
+  MxIcon *icon = user_data;
+  GError *error = NULL;
+  CoglHandle texture;
+
+  texture = mx_icon_theme_lookup_finish (MX_ICON_THEME (source), result,
+                                         &error);
+
+  if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    mx_icon_set_texture (icon, texture);
+
+  g_clear_error (&error);
+  g_object_unref (icon);
+}
+
+static void
+mx_icon_lookup_cb (GObject      *source,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+  MxIcon *icon = user_data;
+  GError *error = NULL;
+  CoglHandle texture;
+
+  texture = mx_icon_theme_lookup_finish (MX_ICON_THEME (source), result,
+                                         &error);
+
+  if (texture)
+    mx_icon_set_texture (icon, texture);
+  else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      /* If the icon is missing, use the image-missing icon */
+      mx_icon_theme_lookup_async (MX_ICON_THEME (source), "image-missing",
+                                  icon->priv->icon_size,
+                                  icon->priv->cancellable,
+                                  mx_icon_missing_lookup_cb,
+                                  g_object_ref (icon));
+    }
+
+  g_clear_error (&error);
+  g_object_unref (icon);
 }
 
 static void
@@ -338,14 +434,29 @@ mx_icon_update (MxIcon *icon)
     }
 
   /* Get rid of the old one */
+  mx_icon_cancel_load (icon);
+
   if (priv->icon_texture)
     {
       cogl_object_unref (priv->icon_texture);
       priv->icon_texture = NULL;
     }
 
+  /* Nothing is shown until the new one is loaded */
+  if (priv->icon_name && priv->load_async)
+    {
+      gchar *icon_name;
+
+      icon_name = g_strconcat (priv->icon_name, priv->icon_suffix, NULL);
+      priv->cancellable = g_cancellable_new ();
+      mx_icon_theme_lookup_async (mx_icon_theme_get_default (), icon_name,
+                                  priv->icon_size, priv->cancellable,
+                                  mx_icon_lookup_cb, g_object_ref (icon));
+      g_free (icon_name);
+    }
+
   /* Try to lookup the new one */
-  if (priv->icon_name)
+  else if (priv->icon_name)
     {
       gchar *icon_name;
       MxIconTheme *theme = mx_icon_theme_get_default ();
@@ -392,6 +503,7 @@ mx_icon_style_changed_cb (MxWidget *widget)
       g_signal_handlers_disconnect_by_func (mx_icon_theme_get_default (),
                                             mx_icon_notify_theme_name_cb,
                                             self);
+      mx_icon_cancel_load (self);
 
       if (priv->icon_texture)
         {
@@ -570,3 +682,49 @@ mx_icon_set_icon_size (MxIcon *icon,
 
   priv->size_set = TRUE;
 }
+
+/**
+ * mx_icon_set_load_async:
+ * @icon: A #MxIcon
+ * @load_async: %TRUE to look up and load icons asynchronously
+ *
+ * Sets whether to look up and load icons asynchronously, see
+ * mx_icon_theme_lookup_async(). While an icon is loading, nothing is shown,
+ * unless the icon had been loaded before and is still in the texture cache,
+ * in which case it is shown right away.
+ *
+ * Since: 2.0
+ */
+void
+mx_icon_set_load_async (MxIcon   *icon,
+                        gboolean  load_async)
+{
+  MxIconPrivate *priv;
+
+  g_return_if_fail (MX_IS_ICON (icon));
+
+  priv = icon->priv;
+  if (priv->load_async != load_async)
+    {
+      priv->load_async = load_async;
+      g_object_notify (G_OBJECT (icon), "load-async");
+    }
+}
+
+/**
+ * mx_icon_get_load_async:
+ * @icon: A #MxIcon
+ *
+ * Determines whether icons are looked up and loaded asynchronously.
+ *
+ * Returns: %TRUE if icons are loaded asynchronously, %FALSE otherwise
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_icon_get_load_async (MxIcon *icon)
+{
+  g_return_val_if_fail (MX_IS_ICON (icon), FALSE);
+
+  return icon->priv->load_async;
+}
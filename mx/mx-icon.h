@@ -88,6 +88,9 @@ void         mx_icon_set_icon_name (MxIcon *icon, const gchar *icon_name);
 gint         mx_icon_get_icon_size (MxIcon *icon);
 void         mx_icon_set_icon_size (MxIcon *icon, gint size);
 
+gboolean     mx_icon_get_load_async (MxIcon *icon);
+void         mx_icon_set_load_async (MxIcon *icon, gboolean load_async);
+
 
 G_END_DECLS
 
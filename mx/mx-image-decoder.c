@@ -0,0 +1,579 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-image-decoder.c: Pluggable image decoding backends
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/**
+ * SECTION:mx-image-decoder
+ * @short_description: Pluggable image decoding backends
+ *
+ * #MxImage and #MxTextureCache hand encoded images to the decoders
+ * registered with mx_image_decoder_register() before falling back to
+ * gdk-pixbuf. Mx registers the faster decoders it was built with, for
+ * JPEG with libjpeg-turbo, PNG with libspng and WebP with libwebp, and a
+ * platform can add its own, for instance one that decodes JPEG in
+ * hardware, at a higher priority.
+ *
+ * When Mx is built with sysprof support, each decode is recorded as a
+ * trace mark carrying the name of the decoder that handled it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "mx-image-decoder.h"
+#include "mx-private.h"
+
+#ifdef HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+#ifdef HAVE_SPNG
+#include <spng.h>
+#endif
+
+#ifdef HAVE_WEBP
+#include <webp/decode.h>
+#endif
+
+typedef struct
+{
+  volatile gint       ref_count;
+
+  guint               id;
+  gchar              *name;
+  gint                priority;
+  MxImageDecoderFunc  func;
+  gpointer            user_data;
+  GDestroyNotify      notify;
+} MxImageDecoder;
+
+/* the registered decoders, highest priority first */
+static GMutex decoders_lock;
+static GList *decoders = NULL;
+static guint decoders_next_id = 1;
+static gboolean decoders_builtin = FALSE;
+
+static MxImageDecoder *
+mx_image_decoder_ref (MxImageDecoder *decoder)
+{
+  g_atomic_int_inc (&decoder->ref_count);
+
+  return decoder;
+}
+
+static void
+mx_image_decoder_unref (MxImageDecoder *decoder)
+{
+  if (!g_atomic_int_dec_and_test (&decoder->ref_count))
+    return;
+
+  if (decoder->notify)
+    decoder->notify (decoder->user_data);
+
+  g_free (decoder->name);
+  g_slice_free (MxImageDecoder, decoder);
+}
+
+static gint
+mx_image_decoder_compare (gconstpointer a,
+                          gconstpointer b)
+{
+  const MxImageDecoder *decoder_a = a, *decoder_b = b;
+
+  /* decoders of the same priority are tried in the order they came */
+  return decoder_b->priority - decoder_a->priority;
+}
+
+static guint
+mx_image_decoder_register_unlocked (const gchar        *name,
+                                    gint                priority,
+                                    MxImageDecoderFunc  func,
+                                    gpointer            user_data,
+                                    GDestroyNotify      notify)
+{
+  MxImageDecoder *decoder;
+
+  decoder = g_slice_new (MxImageDecoder);
+  decoder->ref_count = 1;
+  decoder->id = decoders_next_id++;
+  decoder->name = g_strdup (name);
+  decoder->priority = priority;
+  decoder->func = func;
+  decoder->user_data = user_data;
+  decoder->notify = notify;
+
+  decoders = g_list_insert_sorted (decoders, decoder,
+                                   mx_image_decoder_compare);
+
+  return decoder->id;
+}
+
+/* The smallest scale that keeps a @width x @height image covering
+ * @wanted_width x @wanted_height, either of which may be -1 */
+static gdouble
+mx_image_decoder_get_scale (gint width,
+                            gint height,
+                            gint wanted_width,
+                            gint wanted_height)
+{
+  gdouble scale = 0;
+
+  if (wanted_width < 0 && wanted_height < 0)
+    return 1.0;
+
+  if (wanted_width >= 0 && width > 0)
+    scale = MAX (scale, wanted_width / (gdouble) width);
+  if (wanted_height >= 0 && height > 0)
+    scale = MAX (scale, wanted_height / (gdouble) height);
+
+  return CLAMP (scale, 0, 1.0);
+}
+
+#ifdef HAVE_TURBOJPEG
+
+static GdkPixbuf *
+mx_image_decoder_turbojpeg (const guint8  *data,
+                            gsize          length,
+                            gint           width,
+                            gint           height,
+                            gboolean      *scaled,
+                            gpointer       user_data,
+                            GError       **error)
+{
+  gint image_width, image_height, subsamp, colorspace, n_factors, i;
+  tjscalingfactor *factors, factor = { 1, 1 };
+  GdkPixbuf *pixbuf;
+  gdouble scale;
+  tjhandle tj;
+
+  if (length < 3 || data[0] != 0xff || data[1] != 0xd8 || data[2] != 0xff)
+    return NULL;
+
+  tj = tjInitDecompress ();
+  if (!tj)
+    return NULL;
+
+  /* CMYK isn't converted to RGB, gdk-pixbuf is left to do that */
+  if (tjDecompressHeader3 (tj, data, length, &image_width, &image_height,
+                           &subsamp, &colorspace) < 0 ||
+      colorspace == TJCS_CMYK || colorspace == TJCS_YCCK)
+    {
+      tjDestroy (tj);
+      return NULL;
+    }
+
+  /* pick the smallest of the sizes the DCT can be decoded at directly */
+  scale = mx_image_decoder_get_scale (image_width, image_height,
+                                      width, height);
+  factors = tjGetScalingFactors (&n_factors);
+  for (i = 0; factors && i < n_factors; i++)
+    {
+      if (factors[i].num > factors[i].denom ||
+          factors[i].num / (gdouble) factors[i].denom < scale)
+        continue;
+
+      if (factors[i].num * factor.denom < factor.num * factors[i].denom)
+        factor = factors[i];
+    }
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8,
+                           TJSCALED (image_width, factor),
+                           TJSCALED (image_height, factor));
+  if (!pixbuf)
+    {
+      tjDestroy (tj);
+      return NULL;
+    }
+
+  if (tjDecompress2 (tj, data, length, gdk_pixbuf_get_pixels (pixbuf),
+                     gdk_pixbuf_get_width (pixbuf),
+                     gdk_pixbuf_get_rowstride (pixbuf),
+                     gdk_pixbuf_get_height (pixbuf),
+                     TJPF_RGB, TJFLAG_FASTDCT) < 0)
+    {
+      g_object_unref (pixbuf);
+      pixbuf = NULL;
+    }
+  else if (factor.num != factor.denom)
+    *scaled = TRUE;
+
+  tjDestroy (tj);
+
+  return pixbuf;
+}
+
+#endif /* HAVE_TURBOJPEG */
+
+#ifdef HAVE_SPNG
+
+static GdkPixbuf *
+mx_image_decoder_spng (const guint8  *data,
+                       gsize          length,
+                       gint           width,
+                       gint           height,
+                       gboolean      *scaled,
+                       gpointer       user_data,
+                       GError       **error)
+{
+  static const guint8 signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n' };
+  struct spng_ihdr ihdr;
+  GdkPixbuf *pixbuf;
+  spng_ctx *ctx;
+  size_t size;
+
+  if (length < sizeof (signature) ||
+      memcmp (data, signature, sizeof (signature)) != 0)
+    return NULL;
+
+  ctx = spng_ctx_new (0);
+  if (!ctx)
+    return NULL;
+
+  if (spng_set_png_buffer (ctx, data, length) ||
+      spng_get_ihdr (ctx, &ihdr) ||
+      spng_decoded_image_size (ctx, SPNG_FMT_RGBA8, &size))
+    {
+      spng_ctx_free (ctx);
+      return NULL;
+    }
+
+  /* four channels have no padding at the end of the rows, so the image is
+   * decoded straight into the pixbuf */
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8,
+                           ihdr.width, ihdr.height);
+  if (!pixbuf ||
+      size != (gsize) gdk_pixbuf_get_rowstride (pixbuf) * ihdr.height ||
+      spng_decode_image (ctx, gdk_pixbuf_get_pixels (pixbuf), size,
+                         SPNG_FMT_RGBA8, SPNG_DECODE_TRNS))
+    {
+      if (pixbuf)
+        g_object_unref (pixbuf);
+      pixbuf = NULL;
+    }
+
+  spng_ctx_free (ctx);
+
+  return pixbuf;
+}
+
+#endif /* HAVE_SPNG */
+
+#ifdef HAVE_WEBP
+
+static GdkPixbuf *
+mx_image_decoder_webp (const guint8  *data,
+                       gsize          length,
+                       gint           width,
+                       gint           height,
+                       gboolean      *scaled,
+                       gpointer       user_data,
+                       GError       **error)
+{
+  WebPDecoderConfig config;
+  GdkPixbuf *pixbuf;
+  gint rowstride;
+  gdouble scale;
+
+  if (length < 12 ||
+      memcmp (data, "RIFF", 4) != 0 || memcmp (data + 8, "WEBP", 4) != 0)
+    return NULL;
+
+  if (!WebPInitDecoderConfig (&config) ||
+      WebPGetFeatures (data, length, &config.input) != VP8_STATUS_OK ||
+      config.input.has_animation)
+    return NULL;
+
+  /* WebP scales as it decodes, to any size */
+  scale = mx_image_decoder_get_scale (config.input.width, config.input.height,
+                                      width, height);
+  if (scale < 1.0)
+    {
+      config.options.use_scaling = 1;
+      config.options.scaled_width = MAX (ceil (config.input.width * scale), 1);
+      config.options.scaled_height =
+        MAX (ceil (config.input.height * scale), 1);
+    }
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, config.input.has_alpha, 8,
+                           config.options.use_scaling ?
+                           config.options.scaled_width : config.input.width,
+                           config.options.use_scaling ?
+                           config.options.scaled_height : config.input.height);
+  if (!pixbuf)
+    return NULL;
+
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+  config.output.colorspace = config.input.has_alpha ? MODE_RGBA : MODE_RGB;
+  config.output.is_external_memory = 1;
+  config.output.u.RGBA.rgba = gdk_pixbuf_get_pixels (pixbuf);
+  config.output.u.RGBA.stride = rowstride;
+  config.output.u.RGBA.size = gdk_pixbuf_get_byte_length (pixbuf);
+
+  if (WebPDecode (data, length, &config) != VP8_STATUS_OK)
+    {
+      g_object_unref (pixbuf);
+      pixbuf = NULL;
+    }
+  else if (config.options.use_scaling)
+    *scaled = TRUE;
+
+  WebPFreeDecBuffer (&config.output);
+
+  return pixbuf;
+}
+
+#endif /* HAVE_WEBP */
+
+/* The decoders Mx was built with. These don't set errors, so that images
+ * they fail on are left to gdk-pixbuf, which reports them. */
+static void
+mx_image_decoder_ensure_builtin_unlocked (void)
+{
+  if (decoders_builtin)
+    return;
+
+  decoders_builtin = TRUE;
+
+#ifdef HAVE_TURBOJPEG
+  mx_image_decoder_register_unlocked ("libjpeg-turbo", 0,
+                                      mx_image_decoder_turbojpeg, NULL, NULL);
+#endif
+#ifdef HAVE_SPNG
+  mx_image_decoder_register_unlocked ("libspng", 0,
+                                      mx_image_decoder_spng, NULL, NULL);
+#endif
+#ifdef HAVE_WEBP
+  mx_image_decoder_register_unlocked ("libwebp", 0,
+                                      mx_image_decoder_webp, NULL, NULL);
+#endif
+}
+
+/**
+ * mx_image_decoder_register:
+ * @name: A name for the decoder, used in trace marks
+ * @priority: The priority of the decoder
+ * @func: (scope notified): The function that decodes images
+ * @user_data: (closure): Data to pass to @func
+ * @notify: A function to free @user_data with, or %NULL
+ *
+ * Adds a decoder that #MxImage and #MxTextureCache try before gdk-pixbuf.
+ * Decoders are tried in order of @priority, highest first; those built
+ * into Mx have a priority of 0.
+ *
+ * Returns: An identifier to pass to mx_image_decoder_unregister()
+ *
+ * Since: 2.0
+ */
+guint
+mx_image_decoder_register (const gchar        *name,
+                           gint                priority,
+                           MxImageDecoderFunc  func,
+                           gpointer            user_data,
+                           GDestroyNotify      notify)
+{
+  guint id;
+
+  g_return_val_if_fail (name != NULL, 0);
+  g_return_val_if_fail (func != NULL, 0);
+
+  g_mutex_lock (&decoders_lock);
+  mx_image_decoder_ensure_builtin_unlocked ();
+  id = mx_image_decoder_register_unlocked (name, priority, func, user_data,
+                                           notify);
+  g_mutex_unlock (&decoders_lock);
+
+  return id;
+}
+
+/**
+ * mx_image_decoder_unregister:
+ * @id: An identifier returned by mx_image_decoder_register()
+ *
+ * Removes a decoder. If it is decoding an image on another thread, its
+ * user data is freed once it returns.
+ *
+ * Since: 2.0
+ */
+void
+mx_image_decoder_unregister (guint id)
+{
+  MxImageDecoder *decoder = NULL;
+  GList *l;
+
+  g_return_if_fail (id != 0);
+
+  g_mutex_lock (&decoders_lock);
+  for (l = decoders; l; l = l->next)
+    {
+      if (((MxImageDecoder *) l->data)->id == id)
+        {
+          decoder = l->data;
+          decoders = g_list_delete_link (decoders, l);
+          break;
+        }
+    }
+  g_mutex_unlock (&decoders_lock);
+
+  if (!decoder)
+    {
+      g_warning (G_STRLOC ": No image decoder with id %u", id);
+      return;
+    }
+
+  mx_image_decoder_unref (decoder);
+}
+
+/* Takes references on the decoders to try, so that they can be called
+ * without holding the lock. Returns %NULL if there are none. */
+static GList *
+mx_image_decoder_list (void)
+{
+  GList *list;
+
+  g_mutex_lock (&decoders_lock);
+  mx_image_decoder_ensure_builtin_unlocked ();
+  list = g_list_copy (decoders);
+  g_list_foreach (list, (GFunc) mx_image_decoder_ref, NULL);
+  g_mutex_unlock (&decoders_lock);
+
+  return list;
+}
+
+static GdkPixbuf *
+mx_image_decoder_try (GList         *list,
+                      const guint8  *data,
+                      gsize          length,
+                      gint           width,
+                      gint           height,
+                      gboolean      *scaled,
+                      GError       **error)
+{
+  GdkPixbuf *pixbuf = NULL;
+  GError *err = NULL;
+  gboolean decoder_scaled;
+  GList *l;
+
+  for (l = list; l && !pixbuf && !err; l = l->next)
+    {
+      MxImageDecoder *decoder = l->data;
+      MX_TRACE_BEGIN (mx_image_decoder_decode);
+
+      decoder_scaled = FALSE;
+      pixbuf = decoder->func (data, length, width, height, &decoder_scaled,
+                              decoder->user_data, &err);
+
+      if (pixbuf || err)
+        MX_TRACE_END_WITH_MESSAGE (mx_image_decoder_decode, decoder->name);
+    }
+
+  if (err)
+    {
+      g_propagate_error (error, err);
+      g_clear_object (&pixbuf);
+    }
+  else if (pixbuf && scaled)
+    *scaled = decoder_scaled;
+
+  return pixbuf;
+}
+
+/*
+ * _mx_image_decoder_decode:
+ * @data: The encoded image
+ * @length: The size of @data
+ * @width: The width the image will be shown at, or -1
+ * @height: The height the image will be shown at, or -1
+ * @scaled: (out) (allow-none): Set to whether the image was decoded at a
+ *   reduced size
+ * @error: A pointer to a #GError
+ *
+ * Tries the registered decoders on @data.
+ *
+ * Returns: A new #GdkPixbuf, or %NULL. @error is only set if a decoder
+ *   failed on @data; otherwise the image is left to gdk-pixbuf.
+ */
+GdkPixbuf *
+_mx_image_decoder_decode (const guint8  *data,
+                          gsize          length,
+                          gint           width,
+                          gint           height,
+                          gboolean      *scaled,
+                          GError       **error)
+{
+  GdkPixbuf *pixbuf;
+  GList *list;
+
+  list = mx_image_decoder_list ();
+  if (!list)
+    return NULL;
+
+  pixbuf = mx_image_decoder_try (list, data, length, width, height, scaled,
+                                 error);
+
+  g_list_free_full (list, (GDestroyNotify) mx_image_decoder_unref);
+
+  return pixbuf;
+}
+
+/*
+ * _mx_image_decoder_decode_file:
+ *
+ * Like _mx_image_decoder_decode(), for the contents of @filename, which
+ * is only mapped in if there are decoders to try.
+ */
+GdkPixbuf *
+_mx_image_decoder_decode_file (const gchar  *filename,
+                               gint          width,
+                               gint          height,
+                               gboolean     *scaled,
+                               GError      **error)
+{
+  const guint8 *data;
+  GdkPixbuf *pixbuf;
+  GMappedFile *file;
+  GList *list;
+
+  list = mx_image_decoder_list ();
+  if (!list)
+    return NULL;
+
+  /* failing to open the file is left to gdk-pixbuf to report */
+  file = g_mapped_file_new (filename, FALSE, NULL);
+  if (!file)
+    {
+      g_list_free_full (list, (GDestroyNotify) mx_image_decoder_unref);
+      return NULL;
+    }
+
+  data = (const guint8 *) g_mapped_file_get_contents (file);
+  pixbuf = mx_image_decoder_try (list, data, g_mapped_file_get_length (file),
+                                 width, height, scaled, error);
+
+  g_mapped_file_unref (file);
+  g_list_free_full (list, (GDestroyNotify) mx_image_decoder_unref);
+
+  return pixbuf;
+}
@@ -0,0 +1,73 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-image-decoder.h: Pluggable image decoding backends
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#if !defined(MX_H_INSIDE) && !defined(MX_COMPILATION)
+#error "Only <mx/mx.h> can be included directly.h"
+#endif
+
+#ifndef _MX_IMAGE_DECODER
+#define _MX_IMAGE_DECODER
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+/**
+ * MxImageDecoderFunc:
+ * @data: (array length=length): The encoded image
+ * @length: The size of @data
+ * @width: The width the image will be shown at, or -1
+ * @height: The height the image will be shown at, or -1
+ * @scaled: (out): Set to %TRUE if the image was decoded at a reduced size
+ * @user_data: The data passed to mx_image_decoder_register()
+ * @error: A pointer to a #GError
+ *
+ * Decodes @data. A decoder that doesn't handle the format of @data returns
+ * %NULL without setting @error, and the next decoder is tried. A decoder
+ * may decode at a reduced size, as long as the result is no smaller than
+ * @width x @height; the caller scales it the rest of the way.
+ *
+ * Decoders are called from worker threads.
+ *
+ * Returns: (transfer full): A new #GdkPixbuf, or %NULL
+ *
+ * Since: 2.0
+ */
+typedef GdkPixbuf *(* MxImageDecoderFunc) (const guint8  *data,
+                                           gsize          length,
+                                           gint           width,
+                                           gint           height,
+                                           gboolean      *scaled,
+                                           gpointer       user_data,
+                                           GError       **error);
+
+guint mx_image_decoder_register   (const gchar        *name,
+                                   gint                priority,
+                                   MxImageDecoderFunc  func,
+                                   gpointer            user_data,
+                                   GDestroyNotify      notify);
+void  mx_image_decoder_unregister (guint               id);
+
+G_END_DECLS
+
+#endif /* _MX_IMAGE_DECODER */
@@ -28,16 +28,31 @@
  * Since: 1.2
  */
 
-#include <unistd.h>
+/* for importing EGL images, see mx_image_set_from_egl_image() */
+#define COGL_ENABLE_EXPERIMENTAL_API
+
+#include <math.h>
+#include <string.h>
+#include <glib/gstdio.h>
 #include <cogl/cogl.h>
 
 #include "mx-image.h"
 #include "mx-enum-types.h"
 #include "mx-marshal.h"
+#include "mx-private.h"
+#include "mx-scrollable.h"
 #include "mx-texture-cache.h"
+#include "mx-timer-wheel.h"
+#include "mx-worker-pool.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
+/* Cogl includes the EGL headers when it's built with EGL support */
+#if defined (COGL_HAS_EGL_SUPPORT) && defined (EGL_KHR_image_base) && \
+  COGL_VERSION >= COGL_VERSION_ENCODE (1, 20, 0)
+#define MX_IMAGE_HAS_EGL_IMPORT 1
+#endif
+
 G_DEFINE_TYPE (MxImage, mx_image, MX_TYPE_WIDGET)
 
 #define MX_IMAGE_GET_PRIVATE(obj)    \
@@ -45,32 +60,40 @@ G_DEFINE_TYPE (MxImage, mx_image, MX_TYPE_WIDGET)
 
 #define DEFAULT_DURATION 250
 
+/* how long an adaptive image has to stay larger than it was decoded for
+ * before it is decoded again, so that zooming doesn't decode every step */
+#define REDECODE_DELAY 150
+
 /* This stucture holds all that is necessary for cancellable async
- * image loading using thread pools.
+ * image loading using the worker pool.
  *
  * The idea is that you create this structure (with the pixbuf as NULL)
- * and add it to the thread-pool.
+ * and push it to the worker pool.
  *
  * The 'complete' member of the struct is protected by the mutex.
  * The thread handler uses this to indicate that the load was completed.
  *
  * The thread will take the mutex while it's loading data - if cancelled
- * is set when it takes the mutex, it will add the idle handler and let the
- * main thread free the data.
+ * is set when it takes the mutex, it will do nothing and let the main
+ * thread free the data.
  *
- * The idle handler will check that the cancelled member isn't set and if not,
- * will try to upload the image using mx_image_set_from_pixbuf(). It will free
- * the async structure always. It will also reset the pointer to the task in
- * the MxImage priv struct, but only if the cancelled member *isn't* set.
+ * The completion function will check that the cancelled member isn't set
+ * and if not, will try to upload the image using mx_image_set_from_pixbuf().
+ * It will free the async structure always. It will also reset the pointer
+ * to the task in the MxImage priv struct, but only if the cancelled member
+ * *isn't* set.
  */
 typedef struct
 {
   MxImage   *parent;
 
   GMutex          mutex;
-  guint           complete  : 1;
-  guint           cancelled : 1;
-  guint           upscale   : 1;
+  GCancellable   *cancellable;
+  guint           complete    : 1;
+  guint           cancelled   : 1;
+  guint           upscale     : 1;
+  guint           progressive : 1;
+  guint           thumbnails  : 1;
   guint           idle_handler;
 
   gchar          *filename;
@@ -85,14 +108,56 @@ typedef struct
 
   GdkPixbuf      *pixbuf;
   GError         *error;
+
+  /* Large images are uploaded a few rows at a time from the main loop,
+   * once decoded, see mx_image_upload_cb().
+   */
+  CoglHandle      texture;
+  gint            upload_row;
+
+  /* Progressive loads show the rows decoded so far while decoding goes
+   * on, see mx_image_area_updated_cb(). The partial result is handed over
+   * to the main thread under progress_mutex; the rest is only touched by
+   * the thread.
+   */
+  GMutex          progress_mutex;
+  GdkPixbuf      *partial;
+  gint            partial_y;
+  gboolean        partial_whole;
+  guint           progress_idle;
+  gint            dirty_y1, dirty_y2;
+  gint64          last_progress;
+  gboolean        partial_sent;
+
+  /* Queued loads are decoded in order of priority (see
+   * mx_image_get_load_priority()), then in the order they were made.
+   */
+  guint           job_id;
+
+  /* where to share the result in the texture cache, if at all */
+  gchar          *cache_key;
+  gpointer        cache_ident;
 } MxImageAsyncData;
 
+typedef struct _MxImageAnimation MxImageAnimation;
+
+enum
+{
+  MX_IMAGE_PRIORITY_VISIBLE,
+  MX_IMAGE_PRIORITY_OFFSCREEN,
+  MX_IMAGE_PRIORITY_UNMAPPED
+};
+
 struct _MxImagePrivate
 {
   MxImageScaleMode mode;
   MxImageScaleMode previous_mode;
-  guint            load_async : 1;
-  guint            upscale    : 1;
+  guint            load_async   : 1;
+  guint            upscale      : 1;
+  guint            shared_cache : 1;
+  guint            progressive  : 1;
+  guint            use_thumbnails : 1;
+  guint            adaptive     : 1;
   guint            width_threshold;
   guint            height_threshold;
 
@@ -113,6 +178,25 @@ struct _MxImagePrivate
   guint transition_duration;
 
   MxImageAsyncData *async_load_data;
+
+  /* the animation being played, see mx_image_set_from_animation_file() */
+  MxImageAnimation *animation;
+
+  /* adjustments of the scrollable ancestor, watched while a load is
+   * pending to keep its priority up to date */
+  MxAdjustment *hadjust;
+  MxAdjustment *vadjust;
+
+  /* the file last set at a size, and the size asked for, decoded again at
+   * a larger size when the image grows in adaptive mode */
+  gchar   *source_filename;
+  gint     source_width;
+  gint     source_height;
+  MxTimer  redecode_timer;
+
+  /* a texture of a previous image, only used by this image, kept to
+   * upload the next image of the same size into */
+  CoglHandle spare_texture;
 };
 
 enum
@@ -127,6 +211,10 @@ enum
   PROP_IMAGE_ROTATION,
   PROP_TRANSITION_DURATION,
   PROP_FILENAME,
+  PROP_SHARED_CACHE,
+  PROP_PROGRESSIVE,
+  PROP_USE_THUMBNAILS,
+  PROP_ADAPTIVE_RESOLUTION,
 
   LAST_PROP
 };
@@ -141,9 +229,22 @@ enum
 
 static guint signals[LAST_SIGNAL] = { 0, };
 
-static GThreadPool *mx_image_threads = NULL;
 static GQuark mx_image_cache_quark = 0;
 
+/* The materials of all the images are copied from these, so that Cogl
+ * can share the state it derives from them, such as shaders, and so that
+ * images only change textures and constants. They are created with the
+ * first image, see mx_image_ensure_templates().
+ */
+static CoglHandle    mx_image_blank_texture = NULL;
+static CoglMaterial *mx_image_fade_template = NULL;
+static CoglMaterial *mx_image_plain_template = NULL;
+
+/* set on the textures made by an image that nothing else holds, see
+ * mx_image_get_texture() */
+static CoglUserDataKey mx_image_private_texture_key;
+static GQuark mx_image_premultiplied_quark = 0;
+
 static gboolean
 mx_image_set_from_data_internal (MxImage          *image,
                                  const guchar     *data,
@@ -155,12 +256,40 @@ mx_image_set_from_data_internal (MxImage          *image,
                                  gint              rowstride,
                                  GError          **error);
 
+static void mx_image_cancel_in_progress (MxImage *image);
+static void mx_image_drop_spare_texture (MxImage *image);
+static void mx_image_release_texture (MxImage    *image,
+                                      CoglHandle  texture);
+static gboolean mx_image_set_from_file_internal (MxImage      *image,
+                                                 const gchar  *filename,
+                                                 gint          width,
+                                                 gint          height,
+                                                 GError      **error);
+static void mx_image_stop_animation (MxImage *image);
+
 GQuark
 mx_image_error_quark (void)
 {
   return g_quark_from_static_string ("mx-image-error-quark");
 }
 
+/* the decoded images held by loads that haven't been uploaded yet, which
+ * the worker threads add to */
+static gsize image_async_bytes = 0;
+
+static gsize
+mx_image_pixbuf_get_bytes (GdkPixbuf *pixbuf)
+{
+  return (gsize) gdk_pixbuf_get_rowstride (pixbuf) *
+    gdk_pixbuf_get_height (pixbuf);
+}
+
+gsize
+_mx_image_get_memory_usage (void)
+{
+  return (gsize) g_atomic_pointer_get (&image_async_bytes);
+}
+
 static void
 mx_image_async_data_free (MxImageAsyncData *data)
 {
@@ -168,19 +297,46 @@ mx_image_async_data_free (MxImageAsyncData *data)
     data->free_func (data->buffer);
 
   g_free (data->filename);
+  g_free (data->cache_key);
 
   if (data->idle_handler)
     g_source_remove (data->idle_handler);
 
   if (data->pixbuf)
-    g_object_unref (data->pixbuf);
+    {
+      g_atomic_pointer_add (&image_async_bytes,
+                            -(gssize) mx_image_pixbuf_get_bytes (data->pixbuf));
+      g_object_unref (data->pixbuf);
+    }
 
   if (data->error)
     g_error_free (data->error);
 
+  if (data->texture)
+    cogl_object_unref (data->texture);
+
+  if (data->progress_idle)
+    g_source_remove (data->progress_idle);
+
+  if (data->partial)
+    g_object_unref (data->partial);
+
+  g_mutex_clear (&data->progress_mutex);
+  g_object_unref (data->cancellable);
+
   g_free (data);
 }
 
+/* Marks the load as cancelled. The thread checks the cancellable while
+ * decoding, so that it doesn't finish decoding an image that won't be used.
+ */
+static void
+mx_image_async_data_cancel (MxImageAsyncData *data)
+{
+  data->cancelled = TRUE;
+  g_cancellable_cancel (data->cancellable);
+}
+
 static MxImageAsyncData *
 mx_image_async_data_new (MxImage *parent)
 {
@@ -188,15 +344,158 @@ mx_image_async_data_new (MxImage *parent)
 
   data->parent = parent;
   g_mutex_init (&data->mutex);
+  g_mutex_init (&data->progress_mutex);
+  data->cancellable = g_cancellable_new ();
   data->width = -1;
   data->height = -1;
   data->upscale = parent->priv->upscale;
   data->width_threshold = parent->priv->width_threshold;
   data->height_threshold = parent->priv->height_threshold;
+  data->progressive = parent->priv->progressive;
+  data->thumbnails = parent->priv->use_thumbnails;
 
   return data;
 }
 
+/*
+ * mx_image_get_load_priority:
+ * @image: A #MxImage
+ *
+ * Determines how soon the image will be seen: images that are mapped and
+ * inside the visible area of their scrollable ancestor come first, then
+ * those that are scrolled out of view, then those that aren't mapped.
+ */
+static gint
+mx_image_get_load_priority (MxImage *image)
+{
+  ClutterActor *actor = CLUTTER_ACTOR (image);
+  ClutterActor *view;
+  gfloat x, y, width, height;
+  gfloat view_x, view_y, view_width, view_height;
+
+  if (!CLUTTER_ACTOR_IS_MAPPED (actor))
+    return MX_IMAGE_PRIORITY_UNMAPPED;
+
+  for (view = clutter_actor_get_parent (actor); view;
+       view = clutter_actor_get_parent (view))
+    if (MX_IS_SCROLLABLE (view))
+      break;
+
+  if (!view)
+    return MX_IMAGE_PRIORITY_VISIBLE;
+
+  /* Scrollables move their own contents, so the visible area is the one
+   * of their parent, usually a scroll view.
+   */
+  if (clutter_actor_get_parent (view))
+    view = clutter_actor_get_parent (view);
+
+  clutter_actor_get_transformed_position (actor, &x, &y);
+  clutter_actor_get_transformed_size (actor, &width, &height);
+  clutter_actor_get_transformed_position (view, &view_x, &view_y);
+  clutter_actor_get_transformed_size (view, &view_width, &view_height);
+
+  if (x + width <= view_x || x >= view_x + view_width ||
+      y + height <= view_y || y >= view_y + view_height)
+    return MX_IMAGE_PRIORITY_OFFSCREEN;
+
+  return MX_IMAGE_PRIORITY_VISIBLE;
+}
+
+static void
+mx_image_update_load_priority (MxImage *image)
+{
+  MxImageAsyncData *data = image->priv->async_load_data;
+
+  /* this does nothing once the load has started */
+  if (!data)
+    return;
+
+  mx_worker_pool_set_priority (mx_worker_pool_get_default (), data->job_id,
+                               G_PRIORITY_DEFAULT +
+                               mx_image_get_load_priority (image));
+}
+
+static void
+mx_image_unwatch_visibility (MxImage *image)
+{
+  MxImagePrivate *priv = image->priv;
+
+  if (priv->hadjust)
+    {
+      g_signal_handlers_disconnect_by_func (priv->hadjust,
+                                            mx_image_update_load_priority,
+                                            image);
+      g_object_unref (priv->hadjust);
+      priv->hadjust = NULL;
+    }
+
+  if (priv->vadjust)
+    {
+      g_signal_handlers_disconnect_by_func (priv->vadjust,
+                                            mx_image_update_load_priority,
+                                            image);
+      g_object_unref (priv->vadjust);
+      priv->vadjust = NULL;
+    }
+}
+
+/* follows the scrolling of the image while its load is pending */
+static void
+mx_image_watch_visibility (MxImage *image)
+{
+  MxImagePrivate *priv = image->priv;
+  ClutterActor *parent;
+
+  mx_image_unwatch_visibility (image);
+
+  for (parent = clutter_actor_get_parent (CLUTTER_ACTOR (image)); parent;
+       parent = clutter_actor_get_parent (parent))
+    if (MX_IS_SCROLLABLE (parent))
+      break;
+
+  if (parent)
+    {
+      mx_scrollable_get_adjustments (MX_SCROLLABLE (parent),
+                                     &priv->hadjust, &priv->vadjust);
+
+      if (priv->hadjust)
+        {
+          g_object_ref (priv->hadjust);
+          g_signal_connect_swapped (priv->hadjust, "notify::value",
+                                    G_CALLBACK (mx_image_update_load_priority),
+                                    image);
+        }
+
+      if (priv->vadjust)
+        {
+          g_object_ref (priv->vadjust);
+          g_signal_connect_swapped (priv->vadjust, "notify::value",
+                                    G_CALLBACK (mx_image_update_load_priority),
+                                    image);
+        }
+    }
+
+  mx_image_update_load_priority (image);
+}
+
+static void mx_image_animation_update_playing (MxImageAnimation *animation);
+
+static void
+mx_image_notify_mapped_cb (MxImage *image)
+{
+  /* the image may have been moved to another scrollable */
+  if (image->priv->async_load_data)
+    mx_image_watch_visibility (image);
+
+  /* animations are only played while they can be seen */
+  if (image->priv->animation)
+    mx_image_animation_update_playing (image->priv->animation);
+
+  if (!CLUTTER_ACTOR_IS_MAPPED (image))
+    mx_image_drop_spare_texture (image);
+}
+
 static void
 get_center_coords (CoglHandle  tex,
                    float       rotation,
@@ -458,6 +757,22 @@ mx_image_set_property (GObject      *object,
       mx_image_set_from_file (image, g_value_get_string (value), NULL);
       break;
 
+    case PROP_SHARED_CACHE:
+      mx_image_set_shared_cache (image, g_value_get_boolean (value));
+      break;
+
+    case PROP_PROGRESSIVE:
+      mx_image_set_progressive (image, g_value_get_boolean (value));
+      break;
+
+    case PROP_USE_THUMBNAILS:
+      mx_image_set_use_thumbnails (image, g_value_get_boolean (value));
+      break;
+
+    case PROP_ADAPTIVE_RESOLUTION:
+      mx_image_set_adaptive_resolution (image, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -482,6 +797,22 @@ mx_image_get_property (GObject    *object,
       g_value_set_boolean (value, priv->load_async);
       break;
 
+    case PROP_SHARED_CACHE:
+      g_value_set_boolean (value, priv->shared_cache);
+      break;
+
+    case PROP_PROGRESSIVE:
+      g_value_set_boolean (value, priv->progressive);
+      break;
+
+    case PROP_USE_THUMBNAILS:
+      g_value_set_boolean (value, priv->use_thumbnails);
+      break;
+
+    case PROP_ADAPTIVE_RESOLUTION:
+      g_value_set_boolean (value, priv->adaptive);
+      break;
+
     case PROP_ALLOW_UPSCALE:
       g_value_set_boolean (value, priv->upscale);
       break;
@@ -508,6 +839,90 @@ mx_image_get_property (GObject    *object,
     }
 }
 
+static void
+mx_image_forget_source (MxImage *image)
+{
+  MxImagePrivate *priv = image->priv;
+
+  _mx_timer_stop (&priv->redecode_timer);
+
+  g_free (priv->source_filename);
+  priv->source_filename = NULL;
+}
+
+/* Gets the size an adaptive image would be decoded at now, which is the
+ * size it was asked for, or its content area if that is larger by more
+ * than the scale thresholds. Returns %TRUE if that is larger */
+static gboolean
+mx_image_get_redecode_size (MxImage *image,
+                            gint    *width,
+                            gint    *height)
+{
+  MxImagePrivate *priv = image->priv;
+  ClutterActorBox box, area;
+  gboolean grown = FALSE;
+
+  clutter_actor_get_allocation_box (CLUTTER_ACTOR (image), &box);
+  mx_widget_get_available_area (MX_WIDGET (image), &box, &area);
+
+  *width = priv->source_width;
+  *height = priv->source_height;
+
+  if (priv->source_width >= 0 &&
+      area.x2 - area.x1 > priv->source_width + priv->width_threshold)
+    {
+      *width = ceilf (area.x2 - area.x1);
+      grown = TRUE;
+    }
+
+  if (priv->source_height >= 0 &&
+      area.y2 - area.y1 > priv->source_height + priv->height_threshold)
+    {
+      *height = ceilf (area.y2 - area.y1);
+      grown = TRUE;
+    }
+
+  return grown;
+}
+
+static void
+mx_image_redecode_cb (gpointer data)
+{
+  MxImage *image = data;
+  MxImagePrivate *priv = image->priv;
+  gint width, height;
+  gchar *filename;
+
+  if (!priv->source_filename ||
+      !mx_image_get_redecode_size (image, &width, &height))
+    return;
+
+  filename = g_strdup (priv->source_filename);
+  mx_image_set_from_file_at_size (image, filename, width, height, NULL);
+  g_free (filename);
+}
+
+static void
+mx_image_allocate (ClutterActor           *actor,
+                   const ClutterActorBox  *box,
+                   ClutterAllocationFlags  flags)
+{
+  MxImagePrivate *priv = MX_IMAGE (actor)->priv;
+  gint width, height;
+
+  CLUTTER_ACTOR_CLASS (mx_image_parent_class)->allocate (actor, box, flags);
+
+  /* decoding happens on the worker pool, and shrinking keeps the texture
+   * decoded so far */
+  if (!priv->adaptive || !priv->load_async || !priv->source_filename)
+    return;
+
+  if (mx_image_get_redecode_size (MX_IMAGE (actor), &width, &height))
+    _mx_timer_start (&priv->redecode_timer, REDECODE_DELAY);
+  else
+    _mx_timer_stop (&priv->redecode_timer);
+}
+
 static void
 mx_image_dispose (GObject *object)
 {
@@ -566,11 +981,9 @@ mx_image_dispose (GObject *object)
       priv->template_material = NULL;
     }
 
-  if (priv->async_load_data)
-    {
-      priv->async_load_data->cancelled = TRUE;
-      priv->async_load_data = NULL;
-    }
+  mx_image_cancel_in_progress (MX_IMAGE (object));
+  mx_image_forget_source (MX_IMAGE (object));
+  mx_image_drop_spare_texture (MX_IMAGE (object));
 
   G_OBJECT_CLASS (mx_image_parent_class)->dispose (object);
 }
@@ -590,6 +1003,7 @@ mx_image_class_init (MxImageClass *klass)
   object_class->get_property = mx_image_get_property;
 
   actor_class->paint = mx_image_paint;
+  actor_class->allocate = mx_image_allocate;
   actor_class->get_preferred_width = mx_image_get_preferred_width;
   actor_class->get_preferred_height = mx_image_get_preferred_height;
 
@@ -663,6 +1077,43 @@ mx_image_class_init (MxImageClass *klass)
 
   g_object_class_install_property (object_class, PROP_FILENAME, pspec);
 
+  pspec = g_param_spec_boolean ("shared-cache",
+                                "Shared Cache",
+                                "Whether to share scaled images with other "
+                                "images through the texture cache",
+                                FALSE,
+                                G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_property (object_class, PROP_SHARED_CACHE, pspec);
+
+  pspec = g_param_spec_boolean ("progressive",
+                                "Progressive",
+                                "Whether to show asynchronously loaded "
+                                "images while they are being decoded",
+                                FALSE,
+                                G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_property (object_class, PROP_PROGRESSIVE, pspec);
+
+  pspec = g_param_spec_boolean ("use-thumbnails",
+                                "Use Thumbnails",
+                                "Whether to load images at a size from "
+                                "thumbnails when they are big enough",
+                                FALSE,
+                                G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_property (object_class, PROP_USE_THUMBNAILS, pspec);
+
+  pspec = g_param_spec_boolean ("adaptive-resolution",
+                                "Adaptive Resolution",
+                                "Whether to load images set at a size "
+                                "again when they grow larger",
+                                FALSE,
+                                G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_property (object_class, PROP_ADAPTIVE_RESOLUTION,
+                                   pspec);
+
   /**
    * MxImage::image-loaded:
    * @image: the #MxImage that emitted the signal
@@ -699,6 +1150,8 @@ mx_image_class_init (MxImageClass *klass)
                   G_TYPE_NONE, 1, G_TYPE_ERROR);
 
   mx_image_cache_quark = g_quark_from_static_string ("mx-image-cache");
+  mx_image_premultiplied_quark =
+    g_quark_from_static_string ("mx-image-premultiplied");
 }
 
 static void
@@ -706,7 +1159,6 @@ create_new_material (MxImage *image,
                      gdouble  progress)
 {
   MxImagePrivate *priv = image->priv;
-  CoglHandle copy;
   CoglColor constant;
 
   if (!priv->old_texture)
@@ -714,19 +1166,11 @@ create_new_material (MxImage *image,
       if (priv->material)
         cogl_object_unref (priv->material);
 
-      priv->material = cogl_material_new ();
-      cogl_material_set_layer_wrap_mode (priv->material, 0,
-                                         COGL_MATERIAL_WRAP_MODE_CLAMP_TO_EDGE);
+      priv->material = cogl_material_copy (mx_image_plain_template);
 
       return;
     }
 
-  /* You should assume that a material can only be modified once, after
-   * its creation; if you need to modify it later you should use a copy
-   * instead. Cogl makes copying materials reasonably cheap
-   */
-  copy = cogl_material_copy (priv->material);
-
   /* Create the constant color to be used when combining the two
    * material layers; we use a black color with an alpha component
    * depending on the current progress of the timeline
@@ -734,14 +1178,12 @@ create_new_material (MxImage *image,
   cogl_color_init_from_4ub (&constant, 0x00, 0x00, 0x00, 0xff * progress);
 
   /* This sets the value of the constant color we use when combining
-   * the two layers
+   * the two layers. The material is changed in place, as in
+   * mx_image_paint(): this runs between frames, when it is no longer
+   * referenced by batched geometry, so there is no need for a new copy
+   * each frame.
    */
-  cogl_material_set_layer_combine_constant (copy, 1, &constant);
-
-  if (priv->material)
-    cogl_object_unref (priv->material);
-
-  priv->material = copy;
+  cogl_material_set_layer_combine_constant (priv->material, 1, &constant);
 }
 
 static void
@@ -768,53 +1210,41 @@ timeline_complete (ClutterTimeline *timeline,
 {
   if (image->priv->old_texture)
     {
-      cogl_object_unref (image->priv->old_texture);
+      CoglHandle texture = image->priv->old_texture;
+
       image->priv->old_texture = NULL;
+      mx_image_release_texture (image, texture);
     }
   create_new_material (image, 1.0);
 }
 
 static void
-mx_image_init (MxImage *self)
+mx_image_ensure_templates (void)
 {
-  MxImagePrivate *priv;
   guchar data[4] = { 0, 0, 0, 0 };
 
-  priv = self->priv = MX_IMAGE_GET_PRIVATE (self);
-
-  priv->transition_duration = DEFAULT_DURATION;
-  priv->timeline = clutter_timeline_new (priv->transition_duration);
-  priv->redraw_timeline = clutter_timeline_new (200);
-  clutter_timeline_set_progress_mode (priv->redraw_timeline,
-                                      CLUTTER_EASE_OUT_CUBIC);
-
-  g_signal_connect (priv->timeline, "new-frame", G_CALLBACK (new_frame_cb),
-                    self);
-  g_signal_connect (priv->timeline, "completed", G_CALLBACK (timeline_complete),
-                    self);
-
-  g_signal_connect_swapped (priv->redraw_timeline, "new-frame",
-                            G_CALLBACK (clutter_actor_queue_redraw), self);
+  if (G_LIKELY (mx_image_fade_template))
+    return;
 
-  priv->blank_texture = cogl_texture_new_from_data (1, 1, COGL_TEXTURE_NO_ATLAS,
-                                                    COGL_PIXEL_FORMAT_RGBA_8888,
-                                                    COGL_PIXEL_FORMAT_ANY,
-                                                    1, data);
+  mx_image_blank_texture =
+    cogl_texture_new_from_data (1, 1, COGL_TEXTURE_NO_ATLAS,
+                                COGL_PIXEL_FORMAT_RGBA_8888,
+                                COGL_PIXEL_FORMAT_ANY, 1, data);
 
-  /* set up the initial material */
-  priv->template_material = cogl_material_new ();
+  /* set up the material used during transitions */
+  mx_image_fade_template = cogl_material_new ();
 
-  cogl_material_set_layer (priv->template_material, 1, priv->blank_texture);
-  cogl_material_set_layer (priv->template_material, 0, priv->blank_texture);
+  cogl_material_set_layer (mx_image_fade_template, 1, mx_image_blank_texture);
+  cogl_material_set_layer (mx_image_fade_template, 0, mx_image_blank_texture);
 
-  cogl_material_set_layer_wrap_mode (priv->template_material, 0,
+  cogl_material_set_layer_wrap_mode (mx_image_fade_template, 0,
                                      COGL_MATERIAL_WRAP_MODE_CLAMP_TO_EDGE);
-  cogl_material_set_layer_wrap_mode (priv->template_material, 1,
+  cogl_material_set_layer_wrap_mode (mx_image_fade_template, 1,
                                      COGL_MATERIAL_WRAP_MODE_CLAMP_TO_EDGE);
 
   /* override the default combination description in the first layer so that the
    * paint opacity is not applied to the texture */
-  cogl_material_set_layer_combine (priv->template_material, 0,
+  cogl_material_set_layer_combine (mx_image_fade_template, 0,
                                    "RGBA = REPLACE (TEXTURE)",
                                    NULL);
 
@@ -825,17 +1255,54 @@ mx_image_init (MxImage *self)
    * current one, using the alpha component of a constant color as
    * the interpolation factor.
    */
-  cogl_material_set_layer_combine (priv->template_material, 1,
+  cogl_material_set_layer_combine (mx_image_fade_template, 1,
                                    "RGBA = INTERPOLATE (PREVIOUS, "
                                                        "TEXTURE, "
                                                        "CONSTANT[A])",
                                    NULL);
 
   /* apply the paint opacity */
-  cogl_material_set_layer_combine (priv->template_material, 2,
+  cogl_material_set_layer_combine (mx_image_fade_template, 2,
                                    "RGBA = MODULATE (PREVIOUS, CONSTANT[A])",
                                    NULL);
 
+  /* once the transition is over, only the new texture is drawn */
+  mx_image_plain_template = cogl_material_new ();
+  cogl_material_set_layer_wrap_mode (mx_image_plain_template, 0,
+                                     COGL_MATERIAL_WRAP_MODE_CLAMP_TO_EDGE);
+}
+
+static void
+mx_image_init (MxImage *self)
+{
+  MxImagePrivate *priv;
+
+  priv = self->priv = MX_IMAGE_GET_PRIVATE (self);
+
+  priv->transition_duration = DEFAULT_DURATION;
+  priv->timeline = clutter_timeline_new (priv->transition_duration);
+  priv->redraw_timeline = clutter_timeline_new (200);
+  clutter_timeline_set_progress_mode (priv->redraw_timeline,
+                                      CLUTTER_EASE_OUT_CUBIC);
+
+  g_signal_connect (priv->timeline, "new-frame", G_CALLBACK (new_frame_cb),
+                    self);
+  g_signal_connect (priv->timeline, "completed", G_CALLBACK (timeline_complete),
+                    self);
+
+  g_signal_connect_swapped (priv->redraw_timeline, "new-frame",
+                            G_CALLBACK (clutter_actor_queue_redraw), self);
+
+  g_signal_connect (self, "notify::mapped",
+                    G_CALLBACK (mx_image_notify_mapped_cb), NULL);
+
+  _mx_timer_init (&priv->redecode_timer, mx_image_redecode_cb, self);
+
+  mx_image_ensure_templates ();
+
+  priv->blank_texture = cogl_object_ref (mx_image_blank_texture);
+  priv->template_material = cogl_object_ref (mx_image_fade_template);
+
   /* set the transparent texture to start from */
   mx_image_clear (self);
 }
@@ -961,6 +1428,25 @@ mx_image_prepare_texture (MxImage  *image)
   clutter_actor_queue_relayout (CLUTTER_ACTOR (image));
 }
 
+/* Replaces the texture of @image by @texture, starting the transition */
+static void
+mx_image_show_texture (MxImage    *image,
+                       CoglHandle  texture)
+{
+  MxImagePrivate *priv = image->priv;
+  CoglHandle released = priv->old_texture;
+
+  priv->old_texture = priv->texture;
+  priv->old_rotation = priv->rotation;
+  priv->old_mode = priv->mode;
+  priv->texture = cogl_object_ref (texture);
+
+  if (released)
+    mx_image_release_texture (image, released);
+
+  mx_image_prepare_texture (image);
+}
+
 static void
 mx_image_cancel_in_progress (MxImage *image)
 {
@@ -969,9 +1455,14 @@ mx_image_cancel_in_progress (MxImage *image)
   /* Cancel any asynchronous image load */
   if (priv->async_load_data)
     {
-      priv->async_load_data->cancelled = TRUE;
+      mx_image_async_data_cancel (priv->async_load_data);
       priv->async_load_data = NULL;
     }
+
+  mx_image_unwatch_visibility (image);
+
+  /* any other image replaces the animation */
+  mx_image_stop_animation (image);
 }
 
 /**
@@ -990,6 +1481,8 @@ mx_image_clear (MxImage *image)
   MxImagePrivate *priv = image->priv;
 
   mx_image_cancel_in_progress (image);
+  mx_image_forget_source (image);
+  mx_image_drop_spare_texture (image);
 
   if (priv->texture)
     cogl_object_unref (priv->texture);
@@ -1015,16 +1508,196 @@ mx_image_clear (MxImage *image)
 }
 
 /*
- * mx_image_set_from_data_internal:
- * @image: An #MxImage
- * @data: Image data, or %NULL
- * @uri: A local file path / URI, or %NULL
- * @use_cache: Whether the texture cache should be used
- * @pixel_format: The #CoglPixelFormat of the buffer
- * @width: Width in pixels of image data.
- * @height: Height in pixels of image data
- * @rowstride: Distance in bytes between row starts.
- * @error: Return location for a #GError, or #NULL
+ * mx_image_new_texture:
+ * @width: The width of the image
+ * @height: The height of the image
+ * @error: A pointer to a #GError, or %NULL
+ *
+ * Creates a texture for an image of the given size, with a transparent
+ * border of one pixel around the area where the image is to be uploaded.
+ *
+ * Returns: The new texture, or %NULL on failure
+ */
+static CoglHandle
+mx_image_new_texture (gint     width,
+                      gint     height,
+                      GError **error)
+{
+  CoglHandle texture;
+  gint *blank_area;
+  gint64 start;
+
+  start = _mx_frame_stats_begin (MX_FRAME_STATS_TEXTURE_UPLOAD);
+
+  texture = cogl_texture_new_with_size (width + 2, height + 2,
+                                        COGL_TEXTURE_NO_ATLAS,
+                                        COGL_PIXEL_FORMAT_ANY);
+
+  if (!texture)
+    {
+      _mx_frame_stats_end (MX_FRAME_STATS_TEXTURE_UPLOAD, start);
+      g_set_error (error, MX_IMAGE_ERROR, MX_IMAGE_ERROR_BAD_FORMAT,
+                   "Failed to create Cogl texture");
+      return NULL;
+    }
+
+  /* Blit a transparent buffer around the texture */
+  blank_area = g_new0 (gint, MAX (width, height) + 2);
+  cogl_texture_set_region (texture, 0, 0, 0, 0,
+                           width, 1, width, 1,
+                           COGL_PIXEL_FORMAT_RGBA_8888, (width + 2) * 4,
+                           (const guint8 *)blank_area);
+  cogl_texture_set_region (texture, 0, 0, 0, height + 1,
+                           width + 2, 1, width + 2, 1,
+                           COGL_PIXEL_FORMAT_RGBA_8888, (width + 2) * 4,
+                           (const guint8 *)blank_area);
+  cogl_texture_set_region (texture, 0, 0, 0, 0,
+                           1, height + 2, 1, height + 2,
+                           COGL_PIXEL_FORMAT_RGBA_8888, 4,
+                           (const guint8 *)blank_area);
+  cogl_texture_set_region (texture, 0, 0, width + 1, 0,
+                           1, height + 2, 1, height + 2,
+                           COGL_PIXEL_FORMAT_RGBA_8888, 4,
+                           (const guint8 *)blank_area);
+  g_free (blank_area);
+
+  _mx_frame_stats_end (MX_FRAME_STATS_TEXTURE_UPLOAD, start);
+
+  return texture;
+}
+
+static void
+mx_image_drop_spare_texture (MxImage *image)
+{
+  MxImagePrivate *priv = image->priv;
+
+  if (priv->spare_texture)
+    {
+      cogl_object_unref (priv->spare_texture);
+      priv->spare_texture = NULL;
+    }
+}
+
+/* Gets a texture for an image of the given size, like
+ * mx_image_new_texture(), reusing the spare texture if it is the right
+ * size, as when showing the pictures of a slideshow. The texture is only
+ * held by @image, until mx_image_share_texture() says otherwise. */
+static CoglHandle
+mx_image_get_texture (MxImage  *image,
+                      gint      width,
+                      gint      height,
+                      GError  **error)
+{
+  MxImagePrivate *priv = image->priv;
+  CoglHandle texture;
+
+  if (priv->spare_texture &&
+      cogl_texture_get_width (priv->spare_texture) == width + 2 &&
+      cogl_texture_get_height (priv->spare_texture) == height + 2)
+    {
+      /* the transparent border is still there, as only the area within
+       * it is ever uploaded to */
+      texture = priv->spare_texture;
+      priv->spare_texture = NULL;
+
+      return texture;
+    }
+
+  mx_image_drop_spare_texture (image);
+
+  texture = mx_image_new_texture (width, height, error);
+  if (texture)
+    cogl_object_set_user_data (COGL_OBJECT (texture),
+                               &mx_image_private_texture_key,
+                               GINT_TO_POINTER (TRUE), NULL);
+
+  return texture;
+}
+
+/* Drops the reference of @image to @texture, keeping it as the spare
+ * texture if nothing else holds it */
+static void
+mx_image_release_texture (MxImage    *image,
+                          CoglHandle  texture)
+{
+  MxImagePrivate *priv = image->priv;
+
+  if (!priv->spare_texture &&
+      texture != priv->texture && texture != priv->old_texture &&
+      cogl_object_get_user_data (COGL_OBJECT (texture),
+                                 &mx_image_private_texture_key) &&
+      CLUTTER_ACTOR_IS_MAPPED (image))
+    priv->spare_texture = texture;
+  else
+    cogl_object_unref (texture);
+}
+
+/* Pixbufs hold unpremultiplied pixels, which Cogl would premultiply into
+ * a copy when uploading them. The pixbufs decoded by images are
+ * premultiplied where they are decoded instead, on the worker pool for
+ * asynchronous loads, so that they are uploaded as they are. */
+static void
+mx_image_pixbuf_premultiply (GdkPixbuf *pixbuf)
+{
+  gint width, height, rowstride, x, y;
+  guchar *pixels;
+
+  if (!pixbuf || !gdk_pixbuf_get_has_alpha (pixbuf) ||
+      gdk_pixbuf_get_bits_per_sample (pixbuf) != 8 ||
+      gdk_pixbuf_get_colorspace (pixbuf) != GDK_COLORSPACE_RGB ||
+      gdk_pixbuf_get_n_channels (pixbuf) != 4)
+    return;
+
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+
+  for (y = 0; y < height; y++)
+    {
+      guchar *p = pixels + y * rowstride;
+
+      for (x = 0; x < width; x++, p += 4)
+        {
+          guint alpha = p[3];
+
+          if (alpha == 0xff)
+            continue;
+
+          /* v * a / 255, rounded, without dividing */
+          p[0] = (p[0] * alpha + 128 + ((p[0] * alpha + 128) >> 8)) >> 8;
+          p[1] = (p[1] * alpha + 128 + ((p[1] * alpha + 128) >> 8)) >> 8;
+          p[2] = (p[2] * alpha + 128 + ((p[2] * alpha + 128) >> 8)) >> 8;
+        }
+    }
+
+  g_object_set_qdata (G_OBJECT (pixbuf), mx_image_premultiplied_quark,
+                      GINT_TO_POINTER (TRUE));
+}
+
+static CoglPixelFormat
+mx_image_pixbuf_get_format (GdkPixbuf *pixbuf)
+{
+  if (!gdk_pixbuf_get_has_alpha (pixbuf))
+    return COGL_PIXEL_FORMAT_RGB_888;
+
+  if (g_object_get_qdata (G_OBJECT (pixbuf), mx_image_premultiplied_quark))
+    return COGL_PIXEL_FORMAT_RGBA_8888_PRE;
+
+  return COGL_PIXEL_FORMAT_RGBA_8888;
+}
+
+/*
+ * mx_image_set_from_data_internal:
+ * @image: An #MxImage
+ * @data: Image data, or %NULL
+ * @uri: A local file path / URI, or %NULL
+ * @use_cache: Whether the texture cache should be used
+ * @pixel_format: The #CoglPixelFormat of the buffer
+ * @width: Width in pixels of image data.
+ * @height: Height in pixels of image data
+ * @rowstride: Distance in bytes between row starts.
+ * @error: Return location for a #GError, or #NULL
  *
  * Set the image data from a buffer. In case of failure, #FALSE is returned
  * and @error is set. If @data is %NULL, the image will be loaded from the
@@ -1045,7 +1718,8 @@ mx_image_set_from_data_internal (MxImage          *image,
 {
   MxImagePrivate *priv;
   MxTextureCache *cache;
-  CoglHandle old_texture;
+  CoglHandle old_texture, released;
+  gint64 start;
 
   if (G_UNLIKELY (!MX_IS_IMAGE (image)))
     {
@@ -1081,46 +1755,21 @@ mx_image_set_from_data_internal (MxImage          *image,
     }
   else
     {
-      gint *blank_area;
-
-      priv->texture = cogl_texture_new_with_size (width + 2, height + 2,
-                                                  COGL_TEXTURE_NO_ATLAS,
-                                                  COGL_PIXEL_FORMAT_ANY);
+      priv->texture = uri ? mx_image_new_texture (width, height, error) :
+        mx_image_get_texture (image, width, height, error);
 
       if (!priv->texture)
         {
           priv->texture = old_texture;
-
-          g_set_error (error, MX_IMAGE_ERROR, MX_IMAGE_ERROR_BAD_FORMAT,
-                       "Failed to create Cogl texture");
-
           return FALSE;
         }
 
       /* Create the new texture */
+      start = _mx_frame_stats_begin (MX_FRAME_STATS_TEXTURE_UPLOAD);
       cogl_texture_set_region (priv->texture, 0, 0, 1, 1,
                                width, height, width, height,
                                pixel_format, rowstride, data);
-
-      /* Blit a transparent buffer around the texture */
-      blank_area = g_new0 (gint, MAX (width, height) + 2);
-      cogl_texture_set_region (priv->texture, 0, 0, 0, 0,
-                               width, 1, width, 1,
-                               COGL_PIXEL_FORMAT_RGBA_8888, (width + 2) * 4,
-                               (const guint8 *)blank_area);
-      cogl_texture_set_region (priv->texture, 0, 0, 0, height + 1,
-                               width + 2, 1, width + 2, 1,
-                               COGL_PIXEL_FORMAT_RGBA_8888, (width + 2) * 4,
-                               (const guint8 *)blank_area);
-      cogl_texture_set_region (priv->texture, 0, 0, 0, 0,
-                               1, height + 2, 1, height + 2,
-                               COGL_PIXEL_FORMAT_RGBA_8888, 4,
-                               (const guint8 *)blank_area);
-      cogl_texture_set_region (priv->texture, 0, 0, width + 1, 0,
-                               1, height + 2, 1, height + 2,
-                               COGL_PIXEL_FORMAT_RGBA_8888, 4,
-                               (const guint8 *)blank_area);
-      g_free (blank_area);
+      _mx_frame_stats_end (MX_FRAME_STATS_TEXTURE_UPLOAD, start);
 
       /* Insert the processed image into the cache, if we have a URI */
       if (uri)
@@ -1132,13 +1781,15 @@ mx_image_set_from_data_internal (MxImage          *image,
     }
 
   /* Replace the old texture */
-  if (priv->old_texture)
-    cogl_object_unref (priv->old_texture);
+  released = priv->old_texture;
 
   priv->old_texture = old_texture;
   priv->old_rotation = priv->rotation;
   priv->old_mode = priv->mode;
 
+  if (released)
+    mx_image_release_texture (image, released);
+
   mx_image_prepare_texture (image);
 
   return TRUE;
@@ -1178,6 +1829,8 @@ mx_image_set_from_data (MxImage          *image,
       return FALSE;
     }
 
+  mx_image_forget_source (image);
+
   return mx_image_set_from_data_internal (image, data, NULL, FALSE,
                                           pixel_format, width, height,
                                           rowstride, error);
@@ -1203,6 +1856,7 @@ mx_image_set_from_pixbuf (MxImage      *image,
 {
   gboolean has_alpha;
   MxTextureCache *cache;
+  CoglPixelFormat format;
   gint width, height, rowstride;
 
   if (G_UNLIKELY (!MX_IS_IMAGE (image)))
@@ -1253,6 +1907,8 @@ mx_image_set_from_pixbuf (MxImage      *image,
           g_object_unref (pixbuf);
           return FALSE;
         }
+
+      format = mx_image_pixbuf_get_format (pixbuf);
     }
   else
     {
@@ -1260,41 +1916,454 @@ mx_image_set_from_pixbuf (MxImage      *image,
        * but they won't be accessed if the pixbuf is NULL.
        */
       width = height = rowstride = -1;
-      has_alpha = TRUE;
+      format = COGL_PIXEL_FORMAT_RGBA_8888;
     }
 
   return
     mx_image_set_from_data_internal (image,
                                  pixbuf ? gdk_pixbuf_get_pixels (pixbuf) : NULL,
-                                 filename, TRUE,
-                                 has_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 :
-                                             COGL_PIXEL_FORMAT_RGB_888,
+                                 filename, TRUE, format,
                                  width, height, rowstride, error);
 }
 
+/*
+ * Images with the #MxImage:shared-cache property set share their processed
+ * textures through the texture cache, as metadata of the file (or of a key
+ * made from the hash of the buffer) identified by the loading parameters.
+ */
+static gpointer
+mx_image_get_shared_cache_ident (MxImage *image,
+                                 gint     width,
+                                 gint     height)
+{
+  MxImagePrivate *priv = image->priv;
+  GQuark quark;
+  gchar *name;
+
+  name = g_strdup_printf ("mx-image-cache-%dx%d-%u-%ux%u-%u", width, height,
+                          priv->upscale, priv->width_threshold,
+                          priv->height_threshold, priv->use_thumbnails);
+  quark = g_quark_from_string (name);
+  g_free (name);
+
+  return GUINT_TO_POINTER (quark);
+}
+
+static gchar *
+mx_image_get_buffer_cache_key (const guchar *buffer,
+                               gsize         count)
+{
+  gchar *checksum, *key;
+
+  checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, buffer, count);
+  key = g_strconcat ("mx-image-buffer://", checksum, NULL);
+  g_free (checksum);
+
+  return key;
+}
+
 static gboolean
-mx_image_load_complete_cb (gpointer task_data)
+mx_image_set_from_shared_cache (MxImage     *image,
+                                const gchar *key,
+                                gpointer     ident)
+{
+  CoglHandle texture;
+
+  texture =
+    mx_texture_cache_get_meta_cogl_texture (mx_texture_cache_get_default (),
+                                            key, ident);
+  if (!texture)
+    return FALSE;
+
+  mx_image_cancel_in_progress (image);
+
+  mx_image_show_texture (image, texture);
+  cogl_object_unref (texture);
+
+  return TRUE;
+}
+
+static void
+mx_image_share_texture (MxImage     *image,
+                        const gchar *key,
+                        gpointer     ident)
+{
+  cogl_object_set_user_data (COGL_OBJECT (image->priv->texture),
+                             &mx_image_private_texture_key, NULL, NULL);
+
+  mx_texture_cache_insert_meta (mx_texture_cache_get_default (), key, ident,
+                                image->priv->texture, NULL);
+}
+
+/* Decoded images bigger than this are uploaded in slices of about this
+ * many bytes, one per main loop iteration, so that uploading them doesn't
+ * hold up a frame.
+ */
+#define MX_IMAGE_UPLOAD_SLICE_SIZE (4 * 1024 * 1024)
+
+static gboolean
+mx_image_upload_cb (gpointer task_data)
 {
   MxImageAsyncData *data = task_data;
+  MxImagePrivate *priv;
+  const guchar *pixels;
+  gint width, height, rowstride, rows;
+  gint64 start;
+
+  if (data->cancelled)
+    {
+      data->idle_handler = 0;
+      mx_image_async_data_free (data);
+      return FALSE;
+    }
+
+  width = gdk_pixbuf_get_width (data->pixbuf);
+  height = gdk_pixbuf_get_height (data->pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (data->pixbuf);
+  pixels = gdk_pixbuf_get_pixels (data->pixbuf);
+
+  rows = MAX (1, MX_IMAGE_UPLOAD_SLICE_SIZE / rowstride);
+  rows = MIN (rows, height - data->upload_row);
+
+  start = _mx_frame_stats_begin (MX_FRAME_STATS_TEXTURE_UPLOAD);
+  cogl_texture_set_region (data->texture, 0, 0, 1, data->upload_row + 1,
+                           width, rows, width, rows,
+                           mx_image_pixbuf_get_format (data->pixbuf),
+                           rowstride, pixels + data->upload_row * rowstride);
+  _mx_frame_stats_end (MX_FRAME_STATS_TEXTURE_UPLOAD, start);
+
+  data->upload_row += rows;
+  if (data->upload_row < height)
+    return TRUE;
+
+  /* The whole image is uploaded, show it */
+  data->idle_handler = 0;
+
+  priv = data->parent->priv;
+  priv->async_load_data = NULL;
+  mx_image_unwatch_visibility (data->parent);
+
+  /* progressive loads are already showing the texture */
+  if (priv->texture != data->texture)
+    mx_image_show_texture (data->parent, data->texture);
+  else
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (data->parent));
+
+  /* Unscaled images are cached under the file name, as in
+   * mx_image_set_from_data_internal() */
+  if (data->filename && data->width == -1 && data->height == -1)
+    {
+      cogl_object_set_user_data (COGL_OBJECT (priv->texture),
+                                 &mx_image_private_texture_key, NULL, NULL);
+      mx_texture_cache_insert_meta (mx_texture_cache_get_default (),
+                                    data->filename,
+                                    GINT_TO_POINTER (mx_image_cache_quark),
+                                    priv->texture, NULL);
+    }
+
+  if (data->cache_key)
+    mx_image_share_texture (data->parent, data->cache_key, data->cache_ident);
+
+  g_signal_emit (data->parent, signals[IMAGE_LOADED], 0);
+
+  mx_image_async_data_free (data);
+
+  return FALSE;
+}
+
+/* Whether @pixbuf is in a format that can be uploaded as it is */
+static gboolean
+mx_image_pixbuf_is_supported (GdkPixbuf *pixbuf)
+{
+  return ((gdk_pixbuf_get_bits_per_sample (pixbuf) == 8) &&
+          (gdk_pixbuf_get_colorspace (pixbuf) == GDK_COLORSPACE_RGB) &&
+          (gdk_pixbuf_get_n_channels (pixbuf) ==
+           (gdk_pixbuf_get_has_alpha (pixbuf) ? 4 : 3)));
+}
+
+/* Starts uploading the decoded image of @data in slices, if it is big
+ * enough to need it, or if part of it is shown already. The load stays in
+ * progress until the upload is done, so it is cancelled like any other.
+ */
+static gboolean
+mx_image_start_upload (MxImageAsyncData *data)
+{
+  GdkPixbuf *pixbuf = data->pixbuf;
+  gint width, height;
+
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+
+  if (!data->texture &&
+      (gsize) gdk_pixbuf_get_rowstride (pixbuf) * height <=
+      MX_IMAGE_UPLOAD_SLICE_SIZE)
+    return FALSE;
+
+  /* Unsupported formats are reported by mx_image_set_from_pixbuf() */
+  if (!mx_image_pixbuf_is_supported (pixbuf))
+    return FALSE;
+
+  if (!data->texture)
+    data->texture = mx_image_get_texture (data->parent, width, height, NULL);
+  if (!data->texture)
+    return FALSE;
+
+  data->upload_row = 0;
+  data->idle_handler =
+    clutter_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE,
+                                   mx_image_upload_cb, data, NULL);
+
+  return TRUE;
+}
+
+static void
+mx_image_free_pixels (guchar   *pixels,
+                      gpointer  destroy)
+{
+  if (destroy)
+    ((GDestroyNotify) destroy) (pixels);
+}
+
+/**
+ * mx_image_set_from_data_full:
+ * @image: An #MxImage
+ * @data: (array) (transfer full): Image data
+ * @pixel_format: The #CoglPixelFormat of the buffer, either
+ *   %COGL_PIXEL_FORMAT_RGBA_8888 or %COGL_PIXEL_FORMAT_RGB_888
+ * @width: Width in pixels of image data.
+ * @height: Height in pixels of image data
+ * @rowstride: Distance in bytes between row starts.
+ * @destroy: (allow-none): A function to free @data, or %NULL
+ * @error: Return location for a #GError, or #NULL
+ *
+ * Set the image data from a buffer, like mx_image_set_from_data(), taking
+ * ownership of @data instead of copying it. The data is uploaded straight
+ * from @data in the main loop, over several frames for large images, and
+ * @destroy is called once that's done or the image is replaced.
+ *
+ * The #MxImage::image-loaded signal is emitted when the image is shown. In
+ * case of failure, #FALSE is returned, @error is set and @data is left to
+ * the caller.
+ *
+ * Returns: #TRUE if the image started uploading
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_image_set_from_data_full (MxImage          *image,
+                             guchar           *data,
+                             CoglPixelFormat   pixel_format,
+                             gint              width,
+                             gint              height,
+                             gint              rowstride,
+                             GDestroyNotify    destroy,
+                             GError          **error)
+{
+  MxImageAsyncData *async_data;
+  CoglHandle texture;
+
+  if (G_UNLIKELY (!MX_IS_IMAGE (image)))
+    {
+      g_set_error (error, MX_IMAGE_ERROR,
+                   MX_IMAGE_ERROR_INVALID_PARAMETER,
+                   "image parameter is not a MxImage");
+      return FALSE;
+    }
+
+  mx_image_forget_source (image);
+
+  /* the formats that can be uploaded in slices, see mx_image_upload_cb() */
+  if (pixel_format != COGL_PIXEL_FORMAT_RGBA_8888 &&
+      pixel_format != COGL_PIXEL_FORMAT_RGB_888)
+    {
+      g_set_error (error, MX_IMAGE_ERROR, MX_IMAGE_ERROR_BAD_FORMAT,
+                   "Unsupported pixel format");
+      return FALSE;
+    }
+
+  texture = mx_image_new_texture (width, height, error);
+  if (!texture)
+    return FALSE;
+
+  mx_image_cancel_in_progress (image);
 
-  /* Lock/unlock mutex to make sure the thread is finished. This is necessary
-   * as it's possible that this idle handler will run before the thread unlocks
-   * the mutex, and freeing a locked mutex results in undefined behaviour
-   * (well, it crashes on Linux with an assert in pthreads...)
+  /* The data is wrapped rather than copied, and uploaded like a decoded
+   * image. The texture is already there, so it always goes in slices.
    */
-  g_mutex_lock (&data->mutex);
-  g_mutex_unlock (&data->mutex);
+  async_data = mx_image_async_data_new (image);
+  async_data->pixbuf =
+    gdk_pixbuf_new_from_data (data, GDK_COLORSPACE_RGB,
+                              pixel_format == COGL_PIXEL_FORMAT_RGBA_8888,
+                              8, width, height, rowstride,
+                              mx_image_free_pixels, destroy);
+  g_atomic_pointer_add (&image_async_bytes,
+                        mx_image_pixbuf_get_bytes (async_data->pixbuf));
+  async_data->texture = texture;
+  async_data->complete = TRUE;
+
+  image->priv->async_load_data = async_data;
+  mx_image_start_upload (async_data);
+
+  return TRUE;
+}
+
+/* how often progressive loads show what has been decoded, in
+ * microseconds */
+#define MX_IMAGE_PROGRESS_INTERVAL (G_USEC_PER_SEC / 10)
+
+/* back in the main thread, with the rows decoded since the last time */
+static gboolean
+mx_image_progress_cb (gpointer task_data)
+{
+  MxImageAsyncData *data = task_data;
+  GdkPixbuf *partial;
+  gboolean whole;
+  gint y, width, height;
+  gint64 start;
+
+  g_mutex_lock (&data->progress_mutex);
+  partial = data->partial;
+  y = data->partial_y;
+  whole = data->partial_whole;
+  data->partial = NULL;
+  data->progress_idle = 0;
+  g_mutex_unlock (&data->progress_mutex);
+
+  if (data->cancelled || !partial ||
+      !mx_image_pixbuf_is_supported (partial))
+    goto out;
+
+  width = gdk_pixbuf_get_width (partial);
+  height = gdk_pixbuf_get_height (partial);
+
+  /* the first partial result is the whole image */
+  if (!data->texture)
+    {
+      if (!whole)
+        goto out;
+
+      data->texture = mx_image_new_texture (width, height, NULL);
+      if (!data->texture)
+        goto out;
+    }
+
+  start = _mx_frame_stats_begin (MX_FRAME_STATS_TEXTURE_UPLOAD);
+  cogl_texture_set_region (data->texture, 0, 0, 1, y + 1,
+                           width, height, width, height,
+                           gdk_pixbuf_get_has_alpha (partial) ?
+                           COGL_PIXEL_FORMAT_RGBA_8888 :
+                           COGL_PIXEL_FORMAT_RGB_888,
+                           gdk_pixbuf_get_rowstride (partial),
+                           gdk_pixbuf_get_pixels (partial));
+  _mx_frame_stats_end (MX_FRAME_STATS_TEXTURE_UPLOAD, start);
+
+  if (data->parent->priv->texture != data->texture)
+    mx_image_show_texture (data->parent, data->texture);
+  else
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (data->parent));
+
+out:
+  if (partial)
+    g_object_unref (partial);
+
+  return FALSE;
+}
+
+/* Runs on the thread, as the loader decodes rows. At most every
+ * MX_IMAGE_PROGRESS_INTERVAL, and once the main thread has taken the last
+ * one, a copy of the rows that changed is handed over to be shown.
+ */
+static void
+mx_image_area_updated_cb (GdkPixbufLoader *loader,
+                          gint             x,
+                          gint             y,
+                          gint             width,
+                          gint             height,
+                          gpointer         user_data)
+{
+  MxImageAsyncData *data = user_data;
+  GdkPixbuf *pixbuf, *rows;
+  gint64 now;
+
+  if (data->dirty_y2 > data->dirty_y1)
+    {
+      data->dirty_y1 = MIN (data->dirty_y1, y);
+      data->dirty_y2 = MAX (data->dirty_y2, y + height);
+    }
+  else
+    {
+      data->dirty_y1 = y;
+      data->dirty_y2 = y + height;
+    }
+
+  now = g_get_monotonic_time ();
+  if (now - data->last_progress < MX_IMAGE_PROGRESS_INTERVAL)
+    return;
+
+  g_mutex_lock (&data->progress_mutex);
+
+  if (!data->partial)
+    {
+      pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+
+      /* the texture is created from the first one */
+      data->partial_whole = !data->partial_sent;
+      data->partial_sent = TRUE;
+      if (data->partial_whole)
+        {
+          data->dirty_y1 = 0;
+          data->dirty_y2 = gdk_pixbuf_get_height (pixbuf);
+        }
+
+      rows = gdk_pixbuf_new_subpixbuf (pixbuf, 0, data->dirty_y1,
+                                       gdk_pixbuf_get_width (pixbuf),
+                                       data->dirty_y2 - data->dirty_y1);
+      data->partial = gdk_pixbuf_copy (rows);
+      data->partial_y = data->dirty_y1;
+      g_object_unref (rows);
+
+      data->dirty_y1 = data->dirty_y2 = 0;
+      data->last_progress = now;
+
+      if (!data->progress_idle)
+        data->progress_idle =
+          clutter_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE,
+                                         mx_image_progress_cb, data, NULL);
+    }
 
-  /* Reset the idle handler id so we don't try to remove it when we free
-   * the data later on.
+  g_mutex_unlock (&data->progress_mutex);
+}
+
+/* called in the main loop by the worker pool, once the thread is done
+ * with the data */
+static void
+mx_image_load_complete_cb (gpointer task_data)
+{
+  MxImageAsyncData *data = task_data;
+
+  /* The whole image is uploaded below, so partial results still to be
+   * shown are out of date. The thread is done, so no more will come.
    */
-  data->idle_handler = 0;
+  if (data->progress_idle)
+    {
+      g_source_remove (data->progress_idle);
+      data->progress_idle = 0;
+    }
+  if (data->partial)
+    {
+      g_object_unref (data->partial);
+      data->partial = NULL;
+    }
 
   /* Don't do anything with the image data if we've been cancelled already */
   if (!data->cancelled && data->complete)
     {
+      if (data->pixbuf && mx_image_start_upload (data))
+        return;
+
       /* Reset the current async image load data pointer */
       data->parent->priv->async_load_data = NULL;
+      mx_image_unwatch_visibility (data->parent);
 
       /* If we managed to load the pixbuf, set it now, otherwise forward the
        * error on to the user via a signal.
@@ -1305,7 +2374,11 @@ mx_image_load_complete_cb (gpointer task_data)
           gboolean resized = (data->width != -1 || data->height != -1);
           gboolean success =
             mx_image_set_from_pixbuf (data->parent, data->pixbuf,
-                                      resized ? data->filename : NULL, &error);
+                                      resized ? NULL : data->filename, &error);
+
+          if (success && data->cache_key)
+            mx_image_share_texture (data->parent, data->cache_key,
+                                    data->cache_ident);
 
           if (success)
             g_signal_emit (data->parent, signals[IMAGE_LOADED], 0);
@@ -1321,9 +2394,10 @@ mx_image_load_complete_cb (gpointer task_data)
 
   /* Free the async loading struct */
   mx_image_async_data_free (data);
+}
 
-  return FALSE;
-}
+/* how much encoded data is given to the loader at a time */
+#define MX_IMAGE_LOAD_CHUNK_SIZE (64 * 1024)
 
 typedef struct
 {
@@ -1335,15 +2409,16 @@ typedef struct
   gboolean scaled;
 } MxImageSizeRequest;
 
-static void
-mx_image_size_prepared_cb (GdkPixbufLoader *loader,
-                           gint             width,
-                           gint             height,
-                           gpointer         user_data)
+/* Works out whether an image of @width x @height is scaled to the width
+ * or to the height asked for in @constraints. Returns %FALSE if it isn't
+ * to be scaled at all.
+ */
+static gboolean
+mx_image_get_fit (MxImageSizeRequest *constraints,
+                  gint                width,
+                  gint                height,
+                  gboolean           *fit_width)
 {
-  gboolean fit_width;
-  MxImageSizeRequest *constraints = user_data;
-
   if (constraints->width >= 0)
     {
       if (constraints->height >= 0)
@@ -1351,43 +2426,97 @@ mx_image_size_prepared_cb (GdkPixbufLoader *loader,
           gfloat aspect = constraints->width / (gfloat)constraints->height;
           gfloat aspect_orig = width / (gfloat)height;
 
-          fit_width = (aspect_orig < aspect);
+          *fit_width = (aspect_orig < aspect);
         }
       else
-        fit_width = TRUE;
+        *fit_width = TRUE;
     }
   else if (constraints->height >= 0)
-    fit_width = FALSE;
+    *fit_width = FALSE;
   else
-    return;
+    return FALSE;
+
+  return TRUE;
+}
+
+/* Works out the size an image of @width x @height is scaled to under
+ * @constraints. Returns %FALSE if it's left at its own size. */
+static gboolean
+mx_image_get_scaled_size (MxImageSizeRequest *constraints,
+                          gint                width,
+                          gint                height,
+                          gint               *scaled_width,
+                          gint               *scaled_height)
+{
+  gboolean fit_width;
+
+  if (!mx_image_get_fit (constraints, width, height, &fit_width))
+    return FALSE;
 
   if (fit_width)
     {
       if (!constraints->upscale && (width < constraints->width))
-        return;
+        return FALSE;
 
       if (ABS (width - constraints->width) < constraints->width_threshold)
-        return;
+        return FALSE;
 
-      gdk_pixbuf_loader_set_size (loader, constraints->width,
-                                  (constraints->width / (gfloat)width) *
-                                  (gfloat)height);
-      constraints->scaled = TRUE;
+      *scaled_width = constraints->width;
+      *scaled_height = (constraints->width / (gfloat)width) * (gfloat)height;
     }
   else
     {
       if (!constraints->upscale && (height < constraints->height))
-        return;
+        return FALSE;
 
       if (ABS (height - constraints->height) < constraints->height_threshold)
-        return;
+        return FALSE;
 
-      gdk_pixbuf_loader_set_size (loader,
-                                  (constraints->height / (gfloat)height) *
-                                  (gfloat)width,
-                                  constraints->height);
-      constraints->scaled = TRUE;
+      *scaled_width = (constraints->height / (gfloat)height) * (gfloat)width;
+      *scaled_height = constraints->height;
     }
+
+  return TRUE;
+}
+
+static void
+mx_image_size_prepared_cb (GdkPixbufLoader *loader,
+                           gint             width,
+                           gint             height,
+                           gpointer         user_data)
+{
+  MxImageSizeRequest *constraints = user_data;
+  gint scaled_width, scaled_height;
+
+  if (!mx_image_get_scaled_size (constraints, width, height,
+                                 &scaled_width, &scaled_height))
+    return;
+
+  gdk_pixbuf_loader_set_size (loader, scaled_width, scaled_height);
+  constraints->scaled = TRUE;
+}
+
+/* Scales what a decoder backend returned the way the loader would have */
+static GdkPixbuf *
+mx_image_scale_decoded (GdkPixbuf          *pixbuf,
+                        MxImageSizeRequest *constraints)
+{
+  gint scaled_width, scaled_height;
+  GdkPixbuf *scaled;
+
+  if (!mx_image_get_scaled_size (constraints,
+                                 gdk_pixbuf_get_width (pixbuf),
+                                 gdk_pixbuf_get_height (pixbuf),
+                                 &scaled_width, &scaled_height))
+    return pixbuf;
+
+  scaled = gdk_pixbuf_scale_simple (pixbuf, MAX (scaled_width, 1),
+                                    MAX (scaled_height, 1),
+                                    GDK_INTERP_BILINEAR);
+  g_object_unref (pixbuf);
+  constraints->scaled = TRUE;
+
+  return scaled;
 }
 
 /*
@@ -1401,12 +2530,291 @@ mx_image_size_prepared_cb (GdkPixbufLoader *loader,
  * @height_threshold: The delta allowed before actually scaling the height
  * @upscale: %TRUE if the image should be allowed to scale upwards,
  *   %FALSE otherwise
+ * @cancellable: A #GCancellable, or %NULL
  * @error: A pointer to a #GError
  *
- * Loads and scales a #GdkPixbuf using the given filename or data.
+ * Loads and scales a #GdkPixbuf using the given filename or data. If
+ * @cancellable is cancelled, decoding stops at the next chunk of data.
  *
  * Returns: A new #GdkPixbuf, or %NULL on failure (@error will be set)
  */
+/*
+ * mx_image_scale_thumbnail:
+ * @thumbnail: A smaller version of the image being loaded
+ * @constraints: The size asked for
+ *
+ * Scales @thumbnail the way the image would be under @constraints.
+ *
+ * Returns: The scaled thumbnail, or %NULL if it's too small to stand in for
+ *   the image
+ */
+static GdkPixbuf *
+mx_image_scale_thumbnail (GdkPixbuf          *thumbnail,
+                          MxImageSizeRequest *constraints)
+{
+  gint width, height, size, wanted;
+  gboolean fit_width;
+  guint threshold;
+
+  width = gdk_pixbuf_get_width (thumbnail);
+  height = gdk_pixbuf_get_height (thumbnail);
+
+  if (!mx_image_get_fit (constraints, width, height, &fit_width))
+    return NULL;
+
+  size = fit_width ? width : height;
+  wanted = fit_width ? constraints->width : constraints->height;
+  threshold = fit_width ? constraints->width_threshold :
+                          constraints->height_threshold;
+
+  /* the image itself may well be bigger than that */
+  if (size < wanted && (guint) (wanted - size) >= threshold)
+    return NULL;
+
+  if ((guint) ABS (size - wanted) < threshold)
+    return g_object_ref (thumbnail);
+
+  if (fit_width)
+    return gdk_pixbuf_scale_simple (thumbnail, wanted,
+                                    (wanted / (gfloat)width) * height,
+                                    GDK_INTERP_BILINEAR);
+  else
+    return gdk_pixbuf_scale_simple (thumbnail,
+                                    (wanted / (gfloat)height) * width,
+                                    wanted, GDK_INTERP_BILINEAR);
+}
+
+/* The sizes of the freedesktop.org thumbnail cache directories */
+static const struct
+{
+  const gchar *name;
+  gint         size;
+} mx_image_thumbnail_dirs[] = {
+  { "normal",   128 },
+  { "large",    256 },
+  { "x-large",  512 },
+  { "xx-large", 1024 }
+};
+
+/* Looks for a thumbnail of @filename in the freedesktop.org thumbnail
+ * cache that is up to date and big enough for @constraints.
+ */
+static GdkPixbuf *
+mx_image_lookup_thumbnail (const gchar        *filename,
+                           MxImageSizeRequest *constraints)
+{
+  gchar *path, *uri, *hash, *name, *mtime;
+  GdkPixbuf *pixbuf = NULL;
+  GStatBuf info;
+  guint i;
+  gint wanted;
+
+  if (g_path_is_absolute (filename))
+    path = g_strdup (filename);
+  else
+    {
+      gchar *cwd = g_get_current_dir ();
+      path = g_build_filename (cwd, filename, NULL);
+      g_free (cwd);
+    }
+
+  uri = g_filename_to_uri (path, NULL, NULL);
+  if (!uri || g_stat (path, &info) != 0)
+    {
+      g_free (uri);
+      g_free (path);
+      return NULL;
+    }
+
+  hash = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+  name = g_strconcat (hash, ".png", NULL);
+  mtime = g_strdup_printf ("%" G_GINT64_FORMAT, (gint64) info.st_mtime);
+
+  /* thumbnails fit in a square of the size of their directory */
+  wanted = MIN (constraints->width >= 0 ? constraints->width : G_MAXINT,
+                constraints->height >= 0 ? constraints->height : G_MAXINT);
+
+  for (i = 0; i < G_N_ELEMENTS (mx_image_thumbnail_dirs) && !pixbuf; i++)
+    {
+      GdkPixbuf *thumbnail;
+      const gchar *thumb_mtime;
+      gchar *thumb_path;
+
+      if (mx_image_thumbnail_dirs[i].size < wanted &&
+          i < G_N_ELEMENTS (mx_image_thumbnail_dirs) - 1)
+        continue;
+
+      thumb_path = g_build_filename (g_get_user_cache_dir (), "thumbnails",
+                                     mx_image_thumbnail_dirs[i].name, name,
+                                     NULL);
+      thumbnail = gdk_pixbuf_new_from_file (thumb_path, NULL);
+      g_free (thumb_path);
+
+      if (!thumbnail)
+        continue;
+
+      /* thumbnails of older versions of the file are stale */
+      thumb_mtime = gdk_pixbuf_get_option (thumbnail, "tEXt::Thumb::MTime");
+      if (!g_strcmp0 (thumb_mtime, mtime))
+        pixbuf = mx_image_scale_thumbnail (thumbnail, constraints);
+
+      g_object_unref (thumbnail);
+    }
+
+  g_free (mtime);
+  g_free (name);
+  g_free (hash);
+  g_free (uri);
+  g_free (path);
+
+  return pixbuf;
+}
+
+static guint32
+mx_image_exif_read (const guchar *p,
+                    gboolean      big_endian,
+                    gint          bytes)
+{
+  if (bytes == 2)
+    return big_endian ? (p[0] << 8) | p[1] : (p[1] << 8) | p[0];
+
+  return big_endian ?
+    ((guint32) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3] :
+    ((guint32) p[3] << 24) | (p[2] << 16) | (p[1] << 8) | p[0];
+}
+
+/*
+ * mx_image_get_exif_thumbnail:
+ * @data: The contents of an image file
+ * @length: The length of @data
+ * @thumb_length: Return location for the length of the thumbnail
+ *
+ * Finds the JPEG thumbnail cameras store in the EXIF data of JPEG files,
+ * which is described by the second IFD of the TIFF structure in the APP1
+ * segment.
+ *
+ * Returns: A pointer to the thumbnail in @data, or %NULL
+ */
+static const guchar *
+mx_image_get_exif_thumbnail (const guchar *data,
+                             gsize         length,
+                             gsize        *thumb_length)
+{
+  const guchar *tiff = NULL;
+  gboolean big_endian;
+  gsize offset, tiff_length, ifd, entry;
+  guint32 thumb_offset = 0, thumb_size = 0;
+  guint i, n_entries;
+
+  if (length < 4 || data[0] != 0xff || data[1] != 0xd8)
+    return NULL;
+
+  /* find the APP1 segment among those before the image data */
+  for (offset = 2; offset + 4 <= length && data[offset] == 0xff; )
+    {
+      guint marker = data[offset + 1];
+      gsize size = (data[offset + 2] << 8) | data[offset + 3];
+
+      if (marker == 0xda || size < 2 || size > length - offset - 2)
+        return NULL;
+
+      if (marker == 0xe1 && size >= 16 &&
+          !memcmp (data + offset + 4, "Exif\0\0", 6))
+        {
+          tiff = data + offset + 10;
+          tiff_length = size - 8;
+          break;
+        }
+
+      offset += 2 + size;
+    }
+
+  if (!tiff)
+    return NULL;
+
+  if (tiff[0] == 'I' && tiff[1] == 'I')
+    big_endian = FALSE;
+  else if (tiff[0] == 'M' && tiff[1] == 'M')
+    big_endian = TRUE;
+  else
+    return NULL;
+
+  /* skip the IFD of the image to get to the one of the thumbnail */
+  ifd = mx_image_exif_read (tiff + 4, big_endian, 4);
+  if (ifd > tiff_length - 2)
+    return NULL;
+
+  n_entries = mx_image_exif_read (tiff + ifd, big_endian, 2);
+  entry = ifd + 2 + n_entries * 12;
+  if (entry > tiff_length - 4)
+    return NULL;
+
+  ifd = mx_image_exif_read (tiff + entry, big_endian, 4);
+  if (ifd == 0 || ifd > tiff_length - 2)
+    return NULL;
+
+  n_entries = mx_image_exif_read (tiff + ifd, big_endian, 2);
+  for (i = 0; i < n_entries; i++)
+    {
+      guint tag, type;
+      guint32 value;
+
+      entry = ifd + 2 + i * 12;
+      if (entry > tiff_length - 12)
+        break;
+
+      tag = mx_image_exif_read (tiff + entry, big_endian, 2);
+      type = mx_image_exif_read (tiff + entry + 2, big_endian, 2);
+
+      /* SHORT or LONG */
+      value = (type == 3) ? mx_image_exif_read (tiff + entry + 8,
+                                                big_endian, 2) :
+                            mx_image_exif_read (tiff + entry + 8,
+                                                big_endian, 4);
+
+      if (tag == 0x0201)
+        thumb_offset = value;
+      else if (tag == 0x0202)
+        thumb_size = value;
+    }
+
+  if (!thumb_offset || !thumb_size || thumb_offset > tiff_length ||
+      thumb_size > tiff_length - thumb_offset)
+    return NULL;
+
+  *thumb_length = thumb_size;
+
+  return tiff + thumb_offset;
+}
+
+/* Decodes the EXIF thumbnail of @buffer, if it's big enough */
+static GdkPixbuf *
+mx_image_load_exif_thumbnail (const guchar       *buffer,
+                              gsize               count,
+                              MxImageSizeRequest *constraints)
+{
+  GdkPixbufLoader *loader;
+  GdkPixbuf *pixbuf = NULL;
+  const guchar *thumbnail;
+  gsize length;
+
+  thumbnail = mx_image_get_exif_thumbnail (buffer, count, &length);
+  if (!thumbnail)
+    return NULL;
+
+  loader = gdk_pixbuf_loader_new ();
+  if (gdk_pixbuf_loader_write (loader, thumbnail, length, NULL) &&
+      gdk_pixbuf_loader_close (loader, NULL))
+    pixbuf = mx_image_scale_thumbnail (gdk_pixbuf_loader_get_pixbuf (loader),
+                                       constraints);
+  else
+    gdk_pixbuf_loader_close (loader, NULL);
+
+  g_object_unref (loader);
+
+  return pixbuf;
+}
+
 static GdkPixbuf *
 mx_image_pixbuf_new (const gchar  *filename,
                      guchar       *buffer,
@@ -1416,30 +2824,59 @@ mx_image_pixbuf_new (const gchar  *filename,
                      guint         width_threshold,
                      guint         height_threshold,
                      gboolean      upscale,
+                     gboolean      thumbnails,
                      gboolean     *scaled,
+                     GCallback     area_updated,
+                     gpointer      user_data,
+                     GCancellable *cancellable,
                      GError      **error)
 {
   GdkPixbuf *pixbuf;
   GdkPixbufLoader *loader;
   MxImageSizeRequest constraints;
+  GMappedFile *file = NULL;
+  gboolean decoder_scaled;
+  gsize offset;
 
   GError *err = NULL;
 
-  loader = gdk_pixbuf_loader_new ();
-
   constraints.width = width;
   constraints.height = height;
   constraints.width_threshold = width_threshold;
   constraints.height_threshold = height_threshold;
   constraints.upscale = upscale;
+  constraints.scaled = FALSE;
+
+  /* Thumbnails only stand in for images loaded at a size */
+  if ((width < 0 && height < 0) || g_cancellable_is_cancelled (cancellable))
+    thumbnails = FALSE;
+
+  if (thumbnails && filename)
+    {
+      pixbuf = mx_image_lookup_thumbnail (filename, &constraints);
+      if (pixbuf)
+        {
+          if (scaled)
+            *scaled = TRUE;
+          return pixbuf;
+        }
+    }
+
+  loader = gdk_pixbuf_loader_new ();
 
   g_signal_connect (loader, "size-prepared",
                     G_CALLBACK (mx_image_size_prepared_cb),
                     &constraints);
+  if (area_updated)
+    g_signal_connect (loader, "area-updated", area_updated, user_data);
 
+  /* Map the file rather than reading it in, so that it isn't copied and
+   * pages are only read as the loader gets to them.
+   */
   if (filename)
     {
-      if (!g_file_get_contents (filename, (gchar **)&buffer, &count, &err))
+      file = g_mapped_file_new (filename, FALSE, &err);
+      if (!file)
         {
           if (error)
             g_propagate_error (error, err);
@@ -1448,23 +2885,71 @@ mx_image_pixbuf_new (const gchar  *filename,
           return NULL;
         }
 
-      g_object_weak_ref (G_OBJECT (loader), (GWeakNotify)g_free, buffer);
+      buffer = (guchar *)g_mapped_file_get_contents (file);
+      count = g_mapped_file_get_length (file);
     }
 
   if (!buffer)
     {
       gdk_pixbuf_loader_close (loader, NULL);
       g_object_unref (loader);
+      if (file)
+        g_mapped_file_unref (file);
       return NULL;
     }
 
-  if (!gdk_pixbuf_loader_write (loader, buffer, count, &err))
+  if (thumbnails &&
+      (pixbuf = mx_image_load_exif_thumbnail (buffer, count, &constraints)))
     {
-      if (error)
-        g_propagate_error (error, err);
       gdk_pixbuf_loader_close (loader, NULL);
       g_object_unref (loader);
-      return NULL;
+      if (file)
+        g_mapped_file_unref (file);
+      if (scaled)
+        *scaled = TRUE;
+      return pixbuf;
+    }
+
+  /* Faster decoders get the image before gdk-pixbuf does; they are quick
+   * enough that there's no showing the image as it's decoded */
+  pixbuf = _mx_image_decoder_decode (buffer, count, width, height,
+                                     &decoder_scaled, &err);
+  if (pixbuf || err)
+    {
+      gdk_pixbuf_loader_close (loader, NULL);
+      g_object_unref (loader);
+      if (file)
+        g_mapped_file_unref (file);
+
+      if (err)
+        {
+          g_propagate_error (error, err);
+          return NULL;
+        }
+
+      pixbuf = mx_image_scale_decoded (pixbuf, &constraints);
+      if (scaled)
+        *scaled = constraints.scaled || decoder_scaled;
+      return pixbuf;
+    }
+
+  /* Feed the data in chunks, so decoding overlaps reading the file in */
+  for (offset = 0; offset < count; offset += MX_IMAGE_LOAD_CHUNK_SIZE)
+    {
+      if (g_cancellable_set_error_if_cancelled (cancellable, &err) ||
+          !gdk_pixbuf_loader_write (loader, buffer + offset,
+                                    MIN (count - offset,
+                                         MX_IMAGE_LOAD_CHUNK_SIZE),
+                                    &err))
+        {
+          if (error)
+            g_propagate_error (error, err);
+          gdk_pixbuf_loader_close (loader, NULL);
+          g_object_unref (loader);
+          if (file)
+            g_mapped_file_unref (file);
+          return NULL;
+        }
     }
 
   /* Note, closing the pixbuf loader will make sure that size-prepared
@@ -1475,12 +2960,16 @@ mx_image_pixbuf_new (const gchar  *filename,
       if (error)
         g_propagate_error (error, err);
       g_object_unref (loader);
+      if (file)
+        g_mapped_file_unref (file);
       return NULL;
     }
 
   pixbuf = g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
 
   g_object_unref (loader);
+  if (file)
+    g_mapped_file_unref (file);
 
   if (scaled)
     *scaled = constraints.scaled;
@@ -1488,12 +2977,13 @@ mx_image_pixbuf_new (const gchar  *filename,
   return pixbuf;
 }
 
+/* runs on a worker thread */
 static void
-mx_image_async_cb (gpointer task_data,
-                   gpointer user_data)
+mx_image_async_cb (gpointer task_data)
 {
   gboolean scaled;
   MxImageAsyncData *data = task_data;
+  MX_TRACE_BEGIN (mx_image_async_cb);
 
   g_mutex_lock (&data->mutex);
 
@@ -1502,21 +2992,28 @@ mx_image_async_cb (gpointer task_data,
    */
   if (data->cancelled)
     {
-      data->idle_handler =
-        clutter_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
-                                       mx_image_load_complete_cb, data, NULL);
       g_mutex_unlock (&data->mutex);
-
+      MX_TRACE_END (mx_image_async_cb);
       return;
     }
 
-  /* Try to load the pixbuf */
+  /* Try to load the pixbuf, showing it as it gets decoded if asked to */
+  data->last_progress = g_get_monotonic_time ();
   data->pixbuf = mx_image_pixbuf_new (data->filename, data->buffer,
                                       data->count, data->width, data->height,
                                       data->width_threshold,
                                       data->height_threshold, data->upscale,
-                                      &scaled,
-                                      &data->error);
+                                      data->thumbnails, &scaled,
+                                      data->progressive ?
+                                      G_CALLBACK (mx_image_area_updated_cb) :
+                                      NULL, data,
+                                      data->cancellable, &data->error);
+  if (data->pixbuf)
+    {
+      mx_image_pixbuf_premultiply (data->pixbuf);
+      g_atomic_pointer_add (&image_async_bytes,
+                            mx_image_pixbuf_get_bytes (data->pixbuf));
+    }
 
   /* If scaling was unnecessary, we can cache the result */
   if (!scaled)
@@ -1526,11 +3023,10 @@ mx_image_async_cb (gpointer task_data,
     }
 
   data->complete = TRUE;
-  data->idle_handler =
-    clutter_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
-                                   mx_image_load_complete_cb, data, NULL);
 
   g_mutex_unlock (&data->mutex);
+
+  MX_TRACE_END (mx_image_async_cb);
 }
 
 static gboolean
@@ -1541,9 +3037,10 @@ mx_image_set_async (MxImage         *image,
                     GDestroyNotify   free_func,
                     gint             width,
                     gint             height,
+                    gchar           *cache_key,
+                    gpointer         cache_ident,
                     GError         **error)
 {
-  GError *err;
   MxImagePrivate *priv;
   MxImageAsyncData *data;
 
@@ -1562,30 +3059,12 @@ mx_image_set_async (MxImage         *image,
     {
       g_set_error (error, MX_IMAGE_ERROR, MX_IMAGE_ERROR_NO_ASYNC,
                    "Asynchronous image loading is not enabled");
+      g_free (cache_key);
       return FALSE;
     }
 
-  err = NULL;
   data = NULL;
 
-  /* Load the pixbuf in a thread, then later on upload it to the GPU */
-  if (!mx_image_threads)
-    {
-      mx_image_threads = g_thread_pool_new (mx_image_async_cb, NULL,
-#ifdef _SC_NPROCESSORS_ONLN
-                                            sysconf (_SC_NPROCESSORS_ONLN),
-#else
-                                            /* FIXME: add more OSs */
-                                            1,
-#endif
-                                            FALSE, &err);
-      if (!mx_image_threads)
-        {
-          g_propagate_error (error, err);
-          return FALSE;
-        }
-    }
-
   /* Cancel/free any in-progress load */
   if (priv->async_load_data)
     {
@@ -1594,14 +3073,14 @@ mx_image_set_async (MxImage         *image,
       if (!g_mutex_trylock (&old_data->mutex))
         {
           /* The thread is busy, cancel it and start a new one */
-          old_data->cancelled = TRUE;
+          mx_image_async_data_cancel (old_data);
         }
       else
         {
           if (old_data->complete)
             {
               /* The load finished, cancel the upload */
-              old_data->cancelled = TRUE;
+              mx_image_async_data_cancel (old_data);
               g_mutex_unlock (&old_data->mutex);
             }
           else
@@ -1614,6 +3093,9 @@ mx_image_set_async (MxImage         *image,
               old_data->free_func = free_func;
               old_data->width = width;
               old_data->height = height;
+              g_free (old_data->cache_key);
+              old_data->cache_key = cache_key;
+              old_data->cache_ident = cache_ident;
               old_data->cancelled = FALSE;
               g_mutex_unlock (&old_data->mutex);
 
@@ -1624,17 +3106,401 @@ mx_image_set_async (MxImage         *image,
 
   if (!data)
     {
-      /* Create the async load data and add it to the thread-pool */
-      priv->async_load_data = data = mx_image_async_data_new (image);
-      data->filename = g_strdup (filename);
-      data->buffer = buffer;
-      data->count = count;
-      data->free_func = free_func;
-      data->width = width;
-      data->height = height;
-      g_thread_pool_push (mx_image_threads, data, NULL);
+      /* Create the async load data and add it to the thread-pool */
+      priv->async_load_data = data = mx_image_async_data_new (image);
+      data->filename = g_strdup (filename);
+      data->buffer = buffer;
+      data->count = count;
+      data->free_func = free_func;
+      data->width = width;
+      data->height = height;
+      data->cache_key = cache_key;
+      data->cache_ident = cache_ident;
+
+      /* Load the pixbuf in a thread, then later on upload it to the GPU */
+      data->job_id =
+        mx_worker_pool_push (mx_worker_pool_get_default (),
+                             G_PRIORITY_DEFAULT +
+                             mx_image_get_load_priority (image),
+                             mx_image_async_cb, mx_image_load_complete_cb,
+                             data, data->cancellable);
+    }
+
+  mx_image_watch_visibility (image);
+
+  return TRUE;
+}
+
+/* Animations are decoded a few frames ahead on the worker pool. Each frame
+ * is uploaded over the previous one in the same texture, when it is due
+ * according to a timeline, so that it follows the frame clock and avoids
+ * the transition and relayout of setting a new image.
+ */
+#define MX_IMAGE_ANIMATION_FRAMES 8
+
+/* the shortest time a frame is shown for, in milliseconds, as browsers do
+ * for GIFs with no delays */
+#define MX_IMAGE_ANIMATION_MIN_DELAY 20
+
+typedef struct
+{
+  GdkPixbuf *pixbuf;
+
+  /* how long to show the frame for, in milliseconds, or -1 if it's the
+   * last one */
+  gint       delay;
+} MxImageAnimationFrame;
+
+struct _MxImageAnimation
+{
+  MxImage                *image;
+  gchar                  *filename;
+  GCancellable           *cancellable;
+
+  /* only touched by the decoding job in progress */
+  GdkPixbufAnimation     *animation;
+  GdkPixbufAnimationIter *iter;
+  GTimeVal                time;
+  GError                 *error;
+
+  /* the frames decoded ahead, and whether the last one is decoded */
+  GMutex                  mutex;
+  GQueue                  frames;
+  gboolean                finished;
+
+  /* main thread only */
+  ClutterTimeline        *timeline;
+  CoglHandle              texture;
+  gint                    delay;
+  gint                    elapsed;
+  guint                   decoding : 1;
+  guint                   stopped  : 1;
+};
+
+static void
+mx_image_animation_frame_free (MxImageAnimationFrame *frame)
+{
+  g_object_unref (frame->pixbuf);
+  g_slice_free (MxImageAnimationFrame, frame);
+}
+
+static void
+mx_image_animation_free (MxImageAnimation *animation)
+{
+  g_free (animation->filename);
+  g_object_unref (animation->cancellable);
+
+  if (animation->iter)
+    g_object_unref (animation->iter);
+  if (animation->animation)
+    g_object_unref (animation->animation);
+  if (animation->error)
+    g_error_free (animation->error);
+
+  g_queue_foreach (&animation->frames,
+                   (GFunc) mx_image_animation_frame_free, NULL);
+  g_queue_clear (&animation->frames);
+  g_mutex_clear (&animation->mutex);
+
+  if (animation->timeline)
+    {
+      clutter_timeline_stop (animation->timeline);
+      g_object_unref (animation->timeline);
+    }
+  if (animation->texture)
+    cogl_object_unref (animation->texture);
+
+  g_slice_free (MxImageAnimation, animation);
+}
+
+/* runs on a worker thread, filling the queue of frames */
+static void
+mx_image_animation_decode (gpointer user_data)
+{
+  MxImageAnimation *animation = user_data;
+  gboolean finished;
+  guint n_frames;
+
+  if (!animation->animation)
+    {
+      animation->animation =
+        gdk_pixbuf_animation_new_from_file (animation->filename,
+                                            &animation->error);
+      if (!animation->animation)
+        return;
+
+      animation->iter = gdk_pixbuf_animation_get_iter (animation->animation,
+                                                       &animation->time);
+    }
+
+  g_mutex_lock (&animation->mutex);
+  n_frames = animation->frames.length;
+  finished = animation->finished;
+  g_mutex_unlock (&animation->mutex);
+
+  while (!finished && n_frames < MX_IMAGE_ANIMATION_FRAMES &&
+         !g_cancellable_is_cancelled (animation->cancellable))
+    {
+      MxImageAnimationFrame *frame = g_slice_new (MxImageAnimationFrame);
+      GdkPixbuf *pixbuf;
+
+      /* the iterator reuses its pixbuf */
+      pixbuf = gdk_pixbuf_animation_iter_get_pixbuf (animation->iter);
+      frame->pixbuf = gdk_pixbuf_copy (pixbuf);
+      frame->delay = gdk_pixbuf_animation_iter_get_delay_time (animation->iter);
+
+      finished = (frame->delay < 0);
+      if (!finished)
+        {
+          frame->delay = MAX (frame->delay, MX_IMAGE_ANIMATION_MIN_DELAY);
+          g_time_val_add (&animation->time, frame->delay * 1000);
+          gdk_pixbuf_animation_iter_advance (animation->iter,
+                                             &animation->time);
+        }
+
+      g_mutex_lock (&animation->mutex);
+      g_queue_push_tail (&animation->frames, frame);
+      n_frames = animation->frames.length;
+      animation->finished = finished;
+      g_mutex_unlock (&animation->mutex);
+    }
+}
+
+static void mx_image_animation_decoded (gpointer user_data);
+
+static void
+mx_image_animation_decode_more (MxImageAnimation *animation)
+{
+  animation->decoding = TRUE;
+  mx_worker_pool_push (mx_worker_pool_get_default (), G_PRIORITY_DEFAULT,
+                       mx_image_animation_decode, mx_image_animation_decoded,
+                       animation, animation->cancellable);
+}
+
+/* Shows the next decoded frame, if there is one, and refills the queue
+ * once it's half empty */
+static gboolean
+mx_image_animation_next_frame (MxImageAnimation *animation)
+{
+  MxImageAnimationFrame *frame;
+  gboolean refill;
+  gint width, height;
+
+  g_mutex_lock (&animation->mutex);
+  frame = g_queue_pop_head (&animation->frames);
+  refill = !animation->finished &&
+           animation->frames.length < MX_IMAGE_ANIMATION_FRAMES / 2;
+  g_mutex_unlock (&animation->mutex);
+
+  if (refill && !animation->decoding)
+    mx_image_animation_decode_more (animation);
+
+  if (!frame)
+    return FALSE;
+
+  width = gdk_pixbuf_get_width (frame->pixbuf);
+  height = gdk_pixbuf_get_height (frame->pixbuf);
+
+  if (mx_image_pixbuf_is_supported (frame->pixbuf))
+    {
+      /* all the frames have the size of the animation */
+      if (!animation->texture)
+        animation->texture = mx_image_new_texture (width, height, NULL);
+
+      if (animation->texture)
+        {
+          gint64 start = _mx_frame_stats_begin (MX_FRAME_STATS_TEXTURE_UPLOAD);
+
+          cogl_texture_set_region (animation->texture, 0, 0, 1, 1,
+                                   width, height, width, height,
+                                   gdk_pixbuf_get_has_alpha (frame->pixbuf) ?
+                                   COGL_PIXEL_FORMAT_RGBA_8888 :
+                                   COGL_PIXEL_FORMAT_RGB_888,
+                                   gdk_pixbuf_get_rowstride (frame->pixbuf),
+                                   gdk_pixbuf_get_pixels (frame->pixbuf));
+
+          _mx_frame_stats_end (MX_FRAME_STATS_TEXTURE_UPLOAD, start);
+        }
+    }
+
+  animation->delay = frame->delay;
+  mx_image_animation_frame_free (frame);
+
+  return TRUE;
+}
+
+static void
+mx_image_animation_new_frame_cb (ClutterTimeline  *timeline,
+                                 gint              msecs,
+                                 MxImageAnimation *animation)
+{
+  /* the last frame stays up */
+  if (animation->delay < 0)
+    {
+      clutter_timeline_stop (timeline);
+      return;
+    }
+
+  animation->elapsed += clutter_timeline_get_delta (timeline);
+  if (animation->elapsed < animation->delay)
+    return;
+
+  if (!mx_image_animation_next_frame (animation))
+    {
+      /* the decoder is behind, try again on the next frame */
+      animation->elapsed = animation->delay;
+      return;
+    }
+
+  /* carry the lateness over, without trying to catch up */
+  animation->elapsed = MIN (animation->elapsed - animation->delay,
+                            MAX (animation->delay, 0));
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (animation->image));
+}
+
+static void
+mx_image_animation_update_playing (MxImageAnimation *animation)
+{
+  if (!animation->timeline)
+    return;
+
+  if (CLUTTER_ACTOR_IS_MAPPED (animation->image) && animation->delay >= 0)
+    clutter_timeline_start (animation->timeline);
+  else
+    clutter_timeline_pause (animation->timeline);
+}
+
+/* back in the main thread, once frames have been decoded */
+static void
+mx_image_animation_decoded (gpointer user_data)
+{
+  MxImageAnimation *animation = user_data;
+  MxImage *image = animation->image;
+
+  animation->decoding = FALSE;
+
+  if (animation->stopped)
+    {
+      mx_image_animation_free (animation);
+      return;
+    }
+
+  if (animation->error)
+    {
+      GError *error = animation->error;
+
+      animation->error = NULL;
+      mx_image_stop_animation (image);
+      g_signal_emit (image, signals[IMAGE_LOAD_ERROR], 0, error);
+      g_error_free (error);
+      return;
+    }
+
+  if (animation->timeline)
+    return;
+
+  /* show the first frame, and start playing */
+  if (!mx_image_animation_next_frame (animation) || !animation->texture)
+    {
+      GError *error = g_error_new (MX_IMAGE_ERROR, MX_IMAGE_ERROR_BAD_FORMAT,
+                                   "Unsupported animation '%s'",
+                                   animation->filename);
+
+      mx_image_stop_animation (image);
+      g_signal_emit (image, signals[IMAGE_LOAD_ERROR], 0, error);
+      g_error_free (error);
+      return;
+    }
+
+  mx_image_show_texture (image, animation->texture);
+
+  animation->timeline = clutter_timeline_new (1000);
+  clutter_timeline_set_repeat_count (animation->timeline, -1);
+  g_signal_connect (animation->timeline, "new-frame",
+                    G_CALLBACK (mx_image_animation_new_frame_cb), animation);
+  mx_image_animation_update_playing (animation);
+
+  g_signal_emit (image, signals[IMAGE_LOADED], 0);
+}
+
+static void
+mx_image_stop_animation (MxImage *image)
+{
+  MxImagePrivate *priv = image->priv;
+  MxImageAnimation *animation = priv->animation;
+
+  if (!animation)
+    return;
+
+  priv->animation = NULL;
+
+  /* the decoding job frees the animation when it completes */
+  if (animation->decoding)
+    {
+      animation->stopped = TRUE;
+      g_cancellable_cancel (animation->cancellable);
+    }
+  else
+    mx_image_animation_free (animation);
+}
+
+/**
+ * mx_image_set_from_animation_file:
+ * @image: An #MxImage
+ * @filename: Filename to read the animation from
+ * @error: Return location for a #GError, or #NULL
+ *
+ * Plays an animated image, such as an animated GIF, from @filename. The
+ * frames are decoded shortly before they are due, on worker threads, and
+ * the animation is paused while @image isn't mapped. Files with a single
+ * image are shown like any other image.
+ *
+ * Loading is always asynchronous: the #MxImage::image-loaded signal is
+ * emitted when the first frame is shown, and the #MxImage::image-load-error
+ * signal is emitted if the file can't be read. Setting another image stops
+ * the animation.
+ *
+ * Returns: #TRUE if the animation started loading
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_image_set_from_animation_file (MxImage      *image,
+                                  const gchar  *filename,
+                                  GError      **error)
+{
+  MxImageAnimation *animation;
+
+  if (G_UNLIKELY (!MX_IS_IMAGE (image)))
+    {
+      g_set_error (error, MX_IMAGE_ERROR,
+                   MX_IMAGE_ERROR_INVALID_PARAMETER,
+                   "image parameter is not a MxImage");
+      return FALSE;
+    }
+
+  if (G_UNLIKELY (!filename))
+    {
+      g_set_error (error, MX_IMAGE_ERROR,
+                   MX_IMAGE_ERROR_INVALID_PARAMETER,
+                   "filename parameter is NULL");
+      return FALSE;
     }
 
+  mx_image_cancel_in_progress (image);
+  mx_image_forget_source (image);
+
+  animation = g_slice_new0 (MxImageAnimation);
+  animation->image = image;
+  animation->filename = g_strdup (filename);
+  animation->cancellable = g_cancellable_new ();
+  g_mutex_init (&animation->mutex);
+  g_queue_init (&animation->frames);
+
+  image->priv->animation = animation;
+  mx_image_animation_decode_more (animation);
+
   return TRUE;
 }
 
@@ -1671,6 +3537,9 @@ mx_image_set_from_file (MxImage      *image,
  * In case of failure, #FALSE is returned and @error is set. The aspect ratio
  * will always be maintained.
  *
+ * When #MxImage:adaptive-resolution is set, the image is loaded again at
+ * a larger size whenever it grows larger than it was loaded at.
+ *
  * Returns: #TRUE if the image was successfully updated
  *
  * Since: 1.2
@@ -1681,11 +3550,40 @@ mx_image_set_from_file_at_size (MxImage      *image,
                                 gint          width,
                                 gint          height,
                                 GError      **error)
+{
+  MxImagePrivate *priv;
+
+  if (!mx_image_set_from_file_internal (image, filename, width, height,
+                                        error))
+    return FALSE;
+
+  /* remembered for adaptive mode; the setters used on the way forget it */
+  priv = image->priv;
+  g_free (priv->source_filename);
+  priv->source_filename = NULL;
+
+  if (filename && (width >= 0 || height >= 0))
+    {
+      priv->source_filename = g_strdup (filename);
+      priv->source_width = width;
+      priv->source_height = height;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+mx_image_set_from_file_internal (MxImage      *image,
+                                 const gchar  *filename,
+                                 gint          width,
+                                 gint          height,
+                                 GError      **error)
 {
   GdkPixbuf *pixbuf;
   MxImagePrivate *priv;
   MxTextureCache *cache;
-  gboolean retval, use_cache;
+  gboolean retval, scaled;
+  gpointer shared_ident = NULL;
 
   if (G_UNLIKELY (!MX_IS_IMAGE (image)))
     {
@@ -1698,11 +3596,22 @@ mx_image_set_from_file_at_size (MxImage      *image,
   priv = image->priv;
   pixbuf = NULL;
 
+  /* Scaled images can be shared with other images loading the same file
+   * with the same parameters, without going through the thread-pool.
+   */
+  if (priv->shared_cache && ((width != -1) || (height != -1)))
+    {
+      shared_ident = mx_image_get_shared_cache_ident (image, width, height);
+
+      if (mx_image_set_from_shared_cache (image, filename, shared_ident))
+        return TRUE;
+    }
+
   /* Check if the processed image is in the cache - we don't use the cache
    * if we're loading at a particular size.
    */
   cache = mx_texture_cache_get_default ();
-  use_cache = TRUE;
+  scaled = FALSE;
 
   if ((width != -1) || (height != -1) ||
       !mx_texture_cache_contains_meta (cache, filename,
@@ -1735,19 +3644,28 @@ mx_image_set_from_file_at_size (MxImage      *image,
       /* Load the pixbuf in a thread, then later on upload it to the GPU */
       if (priv->load_async)
         return mx_image_set_async (image, filename, NULL, 0, NULL,
-                                   width, height, error);
+                                   width, height,
+                                   shared_ident ? g_strdup (filename) : NULL,
+                                   shared_ident, error);
 
       /* Synchronously load the pixbuf and set it */
       pixbuf = mx_image_pixbuf_new (filename, NULL, 0, width, height,
                                     priv->width_threshold,
                                     priv->height_threshold,
-                                    priv->upscale, &use_cache, error);
+                                    priv->upscale, priv->use_thumbnails,
+                                    &scaled, NULL, NULL, NULL, error);
       if (!pixbuf)
         return FALSE;
+
+      mx_image_pixbuf_premultiply (pixbuf);
     }
 
+  /* Only unscaled images are cached under the file name alone */
   retval = mx_image_set_from_pixbuf (image, pixbuf,
-                                     use_cache ? filename : NULL, error);
+                                     scaled ? NULL : filename, error);
+
+  if (retval && pixbuf && shared_ident)
+    mx_image_share_texture (image, filename, shared_ident);
 
   if (pixbuf)
     g_object_unref (pixbuf);
@@ -1777,6 +3695,7 @@ mx_image_set_from_cogl_texture (MxImage    *image,
   g_return_val_if_fail (cogl_is_texture (texture), FALSE);
 
   mx_image_cancel_in_progress (image);
+  mx_image_forget_source (image);
 
   priv = image->priv;
 
@@ -1861,6 +3780,224 @@ mx_image_set_from_cogl_texture (MxImage    *image,
     }
 }
 
+#ifdef MX_IMAGE_HAS_EGL_IMPORT
+static gboolean
+mx_image_set_from_egl_image_internal (MxImage          *image,
+                                      EGLImageKHR       egl_image,
+                                      CoglPixelFormat   pixel_format,
+                                      gint              width,
+                                      gint              height,
+                                      GError          **error)
+{
+  CoglContext *context;
+  CoglTexture2D *texture;
+  gboolean retval;
+
+  context = clutter_backend_get_cogl_context (clutter_get_default_backend ());
+  texture = cogl_egl_texture_2d_new_from_image (context, width, height,
+                                                pixel_format, egl_image,
+                                                error);
+  if (!texture)
+    return FALSE;
+
+  /* The EGL image is only sampled from, to draw it with the border */
+  retval = mx_image_set_from_cogl_texture (image, COGL_TEXTURE (texture));
+  cogl_object_unref (texture);
+
+  if (!retval)
+    g_set_error (error, MX_IMAGE_ERROR, MX_IMAGE_ERROR_INTERNAL,
+                 "Failed to copy the EGL image");
+
+  return retval;
+}
+#endif
+
+/**
+ * mx_image_set_from_egl_image:
+ * @image: A #MxImage
+ * @egl_image: An EGLImageKHR
+ * @pixel_format: The #CoglPixelFormat of @egl_image
+ * @width: Width in pixels of @egl_image
+ * @height: Height in pixels of @egl_image
+ * @error: Return location for a #GError, or #NULL
+ *
+ * Sets the contents of the image from an EGL image, such as a video frame
+ * or a camera preview, without reading it back into memory: it is copied
+ * on the GPU, like with mx_image_set_from_cogl_texture(). @egl_image can
+ * be destroyed when this returns.
+ *
+ * This is only supported when Cogl uses EGL, otherwise #FALSE is returned
+ * and @error is set.
+ *
+ * Returns: #TRUE if the image was successfully updated
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_image_set_from_egl_image (MxImage          *image,
+                             gpointer          egl_image,
+                             CoglPixelFormat   pixel_format,
+                             gint              width,
+                             gint              height,
+                             GError          **error)
+{
+  if (G_UNLIKELY (!MX_IS_IMAGE (image)))
+    {
+      g_set_error (error, MX_IMAGE_ERROR,
+                   MX_IMAGE_ERROR_INVALID_PARAMETER,
+                   "image parameter is not a MxImage");
+      return FALSE;
+    }
+
+#ifdef MX_IMAGE_HAS_EGL_IMPORT
+  return mx_image_set_from_egl_image_internal (image, egl_image,
+                                               pixel_format, width, height,
+                                               error);
+#else
+  g_set_error (error, MX_IMAGE_ERROR, MX_IMAGE_ERROR_INTERNAL,
+               "EGL images are not supported");
+  return FALSE;
+#endif
+}
+
+/* from drm_fourcc.h */
+#define MX_IMAGE_FOURCC(a, b, c, d) \
+  ((guint32) (a) | ((guint32) (b) << 8) | \
+   ((guint32) (c) << 16) | ((guint32) (d) << 24))
+
+#ifndef EGL_LINUX_DMA_BUF_EXT
+#define EGL_LINUX_DMA_BUF_EXT          0x3270
+#define EGL_LINUX_DRM_FOURCC_EXT       0x3271
+#define EGL_DMA_BUF_PLANE0_FD_EXT      0x3272
+#define EGL_DMA_BUF_PLANE0_OFFSET_EXT  0x3273
+#define EGL_DMA_BUF_PLANE0_PITCH_EXT   0x3274
+#endif
+
+/**
+ * mx_image_set_from_dma_buf:
+ * @image: A #MxImage
+ * @fd: A dma-buf file descriptor
+ * @fourcc: The DRM fourcc code of the format of the buffer, one of
+ *   ARGB8888, XRGB8888, ABGR8888 or XBGR8888
+ * @width: Width in pixels of the buffer
+ * @height: Height in pixels of the buffer
+ * @offset: Offset in bytes of the first pixel in the buffer
+ * @stride: Distance in bytes between row starts
+ * @error: Return location for a #GError, or #NULL
+ *
+ * Sets the contents of the image from a single-plane dma-buf, such as one
+ * exported by a video decoder or a camera, by importing it as an EGL image,
+ * see mx_image_set_from_egl_image(). @fd is not closed, and can be closed
+ * when this returns.
+ *
+ * This needs EGL and the EGL_EXT_image_dma_buf_import extension, otherwise
+ * #FALSE is returned and @error is set.
+ *
+ * Returns: #TRUE if the image was successfully updated
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_image_set_from_dma_buf (MxImage  *image,
+                           gint      fd,
+                           guint32   fourcc,
+                           gint      width,
+                           gint      height,
+                           gint      offset,
+                           gint      stride,
+                           GError  **error)
+{
+#ifdef MX_IMAGE_HAS_EGL_IMPORT
+  static PFNEGLCREATEIMAGEKHRPROC create_image = NULL;
+  static PFNEGLDESTROYIMAGEKHRPROC destroy_image = NULL;
+  CoglPixelFormat pixel_format;
+  CoglContext *context;
+  EGLDisplay display;
+  EGLImageKHR egl_image;
+  gboolean retval;
+  EGLint attribs[] = {
+    EGL_WIDTH, width,
+    EGL_HEIGHT, height,
+    EGL_LINUX_DRM_FOURCC_EXT, fourcc,
+    EGL_DMA_BUF_PLANE0_FD_EXT, fd,
+    EGL_DMA_BUF_PLANE0_OFFSET_EXT, offset,
+    EGL_DMA_BUF_PLANE0_PITCH_EXT, stride,
+    EGL_NONE
+  };
+#endif
+
+  if (G_UNLIKELY (!MX_IS_IMAGE (image)))
+    {
+      g_set_error (error, MX_IMAGE_ERROR,
+                   MX_IMAGE_ERROR_INVALID_PARAMETER,
+                   "image parameter is not a MxImage");
+      return FALSE;
+    }
+
+#ifdef MX_IMAGE_HAS_EGL_IMPORT
+  /* Cogl can only sample from RGB images */
+  switch (fourcc)
+    {
+    case MX_IMAGE_FOURCC ('A', 'R', '2', '4'):
+    case MX_IMAGE_FOURCC ('A', 'B', '2', '4'):
+      pixel_format = COGL_PIXEL_FORMAT_RGBA_8888_PRE;
+      break;
+
+    case MX_IMAGE_FOURCC ('X', 'R', '2', '4'):
+    case MX_IMAGE_FOURCC ('X', 'B', '2', '4'):
+      pixel_format = COGL_PIXEL_FORMAT_RGB_888;
+      break;
+
+    default:
+      g_set_error (error, MX_IMAGE_ERROR, MX_IMAGE_ERROR_BAD_FORMAT,
+                   "Unsupported dma-buf format");
+      return FALSE;
+    }
+
+  context = clutter_backend_get_cogl_context (clutter_get_default_backend ());
+  display = cogl_egl_context_get_egl_display (context);
+
+  if (!create_image)
+    {
+      const gchar *extensions = eglQueryString (display, EGL_EXTENSIONS);
+
+      if (!extensions ||
+          !strstr (extensions, "EGL_EXT_image_dma_buf_import"))
+        {
+          g_set_error (error, MX_IMAGE_ERROR, MX_IMAGE_ERROR_INTERNAL,
+                       "dma-buf import is not supported");
+          return FALSE;
+        }
+
+      create_image = (PFNEGLCREATEIMAGEKHRPROC)
+        eglGetProcAddress ("eglCreateImageKHR");
+      destroy_image = (PFNEGLDESTROYIMAGEKHRPROC)
+        eglGetProcAddress ("eglDestroyImageKHR");
+    }
+
+  egl_image = create_image (display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT,
+                            NULL, attribs);
+  if (egl_image == EGL_NO_IMAGE_KHR)
+    {
+      g_set_error (error, MX_IMAGE_ERROR, MX_IMAGE_ERROR_INTERNAL,
+                   "Failed to import the dma-buf (EGL error 0x%x)",
+                   eglGetError ());
+      return FALSE;
+    }
+
+  retval = mx_image_set_from_egl_image_internal (image, egl_image,
+                                                 pixel_format, width, height,
+                                                 error);
+  destroy_image (display, egl_image);
+
+  return retval;
+#else
+  g_set_error (error, MX_IMAGE_ERROR, MX_IMAGE_ERROR_INTERNAL,
+               "dma-buf import is not supported");
+  return FALSE;
+#endif
+}
+
 /**
  * mx_image_set_from_buffer:
  * @image: An #MxImage
@@ -1923,6 +4060,8 @@ mx_image_set_from_buffer_at_size (MxImage         *image,
   gboolean retval;
   GdkPixbuf *pixbuf;
   MxImagePrivate *priv;
+  gchar *shared_key = NULL;
+  gpointer shared_ident = NULL;
 
   if (G_UNLIKELY (!MX_IS_IMAGE (image)))
     {
@@ -1934,18 +4073,46 @@ mx_image_set_from_buffer_at_size (MxImage         *image,
 
   priv = image->priv;
 
+  mx_image_forget_source (image);
+
+  /* Hashing the data is much cheaper than decoding it again */
+  if (priv->shared_cache)
+    {
+      shared_key = mx_image_get_buffer_cache_key (buffer, buffer_size);
+      shared_ident = mx_image_get_shared_cache_ident (image, width, height);
+
+      if (mx_image_set_from_shared_cache (image, shared_key, shared_ident))
+        {
+          g_free (shared_key);
+          if (buffer_free_func)
+            buffer_free_func ((gpointer)buffer);
+          return TRUE;
+        }
+    }
+
   if (priv->load_async)
     return mx_image_set_async (image, NULL, buffer, buffer_size,
-                               buffer_free_func, width, height, error);
+                               buffer_free_func, width, height,
+                               shared_key, shared_ident, error);
 
   pixbuf = mx_image_pixbuf_new (NULL, buffer, buffer_size, width, height,
                                 priv->width_threshold, priv->height_threshold,
-                                priv->upscale, NULL, error);
+                                priv->upscale, priv->use_thumbnails, NULL,
+                                NULL, NULL, NULL, error);
   if (!pixbuf)
-    return FALSE;
+    {
+      g_free (shared_key);
+      return FALSE;
+    }
+
+  mx_image_pixbuf_premultiply (pixbuf);
 
   retval = mx_image_set_from_pixbuf (image, pixbuf, NULL, error);
 
+  if (retval && shared_key)
+    mx_image_share_texture (image, shared_key, shared_ident);
+  g_free (shared_key);
+
   g_object_unref (pixbuf);
 
   if (buffer_free_func)
@@ -1984,11 +4151,8 @@ mx_image_set_load_async (MxImage  *image,
       g_object_notify (G_OBJECT (image), "load-async");
 
       /* Cancel the old transfer if we're turning async off */
-      if (!load_async && priv->async_load_data)
-        {
-          priv->async_load_data->cancelled = TRUE;
-          priv->async_load_data = NULL;
-        }
+      if (!load_async)
+        mx_image_cancel_in_progress (image);
     }
 }
 
@@ -2009,6 +4173,213 @@ mx_image_get_load_async (MxImage *image)
   return image->priv->load_async;
 }
 
+/**
+ * mx_image_set_shared_cache:
+ * @image: A #MxImage
+ * @shared_cache: %TRUE to share images with other #MxImage instances
+ *
+ * Sets whether images loaded at a particular size, or from a buffer, are
+ * shared through the default #MxTextureCache. When set, loading an image
+ * that another image with this property set has already loaded with the
+ * same size, scaling thresholds and upscaling setting reuses its texture
+ * straight away, even when loading asynchronously, in which case no
+ * #MxImage::image-loaded signal is emitted. Buffers are identified by a
+ * hash of their contents.
+ *
+ * Since: 2.0
+ */
+void
+mx_image_set_shared_cache (MxImage  *image,
+                           gboolean  shared_cache)
+{
+  MxImagePrivate *priv;
+
+  g_return_if_fail (MX_IS_IMAGE (image));
+
+  priv = image->priv;
+  if (priv->shared_cache != shared_cache)
+    {
+      priv->shared_cache = shared_cache;
+      g_object_notify (G_OBJECT (image), "shared-cache");
+    }
+}
+
+/**
+ * mx_image_get_shared_cache:
+ * @image: A #MxImage
+ *
+ * Determines whether images are shared through the texture cache. See
+ * mx_image_set_shared_cache().
+ *
+ * Returns: %TRUE if images are shared, %FALSE otherwise
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_image_get_shared_cache (MxImage *image)
+{
+  g_return_val_if_fail (MX_IS_IMAGE (image), FALSE);
+  return image->priv->shared_cache;
+}
+
+/**
+ * mx_image_set_progressive:
+ * @image: A #MxImage
+ * @progressive: %TRUE to show images while they are being decoded
+ *
+ * Sets whether images loaded asynchronously are shown while they are being
+ * decoded, which is useful for large progressive or interlaced images and
+ * for slow storage. The rows decoded so far are uploaded a few times a
+ * second, and the #MxImage::image-loaded signal is still only emitted once
+ * the whole image is decoded.
+ *
+ * Images that are scaled while loading are only shown once decoded, unless
+ * the decoder can scale them itself.
+ *
+ * Since: 2.0
+ */
+void
+mx_image_set_progressive (MxImage  *image,
+                          gboolean  progressive)
+{
+  MxImagePrivate *priv;
+
+  g_return_if_fail (MX_IS_IMAGE (image));
+
+  priv = image->priv;
+  if (priv->progressive != progressive)
+    {
+      priv->progressive = progressive;
+      g_object_notify (G_OBJECT (image), "progressive");
+    }
+}
+
+/**
+ * mx_image_get_progressive:
+ * @image: A #MxImage
+ *
+ * Determines whether images are shown while they are being decoded. See
+ * mx_image_set_progressive().
+ *
+ * Returns: %TRUE if images are shown progressively, %FALSE otherwise
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_image_get_progressive (MxImage *image)
+{
+  g_return_val_if_fail (MX_IS_IMAGE (image), FALSE);
+  return image->priv->progressive;
+}
+
+/**
+ * mx_image_set_use_thumbnails:
+ * @image: A #MxImage
+ * @use_thumbnails: %TRUE to load images from their thumbnails
+ *
+ * Sets whether images loaded at a size with
+ * mx_image_set_from_file_at_size() or mx_image_set_from_buffer_at_size()
+ * are loaded from a thumbnail when there is one at least as big as the
+ * size asked for. The freedesktop.org thumbnail cache is looked up for
+ * files, and the thumbnail stored in the EXIF data of JPEG files is used
+ * otherwise. This is much cheaper than decoding the whole image, at some
+ * cost in quality.
+ *
+ * Since: 2.0
+ */
+void
+mx_image_set_use_thumbnails (MxImage  *image,
+                             gboolean  use_thumbnails)
+{
+  MxImagePrivate *priv;
+
+  g_return_if_fail (MX_IS_IMAGE (image));
+
+  priv = image->priv;
+  if (priv->use_thumbnails != use_thumbnails)
+    {
+      priv->use_thumbnails = use_thumbnails;
+      g_object_notify (G_OBJECT (image), "use-thumbnails");
+    }
+}
+
+/**
+ * mx_image_get_use_thumbnails:
+ * @image: A #MxImage
+ *
+ * Determines whether images are loaded from their thumbnails. See
+ * mx_image_set_use_thumbnails().
+ *
+ * Returns: %TRUE if thumbnails are used, %FALSE otherwise
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_image_get_use_thumbnails (MxImage *image)
+{
+  g_return_val_if_fail (MX_IS_IMAGE (image), FALSE);
+  return image->priv->use_thumbnails;
+}
+
+/**
+ * mx_image_set_adaptive_resolution:
+ * @image: A #MxImage
+ * @adaptive: %TRUE to load images again as they grow
+ *
+ * Sets whether an image set from a file at a size, with
+ * mx_image_set_from_file_at_size(), is loaded again at a larger size when
+ * its content area grows larger than it was loaded at, by more than
+ * #MxImage:scale-width-threshold or #MxImage:scale-height-threshold. The
+ * image is loaded again once it has stopped growing for a moment, and the
+ * image loaded so far is shown until then. When the image shrinks, the
+ * image loaded so far is kept.
+ *
+ * This lets an image be loaded at the size it is first shown at and
+ * still be sharp when it is zoomed in on. As images are loaded again in
+ * the background, this only applies when #MxImage:load-async is set.
+ *
+ * Since: 2.0
+ */
+void
+mx_image_set_adaptive_resolution (MxImage  *image,
+                                  gboolean  adaptive)
+{
+  MxImagePrivate *priv;
+
+  g_return_if_fail (MX_IS_IMAGE (image));
+
+  priv = image->priv;
+  if (priv->adaptive != adaptive)
+    {
+      priv->adaptive = adaptive;
+
+      if (adaptive)
+        clutter_actor_queue_relayout (CLUTTER_ACTOR (image));
+      else
+        _mx_timer_stop (&priv->redecode_timer);
+
+      g_object_notify (G_OBJECT (image), "adaptive-resolution");
+    }
+}
+
+/**
+ * mx_image_get_adaptive_resolution:
+ * @image: A #MxImage
+ *
+ * Determines whether images are loaded again as they grow. See
+ * mx_image_set_adaptive_resolution().
+ *
+ * Returns: %TRUE if images are loaded again as they grow, %FALSE otherwise
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_image_get_adaptive_resolution (MxImage *image)
+{
+  g_return_val_if_fail (MX_IS_IMAGE (image), FALSE);
+  return image->priv->adaptive;
+}
+
 /**
  * mx_image_set_allow_upscale:
  * @image: A #MxImage
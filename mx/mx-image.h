@@ -94,10 +94,22 @@ gboolean mx_image_set_from_data (MxImage          *image,
                                  gint              height,
                                  gint              rowstride,
                                  GError          **error);
+gboolean mx_image_set_from_data_full (MxImage          *image,
+                                      guchar           *data,
+                                      CoglPixelFormat   pixel_format,
+                                      gint              width,
+                                      gint              height,
+                                      gint              rowstride,
+                                      GDestroyNotify    destroy,
+                                      GError          **error);
 
 gboolean mx_image_set_from_file (MxImage      *image,
                                  const gchar  *filename,
                                  GError      **error);
+gboolean mx_image_set_from_animation_file (MxImage      *image,
+                                           const gchar  *filename,
+                                           GError      **error);
+
 gboolean mx_image_set_from_file_at_size (MxImage      *image,
                                          const gchar  *filename,
                                          gint          width,
@@ -106,6 +118,20 @@ gboolean mx_image_set_from_file_at_size (MxImage      *image,
 
 gboolean mx_image_set_from_cogl_texture (MxImage    *image,
                                          CoglHandle  texture);
+gboolean mx_image_set_from_egl_image    (MxImage          *image,
+                                         gpointer          egl_image,
+                                         CoglPixelFormat   pixel_format,
+                                         gint              width,
+                                         gint              height,
+                                         GError          **error);
+gboolean mx_image_set_from_dma_buf      (MxImage          *image,
+                                         gint              fd,
+                                         guint32           fourcc,
+                                         gint              width,
+                                         gint              height,
+                                         gint              offset,
+                                         gint              stride,
+                                         GError          **error);
 
 gboolean mx_image_set_from_buffer (MxImage         *image,
                                    guchar          *buffer,
@@ -134,6 +160,22 @@ void     mx_image_set_load_async (MxImage  *image,
                                   gboolean  load_async);
 gboolean mx_image_get_load_async (MxImage  *image);
 
+void     mx_image_set_shared_cache (MxImage  *image,
+                                    gboolean  shared_cache);
+gboolean mx_image_get_shared_cache (MxImage  *image);
+
+void     mx_image_set_progressive (MxImage  *image,
+                                   gboolean  progressive);
+gboolean mx_image_get_progressive (MxImage  *image);
+
+void     mx_image_set_use_thumbnails (MxImage  *image,
+                                      gboolean  use_thumbnails);
+gboolean mx_image_get_use_thumbnails (MxImage  *image);
+
+void     mx_image_set_adaptive_resolution (MxImage  *image,
+                                           gboolean  adaptive);
+gboolean mx_image_get_adaptive_resolution (MxImage  *image);
+
 void     mx_image_set_allow_upscale (MxImage *image,
                                      gboolean allow);
 gboolean mx_image_get_allow_upscale (MxImage *image);
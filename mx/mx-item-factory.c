@@ -74,3 +74,28 @@ mx_item_factory_create (MxItemFactory *factory)
 {
   return MX_ITEM_FACTORY_GET_IFACE (factory)->create (factory);
 }
+
+/**
+ * mx_item_factory_reset:
+ * @factory: A #MxItemFactory
+ * @item: an item created by @factory
+ *
+ * Resets @item before it is kept to be reused for another row, so that it
+ * stops showing, or holding on to, the content of its last row. Nothing is
+ * done if @factory does not implement the reset virtual function.
+ *
+ * Since: 2.0
+ */
+void
+mx_item_factory_reset (MxItemFactory *factory,
+                       ClutterActor  *item)
+{
+  MxItemFactoryIface *iface;
+
+  g_return_if_fail (MX_IS_ITEM_FACTORY (factory));
+  g_return_if_fail (CLUTTER_IS_ACTOR (item));
+
+  iface = MX_ITEM_FACTORY_GET_IFACE (factory);
+  if (iface->reset)
+    iface->reset (factory, item);
+}
@@ -49,6 +49,8 @@ typedef struct _MxItemFactoryIface MxItemFactoryIface;
 /**
  * MxItemFactoryIface:
  * @create: virtual function called when creating a new item
+ * @reset: virtual function called when an item is kept to be reused, to
+ *   drop the state it was given for its last row. Since: 2.0
  *
  * Interface for creating custom items
  */
@@ -60,10 +62,11 @@ struct _MxItemFactoryIface
   /*< public >*/
   /* vfuncs, not signals */
   ClutterActor *(* create) (MxItemFactory *factory);
+  void          (* reset)  (MxItemFactory *factory,
+                            ClutterActor  *item);
 
   /*< private >*/
   /* padding for future expansion */
-  void (*_padding_0) (void);
   void (*_padding_1) (void);
   void (*_padding_2) (void);
   void (*_padding_3) (void);
@@ -73,5 +76,7 @@ struct _MxItemFactoryIface
 GType mx_item_factory_get_type (void) G_GNUC_CONST;
 
 ClutterActor *mx_item_factory_create (MxItemFactory *factory);
+void          mx_item_factory_reset  (MxItemFactory *factory,
+                                      ClutterActor  *item);
 
 #endif
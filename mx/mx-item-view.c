@@ -32,6 +32,11 @@
  *
  * Data is set on the children by mapping columns in the model to object
  * properties on the children.
+ *
+ * The view can also be driven by a #GListModel, set with
+ * mx_item_view_set_list_model(). Each child is then given the item of its
+ * row through the property named by #MxItemView:item-property, and the
+ * changes of the model are applied to the children they concern only.
  */
 
 #include "mx-item-view.h"
@@ -42,19 +47,18 @@ G_DEFINE_TYPE (MxItemView, mx_item_view, MX_TYPE_GRID)
 #define ITEM_VIEW_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_ITEM_VIEW, MxItemViewPrivate))
 
-typedef struct
-{
-  gchar *name;
-  gint   col;
-} AttributeData;
-
 enum
 {
   PROP_0,
 
   PROP_MODEL,
   PROP_ITEM_TYPE,
-  PROP_FACTORY
+  PROP_FACTORY,
+  PROP_RECYCLE_SIZE,
+  PROP_PROGRESSIVE,
+  PROP_LIST_MODEL,
+  PROP_ITEM_PROPERTY,
+  PROP_KEY_COLUMN
 };
 
 struct _MxItemViewPrivate
@@ -71,9 +75,36 @@ struct _MxItemViewPrivate
   gulong         row_removed;
   gulong         sort_changed;
 
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  /* set instead of the model, the items of which are set on the
+   * item_property of the children */
+  GListModel    *list_model;
+#endif
+  gchar         *item_property;
+
+  /* the column the children are matched to their rows by when the model
+   * is sorted or filtered, or -1 */
+  gint           key_column;
+
+  /* children kept after they were removed, to be used again for other
+   * rows instead of creating new ones */
+  GQueue         recycled;
+  guint          recycle_size;
+
+  /* when progressive, the row the next operation of the stage's actor
+   * manager creates or binds a child for */
+  MxActorManager *manager;
+  gulong         progressive_op;
+  gint           progressive_row;
+
   guint          is_frozen : 1;
+  guint          progressive : 1;
 };
 
+static void mx_item_view_clear_recycled (MxItemView *item_view,
+                                         guint       keep);
+static void mx_item_view_stop_progressive (MxItemView *item_view);
+
 /* gobject implementations */
 
 static void
@@ -94,6 +125,23 @@ mx_item_view_get_property (GObject    *object,
     case PROP_FACTORY:
       g_value_set_object (value, priv->factory);
       break;
+    case PROP_RECYCLE_SIZE:
+      g_value_set_uint (value, priv->recycle_size);
+      break;
+    case PROP_PROGRESSIVE:
+      g_value_set_boolean (value, priv->progressive);
+      break;
+#if GLIB_CHECK_VERSION (2, 44, 0)
+    case PROP_LIST_MODEL:
+      g_value_set_object (value, priv->list_model);
+      break;
+#endif
+    case PROP_ITEM_PROPERTY:
+      g_value_set_string (value, priv->item_property);
+      break;
+    case PROP_KEY_COLUMN:
+      g_value_set_int (value, priv->key_column);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -119,6 +167,28 @@ mx_item_view_set_property (GObject      *object,
       mx_item_view_set_factory ((MxItemView*) object,
                                 (MxItemFactory*) g_value_get_object (value));
       break;
+    case PROP_RECYCLE_SIZE:
+      mx_item_view_set_recycle_size ((MxItemView*) object,
+                                     g_value_get_uint (value));
+      break;
+    case PROP_PROGRESSIVE:
+      mx_item_view_set_progressive ((MxItemView*) object,
+                                    g_value_get_boolean (value));
+      break;
+#if GLIB_CHECK_VERSION (2, 44, 0)
+    case PROP_LIST_MODEL:
+      mx_item_view_set_list_model ((MxItemView*) object,
+                                   g_value_get_object (value));
+      break;
+#endif
+    case PROP_ITEM_PROPERTY:
+      mx_item_view_set_item_property ((MxItemView*) object,
+                                      g_value_get_string (value));
+      break;
+    case PROP_KEY_COLUMN:
+      mx_item_view_set_key_column ((MxItemView*) object,
+                                 g_value_get_int (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -129,6 +199,12 @@ mx_item_view_dispose (GObject *object)
 {
   /* This will cause the unref of the model and also disconnect the signals */
   mx_item_view_set_model (MX_ITEM_VIEW (object), NULL);
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  mx_item_view_set_list_model (MX_ITEM_VIEW (object), NULL);
+#endif
+
+  mx_item_view_stop_progressive (MX_ITEM_VIEW (object));
+  mx_item_view_clear_recycled (MX_ITEM_VIEW (object), 0);
 
   G_OBJECT_CLASS (mx_item_view_parent_class)->dispose (object);
 }
@@ -138,9 +214,12 @@ mx_item_view_finalize (GObject *object)
 {
   MxItemViewPrivate *priv = MX_ITEM_VIEW (object)->priv;
 
+  g_free (priv->item_property);
+
   if (priv->attributes)
     {
-      g_slist_foreach (priv->attributes, (GFunc) g_free, NULL);
+      g_slist_foreach (priv->attributes, (GFunc) _mx_item_attribute_free,
+                       NULL);
       g_slist_free (priv->attributes);
       priv->attributes = NULL;
     }
@@ -186,24 +265,253 @@ mx_item_view_class_init (MxItemViewClass *klass)
                                G_TYPE_OBJECT /*MX_TYPE_ITEM_FACTORY*/,
                                MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, PROP_FACTORY, pspec);
+
+  pspec = g_param_spec_uint ("recycle-size",
+                             "Recycle size",
+                             "The number of removed items kept to be "
+                             "reused for other rows",
+                             0, G_MAXUINT, 0,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_RECYCLE_SIZE, pspec);
+
+  pspec = g_param_spec_boolean ("progressive",
+                                "Progressive",
+                                "Whether to create and bind the items over "
+                                "several frames, through the actor manager "
+                                "of the stage",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_PROGRESSIVE, pspec);
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  pspec = g_param_spec_object ("list-model",
+                               "List model",
+                               "The list model for the view, used instead "
+                               "of the model",
+                               G_TYPE_LIST_MODEL,
+                               MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_LIST_MODEL, pspec);
+#endif
+
+  pspec = g_param_spec_string ("item-property",
+                               "Item property",
+                               "The property of the items that is set to "
+                               "the item of their row in the list model",
+                               "item",
+                               MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_ITEM_PROPERTY, pspec);
+
+  pspec = g_param_spec_int ("key-column",
+                            "Key column",
+                            "The column of the model that identifies the "
+                            "rows when it is sorted or filtered, or -1",
+                            -1, G_MAXINT, -1,
+                            MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_KEY_COLUMN, pspec);
 }
 
 static void
 mx_item_view_init (MxItemView *item_view)
 {
   item_view->priv = ITEM_VIEW_PRIVATE (item_view);
+
+  g_queue_init (&item_view->priv->recycled);
+  item_view->priv->item_property = g_strdup ("item");
+  item_view->priv->key_column = -1;
+}
+
+
+/* Destroys the recycled children, until only @keep are left */
+static void
+mx_item_view_clear_recycled (MxItemView   *item_view,
+                             guint         keep)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+
+  while (priv->recycled.length > keep)
+    {
+      ClutterActor *child = g_queue_pop_tail (&priv->recycled);
+
+      clutter_actor_destroy (child);
+      g_object_unref (child);
+    }
+}
+
+/* Removes @child from the view, keeping it to be reused if there is room
+ * for it in the recycled children */
+static void
+mx_item_view_release_item (MxItemView   *item_view,
+                           ClutterActor *child)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+
+  if (priv->recycled.length >= priv->recycle_size)
+    {
+      clutter_actor_remove_child (CLUTTER_ACTOR (item_view), child);
+      return;
+    }
+
+  g_object_ref (child);
+  clutter_actor_remove_child (CLUTTER_ACTOR (item_view), child);
+
+  if (priv->factory)
+    mx_item_factory_reset (priv->factory, child);
+
+  g_queue_push_head (&priv->recycled, child);
+}
+
+static ClutterActor *
+mx_item_view_create_item (MxItemView *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+  ClutterActor *child;
+
+  /* the children that were kept are given back as new, floating ones */
+  child = g_queue_pop_head (&priv->recycled);
+  if (child)
+    {
+      g_object_force_floating (G_OBJECT (child));
+      return child;
+    }
+
+  if (priv->item_type)
+    return g_object_new (priv->item_type, NULL);
+  else
+    return mx_item_factory_create (priv->factory);
+}
+
+static void
+mx_item_view_set_item_values (MxItemView       *item_view,
+                              GObject          *child,
+                              ClutterModelIter *iter)
+{
+  _mx_item_attributes_set (item_view->priv->attributes, child, iter);
+
+  if (item_view->priv->key_column >= 0)
+    _mx_item_set_key (child, iter, item_view->priv->key_column);
+}
+
+static gint
+mx_item_view_get_n_rows (MxItemView *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  if (priv->list_model)
+    return g_list_model_get_n_items (priv->list_model);
+#endif
+
+  return priv->model ? clutter_model_get_n_rows (priv->model) : 0;
+}
+
+/* Sets the values of the rows from @row on @child and the children after
+ * it, for @n_children of them, or all of them if @n_children is -1 */
+static void
+mx_item_view_bind_rows (MxItemView   *item_view,
+                        ClutterActor *child,
+                        gint          row,
+                        gint          n_children)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+  ClutterModelIter *iter;
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  if (priv->list_model)
+    {
+      gint n_rows = g_list_model_get_n_items (priv->list_model);
+
+      for (; child && n_children && row < n_rows;
+           child = clutter_actor_get_next_sibling (child), row++, n_children--)
+        _mx_item_set_list_item (G_OBJECT (child), priv->item_property,
+                                priv->list_model, row);
+      return;
+    }
+#endif
+
+  if (!priv->model)
+    return;
+
+  iter = clutter_model_get_iter_at_row (priv->model, row);
+
+  for (; child && n_children && iter && !clutter_model_iter_is_last (iter);
+       child = clutter_actor_get_next_sibling (child), n_children--)
+    {
+      mx_item_view_set_item_values (item_view, G_OBJECT (child), iter);
+      clutter_model_iter_next (iter);
+    }
+
+  if (iter)
+    g_object_unref (iter);
+}
+
+static void
+mx_item_view_stop_progressive (MxItemView *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+
+  /* the operations are all cancelled already if the stage is gone */
+  if (priv->progressive_op && mx_actor_manager_get_stage (priv->manager))
+    mx_actor_manager_cancel_operation (priv->manager, priv->progressive_op);
+  priv->progressive_op = 0;
+
+  if (priv->manager)
+    {
+      g_object_unref (priv->manager);
+      priv->manager = NULL;
+    }
 }
 
+/* Creates or binds the child of one row, and asks for the next one; as the
+ * actor manager only runs operations for its time slice in each frame,
+ * this spreads the population of the view over frames */
+static ClutterActor *
+mx_item_view_progressive_cb (MxActorManager *manager,
+                             gpointer        user_data)
+{
+  MxItemView *item_view = user_data;
+  MxItemViewPrivate *priv = item_view->priv;
+  ClutterActor *child;
+  gint row, model_n;
+
+  priv->progressive_op = 0;
+  row = priv->progressive_row++;
+
+  child = _mx_actor_get_child_at_index (CLUTTER_ACTOR (item_view), row);
+  if (!child)
+    {
+      child = mx_item_view_create_item (item_view);
+      clutter_actor_add_child (CLUTTER_ACTOR (item_view), child);
+    }
+
+  mx_item_view_bind_rows (item_view, child, row, 1);
+
+  model_n = mx_item_view_get_n_rows (item_view);
+  if (priv->progressive_row < model_n)
+    {
+      priv->progressive_op =
+        mx_actor_manager_create_actor (manager, mx_item_view_progressive_cb,
+                                       item_view, NULL);
+      return child;
+    }
+
+  /* rows may have been removed since the population started */
+  while (clutter_actor_get_n_children (CLUTTER_ACTOR (item_view)) > model_n)
+    mx_item_view_release_item (item_view,
+                         clutter_actor_get_last_child (
+                           CLUTTER_ACTOR (item_view)));
+
+  g_object_unref (priv->manager);
+  priv->manager = NULL;
+
+  return child;
+}
 
 /* model monitors */
 static void
 model_changed_cb (ClutterModel *model,
                   MxItemView   *item_view)
 {
-  GSList *p;
-  GList *l, *children;
   MxItemViewPrivate *priv = item_view->priv;
-  ClutterModelIter *iter = NULL;
   gint model_n = 0, child_n = 0;
 
 
@@ -214,6 +522,8 @@ model_changed_cb (ClutterModel *model,
   if (priv->is_frozen)
     return;
 
+  mx_item_view_stop_progressive (item_view);
+
   if (priv->item_type)
     {
       /* check the item-type is an descendant of ClutterActor */
@@ -226,87 +536,113 @@ model_changed_cb (ClutterModel *model,
         }
     }
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (item_view));
-  child_n = g_list_length (children);
+  child_n = clutter_actor_get_n_children (CLUTTER_ACTOR (item_view));
+  model_n = mx_item_view_get_n_rows (item_view);
 
-  if (model)
-    model_n = clutter_model_get_n_rows (priv->model);
-  else
-    model_n = 0;
+  /* when progressive, the children are created and bound from the first
+   * row by the actor manager, after the extra ones are removed below */
+  if (priv->progressive && model_n &&
+      clutter_actor_get_stage (CLUTTER_ACTOR (item_view)))
+    {
+      priv->manager = mx_actor_manager_get_for_stage (
+        CLUTTER_STAGE (clutter_actor_get_stage (CLUTTER_ACTOR (item_view))));
+      g_object_ref (priv->manager);
+
+      priv->progressive_row = 0;
+      priv->progressive_op =
+        mx_actor_manager_create_actor (priv->manager,
+                                       mx_item_view_progressive_cb,
+                                       item_view, NULL);
+      model_n = child_n;
+    }
 
   /* add children as needed */
   while (model_n > child_n)
     {
-      ClutterActor *new_child;
-
-      if (priv->item_type)
-        {
-          new_child = g_object_new (priv->item_type, NULL);
-        }
-      else
-        {
-          new_child = mx_item_factory_create (priv->factory);
-        }
+      ClutterActor *new_child = mx_item_view_create_item (item_view);
 
       clutter_actor_add_child (CLUTTER_ACTOR (item_view), new_child);
       child_n++;
     }
 
   /* remove children as needed */
-  l = g_list_last (children);
   while (child_n > model_n)
     {
-      clutter_actor_remove_child (CLUTTER_ACTOR (item_view), l->data);
-      l = g_list_previous (l);
+      mx_item_view_release_item (item_view,
+                           clutter_actor_get_last_child (
+                             CLUTTER_ACTOR (item_view)));
       child_n--;
     }
 
-  g_list_free (children);
-
-  if (!priv->model)
+  if (priv->progressive_op)
     return;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (item_view));
-
   /* set the properties on the children */
-  iter = clutter_model_get_first_iter (priv->model);
-  l = children;
-  while (iter && !clutter_model_iter_is_last (iter))
-    {
-      GObject *child;
-
-      child = G_OBJECT (l->data);
-
-      g_object_freeze_notify (child);
-      for (p = priv->attributes; p; p = p->next)
-        {
-          GValue value = { 0, };
-          AttributeData *attr = p->data;
-
-          clutter_model_iter_get_value (iter, attr->col, &value);
+  mx_item_view_bind_rows (item_view,
+                          clutter_actor_get_first_child (
+                            CLUTTER_ACTOR (item_view)),
+                          0, -1);
+}
 
-          g_object_set_property (child, attr->name, &value);
+/* Only the child of the row is updated, unless the children don't match
+ * the rows, in which case everything is */
+static void
+row_changed_cb (ClutterModel     *model,
+                ClutterModelIter *iter,
+                MxItemView       *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+  ClutterActor *child;
 
-          g_value_unset (&value);
-        }
-      g_object_thaw_notify (child);
+  if (priv->is_frozen || !priv->attributes)
+    return;
 
-      l = g_list_next (l);
-      clutter_model_iter_next (iter);
+  if (clutter_model_get_filter_set (model) ||
+      (!priv->progressive_op &&
+       clutter_actor_get_n_children (CLUTTER_ACTOR (item_view)) !=
+       clutter_model_get_n_rows (model)))
+    {
+      model_changed_cb (model, item_view);
+      return;
     }
 
-  g_list_free (children);
+  /* the rows without children are bound when they are created */
+  if (priv->progressive_op &&
+      clutter_model_iter_get_row (iter) >= priv->progressive_row)
+    return;
 
-  if (iter)
-    g_object_unref (iter);
+  child = _mx_actor_get_child_at_index (CLUTTER_ACTOR (item_view),
+                                        clutter_model_iter_get_row (iter));
+  if (child)
+    mx_item_view_set_item_values (item_view, G_OBJECT (child), iter);
 }
 
+/* A child is inserted for the new row, where it is in the model */
 static void
-row_changed_cb (ClutterModel     *model,
-                ClutterModelIter *iter,
-                MxItemView       *item_view)
+row_added_cb (ClutterModel     *model,
+              ClutterModelIter *iter,
+              MxItemView       *item_view)
 {
-  model_changed_cb (model, item_view);
+  MxItemViewPrivate *priv = item_view->priv;
+  ClutterActor *child;
+
+  if (priv->is_frozen || (!priv->item_type && !priv->factory))
+    return;
+
+  /* the row may be filtered out, and the children must already match the
+   * other rows */
+  if (priv->progressive_op || clutter_model_get_filter_set (model) ||
+      clutter_actor_get_n_children (CLUTTER_ACTOR (item_view)) !=
+      clutter_model_get_n_rows (model) - 1)
+    {
+      model_changed_cb (model, item_view);
+      return;
+    }
+
+  child = mx_item_view_create_item (item_view);
+  clutter_actor_insert_child_at_index (CLUTTER_ACTOR (item_view), child,
+                                       clutter_model_iter_get_row (iter));
+  mx_item_view_set_item_values (item_view, G_OBJECT (child), iter);
 }
 
 static void
@@ -314,20 +650,158 @@ row_removed_cb (ClutterModel     *model,
                 ClutterModelIter *iter,
                 MxItemView       *item_view)
 {
-  GList *children;
-  GList *l;
   ClutterActor *child;
 
   if (item_view->priv->is_frozen)
     return;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (item_view));
-  l = g_list_nth (children, clutter_model_iter_get_row (iter));
-  child = (ClutterActor *) l->data;
-  clutter_actor_remove_child (CLUTTER_ACTOR (item_view), child);
-  g_list_free (children);
+  /* the population goes on from the same row, and the extra children are
+   * removed at the end */
+  if (item_view->priv->progressive_op)
+    {
+      if (clutter_model_iter_get_row (iter) >= item_view->priv->progressive_row)
+        return;
+      item_view->priv->progressive_row--;
+    }
+
+  child = _mx_actor_get_child_at_index (CLUTTER_ACTOR (item_view),
+                                        clutter_model_iter_get_row (iter));
+  if (child)
+    mx_item_view_release_item (item_view, child);
 }
 
+/* With a key column, the children are moved to the rows with their keys as
+ * the rows are sorted or filtered, and only the rows whose keys have no
+ * child are bound, to the children that are left over or to new ones */
+static void
+model_reordered_cb (ClutterModel *model,
+                    MxItemView   *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+  ClutterActor *self = CLUTTER_ACTOR (item_view);
+  ClutterActor *child, *prev;
+  ClutterModelIter *iter;
+  GQueue unmatched = G_QUEUE_INIT;
+  GPtrArray *rows;
+  guint i;
+
+  if (priv->is_frozen || (!priv->item_type && !priv->factory))
+    return;
+
+  /* a population in progress starts over */
+  if (priv->key_column < 0 || priv->progressive_op)
+    {
+      model_changed_cb (model, item_view);
+      return;
+    }
+
+  rows = _mx_item_match_rows (self, model, priv->key_column, &unmatched);
+
+  iter = clutter_model_get_first_iter (model);
+  prev = NULL;
+
+  for (i = 0; i < rows->len; i++, clutter_model_iter_next (iter))
+    {
+      child = g_ptr_array_index (rows, i);
+
+      if (!child)
+        {
+          child = g_queue_pop_head (&unmatched);
+          if (!child)
+            {
+              child = mx_item_view_create_item (item_view);
+              if (prev)
+                clutter_actor_insert_child_above (self, child, prev);
+              else
+                clutter_actor_insert_child_below (self, child, NULL);
+            }
+
+          mx_item_view_set_item_values (item_view, G_OBJECT (child), iter);
+        }
+
+      if (clutter_actor_get_previous_sibling (child) != prev)
+        {
+          if (prev)
+            clutter_actor_set_child_above_sibling (self, child, prev);
+          else
+            clutter_actor_set_child_below_sibling (self, child, NULL);
+        }
+
+      prev = child;
+    }
+
+  while ((child = g_queue_pop_head (&unmatched)))
+    mx_item_view_release_item (item_view, child);
+
+  if (iter)
+    g_object_unref (iter);
+  g_ptr_array_free (rows, TRUE);
+}
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+/* The children of the changed rows are spliced in one go: as many as can
+ * be are bound to the new rows where they are, and only the difference is
+ * removed or created, so that the cost is in the number of changed rows */
+static void
+items_changed_cb (GListModel *model,
+                  guint       position,
+                  guint       removed,
+                  guint       added,
+                  MxItemView *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+  ClutterActor *self = CLUTTER_ACTOR (item_view);
+  ClutterActor *child, *prev;
+  guint i;
+
+  if (priv->is_frozen || (!priv->item_type && !priv->factory))
+    return;
+
+  /* the children must match the rows as they were before the change */
+  if (priv->progressive_op ||
+      clutter_actor_get_n_children (self) !=
+      (gint) (g_list_model_get_n_items (model) - added + removed))
+    {
+      model_changed_cb (NULL, item_view);
+      return;
+    }
+
+  prev = position ? _mx_actor_get_child_at_index (self, position - 1) : NULL;
+  child = prev ? clutter_actor_get_next_sibling (prev)
+    : clutter_actor_get_first_child (self);
+
+  for (i = 0; i < MIN (removed, added); i++)
+    {
+      _mx_item_set_list_item (G_OBJECT (child), priv->item_property,
+                              model, position + i);
+      prev = child;
+      child = clutter_actor_get_next_sibling (child);
+    }
+
+  for (; i < removed; i++)
+    {
+      ClutterActor *next = clutter_actor_get_next_sibling (child);
+
+      mx_item_view_release_item (item_view, child);
+      child = next;
+    }
+
+  for (; i < added; i++)
+    {
+      child = mx_item_view_create_item (item_view);
+
+      if (prev)
+        clutter_actor_insert_child_above (self, child, prev);
+      else
+        clutter_actor_insert_child_below (self, child, NULL);
+
+      _mx_item_set_list_item (G_OBJECT (child), priv->item_property,
+                              model, position + i);
+      prev = child;
+    }
+}
+#endif
+
 /* public api */
 
 /**
@@ -376,6 +850,7 @@ mx_item_view_set_item_type (MxItemView *item_view,
   g_return_if_fail (g_type_is_a (item_type, CLUTTER_TYPE_ACTOR));
 
   item_view->priv->item_type = item_type;
+  mx_item_view_clear_recycled (item_view, 0);
 
   /* update the view */
   model_changed_cb (item_view->priv->model, item_view);
@@ -420,6 +895,12 @@ mx_item_view_set_model (MxItemView   *item_view,
       g_signal_handlers_disconnect_by_func (priv->model,
                                             (GCallback) model_changed_cb,
                                             item_view);
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) model_reordered_cb,
+                                            item_view);
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) row_added_cb,
+                                            item_view);
       g_signal_handlers_disconnect_by_func (priv->model,
                                             (GCallback) row_changed_cb,
                                             item_view);
@@ -435,16 +916,21 @@ mx_item_view_set_model (MxItemView   *item_view,
     {
       g_return_if_fail (CLUTTER_IS_MODEL (model));
 
+#if GLIB_CHECK_VERSION (2, 44, 0)
+      /* only one of the models drives the view */
+      mx_item_view_set_list_model (item_view, NULL);
+#endif
+
       priv->model = g_object_ref (model);
 
       priv->filter_changed = g_signal_connect (priv->model,
                                                "filter-changed",
-                                               G_CALLBACK (model_changed_cb),
+                                               G_CALLBACK (model_reordered_cb),
                                                item_view);
 
       priv->row_added = g_signal_connect (priv->model,
                                           "row-added",
-                                          G_CALLBACK (row_changed_cb),
+                                          G_CALLBACK (row_added_cb),
                                           item_view);
 
       priv->row_changed = g_signal_connect (priv->model,
@@ -463,7 +949,7 @@ mx_item_view_set_model (MxItemView   *item_view,
 
       priv->sort_changed = g_signal_connect (priv->model,
                                              "sort-changed",
-                                             G_CALLBACK (model_changed_cb),
+                                             G_CALLBACK (model_reordered_cb),
                                              item_view);
 
       /*
@@ -474,6 +960,194 @@ mx_item_view_set_model (MxItemView   *item_view,
     }
 }
 
+#if GLIB_CHECK_VERSION (2, 44, 0)
+/**
+ * mx_item_view_get_list_model:
+ * @item_view: An #MxItemView
+ *
+ * Get the list model currently used by the #MxItemView
+ *
+ * Returns: (transfer none): the current #GListModel, or %NULL
+ *
+ * Since: 2.0
+ */
+GListModel *
+mx_item_view_get_list_model (MxItemView *item_view)
+{
+  g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), NULL);
+
+  return item_view->priv->list_model;
+}
+
+/**
+ * mx_item_view_set_list_model:
+ * @item_view: An #MxItemView
+ * @model: (allow-none): A #GListModel
+ *
+ * Set a list model to drive @item_view, instead of a #ClutterModel. Each
+ * child is given the item of its row through the property named by
+ * #MxItemView:item-property; the attributes only apply to a #ClutterModel.
+ *
+ * Insertions, removals and reorders of the model that come as one
+ * #GListModel::items-changed signal are applied to the children as one
+ * change, creating, removing or binding again only the children of the
+ * rows that changed.
+ *
+ * Since: 2.0
+ */
+void
+mx_item_view_set_list_model (MxItemView *item_view,
+                             GListModel *model)
+{
+  MxItemViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
+  g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
+
+  priv = item_view->priv;
+
+  if (priv->list_model == model)
+    return;
+
+  if (priv->list_model)
+    {
+      g_signal_handlers_disconnect_by_func (priv->list_model,
+                                            (GCallback) items_changed_cb,
+                                            item_view);
+      g_object_unref (priv->list_model);
+
+      priv->list_model = NULL;
+    }
+
+  if (model)
+    {
+      mx_item_view_set_model (item_view, NULL);
+
+      priv->list_model = g_object_ref (model);
+      g_signal_connect (priv->list_model, "items-changed",
+                        G_CALLBACK (items_changed_cb), item_view);
+
+      /* as with mx_item_view_set_model(), unsetting the model leaves the
+       * view as it is */
+      model_changed_cb (NULL, item_view);
+    }
+
+  g_object_notify (G_OBJECT (item_view), "list-model");
+}
+#endif
+
+/**
+ * mx_item_view_get_item_property:
+ * @item_view: An #MxItemView
+ *
+ * Get the name of the property of the children that is set to the item of
+ * their row, when @item_view is driven by a #GListModel
+ *
+ * Returns: the name of the property, or %NULL
+ *
+ * Since: 2.0
+ */
+const gchar *
+mx_item_view_get_item_property (MxItemView *item_view)
+{
+  g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), NULL);
+
+  return item_view->priv->item_property;
+}
+
+/**
+ * mx_item_view_set_item_property:
+ * @item_view: An #MxItemView
+ * @property: (allow-none): the name of a property of the children
+ *
+ * Set the name of the property of the children that is set to the item of
+ * their row, when @item_view is driven by a #GListModel. This is "item" by
+ * default; with %NULL, the children are not given their items.
+ *
+ * Since: 2.0
+ */
+void
+mx_item_view_set_item_property (MxItemView  *item_view,
+                                const gchar *property)
+{
+  MxItemViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
+
+  priv = item_view->priv;
+
+  if (!g_strcmp0 (priv->item_property, property))
+    return;
+
+  g_free (priv->item_property);
+  priv->item_property = g_strdup (property);
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  if (priv->list_model)
+    model_changed_cb (NULL, item_view);
+#endif
+
+  g_object_notify (G_OBJECT (item_view), "item-property");
+}
+
+/**
+ * mx_item_view_set_key_column:
+ * @item_view: An #MxItemView
+ * @column: a column of the model, or -1
+ *
+ * Set the column of the model whose values identify its rows. When the
+ * model is then sorted or filtered, the children are moved to the rows
+ * with their keys rather than all bound again, and only the rows that
+ * had no child before are bound.
+ *
+ * The values of the column should be unique; strings and numbers are
+ * compared by value, objects and pointers by address.
+ *
+ * Since: 2.0
+ */
+void
+mx_item_view_set_key_column (MxItemView *item_view,
+                            gint        column)
+{
+  MxItemViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
+  g_return_if_fail (column >= -1);
+
+  priv = item_view->priv;
+
+  if (priv->key_column == column)
+    return;
+
+  priv->key_column = column;
+
+  /* the keys are recorded as the children are bound; the values that are
+   * unchanged aren't set again */
+  if (column >= 0 && priv->model)
+    model_changed_cb (priv->model, item_view);
+
+  g_object_notify (G_OBJECT (item_view), "key-column");
+}
+
+/**
+ * mx_item_view_get_key_column:
+ * @item_view: An #MxItemView
+ *
+ * Get the column of the model that identifies its rows, see
+ * mx_item_view_set_key_column().
+ *
+ * Returns: the key column, or -1
+ *
+ * Since: 2.0
+ */
+gint
+mx_item_view_get_key_column (MxItemView *item_view)
+{
+  g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), -1);
+
+  return item_view->priv->key_column;
+}
+
 /**
  * mx_item_view_add_attribute:
  * @item_view: An #MxItemView
@@ -490,7 +1164,7 @@ mx_item_view_add_attribute (MxItemView  *item_view,
                             gint         column)
 {
   MxItemViewPrivate *priv;
-  AttributeData *prop;
+  MxItemAttribute *prop;
 
   g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
   g_return_if_fail (_attribute != NULL);
@@ -498,9 +1172,8 @@ mx_item_view_add_attribute (MxItemView  *item_view,
 
   priv = item_view->priv;
 
-  prop = g_new (AttributeData, 1);
-  prop->name = g_strdup (_attribute);
-  prop->col = column;
+  /* the property is looked up now if the type of the items is known */
+  prop = _mx_item_attribute_new (_attribute, column, priv->item_type);
 
   priv->attributes = g_slist_prepend (priv->attributes, prop);
   model_changed_cb (priv->model, item_view);
@@ -573,6 +1246,9 @@ mx_item_view_set_factory (MxItemView    *item_view,
   if (factory)
     priv->factory = g_object_ref (factory);
 
+  /* the recycled children were made by the old factory */
+  mx_item_view_clear_recycled (item_view, 0);
+
   g_object_notify (G_OBJECT (item_view), "factory");
 }
 
@@ -590,3 +1266,111 @@ mx_item_view_get_factory (MxItemView *item_view)
   g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), NULL);
   return item_view->priv->factory;
 }
+
+/**
+ * mx_item_view_set_recycle_size:
+ * @item_view: A #MxItemView
+ * @recycle_size: the number of items to keep
+ *
+ * Sets how many of the items removed from @item_view, when rows are removed
+ * or filtered out, are kept to be reused for other rows rather than
+ * destroyed. Reused items are given the values of their new row, and are
+ * first reset with mx_item_factory_reset() when a factory is used.
+ *
+ * The default is 0, so that no items are kept.
+ *
+ * Since: 2.0
+ */
+void
+mx_item_view_set_recycle_size (MxItemView *item_view,
+                               guint       recycle_size)
+{
+  MxItemViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
+
+  priv = item_view->priv;
+
+  if (priv->recycle_size == recycle_size)
+    return;
+
+  priv->recycle_size = recycle_size;
+  mx_item_view_clear_recycled (item_view, recycle_size);
+
+  g_object_notify (G_OBJECT (item_view), "recycle-size");
+}
+
+/**
+ * mx_item_view_get_recycle_size:
+ * @item_view: A #MxItemView
+ *
+ * Gets how many removed items are kept to be reused, see
+ * mx_item_view_set_recycle_size().
+ *
+ * Returns: the number of items kept
+ *
+ * Since: 2.0
+ */
+guint
+mx_item_view_get_recycle_size (MxItemView *item_view)
+{
+  g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), 0);
+
+  return item_view->priv->recycle_size;
+}
+
+/**
+ * mx_item_view_set_progressive:
+ * @item_view: A #MxItemView
+ * @progressive: %TRUE to populate @item_view over several frames
+ *
+ * Sets whether the items of @item_view are created and given the values of
+ * their rows by the #MxActorManager of its stage, when the whole model
+ * has to be shown again, rather than all at once. The manager only spends
+ * its time slice on them in each frame, see
+ * mx_actor_manager_set_time_slice(), so that large models don't stop the
+ * user interface while the items are created. Changes to single rows are
+ * still applied straight away.
+ *
+ * Since: 2.0
+ */
+void
+mx_item_view_set_progressive (MxItemView *item_view,
+                              gboolean    progressive)
+{
+  MxItemViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
+
+  priv = item_view->priv;
+
+  if (priv->progressive == progressive)
+    return;
+
+  priv->progressive = progressive;
+
+  /* finish what is left at once */
+  if (!progressive && priv->progressive_op)
+    model_changed_cb (priv->model, item_view);
+
+  g_object_notify (G_OBJECT (item_view), "progressive");
+}
+
+/**
+ * mx_item_view_get_progressive:
+ * @item_view: A #MxItemView
+ *
+ * Gets whether the items of @item_view are created over several frames, see
+ * mx_item_view_set_progressive().
+ *
+ * Returns: %TRUE if @item_view is progressive
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_item_view_get_progressive (MxItemView *item_view)
+{
+  g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), FALSE);
+
+  return item_view->priv->progressive;
+}
@@ -30,6 +30,7 @@
 #define _MX_ITEM_VIEW_H
 
 #include <glib-object.h>
+#include <gio/gio.h>
 
 #include "mx-grid.h"
 #include "mx-item-factory.h"
@@ -92,6 +93,19 @@ void          mx_item_view_set_model     (MxItemView    *item_view,
                                           ClutterModel  *model);
 ClutterModel* mx_item_view_get_model     (MxItemView    *item_view);
 
+#if GLIB_CHECK_VERSION (2, 44, 0)
+void          mx_item_view_set_list_model (MxItemView   *item_view,
+                                           GListModel   *model);
+GListModel   *mx_item_view_get_list_model (MxItemView   *item_view);
+#endif
+void          mx_item_view_set_item_property (MxItemView  *item_view,
+                                              const gchar *property);
+const gchar  *mx_item_view_get_item_property (MxItemView  *item_view);
+
+void          mx_item_view_set_key_column (MxItemView *item_view,
+                                           gint        column);
+gint          mx_item_view_get_key_column (MxItemView *item_view);
+
 void          mx_item_view_set_item_type (MxItemView    *item_view,
                                           GType          item_type);
 GType         mx_item_view_get_item_type (MxItemView    *item_view);
@@ -106,6 +120,14 @@ void          mx_item_view_set_factory   (MxItemView    *item_view,
                                           MxItemFactory *factory);
 MxItemFactory* mx_item_view_get_factory  (MxItemView    *item_view);
 
+void          mx_item_view_set_recycle_size (MxItemView *item_view,
+                                             guint       recycle_size);
+guint         mx_item_view_get_recycle_size (MxItemView *item_view);
+
+void          mx_item_view_set_progressive (MxItemView *item_view,
+                                        gboolean    progressive);
+gboolean      mx_item_view_get_progressive (MxItemView *item_view);
+
 G_END_DECLS
 
 #endif /* _MX_ITEM_VIEW_H */
@@ -43,6 +43,7 @@
 #include "mx-private.h"
 #include "mx-scrollable.h"
 #include "mx-focusable.h"
+#include "mx-tile-cache.h"
 #include <math.h>
 
 #define _KINETIC_DEBUG 0
@@ -65,9 +66,18 @@ typedef struct {
   /* Units to store the origin of a click when scrolling */
   gfloat   x;
   gfloat   y;
-  GTimeVal time;
+  gint64   time;
 } MxKineticScrollViewMotion;
 
+/* The motion events kept to work out the velocity of a fling, which is
+ * fitted to those of the last MX_KINETIC_VELOCITY_WINDOW microseconds */
+#define MX_KINETIC_N_MOTIONS       16
+#define MX_KINETIC_VELOCITY_WINDOW (100 * 1000)
+
+/* The furthest ahead of the last motion event a drag may be predicted, in
+ * milliseconds */
+#define MX_KINETIC_MAX_PREDICTION  50
+
 typedef enum {
   MX_AUTOMATIC_SCROLL_NONE,
   MX_AUTOMATIC_SCROLL_HORIZONTAL,
@@ -75,12 +85,33 @@ typedef enum {
 } MxAutomaticScroll;
 
 
+/* The deceleration is worked out in steps of a 60th of a second, in which
+ * the velocity is divided by the deceleration rate */
+#define MX_KINETIC_STEP (1000.0 / 60.0)
+
+/* The motion along one axis since @start, in ms of the deceleration
+ * timeline, from @origin with @velocity (per step) divided by @decay at
+ * each step. When scrolling beyond the boundaries, a new segment starts at
+ * the boundary, with the overshoot decay. */
+typedef struct
+{
+  gdouble  origin;
+  gdouble  velocity;
+  gdouble  decay;
+  gdouble  start;
+  gboolean outside;
+} MxKineticAxis;
+
 struct _MxKineticScrollViewPrivate
 {
   ClutterActor          *child;
 
+  /* the rendering of the child, while scrolling with use-tile-cache */
+  MxTileCache           *tile_cache;
+
   guint                  use_captured        : 1;
   guint                  use_grab            : 1;
+  guint                  use_tile_cache      : 1;
   guint                  in_drag             : 1;
   guint                  hmoving             : 1;
   guint                  vmoving             : 1;
@@ -99,16 +130,28 @@ struct _MxKineticScrollViewPrivate
   MxAutomaticScroll        in_automatic_scroll;
 
   /* Mouse motion event information */
-  GArray                *motion_buffer;
+  MxKineticScrollViewMotion motions[MX_KINETIC_N_MOTIONS];
+  guint                  n_motions;
   guint                  last_motion;
 
+  /* Dragging moves the contents once a frame, to the last motion event,
+   * plus what is expected of the next motion-prediction milliseconds; the
+   * position they were last moved to is kept for the next frame */
+  guint                  drag_motion_id;
+  gfloat                 drag_x;
+  gfloat                 drag_y;
+  guint                  motion_prediction;
+
   /* Variables for storing acceleration information */
   ClutterTimeline       *deceleration_timeline;
   gfloat                 dx;
   gfloat                 dy;
   gdouble                decel_rate;
   gdouble                overshoot;
-  gdouble                accumulated_delta;
+  MxKineticAxis          haxis;
+  MxKineticAxis          vaxis;
+  gdouble                predicted_hvalue;
+  gdouble                predicted_vvalue;
   gdouble                acceleration_factor;
 
   MxScrollPolicy         scroll_policy;
@@ -129,6 +172,7 @@ enum {
   PROP_BUTTON,
   PROP_USE_CAPTURED,
   PROP_USE_GRAB,
+  PROP_USE_TILE_CACHE,
   PROP_OVERSHOOT,
   PROP_SCROLL_POLICY,
   PROP_ACCELERATION_FACTOR,
@@ -137,8 +181,20 @@ enum {
   PROP_STATE,
   PROP_CLAMP_TO_CENTER,
   PROP_SNAP_ON_PAGE,
+  PROP_PREDICTED_HVALUE,
+  PROP_PREDICTED_VVALUE,
+  PROP_MOTION_PREDICTION
+};
+
+enum
+{
+  FLING_PREDICTED,
+
+  LAST_SIGNAL
 };
 
+static guint signals[LAST_SIGNAL] = { 0, };
+
 #if _KINETIC_DEBUG
 # define LOG_DEBUG(args...) _log_debug(args)
 
@@ -340,6 +396,10 @@ mx_kinetic_scroll_view_get_property (GObject    *object,
       g_value_set_boolean (value, priv->use_grab);
       break;
 
+    case PROP_USE_TILE_CACHE:
+      g_value_set_boolean (value, priv->use_tile_cache);
+      break;
+
     case PROP_OVERSHOOT:
       g_value_set_double (value, priv->overshoot);
       break;
@@ -372,6 +432,18 @@ mx_kinetic_scroll_view_get_property (GObject    *object,
       g_value_set_boolean (value, priv->snap_on_page);
       break;
 
+    case PROP_PREDICTED_HVALUE :
+      g_value_set_double (value, priv->predicted_hvalue);
+      break;
+
+    case PROP_PREDICTED_VVALUE :
+      g_value_set_double (value, priv->predicted_vvalue);
+      break;
+
+    case PROP_MOTION_PREDICTION :
+      g_value_set_uint (value, priv->motion_prediction);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -430,6 +502,11 @@ mx_kinetic_scroll_view_set_property (GObject      *object,
                                            g_value_get_boolean (value));
       break;
 
+    case PROP_USE_TILE_CACHE:
+      mx_kinetic_scroll_view_set_use_tile_cache (self,
+                                                 g_value_get_boolean (value));
+      break;
+
     case PROP_OVERSHOOT:
       mx_kinetic_scroll_view_set_overshoot (self, g_value_get_double (value));
       break;
@@ -463,16 +540,39 @@ mx_kinetic_scroll_view_set_property (GObject      *object,
           g_value_get_boolean (value));
       break;
 
+    case PROP_MOTION_PREDICTION:
+      mx_kinetic_scroll_view_set_motion_prediction (self,
+          g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
 }
 
+static void
+mx_kinetic_scroll_view_drop_tile_cache (MxKineticScrollView *scroll)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+
+  if (priv->tile_cache)
+    {
+      _mx_tile_cache_free (priv->tile_cache);
+      priv->tile_cache = NULL;
+    }
+}
+
+static void cancel_drag_motion (MxKineticScrollView *scroll);
+
 static void
 mx_kinetic_scroll_view_dispose (GObject *object)
 {
   MxKineticScrollViewPrivate *priv = MX_KINETIC_SCROLL_VIEW (object)->priv;
 
+  mx_kinetic_scroll_view_drop_tile_cache (MX_KINETIC_SCROLL_VIEW (object));
+
+  cancel_drag_motion (MX_KINETIC_SCROLL_VIEW (object));
+
   if (priv->deceleration_timeline)
     {
       clutter_timeline_stop (priv->deceleration_timeline);
@@ -488,7 +588,6 @@ mx_kinetic_scroll_view_finalize (GObject *object)
 {
   MxKineticScrollViewPrivate *priv = MX_KINETIC_SCROLL_VIEW (object)->priv;
 
-  g_array_free (priv->motion_buffer, TRUE);
 
   G_OBJECT_CLASS (mx_kinetic_scroll_view_parent_class)->finalize (object);
 }
@@ -544,6 +643,9 @@ mx_kinetic_scroll_view_allocate (ClutterActor           *actor,
   CLUTTER_ACTOR_CLASS (mx_kinetic_scroll_view_parent_class)->
     allocate (actor, box, flags);
 
+  /* the content may have been laid out again */
+  if (priv->tile_cache)
+    _mx_tile_cache_invalidate (priv->tile_cache, NULL);
 
   if (priv->child)
     {
@@ -552,6 +654,91 @@ mx_kinetic_scroll_view_allocate (ClutterActor           *actor,
     }
 }
 
+static void
+mx_kinetic_scroll_view_queue_redraw (ClutterActor *actor,
+                                     ClutterActor *leaf)
+{
+  MxKineticScrollViewPrivate *priv = MX_KINETIC_SCROLL_VIEW (actor)->priv;
+
+  if (priv->tile_cache)
+    _mx_tile_cache_invalidate_actor (priv->tile_cache, leaf);
+
+  CLUTTER_ACTOR_CLASS (mx_kinetic_scroll_view_parent_class)->
+    queue_redraw (actor, leaf);
+}
+
+static void
+mx_kinetic_scroll_view_get_child_offset (MxKineticScrollView *scroll,
+                                         gdouble             *x,
+                                         gdouble             *y)
+{
+  MxAdjustment *hadjust, *vadjust;
+
+  mx_scrollable_get_adjustments (MX_SCROLLABLE (scroll->priv->child),
+                                 &hadjust, &vadjust);
+
+  *x = hadjust ? mx_adjustment_get_value (hadjust) : 0;
+  *y = vadjust ? mx_adjustment_get_value (vadjust) : 0;
+}
+
+/* Paints the child into a tile, in the coordinates of its content */
+static void
+mx_kinetic_scroll_view_paint_tile (const ClutterActorBox *area,
+                                   gpointer               user_data)
+{
+  MxKineticScrollView *scroll = user_data;
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  ClutterActorBox box;
+  gdouble x, y;
+
+  mx_kinetic_scroll_view_get_child_offset (scroll, &x, &y);
+  clutter_actor_get_allocation_box (priv->child, &box);
+
+  cogl_push_matrix ();
+  cogl_translate (x - box.x1, y - box.y1, 0);
+  clutter_actor_paint (priv->child);
+  cogl_pop_matrix ();
+}
+
+/* While scrolling, the content of the child only moves and it can be
+ * painted from tiles of an earlier rendering of it */
+static gboolean
+mx_kinetic_scroll_view_paint_tiles (MxKineticScrollView   *scroll,
+                                    const ClutterActorBox *box)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  ClutterActorBox area;
+  gboolean painted;
+  gdouble x, y;
+
+  if (!priv->use_tile_cache ||
+      priv->state != MX_KINETIC_SCROLL_VIEW_STATE_SCROLLING ||
+      !CLUTTER_ACTOR_IS_VISIBLE (priv->child) ||
+      clutter_actor_is_scaled (priv->child) ||
+      clutter_actor_is_rotated (priv->child))
+    return FALSE;
+
+  if (!priv->tile_cache)
+    priv->tile_cache =
+      _mx_tile_cache_new (priv->child, mx_kinetic_scroll_view_paint_tile,
+                          scroll);
+
+  mx_kinetic_scroll_view_get_child_offset (scroll, &x, &y);
+
+  area.x1 = x;
+  area.y1 = y;
+  area.x2 = x + (box->x2 - box->x1);
+  area.y2 = y + (box->y2 - box->y1);
+
+  cogl_push_matrix ();
+  cogl_translate (box->x1 - x, box->y1 - y, 0);
+  painted = _mx_tile_cache_paint (priv->tile_cache, &area,
+                                  clutter_actor_get_paint_opacity (priv->child));
+  cogl_pop_matrix ();
+
+  return painted;
+}
+
 static void
 mx_kinetic_scroll_view_paint (ClutterActor *actor)
 {
@@ -566,7 +753,9 @@ mx_kinetic_scroll_view_paint (ClutterActor *actor)
       cogl_clip_push_rectangle (box.x1, box.y1,
                                 box.x2 - box.x1,
                                 box.y2 - box.y1);
-      clutter_actor_paint (priv->child);
+      if (!mx_kinetic_scroll_view_paint_tiles (MX_KINETIC_SCROLL_VIEW (actor),
+                                               &box))
+        clutter_actor_paint (priv->child);
       cogl_clip_pop ();
     }
 }
@@ -629,6 +818,7 @@ mx_kinetic_scroll_view_class_init (MxKineticScrollViewClass *klass)
   actor_class->allocate = mx_kinetic_scroll_view_allocate;
   actor_class->paint = mx_kinetic_scroll_view_paint;
   actor_class->pick = mx_kinetic_scroll_view_pick;
+  actor_class->queue_redraw = mx_kinetic_scroll_view_queue_redraw;
 
   actor_class->event = mx_kinetic_scroll_view_event;
   actor_class->button_press_event = mx_kinetic_scroll_view_button_event;
@@ -672,6 +862,23 @@ mx_kinetic_scroll_view_class_init (MxKineticScrollViewClass *klass)
                                 MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, PROP_USE_GRAB, pspec);
 
+  /**
+   * MxKineticScrollView:use-tile-cache:
+   *
+   * Whether to paint the child from a rendering of it into offscreen tiles
+   * while it decelerates. Only the tiles that come into view are rendered,
+   * rather than the whole child being painted every frame.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("use-tile-cache",
+                                "Use tile cache",
+                                "Paint the child from cached tiles while "
+                                "scrolling",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_USE_TILE_CACHE, pspec);
+
   pspec = g_param_spec_double ("overshoot",
                                "Overshoot",
                                "The rate at which the view will decelerate "
@@ -731,6 +938,81 @@ mx_kinetic_scroll_view_class_init (MxKineticScrollViewClass *klass)
                                 MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, PROP_SNAP_ON_PAGE, pspec);
 
+  /**
+   * MxKineticScrollView:predicted-hvalue:
+   *
+   * The value the horizontal adjustment is expected to end up at, as
+   * predicted from the velocity of the last fling.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_double ("predicted-hvalue",
+                               "Predicted horizontal value",
+                               "Where the last fling is expected to end "
+                               "horizontally",
+                               -G_MAXDOUBLE, G_MAXDOUBLE, 0.0,
+                               MX_PARAM_READABLE);
+  g_object_class_install_property (object_class, PROP_PREDICTED_HVALUE, pspec);
+
+  /**
+   * MxKineticScrollView:predicted-vvalue:
+   *
+   * The value the vertical adjustment is expected to end up at, as
+   * predicted from the velocity of the last fling.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_double ("predicted-vvalue",
+                               "Predicted vertical value",
+                               "Where the last fling is expected to end "
+                               "vertically",
+                               -G_MAXDOUBLE, G_MAXDOUBLE, 0.0,
+                               MX_PARAM_READABLE);
+  g_object_class_install_property (object_class, PROP_PREDICTED_VVALUE, pspec);
+
+  /**
+   * MxKineticScrollView:motion-prediction:
+   *
+   * How far ahead of the last motion event, in milliseconds, the contents
+   * are moved while dragging, following the velocity of the drag. A
+   * prediction of about a frame makes up for the time between the event
+   * and the frame it shows up in, so the contents keep up with the finger.
+   * 0, the default, moves the contents to the last motion event.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_uint ("motion-prediction",
+                             "Motion prediction",
+                             "How far ahead to predict drags, in "
+                             "milliseconds",
+                             0, MX_KINETIC_MAX_PREDICTION, 0,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_MOTION_PREDICTION,
+                                   pspec);
+
+  /**
+   * MxKineticScrollView::fling-predicted:
+   * @scroll: the object that received the signal
+   * @hvalue: the value the horizontal adjustment is expected to end up at
+   * @vvalue: the value the vertical adjustment is expected to end up at
+   * @duration: the time in milliseconds until the values are reached
+   *
+   * Emitted when a fling starts to decelerate, with where it is expected to
+   * come to rest. Containers and image loaders can use it to start creating
+   * and loading the content at the destination before it is scrolled to.
+   *
+   * Since: 2.0
+   */
+  signals[FLING_PREDICTED] =
+    g_signal_new ("fling-predicted",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  _mx_marshal_VOID__DOUBLE_DOUBLE_UINT,
+                  G_TYPE_NONE, 3,
+                  G_TYPE_DOUBLE, G_TYPE_DOUBLE, G_TYPE_UINT);
+
   /* MxScrollable properties */
   g_object_class_override_property (object_class,
                                     PROP_HADJUST,
@@ -747,9 +1029,171 @@ set_state (MxKineticScrollView *scroll, MxKineticScrollViewState state)
   MxKineticScrollViewPrivate *priv = scroll->priv;
 
   priv->state = state;
+
+  /* only use the tiles while they stand for the child */
+  if (state != MX_KINETIC_SCROLL_VIEW_STATE_SCROLLING)
+    mx_kinetic_scroll_view_drop_tile_cache (scroll);
+
   g_object_notify (G_OBJECT (scroll), "state");
 }
 
+static void
+add_motion (MxKineticScrollView *scroll,
+            gfloat               x,
+            gfloat               y)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  MxKineticScrollViewMotion *motion;
+
+  if (priv->n_motions)
+    priv->last_motion = (priv->last_motion + 1) % MX_KINETIC_N_MOTIONS;
+  else
+    priv->last_motion = 0;
+
+  priv->n_motions = MIN (priv->n_motions + 1, MX_KINETIC_N_MOTIONS);
+
+  motion = &priv->motions[priv->last_motion];
+  motion->x = x;
+  motion->y = y;
+  motion->time = g_get_monotonic_time ();
+}
+
+/* Fits a line to the position against time of the motion events of the
+ * last MX_KINETIC_VELOCITY_WINDOW, with least squares, and gives its slope
+ * in units per millisecond. A single noisy event then has little effect on
+ * the velocity, and older motion none. */
+static void
+get_velocity (MxKineticScrollView *scroll,
+              gdouble             *x_velocity,
+              gdouble             *y_velocity)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  gdouble st = 0, sx = 0, sy = 0, stt = 0, stx = 0, sty = 0, det;
+  gint64 last_time;
+  guint i, n;
+
+  *x_velocity = *y_velocity = 0;
+
+  if (!priv->n_motions)
+    return;
+
+  last_time = priv->motions[priv->last_motion].time;
+
+  for (i = 0, n = 0; i < priv->n_motions; i++, n++)
+    {
+      MxKineticScrollViewMotion *motion =
+        &priv->motions[(priv->last_motion + MX_KINETIC_N_MOTIONS - i) %
+                       MX_KINETIC_N_MOTIONS];
+      gdouble t;
+
+      if (last_time - motion->time > MX_KINETIC_VELOCITY_WINDOW)
+        break;
+
+      t = (motion->time - last_time) / 1000.0;
+
+      st += t;
+      sx += motion->x;
+      sy += motion->y;
+      stt += t * t;
+      stx += t * motion->x;
+      sty += t * motion->y;
+    }
+
+  det = n * stt - st * st;
+  if (n < 2 || det <= 0)
+    return;
+
+  *x_velocity = (n * stx - st * sx) / det;
+  *y_velocity = (n * sty - st * sy) / det;
+}
+
+/* Moves the contents by how far the pointer moved since they were last
+ * moved, to the last motion event or where the drag is predicted to be */
+static void
+apply_drag_motion (MxKineticScrollView *scroll)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  MxKineticScrollViewMotion *motion;
+  MxAdjustment *hadjust, *vadjust;
+  gfloat x, y;
+
+  if (!priv->child || !priv->n_motions)
+    return;
+
+  motion = &priv->motions[priv->last_motion];
+  x = motion->x;
+  y = motion->y;
+
+  if (priv->motion_prediction)
+    {
+      gdouble x_velocity, y_velocity;
+
+      get_velocity (scroll, &x_velocity, &y_velocity);
+      x += x_velocity * priv->motion_prediction;
+      y += y_velocity * priv->motion_prediction;
+    }
+
+  mx_scrollable_get_adjustments (MX_SCROLLABLE (priv->child),
+                                 &hadjust, &vadjust);
+
+  if (hadjust &&
+      (priv->scroll_policy == MX_SCROLL_POLICY_HORIZONTAL ||
+       priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
+       priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
+       (priv->in_automatic_scroll == MX_AUTOMATIC_SCROLL_HORIZONTAL ||
+       priv->in_automatic_scroll == MX_AUTOMATIC_SCROLL_NONE))
+    {
+      mx_adjustment_set_value (hadjust, (priv->drag_x - x) +
+                               mx_adjustment_get_value (hadjust));
+    }
+
+  if (vadjust &&
+      (priv->scroll_policy == MX_SCROLL_POLICY_VERTICAL ||
+       priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
+       priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
+       (priv->in_automatic_scroll == MX_AUTOMATIC_SCROLL_VERTICAL ||
+       priv->in_automatic_scroll == MX_AUTOMATIC_SCROLL_NONE))
+    {
+      mx_adjustment_set_value (vadjust, (priv->drag_y - y) +
+                               mx_adjustment_get_value (vadjust));
+    }
+
+  priv->drag_x = x;
+  priv->drag_y = y;
+}
+
+static gboolean
+drag_motion_flush (gpointer data)
+{
+  MxKineticScrollView *scroll = data;
+
+  scroll->priv->drag_motion_id = 0;
+  apply_drag_motion (scroll);
+
+  return FALSE;
+}
+
+/* Applies the motion waiting for the next frame straight away */
+static void
+flush_drag_motion (MxKineticScrollView *scroll)
+{
+  if (scroll->priv->drag_motion_id)
+    {
+      clutter_threads_remove_repaint_func (scroll->priv->drag_motion_id);
+      drag_motion_flush (scroll);
+    }
+}
+
+static void
+cancel_drag_motion (MxKineticScrollView *scroll)
+{
+  if (scroll->priv->drag_motion_id)
+    {
+      clutter_threads_remove_repaint_func (scroll->priv->drag_motion_id);
+      scroll->priv->drag_motion_id = 0;
+    }
+}
+
 static gboolean
 motion_event_cb (ClutterActor        *actor,
                  ClutterEvent        *event,
@@ -832,8 +1276,7 @@ motion_event_cb (ClutterActor        *actor,
 
           g_object_get (G_OBJECT (settings),
                         "drag-threshold", &threshold, NULL);
-          motion = &g_array_index (priv->motion_buffer,
-                                   MxKineticScrollViewMotion, 0);
+          motion = &priv->motions[priv->last_motion];
 
           dx = ABS (motion->x - x);
           dy = ABS (motion->y - y);
@@ -916,20 +1359,12 @@ motion_event_cb (ClutterActor        *actor,
         }
 
       LOG_DEBUG (scroll, "motion dx=%f dy=%f",
-                 ABS (g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, priv->motion_buffer->len - 1).x - x),
-                 ABS (g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, priv->motion_buffer->len - 1).y - y));
+                 ABS (priv->motions[priv->last_motion].x - x),
+                 ABS (priv->motions[priv->last_motion].y - y));
 
       if (priv->child)
         {
-          gdouble dx, dy;
-          MxAdjustment *hadjust, *vadjust;
-
-          mx_scrollable_get_adjustments (MX_SCROLLABLE (priv->child),
-                                         &hadjust, &vadjust);
-
-          motion = &g_array_index (priv->motion_buffer,
-                                   MxKineticScrollViewMotion,
-                                   priv->last_motion);
+          motion = &priv->motions[priv->last_motion];
 
           if (!priv->align_tested)
             {
@@ -947,44 +1382,20 @@ motion_event_cb (ClutterActor        *actor,
                 }
             }
 
-
-          if (hadjust &&
-              (priv->scroll_policy == MX_SCROLL_POLICY_HORIZONTAL ||
-               priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
-               priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
-               (priv->in_automatic_scroll == MX_AUTOMATIC_SCROLL_HORIZONTAL ||
-               priv->in_automatic_scroll == MX_AUTOMATIC_SCROLL_NONE))
+          /* only the last motion of each frame moves the contents */
+          if (!priv->drag_motion_id)
             {
-              dx = (motion->x - x) + mx_adjustment_get_value (hadjust);
-              mx_adjustment_set_value (hadjust, dx);
-            }
+              priv->drag_motion_id =
+                clutter_threads_add_repaint_func_full (
+                  CLUTTER_REPAINT_FLAGS_PRE_PAINT, drag_motion_flush,
+                  scroll, NULL);
 
-          if (vadjust &&
-              (priv->scroll_policy == MX_SCROLL_POLICY_VERTICAL ||
-               priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
-               priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
-               (priv->in_automatic_scroll == MX_AUTOMATIC_SCROLL_VERTICAL ||
-               priv->in_automatic_scroll == MX_AUTOMATIC_SCROLL_NONE))
-            {
-              dy = (motion->y - y) + mx_adjustment_get_value (vadjust);
-              mx_adjustment_set_value (vadjust, dy);
+              /* make sure there is a frame to move the contents in */
+              clutter_actor_queue_redraw (actor);
             }
         }
 
-      priv->last_motion ++;
-      if (priv->last_motion == priv->motion_buffer->len)
-        {
-          LOG_DEBUG (scroll, "reset");
-          priv->motion_buffer = g_array_remove_index (priv->motion_buffer, 0);
-          g_array_set_size (priv->motion_buffer, priv->last_motion);
-          priv->last_motion --;
-        }
-
-      motion = &g_array_index (priv->motion_buffer,
-                               MxKineticScrollViewMotion, priv->last_motion);
-      motion->x = x;
-      motion->y = y;
-      g_get_current_time (&motion->time);
+      add_motion (scroll, x, y);
     }
 
   return swallow;
@@ -1100,6 +1511,94 @@ deceleration_completed_cb (ClutterTimeline     *timeline,
   priv->deceleration_timeline = NULL;
 }
 
+static void
+kinetic_axis_init (MxKineticAxis *axis,
+                   MxAdjustment  *adjustment,
+                   gdouble        velocity,
+                   gdouble        decay)
+{
+  axis->origin = adjustment ? mx_adjustment_get_value (adjustment) : 0;
+  axis->velocity = velocity;
+  axis->decay = decay;
+  axis->start = 0;
+  axis->outside = FALSE;
+}
+
+/* The number of steps after which the velocity is down to 2, when the
+ * motion stops */
+static gdouble
+kinetic_axis_get_n_steps (MxKineticAxis *axis)
+{
+  if (ABS (axis->velocity) <= 2)
+    return 0;
+
+  return log (ABS (axis->velocity) / 2) / log (axis->decay);
+}
+
+/* The value @n steps into the segment; the distance covered in n whole
+ * steps is the sum of the geometric series
+ *
+ *   v + v/y + ... + v/y^(n-1) = v * (1 - 1/y^n) / (1 - 1/y)
+ *
+ * which holds just as well between steps */
+static gdouble
+kinetic_axis_get_value (MxKineticAxis *axis,
+                        gdouble        n)
+{
+  return axis->origin + axis->velocity *
+    (1.0 - pow (axis->decay, -n)) / (1.0 - 1.0 / axis->decay);
+}
+
+/* Moves @adjustment to where the motion is at @time. Returns %FALSE once
+ * the motion has stopped. */
+static gboolean
+kinetic_axis_update (MxKineticScrollView *scroll,
+                     MxKineticAxis       *axis,
+                     MxAdjustment        *adjustment,
+                     gdouble              time)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  gdouble n, n_steps, value, lower, upper, page_size, boundary;
+  gboolean moving;
+
+  n = MAX (0, (time - axis->start) / MX_KINETIC_STEP);
+  n_steps = kinetic_axis_get_n_steps (axis);
+  moving = n < n_steps;
+
+  value = kinetic_axis_get_value (axis, MIN (n, n_steps));
+
+  mx_adjustment_get_values (adjustment, NULL, &lower, &upper, NULL, NULL,
+                            &page_size);
+
+  /* past the boundary, the motion decelerates faster from where it
+   * crossed it */
+  if (priv->overshoot > 0.0 && !axis->outside &&
+      (value > upper - page_size || value < lower))
+    {
+      gdouble crossing;
+
+      boundary = (value < lower) ? lower : upper - page_size;
+
+      crossing = 1.0 - (boundary - axis->origin) *
+        (1.0 - 1.0 / axis->decay) / axis->velocity;
+      crossing = (crossing > 0) ? MAX (0, -log (crossing) / log (axis->decay))
+                                : 0;
+
+      axis->origin = kinetic_axis_get_value (axis, crossing);
+      axis->velocity = axis->velocity * pow (axis->decay, -crossing) *
+        priv->overshoot;
+      axis->decay /= priv->overshoot;
+      axis->start += crossing * MX_KINETIC_STEP;
+      axis->outside = TRUE;
+
+      return kinetic_axis_update (scroll, axis, adjustment, time);
+    }
+
+  mx_adjustment_set_value (adjustment, value);
+
+  return moving;
+}
+
 static void
 deceleration_new_frame_cb (ClutterTimeline     *timeline,
                            gint                 frame_num,
@@ -1110,94 +1609,64 @@ deceleration_new_frame_cb (ClutterTimeline     *timeline,
   if (priv->child)
     {
       MxAdjustment *hadjust, *vadjust;
+      const gchar *reason;
+      gdouble time;
 
       gboolean stop = TRUE;
 
+      reason = _mx_debug_redraw_reason_push ("animation");
+
       mx_scrollable_get_adjustments (MX_SCROLLABLE (priv->child),
                                      &hadjust, &vadjust);
 
-      priv->accumulated_delta += clutter_timeline_get_delta (timeline);
+      /* the motion is worked out for the time of the frame, however long
+       * the frames before it were */
+      time = clutter_timeline_get_elapsed_time (timeline);
 
-      if (priv->accumulated_delta <= 1000.0/60.0)
-        stop = FALSE;
-
-      while (priv->accumulated_delta > 1000.0/60.0)
+      if (hadjust &&
+          (priv->scroll_policy == MX_SCROLL_POLICY_HORIZONTAL ||
+          priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
+          priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
+          priv->in_automatic_scroll != MX_AUTOMATIC_SCROLL_VERTICAL &&
+          priv->hmoving)
         {
-          gdouble hvalue, vvalue;
-
-          if (hadjust &&
-              (priv->scroll_policy == MX_SCROLL_POLICY_HORIZONTAL ||
-              priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
-              priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
-              priv->in_automatic_scroll != MX_AUTOMATIC_SCROLL_VERTICAL)
+          if (kinetic_axis_update (scroll, &priv->haxis, hadjust, time))
+            stop = FALSE;
+          else
             {
-              if (ABS (priv->dx) > 2)
-                {
-                  hvalue = priv->dx + mx_adjustment_get_value (hadjust);
-                  mx_adjustment_set_value (hadjust, hvalue);
-
-                  if (priv->overshoot > 0.0)
-                    {
-                      if ((hvalue > mx_adjustment_get_upper (hadjust) -
-                           mx_adjustment_get_page_size (hadjust)) ||
-                          (hvalue < mx_adjustment_get_lower (hadjust)))
-                        priv->dx *= priv->overshoot;
-                    }
-
-                  priv->dx = priv->dx / priv->decel_rate;
-
-                  stop = FALSE;
-                }
-              else if (priv->hmoving)
-                {
-                  guint duration;
+              guint duration;
 
-                  priv->hmoving = FALSE;
+              priv->hmoving = FALSE;
 
-                  duration = (priv->overshoot > 0.0) ?
-                                priv->clamp_duration : 10;
-                  clamp_adjustments (scroll, duration, TRUE, FALSE);
-                }
+              duration = (priv->overshoot > 0.0) ?
+                            priv->clamp_duration : 10;
+              clamp_adjustments (scroll, duration, TRUE, FALSE);
             }
+        }
 
-          if (vadjust &&
-              (priv->scroll_policy == MX_SCROLL_POLICY_VERTICAL ||
-              priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
-              priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
-              priv->in_automatic_scroll != MX_AUTOMATIC_SCROLL_HORIZONTAL)
+      if (vadjust &&
+          (priv->scroll_policy == MX_SCROLL_POLICY_VERTICAL ||
+          priv->scroll_policy == MX_SCROLL_POLICY_BOTH ||
+          priv->scroll_policy == MX_SCROLL_POLICY_AUTOMATIC) &&
+          priv->in_automatic_scroll != MX_AUTOMATIC_SCROLL_HORIZONTAL &&
+          priv->vmoving)
+        {
+          if (kinetic_axis_update (scroll, &priv->vaxis, vadjust, time))
+            stop = FALSE;
+          else
             {
-              if (ABS (priv->dy) > 2)
-                {
-                  vvalue = priv->dy + mx_adjustment_get_value (vadjust);
-                  mx_adjustment_set_value (vadjust, vvalue);
-
-                  if (priv->overshoot > 0.0)
-                    {
-                      if ((vvalue > mx_adjustment_get_upper (vadjust) -
-                           mx_adjustment_get_page_size (vadjust)) ||
-                          (vvalue < mx_adjustment_get_lower (vadjust)))
-                        priv->dy *= priv->overshoot;
-                    }
-
-                  priv->dy = priv->dy / priv->decel_rate;
-
-                  stop = FALSE;
-                }
-              else if (priv->vmoving)
-                {
-                  guint duration;
+              guint duration;
 
-                  priv->vmoving = FALSE;
+              priv->vmoving = FALSE;
 
-                  duration = (priv->overshoot > 0.0) ?
-                                priv->clamp_duration : 10;
-                  clamp_adjustments (scroll, duration, FALSE, TRUE);
-                }
+              duration = (priv->overshoot > 0.0) ?
+                            priv->clamp_duration : 10;
+              clamp_adjustments (scroll, duration, FALSE, TRUE);
             }
-
-          priv->accumulated_delta -= 1000.0/60.0;
         }
 
+      _mx_debug_redraw_reason_pop (reason);
+
       if (stop)
         {
           clutter_timeline_stop (timeline);
@@ -1261,6 +1730,9 @@ release_event (MxKineticScrollView *scroll,
 
   LOG_DEBUG (scroll, "RELEASE!");
 
+  /* the fling starts from where the contents were dragged to */
+  flush_drag_motion (scroll);
+
   g_signal_handlers_disconnect_by_func (scroll,
                                         motion_event_cb,
                                         scroll);
@@ -1275,7 +1747,7 @@ release_event (MxKineticScrollView *scroll,
     {
       priv->device = NULL;
       priv->sequence = NULL;
-      priv->last_motion = 0;
+      priv->n_motions = 0;
       return FALSE;
     }
 
@@ -1290,51 +1762,25 @@ release_event (MxKineticScrollView *scroll,
         {
           gdouble value, lower, upper, step_increment, page_size,
                   d, ax, ay, y, nx, ny, n;
-          gfloat frac, x_origin, y_origin;
-          GTimeVal release_time, motion_time;
+          gdouble x_velocity, y_velocity;
           MxAdjustment *hadjust, *vadjust;
-          glong time_diff;
           guint duration;
-          gint i;
-
-          /* Get time delta */
-          g_get_current_time (&release_time);
 
-          /* Get average position/time of last x mouse events */
-          priv->last_motion ++;
-          x_origin = y_origin = 0;
-          motion_time = (GTimeVal){ 0, 0 };
-          for (i = 0; i < priv->last_motion; i++)
-            {
-              MxKineticScrollViewMotion *motion =
-                &g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, i);
-
-              /* FIXME: This doesn't guard against overflows - Should
-               *        either fix that, or calculate the correct maximum
-               *        value for the buffer size
-               */
-              x_origin += motion->x;
-              y_origin += motion->y;
-              motion_time.tv_sec += motion->time.tv_sec;
-              motion_time.tv_usec += motion->time.tv_usec;
-            }
-          x_origin = x_origin / priv->last_motion;
-          y_origin = y_origin / priv->last_motion;
-          motion_time.tv_sec /= priv->last_motion;
-          motion_time.tv_usec /= priv->last_motion;
-
-          if (motion_time.tv_sec == release_time.tv_sec)
-            time_diff = release_time.tv_usec - motion_time.tv_usec;
-          else
-            time_diff = release_time.tv_usec +
-                        (G_USEC_PER_SEC - motion_time.tv_usec);
+          mx_scrollable_get_adjustments (MX_SCROLLABLE (priv->child),
+                                         &hadjust, &vadjust);
+          priv->predicted_hvalue =
+            hadjust ? mx_adjustment_get_value (hadjust) : 0;
+          priv->predicted_vvalue =
+            vadjust ? mx_adjustment_get_value (vadjust) : 0;
 
-          /* Work out the fraction of 1/60th of a second that has elapsed */
-          frac = (time_diff/1000.0) / (1000.0/60.0);
+          /* Fit the velocity to the last motion events, up to the release */
+          add_motion (scroll, event_x, event_y);
+          get_velocity (scroll, &x_velocity, &y_velocity);
 
-          /* See how many units to move in 1/60th of a second */
-          priv->dx = (x_origin - event_x) / frac * priv->acceleration_factor;
-          priv->dy = (y_origin - event_y) / frac * priv->acceleration_factor;
+          /* See how many units to move in 1/60th of a second; the contents
+           * move the opposite way to the pointer */
+          priv->dx = -x_velocity * MX_KINETIC_STEP * priv->acceleration_factor;
+          priv->dy = -y_velocity * MX_KINETIC_STEP * priv->acceleration_factor;
 
           /* If the delta is too low for the equations to work,
            * bump the values up a bit.
@@ -1357,7 +1803,7 @@ release_event (MxKineticScrollView *scroll,
           ny = logf (ABS (priv->dy)) / logf (y);
           n = MAX (nx, ny);
 
-          duration = MAX (1, (gint)(MAX (nx, ny) * (1000/60.0)));
+          duration = MAX (1, (gint)(MAX (nx, ny) * MX_KINETIC_STEP));
 
           if (duration > 250)
             {
@@ -1381,9 +1827,7 @@ release_event (MxKineticScrollView *scroll,
                * x = d / a
                */
 
-              /* Get adjustments, work out y^n */
-              mx_scrollable_get_adjustments (MX_SCROLLABLE (priv->child),
-                                             &hadjust, &vadjust);
+              /* Work out y^n */
               ax = (1.0 - 1.0 / pow (y, n + 1)) / (1.0 - 1.0 / y);
               ay = (1.0 - 1.0 / pow (y, n + 1)) / (1.0 - 1.0 / y);
 
@@ -1423,6 +1867,7 @@ release_event (MxKineticScrollView *scroll,
                     }
 
                   priv->dx = d / ax;
+                  priv->predicted_hvalue = value + d;
                 }
 
               /* Solving for dy */
@@ -1458,6 +1903,7 @@ release_event (MxKineticScrollView *scroll,
                     }
 
                   priv->dy = d / ay;
+                  priv->predicted_vvalue = value + d;
                 }
 
               priv->deceleration_timeline = clutter_timeline_new (duration);
@@ -1466,7 +1912,10 @@ release_event (MxKineticScrollView *scroll,
                                 G_CALLBACK (deceleration_new_frame_cb), scroll);
               g_signal_connect (priv->deceleration_timeline, "completed",
                                 G_CALLBACK (deceleration_completed_cb), scroll);
-              priv->accumulated_delta = 0;
+              kinetic_axis_init (&priv->haxis, hadjust, priv->dx,
+                                 priv->decel_rate);
+              kinetic_axis_init (&priv->vaxis, vadjust, priv->dy,
+                                 priv->decel_rate);
               priv->hmoving = priv->vmoving = TRUE;
               clutter_timeline_start (priv->deceleration_timeline);
               decelerating = TRUE;
@@ -1487,9 +1936,16 @@ release_event (MxKineticScrollView *scroll,
   priv->device = NULL;
 
   /* Reset motion event buffer */
-  priv->last_motion = 0;
+  priv->n_motions = 0;
 
-  if (!decelerating)
+  g_object_notify (G_OBJECT (scroll), "predicted-hvalue");
+  g_object_notify (G_OBJECT (scroll), "predicted-vvalue");
+
+  if (decelerating)
+    g_signal_emit (scroll, signals[FLING_PREDICTED], 0,
+                   priv->predicted_hvalue, priv->predicted_vvalue,
+                   clutter_timeline_get_duration (priv->deceleration_timeline));
+  else
     clamp_adjustments (scroll, priv->clamp_duration, TRUE, TRUE);
 
   return TRUE;
@@ -1503,27 +1959,25 @@ press_event (MxKineticScrollView *scroll,
   MxKineticScrollViewPrivate *priv = scroll->priv;
   ClutterActor *actor = (ClutterActor *) scroll;
   ClutterActor *stage = clutter_actor_get_stage (actor);
-  MxKineticScrollViewMotion *motion;
 
   /* Reset automatic-scroll setting */
   priv->in_automatic_scroll = MX_AUTOMATIC_SCROLL_NONE;
   priv->align_tested = 0;
 
-  /* Reset motion buffer */
-  priv->last_motion = 0;
-  motion = &g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, 0);
-  motion->x = x;
-  motion->y = y;
-
   LOG_DEBUG (scroll, "initial point(%fx%f)", x, y);
 
-  if (clutter_actor_transform_stage_point (actor, x, y,
-                                           &motion->x, &motion->y))
+  if (clutter_actor_transform_stage_point (actor, x, y, &x, &y))
     {
       guint threshold;
       MxSettings *settings = mx_settings_get_default ();
 
-      g_get_current_time (&motion->time);
+      /* Reset motion buffer */
+      priv->n_motions = 0;
+      add_motion (scroll, x, y);
+
+      cancel_drag_motion (scroll);
+      priv->drag_x = x;
+      priv->drag_y = y;
 
       if (priv->deceleration_timeline)
         {
@@ -1704,6 +2158,8 @@ mx_kinetic_scroll_view_actor_added (ClutterActor *container,
       priv->child = NULL;
     }
 
+  mx_kinetic_scroll_view_drop_tile_cache (MX_KINETIC_SCROLL_VIEW (container));
+
   if (MX_IS_SCROLLABLE (actor))
     {
       MxAdjustment *hadjust, *vadjust;
@@ -1730,7 +2186,10 @@ mx_kinetic_scroll_view_actor_removed (ClutterActor *container,
   MxKineticScrollViewPrivate *priv = MX_KINETIC_SCROLL_VIEW (container)->priv;
 
   if (priv->child == actor)
-    priv->child = NULL;
+    {
+      mx_kinetic_scroll_view_drop_tile_cache (MX_KINETIC_SCROLL_VIEW (container));
+      priv->child = NULL;
+    }
 }
 
 static void
@@ -1739,9 +2198,6 @@ mx_kinetic_scroll_view_init (MxKineticScrollView *self)
   MxKineticScrollViewPrivate *priv = self->priv =
     KINETIC_SCROLL_VIEW_PRIVATE (self);
 
-  priv->motion_buffer =
-    g_array_sized_new (FALSE, TRUE, sizeof (MxKineticScrollViewMotion), 3);
-  g_array_set_size (priv->motion_buffer, 3);
   priv->decel_rate = 1.1f;
   priv->button = 1;
   priv->scroll_policy = MX_SCROLL_POLICY_BOTH;
@@ -2033,6 +2489,61 @@ mx_kinetic_scroll_view_get_use_grab (MxKineticScrollView *scroll)
   return scroll->priv->use_grab;
 }
 
+/**
+ * mx_kinetic_scroll_view_set_use_tile_cache:
+ * @scroll: A #MxKineticScrollView
+ * @use_tile_cache: %TRUE to paint from cached tiles while scrolling
+ *
+ * Sets whether to render the child into offscreen tiles while it
+ * decelerates, and paint it from those. This saves painting the whole child
+ * every frame when it is expensive to paint, with text or many images.
+ *
+ * Changes to the child are picked up from the redraws it queues, but the
+ * child must paint all of its content for it to be in the tiles: a
+ * container that only creates the children it shows, like a virtualized
+ * #MxListView, will show blank areas until the motion stops.
+ *
+ * Since: 2.0
+ */
+void
+mx_kinetic_scroll_view_set_use_tile_cache (MxKineticScrollView *scroll,
+                                           gboolean             use_tile_cache)
+{
+  MxKineticScrollViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_KINETIC_SCROLL_VIEW (scroll));
+
+  priv = scroll->priv;
+  if (priv->use_tile_cache != use_tile_cache)
+    {
+      priv->use_tile_cache = use_tile_cache;
+
+      if (!use_tile_cache)
+        mx_kinetic_scroll_view_drop_tile_cache (scroll);
+
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (scroll));
+
+      g_object_notify (G_OBJECT (scroll), "use-tile-cache");
+    }
+}
+
+/**
+ * mx_kinetic_scroll_view_get_use_tile_cache:
+ * @scroll: A #MxKineticScrollView
+ *
+ * Gets the #MxKineticScrollView:use-tile-cache property.
+ *
+ * Returns: %TRUE if the child is painted from cached tiles while scrolling
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_kinetic_scroll_view_get_use_tile_cache (MxKineticScrollView *scroll)
+{
+  g_return_val_if_fail (MX_IS_KINETIC_SCROLL_VIEW (scroll), FALSE);
+  return scroll->priv->use_tile_cache;
+}
+
 /**
  * mx_kinetic_scroll_view_set_overshoot:
  * @scroll: A #MxKineticScrollView
@@ -2338,6 +2849,53 @@ mx_kinetic_scroll_view_set_snap_on_page (MxKineticScrollView *scroll,
     }
 }
 
+/**
+ * mx_kinetic_scroll_view_set_motion_prediction:
+ * @scroll: A #MxKineticScrollView
+ * @prediction: how far ahead to predict drags, in milliseconds
+ *
+ * Sets how far ahead of the last motion event the contents are moved while
+ * dragging. See #MxKineticScrollView:motion-prediction.
+ *
+ * Since: 2.0
+ */
+void
+mx_kinetic_scroll_view_set_motion_prediction (MxKineticScrollView *scroll,
+                                              guint                prediction)
+{
+  MxKineticScrollViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_KINETIC_SCROLL_VIEW (scroll));
+
+  priv = scroll->priv;
+
+  prediction = MIN (prediction, MX_KINETIC_MAX_PREDICTION);
+  if (priv->motion_prediction != prediction)
+    {
+      priv->motion_prediction = prediction;
+      g_object_notify (G_OBJECT (scroll), "motion-prediction");
+    }
+}
+
+/**
+ * mx_kinetic_scroll_view_get_motion_prediction:
+ * @scroll: A #MxKineticScrollView
+ *
+ * Gets how far ahead of the last motion event the contents are moved while
+ * dragging.
+ *
+ * Returns: the prediction, in milliseconds
+ *
+ * Since: 2.0
+ */
+guint
+mx_kinetic_scroll_view_get_motion_prediction (MxKineticScrollView *scroll)
+{
+  g_return_val_if_fail (MX_IS_KINETIC_SCROLL_VIEW (scroll), 0);
+
+  return scroll->priv->motion_prediction;
+}
+
 static void
 _mx_scroll_view_ensure_visible_axis (MxAdjustment *adjust,
                                      gdouble       lower,
@@ -2440,3 +2998,34 @@ mx_kinetic_scroll_view_get_input (MxKineticScrollView   *scroll,
   if (sequence != NULL)
     *sequence = priv->sequence;
 }
+
+/**
+ * mx_kinetic_scroll_view_get_predicted_position:
+ * @scroll: A #MxKineticScrollView
+ * @hvalue: (allow-none) (out): return location for the horizontal value
+ * @vvalue: (allow-none) (out): return location for the vertical value
+ *
+ * Retrieves the values the adjustments are expected to end up at after the
+ * last fling, from the velocity it was released with. See
+ * #MxKineticScrollView:predicted-hvalue and
+ * #MxKineticScrollView:predicted-vvalue.
+ *
+ * Since: 2.0
+ */
+void
+mx_kinetic_scroll_view_get_predicted_position (MxKineticScrollView *scroll,
+                                               gdouble             *hvalue,
+                                               gdouble             *vvalue)
+{
+  MxKineticScrollViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_KINETIC_SCROLL_VIEW (scroll));
+
+  priv = scroll->priv;
+
+  if (hvalue)
+    *hvalue = priv->predicted_hvalue;
+
+  if (vvalue)
+    *vvalue = priv->predicted_vvalue;
+}
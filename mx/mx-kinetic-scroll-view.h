@@ -90,6 +90,10 @@ void mx_kinetic_scroll_view_set_use_grab (MxKineticScrollView *scroll,
                                           gboolean             use_grab);
 gboolean mx_kinetic_scroll_view_get_use_grab (MxKineticScrollView *scroll);
 
+void mx_kinetic_scroll_view_set_use_tile_cache (MxKineticScrollView *scroll,
+                                                gboolean             use_tile_cache);
+gboolean mx_kinetic_scroll_view_get_use_tile_cache (MxKineticScrollView *scroll);
+
 void mx_kinetic_scroll_view_set_mouse_button (MxKineticScrollView *scroll,
                                               guint32         button);
 guint32 mx_kinetic_scroll_view_get_mouse_button (MxKineticScrollView *scroll);
@@ -127,6 +131,10 @@ void mx_kinetic_scroll_view_set_snap_on_page (MxKineticScrollView *scroll,
                                               gboolean snap_on_page);
 gboolean mx_kinetic_scroll_view_get_snap_on_page (MxKineticScrollView *scroll);
 
+void  mx_kinetic_scroll_view_set_motion_prediction (MxKineticScrollView *scroll,
+                                                    guint                prediction);
+guint mx_kinetic_scroll_view_get_motion_prediction (MxKineticScrollView *scroll);
+
 void mx_kinetic_scroll_view_ensure_visible (MxKineticScrollView   *scroll,
                                             const ClutterGeometry *geometry);
 
@@ -134,6 +142,10 @@ void mx_kinetic_scroll_view_get_input (MxKineticScrollView   *scroll,
                                        ClutterInputDevice   **device,
                                        ClutterEventSequence **sequence);
 
+void mx_kinetic_scroll_view_get_predicted_position (MxKineticScrollView *scroll,
+                                                    gdouble             *hvalue,
+                                                    gdouble             *vvalue);
+
 G_END_DECLS
 
 #endif /* __MX_KINETIC_SCROLL_VIEW_H__ */
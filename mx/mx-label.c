@@ -35,19 +35,21 @@
 #include "config.h"
 #endif
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <glib.h>
 
 #include <clutter/clutter.h>
+#include <cogl-pango/cogl-pango.h>
+#include <pango/pangocairo.h>
 
 #include "mx-label.h"
 
 #include "mx-widget.h"
 #include "mx-stylable.h"
 #include "mx-private.h"
-#include "mx-fade-effect.h"
 
 enum
 {
@@ -68,7 +70,6 @@ enum
 struct _MxLabelPrivate
 {
   ClutterActor  *label;
-  ClutterEffect *fade_effect;
 
   MxAlign x_align;
   MxAlign y_align;
@@ -77,6 +78,11 @@ struct _MxLabelPrivate
 
   gint em_width;
 
+  /* the width of the label that is shown when fading, and how far the
+   * fade has gone in, from 0 to 1 */
+  gfloat  fade_width;
+  gdouble fade_progress;
+
   guint fade_out           : 1;
   guint label_should_fade  : 1;
   guint show_tooltip       : 1;
@@ -188,6 +194,525 @@ mx_label_style_changed (MxWidget            *self,
                                              CLUTTER_TEXT (priv->label));
 }
 
+/* Sizes of the texts of the labels, shared by all of them so that labels
+ * with the same text and attributes, as found in grids and lists, only
+ * have it measured once. The entries are kept in least recently used
+ * order, and all are dropped when the font settings change. */
+#define MX_LABEL_SIZE_CACHE_SIZE 256
+
+typedef struct
+{
+  gchar                *text;
+  PangoFontDescription *font;
+  ClutterMargin         margin;
+  gfloat                for_size;
+  PangoWrapMode         wrap_mode;
+  PangoEllipsizeMode    ellipsize;
+  PangoAlignment        alignment;
+  guint                 height      : 1;
+  guint                 use_markup  : 1;
+  guint                 line_wrap   : 1;
+  guint                 single_line : 1;
+  guint                 justify     : 1;
+
+  gfloat                min_size;
+  gfloat                natural_size;
+  GList                *link;
+} MxLabelSizeEntry;
+
+static GHashTable *size_cache = NULL;
+static GQueue size_cache_lru = G_QUEUE_INIT;
+
+static guint
+mx_label_size_entry_hash (gconstpointer key)
+{
+  const MxLabelSizeEntry *entry = key;
+
+  return g_str_hash (entry->text) ^
+    pango_font_description_hash (entry->font) ^
+    ((guint) (gint) entry->for_size << 1) ^ entry->height;
+}
+
+static gboolean
+mx_label_size_entry_equal (gconstpointer a,
+                           gconstpointer b)
+{
+  const MxLabelSizeEntry *entry_a = a, *entry_b = b;
+
+  return entry_a->for_size == entry_b->for_size &&
+    entry_a->height == entry_b->height &&
+    entry_a->use_markup == entry_b->use_markup &&
+    entry_a->line_wrap == entry_b->line_wrap &&
+    entry_a->single_line == entry_b->single_line &&
+    entry_a->justify == entry_b->justify &&
+    entry_a->wrap_mode == entry_b->wrap_mode &&
+    entry_a->ellipsize == entry_b->ellipsize &&
+    entry_a->alignment == entry_b->alignment &&
+    !memcmp (&entry_a->margin, &entry_b->margin, sizeof (ClutterMargin)) &&
+    pango_font_description_equal (entry_a->font, entry_b->font) &&
+    g_str_equal (entry_a->text, entry_b->text);
+}
+
+static void
+mx_label_size_entry_free (MxLabelSizeEntry *entry)
+{
+  g_free (entry->text);
+  pango_font_description_free (entry->font);
+  g_slice_free (MxLabelSizeEntry, entry);
+}
+
+static void
+mx_label_size_cache_clear (void)
+{
+  MxLabelSizeEntry *entry;
+
+  g_hash_table_remove_all (size_cache);
+  while ((entry = g_queue_pop_head (&size_cache_lru)))
+    mx_label_size_entry_free (entry);
+}
+
+static void
+mx_label_font_settings_changed_cb (ClutterSettings *settings,
+                                   GParamSpec      *pspec,
+                                   gpointer         user_data)
+{
+  mx_label_size_cache_clear ();
+}
+
+static void
+mx_label_size_cache_ensure (void)
+{
+  if (G_UNLIKELY (!size_cache))
+    {
+      size_cache = g_hash_table_new (mx_label_size_entry_hash,
+                                     mx_label_size_entry_equal);
+      g_signal_connect (clutter_settings_get_default (), "notify",
+                        G_CALLBACK (mx_label_font_settings_changed_cb),
+                        NULL);
+    }
+}
+
+/* Fills in @key for measuring @text; returns %FALSE when the size of @text
+ * depends on something that is not part of the key. */
+static gboolean
+mx_label_size_key_init (MxLabelSizeEntry *key,
+                        ClutterText      *text,
+                        gboolean          height,
+                        gfloat            for_size)
+{
+  ClutterActor *actor = CLUTTER_ACTOR (text);
+  gboolean min_set, natural_set;
+  PangoFontDescription *font;
+
+  font = clutter_text_get_font_description (text);
+
+  g_object_get (text,
+                height ? "min-height-set" : "min-width-set", &min_set,
+                height ? "natural-height-set" : "natural-width-set",
+                &natural_set,
+                NULL);
+
+  if (!font || min_set || natural_set ||
+      clutter_text_get_attributes (text) ||
+      clutter_text_get_password_char (text) ||
+      clutter_text_get_editable (text))
+    return FALSE;
+
+  key->text = (gchar *) clutter_text_get_text (text);
+  key->font = font;
+  clutter_actor_get_margin (actor, &key->margin);
+  key->for_size = for_size;
+  key->wrap_mode = clutter_text_get_line_wrap_mode (text);
+  key->ellipsize = clutter_text_get_ellipsize (text);
+  key->alignment = clutter_text_get_line_alignment (text);
+  key->height = height;
+  key->use_markup = clutter_text_get_use_markup (text);
+  key->line_wrap = clutter_text_get_line_wrap (text);
+  key->single_line = clutter_text_get_single_line_mode (text);
+  key->justify = clutter_text_get_justify (text);
+
+  return TRUE;
+}
+
+static MxLabelSizeEntry *
+mx_label_size_entry_dup (const MxLabelSizeEntry *key)
+{
+  MxLabelSizeEntry *entry;
+
+  entry = g_slice_dup (MxLabelSizeEntry, key);
+  entry->text = g_strdup (key->text);
+  entry->font = pango_font_description_copy (key->font);
+
+  return entry;
+}
+
+/* adds @entry to the front of the cache, dropping the least recently used
+ * entry when it is full */
+static void
+mx_label_size_cache_insert (MxLabelSizeEntry *entry)
+{
+  if (g_queue_get_length (&size_cache_lru) >= MX_LABEL_SIZE_CACHE_SIZE)
+    {
+      MxLabelSizeEntry *oldest = g_queue_pop_tail (&size_cache_lru);
+
+      g_hash_table_remove (size_cache, oldest);
+      mx_label_size_entry_free (oldest);
+    }
+
+  g_queue_push_head (&size_cache_lru, entry);
+  entry->link = g_queue_peek_head_link (&size_cache_lru);
+  g_hash_table_insert (size_cache, entry, entry);
+}
+
+/* Gets the preferred width (or height, with @height) of @text for
+ * @for_size, from the cache when another label measured the same. */
+static void
+mx_label_get_text_size (ClutterText *text,
+                        gboolean     height,
+                        gfloat       for_size,
+                        gfloat      *min_size_p,
+                        gfloat      *natural_size_p)
+{
+  ClutterActor *actor = CLUTTER_ACTOR (text);
+  MxLabelSizeEntry key, *entry;
+
+  /* anything that is not in the key gets measured directly */
+  if (!mx_label_size_key_init (&key, text, height, for_size))
+    {
+      if (height)
+        clutter_actor_get_preferred_height (actor, for_size,
+                                            min_size_p, natural_size_p);
+      else
+        clutter_actor_get_preferred_width (actor, for_size,
+                                           min_size_p, natural_size_p);
+      return;
+    }
+
+  mx_label_size_cache_ensure ();
+
+  entry = g_hash_table_lookup (size_cache, &key);
+  if (entry)
+    {
+      /* move it to the front of the queue */
+      g_queue_unlink (&size_cache_lru, entry->link);
+      g_queue_push_head_link (&size_cache_lru, entry->link);
+    }
+  else
+    {
+      entry = mx_label_size_entry_dup (&key);
+
+      if (height)
+        clutter_actor_get_preferred_height (actor, for_size,
+                                            &entry->min_size,
+                                            &entry->natural_size);
+      else
+        clutter_actor_get_preferred_width (actor, for_size,
+                                           &entry->min_size,
+                                           &entry->natural_size);
+
+      mx_label_size_cache_insert (entry);
+    }
+
+  if (min_size_p)
+    *min_size_p = entry->min_size;
+  if (natural_size_p)
+    *natural_size_p = entry->natural_size;
+}
+
+/* Measuring the texts of many labels at once, on worker threads, before
+ * they are laid out. The workers can't use the labels nor the font map of
+ * Clutter, so each measures copies of the cache keys with a font map of
+ * its own, the way ClutterText measures its layout. What they measure is
+ * the natural width of each text and its height at that width, which is
+ * what labels are asked for in grids and lists of items. */
+#define MX_LABEL_PREFETCH_MIN_JOBS 16
+#define MX_LABEL_PREFETCH_MAX_JOBS (MX_LABEL_SIZE_CACHE_SIZE / 2)
+
+typedef struct
+{
+  MxLabelSizeEntry *width;
+  MxLabelSizeEntry *height;
+} MxLabelPrefetchJob;
+
+typedef struct
+{
+  GArray               *jobs;
+  gint                  next_job;
+
+  gdouble               resolution;
+  cairo_font_options_t *font_options;
+
+  GMutex                mutex;
+  GCond                 cond;
+  guint                 n_running;
+} MxLabelPrefetch;
+
+static GPrivate prefetch_font_map = G_PRIVATE_INIT (g_object_unref);
+static GThreadPool *prefetch_pool = NULL;
+
+/* same as the preferred size of ClutterText, plus its margin as added by
+ * ClutterActor */
+static void
+mx_label_measure_entry (PangoContext     *context,
+                        MxLabelSizeEntry *entry)
+{
+  PangoLayout *layout;
+  PangoRectangle logical_rect;
+  gfloat size, for_width;
+
+  layout = pango_layout_new (context);
+  pango_layout_set_text (layout, entry->text, -1);
+  pango_layout_set_font_description (layout, entry->font);
+  pango_layout_set_alignment (layout, entry->alignment);
+  pango_layout_set_single_paragraph_mode (layout, entry->single_line);
+  pango_layout_set_justify (layout, entry->justify);
+  pango_layout_set_ellipsize (layout, entry->ellipsize);
+  pango_layout_set_wrap (layout, entry->wrap_mode);
+
+  if (!entry->height)
+    {
+      pango_layout_get_extents (layout, NULL, &logical_rect);
+      size = logical_rect.x + logical_rect.width;
+      size = (size > 0) ? ceilf (size / PANGO_SCALE) : 1;
+
+      if (entry->line_wrap || entry->ellipsize != PANGO_ELLIPSIZE_NONE)
+        entry->min_size = 1;
+      else
+        entry->min_size = size;
+      entry->natural_size = size;
+
+      entry->min_size += entry->margin.left + entry->margin.right;
+      entry->natural_size += entry->margin.left + entry->margin.right;
+    }
+  else
+    {
+      for_width = entry->for_size;
+      if (for_width > 0)
+        for_width = MAX (0, for_width -
+                         (entry->margin.left + entry->margin.right));
+
+      if (for_width == 0)
+        entry->min_size = entry->natural_size = 0;
+      else
+        {
+          if (for_width > 0 &&
+              (entry->line_wrap || entry->ellipsize != PANGO_ELLIPSIZE_NONE))
+            pango_layout_set_width (layout, for_width * PANGO_SCALE);
+
+          pango_layout_get_extents (layout, NULL, &logical_rect);
+          entry->natural_size =
+            ceilf ((gfloat) (logical_rect.y + logical_rect.height) /
+                   PANGO_SCALE);
+
+          if (entry->line_wrap && entry->ellipsize != PANGO_ELLIPSIZE_NONE)
+            {
+              PangoLayoutLine *line;
+
+              line = pango_layout_get_line_readonly (layout, 0);
+              pango_layout_line_get_extents (line, NULL, &logical_rect);
+              entry->min_size =
+                ceilf ((gfloat) (logical_rect.y + logical_rect.height) /
+                       PANGO_SCALE);
+            }
+          else
+            entry->min_size = entry->natural_size;
+        }
+
+      entry->min_size += entry->margin.top + entry->margin.bottom;
+      entry->natural_size += entry->margin.top + entry->margin.bottom;
+    }
+
+  g_object_unref (layout);
+}
+
+/* measures jobs until there are none left, on any thread */
+static void
+mx_label_prefetch_run (MxLabelPrefetch *prefetch)
+{
+  PangoFontMap *font_map;
+  PangoContext *context;
+  guint i;
+
+  font_map = g_private_get (&prefetch_font_map);
+  if (!font_map)
+    {
+      font_map = pango_cairo_font_map_new ();
+      g_private_set (&prefetch_font_map, font_map);
+    }
+
+  context = pango_font_map_create_context (font_map);
+  pango_cairo_context_set_resolution (context, prefetch->resolution);
+  pango_cairo_context_set_font_options (context, prefetch->font_options);
+
+  while ((i = g_atomic_int_add (&prefetch->next_job, 1)) <
+         prefetch->jobs->len)
+    {
+      MxLabelPrefetchJob *job =
+        &g_array_index (prefetch->jobs, MxLabelPrefetchJob, i);
+
+      mx_label_measure_entry (context, job->width);
+
+      job->height->for_size = job->width->natural_size;
+      mx_label_measure_entry (context, job->height);
+    }
+
+  g_object_unref (context);
+}
+
+static void
+mx_label_prefetch_worker (gpointer data,
+                          gpointer user_data)
+{
+  MxLabelPrefetch *prefetch = data;
+
+  mx_label_prefetch_run (prefetch);
+
+  g_mutex_lock (&prefetch->mutex);
+  if (--prefetch->n_running == 0)
+    g_cond_signal (&prefetch->cond);
+  g_mutex_unlock (&prefetch->mutex);
+}
+
+/* collects the labels under @actor whose natural width is not cached yet */
+static void
+mx_label_prefetch_collect (ClutterActor *actor,
+                           GHashTable   *seen,
+                           GArray       *jobs)
+{
+  ClutterActorIter iter;
+  ClutterActor *child;
+
+  if (MX_IS_LABEL (actor))
+    {
+      ClutterText *text = CLUTTER_TEXT (MX_LABEL (actor)->priv->label);
+      MxLabelPrefetchJob job;
+      MxLabelSizeEntry key;
+
+      /* the attributes of markup are not part of the key */
+      if (!mx_label_size_key_init (&key, text, FALSE, -1) ||
+          key.use_markup ||
+          g_hash_table_contains (size_cache, &key) ||
+          g_hash_table_contains (seen, &key))
+        return;
+
+      job.width = mx_label_size_entry_dup (&key);
+      job.height = mx_label_size_entry_dup (&key);
+      job.height->height = TRUE;
+
+      g_array_append_val (jobs, job);
+      g_hash_table_add (seen, job.width);
+
+      return;
+    }
+
+  clutter_actor_iter_init (&iter, actor);
+  while (jobs->len < MX_LABEL_PREFETCH_MAX_JOBS &&
+         clutter_actor_iter_next (&iter, &child))
+    {
+      if (CLUTTER_ACTOR_IS_VISIBLE (child))
+        mx_label_prefetch_collect (child, seen, jobs);
+    }
+}
+
+/* measures the jobs of @prefetch on the main thread and the workers, then
+ * adds them to the cache */
+static void
+mx_label_prefetch_measure (MxLabelPrefetch *prefetch)
+{
+  ClutterBackend *backend = clutter_get_default_backend ();
+  const cairo_font_options_t *font_options;
+  guint i, n_workers;
+  MX_TRACE_BEGIN (mx_label_prefetch_measure);
+
+  prefetch->next_job = 0;
+  prefetch->resolution = clutter_backend_get_resolution (backend);
+  if (prefetch->resolution <= 0)
+    prefetch->resolution = 96.0;
+  font_options = clutter_backend_get_font_options (backend);
+  prefetch->font_options = font_options ?
+    cairo_font_options_copy (font_options) : cairo_font_options_create ();
+  g_mutex_init (&prefetch->mutex);
+  g_cond_init (&prefetch->cond);
+
+  if (G_UNLIKELY (!prefetch_pool))
+    prefetch_pool = g_thread_pool_new (mx_label_prefetch_worker, NULL,
+                                       MAX (1, g_get_num_processors () - 1),
+                                       FALSE, NULL);
+
+  /* the main thread measures too, rather than only waiting */
+  n_workers = MIN (prefetch->jobs->len / MX_LABEL_PREFETCH_MIN_JOBS,
+                   (guint) g_get_num_processors ()) - 1;
+  prefetch->n_running = n_workers;
+  for (i = 0; i < n_workers; i++)
+    if (!g_thread_pool_push (prefetch_pool, prefetch, NULL))
+      prefetch->n_running--;
+
+  mx_label_prefetch_run (prefetch);
+
+  g_mutex_lock (&prefetch->mutex);
+  while (prefetch->n_running)
+    g_cond_wait (&prefetch->cond, &prefetch->mutex);
+  g_mutex_unlock (&prefetch->mutex);
+
+  for (i = 0; i < prefetch->jobs->len; i++)
+    {
+      MxLabelPrefetchJob *job =
+        &g_array_index (prefetch->jobs, MxLabelPrefetchJob, i);
+
+      mx_label_size_cache_insert (job->width);
+
+      if (g_hash_table_contains (size_cache, job->height))
+        mx_label_size_entry_free (job->height);
+      else
+        mx_label_size_cache_insert (job->height);
+    }
+
+  g_array_free (prefetch->jobs, TRUE);
+  cairo_font_options_destroy (prefetch->font_options);
+  g_mutex_clear (&prefetch->mutex);
+  g_cond_clear (&prefetch->cond);
+
+  MX_TRACE_END (mx_label_prefetch_measure);
+}
+
+/* Measures the texts of the labels under @container on worker threads and
+ * adds them to the size cache, so that laying @container out finds them
+ * there. Nothing is done when there are too few to be worth it. */
+void
+_mx_label_prefetch_text_sizes (ClutterActor *container)
+{
+  MxLabelPrefetch prefetch;
+  GHashTable *seen;
+  guint i;
+
+  mx_label_size_cache_ensure ();
+
+  prefetch.jobs = g_array_new (FALSE, FALSE, sizeof (MxLabelPrefetchJob));
+  seen = g_hash_table_new (mx_label_size_entry_hash,
+                           mx_label_size_entry_equal);
+
+  mx_label_prefetch_collect (container, seen, prefetch.jobs);
+
+  g_hash_table_destroy (seen);
+
+  if (prefetch.jobs->len < MX_LABEL_PREFETCH_MIN_JOBS)
+    {
+      for (i = 0; i < prefetch.jobs->len; i++)
+        {
+          MxLabelPrefetchJob *job =
+            &g_array_index (prefetch.jobs, MxLabelPrefetchJob, i);
+
+          mx_label_size_entry_free (job->width);
+          mx_label_size_entry_free (job->height);
+        }
+      g_array_free (prefetch.jobs, TRUE);
+
+      return;
+    }
+
+  mx_label_prefetch_measure (&prefetch);
+}
+
 static void
 mx_label_get_preferred_width (ClutterActor *actor,
                               gfloat        for_height,
@@ -201,9 +726,8 @@ mx_label_get_preferred_width (ClutterActor *actor,
 
   for_height -= padding.top + padding.bottom;
 
-  clutter_actor_get_preferred_width (priv->label, for_height,
-                                     min_width_p,
-                                     natural_width_p);
+  mx_label_get_text_size (CLUTTER_TEXT (priv->label), FALSE, for_height,
+                          min_width_p, natural_width_p);
 
   /* If we're fading out, make sure our minimum width is zero */
   if (priv->fade_out && min_width_p)
@@ -229,9 +753,8 @@ mx_label_get_preferred_height (ClutterActor *actor,
 
   for_width -= padding.left + padding.right;
 
-  clutter_actor_get_preferred_height (priv->label, for_width,
-                                      min_height_p,
-                                      natural_height_p);
+  mx_label_get_text_size (CLUTTER_TEXT (priv->label), TRUE, for_width,
+                          min_height_p, natural_height_p);
 
   if (min_height_p)
     *min_height_p += padding.top + padding.bottom;
@@ -277,12 +800,13 @@ mx_label_allocate (ClutterActor          *actor,
   if (priv->fade_out)
     {
       /* If we're fading out, make sure the label has its full width
-       * allocated. This ensures that the offscreen effect has the full
-       * label inside its texture.
+       * allocated, so that its layout is not ellipsized; the part that
+       * does not fit is clipped when painting.
        */
       gfloat label_width;
 
-      clutter_actor_get_preferred_width (priv->label, -1, NULL, &label_width);
+      mx_label_get_text_size (CLUTTER_TEXT (priv->label), FALSE, -1,
+                              NULL, &label_width);
 
       if (label_width > avail_width)
         {
@@ -290,8 +814,7 @@ mx_label_allocate (ClutterActor          *actor,
           child_box.x2 = child_box.x1 + label_width;
         }
 
-      mx_fade_effect_set_bounds (MX_FADE_EFFECT (priv->fade_effect),
-                                 0, 0, MIN (label_width, avail_width), 0);
+      priv->fade_width = MIN (label_width, avail_width);
     }
 
   /* Allocate the label */
@@ -330,17 +853,80 @@ mx_label_allocate (ClutterActor          *actor,
     }
 }
 
+/* Number of pixels over which the opacity of the fade is constant */
+#define MX_LABEL_FADE_STEP 4
+#define MX_LABEL_FADE_MAX_STEPS 24
+
+/* Paints the label up to where the fade starts, then the glyphs of the
+ * faded end in strips of decreasing opacity. The layout keeps its glyphs
+ * cached, so this avoids rendering the text offscreen. */
+static void
+mx_label_paint_faded (MxLabel *label)
+{
+  MxLabelPrivate *priv = label->priv;
+  ClutterText *text = CLUTTER_TEXT (priv->label);
+  ClutterActorBox box;
+  ClutterColor text_color;
+  PangoLayout *layout;
+  gfloat border, fade_x;
+  guint8 opacity;
+  gint i, n_steps;
+
+  clutter_actor_get_allocation_box (priv->label, &box);
+
+  border = MIN (priv->em_width * 5, priv->fade_width);
+  fade_x = box.x1 + priv->fade_width - border;
+
+  cogl_clip_push_rectangle (box.x1, box.y1, fade_x, box.y2);
+  clutter_actor_paint (priv->label);
+  cogl_clip_pop ();
+
+  if (border <= 0)
+    return;
+
+  layout = clutter_text_get_layout (text);
+  clutter_text_get_color (text, &text_color);
+  opacity = clutter_actor_get_paint_opacity (priv->label) *
+    text_color.alpha / 255;
+
+  n_steps = CLAMP (border / MX_LABEL_FADE_STEP, 1, MX_LABEL_FADE_MAX_STEPS);
+
+  for (i = 0; i < n_steps; i++)
+    {
+      CoglColor color;
+      gfloat fade;
+
+      /* the opacity goes down linearly to 1 - progress at the end */
+      fade = 1.0 - priv->fade_progress * (i + 0.5) / n_steps;
+
+      cogl_color_init_from_4ub (&color,
+                                text_color.red,
+                                text_color.green,
+                                text_color.blue,
+                                opacity * fade);
+
+      cogl_clip_push_rectangle (fade_x + border * i / n_steps, box.y1,
+                                fade_x + border * (i + 1) / n_steps, box.y2);
+      cogl_pango_render_layout (layout, box.x1, box.y1, &color, 0);
+      cogl_clip_pop ();
+    }
+}
+
 static void
 mx_label_paint (ClutterActor *actor)
 {
-  MxLabelPrivate *priv = MX_LABEL (actor)->priv;
+  MxLabel *label = MX_LABEL (actor);
+  MxLabelPrivate *priv = label->priv;
   ClutterActorClass *parent_class;
 
   parent_class = CLUTTER_ACTOR_CLASS (mx_label_parent_class);
   parent_class->paint (actor);
 
-  clutter_actor_paint (priv->label);
-  _mx_fade_effect_set_freeze_update (MX_FADE_EFFECT (priv->fade_effect), TRUE);
+  if (priv->fade_out && priv->fade_progress > 0 &&
+      CLUTTER_ACTOR_IS_VISIBLE (priv->label))
+    mx_label_paint_faded (label);
+  else
+    clutter_actor_paint (priv->label);
 }
 
 static void
@@ -477,15 +1063,6 @@ mx_label_single_line_mode_cb (ClutterText *text,
     mx_label_set_fade_out (self, FALSE);
 }
 
-static void
-mx_label_label_changed_cb (MxLabel *label)
-{
-  MxLabelPrivate *priv = label->priv;
-
-  /* Enable updating of the off-screen texture */
-  _mx_fade_effect_set_freeze_update (MX_FADE_EFFECT (priv->fade_effect), FALSE);
-}
-
 static void
 mx_label_font_description_cb (ClutterText *text,
                               GParamSpec  *pspec,
@@ -518,8 +1095,7 @@ mx_label_font_description_cb (ClutterText *text,
 
       priv->em_width = (1.2f * font_size) * dpi / 96.f;
 
-      mx_fade_effect_set_border (MX_FADE_EFFECT (priv->fade_effect),
-                                 0, priv->em_width * 5, 0, 0);
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
     }
 }
 
@@ -528,31 +1104,13 @@ mx_label_fade_new_frame_cb (ClutterTimeline *timeline,
                             gint             msecs,
                             MxLabel         *self)
 {
-  guint8 a;
-  ClutterColor color;
-
   MxLabelPrivate *priv = self->priv;
 
-  a = (1.0 - clutter_timeline_get_progress (priv->fade_timeline)) * 255;
-
-  color.red = a;
-  color.green = a;
-  color.blue = a;
-  color.alpha = a;
-
-  mx_fade_effect_set_color (MX_FADE_EFFECT (priv->fade_effect), &color);
+  priv->fade_progress = clutter_timeline_get_progress (priv->fade_timeline);
 
   clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
 }
 
-static void
-mx_label_fade_started_cb (ClutterTimeline *timeline,
-                          MxLabel         *label)
-{
-  clutter_actor_meta_set_enabled (CLUTTER_ACTOR_META (label->priv->fade_effect),
-                                  TRUE);
-}
-
 static void
 mx_label_fade_completed_cb (ClutterTimeline *timeline,
                             MxLabel         *label)
@@ -560,15 +1118,16 @@ mx_label_fade_completed_cb (ClutterTimeline *timeline,
   MxLabelPrivate *priv = label->priv;
 
   if (!priv->label_should_fade)
-    clutter_actor_meta_set_enabled (CLUTTER_ACTOR_META (priv->fade_effect),
-                                    FALSE);
+    {
+      priv->fade_progress = 0;
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (label));
+    }
 }
 
 static void
 mx_label_init (MxLabel *label)
 {
   MxLabelPrivate *priv;
-  const ClutterColor opaque = { 0xff, 0xff, 0xff, 0xff };
 
   label->priv = priv = MX_LABEL_GET_PRIVATE (label);
 
@@ -578,26 +1137,16 @@ mx_label_init (MxLabel *label)
 
   clutter_actor_add_child (CLUTTER_ACTOR (label), priv->label);
 
-  priv->fade_effect = mx_fade_effect_new ();
-  mx_fade_effect_set_color (MX_FADE_EFFECT (priv->fade_effect), &opaque);
-  clutter_actor_add_effect (priv->label, priv->fade_effect);
-  clutter_actor_meta_set_enabled (CLUTTER_ACTOR_META (priv->fade_effect),
-                                  FALSE);
-
   g_signal_connect (label, "style-changed",
                     G_CALLBACK (mx_label_style_changed), NULL);
   g_signal_connect (priv->label, "notify::single-line-mode",
                     G_CALLBACK (mx_label_single_line_mode_cb), label);
-  g_signal_connect_swapped (priv->label, "queue-redraw",
-                            G_CALLBACK (mx_label_label_changed_cb), label);
 
   priv->fade_timeline = clutter_timeline_new (250);
   clutter_timeline_set_progress_mode (priv->fade_timeline,
                                       CLUTTER_EASE_OUT_QUAD);
   g_signal_connect (priv->fade_timeline, "new-frame",
                     G_CALLBACK (mx_label_fade_new_frame_cb), label);
-  g_signal_connect (priv->fade_timeline, "started",
-                    G_CALLBACK (mx_label_fade_started_cb), label);
   g_signal_connect (priv->fade_timeline, "completed",
                     G_CALLBACK (mx_label_fade_completed_cb), label);
 }
@@ -32,31 +32,56 @@
  *
  * Data is set on the children by mapping columns in the model to object
  * properties on the children.
+ *
+ * When #MxListView:virtualized is set and the list view is vertical and in
+ * a scrollable container, such as #MxScrollView, children are only created
+ * for the rows that are visible, and a few more on each side, and are
+ * reused for other rows as the view scrolls.
+ *
+ * The view can also be driven by a #GListModel, set with
+ * mx_list_view_set_list_model(). Each child is then given the item of its
+ * row through the property named by #MxListView:item-property, and the
+ * changes of the model are applied to the children they concern only.
  */
 
+#include <math.h>
+#include <string.h>
+
 #include "mx-list-view.h"
 #include "mx-box-layout.h"
 #include "mx-private.h"
 #include "mx-item-factory.h"
+#include "mx-scrollable.h"
+
+static void mx_list_view_scrollable_iface_init (MxScrollableIface *iface);
 
-G_DEFINE_TYPE (MxListView, mx_list_view, MX_TYPE_BOX_LAYOUT)
+G_DEFINE_TYPE_WITH_CODE (MxListView, mx_list_view, MX_TYPE_BOX_LAYOUT,
+                         G_IMPLEMENT_INTERFACE (MX_TYPE_SCROLLABLE,
+                                                mx_list_view_scrollable_iface_init))
+
+static MxScrollableIface *mx_list_view_scrollable_parent_iface = NULL;
+
+/* the number of rows created beyond each edge of the view when the view is
+ * virtualized, so that they're ready before they scroll in */
+#define MX_LIST_VIEW_OVERSCAN 4
 
 #define LIST_VIEW_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_LIST_VIEW, MxListViewPrivate))
 
-typedef struct
-{
-  gchar *name;
-  gint   col;
-} AttributeData;
-
 enum
 {
   PROP_0,
 
   PROP_MODEL,
   PROP_ITEM_TYPE,
-  PROP_FACTORY
+  PROP_FACTORY,
+  PROP_VIRTUALIZED,
+  PROP_RECYCLE_SIZE,
+  PROP_PROGRESSIVE,
+  PROP_VARIABLE_ROW_HEIGHT,
+  PROP_LIST_MODEL,
+  PROP_ITEM_PROPERTY,
+  PROP_KEY_COLUMN
 };
 
 struct _MxListViewPrivate
@@ -73,9 +98,68 @@ struct _MxListViewPrivate
   gulong         row_removed;
   gulong         sort_changed;
 
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  /* set instead of the model, the items of which are set on the
+   * item_property of the children */
+  GListModel    *list_model;
+#endif
+  gchar         *item_property;
+
+  /* the column the children are matched to their rows by when the model
+   * is sorted or filtered, or -1 */
+  gint           key_column;
+
+  /* children kept after they were removed, to be used again for other
+   * rows instead of creating new ones */
+  GQueue         recycled;
+  guint          recycle_size;
+
+  /* when progressive, the row the next operation of the stage's actor
+   * manager creates or binds a child for */
+  MxActorManager *manager;
+  gulong         progressive_op;
+  gint           progressive_row;
+
   guint          is_frozen : 1;
+  guint          progressive : 1;
+  guint          virtualized : 1;
+  guint          variable_row_height : 1;
+  guint          rebind_pending : 1;
+  guint          in_allocation : 1;
+
+  /* When virtualized, the children show the rows from first_row to
+   * last_row, not including it, and all the rows are assumed to be
+   * row_height high, as measured from the first one. */
+  MxAdjustment  *vadjustment;
+  gint           first_row;
+  gint           last_row;
+  gfloat         row_height;
+  guint          update_idle;
+
+  /* With variable row heights, the height of each row, as measured or
+   * estimated, and a Fenwick tree of the heights plus the spacing, so that
+   * the offset of a row and the row at an offset are found in O(log n).
+   * The tree is 1-based, and built for index_width and index_spacing. */
+  GArray        *row_heights;
+  GArray        *row_tree;
+  gfloat         index_width;
+  gfloat         index_spacing;
+
+  MxListViewRowHeightFunc row_height_func;
+  gpointer       row_height_data;
+  GDestroyNotify row_height_notify;
 };
 
+static void model_changed_cb (ClutterModel *model,
+                              MxListView   *list_view);
+static void mx_list_view_vadjustment_value_cb (MxAdjustment *adjustment,
+                                               GParamSpec   *pspec,
+                                               MxListView   *list_view);
+static void mx_list_view_clear_recycled (MxListView *list_view,
+                                         guint       keep);
+static void mx_list_view_stop_progressive (MxListView *list_view);
+static void mx_list_view_index_clear (MxListView *list_view);
+
 /* gobject implementations */
 
 static void
@@ -96,6 +180,29 @@ mx_list_view_get_property (GObject    *object,
     case PROP_FACTORY:
       g_value_set_object (value, priv->factory);
       break;
+    case PROP_VIRTUALIZED:
+      g_value_set_boolean (value, priv->virtualized);
+      break;
+    case PROP_RECYCLE_SIZE:
+      g_value_set_uint (value, priv->recycle_size);
+      break;
+    case PROP_PROGRESSIVE:
+      g_value_set_boolean (value, priv->progressive);
+      break;
+    case PROP_VARIABLE_ROW_HEIGHT:
+      g_value_set_boolean (value, priv->variable_row_height);
+      break;
+#if GLIB_CHECK_VERSION (2, 44, 0)
+    case PROP_LIST_MODEL:
+      g_value_set_object (value, priv->list_model);
+      break;
+#endif
+    case PROP_ITEM_PROPERTY:
+      g_value_set_string (value, priv->item_property);
+      break;
+    case PROP_KEY_COLUMN:
+      g_value_set_int (value, priv->key_column);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -121,6 +228,36 @@ mx_list_view_set_property (GObject      *object,
       mx_list_view_set_factory ((MxListView*) object,
                                 (MxItemFactory*) g_value_get_object (value));
       break;
+    case PROP_VIRTUALIZED:
+      mx_list_view_set_virtualized ((MxListView*) object,
+                                    g_value_get_boolean (value));
+      break;
+    case PROP_RECYCLE_SIZE:
+      mx_list_view_set_recycle_size ((MxListView*) object,
+                                     g_value_get_uint (value));
+      break;
+    case PROP_PROGRESSIVE:
+      mx_list_view_set_progressive ((MxListView*) object,
+                                    g_value_get_boolean (value));
+      break;
+    case PROP_VARIABLE_ROW_HEIGHT:
+      mx_list_view_set_variable_row_height ((MxListView*) object,
+                                            g_value_get_boolean (value));
+      break;
+#if GLIB_CHECK_VERSION (2, 44, 0)
+    case PROP_LIST_MODEL:
+      mx_list_view_set_list_model ((MxListView*) object,
+                                   g_value_get_object (value));
+      break;
+#endif
+    case PROP_ITEM_PROPERTY:
+      mx_list_view_set_item_property ((MxListView*) object,
+                                      g_value_get_string (value));
+      break;
+    case PROP_KEY_COLUMN:
+      mx_list_view_set_key_column ((MxListView*) object,
+                                 g_value_get_int (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -133,6 +270,28 @@ mx_list_view_dispose (GObject *object)
 
   /* This will cause the unref of the model and also disconnect the signals */
   mx_list_view_set_model (MX_LIST_VIEW (object), NULL);
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  mx_list_view_set_list_model (MX_LIST_VIEW (object), NULL);
+#endif
+
+  mx_list_view_stop_progressive (MX_LIST_VIEW (object));
+  mx_list_view_set_row_height_func (MX_LIST_VIEW (object), NULL, NULL, NULL);
+  mx_list_view_clear_recycled (MX_LIST_VIEW (object), 0);
+
+  if (priv->update_idle)
+    {
+      g_source_remove (priv->update_idle);
+      priv->update_idle = 0;
+    }
+
+  if (priv->vadjustment)
+    {
+      g_signal_handlers_disconnect_by_func (priv->vadjustment,
+                                            mx_list_view_vadjustment_value_cb,
+                                            object);
+      g_object_unref (priv->vadjustment);
+      priv->vadjustment = NULL;
+    }
 
   if (priv->factory)
     {
@@ -143,21 +302,19 @@ mx_list_view_dispose (GObject *object)
   G_OBJECT_CLASS (mx_list_view_parent_class)->dispose (object);
 }
 
-static void
-free_attribute (AttributeData *data)
-{
-  g_free (data->name);
-  g_free (data);
-}
-
 static void
 mx_list_view_finalize (GObject *object)
 {
   MxListViewPrivate *priv = MX_LIST_VIEW (object)->priv;
 
+  mx_list_view_index_clear (MX_LIST_VIEW (object));
+
+  g_free (priv->item_property);
+
   if (priv->attributes)
     {
-      g_slist_foreach (priv->attributes, (GFunc) free_attribute, NULL);
+      g_slist_foreach (priv->attributes, (GFunc) _mx_item_attribute_free,
+                       NULL);
       g_slist_free (priv->attributes);
       priv->attributes = NULL;
     }
@@ -165,332 +322,1727 @@ mx_list_view_finalize (GObject *object)
   G_OBJECT_CLASS (mx_list_view_parent_class)->finalize (object);
 }
 
-static void
-mx_list_view_class_init (MxListViewClass *klass)
+static gboolean
+mx_list_view_is_virtual (MxListView *list_view)
 {
-  GObjectClass *object_class = G_OBJECT_CLASS (klass);
-  GParamSpec *pspec;
-
-  g_type_class_add_private (klass, sizeof (MxListViewPrivate));
-
-  object_class->get_property = mx_list_view_get_property;
-  object_class->set_property = mx_list_view_set_property;
-  object_class->dispose = mx_list_view_dispose;
-  object_class->finalize = mx_list_view_finalize;
-
-  pspec = g_param_spec_object ("model",
-                               "model",
-                               "The model for the item view",
-                               CLUTTER_TYPE_MODEL,
-                               MX_PARAM_READWRITE);
-  g_object_class_install_property (object_class, PROP_MODEL, pspec);
-
-  pspec = g_param_spec_gtype ("item-type",
-                              "Item Type",
-                              "The GType to use as the items in the view. "
-                              "Must be a subclass of ClutterActor",
-                              CLUTTER_TYPE_ACTOR,
-                              MX_PARAM_READWRITE);
-  g_object_class_install_property (object_class, PROP_ITEM_TYPE, pspec);
+  MxListViewPrivate *priv = list_view->priv;
 
-  /* Note, interfaces aren't necessarily objects, so you can't use
-   * MX_TYPE_ITEM_FACTORY here. The function mx_list_view_set_factory does
-   * a type check, so this is still safe.
-   */
-  pspec = g_param_spec_object ("factory",
-                               "Factory",
-                               "The MxItemFactory used for creating new items.",
-                               G_TYPE_OBJECT /*MX_TYPE_ITEM_FACTORY*/,
-                               MX_PARAM_READWRITE);
-  g_object_class_install_property (object_class, PROP_FACTORY, pspec);
+  return priv->virtualized && priv->vadjustment &&
+    mx_box_layout_get_orientation (MX_BOX_LAYOUT (list_view)) ==
+    MX_ORIENTATION_VERTICAL;
 }
 
+/* Destroys the recycled children, until only @keep are left */
 static void
-mx_list_view_init (MxListView *list_view)
+mx_list_view_clear_recycled (MxListView   *list_view,
+                             guint         keep)
 {
-  list_view->priv = LIST_VIEW_PRIVATE (list_view);
+  MxListViewPrivate *priv = list_view->priv;
 
-  mx_box_layout_set_orientation (MX_BOX_LAYOUT (list_view), MX_ORIENTATION_VERTICAL);
-}
+  while (priv->recycled.length > keep)
+    {
+      ClutterActor *child = g_queue_pop_tail (&priv->recycled);
 
+      clutter_actor_destroy (child);
+      g_object_unref (child);
+    }
+}
 
-/* model monitors */
+/* Removes @child from the view, keeping it to be reused if there is room
+ * for it in the recycled children */
 static void
-model_changed_cb (ClutterModel *model,
-                  MxListView   *list_view)
+mx_list_view_release_item (MxListView   *list_view,
+                           ClutterActor *child)
 {
-  GSList *p;
-  GList *l, *children;
   MxListViewPrivate *priv = list_view->priv;
-  ClutterModelIter *iter = NULL;
-  gint model_n = 0, child_n = 0;
 
+  if (priv->recycled.length >= priv->recycle_size)
+    {
+      clutter_actor_remove_child (CLUTTER_ACTOR (list_view), child);
+      return;
+    }
 
-  /* bail out if we don't yet have an item type or a factory */
-  if (!priv->item_type && !priv->factory)
-    return;
+  g_object_ref (child);
+  clutter_actor_remove_child (CLUTTER_ACTOR (list_view), child);
 
-  if (priv->is_frozen)
-    return;
+  if (priv->factory)
+    mx_item_factory_reset (priv->factory, child);
 
-  if (priv->item_type)
+  g_queue_push_head (&priv->recycled, child);
+}
+
+static ClutterActor *
+mx_list_view_create_item (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActor *child;
+
+  /* the children that were kept are given back as new, floating ones */
+  child = g_queue_pop_head (&priv->recycled);
+  if (child)
     {
-      /* check the item-type is an descendant of ClutterActor */
-      if (!g_type_is_a (priv->item_type, CLUTTER_TYPE_ACTOR))
-        {
-          g_warning ("%s is not a subclass of ClutterActor and therefore"
-                     " cannot be used as items in an MxListView",
-                     g_type_name (priv->item_type));
-          return;
-        }
+      g_object_force_floating (G_OBJECT (child));
+      return child;
     }
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (list_view));
-  child_n = g_list_length (children);
-
-  if (model)
-    model_n = clutter_model_get_n_rows (priv->model);
+  if (priv->item_type)
+    return g_object_new (priv->item_type, NULL);
   else
-    model_n = 0;
-
-  /* add children as needed */
-  while (model_n > child_n)
-    {
-      ClutterActor *new_child;
+    return mx_item_factory_create (priv->factory);
+}
 
-      if (priv->item_type)
-        {
-          new_child = g_object_new (priv->item_type, NULL);
-        }
-      else
-        {
-          new_child = mx_item_factory_create (priv->factory);
-        }
+static void
+mx_list_view_set_item_values (MxListView       *list_view,
+                              GObject          *child,
+                              ClutterModelIter *iter)
+{
+  _mx_item_attributes_set (list_view->priv->attributes, child, iter);
 
-      clutter_actor_add_child (CLUTTER_ACTOR (list_view), new_child);
-      child_n++;
-    }
+  if (list_view->priv->key_column >= 0)
+    _mx_item_set_key (child, iter, list_view->priv->key_column);
+}
 
-  /* remove children as needed */
-  l = g_list_last (children);
-  while (child_n > model_n)
-    {
-      clutter_actor_remove_child (CLUTTER_ACTOR (list_view), l->data);
-      l = g_list_previous (l);
-      child_n--;
-    }
+static gboolean
+mx_list_view_has_model (MxListView *list_view)
+{
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  if (list_view->priv->list_model)
+    return TRUE;
+#endif
 
-  g_list_free (children);
+  return list_view->priv->model != NULL;
+}
 
-  if (!priv->model)
-    return;
+static gint
+mx_list_view_get_n_rows (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (list_view));
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  if (priv->list_model)
+    return g_list_model_get_n_items (priv->list_model);
+#endif
 
-  /* set the properties on the children */
-  iter = clutter_model_get_first_iter (priv->model);
-  l = children;
-  while (iter && !clutter_model_iter_is_last (iter))
-    {
-      GObject *child;
+  return priv->model ? clutter_model_get_n_rows (priv->model) : 0;
+}
 
-      child = G_OBJECT (l->data);
+/* Sets the values of the rows from @row on @child and the children after
+ * it, for @n_children of them, or all of them if @n_children is -1 */
+static void
+mx_list_view_bind_rows (MxListView   *list_view,
+                        ClutterActor *child,
+                        gint          row,
+                        gint          n_children)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterModelIter *iter;
 
-      g_object_freeze_notify (child);
-      for (p = priv->attributes; p; p = p->next)
-        {
-          GValue value = { 0, };
-          AttributeData *attr = p->data;
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  if (priv->list_model)
+    {
+      gint n_rows = g_list_model_get_n_items (priv->list_model);
 
-          clutter_model_iter_get_value (iter, attr->col, &value);
+      for (; child && n_children && row < n_rows;
+           child = clutter_actor_get_next_sibling (child), row++, n_children--)
+        _mx_item_set_list_item (G_OBJECT (child), priv->item_property,
+                                priv->list_model, row);
+      return;
+    }
+#endif
 
-          g_object_set_property (child, attr->name, &value);
+  if (!priv->model)
+    return;
 
-          g_value_unset (&value);
-        }
-      g_object_thaw_notify (child);
+  iter = clutter_model_get_iter_at_row (priv->model, row);
 
-      l = g_list_next (l);
+  for (; child && n_children && iter && !clutter_model_iter_is_last (iter);
+       child = clutter_actor_get_next_sibling (child), n_children--)
+    {
+      mx_list_view_set_item_values (list_view, G_OBJECT (child), iter);
       clutter_model_iter_next (iter);
     }
 
-  g_list_free (children);
-
   if (iter)
     g_object_unref (iter);
 }
 
+/* row index, for variable row heights */
+
 static void
-row_changed_cb (ClutterModel     *model,
-                ClutterModelIter *iter,
-                MxListView       *list_view)
+mx_list_view_index_clear (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  if (priv->row_heights)
+    {
+      g_array_free (priv->row_heights, TRUE);
+      g_array_free (priv->row_tree, TRUE);
+      priv->row_heights = NULL;
+      priv->row_tree = NULL;
+    }
+}
+
+static gboolean
+mx_list_view_has_index (MxListView *list_view)
+{
+  return list_view->priv->variable_row_height &&
+    list_view->priv->row_heights != NULL;
+}
+
+static gint
+mx_list_view_index_get_n_rows (MxListView *list_view)
 {
-  model_changed_cb (model, list_view);
+  return list_view->priv->row_heights->len;
 }
 
+/* the tree is built again from the heights in O(n) */
 static void
-row_removed_cb (ClutterModel     *model,
-                ClutterModelIter *iter,
-                MxListView       *list_view)
+mx_list_view_index_rebuild_tree (MxListView *list_view)
 {
-  GList *children;
-  GList *l;
-  ClutterActor *child;
+  MxListViewPrivate *priv = list_view->priv;
+  gdouble *tree;
+  gint i, j, n_rows;
 
-  if (list_view->priv->is_frozen)
-    return;
+  n_rows = priv->row_heights->len;
+  g_array_set_size (priv->row_tree, n_rows + 1);
+  tree = (gdouble *) priv->row_tree->data;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (list_view));
-  l = g_list_nth (children, clutter_model_iter_get_row (iter));
-  child = (ClutterActor *) l->data;
-  clutter_actor_remove_child (CLUTTER_ACTOR (list_view), child);
-  g_list_free (children);
+  tree[0] = 0;
+  for (i = 1; i <= n_rows; i++)
+    tree[i] = g_array_index (priv->row_heights, gfloat, i - 1) +
+      priv->index_spacing;
+
+  for (i = 1; i <= n_rows; i++)
+    {
+      j = i + (i & -i);
+      if (j <= n_rows)
+        tree[j] += tree[i];
+    }
 }
 
-/* public api */
+/* Returns the offset of the top of @row from the top of the first row,
+ * that is the heights and the spacing of the rows before it */
+static gdouble
+mx_list_view_index_get_offset (MxListView *list_view,
+                               gint        row)
+{
+  gdouble *tree = (gdouble *) list_view->priv->row_tree->data;
+  gdouble offset = 0;
 
-/**
- * mx_list_view_new:
- *
- * Create a new #MxListView
- *
- * Returns: a newly allocated #MxListView
- */
-ClutterActor *
-mx_list_view_new (void)
+  for (row = MIN (row, mx_list_view_index_get_n_rows (list_view));
+       row > 0; row -= row & -row)
+    offset += tree[row];
+
+  return offset;
+}
+
+/* Returns the row at @offset from the top of the first row, the spacing
+ * after a row counting as part of it */
+static gint
+mx_list_view_index_get_row_at_offset (MxListView *list_view,
+                                      gdouble     offset)
 {
-  return g_object_new (MX_TYPE_LIST_VIEW, NULL);
+  gdouble *tree = (gdouble *) list_view->priv->row_tree->data;
+  gint n_rows, mask, row;
+
+  n_rows = mx_list_view_index_get_n_rows (list_view);
+  if (!n_rows)
+    return 0;
+
+  for (mask = 1; mask * 2 <= n_rows; mask *= 2);
+
+  for (row = 0; mask; mask /= 2)
+    {
+      if (row + mask <= n_rows && tree[row + mask] <= offset)
+        {
+          row += mask;
+          offset -= tree[row];
+        }
+    }
+
+  return MIN (row, n_rows - 1);
 }
 
-/**
- * mx_list_view_get_item_type:
- * @list_view: An #MxListView
- *
- * Get the item type currently being used to create items
- *
- * Returns: a #GType
- */
-GType
-mx_list_view_get_item_type (MxListView *list_view)
+static gdouble
+mx_list_view_index_get_height (MxListView *list_view)
 {
-  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), G_TYPE_INVALID);
+  gint n_rows = mx_list_view_index_get_n_rows (list_view);
 
-  return list_view->priv->item_type;
+  if (!n_rows)
+    return 0;
+
+  return mx_list_view_index_get_offset (list_view, n_rows) -
+    list_view->priv->index_spacing;
 }
 
+static void
+mx_list_view_index_set_row_height (MxListView *list_view,
+                                   gint        row,
+                                   gfloat      height)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gdouble *tree = (gdouble *) priv->row_tree->data;
+  gfloat *old_height;
+  gdouble delta;
+  gint i, n_rows;
+
+  old_height = &g_array_index (priv->row_heights, gfloat, row);
+  delta = height - *old_height;
+  *old_height = height;
+
+  n_rows = priv->row_heights->len;
+  for (i = row + 1; i <= n_rows; i += i & -i)
+    tree[i] += delta;
+}
 
-/**
- * mx_list_view_set_item_type:
- * @list_view: An #MxListView
- * @item_type: A #GType
- *
- * Set the item type used to create items representing each row in the
- * model
- */
-void
-mx_list_view_set_item_type (MxListView *list_view,
-                            GType       item_type)
+static gfloat
+mx_list_view_index_estimate (MxListView       *list_view,
+                             ClutterModelIter *iter)
 {
-  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
-  g_return_if_fail (g_type_is_a (item_type, CLUTTER_TYPE_ACTOR));
+  MxListViewPrivate *priv = list_view->priv;
 
-  list_view->priv->item_type = item_type;
+  if (priv->row_height_func && iter)
+    return MAX (0, priv->row_height_func (list_view, iter, priv->index_width,
+                                          priv->row_height_data));
 
-  /* update the view */
-  model_changed_cb (list_view->priv->model, list_view);
+  return priv->row_height;
 }
 
-/**
- * mx_list_view_get_model:
- * @list_view: An #MxListView
- *
- * Get the model currently used by the #MxListView
- *
- * Returns: (transfer none): the current #ClutterModel
- */
-ClutterModel*
-mx_list_view_get_model (MxListView *list_view)
+/* Builds the index again with estimates for all the rows, if it is
+ * missing or was built for another width or spacing */
+static void
+mx_list_view_index_ensure (MxListView *list_view,
+                           gfloat      width)
 {
-  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), NULL);
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterModelIter *iter;
+  gfloat spacing;
+  gint n_rows;
 
-  return list_view->priv->model;
-}
+  if (!priv->variable_row_height || !mx_list_view_has_model (list_view))
+    return;
+
+  n_rows = mx_list_view_get_n_rows (list_view);
+  spacing = mx_box_layout_get_spacing (MX_BOX_LAYOUT (list_view));
+
+  if (priv->row_heights && (gint) priv->row_heights->len == n_rows &&
+      priv->index_width == width && priv->index_spacing == spacing)
+    return;
+
+  if (!priv->row_heights)
+    {
+      priv->row_heights = g_array_new (FALSE, FALSE, sizeof (gfloat));
+      priv->row_tree = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    }
+
+  priv->index_width = width;
+  priv->index_spacing = spacing;
+
+  g_array_set_size (priv->row_heights, 0);
+
+  /* the items of list models are all estimated the same */
+  if (!priv->model)
+    {
+      gfloat height = mx_list_view_index_estimate (list_view, NULL);
+
+      while ((gint) priv->row_heights->len < n_rows)
+        g_array_append_val (priv->row_heights, height);
+    }
+
+  iter = priv->model ? clutter_model_get_first_iter (priv->model) : NULL;
+  while (iter && !clutter_model_iter_is_last (iter))
+    {
+      gfloat height = mx_list_view_index_estimate (list_view, iter);
+
+      g_array_append_val (priv->row_heights, height);
+      clutter_model_iter_next (iter);
+    }
+  if (iter)
+    g_object_unref (iter);
+
+  mx_list_view_index_rebuild_tree (list_view);
+}
+
+/* Adds an estimate for a new row; rows appended at the end, as in a log
+ * or a conversation, are added in O(log n) */
+static void
+mx_list_view_index_insert (MxListView       *list_view,
+                           gint              row,
+                           ClutterModelIter *iter)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gfloat height;
+  gdouble stride;
+  gint n_rows;
+
+  if (!mx_list_view_has_index (list_view))
+    return;
+
+  height = mx_list_view_index_estimate (list_view, iter);
+  n_rows = priv->row_heights->len;
+
+  if (row < n_rows)
+    {
+      g_array_insert_val (priv->row_heights, row, height);
+      mx_list_view_index_rebuild_tree (list_view);
+      return;
+    }
+
+  /* the new node covers the rows from n_rows - lowbit + 1, including
+   * itself, the ones before being read from the tree as it is */
+  n_rows++;
+  g_array_append_val (priv->row_heights, height);
+  stride = height + priv->index_spacing +
+    mx_list_view_index_get_offset (list_view, n_rows - 1) -
+    mx_list_view_index_get_offset (list_view, n_rows - (n_rows & -n_rows));
+  g_array_append_val (priv->row_tree, stride);
+}
+
+static void
+mx_list_view_index_remove (MxListView *list_view,
+                           gint        row)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  if (!mx_list_view_has_index (list_view) || row >= (gint) priv->row_heights->len)
+    return;
+
+  g_array_remove_index (priv->row_heights, row);
+  mx_list_view_index_rebuild_tree (list_view);
+}
+
+/* Replaces the estimates of @removed rows from @position with estimates
+ * for @added new ones, rebuilding the tree once */
+static void
+mx_list_view_index_splice (MxListView *list_view,
+                           guint       position,
+                           guint       removed,
+                           guint       added)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gfloat height, *heights;
+  guint i, n_rows;
+
+  if (!mx_list_view_has_index (list_view) ||
+      position > priv->row_heights->len)
+    return;
+
+  removed = MIN (removed, priv->row_heights->len - position);
+  g_array_remove_range (priv->row_heights, position, removed);
+
+  if (added)
+    {
+      n_rows = priv->row_heights->len;
+      g_array_set_size (priv->row_heights, n_rows + added);
+
+      heights = (gfloat *) priv->row_heights->data;
+      memmove (heights + position + added, heights + position,
+               (n_rows - position) * sizeof (gfloat));
+
+      height = mx_list_view_index_estimate (list_view, NULL);
+      for (i = 0; i < added; i++)
+        heights[position + i] = height;
+    }
+
+  mx_list_view_index_rebuild_tree (list_view);
+}
+
+static gfloat
+mx_list_view_get_row_stride (MxListView *list_view)
+{
+  return list_view->priv->row_height +
+    mx_box_layout_get_spacing (MX_BOX_LAYOUT (list_view));
+}
+
+/* The rows that should have children, those in the view and the
+ * overscan */
+static void
+mx_list_view_get_visible_rows (MxListView *list_view,
+                               gint       *first_row,
+                               gint       *last_row)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gdouble value, page_size;
+  gfloat stride;
+  gint n_rows;
+
+  n_rows = mx_list_view_get_n_rows (list_view);
+
+  /* one row is needed to measure them all */
+  if (!priv->row_height)
+    {
+      *first_row = 0;
+      *last_row = MIN (1, n_rows);
+      return;
+    }
+
+  mx_adjustment_get_values (priv->vadjustment, &value, NULL, NULL, NULL,
+                            NULL, &page_size);
+
+  if (mx_list_view_has_index (list_view))
+    {
+      n_rows = MIN (n_rows, mx_list_view_index_get_n_rows (list_view));
+      if (!n_rows)
+        {
+          *first_row = *last_row = 0;
+          return;
+        }
+
+      *first_row =
+        MAX (0, mx_list_view_index_get_row_at_offset (list_view, value) -
+             MX_LIST_VIEW_OVERSCAN);
+      *last_row =
+        MIN (n_rows, mx_list_view_index_get_row_at_offset (list_view,
+                                                           value + page_size)
+             + 1 + MX_LIST_VIEW_OVERSCAN);
+      return;
+    }
+
+  stride = mx_list_view_get_row_stride (list_view);
+
+  *first_row = CLAMP ((gint) (value / stride) - MX_LIST_VIEW_OVERSCAN,
+                      0, n_rows);
+  *last_row = CLAMP ((gint) ceil ((value + page_size) / stride) +
+                     MX_LIST_VIEW_OVERSCAN, *first_row, n_rows);
+}
+
+/* Gives the children of a virtualized view the rows they should show,
+ * creating or removing children as needed. Unless @rebind is set, nothing
+ * is done if the same rows are visible. */
+static void
+mx_list_view_update_rows (MxListView *list_view,
+                          gboolean    rebind)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gint first_row, last_row, n_children;
+
+  mx_list_view_get_visible_rows (list_view, &first_row, &last_row);
+
+  if (!rebind && first_row == priv->first_row && last_row == priv->last_row)
+    return;
+
+  priv->first_row = first_row;
+  priv->last_row = last_row;
+
+  n_children = clutter_actor_get_n_children (CLUTTER_ACTOR (list_view));
+  while (n_children < last_row - first_row)
+    {
+      clutter_actor_add_child (CLUTTER_ACTOR (list_view),
+                               mx_list_view_create_item (list_view));
+      n_children++;
+    }
+
+  while (n_children > last_row - first_row)
+    {
+      mx_list_view_release_item (list_view,
+                           clutter_actor_get_last_child (
+                             CLUTTER_ACTOR (list_view)));
+      n_children--;
+    }
+
+  /* the children are reused in order for the new rows */
+  if (n_children)
+    mx_list_view_bind_rows (list_view,
+                            clutter_actor_get_first_child (
+                              CLUTTER_ACTOR (list_view)),
+                            first_row, -1);
+
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+}
+
+static gboolean
+mx_list_view_update_idle_cb (gpointer user_data)
+{
+  MxListView *list_view = user_data;
+  gboolean rebind = list_view->priv->rebind_pending;
+
+  list_view->priv->update_idle = 0;
+  list_view->priv->rebind_pending = FALSE;
+
+  if (mx_list_view_is_virtual (list_view))
+    mx_list_view_update_rows (list_view, rebind);
+
+  return FALSE;
+}
+
+/* Updates the rows that are shown from an idle, for when the children
+ * can't be changed at once */
+static void
+mx_list_view_queue_update_rows (MxListView *list_view,
+                                gboolean    rebind)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  priv->rebind_pending |= rebind;
+
+  if (!priv->update_idle)
+    priv->update_idle =
+      clutter_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                     mx_list_view_update_idle_cb,
+                                     list_view, NULL);
+}
+
+static void
+mx_list_view_vadjustment_value_cb (MxAdjustment *adjustment,
+                                   GParamSpec   *pspec,
+                                   MxListView   *list_view)
+{
+  if (!mx_list_view_is_virtual (list_view) || list_view->priv->is_frozen)
+    return;
+
+  /* the value is moved while allocating to keep the rows in place */
+  if (list_view->priv->in_allocation)
+    mx_list_view_queue_update_rows (list_view, FALSE);
+  else
+    mx_list_view_update_rows (list_view, FALSE);
+}
+
+static void
+mx_list_view_scrollable_set_adjustments (MxScrollable *scrollable,
+                                         MxAdjustment *hadjustment,
+                                         MxAdjustment *vadjustment)
+{
+  MxListView *list_view = MX_LIST_VIEW (scrollable);
+  MxListViewPrivate *priv = list_view->priv;
+  gboolean was_virtual = mx_list_view_is_virtual (list_view);
+
+  mx_list_view_scrollable_parent_iface->set_adjustments (scrollable,
+                                                         hadjustment,
+                                                         vadjustment);
+
+  if (vadjustment == priv->vadjustment)
+    return;
+
+  if (priv->vadjustment)
+    {
+      g_signal_handlers_disconnect_by_func (priv->vadjustment,
+                                            mx_list_view_vadjustment_value_cb,
+                                            list_view);
+      g_object_unref (priv->vadjustment);
+    }
+
+  priv->vadjustment = vadjustment ? g_object_ref (vadjustment) : NULL;
+
+  if (vadjustment)
+    g_signal_connect (vadjustment, "notify::value",
+                      G_CALLBACK (mx_list_view_vadjustment_value_cb),
+                      list_view);
+
+  /* the children are created differently when scrolling */
+  if (priv->virtualized && was_virtual != mx_list_view_is_virtual (list_view))
+    model_changed_cb (priv->model, list_view);
+}
+
+static void
+mx_list_view_scrollable_iface_init (MxScrollableIface *iface)
+{
+  mx_list_view_scrollable_parent_iface =
+    g_type_interface_peek_parent (iface);
+
+  iface->set_adjustments = mx_list_view_scrollable_set_adjustments;
+}
+
+static void
+mx_list_view_get_preferred_height (ClutterActor *actor,
+                                   gfloat        for_width,
+                                   gfloat       *min_height_p,
+                                   gfloat       *nat_height_p)
+{
+  MxListView *list_view = MX_LIST_VIEW (actor);
+  MxListViewPrivate *priv = list_view->priv;
+  MxPadding padding;
+  gfloat height;
+  gint n_rows;
+
+  if (!mx_list_view_is_virtual (list_view) || !priv->row_height)
+    {
+      CLUTTER_ACTOR_CLASS (mx_list_view_parent_class)->
+        get_preferred_height (actor, for_width, min_height_p, nat_height_p);
+      return;
+    }
+
+  /* all the rows are counted, not only those that have children */
+  n_rows = mx_list_view_get_n_rows (list_view);
+  if (mx_list_view_has_index (list_view))
+    height = mx_list_view_index_get_height (list_view);
+  else
+    height = n_rows ? n_rows * mx_list_view_get_row_stride (list_view) -
+      mx_box_layout_get_spacing (MX_BOX_LAYOUT (list_view)) : 0;
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+  height += padding.top + padding.bottom;
+
+  if (min_height_p)
+    *min_height_p = height;
+  if (nat_height_p)
+    *nat_height_p = height;
+}
+
+/* The view may show other rows now that it has a size, or that the rows
+ * were measured, but children can't be changed while allocating. */
+static void
+mx_list_view_check_visible_rows (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gint first_row, last_row;
+
+  mx_list_view_get_visible_rows (list_view, &first_row, &last_row);
+  if (first_row != priv->first_row || last_row != priv->last_row)
+    mx_list_view_queue_update_rows (list_view, FALSE);
+}
+
+/* Measures the children of a view with variable row heights, and lays
+ * them out from the offsets in the row index. When rows above the top of
+ * the view turn out to have another height than estimated, the
+ * adjustment is moved by the difference so that the visible rows stay
+ * where they are. */
+static void
+mx_list_view_allocate_variable (MxListView             *list_view,
+                                const MxPadding        *padding,
+                                gfloat                  avail_width,
+                                gfloat                  avail_height,
+                                ClutterAllocationFlags  flags)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActorIter iter;
+  ClutterActor *child;
+  gdouble value, offset, shift, upper, step;
+  gint row, n_rows;
+
+  mx_list_view_index_ensure (list_view, avail_width);
+  if (!priv->row_heights)
+    return;
+
+  n_rows = mx_list_view_index_get_n_rows (list_view);
+  value = mx_adjustment_get_value (priv->vadjustment);
+  shift = 0;
+
+  row = priv->first_row;
+  clutter_actor_iter_init (&iter, CLUTTER_ACTOR (list_view));
+  while (clutter_actor_iter_next (&iter, &child) && row < n_rows)
+    {
+      gfloat height, old_height;
+
+      clutter_actor_get_preferred_height (child, avail_width, NULL, &height);
+      old_height = g_array_index (priv->row_heights, gfloat, row);
+
+      if (height != old_height)
+        {
+          if (mx_list_view_index_get_offset (list_view, row) + old_height <=
+              value + shift)
+            shift += height - old_height;
+          mx_list_view_index_set_row_height (list_view, row, height);
+        }
+      row++;
+    }
+
+  offset = mx_list_view_index_get_offset (list_view, priv->first_row);
+  row = priv->first_row;
+  clutter_actor_iter_init (&iter, CLUTTER_ACTOR (list_view));
+  while (clutter_actor_iter_next (&iter, &child) && row < n_rows)
+    {
+      ClutterActorBox child_box;
+      gfloat height = g_array_index (priv->row_heights, gfloat, row);
+
+      child_box.x1 = padding->left;
+      child_box.x2 = child_box.x1 + avail_width;
+      child_box.y1 = padding->top + offset;
+      child_box.y2 = child_box.y1 + height;
+
+      clutter_actor_allocate (child, &child_box, flags);
+
+      offset += height + priv->index_spacing;
+      row++;
+    }
+
+  upper = mx_list_view_index_get_height (list_view);
+  step = n_rows ? (upper + priv->index_spacing) / n_rows : 0;
+
+  priv->in_allocation = TRUE;
+  g_object_set (G_OBJECT (priv->vadjustment),
+                "lower", 0.0,
+                "upper", upper,
+                "page-size", (gdouble) avail_height,
+                "step-increment", step,
+                "page-increment", (gdouble) avail_height,
+                NULL);
+  if (shift != 0)
+    mx_adjustment_set_value (priv->vadjustment, value + shift);
+  priv->in_allocation = FALSE;
+
+  mx_list_view_check_visible_rows (list_view);
+}
+
+static void
+mx_list_view_allocate (ClutterActor           *actor,
+                       const ClutterActorBox  *box,
+                       ClutterAllocationFlags  flags)
+{
+  MxListView *list_view = MX_LIST_VIEW (actor);
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActorClass *widget_class;
+  gfloat avail_width, avail_height, upper, stride;
+  gint row, n_rows;
+  ClutterActorIter iter;
+  ClutterActor *child;
+  MxPadding padding;
+
+  if (!mx_list_view_is_virtual (list_view))
+    {
+      CLUTTER_ACTOR_CLASS (mx_list_view_parent_class)->allocate (actor, box,
+                                                                 flags);
+      return;
+    }
+
+  /* MxBoxLayout would lay out the children from the top, so skip it, and
+   * the culling it does from that layout */
+  widget_class = g_type_class_peek_parent (mx_list_view_parent_class);
+  widget_class->allocate (actor, box, flags);
+  _mx_box_layout_invalidate_offsets (MX_BOX_LAYOUT (actor));
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+  avail_width = box->x2 - box->x1 - padding.left - padding.right;
+  avail_height = box->y2 - box->y1 - padding.top - padding.bottom;
+
+  child = clutter_actor_get_first_child (actor);
+  if (child && !priv->row_height)
+    {
+      clutter_actor_get_preferred_height (child, avail_width, NULL,
+                                          &priv->row_height);
+      priv->row_height = MAX (1, priv->row_height);
+    }
+
+  n_rows = mx_list_view_get_n_rows (list_view);
+
+  if (priv->variable_row_height && priv->row_height)
+    {
+      mx_list_view_allocate_variable (list_view, &padding, avail_width,
+                                      avail_height, flags);
+      return;
+    }
+
+  stride = MAX (1, mx_list_view_get_row_stride (list_view));
+
+  row = priv->first_row;
+  clutter_actor_iter_init (&iter, actor);
+  while (clutter_actor_iter_next (&iter, &child))
+    {
+      ClutterActorBox child_box;
+
+      child_box.x1 = padding.left;
+      child_box.x2 = child_box.x1 + avail_width;
+      child_box.y1 = padding.top + row * stride;
+      child_box.y2 = child_box.y1 + priv->row_height;
+
+      clutter_actor_allocate (child, &child_box, flags);
+      row++;
+    }
+
+  upper = n_rows ? n_rows * stride - (stride - priv->row_height) : 0;
+
+  g_object_set (G_OBJECT (priv->vadjustment),
+                "lower", 0.0,
+                "upper", (gdouble) upper,
+                "page-size", (gdouble) avail_height,
+                "step-increment", (gdouble) stride,
+                "page-increment",
+                (gdouble) (((gint) (avail_height / stride)) * stride),
+                NULL);
+
+  mx_list_view_check_visible_rows (list_view);
+}
+static void
+mx_list_view_class_init (MxListViewClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
+  GParamSpec *pspec;
+
+  g_type_class_add_private (klass, sizeof (MxListViewPrivate));
+
+  actor_class->get_preferred_height = mx_list_view_get_preferred_height;
+  actor_class->allocate = mx_list_view_allocate;
+
+  object_class->get_property = mx_list_view_get_property;
+  object_class->set_property = mx_list_view_set_property;
+  object_class->dispose = mx_list_view_dispose;
+  object_class->finalize = mx_list_view_finalize;
+
+  pspec = g_param_spec_object ("model",
+                               "model",
+                               "The model for the item view",
+                               CLUTTER_TYPE_MODEL,
+                               MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_MODEL, pspec);
+
+  pspec = g_param_spec_gtype ("item-type",
+                              "Item Type",
+                              "The GType to use as the items in the view. "
+                              "Must be a subclass of ClutterActor",
+                              CLUTTER_TYPE_ACTOR,
+                              MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_ITEM_TYPE, pspec);
+
+  /* Note, interfaces aren't necessarily objects, so you can't use
+   * MX_TYPE_ITEM_FACTORY here. The function mx_list_view_set_factory does
+   * a type check, so this is still safe.
+   */
+  pspec = g_param_spec_object ("factory",
+                               "Factory",
+                               "The MxItemFactory used for creating new items.",
+                               G_TYPE_OBJECT /*MX_TYPE_ITEM_FACTORY*/,
+                               MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_FACTORY, pspec);
+
+  pspec = g_param_spec_boolean ("virtualized",
+                                "Virtualized",
+                                "Whether to only create items for the rows "
+                                "that are visible, when scrolling",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_VIRTUALIZED, pspec);
+
+  pspec = g_param_spec_uint ("recycle-size",
+                             "Recycle size",
+                             "The number of removed items kept to be "
+                             "reused for other rows",
+                             0, G_MAXUINT, 0,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_RECYCLE_SIZE, pspec);
+
+  pspec = g_param_spec_boolean ("progressive",
+                                "Progressive",
+                                "Whether to create and bind the items over "
+                                "several frames, through the actor manager "
+                                "of the stage",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_PROGRESSIVE, pspec);
+
+  pspec = g_param_spec_boolean ("variable-row-height",
+                                "Variable row height",
+                                "Whether the rows of a virtualized view "
+                                "can have different heights",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_VARIABLE_ROW_HEIGHT,
+                                   pspec);
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  pspec = g_param_spec_object ("list-model",
+                               "List model",
+                               "The list model for the view, used instead "
+                               "of the model",
+                               G_TYPE_LIST_MODEL,
+                               MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_LIST_MODEL, pspec);
+#endif
+
+  pspec = g_param_spec_string ("item-property",
+                               "Item property",
+                               "The property of the items that is set to "
+                               "the item of their row in the list model",
+                               "item",
+                               MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_ITEM_PROPERTY, pspec);
+
+  pspec = g_param_spec_int ("key-column",
+                            "Key column",
+                            "The column of the model that identifies the "
+                            "rows when it is sorted or filtered, or -1",
+                            -1, G_MAXINT, -1,
+                            MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_KEY_COLUMN, pspec);
+}
+
+static void
+mx_list_view_init (MxListView *list_view)
+{
+  list_view->priv = LIST_VIEW_PRIVATE (list_view);
+
+  g_queue_init (&list_view->priv->recycled);
+  list_view->priv->item_property = g_strdup ("item");
+  list_view->priv->key_column = -1;
+
+  mx_box_layout_set_orientation (MX_BOX_LAYOUT (list_view), MX_ORIENTATION_VERTICAL);
+}
+
+
+static void
+mx_list_view_stop_progressive (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  /* the operations are all cancelled already if the stage is gone */
+  if (priv->progressive_op && mx_actor_manager_get_stage (priv->manager))
+    mx_actor_manager_cancel_operation (priv->manager, priv->progressive_op);
+  priv->progressive_op = 0;
+
+  if (priv->manager)
+    {
+      g_object_unref (priv->manager);
+      priv->manager = NULL;
+    }
+}
+
+/* Creates or binds the child of one row, and asks for the next one; as the
+ * actor manager only runs operations for its time slice in each frame,
+ * this spreads the population of the view over frames */
+static ClutterActor *
+mx_list_view_progressive_cb (MxActorManager *manager,
+                             gpointer        user_data)
+{
+  MxListView *list_view = user_data;
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActor *child;
+  gint row, model_n;
+
+  priv->progressive_op = 0;
+  row = priv->progressive_row++;
+
+  child = _mx_actor_get_child_at_index (CLUTTER_ACTOR (list_view), row);
+  if (!child)
+    {
+      child = mx_list_view_create_item (list_view);
+      clutter_actor_add_child (CLUTTER_ACTOR (list_view), child);
+    }
+
+  mx_list_view_bind_rows (list_view, child, row, 1);
+
+  model_n = mx_list_view_get_n_rows (list_view);
+  if (priv->progressive_row < model_n)
+    {
+      priv->progressive_op =
+        mx_actor_manager_create_actor (manager, mx_list_view_progressive_cb,
+                                       list_view, NULL);
+      return child;
+    }
+
+  /* rows may have been removed since the population started */
+  while (clutter_actor_get_n_children (CLUTTER_ACTOR (list_view)) > model_n)
+    mx_list_view_release_item (list_view,
+                         clutter_actor_get_last_child (
+                           CLUTTER_ACTOR (list_view)));
+
+  g_object_unref (priv->manager);
+  priv->manager = NULL;
+
+  return child;
+}
+
+/* model monitors */
+static void
+model_changed_cb (ClutterModel *model,
+                  MxListView   *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  gint model_n = 0, child_n = 0;
+
+
+  /* bail out if we don't yet have an item type or a factory */
+  if (!priv->item_type && !priv->factory)
+    return;
+
+  if (priv->is_frozen)
+    return;
+
+  mx_list_view_stop_progressive (list_view);
+
+  if (priv->item_type)
+    {
+      /* check the item-type is an descendant of ClutterActor */
+      if (!g_type_is_a (priv->item_type, CLUTTER_TYPE_ACTOR))
+        {
+          g_warning ("%s is not a subclass of ClutterActor and therefore"
+                     " cannot be used as items in an MxListView",
+                     g_type_name (priv->item_type));
+          return;
+        }
+    }
+
+  if (mx_list_view_is_virtual (list_view))
+    {
+      /* the heights are estimated again for the new rows */
+      mx_list_view_index_clear (list_view);
+
+      if (mx_list_view_has_model (list_view))
+        mx_list_view_update_rows (list_view, TRUE);
+      return;
+    }
+
+  child_n = clutter_actor_get_n_children (CLUTTER_ACTOR (list_view));
+  model_n = mx_list_view_get_n_rows (list_view);
+
+  /* when progressive, the children are created and bound from the first
+   * row by the actor manager, after the extra ones are removed below */
+  if (priv->progressive && model_n &&
+      clutter_actor_get_stage (CLUTTER_ACTOR (list_view)))
+    {
+      priv->manager = mx_actor_manager_get_for_stage (
+        CLUTTER_STAGE (clutter_actor_get_stage (CLUTTER_ACTOR (list_view))));
+      g_object_ref (priv->manager);
+
+      priv->progressive_row = 0;
+      priv->progressive_op =
+        mx_actor_manager_create_actor (priv->manager,
+                                       mx_list_view_progressive_cb,
+                                       list_view, NULL);
+      model_n = child_n;
+    }
+
+  /* add children as needed */
+  while (model_n > child_n)
+    {
+      ClutterActor *new_child = mx_list_view_create_item (list_view);
+
+      clutter_actor_add_child (CLUTTER_ACTOR (list_view), new_child);
+      child_n++;
+    }
+
+  /* remove children as needed */
+  while (child_n > model_n)
+    {
+      mx_list_view_release_item (list_view,
+                           clutter_actor_get_last_child (
+                             CLUTTER_ACTOR (list_view)));
+      child_n--;
+    }
+
+  if (priv->progressive_op)
+    return;
+
+  /* set the properties on the children */
+  mx_list_view_bind_rows (list_view,
+                          clutter_actor_get_first_child (
+                            CLUTTER_ACTOR (list_view)),
+                          0, -1);
+}
+
+/* Only the child of the row is updated, unless the children don't match
+ * the rows, in which case everything is */
+static void
+row_changed_cb (ClutterModel     *model,
+                ClutterModelIter *iter,
+                MxListView       *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActor *child;
+  gint row;
+
+  if (priv->is_frozen || !priv->attributes)
+    return;
+
+  row = clutter_model_iter_get_row (iter);
+
+  /* only rows that have children need updating, the others may only
+   * have another estimated height */
+  if (mx_list_view_is_virtual (list_view))
+    {
+      if (row < priv->first_row || row >= priv->last_row)
+        {
+          if (mx_list_view_has_index (list_view) &&
+              row < mx_list_view_index_get_n_rows (list_view))
+            {
+              mx_list_view_index_set_row_height (list_view, row,
+                mx_list_view_index_estimate (list_view, iter));
+              clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+            }
+          return;
+        }
+      row -= priv->first_row;
+    }
+  else if (priv->progressive_op && !clutter_model_get_filter_set (model))
+    {
+      /* the rows without children are bound when they are created */
+      if (row >= priv->progressive_row)
+        return;
+    }
+  else if (clutter_model_get_filter_set (model) ||
+           clutter_actor_get_n_children (CLUTTER_ACTOR (list_view)) !=
+           clutter_model_get_n_rows (model))
+    {
+      model_changed_cb (model, list_view);
+      return;
+    }
+
+  child = _mx_actor_get_child_at_index (CLUTTER_ACTOR (list_view), row);
+  if (child)
+    mx_list_view_set_item_values (list_view, G_OBJECT (child), iter);
+}
+
+/* A child is inserted for the new row, where it is in the model */
+static void
+row_added_cb (ClutterModel     *model,
+              ClutterModelIter *iter,
+              MxListView       *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActor *child;
+  gint row;
+
+  if (priv->is_frozen || (!priv->item_type && !priv->factory))
+    return;
+
+  row = clutter_model_iter_get_row (iter);
+
+  /* rows after the visible ones only change the height */
+  if (mx_list_view_is_virtual (list_view))
+    {
+      mx_list_view_index_insert (list_view, row, iter);
+
+      if (row >= priv->last_row)
+        clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+      else
+        mx_list_view_update_rows (list_view, TRUE);
+      return;
+    }
+
+  /* the row may be filtered out, and the children must already match the
+   * other rows */
+  if (priv->progressive_op || clutter_model_get_filter_set (model) ||
+      clutter_actor_get_n_children (CLUTTER_ACTOR (list_view)) !=
+      clutter_model_get_n_rows (model) - 1)
+    {
+      model_changed_cb (model, list_view);
+      return;
+    }
+
+  child = mx_list_view_create_item (list_view);
+  clutter_actor_insert_child_at_index (CLUTTER_ACTOR (list_view), child, row);
+  mx_list_view_set_item_values (list_view, G_OBJECT (child), iter);
+}
+
+static void
+row_removed_cb (ClutterModel     *model,
+                ClutterModelIter *iter,
+                MxListView       *list_view)
+{
+  ClutterActor *child;
+
+  if (list_view->priv->is_frozen)
+    return;
+
+  /* the rows that are shown are looked up again once the row is gone, as
+   * it is still in the model */
+  if (mx_list_view_is_virtual (list_view))
+    {
+      mx_list_view_index_remove (list_view,
+                                 clutter_model_iter_get_row (iter));
+      mx_list_view_queue_update_rows (list_view, TRUE);
+      return;
+    }
+
+  /* the population goes on from the same row, and the extra children are
+   * removed at the end */
+  if (list_view->priv->progressive_op)
+    {
+      if (clutter_model_iter_get_row (iter) >= list_view->priv->progressive_row)
+        return;
+      list_view->priv->progressive_row--;
+    }
+
+  child = _mx_actor_get_child_at_index (CLUTTER_ACTOR (list_view),
+                                        clutter_model_iter_get_row (iter));
+  if (child)
+    mx_list_view_release_item (list_view, child);
+}
+
+/* With a key column, the children are moved to the rows with their keys as
+ * the rows are sorted or filtered, and only the rows whose keys have no
+ * child are bound, to the children that are left over or to new ones */
+static void
+model_reordered_cb (ClutterModel *model,
+                    MxListView   *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActor *self = CLUTTER_ACTOR (list_view);
+  ClutterActor *child, *prev;
+  ClutterModelIter *iter;
+  GQueue unmatched = G_QUEUE_INIT;
+  GPtrArray *rows;
+  guint i;
+
+  if (priv->is_frozen || (!priv->item_type && !priv->factory))
+    return;
+
+  /* the children of a virtualized view only show the visible rows, which
+   * are bound again anyway; a population in progress starts over */
+  if (priv->key_column < 0 || mx_list_view_is_virtual (list_view) ||
+      priv->progressive_op)
+    {
+      model_changed_cb (model, list_view);
+      return;
+    }
+
+  rows = _mx_item_match_rows (self, model, priv->key_column, &unmatched);
+
+  iter = clutter_model_get_first_iter (model);
+  prev = NULL;
+
+  for (i = 0; i < rows->len; i++, clutter_model_iter_next (iter))
+    {
+      child = g_ptr_array_index (rows, i);
+
+      if (!child)
+        {
+          child = g_queue_pop_head (&unmatched);
+          if (!child)
+            {
+              child = mx_list_view_create_item (list_view);
+              if (prev)
+                clutter_actor_insert_child_above (self, child, prev);
+              else
+                clutter_actor_insert_child_below (self, child, NULL);
+            }
+
+          mx_list_view_set_item_values (list_view, G_OBJECT (child), iter);
+        }
+
+      if (clutter_actor_get_previous_sibling (child) != prev)
+        {
+          if (prev)
+            clutter_actor_set_child_above_sibling (self, child, prev);
+          else
+            clutter_actor_set_child_below_sibling (self, child, NULL);
+        }
+
+      prev = child;
+    }
+
+  while ((child = g_queue_pop_head (&unmatched)))
+    mx_list_view_release_item (list_view, child);
+
+  if (iter)
+    g_object_unref (iter);
+  g_ptr_array_free (rows, TRUE);
+}
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+/* The children of the changed rows are spliced in one go: as many as can
+ * be are bound to the new rows where they are, and only the difference is
+ * removed or created, so that the cost is in the number of changed rows */
+static void
+items_changed_cb (GListModel *model,
+                  guint       position,
+                  guint       removed,
+                  guint       added,
+                  MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActor *self = CLUTTER_ACTOR (list_view);
+  ClutterActor *child, *prev;
+  guint i;
+
+  if (priv->is_frozen || (!priv->item_type && !priv->factory))
+    return;
+
+  /* rows after the visible ones only change the height */
+  if (mx_list_view_is_virtual (list_view))
+    {
+      mx_list_view_index_splice (list_view, position, removed, added);
+
+      if ((gint) position >= priv->last_row)
+        clutter_actor_queue_relayout (self);
+      else
+        mx_list_view_update_rows (list_view, TRUE);
+      return;
+    }
+
+  /* the children must match the rows as they were before the change */
+  if (priv->progressive_op ||
+      clutter_actor_get_n_children (self) !=
+      (gint) (g_list_model_get_n_items (model) - added + removed))
+    {
+      model_changed_cb (NULL, list_view);
+      return;
+    }
+
+  prev = position ? _mx_actor_get_child_at_index (self, position - 1) : NULL;
+  child = prev ? clutter_actor_get_next_sibling (prev)
+    : clutter_actor_get_first_child (self);
+
+  for (i = 0; i < MIN (removed, added); i++)
+    {
+      _mx_item_set_list_item (G_OBJECT (child), priv->item_property,
+                              model, position + i);
+      prev = child;
+      child = clutter_actor_get_next_sibling (child);
+    }
+
+  for (; i < removed; i++)
+    {
+      ClutterActor *next = clutter_actor_get_next_sibling (child);
+
+      mx_list_view_release_item (list_view, child);
+      child = next;
+    }
+
+  for (; i < added; i++)
+    {
+      child = mx_list_view_create_item (list_view);
+
+      if (prev)
+        clutter_actor_insert_child_above (self, child, prev);
+      else
+        clutter_actor_insert_child_below (self, child, NULL);
+
+      _mx_item_set_list_item (G_OBJECT (child), priv->item_property,
+                              model, position + i);
+      prev = child;
+    }
+}
+#endif
+
+/* public api */
+
+/**
+ * mx_list_view_new:
+ *
+ * Create a new #MxListView
+ *
+ * Returns: a newly allocated #MxListView
+ */
+ClutterActor *
+mx_list_view_new (void)
+{
+  return g_object_new (MX_TYPE_LIST_VIEW, NULL);
+}
+
+/**
+ * mx_list_view_get_item_type:
+ * @list_view: An #MxListView
+ *
+ * Get the item type currently being used to create items
+ *
+ * Returns: a #GType
+ */
+GType
+mx_list_view_get_item_type (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), G_TYPE_INVALID);
+
+  return list_view->priv->item_type;
+}
+
+
+/**
+ * mx_list_view_set_item_type:
+ * @list_view: An #MxListView
+ * @item_type: A #GType
+ *
+ * Set the item type used to create items representing each row in the
+ * model
+ */
+void
+mx_list_view_set_item_type (MxListView *list_view,
+                            GType       item_type)
+{
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+  g_return_if_fail (g_type_is_a (item_type, CLUTTER_TYPE_ACTOR));
+
+  list_view->priv->item_type = item_type;
+  mx_list_view_clear_recycled (list_view, 0);
+  list_view->priv->row_height = 0;
+
+  /* update the view */
+  model_changed_cb (list_view->priv->model, list_view);
+}
+
+/**
+ * mx_list_view_get_model:
+ * @list_view: An #MxListView
+ *
+ * Get the model currently used by the #MxListView
+ *
+ * Returns: (transfer none): the current #ClutterModel
+ */
+ClutterModel*
+mx_list_view_get_model (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), NULL);
+
+  return list_view->priv->model;
+}
+
+/**
+ * mx_list_view_set_model:
+ * @list_view: An #MxListView
+ * @model: A #ClutterModel
+ *
+ * Set the model used by the #MxListView
+ */
+void
+mx_list_view_set_model (MxListView   *list_view,
+                        ClutterModel *model)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+  g_return_if_fail (model == NULL || CLUTTER_IS_MODEL (model));
+
+  priv = list_view->priv;
+
+  if (priv->model)
+    {
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) model_changed_cb,
+                                            list_view);
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) model_reordered_cb,
+                                            list_view);
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) row_added_cb,
+                                            list_view);
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) row_changed_cb,
+                                            list_view);
+      g_signal_handlers_disconnect_by_func (priv->model,
+                                            (GCallback) row_removed_cb,
+                                            list_view);
+      g_object_unref (priv->model);
+
+      priv->model = NULL;
+    }
+
+  if (model)
+    {
+      g_return_if_fail (CLUTTER_IS_MODEL (model));
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+      /* only one of the models drives the view */
+      mx_list_view_set_list_model (list_view, NULL);
+#endif
+
+      priv->model = g_object_ref (model);
+
+      priv->filter_changed = g_signal_connect (priv->model,
+                                               "filter-changed",
+                                               G_CALLBACK (model_reordered_cb),
+                                               list_view);
+
+      priv->row_added = g_signal_connect (priv->model,
+                                          "row-added",
+                                          G_CALLBACK (row_added_cb),
+                                          list_view);
+
+      priv->row_changed = g_signal_connect (priv->model,
+                                            "row-changed",
+                                            G_CALLBACK (row_changed_cb),
+                                            list_view);
+
+      /*
+       * model_changed_cb (called from row_changed_cb) expect the row to already
+       * have been removed, thus we need to use _after
+       */
+      priv->row_removed = g_signal_connect_after (priv->model,
+                                                  "row-removed",
+                                                  G_CALLBACK (row_removed_cb),
+                                                  list_view);
+
+      priv->sort_changed = g_signal_connect (priv->model,
+                                             "sort-changed",
+                                             G_CALLBACK (model_reordered_cb),
+                                             list_view);
+
+      /*
+       * Only do this inside this block, setting the model to NULL should have
+       * the effect of preserving the view; just disconnect the handlers
+       */
+      model_changed_cb (priv->model, list_view);
+    }
+}
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+/**
+ * mx_list_view_get_list_model:
+ * @list_view: An #MxListView
+ *
+ * Get the list model currently used by the #MxListView
+ *
+ * Returns: (transfer none): the current #GListModel, or %NULL
+ *
+ * Since: 2.0
+ */
+GListModel *
+mx_list_view_get_list_model (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), NULL);
+
+  return list_view->priv->list_model;
+}
+
+/**
+ * mx_list_view_set_list_model:
+ * @list_view: An #MxListView
+ * @model: (allow-none): A #GListModel
+ *
+ * Set a list model to drive @list_view, instead of a #ClutterModel. Each
+ * child is given the item of its row through the property named by
+ * #MxListView:item-property; the attributes only apply to a #ClutterModel.
+ *
+ * Insertions, removals and reorders of the model that come as one
+ * #GListModel::items-changed signal are applied to the children as one
+ * change, creating, removing or binding again only the children of the
+ * rows that changed.
+ *
+ * When the rows can have different heights, the rows of a list model that
+ * have not been shown yet are all estimated to be as high as the first
+ * one.
+ *
+ * Since: 2.0
+ */
+void
+mx_list_view_set_list_model (MxListView *list_view,
+                             GListModel *model)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+  g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
+
+  priv = list_view->priv;
+
+  if (priv->list_model == model)
+    return;
+
+  if (priv->list_model)
+    {
+      g_signal_handlers_disconnect_by_func (priv->list_model,
+                                            (GCallback) items_changed_cb,
+                                            list_view);
+      g_object_unref (priv->list_model);
+
+      priv->list_model = NULL;
+    }
+
+  if (model)
+    {
+      mx_list_view_set_model (list_view, NULL);
+
+      priv->list_model = g_object_ref (model);
+      g_signal_connect (priv->list_model, "items-changed",
+                        G_CALLBACK (items_changed_cb), list_view);
+
+      /* as with mx_list_view_set_model(), unsetting the model leaves the
+       * view as it is */
+      mx_list_view_index_clear (list_view);
+      model_changed_cb (NULL, list_view);
+    }
+
+  g_object_notify (G_OBJECT (list_view), "list-model");
+}
+#endif
 
 /**
- * mx_list_view_set_model:
+ * mx_list_view_get_item_property:
  * @list_view: An #MxListView
- * @model: A #ClutterModel
  *
- * Set the model used by the #MxListView
+ * Get the name of the property of the children that is set to the item of
+ * their row, when @list_view is driven by a #GListModel
+ *
+ * Returns: the name of the property, or %NULL
+ *
+ * Since: 2.0
+ */
+const gchar *
+mx_list_view_get_item_property (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), NULL);
+
+  return list_view->priv->item_property;
+}
+
+/**
+ * mx_list_view_set_item_property:
+ * @list_view: An #MxListView
+ * @property: (allow-none): the name of a property of the children
+ *
+ * Set the name of the property of the children that is set to the item of
+ * their row, when @list_view is driven by a #GListModel. This is "item" by
+ * default; with %NULL, the children are not given their items.
+ *
+ * Since: 2.0
  */
 void
-mx_list_view_set_model (MxListView   *list_view,
-                        ClutterModel *model)
+mx_list_view_set_item_property (MxListView  *list_view,
+                                const gchar *property)
 {
   MxListViewPrivate *priv;
 
   g_return_if_fail (MX_IS_LIST_VIEW (list_view));
-  g_return_if_fail (model == NULL || CLUTTER_IS_MODEL (model));
 
   priv = list_view->priv;
 
-  if (priv->model)
-    {
-      g_signal_handlers_disconnect_by_func (priv->model,
-                                            (GCallback) model_changed_cb,
-                                            list_view);
-      g_signal_handlers_disconnect_by_func (priv->model,
-                                            (GCallback) row_changed_cb,
-                                            list_view);
-      g_signal_handlers_disconnect_by_func (priv->model,
-                                            (GCallback) row_removed_cb,
-                                            list_view);
-      g_object_unref (priv->model);
+  if (!g_strcmp0 (priv->item_property, property))
+    return;
 
-      priv->model = NULL;
-    }
+  g_free (priv->item_property);
+  priv->item_property = g_strdup (property);
 
-  if (model)
-    {
-      g_return_if_fail (CLUTTER_IS_MODEL (model));
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  if (priv->list_model)
+    model_changed_cb (NULL, list_view);
+#endif
 
-      priv->model = g_object_ref (model);
+  g_object_notify (G_OBJECT (list_view), "item-property");
+}
 
-      priv->filter_changed = g_signal_connect (priv->model,
-                                               "filter-changed",
-                                               G_CALLBACK (model_changed_cb),
-                                               list_view);
+/**
+ * mx_list_view_set_key_column:
+ * @list_view: An #MxListView
+ * @column: a column of the model, or -1
+ *
+ * Set the column of the model whose values identify its rows. When the
+ * model is then sorted or filtered, the children are moved to the rows
+ * with their keys rather than all bound again, and only the rows that
+ * had no child before are bound.
+ *
+ * The values of the column should be unique; strings and numbers are
+ * compared by value, objects and pointers by address.
+ *
+ * Since: 2.0
+ */
+void
+mx_list_view_set_key_column (MxListView *list_view,
+                            gint        column)
+{
+  MxListViewPrivate *priv;
 
-      priv->row_added = g_signal_connect (priv->model,
-                                          "row-added",
-                                          G_CALLBACK (row_changed_cb),
-                                          list_view);
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+  g_return_if_fail (column >= -1);
 
-      priv->row_changed = g_signal_connect (priv->model,
-                                            "row-changed",
-                                            G_CALLBACK (row_changed_cb),
-                                            list_view);
+  priv = list_view->priv;
 
-      /*
-       * model_changed_cb (called from row_changed_cb) expect the row to already
-       * have been removed, thus we need to use _after
-       */
-      priv->row_removed = g_signal_connect_after (priv->model,
-                                                  "row-removed",
-                                                  G_CALLBACK (row_removed_cb),
-                                                  list_view);
+  if (priv->key_column == column)
+    return;
 
-      priv->sort_changed = g_signal_connect (priv->model,
-                                             "sort-changed",
-                                             G_CALLBACK (model_changed_cb),
-                                             list_view);
+  priv->key_column = column;
 
-      /*
-       * Only do this inside this block, setting the model to NULL should have
-       * the effect of preserving the view; just disconnect the handlers
-       */
-      model_changed_cb (priv->model, list_view);
-    }
+  /* the keys are recorded as the children are bound; the values that are
+   * unchanged aren't set again */
+  if (column >= 0 && priv->model)
+    model_changed_cb (priv->model, list_view);
+
+  g_object_notify (G_OBJECT (list_view), "key-column");
+}
+
+/**
+ * mx_list_view_get_key_column:
+ * @list_view: An #MxListView
+ *
+ * Get the column of the model that identifies its rows, see
+ * mx_list_view_set_key_column().
+ *
+ * Returns: the key column, or -1
+ *
+ * Since: 2.0
+ */
+gint
+mx_list_view_get_key_column (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), -1);
+
+  return list_view->priv->key_column;
 }
 
 /**
@@ -509,7 +2061,7 @@ mx_list_view_add_attribute (MxListView  *list_view,
                             gint         column)
 {
   MxListViewPrivate *priv;
-  AttributeData *prop;
+  MxItemAttribute *prop;
 
   g_return_if_fail (MX_IS_LIST_VIEW (list_view));
   g_return_if_fail (_attribute != NULL);
@@ -517,9 +2069,8 @@ mx_list_view_add_attribute (MxListView  *list_view,
 
   priv = list_view->priv;
 
-  prop = g_new (AttributeData, 1);
-  prop->name = g_strdup (_attribute);
-  prop->col = column;
+  /* the property is looked up now if the type of the items is known */
+  prop = _mx_item_attribute_new (_attribute, column, priv->item_type);
 
   priv->attributes = g_slist_prepend (priv->attributes, prop);
   model_changed_cb (priv->model, list_view);
@@ -596,6 +2147,9 @@ mx_list_view_set_factory (MxListView    *list_view,
   if (factory)
     priv->factory = g_object_ref (factory);
 
+  /* the recycled children were made by the old factory */
+  mx_list_view_clear_recycled (list_view, 0);
+
   g_object_notify (G_OBJECT (list_view), "factory");
 }
 
@@ -613,3 +2167,314 @@ mx_list_view_get_factory (MxListView *list_view)
   g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), NULL);
   return list_view->priv->factory;
 }
+
+/**
+ * mx_list_view_set_virtualized:
+ * @list_view: A #MxListView
+ * @virtualized: %TRUE to only create items for the visible rows
+ *
+ * Sets whether items are only created for the rows that are visible, and a
+ * few more on each side, instead of for every row of the model. This only
+ * has an effect while @list_view is vertical and is scrolled, for example
+ * by an #MxScrollView; items are then reused for other rows as it scrolls.
+ *
+ * All the rows are assumed to be as high as the first one, which is used
+ * to work out the height of the whole list.
+ *
+ * Since: 2.0
+ */
+void
+mx_list_view_set_virtualized (MxListView *list_view,
+                              gboolean    virtualized)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+
+  priv = list_view->priv;
+
+  if (priv->virtualized == virtualized)
+    return;
+
+  priv->virtualized = virtualized;
+  priv->row_height = 0;
+  priv->first_row = priv->last_row = 0;
+  mx_list_view_index_clear (list_view);
+
+  /* the children are created again for the new mode */
+  model_changed_cb (priv->model, list_view);
+
+  g_object_notify (G_OBJECT (list_view), "virtualized");
+}
+
+/**
+ * mx_list_view_get_virtualized:
+ * @list_view: A #MxListView
+ *
+ * Gets whether items are only created for the rows that are visible, see
+ * mx_list_view_set_virtualized().
+ *
+ * Returns: %TRUE if the view is virtualized
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_list_view_get_virtualized (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), FALSE);
+
+  return list_view->priv->virtualized;
+}
+
+/**
+ * mx_list_view_set_recycle_size:
+ * @list_view: A #MxListView
+ * @recycle_size: the number of items to keep
+ *
+ * Sets how many of the items removed from @list_view, when rows are removed
+ * or filtered out, are kept to be reused for other rows rather than
+ * destroyed. Reused items are given the values of their new row, and are
+ * first reset with mx_item_factory_reset() when a factory is used.
+ *
+ * The default is 0, so that no items are kept.
+ *
+ * Since: 2.0
+ */
+void
+mx_list_view_set_recycle_size (MxListView *list_view,
+                               guint       recycle_size)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+
+  priv = list_view->priv;
+
+  if (priv->recycle_size == recycle_size)
+    return;
+
+  priv->recycle_size = recycle_size;
+  mx_list_view_clear_recycled (list_view, recycle_size);
+
+  g_object_notify (G_OBJECT (list_view), "recycle-size");
+}
+
+/**
+ * mx_list_view_get_recycle_size:
+ * @list_view: A #MxListView
+ *
+ * Gets how many removed items are kept to be reused, see
+ * mx_list_view_set_recycle_size().
+ *
+ * Returns: the number of items kept
+ *
+ * Since: 2.0
+ */
+guint
+mx_list_view_get_recycle_size (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), 0);
+
+  return list_view->priv->recycle_size;
+}
+
+/**
+ * mx_list_view_set_progressive:
+ * @list_view: A #MxListView
+ * @progressive: %TRUE to populate @list_view over several frames
+ *
+ * Sets whether the items of @list_view are created and given the values of
+ * their rows by the #MxActorManager of its stage, when the whole model
+ * has to be shown again, rather than all at once. The manager only spends
+ * its time slice on them in each frame, see
+ * mx_actor_manager_set_time_slice(), so that large models don't stop the
+ * user interface while the items are created. Changes to single rows are
+ * still applied straight away.
+ *
+ * Since: 2.0
+ */
+void
+mx_list_view_set_progressive (MxListView *list_view,
+                              gboolean    progressive)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+
+  priv = list_view->priv;
+
+  if (priv->progressive == progressive)
+    return;
+
+  priv->progressive = progressive;
+
+  /* finish what is left at once */
+  if (!progressive && priv->progressive_op)
+    model_changed_cb (priv->model, list_view);
+
+  g_object_notify (G_OBJECT (list_view), "progressive");
+}
+
+/**
+ * mx_list_view_get_progressive:
+ * @list_view: A #MxListView
+ *
+ * Gets whether the items of @list_view are created over several frames, see
+ * mx_list_view_set_progressive().
+ *
+ * Returns: %TRUE if @list_view is progressive
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_list_view_get_progressive (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), FALSE);
+
+  return list_view->priv->progressive;
+}
+
+/**
+ * mx_list_view_set_variable_row_height:
+ * @list_view: A #MxListView
+ * @variable_row_height: %TRUE if the rows can have different heights
+ *
+ * Sets whether the rows of a virtualized @list_view can have different
+ * heights, see mx_list_view_set_virtualized(). The items are then measured
+ * when they are shown, and the rows that are not shown are assumed to be
+ * as high as given by the function set with
+ * mx_list_view_set_row_height_func(), or else as high as the first row.
+ *
+ * The heights are kept in an index, so that the rows at a scroll position
+ * are found in logarithmic time, and the position is kept as the rows
+ * above the visible ones are measured.
+ *
+ * Since: 2.0
+ */
+void
+mx_list_view_set_variable_row_height (MxListView *list_view,
+                                      gboolean    variable_row_height)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+
+  priv = list_view->priv;
+
+  if (priv->variable_row_height == variable_row_height)
+    return;
+
+  priv->variable_row_height = variable_row_height;
+  mx_list_view_index_clear (list_view);
+
+  if (mx_list_view_is_virtual (list_view))
+    mx_list_view_queue_update_rows (list_view, FALSE);
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+
+  g_object_notify (G_OBJECT (list_view), "variable-row-height");
+}
+
+/**
+ * mx_list_view_get_variable_row_height:
+ * @list_view: A #MxListView
+ *
+ * Gets whether the rows of @list_view can have different heights, see
+ * mx_list_view_set_variable_row_height().
+ *
+ * Returns: %TRUE if the rows can have different heights
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_list_view_get_variable_row_height (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), FALSE);
+
+  return list_view->priv->variable_row_height;
+}
+
+/**
+ * mx_list_view_set_row_height_func:
+ * @list_view: A #MxListView
+ * @func: (allow-none): function estimating the height of a row, or %NULL
+ * @user_data: data to pass to @func
+ * @notify: function to free @user_data, or %NULL
+ *
+ * Sets the function used to estimate the heights of the rows that have not
+ * been shown yet, when the rows of @list_view can have different heights.
+ * The estimates are replaced by the heights of the items once they are
+ * shown, so they only need to be close enough to keep the scroll bar
+ * steady.
+ *
+ * Since: 2.0
+ */
+void
+mx_list_view_set_row_height_func (MxListView              *list_view,
+                                  MxListViewRowHeightFunc  func,
+                                  gpointer                 user_data,
+                                  GDestroyNotify           notify)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+
+  priv = list_view->priv;
+
+  if (priv->row_height_notify)
+    priv->row_height_notify (priv->row_height_data);
+
+  priv->row_height_func = func;
+  priv->row_height_data = user_data;
+  priv->row_height_notify = notify;
+
+  if (mx_list_view_has_index (list_view))
+    {
+      mx_list_view_index_clear (list_view);
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (list_view));
+    }
+}
+
+/**
+ * mx_list_view_scroll_to_row:
+ * @list_view: A #MxListView
+ * @row: the row to scroll to
+ *
+ * Scrolls @list_view so that @row is at the top, or as close to it as
+ * possible. This also works when @list_view is virtualized and @row has no
+ * item yet.
+ *
+ * Since: 2.0
+ */
+void
+mx_list_view_scroll_to_row (MxListView *list_view,
+                            gint        row)
+{
+  MxListViewPrivate *priv;
+  ClutterActor *child;
+  gdouble offset;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+  g_return_if_fail (row >= 0);
+
+  priv = list_view->priv;
+
+  if (!priv->vadjustment)
+    return;
+
+  if (mx_list_view_has_index (list_view))
+    offset = mx_list_view_index_get_offset (list_view, row);
+  else if (mx_list_view_is_virtual (list_view))
+    offset = row * mx_list_view_get_row_stride (list_view);
+  else if ((child = _mx_actor_get_child_at_index (CLUTTER_ACTOR (list_view),
+                                                  row)))
+    {
+      MxPadding padding;
+
+      mx_widget_get_padding (MX_WIDGET (list_view), &padding);
+      offset = clutter_actor_get_y (child) - padding.top;
+    }
+  else
+    return;
+
+  mx_adjustment_set_value (priv->vadjustment, offset);
+}
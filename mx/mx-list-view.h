@@ -30,6 +30,7 @@
 #define _MX_LIST_VIEW_H
 
 #include <glib-object.h>
+#include <gio/gio.h>
 #include "mx-box-layout.h"
 #include "mx-item-factory.h"
 
@@ -83,6 +84,25 @@ typedef struct {
   void (*_padding_4) (void);
 } MxListViewClass;
 
+/**
+ * MxListViewRowHeightFunc:
+ * @list_view: An #MxListView
+ * @iter: the row to estimate the height of
+ * @for_width: the width the items are given
+ * @user_data: the data passed to mx_list_view_set_row_height_func()
+ *
+ * Estimates the height of a row whose item has not been measured, when
+ * the rows of a virtualized #MxListView can have different heights.
+ *
+ * Returns: the estimated height of the row
+ *
+ * Since: 2.0
+ */
+typedef gfloat (* MxListViewRowHeightFunc) (MxListView       *list_view,
+                                            ClutterModelIter *iter,
+                                            gfloat            for_width,
+                                            gpointer          user_data);
+
 GType mx_list_view_get_type (void);
 
 ClutterActor *mx_list_view_new (void);
@@ -91,6 +111,19 @@ void          mx_list_view_set_model     (MxListView    *list_view,
                                           ClutterModel  *model);
 ClutterModel* mx_list_view_get_model     (MxListView    *list_view);
 
+#if GLIB_CHECK_VERSION (2, 44, 0)
+void          mx_list_view_set_list_model (MxListView   *list_view,
+                                           GListModel   *model);
+GListModel   *mx_list_view_get_list_model (MxListView   *list_view);
+#endif
+void          mx_list_view_set_item_property (MxListView  *list_view,
+                                              const gchar *property);
+const gchar  *mx_list_view_get_item_property (MxListView  *list_view);
+
+void          mx_list_view_set_key_column (MxListView *list_view,
+                                           gint        column);
+gint          mx_list_view_get_key_column (MxListView *list_view);
+
 void          mx_list_view_set_item_type (MxListView    *list_view,
                                           GType          item_type);
 GType         mx_list_view_get_item_type (MxListView    *list_view);
@@ -105,6 +138,29 @@ void          mx_list_view_set_factory   (MxListView    *list_view,
                                           MxItemFactory *factory);
 MxItemFactory *mx_list_view_get_factory  (MxListView    *list_view);
 
+void          mx_list_view_set_virtualized (MxListView *list_view,
+                                            gboolean    virtualized);
+gboolean      mx_list_view_get_virtualized (MxListView *list_view);
+
+void          mx_list_view_set_recycle_size (MxListView *list_view,
+                                             guint       recycle_size);
+guint         mx_list_view_get_recycle_size (MxListView *list_view);
+
+void          mx_list_view_set_progressive (MxListView *list_view,
+                                        gboolean    progressive);
+gboolean      mx_list_view_get_progressive (MxListView *list_view);
+
+void          mx_list_view_set_variable_row_height (MxListView *list_view,
+                                                    gboolean    variable_row_height);
+gboolean      mx_list_view_get_variable_row_height (MxListView *list_view);
+void          mx_list_view_set_row_height_func     (MxListView              *list_view,
+                                                    MxListViewRowHeightFunc  func,
+                                                    gpointer                 user_data,
+                                                    GDestroyNotify           notify);
+
+void          mx_list_view_scroll_to_row (MxListView *list_view,
+                                          gint        row);
+
 G_END_DECLS
 
 #endif /* _MX_LIST_VIEW_H */
@@ -0,0 +1,189 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-memory.c: Memory accounting and trimming of the Mx caches
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/**
+ * SECTION:mx-memory
+ * @short_description: Memory used by the caches of Mx
+ *
+ * Mx keeps matched styles, textures, icon lookups and the rendering of
+ * scrolled content around so that they don't have to be built again.
+ * mx_get_memory_report() estimates how much memory each of these holds,
+ * and mx_trim_memory() frees them, cheapest to rebuild first.
+ *
+ * When GLib provides a #GMemoryMonitor, Mx trims its caches by itself
+ * whenever the system warns that memory is running low.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gio/gio.h>
+#include <cogl-pango/cogl-pango.h>
+
+#include "mx-memory.h"
+#include "mx-private.h"
+#include "mx-tile-cache.h"
+
+/**
+ * mx_memory_report_copy:
+ * @report: a #MxMemoryReport
+ *
+ * Makes a copy of @report.
+ *
+ * Returns: (transfer full): a newly allocated #MxMemoryReport, to be freed
+ *   with mx_memory_report_free()
+ *
+ * Since: 2.0
+ */
+MxMemoryReport *
+mx_memory_report_copy (const MxMemoryReport *report)
+{
+  g_return_val_if_fail (report != NULL, NULL);
+
+  return g_slice_dup (MxMemoryReport, report);
+}
+
+/**
+ * mx_memory_report_free:
+ * @report: a #MxMemoryReport
+ *
+ * Frees a #MxMemoryReport allocated with mx_memory_report_copy().
+ *
+ * Since: 2.0
+ */
+void
+mx_memory_report_free (MxMemoryReport *report)
+{
+  g_return_if_fail (report != NULL);
+
+  g_slice_free (MxMemoryReport, report);
+}
+
+GType
+mx_memory_report_get_type (void)
+{
+  static GType our_type = 0;
+
+  if (G_UNLIKELY (our_type == 0))
+    our_type =
+      g_boxed_type_register_static (g_intern_static_string ("MxMemoryReport"),
+                                    (GBoxedCopyFunc) mx_memory_report_copy,
+                                    (GBoxedFreeFunc) mx_memory_report_free);
+
+  return our_type;
+}
+
+/**
+ * mx_get_memory_report:
+ * @report: (out caller-allocates): return location for the report
+ *
+ * Estimates the memory held by each of the caches of Mx. Caches that
+ * haven't been used yet are not created by this, and report nothing.
+ *
+ * The estimates are of the memory the caches keep alive: textures that
+ * are also in use elsewhere are counted, since freeing them is up to their
+ * other users. The glyph cache is shared with Clutter, and isn't included.
+ *
+ * Since: 2.0
+ */
+void
+mx_get_memory_report (MxMemoryReport *report)
+{
+  g_return_if_fail (report != NULL);
+
+  report->style_bytes = _mx_style_get_memory_usage ();
+  report->texture_cache_bytes = _mx_texture_cache_get_memory_usage ();
+  report->icon_theme_bytes = _mx_icon_theme_get_memory_usage ();
+  report->image_bytes = _mx_image_get_memory_usage ();
+  report->tile_cache_bytes = _mx_tile_cache_get_memory_usage ();
+
+  report->total_bytes = report->style_bytes + report->texture_cache_bytes +
+    report->icon_theme_bytes + report->image_bytes + report->tile_cache_bytes;
+}
+
+/**
+ * mx_trim_memory:
+ * @level: how much to free
+ *
+ * Frees memory held by the caches of Mx, for instance when the application
+ * goes to the background or the system is running out of memory. What is
+ * freed is rebuilt when it is needed again, at the cost of some time.
+ *
+ * Mx calls this by itself when a #GMemoryMonitor is available and warns
+ * that memory is low.
+ *
+ * Since: 2.0
+ */
+void
+mx_trim_memory (MxMemoryTrimLevel level)
+{
+  /* cheapest to build again first */
+  _mx_style_trim_memory (level);
+  _mx_tile_cache_trim_memory (level);
+
+  if (level < MX_MEMORY_TRIM_LEVEL_MEDIUM)
+    return;
+
+  _mx_icon_theme_trim_memory (level);
+  _mx_texture_cache_trim_memory (level);
+
+  if (level < MX_MEMORY_TRIM_LEVEL_CRITICAL)
+    return;
+
+  if (COGL_PANGO_IS_FONT_MAP (clutter_get_font_map ()))
+    cogl_pango_font_map_clear_glyph_cache (COGL_PANGO_FONT_MAP (
+                                             clutter_get_font_map ()));
+}
+
+#if GLIB_CHECK_VERSION (2, 64, 0)
+static void
+mx_memory_low_memory_warning_cb (GMemoryMonitor             *monitor,
+                                 GMemoryMonitorWarningLevel  level,
+                                 gpointer                    data)
+{
+  if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL)
+    mx_trim_memory (MX_MEMORY_TRIM_LEVEL_CRITICAL);
+  else if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM)
+    mx_trim_memory (MX_MEMORY_TRIM_LEVEL_MEDIUM);
+  else
+    mx_trim_memory (MX_MEMORY_TRIM_LEVEL_LOW);
+}
+#endif
+
+/* Starts trimming the caches on low memory warnings. This is called when
+ * the default caches are created, so that only processes that use them
+ * watch for the warnings. */
+void
+_mx_memory_monitor_init (void)
+{
+#if GLIB_CHECK_VERSION (2, 64, 0)
+  static GMemoryMonitor *monitor = NULL;
+
+  if (monitor)
+    return;
+
+  monitor = g_memory_monitor_dup_default ();
+  g_signal_connect (monitor, "low-memory-warning",
+                    G_CALLBACK (mx_memory_low_memory_warning_cb), NULL);
+#endif
+}
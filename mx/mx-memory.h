@@ -0,0 +1,90 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-memory.h: Memory accounting and trimming of the Mx caches
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#if !defined(MX_H_INSIDE) && !defined(MX_COMPILATION)
+#error "Only <mx/mx.h> can be included directly.h"
+#endif
+
+#ifndef __MX_MEMORY_H__
+#define __MX_MEMORY_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * MxMemoryTrimLevel:
+ * @MX_MEMORY_TRIM_LEVEL_LOW: drop what is cheap to build again: the
+ *   matched styles and the rendering of scrolled content
+ * @MX_MEMORY_TRIM_LEVEL_MEDIUM: also drop the icon lookups and the least
+ *   recently used half of the texture cache
+ * @MX_MEMORY_TRIM_LEVEL_CRITICAL: also drop every cached texture that is
+ *   not in use and the glyph cache
+ *
+ * How much memory mx_trim_memory() should free. Each level frees what the
+ * levels below it do.
+ *
+ * Since: 2.0
+ */
+typedef enum
+{
+  MX_MEMORY_TRIM_LEVEL_LOW,
+  MX_MEMORY_TRIM_LEVEL_MEDIUM,
+  MX_MEMORY_TRIM_LEVEL_CRITICAL
+} MxMemoryTrimLevel;
+
+/**
+ * MxMemoryReport:
+ * @style_bytes: the styles matched by the default #MxStyle
+ * @texture_cache_bytes: the textures held by the default #MxTextureCache
+ * @icon_theme_bytes: the icon lookups of the default #MxIconTheme
+ * @image_bytes: the decoded images waiting to be uploaded by #MxImage
+ * @tile_cache_bytes: the textures scrolled content is rendered into
+ * @total_bytes: the sum of the above
+ *
+ * An estimate of the memory held by the caches of Mx, in bytes, as filled
+ * in by mx_get_memory_report().
+ *
+ * Since: 2.0
+ */
+typedef struct {
+  gsize style_bytes;
+  gsize texture_cache_bytes;
+  gsize icon_theme_bytes;
+  gsize image_bytes;
+  gsize tile_cache_bytes;
+
+  gsize total_bytes;
+} MxMemoryReport;
+
+#define MX_TYPE_MEMORY_REPORT (mx_memory_report_get_type ())
+
+GType           mx_memory_report_get_type (void) G_GNUC_CONST;
+MxMemoryReport *mx_memory_report_copy     (const MxMemoryReport *report);
+void            mx_memory_report_free     (MxMemoryReport       *report);
+
+void            mx_get_memory_report      (MxMemoryReport       *report);
+void            mx_trim_memory            (MxMemoryTrimLevel     level);
+
+G_END_DECLS
+
+#endif /* __MX_MEMORY_H__ */
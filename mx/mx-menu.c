@@ -32,6 +32,11 @@
 #include "mx-stylable.h"
 #include "mx-focusable.h"
 #include "mx-focus-manager.h"
+#include "mx-private.h"
+
+#include <string.h>
+
+#define SEARCH_TIMEOUT 1000 /* ms until type-to-jump starts a new prefix */
 
 static void mx_focusable_iface_init (MxFocusableIface *iface);
 
@@ -45,6 +50,8 @@ G_DEFINE_TYPE_WITH_CODE (MxMenu, mx_menu, MX_TYPE_FLOATING_WIDGET,
 typedef struct
 {
   MxAction *action;
+
+  /* NULL for the actions that are scrolled out of a virtualized menu */
   MxWidget *box;
 } MxMenuChild;
 
@@ -65,6 +72,33 @@ struct _MxMenuPrivate
   ClutterActor *down_button;
   gulong up_source;
   gulong down_source;
+
+  /* a virtualized menu only has buttons for the actions between
+   * bound_first and bound_last, and recycles the others through the
+   * pool. The rows all have the height of the sample button, and the
+   * menu is as wide as it with the widest display name. */
+  gulong virtualized : 1;
+  gulong widths_valid : 1;
+  gint bound_first;
+  gint bound_last;
+  GPtrArray *pool;
+  ClutterActor *sample;
+  gfloat max_text_width;
+
+  GString *search;
+  guint search_timeout;
+
+  /* a prepared menu is styled and laid out in idle time while it is
+   * hidden, so that it only needs mapping and painting to be shown */
+  gulong prepared : 1;
+  guint prepare_id;
+};
+
+enum
+{
+  PROP_0,
+
+  PROP_VIRTUALIZED
 };
 
 enum
@@ -80,6 +114,121 @@ static gboolean mx_menu_captured_event_handler (ClutterActor *actor,
                                                 ClutterEvent *event,
                                                 ClutterActor *menu);
 
+static void mx_menu_button_clicked_cb (ClutterActor *box,
+                                       gpointer      user_data);
+static gboolean mx_menu_button_enter_event_cb (ClutterActor *box,
+                                               ClutterEvent *event,
+                                               gpointer      user_data);
+static void mx_menu_queue_prepare (MxMenu *menu);
+
+static MxWidget *
+mx_menu_create_button (MxMenu   *menu,
+                       MxAction *action)
+{
+  ClutterActor *button, *button_child;
+
+  /* TODO: Connect to notify signals in case action properties change */
+  button = g_object_new (MX_TYPE_BUTTON,
+                         "action", action,
+                         NULL);
+  mx_button_set_action (MX_BUTTON (button), action);
+
+  /* align to the left */
+  button_child = clutter_actor_get_child_at_index (button, 0);
+  clutter_actor_set_x_align (button_child, CLUTTER_ACTOR_ALIGN_START);
+
+
+  g_signal_connect (button, "clicked",
+                    G_CALLBACK (mx_menu_button_clicked_cb), NULL);
+  g_signal_connect (button, "enter-event",
+                    G_CALLBACK (mx_menu_button_enter_event_cb), menu);
+  clutter_actor_add_child (CLUTTER_ACTOR (menu), button);
+
+  return MX_WIDGET (button);
+}
+
+/* Gives the actions from @first to @last a button, taking them from those
+ * of the other actions of a virtualized menu */
+static void
+mx_menu_bind_range (MxMenu *menu,
+                    gint    first,
+                    gint    last)
+{
+  MxMenuPrivate *priv = menu->priv;
+  MxMenuChild *child;
+  gint i;
+
+  last = MIN (last, (gint) priv->children->len - 1);
+
+  for (i = priv->bound_first; i <= priv->bound_last; i++)
+    {
+      if (i >= first && i <= last)
+        continue;
+
+      child = &g_array_index (priv->children, MxMenuChild, i);
+      if (child->box)
+        {
+          g_ptr_array_add (priv->pool, child->box);
+          child->box = NULL;
+        }
+    }
+
+  for (i = first; i <= last; i++)
+    {
+      child = &g_array_index (priv->children, MxMenuChild, i);
+      if (child->box)
+        continue;
+
+      if (priv->pool->len)
+        {
+          child->box = g_ptr_array_remove_index_fast (priv->pool,
+                                                      priv->pool->len - 1);
+
+          if (mx_button_get_action (MX_BUTTON (child->box)) != child->action)
+            mx_button_set_action (MX_BUTTON (child->box), child->action);
+        }
+      else
+        child->box = mx_menu_create_button (menu, child->action);
+    }
+
+  priv->bound_first = first;
+  priv->bound_last = last;
+}
+
+static void
+mx_menu_unbind_all (MxMenu *menu)
+{
+  mx_menu_bind_range (menu, 0, -1);
+}
+
+/* Returns the button of the action at @index, scrolling a virtualized menu
+ * so that it has one */
+static MxWidget *
+mx_menu_get_child_box (MxMenu *menu,
+                       gint    index)
+{
+  MxMenuPrivate *priv = menu->priv;
+  MxMenuChild *child = &g_array_index (priv->children, MxMenuChild, index);
+  gint n_shown;
+
+  if (!priv->virtualized || child->box)
+    return child->box;
+
+  n_shown = MAX (1, priv->last_shown_id - priv->id_offset + 1);
+
+  if (index < priv->id_offset)
+    priv->id_offset = index;
+  else if (index >= priv->id_offset + n_shown)
+    priv->id_offset = index - n_shown + 1;
+
+  priv->last_shown_id = MIN (priv->id_offset + n_shown,
+                             (gint) priv->children->len) - 1;
+  mx_menu_bind_range (menu, priv->id_offset, priv->last_shown_id);
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (menu));
+
+  return child->box;
+}
+
 /* MxFocusable Interface */
 
 static MxFocusable*
@@ -90,6 +239,7 @@ mx_menu_move_focus (MxFocusable      *focusable,
   MxMenuPrivate *priv = MX_MENU (focusable)->priv;
   MxFocusable *result;
   MxMenuChild *child;
+  MxWidget *box;
   gint i, start;
 
   /* find the current focused child */
@@ -115,7 +265,7 @@ mx_menu_move_focus (MxFocusable      *focusable,
           i = priv->children->len - 1;
           gint nb_elts = priv->last_shown_id - priv->id_offset;
           priv->id_offset = i - nb_elts;
-          clutter_actor_queue_redraw (CLUTTER_ACTOR(focusable));
+          clutter_actor_queue_relayout (CLUTTER_ACTOR(focusable));
         }
       else
         {
@@ -123,7 +273,7 @@ mx_menu_move_focus (MxFocusable      *focusable,
           if (i < priv->id_offset)
             {
               priv->id_offset--;
-              clutter_actor_queue_redraw (CLUTTER_ACTOR(focusable));
+              clutter_actor_queue_relayout (CLUTTER_ACTOR(focusable));
             }
         }
 
@@ -132,9 +282,10 @@ mx_menu_move_focus (MxFocusable      *focusable,
           if (i == start)
             break;
 
-          child = &g_array_index (priv->children, MxMenuChild, i);
+          box = mx_menu_get_child_box (MX_MENU (focusable), i);
 
-          result = mx_focusable_accept_focus (MX_FOCUSABLE (child->box), 0);
+          result = box ? mx_focusable_accept_focus (MX_FOCUSABLE (box), 0) :
+            NULL;
 
           if (result)
             return result;
@@ -152,7 +303,7 @@ mx_menu_move_focus (MxFocusable      *focusable,
         {
           priv->id_offset = 0;
           i = 0;
-          clutter_actor_queue_redraw (CLUTTER_ACTOR(focusable));
+          clutter_actor_queue_relayout (CLUTTER_ACTOR(focusable));
         }
       else
         {
@@ -160,7 +311,7 @@ mx_menu_move_focus (MxFocusable      *focusable,
           if (i > priv->last_shown_id)
             {
               priv->id_offset++;
-              clutter_actor_queue_redraw (CLUTTER_ACTOR(focusable));
+              clutter_actor_queue_relayout (CLUTTER_ACTOR(focusable));
             }
         }
 
@@ -169,9 +320,10 @@ mx_menu_move_focus (MxFocusable      *focusable,
           if (i == start)
             break;
 
-          child = &g_array_index (priv->children, MxMenuChild, i);
+          box = mx_menu_get_child_box (MX_MENU (focusable), i);
 
-          result = mx_focusable_accept_focus (MX_FOCUSABLE (child->box), 0);
+          result = box ? mx_focusable_accept_focus (MX_FOCUSABLE (box), 0) :
+            NULL;
 
           if (result)
             return result;
@@ -204,11 +356,14 @@ mx_menu_accept_focus (MxFocusable *focusable,
                       MxFocusHint  hint)
 {
   MxMenuPrivate *priv = MX_MENU (focusable)->priv;
-  MxMenuChild *child;
+  MxWidget *box;
 
-  child = &g_array_index (priv->children, MxMenuChild, 0);
+  if (!priv->children->len)
+    return NULL;
+
+  box = mx_menu_get_child_box (MX_MENU (focusable), 0);
 
-  return mx_focusable_accept_focus (MX_FOCUSABLE (child->box), 0);
+  return box ? mx_focusable_accept_focus (MX_FOCUSABLE (box), 0) : NULL;
 }
 
 static void
@@ -226,6 +381,10 @@ mx_menu_get_property (GObject    *object,
 {
   switch (property_id)
     {
+    case PROP_VIRTUALIZED:
+      g_value_set_boolean (value, mx_menu_get_virtualized (MX_MENU (object)));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -239,6 +398,10 @@ mx_menu_set_property (GObject      *object,
 {
   switch (property_id)
     {
+    case PROP_VIRTUALIZED:
+      mx_menu_set_virtualized (MX_MENU (object), g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -253,7 +416,9 @@ mx_menu_free_action_at (MxMenu   *menu,
   MxMenuChild *child = &g_array_index (priv->children, MxMenuChild,
                                         index);
 
-  clutter_actor_remove_child (CLUTTER_ACTOR (menu), CLUTTER_ACTOR (child->box));
+  if (child->box)
+    clutter_actor_remove_child (CLUTTER_ACTOR (menu),
+                                CLUTTER_ACTOR (child->box));
   g_object_unref (child->action);
 
   if (remove_action)
@@ -275,6 +440,23 @@ mx_menu_dispose (GObject *object)
       priv->children = NULL;
     }
 
+  if (priv->pool)
+    {
+      g_ptr_array_free (priv->pool, TRUE);
+      priv->pool = NULL;
+    }
+
+  if (priv->search_timeout)
+    {
+      g_source_remove (priv->search_timeout);
+      priv->search_timeout = 0;
+    }
+
+  if (priv->prepare_id)
+    {
+      g_source_remove (priv->prepare_id);
+      priv->prepare_id = 0;
+    }
 
   G_OBJECT_CLASS (mx_menu_parent_class)->dispose (object);
 }
@@ -282,9 +464,84 @@ mx_menu_dispose (GObject *object)
 static void
 mx_menu_finalize (GObject *object)
 {
+  MxMenuPrivate *priv = MX_MENU (object)->priv;
+
+  g_string_free (priv->search, TRUE);
+
   G_OBJECT_CLASS (mx_menu_parent_class)->finalize (object);
 }
 
+/* The width of the display name of @action in the font of the sample */
+static gfloat
+mx_menu_get_text_width (PangoLayout *layout,
+                        const gchar *text)
+{
+  gint width;
+
+  pango_layout_set_text (layout, text ? text : "", -1);
+  pango_layout_get_pixel_size (layout, &width, NULL);
+
+  return width;
+}
+
+/* A virtualized menu is as wide as the sample button would be with the
+ * widest display name, measured as text rather than with a button */
+static void
+mx_menu_get_virtual_width (MxMenu *menu,
+                           gfloat  for_height,
+                           gfloat *min_width_p,
+                           gfloat *natural_width_p)
+{
+  MxMenuPrivate *priv = menu->priv;
+  ClutterText *label;
+  PangoLayout *layout;
+  gfloat min_width, nat_width, sample_width;
+  gint i;
+
+  label = CLUTTER_TEXT (_mx_button_get_label (MX_BUTTON (priv->sample)));
+  layout = pango_layout_copy (clutter_text_get_layout (label));
+
+  if (!priv->widths_valid)
+    {
+      priv->max_text_width = 0;
+
+      for (i = 0; i < priv->children->len; i++)
+        {
+          MxMenuChild *child = &g_array_index (priv->children, MxMenuChild,
+                                                i);
+          gfloat width;
+
+          width = mx_menu_get_text_width (layout,
+              mx_action_get_display_name (child->action));
+          priv->max_text_width = MAX (priv->max_text_width, width);
+        }
+
+      priv->widths_valid = TRUE;
+    }
+
+  sample_width = mx_menu_get_text_width (layout,
+                                         clutter_text_get_text (label));
+  g_object_unref (layout);
+
+  clutter_actor_get_preferred_width (priv->sample, for_height,
+                                     &min_width, &nat_width);
+
+  *min_width_p = min_width - sample_width + priv->max_text_width;
+  *natural_width_p = nat_width - sample_width + priv->max_text_width;
+}
+
+static gfloat
+mx_menu_get_row_height (MxMenu *menu,
+                        gfloat  for_width)
+{
+  gfloat height;
+
+  clutter_actor_get_preferred_height (menu->priv->sample, for_width,
+                                      NULL, &height);
+
+  return height;
+}
+
 static void
 mx_menu_get_preferred_width (ClutterActor *actor,
                              gfloat        for_height,
@@ -300,7 +557,17 @@ mx_menu_get_preferred_width (ClutterActor *actor,
   /* Add padding and the size of the widest child */
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
   min_width = nat_width = 0;
-  for (i = 0; i < priv->children->len; i++)
+
+  if (priv->virtualized)
+    {
+      mx_menu_get_virtual_width (MX_MENU (actor), for_height,
+                                 &min_width, &nat_width);
+      i = priv->children->len;
+    }
+  else
+    i = 0;
+
+  for (; i < priv->children->len; i++)
     {
       gfloat child_min_width, child_nat_width;
       MxMenuChild *child;
@@ -339,7 +606,19 @@ mx_menu_get_preferred_height (ClutterActor *actor,
   /* Add padding and the cumulative height of the children */
   mx_widget_get_padding (MX_WIDGET (actor), &padding);
   min_height = nat_height = padding.top + padding.bottom;
-  for (i = 0; i < priv->children->len; i++)
+
+  if (priv->virtualized)
+    {
+      gfloat row_height = mx_menu_get_row_height (MX_MENU (actor), for_width);
+
+      min_height += priv->children->len * (row_height + 1);
+      nat_height += priv->children->len * (row_height + 1);
+      i = priv->children->len;
+    }
+  else
+    i = 0;
+
+  for (; i < priv->children->len; i++)
     {
       gfloat child_min_height, child_nat_height;
 
@@ -418,32 +697,63 @@ mx_menu_allocate (ClutterActor           *actor,
     }
 
 
-  for (i = priv->id_offset; i < priv->children->len; i++)
+  if (priv->virtualized)
     {
-      gfloat natural_height;
+      gfloat row_height, y;
 
-      MxMenuChild *child = &g_array_index (priv->children, MxMenuChild,
-                                            i);
+      /* find how many rows fit before giving them buttons */
+      row_height = mx_menu_get_row_height (MX_MENU (actor),
+                                           child_box.x2 - child_box.x1);
 
-      clutter_actor_get_preferred_height (CLUTTER_ACTOR (child->box),
-                                          child_box.x2 - child_box.x1,
-                                          NULL,
-                                          &natural_height);
-      child_box.y2 = child_box.y1 + natural_height;
-      if (child_box.y2 >= available_h)
+      for (i = priv->id_offset, y = child_box.y1;
+           i < priv->children->len && y + row_height < available_h;
+           i++, y += row_height + 1);
+
+      priv->last_shown_id = i - 1;
+      mx_menu_bind_range (MX_MENU (actor), priv->id_offset,
+                          priv->last_shown_id);
+
+      for (i = priv->id_offset; i <= priv->last_shown_id; i++)
         {
-          priv->last_shown_id = i-1;
-          break;
+          MxMenuChild *child = &g_array_index (priv->children, MxMenuChild,
+                                                i);
+
+          child_box.y2 = child_box.y1 + row_height;
+          clutter_actor_allocate (CLUTTER_ACTOR (child->box), &child_box,
+                                  flags);
+          child_box.y1 = child_box.y2 + 1;
         }
+    }
+  else
+    {
+      for (i = priv->id_offset; i < priv->children->len; i++)
+        {
+          gfloat natural_height;
 
-      clutter_actor_allocate (CLUTTER_ACTOR (child->box), &child_box, flags);
+          MxMenuChild *child = &g_array_index (priv->children, MxMenuChild,
+                                                i);
 
-      child_box.y1 = child_box.y2 + 1;
+          clutter_actor_get_preferred_height (CLUTTER_ACTOR (child->box),
+                                              child_box.x2 - child_box.x1,
+                                              NULL,
+                                              &natural_height);
+          child_box.y2 = child_box.y1 + natural_height;
+          if (child_box.y2 >= available_h)
+            {
+              priv->last_shown_id = i-1;
+              break;
+            }
+
+          clutter_actor_allocate (CLUTTER_ACTOR (child->box), &child_box,
+                                  flags);
+
+          child_box.y1 = child_box.y2 + 1;
+        }
+      if (priv->children->len == i)
+        {
+          priv->last_shown_id = i-1;
+        }
     }
-    if (priv->children->len == i)
-      {
-        priv->last_shown_id = i-1;
-      }
 
     if (priv->scrolling_mode)
       {
@@ -468,7 +778,8 @@ mx_menu_floating_paint (ClutterActor *menu)
     {
       MxMenuChild *child = &g_array_index (priv->children, MxMenuChild,
                                             i);
-      clutter_actor_paint (CLUTTER_ACTOR (child->box));
+      if (child->box)
+        clutter_actor_paint (CLUTTER_ACTOR (child->box));
     }
 
   if(priv->scrolling_mode)
@@ -494,7 +805,8 @@ mx_menu_floating_pick (ClutterActor       *menu,
     {
       MxMenuChild *child = &g_array_index (priv->children, MxMenuChild, i);
 
-      if (clutter_actor_should_pick_paint (CLUTTER_ACTOR (child->box)))
+      if (child->box &&
+          clutter_actor_should_pick_paint (CLUTTER_ACTOR (child->box)))
         {
           clutter_actor_paint (CLUTTER_ACTOR (child->box));
         }
@@ -527,7 +839,8 @@ mx_menu_map (ClutterActor *actor)
     {
       MxMenuChild *child = &g_array_index (priv->children, MxMenuChild,
                                             i);
-      clutter_actor_map (CLUTTER_ACTOR (child->box));
+      if (child->box)
+        clutter_actor_map (CLUTTER_ACTOR (child->box));
     }
 
   /* set up a capture so we can close the menu if the user clicks outside it */
@@ -556,7 +869,8 @@ mx_menu_unmap (ClutterActor *actor)
     {
       MxMenuChild *child = &g_array_index (priv->children, MxMenuChild,
                                             i);
-      clutter_actor_unmap (CLUTTER_ACTOR (child->box));
+      if (child->box)
+        clutter_actor_unmap (CLUTTER_ACTOR (child->box));
     }
 
   if (priv->stage)
@@ -600,6 +914,93 @@ mx_menu_close (ClutterActor *menu)
   clutter_actor_set_reactive ((ClutterActor*) menu, FALSE);
 }
 
+static gboolean
+mx_menu_search_timeout (gpointer data)
+{
+  MxMenuPrivate *priv = MX_MENU (data)->priv;
+
+  g_string_truncate (priv->search, 0);
+  priv->search_timeout = 0;
+
+  return FALSE;
+}
+
+/* Focuses the first action whose display name starts with the characters
+ * typed so far, scrolling it into view */
+static gboolean
+mx_menu_search_key (MxMenu          *menu,
+                    ClutterKeyEvent *event)
+{
+  MxMenuPrivate *priv = menu->priv;
+  ClutterActor *stage;
+  MxWidget *box;
+  gchar *prefix;
+  gunichar c;
+  gint i, n_shown;
+
+  c = clutter_event_get_key_unicode ((ClutterEvent *) event);
+  if (!g_unichar_isgraph (c) && !(c == ' ' && priv->search->len))
+    return FALSE;
+
+  if (event->modifier_state & (CLUTTER_CONTROL_MASK | CLUTTER_MOD1_MASK))
+    return FALSE;
+
+  g_string_append_unichar (priv->search, c);
+
+  if (priv->search_timeout)
+    g_source_remove (priv->search_timeout);
+  priv->search_timeout = g_timeout_add (SEARCH_TIMEOUT,
+                                        mx_menu_search_timeout, menu);
+
+  prefix = g_utf8_casefold (priv->search->str, -1);
+
+  for (i = 0; i < priv->children->len; i++)
+    {
+      MxMenuChild *child = &g_array_index (priv->children, MxMenuChild, i);
+      const gchar *name = mx_action_get_display_name (child->action);
+      gchar *folded;
+      gboolean match;
+
+      if (!name)
+        continue;
+
+      folded = g_utf8_casefold (name, -1);
+      match = g_str_has_prefix (folded, prefix);
+      g_free (folded);
+
+      if (match)
+        break;
+    }
+
+  g_free (prefix);
+
+  if (i == priv->children->len)
+    return TRUE;
+
+  /* scroll the match to the top of the menu, as far as it goes */
+  n_shown = MAX (1, priv->last_shown_id - priv->id_offset + 1);
+  priv->id_offset = MAX (0, MIN (i, (gint) priv->children->len - n_shown));
+  priv->last_shown_id = MIN (priv->id_offset + n_shown,
+                             (gint) priv->children->len) - 1;
+  if (priv->virtualized)
+    mx_menu_bind_range (menu, priv->id_offset, priv->last_shown_id);
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (menu));
+
+  box = mx_menu_get_child_box (menu, i);
+  stage = clutter_actor_get_stage (CLUTTER_ACTOR (menu));
+  if (box && stage)
+    {
+      /* ensure the menu is not closed when focus is pushed to the item */
+      priv->internal_focus_push = TRUE;
+
+      mx_focus_manager_push_focus (
+        mx_focus_manager_get_for_stage (CLUTTER_STAGE (stage)),
+        MX_FOCUSABLE (box));
+    }
+
+  return TRUE;
+}
+
 static gboolean
 mx_menu_event (ClutterActor *actor,
                ClutterEvent *event)
@@ -616,6 +1017,9 @@ mx_menu_event (ClutterActor *actor,
       return TRUE;
 
     case CLUTTER_KEY_PRESS:
+      if (mx_menu_search_key (MX_MENU (actor), (ClutterKeyEvent *) event))
+        return TRUE;
+
     case CLUTTER_KEY_RELEASE:
       /* hide the menu if the escape key was pressed */
       if (((ClutterKeyEvent*) event)->keyval == CLUTTER_KEY_Escape
@@ -634,26 +1038,13 @@ mx_menu_captured_event_handler (ClutterActor *actor,
                                 ClutterEvent *event,
                                 ClutterActor *menu)
 {
-  int i;
   ClutterActor *source;
-  MxMenuPrivate *priv = MX_MENU (menu)->priv;
 
   /* allow the event to continue if it is applied to the menu or any of its
-   * children
+   * children: the buttons of the actions and the scroll buttons
    */
   source = clutter_event_get_source (event);
-  if (source == menu)
-    return FALSE;
-  for (i = 0; i < priv->children->len; i++)
-    {
-      MxMenuChild *child;
-
-      child = &g_array_index (priv->children, MxMenuChild, i);
-
-      if (source == (ClutterActor*) child->box)
-        return FALSE;
-    }
-  if (source == priv->up_button || source == priv->down_button)
+  if (source == menu || clutter_actor_get_parent (source) == menu)
     return FALSE;
 
   /* hide the menu if the user clicks outside the menu */
@@ -715,6 +1106,15 @@ mx_menu_class_init (MxMenuClass *klass)
   float_class->floating_paint = mx_menu_floating_paint;
   float_class->floating_pick = mx_menu_floating_pick;
 
+  g_object_class_install_property (object_class, PROP_VIRTUALIZED,
+      g_param_spec_boolean ("virtualized",
+                            "Virtualized",
+                            "Whether to only create buttons for the actions "
+                            "that are shown, and recycle them as the menu "
+                            "scrolls",
+                            FALSE,
+                            MX_PARAM_READWRITE));
+
   signals[ACTION_ACTIVATED] =
     g_signal_new ("action-activated",
                   G_TYPE_FROM_CLASS (klass),
@@ -798,6 +1198,9 @@ mx_menu_init (MxMenu *self)
   MxMenuPrivate *priv = self->priv = MENU_PRIVATE (self);
 
   priv->children = g_array_new (FALSE, FALSE, sizeof (MxMenuChild));
+  priv->pool = g_ptr_array_new ();
+  priv->bound_last = -1;
+  priv->search = g_string_new (NULL);
 
   g_object_set (G_OBJECT (self),
                 "show-on-set-parent", FALSE,
@@ -837,10 +1240,13 @@ mx_menu_new (void)
 
 static void
 mx_menu_button_clicked_cb (ClutterActor *box,
-                           MxAction     *action)
+                           gpointer      user_data)
 {
+  MxAction *action;
   MxMenu *menu;
 
+  /* the buttons of a virtualized menu change action as it scrolls */
+  action = mx_button_get_action (MX_BUTTON (box));
   menu = MX_MENU (clutter_actor_get_parent (box));
 
   g_object_ref (menu);
@@ -888,9 +1294,26 @@ mx_menu_button_enter_event_cb (ClutterActor *box,
 void
 mx_menu_add_action (MxMenu   *menu,
                     MxAction *action)
+{
+  mx_menu_insert_action (menu, action, -1);
+}
+
+/**
+ * mx_menu_insert_action:
+ * @menu: A #MxMenu
+ * @action: A #MxAction
+ * @position: the position to insert @action at, or -1 to append it
+ *
+ * Insert @action into @menu at @position.
+ *
+ * Since: 2.0
+ */
+void
+mx_menu_insert_action (MxMenu   *menu,
+                       MxAction *action,
+                       gint      position)
 {
   MxMenuChild child;
-  ClutterActor *button_child;
 
   g_return_if_fail (MX_IS_MENU (menu));
   g_return_if_fail (MX_IS_ACTION (action));
@@ -898,26 +1321,24 @@ mx_menu_add_action (MxMenu   *menu,
   MxMenuPrivate *priv = menu->priv;
 
   child.action = g_object_ref_sink (action);
-  /* TODO: Connect to notify signals in case action properties change */
-  child.box = g_object_new (MX_TYPE_BUTTON,
-                            "action", child.action,
-                            NULL);
-  mx_button_set_action (MX_BUTTON (child.box), child.action);
-
-  /* align to the left */
-  button_child = clutter_actor_get_child_at_index ((ClutterActor*) child.box, 0);
-  clutter_actor_set_x_align (button_child, CLUTTER_ACTOR_ALIGN_START);
-
 
-  g_signal_connect (child.box, "clicked",
-                    G_CALLBACK (mx_menu_button_clicked_cb), action);
-  g_signal_connect (child.box, "enter-event",
-                    G_CALLBACK (mx_menu_button_enter_event_cb), menu);
-  clutter_actor_add_child (CLUTTER_ACTOR (menu), CLUTTER_ACTOR (child.box));
+  /* the action gets a button when it is scrolled into view */
+  if (priv->virtualized)
+    {
+      mx_menu_unbind_all (menu);
+      priv->widths_valid = FALSE;
+      child.box = NULL;
+    }
+  else
+    child.box = mx_menu_create_button (menu, child.action);
 
-  g_array_append_val (priv->children, child);
+  if (position < 0 || position > priv->children->len)
+    g_array_append_val (priv->children, child);
+  else
+    g_array_insert_val (priv->children, position, child);
 
   clutter_actor_queue_relayout (CLUTTER_ACTOR (menu));
+  mx_menu_queue_prepare (menu);
 }
 
 /**
@@ -946,7 +1367,15 @@ mx_menu_remove_action (MxMenu   *menu,
 
       if (child->action == action)
         {
+          if (priv->virtualized)
+            {
+              mx_menu_unbind_all (menu);
+              priv->widths_valid = FALSE;
+            }
+
           mx_menu_free_action_at (menu, i, TRUE);
+          clutter_actor_queue_relayout (CLUTTER_ACTOR (menu));
+          mx_menu_queue_prepare (menu);
           break;
         }
     }
@@ -971,10 +1400,18 @@ mx_menu_remove_all (MxMenu *menu)
   if (!priv->children->len)
     return;
 
+  mx_menu_unbind_all (menu);
+
   for (i = 0; i < priv->children->len; i++)
     mx_menu_free_action_at (menu, i, FALSE);
 
   g_array_remove_range (priv->children, 0, priv->children->len);
+
+  priv->id_offset = 0;
+  priv->last_shown_id = 0;
+  priv->widths_valid = FALSE;
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (menu));
+  mx_menu_queue_prepare (menu);
 }
 
 /**
@@ -997,3 +1434,181 @@ mx_menu_show_with_position (MxMenu *menu,
   clutter_actor_show (CLUTTER_ACTOR (menu));
 }
 
+static gboolean
+mx_menu_prepare_cb (gpointer data)
+{
+  ClutterActor *actor = data;
+  MxMenuPrivate *priv = MX_MENU (actor)->priv;
+  ClutterActorBox box;
+  gfloat width, height;
+
+  priv->prepare_id = 0;
+
+  /* a mapped menu is styled and laid out as it is shown */
+  if (CLUTTER_ACTOR_IS_MAPPED (actor))
+    return FALSE;
+
+  /* style the menu and its buttons now rather than when it is realized,
+   * which then finds their style already applied */
+  mx_stylable_style_changed (MX_STYLABLE (actor), MX_STYLE_CHANGED_FORCE);
+
+  clutter_actor_get_preferred_size (actor, NULL, NULL, &width, &height);
+
+  /* it can only be allocated inside a stage; the box it was last given
+   * is kept, as that is likely to be the one it is given again */
+  if (clutter_actor_get_stage (actor))
+    {
+      clutter_actor_get_allocation_box (actor, &box);
+      if (box.x2 <= box.x1 || box.y2 <= box.y1)
+        {
+          clutter_actor_get_position (actor, &box.x1, &box.y1);
+          box.x2 = box.x1 + width;
+          box.y2 = box.y1 + height;
+        }
+
+      clutter_actor_allocate (actor, &box, CLUTTER_ALLOCATION_NONE);
+    }
+
+  return FALSE;
+}
+
+static void
+mx_menu_queue_prepare (MxMenu *menu)
+{
+  MxMenuPrivate *priv = menu->priv;
+
+  if (!priv->prepared || priv->prepare_id)
+    return;
+
+  priv->prepare_id = g_idle_add_full (G_PRIORITY_LOW, mx_menu_prepare_cb,
+                                      menu, NULL);
+}
+
+/**
+ * mx_menu_prepare:
+ * @menu: A #MxMenu
+ *
+ * Styles and lays out @menu in idle time, ahead of it being shown, and
+ * does so again whenever its actions change while it is hidden. Showing a
+ * prepared menu then only maps and paints it, which is worth it for menus
+ * that are opened often, such as context menus.
+ *
+ * @menu should have been added to the widget it belongs to, see
+ * mx_widget_set_menu(), as it can only be laid out inside a stage.
+ *
+ * Since: 2.0
+ */
+void
+mx_menu_prepare (MxMenu *menu)
+{
+  g_return_if_fail (MX_IS_MENU (menu));
+
+  menu->priv->prepared = TRUE;
+  mx_menu_queue_prepare (menu);
+}
+
+/**
+ * mx_menu_set_virtualized:
+ * @menu: A #MxMenu
+ * @virtualized: %TRUE to only create buttons for the actions shown
+ *
+ * Sets the #MxMenu:virtualized property. A virtualized menu creates
+ * buttons only for the actions that fit in it and gives them the actions
+ * scrolled into view, so that menus of many actions stay cheap. Its rows
+ * all have the height of a button without an icon, and it is as wide as
+ * such a button with the widest display name.
+ *
+ * Since: 2.0
+ */
+void
+mx_menu_set_virtualized (MxMenu   *menu,
+                         gboolean  virtualized)
+{
+  MxMenuPrivate *priv;
+  gint i;
+
+  g_return_if_fail (MX_IS_MENU (menu));
+
+  priv = menu->priv;
+
+  if (priv->virtualized == virtualized)
+    return;
+
+  if (virtualized)
+    {
+      /* the sample is only measured, never shown */
+      priv->sample = mx_button_new_with_label ("Xg");
+      clutter_actor_hide (priv->sample);
+      clutter_actor_add_child (CLUTTER_ACTOR (menu), priv->sample);
+
+      /* keep the buttons of the actions shown, recycle the others */
+      for (i = 0; i < priv->children->len; i++)
+        {
+          MxMenuChild *child = &g_array_index (priv->children, MxMenuChild,
+                                                i);
+
+          if (i >= priv->id_offset && i <= priv->last_shown_id)
+            continue;
+
+          clutter_actor_remove_child (CLUTTER_ACTOR (menu),
+                                      CLUTTER_ACTOR (child->box));
+          child->box = NULL;
+        }
+
+      priv->bound_first = priv->id_offset;
+      priv->bound_last = MIN (priv->last_shown_id,
+                              (gint) priv->children->len - 1);
+      priv->widths_valid = FALSE;
+      priv->virtualized = TRUE;
+    }
+  else
+    {
+      mx_menu_unbind_all (menu);
+      priv->virtualized = FALSE;
+
+      for (i = 0; i < priv->children->len; i++)
+        {
+          MxMenuChild *child = &g_array_index (priv->children, MxMenuChild,
+                                                i);
+
+          if (priv->pool->len)
+            {
+              child->box = g_ptr_array_remove_index_fast (priv->pool,
+                                                          priv->pool->len - 1);
+              mx_button_set_action (MX_BUTTON (child->box), child->action);
+            }
+          else
+            child->box = mx_menu_create_button (menu, child->action);
+        }
+
+      while (priv->pool->len)
+        clutter_actor_destroy (g_ptr_array_remove_index_fast (priv->pool,
+                                                              0));
+
+      clutter_actor_destroy (priv->sample);
+      priv->sample = NULL;
+    }
+
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (menu));
+  mx_menu_queue_prepare (menu);
+
+  g_object_notify (G_OBJECT (menu), "virtualized");
+}
+
+/**
+ * mx_menu_get_virtualized:
+ * @menu: A #MxMenu
+ *
+ * Gets the value of the #MxMenu:virtualized property.
+ *
+ * Returns: %TRUE if @menu only creates buttons for the actions shown
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_menu_get_virtualized (MxMenu *menu)
+{
+  g_return_val_if_fail (MX_IS_MENU (menu), FALSE);
+
+  return menu->priv->virtualized;
+}
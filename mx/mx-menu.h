@@ -92,12 +92,20 @@ ClutterActor *mx_menu_new           (void);
 
 void          mx_menu_add_action         (MxMenu   *menu,
                                           MxAction *action);
+void          mx_menu_insert_action      (MxMenu   *menu,
+                                          MxAction *action,
+                                          gint      position);
 void          mx_menu_remove_action      (MxMenu   *menu,
                                           MxAction *action);
 void          mx_menu_remove_all         (MxMenu *menu);
 void          mx_menu_show_with_position (MxMenu *menu,
                                           gfloat  x,
                                           gfloat  y);
+void          mx_menu_prepare            (MxMenu *menu);
+
+void          mx_menu_set_virtualized    (MxMenu   *menu,
+                                          gboolean  virtualized);
+gboolean      mx_menu_get_virtualized    (MxMenu   *menu);
 
 G_END_DECLS
 
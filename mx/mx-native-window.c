@@ -117,3 +117,34 @@ _mx_native_window_present (MxNativeWindow *window)
   if (iface->present)
     iface->present (window);
 }
+
+/* Returns the time between the frames the compositor presented, in
+ * microseconds, or 0 when that isn't known */
+gint64
+_mx_native_window_get_frame_interval (MxNativeWindow *window)
+{
+  MxNativeWindowIface *iface;
+
+  g_return_val_if_fail (MX_IS_NATIVE_WINDOW (window), 0);
+
+  iface = MX_NATIVE_WINDOW_GET_IFACE (window);
+  if (iface->get_frame_interval)
+    return iface->get_frame_interval (window);
+
+  return 0;
+}
+
+/* Tells the compositor that @region of the window, in window coordinates,
+ * is opaque, or that no part of it is known to be when @region is %NULL */
+void
+_mx_native_window_set_opaque_region (MxNativeWindow        *window,
+                                     const ClutterActorBox *region)
+{
+  MxNativeWindowIface *iface;
+
+  g_return_if_fail (MX_IS_NATIVE_WINDOW (window));
+
+  iface = MX_NATIVE_WINDOW_GET_IFACE (window);
+  if (iface->set_opaque_region)
+    iface->set_opaque_region (window, region);
+}
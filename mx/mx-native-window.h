@@ -54,6 +54,11 @@ struct _MxNativeWindowIface
   void (* get_position) (MxNativeWindow *window, gint *x, gint *y);
   void (* set_position) (MxNativeWindow *window, gint  x, gint  y);
   void (* present)      (MxNativeWindow *window);
+
+  gint64 (* get_frame_interval) (MxNativeWindow *window);
+
+  void (* set_opaque_region) (MxNativeWindow        *window,
+                              const ClutterActorBox *region);
 };
 
 GType _mx_native_window_get_type (void) G_GNUC_CONST;
@@ -62,6 +67,11 @@ void _mx_native_window_get_position (MxNativeWindow *window, gint *x, gint *y);
 void _mx_native_window_set_position (MxNativeWindow *window, gint  x, gint  y);
 void _mx_native_window_present      (MxNativeWindow *window);
 
+gint64 _mx_native_window_get_frame_interval (MxNativeWindow *window);
+
+void _mx_native_window_set_opaque_region (MxNativeWindow        *window,
+                                          const ClutterActorBox *region);
+
 G_END_DECLS
 
 #endif /* _MX_NATIVE_WINDOW_H */
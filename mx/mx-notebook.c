@@ -59,13 +59,21 @@ mx_notebook_show_complete_cb (ClutterActor *actor,
   MxNotebookPrivate *priv = book->priv;
   GList *l;
 
+  g_signal_handlers_disconnect_by_func (actor,
+                                        mx_notebook_show_complete_cb,
+                                        book);
+
   for (l = priv->children; l; l = l->next)
     {
       ClutterActor *child = CLUTTER_ACTOR (l->data);
       if (child != priv->current_page)
         {
+          _mx_actor_set_paint_from_snapshot (child, FALSE);
           clutter_actor_hide (child);
           clutter_actor_set_opacity (child, 0x00);
+
+          /* hidden pages catch up with style changes when shown */
+          _mx_stylable_set_frozen (child, TRUE);
         }
     }
 }
@@ -80,8 +88,17 @@ mx_notebook_update_children (MxNotebook *book)
     {
       ClutterActor *child = CLUTTER_ACTOR (l->data);
 
-      if (child == priv->current_page)
+      if (child != priv->current_page)
         {
+          /* the pages faded out paint what they showed as the transition
+           * starts */
+          if (CLUTTER_ACTOR_IS_VISIBLE (child))
+            _mx_actor_set_paint_from_snapshot (child, TRUE);
+        }
+      else
+        {
+          _mx_actor_set_paint_from_snapshot (child, FALSE);
+          _mx_stylable_set_frozen (child, FALSE);
           clutter_actor_show (child);
 
           clutter_actor_save_easing_state (child);
@@ -90,6 +107,9 @@ mx_notebook_update_children (MxNotebook *book)
           clutter_actor_set_opacity (child, 0xff);
           clutter_actor_restore_easing_state (child);
 
+          g_signal_handlers_disconnect_by_func (child,
+                                                mx_notebook_show_complete_cb,
+                                                book);
           g_signal_connect (child, "transition-stopped::opacity",
                             G_CALLBACK (mx_notebook_show_complete_cb), book);
         }
@@ -112,7 +132,10 @@ mx_notebook_add (ClutterContainer *container,
       g_object_notify (G_OBJECT (container), "current-page");
     }
   else
-    clutter_actor_hide (actor);
+    {
+      clutter_actor_hide (actor);
+      _mx_stylable_set_frozen (actor, TRUE);
+    }
 }
 
 static void
@@ -145,6 +168,12 @@ mx_notebook_remove (ClutterContainer *container,
 
   g_object_ref (actor);
 
+  g_signal_handlers_disconnect_by_func (actor,
+                                        mx_notebook_show_complete_cb,
+                                        container);
+  _mx_stylable_set_frozen (actor, FALSE);
+  _mx_actor_set_paint_from_snapshot (actor, FALSE);
+
   priv->children = g_list_delete_link (priv->children, item);
   clutter_actor_remove_child (CLUTTER_ACTOR (container), actor);
 
@@ -0,0 +1,752 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-offscreen-renderer.c: Rendering widgets to images
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/**
+ * SECTION:mx-offscreen-renderer
+ * @short_description: Renders widgets to images
+ *
+ * #MxOffscreenRenderer renders widgets to #GdkPixbuf images without
+ * showing them, for thumbnails or for comparing the rendering of a user
+ * interface against reference images.
+ *
+ * Widgets are styled and laid out by the frames of the stage the renderer
+ * is created for, which must be shown, but are not painted on it. Each is
+ * painted into an offscreen buffer after the stage, and its pixels are
+ * read back into a pixel buffer, which most drivers fill without waiting
+ * for the GPU. The pixels are only looked at in a later frame, so that
+ * several renders are in flight at once, and are turned into images on
+ * the threads of the #MxWorkerPool.
+ *
+ * Widgets are rendered as they are within a frame of being added, so
+ * content that loads asynchronously, like #MxImage with
+ * #MxImage:load-async, should be loaded beforehand.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+/* for reading back into pixel buffers */
+#define COGL_ENABLE_EXPERIMENTAL_API
+
+#include <math.h>
+#include <cogl/cogl.h>
+
+#include "mx-offscreen-renderer.h"
+#include "mx-private.h"
+#include "mx-worker-pool.h"
+
+G_DEFINE_TYPE (MxOffscreenRenderer, mx_offscreen_renderer, G_TYPE_OBJECT)
+
+#define OFFSCREEN_RENDERER_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_OFFSCREEN_RENDERER, \
+                                MxOffscreenRendererPrivate))
+
+#define DEFAULT_MAX_IN_FLIGHT 4
+
+typedef struct
+{
+  MxOffscreenRenderer *renderer;
+  GSimpleAsyncResult  *simple;
+  GCancellable        *cancellable;
+
+  /* lays the widget out at the size asked for */
+  ClutterActor        *frame;
+  ClutterActor        *widget;
+  gfloat               scale;
+
+  /* the size of the image, in pixels */
+  gint                 width;
+  gint                 height;
+
+  CoglPixelBuffer     *buffer;
+  guint8              *pixels;
+  GdkPixbuf           *pixbuf;
+} MxOffscreenJob;
+
+struct _MxOffscreenRendererPrivate
+{
+  ClutterStage *stage;
+
+  /* the parent of the frames, which paints and picks nothing */
+  ClutterActor *holder;
+
+  gulong        after_paint_id;
+  gulong        destroy_id;
+  guint         idle_source;
+
+  /* jobs waiting to be painted, and jobs waiting for their pixels */
+  GQueue        pending;
+  GQueue        in_flight;
+  guint         max_in_flight;
+};
+
+enum
+{
+  PROP_0,
+
+  PROP_STAGE,
+  PROP_MAX_IN_FLIGHT
+};
+
+static void
+mx_offscreen_job_detach (MxOffscreenJob *job)
+{
+  if (!job->frame)
+    return;
+
+  clutter_actor_remove_child (job->frame, job->widget);
+  clutter_actor_destroy (job->frame);
+  job->frame = NULL;
+}
+
+static void
+mx_offscreen_job_free (MxOffscreenJob *job)
+{
+  mx_offscreen_job_detach (job);
+
+  if (job->buffer)
+    cogl_object_unref (job->buffer);
+  g_free (job->pixels);
+  if (job->pixbuf)
+    g_object_unref (job->pixbuf);
+
+  g_object_unref (job->widget);
+  if (job->cancellable)
+    g_object_unref (job->cancellable);
+  g_object_unref (job->simple);
+
+  g_slice_free (MxOffscreenJob, job);
+}
+
+/* Completes @job in an idle with an error, for when it fails while the
+ * stage is painting or being destroyed */
+static void
+mx_offscreen_job_fail (MxOffscreenJob *job,
+                       GQuark          domain,
+                       gint            code,
+                       const gchar    *message)
+{
+  mx_offscreen_job_detach (job);
+
+  g_simple_async_result_set_error (job->simple, domain, code, "%s", message);
+  g_simple_async_result_complete_in_idle (job->simple);
+
+  mx_offscreen_job_free (job);
+}
+
+static gboolean
+mx_offscreen_job_paint (MxOffscreenJob *job)
+{
+  CoglContext *context;
+  CoglHandle texture, offscreen;
+  CoglBitmap *bitmap;
+  CoglColor transparent;
+  CoglMatrix matrix;
+  gboolean retval;
+
+  texture = cogl_texture_new_with_size (job->width, job->height,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  if (texture == COGL_INVALID_HANDLE)
+    return FALSE;
+
+  offscreen = cogl_offscreen_new_to_texture (texture);
+  cogl_handle_unref (texture);
+  if (offscreen == COGL_INVALID_HANDLE)
+    return FALSE;
+
+  cogl_push_framebuffer (offscreen);
+  cogl_ortho (0, job->width, job->height, 0, -1, 1);
+
+  cogl_matrix_init_identity (&matrix);
+  cogl_matrix_scale (&matrix, job->scale, job->scale, 1);
+  cogl_set_modelview_matrix (&matrix);
+
+  cogl_color_set_from_4ub (&transparent, 0, 0, 0, 0);
+  cogl_clear (&transparent, COGL_BUFFER_BIT_COLOR);
+
+  /* the frame is at the origin of the holder, and actors aren't culled
+   * outside of the stage's own framebuffer */
+  clutter_actor_paint (job->frame);
+
+  /* reading into a pixel buffer returns before the GPU is done */
+  context = clutter_backend_get_cogl_context (clutter_get_default_backend ());
+  job->buffer = cogl_pixel_buffer_new (context,
+                                       job->width * job->height * 4, NULL);
+  bitmap = cogl_bitmap_new_from_buffer (COGL_BUFFER (job->buffer),
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                        job->width, job->height,
+                                        job->width * 4, 0);
+  retval =
+    cogl_framebuffer_read_pixels_into_bitmap (COGL_FRAMEBUFFER (offscreen),
+                                              0, 0,
+                                              COGL_READ_PIXELS_COLOR_BUFFER,
+                                              bitmap);
+  cogl_object_unref (bitmap);
+
+  cogl_pop_framebuffer ();
+  cogl_handle_unref (offscreen);
+
+  if (!retval)
+    {
+      cogl_object_unref (job->buffer);
+      job->buffer = NULL;
+    }
+
+  return retval;
+}
+
+/* runs on a worker thread */
+static void
+mx_offscreen_job_convert_cb (gpointer data)
+{
+  MxOffscreenJob *job = data;
+  guint8 *p, *end;
+
+  end = job->pixels + job->width * job->height * 4;
+  for (p = job->pixels; p < end; p += 4)
+    {
+      guint a = p[3];
+
+      if (a == 0 || a == 255)
+        continue;
+
+      p[0] = MIN (255, (p[0] * 255 + a / 2) / a);
+      p[1] = MIN (255, (p[1] * 255 + a / 2) / a);
+      p[2] = MIN (255, (p[2] * 255 + a / 2) / a);
+    }
+
+  job->pixbuf = gdk_pixbuf_new_from_data (job->pixels, GDK_COLORSPACE_RGB,
+                                          TRUE, 8, job->width, job->height,
+                                          job->width * 4,
+                                          (GdkPixbufDestroyNotify) g_free,
+                                          NULL);
+  job->pixels = NULL;
+}
+
+static void
+mx_offscreen_job_complete_cb (gpointer data)
+{
+  MxOffscreenJob *job = data;
+
+  /* without a pixbuf, the job was cancelled before it ran; the check of
+   * the cancellable reports it */
+  if (job->pixbuf)
+    g_simple_async_result_set_op_res_gpointer (job->simple,
+                                               g_object_ref (job->pixbuf),
+                                               g_object_unref);
+  g_simple_async_result_complete (job->simple);
+
+  mx_offscreen_job_free (job);
+}
+
+/* Takes the pixels of the jobs in flight out of their buffers. This waits
+ * for the GPU if it hasn't rendered them yet. */
+static void
+mx_offscreen_renderer_collect (MxOffscreenRenderer *renderer)
+{
+  MxOffscreenRendererPrivate *priv = renderer->priv;
+  MxOffscreenJob *job;
+
+  while ((job = g_queue_pop_head (&priv->in_flight)))
+    {
+      guint8 *map;
+
+      /* the widget can go back to its owner now */
+      mx_offscreen_job_detach (job);
+
+      map = cogl_buffer_map (COGL_BUFFER (job->buffer),
+                             COGL_BUFFER_ACCESS_READ, 0);
+      if (map)
+        {
+          job->pixels = g_memdup (map, job->width * job->height * 4);
+          cogl_buffer_unmap (COGL_BUFFER (job->buffer));
+        }
+
+      cogl_object_unref (job->buffer);
+      job->buffer = NULL;
+
+      if (!job->pixels)
+        {
+          mx_offscreen_job_fail (job, G_IO_ERROR, G_IO_ERROR_FAILED,
+                                 "Failed to read back the rendered widget");
+          continue;
+        }
+
+      mx_worker_pool_push (mx_worker_pool_get_default (), G_PRIORITY_DEFAULT,
+                           mx_offscreen_job_convert_cb,
+                           mx_offscreen_job_complete_cb,
+                           job, job->cancellable);
+    }
+}
+
+static gboolean
+mx_offscreen_renderer_idle_cb (gpointer data)
+{
+  MxOffscreenRenderer *renderer = data;
+  MxOffscreenRendererPrivate *priv = renderer->priv;
+
+  priv->idle_source = 0;
+
+  /* the jobs in flight are collected by the next frame, if there is one */
+  if (priv->pending.length)
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (priv->stage));
+  else
+    mx_offscreen_renderer_collect (renderer);
+
+  return FALSE;
+}
+
+static void
+mx_offscreen_renderer_after_paint_cb (ClutterActor        *stage,
+                                      MxOffscreenRenderer *renderer)
+{
+  MxOffscreenRendererPrivate *priv = renderer->priv;
+  MxOffscreenJob *job;
+
+  /* the GPU has had a frame to render these in */
+  mx_offscreen_renderer_collect (renderer);
+
+  while (priv->in_flight.length < priv->max_in_flight &&
+         (job = g_queue_pop_head (&priv->pending)))
+    {
+      if (job->cancellable && g_cancellable_is_cancelled (job->cancellable))
+        {
+          mx_offscreen_job_detach (job);
+          g_simple_async_result_complete_in_idle (job->simple);
+          mx_offscreen_job_free (job);
+        }
+      else if (mx_offscreen_job_paint (job))
+        g_queue_push_tail (&priv->in_flight, job);
+      else
+        mx_offscreen_job_fail (job, G_IO_ERROR, G_IO_ERROR_FAILED,
+                               "Failed to render the widget offscreen");
+    }
+
+  if ((priv->pending.length || priv->in_flight.length) && !priv->idle_source)
+    priv->idle_source =
+      clutter_threads_add_idle_full (G_PRIORITY_LOW,
+                                     mx_offscreen_renderer_idle_cb,
+                                     renderer, NULL);
+}
+
+static void
+mx_offscreen_renderer_stop_cb (ClutterActor *holder)
+{
+  /* the frames are only painted offscreen */
+  g_signal_stop_emission_by_name (holder, "paint");
+}
+
+static void
+mx_offscreen_renderer_stop_pick_cb (ClutterActor       *holder,
+                                    const ClutterColor *color)
+{
+  g_signal_stop_emission_by_name (holder, "pick");
+}
+
+static void
+mx_offscreen_renderer_fail_all (MxOffscreenRenderer *renderer)
+{
+  MxOffscreenRendererPrivate *priv = renderer->priv;
+  MxOffscreenJob *job;
+
+  while ((job = g_queue_pop_head (&priv->in_flight)))
+    mx_offscreen_job_fail (job, G_IO_ERROR, G_IO_ERROR_CLOSED,
+                           "The stage of the renderer was destroyed");
+  while ((job = g_queue_pop_head (&priv->pending)))
+    mx_offscreen_job_fail (job, G_IO_ERROR, G_IO_ERROR_CLOSED,
+                           "The stage of the renderer was destroyed");
+}
+
+static void
+mx_offscreen_renderer_release_stage (MxOffscreenRenderer *renderer)
+{
+  MxOffscreenRendererPrivate *priv = renderer->priv;
+
+  if (!priv->stage)
+    return;
+
+  mx_offscreen_renderer_fail_all (renderer);
+
+  if (priv->idle_source)
+    {
+      g_source_remove (priv->idle_source);
+      priv->idle_source = 0;
+    }
+
+  g_signal_handler_disconnect (priv->stage, priv->after_paint_id);
+  g_signal_handler_disconnect (priv->stage, priv->destroy_id);
+
+  if (priv->holder)
+    {
+      clutter_actor_destroy (priv->holder);
+      g_object_unref (priv->holder);
+      priv->holder = NULL;
+    }
+
+  g_object_unref (priv->stage);
+  priv->stage = NULL;
+}
+
+static void
+mx_offscreen_renderer_stage_destroy_cb (ClutterActor        *stage,
+                                        MxOffscreenRenderer *renderer)
+{
+  mx_offscreen_renderer_release_stage (renderer);
+}
+
+static void
+mx_offscreen_renderer_set_stage (MxOffscreenRenderer *renderer,
+                                 ClutterStage        *stage)
+{
+  MxOffscreenRendererPrivate *priv = renderer->priv;
+
+  if (!stage)
+    return;
+
+  priv->stage = g_object_ref (stage);
+
+  priv->holder = g_object_ref_sink (clutter_actor_new ());
+  g_signal_connect (priv->holder, "paint",
+                    G_CALLBACK (mx_offscreen_renderer_stop_cb), NULL);
+  g_signal_connect (priv->holder, "pick",
+                    G_CALLBACK (mx_offscreen_renderer_stop_pick_cb), NULL);
+  clutter_actor_add_child (CLUTTER_ACTOR (stage), priv->holder);
+
+  priv->after_paint_id =
+    g_signal_connect_after (stage, "paint",
+                            G_CALLBACK (mx_offscreen_renderer_after_paint_cb),
+                            renderer);
+  priv->destroy_id =
+    g_signal_connect (stage, "destroy",
+                      G_CALLBACK (mx_offscreen_renderer_stage_destroy_cb),
+                      renderer);
+}
+
+static void
+mx_offscreen_renderer_set_property (GObject      *object,
+                                    guint         prop_id,
+                                    const GValue *value,
+                                    GParamSpec   *pspec)
+{
+  MxOffscreenRenderer *renderer = MX_OFFSCREEN_RENDERER (object);
+
+  switch (prop_id)
+    {
+    case PROP_STAGE:
+      mx_offscreen_renderer_set_stage (renderer, g_value_get_object (value));
+      break;
+
+    case PROP_MAX_IN_FLIGHT:
+      mx_offscreen_renderer_set_max_in_flight (renderer,
+                                               g_value_get_uint (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+mx_offscreen_renderer_get_property (GObject    *object,
+                                    guint       prop_id,
+                                    GValue     *value,
+                                    GParamSpec *pspec)
+{
+  MxOffscreenRendererPrivate *priv = MX_OFFSCREEN_RENDERER (object)->priv;
+
+  switch (prop_id)
+    {
+    case PROP_STAGE:
+      g_value_set_object (value, priv->stage);
+      break;
+
+    case PROP_MAX_IN_FLIGHT:
+      g_value_set_uint (value, priv->max_in_flight);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+mx_offscreen_renderer_dispose (GObject *object)
+{
+  mx_offscreen_renderer_release_stage (MX_OFFSCREEN_RENDERER (object));
+
+  G_OBJECT_CLASS (mx_offscreen_renderer_parent_class)->dispose (object);
+}
+
+static void
+mx_offscreen_renderer_class_init (MxOffscreenRendererClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GParamSpec *pspec;
+
+  g_type_class_add_private (klass, sizeof (MxOffscreenRendererPrivate));
+
+  object_class->set_property = mx_offscreen_renderer_set_property;
+  object_class->get_property = mx_offscreen_renderer_get_property;
+  object_class->dispose = mx_offscreen_renderer_dispose;
+
+  /**
+   * MxOffscreenRenderer:stage:
+   *
+   * The stage whose frames style and lay out the widgets being rendered.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_object ("stage",
+                               "Stage",
+                               "The stage that lays out the widgets",
+                               CLUTTER_TYPE_STAGE,
+                               MX_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+  g_object_class_install_property (object_class, PROP_STAGE, pspec);
+
+  /**
+   * MxOffscreenRenderer:max-in-flight:
+   *
+   * The number of renders that are painted in a frame and read back
+   * together. Higher values keep the GPU busier, at the cost of the memory
+   * of the images being read back.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_uint ("max-in-flight",
+                             "Maximum in flight",
+                             "The number of renders read back at once",
+                             1, G_MAXUINT, DEFAULT_MAX_IN_FLIGHT,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_MAX_IN_FLIGHT, pspec);
+}
+
+static void
+mx_offscreen_renderer_init (MxOffscreenRenderer *self)
+{
+  MxOffscreenRendererPrivate *priv = self->priv =
+    OFFSCREEN_RENDERER_PRIVATE (self);
+
+  g_queue_init (&priv->pending);
+  g_queue_init (&priv->in_flight);
+  priv->max_in_flight = DEFAULT_MAX_IN_FLIGHT;
+}
+
+/**
+ * mx_offscreen_renderer_new:
+ * @stage: the #ClutterStage to lay the widgets out on
+ *
+ * Creates a renderer of widgets to images. The widgets are styled and laid
+ * out by the frames of @stage, which must be shown, but are not painted on
+ * it.
+ *
+ * Returns: a newly allocated #MxOffscreenRenderer
+ *
+ * Since: 2.0
+ */
+MxOffscreenRenderer *
+mx_offscreen_renderer_new (ClutterStage *stage)
+{
+  g_return_val_if_fail (CLUTTER_IS_STAGE (stage), NULL);
+
+  return g_object_new (MX_TYPE_OFFSCREEN_RENDERER, "stage", stage, NULL);
+}
+
+/**
+ * mx_offscreen_renderer_get_stage:
+ * @renderer: A #MxOffscreenRenderer
+ *
+ * Gets the stage @renderer lays widgets out on.
+ *
+ * Returns: (transfer none): the #ClutterStage of @renderer, or %NULL if it
+ *   was destroyed
+ *
+ * Since: 2.0
+ */
+ClutterStage *
+mx_offscreen_renderer_get_stage (MxOffscreenRenderer *renderer)
+{
+  g_return_val_if_fail (MX_IS_OFFSCREEN_RENDERER (renderer), NULL);
+
+  return renderer->priv->stage;
+}
+
+/**
+ * mx_offscreen_renderer_set_max_in_flight:
+ * @renderer: A #MxOffscreenRenderer
+ * @max_in_flight: the number of renders to read back at once
+ *
+ * Sets the number of renders that are painted in a frame and read back
+ * together.
+ *
+ * Since: 2.0
+ */
+void
+mx_offscreen_renderer_set_max_in_flight (MxOffscreenRenderer *renderer,
+                                         guint                max_in_flight)
+{
+  MxOffscreenRendererPrivate *priv;
+
+  g_return_if_fail (MX_IS_OFFSCREEN_RENDERER (renderer));
+  g_return_if_fail (max_in_flight > 0);
+
+  priv = renderer->priv;
+
+  if (priv->max_in_flight == max_in_flight)
+    return;
+
+  priv->max_in_flight = max_in_flight;
+
+  g_object_notify (G_OBJECT (renderer), "max-in-flight");
+}
+
+/**
+ * mx_offscreen_renderer_get_max_in_flight:
+ * @renderer: A #MxOffscreenRenderer
+ *
+ * Gets the number of renders that are painted in a frame and read back
+ * together.
+ *
+ * Returns: the number of renders read back at once
+ *
+ * Since: 2.0
+ */
+guint
+mx_offscreen_renderer_get_max_in_flight (MxOffscreenRenderer *renderer)
+{
+  g_return_val_if_fail (MX_IS_OFFSCREEN_RENDERER (renderer), 0);
+
+  return renderer->priv->max_in_flight;
+}
+
+/**
+ * mx_offscreen_renderer_render_async:
+ * @renderer: A #MxOffscreenRenderer
+ * @widget: the #MxWidget to render, which must not have a parent
+ * @width: the width to lay @widget out at
+ * @height: the height to lay @widget out at
+ * @scale: the number of pixels of the image per unit of @width and @height
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the image
+ *   is ready
+ * @user_data: (closure): user data to pass to @callback
+ *
+ * Renders @widget, laid out at @width by @height, into an image of
+ * @width by @height times @scale pixels, rounded up. @widget is added to
+ * the stage of @renderer until it has been painted, and is given back
+ * without a parent once the image has been read back, before @callback is
+ * called. A floating @widget is destroyed once it has been rendered.
+ *
+ * Renders are started in the order they were asked for, and finish within
+ * a few frames of the stage.
+ *
+ * Since: 2.0
+ */
+void
+mx_offscreen_renderer_render_async (MxOffscreenRenderer *renderer,
+                                    MxWidget            *widget,
+                                    gfloat               width,
+                                    gfloat               height,
+                                    gfloat               scale,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+  MxOffscreenRendererPrivate *priv;
+  MxOffscreenJob *job;
+
+  g_return_if_fail (MX_IS_OFFSCREEN_RENDERER (renderer));
+  g_return_if_fail (MX_IS_WIDGET (widget));
+  g_return_if_fail (clutter_actor_get_parent (CLUTTER_ACTOR (widget)) == NULL);
+  g_return_if_fail (width > 0 && height > 0 && scale > 0);
+
+  priv = renderer->priv;
+
+  job = g_slice_new0 (MxOffscreenJob);
+  job->renderer = renderer;
+  job->simple = g_simple_async_result_new (G_OBJECT (renderer), callback,
+                                           user_data,
+                                           mx_offscreen_renderer_render_async);
+  g_simple_async_result_set_check_cancellable (job->simple, cancellable);
+  if (cancellable)
+    job->cancellable = g_object_ref (cancellable);
+
+  job->widget = g_object_ref_sink (widget);
+  job->scale = scale;
+  job->width = (gint) ceilf (width * scale);
+  job->height = (gint) ceilf (height * scale);
+
+  if (!priv->stage)
+    {
+      mx_offscreen_job_fail (job, G_IO_ERROR, G_IO_ERROR_CLOSED,
+                             "The stage of the renderer was destroyed");
+      return;
+    }
+
+  job->frame = clutter_actor_new ();
+  clutter_actor_set_layout_manager (job->frame,
+                                    clutter_bin_layout_new (
+                                      CLUTTER_BIN_ALIGNMENT_FILL,
+                                      CLUTTER_BIN_ALIGNMENT_FILL));
+  clutter_actor_set_size (job->frame, width, height);
+  clutter_actor_add_child (job->frame, job->widget);
+  clutter_actor_add_child (priv->holder, job->frame);
+
+  g_queue_push_tail (&priv->pending, job);
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (priv->stage));
+}
+
+/**
+ * mx_offscreen_renderer_render_finish:
+ * @renderer: A #MxOffscreenRenderer
+ * @result: the #GAsyncResult passed to the callback
+ * @error: a #GError or %NULL
+ *
+ * Finishes a render started with mx_offscreen_renderer_render_async().
+ *
+ * Returns: (transfer full): the rendered image, with an alpha channel
+ *   that is not premultiplied, or %NULL on error
+ *
+ * Since: 2.0
+ */
+GdkPixbuf *
+mx_offscreen_renderer_render_finish (MxOffscreenRenderer  *renderer,
+                                     GAsyncResult         *result,
+                                     GError              **error)
+{
+  GSimpleAsyncResult *simple;
+
+  g_return_val_if_fail (MX_IS_OFFSCREEN_RENDERER (renderer), NULL);
+  g_return_val_if_fail (g_simple_async_result_is_valid (result,
+                                                        G_OBJECT (renderer),
+                                                        mx_offscreen_renderer_render_async),
+                        NULL);
+
+  simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  if (g_simple_async_result_propagate_error (simple, error))
+    return NULL;
+
+  return g_object_ref (g_simple_async_result_get_op_res_gpointer (simple));
+}
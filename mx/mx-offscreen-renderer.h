@@ -0,0 +1,109 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-offscreen-renderer.h: Rendering widgets to images
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#if !defined(MX_H_INSIDE) && !defined(MX_COMPILATION)
+#error "Only <mx/mx.h> can be included directly.h"
+#endif
+
+#ifndef _MX_OFFSCREEN_RENDERER
+#define _MX_OFFSCREEN_RENDERER
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <clutter/clutter.h>
+#include <mx/mx-widget.h>
+
+G_BEGIN_DECLS
+
+#define MX_TYPE_OFFSCREEN_RENDERER mx_offscreen_renderer_get_type()
+
+#define MX_OFFSCREEN_RENDERER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+  MX_TYPE_OFFSCREEN_RENDERER, MxOffscreenRenderer))
+
+#define MX_OFFSCREEN_RENDERER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), \
+  MX_TYPE_OFFSCREEN_RENDERER, MxOffscreenRendererClass))
+
+#define MX_IS_OFFSCREEN_RENDERER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+  MX_TYPE_OFFSCREEN_RENDERER))
+
+#define MX_IS_OFFSCREEN_RENDERER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+  MX_TYPE_OFFSCREEN_RENDERER))
+
+#define MX_OFFSCREEN_RENDERER_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+  MX_TYPE_OFFSCREEN_RENDERER, MxOffscreenRendererClass))
+
+typedef struct _MxOffscreenRendererPrivate MxOffscreenRendererPrivate;
+
+/**
+ * MxOffscreenRenderer:
+ *
+ * The contents of this structure are private and should only be accessed
+ * through the public API.
+ */
+typedef struct {
+  /*< private >*/
+  GObject parent;
+
+  MxOffscreenRendererPrivate *priv;
+} MxOffscreenRenderer;
+
+typedef struct {
+  GObjectClass parent_class;
+
+  /* padding for future expansion */
+  void (*_padding_0) (void);
+  void (*_padding_1) (void);
+  void (*_padding_2) (void);
+  void (*_padding_3) (void);
+} MxOffscreenRendererClass;
+
+GType mx_offscreen_renderer_get_type (void);
+
+MxOffscreenRenderer *mx_offscreen_renderer_new               (ClutterStage        *stage);
+
+ClutterStage        *mx_offscreen_renderer_get_stage         (MxOffscreenRenderer *renderer);
+
+void                 mx_offscreen_renderer_set_max_in_flight (MxOffscreenRenderer *renderer,
+                                                              guint                max_in_flight);
+guint                mx_offscreen_renderer_get_max_in_flight (MxOffscreenRenderer *renderer);
+
+void                 mx_offscreen_renderer_render_async      (MxOffscreenRenderer *renderer,
+                                                              MxWidget            *widget,
+                                                              gfloat               width,
+                                                              gfloat               height,
+                                                              gfloat               scale,
+                                                              GCancellable        *cancellable,
+                                                              GAsyncReadyCallback  callback,
+                                                              gpointer             user_data);
+GdkPixbuf           *mx_offscreen_renderer_render_finish     (MxOffscreenRenderer *renderer,
+                                                              GAsyncResult        *result,
+                                                              GError             **error);
+
+G_END_DECLS
+
+#endif /* _MX_OFFSCREEN_RENDERER */
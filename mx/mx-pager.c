@@ -30,9 +30,15 @@
  * bottom. Hovering on the sides of the widget will also show a preview of
  * what's on the next page.
  *
+ * The pages other than the current one, which are only seen as previews
+ * and as they are turned away from, are painted from snapshots of
+ * themselves that are rendered again when they queue a redraw.
+ *
  * Since: UNRELEASED
  */
 
+#include <string.h>
+
 #include "mx-pager.h"
 #include "mx-private.h"
 
@@ -57,20 +63,41 @@ enum /* properties */
   PROP_EDGE_PREVIEWS,
   PROP_PAGE_NUM,
   PROP_PAGE_ACTOR,
+  PROP_CACHED_PAGES,
 
   LAST_PROP
 };
 
+typedef struct
+{
+  ClutterActor *actor;
+  ClutterActor *button;
+
+  /* the actor of a lazy page is created by the page function, and
+   * destroyed again when the page is far from the current one */
+  gboolean      lazy;
+} MxPagerPage;
+
 struct _MxPagerPrivate
 {
-  GList *pages;
-  GList *current_page;
+  GPtrArray *pages;
+  gint current_page;
+
+  /* the page before the current one, whose neighbours are kept until
+   * the next page change so that the pages the animation goes through
+   * aren't unloaded under it */
+  gint previous_page;
+
+  gint cached_pages;
+
+  MxPagerPageFunc page_func;
+  gpointer page_data;
+  GDestroyNotify page_notify;
 
   gboolean edge_previews;
 
   ClutterActor *button_box;
   MxButtonGroup *button_group;
-  GHashTable *pages_to_buttons; /* ClutterActor* -> MxButton* */
 
   guint hover_timeout;
 };
@@ -98,22 +125,46 @@ mx_pager_add_internal_actor (MxPager      *self,
   va_end (var_args);
 }
 
+#define PAGE(self, i) \
+  ((MxPagerPage *) g_ptr_array_index ((self)->priv->pages, (i)))
+
+static void
+mx_pager_page_free (MxPagerPage *page)
+{
+  g_slice_free (MxPagerPage, page);
+}
+
+static gint
+mx_pager_find_page (MxPager     *self,
+                    MxPagerPage *page)
+{
+  guint i;
+
+  for (i = 0; i < self->priv->pages->len; i++)
+    if (PAGE (self, i) == page)
+      return i;
+
+  return -1;
+}
+
 static void
 pager_page_button_clicked (MxButton *button,
                            MxPager  *self)
 {
-  ClutterActor *page;
+  gint page;
 
-  page = g_object_get_data (G_OBJECT (button), "page-actor");
+  page = mx_pager_find_page (self, g_object_get_data (G_OBJECT (button),
+                                                      "pager-page"));
 
-  g_return_if_fail (CLUTTER_IS_ACTOR (page));
+  g_return_if_fail (page >= 0);
 
-  mx_pager_set_current_page_by_actor (self, page, TRUE);
+  mx_pager_set_current_page (self, page, TRUE);
 }
 
 static void
-mx_pager_add_page_button (MxPager      *self,
-                          ClutterActor *page)
+mx_pager_add_page_button (MxPager     *self,
+                          MxPagerPage *page,
+                          gint         position)
 {
   ClutterActor *button;
 
@@ -122,82 +173,158 @@ mx_pager_add_page_button (MxPager      *self,
   /* FIXME: add style class */
 
   mx_button_group_add (self->priv->button_group, MX_BUTTON (button));
-  clutter_actor_add_child (self->priv->button_box, button);
+  clutter_actor_insert_child_at_index (self->priv->button_box, button,
+                                       position);
 
-  g_hash_table_insert (self->priv->pages_to_buttons, page, button);
-  g_object_set_data (G_OBJECT (button), "page-actor", page);
+  page->button = button;
+  g_object_set_data (G_OBJECT (button), "pager-page", page);
 
   g_signal_connect (button, "clicked",
       G_CALLBACK (pager_page_button_clicked), self);
 }
 
-static ClutterActor *
-mx_pager_get_button_for_page (MxPager      *self,
-                              ClutterActor *page)
-{
-  ClutterActor *button;
-
-  button = g_hash_table_lookup (self->priv->pages_to_buttons, page);
-
-  g_return_val_if_fail (MX_IS_BUTTON (button), NULL);
-
-  return button;
-}
-
+/* Lays the pages out around the current one, which is the only one painted
+ * live */
 static void
 mx_pager_relayout_pages (MxPager *self,
                          gboolean animate)
 {
   float width = clutter_actor_get_width (CLUTTER_ACTOR (self));
-  GList *page;
   int current, i;
 
-  current = mx_pager_get_current_page (self);
+  current = self->priv->current_page;
 
-  for (page = self->priv->pages, i = 0;
-       page != NULL;
-       page = page->next, i++)
+  for (i = 0; i < (gint) self->priv->pages->len; i++)
     {
+      ClutterActor *page = PAGE (self, i)->actor;
       gfloat x = width * (current - i);
 
+      if (page == NULL)
+        continue;
+
+      _mx_actor_set_paint_from_snapshot (page, i != current &&
+                                         CLUTTER_ACTOR_IS_VISIBLE (page));
+
       if (animate)
         {
-          clutter_actor_save_easing_state (page->data);
-          clutter_actor_set_easing_mode (page->data, CLUTTER_EASE_IN_OUT_SINE);
-          clutter_actor_set_easing_duration (page->data, ANIMATION_DURATION);
-          clutter_actor_set_pivot_point (page->data, x, 0.);
-          clutter_actor_restore_easing_state (page->data);
+          clutter_actor_save_easing_state (page);
+          clutter_actor_set_easing_mode (page, CLUTTER_EASE_IN_OUT_SINE);
+          clutter_actor_set_easing_duration (page, ANIMATION_DURATION);
+          clutter_actor_set_pivot_point (page, x, 0.);
+          clutter_actor_restore_easing_state (page);
         }
       else
-        clutter_actor_set_pivot_point (page->data, x, 0.);
+        clutter_actor_set_pivot_point (page, x, 0.);
+    }
+}
+
+static gboolean
+mx_pager_is_page_kept (MxPager *self,
+                       gint     page)
+{
+  MxPagerPrivate *priv = self->priv;
+
+  return (priv->cached_pages < 0 ||
+          ABS (page - priv->current_page) <= priv->cached_pages ||
+          (priv->previous_page >= 0 &&
+           ABS (page - priv->previous_page) <= priv->cached_pages));
+}
+
+/* Creates the actor of a lazy page, or shows the hidden actor of another */
+static void
+mx_pager_realize_page (MxPager *self,
+                       gint     index)
+{
+  MxPagerPrivate *priv = self->priv;
+  MxPagerPage *page = PAGE (self, index);
+
+  if (page->actor)
+    {
+      clutter_actor_show (page->actor);
+      return;
+    }
+
+  if (!page->lazy || !priv->page_func)
+    return;
+
+  page->actor = priv->page_func (self, index, priv->page_data);
+  if (!page->actor)
+    return;
+
+  g_object_set_data (G_OBJECT (page->actor), "pager-page", page);
+  mx_pager_add_internal_actor (self, page->actor,
+      "fit", TRUE,
+      NULL);
+  clutter_actor_set_child_below_sibling ((ClutterActor *) self,
+                                         page->actor, NULL);
+}
+
+/* Destroys the actor of a lazy page, or hides the actor of another, as the
+ * pager doesn't own those */
+static void
+mx_pager_unrealize_page (MxPager *self,
+                         gint     index)
+{
+  MxPagerPage *page = PAGE (self, index);
+  ClutterActor *actor = page->actor;
+
+  if (!actor)
+    return;
+
+  if (!page->lazy)
+    {
+      _mx_actor_set_paint_from_snapshot (actor, FALSE);
+      clutter_actor_hide (actor);
+      return;
+    }
+
+  /* the page stays, without its actor */
+  page->actor = NULL;
+  g_object_set_data (G_OBJECT (actor), "pager-page", NULL);
+  clutter_actor_destroy (actor);
+}
+
+static void
+mx_pager_update_pages (MxPager *self)
+{
+  gint i;
+
+  for (i = 0; i < (gint) self->priv->pages->len; i++)
+    {
+      if (mx_pager_is_page_kept (self, i))
+        mx_pager_realize_page (self, i);
+      else
+        mx_pager_unrealize_page (self, i);
     }
 }
 
 /**
  * mx_pager_change_page:
  * @self:
- * @new_page: pointer to the new page
+ * @new_page: the number of the new page
  * @animate: whether to animate the transition
  *
- * Changes the currently visible page.
+ * Changes the currently visible page. The pages around the new one are
+ * created before the transition starts.
  */
 static void
 mx_pager_change_page (MxPager *self,
-                      GList   *new_page,
+                      gint     new_page,
                       gboolean animate)
 {
-  if (new_page == self->priv->current_page)
+  MxPagerPrivate *priv = self->priv;
+
+  if (new_page == priv->current_page)
     return;
 
-  if (new_page != NULL)
-    {
-      ClutterActor *page = new_page->data;
+  priv->previous_page = priv->current_page;
+  priv->current_page = new_page;
+  mx_pager_update_pages (self);
 
-      mx_button_group_set_active_button (self->priv->button_group,
-          (MxButton *) mx_pager_get_button_for_page (self, page));
-    }
+  if (new_page >= 0)
+    mx_button_group_set_active_button (priv->button_group,
+        (MxButton *) PAGE (self, new_page)->button);
 
-  self->priv->current_page = new_page;
   g_object_notify (G_OBJECT (self), "page-num");
   g_object_notify (G_OBJECT (self), "page-actor");
   mx_pager_relayout_pages (self, animate);
@@ -226,6 +353,11 @@ mx_pager_get_property (GObject    *self,
             mx_pager_get_current_page_actor (MX_PAGER (self)));
         break;
 
+      case PROP_CACHED_PAGES:
+        g_value_set_int (value,
+            mx_pager_get_cached_pages (MX_PAGER (self)));
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
         break;
@@ -255,6 +387,11 @@ mx_pager_set_property (GObject      *self,
             g_value_get_object (value), TRUE);
         break;
 
+      case PROP_CACHED_PAGES:
+        mx_pager_set_cached_pages (MX_PAGER (self),
+            g_value_get_int (value));
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
         break;
@@ -265,15 +402,33 @@ static void
 mx_pager_dispose (GObject *self)
 {
   MxPagerPrivate *priv = MX_PAGER (self)->priv;
+  guint i;
 
   g_clear_object (&priv->button_group);
 
-  if (priv->pages_to_buttons != NULL)
+  /* the children removed when chaining up are no longer pages */
+  if (priv->pages != NULL)
     {
-      g_hash_table_unref (priv->pages_to_buttons);
-      priv->pages_to_buttons = NULL;
+      for (i = 0; i < priv->pages->len; i++)
+        {
+          MxPagerPage *page = PAGE (MX_PAGER (self), i);
+
+          if (page->actor)
+            {
+              g_object_set_data (G_OBJECT (page->actor), "pager-page", NULL);
+              _mx_actor_set_paint_from_snapshot (page->actor, FALSE);
+            }
+        }
+
+      g_ptr_array_free (priv->pages, TRUE);
+      priv->pages = NULL;
     }
 
+  if (priv->page_notify)
+    priv->page_notify (priv->page_data);
+  priv->page_func = NULL;
+  priv->page_notify = NULL;
+
   G_OBJECT_CLASS (mx_pager_parent_class)->dispose (self);
 }
 
@@ -309,6 +464,14 @@ mx_pager_class_init (MxPagerClass *klass)
         "The actor being shown on the current page",
         CLUTTER_TYPE_ACTOR,
         MX_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_CACHED_PAGES,
+      g_param_spec_int ("cached-pages",
+        "Cached pages",
+        "The number of pages either side of the current one that are "
+        "kept realized, or -1 to keep all of them",
+        -1, G_MAXINT, -1,
+        MX_PARAM_READWRITE));
 }
 
 /**
@@ -322,19 +485,19 @@ static void
 mx_pager_bump (MxPager *self,
                int      direction)
 {
-  GList *l;
+  guint i;
 
   g_return_if_fail (direction == -1 || direction == 1);
 
   switch (direction)
     {
       case -1:
-        if (self->priv->current_page->prev == NULL)
+        if (self->priv->current_page <= 0)
           return;
         break;
 
       case 1:
-        if (self->priv->current_page->next == NULL)
+        if (self->priv->current_page + 1 >= (gint) self->priv->pages->len)
           return;
         break;
 
@@ -342,11 +505,14 @@ mx_pager_bump (MxPager *self,
         g_assert_not_reached ();
     }
 
-  for (l = self->priv->pages; l != NULL; l = l->next)
+  for (i = 0; i < self->priv->pages->len; i++)
     {
-      ClutterActor *page = l->data;
+      ClutterActor *page = PAGE (self, i)->actor;
       float x, y;
 
+      if (page == NULL)
+        continue;
+
       clutter_actor_get_pivot_point (page, &x, &y);
 
       clutter_actor_save_easing_state (page);
@@ -430,8 +596,13 @@ mx_pager_init (MxPager *self)
 
   clutter_actor_set_clip_to_allocation (CLUTTER_ACTOR (self), TRUE);
 
+  self->priv->pages =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) mx_pager_page_free);
+  self->priv->current_page = -1;
+  self->priv->previous_page = -1;
+  self->priv->cached_pages = -1;
+
   /* refs are held by Clutter */
-  self->priv->pages_to_buttons = g_hash_table_new (NULL, NULL);
   self->priv->button_group = mx_button_group_new ();
   self->priv->button_box = mx_box_layout_new ();
   mx_box_layout_set_enable_animations (MX_BOX_LAYOUT (self->priv->button_box),
@@ -477,31 +648,58 @@ mx_pager_init (MxPager *self)
 }
 
 static void
-mx_pager_actor_removed (ClutterContainer *self,
-                        ClutterActor     *child)
+mx_pager_remove_page_at (MxPager *self,
+                         gint     index)
 {
-  MxPagerPrivate *priv = MX_PAGER (self)->priv;
-  GList *l, *new_page;
+  MxPagerPrivate *priv = self->priv;
+  MxPagerPage *page = PAGE (self, index);
 
-  l = g_list_find (priv->pages, child);
+  clutter_actor_destroy (page->button);
+  g_ptr_array_remove_index (priv->pages, index);
 
-  if (l == NULL)
-    return;
+  priv->previous_page = -1;
 
-  if (priv->current_page == l)
+  if (priv->current_page > index)
+    {
+      priv->current_page--;
+      g_object_notify (G_OBJECT (self), "page-num");
+      mx_pager_relayout_pages (self, TRUE);
+    }
+  else if (priv->current_page == index)
     {
       /* change the current page */
-      new_page = l->next;
+      priv->current_page = -1;
 
-      if (priv->current_page == NULL)
-        new_page = priv->pages;
+      if (priv->pages->len > 0)
+        mx_pager_change_page (self, MIN (index, (gint) priv->pages->len - 1),
+                              TRUE);
+      else
+        {
+          g_object_notify (G_OBJECT (self), "page-num");
+          g_object_notify (G_OBJECT (self), "page-actor");
+        }
     }
+}
+
+static void
+mx_pager_actor_removed (ClutterContainer *self,
+                        ClutterActor     *child)
+{
+  MxPagerPage *page;
+  gint index;
+
+  /* the actors of unloaded pages are already taken off their page */
+  page = g_object_get_data (G_OBJECT (child), "pager-page");
+  if (page == NULL || MX_PAGER (self)->priv->pages == NULL)
+    return;
 
-  clutter_actor_destroy (mx_pager_get_button_for_page ((MxPager *) self,
-                                                       child));
+  g_object_set_data (G_OBJECT (child), "pager-page", NULL);
+  _mx_actor_set_paint_from_snapshot (child, FALSE);
+  page->actor = NULL;
 
-  priv->pages = g_list_delete_link (priv->pages, l);
-  mx_pager_change_page ((MxPager *) self, new_page, TRUE);
+  index = mx_pager_find_page (MX_PAGER (self), page);
+  if (index >= 0)
+    mx_pager_remove_page_at (MX_PAGER (self), index);
 }
 
 static void
@@ -554,6 +752,60 @@ mx_pager_new (void)
   return g_object_new (MX_TYPE_PAGER, NULL);
 }
 
+static void
+mx_pager_insert_page_internal (MxPager      *self,
+                               ClutterActor *child,
+                               gint          position)
+{
+  MxPagerPrivate *priv = self->priv;
+  MxPagerPage *page;
+
+  if (position < 0 || position > (gint) priv->pages->len)
+    position = priv->pages->len;
+
+  page = g_slice_new0 (MxPagerPage);
+  page->actor = child;
+  page->lazy = (child == NULL);
+
+  g_ptr_array_add (priv->pages, page);
+  memmove (&priv->pages->pdata[position + 1], &priv->pages->pdata[position],
+           (priv->pages->len - 1 - position) * sizeof (gpointer));
+  priv->pages->pdata[position] = page;
+
+  if (child)
+    {
+      g_object_set_data (G_OBJECT (child), "pager-page", page);
+      mx_pager_add_internal_actor (self, child,
+          "fit", TRUE,
+          NULL);
+      clutter_actor_set_child_below_sibling ((ClutterActor *) self, child,
+                                             NULL);
+    }
+
+  mx_pager_add_page_button (self, page, position);
+
+  /* the current page stays the same */
+  if (priv->current_page >= position)
+    {
+      priv->current_page++;
+      g_object_notify (G_OBJECT (self), "page-num");
+    }
+  if (priv->previous_page >= position)
+    priv->previous_page++;
+
+  if (priv->current_page < 0)
+    mx_pager_change_page (self, position, FALSE);
+  else
+    {
+      if (mx_pager_is_page_kept (self, position))
+        mx_pager_realize_page (self, position);
+      else
+        mx_pager_unrealize_page (self, position);
+
+      mx_pager_relayout_pages (self, FALSE);
+    }
+}
+
 /**
  * mx_pager_insert_page:
  * @self: a #MxPager
@@ -569,20 +821,142 @@ mx_pager_insert_page (MxPager      *self,
                       gint          position)
 {
   g_return_if_fail (MX_IS_PAGER (self));
+  g_return_if_fail (CLUTTER_IS_ACTOR (child));
 
-  self->priv->pages = g_list_insert (self->priv->pages, child, position);
+  mx_pager_insert_page_internal (self, child, position);
+}
 
-  mx_pager_add_internal_actor (self, child,
-      "fit", TRUE,
-      NULL);
-  clutter_actor_set_child_below_sibling ((ClutterActor *) self, child, NULL);
+/**
+ * mx_pager_insert_lazy_page:
+ * @self: a #MxPager
+ * @position: the position to insert the page. If this is negative, or is
+ *   larger than the number of pages, it will the last page
+ *
+ * Inserts a page whose actor is only created, by the function set with
+ * mx_pager_set_page_func(), when the page comes within
+ * #MxPager:cached-pages of the current page, and destroyed again when it
+ * is no longer.
+ *
+ * Since: 2.0
+ */
+void
+mx_pager_insert_lazy_page (MxPager *self,
+                           gint     position)
+{
+  g_return_if_fail (MX_IS_PAGER (self));
+
+  mx_pager_insert_page_internal (self, NULL, position);
+}
+
+/**
+ * mx_pager_remove_page:
+ * @self: a #MxPager
+ * @page: a page number
+ *
+ * Removes @page from the #MxPager. The actor of a lazy page is destroyed;
+ * that of another page is removed from the pager.
+ *
+ * Since: 2.0
+ */
+void
+mx_pager_remove_page (MxPager *self,
+                      guint    page)
+{
+  ClutterActor *actor;
+
+  g_return_if_fail (MX_IS_PAGER (self));
+  g_return_if_fail (page < self->priv->pages->len);
 
-  mx_pager_add_page_button (self, child);
+  actor = PAGE (self, page)->actor;
 
-  if (self->priv->current_page == NULL)
-    mx_pager_change_page (self, self->priv->pages, FALSE);
+  /* removing the actor removes the page */
+  if (actor && PAGE (self, page)->lazy)
+    clutter_actor_destroy (actor);
+  else if (actor)
+    clutter_actor_remove_child (CLUTTER_ACTOR (self), actor);
   else
-    mx_pager_relayout_pages (self, FALSE);
+    mx_pager_remove_page_at (self, page);
+}
+
+/**
+ * mx_pager_set_page_func:
+ * @self: a #MxPager
+ * @func: (allow-none): a function to create the actors of lazy pages
+ * @user_data: data to pass to @func
+ * @notify: a function to free @user_data, or %NULL
+ *
+ * Sets the function that creates the actors of the pages inserted with
+ * mx_pager_insert_lazy_page(). The pages that need an actor are realized
+ * with it straight away.
+ *
+ * Since: 2.0
+ */
+void
+mx_pager_set_page_func (MxPager         *self,
+                        MxPagerPageFunc  func,
+                        gpointer         user_data,
+                        GDestroyNotify   notify)
+{
+  MxPagerPrivate *priv;
+
+  g_return_if_fail (MX_IS_PAGER (self));
+
+  priv = self->priv;
+
+  if (priv->page_notify)
+    priv->page_notify (priv->page_data);
+
+  priv->page_func = func;
+  priv->page_data = user_data;
+  priv->page_notify = notify;
+
+  mx_pager_update_pages (self);
+  mx_pager_relayout_pages (self, FALSE);
+}
+
+/**
+ * mx_pager_set_cached_pages:
+ * @self: a #MxPager
+ * @cached_pages: the number of pages to keep either side of the current
+ *   one, or -1 to keep all of them
+ *
+ * Sets the #MxPager:cached-pages property. The actors of lazy pages
+ * further from the current page are destroyed, and those of other pages
+ * hidden, until the page is within reach again.
+ *
+ * Since: 2.0
+ */
+void
+mx_pager_set_cached_pages (MxPager *self,
+                           gint     cached_pages)
+{
+  g_return_if_fail (MX_IS_PAGER (self));
+  g_return_if_fail (cached_pages >= -1);
+
+  if (self->priv->cached_pages == cached_pages)
+    return;
+
+  self->priv->cached_pages = cached_pages;
+  mx_pager_update_pages (self);
+  mx_pager_relayout_pages (self, FALSE);
+
+  g_object_notify (G_OBJECT (self), "cached-pages");
+}
+
+/**
+ * mx_pager_get_cached_pages:
+ * @self: a #MxPager
+ *
+ * Returns: the value of the #MxPager:cached-pages property
+ *
+ * Since: 2.0
+ */
+gint
+mx_pager_get_cached_pages (MxPager *self)
+{
+  g_return_val_if_fail (MX_IS_PAGER (self), -1);
+
+  return self->priv->cached_pages;
 }
 
 /**
@@ -595,12 +969,12 @@ void
 mx_pager_next (MxPager *self)
 {
   g_return_if_fail (MX_IS_PAGER (self));
-  g_return_if_fail (self->priv->current_page != NULL);
+  g_return_if_fail (self->priv->current_page >= 0);
 
-  if (self->priv->current_page->next == NULL)
+  if (self->priv->current_page + 1 >= (gint) self->priv->pages->len)
     return;
 
-  mx_pager_change_page (self, self->priv->current_page->next, TRUE);
+  mx_pager_change_page (self, self->priv->current_page + 1, TRUE);
 }
 
 /**
@@ -613,12 +987,12 @@ void
 mx_pager_previous (MxPager *self)
 {
   g_return_if_fail (MX_IS_PAGER (self));
-  g_return_if_fail (self->priv->current_page != NULL);
+  g_return_if_fail (self->priv->current_page >= 0);
 
-  if (self->priv->current_page->prev == NULL)
+  if (self->priv->current_page == 0)
     return;
 
-  mx_pager_change_page (self, self->priv->current_page->prev, TRUE);
+  mx_pager_change_page (self, self->priv->current_page - 1, TRUE);
 }
 
 /**
@@ -634,15 +1008,10 @@ mx_pager_set_current_page (MxPager *self,
                            guint    page,
                            gboolean animate)
 {
-  GList *page_l;
-
   g_return_if_fail (MX_IS_PAGER (self));
+  g_return_if_fail (page < self->priv->pages->len);
 
-  page_l = g_list_nth (self->priv->pages, page);
-
-  g_return_if_fail (page_l != NULL);
-
-  mx_pager_change_page (self, page_l, animate);
+  mx_pager_change_page (self, page, animate);
 }
 
 /**
@@ -654,15 +1023,10 @@ mx_pager_set_current_page (MxPager *self,
 guint
 mx_pager_get_current_page (MxPager *self)
 {
-  int pos;
-
   g_return_val_if_fail (MX_IS_PAGER (self), 0);
+  g_return_val_if_fail (self->priv->current_page >= 0, 0);
 
-  pos = g_list_position (self->priv->pages, self->priv->current_page);
-
-  g_return_val_if_fail (pos >= 0, 0);
-
-  return pos;
+  return self->priv->current_page;
 }
 
 /**
@@ -678,15 +1042,17 @@ mx_pager_set_current_page_by_actor (MxPager      *self,
                                     ClutterActor *actor,
                                     gboolean      animate)
 {
-  GList *page_l;
+  gint page;
 
   g_return_if_fail (MX_IS_PAGER (self));
+  g_return_if_fail (CLUTTER_IS_ACTOR (actor));
 
-  page_l = g_list_find (self->priv->pages, actor);
+  page = mx_pager_find_page (self, g_object_get_data (G_OBJECT (actor),
+                                                      "pager-page"));
 
-  g_return_if_fail (page_l != NULL);
+  g_return_if_fail (page >= 0);
 
-  mx_pager_change_page (self, page_l, animate);
+  mx_pager_change_page (self, page, animate);
 }
 
 /**
@@ -700,7 +1066,10 @@ mx_pager_get_current_page_actor (MxPager *self)
 {
   g_return_val_if_fail (MX_IS_PAGER (self), NULL);
 
-  return CLUTTER_ACTOR (self->priv->current_page->data);
+  if (self->priv->current_page < 0)
+    return NULL;
+
+  return PAGE (self, self->priv->current_page)->actor;
 }
 
 /**
@@ -708,6 +1077,9 @@ mx_pager_get_current_page_actor (MxPager *self)
  * @self: a #MxPager
  * @page: a page number
  *
+ * Gets the actor of @page. The actor of a lazy page that isn't realized
+ * is created for this, but may be destroyed at the next page change.
+ *
  * Returns: (transfer none): the #ClutterActor for @page
  */
 ClutterActor *
@@ -716,7 +1088,16 @@ mx_pager_get_actor_for_page (MxPager *self,
 {
   g_return_val_if_fail (MX_IS_PAGER (self), NULL);
 
-  return CLUTTER_ACTOR (g_list_nth_data (self->priv->pages, page));
+  if (page >= self->priv->pages->len)
+    return NULL;
+
+  if (!PAGE (self, page)->actor)
+    {
+      mx_pager_realize_page (self, page);
+      mx_pager_relayout_pages (self, FALSE);
+    }
+
+  return PAGE (self, page)->actor;
 }
 
 /**
@@ -730,7 +1111,7 @@ mx_pager_get_n_pages (MxPager *self)
 {
   g_return_val_if_fail (MX_IS_PAGER (self), 0);
 
-  return g_list_length (self->priv->pages);
+  return self->priv->pages->len;
 }
 
 /**
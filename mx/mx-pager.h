@@ -38,6 +38,22 @@ typedef struct _MxPager MxPager;
 typedef struct _MxPagerClass MxPagerClass;
 typedef struct _MxPagerPrivate MxPagerPrivate;
 
+/**
+ * MxPagerPageFunc:
+ * @pager: the #MxPager
+ * @page: the number of the page to create
+ * @user_data: the data passed to mx_pager_set_page_func()
+ *
+ * Creates the actor of a page inserted with mx_pager_insert_lazy_page().
+ *
+ * Returns: (transfer full): a new #ClutterActor, or %NULL
+ *
+ * Since: 2.0
+ */
+typedef ClutterActor *(*MxPagerPageFunc) (MxPager  *pager,
+                                          guint     page,
+                                          gpointer  user_data);
+
 struct _MxPager
 {
   /*< private >*/
@@ -63,6 +79,13 @@ GType mx_pager_get_type (void);
 ClutterActor *mx_pager_new (void);
 
 void mx_pager_insert_page (MxPager *self, ClutterActor *child, gint position);
+void mx_pager_insert_lazy_page (MxPager *self, gint position);
+void mx_pager_remove_page (MxPager *self, guint page);
+
+void mx_pager_set_page_func (MxPager *self, MxPagerPageFunc func,
+    gpointer user_data, GDestroyNotify notify);
+void mx_pager_set_cached_pages (MxPager *self, gint cached_pages);
+gint mx_pager_get_cached_pages (MxPager *self);
 
 void mx_pager_next (MxPager *self);
 void mx_pager_previous (MxPager *self);
@@ -25,6 +25,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "mx-path-bar.h"
 #include "mx-path-bar-button.h"
 #include "mx-stylable.h"
@@ -56,7 +58,9 @@ G_DEFINE_TYPE_WITH_CODE (MxPathBar, mx_path_bar, MX_TYPE_WIDGET,
 
 struct _MxPathBarPrivate
 {
-  GList        *crumbs;
+  /* the buttons of the levels, followed by those of popped levels that
+   * are still animating out */
+  GPtrArray    *crumbs;
   gint          current_level;
   gint          overlap;
 
@@ -102,11 +106,11 @@ mx_path_bar_accept_focus (MxFocusable *focusable, MxFocusHint hint)
             focus_widget = MX_FOCUSABLE (priv->entry);
           else
             focus_widget =
-              MX_FOCUSABLE (g_list_nth_data (priv->crumbs,
-                                             priv->current_level - 1));
+              MX_FOCUSABLE (g_ptr_array_index (priv->crumbs,
+                                               priv->current_level - 1));
         }
       else
-        focus_widget = MX_FOCUSABLE (priv->crumbs->data);
+        focus_widget = MX_FOCUSABLE (g_ptr_array_index (priv->crumbs, 0));
     }
   else
     focus_widget = MX_FOCUSABLE (priv->entry);
@@ -119,9 +123,8 @@ mx_path_bar_move_focus (MxFocusable      *focusable,
                         MxFocusDirection  direction,
                         MxFocusable      *from)
 {
-  gint i;
-  GList *c, *last;
-  MxFocusable *focus_widget;
+  guint i;
+  MxFocusable *focus_widget, *last;
   MxPathBarPrivate *priv = MX_PATH_BAR (focusable)->priv;
 
   if (direction == MX_FOCUS_DIRECTION_UP ||
@@ -131,11 +134,9 @@ mx_path_bar_move_focus (MxFocusable      *focusable,
 
   last = NULL;
   focus_widget = NULL;
-  for (i = 0, c = priv->crumbs;
-       c && (i < priv->current_level);
-       c = c->next, i++)
+  for (i = 0; i < priv->crumbs->len && i < (guint) priv->current_level; i++)
     {
-      MxFocusable *crumb = c->data;
+      MxFocusable *crumb = g_ptr_array_index (priv->crumbs, i);
 
       if (crumb == from)
         {
@@ -145,13 +146,13 @@ mx_path_bar_move_focus (MxFocusable      *focusable,
             case MX_FOCUS_DIRECTION_PREVIOUS:
               if (!last)
                 return NULL;
-              focus_widget = (MxFocusable *)last->data;
+              focus_widget = last;
               break;
 
             case MX_FOCUS_DIRECTION_RIGHT:
             case MX_FOCUS_DIRECTION_NEXT:
-              if (c->next)
-                focus_widget = (MxFocusable *)c->next->data;
+              if (i + 1 < priv->crumbs->len)
+                focus_widget = g_ptr_array_index (priv->crumbs, i + 1);
               else if (priv->editable)
                 focus_widget = (MxFocusable *)priv->entry;
               else
@@ -162,7 +163,7 @@ mx_path_bar_move_focus (MxFocusable      *focusable,
               return NULL;
             }
         }
-      last = c;
+      last = crumb;
     }
 
   if (from == (MxFocusable *)priv->entry)
@@ -174,7 +175,7 @@ mx_path_bar_move_focus (MxFocusable      *focusable,
           if (!last)
             return NULL;
           else
-            focus_widget = (MxFocusable *)last->data;
+            focus_widget = last;
           break;
 
         default:
@@ -205,7 +206,7 @@ mx_path_bar_style_changed_cb (MxWidget *self, MxStyleChangedFlags flags)
 {
   MxPathBarPrivate *priv = MX_PATH_BAR (self)->priv;
   gint overlap;
-  GList *c;
+  guint i;
 
   mx_stylable_get (MX_STYLABLE (self),
                    "x-mx-overlap", &overlap,
@@ -218,8 +219,9 @@ mx_path_bar_style_changed_cb (MxWidget *self, MxStyleChangedFlags flags)
     }
 
   /* Inform our private children */
-  for (c = priv->crumbs; c; c = c->next)
-    mx_stylable_style_changed (MX_STYLABLE (c->data), flags);
+  for (i = 0; i < priv->crumbs->len; i++)
+    mx_stylable_style_changed (MX_STYLABLE (g_ptr_array_index (priv->crumbs,
+                                                               i)), flags);
 
   if (priv->entry)
     mx_stylable_style_changed (MX_STYLABLE (priv->entry), flags);
@@ -282,6 +284,10 @@ mx_path_bar_set_property (GObject      *object,
 static void
 mx_path_bar_finalize (GObject *object)
 {
+  MxPathBarPrivate *priv = MX_PATH_BAR (object)->priv;
+
+  g_ptr_array_free (priv->crumbs, TRUE);
+
   G_OBJECT_CLASS (mx_path_bar_parent_class)->finalize (object);
 }
 
@@ -291,17 +297,17 @@ mx_path_bar_get_preferred_width (ClutterActor *actor,
                                  gfloat       *min_width_p,
                                  gfloat       *nat_width_p)
 {
-  GList *c;
+  guint i;
   MxPadding padding;
   gfloat min_width, nat_width;
 
   MxPathBarPrivate *priv = MX_PATH_BAR (actor)->priv;
 
   min_width = nat_width = 0;
-  for (c = priv->crumbs; c; c = c->next)
+  for (i = 0; i < priv->crumbs->len; i++)
     {
       gfloat cmin_width, cnat_width;
-      ClutterActor *crumb = c->data;
+      ClutterActor *crumb = g_ptr_array_index (priv->crumbs, i);
       ClutterTimeline *timeline;
 
       clutter_actor_get_preferred_width (crumb,
@@ -319,7 +325,7 @@ mx_path_bar_get_preferred_width (ClutterActor *actor,
       min_width += cmin_width;
       nat_width += cnat_width;
 
-      if (c != priv->crumbs)
+      if (i > 0)
         {
           min_width -= MIN (priv->overlap, cmin_width);
           nat_width -= MIN (priv->overlap, cnat_width);
@@ -338,7 +344,7 @@ mx_path_bar_get_preferred_width (ClutterActor *actor,
       min_width += emin_width;
       nat_width += enat_width;
 
-      if (priv->crumbs)
+      if (priv->crumbs->len)
         {
           min_width -= MIN (min_width, priv->overlap);
           nat_width -= MIN (nat_width, priv->overlap);
@@ -359,17 +365,17 @@ mx_path_bar_get_preferred_height (ClutterActor *actor,
                                   gfloat       *min_height_p,
                                   gfloat       *nat_height_p)
 {
-  GList *c;
+  guint i;
   MxPadding padding;
   gfloat min_height, nat_height;
 
   MxPathBarPrivate *priv = MX_PATH_BAR (actor)->priv;
 
   min_height = nat_height = 0;
-  for (c = priv->crumbs; c; c = c->next)
+  for (i = 0; i < priv->crumbs->len; i++)
     {
       gfloat cmin_height, cnat_height;
-      ClutterActor *crumb = c->data;
+      ClutterActor *crumb = g_ptr_array_index (priv->crumbs, i);
 
       clutter_actor_get_preferred_height (crumb,
                                           -1,
@@ -412,7 +418,7 @@ mx_path_bar_allocate (ClutterActor           *actor,
                       const ClutterActorBox  *box,
                       ClutterAllocationFlags  flags)
 {
-  GList *c;
+  guint i;
   gint n_crumbs;
   MxPadding padding;
   gboolean allocate_pref;
@@ -454,11 +460,11 @@ mx_path_bar_allocate (ClutterActor           *actor,
     }
 
   /* Allocate crumbs */
-  n_crumbs = g_list_length (priv->crumbs);
-  for (c = priv->crumbs; c; c = c->next)
+  n_crumbs = priv->crumbs->len;
+  for (i = 0; i < priv->crumbs->len; i++)
     {
       gfloat cmin_width, cnat_width;
-      ClutterActor *crumb = c->data;
+      ClutterActor *crumb = g_ptr_array_index (priv->crumbs, i);
       ClutterTimeline *timeline;
 
       clutter_actor_get_preferred_width (crumb,
@@ -491,7 +497,7 @@ mx_path_bar_allocate (ClutterActor           *actor,
         child_box.x2 = child_box.x1 + cnat_width;
 
       /* If this is the last crumb, give it all extra space */
-      if (!priv->entry && !c->next &&
+      if (!priv->entry && i + 1 == priv->crumbs->len &&
           (box->x2 - box->x1 - padding.right) > (child_box.x2 - child_box.x1))
         child_box.x2 = box->x2 - box->x1 - padding.right;
 
@@ -511,7 +517,7 @@ mx_path_bar_allocate (ClutterActor           *actor,
 static void
 mx_path_bar_paint (ClutterActor *actor)
 {
-  GList *c;
+  guint i;
   MxPathBarPrivate *priv = MX_PATH_BAR (actor)->priv;
 
   CLUTTER_ACTOR_CLASS (mx_path_bar_parent_class)->paint (actor);
@@ -519,8 +525,8 @@ mx_path_bar_paint (ClutterActor *actor)
   if (priv->entry)
     clutter_actor_paint (priv->entry);
 
-  for (c = g_list_last (priv->crumbs); c; c = c->prev)
-    clutter_actor_paint (CLUTTER_ACTOR (c->data));
+  for (i = priv->crumbs->len; i > 0; i--)
+    clutter_actor_paint (g_ptr_array_index (priv->crumbs, i - 1));
 }
 
 static void
@@ -582,6 +588,8 @@ mx_path_bar_init (MxPathBar *self)
 {
   self->priv = PATH_BAR_PRIVATE (self);
 
+  self->priv->crumbs = g_ptr_array_new ();
+
   g_signal_connect (self, "style-changed",
                     G_CALLBACK (mx_path_bar_style_changed_cb), NULL);
 }
@@ -596,31 +604,29 @@ static void
 mx_path_bar_crumb_clicked_cb (ClutterActor *crumb,
                               MxPathBar    *self)
 {
-  gint i;
-  GList *c;
+  gint level;
 
   MxPathBarPrivate *priv = self->priv;
 
   if (priv->clear_on_change)
     mx_path_bar_set_text (self, "");
 
-  for (c = priv->crumbs, i = 1; c; c = c->next, i++)
-    {
-      if (c->data == crumb)
-        {
-          while (priv->current_level > i)
-            mx_path_bar_pop (self);
-          break;
-        }
-    }
+  /* popped crumbs are no longer connected, so this is a current level */
+  level = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (crumb),
+                                              "mx-path-bar-level"));
+
+  while (priv->current_level > level)
+    mx_path_bar_pop (self);
 }
 
 static void
 mx_path_bar_reset_last_crumb (MxPathBar *bar)
 {
   MxPathBarPrivate *priv = bar->priv;
-  ClutterActor *last_crumb =
-    g_list_nth_data (priv->crumbs, priv->current_level -1);
+  ClutterActor *last_crumb = NULL;
+
+  if (priv->current_level)
+    last_crumb = g_ptr_array_index (priv->crumbs, priv->current_level - 1);
 
   if (last_crumb)
     mx_stylable_set_style_class (MX_STYLABLE (last_crumb),
@@ -639,7 +645,7 @@ mx_path_bar_button_animation_stopped (ClutterTimeline *timeline,
   if (clutter_timeline_get_direction (timeline) == CLUTTER_TIMELINE_BACKWARD)
     {
       MxPathBarPrivate *priv = MX_PATH_BAR (clutter_actor_get_parent (CLUTTER_ACTOR (button)))->priv;
-      priv->crumbs = g_list_remove (priv->crumbs, button);
+      g_ptr_array_remove (priv->crumbs, button);
       clutter_actor_destroy (CLUTTER_ACTOR (button));
     }
 }
@@ -696,14 +702,19 @@ mx_path_bar_push (MxPathBar *bar, const gchar *name)
   crumb = mx_path_bar_button_new (name);
   clutter_actor_add_child (CLUTTER_ACTOR (bar), crumb);
 
-  priv->crumbs = g_list_insert (priv->crumbs, crumb, priv->current_level);
+  /* the new level goes before the crumbs still animating out */
+  g_ptr_array_add (priv->crumbs, crumb);
+  memmove (priv->crumbs->pdata + priv->current_level + 1,
+           priv->crumbs->pdata + priv->current_level,
+           (priv->crumbs->len - priv->current_level - 1) * sizeof (gpointer));
+  g_ptr_array_index (priv->crumbs, priv->current_level) = crumb;
 
   if (!priv->entry)
     {
       if (priv->current_level)
         {
           ClutterActor *old_last_crumb =
-            g_list_nth_data (priv->crumbs, priv->current_level - 1);
+            g_ptr_array_index (priv->crumbs, priv->current_level - 1);
 
           mx_stylable_set_style_class (MX_STYLABLE (old_last_crumb), NULL);
         }
@@ -713,6 +724,8 @@ mx_path_bar_push (MxPathBar *bar, const gchar *name)
 
   priv->current_level ++;
 
+  g_object_set_data (G_OBJECT (crumb), "mx-path-bar-level",
+                     GINT_TO_POINTER (priv->current_level));
   g_signal_connect (crumb, "clicked",
                     G_CALLBACK (mx_path_bar_crumb_clicked_cb), bar);
 
@@ -741,8 +754,10 @@ mx_path_bar_pop (MxPathBar *bar)
   if (priv->current_level == 0)
     return 0;
 
-  crumb = g_list_nth_data (priv->crumbs, priv->current_level - 1);
+  crumb = g_ptr_array_index (priv->crumbs, priv->current_level - 1);
 
+  g_signal_handlers_disconnect_by_func (crumb, mx_path_bar_crumb_clicked_cb,
+                                        bar);
   mx_path_bar_animate_button (bar, crumb, TRUE);
 
   priv->current_level --;
@@ -878,7 +893,7 @@ mx_path_bar_get_label (MxPathBar *bar, gint level)
                         NULL);
 
   priv = bar->priv;
-  crumb = (ClutterActor *)g_list_nth_data (priv->crumbs, level - 1);
+  crumb = g_ptr_array_index (priv->crumbs, level - 1);
 
   if (crumb)
     return mx_button_get_label (MX_BUTTON (crumb));
@@ -907,7 +922,7 @@ mx_path_bar_set_label (MxPathBar   *bar,
   g_return_if_fail ((level > 0) && (level <= bar->priv->current_level));
 
   priv = bar->priv;
-  crumb = (ClutterActor *)g_list_nth_data (priv->crumbs, level - 1);
+  crumb = g_ptr_array_index (priv->crumbs, level - 1);
 
   if (crumb)
     mx_button_set_label (MX_BUTTON (crumb), label);
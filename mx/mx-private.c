@@ -28,9 +28,28 @@ static GDebugKey debug_keys[] =
     {"layout", MX_DEBUG_LAYOUT},
     {"inspector", MX_DEBUG_INSPECTOR},
     {"focus", MX_DEBUG_FOCUS},
-    {"css", MX_DEBUG_CSS}
+    {"css", MX_DEBUG_CSS},
+    {"style-cache", MX_DEBUG_STYLE_CACHE},
+    {"css-profile", MX_DEBUG_CSS_PROFILE},
+    {"startup", MX_DEBUG_STARTUP},
+    {"redraws", MX_DEBUG_REDRAWS}
 };
 
+typedef struct
+{
+  const gchar *subsystem;
+  gint64       time;
+  guint        calls;
+} MxStartupTrace;
+
+/* the subsystems traced so far, in the order they were first seen, and
+ * when the first was */
+static GArray  *startup_traces = NULL;
+static gint64   startup_begin = 0;
+static gboolean startup_done = FALSE;
+
+static const gchar *redraw_reason = NULL;
+
 
 gboolean
 _mx_debug (gint check)
@@ -51,6 +70,113 @@ _mx_debug (gint check)
   return debug & check;
 }
 
+/* The reasons are only ever static strings, and only set from the main
+ * thread, so this costs a store when the redraws aren't debugged */
+const gchar *
+_mx_debug_redraw_reason_push (const gchar *reason)
+{
+  const gchar *previous = redraw_reason;
+
+  if (!redraw_reason)
+    redraw_reason = reason;
+
+  return previous;
+}
+
+void
+_mx_debug_redraw_reason_pop (const gchar *previous)
+{
+  redraw_reason = previous;
+}
+
+const gchar *
+_mx_debug_redraw_reason_get (void)
+{
+  return redraw_reason;
+}
+
+static gboolean
+mx_startup_trace_report (gpointer data)
+{
+  gint64 total = 0;
+  guint i;
+
+  startup_done = TRUE;
+
+  g_message ("[STARTUP] First frame painted %.1f ms after Mx started",
+             (g_get_monotonic_time () - startup_begin) / 1000.0);
+
+  for (i = 0; i < startup_traces->len; i++)
+    {
+      MxStartupTrace *trace = &g_array_index (startup_traces,
+                                              MxStartupTrace, i);
+
+      g_message ("[STARTUP] %-12s %8.1f ms in %u call%s",
+                 trace->subsystem, trace->time / 1000.0, trace->calls,
+                 trace->calls == 1 ? "" : "s");
+      total += trace->time;
+    }
+
+  g_message ("[STARTUP] %-12s %8.1f ms", "total", total / 1000.0);
+
+  g_array_free (startup_traces, TRUE);
+  startup_traces = NULL;
+
+  return FALSE;
+}
+
+/* Returns the time to pass to _mx_startup_trace_end(), or 0 when the
+ * startup isn't traced */
+gint64
+_mx_startup_trace_begin (void)
+{
+  if (G_LIKELY (startup_done || !_mx_debug (MX_DEBUG_STARTUP)))
+    return 0;
+
+  if (!startup_traces)
+    {
+      startup_traces = g_array_new (FALSE, FALSE, sizeof (MxStartupTrace));
+      startup_begin = g_get_monotonic_time ();
+
+      clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                             mx_startup_trace_report,
+                                             NULL, NULL);
+    }
+
+  return g_get_monotonic_time ();
+}
+
+/* Adds the time since @start to what @subsystem, a static string, took */
+void
+_mx_startup_trace_end (const gchar *subsystem,
+                       gint64       start)
+{
+  MxStartupTrace *trace, new_trace;
+  guint i;
+
+  if (G_LIKELY (!start || !startup_traces))
+    return;
+
+  for (i = 0; i < startup_traces->len; i++)
+    {
+      trace = &g_array_index (startup_traces, MxStartupTrace, i);
+      if (g_str_equal (trace->subsystem, subsystem))
+        break;
+    }
+
+  if (i == startup_traces->len)
+    {
+      new_trace.subsystem = subsystem;
+      new_trace.time = 0;
+      new_trace.calls = 0;
+      g_array_append_val (startup_traces, new_trace);
+    }
+
+  trace = &g_array_index (startup_traces, MxStartupTrace, i);
+  trace->time += g_get_monotonic_time () - start;
+  trace->calls ++;
+}
+
 const gchar *
 _mx_enum_to_string (GType type,
                     gint  value)
@@ -122,3 +248,559 @@ _mx_paint_texture_with_opacity (CoglHandle texture,
 
   cogl_handle_unref (material);
 }
+
+/* Renders @area of what @render_func paints, in the coordinates it paints
+ * in, to a new texture. Actors painted by it should be painted with
+ * clutter_actor_paint(), which applies their transformation, so that an
+ * actor paints its children in its own coordinates. Returns
+ * %COGL_INVALID_HANDLE if the texture could not be rendered. */
+CoglHandle
+_mx_render_to_texture (const ClutterActorBox *area,
+                       MxRenderFunc           render_func,
+                       gpointer               user_data)
+{
+  CoglHandle texture, offscreen;
+  CoglColor transparent;
+  CoglMatrix matrix;
+  gint width, height;
+
+  width = (gint) (area->x2 - area->x1 + 0.5f);
+  height = (gint) (area->y2 - area->y1 + 0.5f);
+  if (width < 1 || height < 1)
+    return COGL_INVALID_HANDLE;
+
+  texture = cogl_texture_new_with_size (width, height,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  if (texture == COGL_INVALID_HANDLE)
+    return COGL_INVALID_HANDLE;
+
+  offscreen = cogl_offscreen_new_to_texture (texture);
+  if (offscreen == COGL_INVALID_HANDLE)
+    {
+      cogl_handle_unref (texture);
+      return COGL_INVALID_HANDLE;
+    }
+
+  cogl_push_framebuffer (offscreen);
+  cogl_ortho (0, width, height, 0, -1, 1);
+
+  cogl_matrix_init_identity (&matrix);
+  cogl_matrix_translate (&matrix, -area->x1, -area->y1, 0);
+  cogl_set_modelview_matrix (&matrix);
+
+  cogl_color_set_from_4ub (&transparent, 0, 0, 0, 0);
+  cogl_clear (&transparent, COGL_BUFFER_BIT_COLOR);
+
+  render_func (user_data);
+
+  cogl_pop_framebuffer ();
+  cogl_handle_unref (offscreen);
+
+  return texture;
+}
+
+/* An actor painted from a snapshot of itself, see
+ * _mx_actor_set_paint_from_snapshot() */
+typedef struct
+{
+  CoglHandle texture;
+  gfloat     width;
+  gfloat     height;
+
+  gulong     paint_id;
+  gulong     queue_redraw_id;
+} MxActorSnapshot;
+
+static GQuark
+_mx_actor_snapshot_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (G_UNLIKELY (!quark))
+    quark = g_quark_from_static_string ("mx-actor-snapshot");
+
+  return quark;
+}
+
+static void
+_mx_actor_snapshot_clear (MxActorSnapshot *snapshot)
+{
+  if (snapshot->texture)
+    {
+      cogl_handle_unref (snapshot->texture);
+      snapshot->texture = NULL;
+    }
+}
+
+static void
+_mx_actor_snapshot_free (MxActorSnapshot *snapshot)
+{
+  _mx_actor_snapshot_clear (snapshot);
+  g_slice_free (MxActorSnapshot, snapshot);
+}
+
+static void
+_mx_actor_snapshot_render (gpointer user_data)
+{
+  ClutterActor *actor = user_data;
+
+  CLUTTER_ACTOR_GET_CLASS (actor)->paint (actor);
+}
+
+/* The snapshot is rendered in the coordinates of the actor, and painted
+ * with whatever transformation it has at the time */
+static void
+_mx_actor_snapshot_paint_cb (ClutterActor    *actor,
+                             MxActorSnapshot *snapshot)
+{
+  ClutterActorBox area;
+  gfloat width, height;
+
+  clutter_actor_get_size (actor, &width, &height);
+
+  if (snapshot->width != width || snapshot->height != height)
+    _mx_actor_snapshot_clear (snapshot);
+
+  if (!snapshot->texture)
+    {
+      area.x1 = 0;
+      area.y1 = 0;
+      area.x2 = width;
+      area.y2 = height;
+
+      snapshot->texture = _mx_render_to_texture (&area,
+                                                 _mx_actor_snapshot_render,
+                                                 actor);
+      snapshot->width = width;
+      snapshot->height = height;
+
+      /* paint the actor itself */
+      if (!snapshot->texture)
+        return;
+    }
+
+  _mx_paint_texture_with_opacity (snapshot->texture, 0xff,
+                                  0, 0, width, height);
+
+  g_signal_stop_emission_by_name (actor, "paint");
+}
+
+/* The redraws an actor queues on itself while it is moved don't change
+ * what it paints */
+static gboolean
+_mx_actor_is_moving (ClutterActor *actor)
+{
+  static const gchar *properties[] = {
+    "pivot-point", "translation-x", "translation-y", "x", "y"
+  };
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (properties); i++)
+    if (clutter_actor_get_transition (actor, properties[i]))
+      return TRUE;
+
+  return FALSE;
+}
+
+static void
+_mx_actor_snapshot_queue_redraw_cb (ClutterActor    *actor,
+                                    ClutterActor    *origin,
+                                    MxActorSnapshot *snapshot)
+{
+  if (origin == actor && _mx_actor_is_moving (actor))
+    return;
+
+  _mx_actor_snapshot_clear (snapshot);
+}
+
+/* Paints @actor from a texture of what it painted, while @snapshot is set.
+ * The texture is rendered again when the actor or one of its descendants
+ * queues a redraw, or when it changes size. */
+void
+_mx_actor_set_paint_from_snapshot (ClutterActor *actor,
+                                   gboolean      snapshot)
+{
+  GQuark quark = _mx_actor_snapshot_quark ();
+  MxActorSnapshot *data;
+
+  data = g_object_get_qdata (G_OBJECT (actor), quark);
+
+  if (snapshot && !data)
+    {
+      data = g_slice_new0 (MxActorSnapshot);
+      data->paint_id =
+        g_signal_connect (actor, "paint",
+                          G_CALLBACK (_mx_actor_snapshot_paint_cb), data);
+      data->queue_redraw_id =
+        g_signal_connect (actor, "queue-redraw",
+                          G_CALLBACK (_mx_actor_snapshot_queue_redraw_cb),
+                          data);
+
+      g_object_set_qdata_full (G_OBJECT (actor), quark, data,
+                               (GDestroyNotify) _mx_actor_snapshot_free);
+    }
+  else if (!snapshot && data)
+    {
+      g_signal_handler_disconnect (actor, data->paint_id);
+      g_signal_handler_disconnect (actor, data->queue_redraw_id);
+
+      g_object_set_qdata (G_OBJECT (actor), quark, NULL);
+      clutter_actor_queue_redraw (actor);
+    }
+}
+
+static void
+_mx_item_attribute_resolve (MxItemAttribute *attr,
+                            GType            item_type)
+{
+  GObjectClass *klass;
+  GParamSpec *pspec;
+
+  attr->item_type = item_type;
+  attr->pspec = NULL;
+
+  klass = g_type_class_ref (item_type);
+  pspec = g_object_class_find_property (klass, attr->name);
+  g_type_class_unref (klass);
+
+  /* anything else is left to g_object_set_property() to warn about */
+  if (pspec && (pspec->flags & G_PARAM_WRITABLE) &&
+      !(pspec->flags & G_PARAM_CONSTRUCT_ONLY))
+    attr->pspec = pspec;
+}
+
+MxItemAttribute *
+_mx_item_attribute_new (const gchar *name,
+                        gint         col,
+                        GType        item_type)
+{
+  MxItemAttribute *attr;
+
+  attr = g_slice_new0 (MxItemAttribute);
+  attr->name = g_strdup (name);
+  attr->col = col;
+
+  if (item_type)
+    _mx_item_attribute_resolve (attr, item_type);
+
+  return attr;
+}
+
+void
+_mx_item_attribute_free (MxItemAttribute *attr)
+{
+  g_free (attr->name);
+  g_slice_free (MxItemAttribute, attr);
+}
+
+/* Sets the properties of @item that are bound to the values of the row at
+ * @iter, leaving alone the ones that already have the value so that they
+ * aren't notified. The properties aren't set through their class directly
+ * as an overridden property would then be set on the wrong class. */
+void
+_mx_item_attributes_set (GSList           *attributes,
+                         GObject          *item,
+                         ClutterModelIter *iter)
+{
+  GSList *p;
+
+  g_object_freeze_notify (item);
+  for (p = attributes; p; p = p->next)
+    {
+      MxItemAttribute *attr = p->data;
+      GValue value = { 0, };
+      GValue converted = { 0, };
+      GValue current = { 0, };
+      GValue *new_value;
+      GParamSpec *pspec;
+
+      clutter_model_iter_get_value (iter, attr->col, &value);
+      new_value = &value;
+
+      if (attr->item_type != G_OBJECT_TYPE (item))
+        _mx_item_attribute_resolve (attr, G_OBJECT_TYPE (item));
+
+      pspec = attr->pspec;
+      if (pspec && (pspec->flags & G_PARAM_READABLE))
+        {
+          if (G_VALUE_TYPE (&value) != pspec->value_type)
+            {
+              g_value_init (&converted, pspec->value_type);
+              if (g_value_transform (&value, &converted))
+                new_value = &converted;
+              else
+                pspec = NULL;
+            }
+
+          if (pspec)
+            {
+              g_param_value_validate (pspec, new_value);
+
+              g_value_init (&current, pspec->value_type);
+              g_object_get_property (item, pspec->name, &current);
+            }
+        }
+
+      if (!G_IS_VALUE (&current) ||
+          g_param_values_cmp (pspec, new_value, &current) != 0)
+        g_object_set_property (item, attr->name, new_value);
+
+      if (G_IS_VALUE (&current))
+        g_value_unset (&current);
+      if (G_IS_VALUE (&converted))
+        g_value_unset (&converted);
+      g_value_unset (&value);
+    }
+  g_object_thaw_notify (item);
+}
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+/* Sets the item at @position of @model on the @property of @item, for the
+ * views driven by a list model */
+void
+_mx_item_set_list_item (GObject     *item,
+                        const gchar *property,
+                        GListModel  *model,
+                        guint        position)
+{
+  gpointer list_item;
+
+  if (!property)
+    return;
+
+  list_item = g_list_model_get_item (model, position);
+  g_object_set (item, property, list_item, NULL);
+
+  if (list_item)
+    g_object_unref (list_item);
+}
+#endif
+
+/* The key of a row, by which its item is found again when the model is
+ * sorted or filtered: strings and numbers stand for their values, objects
+ * and pointers for their addresses */
+static gchar *
+_mx_item_get_row_key (ClutterModelIter *iter,
+                      gint              column)
+{
+  GValue value = { 0, };
+  GValue string = { 0, };
+  gchar *key = NULL;
+
+  clutter_model_iter_get_value (iter, column, &value);
+
+  if (G_VALUE_HOLDS_STRING (&value))
+    key = g_value_dup_string (&value);
+  else if (G_VALUE_HOLDS_OBJECT (&value) || G_VALUE_HOLDS_POINTER (&value) ||
+           G_VALUE_HOLDS_BOXED (&value))
+    key = g_strdup_printf ("%p", g_value_peek_pointer (&value));
+  else if (g_value_type_transformable (G_VALUE_TYPE (&value), G_TYPE_STRING))
+    {
+      g_value_init (&string, G_TYPE_STRING);
+      if (g_value_transform (&value, &string))
+        key = g_value_dup_string (&string);
+      g_value_unset (&string);
+    }
+
+  g_value_unset (&value);
+
+  return key;
+}
+
+/* Records the key of the row at @iter on @item */
+void
+_mx_item_set_key (GObject          *item,
+                  ClutterModelIter *iter,
+                  gint              column)
+{
+  g_object_set_data_full (item, "mx-item-key",
+                          _mx_item_get_row_key (iter, column), g_free);
+}
+
+/* Matches the children of @container to the rows of @model by the keys
+ * recorded with _mx_item_set_key(). Returns an array of the child of each
+ * row, in the order of the rows, with %NULL for the rows whose key no
+ * child has; the children that have no row are added to @unmatched, in
+ * their order. */
+GPtrArray *
+_mx_item_match_rows (ClutterActor *container,
+                     ClutterModel *model,
+                     gint          column,
+                     GQueue       *unmatched)
+{
+  GHashTable *children, *matched;
+  ClutterModelIter *iter;
+  ClutterActor *child;
+  GPtrArray *rows;
+
+  children = g_hash_table_new (g_str_hash, g_str_equal);
+  matched = g_hash_table_new (NULL, NULL);
+  rows = g_ptr_array_sized_new (clutter_model_get_n_rows (model));
+
+  /* if keys are repeated, the first child with the key is used */
+  for (child = clutter_actor_get_last_child (container); child;
+       child = clutter_actor_get_previous_sibling (child))
+    {
+      const gchar *key = g_object_get_data (G_OBJECT (child), "mx-item-key");
+
+      if (key)
+        g_hash_table_insert (children, (gpointer) key, child);
+    }
+
+  iter = clutter_model_get_first_iter (model);
+  for (; iter && !clutter_model_iter_is_last (iter);
+       clutter_model_iter_next (iter))
+    {
+      gchar *key = _mx_item_get_row_key (iter, column);
+
+      child = key ? g_hash_table_lookup (children, key) : NULL;
+      if (child)
+        {
+          g_hash_table_remove (children, key);
+          g_hash_table_add (matched, child);
+        }
+
+      g_ptr_array_add (rows, child);
+      g_free (key);
+    }
+
+  if (iter)
+    g_object_unref (iter);
+
+  for (child = clutter_actor_get_first_child (container); child;
+       child = clutter_actor_get_next_sibling (child))
+    if (!g_hash_table_contains (matched, child))
+      g_queue_push_tail (unmatched, child);
+
+  g_hash_table_destroy (children);
+  g_hash_table_destroy (matched);
+
+  return rows;
+}
+
+typedef struct
+{
+  GPtrArray *children;
+  gboolean   valid;
+} MxChildIndex;
+
+static void
+_mx_child_index_free (MxChildIndex *index)
+{
+  g_ptr_array_free (index->children, TRUE);
+  g_slice_free (MxChildIndex, index);
+}
+
+static void
+_mx_child_index_invalidate (ClutterContainer *container,
+                            ClutterActor     *child,
+                            MxChildIndex     *index)
+{
+  index->valid = FALSE;
+}
+
+/* Gets the child of @parent at @index_ from an array of its children, which
+ * is gathered again after children are added or removed, so that going
+ * through them by index doesn't walk the list each time. Children moved
+ * without being removed aren't noticed, so this is only for the item
+ * views, which never do that. */
+ClutterActor *
+_mx_actor_get_child_at_index (ClutterActor *parent,
+                              gint          index_)
+{
+  static GQuark quark = 0;
+  MxChildIndex *index;
+
+  if (G_UNLIKELY (!quark))
+    quark = g_quark_from_static_string ("mx-child-index");
+
+  /* asking past the end, as when children are being appended, doesn't
+   * need the array */
+  if (index_ < 0 || index_ >= clutter_actor_get_n_children (parent))
+    return NULL;
+
+  index = g_object_get_qdata (G_OBJECT (parent), quark);
+  if (!index)
+    {
+      index = g_slice_new0 (MxChildIndex);
+      index->children = g_ptr_array_new ();
+      g_object_set_qdata_full (G_OBJECT (parent), quark, index,
+                               (GDestroyNotify) _mx_child_index_free);
+
+      g_signal_connect (parent, "actor-added",
+                        G_CALLBACK (_mx_child_index_invalidate), index);
+      g_signal_connect (parent, "actor-removed",
+                        G_CALLBACK (_mx_child_index_invalidate), index);
+    }
+
+  if (!index->valid)
+    {
+      ClutterActor *child;
+
+      g_ptr_array_set_size (index->children, 0);
+      for (child = clutter_actor_get_first_child (parent); child;
+           child = clutter_actor_get_next_sibling (child))
+        g_ptr_array_add (index->children, child);
+
+      index->valid = TRUE;
+    }
+
+  return g_ptr_array_index (index->children, index_);
+}
+
+typedef struct
+{
+  ClutterActor     *child;
+  ClutterChildMeta *meta;
+} MxChildMetaEntry;
+
+static void
+_mx_child_metas_clear (ClutterContainer *container,
+                       ClutterActor     *actor,
+                       GArray           *metas)
+{
+  g_array_set_size (metas, 0);
+}
+
+/* Gets the child meta of @child, the child at @index_ of @container, from
+ * an array of the metas in the order of the children, so that layouts that
+ * go through the children in several passes don't look the meta of each
+ * one up in each pass. The metas are read directly, as their setters don't
+ * notify the container. The array is emptied when children are removed;
+ * a child found at another index is looked up again there. */
+ClutterChildMeta *
+_mx_container_get_child_meta_at (ClutterContainer *container,
+                                 ClutterActor     *child,
+                                 guint             index_)
+{
+  static GQuark quark = 0;
+  MxChildMetaEntry *entry;
+  GArray *metas;
+
+  if (G_UNLIKELY (!quark))
+    quark = g_quark_from_static_string ("mx-child-metas");
+
+  metas = g_object_get_qdata (G_OBJECT (container), quark);
+  if (!metas)
+    {
+      metas = g_array_new (FALSE, TRUE, sizeof (MxChildMetaEntry));
+      g_object_set_qdata_full (G_OBJECT (container), quark, metas,
+                               (GDestroyNotify) g_array_unref);
+
+      g_signal_connect (container, "actor-removed",
+                        G_CALLBACK (_mx_child_metas_clear), metas);
+    }
+
+  if (index_ >= metas->len)
+    g_array_set_size (metas, index_ + 1);
+
+  entry = &g_array_index (metas, MxChildMetaEntry, index_);
+  if (entry->child != child)
+    {
+      entry->child = child;
+      entry->meta = clutter_container_get_child_meta (container, child);
+    }
+
+  return entry->meta;
+}
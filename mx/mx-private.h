@@ -74,6 +74,7 @@ typedef enum
 ClutterActor *_mx_widget_get_dnd_clone (MxWidget *widget);
 
 void _mx_box_layout_start_animation (MxBoxLayout *box);
+void _mx_box_layout_invalidate_offsets (MxBoxLayout *box);
 
 /* used by MxTableChild to update row/column count */
 void _mx_table_update_row_col (MxTable      *table,
@@ -83,9 +84,82 @@ CoglHandle _mx_window_get_icon_cogl_texture (MxWindow *window);
 
 ClutterActor * _mx_window_get_resize_grip (MxWindow *window);
 
-void _mx_style_invalidate_cache (MxStylable *stylable);
+gint64 _mx_window_get_frame_interval (MxWindow *window);
+
+typedef enum
+{
+  MX_FRAME_STATS_STYLE,
+  MX_FRAME_STATS_ACTOR_MANAGER,
+  MX_FRAME_STATS_TEXTURE_UPLOAD,
+
+  MX_FRAME_STATS_N_TIMES
+} MxFrameStatsTime;
 
-gchar * _mx_stylable_get_style_string (MxStylable *stylable);
+typedef enum
+{
+  MX_FRAME_STATS_RESTYLED,
+  MX_FRAME_STATS_RELAYOUTS,
+  MX_FRAME_STATS_PAINTED
+} MxFrameStatsCount;
+
+gint64 _mx_frame_stats_begin (MxFrameStatsTime  time);
+void   _mx_frame_stats_end   (MxFrameStatsTime  time,
+                              gint64            start);
+void   _mx_frame_stats_count (MxFrameStatsCount count);
+
+/* the memory held by the default instance of each cache, for
+ * mx_get_memory_report(), and freeing it for mx_trim_memory() */
+void   _mx_memory_monitor_init            (void);
+gsize  _mx_style_get_memory_usage         (void);
+void   _mx_style_trim_memory              (MxMemoryTrimLevel level);
+gsize  _mx_texture_cache_get_memory_usage (void);
+void   _mx_texture_cache_trim_memory      (MxMemoryTrimLevel level);
+gsize  _mx_icon_theme_get_memory_usage    (void);
+void   _mx_icon_theme_trim_memory         (MxMemoryTrimLevel level);
+gsize  _mx_image_get_memory_usage         (void);
+
+ClutterActor * _mx_button_get_label (MxButton *button);
+
+void _mx_label_prefetch_text_sizes (ClutterActor *container);
+
+void _mx_style_invalidate_cache (MxStylable *stylable);
+void _mx_style_free_stylable_cache (gpointer cache);
+gboolean _mx_style_invalidate_cache_for_change (MxStylable *stylable);
+gboolean _mx_style_change_affects (MxStyle    *style,
+                                   MxStylable *stylable);
+const GValue *_mx_style_peek_property (MxStyle    *style,
+                                       MxStylable *stylable,
+                                       GParamSpec *pspec,
+                                       GValue     *scratch);
+gpointer _mx_style_lookup_computed (MxStylable     *stylable,
+                                    GQuark          quark);
+void     _mx_style_set_computed    (MxStylable     *stylable,
+                                    GQuark          quark,
+                                    gpointer        computed,
+                                    GDestroyNotify  destroy);
+
+/* set on pending style changes that have to be propagated to the children
+ * of the stylable, never emitted */
+#define MX_STYLE_CHANGED_CHILDREN (1 << 8)
+
+void    _mx_stylable_set_frozen (ClutterActor *actor,
+                                 gboolean      frozen);
+
+guint64 _mx_stylable_pseudo_class_to_mask (const gchar *pseudo_class,
+                                           gboolean    *complete);
+guint64 _mx_stylable_get_style_pseudo_class_mask (MxStylable *stylable);
+guint   _mx_stylable_get_font_settings_serial (void);
+void    _mx_stylable_get_default_value_for_pspec (GParamSpec *pspec,
+                                                  GValue     *value_out);
+gboolean _mx_stylable_get_default_font_value (const gchar *property_name,
+                                              GValue      *value);
+PangoFontDescription *_mx_stylable_get_font_description (const gchar  *family,
+                                                         gint          size,
+                                                         MxFontWeight  weight);
+
+gboolean       _mx_value_is_interned   (gconstpointer        value);
+MxBorderImage *_mx_border_image_intern (const MxBorderImage *border_image);
+MxPadding     *_mx_padding_intern      (const MxPadding     *padding);
 
 const gchar * _mx_enum_to_string (GType type,
                                   gint  value);
@@ -106,8 +180,109 @@ void _mx_paint_texture_with_opacity (CoglHandle texture,
                                      gfloat     width,
                                      gfloat     height);
 
+typedef void (* MxRenderFunc) (gpointer user_data);
+
+CoglHandle _mx_render_to_texture (const ClutterActorBox *area,
+                                  MxRenderFunc           render_func,
+                                  gpointer               user_data);
+
+void _mx_actor_set_paint_from_snapshot (ClutterActor *actor,
+                                        gboolean      snapshot);
+
+/* the scale factor a texture of the texture cache was loaded at */
+gint _mx_texture_cache_get_texture_scale (CoglHandle texture);
+
+typedef struct _MxTextureFrameCache MxTextureFrameCache;
+
+void _mx_texture_frame_paint_cached (MxTextureFrameCache **cache,
+                                     CoglHandle            texture,
+                                     guint8                opacity,
+                                     gfloat                top,
+                                     gfloat                right,
+                                     gfloat                bottom,
+                                     gfloat                left,
+                                     gfloat                width,
+                                     gfloat                height);
+void _mx_texture_frame_cache_free   (MxTextureFrameCache  *cache);
+gboolean _mx_texture_frame_get_rectangles (CoglHandle  texture,
+                                           gfloat      top,
+                                           gfloat      right,
+                                           gfloat      bottom,
+                                           gfloat      left,
+                                           gfloat      width,
+                                           gfloat      height,
+                                           float      *rectangles);
+
+typedef struct _MxBackgroundBatch MxBackgroundBatch;
+
+MxBackgroundBatch *_mx_background_batch_new   (void);
+void               _mx_background_batch_free  (MxBackgroundBatch *batch);
+gboolean           _mx_background_batch_add   (MxBackgroundBatch *batch,
+                                               ClutterActor      *container,
+                                               ClutterActor      *child);
+void               _mx_background_batch_paint (MxBackgroundBatch *batch);
+void               _mx_background_batch_end   (MxBackgroundBatch *batch);
+
 gboolean _mx_settings_get_touch_mode (MxSettings *settings);
 
+/* an attribute of MxItemView and MxListView, binding a model column to a
+ * property of the items; the property is looked up again only when the
+ * type of the item changes */
+typedef struct
+{
+  gchar      *name;
+  gint        col;
+
+  GType       item_type;
+  GParamSpec *pspec;
+} MxItemAttribute;
+
+MxItemAttribute *_mx_item_attribute_new  (const gchar      *name,
+                                          gint              col,
+                                          GType             item_type);
+void             _mx_item_attribute_free (MxItemAttribute  *attr);
+void             _mx_item_attributes_set (GSList           *attributes,
+                                          GObject          *item,
+                                          ClutterModelIter *iter);
+#if GLIB_CHECK_VERSION (2, 44, 0)
+void             _mx_item_set_list_item  (GObject          *item,
+                                          const gchar      *property,
+                                          GListModel       *model,
+                                          guint             position);
+#endif
+void             _mx_item_set_key        (GObject          *item,
+                                          ClutterModelIter *iter,
+                                          gint              column);
+GPtrArray       *_mx_item_match_rows     (ClutterActor     *container,
+                                          ClutterModel     *model,
+                                          gint              column,
+                                          GQueue           *unmatched);
+
+/* a size a container already asked a child for, see
+ * _mx_allocate_align_fill_measured() */
+typedef struct
+{
+  guint  has_width : 1;
+  guint  has_height : 1;
+
+  gfloat width_for_height, min_width, natural_width;
+  gfloat height_for_width, min_height, natural_height;
+} MxMeasuredSize;
+
+void _mx_allocate_align_fill_measured (ClutterActor         *child,
+                                       ClutterActorBox      *childbox,
+                                       MxAlign               x_alignment,
+                                       MxAlign               y_alignment,
+                                       gboolean              x_fill,
+                                       gboolean              y_fill,
+                                       const MxMeasuredSize *measured);
+
+ClutterActor *_mx_actor_get_child_at_index (ClutterActor *parent,
+                                            gint          index_);
+ClutterChildMeta *_mx_container_get_child_meta_at (ClutterContainer *container,
+                                                   ClutterActor     *child,
+                                                   guint             index_);
+
 
 typedef enum
 {
@@ -115,11 +290,73 @@ typedef enum
   MX_DEBUG_INSPECTOR   = 1 << 1,
   MX_DEBUG_FOCUS       = 1 << 2,
   MX_DEBUG_CSS         = 1 << 3,
-  MX_DEBUG_STYLE_CACHE = 1 << 4
+  MX_DEBUG_STYLE_CACHE = 1 << 4,
+  MX_DEBUG_CSS_PROFILE = 1 << 5,
+  MX_DEBUG_STARTUP     = 1 << 6,
+  MX_DEBUG_REDRAWS     = 1 << 7
 } MxDebugTopic;
 
 gboolean _mx_debug (gint debug);
 
+/* with MX_DEBUG=redraws, why the redraws queued meanwhile are queued, as
+ * reported for each frame; the outermost reason is kept, and push returns
+ * what is to be given back to pop */
+const gchar *_mx_debug_redraw_reason_push (const gchar *reason);
+void         _mx_debug_redraw_reason_pop  (const gchar *previous);
+const gchar *_mx_debug_redraw_reason_get  (void);
+
+/* with MX_DEBUG=startup, the time spent in each subsystem up to the first
+ * frame is reported once it has been painted */
+gint64 _mx_startup_trace_begin (void);
+void   _mx_startup_trace_end   (const gchar *subsystem,
+                                gint64       start);
+
+/* the decoders registered with mx_image_decoder_register(), tried before
+ * gdk-pixbuf; these return %NULL without setting @error when none of them
+ * handle the image */
+GdkPixbuf *_mx_image_decoder_decode      (const guint8  *data,
+                                          gsize          length,
+                                          gint           width,
+                                          gint           height,
+                                          gboolean      *scaled,
+                                          GError       **error);
+GdkPixbuf *_mx_image_decoder_decode_file (const gchar   *filename,
+                                          gint           width,
+                                          gint           height,
+                                          gboolean      *scaled,
+                                          GError       **error);
+
+/* Trace spans, recorded as sysprof marks when Mx is configured with
+ * --enable-sysprof and compiled out otherwise. MX_TRACE_BEGIN() declares
+ * the start of the span, so it goes at the end of the declarations, and
+ * each return after it needs a matching MX_TRACE_END(). */
+#ifdef HAVE_SYSPROF
+
+#include <sysprof-capture.h>
+
+#define MX_TRACE_BEGIN(name) \
+  gint64 _mx_trace_##name = SYSPROF_CAPTURE_CURRENT_TIME
+
+#define MX_TRACE_END(name)                                 G_STMT_START { \
+    sysprof_collector_mark (_mx_trace_##name,                             \
+                            SYSPROF_CAPTURE_CURRENT_TIME - _mx_trace_##name, \
+                            "Mx", #name, NULL);                           \
+                                                           } G_STMT_END
+
+#define MX_TRACE_END_WITH_MESSAGE(name, message)           G_STMT_START { \
+    sysprof_collector_mark (_mx_trace_##name,                             \
+                            SYSPROF_CAPTURE_CURRENT_TIME - _mx_trace_##name, \
+                            "Mx", #name, (message));                      \
+                                                           } G_STMT_END
+
+#else
+
+#define MX_TRACE_BEGIN(name) G_STMT_START { } G_STMT_END
+#define MX_TRACE_END(name)   G_STMT_START { } G_STMT_END
+#define MX_TRACE_END_WITH_MESSAGE(name, message) G_STMT_START { } G_STMT_END
+
+#endif
+
 #ifdef G_HAVE_ISO_VARARGS
 
 #define MX_NOTE(topic,...)                         G_STMT_START { \
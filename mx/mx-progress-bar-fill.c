@@ -77,12 +77,18 @@ _mx_progress_bar_fill_class_init (MxProgressBarFillClass *klass)
 static void
 mx_progress_bar_fill_style_changed_cb (MxProgressBarFill *self)
 {
+  MxBorderImage *image;
   guint height;
 
   mx_stylable_get (MX_STYLABLE (self),
                    "height", &height,
+                   "border-image", &image,
                    NULL);
 
+  self->end_width = image ? image->right : 0;
+  if (image)
+    g_boxed_free (MX_TYPE_BORDER_IMAGE, image);
+
   if (self->height != height)
     {
       self->height = height;
@@ -57,6 +57,10 @@ typedef struct
   MxWidget parent;
 
   guint    height;
+
+  /* the width of the right slice of the border image, which the bar keeps
+   * whole when it is partly filled */
+  gfloat   end_width;
 } MxProgressBarFill;
 
 typedef struct
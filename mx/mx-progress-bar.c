@@ -101,41 +101,37 @@ static void
 mx_progress_bar_paint (ClutterActor *actor)
 {
   MxProgressBarPrivate *priv = MX_PROGRESS_BAR (actor)->priv;
+  ClutterActorBox box;
+  gfloat width, end;
 
   CLUTTER_ACTOR_CLASS (mx_progress_bar_parent_class)->paint (actor);
 
-  if (priv->progress)
-    clutter_actor_paint (priv->fill);
-}
+  if (!priv->progress)
+    return;
 
-static void
-mx_progress_bar_allocate_fill (MxProgressBar         *self,
-                               const ClutterActorBox *box,
-                               ClutterAllocationFlags flags)
-{
-  ClutterActorBox box_data;
-  MxProgressBarPrivate *priv = self->priv;
+  /* The fill is allocated the whole width of the bar and only painted up
+   * to the progress, so that changing the progress needs no relayout. To
+   * keep the look of a fill of that width, the end of its border image is
+   * painted separately, moved back to where the progress ends. */
+  clutter_actor_get_allocation_box (priv->fill, &box);
 
-  if (!box)
-    {
-      clutter_actor_get_allocation_box (CLUTTER_ACTOR (self), &box_data);
-      box = &box_data;
-    }
+  width = (box.x2 - box.x1) * priv->progress;
+  end = MIN (MX_PROGRESS_BAR_FILL (priv->fill)->end_width, width / 2);
 
-  if (priv->progress)
-    {
-      ClutterActorBox child_box;
-      MxPadding padding;
+  cogl_clip_push_rectangle (box.x1, box.y1, box.x1 + width - end, box.y2);
+  clutter_actor_paint (priv->fill);
+  cogl_clip_pop ();
 
-      mx_widget_get_padding (MX_WIDGET (self), &padding);
+  if (end > 0)
+    {
+      cogl_push_matrix ();
+      cogl_translate (width - (box.x2 - box.x1), 0, 0);
 
-      child_box.x1 = padding.left;
-      child_box.y1 = padding.top;
-      child_box.y2 = (box->y2 - box->y1) - padding.bottom;
-      child_box.x2 = ((box->x2 - box->x1 - padding.left - padding.right) *
-                      priv->progress) + padding.left;
+      cogl_clip_push_rectangle (box.x2 - end, box.y1, box.x2, box.y2);
+      clutter_actor_paint (priv->fill);
+      cogl_clip_pop ();
 
-      clutter_actor_allocate (priv->fill, &child_box, flags);
+      cogl_pop_matrix ();
     }
 }
 
@@ -144,12 +140,21 @@ mx_progress_bar_allocate (ClutterActor          *actor,
                           const ClutterActorBox *box,
                           ClutterAllocationFlags flags)
 {
-  MxProgressBar *self = MX_PROGRESS_BAR (actor);
+  MxProgressBarPrivate *priv = MX_PROGRESS_BAR (actor)->priv;
+  ClutterActorBox child_box;
+  MxPadding padding;
 
   CLUTTER_ACTOR_CLASS (mx_progress_bar_parent_class)->
   allocate (actor, box, flags);
 
-  mx_progress_bar_allocate_fill (self, box, flags);
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  child_box.x1 = padding.left;
+  child_box.y1 = padding.top;
+  child_box.x2 = (box->x2 - box->x1) - padding.right;
+  child_box.y2 = (box->y2 - box->y1) - padding.bottom;
+
+  clutter_actor_allocate (priv->fill, &child_box, flags);
 }
 
 static void
@@ -275,7 +280,6 @@ mx_progress_bar_set_progress (MxProgressBar *bar,
   if (priv->progress != progress)
     {
       priv->progress = progress;
-      mx_progress_bar_allocate_fill (bar, NULL, 0);
       clutter_actor_queue_redraw (CLUTTER_ACTOR (bar));
       g_object_notify (G_OBJECT (bar), "progress");
     }
@@ -64,11 +64,21 @@ struct _MxScrollBarPrivate
   gfloat        x_origin;
   gfloat        y_origin;
 
+  /* the last motion of a drag of the handle, applied before the next
+   * frame is painted */
+  gfloat        drag_x;
+  gfloat        drag_y;
+  guint         drag_motion_id;
+
   ClutterActor *bw_stepper;
   ClutterActor *fw_stepper;
   ClutterActor *trough;
   ClutterActor *handle;
 
+  /* how far the handle moves from the start of the trough, from the lower
+   * to the upper value of the adjustment */
+  gfloat        handle_travel;
+
   gfloat        move_x;
   gfloat        move_y;
 
@@ -108,6 +118,8 @@ handle_button_press_event_cb (ClutterActor       *actor,
                               ClutterButtonEvent *event,
                               MxScrollBar        *bar);
 
+static void move_slider_cancel (MxScrollBar *bar);
+
 static void
 mx_scroll_bar_get_property (GObject    *gobject,
                             guint       prop_id,
@@ -162,6 +174,8 @@ mx_scroll_bar_dispose (GObject *gobject)
   MxScrollBar *bar = MX_SCROLL_BAR (gobject);
   MxScrollBarPrivate *priv = bar->priv;
 
+  move_slider_cancel (bar);
+
   if (priv->adjustment)
     mx_scroll_bar_set_adjustment (bar, NULL);
 
@@ -301,6 +315,150 @@ mx_scroll_bar_get_preferred_height (ClutterActor *actor,
 
 }
 
+/* Moves the handle along the trough for the value of the adjustment. The
+ * handle is allocated at the start of the trough and only translated from
+ * there, so that scrolling neither lays out nor allocates anything. */
+static void
+mx_scroll_bar_update_handle_position (MxScrollBar *bar)
+{
+  MxScrollBarPrivate *priv = bar->priv;
+  gdouble value, lower, upper, page_size, position;
+  gfloat offset;
+
+  if (!priv->adjustment)
+    return;
+
+  mx_adjustment_get_values (priv->adjustment,
+                            &value,
+                            &lower,
+                            &upper,
+                            NULL,
+                            NULL,
+                            &page_size);
+
+  if (upper - lower - page_size <= 0)
+    position = 0;
+  else
+    position = (value - lower) / (upper - lower - page_size);
+
+  /* snap to pixel, the allocation of the handle already is */
+  offset = (int) (CLAMP (position, 0.0, 1.0) * priv->handle_travel);
+
+  if (priv->orientation == MX_ORIENTATION_VERTICAL)
+    clutter_actor_set_translation (priv->handle, 0, offset, 0);
+  else
+    clutter_actor_set_translation (priv->handle, offset, 0, 0);
+}
+
+/* Allocates the handle for the range and page size of the adjustment, at the
+ * start of the trough. It only depends on them and on the allocation of the
+ * scroll bar, so it is done again when they change without laying out the
+ * scroll bar; the value only moves the handle. */
+static void
+mx_scroll_bar_allocate_handle (MxScrollBar            *bar,
+                               const ClutterActorBox  *box,
+                               ClutterAllocationFlags  flags)
+{
+  ClutterActor *actor = CLUTTER_ACTOR (bar);
+  MxScrollBarPrivate *priv = bar->priv;
+  gfloat x, y, width, height, stepper_size, bw_end, fw_start;
+  gfloat handle_size, avail_size;
+  gdouble lower, upper, page_size, increment;
+  ClutterActorBox handle_box = { 0, };
+  guint min_size, max_size;
+  MxPadding padding;
+
+  if (!priv->adjustment)
+    return;
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  /* calculate the child area, as in mx_scroll_bar_allocate() */
+  x = padding.left;
+  y = padding.top;
+  width = (box->x2 - box->x1) - padding.left - padding.right;
+  height = (box->y2 - box->y1) - padding.top - padding.bottom;
+
+  if (priv->orientation == MX_ORIENTATION_VERTICAL)
+    {
+      stepper_size = width;
+      bw_end = y + stepper_size;
+      fw_start = y + height - stepper_size;
+    }
+  else
+    {
+      stepper_size = height;
+      bw_end = x + stepper_size;
+      fw_start = x + width - stepper_size;
+    }
+
+
+  mx_adjustment_get_values (priv->adjustment,
+                            NULL,
+                            &lower,
+                            &upper,
+                            NULL,
+                            NULL,
+                            &page_size);
+
+  if ((upper == lower)
+      || (page_size >= (upper - lower)))
+    increment = 1.0;
+  else
+    increment = page_size / (upper - lower);
+
+  min_size = priv->handle_min_size;
+
+  mx_stylable_get (MX_STYLABLE (actor),
+                   "mx-max-size", &max_size,
+                   NULL);
+
+  if (priv->orientation == MX_ORIENTATION_VERTICAL)
+    {
+      avail_size = height - stepper_size * 2;
+      handle_size = increment * avail_size;
+      handle_size = CLAMP (handle_size, min_size, max_size);
+
+      handle_box.x1 = x;
+      handle_box.y1 = bw_end;
+
+      handle_box.x2 = handle_box.x1 + width;
+      handle_box.y2 = CLAMP (bw_end + handle_size,
+                             bw_end + min_size, fw_start);
+
+      priv->handle_travel = avail_size - (handle_box.y2 - handle_box.y1);
+    }
+  else
+    {
+      avail_size = width - stepper_size * 2;
+      handle_size = increment * avail_size;
+      handle_size = CLAMP (handle_size, min_size, max_size);
+
+      handle_box.x1 = bw_end;
+      handle_box.y1 = y;
+
+      handle_box.x2 = CLAMP (bw_end + handle_size,
+                             bw_end + min_size, fw_start);
+      handle_box.y2 = handle_box.y1 + height;
+
+      priv->handle_travel = avail_size - (handle_box.x2 - handle_box.x1);
+    }
+
+  priv->handle_travel = MAX (priv->handle_travel, 0);
+
+  /* snap to pixel */
+  handle_box.x1 = (int) handle_box.x1;
+  handle_box.y1 = (int) handle_box.y1;
+  handle_box.x2 = (int) handle_box.x2;
+  handle_box.y2 = (int) handle_box.y2;
+
+  clutter_actor_allocate (priv->handle,
+                          &handle_box,
+                          flags);
+
+  mx_scroll_bar_update_handle_position (bar);
+}
+
 static void
 mx_scroll_bar_allocate (ClutterActor          *actor,
                         const ClutterActorBox *box,
@@ -375,82 +533,7 @@ mx_scroll_bar_allocate (ClutterActor          *actor,
       clutter_actor_allocate (priv->trough, &trough_box, flags);
     }
 
-
-  if (priv->adjustment)
-    {
-      gfloat handle_size, position, avail_size, handle_pos;
-      gdouble value, lower, upper, page_size, increment;
-      ClutterActorBox handle_box = { 0, };
-      guint min_size, max_size;
-
-      mx_adjustment_get_values (priv->adjustment,
-                                &value,
-                                &lower,
-                                &upper,
-                                NULL,
-                                NULL,
-                                &page_size);
-
-      value = mx_adjustment_get_value (priv->adjustment);
-
-      if ((upper == lower)
-          || (page_size >= (upper - lower)))
-        increment = 1.0;
-      else
-        increment = page_size / (upper - lower);
-
-      min_size = priv->handle_min_size;
-
-      mx_stylable_get (MX_STYLABLE (actor),
-                       "mx-max-size", &max_size,
-                       NULL);
-
-      if (upper - lower - page_size <= 0)
-        position = 0;
-      else
-        position = (value - lower) / (upper - lower - page_size);
-
-      if (priv->orientation == MX_ORIENTATION_VERTICAL)
-        {
-          avail_size = height - stepper_size * 2;
-          handle_size = increment * avail_size;
-          handle_size = CLAMP (handle_size, min_size, max_size);
-
-          handle_box.x1 = x;
-          handle_pos = bw_box.y2 + position * (avail_size - handle_size);
-          handle_box.y1 = CLAMP (handle_pos,
-                                 bw_box.y2, fw_box.y1 - min_size);
-
-          handle_box.x2 = handle_box.x1 + width;
-          handle_box.y2 = CLAMP (handle_pos + handle_size,
-                                 bw_box.y2 + min_size, fw_box.y1);
-        }
-      else
-        {
-          avail_size = width - stepper_size * 2;
-          handle_size = increment * avail_size;
-          handle_size = CLAMP (handle_size, min_size, max_size);
-
-          handle_pos = bw_box.x2 + position * (avail_size - handle_size);
-          handle_box.x1 = CLAMP (handle_pos,
-                                 bw_box.x2, fw_box.x1 - min_size);
-          handle_box.y1 = y;
-
-          handle_box.x2 = CLAMP (handle_pos + handle_size,
-                                 bw_box.x2 + min_size, fw_box.x1);
-          handle_box.y2 = handle_box.y1 + height;
-        }
-
-      /* snap to pixel */
-      handle_box.x1 = (int) handle_box.x1;
-      handle_box.y1 = (int) handle_box.y1;
-      handle_box.x2 = (int) handle_box.x2;
-      handle_box.y2 = (int) handle_box.y2;
-
-      clutter_actor_allocate (priv->handle,
-                              &handle_box,
-                              flags);
-    }
+  mx_scroll_bar_allocate_handle (MX_SCROLL_BAR (actor), box, flags);
 }
 
 static void
@@ -696,22 +779,61 @@ move_slider (MxScrollBar *bar,
   mx_adjustment_set_value (priv->adjustment, position);
 }
 
+static gboolean
+move_slider_flush (gpointer data)
+{
+  MxScrollBar *bar = data;
+
+  bar->priv->drag_motion_id = 0;
+  move_slider (bar, bar->priv->drag_x, bar->priv->drag_y);
+
+  return FALSE;
+}
+
+static void
+move_slider_cancel (MxScrollBar *bar)
+{
+  if (bar->priv->drag_motion_id)
+    {
+      clutter_threads_remove_repaint_func (bar->priv->drag_motion_id);
+      bar->priv->drag_motion_id = 0;
+    }
+}
+
 static gboolean
 handle_capture_event_cb (ClutterActor *trough,
                          ClutterEvent *event,
                          MxScrollBar  *bar)
 {
+  MxScrollBarPrivate *priv = bar->priv;
+
   if (clutter_event_type (event) == CLUTTER_MOTION)
     {
-      move_slider (bar,
-                   ((ClutterMotionEvent*) event)->x,
-                   ((ClutterMotionEvent*) event)->y);
+      /* only the last motion of each frame moves the handle */
+      priv->drag_x = ((ClutterMotionEvent*) event)->x;
+      priv->drag_y = ((ClutterMotionEvent*) event)->y;
+
+      if (!priv->drag_motion_id)
+        {
+          priv->drag_motion_id =
+            clutter_threads_add_repaint_func_full (
+              CLUTTER_REPAINT_FLAGS_PRE_PAINT, move_slider_flush, bar, NULL);
+
+          /* make sure there is a frame to move the handle in */
+          clutter_actor_queue_redraw (CLUTTER_ACTOR (bar));
+        }
     }
   else if (clutter_event_type (event) == CLUTTER_BUTTON_RELEASE
            && ((ClutterButtonEvent*) event)->button == 1)
     {
       ClutterActor *stage, *target;
 
+      if (priv->drag_motion_id)
+        {
+          move_slider_cancel (bar);
+          move_slider (bar, priv->drag_x, priv->drag_y);
+        }
+
       stage = clutter_actor_get_stage(bar->priv->trough);
 
       if (bar->priv->capture_handler)
@@ -821,10 +943,13 @@ trough_paging_cb (MxScrollBar *self)
                             &value, NULL, NULL,
                             NULL, &page_increment, NULL);
 
+  /* the handle is moved along the trough by its translation */
+  clutter_actor_get_translation (self->priv->handle, &tx, &ty, NULL);
+
   if (self->priv->orientation == MX_ORIENTATION_VERTICAL)
-    handle_pos = clutter_actor_get_y (self->priv->handle);
+    handle_pos = clutter_actor_get_y (self->priv->handle) + ty;
   else
-    handle_pos = clutter_actor_get_x (self->priv->handle);
+    handle_pos = clutter_actor_get_x (self->priv->handle) + tx;
 
   clutter_actor_transform_stage_point (CLUTTER_ACTOR (self->priv->trough),
                                        self->priv->move_x,
@@ -1104,6 +1229,27 @@ mx_scroll_bar_new_with_adjustment (MxAdjustment *adjustment)
                        NULL);
 }
 
+static void
+mx_scroll_bar_adjustment_changed_cb (MxScrollBar *bar)
+{
+  ClutterActor *actor = CLUTTER_ACTOR (bar);
+  ClutterActorBox box;
+
+  /* only the handle depends on the range and page size of the adjustment,
+   * so allocate it again within the current allocation rather than laying
+   * out the scroll bar again */
+  if (!clutter_actor_has_allocation (actor))
+    {
+      clutter_actor_queue_relayout (actor);
+      return;
+    }
+
+  clutter_actor_get_allocation_box (actor, &box);
+  mx_scroll_bar_allocate_handle (bar, &box, CLUTTER_ALLOCATION_NONE);
+
+  clutter_actor_queue_redraw (actor);
+}
+
 void
 mx_scroll_bar_set_adjustment (MxScrollBar  *bar,
                               MxAdjustment *adjustment)
@@ -1116,10 +1262,10 @@ mx_scroll_bar_set_adjustment (MxScrollBar  *bar,
   if (priv->adjustment)
     {
       g_signal_handlers_disconnect_by_func (priv->adjustment,
-                                            clutter_actor_queue_relayout,
+                                            mx_scroll_bar_adjustment_changed_cb,
                                             bar);
       g_signal_handlers_disconnect_by_func (priv->adjustment,
-                                            clutter_actor_queue_relayout,
+                                            mx_scroll_bar_update_handle_position,
                                             bar);
       g_object_unref (priv->adjustment);
       priv->adjustment = NULL;
@@ -1130,10 +1276,10 @@ mx_scroll_bar_set_adjustment (MxScrollBar  *bar,
       priv->adjustment = g_object_ref (adjustment);
 
       g_signal_connect_swapped (priv->adjustment, "notify::value",
-                                G_CALLBACK (clutter_actor_queue_relayout),
+                                G_CALLBACK (mx_scroll_bar_update_handle_position),
                                 bar);
       g_signal_connect_swapped (priv->adjustment, "changed",
-                                G_CALLBACK (clutter_actor_queue_relayout),
+                                G_CALLBACK (mx_scroll_bar_adjustment_changed_cb),
                                 bar);
 
       clutter_actor_queue_relayout (CLUTTER_ACTOR (bar));
@@ -78,6 +78,11 @@ struct _MxScrollViewPrivate
 
   MxScrollPolicy scroll_policy;
   MxScrollPolicy scroll_visibility;
+
+  /* Smooth scroll deltas received since the last frame */
+  gdouble       pending_dx;
+  gdouble       pending_dy;
+  guint         pending_scroll_id;
 };
 
 enum {
@@ -157,6 +162,12 @@ mx_scroll_view_dispose (GObject *object)
 {
   MxScrollViewPrivate *priv = MX_SCROLL_VIEW (object)->priv;
 
+  if (priv->pending_scroll_id)
+    {
+      clutter_threads_remove_repaint_func (priv->pending_scroll_id);
+      priv->pending_scroll_id = 0;
+    }
+
   if (priv->vscroll)
     {
       clutter_actor_remove_child (CLUTTER_ACTOR (object), priv->vscroll);
@@ -576,6 +587,55 @@ mx_scroll_view_touch_event (ClutterActor      *self,
   return FALSE;
 }
 
+/* Applies the smooth scroll deltas received since the last frame at once,
+ * before the frame is laid out and painted */
+static gboolean
+mx_scroll_view_flush_scroll (gpointer user_data)
+{
+  MxScrollViewPrivate *priv = MX_SCROLL_VIEW (user_data)->priv;
+  MxAdjustment *hadjustment, *vadjustment;
+
+  priv->pending_scroll_id = 0;
+
+  hadjustment = mx_scroll_bar_get_adjustment (MX_SCROLL_BAR (priv->hscroll));
+  vadjustment = mx_scroll_bar_get_adjustment (MX_SCROLL_BAR (priv->vscroll));
+
+  if (hadjustment && priv->pending_dx != 0)
+    mx_adjustment_interpolate_relative (hadjustment, priv->pending_dx,
+                                        250, CLUTTER_EASE_OUT_CUBIC);
+
+  if (vadjustment && priv->pending_dy != 0)
+    mx_adjustment_interpolate_relative (vadjustment, priv->pending_dy,
+                                        250, CLUTTER_EASE_OUT_CUBIC);
+
+  priv->pending_dx = 0;
+  priv->pending_dy = 0;
+
+  return FALSE;
+}
+
+static void
+mx_scroll_view_queue_scroll (MxScrollView *scroll,
+                             gdouble       dx,
+                             gdouble       dy)
+{
+  MxScrollViewPrivate *priv = scroll->priv;
+
+  priv->pending_dx += dx;
+  priv->pending_dy += dy;
+
+  if (!priv->pending_scroll_id)
+    {
+      priv->pending_scroll_id =
+        clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+                                               mx_scroll_view_flush_scroll,
+                                               scroll, NULL);
+
+      /* make sure there is a frame to apply the deltas in */
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (scroll));
+    }
+}
+
 static gboolean
 mx_scroll_view_scroll_event (ClutterActor       *self,
                              ClutterScrollEvent *event)
@@ -670,7 +730,7 @@ mx_scroll_view_scroll_event (ClutterActor       *self,
 
     case CLUTTER_SCROLL_SMOOTH:
       {
-        gdouble dx, dy;
+        gdouble dx, dy, hdelta = 0, vdelta = 0;
         gboolean handled = FALSE;
 
         clutter_event_get_scroll_delta ((ClutterEvent *) event, &dx, &dy);
@@ -681,8 +741,7 @@ mx_scroll_view_scroll_event (ClutterActor       *self,
             if (!(((hvalue == hlower) && (dx < 0)) &&
                   ((hvalue == hupper) && (dx > 0))))
               {
-                mx_adjustment_interpolate_relative (hadjustment, dx,
-                                                    250, CLUTTER_EASE_OUT_CUBIC);
+                hdelta = dx;
                 handled = TRUE;
               }
           }
@@ -693,12 +752,15 @@ mx_scroll_view_scroll_event (ClutterActor       *self,
             if (!(((vvalue == vlower) && (dy < 0)) &&
                   ((vvalue == vupper) && (dy > 0))))
               {
-                mx_adjustment_interpolate_relative (vadjustment, dy,
-                                                    250, CLUTTER_EASE_OUT_CUBIC);
+                vdelta = dy;
                 handled = TRUE;
               }
           }
 
+        /* Touchpads send many of these per frame: apply them together */
+        if (handled)
+          mx_scroll_view_queue_scroll (MX_SCROLL_VIEW (self), hdelta, vdelta);
+
         return handled;
       }
       break;
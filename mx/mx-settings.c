@@ -24,6 +24,7 @@
 #endif
 
 #include "mx-settings.h"
+#include "mx-marshal.h"
 #include "mx-private.h"
 #include "mx-settings-provider.h"
 
@@ -46,6 +47,31 @@ struct _MxSettingsPrivate
   guint  drag_threshold;
   guint  small_screen : 1;
   guint  touch_mode : 1;
+
+  /* the changes of the provider waiting to be delivered, as a mask of
+   * 1 << MxSettingsProperty */
+  guint  pending_changes;
+  guint  changes_id;
+};
+
+enum
+{
+  SETTINGS_CHANGED,
+
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0, };
+
+/* the property names, by MxSettingsProperty */
+static const gchar *property_names[] = {
+  NULL,
+  "icon-theme",
+  "font-name",
+  "long-press-timeout",
+  "small-screen",
+  "drag-threshold",
+  "touch-mode"
 };
 
 static void
@@ -242,6 +268,12 @@ mx_settings_dispose (GObject *object)
       priv->provider = NULL;
     }
 
+  if (priv->changes_id)
+    {
+      g_source_remove (priv->changes_id);
+      priv->changes_id = 0;
+    }
+
   G_OBJECT_CLASS (mx_settings_parent_class)->dispose (object);
 }
 
@@ -277,34 +309,54 @@ mx_settings_constructor (GType                  type,
   return object;
 }
 
+static gboolean
+mx_settings_emit_changes (gpointer data)
+{
+  MxSettings *self = data;
+  MxSettingsPrivate *priv = self->priv;
+  const gchar *names[G_N_ELEMENTS (property_names)];
+  guint i, n_names = 0;
+
+  priv->changes_id = 0;
+
+  for (i = 1; i < G_N_ELEMENTS (property_names); i++)
+    if (priv->pending_changes & (1 << i))
+      names[n_names++] = property_names[i];
+  names[n_names] = NULL;
+
+  priv->pending_changes = 0;
+
+  /* the notifications are queued until the batch has been delivered */
+  g_object_freeze_notify (G_OBJECT (self));
+  for (i = 0; i < n_names; i++)
+    g_object_notify (G_OBJECT (self), names[i]);
+
+  g_signal_emit (self, signals[SETTINGS_CHANGED], 0, names);
+  g_object_thaw_notify (G_OBJECT (self));
+
+  return FALSE;
+}
+
 #if defined(HAVE_X11)
+/* Providers report their settings one at a time, but desktop-wide changes
+ * (of the theme, font and resolution together) come in bursts; these are
+ * delivered together, once the burst has been dispatched */
 static void
 mx_settings_changed_cb (MxSettingsProvider *provider,
                         MxSettingsProperty  id,
                         MxSettings         *self)
 {
-  switch (id)
-    {
-    case MX_SETTINGS_ICON_THEME:
-      g_object_notify (G_OBJECT (self), "icon-theme");
-      return;
+  MxSettingsPrivate *priv = self->priv;
 
-    case MX_SETTINGS_FONT_NAME:
-      g_object_notify (G_OBJECT (self), "font-name");
-      return;
-
-    case MX_SETTINGS_LONG_PRESS_TIMEOUT:
-      g_object_notify (G_OBJECT (self), "long-press-timeout");
-      return;
+  if (id < 1 || id >= G_N_ELEMENTS (property_names))
+    return;
 
-    case MX_SETTINGS_SMALL_SCREEN:
-      g_object_notify (G_OBJECT (self), "small-screen");
-      return;
+  priv->pending_changes |= 1 << id;
 
-    case MX_SETTINGS_DRAG_THRESHOLD:
-      g_object_notify (G_OBJECT (self), "drag-threshold");
-      return;
-    }
+  if (!priv->changes_id)
+    priv->changes_id =
+      clutter_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                     mx_settings_emit_changes, self, NULL);
 }
 #endif
 
@@ -383,6 +435,29 @@ mx_settings_class_init (MxSettingsClass *klass)
                                 MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, MX_SETTINGS_TOUCH_MODE,
                                    pspec);
+
+  /**
+   * MxSettings::settings-changed:
+   * @settings: the object that received the signal
+   * @names: (array zero-terminated=1): the names of the properties that
+   *   changed
+   *
+   * Emitted when the settings of the desktop have changed. Changes that
+   * arrive together, such as a new theme and font, are batched, so that
+   * the signal is emitted once for them, after the main loop has
+   * dispatched them all. The #GObject::notify signals for the properties
+   * are emitted once this signal has been handled.
+   *
+   * Since: 2.0
+   */
+  signals[SETTINGS_CHANGED] =
+    g_signal_new ("settings-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL,
+                  _mx_marshal_VOID__BOXED,
+                  G_TYPE_NONE, 1,
+                  G_TYPE_STRV | G_SIGNAL_TYPE_STATIC_SCOPE);
 }
 
 static void
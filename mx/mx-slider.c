@@ -64,10 +64,19 @@ struct _MxSliderPrivate
   gulong        capture_handler;
   gfloat        x_origin;
 
+  /* the last motion of a drag of the handle, applied before the next
+   * frame is painted */
+  gfloat        drag_x;
+  gfloat        drag_y;
+  guint         drag_motion_id;
+
   /* the middle of the handle can wander on the axis between start and end */
   gfloat        handle_middle_start;
   gfloat        handle_middle_end;
 
+  /* where the fill is clipped, for the current value */
+  gfloat        fill_end;
+
   /* keep those around for ::alocate_fill() */
   gfloat        trough_box_y1;
   gfloat        trough_box_y2;
@@ -163,10 +172,27 @@ drag_handle (MxSlider *bar,
 
   value = pos / fill_size;
   mx_slider_set_value (bar, value);
+}
+
+static gboolean
+drag_handle_flush (gpointer data)
+{
+  MxSlider *bar = data;
+
+  bar->priv->drag_motion_id = 0;
+  drag_handle (bar, bar->priv->drag_x, bar->priv->drag_y);
 
-  /* update the handle position */
-  mx_slider_allocate_fill_handle (bar, NULL, 0);
-  clutter_actor_queue_redraw (CLUTTER_ACTOR (bar));
+  return FALSE;
+}
+
+static void
+drag_handle_cancel (MxSlider *bar)
+{
+  if (bar->priv->drag_motion_id)
+    {
+      clutter_threads_remove_repaint_func (bar->priv->drag_motion_id);
+      bar->priv->drag_motion_id = 0;
+    }
 }
 
 static gboolean
@@ -178,25 +204,37 @@ on_handle_capture_event (ClutterActor *trough,
 
   if (clutter_event_type (event) == CLUTTER_MOTION)
     {
-      drag_handle (bar,
-                   ((ClutterMotionEvent*)event)->x,
-                   ((ClutterMotionEvent*)event)->y);
+      /* only the last motion of each frame moves the handle */
+      priv->drag_x = ((ClutterMotionEvent*)event)->x;
+      priv->drag_y = ((ClutterMotionEvent*)event)->y;
+
+      if (!priv->drag_motion_id)
+        {
+          priv->drag_motion_id =
+            clutter_threads_add_repaint_func_full (
+              CLUTTER_REPAINT_FLAGS_PRE_PAINT, drag_handle_flush, bar, NULL);
+
+          /* make sure there is a frame to move the handle in */
+          clutter_actor_queue_redraw (CLUTTER_ACTOR (bar));
+        }
     }
   else if (clutter_event_type (event) == CLUTTER_BUTTON_RELEASE
            && ((ClutterButtonEvent*)event)->button == 1)
     {
       ClutterActor *stage, *target;
 
+      if (priv->drag_motion_id)
+        {
+          drag_handle_cancel (bar);
+          drag_handle (bar, priv->drag_x, priv->drag_y);
+        }
+
       stage = clutter_actor_get_stage(priv->trough);
 
       if (priv->capture_handler)
         {
           g_signal_handler_disconnect (stage, priv->capture_handler);
           priv->capture_handler = 0;
-
-          /* update the handle position */
-          mx_slider_allocate_fill_handle (bar, NULL, 0);
-          clutter_actor_queue_redraw (CLUTTER_ACTOR (bar));
         }
 
       clutter_stage_set_motion_events_enabled (CLUTTER_STAGE (stage), TRUE);
@@ -401,7 +439,15 @@ mx_slider_paint (ClutterActor *actor)
     clutter_actor_paint (priv->buffer);
 
   if (priv->value)
-    clutter_actor_paint (priv->fill);
+    {
+      ClutterActorBox fill_box;
+
+      clutter_actor_get_allocation_box (priv->fill, &fill_box);
+      cogl_clip_push_rectangle (fill_box.x1, fill_box.y1,
+                                priv->fill_end, fill_box.y2);
+      clutter_actor_paint (priv->fill);
+      cogl_clip_pop ();
+    }
 
   clutter_actor_paint (priv->handle);
 }
@@ -463,6 +509,50 @@ mx_slider_get_preferred_height (ClutterActor *actor,
                     padding.top + padding.bottom;
 }
 
+/* Where the end of the fill, and the middle of the handle, are for @value
+ * in a slider @width wide */
+static gfloat
+mx_slider_get_fill_end (MxSlider *self,
+                        gfloat    width,
+                        gdouble   value)
+{
+  MxSliderPrivate *priv = self->priv;
+  MxPadding padding;
+  gfloat fill_end;
+
+  mx_widget_get_padding (MX_WIDGET (self), &padding);
+
+  fill_end = ((width - padding.left - padding.right - priv->handle_width) *
+              value) + padding.left + (priv->handle_width >> 1);
+
+  return CLAMP (fill_end, priv->handle_middle_start, priv->handle_middle_end);
+}
+
+/* The handle is allocated where it is for a value of 0 and the fill as for a
+ * value of 1; the value only moves the handle, by its translation, and
+ * clips the fill when painting, so that it doesn't need a new allocation */
+static void
+mx_slider_update_position (MxSlider *self)
+{
+  MxSliderPrivate *priv = self->priv;
+  gfloat width, handle_width_2, start, end;
+
+  if (!clutter_actor_has_allocation (CLUTTER_ACTOR (self)))
+    return;
+
+  width = clutter_actor_get_width (CLUTTER_ACTOR (self));
+  handle_width_2 = priv->handle_width >> 1;
+
+  priv->fill_end = mx_slider_get_fill_end (self, width, priv->value);
+
+  /* snapped to pixels, as the allocation of the handle is */
+  start = (int) (mx_slider_get_fill_end (self, width, 0) - handle_width_2);
+  end = (int) (priv->fill_end - handle_width_2);
+  clutter_actor_set_translation (priv->handle, end - start, 0, 0);
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
+}
+
 static void
 mx_slider_allocate_fill_handle (MxSlider               *self,
                                 const ClutterActorBox  *box,
@@ -486,15 +576,10 @@ mx_slider_allocate_fill_handle (MxSlider               *self,
 
   handle_width_2 = priv->handle_width >> 1;
 
-  /* fill */
+  /* fill, as long as it can be */
   fill_box.x1 = padding.left;
   fill_box.y1 = priv->trough_box_y1;
-  fill_box.x2 = ((box->x2 - box->x1 - padding.left - padding.right -
-                  priv->handle_width) * priv->value) + padding.left +
-                  handle_width_2;
-  fill_box.x2 = CLAMP (fill_box.x2,
-                       priv->handle_middle_start,
-                       priv->handle_middle_end);
+  fill_box.x2 = mx_slider_get_fill_end (self, box->x2 - box->x1, 1.0);
   fill_box.y2 = priv->trough_box_y2;
 
   clutter_actor_allocate (priv->fill, &fill_box, flags);
@@ -509,8 +594,9 @@ mx_slider_allocate_fill_handle (MxSlider               *self,
 
   clutter_actor_allocate (priv->buffer, &buffer_box, flags);
 
-  /* handle */
-  handle_box.x1 = fill_box.x2 - handle_width_2;
+  /* handle, at the start */
+  handle_box.x1 = mx_slider_get_fill_end (self, box->x2 - box->x1, 0) -
+    handle_width_2;
   handle_box.x2 = handle_box.x1 + priv->handle_width;
 
   /* If the handle height is unset, occupy all available space.
@@ -534,6 +620,8 @@ mx_slider_allocate_fill_handle (MxSlider               *self,
   handle_box.y2 = (int) handle_box.y2;
 
   clutter_actor_allocate (priv->handle, &handle_box, flags);
+
+  mx_slider_update_position (self);
 }
 
 static void
@@ -652,6 +740,8 @@ mx_slider_dispose (GObject *object)
   MxSlider *self = MX_SLIDER (object);
   MxSliderPrivate *priv = self->priv;
 
+  drag_handle_cancel (self);
+
   if (priv->capture_handler && priv->trough)
     {
       ClutterActor *stage;
@@ -858,11 +948,7 @@ mx_slider_set_value (MxSlider *bar,
 
   priv->value = value;
 
-  if (!priv->capture_handler)
-    {
-      mx_slider_allocate_fill_handle (bar, NULL, 0);
-      clutter_actor_queue_redraw (CLUTTER_ACTOR (bar));
-    }
+  mx_slider_update_position (bar);
 
   g_object_notify (G_OBJECT (bar), "value");
 }
@@ -64,13 +64,90 @@ struct _MxSpinnerPrivate
   guint       anim_duration;
 
   guint       current_frame;
-  guint       update_id;
+  guint       elapsed;
 
   guint       animating : 1;
+  guint       clock_active : 1;
 };
 
 static guint signals[LAST_SIGNAL] = { 0, };
 
+/* A single timeline drives all the spinners that are animating and mapped,
+ * so that they advance together on the frames of the master clock rather
+ * than each waking the main loop from a timeout of its own. It runs while
+ * there is any such spinner. */
+static ClutterTimeline *spinner_clock = NULL;
+static GList *spinners = NULL;
+
+static void mx_spinner_advance (MxSpinner *spinner,
+                                guint      delta);
+
+static void
+spinner_clock_new_frame_cb (ClutterTimeline *timeline,
+                            guint            msecs,
+                            gpointer         user_data)
+{
+  GList *active, *l;
+  guint delta;
+
+  delta = clutter_timeline_get_delta (timeline);
+
+  /* The looped signal handlers may start or stop spinners */
+  active = g_list_copy (spinners);
+  g_list_foreach (active, (GFunc) g_object_ref, NULL);
+
+  for (l = active; l; l = l->next)
+    {
+      MxSpinner *spinner = l->data;
+
+      if (spinner->priv->clock_active)
+        mx_spinner_advance (spinner, delta);
+
+      g_object_unref (spinner);
+    }
+
+  g_list_free (active);
+}
+
+static void
+spinner_clock_add (MxSpinner *spinner)
+{
+  MxSpinnerPrivate *priv = spinner->priv;
+
+  if (priv->clock_active)
+    return;
+
+  priv->clock_active = TRUE;
+  priv->elapsed = 0;
+  spinners = g_list_prepend (spinners, spinner);
+
+  if (!spinner_clock)
+    {
+      spinner_clock = clutter_timeline_new (1000);
+      clutter_timeline_set_repeat_count (spinner_clock, -1);
+      g_signal_connect (spinner_clock, "new-frame",
+                        G_CALLBACK (spinner_clock_new_frame_cb), NULL);
+    }
+
+  if (!clutter_timeline_is_playing (spinner_clock))
+    clutter_timeline_start (spinner_clock);
+}
+
+static void
+spinner_clock_remove (MxSpinner *spinner)
+{
+  MxSpinnerPrivate *priv = spinner->priv;
+
+  if (!priv->clock_active)
+    return;
+
+  priv->clock_active = FALSE;
+  spinners = g_list_remove (spinners, spinner);
+
+  if (!spinners)
+    clutter_timeline_stop (spinner_clock);
+}
+
 
 static void
 mx_spinner_get_property (GObject    *object,
@@ -115,11 +192,7 @@ mx_spinner_dispose (GObject *object)
 {
   MxSpinnerPrivate *priv = MX_SPINNER (object)->priv;
 
-  if (priv->update_id)
-    {
-      g_source_remove (priv->update_id);
-      priv->update_id = 0;
-    }
+  spinner_clock_remove (MX_SPINNER (object));
 
   if (priv->material)
     {
@@ -281,6 +354,70 @@ mx_stylable_iface_init (MxStylableIface *iface)
     }
 }
 
+/* moves the animation on by @delta milliseconds */
+static void
+mx_spinner_advance (MxSpinner *spinner,
+                    guint      delta)
+{
+  MxSpinnerPrivate *priv = spinner->priv;
+  guint frame_time, steps;
+
+  frame_time = MAX (1, priv->anim_duration / priv->frames);
+
+  priv->elapsed += delta;
+  steps = priv->elapsed / frame_time;
+  if (steps == 0)
+    return;
+
+  priv->elapsed -= steps * frame_time;
+
+  /* We may be destroyed during the signal emission, so
+   * queue the redraw here instead of below.
+   */
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (spinner));
+
+  /* frames missed in a slow frame are skipped, but a loop is still
+   * signalled */
+  steps += priv->current_frame;
+  priv->current_frame = steps % priv->frames;
+
+  if (steps >= priv->frames)
+    g_signal_emit (spinner, signals[LOOPED], 0);
+}
+
+static void
+mx_spinner_update_clock (MxSpinner *spinner)
+{
+  MxSpinnerPrivate *priv = spinner->priv;
+
+  if (!priv->animating || !priv->frames || !priv->material)
+    {
+      spinner_clock_remove (spinner);
+      priv->current_frame = 0;
+    }
+  else if (CLUTTER_ACTOR_IS_MAPPED (spinner))
+    spinner_clock_add (spinner);
+  else
+    spinner_clock_remove (spinner);
+}
+
+static void
+mx_spinner_map (ClutterActor *actor)
+{
+  CLUTTER_ACTOR_CLASS (mx_spinner_parent_class)->map (actor);
+
+  mx_spinner_update_clock (MX_SPINNER (actor));
+}
+
+static void
+mx_spinner_unmap (ClutterActor *actor)
+{
+  /* a spinner that cannot be seen does not need to advance */
+  spinner_clock_remove (MX_SPINNER (actor));
+
+  CLUTTER_ACTOR_CLASS (mx_spinner_parent_class)->unmap (actor);
+}
+
 static void
 mx_spinner_class_init (MxSpinnerClass *klass)
 {
@@ -299,6 +436,8 @@ mx_spinner_class_init (MxSpinnerClass *klass)
   actor_class->get_preferred_width = mx_spinner_get_preferred_width;
   actor_class->get_preferred_height = mx_spinner_get_preferred_height;
   actor_class->paint = mx_spinner_paint;
+  actor_class->map = mx_spinner_map;
+  actor_class->unmap = mx_spinner_unmap;
 
   pspec = g_param_spec_boolean ("animating",
                                 "Animating",
@@ -325,48 +464,6 @@ mx_spinner_class_init (MxSpinnerClass *klass)
                   G_TYPE_NONE, 0);
 }
 
-static gboolean
-mx_spinner_timeout_cb (MxSpinner *spinner)
-{
-  MxSpinnerPrivate *priv = spinner->priv;
-
-  /* We may be destroyed during the signal emission, so
-   * queue the redraw here instead of below.
-   */
-  clutter_actor_queue_redraw (CLUTTER_ACTOR (spinner));
-
-  if (++priv->current_frame == priv->frames)
-    {
-      priv->current_frame = 0;
-      g_signal_emit (spinner, signals[LOOPED], 0);
-    }
-
-  return TRUE;
-}
-
-static void
-mx_spinner_update_timeout (MxSpinner *spinner)
-{
-  MxSpinnerPrivate *priv = spinner->priv;
-
-  if (priv->update_id)
-    {
-      g_source_remove (priv->update_id);
-      priv->update_id = 0;
-    }
-
-  if (priv->animating && priv->frames && priv->material)
-    priv->update_id = clutter_threads_add_timeout_full (CLUTTER_PRIORITY_REDRAW,
-                                                        MAX (1, priv->anim_duration /
-                                                             priv->frames),
-                                                        (GSourceFunc)
-                                                        mx_spinner_timeout_cb,
-                                                        spinner,
-                                                        NULL);
-  else
-    priv->current_frame = 0;
-}
-
 static void
 mx_spinner_style_changed_cb (MxStylable          *stylable,
                              MxStyleChangedFlags  flags)
@@ -407,7 +504,7 @@ mx_spinner_style_changed_cb (MxStylable          *stylable,
         }
     }
 
-  mx_spinner_update_timeout (spinner);
+  mx_spinner_update_clock (spinner);
 
   clutter_actor_queue_relayout (CLUTTER_ACTOR (stylable));
 }
@@ -478,7 +575,7 @@ mx_spinner_set_animating (MxSpinner *spinner, gboolean animating)
   if (priv->animating != animating)
     {
       priv->animating = animating;
-      mx_spinner_update_timeout (spinner);
+      mx_spinner_update_clock (spinner);
       g_object_notify (G_OBJECT (spinner), "animating");
     }
 }
@@ -49,7 +49,8 @@ enum
   PROP_X_ALIGN,
   PROP_Y_ALIGN,
   PROP_FIT,
-  PROP_CROP
+  PROP_CROP,
+  PROP_OPAQUE
 };
 
 static void
@@ -80,6 +81,9 @@ mx_stack_child_get_property (GObject    *object,
     case PROP_CROP:
       g_value_set_boolean (value, child->crop);
       break;
+    case PROP_OPAQUE:
+      g_value_set_boolean (value, child->opaque);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -115,6 +119,9 @@ mx_stack_child_set_property (GObject      *object,
     case PROP_CROP:
       child->crop = g_value_get_boolean (value);
       break;
+    case PROP_OPAQUE:
+      child->opaque = g_value_get_boolean (value);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -183,6 +190,15 @@ mx_stack_child_class_init (MxStackChildClass *klass)
                                 FALSE,
                                 MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, PROP_CROP, pspec);
+
+  pspec = g_param_spec_boolean ("opaque", "Opaque",
+                                "Whether the child paints every pixel of its"
+                                " allocation, so that the children below it"
+                                " need not be painted when it covers the"
+                                " stack.",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_OPAQUE, pspec);
 }
 
 static void
@@ -519,3 +535,59 @@ mx_stack_child_set_crop (MxStack      *stack,
 
   clutter_actor_queue_relayout (child);
 }
+
+/**
+ * mx_stack_child_get_opaque:
+ * @stack: An #MxStack
+ * @child: A #ClutterActor
+ *
+ * Get the value of the #MxStackChild:opaque property.
+ *
+ * Returns: the current value of the #MxStackChild:opaque property
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_stack_child_get_opaque (MxStack      *stack,
+                           ClutterActor *child)
+{
+  MxStackChild *meta;
+
+  g_return_val_if_fail (MX_IS_STACK (stack), FALSE);
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (child), FALSE);
+
+  meta = _get_child_meta (stack, child);
+
+  return meta->opaque;
+}
+
+/**
+ * mx_stack_child_set_opaque:
+ * @stack: An #MxStack
+ * @child: A #ClutterActor
+ * @opaque: A #gboolean
+ *
+ * Set the value of the #MxStackChild:opaque property. The children below an
+ * opaque child that covers the whole of @stack are not painted or picked.
+ *
+ * An #MxWidget child with an opaque background-color is considered opaque
+ * whatever the value of this property.
+ *
+ * Since: 2.0
+ */
+void
+mx_stack_child_set_opaque (MxStack      *stack,
+                           ClutterActor *child,
+                           gboolean      opaque)
+{
+  MxStackChild *meta;
+
+  g_return_if_fail (MX_IS_STACK (stack));
+  g_return_if_fail (CLUTTER_IS_ACTOR (child));
+
+  meta = _get_child_meta (stack, child);
+
+  meta->opaque = opaque;
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stack));
+}
@@ -75,6 +75,7 @@ struct _MxStackChild
   guint y_fill     : 1;
   guint fit        : 1;
   guint crop       : 1;
+  guint opaque     : 1;
   MxAlign x_align;
   MxAlign y_align;
 };
@@ -129,6 +130,11 @@ void     mx_stack_child_set_crop (MxStack      *stack,
                                   ClutterActor *child,
                                   gboolean      crop);
 
+gboolean mx_stack_child_get_opaque (MxStack      *stack,
+                                    ClutterActor *child);
+void     mx_stack_child_set_opaque (MxStack      *stack,
+                                    ClutterActor *child,
+                                    gboolean      opaque);
 
 G_END_DECLS
 
@@ -73,39 +73,34 @@ mx_stack_move_focus (MxFocusable     *focusable,
                     MxFocusDirection  direction,
                     MxFocusable      *from)
 {
-  GList *c, *children;
+  ClutterActor *child;
 
   MxStackPrivate *priv = MX_STACK (focusable)->priv;
 
   if (direction == MX_FOCUS_DIRECTION_OUT)
     return NULL;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
+  child = CLUTTER_ACTOR (from);
+  if (clutter_actor_get_parent (child) != CLUTTER_ACTOR (focusable))
+    return NULL;
 
   focusable = NULL;
 
-  c = g_list_find (children, from);
-  while (c && !focusable)
+  while (child && !focusable)
     {
-      ClutterActor *child;
-
       switch (direction)
         {
         case MX_FOCUS_DIRECTION_PREVIOUS :
         case MX_FOCUS_DIRECTION_LEFT :
         case MX_FOCUS_DIRECTION_UP :
-          c = c->prev;
+          child = clutter_actor_get_previous_sibling (child);
           break;
         default:
-          c = c->next;
+          child = clutter_actor_get_next_sibling (child);
           break;
         }
 
-      if (!c)
-        continue;
-
-      child = c->data;
-      if (!MX_IS_FOCUSABLE (child))
+      if (!child || !MX_IS_FOCUSABLE (child))
         continue;
 
       focusable = mx_focusable_accept_focus (MX_FOCUSABLE (child),
@@ -114,18 +109,16 @@ mx_stack_move_focus (MxFocusable     *focusable,
         priv->current_focus = child;
     }
 
-  g_list_free (children);
-
   return focusable;
 }
 
 static MxFocusable *
 mx_stack_accept_focus (MxFocusable *focusable, MxFocusHint hint)
 {
-  GList *c, *children;
+  ClutterActor *self = CLUTTER_ACTOR (focusable);
   MxStackPrivate *priv = MX_STACK (focusable)->priv;
+  ClutterActor *child;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
   focusable = NULL;
 
   switch (hint)
@@ -146,33 +139,30 @@ mx_stack_accept_focus (MxFocusable *focusable, MxFocusHint hint)
 
     case MX_FOCUS_HINT_FIRST:
     case MX_FOCUS_HINT_LAST:
-      if (hint == MX_FOCUS_HINT_LAST)
-        children = g_list_reverse (children);
+      child = (hint == MX_FOCUS_HINT_LAST) ?
+        clutter_actor_get_last_child (self) :
+        clutter_actor_get_first_child (self);
 
-      if (children)
+      while (child && !focusable)
         {
-          c = children;
-          while (c && !focusable)
-            {
-              ClutterActor *child = c->data;
-              c = c->next;
-
-              if (!MX_IS_FOCUSABLE (child))
-                continue;
-
-              if (MX_IS_WIDGET (child) &&
-                  mx_widget_get_disabled ((MxWidget *)child))
-                continue;
+          ClutterActor *next = (hint == MX_FOCUS_HINT_LAST) ?
+            clutter_actor_get_previous_sibling (child) :
+            clutter_actor_get_next_sibling (child);
 
+          if (MX_IS_FOCUSABLE (child) &&
+              (!MX_IS_WIDGET (child) ||
+               !mx_widget_get_disabled ((MxWidget *)child)))
+            {
               priv->current_focus = child;
               focusable = mx_focusable_accept_focus (MX_FOCUSABLE (child),
                                                      hint);
             }
+
+          child = next;
         }
       break;
     }
 
-  g_list_free (children);
   return focusable;
 }
 
@@ -477,15 +467,87 @@ mx_stack_allocate (ClutterActor           *actor,
     }
 }
 
+/* Whether @child paints or picks (when @pick is set) the whole of the
+ * stack, so that the children below it can be skipped */
+static gboolean
+mx_stack_child_covers (ClutterActor *actor,
+                       ClutterActor *child,
+                       gboolean      pick)
+{
+  MxStackChild *meta;
+  ClutterActorBox box;
+  gfloat width, height, x, y;
+
+  if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+    return FALSE;
+
+  meta = (MxStackChild *)
+    clutter_container_get_child_meta (CLUTTER_CONTAINER (actor), child);
+
+  if (!meta->opaque)
+    {
+      ClutterColor *color = NULL;
+
+      if (MX_IS_WIDGET (child))
+        color = mx_widget_get_background_color (MX_WIDGET (child));
+
+      if (!color || color->alpha != 0xff)
+        return FALSE;
+    }
+
+  /* a child that isn't reactive lets the pick through, and one that isn't
+   * fully opaque lets the children below show */
+  if (pick ? !clutter_actor_get_reactive (child) :
+      clutter_actor_get_paint_opacity (child) != 0xff)
+    return FALSE;
+
+  /* the allocation of the child has to be where it paints */
+  if (clutter_actor_has_effects (child) ||
+      clutter_actor_has_clip (child) ||
+      clutter_actor_is_rotated (child) ||
+      clutter_actor_is_scaled (child))
+    return FALSE;
+
+  clutter_actor_get_translation (child, &x, &y, NULL);
+  if (x != 0 || y != 0)
+    return FALSE;
+
+  clutter_actor_get_allocation_box (child, &box);
+  clutter_actor_get_size (actor, &width, &height);
+
+  return (box.x1 <= 0 && box.y1 <= 0 && box.x2 >= width && box.y2 >= height);
+}
+
+/* Finds the topmost child that covers the stack, or %NULL */
+static ClutterActor *
+mx_stack_get_occluder (ClutterActor *actor,
+                       gboolean      pick)
+{
+  ClutterActor *child;
+
+  for (child = clutter_actor_get_last_child (actor);
+       child;
+       child = clutter_actor_get_previous_sibling (child))
+    {
+      if (mx_stack_child_covers (actor, child, pick))
+        return child;
+    }
+
+  return NULL;
+}
+
 static void
-mx_stack_paint_children (ClutterActor *actor)
+mx_stack_paint_children (ClutterActor *actor,
+                         ClutterActor *first)
 {
   MxStackPrivate *priv = MX_STACK (actor)->priv;
-  ClutterActorIter iter;
   ClutterActor *child;
 
-  clutter_actor_iter_init (&iter, actor);
-  while (clutter_actor_iter_next (&iter, &child))
+  /* the children below @first are covered by it */
+  if (!first)
+    first = clutter_actor_get_first_child (actor);
+
+  for (child = first; child; child = clutter_actor_get_next_sibling (child))
     {
       gboolean crop;
 
@@ -519,7 +581,7 @@ mx_stack_paint (ClutterActor *actor)
   CLUTTER_ACTOR_CLASS (mx_stack_parent_class)->paint (actor);
 
 
-  mx_stack_paint_children (actor);
+  mx_stack_paint_children (actor, mx_stack_get_occluder (actor, FALSE));
 }
 
 static void
@@ -528,7 +590,7 @@ mx_stack_pick (ClutterActor       *actor,
 {
   CLUTTER_ACTOR_CLASS (mx_stack_parent_class)->pick (actor, color);
 
-  mx_stack_paint_children (actor);
+  mx_stack_paint_children (actor, mx_stack_get_occluder (actor, TRUE));
 }
 
 static void
@@ -42,10 +42,12 @@
 #include <gobject/gvaluecollector.h>
 #include <gobject/gobjectnotifyqueue.c>
 
+#include "mx-css.h"
 #include "mx-marshal.h"
 #include "mx-private.h"
 #include "mx-stylable.h"
 #include "mx-settings.h"
+#include "mx-widget-private.h"
 
 
 #include <cogl-pango/cogl-pango.h>
@@ -65,12 +67,41 @@ static GObjectNotifyContext property_notify_context = { 0, };
 
 static GParamSpecPool *style_property_spec_pool = NULL;
 
+/* installed style properties by id; the id is also kept in the param_id of
+ * the pspec, which the pool does not use */
+static GPtrArray *style_property_ids = NULL;
+
 static GQuark quark_real_owner         = 0;
 static GQuark quark_style              = 0;
 
 static guint stylable_signals[LAST_SIGNAL] = { 0, };
 
+/* Pseudo-classes are given a bit each, so that the set of pseudo-classes on
+ * a stylable can be tested against a selector with a mask. The common states
+ * are registered up front and any others are registered the first time they
+ * are seen, until the bits run out.
+ */
+#define MX_STYLABLE_N_PSEUDO_CLASS_BITS 64
+
+static GHashTable *pseudo_class_bits = NULL;
+static guint       n_pseudo_class_bits = 0;
+
+/* style sheets may be parsed on other threads */
+G_LOCK_DEFINE_STATIC (pseudo_class_bits);
+
+/* stylables waiting for style-changed at the next frame, with the OR of
+ * their pending flags */
+static GHashTable *pending_style_changes = NULL;
+static guint       pending_style_changes_id = 0;
+
+/* stylables whose style changed between mx_stylable_begin_update() and
+ * mx_stylable_end_update(), with the OR of their flags */
+static GHashTable *batched_style_changes = NULL;
+static guint       batch_depth = 0;
+
 static void mx_stylable_property_changed_notify (MxStylable *stylable);
+static void mx_stylable_style_sheet_changed_notify (MxStylable *stylable,
+                                                    MxStyle    *style);
 
 static void
 mx_stylable_notify_dispatcher (GObject     *gobject,
@@ -203,80 +234,112 @@ mx_stylable_get_type (void)
   return our_type;
 }
 
-static void
-_mx_stylable_prepend_style_string (GString    *string,
-                                   MxStylable *stylable)
+static guint64
+mx_stylable_pseudo_class_get_bit (const gchar *name)
 {
-  GType type_id;
-  gchar *style_string;
-  const gchar *type, *id, *class, *pseudo_class;
+  gpointer bit;
 
-  type_id = G_OBJECT_CLASS_TYPE (G_OBJECT_GET_CLASS (stylable));
-  type = g_type_name (type_id);
+  G_LOCK (pseudo_class_bits);
 
-  id = clutter_actor_get_name ((ClutterActor*) stylable);
+  if (G_UNLIKELY (!pseudo_class_bits))
+    {
+      static const gchar *builtin[] = { "hover", "active", "focus",
+                                        "checked", "disabled" };
+      gint i;
+
+      pseudo_class_bits = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 g_free, NULL);
+
+      for (i = 0; i < G_N_ELEMENTS (builtin); i++)
+        g_hash_table_insert (pseudo_class_bits, g_strdup (builtin[i]),
+                             GUINT_TO_POINTER (++n_pseudo_class_bits));
+    }
+
+  /* bits are stored offset by one, so that zero means unregistered */
+  bit = g_hash_table_lookup (pseudo_class_bits, name);
+
+  if (!bit && n_pseudo_class_bits < MX_STYLABLE_N_PSEUDO_CLASS_BITS)
+    {
+      bit = GUINT_TO_POINTER (++n_pseudo_class_bits);
+      g_hash_table_insert (pseudo_class_bits, g_strdup (name), bit);
+    }
 
-  class = mx_stylable_get_style_class (stylable);
+  G_UNLOCK (pseudo_class_bits);
 
-  pseudo_class = mx_stylable_get_style_pseudo_class (stylable);
+  if (!bit)
+    return 0;
 
-  style_string = g_strconcat (type,
-                              "#", id ? id : "",
-                              ".", class ? class : "",
-                              ":", pseudo_class ? pseudo_class : "",
-                              ">",
-                              NULL);
-  g_string_prepend (string, style_string);
-  g_free (style_string);
+  return G_GUINT64_CONSTANT (1) << (GPOINTER_TO_UINT (bit) - 1);
 }
 
-gchar *
-_mx_stylable_get_style_string (MxStylable *stylable)
+/*
+ * _mx_stylable_pseudo_class_to_mask:
+ * @pseudo_class: a list of pseudo-classes, separated by ':', or %NULL
+ * @complete: (out) (allow-none): return location for whether every
+ *   pseudo-class in the list could be represented in the mask
+ *
+ * Returns: the mask of the pseudo-classes in @pseudo_class
+ */
+guint64
+_mx_stylable_pseudo_class_to_mask (const gchar *pseudo_class,
+                                   gboolean    *complete)
 {
-  GType type_id;
-  gchar *cstring;
-  GString *string;
-  const gchar *type, *id, *class, *pseudo_class;
-  ClutterActor *actor;
-  ClutterActor *parent;
+  const gchar *start, *end;
+  guint64 mask = 0;
 
-  /* Create a string that contains all the properties of a
-   * Stylable that can be matched against in the CSS.
-   */
-  type_id = G_OBJECT_CLASS_TYPE (G_OBJECT_GET_CLASS (stylable));
-  type = g_type_name (type_id);
+  if (complete)
+    *complete = TRUE;
+
+  if (!pseudo_class)
+    return 0;
 
-  actor = CLUTTER_ACTOR (stylable);
+  for (start = pseudo_class; *start; start = (*end) ? end + 1 : end)
+    {
+      gchar buf[64], *name;
+      gsize len;
+      guint64 bit;
 
-  id = clutter_actor_get_name (actor);
+      end = strchr (start, ':');
+      if (!end)
+        end = start + strlen (start);
 
-  class = mx_stylable_get_style_class (stylable);
+      len = end - start;
+      if (len == 0)
+        continue;
 
-  pseudo_class = mx_stylable_get_style_pseudo_class (stylable);
+      /* avoid allocating for the usual short names */
+      if (len < sizeof (buf))
+        {
+          memcpy (buf, start, len);
+          buf[len] = '\0';
+          name = buf;
+        }
+      else
+        name = g_strndup (start, len);
 
-  string = g_string_sized_new (512);
+      bit = mx_stylable_pseudo_class_get_bit (name);
 
-  /* Add the actor hierarchy */
-  parent = clutter_actor_get_parent (actor);
+      if (name != buf)
+        g_free (name);
 
-  while (parent)
-    {
-      if (MX_IS_STYLABLE (parent))
-        _mx_stylable_prepend_style_string (string, (MxStylable*) parent);
+      if (!bit && complete)
+        *complete = FALSE;
 
-      parent = clutter_actor_get_parent (parent);
+      mask |= bit;
     }
 
-  g_string_append_printf (string, "%s#%s.%s:%s",
-                          type,
-                          id ? id : "",
-                          class ? class : "",
-                          pseudo_class ? pseudo_class : "");
+  return mask;
+}
 
-  cstring = string->str;
-  g_string_free (string, FALSE);
+guint64
+_mx_stylable_get_style_pseudo_class_mask (MxStylable *stylable)
+{
+  /* widgets keep their mask up to date as the pseudo-class changes */
+  if (MX_IS_WIDGET (stylable))
+    return _mx_widget_get_style_pseudo_class_mask ((MxWidget *) stylable);
 
-  return cstring;
+  return _mx_stylable_pseudo_class_to_mask (
+           mx_stylable_get_style_pseudo_class (stylable), NULL);
 }
 
 #if 0
@@ -383,18 +446,24 @@ mx_stylable_notify (MxStylable  *stylable,
  *     }
  * }
  * </programlisting></informalexample>
+ *
+ * The returned identifier can be used with the typed getters, such as
+ * mx_stylable_get_float_by_id(), which are quicker than looking up the
+ * property by name.
+ *
+ * Returns: an identifier for the style property, or 0 on error
  */
-void
+guint
 mx_stylable_iface_install_property (MxStylableIface *iface,
                                     GType            owner_type,
                                     GParamSpec      *pspec)
 {
-  g_return_if_fail (MX_IS_STYLABLE_IFACE (iface));
-  g_return_if_fail (owner_type != G_TYPE_INVALID);
-  g_return_if_fail (G_IS_PARAM_SPEC (pspec));
-  g_return_if_fail (pspec->flags & G_PARAM_READABLE);
-  g_return_if_fail (!(pspec->flags & (G_PARAM_CONSTRUCT_ONLY | G_PARAM_CONSTRUCT
-                                      )));
+  g_return_val_if_fail (MX_IS_STYLABLE_IFACE (iface), 0);
+  g_return_val_if_fail (owner_type != G_TYPE_INVALID, 0);
+  g_return_val_if_fail (G_IS_PARAM_SPEC (pspec), 0);
+  g_return_val_if_fail (pspec->flags & G_PARAM_READABLE, 0);
+  g_return_val_if_fail (!(pspec->flags & (G_PARAM_CONSTRUCT_ONLY | G_PARAM_CONSTRUCT
+                                          )), 0);
 
   if (g_param_spec_pool_lookup (style_property_spec_pool, pspec->name,
                                 owner_type,
@@ -404,7 +473,7 @@ mx_stylable_iface_install_property (MxStylableIface *iface,
                  G_STRLOC,
                  g_type_name (owner_type),
                  pspec->name);
-      return;
+      return 0;
     }
 
   g_param_spec_ref_sink (pspec);
@@ -415,6 +484,18 @@ mx_stylable_iface_install_property (MxStylableIface *iface,
   g_param_spec_pool_insert (style_property_spec_pool,
                             pspec,
                             owner_type);
+
+  /* id 0 is never given out */
+  if (G_UNLIKELY (!style_property_ids))
+    {
+      style_property_ids = g_ptr_array_new ();
+      g_ptr_array_add (style_property_ids, NULL);
+    }
+
+  pspec->param_id = style_property_ids->len;
+  g_ptr_array_add (style_property_ids, pspec);
+
+  return pspec->param_id;
 }
 
 /**
@@ -542,6 +623,230 @@ mx_stylable_get_style_property (MxStylable  *stylable,
   mx_stylable_get_property_internal (stylable, pspec, value);
 }
 
+/* the value of the style property @id of @stylable, without copying it if
+ * possible; see _mx_style_peek_property() */
+static const GValue *
+mx_stylable_peek_by_id (MxStylable *stylable,
+                        guint       id,
+                        GType       value_type,
+                        GValue     *scratch)
+{
+  MxStyle *style;
+  GParamSpec *pspec;
+
+  g_return_val_if_fail (MX_IS_STYLABLE (stylable), NULL);
+  g_return_val_if_fail (style_property_ids != NULL, NULL);
+  g_return_val_if_fail (id > 0 && id < style_property_ids->len, NULL);
+
+  pspec = g_ptr_array_index (style_property_ids, id);
+
+  /* the pool records the owner type in the pspec */
+  g_return_val_if_fail (g_type_is_a (G_OBJECT_TYPE (stylable),
+                                     pspec->owner_type), NULL);
+  g_return_val_if_fail (g_type_is_a (G_PARAM_SPEC_VALUE_TYPE (pspec),
+                                     value_type), NULL);
+
+  style = mx_stylable_get_style (stylable);
+  if (!style)
+    return NULL;
+
+  return _mx_style_peek_property (style, stylable, pspec, scratch);
+}
+
+/**
+ * mx_stylable_get_float_by_id:
+ * @stylable: a #MxStylable
+ * @id: the identifier of a float style property, as returned by
+ *   mx_stylable_iface_install_property()
+ *
+ * Gets the value of a float style property of @stylable, like
+ * mx_stylable_get(), but without looking it up by name.
+ *
+ * Returns: the value of the style property
+ *
+ * Since: 2.0
+ */
+gfloat
+mx_stylable_get_float_by_id (MxStylable *stylable,
+                             guint       id)
+{
+  GValue scratch = G_VALUE_INIT;
+  const GValue *value;
+  gfloat result = 0;
+
+  value = mx_stylable_peek_by_id (stylable, id, G_TYPE_FLOAT, &scratch);
+  if (value)
+    result = g_value_get_float (value);
+
+  if (G_IS_VALUE (&scratch))
+    g_value_unset (&scratch);
+
+  return result;
+}
+
+/**
+ * mx_stylable_get_int_by_id:
+ * @stylable: a #MxStylable
+ * @id: the identifier of an integer style property, as returned by
+ *   mx_stylable_iface_install_property()
+ *
+ * Gets the value of an integer style property of @stylable, like
+ * mx_stylable_get(), but without looking it up by name.
+ *
+ * Returns: the value of the style property
+ *
+ * Since: 2.0
+ */
+gint
+mx_stylable_get_int_by_id (MxStylable *stylable,
+                           guint       id)
+{
+  GValue scratch = G_VALUE_INIT;
+  const GValue *value;
+  gint result = 0;
+
+  value = mx_stylable_peek_by_id (stylable, id, G_TYPE_INT, &scratch);
+  if (value)
+    result = g_value_get_int (value);
+
+  if (G_IS_VALUE (&scratch))
+    g_value_unset (&scratch);
+
+  return result;
+}
+
+/**
+ * mx_stylable_get_uint_by_id:
+ * @stylable: a #MxStylable
+ * @id: the identifier of an unsigned integer style property, as returned
+ *   by mx_stylable_iface_install_property()
+ *
+ * Gets the value of an unsigned integer style property of @stylable, like
+ * mx_stylable_get(), but without looking it up by name.
+ *
+ * Returns: the value of the style property
+ *
+ * Since: 2.0
+ */
+guint
+mx_stylable_get_uint_by_id (MxStylable *stylable,
+                            guint       id)
+{
+  GValue scratch = G_VALUE_INIT;
+  const GValue *value;
+  guint result = 0;
+
+  value = mx_stylable_peek_by_id (stylable, id, G_TYPE_UINT, &scratch);
+  if (value)
+    result = g_value_get_uint (value);
+
+  if (G_IS_VALUE (&scratch))
+    g_value_unset (&scratch);
+
+  return result;
+}
+
+/**
+ * mx_stylable_get_boolean_by_id:
+ * @stylable: a #MxStylable
+ * @id: the identifier of a boolean style property, as returned by
+ *   mx_stylable_iface_install_property()
+ *
+ * Gets the value of a boolean style property of @stylable, like
+ * mx_stylable_get(), but without looking it up by name.
+ *
+ * Returns: the value of the style property
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_stylable_get_boolean_by_id (MxStylable *stylable,
+                               guint       id)
+{
+  GValue scratch = G_VALUE_INIT;
+  const GValue *value;
+  gboolean result = FALSE;
+
+  value = mx_stylable_peek_by_id (stylable, id, G_TYPE_BOOLEAN, &scratch);
+  if (value)
+    result = g_value_get_boolean (value);
+
+  if (G_IS_VALUE (&scratch))
+    g_value_unset (&scratch);
+
+  return result;
+}
+
+/**
+ * mx_stylable_get_enum_by_id:
+ * @stylable: a #MxStylable
+ * @id: the identifier of an enumeration style property, as returned by
+ *   mx_stylable_iface_install_property()
+ *
+ * Gets the value of an enumeration style property of @stylable, like
+ * mx_stylable_get(), but without looking it up by name.
+ *
+ * Returns: the value of the style property
+ *
+ * Since: 2.0
+ */
+gint
+mx_stylable_get_enum_by_id (MxStylable *stylable,
+                            guint       id)
+{
+  GValue scratch = G_VALUE_INIT;
+  const GValue *value;
+  gint result = 0;
+
+  value = mx_stylable_peek_by_id (stylable, id, G_TYPE_ENUM, &scratch);
+  if (value)
+    result = g_value_get_enum (value);
+
+  if (G_IS_VALUE (&scratch))
+    g_value_unset (&scratch);
+
+  return result;
+}
+
+/**
+ * mx_stylable_get_color_by_id:
+ * @stylable: a #MxStylable
+ * @id: the identifier of a #ClutterColor style property, as returned by
+ *   mx_stylable_iface_install_property()
+ * @color: (out caller-allocates): return location for the color
+ *
+ * Gets the value of a color style property of @stylable, like
+ * mx_stylable_get(), but without looking it up by name or allocating a
+ * copy of the color.
+ *
+ * Returns: %TRUE if the style property has a color, and @color was set
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_stylable_get_color_by_id (MxStylable   *stylable,
+                             guint         id,
+                             ClutterColor *color)
+{
+  GValue scratch = G_VALUE_INIT;
+  const GValue *value;
+  const ClutterColor *result = NULL;
+
+  g_return_val_if_fail (color != NULL, FALSE);
+
+  value = mx_stylable_peek_by_id (stylable, id, CLUTTER_TYPE_COLOR, &scratch);
+  if (value)
+    result = g_value_get_boxed (value);
+
+  if (result)
+    *color = *result;
+
+  if (G_IS_VALUE (&scratch))
+    g_value_unset (&scratch);
+
+  return (result != NULL);
+}
+
 /**
  * mx_stylable_get:
  * @stylable: a #MxStylable
@@ -651,6 +956,69 @@ _set_from_xsettings (GParamSpec *pspec,
   return result;
 }
 
+typedef struct
+{
+  GValue   value;
+  guint    settings_serial;
+  gboolean has_resolution;
+  gdouble  resolution;
+} MxStylableDefaultValue;
+
+static void
+mx_stylable_default_value_free (MxStylableDefaultValue *cached)
+{
+  g_value_unset (&cached->value);
+  g_slice_free (MxStylableDefaultValue, cached);
+}
+
+/* Like mx_stylable_get_default_value(), for a known @pspec. The defaults
+ * that come from the settings are expensive to work out, so they are kept
+ * with the pspec until the settings, or for the font size the resolution,
+ * change. */
+void
+_mx_stylable_get_default_value_for_pspec (GParamSpec *pspec,
+                                          GValue     *value_out)
+{
+  static GQuark quark_default = 0;
+  MxStylableDefaultValue *cached;
+  gdouble resolution = 0;
+  guint serial;
+
+  if (G_UNLIKELY (!quark_default))
+    quark_default = g_quark_from_static_string ("mx-stylable-default-value");
+
+  serial = _mx_stylable_get_font_settings_serial ();
+  cached = g_param_spec_get_qdata (pspec, quark_default);
+
+  if (cached && cached->has_resolution)
+    resolution =
+      clutter_backend_get_resolution (clutter_get_default_backend ());
+
+  if (!cached || cached->settings_serial != serial ||
+      (cached->has_resolution && cached->resolution != resolution))
+    {
+      cached = g_slice_new0 (MxStylableDefaultValue);
+      cached->settings_serial = serial;
+      cached->has_resolution = !strcmp (pspec->name, "font-size");
+      if (cached->has_resolution)
+        cached->resolution =
+          clutter_backend_get_resolution (clutter_get_default_backend ());
+
+      g_value_init (&cached->value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+
+      /* default font values come from xsettings if possible */
+      if (!_set_from_xsettings (pspec, &cached->value))
+        g_param_value_set_default (pspec, &cached->value);
+
+      g_param_spec_set_qdata_full (pspec, quark_default, cached,
+                                   (GDestroyNotify)
+                                   mx_stylable_default_value_free);
+    }
+
+  g_value_init (value_out, G_PARAM_SPEC_VALUE_TYPE (pspec));
+  g_value_copy (&cached->value, value_out);
+}
+
 /**
  * mx_stylable_get_default_value:
  * @stylable: a #MxStylable
@@ -688,11 +1056,7 @@ mx_stylable_get_default_value (MxStylable  *stylable,
       return FALSE;
     }
 
-  g_value_init (value_out, G_PARAM_SPEC_VALUE_TYPE (pspec));
-
-  /* default font values come from xsettings if possible */
-  if (!_set_from_xsettings (pspec, value_out))
-    g_param_value_set_default (pspec, value_out);
+  _mx_stylable_get_default_value_for_pspec (pspec, value_out);
 
   return TRUE;
 }
@@ -761,7 +1125,7 @@ mx_stylable_set_style_internal (MxStylable *stylable,
       data->instance = g_object_ref_sink (style);
       data->handler_id =
         g_signal_connect_swapped (style, "changed",
-                                  G_CALLBACK (mx_stylable_property_changed_notify),
+                                  G_CALLBACK (mx_stylable_style_sheet_changed_notify),
                                   stylable);
 
       g_object_set_qdata_full (G_OBJECT (stylable),
@@ -769,6 +1133,9 @@ mx_stylable_set_style_internal (MxStylable *stylable,
                                data,
                                (GDestroyNotify) disconnect_style_changed_signal);
 
+      /* the cached state belongs to the previous style, so it can't tell
+       * whether the children are affected */
+      _mx_style_invalidate_cache (stylable);
       mx_stylable_style_changed (stylable, MX_STYLE_CHANGED_INVALIDATE_CACHE);
 
       g_object_notify (G_OBJECT (stylable), "style");
@@ -868,10 +1235,17 @@ mx_stylable_style_pseudo_class_contains (MxStylable  *stylable,
                                          const gchar *pseudo_class)
 {
   const gchar *old_class, *match;
+  gboolean complete;
+  guint64 bit;
 
   g_return_val_if_fail (MX_IS_STYLABLE (stylable), FALSE);
   g_return_val_if_fail (pseudo_class != NULL, FALSE);
 
+  /* a single registered pseudo-class can be checked against the mask */
+  bit = _mx_stylable_pseudo_class_to_mask (pseudo_class, &complete);
+  if (complete && bit && !strchr (pseudo_class, ':'))
+    return (_mx_stylable_get_style_pseudo_class_mask (stylable) & bit) != 0;
+
   old_class = mx_stylable_get_style_pseudo_class (stylable);
 
   if (old_class && pseudo_class && (match = strstr (old_class, pseudo_class)))
@@ -879,7 +1253,7 @@ mx_stylable_style_pseudo_class_contains (MxStylable  *stylable,
       if ((match == old_class) ||
            (match[-1] == ':'))
         {
-          size_t length = strlen (match);
+          size_t length = strlen (pseudo_class);
           if ((match[length] == ':') ||
               (match[length] == '\0'))
             return TRUE;
@@ -1039,6 +1413,17 @@ mx_stylable_property_changed_notify (MxStylable *stylable)
   mx_stylable_style_changed (stylable, MX_STYLE_CHANGED_INVALIDATE_CACHE);
 }
 
+static void
+mx_stylable_style_sheet_changed_notify (MxStylable *stylable,
+                                        MxStyle    *style)
+{
+  /* a reloaded style sheet only restyles what its changes could affect */
+  if (!_mx_style_change_affects (style, stylable))
+    return;
+
+  mx_stylable_style_changed (stylable, MX_STYLE_CHANGED_INVALIDATE_CACHE);
+}
+
 static void
 mx_stylable_parent_set_notify (ClutterActor *actor,
                                ClutterActor *old_parent)
@@ -1056,10 +1441,57 @@ mx_stylable_parent_set_notify (ClutterActor *actor,
 static void mx_stylable_style_changed_internal (MxStylable          *stylable,
                                                 MxStyleChangedFlags  flags);
 
+/* set on the flags kept for a frozen actor, so that it is frozen even when
+ * no style change is pending */
+#define MX_STYLE_CHANGED_FROZEN (1 << 9)
+
+static GQuark
+mx_stylable_frozen_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (G_UNLIKELY (!quark))
+    quark = g_quark_from_static_string ("mx-stylable-frozen");
+
+  return quark;
+}
+
+/* Stops the style changes of the ancestors of @actor from propagating into
+ * it, for actors that can't be seen, such as the hidden pages of an
+ * #MxNotebook. The changes are collected and @actor is restyled once when
+ * it is thawed. */
+void
+_mx_stylable_set_frozen (ClutterActor *actor,
+                         gboolean      frozen)
+{
+  GQuark quark = mx_stylable_frozen_quark ();
+  guint pending;
+
+  pending = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (actor), quark));
+
+  if (frozen)
+    {
+      if (!pending)
+        g_object_set_qdata (G_OBJECT (actor), quark,
+                            GUINT_TO_POINTER (MX_STYLE_CHANGED_FROZEN));
+      return;
+    }
+
+  if (!pending)
+    return;
+
+  g_object_set_qdata (G_OBJECT (actor), quark, NULL);
+
+  pending &= ~MX_STYLE_CHANGED_FROZEN;
+  if (pending)
+    mx_stylable_style_changed_internal ((MxStylable *) actor, pending);
+}
+
 static void
 mx_stylable_style_changed_internal (MxStylable          *stylable,
                                     MxStyleChangedFlags  flags)
 {
+  GQuark frozen_quark = mx_stylable_frozen_quark ();
   ClutterActorIter iter;
   MxStylable *child;
 
@@ -1081,6 +1513,10 @@ mx_stylable_style_changed_internal (MxStylable          *stylable,
        */
       flags |= MX_STYLE_CHANGED_INVALIDATE_CACHE;
 
+      if (G_UNLIKELY (_mx_debug (MX_DEBUG_CSS_PROFILE)))
+        mx_style_sheet_profile_restyle (G_OBJECT_TYPE (stylable));
+
+      _mx_frame_stats_count (MX_FRAME_STATS_RESTYLED);
       g_signal_emit (stylable, stylable_signals[STYLE_CHANGED], 0, flags);
     }
 
@@ -1089,178 +1525,703 @@ mx_stylable_style_changed_internal (MxStylable          *stylable,
   clutter_actor_iter_init (&iter, CLUTTER_ACTOR (stylable));
   while (clutter_actor_iter_next (&iter, (ClutterActor **) &child))
     {
+      guint frozen = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (child),
+                                                           frozen_quark));
+
+      if (frozen)
+        {
+          g_object_set_qdata (G_OBJECT (child), frozen_quark,
+                              GUINT_TO_POINTER (frozen | flags));
+          continue;
+        }
+
       mx_stylable_style_changed_internal (child, flags);
     }
 }
 
-/**
- * mx_stylable_style_changed:
- * @stylable: an MxStylable
- * @flags: flags that control the style changing
- *
- * Emit the "style-changed" signal on @stylable to notify it that one or more
- * of the style properties has changed.
- *
- * If @stylable is a #ClutterContainer then the "style-changed" notification is
- * propagated to it's children, since their style may depend on one or more
- * properties of the parent.
- *
- */
-void
-mx_stylable_style_changed (MxStylable *stylable, MxStyleChangedFlags flags)
+static void
+mx_stylable_pending_style_change_weak_notify (gpointer  data,
+                                              GObject  *old_object)
 {
-  g_return_if_fail (MX_IS_STYLABLE (stylable));
-
-  mx_stylable_style_changed_internal (stylable, flags);
+  g_hash_table_remove (pending_style_changes, old_object);
 }
 
-void
-mx_stylable_connect_change_notifiers (MxStylable *stylable)
+/* a stylable does not need to be restyled on its own if one of its
+ * ancestors is restyled along with its children, as the style change
+ * propagates to it */
+static gboolean
+mx_stylable_has_pending_ancestor (MxStylable *stylable,
+                                  GHashTable *pending)
 {
-  g_return_if_fail (CLUTTER_IS_ACTOR (stylable));
-
-  g_return_if_fail (MX_IS_STYLABLE (stylable));
-
-  /* ClutterActor signals */
-  g_signal_connect (stylable, "notify::name",
-                    G_CALLBACK (mx_stylable_property_changed_notify), NULL);
-  g_signal_connect (stylable, "parent-set",
-                    G_CALLBACK (mx_stylable_parent_set_notify), NULL);
-
-  /* style-changed is blocked until the actor is realized, so style-changed
-   * needs to be sent as soon as the actor is mapped */
-  g_signal_connect (stylable, "notify::realized",
-                    G_CALLBACK (mx_stylable_property_changed_notify), NULL);
+  ClutterActor *parent;
+  gpointer flags;
 
-  /* MxStylable notifiers */
-  g_signal_connect (stylable, "notify::style-class",
-                    G_CALLBACK (mx_stylable_property_changed_notify), NULL);
-  g_signal_connect (stylable, "notify::style-pseudo-class",
-                    G_CALLBACK (mx_stylable_property_changed_notify), NULL);
+  for (parent = clutter_actor_get_parent (CLUTTER_ACTOR (stylable));
+       parent;
+       parent = clutter_actor_get_parent (parent))
+    {
+      if (g_hash_table_lookup_extended (pending, parent, NULL, &flags) &&
+          (GPOINTER_TO_UINT (flags) & MX_STYLE_CHANGED_CHILDREN))
+        return TRUE;
+    }
 
+  return FALSE;
 }
 
-void
-mx_stylable_disconnect_change_notifiers (MxStylable *stylable)
+static gboolean
+mx_stylable_flush_style_changes (gpointer data)
 {
-  g_return_if_fail (CLUTTER_IS_ACTOR (stylable));
+  gint64 start = _mx_frame_stats_begin (MX_FRAME_STATS_STYLE);
+  const gchar *reason = _mx_debug_redraw_reason_push ("style change");
 
-  g_return_if_fail (MX_IS_STYLABLE (stylable));
+  /* style-changed handlers may change the style of other stylables, and
+   * those are restyled in this same frame */
+  while (g_hash_table_size (pending_style_changes))
+    {
+      GHashTable *pending;
+      GHashTableIter iter;
+      GPtrArray *roots;
+      gpointer key, value;
+      guint i;
 
-  g_signal_handlers_disconnect_by_func (stylable,
-                                        mx_stylable_property_changed_notify,
-                                        NULL);
+      pending = pending_style_changes;
+      pending_style_changes = g_hash_table_new (NULL, NULL);
 
-  g_signal_handlers_disconnect_by_func (stylable, mx_stylable_parent_set_notify,
-                                        NULL);
-}
+      roots = g_ptr_array_new ();
 
-static void
-stylable_destroy_text_shadow (MxTextShadow *text_shadow)
-{
-  g_boxed_free (MX_TYPE_TEXT_SHADOW, text_shadow);
-}
+      g_hash_table_iter_init (&iter, pending);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          g_object_weak_unref (key,
+                               mx_stylable_pending_style_change_weak_notify,
+                               NULL);
 
-static void
-stylable_text_shadow_paint (ClutterText  *text,
-                            MxTextShadow *text_shadow)
-{
-  PangoLayout *layout;
-  CoglColor color;
-  ClutterActorBox box;
+          if (!mx_stylable_has_pending_ancestor (key, pending))
+            {
+              g_ptr_array_add (roots, g_object_ref (key));
+              g_ptr_array_add (roots, value);
+            }
+        }
 
-  cogl_color_init_from_4ub (&color,
-                            text_shadow->color.red,
-                            text_shadow->color.green,
-                            text_shadow->color.blue,
-                            text_shadow->color.alpha);
+      g_hash_table_destroy (pending);
 
-  /* pango layout */
-  layout = clutter_text_get_layout (text);
+      for (i = 0; i < roots->len; i += 2)
+        {
+          MxStylable *stylable = roots->pdata[i];
+          MxStyleChangedFlags flags = GPOINTER_TO_UINT (roots->pdata[i + 1]);
+
+          if (flags & MX_STYLE_CHANGED_CHILDREN)
+            mx_stylable_style_changed_internal (stylable,
+                                                flags &
+                                                ~MX_STYLE_CHANGED_CHILDREN);
+          else if (CLUTTER_ACTOR_IS_REALIZED (CLUTTER_ACTOR (stylable)))
+            {
+              /* nothing the children match against or inherit changed,
+               * so only this stylable needs restyling */
+              _mx_style_invalidate_cache (stylable);
+
+              if (G_UNLIKELY (_mx_debug (MX_DEBUG_CSS_PROFILE)))
+                mx_style_sheet_profile_restyle (G_OBJECT_TYPE (stylable));
+
+              _mx_frame_stats_count (MX_FRAME_STATS_RESTYLED);
+              g_signal_emit (stylable, stylable_signals[STYLE_CHANGED], 0,
+                             flags | MX_STYLE_CHANGED_INVALIDATE_CACHE);
+            }
+
+          g_object_unref (stylable);
+        }
+
+      g_ptr_array_free (roots, TRUE);
+    }
 
+  pending_style_changes_id = 0;
 
-  /* shadow position */
-  clutter_actor_get_allocation_box (CLUTTER_ACTOR (text), &box);
+  _mx_debug_redraw_reason_pop (reason);
+  _mx_frame_stats_end (MX_FRAME_STATS_STYLE, start);
+
+  return FALSE;
+}
 
-  cogl_pango_render_layout (layout,text_shadow->h_offset,
-                            text_shadow->v_offset, &color, 0);
+static void
+mx_stylable_batched_style_change_weak_notify (gpointer  data,
+                                              GObject  *old_object)
+{
+  g_hash_table_remove (batched_style_changes, old_object);
 }
 
+/**
+ * mx_stylable_begin_update:
+ *
+ * Starts a batch of style changes, such as setting the style class or
+ * pseudo-class of many stylables at once. Until the matching call to
+ * mx_stylable_end_update(), the changes are only recorded; working out
+ * what they affect then happens once for each stylable that changed,
+ * however many times it did.
+ *
+ * Style properties read during the batch may not reflect the changes
+ * made in it yet. Calls can be nested, and the changes are applied when
+ * the outermost batch ends.
+ *
+ * Since: 2.0
+ */
 void
-mx_stylable_apply_clutter_text_attributes (MxStylable  *stylable,
-                                           ClutterText *text)
+mx_stylable_begin_update (void)
 {
-  ClutterColor *real_color = NULL;
-  gchar *font_name = NULL;
-  gint font_size = 0;
-  MxFontWeight font_weight;
-  PangoWeight weight;
-  PangoFontDescription *descr;
-  gchar *descr_string;
-  MxTextShadow *text_shadow;
-  MxTextShadow *old_text_shadow;
-  MxTextAlign text_align;
-  PangoAlignment pango_align;
+  batch_depth ++;
+}
 
-  static GQuark stylable_text_shadow_quark = 0;
+/**
+ * mx_stylable_end_update:
+ *
+ * Ends a batch of style changes started with mx_stylable_begin_update().
+ * When the outermost batch ends, the stylables that changed in it are
+ * restyled along with the next frame, as if they had changed now.
+ *
+ * Since: 2.0
+ */
+void
+mx_stylable_end_update (void)
+{
+  GHashTable *batched;
+  GHashTableIter iter;
+  GPtrArray *changed;
+  gpointer key, value;
+  guint i;
 
-  if (!stylable_text_shadow_quark)
-   stylable_text_shadow_quark = g_quark_from_static_string ("stylable-text-shadow");
+  g_return_if_fail (batch_depth > 0);
 
+  if (--batch_depth || !batched_style_changes)
+    return;
 
-  mx_stylable_get (stylable,
-                   "color", &real_color,
-                   "font-family", &font_name,
-                   "font-size", &font_size,
-                   "font-weight", &font_weight,
-                   "text-shadow", &text_shadow,
-                   "text-align", &text_align,
-                   NULL);
+  batched = batched_style_changes;
+  batched_style_changes = NULL;
 
+  changed = g_ptr_array_sized_new (g_hash_table_size (batched) * 2);
 
-  old_text_shadow = g_object_get_qdata (G_OBJECT (text),
-                                        stylable_text_shadow_quark);
+  g_hash_table_iter_init (&iter, batched);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      g_object_weak_unref (key,
+                           mx_stylable_batched_style_change_weak_notify,
+                           NULL);
+      g_ptr_array_add (changed, g_object_ref (key));
+      g_ptr_array_add (changed, value);
+    }
+
+  g_hash_table_destroy (batched);
 
-  if (text_shadow)
+  for (i = 0; i < changed->len; i += 2)
     {
-      if (!old_text_shadow)
-        {
-          g_signal_connect (text, "paint",
-                            G_CALLBACK (stylable_text_shadow_paint),
-                            text_shadow);
+      MxStylable *stylable = changed->pdata[i];
 
-          g_object_set_qdata_full (G_OBJECT (text), stylable_text_shadow_quark,
-                                   text_shadow,
-                                   (GDestroyNotify) stylable_destroy_text_shadow);
-        }
+      mx_stylable_style_changed (stylable,
+                                 GPOINTER_TO_UINT (changed->pdata[i + 1]));
+      g_object_unref (stylable);
+    }
+
+  g_ptr_array_free (changed, TRUE);
+}
+
+/**
+ * mx_stylable_style_changed:
+ * @stylable: an MxStylable
+ * @flags: flags that control the style changing
+ *
+ * Emit the "style-changed" signal on @stylable to notify it that one or more
+ * of the style properties has changed.
+ *
+ * If @stylable is a #ClutterContainer then the "style-changed" notification is
+ * propagated to it's children, since their style may depend on one or more
+ * properties of the parent.
+ *
+ * Unless @flags contains %MX_STYLE_CHANGED_FORCE, the signal is emitted
+ * once per frame, before the stage is laid out, however many times the
+ * style of @stylable changed since the last frame.
+ */
+void
+mx_stylable_style_changed (MxStylable *stylable, MxStyleChangedFlags flags)
+{
+  gpointer old_flags;
+
+  g_return_if_fail (MX_IS_STYLABLE (stylable));
+
+  if ((flags & MX_STYLE_CHANGED_FORCE) || !CLUTTER_IS_ACTOR (stylable))
+    {
+      gint64 start = _mx_frame_stats_begin (MX_FRAME_STATS_STYLE);
+      const gchar *reason = _mx_debug_redraw_reason_push ("style change");
+
+      mx_stylable_style_changed_internal (stylable, flags);
+
+      _mx_debug_redraw_reason_pop (reason);
+      _mx_frame_stats_end (MX_FRAME_STATS_STYLE, start);
+      return;
+    }
+
+  /* unrealized stylables are restyled when they are realized */
+  if (!CLUTTER_ACTOR_IS_REALIZED (CLUTTER_ACTOR (stylable)))
+    return;
+
+  /* within a batch, only collect the change; the style key still matches
+   * the style before the batch, so that mx_stylable_end_update() compares
+   * the state before and after it once */
+  if (batch_depth)
+    {
+      if (G_UNLIKELY (!batched_style_changes))
+        batched_style_changes = g_hash_table_new (NULL, NULL);
+
+      if (g_hash_table_lookup_extended (batched_style_changes, stylable, NULL,
+                                        &old_flags))
+        flags |= GPOINTER_TO_UINT (old_flags);
       else
-        {
-          *old_text_shadow = *text_shadow;
-          g_boxed_free (MX_TYPE_TEXT_SHADOW, text_shadow);
-        }
+        g_object_weak_ref (G_OBJECT (stylable),
+                           mx_stylable_batched_style_change_weak_notify,
+                           NULL);
+
+      g_hash_table_insert (batched_style_changes, stylable,
+                           GUINT_TO_POINTER (flags));
+      return;
     }
+
+  /* make sure reading style properties before the next frame already sees
+   * the change on this stylable, and find out if the children have to be
+   * restyled too: a change in the name, style class or pseudo-class of
+   * @stylable only affects them if a selector tests it in a parent or
+   * ancestor position, or if it changes a property they inherit */
+  if (!(flags & MX_STYLE_CHANGED_INVALIDATE_CACHE) ||
+      _mx_style_invalidate_cache_for_change (stylable))
+    flags |= MX_STYLE_CHANGED_CHILDREN;
+
+  if (G_UNLIKELY (!pending_style_changes))
+    pending_style_changes = g_hash_table_new (NULL, NULL);
+
+  if (g_hash_table_lookup_extended (pending_style_changes, stylable, NULL,
+                                    &old_flags))
+    flags |= GPOINTER_TO_UINT (old_flags);
   else
+    g_object_weak_ref (G_OBJECT (stylable),
+                       mx_stylable_pending_style_change_weak_notify, NULL);
+
+  g_hash_table_insert (pending_style_changes, stylable,
+                       GUINT_TO_POINTER (flags));
+
+  if (!pending_style_changes_id)
     {
-      if (old_text_shadow)
+      pending_style_changes_id =
+        clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+                                               mx_stylable_flush_style_changes,
+                                               NULL, NULL);
+
+      /* make sure there is a frame to flush the changes in */
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (stylable));
+    }
+}
+
+void
+mx_stylable_connect_change_notifiers (MxStylable *stylable)
+{
+  g_return_if_fail (CLUTTER_IS_ACTOR (stylable));
+
+  g_return_if_fail (MX_IS_STYLABLE (stylable));
+
+  /* ClutterActor signals */
+  g_signal_connect (stylable, "notify::name",
+                    G_CALLBACK (mx_stylable_property_changed_notify), NULL);
+  g_signal_connect (stylable, "parent-set",
+                    G_CALLBACK (mx_stylable_parent_set_notify), NULL);
+
+  /* style-changed is blocked until the actor is realized, so style-changed
+   * needs to be sent as soon as the actor is mapped */
+  g_signal_connect (stylable, "notify::realized",
+                    G_CALLBACK (mx_stylable_property_changed_notify), NULL);
+
+  /* MxStylable notifiers */
+  g_signal_connect (stylable, "notify::style-class",
+                    G_CALLBACK (mx_stylable_property_changed_notify), NULL);
+  g_signal_connect (stylable, "notify::style-pseudo-class",
+                    G_CALLBACK (mx_stylable_property_changed_notify), NULL);
+
+}
+
+void
+mx_stylable_disconnect_change_notifiers (MxStylable *stylable)
+{
+  g_return_if_fail (CLUTTER_IS_ACTOR (stylable));
+
+  g_return_if_fail (MX_IS_STYLABLE (stylable));
+
+  g_signal_handlers_disconnect_by_func (stylable,
+                                        mx_stylable_property_changed_notify,
+                                        NULL);
+
+  g_signal_handlers_disconnect_by_func (stylable, mx_stylable_parent_set_notify,
+                                        NULL);
+}
+
+/* The shadow of the text of a ClutterText. The layout is rendered once
+ * into a texture, blurred if need be, which is then painted under the text
+ * in the shadow color until the text is laid out again or the blur
+ * changes. */
+typedef struct
+{
+  MxTextShadow  shadow;
+
+  PangoLayout  *layout; /* the layout @texture was rendered from */
+  gfloat        blur;
+  CoglHandle    texture;
+  CoglMaterial *material;
+
+  /* the position of @texture relative to the layout origin */
+  gint          x;
+  gint          y;
+} MxTextShadowCache;
+
+static void
+stylable_text_shadow_cache_clear (MxTextShadowCache *cache)
+{
+  if (cache->layout)
+    {
+      g_object_unref (cache->layout);
+      cache->layout = NULL;
+    }
+
+  if (cache->texture)
+    {
+      cogl_handle_unref (cache->texture);
+      cache->texture = NULL;
+    }
+}
+
+static void
+stylable_destroy_text_shadow (MxTextShadowCache *cache)
+{
+  stylable_text_shadow_cache_clear (cache);
+
+  if (cache->material)
+    cogl_object_unref (cache->material);
+
+  g_slice_free (MxTextShadowCache, cache);
+}
+
+/* blurs the @n values of @pixels that are @step apart with a box of
+ * 2 * @radius + 1 values, using @line as scratch */
+static void
+stylable_box_blur_line (guchar *pixels,
+                        gint    n,
+                        gint    step,
+                        gint    radius,
+                        guchar *line)
+{
+  gint i, sum = 0, size = 2 * radius + 1;
+
+  for (i = 0; i < n; i++)
+    line[i] = pixels[i * step];
+
+  /* the values outside of the line count as 0 */
+  for (i = 0; i < n && i <= radius; i++)
+    sum += line[i];
+
+  for (i = 0; i < n; i++)
+    {
+      pixels[i * step] = sum / size;
+
+      if (i + radius + 1 < n)
+        sum += line[i + radius + 1];
+      if (i - radius >= 0)
+        sum -= line[i - radius];
+    }
+}
+
+/* Returns an alpha-only texture of the alpha of @texture blurred by
+ * @radius, with three successive box blurs to approach a gaussian one */
+static CoglHandle
+stylable_blur_texture (CoglHandle texture,
+                       gint       radius)
+{
+  gint width, height, box, pass, i;
+  guchar *data, *alpha, *line;
+  CoglHandle blurred;
+
+  width = cogl_texture_get_width (texture);
+  height = cogl_texture_get_height (texture);
+
+  data = g_malloc (width * height * 4);
+  cogl_texture_get_data (texture, COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                         width * 4, data);
+
+  alpha = g_malloc (width * height);
+  for (i = 0; i < width * height; i++)
+    alpha[i] = data[i * 4 + 3];
+  g_free (data);
+
+  line = g_malloc (MAX (width, height));
+  box = MAX (1, (radius + 2) / 3);
+
+  for (pass = 0; pass < 3; pass++)
+    {
+      for (i = 0; i < height; i++)
+        stylable_box_blur_line (alpha + i * width, width, 1, box, line);
+      for (i = 0; i < width; i++)
+        stylable_box_blur_line (alpha + i, height, width, box, line);
+    }
+  g_free (line);
+
+  blurred = cogl_texture_new_from_data (width, height, COGL_TEXTURE_NONE,
+                                        COGL_PIXEL_FORMAT_A_8,
+                                        COGL_PIXEL_FORMAT_ANY,
+                                        width, alpha);
+  g_free (alpha);
+
+  return blurred;
+}
+
+/* renders the shadow of @layout into the texture of @cache */
+static gboolean
+stylable_text_shadow_render (MxTextShadowCache *cache,
+                             PangoLayout       *layout)
+{
+  PangoRectangle ink;
+  CoglHandle texture, offscreen;
+  CoglColor white, transparent;
+  CoglMatrix matrix;
+  gint radius, width, height;
+
+  pango_layout_get_pixel_extents (layout, &ink, NULL);
+
+  radius = MAX (0, (gint) cache->shadow.blur);
+  width = ink.width + 2 * radius;
+  height = ink.height + 2 * radius;
+
+  if (ink.width <= 0 || ink.height <= 0)
+    return FALSE;
+
+  texture = cogl_texture_new_with_size (width, height,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  if (texture == COGL_INVALID_HANDLE)
+    return FALSE;
+
+  offscreen = cogl_offscreen_new_to_texture (texture);
+  if (offscreen == COGL_INVALID_HANDLE)
+    {
+      cogl_handle_unref (texture);
+      return FALSE;
+    }
+
+  cache->x = ink.x - radius;
+  cache->y = ink.y - radius;
+
+  cogl_push_framebuffer (offscreen);
+  cogl_ortho (0, width, height, 0, -1, 1);
+
+  cogl_matrix_init_identity (&matrix);
+  cogl_set_modelview_matrix (&matrix);
+
+  cogl_color_init_from_4ub (&transparent, 0, 0, 0, 0);
+  cogl_clear (&transparent, COGL_BUFFER_BIT_COLOR);
+
+  cogl_color_init_from_4ub (&white, 0xff, 0xff, 0xff, 0xff);
+  cogl_pango_render_layout (layout, -cache->x, -cache->y, &white, 0);
+
+  cogl_pop_framebuffer ();
+  cogl_handle_unref (offscreen);
+
+  if (radius > 0)
+    {
+      CoglHandle blurred = stylable_blur_texture (texture, radius);
+
+      cogl_handle_unref (texture);
+      texture = blurred;
+
+      if (texture == COGL_INVALID_HANDLE)
+        return FALSE;
+    }
+
+  if (!cache->material)
+    {
+      cache->material = cogl_material_new ();
+
+      /* only the alpha of the texture is looked at, the color is the one
+       * of the shadow */
+      cogl_material_set_layer_combine (cache->material, 0,
+                                       "RGBA = MODULATE (PRIMARY, TEXTURE[A])",
+                                       NULL);
+    }
+
+  cogl_material_set_layer (cache->material, 0, texture);
+  cache->texture = texture;
+
+  return TRUE;
+}
+
+static void
+stylable_text_shadow_paint (ClutterText       *text,
+                            MxTextShadowCache *cache)
+{
+  MxTextShadow *text_shadow = &cache->shadow;
+  PangoLayout *layout;
+  CoglColor color;
+  guint8 alpha;
+
+  /* pango layout */
+  layout = clutter_text_get_layout (text);
+
+  /* the cache holds a reference on the layout it was rendered from, so a
+   * different pointer always means a different layout */
+  if (cache->layout != layout || cache->blur != text_shadow->blur)
+    {
+      stylable_text_shadow_cache_clear (cache);
+
+      if (clutter_feature_available (CLUTTER_FEATURE_OFFSCREEN) &&
+          stylable_text_shadow_render (cache, layout))
         {
-          g_signal_handlers_disconnect_by_func (text,
-                                                stylable_text_shadow_paint,
-                                                old_text_shadow);
-          g_object_set_qdata (G_OBJECT (text), stylable_text_shadow_quark, NULL);
+          cache->layout = g_object_ref (layout);
+          cache->blur = text_shadow->blur;
         }
     }
 
-  /* Create a description, we will convert to a string and set on the
-   * ClutterText. When Clutter gets API to set the description directly this
-   * won't be necessary. */
+  if (!cache->texture)
+    {
+      /* without offscreen buffers, draw the layout again */
+      cogl_color_init_from_4ub (&color,
+                                text_shadow->color.red,
+                                text_shadow->color.green,
+                                text_shadow->color.blue,
+                                text_shadow->color.alpha);
+
+      cogl_pango_render_layout (layout, text_shadow->h_offset,
+                                text_shadow->v_offset, &color, 0);
+      return;
+    }
+
+  alpha = text_shadow->color.alpha *
+    clutter_actor_get_paint_opacity (CLUTTER_ACTOR (text)) / 255;
+  cogl_material_set_color4ub (cache->material,
+                              text_shadow->color.red * alpha / 255,
+                              text_shadow->color.green * alpha / 255,
+                              text_shadow->color.blue * alpha / 255,
+                              alpha);
+
+  cogl_set_source (cache->material);
+  cogl_rectangle (text_shadow->h_offset + cache->x,
+                  text_shadow->v_offset + cache->y,
+                  text_shadow->h_offset + cache->x +
+                  cogl_texture_get_width (cache->texture),
+                  text_shadow->v_offset + cache->y +
+                  cogl_texture_get_height (cache->texture));
+}
+
+/* The text attributes of a stylable, computed once for all the stylables
+ * that match the style sheet the same way, and never modified after */
+typedef struct
+{
+  volatile gint   ref_count;
+
+  /* the default font comes from the settings, so this is checked against
+   * _mx_stylable_get_font_settings_serial() */
+  guint                 settings_serial;
+
+  ClutterColor         *color;
+  PangoFontDescription *font_description; /* interned */
+  MxTextShadow         *text_shadow;
+  PangoAlignment        alignment;
+  gboolean              justify;
+} MxStylableTextAttributes;
+
+static guint font_settings_serial = 0;
+
+/* identical font descriptions are shared, so that the text attributes of
+ * stylables with the same font compare equal. There are only ever a
+ * handful of these, so they are kept for the lifetime of the process */
+static GHashTable *font_descriptions = NULL;
+
+static MxStylableTextAttributes *
+mx_stylable_text_attributes_ref (MxStylableTextAttributes *attributes)
+{
+  g_atomic_int_inc (&attributes->ref_count);
+
+  return attributes;
+}
+
+static void
+mx_stylable_text_attributes_unref (MxStylableTextAttributes *attributes)
+{
+  if (!g_atomic_int_dec_and_test (&attributes->ref_count))
+    return;
+
+  if (attributes->color)
+    clutter_color_free (attributes->color);
+  if (attributes->text_shadow)
+    g_boxed_free (MX_TYPE_TEXT_SHADOW, attributes->text_shadow);
+
+  g_slice_free (MxStylableTextAttributes, attributes);
+}
+
+static void
+mx_stylable_font_settings_changed (MxSettings *settings,
+                                   GParamSpec *pspec)
+{
+  font_settings_serial ++;
+}
+
+/* Returns a number that changes whenever the default font does, which
+ * anything computed from the default font values needs to check */
+guint
+_mx_stylable_get_font_settings_serial (void)
+{
+  static gboolean connected = FALSE;
+
+  if (G_UNLIKELY (!connected))
+    {
+      connected = TRUE;
+      g_signal_connect (mx_settings_get_default (), "notify::font-name",
+                        G_CALLBACK (mx_stylable_font_settings_changed), NULL);
+    }
+
+  return font_settings_serial;
+}
+
+/* takes ownership of @descr and returns the shared equal description */
+static PangoFontDescription *
+mx_stylable_intern_font_description (PangoFontDescription *descr)
+{
+  PangoFontDescription *interned;
+
+  if (G_UNLIKELY (!font_descriptions))
+    font_descriptions =
+      g_hash_table_new_full ((GHashFunc) pango_font_description_hash,
+                             (GEqualFunc) pango_font_description_equal,
+                             (GDestroyNotify) pango_font_description_free,
+                             NULL);
+
+  interned = g_hash_table_lookup (font_descriptions, descr);
+  if (interned)
+    {
+      pango_font_description_free (descr);
+      return interned;
+    }
+
+  g_hash_table_add (font_descriptions, descr);
+
+  return descr;
+}
+
+/* Returns the shared font description of the text of a stylable with the
+ * given font-family, font-size and font-weight */
+PangoFontDescription *
+_mx_stylable_get_font_description (const gchar  *family,
+                                   gint          size,
+                                   MxFontWeight  font_weight)
+{
+  PangoFontDescription *descr;
+  PangoWeight weight;
+
   descr = pango_font_description_new ();
 
   /* font name */
-  pango_font_description_set_family (descr, font_name);
-  g_free (font_name);
+  pango_font_description_set_family (descr, family);
 
   /* font size */
-  pango_font_description_set_absolute_size (descr, font_size * PANGO_SCALE);
+  pango_font_description_set_absolute_size (descr, size * PANGO_SCALE);
 
   /* font weight */
   switch (font_weight)
@@ -1280,31 +2241,180 @@ mx_stylable_apply_clutter_text_attributes (MxStylable  *stylable,
     }
   pango_font_description_set_weight (descr, weight);
 
+  return mx_stylable_intern_font_description (descr);
+}
+
+/* Sets @value to the default of the text property @property_name of
+ * #MxWidget, which takes the font settings into account. Returns %FALSE if
+ * there is no such property */
+gboolean
+_mx_stylable_get_default_font_value (const gchar *property_name,
+                                     GValue      *value)
+{
+  GParamSpec *pspec;
+  gpointer klass;
+
+  /* the style properties of MxWidget are installed with its class */
+  klass = g_type_class_ref (MX_TYPE_WIDGET);
+  pspec = g_param_spec_pool_lookup (style_property_spec_pool, property_name,
+                                    MX_TYPE_WIDGET, TRUE);
+  g_type_class_unref (klass);
+
+  if (!pspec)
+    return FALSE;
+
+  _mx_stylable_get_default_value_for_pspec (pspec, value);
+
+  return TRUE;
+}
+
+static MxStylableTextAttributes *
+mx_stylable_compute_text_attributes (MxStylable *stylable)
+{
+  MxStylableTextAttributes *attributes;
+  gchar *font_name = NULL;
+  gint font_size = 0;
+  MxFontWeight font_weight;
+  MxTextAlign text_align;
+
+  attributes = g_slice_new0 (MxStylableTextAttributes);
+  attributes->ref_count = 1;
+  attributes->settings_serial = _mx_stylable_get_font_settings_serial ();
+
+  mx_stylable_get (stylable,
+                   "color", &attributes->color,
+                   "font-family", &font_name,
+                   "font-size", &font_size,
+                   "font-weight", &font_weight,
+                   "text-shadow", &attributes->text_shadow,
+                   "text-align", &text_align,
+                   NULL);
+
+  attributes->font_description =
+    _mx_stylable_get_font_description (font_name, font_size, font_weight);
+  g_free (font_name);
+
   switch (text_align)
     {
     case MX_TEXT_ALIGN_JUSTIFY:
     case MX_TEXT_ALIGN_LEFT:
-      pango_align = PANGO_ALIGN_LEFT;
+      attributes->alignment = PANGO_ALIGN_LEFT;
       break;
     case MX_TEXT_ALIGN_RIGHT:
-      pango_align = PANGO_ALIGN_RIGHT;
+      attributes->alignment = PANGO_ALIGN_RIGHT;
       break;
     case MX_TEXT_ALIGN_CENTER:
-      pango_align = PANGO_ALIGN_CENTER;
+      attributes->alignment = PANGO_ALIGN_CENTER;
       break;
     }
-  clutter_text_set_line_alignment (text, pango_align);
-  clutter_text_set_justify (text, (text_align == MX_TEXT_ALIGN_JUSTIFY));
+  attributes->justify = (text_align == MX_TEXT_ALIGN_JUSTIFY);
 
-  descr_string = pango_font_description_to_string (descr);
-  clutter_text_set_font_name (text, descr_string);
-  g_free (descr_string);
-  pango_font_description_free (descr);
+  return attributes;
+}
 
-  /* font color */
-  if (real_color)
+/* Returns a new reference to the text attributes of @stylable */
+static MxStylableTextAttributes *
+mx_stylable_get_text_attributes (MxStylable *stylable)
+{
+  static GQuark quark = 0;
+  MxStylableTextAttributes *attributes;
+
+  if (G_UNLIKELY (!quark))
+    quark = g_quark_from_static_string ("mx-stylable-text-attributes");
+
+  attributes = _mx_style_lookup_computed (stylable, quark);
+  if (attributes &&
+      attributes->settings_serial == _mx_stylable_get_font_settings_serial ())
+    return mx_stylable_text_attributes_ref (attributes);
+
+  attributes = mx_stylable_compute_text_attributes (stylable);
+
+  _mx_style_set_computed (stylable, quark,
+                          mx_stylable_text_attributes_ref (attributes),
+                          (GDestroyNotify) mx_stylable_text_attributes_unref);
+
+  return attributes;
+}
+
+void
+mx_stylable_apply_clutter_text_attributes (MxStylable  *stylable,
+                                           ClutterText *text)
+{
+  MxStylableTextAttributes *attributes, *old_attributes;
+  MxTextShadowCache *old_text_shadow;
+
+  static GQuark stylable_text_shadow_quark = 0;
+  static GQuark stylable_text_attributes_quark = 0;
+
+  if (!stylable_text_shadow_quark)
+   stylable_text_shadow_quark = g_quark_from_static_string ("stylable-text-shadow");
+  if (!stylable_text_attributes_quark)
+   stylable_text_attributes_quark =
+     g_quark_from_static_string ("stylable-text-attributes");
+
+
+  attributes = mx_stylable_get_text_attributes (stylable);
+
+  /* the attributes are shared, so the same ones as last time means they
+   * are already applied */
+  old_attributes = g_object_get_qdata (G_OBJECT (text),
+                                       stylable_text_attributes_quark);
+  if (attributes == old_attributes)
+    {
+      mx_stylable_text_attributes_unref (attributes);
+      return;
+    }
+
+  old_text_shadow = g_object_get_qdata (G_OBJECT (text),
+                                        stylable_text_shadow_quark);
+
+  if (attributes->text_shadow)
+    {
+      if (!old_text_shadow)
+        {
+          MxTextShadowCache *text_shadow = g_slice_new0 (MxTextShadowCache);
+
+          text_shadow->shadow = *attributes->text_shadow;
+
+          g_signal_connect (text, "paint",
+                            G_CALLBACK (stylable_text_shadow_paint),
+                            text_shadow);
+
+          g_object_set_qdata_full (G_OBJECT (text), stylable_text_shadow_quark,
+                                   text_shadow,
+                                   (GDestroyNotify) stylable_destroy_text_shadow);
+        }
+      else
+        {
+          /* the cached texture only depends on the blur, which the paint
+           * handler checks */
+          old_text_shadow->shadow = *attributes->text_shadow;
+        }
+    }
+  else
     {
-      clutter_text_set_color (text, real_color);
-      clutter_color_free (real_color);
+      if (old_text_shadow)
+        {
+          g_signal_handlers_disconnect_by_func (text,
+                                                stylable_text_shadow_paint,
+                                                old_text_shadow);
+          g_object_set_qdata (G_OBJECT (text), stylable_text_shadow_quark, NULL);
+        }
     }
+
+  clutter_text_set_line_alignment (text, attributes->alignment);
+  clutter_text_set_justify (text, attributes->justify);
+
+  /* ClutterText copies the description, and only lays the text out again
+   * if it is different from its current one */
+  clutter_text_set_font_description (text, attributes->font_description);
+
+  /* font color */
+  if (attributes->color)
+    clutter_text_set_color (text, attributes->color);
+
+  /* keep the attributes, so that applying them again can be skipped */
+  g_object_set_qdata_full (G_OBJECT (text), stylable_text_attributes_quark,
+                           attributes,
+                           (GDestroyNotify) mx_stylable_text_attributes_unref);
 }
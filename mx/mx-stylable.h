@@ -88,11 +88,17 @@ struct _MxStylableIface
                              GParamSpec *pspec);
 #endif
   void (* style_changed)    (MxStylable *stylable, MxStyleChangedFlags flags);
+
+  /*< private >*/
+  /* where #MxStyle keeps its cache for the stylable, which has to free it
+   * with _mx_style_free_stylable_cache(); without it, the cache is kept in
+   * qdata */
+  gpointer * (* get_style_cache) (MxStylable *stylable);
 };
 
 GType        mx_stylable_get_type               (void) G_GNUC_CONST;
 
-void         mx_stylable_iface_install_property (MxStylableIface *iface,
+guint        mx_stylable_iface_install_property (MxStylableIface *iface,
                                                  GType              owner_type,
                                                  GParamSpec        *pspec);
 
@@ -120,6 +126,20 @@ gboolean     mx_stylable_get_default_value      (MxStylable      *stylable,
                                                  const gchar       *property_name,
                                                  GValue            *value_out);
 
+gfloat       mx_stylable_get_float_by_id        (MxStylable      *stylable,
+                                                 guint              id);
+gint         mx_stylable_get_int_by_id          (MxStylable      *stylable,
+                                                 guint              id);
+guint        mx_stylable_get_uint_by_id         (MxStylable      *stylable,
+                                                 guint              id);
+gboolean     mx_stylable_get_boolean_by_id      (MxStylable      *stylable,
+                                                 guint              id);
+gint         mx_stylable_get_enum_by_id         (MxStylable      *stylable,
+                                                 guint              id);
+gboolean     mx_stylable_get_color_by_id        (MxStylable      *stylable,
+                                                 guint              id,
+                                                 ClutterColor      *color);
+
 
 const gchar* mx_stylable_get_style_class (MxStylable  *stylable);
 void         mx_stylable_set_style_class (MxStylable  *stylable,
@@ -130,6 +150,8 @@ void         mx_stylable_set_style_pseudo_class (MxStylable  *stylable,
                                                  const gchar *pseudo_class);
 
 void mx_stylable_style_changed (MxStylable *stylable, MxStyleChangedFlags flags);
+void mx_stylable_begin_update  (void);
+void mx_stylable_end_update    (void);
 void mx_stylable_connect_change_notifiers (MxStylable *stylable);
 void mx_stylable_disconnect_change_notifiers (MxStylable *stylable);
 
@@ -34,6 +34,7 @@
 
 #include <glib-object.h>
 #include <gobject/gvaluecollector.h>
+#include <cogl-pango/cogl-pango.h>
 
 #include "mx-stylable.h"
 #include "mx-css.h"
@@ -42,6 +43,8 @@
 #include "mx-style.h"
 #include "mx-enum-types.h"
 #include "mx-types.h"
+#include "mx-texture-cache.h"
+#include "mx-worker-pool.h"
 #include "mx-private.h"
 
 #ifdef HAVE_DEFAULT_STYLE
@@ -55,6 +58,15 @@ enum
   LAST_SIGNAL
 };
 
+enum
+{
+  PROP_0,
+
+  PROP_CACHE_SIZE,
+  PROP_LOAD_DEFAULT,
+  PROP_PARENT
+};
+
 #define MX_STYLE_GET_PRIVATE(obj) \
         (G_TYPE_INSTANCE_GET_PRIVATE ((obj), MX_TYPE_STYLE, MxStylePrivate))
 
@@ -75,14 +87,43 @@ enum
  */
 #define MX_STYLE_CACHE_SIZE 6
 
-/* A style cache entry is the unique string representing all the properties
- * that can be matched against in CSS, and the matched properties themselves.
+/* The characters whose glyphs mx_style_prewarm_fonts() renders by default,
+ * and the time it may spend on them in each main loop iteration, in
+ * milliseconds */
+#define MX_STYLE_PREWARM_CHARACTERS \
+  " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ" \
+  "[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~"
+#define MX_STYLE_PREWARM_SLICE 4
+
+/* A style key is the unique identity of all the properties of a stylable
+ * that can be matched against in CSS: its own type, name, style class and
+ * pseudo-class, and the key of its stylable parent. Keys are interned, so
+ * stylables that match the same rules share a key, and a key is built from
+ * the parent's in constant time.
+ */
+typedef struct _MxStyleKey MxStyleKey;
+struct _MxStyleKey
+{
+  MxStyleKey *parent;
+  GType       type;
+  GQuark      id;
+  GQuark      class;
+  GQuark      pseudo_class;
+
+  guint64     hash;
+  guint       ref_count;
+};
+
+/* A style cache entry is the style key and the matched properties, along
+ * with whatever stylables computed from them, which every stylable with the
+ * same key can share.
  */
 typedef struct
 {
-  gchar      *style_string;
+  MxStyleKey *key;
   gint        age;
   GHashTable *properties;
+  GData      *computed;
 } MxStyleCacheEntry;
 
 /* This is the per-stylable cache store. We need a reference back to the
@@ -90,8 +131,8 @@ typedef struct
  */
 typedef struct
 {
-  GList   *styles;
-  gchar   *string;
+  GList      *styles;
+  MxStyleKey *key;
 } MxStylableCache;
 
 typedef struct {
@@ -104,6 +145,16 @@ struct _MxStylePrivate
 {
   MxStyleSheet *stylesheet;
 
+  /* the style whose rules are matched first, with those of the style sheet
+   * overriding them */
+  MxStyle      *parent;
+
+  /* the default style sheet is only parsed when first needed, and never
+   * if the application turned it off before */
+  guint       load_default    : 1;
+  guint       default_pending : 1;
+  guint       loading_default : 1;
+
   GHashTable *style_hash;
   GHashTable *node_hash;
 
@@ -111,14 +162,35 @@ struct _MxStylePrivate
   GQueue     *cached_matches;
   GHashTable *cache_hash;
   gint        age;
+
+  guint       cache_size;
+  guint       cache_hits;
+  guint       cache_misses;
+  guint       cache_evictions;
+
+  /* the rules that changed, while "changed" is emitted after a style sheet
+   * was reloaded; %NULL means anything may have changed */
+  MxStyleSheetChange *change;
+
+  /* the fonts mx_style_prewarm_fonts() has yet to render, and an actor to
+   * create layouts like those of the text of stylables */
+  GQueue       *prewarm_fonts;
+  gchar        *prewarm_characters;
+  ClutterActor *prewarm_actor;
+  guint         prewarm_source;
 };
 
 static guint style_signals[LAST_SIGNAL] = { 0, };
 
 static MxStyle *default_style = NULL;
 
+static GHashTable *style_keys = NULL;
+
 G_DEFINE_TYPE (MxStyle, mx_style, G_TYPE_OBJECT);
 
+static void mx_style_cache_entry_free (MxStyleCacheEntry *entry,
+                                       gboolean           free_struct);
+
 static GQuark
 g_style_error_quark (void)
 {
@@ -131,6 +203,13 @@ g_style_cache_quark (void)
   return g_quark_from_static_string ("mx-style-cache-quark");
 }
 
+/* whether @style has any rules to match, its own or inherited */
+static inline gboolean
+mx_style_has_rules (MxStyle *style)
+{
+  return style->priv->stylesheet || style->priv->parent;
+}
+
 static void
 css_file_changed (GFileMonitor      *monitor,
                   GFile             *file,
@@ -139,22 +218,169 @@ css_file_changed (GFileMonitor      *monitor,
                   MxStyle           *style)
 {
   MxStylePrivate *priv = style->priv;
-  const gchar *path = g_file_get_path (file);
+  MxStyleSheetChange *change;
+  const gchar *filename;
+  GList *l, *next;
 
   if (event_type != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT)
     return;
 
-  mx_style_sheet_remove (priv->stylesheet, path);
+  /* the style sheet knows the file by the name it was loaded with */
+  filename = g_object_get_data (G_OBJECT (monitor), "mx-style-filename");
 
-  mx_style_sheet_add_from_file (priv->stylesheet, path, NULL);
+  mx_style_sheet_reload_file (priv->stylesheet, filename, &change);
 
+  if (!change)
+    {
+      /* Increment the age so we know if a style cache entry is valid */
+      priv->age ++;
 
-  /* Increment the age so we know if a style cache entry is valid */
-  priv->age ++;
+      g_signal_emit (style, style_signals[CHANGED], 0, NULL);
+
+      return;
+    }
+
+  /* only drop the cache entries that could match a changed rule, either
+   * directly or through one of the ancestors they inherit values from */
+  for (l = priv->cached_matches->head; l; l = next)
+    {
+      MxStyleCacheEntry *entry = l->data;
+      MxStyleKey *key;
+
+      next = l->next;
+
+      for (key = entry->key; key; key = key->parent)
+        {
+          if (mx_style_sheet_change_affects (change, key->type, key->id,
+                                             key->class))
+            break;
+        }
+
+      if (key)
+        {
+          g_hash_table_remove (priv->cache_hash, entry->key);
+          g_queue_delete_link (priv->cached_matches, l);
+          mx_style_cache_entry_free (entry, TRUE);
+        }
+    }
 
+  /* stylables check the change in their handler, and skip restyling if it
+   * does not affect them */
+  priv->change = change;
   g_signal_emit (style, style_signals[CHANGED], 0, NULL);
+  priv->change = NULL;
+
+  mx_style_sheet_change_free (change);
+}
+
+gboolean
+_mx_style_change_affects (MxStyle    *style,
+                          MxStylable *stylable)
+{
+  MxStylePrivate *priv = style->priv;
+  const gchar *string;
+  GQuark id, class;
+
+  if (!priv->change)
+    return TRUE;
+
+  /* any name used by a changed rule has been interned when parsing it */
+  string = clutter_actor_get_name (CLUTTER_ACTOR (stylable));
+  id = (string) ? g_quark_try_string (string) : 0;
+
+  string = mx_stylable_get_style_class (stylable);
+  class = (string) ? g_quark_try_string (string) : 0;
+
+  return mx_style_sheet_change_affects (priv->change,
+                                        G_OBJECT_TYPE (stylable), id, class);
+}
+
+/* Starts decoding the images the style sheet refers to, so that they are
+ * packed into the atlas pages of the texture cache before the first widget
+ * using them is painted, rather than loaded one by one as they show up */
+static void
+mx_style_preload_images (MxStyle *style)
+{
+  MxStylePrivate *priv = style->priv;
+  GHashTable *seen;
+  GPtrArray *uris;
+  GList *styles, *l;
+
+  if (!priv->stylesheet)
+    return;
+
+  seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  uris = g_ptr_array_new ();
+
+  styles = mx_style_sheet_get_styles (priv->stylesheet);
+  for (l = styles; l; l = l->next)
+    {
+      static const gchar *properties[] = { "border-image",
+                                           "background-image" };
+      guint i;
+
+      for (i = 0; i < G_N_ELEMENTS (properties); i++)
+        {
+          MxStyleSheetValue *css_value;
+          GValue value = { 0, };
+          MxBorderImage *image;
+
+          css_value = g_hash_table_lookup (l->data, properties[i]);
+          if (!css_value || !g_str_has_prefix (css_value->string, "url"))
+            continue;
+
+          g_value_init (&value, MX_TYPE_BORDER_IMAGE);
+          mx_border_image_set_from_string (&value, css_value->string,
+                                           css_value->source);
+          image = g_value_get_boxed (&value);
+
+          if (image && image->uri &&
+              !g_hash_table_lookup_extended (seen, image->uri, NULL, NULL) &&
+              g_file_test (image->uri, G_FILE_TEST_IS_REGULAR))
+            {
+              gchar *uri = g_strdup (image->uri);
+
+              g_hash_table_insert (seen, uri, NULL);
+              g_ptr_array_add (uris, uri);
+            }
+
+          g_value_unset (&value);
+        }
+    }
+  g_list_free (styles);
+
+  if (uris->len)
+    {
+      g_ptr_array_add (uris, NULL);
+      mx_texture_cache_preload (mx_texture_cache_get_default (),
+                                (const gchar **) uris->pdata, NULL);
+    }
+
+  g_ptr_array_free (uris, TRUE);
+  g_hash_table_destroy (seen);
+}
+
+static void
+mx_style_monitor_file (MxStyle     *style,
+                       const gchar *filename)
+{
+  GFile *file;
+  GFileMonitor *monitor;
+
+  file = g_file_new_for_path (filename);
+  monitor = g_file_monitor (file, G_FILE_MONITOR_NONE, NULL, NULL);
+
+  if (monitor)
+    {
+      g_object_set_data_full (G_OBJECT (monitor), "mx-style-filename",
+                              g_strdup (filename), g_free);
+      g_signal_connect (monitor, "changed", G_CALLBACK (css_file_changed),
+                        style);
+    }
 }
 
+static void mx_style_ensure_default (MxStyle *style);
+
 static gboolean
 mx_style_real_load_from_file (MxStyle      *style,
                               const gchar  *filename,
@@ -171,6 +397,9 @@ mx_style_real_load_from_file (MxStyle      *style,
 
   priv = MX_STYLE (style)->priv;
 
+  /* the default style sheet has the lowest priority, so comes first */
+  mx_style_ensure_default (style);
+
   if (!data && !g_file_test (filename, G_FILE_TEST_IS_REGULAR))
     {
       internal_error = g_error_new (MX_STYLE_ERROR,
@@ -202,23 +431,252 @@ mx_style_real_load_from_file (MxStyle      *style,
   /* Increment the age so we know if a style cache entry is valid */
   priv->age ++;
 
-  g_signal_emit (style, style_signals[CHANGED], 0, NULL);
+  /* nothing was looked up in a style that is still loading its default */
+  if (!priv->loading_default)
+    g_signal_emit (style, style_signals[CHANGED], 0, NULL);
+
+  mx_style_preload_images (style);
 
   if (!data)
+    mx_style_monitor_file (style, filename);
+
+  return TRUE;
+}
+
+typedef struct
+{
+  gchar                *filename;
+  GCancellable         *cancellable;
+  MxStyleSheetParseJob *parsed;
+} MxStyleLoadData;
+
+static void
+mx_style_load_data_free (MxStyleLoadData *data)
+{
+  g_free (data->filename);
+  if (data->cancellable)
+    g_object_unref (data->cancellable);
+  mx_style_sheet_parse_job_free (data->parsed);
+
+  g_slice_free (MxStyleLoadData, data);
+}
+
+/* runs on a worker thread, and so must not touch the style */
+static void
+mx_style_load_thread (gpointer user_data)
+{
+  GSimpleAsyncResult *simple = user_data;
+  MxStyleLoadData *data = g_simple_async_result_get_op_res_gpointer (simple);
+
+  if (!g_file_test (data->filename, G_FILE_TEST_IS_REGULAR))
+    {
+      g_simple_async_result_set_error (simple, MX_STYLE_ERROR,
+                                       MX_STYLE_ERROR_INVALID_FILE,
+                                       "Invalid theme file '%s'",
+                                       data->filename);
+      return;
+    }
+
+  data->parsed = mx_style_sheet_parse_file (data->filename, NULL);
+
+  if (!data->parsed)
+    g_simple_async_result_set_error (simple, MX_STYLE_ERROR,
+                                     MX_STYLE_ERROR_PARSE_ERROR,
+                                     "Could not parse '%s'", data->filename);
+}
+
+/* back in the main loop, with the whole file parsed */
+static void
+mx_style_load_ready (gpointer user_data)
+{
+  GSimpleAsyncResult *simple = user_data;
+  GObject *object = g_async_result_get_source_object (G_ASYNC_RESULT (simple));
+  MxStyle *style = MX_STYLE (object);
+  MxStylePrivate *priv = style->priv;
+  MxStyleLoadData *data = g_simple_async_result_get_op_res_gpointer (simple);
+  GError *error = NULL;
+
+  /* the worker doesn't run at all if cancelled in time, and otherwise sets
+   * the error when the file can't be parsed */
+  if (g_cancellable_set_error_if_cancelled (data->cancellable, &error))
+    {
+      g_simple_async_result_take_error (simple, error);
+    }
+  else if (data->parsed)
     {
-      GFile *file;
-      GFileMonitor *monitor;
+      /* the new rules, the age and the "changed" emission all change in
+       * this one step, and the restyle happens at the next frame */
+      mx_style_ensure_default (style);
+
+      if (!priv->stylesheet)
+        priv->stylesheet = mx_style_sheet_new ();
+
+      mx_style_sheet_add_parsed (priv->stylesheet, data->parsed);
+      data->parsed = NULL;
+
+      priv->age ++;
+
+      g_signal_emit (style, style_signals[CHANGED], 0, NULL);
+
+      mx_style_preload_images (style);
+      mx_style_monitor_file (style, data->filename);
+    }
+
+  g_simple_async_result_complete (simple);
+  g_object_unref (simple);
+  g_object_unref (object);
+}
+
+/**
+ * mx_style_load_from_file_async:
+ * @style: a #MxStyle
+ * @filename: filename of the style sheet to load
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the style
+ *   sheet is loaded
+ * @user_data: (closure): data to pass to @callback
+ *
+ * Asynchronous version of mx_style_load_from_file(). The file is read and
+ * parsed on a worker thread, and its rules only become part of @style,
+ * all at once, when that is complete. If the file can't be parsed,
+ * nothing is added to @style.
+ *
+ * When the operation is finished, @callback is called; call
+ * mx_style_load_from_file_finish() from it to get the result.
+ *
+ * Since: 2.0
+ */
+void
+mx_style_load_from_file_async (MxStyle             *style,
+                               const gchar         *filename,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  GSimpleAsyncResult *simple;
+  MxStyleLoadData *data;
+
+  g_return_if_fail (MX_IS_STYLE (style));
+  g_return_if_fail (filename != NULL);
+
+  data = g_slice_new0 (MxStyleLoadData);
+  data->filename = g_strdup (filename);
+  if (cancellable)
+    data->cancellable = g_object_ref (cancellable);
+
+  simple = g_simple_async_result_new (G_OBJECT (style), callback, user_data,
+                                      mx_style_load_from_file_async);
+  g_simple_async_result_set_op_res_gpointer (simple, data,
+                                             (GDestroyNotify)
+                                             mx_style_load_data_free);
+
+  /* the rules are added in the main loop, before @callback is called */
+  mx_worker_pool_push (mx_worker_pool_get_default (), G_PRIORITY_DEFAULT,
+                       mx_style_load_thread, mx_style_load_ready, simple,
+                       cancellable);
+}
+
+/**
+ * mx_style_load_from_file_finish:
+ * @style: a #MxStyle
+ * @result: the #GAsyncResult passed to the callback
+ * @error: a #GError or #NULL
+ *
+ * Finishes loading a style sheet started with
+ * mx_style_load_from_file_async().
+ *
+ * returns: TRUE if the style information was loaded successfully. Returns
+ * FALSE on error.
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_style_load_from_file_finish (MxStyle       *style,
+                                GAsyncResult  *result,
+                                GError       **error)
+{
+  g_return_val_if_fail (MX_IS_STYLE (style), FALSE);
+  g_return_val_if_fail (g_simple_async_result_is_valid (result,
+                                                        G_OBJECT (style),
+                                                        mx_style_load_from_file_async),
+                        FALSE);
+
+  return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result),
+                                                 error);
+}
+
+/**
+ * mx_style_load_from_files:
+ * @style: a #MxStyle
+ * @filenames: (array zero-terminated=1): a %NULL-terminated array of file
+ *   names of the style sheets to load
+ * @error: a #GError or #NULL
+ *
+ * Load style information from each of @filenames, as if
+ * mx_style_load_from_file() was called on each of them in turn, with
+ * later files taking priority over earlier ones. The files are parsed in
+ * parallel, which is quicker than loading them one by one on systems
+ * with several processors.
+ *
+ * returns: TRUE if the style information was loaded successfully. Returns
+ * FALSE on error.
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_style_load_from_files (MxStyle      *style,
+                          const gchar **filenames,
+                          GError      **error)
+{
+  MxStylePrivate *priv;
+  GError *internal_error = NULL;
+  gboolean result;
+  gint i;
+
+  g_return_val_if_fail (MX_IS_STYLE (style), FALSE);
+  g_return_val_if_fail (filenames != NULL, FALSE);
 
-      file = g_file_new_for_path (filename);
-      monitor = g_file_monitor (file, G_FILE_MONITOR_NONE, NULL, NULL);
+  priv = style->priv;
+
+  mx_style_ensure_default (style);
 
-      if (monitor)
+  for (i = 0; filenames[i]; i++)
+    {
+      if (!g_file_test (filenames[i], G_FILE_TEST_IS_REGULAR))
         {
-          g_signal_connect (monitor, "changed", G_CALLBACK (css_file_changed),
-                            style);
+          internal_error = g_error_new (MX_STYLE_ERROR,
+                                        MX_STYLE_ERROR_INVALID_FILE,
+                                        "Invalid theme file '%s'",
+                                        filenames[i]);
+          g_propagate_error (error, internal_error);
+          return FALSE;
         }
     }
 
+  if (!priv->stylesheet)
+    priv->stylesheet = mx_style_sheet_new ();
+
+  result = mx_style_sheet_add_from_files (priv->stylesheet, filenames,
+                                          &internal_error);
+
+  /* whatever could be parsed was added, as with a single file */
+  priv->age ++;
+
+  g_signal_emit (style, style_signals[CHANGED], 0, NULL);
+
+  mx_style_preload_images (style);
+
+  for (i = 0; filenames[i]; i++)
+    mx_style_monitor_file (style, filenames[i]);
+
+  if (!result)
+    {
+      g_set_error_literal (error, MX_STYLE_ERROR, MX_STYLE_ERROR_PARSE_ERROR,
+                           internal_error->message);
+      g_error_free (internal_error);
+      return FALSE;
+    }
+
   return TRUE;
 }
 
@@ -264,6 +722,129 @@ mx_style_load_from_data (MxStyle      *style,
   return mx_style_real_load_from_file (style, id, data, error, 0);
 }
 
+/**
+ * mx_style_load_from_compiled_file:
+ * @style: a #MxStyle
+ * @filename: filename of the compiled style sheet to load
+ * @error: a #GError or #NULL
+ *
+ * Load style information from a style sheet compiled with mx-css-compile.
+ * The file is mapped into memory rather than parsed. If the style sheet it
+ * was compiled from has changed since, the original style sheet is loaded
+ * instead.
+ *
+ * returns: TRUE if the style information was loaded successfully. Returns
+ * FALSE on error.
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_style_load_from_compiled_file (MxStyle      *style,
+                                  const gchar  *filename,
+                                  GError      **error)
+{
+  MxStylePrivate *priv;
+  GError *internal_error = NULL;
+  gchar *source = NULL;
+
+  g_return_val_if_fail (MX_IS_STYLE (style), FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  priv = MX_STYLE (style)->priv;
+
+  mx_style_ensure_default (style);
+
+  if (!priv->stylesheet)
+    priv->stylesheet = mx_style_sheet_new ();
+
+  if (!mx_style_sheet_add_from_compiled_file (priv->stylesheet, filename,
+                                              &source, &internal_error))
+    {
+      gboolean result;
+
+      /* an out of date compiled file is replaced by its source */
+      if (source && g_error_matches (internal_error, MX_STYLE_SHEET_ERROR,
+                                     MX_STYLE_SHEET_ERROR_STALE))
+        {
+          MX_NOTE (CSS, "%s", internal_error->message);
+          g_error_free (internal_error);
+
+          result = mx_style_real_load_from_file (style, source, NULL, error,
+                                                 0);
+          g_free (source);
+
+          return result;
+        }
+
+      g_set_error (error, MX_STYLE_ERROR, MX_STYLE_ERROR_INVALID_FILE,
+                   "%s", internal_error->message);
+      g_error_free (internal_error);
+      g_free (source);
+
+      return FALSE;
+    }
+
+  g_free (source);
+
+  /* Increment the age so we know if a style cache entry is valid */
+  priv->age ++;
+
+  g_signal_emit (style, style_signals[CHANGED], 0, NULL);
+
+  mx_style_preload_images (style);
+
+  return TRUE;
+}
+
+/**
+ * mx_style_compile_file:
+ * @filename: filename of the style sheet to compile
+ * @output: filename to write the compiled style sheet to
+ * @error: a #GError or #NULL
+ *
+ * Parse the style sheet in @filename and write it to @output in the form
+ * read by mx_style_load_from_compiled_file(). Compiled style sheets are
+ * specific to the architecture they were compiled on.
+ *
+ * returns: TRUE if the style sheet was compiled successfully. Returns
+ * FALSE on error.
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_style_compile_file (const gchar  *filename,
+                       const gchar  *output,
+                       GError      **error)
+{
+  GError *internal_error = NULL;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (output != NULL, FALSE);
+
+  if (!g_file_test (filename, G_FILE_TEST_IS_REGULAR))
+    {
+      g_set_error (error, MX_STYLE_ERROR, MX_STYLE_ERROR_INVALID_FILE,
+                   "Invalid theme file '%s'", filename);
+      return FALSE;
+    }
+
+  if (!mx_style_sheet_compile_file (filename, output, &internal_error))
+    {
+      if (internal_error->domain == MX_STYLE_SHEET_ERROR)
+        {
+          g_set_error (error, MX_STYLE_ERROR, MX_STYLE_ERROR_PARSE_ERROR,
+                       "%s", internal_error->message);
+          g_error_free (internal_error);
+        }
+      else
+        g_propagate_error (error, internal_error);
+
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
 gboolean
 mx_style_load_from_resource (MxStyle      *style,
                              const gchar  *path,
@@ -301,6 +882,9 @@ mx_style_load (MxStyle *style)
   const gchar *env_var;
   gchar *rc_file = NULL;
   GError *error;
+  gint64 start;
+
+  start = _mx_startup_trace_begin ();
 
   env_var = g_getenv ("MX_RC_FILE");
   if (env_var && *env_var)
@@ -319,7 +903,11 @@ mx_style_load (MxStyle *style)
           g_clear_error (&error);
         }
       else
-        return;
+        {
+          g_free (rc_file);
+          _mx_startup_trace_end ("style", start);
+          return;
+        }
     }
 
   g_free (rc_file);
@@ -335,18 +923,148 @@ mx_style_load (MxStyle *style)
       g_clear_error (&error);
     }
 #endif
+
+  _mx_startup_trace_end ("style", start);
+}
+
+/* Loads the default style sheet the first time anything is looked up in
+ * or added to @style */
+static void
+mx_style_ensure_default (MxStyle *style)
+{
+  MxStylePrivate *priv = style->priv;
+
+  if (G_LIKELY (!priv->default_pending))
+    return;
+
+  priv->default_pending = FALSE;
+
+  priv->loading_default = TRUE;
+  mx_style_load (style);
+  priv->loading_default = FALSE;
+}
+
+static guint
+mx_style_key_hash (gconstpointer data)
+{
+  const MxStyleKey *key = data;
+
+  return (guint) (key->hash ^ (key->hash >> 32));
+}
+
+static gboolean
+mx_style_key_equal (gconstpointer a,
+                    gconstpointer b)
+{
+  const MxStyleKey *key_a = a;
+  const MxStyleKey *key_b = b;
+
+  /* the hash covers the whole ancestry, but only the fields decide; the
+   * parents are interned, so they compare by pointer */
+  return (key_a->hash == key_b->hash &&
+          key_a->parent == key_b->parent &&
+          key_a->type == key_b->type &&
+          key_a->id == key_b->id &&
+          key_a->class == key_b->class &&
+          key_a->pseudo_class == key_b->pseudo_class);
+}
+
+#define MX_STYLE_KEY_MIX(hash, value) \
+  (((hash) ^ (guint64) (value)) * G_GUINT64_CONSTANT (0x100000001b3))
+
+static MxStyleKey *
+mx_style_key_ref (MxStyleKey *key)
+{
+  key->ref_count ++;
+
+  return key;
+}
+
+static void
+mx_style_key_unref (MxStyleKey *key)
+{
+  /* dropping the last reference to a key also drops its reference on the
+   * parent key */
+  while (key && --key->ref_count == 0)
+    {
+      MxStyleKey *parent = key->parent;
+
+      g_hash_table_remove (style_keys, key);
+      g_slice_free (MxStyleKey, key);
+
+      key = parent;
+    }
+}
+
+/* Fills in the fields of @key from the current state of @stylable */
+static void
+mx_style_key_init (MxStyleKey *key,
+                   MxStyleKey *parent_key,
+                   MxStylable *stylable)
+{
+  const gchar *string;
+
+  key->parent = parent_key;
+  key->type = G_OBJECT_TYPE (stylable);
+
+  /* these have to be interned, rather than looked up, as a reloaded style
+   * sheet may start using them */
+  string = clutter_actor_get_name (CLUTTER_ACTOR (stylable));
+  key->id = (string) ? g_quark_from_string (string) : 0;
+  string = mx_stylable_get_style_class (stylable);
+  key->class = (string) ? g_quark_from_string (string) : 0;
+  string = mx_stylable_get_style_pseudo_class (stylable);
+  key->pseudo_class = (string) ? g_quark_from_string (string) : 0;
+
+  /* FNV-1a over the fields, starting from the parent's hash */
+  key->hash = (parent_key) ? parent_key->hash
+                           : G_GUINT64_CONSTANT (0xcbf29ce484222325);
+  key->hash = MX_STYLE_KEY_MIX (key->hash, key->type);
+  key->hash = MX_STYLE_KEY_MIX (key->hash, key->id);
+  key->hash = MX_STYLE_KEY_MIX (key->hash, key->class);
+  key->hash = MX_STYLE_KEY_MIX (key->hash, key->pseudo_class);
+
+  key->ref_count = 0;
+}
+
+/* Returns a new reference to the interned key for @stylable, below
+ * @parent_key */
+static MxStyleKey *
+mx_style_key_get (MxStyleKey *parent_key,
+                  MxStylable *stylable)
+{
+  MxStyleKey lookup, *key;
+
+  if (G_UNLIKELY (!style_keys))
+    style_keys = g_hash_table_new (mx_style_key_hash, mx_style_key_equal);
+
+  mx_style_key_init (&lookup, parent_key, stylable);
+
+  key = g_hash_table_lookup (style_keys, &lookup);
+  if (key)
+    return mx_style_key_ref (key);
+
+  key = g_slice_dup (MxStyleKey, &lookup);
+  key->ref_count = 1;
+  if (parent_key)
+    mx_style_key_ref (parent_key);
+
+  g_hash_table_add (style_keys, key);
+
+  return key;
 }
 
 static MxStyleCacheEntry *
-mx_style_cache_entry_new (const gchar *style_string,
+mx_style_cache_entry_new (MxStyleKey  *key,
                           GHashTable  *properties,
                           gint         age)
 {
   MxStyleCacheEntry *entry = g_slice_new (MxStyleCacheEntry);
 
-  entry->style_string = g_strdup (style_string);
+  entry->key = mx_style_key_ref (key);
   entry->properties = properties;
   entry->age = age;
+  g_datalist_init (&entry->computed);
 
   return entry;
 }
@@ -355,17 +1073,59 @@ static void
 mx_style_cache_entry_free (MxStyleCacheEntry *entry,
                            gboolean           free_struct)
 {
-  g_free (entry->style_string);
+  mx_style_key_unref (entry->key);
   g_hash_table_unref (entry->properties);
+  g_datalist_clear (&entry->computed);
   if (free_struct)
     g_slice_free (MxStyleCacheEntry, entry);
 }
 
+static void mx_style_stop_prewarm (MxStyle *style);
+
+/* the matches of the parent style are part of every match of the style, so
+ * they all go when the parent changes */
+static void
+mx_style_parent_changed_cb (MxStyle *parent,
+                            MxStyle *style)
+{
+  style->priv->age ++;
+
+  g_signal_emit (style, style_signals[CHANGED], 0, NULL);
+}
+
+static void
+mx_style_set_parent (MxStyle *style,
+                     MxStyle *parent)
+{
+  MxStylePrivate *priv = style->priv;
+
+  if (!parent)
+    return;
+
+  priv->parent = g_object_ref (parent);
+  g_signal_connect (parent, "changed",
+                    G_CALLBACK (mx_style_parent_changed_cb), style);
+
+  /* the default style sheet, if any, comes with the parent */
+  priv->load_default = FALSE;
+  priv->default_pending = FALSE;
+}
+
 static void
 mx_style_finalize (GObject *gobject)
 {
   MxStylePrivate *priv = MX_STYLE (gobject)->priv;
 
+  mx_style_stop_prewarm (MX_STYLE (gobject));
+
+  if (priv->parent)
+    {
+      g_signal_handlers_disconnect_by_func (priv->parent,
+                                            mx_style_parent_changed_cb,
+                                            gobject);
+      g_object_unref (priv->parent);
+    }
+
   g_hash_table_unref (priv->cache_hash);
 
   while (g_queue_get_length (priv->cached_matches))
@@ -375,15 +1135,105 @@ mx_style_finalize (GObject *gobject)
   G_OBJECT_CLASS (mx_style_parent_class)->finalize (gobject);
 }
 
+static void
+mx_style_set_property (GObject      *gobject,
+                       guint         prop_id,
+                       const GValue *value,
+                       GParamSpec   *pspec)
+{
+  MxStyle *style = MX_STYLE (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_CACHE_SIZE:
+      mx_style_set_cache_size (style, g_value_get_uint (value));
+      break;
+
+    case PROP_LOAD_DEFAULT:
+      mx_style_set_load_default (style, g_value_get_boolean (value));
+      break;
+
+    case PROP_PARENT:
+      mx_style_set_parent (style, g_value_get_object (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+mx_style_get_property_real (GObject    *gobject,
+                            guint       prop_id,
+                            GValue     *value,
+                            GParamSpec *pspec)
+{
+  MxStylePrivate *priv = MX_STYLE (gobject)->priv;
+
+  switch (prop_id)
+    {
+    case PROP_CACHE_SIZE:
+      g_value_set_uint (value, priv->cache_size);
+      break;
+
+    case PROP_LOAD_DEFAULT:
+      g_value_set_boolean (value, priv->load_default);
+      break;
+
+    case PROP_PARENT:
+      g_value_set_object (value, priv->parent);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+      break;
+    }
+}
+
 static void
 mx_style_class_init (MxStyleClass *klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GParamSpec *pspec;
 
   g_type_class_add_private (klass, sizeof (MxStylePrivate));
 
+  gobject_class->set_property = mx_style_set_property;
+  gobject_class->get_property = mx_style_get_property_real;
   gobject_class->finalize = mx_style_finalize;
 
+  pspec = g_param_spec_uint ("cache-size",
+                             "Cache size",
+                             "Maximum number of matched styles to cache, or 0 "
+                             "to scale with the number of stylables",
+                             0, G_MAXUINT, 0,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_CACHE_SIZE, pspec);
+
+  pspec = g_param_spec_boolean ("load-default",
+                                "Load default",
+                                "Whether the default style sheet is loaded "
+                                "before the first style is looked up",
+                                TRUE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_LOAD_DEFAULT, pspec);
+
+  /**
+   * MxStyle:parent:
+   *
+   * The style whose rules the style sheet of this style is layered over.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_object ("parent",
+                               "Parent",
+                               "Style whose rules this style overrides",
+                               MX_TYPE_STYLE,
+                               G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+                               G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (gobject_class, PROP_PARENT, pspec);
+
   /**
    * MxStyle::changed:
    *
@@ -410,9 +1260,10 @@ mx_style_init (MxStyle *style)
   style->priv = priv = MX_STYLE_GET_PRIVATE (style);
 
   priv->cached_matches = g_queue_new ();
-  priv->cache_hash = g_hash_table_new (g_str_hash, g_str_equal);
+  priv->cache_hash = g_hash_table_new (NULL, NULL);
 
-  mx_style_load (style);
+  priv->load_default = TRUE;
+  priv->default_pending = TRUE;
 }
 
 /**
@@ -429,6 +1280,51 @@ mx_style_new (void)
   return g_object_new (MX_TYPE_STYLE, NULL);
 }
 
+/**
+ * mx_style_new_with_parent:
+ * @parent: the #MxStyle to layer the new style over
+ *
+ * Creates a new #MxStyle whose style sheets override the rules of @parent.
+ * A stylable styled with it gets the properties matched in @parent, which
+ * are shared with every other stylable and style matching @parent the same
+ * way, and only the rules loaded into the new style are matched on top of
+ * them. This suits a theme that only changes a few rules of another one,
+ * usually of the default style.
+ *
+ * The new style does not load the default style sheet itself, and changes
+ * whenever @parent does.
+ *
+ * Returns: a newly allocated #MxStyle
+ *
+ * Since: 2.0
+ */
+MxStyle *
+mx_style_new_with_parent (MxStyle *parent)
+{
+  g_return_val_if_fail (MX_IS_STYLE (parent), NULL);
+
+  return g_object_new (MX_TYPE_STYLE, "parent", parent, NULL);
+}
+
+/**
+ * mx_style_get_parent:
+ * @style: a #MxStyle
+ *
+ * Gets the style that @style is layered over, see
+ * mx_style_new_with_parent().
+ *
+ * Returns: (transfer none): the parent #MxStyle, or %NULL
+ *
+ * Since: 2.0
+ */
+MxStyle *
+mx_style_get_parent (MxStyle *style)
+{
+  g_return_val_if_fail (MX_IS_STYLE (style), NULL);
+
+  return style->priv->parent;
+}
+
 /**
  * mx_style_get_default:
  *
@@ -445,55 +1341,93 @@ mx_style_get_default (void)
     return default_style;
 
   default_style = g_object_new (MX_TYPE_STYLE, NULL);
+  _mx_memory_monitor_init ();
 
   return default_style;
 }
 
+/* An estimate of the matched styles kept by the default style: the entries
+ * and their property tables, whose values belong to the style sheet */
+gsize
+_mx_style_get_memory_usage (void)
+{
+  MxStylePrivate *priv;
+  gsize bytes = 0;
+  GList *l;
+
+  if (!default_style)
+    return 0;
 
-static void
-mx_style_transform_css_value (MxStyleSheetValue *css_value,
-                              MxStylable        *stylable,
-                              GParamSpec        *pspec,
-                              GValue            *value)
+  priv = default_style->priv;
+
+  for (l = priv->cached_matches->head; l; l = l->next)
+    {
+      MxStyleCacheEntry *entry = l->data;
+
+      bytes += sizeof (MxStyleCacheEntry) + sizeof (MxStyleKey) +
+        sizeof (GList) + 64 +
+        g_hash_table_size (entry->properties) * 4 * sizeof (gpointer);
+    }
+
+  return bytes;
+}
+
+/* Drops all the matched styles of the default style. Stylables match
+ * their style again the next time they look it up. */
+void
+_mx_style_trim_memory (MxMemoryTrimLevel level)
 {
-  if (pspec->value_type == G_TYPE_INT)
+  MxStylePrivate *priv;
+
+  if (!default_style)
+    return;
+
+  priv = default_style->priv;
+
+  g_hash_table_remove_all (priv->cache_hash);
+  while (g_queue_get_length (priv->cached_matches))
+    mx_style_cache_entry_free (g_queue_pop_head (priv->cached_matches), TRUE);
+}
+
+
+/* returns whether @value only depends on @css_value, the type of @pspec and
+ * @resolution, and so can be cached */
+static gboolean
+mx_style_real_transform_css_value (MxStyleSheetValue *css_value,
+                                   MxStylable        *stylable,
+                                   GParamSpec        *pspec,
+                                   gdouble            resolution,
+                                   GValue            *value)
+{
+  if (!css_value->string)
     {
+      /* a declaration without a value falls back to the default */
       g_value_init (value, pspec->value_type);
+      g_param_value_set_default (pspec, value);
 
-      if (css_value->string)
-        {
-          gint number = atoi (css_value->string);
+      return FALSE;
+    }
 
-          if (g_str_equal (g_param_spec_get_name (pspec), "font-size") &&
-              g_str_has_suffix (css_value->string, "pt"))
-            {
-              ClutterBackend *backend = clutter_get_default_backend ();
-              gdouble res = clutter_backend_get_resolution (backend);
-              number = number * res / 72.0;
-            }
+  if (pspec->value_type == G_TYPE_INT)
+    {
+      g_value_init (value, pspec->value_type);
 
-          g_value_set_int (value, number);
-        }
+      if (resolution > 0)
+        g_value_set_int (value, css_value->int_value * resolution / 72.0);
       else
-        g_value_set_int (value, ((GParamSpecInt *) pspec)->default_value);
+        g_value_set_int (value, css_value->int_value);
     }
   else if (pspec->value_type == G_TYPE_UINT)
     {
       g_value_init (value, pspec->value_type);
 
-      if (css_value->string)
-        g_value_set_uint (value, atoi (css_value->string));
-      else
-        g_value_set_uint (value, ((GParamSpecUInt *) pspec)->default_value);
+      g_value_set_uint (value, css_value->int_value);
     }
   else if (pspec->value_type == G_TYPE_FLOAT)
     {
       g_value_init (value, pspec->value_type);
 
-      if (css_value->string)
-        g_value_set_float (value, atof (css_value->string));
-      else
-        g_value_set_float (value, ((GParamSpecFloat *) pspec)->default_value);
+      g_value_set_float (value, css_value->float_value);
     }
   else if (pspec->value_type == MX_TYPE_BORDER_IMAGE)
     {
@@ -502,6 +1436,11 @@ mx_style_transform_css_value (MxStyleSheetValue *css_value,
       mx_border_image_set_from_string (value,
                                        css_value->string,
                                        css_value->source);
+
+      /* identical declarations share one instance, so that copying the
+       * value is free and comparing it is a pointer comparison */
+      g_value_set_boxed (value,
+                         _mx_border_image_intern (g_value_get_boxed (value)));
     }
   else if (pspec->value_type == MX_TYPE_FONT_WEIGHT)
     {
@@ -519,7 +1458,7 @@ mx_style_transform_css_value (MxStyleSheetValue *css_value,
       if (!g_strcmp0 (css_value->string, "none"))
         {
           g_value_set_string (value, NULL);
-          return;
+          return TRUE;
         }
 
 
@@ -559,11 +1498,12 @@ mx_style_transform_css_value (MxStyleSheetValue *css_value,
                      G_OBJECT_CLASS_NAME(G_OBJECT_GET_CLASS (stylable)),
                      css_value->string,
                      g_type_name (pspec->value_type));
+          g_type_class_unref (class);
+
+          return FALSE;
         }
-      else
-        {
-          g_value_set_enum (value, enum_value->value);
-        }
+
+      g_value_set_enum (value, enum_value->value);
 
       g_type_class_unref (class);
     }
@@ -584,9 +1524,62 @@ mx_style_transform_css_value (MxStyleSheetValue *css_value,
                      G_OBJECT_CLASS_NAME(G_OBJECT_GET_CLASS (stylable)),
                      css_value->string,
                      g_type_name (pspec->value_type));
+          g_value_unset (&strval);
+
+          return FALSE;
         }
       g_value_unset (&strval);
+
+      if (pspec->value_type == MX_TYPE_PADDING)
+        g_value_set_boxed (value, _mx_padding_intern (g_value_get_boxed (value)));
+    }
+
+  return TRUE;
+}
+
+/* the value @css_value was already transformed to for @pspec, if any;
+ * @resolution is set to the part of the cache key that depends on the
+ * display */
+static const GValue *
+mx_style_get_cached_css_value (MxStyleSheetValue *css_value,
+                               GParamSpec        *pspec,
+                               gdouble           *resolution)
+{
+  *resolution = 0;
+
+  /* point sizes depend on the resolution, which can change at any time, so
+   * it is part of the cache key */
+  if (css_value->is_pt && pspec->value_type == G_TYPE_INT &&
+      g_str_equal (g_param_spec_get_name (pspec), "font-size"))
+    {
+      ClutterBackend *backend = clutter_get_default_backend ();
+      *resolution = clutter_backend_get_resolution (backend);
     }
+
+  return mx_style_sheet_value_get_cached (css_value, pspec->value_type,
+                                          *resolution);
+}
+
+static void
+mx_style_transform_css_value (MxStyleSheetValue *css_value,
+                              MxStylable        *stylable,
+                              GParamSpec        *pspec,
+                              GValue            *value)
+{
+  const GValue *cached;
+  gdouble resolution;
+
+  cached = mx_style_get_cached_css_value (css_value, pspec, &resolution);
+  if (cached)
+    {
+      g_value_init (value, G_VALUE_TYPE (cached));
+      g_value_copy (cached, value);
+      return;
+    }
+
+  if (mx_style_real_transform_css_value (css_value, stylable, pspec,
+                                         resolution, value))
+    mx_style_sheet_value_set_cached (css_value, resolution, value);
 }
 
 
@@ -623,6 +1616,9 @@ mx_style_cache_weak_ref_cb (gpointer  data,
 static void
 mx_style_stylable_cache_free (MxStylableCache *cache)
 {
+  if (!cache)
+    return;
+
   /* If there are still styles referencing this stylable, decrement their
    * count of alive stylables and remove the weak reference.
    */
@@ -642,139 +1638,1332 @@ mx_style_stylable_cache_free (MxStylableCache *cache)
       cache->styles = g_list_delete_link (cache->styles, cache->styles);
     }
 
-  g_free (cache->string);
+  mx_style_key_unref (cache->key);
   g_slice_free (MxStylableCache, cache);
 }
 
-void
-_mx_style_invalidate_cache (MxStylable *stylable)
+/* The slot the stylable keeps its cache in, if it has one, which saves a
+ * GData lookup each time its style is fetched.
+ */
+static inline gpointer *
+mx_style_stylable_cache_slot (MxStylable *stylable)
 {
-  GObject *object = G_OBJECT (stylable);
-  MxStylableCache *cache = g_object_get_qdata (object, MX_STYLE_CACHE);
+  MxStylableIface *iface = MX_STYLABLE_GET_IFACE (stylable);
 
-  /* Reset the cache string */
-  if (cache)
-    {
-      g_free (cache->string);
-      cache->string = NULL;
-    }
+  return (iface->get_style_cache) ? iface->get_style_cache (stylable) : NULL;
 }
 
-static GHashTable *
-mx_style_get_style_sheet_properties (MxStyle    *style,
-                                     MxStylable *stylable)
+static MxStylableCache *
+mx_style_stylable_cache_peek (MxStylable *stylable)
 {
-  GList *entry_link;
-  MxStylableCache *cache;
+  gpointer *slot = mx_style_stylable_cache_slot (stylable);
 
-  MxStyleCacheEntry *entry = NULL;
-  MxStylePrivate *priv = style->priv;
+  if (G_LIKELY (slot))
+    return *slot;
 
-  /* see if we have a cached style and return that if possible */
-  cache = g_object_get_qdata (G_OBJECT (stylable), MX_STYLE_CACHE);
+  return g_object_get_qdata (G_OBJECT (stylable), MX_STYLE_CACHE);
+}
 
-  if (cache)
-    {
-      /* Make sure that the style string is up-to-date. We set this
-       * to NULL when invalidating the stylable's cache.
-       */
-      if (!cache->string)
-        cache->string = _mx_stylable_get_style_string (stylable);
+static MxStylableCache *
+mx_style_stylable_cache_get (MxStylable *stylable)
+{
+  MxStylableCache *cache;
+  gpointer *slot;
 
-      /* Check that the stylable has a reference to us. If the stylable
-       * cache struct was created by another style, we need to add ourselves
-       * to the list.
-       */
-      if (!g_list_find (cache->styles, style))
-        {
-          cache->styles = g_list_prepend (cache->styles, style);
-          g_object_weak_ref (G_OBJECT (style), mx_style_cache_weak_ref_cb,
-                             cache);
-          priv->alive_stylables ++;
-        }
-    }
-  else
+  slot = mx_style_stylable_cache_slot (stylable);
+  if (G_LIKELY (slot))
     {
-      /* This is the first time this stylable has tried to get style
-       * properties, initialise a cache.
-       */
-      cache = g_slice_new0 (MxStylableCache);
-      cache->string = _mx_stylable_get_style_string (stylable);
-      cache->styles = g_list_prepend (NULL, style);
+      if (G_UNLIKELY (!*slot))
+        *slot = g_slice_new0 (MxStylableCache);
 
-      /* Increase the alive-stylables count and add a weak reference so we
-       * can remove it.
-       */
-      priv->alive_stylables ++;
-      g_object_weak_ref (G_OBJECT (style), mx_style_cache_weak_ref_cb, cache);
+      return *slot;
+    }
 
-      MX_NOTE (STYLE_CACHE, "(%p) Alive stylables: %d",
-               style, priv->alive_stylables);
+  cache = g_object_get_qdata (G_OBJECT (stylable), MX_STYLE_CACHE);
 
+  if (G_UNLIKELY (!cache))
+    {
       /* Use qdata to associate the cache entry with the stylable object */
+      cache = g_slice_new0 (MxStylableCache);
       g_object_set_qdata_full (G_OBJECT (stylable), MX_STYLE_CACHE, cache,
                                (GDestroyNotify)mx_style_stylable_cache_free);
     }
 
-  if ((entry_link = g_hash_table_lookup (priv->cache_hash, cache->string)))
-    {
-      entry = entry_link->data;
+  return cache;
+}
 
-      /* If the entry is old, remove it from the cache */
-      if (entry->age != priv->age)
-        {
-          g_hash_table_remove (priv->cache_hash, entry->style_string);
-          g_queue_delete_link (priv->cached_matches, entry_link);
-          mx_style_cache_entry_free (entry, TRUE);
-          entry = NULL;
-        }
+/*
+ * _mx_style_free_stylable_cache:
+ * @cache: the contents of the slot returned by the get_style_cache()
+ *   virtual function of a #MxStylable, or %NULL
+ *
+ * Frees the cache #MxStyle kept in the slot of a stylable, which the
+ * stylable calls when it is finalized.
+ */
+void
+_mx_style_free_stylable_cache (gpointer cache)
+{
+  mx_style_stylable_cache_free (cache);
+}
 
-      /* As the cache is rarely emptied, FIFO is good enough for the
-       * eviction strategy (preferring speedy retrieval to efficient
-       * eviction)
-       *
-       * If we did want LRU though, for example, here would be the place
-       * to do it. You could remove the link from the queue using
-       * g_queue_unlink() and reinsert it with g_queue_push_head_link()
-       */
-    }
+static MxStyleKey *
+mx_style_stylable_get_key (MxStylable *stylable)
+{
+  MxStylableCache *cache = mx_style_stylable_cache_get (stylable);
 
-  /* No cached style properties were found, or the entry found is out of date,
-   * so look them up from the style-sheet and (re-)add them to the cache.
+  /* The key is derived from the parent's, so it only needs rebuilding
+   * when the stylable or one of its ancestors changed. We set this to
+   * NULL when invalidating the stylable's cache, which also happens for
+   * all of its children.
    */
-  if (!entry || (entry->age != priv->age))
+  if (!cache->key)
     {
-      /* Look up style properties */
-      GHashTable *properties = mx_style_sheet_get_properties (priv->stylesheet,
-                                                              stylable);
-
-      /* Append this to the style cache */
-      entry = mx_style_cache_entry_new (cache->string, properties, priv->age);
-      g_queue_push_head (priv->cached_matches, entry);
-      g_hash_table_insert (priv->cache_hash, entry->style_string,
-                           priv->cached_matches->head);
-
-      /* Shrink the cache if its grown too large */
-      while (g_queue_get_length (priv->cached_matches) >
-             (priv->alive_stylables * MX_STYLE_CACHE_SIZE))
-        {
-          MxStyleCacheEntry *old_entry =
-            g_queue_pop_tail (priv->cached_matches);
+      ClutterActor *parent;
+      MxStyleKey *parent_key = NULL;
 
-          g_hash_table_remove (priv->cache_hash, old_entry->style_string);
-          mx_style_cache_entry_free (old_entry, TRUE);
-        }
+      /* only consecutive stylable ancestors can be matched against */
+      parent = clutter_actor_get_parent (CLUTTER_ACTOR (stylable));
+      if (parent && MX_IS_STYLABLE (parent))
+        parent_key = mx_style_stylable_get_key (MX_STYLABLE (parent));
 
-      MX_NOTE (STYLE_CACHE, "(%p) Cache size: %d, (Max-size: %d)",
-               style, g_queue_get_length (priv->cached_matches),
-               priv->alive_stylables * MX_STYLE_CACHE_SIZE);
+      cache->key = mx_style_key_get (parent_key, stylable);
     }
 
-  return entry->properties ? g_hash_table_ref (entry->properties) : NULL;
+  return cache->key;
 }
 
-/**
- * mx_style_get_property:
+void
+_mx_style_invalidate_cache (MxStylable *stylable)
+{
+  MxStylableCache *cache = mx_style_stylable_cache_peek (stylable);
+
+  /* Reset the style key */
+  if (cache && cache->key)
+    {
+      mx_style_key_unref (cache->key);
+      cache->key = NULL;
+    }
+}
+
+/* whether the values @stylable passes on to children that inherit them are
+ * the same with @old_properties and @new_properties */
+static gboolean
+mx_style_inherited_values_equal (MxStylable *stylable,
+                                 GHashTable *old_properties,
+                                 GHashTable *new_properties)
+{
+  GParamSpec **pspecs;
+  gboolean equal = TRUE;
+  guint i, n_pspecs;
+
+  pspecs = mx_stylable_list_properties (stylable, &n_pspecs);
+
+  for (i = 0; equal && i < n_pspecs; i++)
+    {
+      MxStyleSheetValue *old_value, *new_value;
+      const gchar *name;
+
+      if (!(pspecs[i]->flags & MX_PARAM_STYLE_INHERIT))
+        continue;
+
+      name = mx_style_normalize_property_name (pspecs[i]->name);
+      old_value = g_hash_table_lookup (old_properties, name);
+      new_value = g_hash_table_lookup (new_properties, name);
+
+      if (old_value != new_value &&
+          (!old_value || !new_value ||
+           g_strcmp0 (old_value->string, new_value->string)))
+        equal = FALSE;
+    }
+
+  g_free (pspecs);
+
+  return equal;
+}
+
+/* whether a change to a stylable can affect the style of its descendants
+ * through the rules of @style or of the styles it is layered over */
+static gboolean
+mx_style_affects_descendants (MxStyle  *style,
+                              GQuark    id,
+                              GQuark    class,
+                              guint64   pseudo_class_mask,
+                              gboolean  pseudo_class_unmasked)
+{
+  for (; style; style = style->priv->parent)
+    {
+      if (style->priv->stylesheet &&
+          mx_style_sheet_affects_descendants (style->priv->stylesheet, id,
+                                              class, pseudo_class_mask,
+                                              pseudo_class_unmasked))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static GHashTable *mx_style_get_style_sheet_properties (MxStyle    *style,
+                                                        MxStylable *stylable);
+
+/* Matches @stylable against the rules of @style, over the properties it
+ * gets from the parent style. With @use_cache, those come from the cache of
+ * the parent, so that they are only matched once for all the styles layered
+ * over it; otherwise the current state of @stylable is matched throughout.
+ */
+static GHashTable *
+mx_style_match (MxStyle    *style,
+                MxStylable *stylable,
+                gboolean    use_cache)
+{
+  MxStylePrivate *priv = style->priv;
+  GHashTable *properties, *inherited = NULL;
+  GHashTableIter iter;
+  gpointer name, value;
+
+  if (priv->parent)
+    {
+      mx_style_ensure_default (priv->parent);
+
+      if (mx_style_has_rules (priv->parent))
+        inherited = (use_cache)
+          ? mx_style_get_style_sheet_properties (priv->parent, stylable)
+          : mx_style_match (priv->parent, stylable, FALSE);
+    }
+
+  if (!priv->stylesheet)
+    return (inherited) ? inherited
+                       : g_hash_table_new (g_str_hash, g_str_equal);
+
+  properties = mx_style_sheet_get_properties (priv->stylesheet, stylable);
+
+  if (inherited)
+    {
+      /* the rules of the style override those it inherits */
+      g_hash_table_iter_init (&iter, inherited);
+      while (g_hash_table_iter_next (&iter, &name, &value))
+        {
+          if (!g_hash_table_contains (properties, name))
+            g_hash_table_insert (properties, name, value);
+        }
+
+      g_hash_table_unref (inherited);
+    }
+
+  return properties;
+}
+
+/*
+ * _mx_style_invalidate_cache_for_change:
+ * @stylable: a #MxStylable whose name, style class or pseudo-class changed
+ *
+ * Like _mx_style_invalidate_cache(), but also works out whether the change
+ * can affect the style of the descendants of @stylable: either through a
+ * selector that tests what changed in a parent or ancestor position, or
+ * through a property that the descendants inherit.
+ *
+ * Returns: %FALSE if only @stylable needs restyling
+ */
+gboolean
+_mx_style_invalidate_cache_for_change (MxStylable *stylable)
+{
+  MxStylableCache *cache, *parent_cache;
+  MxStylePrivate *priv;
+  MxStyleKey *old_key, new_key;
+  ClutterActor *parent;
+  GList *entry_link;
+  MxStyle *style;
+  gboolean affected = TRUE;
+
+  cache = mx_style_stylable_cache_peek (stylable);
+
+  /* without the previous state, there is nothing to compare */
+  if (!cache || !cache->key)
+    return TRUE;
+
+  old_key = cache->key;
+  style = mx_stylable_get_style (stylable);
+  priv = (style) ? style->priv : NULL;
+
+  /* a change of parent changes what every descendant matches against */
+  parent = clutter_actor_get_parent (CLUTTER_ACTOR (stylable));
+  parent_cache = (parent && MX_IS_STYLABLE (parent))
+    ? mx_style_stylable_cache_peek (MX_STYLABLE (parent)) : NULL;
+
+  if ((parent_cache ? parent_cache->key : NULL) == old_key->parent &&
+      (old_key->parent || !parent || !MX_IS_STYLABLE (parent)) &&
+      priv && mx_style_has_rules (style) &&
+      (entry_link = g_hash_table_lookup (priv->cache_hash, old_key)) &&
+      ((MxStyleCacheEntry *) entry_link->data)->age == priv->age)
+    {
+      MxStyleCacheEntry *entry = entry_link->data;
+      guint64 old_mask, new_mask;
+      gboolean old_complete, new_complete;
+
+      mx_style_key_init (&new_key, old_key->parent, stylable);
+
+      old_mask = _mx_stylable_pseudo_class_to_mask (
+                   g_quark_to_string (old_key->pseudo_class), &old_complete);
+      new_mask = _mx_stylable_pseudo_class_to_mask (
+                   g_quark_to_string (new_key.pseudo_class), &new_complete);
+
+      affected =
+        mx_style_affects_descendants (style,
+                                      (new_key.id != old_key->id)
+                                      ? old_key->id : 0,
+                                      (new_key.class != old_key->class)
+                                      ? old_key->class : 0,
+                                      old_mask ^ new_mask,
+                                      (new_key.pseudo_class !=
+                                       old_key->pseudo_class) &&
+                                      (!old_complete || !new_complete)) ||
+        mx_style_affects_descendants (style,
+                                      (new_key.id != old_key->id)
+                                      ? new_key.id : 0,
+                                      (new_key.class != old_key->class)
+                                      ? new_key.class : 0,
+                                      0, FALSE);
+
+      if (!affected)
+        {
+          GHashTable *properties;
+
+          properties = mx_style_match (style, stylable, FALSE);
+          affected = !mx_style_inherited_values_equal (stylable,
+                                                       entry->properties,
+                                                       properties);
+          g_hash_table_unref (properties);
+        }
+    }
+
+  mx_style_key_unref (cache->key);
+  cache->key = NULL;
+
+  return affected;
+}
+
+static guint
+mx_style_cache_get_max_size (MxStyle *style)
+{
+  MxStylePrivate *priv = style->priv;
+
+  if (priv->cache_size)
+    return priv->cache_size;
+
+  return priv->alive_stylables * MX_STYLE_CACHE_SIZE;
+}
+
+static void
+mx_style_cache_shrink (MxStyle *style)
+{
+  MxStylePrivate *priv = style->priv;
+  guint max_size = mx_style_cache_get_max_size (style);
+
+  /* Evict the least recently used entries if the cache has grown too
+   * large */
+  while (g_queue_get_length (priv->cached_matches) > max_size)
+    {
+      MxStyleCacheEntry *old_entry = g_queue_pop_tail (priv->cached_matches);
+
+      g_hash_table_remove (priv->cache_hash, old_entry->key);
+      mx_style_cache_entry_free (old_entry, TRUE);
+      priv->cache_evictions ++;
+    }
+
+  MX_NOTE (STYLE_CACHE, "(%p) Cache size: %d, (Max-size: %d)",
+           style, g_queue_get_length (priv->cached_matches), max_size);
+}
+
+/* Makes sure @stylable has a reference to @style. If this is the first time
+ * the stylable gets style properties from this style, increase the
+ * alive-stylables count and add a weak reference so we can remove it. The
+ * style last used is kept first, so that stylables that only ever use one
+ * style, usually the default one, don't scan the list.
+ */
+static void
+mx_style_stylable_cache_add_style (MxStylable *stylable,
+                                   MxStyle    *style)
+{
+  MxStylableCache *cache = mx_style_stylable_cache_get (stylable);
+  MxStylePrivate *priv = style->priv;
+
+  if (G_UNLIKELY (!cache->styles || cache->styles->data != style))
+    {
+      GList *style_link = g_list_find (cache->styles, style);
+
+      if (style_link)
+        {
+          cache->styles = g_list_remove_link (cache->styles, style_link);
+          cache->styles = g_list_concat (style_link, cache->styles);
+        }
+      else
+        {
+          cache->styles = g_list_prepend (cache->styles, style);
+          g_object_weak_ref (G_OBJECT (style), mx_style_cache_weak_ref_cb,
+                             cache);
+          priv->alive_stylables ++;
+
+          MX_NOTE (STYLE_CACHE, "(%p) Alive stylables: %d",
+                   style, priv->alive_stylables);
+        }
+    }
+}
+
+static GHashTable *
+mx_style_get_style_sheet_properties (MxStyle    *style,
+                                     MxStylable *stylable)
+{
+  GList *entry_link;
+  MxStyleKey *key;
+
+  MxStyleCacheEntry *entry = NULL;
+  MxStylePrivate *priv = style->priv;
+
+  mx_style_stylable_cache_add_style (stylable, style);
+
+  /* see if we have a cached style and return that if possible */
+  key = mx_style_stylable_get_key (stylable);
+
+  if ((entry_link = g_hash_table_lookup (priv->cache_hash, key)))
+    {
+      entry = entry_link->data;
+
+      /* If the entry is old, remove it from the cache */
+      if (entry->age != priv->age)
+        {
+          g_hash_table_remove (priv->cache_hash, entry->key);
+          g_queue_delete_link (priv->cached_matches, entry_link);
+          mx_style_cache_entry_free (entry, TRUE);
+          entry = NULL;
+        }
+      else
+        {
+          /* Move the entry to the front, so the least recently used
+           * entries are evicted first. The link itself is kept, since the
+           * hash table points to it.
+           */
+          g_queue_unlink (priv->cached_matches, entry_link);
+          g_queue_push_head_link (priv->cached_matches, entry_link);
+          priv->cache_hits ++;
+
+          if (G_UNLIKELY (_mx_debug (MX_DEBUG_CSS_PROFILE)))
+            mx_style_sheet_profile_cache_lookup (TRUE);
+        }
+    }
+
+  /* No cached style properties were found, or the entry found is out of date,
+   * so look them up from the style-sheet and (re-)add them to the cache.
+   */
+  if (!entry || (entry->age != priv->age))
+    {
+      /* Look up style properties */
+      GHashTable *properties = mx_style_match (style, stylable, TRUE);
+
+      priv->cache_misses ++;
+
+      if (G_UNLIKELY (_mx_debug (MX_DEBUG_CSS_PROFILE)))
+        mx_style_sheet_profile_cache_lookup (FALSE);
+
+      /* Append this to the style cache */
+      entry = mx_style_cache_entry_new (key, properties, priv->age);
+      g_queue_push_head (priv->cached_matches, entry);
+      g_hash_table_insert (priv->cache_hash, entry->key,
+                           priv->cached_matches->head);
+
+      mx_style_cache_shrink (style);
+    }
+
+  return entry->properties ? g_hash_table_ref (entry->properties) : NULL;
+}
+
+/* the up-to-date entry of @style matching @stylable, if the values computed
+ * from it can be shared with other stylables */
+static MxStyleCacheEntry *
+mx_style_get_shared_entry (MxStyle    *style,
+                           MxStylable *stylable,
+                           gboolean    create)
+{
+  ClutterActor *parent;
+  GHashTable *properties;
+  GList *entry_link;
+  MxStyleCacheEntry *entry;
+
+  if (!style)
+    return NULL;
+
+  mx_style_ensure_default (style);
+
+  if (!mx_style_has_rules (style))
+    return NULL;
+
+  /* the key does not cover the ancestors past a parent that is not
+   * stylable, though inherited values may come from them */
+  parent = clutter_actor_get_parent (CLUTTER_ACTOR (stylable));
+  if (parent && !MX_IS_STYLABLE (parent))
+    return NULL;
+
+  if (create)
+    {
+      properties = mx_style_get_style_sheet_properties (style, stylable);
+      if (properties)
+        g_hash_table_unref (properties);
+    }
+
+  entry_link = g_hash_table_lookup (style->priv->cache_hash,
+                                    mx_style_stylable_get_key (stylable));
+  if (!entry_link)
+    return NULL;
+
+  entry = entry_link->data;
+
+  return (entry->age == style->priv->age) ? entry : NULL;
+}
+
+/*
+ * _mx_style_lookup_computed:
+ * @stylable: a #MxStylable
+ * @quark: what was computed
+ *
+ * Looks up the values computed from the style of @stylable that were stored
+ * with _mx_style_set_computed(), by any stylable that matched the style
+ * sheet the same way. As the values are dropped along with the matched
+ * style, a stylable can tell they changed by comparing the pointer.
+ *
+ * Returns: (transfer none): the computed values, or %NULL
+ */
+gpointer
+_mx_style_lookup_computed (MxStylable *stylable,
+                           GQuark      quark)
+{
+  MxStyleCacheEntry *entry;
+
+  entry = mx_style_get_shared_entry (mx_stylable_get_style (stylable),
+                                     stylable, TRUE);
+
+  return (entry) ? g_datalist_id_get_data (&entry->computed, quark) : NULL;
+}
+
+/*
+ * _mx_style_set_computed:
+ * @stylable: a #MxStylable
+ * @quark: what was computed
+ * @computed: (transfer full): the computed values
+ * @destroy: function to release @computed
+ *
+ * Stores values computed from the current style of @stylable, for
+ * _mx_style_lookup_computed(). If they can't be shared, @computed is
+ * released straight away.
+ */
+void
+_mx_style_set_computed (MxStylable     *stylable,
+                        GQuark          quark,
+                        gpointer        computed,
+                        GDestroyNotify  destroy)
+{
+  MxStyleCacheEntry *entry;
+
+  entry = mx_style_get_shared_entry (mx_stylable_get_style (stylable),
+                                     stylable, FALSE);
+
+  if (entry)
+    g_datalist_id_set_data_full (&entry->computed, quark, computed, destroy);
+  else
+    destroy (computed);
+}
+
+/**
+ * mx_style_set_cache_size:
+ * @style: a #MxStyle
+ * @size: the maximum number of matched styles to cache, or 0
+ *
+ * Sets the maximum number of matched styles @style keeps, evicting the
+ * least recently used ones when it is exceeded. With a size of 0, the
+ * default, the cache scales with the number of stylables using @style.
+ *
+ * Since: 2.0
+ */
+void
+mx_style_set_cache_size (MxStyle *style,
+                         guint    size)
+{
+  MxStylePrivate *priv;
+
+  g_return_if_fail (MX_IS_STYLE (style));
+
+  priv = style->priv;
+
+  if (priv->cache_size != size)
+    {
+      priv->cache_size = size;
+      mx_style_cache_shrink (style);
+
+      g_object_notify (G_OBJECT (style), "cache-size");
+    }
+}
+
+/**
+ * mx_style_get_cache_size:
+ * @style: a #MxStyle
+ *
+ * Gets the maximum number of matched styles that @style caches. See
+ * mx_style_set_cache_size().
+ *
+ * Returns: the maximum cache size, or 0 if it is automatic
+ *
+ * Since: 2.0
+ */
+guint
+mx_style_get_cache_size (MxStyle *style)
+{
+  g_return_val_if_fail (MX_IS_STYLE (style), 0);
+
+  return style->priv->cache_size;
+}
+
+/**
+ * mx_style_set_load_default:
+ * @style: a #MxStyle
+ * @load_default: %TRUE to load the default style sheet
+ *
+ * Sets whether @style loads the default style sheet, or the one named by
+ * the MX_RC_FILE environment variable. It is loaded the first time a style
+ * sheet is added to @style or a stylable is styled with it, so an
+ * application that replaces the whole style can turn it off before then
+ * to avoid parsing it at all. Once loaded, it is not removed.
+ *
+ * Since: 2.0
+ */
+void
+mx_style_set_load_default (MxStyle  *style,
+                           gboolean  load_default)
+{
+  MxStylePrivate *priv;
+
+  g_return_if_fail (MX_IS_STYLE (style));
+
+  priv = style->priv;
+
+  load_default = !!load_default;
+  if (priv->load_default != load_default)
+    {
+      priv->load_default = load_default;
+
+      /* the default may already have been loaded, then this is too late */
+      if (!load_default)
+        priv->default_pending = FALSE;
+
+      g_object_notify (G_OBJECT (style), "load-default");
+    }
+}
+
+/**
+ * mx_style_get_load_default:
+ * @style: a #MxStyle
+ *
+ * Gets whether @style loads the default style sheet. See
+ * mx_style_set_load_default().
+ *
+ * Returns: %TRUE if the default style sheet is loaded
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_style_get_load_default (MxStyle *style)
+{
+  g_return_val_if_fail (MX_IS_STYLE (style), FALSE);
+
+  return style->priv->load_default;
+}
+
+/**
+ * mx_style_get_cache_stats:
+ * @style: a #MxStyle
+ * @hits: (out) (allow-none): return location for the number of cache hits
+ * @misses: (out) (allow-none): return location for the number of cache
+ *   misses
+ * @evictions: (out) (allow-none): return location for the number of
+ *   entries evicted to keep the cache within its size
+ *
+ * Gets the counters of the cache of matched styles in @style, for tuning
+ * the cache size.
+ *
+ * Since: 2.0
+ */
+void
+mx_style_get_cache_stats (MxStyle *style,
+                          guint   *hits,
+                          guint   *misses,
+                          guint   *evictions)
+{
+  MxStylePrivate *priv;
+
+  g_return_if_fail (MX_IS_STYLE (style));
+
+  priv = style->priv;
+
+  if (hits)
+    *hits = priv->cache_hits;
+  if (misses)
+    *misses = priv->cache_misses;
+  if (evictions)
+    *evictions = priv->cache_evictions;
+}
+
+/**
+ * mx_style_get_selector_profile:
+ * @style: a #MxStyle
+ * @max_selectors: the maximum number of selectors to return
+ *
+ * Describes the selectors of @style that took the longest to match, for
+ * finding the rules that make restyling slow. Each line has the time spent
+ * matching the selector in milliseconds, the number of times it was tried,
+ * the number of times it matched, the selector itself and where it was
+ * loaded from.
+ *
+ * Selectors are only profiled when the MX_DEBUG environment variable
+ * contains "css-profile", otherwise the array is empty.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): a newly allocated
+ *   array of strings, to be freed with g_strfreev()
+ *
+ * Since: 2.0
+ */
+gchar **
+mx_style_get_selector_profile (MxStyle *style,
+                               guint    max_selectors)
+{
+  MxStylePrivate *priv;
+
+  g_return_val_if_fail (MX_IS_STYLE (style), NULL);
+
+  priv = style->priv;
+
+  if (!priv->stylesheet)
+    return g_new0 (gchar *, 1);
+
+  return mx_style_sheet_profile_get_report (priv->stylesheet, max_selectors);
+}
+
+static void
+mx_style_stop_prewarm (MxStyle *style)
+{
+  MxStylePrivate *priv = style->priv;
+
+  if (priv->prewarm_source)
+    {
+      g_source_remove (priv->prewarm_source);
+      priv->prewarm_source = 0;
+    }
+
+  /* the font descriptions are shared, see
+   * _mx_stylable_get_font_description() */
+  if (priv->prewarm_fonts)
+    {
+      g_queue_free (priv->prewarm_fonts);
+      priv->prewarm_fonts = NULL;
+    }
+
+  if (priv->prewarm_actor)
+    {
+      g_object_unref (priv->prewarm_actor);
+      priv->prewarm_actor = NULL;
+    }
+
+  g_free (priv->prewarm_characters);
+  priv->prewarm_characters = NULL;
+}
+
+static gboolean
+mx_style_prewarm_fonts_cb (MxStyle *style)
+{
+  MxStylePrivate *priv = style->priv;
+  PangoFontDescription *descr;
+  PangoLayout *layout;
+  gint64 end;
+
+  end = g_get_monotonic_time () + MX_STYLE_PREWARM_SLICE * 1000;
+
+  while ((descr = g_queue_pop_head (priv->prewarm_fonts)))
+    {
+      layout = clutter_actor_create_pango_layout (priv->prewarm_actor,
+                                                  priv->prewarm_characters);
+      pango_layout_set_font_description (layout, descr);
+      cogl_pango_ensure_glyph_cache_for_layout (layout);
+      g_object_unref (layout);
+
+      if (g_get_monotonic_time () >= end)
+        break;
+    }
+
+  if (!g_queue_is_empty (priv->prewarm_fonts))
+    return TRUE;
+
+  priv->prewarm_source = 0;
+  mx_style_stop_prewarm (style);
+
+  return FALSE;
+}
+
+/* the font of the text of a stylable that only @css applies to, or %NULL
+ * if @css does not set any of the font properties */
+static PangoFontDescription *
+mx_style_get_css_font (GHashTable *css)
+{
+  MxStyleSheetValue *family_value, *size_value, *weight_value;
+  GValue family = { 0, }, size = { 0, }, weight = { 0, };
+  PangoFontDescription *descr;
+  gchar *stripped = NULL;
+
+  family_value = g_hash_table_lookup (css, "font-family");
+  size_value = g_hash_table_lookup (css, "font-size");
+  weight_value = g_hash_table_lookup (css, "font-weight");
+
+  if (!family_value && !size_value && !weight_value)
+    return NULL;
+
+  if (!_mx_stylable_get_default_font_value ("font-family", &family) ||
+      !_mx_stylable_get_default_font_value ("font-size", &size) ||
+      !_mx_stylable_get_default_font_value ("font-weight", &weight))
+    {
+      if (G_IS_VALUE (&family))
+        g_value_unset (&family);
+      if (G_IS_VALUE (&size))
+        g_value_unset (&size);
+      return NULL;
+    }
+
+  if (family_value && family_value->string &&
+      g_strcmp0 (family_value->string, "none"))
+    {
+      gint len = strlen (family_value->string);
+
+      if (len > 1 &&
+          ((family_value->string[0] == '\'' &&
+            family_value->string[len - 1] == '\'') ||
+           (family_value->string[0] == '\"' &&
+            family_value->string[len - 1] == '\"')))
+        stripped = g_strndup (family_value->string + 1, len - 2);
+      else
+        stripped = g_strdup (family_value->string);
+    }
+
+  if (size_value && size_value->string)
+    {
+      if (size_value->is_pt)
+        {
+          ClutterBackend *backend = clutter_get_default_backend ();
+          gdouble resolution = clutter_backend_get_resolution (backend);
+
+          g_value_set_int (&size, size_value->int_value * resolution / 72.0);
+        }
+      else
+        g_value_set_int (&size, size_value->int_value);
+    }
+
+  if (weight_value && weight_value->string)
+    mx_font_weight_set_from_string (&weight, weight_value->string);
+
+  descr = _mx_stylable_get_font_description (stripped ? stripped :
+                                             g_value_get_string (&family),
+                                             g_value_get_int (&size),
+                                             g_value_get_enum (&weight));
+
+  g_free (stripped);
+  g_value_unset (&family);
+  g_value_unset (&size);
+  g_value_unset (&weight);
+
+  return descr;
+}
+
+/**
+ * mx_style_prewarm_fonts:
+ * @style: a #MxStyle
+ * @characters: (allow-none): the characters to render, or %NULL for the
+ *   printable ASCII characters
+ *
+ * Renders @characters in each of the fonts the rules loaded in @style set,
+ * so that their glyphs are cached before any text needs them, rather than
+ * on the first frame that shows text in a new font. The rendering is done
+ * a few milliseconds at a time when the main loop is idle, so this is best
+ * called once the style sheets are loaded at startup.
+ *
+ * Calling this again replaces the fonts and characters still to be
+ * rendered.
+ *
+ * Since: 2.0
+ */
+void
+mx_style_prewarm_fonts (MxStyle     *style,
+                        const gchar *characters)
+{
+  MxStylePrivate *priv;
+  GHashTable *fonts;
+  GList *styles, *l;
+
+  g_return_if_fail (MX_IS_STYLE (style));
+
+  priv = style->priv;
+
+  mx_style_stop_prewarm (style);
+
+  mx_style_ensure_default (style);
+
+  if (!priv->stylesheet)
+    return;
+
+  if (!characters)
+    characters = MX_STYLE_PREWARM_CHARACTERS;
+
+  if (!*characters)
+    return;
+
+  /* the descriptions are interned, so each font is only queued once */
+  fonts = g_hash_table_new (NULL, NULL);
+  priv->prewarm_fonts = g_queue_new ();
+
+  styles = mx_style_sheet_get_styles (priv->stylesheet);
+  for (l = styles; l; l = l->next)
+    {
+      PangoFontDescription *descr = mx_style_get_css_font (l->data);
+
+      if (descr && !g_hash_table_lookup (fonts, descr))
+        {
+          g_hash_table_add (fonts, descr);
+          g_queue_push_tail (priv->prewarm_fonts, descr);
+        }
+    }
+  g_list_free (styles);
+  g_hash_table_unref (fonts);
+
+  if (g_queue_is_empty (priv->prewarm_fonts))
+    {
+      mx_style_stop_prewarm (style);
+      return;
+    }
+
+  priv->prewarm_characters = g_strdup (characters);
+  priv->prewarm_actor = g_object_ref_sink (clutter_actor_new ());
+  priv->prewarm_source =
+    g_idle_add_full (G_PRIORITY_LOW,
+                     (GSourceFunc) mx_style_prewarm_fonts_cb, style, NULL);
+}
+
+/* A style key whose match mx_style_prematch_async() makes on a worker
+ * thread, from the nodes captured from a stylable with that key */
+typedef struct
+{
+  MxStyleKey        *key;
+  MxStyleSheetNodes *nodes;
+  GHashTable        *properties;
+} MxStylePrematch;
+
+typedef struct
+{
+  GCancellable *cancellable;
+
+  /* the style sheets of the style and of each style it is layered over,
+   * with their generations and the age of the style when the nodes were
+   * captured, so that matches against changed rules are dropped */
+  GPtrArray    *sheets;
+  GArray       *generations;
+  gint          age;
+
+  GArray       *matches;
+  GHashTable   *keys;
+} MxStylePrematchData;
+
+static void
+mx_style_prematch_data_free (MxStylePrematchData *data)
+{
+  guint i;
+
+  for (i = 0; i < data->matches->len; i++)
+    {
+      MxStylePrematch *match =
+        &g_array_index (data->matches, MxStylePrematch, i);
+
+      mx_style_key_unref (match->key);
+      mx_style_sheet_nodes_free (match->nodes);
+      if (match->properties)
+        g_hash_table_unref (match->properties);
+    }
+  g_array_free (data->matches, TRUE);
+  g_hash_table_unref (data->keys);
+
+  g_ptr_array_unref (data->sheets);
+  g_array_free (data->generations, TRUE);
+
+  if (data->cancellable)
+    g_object_unref (data->cancellable);
+
+  g_slice_free (MxStylePrematchData, data);
+}
+
+/* captures the nodes of the stylables in the subtree of @actor that use
+ * @style and have no up-to-date match yet, one for each key */
+static void
+mx_style_prematch_capture (MxStyle             *style,
+                           MxStylePrematchData *data,
+                           ClutterActor        *actor)
+{
+  MxStylePrivate *priv = style->priv;
+  ClutterActorIter iter;
+  ClutterActor *child;
+
+  if (MX_IS_STYLABLE (actor) &&
+      mx_stylable_get_style (MX_STYLABLE (actor)) == style)
+    {
+      MxStylable *stylable = MX_STYLABLE (actor);
+      MxStyleCacheEntry *entry = NULL;
+      GList *entry_link;
+      MxStyleKey *key;
+
+      /* the stylable counts as alive from now on, so that the size of the
+       * cache allows for its match before it first uses it */
+      mx_style_stylable_cache_add_style (stylable, style);
+
+      key = mx_style_stylable_get_key (stylable);
+
+      if ((entry_link = g_hash_table_lookup (priv->cache_hash, key)))
+        entry = entry_link->data;
+
+      if ((!entry || entry->age != priv->age) &&
+          !g_hash_table_contains (data->keys, key))
+        {
+          MxStylePrematch match;
+
+          match.key = mx_style_key_ref (key);
+          match.nodes = mx_style_sheet_nodes_capture (stylable);
+          match.properties = NULL;
+
+          g_array_append_val (data->matches, match);
+          g_hash_table_add (data->keys, key);
+        }
+    }
+
+  clutter_actor_iter_init (&iter, actor);
+  while (clutter_actor_iter_next (&iter, &child))
+    mx_style_prematch_capture (style, data, child);
+}
+
+/* runs on a worker thread, and so must only touch the captured nodes and
+ * the style sheets, which are locked while they are matched against */
+static void
+mx_style_prematch_thread (gpointer user_data)
+{
+  GSimpleAsyncResult *simple = user_data;
+  MxStylePrematchData *data = g_simple_async_result_get_op_res_gpointer (simple);
+  guint i, j;
+
+  for (i = 0; i < data->matches->len; i++)
+    {
+      MxStylePrematch *match =
+        &g_array_index (data->matches, MxStylePrematch, i);
+
+      if (g_cancellable_is_cancelled (data->cancellable))
+        return;
+
+      /* as in mx_style_match(), the rules of a style override those of the
+       * styles it is layered over */
+      for (j = 0; j < data->sheets->len; j++)
+        {
+          GHashTable *properties;
+          GHashTableIter iter;
+          gpointer name, value;
+
+          properties = mx_style_sheet_match_nodes (data->sheets->pdata[j],
+                                                   match->nodes);
+
+          if (!match->properties)
+            {
+              match->properties = properties;
+              continue;
+            }
+
+          g_hash_table_iter_init (&iter, properties);
+          while (g_hash_table_iter_next (&iter, &name, &value))
+            {
+              if (!g_hash_table_contains (match->properties, name))
+                g_hash_table_insert (match->properties, name, value);
+            }
+
+          g_hash_table_unref (properties);
+        }
+
+      if (!match->properties)
+        match->properties = g_hash_table_new (g_str_hash, g_str_equal);
+    }
+}
+
+/* back in the main loop, with the matches made */
+static void
+mx_style_prematch_ready (gpointer user_data)
+{
+  GSimpleAsyncResult *simple = user_data;
+  GObject *object = g_async_result_get_source_object (G_ASYNC_RESULT (simple));
+  MxStyle *style = MX_STYLE (object);
+  MxStylePrivate *priv = style->priv;
+  MxStylePrematchData *data = g_simple_async_result_get_op_res_gpointer (simple);
+  GError *error = NULL;
+  gboolean current;
+  guint i;
+
+  current = (data->age == priv->age);
+  for (i = 0; current && i < data->sheets->len; i++)
+    {
+      if (mx_style_sheet_get_generation (data->sheets->pdata[i]) !=
+          g_array_index (data->generations, guint, i))
+        current = FALSE;
+    }
+
+  if (g_cancellable_set_error_if_cancelled (data->cancellable, &error))
+    {
+      g_simple_async_result_take_error (simple, error);
+    }
+  else if (current)
+    {
+      for (i = 0; i < data->matches->len; i++)
+        {
+          MxStylePrematch *match =
+            &g_array_index (data->matches, MxStylePrematch, i);
+          MxStyleCacheEntry *entry;
+          GList *entry_link;
+
+          /* a stylable may have been matched in the meantime */
+          if ((entry_link = g_hash_table_lookup (priv->cache_hash,
+                                                 match->key)))
+            {
+              entry = entry_link->data;
+
+              if (entry->age == priv->age)
+                continue;
+
+              g_hash_table_remove (priv->cache_hash, entry->key);
+              g_queue_delete_link (priv->cached_matches, entry_link);
+              mx_style_cache_entry_free (entry, TRUE);
+            }
+
+          entry = mx_style_cache_entry_new (match->key, match->properties,
+                                            priv->age);
+          match->properties = NULL;
+
+          g_queue_push_head (priv->cached_matches, entry);
+          g_hash_table_insert (priv->cache_hash, entry->key,
+                               priv->cached_matches->head);
+        }
+
+      mx_style_cache_shrink (style);
+    }
+
+  g_simple_async_result_complete (simple);
+  g_object_unref (simple);
+  g_object_unref (object);
+}
+
+/**
+ * mx_style_prematch_async:
+ * @style: a #MxStyle
+ * @root: the root of a subtree of actors
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *   matches are made
+ * @user_data: (closure): data to pass to @callback
+ *
+ * Matches the rules of @style for the stylables in the subtree of @root
+ * that use it on a worker thread, rather than one by one on the main
+ * thread as each stylable is first styled. This is meant for large
+ * subtrees that were just built, such as the pages of an application.
+ *
+ * What the rules are matched against - the type, name, style class and
+ * pseudo-class of each stylable and of its stylable ancestors - is taken
+ * before this returns. The matches are added to the cache of @style in the
+ * main loop, before @callback is called, so the subtree is best added to
+ * its parent first, and only shown from @callback. If the rules of @style
+ * change in the meantime, the matches are dropped, and the stylables are
+ * matched as usual.
+ *
+ * When the operation is finished, @callback is called; call
+ * mx_style_prematch_finish() from it to get the result.
+ *
+ * Since: 2.0
+ */
+void
+mx_style_prematch_async (MxStyle             *style,
+                         ClutterActor        *root,
+                         GCancellable        *cancellable,
+                         GAsyncReadyCallback  callback,
+                         gpointer             user_data)
+{
+  GSimpleAsyncResult *simple;
+  MxStylePrematchData *data;
+  MxStyle *layer;
+
+  g_return_if_fail (MX_IS_STYLE (style));
+  g_return_if_fail (CLUTTER_IS_ACTOR (root));
+
+  data = g_slice_new0 (MxStylePrematchData);
+  if (cancellable)
+    data->cancellable = g_object_ref (cancellable);
+
+  data->sheets = g_ptr_array_new ();
+  data->generations = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  for (layer = style; layer; layer = layer->priv->parent)
+    {
+      guint generation;
+
+      mx_style_ensure_default (layer);
+
+      if (!layer->priv->stylesheet)
+        continue;
+
+      generation = mx_style_sheet_get_generation (layer->priv->stylesheet);
+      g_ptr_array_add (data->sheets, layer->priv->stylesheet);
+      g_array_append_val (data->generations, generation);
+    }
+
+  data->age = style->priv->age;
+
+  data->matches = g_array_new (FALSE, FALSE, sizeof (MxStylePrematch));
+  data->keys = g_hash_table_new (NULL, NULL);
+  mx_style_prematch_capture (style, data, root);
+
+  simple = g_simple_async_result_new (G_OBJECT (style), callback, user_data,
+                                      mx_style_prematch_async);
+  g_simple_async_result_set_op_res_gpointer (simple, data,
+                                             (GDestroyNotify)
+                                             mx_style_prematch_data_free);
+
+  mx_worker_pool_push (mx_worker_pool_get_default (), G_PRIORITY_DEFAULT,
+                       mx_style_prematch_thread, mx_style_prematch_ready,
+                       simple, cancellable);
+}
+
+/**
+ * mx_style_prematch_finish:
+ * @style: a #MxStyle
+ * @result: the #GAsyncResult passed to the callback
+ * @error: a #GError or #NULL
+ *
+ * Finishes matching rules started with mx_style_prematch_async().
+ *
+ * Returns: %FALSE if the operation was cancelled, %TRUE otherwise
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_style_prematch_finish (MxStyle       *style,
+                          GAsyncResult  *result,
+                          GError       **error)
+{
+  g_return_val_if_fail (MX_IS_STYLE (style), FALSE);
+  g_return_val_if_fail (g_simple_async_result_is_valid (result,
+                                                        G_OBJECT (style),
+                                                        mx_style_prematch_async),
+                        FALSE);
+
+  return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result),
+                                                 error);
+}
+
+typedef struct
+{
+  GValue value;
+  guint  settings_serial;
+} MxStyleInheritedValue;
+
+static void
+mx_style_inherited_value_free (MxStyleInheritedValue *inherited)
+{
+  g_value_unset (&inherited->value);
+  g_slice_free (MxStyleInheritedValue, inherited);
+}
+
+static GQuark
+mx_style_inherited_quark (GParamSpec *pspec)
+{
+  static GQuark quark_inherited = 0;
+  GQuark quark;
+
+  if (G_UNLIKELY (!quark_inherited))
+    quark_inherited = g_quark_from_static_string ("mx-style-inherited");
+
+  quark = GPOINTER_TO_UINT (g_param_spec_get_qdata (pspec, quark_inherited));
+  if (G_UNLIKELY (!quark))
+    {
+      gchar *name = g_strconcat ("mx-style-inherited-", pspec->name, NULL);
+
+      quark = g_quark_from_string (name);
+      g_param_spec_set_qdata (pspec, quark_inherited,
+                              GUINT_TO_POINTER (quark));
+      g_free (name);
+    }
+
+  return quark;
+}
+
+/* Gets the value @stylable inherits for @pspec from its closest stylable
+ * ancestor. The value of each ancestor is kept with its matched style, so
+ * it is only worked out once for all of its descendants rather than by
+ * walking up to the root for each of them. */
+static void
+mx_style_get_inherited_value (MxStyle    *style,
+                              MxStylable *stylable,
+                              GParamSpec *pspec,
+                              GValue     *value)
+{
+  MxStyleInheritedValue *inherited;
+  MxStyleCacheEntry *entry;
+  ClutterActor *parent;
+  GQuark quark;
+
+  for (parent = clutter_actor_get_parent ((ClutterActor*) stylable);
+       parent;
+       parent = clutter_actor_get_parent (parent))
+    {
+      if (MX_IS_STYLABLE (parent))
+        break;
+    }
+
+  if (!parent)
+    {
+      _mx_stylable_get_default_value_for_pspec (pspec, value);
+      return;
+    }
+
+  quark = mx_style_inherited_quark (pspec);
+
+  /* the values at the root may be defaults from the settings */
+  entry = mx_style_get_shared_entry (style, MX_STYLABLE (parent), TRUE);
+  inherited = (entry) ? g_datalist_id_get_data (&entry->computed, quark)
+                      : NULL;
+  if (inherited &&
+      inherited->settings_serial == _mx_stylable_get_font_settings_serial ())
+    {
+      g_value_init (value, G_VALUE_TYPE (&inherited->value));
+      g_value_copy (&inherited->value, value);
+      return;
+    }
+
+  mx_style_get_property (style, MX_STYLABLE (parent), pspec, value);
+
+  /* looking up the value may have evicted the entry */
+  entry = mx_style_get_shared_entry (style, MX_STYLABLE (parent), FALSE);
+  if (entry)
+    {
+      inherited = g_slice_new0 (MxStyleInheritedValue);
+      inherited->settings_serial = _mx_stylable_get_font_settings_serial ();
+      g_value_init (&inherited->value, G_VALUE_TYPE (value));
+      g_value_copy (value, &inherited->value);
+
+      g_datalist_id_set_data_full (&entry->computed, quark, inherited,
+                                   (GDestroyNotify)
+                                   mx_style_inherited_value_free);
+    }
+}
+
+/**
+ * mx_style_get_property:
  * @style: the style data store object
  * @stylable: a stylable to retreive the data for
  * @pspec: a #GParamSpec describing the property required
@@ -798,8 +2987,10 @@ mx_style_get_property (MxStyle    *style,
 
   priv = style->priv;
 
+  mx_style_ensure_default (style);
+
   /* look up the property in the css */
-  if (priv->stylesheet)
+  if (mx_style_has_rules (style))
     {
       MxStyleSheetValue *css_value;
       GHashTable *properties;
@@ -813,28 +3004,11 @@ mx_style_get_property (MxStyle    *style,
         {
           if (pspec->flags & MX_PARAM_STYLE_INHERIT)
             {
-              ClutterActor *parent;
-
-              /* if the style property is set to inherit its value, then find a
-               * parent that is an MxStylable and copy its value */
-
-              for (parent = clutter_actor_get_parent ((ClutterActor*) stylable);
-                   parent;
-                   parent = clutter_actor_get_parent (parent))
-                {
-                  if (MX_IS_STYLABLE (parent))
-                    break;
-                }
-
-              if (parent)
-                mx_style_get_property (style, (MxStylable *) parent, pspec,
-                                       value);
-              else
-                mx_stylable_get_default_value (stylable, pspec->name, value);
+              mx_style_get_inherited_value (style, stylable, pspec, value);
 
             }
           else
-            mx_stylable_get_default_value (stylable, pspec->name, value);
+            _mx_stylable_get_default_value_for_pspec (pspec, value);
         }
       else
         mx_style_transform_css_value (css_value, stylable, pspec, value);
@@ -843,6 +3017,56 @@ mx_style_get_property (MxStyle    *style,
     }
 }
 
+/*
+ * _mx_style_peek_property:
+ * @style: a #MxStyle
+ * @stylable: a #MxStylable
+ * @pspec: the style property to get
+ * @scratch: an empty #GValue
+ *
+ * Like mx_style_get_property(), but avoids copying the value when it is
+ * already transformed from the style sheet. Otherwise the value is put in
+ * @scratch, which the caller must unset if it was initialized.
+ *
+ * Returns: (transfer none): the value of @pspec for @stylable, valid until
+ *   the style changes
+ */
+const GValue *
+_mx_style_peek_property (MxStyle    *style,
+                         MxStylable *stylable,
+                         GParamSpec *pspec,
+                         GValue     *scratch)
+{
+  MxStylePrivate *priv = style->priv;
+
+  mx_style_ensure_default (style);
+
+  if (mx_style_has_rules (style))
+    {
+      MxStyleSheetValue *css_value;
+      const GValue *cached = NULL;
+      GHashTable *properties;
+      gdouble resolution;
+
+      properties = mx_style_get_style_sheet_properties (style, stylable);
+      css_value = g_hash_table_lookup (properties,
+                                       mx_style_normalize_property_name (pspec->name));
+
+      /* the cache entry keeps the properties, and so the value, alive */
+      if (css_value)
+        cached = mx_style_get_cached_css_value (css_value, pspec, &resolution);
+
+      g_hash_table_unref (properties);
+
+      if (cached)
+        return cached;
+    }
+
+  mx_style_get_property (style, stylable, pspec, scratch);
+
+  return G_IS_VALUE (scratch) ? scratch : NULL;
+}
+
 /**
  * mx_style_get_valist:
  * @style: a #MxStyle
@@ -871,8 +3095,10 @@ mx_style_get_valist (MxStyle     *style,
 
   priv = style->priv;
 
+  mx_style_ensure_default (style);
+
   /* look up the property in the css */
-  if (priv->stylesheet)
+  if (mx_style_has_rules (style))
     {
       GHashTable *properties;
 
@@ -901,28 +3127,12 @@ mx_style_get_valist (MxStyle     *style,
             {
               if (pspec->flags & MX_PARAM_STYLE_INHERIT)
                 {
-                  ClutterActor *parent;
-
-                  /* if the style property is set to inherit its value, then find a
-                   * parent that is an MxStylable and copy its value */
-
-                  for (parent = clutter_actor_get_parent ((ClutterActor*) stylable);
-                       parent;
-                       parent = clutter_actor_get_parent (parent))
-                    {
-                      if (MX_IS_STYLABLE (parent))
-                        break;
-                    }
-
-                  if (parent)
-                    mx_style_get_property (style, (MxStylable *) parent, pspec,
-                                           &value);
-                  else
-                    mx_stylable_get_default_value (stylable, pspec->name, &value);
+                  mx_style_get_inherited_value (style, stylable, pspec,
+                                                &value);
 
                 }
               else
-                mx_stylable_get_default_value (stylable, pspec->name, &value);
+                _mx_stylable_get_default_value_for_pspec (pspec, &value);
             }
           else
             mx_style_transform_css_value (css_value, stylable, pspec, &value);
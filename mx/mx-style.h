@@ -26,6 +26,7 @@
 
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <clutter/clutter.h>
 
 G_BEGIN_DECLS
 
@@ -86,10 +87,23 @@ GType mx_style_get_type (void) G_GNUC_CONST;
 
 MxStyle *mx_style_get_default (void);
 MxStyle *mx_style_new         (void);
+MxStyle *mx_style_new_with_parent (MxStyle *parent);
+MxStyle *mx_style_get_parent  (MxStyle *style);
 
 gboolean mx_style_load_from_file (MxStyle      *style,
                                   const gchar  *filename,
                                   GError      **error);
+void     mx_style_load_from_file_async  (MxStyle             *style,
+                                         const gchar         *filename,
+                                         GCancellable        *cancellable,
+                                         GAsyncReadyCallback  callback,
+                                         gpointer             user_data);
+gboolean mx_style_load_from_file_finish (MxStyle             *style,
+                                         GAsyncResult        *result,
+                                         GError             **error);
+gboolean mx_style_load_from_files (MxStyle      *style,
+                                   const gchar **filenames,
+                                   GError      **error);
 gboolean mx_style_load_from_data (MxStyle      *style,
                                   const gchar  *id,
                                   const gchar  *data,
@@ -99,6 +113,38 @@ gboolean mx_style_load_from_resource (MxStyle      *style,
                                       const gchar  *path,
                                       GError      **error);
 
+gboolean mx_style_load_from_compiled_file (MxStyle      *style,
+                                           const gchar  *filename,
+                                           GError      **error);
+gboolean mx_style_compile_file            (const gchar  *filename,
+                                           const gchar  *output,
+                                           GError      **error);
+
+void     mx_style_set_cache_size  (MxStyle      *style,
+                                   guint         size);
+guint    mx_style_get_cache_size  (MxStyle      *style);
+void     mx_style_set_load_default (MxStyle     *style,
+                                    gboolean     load_default);
+gboolean mx_style_get_load_default (MxStyle     *style);
+void     mx_style_get_cache_stats (MxStyle      *style,
+                                   guint        *hits,
+                                   guint        *misses,
+                                   guint        *evictions);
+gchar  **mx_style_get_selector_profile (MxStyle     *style,
+                                        guint        max_selectors);
+
+void     mx_style_prewarm_fonts   (MxStyle      *style,
+                                   const gchar  *characters);
+
+void     mx_style_prematch_async  (MxStyle             *style,
+                                   ClutterActor        *root,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data);
+gboolean mx_style_prematch_finish (MxStyle             *style,
+                                   GAsyncResult        *result,
+                                   GError             **error);
+
 void     mx_style_get_property   (MxStyle      *style,
                                   MxStylable   *stylable,
                                   GParamSpec   *pspec,
@@ -63,6 +63,8 @@
 #include "mx-table-child.h"
 #include "mx-stylable.h"
 #include "mx-focusable.h"
+#include "mx-tile-cache.h"
+#include "mx-box-array.h"
 
 enum
 {
@@ -90,6 +92,29 @@ typedef struct
 
 } DimensionData;
 
+/* Where a row or a column is, as allocated last. end also covers the ones
+ * before it, so that it only ever increases. */
+typedef struct
+{
+  gfloat start;
+  gfloat end;
+} MxTableOffset;
+
+/* The columns and rows solved for a size, kept until a relayout is queued */
+typedef struct
+{
+  gboolean valid;
+  gfloat   for_width;
+  gfloat   for_height;
+  GArray  *columns;
+  GArray  *rows;
+  gint     visible_cols;
+  gint     visible_rows;
+  guint    age;
+} MxTableSolution;
+
+#define MX_TABLE_N_SOLUTIONS 3
+
 struct _MxTablePrivate
 {
   guint   ignore_css_col_spacing : 1;
@@ -109,6 +134,25 @@ struct _MxTablePrivate
   GArray *columns;
   GArray *rows;
 
+  /* the preferred width, preferred height and allocation usually each ask
+   * for a different size */
+  MxTableSolution solutions[MX_TABLE_N_SOLUTIONS];
+  guint           solution_age;
+
+  /* the child at each cell, row by row, built when needed; irregular is
+   * set when children overlap or are out of the cells, so that they cannot
+   * be painted by going through the cells */
+  ClutterActor  **cells;
+  gboolean        cells_valid;
+  gboolean        cells_irregular;
+
+  GArray         *row_offsets;
+  GArray         *col_offsets;
+
+  /* the allocations of the visible children, for culling them when they
+   * can't be found through the cells */
+  MxBoxArray     *boxes;
+
   MxFocusable *last_focus;
 };
 
@@ -116,6 +160,8 @@ static void mx_container_iface_init (ClutterContainerIface *iface);
 static void mx_focusable_iface_init (MxFocusableIface *iface);
 static void mx_stylable_iface_init (MxStylableIface *iface);
 
+static void mx_table_invalidate_solutions (MxTable *table);
+
 G_DEFINE_TYPE_WITH_CODE (MxTable, mx_table, MX_TYPE_WIDGET,
                          G_IMPLEMENT_INTERFACE (CLUTTER_TYPE_CONTAINER,
                                                 mx_container_iface_init)
@@ -125,28 +171,79 @@ G_DEFINE_TYPE_WITH_CODE (MxTable, mx_table, MX_TYPE_WIDGET,
                                                 mx_focusable_iface_init));
 
 
-static ClutterActor*
-mx_table_find_actor_at (MxTable *table,
-                        int      row,
-                        int      column)
+static void
+mx_table_invalidate_cells (MxTable *table)
 {
+  MxTablePrivate *priv = table->priv;
+
+  g_free (priv->cells);
+  priv->cells = NULL;
+  priv->cells_valid = FALSE;
+
+  _mx_box_array_set_length (priv->boxes, 0);
+}
+
+/* Fills in the child at each cell, the first one to cover it when
+ * children overlap */
+static void
+mx_table_ensure_cells (MxTable *table)
+{
+  MxTablePrivate *priv = table->priv;
   ClutterActorIter iter;
   ClutterActor *actor_child;
+  guint child_index;
+
+  if (priv->cells_valid)
+    return;
+
+  priv->cells = g_new0 (ClutterActor *, priv->n_rows * priv->n_cols);
+  priv->cells_valid = TRUE;
+  priv->cells_irregular = FALSE;
 
   clutter_actor_iter_init (&iter, CLUTTER_ACTOR (table));
-  while (clutter_actor_iter_next (&iter, &actor_child))
+  for (child_index = 0; clutter_actor_iter_next (&iter, &actor_child);
+       child_index++)
     {
       MxTableChild *child;
+      gint row, column, last_row, last_column;
 
-      child = (MxTableChild *) clutter_container_get_child_meta (CLUTTER_CONTAINER (table),
-                                                                 actor_child);
+      child = (MxTableChild *)
+        _mx_container_get_child_meta_at (CLUTTER_CONTAINER (table),
+                                         actor_child, child_index);
 
-      if ((row >= child->row && row <= child->row + (child->row_span - 1)) &&
-          (column >= child->col && column <= child->col + (child->col_span - 1)))
-        return actor_child;
+      last_row = MIN (child->row + child->row_span, priv->n_rows);
+      last_column = MIN (child->col + child->col_span, priv->n_cols);
+
+      if (child->row < 0 || child->col < 0 ||
+          child->row >= last_row || child->col >= last_column)
+        priv->cells_irregular = TRUE;
+
+      for (row = MAX (child->row, 0); row < last_row; row++)
+        for (column = MAX (child->col, 0); column < last_column; column++)
+          {
+            ClutterActor **cell = &priv->cells[row * priv->n_cols + column];
+
+            if (!*cell)
+              *cell = actor_child;
+            else
+              priv->cells_irregular = TRUE;
+          }
     }
+}
 
-  return NULL;
+static ClutterActor*
+mx_table_find_actor_at (MxTable *table,
+                        int      row,
+                        int      column)
+{
+  MxTablePrivate *priv = table->priv;
+
+  if (row < 0 || row >= priv->n_rows || column < 0 || column >= priv->n_cols)
+    return NULL;
+
+  mx_table_ensure_cells (table);
+
+  return priv->cells[row * priv->n_cols + column];
 }
 
 static MxFocusable*
@@ -156,7 +253,6 @@ mx_table_move_focus (MxFocusable      *focusable,
 {
   MxTablePrivate *priv = MX_TABLE (focusable)->priv;
   MxTable *table = MX_TABLE (focusable);
-  GList *l, *childlink, *children;
   MxTableChild *child_meta;
   ClutterActor *child_actor;
   MxFocusable *focused;
@@ -179,49 +275,39 @@ mx_table_move_focus (MxFocusable      *focusable,
   switch (direction)
     {
     case MX_FOCUS_DIRECTION_NEXT:
-      children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
-      childlink = g_list_find (children, from);
-
-      for (l = childlink->next; l; l = g_list_next (l))
+      for (found = clutter_actor_get_next_sibling (child_actor);
+           found;
+           found = clutter_actor_get_next_sibling (found))
         {
-          if (MX_IS_FOCUSABLE (l->data))
+          if (MX_IS_FOCUSABLE (found))
             {
-              focused = mx_focusable_accept_focus (MX_FOCUSABLE (l->data),
+              focused = mx_focusable_accept_focus (MX_FOCUSABLE (found),
                                                    MX_FOCUS_HINT_FIRST);
 
               if (focused)
-                {
-                  g_list_free (children);
-                  return focused;
-                }
+                return focused;
             }
         }
 
       /* no next widgets to focus */
-      g_list_free (children);
       return NULL;
 
     case MX_FOCUS_DIRECTION_PREVIOUS:
-
-      children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
-      childlink = g_list_find (children, from);
-      for (l = g_list_previous (childlink); l; l = g_list_previous (l))
+      for (found = clutter_actor_get_previous_sibling (child_actor);
+           found;
+           found = clutter_actor_get_previous_sibling (found))
         {
-          if (MX_IS_FOCUSABLE (l->data))
+          if (MX_IS_FOCUSABLE (found))
             {
-              focused = mx_focusable_accept_focus (MX_FOCUSABLE (l->data),
+              focused = mx_focusable_accept_focus (MX_FOCUSABLE (found),
                                                    MX_FOCUS_HINT_LAST);
 
               if (focused)
-                {
-                  g_list_free (children);
-                  return focused;
-                }
+                return focused;
             }
         }
 
       /* no widget found in the previous position */
-      g_list_free (children);
       return NULL;
 
     case MX_FOCUS_DIRECTION_UP:
@@ -372,49 +458,46 @@ static MxFocusable*
 mx_table_accept_focus (MxFocusable *focusable, MxFocusHint hint)
 {
   MxTablePrivate *priv = MX_TABLE (focusable)->priv;
+  ClutterActor *self = CLUTTER_ACTOR (focusable);
   MxFocusable *return_focusable;
-  GList* list, *l, *children;
+  ClutterActor *child;
 
   return_focusable = NULL;
 
-  children = clutter_actor_get_children (CLUTTER_ACTOR (focusable));
-
   /* find the first/last focusable widget */
   switch (hint)
     {
     case MX_FOCUS_HINT_LAST:
-      list = g_list_reverse (g_list_copy (children));
+      child = clutter_actor_get_last_child (self);
       break;
 
     case MX_FOCUS_HINT_PRIOR:
       if (priv->last_focus)
         {
-          list = g_list_copy (g_list_find (children, priv->last_focus));
-          if (list)
-            break;
+          child = CLUTTER_ACTOR (priv->last_focus);
+          break;
         }
       /* This intentionally runs into the next switch case */
 
     default:
     case MX_FOCUS_HINT_FIRST:
-      list = g_list_copy (children);
+      child = clutter_actor_get_first_child (self);
       break;
     }
 
-  for (l = list; l; l = g_list_next (l))
+  for (; child; child = (hint == MX_FOCUS_HINT_LAST) ?
+         clutter_actor_get_previous_sibling (child) :
+         clutter_actor_get_next_sibling (child))
     {
-      if (MX_IS_FOCUSABLE (l->data))
+      if (MX_IS_FOCUSABLE (child))
         {
-          return_focusable = mx_focusable_accept_focus (MX_FOCUSABLE (l->data),
+          return_focusable = mx_focusable_accept_focus (MX_FOCUSABLE (child),
                                                         hint);
           if (return_focusable)
             break;
         }
     }
 
-  g_list_free (list);
-  g_list_free (children);
-
   return return_focusable;
 }
 
@@ -469,6 +552,9 @@ mx_table_actor_removed (ClutterContainer *container,
   priv->n_rows = rows;
   priv->n_cols = cols;
 
+  mx_table_invalidate_solutions (MX_TABLE (container));
+  mx_table_invalidate_cells (MX_TABLE (container));
+
   clutter_actor_queue_relayout (CLUTTER_ACTOR (container));
 }
 
@@ -572,9 +658,22 @@ mx_table_finalize (GObject *gobject)
 {
   MxTablePrivate *priv = MX_TABLE (gobject)->priv;
 
+  gint i;
+
   g_array_free (priv->columns, TRUE);
   g_array_free (priv->rows, TRUE);
 
+  for (i = 0; i < MX_TABLE_N_SOLUTIONS; i++)
+    {
+      g_array_free (priv->solutions[i].columns, TRUE);
+      g_array_free (priv->solutions[i].rows, TRUE);
+    }
+
+  g_free (priv->cells);
+  g_array_free (priv->row_offsets, TRUE);
+  g_array_free (priv->col_offsets, TRUE);
+  _mx_box_array_free (priv->boxes);
+
   G_OBJECT_CLASS (mx_table_parent_class)->finalize (gobject);
 }
 
@@ -588,6 +687,8 @@ mx_table_calculate_col_widths (MxTable *table,
   MxPadding padding;
   ClutterActorIter iter;
   ClutterActor *child;
+  guint child_index;
+  MX_TRACE_BEGIN (mx_table_calculate_col_widths);
 
   g_array_set_size (priv->columns, 0);
   g_array_set_size (priv->columns, priv->n_cols);
@@ -606,7 +707,7 @@ mx_table_calculate_col_widths (MxTable *table,
 
   /* STAGE ONE: calculate column widths for non-spanned children */
   clutter_actor_iter_init (&iter, CLUTTER_ACTOR (table));
-  while (clutter_actor_iter_next (&iter, &child))
+  for (child_index = 0; clutter_actor_iter_next (&iter, &child); child_index++)
     {
       MxTableChild *meta;
       DimensionData *col;
@@ -616,7 +717,8 @@ mx_table_calculate_col_widths (MxTable *table,
         continue;
 
       meta = (MxTableChild *)
-        clutter_container_get_child_meta (CLUTTER_CONTAINER (table), child);
+        _mx_container_get_child_meta_at (CLUTTER_CONTAINER (table), child,
+                                         child_index);
 
       if (meta->col_span > 1)
         continue;
@@ -639,7 +741,7 @@ mx_table_calculate_col_widths (MxTable *table,
 
   /* STAGE TWO: take spanning children into account */
   clutter_actor_iter_init (&iter, CLUTTER_ACTOR (table));
-  while (clutter_actor_iter_next (&iter, &child))
+  for (child_index = 0; clutter_actor_iter_next (&iter, &child); child_index++)
     {
       MxTableChild *meta;
       gfloat c_min, c_pref;
@@ -651,7 +753,8 @@ mx_table_calculate_col_widths (MxTable *table,
         continue;
 
       meta = (MxTableChild *)
-        clutter_container_get_child_meta (CLUTTER_CONTAINER (table), child);
+        _mx_container_get_child_meta_at (CLUTTER_CONTAINER (table), child,
+                                         child_index);
 
       if (meta->col_span < 2)
         continue;
@@ -776,6 +879,7 @@ mx_table_calculate_col_widths (MxTable *table,
             {
               columns[i].final_size = columns[i].min_size;
             }
+          MX_TRACE_END (mx_table_calculate_col_widths);
           return;
         }
 
@@ -786,6 +890,7 @@ mx_table_calculate_col_widths (MxTable *table,
             {
               columns[i].final_size = columns[i].pref_size;
             }
+          MX_TRACE_END (mx_table_calculate_col_widths);
           return;
         }
 
@@ -815,6 +920,7 @@ mx_table_calculate_col_widths (MxTable *table,
                 }
             }
 
+          MX_TRACE_END (mx_table_calculate_col_widths);
           return;
         }
 
@@ -859,6 +965,7 @@ mx_table_calculate_col_widths (MxTable *table,
         }
     }
 
+  MX_TRACE_END (mx_table_calculate_col_widths);
 }
 
 static void
@@ -871,6 +978,7 @@ mx_table_calculate_row_heights (MxTable *table,
   MxPadding padding;
   ClutterActorIter iter;
   ClutterActor *child;
+  guint child_index;
 
   mx_widget_get_padding (MX_WIDGET (table), &padding);
 
@@ -890,7 +998,7 @@ mx_table_calculate_row_heights (MxTable *table,
 
   /* STAGE ONE: calculate row heights for non-spanned children */
   clutter_actor_iter_init (&iter, CLUTTER_ACTOR (table));
-  while (clutter_actor_iter_next (&iter, &child))
+  for (child_index = 0; clutter_actor_iter_next (&iter, &child); child_index++)
     {
       MxTableChild *meta;
       DimensionData *row;
@@ -900,7 +1008,8 @@ mx_table_calculate_row_heights (MxTable *table,
         continue;
 
       meta = (MxTableChild *)
-        clutter_container_get_child_meta (CLUTTER_CONTAINER (table), child);
+        _mx_container_get_child_meta_at (CLUTTER_CONTAINER (table), child,
+                                         child_index);
 
       if (meta->row_span > 1)
         continue;
@@ -926,7 +1035,7 @@ mx_table_calculate_row_heights (MxTable *table,
 
   /* STAGE TWO: take spanning children into account */
   clutter_actor_iter_init (&iter, CLUTTER_ACTOR (table));
-  while (clutter_actor_iter_next (&iter, &child))
+  for (child_index = 0; clutter_actor_iter_next (&iter, &child); child_index++)
     {
       MxTableChild *meta;
       gfloat c_min, c_pref;
@@ -938,7 +1047,8 @@ mx_table_calculate_row_heights (MxTable *table,
         continue;
 
       meta = (MxTableChild *)
-        clutter_container_get_child_meta (CLUTTER_CONTAINER (table), child);
+        _mx_container_get_child_meta_at (CLUTTER_CONTAINER (table), child,
+                                         child_index);
 
       if (meta->row_span < 2)
         continue;
@@ -1157,13 +1267,96 @@ mx_table_calculate_row_heights (MxTable *table,
 
 }
 
+static void
+mx_table_invalidate_solutions (MxTable *table)
+{
+  MxTablePrivate *priv = table->priv;
+  gint i;
+
+  for (i = 0; i < MX_TABLE_N_SOLUTIONS; i++)
+    priv->solutions[i].valid = FALSE;
+}
+
+static void
+mx_table_copy_dimensions (GArray *dest,
+                          GArray *src)
+{
+  g_array_set_size (dest, src->len);
+  if (src->len)
+    memcpy (dest->data, src->data, src->len * sizeof (DimensionData));
+}
+
 static void
 mx_table_calculate_dimensions (MxTable *table,
                                gfloat for_width,
                                gfloat for_height)
 {
+  MxTablePrivate *priv = table->priv;
+  MxTableSolution *solution = NULL;
+  gint i;
+
+  for (i = 0; i < MX_TABLE_N_SOLUTIONS; i++)
+    {
+      MxTableSolution *s = &priv->solutions[i];
+
+      if (s->valid && s->for_width == for_width &&
+          s->for_height == for_height)
+        {
+          s->age = ++priv->solution_age;
+
+          mx_table_copy_dimensions (priv->columns, s->columns);
+          mx_table_copy_dimensions (priv->rows, s->rows);
+          priv->visible_cols = s->visible_cols;
+          priv->visible_rows = s->visible_rows;
+
+          return;
+        }
+
+      if (!solution || !s->valid ||
+          (solution->valid && s->age < solution->age))
+        solution = s;
+    }
+
   mx_table_calculate_col_widths (table, for_width);
   mx_table_calculate_row_heights (table, for_height);
+
+  /* replace the solution used the least recently */
+  solution->valid = TRUE;
+  solution->for_width = for_width;
+  solution->for_height = for_height;
+  solution->age = ++priv->solution_age;
+  mx_table_copy_dimensions (solution->columns, priv->columns);
+  mx_table_copy_dimensions (solution->rows, priv->rows);
+  solution->visible_cols = priv->visible_cols;
+  solution->visible_rows = priv->visible_rows;
+}
+
+static void
+mx_table_update_offsets (GArray        *offsets,
+                         DimensionData *dimensions,
+                         gint           n_dimensions,
+                         gint           start,
+                         gint           spacing)
+{
+  gint i;
+
+  g_array_set_size (offsets, n_dimensions);
+
+  for (i = 0; i < n_dimensions; i++)
+    {
+      MxTableOffset *offset = &g_array_index (offsets, MxTableOffset, i);
+
+      offset->start = start;
+      offset->end = start + (gint) dimensions[i].final_size;
+      if (i > 0)
+        offset->end = MAX (offset->end, (offset - 1)->end);
+
+      if (dimensions[i].is_visible)
+        {
+          start += dimensions[i].final_size;
+          start += spacing;
+        }
+    }
 }
 
 static void
@@ -1179,6 +1372,7 @@ mx_table_preferred_allocate (ClutterActor          *self,
   DimensionData *rows, *columns;
   ClutterActorIter iter;
   ClutterActor *child;
+  guint child_index;
 
   table = MX_TABLE (self);
   priv = MX_TABLE (self)->priv;
@@ -1193,8 +1387,16 @@ mx_table_preferred_allocate (ClutterActor          *self,
   rows = &g_array_index (priv->rows, DimensionData, 0);
   columns = &g_array_index (priv->columns, DimensionData, 0);
 
+  /* the rows and columns start after the visible ones before them */
+  mx_table_update_offsets (priv->row_offsets, rows, priv->n_rows,
+                           (int) padding.top, row_spacing);
+  mx_table_update_offsets (priv->col_offsets, columns, priv->n_cols,
+                           (int) padding.left, col_spacing);
+
+  _mx_box_array_set_length (priv->boxes, 0);
+
   clutter_actor_iter_init (&iter, self);
-  while (clutter_actor_iter_next (&iter, &child))
+  for (child_index = 0; clutter_actor_iter_next (&iter, &child); child_index++)
     {
       gint row, col, row_span, col_span;
       gint col_width, row_height;
@@ -1205,7 +1407,9 @@ mx_table_preferred_allocate (ClutterActor          *self,
       gboolean x_fill, y_fill;
       MxAlign x_align, y_align;
 
-      meta = (MxTableChild *) clutter_container_get_child_meta (CLUTTER_CONTAINER (self), child);
+      meta = (MxTableChild *)
+        _mx_container_get_child_meta_at (CLUTTER_CONTAINER (self), child,
+                                         child_index);
 
       if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
@@ -1270,27 +1474,9 @@ mx_table_preferred_allocate (ClutterActor          *self,
             }
         }
 
-      /* calculate child x */
-      child_x = (int) padding.left;
-      for (i = 0; i < col; i++)
-        {
-          if (columns[i].is_visible)
-            {
-              child_x += columns[i].final_size;
-              child_x += col_spacing;
-            }
-        }
-
-      /* calculate child y */
-      child_y = (int) padding.top;
-      for (i = 0; i < row; i++)
-        {
-          if (rows[i].is_visible)
-            {
-              child_y += rows[i].final_size;
-              child_y += row_spacing;
-            }
-        }
+      /* calculate child x and y */
+      child_x = g_array_index (priv->col_offsets, MxTableOffset, col).start;
+      child_y = g_array_index (priv->row_offsets, MxTableOffset, row).start;
 
 
       /* set up childbox */
@@ -1304,6 +1490,7 @@ mx_table_preferred_allocate (ClutterActor          *self,
       mx_allocate_align_fill (child, &childbox, x_align, y_align, x_fill, y_fill);
 
       clutter_actor_allocate (child, &childbox, flags);
+      _mx_box_array_append (priv->boxes, child, &childbox);
     }
 }
 
@@ -1412,23 +1599,224 @@ mx_table_get_preferred_height (ClutterActor *self,
 }
 
 static void
-mx_table_paint (ClutterActor *self)
+mx_table_queue_relayout (ClutterActor *self)
 {
-  MxTablePrivate *priv = MX_TABLE (self)->priv;
+  /* children, their child properties, the spacing and the padding all
+   * queue a relayout when they change */
+  mx_table_invalidate_solutions (MX_TABLE (self));
+
+  CLUTTER_ACTOR_CLASS (mx_table_parent_class)->queue_relayout (self);
+}
+
+/* Maps @box, in the coordinates of @actor (or of the stage when %NULL), to
+ * those of @table, and reduces @area to it */
+static gboolean
+mx_table_clip_area (MxTable         *table,
+                    ClutterActor    *actor,
+                    ClutterActorBox *box,
+                    ClutterActorBox *area)
+{
+  ClutterActorBox mapped = { G_MAXFLOAT, G_MAXFLOAT, -G_MAXFLOAT, -G_MAXFLOAT };
+  gint i;
+
+  for (i = 0; i < 4; i++)
+    {
+      ClutterVertex point = { (i & 1) ? box->x2 : box->x1,
+                              (i & 2) ? box->y2 : box->y1, 0 };
+      ClutterVertex stage_point;
+      gfloat x, y;
+
+      if (actor)
+        clutter_actor_apply_transform_to_point (actor, &point, &stage_point);
+      else
+        stage_point = point;
+
+      if (!clutter_actor_transform_stage_point (CLUTTER_ACTOR (table),
+                                                stage_point.x, stage_point.y,
+                                                &x, &y))
+        return FALSE;
+
+      mapped.x1 = MIN (mapped.x1, x);
+      mapped.y1 = MIN (mapped.y1, y);
+      mapped.x2 = MAX (mapped.x2, x);
+      mapped.y2 = MAX (mapped.y2, y);
+    }
+
+  area->x1 = MAX (area->x1, mapped.x1);
+  area->y1 = MAX (area->y1, mapped.y1);
+  area->x2 = MIN (area->x2, mapped.x2);
+  area->y2 = MIN (area->y2, mapped.y2);
+
+  return TRUE;
+}
+
+/* Finds the part of @table that can be seen on the stage, through the
+ * clips of the table and its parents, such as the one of an #MxScrollView.
+ * Returns %FALSE when that is not known: when painted through a clone or
+ * into a cached tile, or when anything is rotated. */
+static gboolean
+mx_table_get_visible_area (MxTable         *table,
+                           ClutterActorBox *area)
+{
+  ClutterActor *self = CLUTTER_ACTOR (table);
+  ClutterActor *actor, *stage;
+  ClutterActorBox box;
+
+  if (clutter_actor_is_in_clone_paint (self) || _mx_tile_cache_is_rendering ())
+    return FALSE;
+
+  stage = clutter_actor_get_stage (self);
+  if (!stage)
+    return FALSE;
+
+  area->x1 = area->y1 = -G_MAXFLOAT;
+  area->x2 = area->y2 = G_MAXFLOAT;
+
+  for (actor = self; actor && actor != stage;
+       actor = clutter_actor_get_parent (actor))
+    {
+      if (clutter_actor_is_rotated (actor))
+        return FALSE;
+
+      if (clutter_actor_get_clip_to_allocation (actor))
+        {
+          box.x1 = box.y1 = 0;
+          clutter_actor_get_size (actor, &box.x2, &box.y2);
+        }
+      else if (clutter_actor_has_clip (actor))
+        {
+          gfloat width, height;
+
+          clutter_actor_get_clip (actor, &box.x1, &box.y1, &width, &height);
+          box.x2 = box.x1 + width;
+          box.y2 = box.y1 + height;
+        }
+      else
+        continue;
+
+      if (!mx_table_clip_area (table, actor, &box, area))
+        return FALSE;
+    }
+
+  box.x1 = box.y1 = 0;
+  clutter_actor_get_size (stage, &box.x2, &box.y2);
+
+  return mx_table_clip_area (table, NULL, &box, area);
+}
+
+/* Finds the range [@first, @last) of @offsets that reaches into
+ * [@start, @end) */
+static void
+mx_table_get_offset_range (GArray *offsets,
+                           gfloat  start,
+                           gfloat  end,
+                           gint   *first,
+                           gint   *last)
+{
+  gint low = 0, high = offsets->len;
+
+  while (low < high)
+    {
+      gint middle = (low + high) / 2;
+
+      if (g_array_index (offsets, MxTableOffset, middle).end > start)
+        high = middle;
+      else
+        low = middle + 1;
+    }
+
+  *first = low;
+  for (*last = low; *last < (gint) offsets->len; (*last)++)
+    if (g_array_index (offsets, MxTableOffset, *last).start >= end)
+      break;
+}
+
+/* Paints the visible children. When each cell has at most one child, only
+ * the cells that can be seen are looked at; otherwise the allocations of
+ * the children are tested against the area that can be seen. */
+static void
+mx_table_paint_children (MxTable *table)
+{
+  MxTablePrivate *priv = table->priv;
+  gint first_row, last_row, first_col, last_col, row, col;
+  ClutterActorBox area;
   ClutterActorIter iter;
   ClutterActor *child;
+  gboolean has_area;
 
+  if (priv->n_rows > 0 && priv->n_cols > 0)
+    mx_table_ensure_cells (table);
 
-  /* make sure the background gets painted first */
-  CLUTTER_ACTOR_CLASS (mx_table_parent_class)->paint (self);
+  has_area = priv->n_rows > 0 && priv->n_cols > 0 &&
+    mx_table_get_visible_area (table, &area);
 
-  clutter_actor_iter_init (&iter, self);
-  while (clutter_actor_iter_next (&iter, &child))
+  if (has_area && priv->cells_irregular &&
+      _mx_box_array_get_length (priv->boxes))
     {
-      if (CLUTTER_ACTOR_IS_VISIBLE (child))
-        clutter_actor_paint (child);
+      const guint *visible;
+      guint i, n_visible;
+
+      n_visible = _mx_box_array_cull (priv->boxes, 0,
+                                      _mx_box_array_get_length (priv->boxes),
+                                      &area, &visible);
+      for (i = 0; i < n_visible; i++)
+        {
+          child = _mx_box_array_get_actor (priv->boxes, visible[i]);
+
+          if (CLUTTER_ACTOR_IS_VISIBLE (child))
+            clutter_actor_paint (child);
+        }
+
+      return;
     }
 
+  if (priv->n_rows < 1 || priv->n_cols < 1 || priv->cells_irregular ||
+      priv->row_offsets->len != priv->n_rows ||
+      priv->col_offsets->len != priv->n_cols || !has_area)
+    {
+      clutter_actor_iter_init (&iter, CLUTTER_ACTOR (table));
+      while (clutter_actor_iter_next (&iter, &child))
+        {
+          if (CLUTTER_ACTOR_IS_VISIBLE (child))
+            clutter_actor_paint (child);
+        }
+
+      return;
+    }
+
+  mx_table_get_offset_range (priv->row_offsets, area.y1, area.y2,
+                             &first_row, &last_row);
+  mx_table_get_offset_range (priv->col_offsets, area.x1, area.x2,
+                             &first_col, &last_col);
+
+  for (row = first_row; row < last_row; row++)
+    for (col = first_col; col < last_col; col++)
+      {
+        child = priv->cells[row * priv->n_cols + col];
+
+        /* spanning children are painted from their first visible cell */
+        if (!child ||
+            (row > first_row &&
+             priv->cells[(row - 1) * priv->n_cols + col] == child) ||
+            (col > first_col &&
+             priv->cells[row * priv->n_cols + col - 1] == child))
+          continue;
+
+        if (CLUTTER_ACTOR_IS_VISIBLE (child))
+          clutter_actor_paint (child);
+      }
+}
+
+static void
+mx_table_paint (ClutterActor *self)
+{
+  MxTablePrivate *priv = MX_TABLE (self)->priv;
+
+  /* make sure the background gets painted first */
+  CLUTTER_ACTOR_CLASS (mx_table_parent_class)->paint (self);
+
+  mx_table_paint_children (MX_TABLE (self));
+
   if (_mx_debug (MX_DEBUG_LAYOUT))
     {
       int i;
@@ -1469,18 +1857,10 @@ static void
 mx_table_pick (ClutterActor       *self,
                const ClutterColor *color)
 {
-  ClutterActorIter iter;
-  ClutterActor *child;
-
   /* Chain up so we get a bounding box painted (if we are reactive) */
   CLUTTER_ACTOR_CLASS (mx_table_parent_class)->pick (self, color);
 
-  clutter_actor_iter_init (&iter, self);
-  while (clutter_actor_iter_next (&iter, &child))
-    {
-      if (CLUTTER_ACTOR_IS_VISIBLE (child))
-        clutter_actor_paint (child);
-    }
+  mx_table_paint_children (MX_TABLE (self));
 }
 
 static void
@@ -1501,6 +1881,7 @@ mx_table_class_init (MxTableClass *klass)
   actor_class->allocate = mx_table_allocate;
   actor_class->get_preferred_width = mx_table_get_preferred_width;
   actor_class->get_preferred_height = mx_table_get_preferred_height;
+  actor_class->queue_relayout = mx_table_queue_relayout;
 
 
   pspec = g_param_spec_int ("column-spacing",
@@ -1563,6 +1944,8 @@ mx_table_style_changed (MxWidget *widget,
 static void
 mx_table_init (MxTable *table)
 {
+  gint i;
+
   table->priv = MX_TABLE_GET_PRIVATE (table);
 
   table->priv->n_cols = 0;
@@ -1570,6 +1953,17 @@ mx_table_init (MxTable *table)
 
   table->priv->columns = g_array_new (FALSE, TRUE, sizeof (DimensionData));
   table->priv->rows = g_array_new (FALSE, TRUE, sizeof (DimensionData));
+  table->priv->row_offsets = g_array_new (FALSE, FALSE, sizeof (MxTableOffset));
+  table->priv->boxes = _mx_box_array_new ();
+  table->priv->col_offsets = g_array_new (FALSE, FALSE, sizeof (MxTableOffset));
+
+  for (i = 0; i < MX_TABLE_N_SOLUTIONS; i++)
+    {
+      table->priv->solutions[i].columns =
+        g_array_new (FALSE, FALSE, sizeof (DimensionData));
+      table->priv->solutions[i].rows =
+        g_array_new (FALSE, FALSE, sizeof (DimensionData));
+    }
 
   g_signal_connect (table, "style-changed",
                     G_CALLBACK (mx_table_style_changed), NULL);
@@ -1585,6 +1979,9 @@ void _mx_table_update_row_col (MxTable      *table,
   if (meta->row > -1)
     table->priv->n_rows = MAX (table->priv->n_rows, meta->row + meta->row_span);
 
+  mx_table_invalidate_solutions (table);
+  mx_table_invalidate_cells (table);
+
 }
 
 /*** Public Functions ***/
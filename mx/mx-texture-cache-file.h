@@ -0,0 +1,144 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-texture-cache-file.h: Layout of texture cache files
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef __MX_TEXTURE_CACHE_FILE_H__
+#define __MX_TEXTURE_CACHE_FILE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * A texture cache file describes where images can be found in one or more
+ * atlas pages, so that mx_texture_cache_load_cache() can serve them from
+ * there without loading them individually. It is read in place from a
+ * mapping of the file, and is laid out as:
+ *
+ *   MxTextureCacheFileHeader
+ *   MxTextureCacheFilePage  pages[n_pages]
+ *   MxTextureCacheFileEntry entries[n_entries]
+ *   guint32                 buckets[n_buckets]
+ *   gchar                   strings[strings_size]
+ *
+ * All the integers are little-endian. Strings are referenced by their
+ * offset in the string table and are nul-terminated. The entries for the
+ * URIs hashing to the same bucket are chained through their "next" field,
+ * starting from the index in the bucket and ending with
+ * MX_TEXTURE_CACHE_FILE_NONE.
+ */
+
+#define MX_TEXTURE_CACHE_FILE_MAGIC   "MXTCACHE"
+#define MX_TEXTURE_CACHE_FILE_VERSION 1
+#define MX_TEXTURE_CACHE_FILE_NONE    G_MAXUINT32
+
+typedef struct
+{
+  gchar   magic[8];
+  guint32 version;
+
+  /* Adler-32 of everything after the header */
+  guint32 checksum;
+
+  guint32 n_pages;
+  guint32 n_entries;
+  guint32 n_buckets;
+  guint32 strings_size;
+} MxTextureCacheFileHeader;
+
+typedef struct
+{
+  /* image file, absolute or relative to the directory of the cache file */
+  guint32 path;
+  guint32 width, height;
+} MxTextureCacheFilePage;
+
+typedef struct
+{
+  guint32 uri;
+  guint32 hash;
+  guint32 next;
+
+  guint32 page;
+  guint32 x, y;
+  guint32 width, height;
+} MxTextureCacheFileEntry;
+
+/*
+ * A shared page file holds the decoded pixels of an atlas page of a cache
+ * file, so that the processes using the same cache file map them rather
+ * than each decoding the image. It is laid out as:
+ *
+ *   MxTextureCachePageFileHeader
+ *   guint8                       pixels[rowstride * height]
+ *
+ * The pixels are 8 bits per channel RGBA, or RGB without an alpha channel,
+ * as GdkPixbuf decodes them. The integers of the header are little-endian.
+ * A shared page file is named after the path, size and modification time
+ * of the image it was decoded from, so a page that changes gets a new one.
+ */
+
+#define MX_TEXTURE_CACHE_PAGE_FILE_MAGIC   "MXTCPAGE"
+#define MX_TEXTURE_CACHE_PAGE_FILE_VERSION 1
+
+typedef struct
+{
+  gchar   magic[8];
+  guint32 version;
+
+  guint32 width, height;
+  guint32 rowstride;
+  guint32 has_alpha;
+
+  guint32 reserved;
+} MxTextureCachePageFileHeader;
+
+static inline guint32
+mx_texture_cache_file_hash (const gchar *uri)
+{
+  const guchar *p;
+  guint32 hash = 5381;
+
+  for (p = (const guchar *) uri; *p; p++)
+    hash = (hash << 5) + hash + *p;
+
+  return hash;
+}
+
+static inline guint32
+mx_texture_cache_file_checksum (const guchar *data,
+                                gsize         length)
+{
+  guint32 a = 1, b = 0;
+  gsize i;
+
+  for (i = 0; i < length; i++)
+    {
+      a = (a + data[i]) % 65521;
+      b = (b + a) % 65521;
+    }
+
+  return (b << 16) | a;
+}
+
+G_END_DECLS
+
+#endif /* __MX_TEXTURE_CACHE_FILE_H__ */
@@ -25,6 +25,19 @@
  *
  * #MxTextureCache allows an application to re-use an previously loaded
  * textures.
+ *
+ * Images of up to 256x256 pixels are packed together into larger textures,
+ * and returned as sub-textures of those, so that widgets using them can be
+ * drawn in the same batch.
+ *
+ * If a KTX or KTX2 file with the same name as an image is found next to
+ * it, holding the image in a GPU compressed format such as ETC2 or ASTC,
+ * it is used instead whenever the driver supports that format.
+ *
+ * The cache is used from the main thread, with the exception of
+ * mx_texture_cache_is_cached(), mx_texture_cache_is_loading() and
+ * mx_texture_cache_load_in_thread(), which worker threads can use to find
+ * out what is already loaded and to decode images themselves.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -34,7 +47,11 @@
 #include <glib.h>
 #include <glib-object.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #if defined(__ANDROID__) || defined(ANDROID)
 # include <clutter/android/clutter-android-application.h>
@@ -50,6 +67,8 @@ extern unsigned char *stbi_load_from_memory (unsigned char const *buffer,
 #endif
 
 #include "mx-texture-cache.h"
+#include "mx-texture-cache-file.h"
+#include "mx-worker-pool.h"
 #include "mx-marshal.h"
 #include "mx-private.h"
 
@@ -60,10 +79,62 @@ G_DEFINE_TYPE (MxTextureCache, mx_texture_cache, G_TYPE_OBJECT)
 
 typedef struct _MxTextureCachePrivate MxTextureCachePrivate;
 
+/* The URIs of the items of the cache, for lookups from other threads. The
+ * main thread keeps them in step with the cache; they are spread over
+ * several tables so that lookups from different threads rarely wait on
+ * each other. */
+#define INDEX_N_STRIPES 16
+
+typedef struct
+{
+  GMutex      lock;
+  GHashTable *uris;
+} MxTextureCacheStripe;
+
 struct _MxTextureCachePrivate
 {
   GHashTable *cache;
-  GRegex     *is_uri;
+  MxTextureCacheStripe stripes[INDEX_N_STRIPES];
+
+  /* URIs of the absolute paths that have been looked up */
+  GHashTable *path_uris;
+
+  /* the device scale factor, and the variants of the image files found
+   * for it, by path */
+  gint        scale_factor;
+  GHashTable *variants;
+
+  /* items holding texture memory, most recently used first */
+  GQueue      lru;
+  gsize       n_bytes;
+  gsize       max_bytes;
+
+  /* asynchronous loads in progress, by URI, including those started by
+   * mx_texture_cache_load_in_thread(); the table is shared with other
+   * threads under loads_lock, the loads themselves are only touched from
+   * the main thread */
+  GHashTable  *loads;
+  GMutex       loads_lock;
+
+  /* decoded images from mx_texture_cache_preload(), uploaded a few at a
+   * time */
+  GQueue       preloads;
+  guint        preload_source;
+
+  /* pages small images are packed into */
+  GList       *atlases;
+
+  /* cache files loaded with mx_texture_cache_load_cache() */
+  GList       *indexes;
+
+  /* where the decoded pages of cache files are shared with other
+   * processes, if anywhere */
+  gchar       *shared_dir;
+
+  /* the counters of MxTextureCacheStats, and the pending emission of
+   * stats-changed */
+  MxTextureCacheStats stats;
+  guint               stats_changed_id;
 };
 
 typedef struct FinalizedClosure
@@ -77,17 +148,107 @@ enum
   PROP_0,
 };
 
+enum
+{
+  STATS_CHANGED,
+
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0, };
+
 static MxTextureCache* __cache_singleton = NULL;
 
+/* Images up to this size (the same limit as mx-create-image-cache) are
+ * packed into shared pages, so that widgets using them can be drawn in
+ * the same batch */
+#define ATLAS_MAX_IMAGE_SIZE 256
+#define ATLAS_PAGE_SIZE 1024
+/* images are surrounded by a copy of their edges, so that filtering
+ * doesn't pick up their neighbours */
+#define ATLAS_PADDING 1
+
+typedef struct
+{
+  gint y, height;
+  gint x;
+} MxTextureCacheShelf;
+
+typedef struct
+{
+  MxTextureCache *cache;
+  CoglHandle      texture;
+  GArray         *shelves;
+  gint            bottom;
+
+  /* the sub-textures still alive; the page is dropped with the last one */
+  guint           n_textures;
+} MxTextureCacheAtlas;
+
+static CoglUserDataKey atlas_key;
+
+/* Images drawn for a scale factor are looked for next to the original,
+ * as "foo@2x.png", up to this factor */
+#define MAX_VARIANT_SCALE 4
+
+typedef struct
+{
+  gchar *filename;  /* NULL when the original is used */
+  gint   scale;     /* the scale factor the file was drawn for */
+} MxTextureCacheVariant;
+
+/* the scale factor of textures loaded from a variant */
+static CoglUserDataKey scale_key;
+
+/* A mapped cache file. Entries are only looked up, and turned into cache
+ * items, when their URI is first requested. */
+typedef struct
+{
+  GMappedFile                   *file;
+  const MxTextureCacheFileEntry *entries;
+  const guint32                 *buckets;
+  const gchar                   *strings;
+  guint32                        n_entries;
+  guint32                        n_buckets;
+
+  guint32                        n_pages;
+  gchar                        **page_uris;
+} MxTextureCacheIndex;
+
 /*
+ * Layout of the entries of a cache file, as read by
+ * mx_texture_cache_load_cache().
+ *
  * Convention: posX with a value of -1 indicates whole texture
  */
-typedef struct MxTextureCacheItem {
+typedef struct MxTextureCacheFileItem {
   char          filename[256];
   int           width, height;
   int           posX, posY;
   CoglHandle    ptr;
   GHashTable   *meta;
+} MxTextureCacheFileItem;
+
+typedef struct MxTextureCacheItem {
+  MxTextureCache  *cache;
+  const gchar     *uri;          /* owned by the hash table */
+  CoglHandle       ptr;
+  GHashTable      *meta;
+
+  /* size of the full image, 0 until known */
+  gint             width, height;
+
+  /* bytes of texture memory accounted to this item */
+  gsize            bytes;
+  GList            lru_link;
+  CoglUserDataKey  destroy_key;
+
+  /* the cache dropped its reference on ptr, which is kept alive (and
+   * shared) by its other users until they release it */
+  guint            weak : 1;
+  /* ptr is a region of a texture that is accounted separately */
+  guint            sub_texture : 1;
+  guint            in_lru : 1;
 } MxTextureCacheItem;
 
 typedef struct
@@ -97,17 +258,190 @@ typedef struct
   GDestroyNotify  destroy_func;
 } MxTextureCacheMetaEntry;
 
+/* Scaled copies of an image are kept as metadata of its item, at sizes
+ * halving from the full image, with these identifiers */
+#define MAX_SCALED_LEVEL 8
+
+static gchar scaled_idents[MAX_SCALED_LEVEL + 1];
+
+typedef struct
+{
+  gint  width, height;
+  gint  source_width, source_height;
+  guint level;
+} MxTextureCacheScaleRequest;
+
+/* The first level of a pre-compressed image, read from a KTX file */
+typedef struct
+{
+  gchar        *contents;
+  guint32       gl_format;
+  guint32       width, height;
+  const guint8 *data;
+  guint32       size;
+} MxTextureCacheCompressed;
+
+/* An image being decoded for mx_texture_cache_get_cogl_texture_async(),
+ * shared by all the requests for the same URI */
+typedef struct
+{
+  MxTextureCache           *cache;
+  gchar                    *uri;
+  gchar                    *filename;     /* NULL for resources */
+  GList                    *results;
+
+  MxTextureCacheCompressed *compressed;
+  GdkPixbuf                *pixbuf;
+  GError                   *error;
+
+  /* time the worker spent decoding pixbuf, in microseconds */
+  gint64                    decode_time;
+
+  /* the scale factor @filename was drawn for, and the one it is loaded
+   * at */
+  gint                      source_scale;
+  gint                      scale;
+
+  /* the decoding job in the worker pool */
+  guint                     job_id;
+
+  /* for preloads, until a request for the image comes */
+  GCancellable             *cancellable;
+  /* the load was cancelled before it was decoded */
+  guint                     skipped : 1;
+  /* the load is waiting in the preloads queue */
+  guint                     queued : 1;
+} MxTextureCacheLoad;
+
+/* time spent uploading preloaded images per main loop iteration, in
+ * milliseconds */
+#define PRELOAD_TIME_SLICE 5
+
+static gboolean
+mx_texture_cache_emit_stats_changed (gpointer data)
+{
+  MxTextureCache *self = data;
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+
+  priv->stats_changed_id = 0;
+  g_signal_emit (self, signals[STATS_CHANGED], 0);
+
+  return FALSE;
+}
+
+/* stats-changed is emitted at most once per main loop iteration, as the
+ * counters change on every lookup */
+static void
+mx_texture_cache_queue_stats_changed (MxTextureCache *self)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+
+  if (!priv->stats_changed_id)
+    priv->stats_changed_id =
+      clutter_threads_add_idle_full (G_PRIORITY_LOW,
+                                     mx_texture_cache_emit_stats_changed,
+                                     self, NULL);
+}
+
+static void
+mx_texture_cache_add_decode_time (MxTextureCache *self,
+                                  gint64          decode_time)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+
+  priv->stats.n_decodes++;
+  priv->stats.decode_time += decode_time;
+  mx_texture_cache_queue_stats_changed (self);
+}
+
+static MxTextureCacheStripe *
+mx_texture_cache_get_stripe (MxTextureCachePrivate *priv,
+                             const gchar           *uri)
+{
+  return &priv->stripes[g_str_hash (uri) % INDEX_N_STRIPES];
+}
+
+static void
+mx_texture_cache_index_add (MxTextureCachePrivate *priv,
+                            const gchar           *uri)
+{
+  MxTextureCacheStripe *stripe = mx_texture_cache_get_stripe (priv, uri);
+
+  g_mutex_lock (&stripe->lock);
+  g_hash_table_add (stripe->uris, g_strdup (uri));
+  g_mutex_unlock (&stripe->lock);
+}
+
+static void
+mx_texture_cache_index_remove (MxTextureCachePrivate *priv,
+                               const gchar           *uri)
+{
+  MxTextureCacheStripe *stripe = mx_texture_cache_get_stripe (priv, uri);
+
+  g_mutex_lock (&stripe->lock);
+  g_hash_table_remove (stripe->uris, uri);
+  g_mutex_unlock (&stripe->lock);
+}
+
+static gboolean
+mx_texture_cache_index_contains (MxTextureCachePrivate *priv,
+                                 const gchar           *uri)
+{
+  MxTextureCacheStripe *stripe = mx_texture_cache_get_stripe (priv, uri);
+  gboolean contains;
+
+  g_mutex_lock (&stripe->lock);
+  contains = g_hash_table_contains (stripe->uris, uri);
+  g_mutex_unlock (&stripe->lock);
+
+  return contains;
+}
+
+/* removes @item from the cache, which frees it */
+static void
+mx_texture_cache_remove_item (MxTextureCachePrivate *priv,
+                              MxTextureCacheItem    *item)
+{
+  mx_texture_cache_index_remove (priv, item->uri);
+  g_hash_table_remove (priv->cache, item->uri);
+}
+
 static MxTextureCacheItem *
 mx_texture_cache_item_new (void)
 {
-  return g_slice_new0 (MxTextureCacheItem);
+  MxTextureCacheItem *item = g_slice_new0 (MxTextureCacheItem);
+
+  item->lru_link.data = item;
+
+  return item;
 }
 
 static void
 mx_texture_cache_item_free (MxTextureCacheItem *item)
 {
+  if (item->cache)
+    {
+      MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (item->cache);
+
+      if (item->in_lru)
+        g_queue_unlink (&priv->lru, &item->lru_link);
+      priv->n_bytes -= item->bytes;
+
+      mx_texture_cache_queue_stats_changed (item->cache);
+    }
+
   if (item->ptr)
-    cogl_handle_unref (item->ptr);
+    {
+      gboolean weak = item->weak;
+
+      /* detach from the texture first, so the destroy callback doesn't
+       * fire on a freed item */
+      item->weak = FALSE;
+      cogl_object_set_user_data (item->ptr, &item->destroy_key, NULL, NULL);
+
+      if (!weak)
+        cogl_handle_unref (item->ptr);
+    }
 
   if (item->meta)
     g_hash_table_unref (item->meta);
@@ -115,6 +449,213 @@ mx_texture_cache_item_free (MxTextureCacheItem *item)
   g_slice_free (MxTextureCacheItem, item);
 }
 
+static void
+mx_texture_cache_texture_destroyed (void *data)
+{
+  MxTextureCacheItem *item = data;
+  MxTextureCachePrivate *priv;
+
+  /* only weak items can outlive their texture */
+  if (!item->weak)
+    return;
+
+  item->weak = FALSE;
+  item->ptr = NULL;
+
+  if (!item->meta)
+    {
+      priv = TEXTURE_CACHE_PRIVATE (item->cache);
+      mx_texture_cache_remove_item (priv, item);
+    }
+}
+
+static void
+mx_texture_cache_item_set_texture (MxTextureCacheItem *item,
+                                   CoglHandle          texture)
+{
+  item->ptr = texture;
+  cogl_object_set_user_data (texture, &item->destroy_key, item,
+                             mx_texture_cache_texture_destroyed);
+}
+
+static gsize
+mx_texture_cache_get_texture_bytes (CoglHandle texture)
+{
+  gsize bpp;
+
+  switch (cogl_texture_get_format (texture) & ~COGL_PREMULT_BIT)
+    {
+    case COGL_PIXEL_FORMAT_A_8:
+    case COGL_PIXEL_FORMAT_G_8:
+      bpp = 1;
+      break;
+
+    case COGL_PIXEL_FORMAT_RGB_565:
+    case COGL_PIXEL_FORMAT_RGBA_4444:
+    case COGL_PIXEL_FORMAT_RGBA_5551:
+      bpp = 2;
+      break;
+
+    case COGL_PIXEL_FORMAT_RGB_888:
+    case COGL_PIXEL_FORMAT_BGR_888:
+      bpp = 3;
+      break;
+
+    default:
+      bpp = 4;
+      break;
+    }
+
+  return (gsize) cogl_texture_get_width (texture) *
+    cogl_texture_get_height (texture) * bpp;
+}
+
+/* recomputes the memory held by an item and moves it to the head of the
+ * LRU list, if it still holds any */
+static void
+mx_texture_cache_item_update (MxTextureCachePrivate *priv,
+                              MxTextureCacheItem    *item)
+{
+  gsize bytes = 0;
+
+  if (item->ptr && !item->weak && !item->sub_texture)
+    bytes += mx_texture_cache_get_texture_bytes (item->ptr);
+
+  if (item->meta)
+    {
+      GHashTableIter iter;
+      MxTextureCacheMetaEntry *entry;
+
+      g_hash_table_iter_init (&iter, item->meta);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+        if (entry->texture)
+          bytes += mx_texture_cache_get_texture_bytes (entry->texture);
+    }
+
+  priv->n_bytes = priv->n_bytes - item->bytes + bytes;
+  item->bytes = bytes;
+
+  if (item->in_lru)
+    g_queue_unlink (&priv->lru, &item->lru_link);
+
+  item->in_lru = (item->ptr && !item->weak) || item->meta;
+  if (item->in_lru)
+    g_queue_push_head_link (&priv->lru, &item->lru_link);
+
+  if (item->cache)
+    mx_texture_cache_queue_stats_changed (item->cache);
+}
+
+static void
+mx_texture_cache_evict_item (MxTextureCachePrivate *priv,
+                             MxTextureCacheItem    *item)
+{
+  CoglHandle texture;
+
+  g_queue_unlink (&priv->lru, &item->lru_link);
+  item->in_lru = FALSE;
+
+  priv->n_bytes -= item->bytes;
+  item->bytes = 0;
+
+  mx_texture_cache_queue_stats_changed (item->cache);
+
+  if (item->meta)
+    {
+      g_hash_table_unref (item->meta);
+      item->meta = NULL;
+    }
+
+  if (!item->ptr || item->weak)
+    {
+      mx_texture_cache_remove_item (priv, item);
+      return;
+    }
+
+  /* Drop the cache's reference. If there are no other users, the texture
+   * is freed right away and the destroy callback removes the item;
+   * otherwise the item stays around so that further lookups keep sharing
+   * the texture instead of loading a second copy.
+   */
+  texture = item->ptr;
+  item->weak = TRUE;
+  cogl_handle_unref (texture);
+}
+
+/* evicts the least recently used items until the cache holds no more
+ * than @max_bytes, never evicting @keep */
+static void
+mx_texture_cache_trim_to (MxTextureCache     *self,
+                          MxTextureCacheItem *keep,
+                          gsize               max_bytes)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  GList *link;
+
+  link = priv->lru.tail;
+  while (link && priv->n_bytes > max_bytes)
+    {
+      MxTextureCacheItem *item = link->data;
+
+      if (item == keep || !item->bytes)
+        {
+          link = link->prev;
+          continue;
+        }
+
+      /* releasing textures can remove other items, so start over from
+       * the tail rather than keeping a pointer to the neighbour */
+      mx_texture_cache_evict_item (priv, item);
+      link = priv->lru.tail;
+    }
+}
+
+/* evicts the least recently used items until the cache is within its
+ * budget, never evicting @keep */
+static void
+mx_texture_cache_trim (MxTextureCache     *self,
+                       MxTextureCacheItem *keep)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+
+  if (priv->max_bytes)
+    mx_texture_cache_trim_to (self, keep, priv->max_bytes);
+}
+
+/* marks an item as used, taking back the reference on its texture if it
+ * had been evicted while still in use elsewhere */
+static void
+mx_texture_cache_use_item (MxTextureCache     *self,
+                           MxTextureCacheItem *item)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+
+  if (item->weak)
+    {
+      cogl_handle_ref (item->ptr);
+      item->weak = FALSE;
+    }
+
+  mx_texture_cache_item_update (priv, item);
+  mx_texture_cache_trim (self, item);
+}
+
+static void
+mx_texture_cache_compressed_free (MxTextureCacheCompressed *compressed)
+{
+  g_free (compressed->contents);
+  g_slice_free (MxTextureCacheCompressed, compressed);
+}
+
+static void
+mx_texture_cache_index_free (MxTextureCacheIndex *index)
+{
+  g_mapped_file_unref (index->file);
+  g_strfreev (index->page_uris);
+
+  g_slice_free (MxTextureCacheIndex, index);
+}
+
 static void
 mx_texture_cache_set_property (GObject      *object,
                                guint         prop_id,
@@ -150,16 +691,197 @@ mx_texture_cache_dispose (GObject *object)
     G_OBJECT_CLASS (mx_texture_cache_parent_class)->dispose (object);
 }
 
+static void
+mx_texture_cache_variant_free (gpointer data)
+{
+  MxTextureCacheVariant *variant = data;
+
+  g_free (variant->filename);
+  g_slice_free (MxTextureCacheVariant, variant);
+}
+
+/* Finds the file to load for the image at @filename: its variant for the
+ * scale factor of the cache, or for a larger one, or NULL for the image
+ * itself. Lookups are remembered, so that the files are only looked for
+ * once. */
+static const MxTextureCacheVariant *
+mx_texture_cache_get_variant (MxTextureCache *self,
+                              const gchar    *filename)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  MxTextureCacheVariant *variant;
+  const gchar *basename, *dot;
+  gint scale;
+
+  if (priv->scale_factor == 1)
+    return NULL;
+
+  variant = g_hash_table_lookup (priv->variants, filename);
+  if (variant)
+    return variant->filename ? variant : NULL;
+
+  variant = g_slice_new0 (MxTextureCacheVariant);
+  variant->scale = 1;
+
+  basename = strrchr (filename, G_DIR_SEPARATOR);
+  dot = strrchr (basename ? basename : filename, '.');
+  if (!dot)
+    dot = filename + strlen (filename);
+
+  for (scale = priv->scale_factor; scale <= MAX_VARIANT_SCALE; scale++)
+    {
+      gchar *path = g_strdup_printf ("%.*s@%dx%s", (gint) (dot - filename),
+                                     filename, scale, dot);
+
+      if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
+        {
+          variant->filename = path;
+          variant->scale = scale;
+          break;
+        }
+
+      g_free (path);
+    }
+
+  g_hash_table_insert (priv->variants, g_strdup (filename), variant);
+
+  return variant->filename ? variant : NULL;
+}
+
+/* Decodes @filename, drawn for @source_scale, at @scale. This may run on
+ * a worker thread. */
+static GdkPixbuf *
+mx_texture_cache_decode_file (const gchar  *filename,
+                              gint          source_scale,
+                              gint          scale,
+                              GError      **error)
+{
+  GdkPixbuf *pixbuf, *scaled;
+  GError *err = NULL;
+  gint width, height;
+
+  pixbuf = _mx_image_decoder_decode_file (filename, -1, -1, NULL, &err);
+  if (err)
+    {
+      g_propagate_error (error, err);
+      return NULL;
+    }
+
+  if (pixbuf)
+    {
+      if (source_scale <= scale)
+        return pixbuf;
+
+      width = gdk_pixbuf_get_width (pixbuf);
+      height = gdk_pixbuf_get_height (pixbuf);
+      scaled = gdk_pixbuf_scale_simple (pixbuf,
+                                        MAX (width * scale / source_scale, 1),
+                                        MAX (height * scale / source_scale, 1),
+                                        GDK_INTERP_BILINEAR);
+      g_object_unref (pixbuf);
+
+      return scaled;
+    }
+
+  if (source_scale > scale &&
+      gdk_pixbuf_get_file_info (filename, &width, &height))
+    return gdk_pixbuf_new_from_file_at_size (filename,
+                                             MAX (width * scale /
+                                                  source_scale, 1),
+                                             MAX (height * scale /
+                                                  source_scale, 1),
+                                             error);
+
+  return gdk_pixbuf_new_from_file (filename, error);
+}
+
+/* Decodes the resource at @path. This may run on a worker thread. */
+static GdkPixbuf *
+mx_texture_cache_decode_resource (const gchar  *path,
+                                  GError      **error)
+{
+  GdkPixbuf *pixbuf;
+  GInputStream *stream;
+  GError *err = NULL;
+  GBytes *bytes;
+
+  bytes = g_resources_lookup_data (path, G_RESOURCE_LOOKUP_FLAGS_NONE, error);
+  if (!bytes)
+    return NULL;
+
+  pixbuf = _mx_image_decoder_decode (g_bytes_get_data (bytes, NULL),
+                                     g_bytes_get_size (bytes), -1, -1, NULL,
+                                     &err);
+  if (!pixbuf && !err)
+    {
+      stream = g_memory_input_stream_new_from_bytes (bytes);
+      pixbuf = gdk_pixbuf_new_from_stream (stream, NULL, &err);
+      g_object_unref (stream);
+    }
+
+  g_bytes_unref (bytes);
+
+  if (err)
+    g_propagate_error (error, err);
+
+  return pixbuf;
+}
+
+/* remembers the scale factor a texture loaded from a variant is at */
+static void
+mx_texture_cache_set_texture_scale (CoglHandle texture,
+                                    gint       scale)
+{
+  if (texture && scale > 1)
+    cogl_object_set_user_data (texture, &scale_key, GINT_TO_POINTER (scale),
+                               NULL);
+}
+
 static void
 mx_texture_cache_finalize (GObject *object)
 {
   MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE(object);
+  gint i;
 
   if (priv->cache)
     g_hash_table_unref (priv->cache);
 
-  if (priv->is_uri)
-    g_regex_unref (priv->is_uri);
+  for (i = 0; i < INDEX_N_STRIPES; i++)
+    {
+      g_hash_table_unref (priv->stripes[i].uris);
+      g_mutex_clear (&priv->stripes[i].lock);
+    }
+
+  g_queue_clear (&priv->lru);
+
+  /* pending loads hold a reference on the cache, so there are none left */
+  if (priv->loads)
+    g_hash_table_unref (priv->loads);
+  g_mutex_clear (&priv->loads_lock);
+
+  g_list_free_full (priv->indexes,
+                    (GDestroyNotify) mx_texture_cache_index_free);
+
+  /* pages still in use are freed with their last sub-texture */
+  while (priv->atlases)
+    {
+      MxTextureCacheAtlas *atlas = priv->atlases->data;
+
+      atlas->cache = NULL;
+      priv->atlases = g_list_delete_link (priv->atlases, priv->atlases);
+    }
+
+  if (priv->path_uris)
+    g_hash_table_unref (priv->path_uris);
+
+  if (priv->variants)
+    g_hash_table_unref (priv->variants);
+
+  g_free (priv->shared_dir);
+
+  /* freeing the items above may have queued an emission */
+  if (priv->stats_changed_id)
+    g_source_remove (priv->stats_changed_id);
 
   G_OBJECT_CLASS (mx_texture_cache_parent_class)->finalize (object);
 }
@@ -176,22 +898,66 @@ mx_texture_cache_class_init (MxTextureCacheClass *klass)
   object_class->dispose = mx_texture_cache_dispose;
   object_class->finalize = mx_texture_cache_finalize;
 
+  /**
+   * MxTextureCache::stats-changed:
+   * @cache: the object that received the signal
+   *
+   * Emitted when the values returned by mx_texture_cache_get_stats() have
+   * changed. Changes are batched, so the signal is emitted at most once
+   * per main loop iteration.
+   *
+   * Since: 2.0
+   */
+  signals[STATS_CHANGED] =
+    g_signal_new ("stats-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (MxTextureCacheClass, stats_changed),
+                  NULL, NULL,
+                  _mx_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
 }
 
 static void
 mx_texture_cache_init (MxTextureCache *self)
 {
-  GError *error = NULL;
   MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE(self);
+  gint i;
 
   priv->cache =
     g_hash_table_new_full (g_str_hash, g_str_equal,
                            g_free, (GDestroyNotify)mx_texture_cache_item_free);
-
-  priv->is_uri = g_regex_new ("^([a-zA-Z0-9+.-]+)://.*",
-                              G_REGEX_OPTIMIZE, 0, &error);
-  if (!priv->is_uri)
-    g_error (G_STRLOC ": Unable to compile regex: %s", error->message);
+  for (i = 0; i < INDEX_N_STRIPES; i++)
+    {
+      g_mutex_init (&priv->stripes[i].lock);
+      priv->stripes[i].uris = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                     g_free, NULL);
+    }
+  g_queue_init (&priv->lru);
+  g_queue_init (&priv->preloads);
+  priv->loads = g_hash_table_new (g_str_hash, g_str_equal);
+  g_mutex_init (&priv->loads_lock);
+  priv->path_uris = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, g_free);
+  priv->scale_factor = 1;
+  priv->variants = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                          mx_texture_cache_variant_free);
+
+  /* so that a device can have all of its applications share pages */
+  priv->shared_dir = g_strdup (g_getenv ("MX_TEXTURE_CACHE_SHARED_DIR"));
+}
+
+/* the default cache follows the scale factor of the stages, where Clutter
+ * has one */
+static void
+mx_texture_cache_scaling_factor_notify_cb (ClutterSettings *settings,
+                                           GParamSpec      *pspec,
+                                           MxTextureCache  *cache)
+{
+  gint scale = 1;
+
+  g_object_get (settings, "window-scaling-factor", &scale, NULL);
+  mx_texture_cache_set_scale_factor (cache, MAX (scale, 1));
 }
 
 /**
@@ -206,11 +972,54 @@ MxTextureCache*
 mx_texture_cache_get_default (void)
 {
   if (G_UNLIKELY (__cache_singleton == NULL))
-    __cache_singleton = g_object_new (MX_TYPE_TEXTURE_CACHE, NULL);
+    {
+      ClutterSettings *settings = clutter_settings_get_default ();
+
+      __cache_singleton = g_object_new (MX_TYPE_TEXTURE_CACHE, NULL);
+      _mx_memory_monitor_init ();
+
+      if (g_object_class_find_property (G_OBJECT_GET_CLASS (settings),
+                                        "window-scaling-factor"))
+        {
+          mx_texture_cache_scaling_factor_notify_cb (settings, NULL,
+                                                     __cache_singleton);
+          g_signal_connect (settings, "notify::window-scaling-factor",
+                            G_CALLBACK (mx_texture_cache_scaling_factor_notify_cb),
+                            __cache_singleton);
+        }
+    }
 
   return __cache_singleton;
 }
 
+gsize
+_mx_texture_cache_get_memory_usage (void)
+{
+  if (!__cache_singleton)
+    return 0;
+
+  return TEXTURE_CACHE_PRIVATE (__cache_singleton)->n_bytes;
+}
+
+/* Evicts the least recently used half of the default cache, or all of it
+ * when memory is critically low. Textures in use elsewhere stay alive
+ * until their users release them. */
+void
+_mx_texture_cache_trim_memory (MxMemoryTrimLevel level)
+{
+  MxTextureCachePrivate *priv;
+
+  if (!__cache_singleton)
+    return;
+
+  priv = TEXTURE_CACHE_PRIVATE (__cache_singleton);
+
+  if (level >= MX_MEMORY_TRIM_LEVEL_CRITICAL)
+    mx_texture_cache_trim_to (__cache_singleton, NULL, 0);
+  else
+    mx_texture_cache_trim_to (__cache_singleton, NULL, priv->n_bytes / 2);
+}
+
 #if 0
 static void
 on_texure_finalized (gpointer data,
@@ -250,7 +1059,12 @@ add_texture_to_cache (MxTextureCache     *self,
   /*  FinalizedClosure        *closure; */
   MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE(self);
 
-  g_hash_table_insert (priv->cache, g_strdup (uri), item);
+  gchar *key = g_strdup (uri);
+
+  item->cache = self;
+  item->uri = key;
+  g_hash_table_replace (priv->cache, key, item);
+  mx_texture_cache_index_add (priv, key);
 
 #if 0
   /* Make sure we can remove from hash */
@@ -262,6 +1076,284 @@ add_texture_to_cache (MxTextureCache     *self,
 #endif
 }
 
+/**
+ * mx_texture_cache_set_max_bytes:
+ * @self: A #MxTextureCache
+ * @max_bytes: the maximum amount of texture memory to keep, in bytes, or 0
+ *   for no limit
+ *
+ * Sets the amount of texture memory the cache may hold on to. When the
+ * cache grows over this budget, the least recently used textures are
+ * evicted. Textures that are still being used elsewhere are not freed by
+ * this, they remain shared through the cache until they are released.
+ *
+ * The memory used by a texture is estimated from its size and pixel
+ * format.
+ *
+ * Since: 2.0
+ */
+void
+mx_texture_cache_set_max_bytes (MxTextureCache *self,
+                                gsize           max_bytes)
+{
+  MxTextureCachePrivate *priv;
+
+  g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
+
+  priv = TEXTURE_CACHE_PRIVATE (self);
+
+  priv->max_bytes = max_bytes;
+  mx_texture_cache_trim (self, NULL);
+}
+
+/**
+ * mx_texture_cache_get_max_bytes:
+ * @self: A #MxTextureCache
+ *
+ * Retrieves the budget set with mx_texture_cache_set_max_bytes().
+ *
+ * Returns: the maximum amount of texture memory to keep, in bytes, or 0
+ *   if there is no limit
+ *
+ * Since: 2.0
+ */
+gsize
+mx_texture_cache_get_max_bytes (MxTextureCache *self)
+{
+  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), 0);
+
+  return TEXTURE_CACHE_PRIVATE (self)->max_bytes;
+}
+
+/**
+ * mx_texture_cache_get_used_bytes:
+ * @self: A #MxTextureCache
+ *
+ * Retrieves an estimate of the texture memory currently held by the
+ * cache. Evicted textures that are still in use elsewhere are not
+ * included.
+ *
+ * Returns: the amount of texture memory held by the cache, in bytes
+ *
+ * Since: 2.0
+ */
+gsize
+mx_texture_cache_get_used_bytes (MxTextureCache *self)
+{
+  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), 0);
+
+  return TEXTURE_CACHE_PRIVATE (self)->n_bytes;
+}
+
+/**
+ * mx_texture_cache_set_scale_factor:
+ * @self: A #MxTextureCache
+ * @scale_factor: the scale factor of the display, 1 or more
+ *
+ * Sets the scale factor of the display the textures are drawn on. When it
+ * is more than 1, images given by path are loaded from the variant drawn
+ * for that factor when there is one next to them, as "foo@2x.png" for
+ * "foo.png" and a factor of 2. Failing that, a variant drawn for a larger
+ * factor is scaled down to the display's once, as it is loaded.
+ *
+ * The textures of variants are larger than the images they stand for, by
+ * the scale factor. Mx draws border and background images at the size of
+ * the original image; other users of the textures need to take the
+ * difference into account.
+ *
+ * The default cache follows the scale factor of the stages. Textures that
+ * were already loaded are not reloaded when it changes.
+ *
+ * Since: 2.0
+ */
+void
+mx_texture_cache_set_scale_factor (MxTextureCache *self,
+                                   gint            scale_factor)
+{
+  MxTextureCachePrivate *priv;
+
+  g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
+  g_return_if_fail (scale_factor >= 1);
+
+  priv = TEXTURE_CACHE_PRIVATE (self);
+
+  if (priv->scale_factor == scale_factor)
+    return;
+
+  priv->scale_factor = scale_factor;
+  g_hash_table_remove_all (priv->variants);
+}
+
+/**
+ * mx_texture_cache_get_scale_factor:
+ * @self: A #MxTextureCache
+ *
+ * Retrieves the scale factor set with mx_texture_cache_set_scale_factor().
+ *
+ * Returns: the scale factor images are loaded for
+ *
+ * Since: 2.0
+ */
+gint
+mx_texture_cache_get_scale_factor (MxTextureCache *self)
+{
+  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), 1);
+
+  return TEXTURE_CACHE_PRIVATE (self)->scale_factor;
+}
+
+/* Retrieves the scale factor @texture was loaded at, 1 unless it was
+ * loaded from a variant of its image */
+gint
+_mx_texture_cache_get_texture_scale (CoglHandle texture)
+{
+  gpointer scale;
+
+  if (!texture)
+    return 1;
+
+  scale = cogl_object_get_user_data (texture, &scale_key);
+
+  return scale ? GPOINTER_TO_INT (scale) : 1;
+}
+
+/**
+ * mx_texture_cache_stats_copy:
+ * @stats: a #MxTextureCacheStats
+ *
+ * Makes a copy of @stats.
+ *
+ * Returns: (transfer full): a newly allocated #MxTextureCacheStats, to be
+ *   freed with mx_texture_cache_stats_free()
+ *
+ * Since: 2.0
+ */
+MxTextureCacheStats *
+mx_texture_cache_stats_copy (const MxTextureCacheStats *stats)
+{
+  g_return_val_if_fail (stats != NULL, NULL);
+
+  return g_slice_dup (MxTextureCacheStats, stats);
+}
+
+/**
+ * mx_texture_cache_stats_free:
+ * @stats: a #MxTextureCacheStats
+ *
+ * Frees a #MxTextureCacheStats allocated with
+ * mx_texture_cache_stats_copy().
+ *
+ * Since: 2.0
+ */
+void
+mx_texture_cache_stats_free (MxTextureCacheStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  g_slice_free (MxTextureCacheStats, stats);
+}
+
+GType
+mx_texture_cache_stats_get_type (void)
+{
+  static GType our_type = 0;
+
+  if (G_UNLIKELY (our_type == 0))
+    our_type =
+      g_boxed_type_register_static (g_intern_static_string ("MxTextureCacheStats"),
+                                    (GBoxedCopyFunc) mx_texture_cache_stats_copy,
+                                    (GBoxedFreeFunc) mx_texture_cache_stats_free);
+
+  return our_type;
+}
+
+/**
+ * mx_texture_cache_get_stats:
+ * @self: A #MxTextureCache
+ * @stats: (out caller-allocates): return location for the statistics
+ *
+ * Takes a snapshot of the usage of the cache, for instance to tune the
+ * budget given to mx_texture_cache_set_max_bytes(). The
+ * #MxTextureCache::stats-changed signal is emitted when it changes.
+ *
+ * Since: 2.0
+ */
+void
+mx_texture_cache_get_stats (MxTextureCache      *self,
+                            MxTextureCacheStats *stats)
+{
+  MxTextureCachePrivate *priv;
+
+  g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
+  g_return_if_fail (stats != NULL);
+
+  priv = TEXTURE_CACHE_PRIVATE (self);
+
+  *stats = priv->stats;
+  stats->n_entries = g_hash_table_size (priv->cache);
+  stats->used_bytes = priv->n_bytes;
+  stats->max_bytes = priv->max_bytes;
+}
+
+/**
+ * mx_texture_cache_foreach:
+ * @self: A #MxTextureCache
+ * @func: (scope call): the function to call for each image
+ * @user_data: data to pass to @func
+ *
+ * Calls @func for each image in the cache, with the amount of texture
+ * memory it uses. This includes the memory of images shared with other
+ * users and of their metadata textures, and so can be more than what is
+ * accounted to the cache. Images in an atlas page report the size of
+ * their region of the page.
+ *
+ * @func must not modify the cache.
+ *
+ * Since: 2.0
+ */
+void
+mx_texture_cache_foreach (MxTextureCache            *self,
+                          MxTextureCacheForeachFunc  func,
+                          gpointer                   user_data)
+{
+  MxTextureCachePrivate *priv;
+  MxTextureCacheItem *item;
+  GHashTableIter iter;
+  const gchar *uri;
+
+  g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
+  g_return_if_fail (func != NULL);
+
+  priv = TEXTURE_CACHE_PRIVATE (self);
+
+  g_hash_table_iter_init (&iter, priv->cache);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &uri, (gpointer *) &item))
+    {
+      gboolean in_atlas = FALSE;
+      gsize bytes = 0;
+
+      if (item->ptr)
+        {
+          bytes = mx_texture_cache_get_texture_bytes (item->ptr);
+          in_atlas = item->sub_texture ||
+            cogl_object_get_user_data (item->ptr, &atlas_key) != NULL;
+        }
+
+      if (item->meta)
+        {
+          MxTextureCacheMetaEntry *entry;
+          GHashTableIter meta_iter;
+
+          g_hash_table_iter_init (&meta_iter, item->meta);
+          while (g_hash_table_iter_next (&meta_iter, NULL, (gpointer *) &entry))
+            if (entry->texture)
+              bytes += mx_texture_cache_get_texture_bytes (entry->texture);
+        }
+
+      func (uri, bytes, in_atlas, user_data);
+    }
+}
+
 /* NOTE: you should unref the returned texture when not needed */
 
 static gchar *
@@ -306,6 +1398,54 @@ mx_texture_cache_filename_to_uri (const gchar *file)
   return uri;
 }
 
+/* whether @uri starts with a scheme, as in "^[a-zA-Z0-9+.-]+://" */
+static gboolean
+mx_texture_cache_is_uri (const gchar *uri)
+{
+  const gchar *p;
+
+  for (p = uri; g_ascii_isalnum (*p) || *p == '+' || *p == '.' || *p == '-';
+       p++)
+    ;
+
+  return p != uri && p[0] == ':' && p[1] == '/' && p[2] == '/';
+}
+
+/* Returns the URI for @path. The URIs of absolute paths are remembered, so
+ * that the lookups the widgets do on every restyle don't allocate; for
+ * relative paths, which depend on the current directory, and once the
+ * table is full, the URI is returned in @new_uri, to be freed. */
+#define MAX_PATH_URIS 4096
+
+static const gchar *
+mx_texture_cache_path_to_uri (MxTextureCache  *self,
+                              const gchar     *path,
+                              gchar          **new_uri)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  gchar *uri;
+
+  *new_uri = NULL;
+
+  if (!g_path_is_absolute (path))
+    return *new_uri = mx_texture_cache_filename_to_uri (path);
+
+  uri = g_hash_table_lookup (priv->path_uris, path);
+  if (uri)
+    return uri;
+
+  uri = mx_texture_cache_filename_to_uri (path);
+  if (!uri)
+    return NULL;
+
+  if (g_hash_table_size (priv->path_uris) < MAX_PATH_URIS)
+    g_hash_table_insert (priv->path_uris, g_strdup (path), uri);
+  else
+    *new_uri = uri;
+
+  return uri;
+}
+
 static gchar *
 mx_texture_cache_uri_to_filename (const gchar *uri)
 {
@@ -319,114 +1459,627 @@ mx_texture_cache_uri_to_filename (const gchar *uri)
   return file;
 }
 
-#if defined(__ANDROID__) || defined(ANDROID)
 static GQuark
 mx_texture_cache_error_quark (void)
 {
   return g_quark_from_static_string ("mx-texture-cache-error-quark");
 }
-#endif
 
-static MxTextureCacheItem *
-mx_texture_cache_get_item (MxTextureCache *self,
-                           const gchar    *uri,
-                           gboolean        create_if_not_exists)
+static void
+mx_texture_cache_atlas_texture_destroyed (void *data)
 {
-  MxTextureCachePrivate *priv;
-  MxTextureCacheItem *item;
-  gchar *new_file, *new_uri;
-  const gchar *file = NULL;
-  gboolean is_resource = FALSE;
+  MxTextureCacheAtlas *atlas = data;
 
-  priv = TEXTURE_CACHE_PRIVATE (self);
-
-  /* Make sure we have the URI (and the path if we're loading) */
-  new_file = new_uri = NULL;
+  if (--atlas->n_textures)
+    return;
 
-  if (g_str_has_prefix (uri, "resource://"))
-    is_resource = TRUE;
-  else
+  if (atlas->cache)
     {
-      if (g_regex_match (priv->is_uri, uri, 0, NULL))
-        {
-          if (create_if_not_exists)
-            {
-              file = new_file = mx_texture_cache_uri_to_filename (uri);
-              if (!new_file)
-                return NULL;
-            }
-        }
-      else
-        {
-          file = uri;
-          uri = new_uri = mx_texture_cache_filename_to_uri (file);
-          if (!new_uri)
-            return NULL;
-        }
+      MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (atlas->cache);
+
+      priv->atlases = g_list_remove (priv->atlases, atlas);
     }
 
-  item = g_hash_table_lookup (priv->cache, uri);
+  cogl_handle_unref (atlas->texture);
+  g_array_free (atlas->shelves, TRUE);
+  g_slice_free (MxTextureCacheAtlas, atlas);
+}
 
-  if ((!item || !item->ptr) && create_if_not_exists)
+/* finds room for a @width x @height rectangle on a shelf of @atlas */
+static gboolean
+mx_texture_cache_atlas_reserve (MxTextureCacheAtlas *atlas,
+                                gint                 width,
+                                gint                 height,
+                                gint                *x,
+                                gint                *y)
+{
+  MxTextureCacheShelf *shelf, *best = NULL;
+  guint i;
+
+  /* use the flattest shelf the rectangle fits on, so tall shelves aren't
+   * taken up by short images */
+  for (i = 0; i < atlas->shelves->len; i++)
     {
-      gboolean created;
-      GError *err = NULL;
+      shelf = &g_array_index (atlas->shelves, MxTextureCacheShelf, i);
 
-      if (!item)
-        {
-          item = mx_texture_cache_item_new ();
-          created = TRUE;
-        }
-      else
-        created = FALSE;
+      if (shelf->height >= height &&
+          shelf->x + width <= ATLAS_PAGE_SIZE &&
+          (!best || shelf->height < best->height))
+        best = shelf;
+    }
 
-      if (is_resource)
-        {
-          GdkPixbuf *pixbuf;
-          GInputStream *stream = NULL;
-          gint width, height, has_alpha, rowstride;
+  /* start a new shelf, unless the existing one wastes little space */
+  if ((!best || best->height > height + height / 2) &&
+      atlas->bottom + height <= ATLAS_PAGE_SIZE)
+    {
+      MxTextureCacheShelf new_shelf = { atlas->bottom, height, 0 };
 
-          stream = g_resources_open_stream (&uri[11],
-                                            G_RESOURCE_LOOKUP_FLAGS_NONE,
-                                            &err);
+      g_array_append_val (atlas->shelves, new_shelf);
+      atlas->bottom += height;
 
-          if (stream)
-            {
+      best = &g_array_index (atlas->shelves, MxTextureCacheShelf,
+                             atlas->shelves->len - 1);
+    }
 
-              pixbuf = gdk_pixbuf_new_from_stream (stream, NULL, &err);
+  if (!best)
+    return FALSE;
 
+  *x = best->x;
+  *y = best->y;
+  best->x += width;
 
-              width = gdk_pixbuf_get_width (pixbuf);
-              height = gdk_pixbuf_get_height (pixbuf);
-              has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
-              rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  return TRUE;
+}
 
-              item->ptr = cogl_texture_new_from_data (width, height,
-                                                      COGL_TEXTURE_NONE,
-                                                      has_alpha ? COGL_PIXEL_FORMAT_RGBA_8888 : COGL_PIXEL_FORMAT_RGB_888,
-                                                      COGL_PIXEL_FORMAT_ANY,
-                                                      rowstride,
-                                                      gdk_pixbuf_get_pixels (pixbuf));
+static CoglHandle
+mx_texture_cache_atlas_add (MxTextureCache *self,
+                            GdkPixbuf      *pixbuf)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  MxTextureCacheAtlas *atlas = NULL;
+  GdkPixbuf *padded;
+  CoglHandle texture;
+  gint width, height, x, y;
+  gint64 start;
+  GList *l;
+
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+
+  for (l = priv->atlases; l; l = l->next)
+    if (mx_texture_cache_atlas_reserve (l->data,
+                                        width + 2 * ATLAS_PADDING,
+                                        height + 2 * ATLAS_PADDING,
+                                        &x, &y))
+      {
+        atlas = l->data;
+        break;
+      }
+
+  if (!atlas)
+    {
+      texture = cogl_texture_new_with_size (ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE,
+                                            COGL_TEXTURE_NO_ATLAS |
+                                            COGL_TEXTURE_NO_AUTO_MIPMAP,
+                                            COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+      if (!texture)
+        return NULL;
+
+      atlas = g_slice_new0 (MxTextureCacheAtlas);
+      atlas->cache = self;
+      atlas->texture = texture;
+      atlas->shelves = g_array_new (FALSE, FALSE,
+                                    sizeof (MxTextureCacheShelf));
+      priv->atlases = g_list_prepend (priv->atlases, atlas);
+
+      mx_texture_cache_atlas_reserve (atlas,
+                                      width + 2 * ATLAS_PADDING,
+                                      height + 2 * ATLAS_PADDING,
+                                      &x, &y);
+    }
 
-              g_object_unref (stream);
-            }
-        }
-      else
-        {
-#if defined(__ANDROID__) || defined(ANDROID)
-          ClutterAndroidApplication *application =
-            clutter_android_application_get_default ();
-          const unsigned char *buffer, *pixels;
-          int width, height, stb_pixel_format, i;
-          AAssetManager *asset_manager;
-          AAsset *asset;
+  /* copy the image with its edges extruded into the padding */
+  padded = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8,
+                           width + 2 * ATLAS_PADDING,
+                           height + 2 * ATLAS_PADDING);
+  if (gdk_pixbuf_get_has_alpha (pixbuf))
+    gdk_pixbuf_copy_area (pixbuf, 0, 0, width, height,
+                          padded, ATLAS_PADDING, ATLAS_PADDING);
+  else
+    {
+      GdkPixbuf *alpha = gdk_pixbuf_add_alpha (pixbuf, FALSE, 0, 0, 0);
 
-          /* Remove preceeding characters, the android asset manager
-             doesn't support paths starting with . or / */
-          for (i = 0; file[i] != '\0'; i++)
-            {
-              if (file[i] != '.' &&
-                  file[i] != '/')
+      gdk_pixbuf_copy_area (alpha, 0, 0, width, height,
+                            padded, ATLAS_PADDING, ATLAS_PADDING);
+      g_object_unref (alpha);
+    }
+
+  gdk_pixbuf_copy_area (padded, ATLAS_PADDING, ATLAS_PADDING, width, 1,
+                        padded, ATLAS_PADDING, 0);
+  gdk_pixbuf_copy_area (padded, ATLAS_PADDING, height, width, 1,
+                        padded, ATLAS_PADDING, height + ATLAS_PADDING);
+  gdk_pixbuf_copy_area (padded, ATLAS_PADDING, 0, 1, height + 2 * ATLAS_PADDING,
+                        padded, 0, 0);
+  gdk_pixbuf_copy_area (padded, width, 0, 1, height + 2 * ATLAS_PADDING,
+                        padded, width + ATLAS_PADDING, 0);
+
+  start = _mx_frame_stats_begin (MX_FRAME_STATS_TEXTURE_UPLOAD);
+  cogl_texture_set_region (atlas->texture, 0, 0, x, y,
+                           width + 2 * ATLAS_PADDING,
+                           height + 2 * ATLAS_PADDING,
+                           width + 2 * ATLAS_PADDING,
+                           height + 2 * ATLAS_PADDING,
+                           COGL_PIXEL_FORMAT_RGBA_8888,
+                           gdk_pixbuf_get_rowstride (padded),
+                           gdk_pixbuf_get_pixels (padded));
+  _mx_frame_stats_end (MX_FRAME_STATS_TEXTURE_UPLOAD, start);
+  g_object_unref (padded);
+
+  texture = cogl_texture_new_from_sub_texture (atlas->texture,
+                                               x + ATLAS_PADDING,
+                                               y + ATLAS_PADDING,
+                                               width, height);
+
+  atlas->n_textures++;
+  cogl_object_set_user_data (texture, &atlas_key, atlas,
+                             mx_texture_cache_atlas_texture_destroyed);
+
+  return texture;
+}
+
+static CoglHandle
+mx_texture_cache_texture_from_pixels (MxTextureCache *self,
+                                      gint            width,
+                                      gint            height,
+                                      gint            rowstride,
+                                      gboolean        has_alpha,
+                                      const guint8   *pixels)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  CoglHandle texture;
+  gint64 start;
+
+  start = _mx_frame_stats_begin (MX_FRAME_STATS_TEXTURE_UPLOAD);
+  texture = cogl_texture_new_from_data (width, height, COGL_TEXTURE_NONE,
+                                        has_alpha ?
+                                        COGL_PIXEL_FORMAT_RGBA_8888 :
+                                        COGL_PIXEL_FORMAT_RGB_888,
+                                        COGL_PIXEL_FORMAT_ANY,
+                                        rowstride, pixels);
+  _mx_frame_stats_end (MX_FRAME_STATS_TEXTURE_UPLOAD, start);
+
+  if (texture)
+    priv->stats.standalone_bytes +=
+      mx_texture_cache_get_texture_bytes (texture);
+
+  return texture;
+}
+
+static CoglHandle
+mx_texture_cache_texture_from_pixbuf (MxTextureCache *self,
+                                      GdkPixbuf      *pixbuf)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  gboolean has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
+  CoglHandle texture;
+
+  if (gdk_pixbuf_get_width (pixbuf) <= ATLAS_MAX_IMAGE_SIZE &&
+      gdk_pixbuf_get_height (pixbuf) <= ATLAS_MAX_IMAGE_SIZE &&
+      gdk_pixbuf_get_bits_per_sample (pixbuf) == 8)
+    {
+      texture = mx_texture_cache_atlas_add (self, pixbuf);
+
+      if (texture)
+        {
+          priv->stats.atlas_bytes +=
+            mx_texture_cache_get_texture_bytes (texture);
+          return texture;
+        }
+    }
+
+  return mx_texture_cache_texture_from_pixels (self,
+                                               gdk_pixbuf_get_width (pixbuf),
+                                               gdk_pixbuf_get_height (pixbuf),
+                                               gdk_pixbuf_get_rowstride (pixbuf),
+                                               has_alpha,
+                                               gdk_pixbuf_get_pixels (pixbuf));
+}
+
+/*
+ * Pre-compressed images
+ *
+ * An image can be provided in a GPU compressed format (ETC2, ASTC...) by
+ * putting a KTX or KTX2 file with the same name next to it. If the driver
+ * doesn't support its format, the original image is loaded instead. As
+ * Cogl doesn't handle compressed formats, the texture is uploaded with GL
+ * and wrapped as a foreign texture. Images with an alpha channel are
+ * expected to have premultiplied alpha.
+ */
+
+#define MX_GL_TEXTURE_2D             0x0DE1
+#define MX_GL_TEXTURE_BINDING_2D     0x8069
+#define MX_GL_TEXTURE_MAG_FILTER     0x2800
+#define MX_GL_TEXTURE_MIN_FILTER     0x2801
+#define MX_GL_TEXTURE_WRAP_S         0x2802
+#define MX_GL_TEXTURE_WRAP_T         0x2803
+#define MX_GL_LINEAR                 0x2601
+#define MX_GL_CLAMP_TO_EDGE          0x812F
+#define MX_GL_COMPRESSED_RGB8_ETC2   0x9274
+#define MX_GL_COMPRESSED_SRGB8_ETC2  0x9275
+
+static const guint8 ktx_identifier[12] =
+  { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const guint8 ktx2_identifier[12] =
+  { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+static struct
+{
+  gboolean initialized;
+
+  void   (* GenTextures)          (gint n, guint *textures);
+  void   (* DeleteTextures)       (gint n, const guint *textures);
+  void   (* BindTexture)          (guint target, guint texture);
+  void   (* TexParameteri)        (guint target, guint pname, gint param);
+  void   (* GetIntegerv)          (guint pname, gint *params);
+  guint  (* GetError)             (void);
+  void   (* CompressedTexImage2D) (guint target, gint level,
+                                   guint internal_format,
+                                   gint width, gint height, gint border,
+                                   gint size, const void *data);
+} gl;
+
+static CoglUserDataKey compressed_texture_key;
+
+/* maps the Vulkan formats used by KTX2 to GL ones, 0 if unsupported */
+static guint32
+mx_texture_cache_vk_format_to_gl (guint32 vk_format)
+{
+  switch (vk_format)
+    {
+    case 147: /* VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK */
+      return MX_GL_COMPRESSED_RGB8_ETC2;
+    case 148: /* VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK */
+      return MX_GL_COMPRESSED_SRGB8_ETC2;
+    case 149: /* VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK */
+      return 0x9276;
+    case 151: /* VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK */
+      return 0x9278;
+    default:
+      /* VK_FORMAT_ASTC_4x4_UNORM_BLOCK to VK_FORMAT_ASTC_12x12_UNORM_BLOCK
+       * are in the same order as GL_COMPRESSED_RGBA_ASTC_4x4_KHR to
+       * GL_COMPRESSED_RGBA_ASTC_12x12_KHR */
+      if (vk_format >= 157 && vk_format <= 183 && vk_format % 2)
+        return 0x93B0 + (vk_format - 157) / 2;
+      return 0;
+    }
+}
+
+/* parses the KTX or KTX2 file next to @filename, if there is one. This
+ * doesn't touch GL, so can be called from any thread. */
+static MxTextureCacheCompressed *
+mx_texture_cache_read_compressed (const gchar *filename)
+{
+  MxTextureCacheCompressed *compressed;
+  const gchar *dot, *slash;
+  gchar *base, *path, *contents;
+  const guint32 *header;
+  gsize length, i;
+  guint32 gl_format = 0, width = 0, height = 0, offset = 0, size = 0;
+
+  dot = strrchr (filename, '.');
+  slash = strrchr (filename, G_DIR_SEPARATOR);
+  if (!dot || (slash && dot < slash))
+    return NULL;
+
+  base = g_strndup (filename, dot - filename);
+  contents = NULL;
+
+  for (i = 0; i < 2 && !contents; i++)
+    {
+      path = g_strconcat (base, i ? ".ktx2" : ".ktx", NULL);
+      if (!g_file_get_contents (path, &contents, &length, NULL))
+        contents = NULL;
+      g_free (path);
+    }
+  g_free (base);
+
+  if (!contents)
+    return NULL;
+
+  header = (const guint32 *) (contents + 12);
+
+  if (length >= 64 && !memcmp (contents, ktx_identifier, 12))
+    {
+      gboolean swap = header[0] == 0x01020304;
+      guint32 fields[13];
+      gsize j;
+
+      for (j = 0; j < 13; j++)
+        fields[j] = swap ? GUINT32_SWAP_LE_BE (header[j]) : header[j];
+
+      /* compressed (no type or format), 2D, not an array nor a cube map */
+      if (fields[0] == 0x04030201 && !fields[1] && !fields[3] &&
+          !fields[8] && !fields[9] && fields[10] <= 1)
+        {
+          gl_format = fields[4];
+          width = fields[6];
+          height = fields[7];
+          offset = 64 + fields[12];
+
+          if (offset >= 64 && (guint64) offset + 4 <= length)
+            {
+              memcpy (&size, contents + offset, 4);
+              if (swap)
+                size = GUINT32_SWAP_LE_BE (size);
+              offset += 4;
+            }
+          else
+            gl_format = 0;
+        }
+    }
+  else if (length >= 104 && !memcmp (contents, ktx2_identifier, 12))
+    {
+      guint64 level_offset, level_size;
+
+      /* no supercompression, 2D, single layer and face */
+      if (!GUINT32_FROM_LE (header[8]) && !GUINT32_FROM_LE (header[4]) &&
+          GUINT32_FROM_LE (header[5]) <= 1 && GUINT32_FROM_LE (header[6]) == 1)
+        {
+          gl_format =
+            mx_texture_cache_vk_format_to_gl (GUINT32_FROM_LE (header[0]));
+          width = GUINT32_FROM_LE (header[2]);
+          height = GUINT32_FROM_LE (header[3]);
+
+          /* the level index follows the 80 bytes of header and index */
+          memcpy (&level_offset, contents + 80, 8);
+          memcpy (&level_size, contents + 88, 8);
+          level_offset = GUINT64_FROM_LE (level_offset);
+          level_size = GUINT64_FROM_LE (level_size);
+
+          if (level_offset <= length && level_size <= G_MAXUINT32)
+            {
+              offset = level_offset;
+              size = level_size;
+            }
+          else
+            gl_format = 0;
+        }
+    }
+
+  if (!gl_format || !width || !height || !size ||
+      (guint64) offset + size > length)
+    {
+      g_free (contents);
+      return NULL;
+    }
+
+  compressed = g_slice_new (MxTextureCacheCompressed);
+  compressed->contents = contents;
+  compressed->gl_format = gl_format;
+  compressed->width = width;
+  compressed->height = height;
+  compressed->data = (const guint8 *) contents + offset;
+  compressed->size = size;
+
+  return compressed;
+}
+
+static void
+mx_texture_cache_compressed_texture_destroyed (void *data)
+{
+  guint gl_texture = GPOINTER_TO_UINT (data);
+
+  gl.DeleteTextures (1, &gl_texture);
+}
+
+/* uploads a compressed image, returning NULL if the driver doesn't
+ * support its format */
+static CoglHandle
+mx_texture_cache_upload_compressed (MxTextureCache           *self,
+                                    MxTextureCacheCompressed *compressed)
+{
+  static GHashTable *unsupported_formats = NULL;
+  CoglHandle texture;
+  CoglPixelFormat format;
+  guint gl_texture;
+  gint previous;
+
+  if (!gl.initialized)
+    {
+      gl.initialized = TRUE;
+
+      gl.GenTextures = (void *) cogl_get_proc_address ("glGenTextures");
+      gl.DeleteTextures = (void *) cogl_get_proc_address ("glDeleteTextures");
+      gl.BindTexture = (void *) cogl_get_proc_address ("glBindTexture");
+      gl.TexParameteri = (void *) cogl_get_proc_address ("glTexParameteri");
+      gl.GetIntegerv = (void *) cogl_get_proc_address ("glGetIntegerv");
+      gl.GetError = (void *) cogl_get_proc_address ("glGetError");
+      gl.CompressedTexImage2D =
+        (void *) cogl_get_proc_address ("glCompressedTexImage2D");
+
+      unsupported_formats = g_hash_table_new (NULL, NULL);
+    }
+
+  if (!gl.GenTextures || !gl.DeleteTextures || !gl.BindTexture ||
+      !gl.TexParameteri || !gl.GetIntegerv || !gl.GetError ||
+      !gl.CompressedTexImage2D ||
+      g_hash_table_contains (unsupported_formats,
+                             GUINT_TO_POINTER (compressed->gl_format)))
+    return NULL;
+
+  /* Cogl keeps track of the bound texture, so leave it as it was */
+  cogl_flush ();
+  gl.GetIntegerv (MX_GL_TEXTURE_BINDING_2D, &previous);
+
+  while (gl.GetError ())
+    ;
+
+  gl.GenTextures (1, &gl_texture);
+  gl.BindTexture (MX_GL_TEXTURE_2D, gl_texture);
+  gl.TexParameteri (MX_GL_TEXTURE_2D, MX_GL_TEXTURE_MIN_FILTER, MX_GL_LINEAR);
+  gl.TexParameteri (MX_GL_TEXTURE_2D, MX_GL_TEXTURE_MAG_FILTER, MX_GL_LINEAR);
+  gl.TexParameteri (MX_GL_TEXTURE_2D, MX_GL_TEXTURE_WRAP_S,
+                    MX_GL_CLAMP_TO_EDGE);
+  gl.TexParameteri (MX_GL_TEXTURE_2D, MX_GL_TEXTURE_WRAP_T,
+                    MX_GL_CLAMP_TO_EDGE);
+  gl.CompressedTexImage2D (MX_GL_TEXTURE_2D, 0, compressed->gl_format,
+                           compressed->width, compressed->height, 0,
+                           compressed->size, compressed->data);
+
+  gl.BindTexture (MX_GL_TEXTURE_2D, previous);
+
+  if (gl.GetError ())
+    {
+      g_hash_table_add (unsupported_formats,
+                        GUINT_TO_POINTER (compressed->gl_format));
+      gl.DeleteTextures (1, &gl_texture);
+      return NULL;
+    }
+
+  if (compressed->gl_format == MX_GL_COMPRESSED_RGB8_ETC2 ||
+      compressed->gl_format == MX_GL_COMPRESSED_SRGB8_ETC2)
+    format = COGL_PIXEL_FORMAT_RGB_888;
+  else
+    format = COGL_PIXEL_FORMAT_RGBA_8888_PRE;
+
+  texture = cogl_texture_new_from_foreign (gl_texture, MX_GL_TEXTURE_2D,
+                                           compressed->width,
+                                           compressed->height,
+                                           0, 0, format);
+  if (!texture)
+    {
+      gl.DeleteTextures (1, &gl_texture);
+      return NULL;
+    }
+
+  /* Cogl doesn't delete foreign textures */
+  cogl_object_set_user_data (texture, &compressed_texture_key,
+                             GUINT_TO_POINTER (gl_texture),
+                             mx_texture_cache_compressed_texture_destroyed);
+
+  TEXTURE_CACHE_PRIVATE (self)->stats.standalone_bytes += compressed->size;
+
+  return texture;
+}
+
+static CoglHandle mx_texture_cache_index_lookup (MxTextureCache *self,
+                                                 const gchar    *uri);
+
+static MxTextureCacheItem *
+mx_texture_cache_get_item (MxTextureCache *self,
+                           const gchar    *uri,
+                           gboolean        create_if_not_exists)
+{
+  MxTextureCachePrivate *priv;
+  MxTextureCacheItem *item;
+  const MxTextureCacheVariant *variant = NULL;
+  gchar *new_file, *new_uri;
+  const gchar *file = NULL;
+  gboolean is_resource = FALSE;
+  MX_TRACE_BEGIN (mx_texture_cache_get_item);
+
+  priv = TEXTURE_CACHE_PRIVATE (self);
+
+  /* Make sure we have the URI; the path is only needed if we're loading */
+  new_file = new_uri = NULL;
+
+  if (g_str_has_prefix (uri, "resource://"))
+    is_resource = TRUE;
+  else if (!mx_texture_cache_is_uri (uri))
+    {
+      /* variants are cached under their own URI */
+      variant = mx_texture_cache_get_variant (self, uri);
+      file = variant ? variant->filename : uri;
+      uri = mx_texture_cache_path_to_uri (self, file, &new_uri);
+      if (!uri)
+        {
+          MX_TRACE_END (mx_texture_cache_get_item);
+          return NULL;
+        }
+    }
+
+  item = g_hash_table_lookup (priv->cache, uri);
+
+  if (!item && priv->indexes)
+    {
+      CoglHandle texture = mx_texture_cache_index_lookup (self, uri);
+
+      if (texture)
+        {
+          /* the memory is accounted to the page */
+          item = mx_texture_cache_item_new ();
+          item->sub_texture = TRUE;
+          mx_texture_cache_item_set_texture (item, texture);
+          add_texture_to_cache (self, uri, item);
+          mx_texture_cache_item_update (priv, item);
+        }
+    }
+
+  if (create_if_not_exists)
+    {
+      if (item && item->ptr)
+        priv->stats.hits++;
+      else
+        priv->stats.misses++;
+
+      mx_texture_cache_queue_stats_changed (self);
+    }
+
+  if ((!item || !item->ptr) && create_if_not_exists && !is_resource && !file)
+    {
+      file = new_file = mx_texture_cache_uri_to_filename (uri);
+      if (!new_file)
+        {
+          g_free (new_uri);
+          MX_TRACE_END (mx_texture_cache_get_item);
+          return NULL;
+        }
+    }
+
+  if ((!item || !item->ptr) && create_if_not_exists)
+    {
+      gboolean created;
+      GError *err = NULL;
+      gint64 start = g_get_monotonic_time ();
+
+      if (!item)
+        {
+          item = mx_texture_cache_item_new ();
+          created = TRUE;
+        }
+      else
+        created = FALSE;
+
+      if (is_resource)
+        {
+          GdkPixbuf *pixbuf;
+
+          pixbuf = mx_texture_cache_decode_resource (&uri[11], &err);
+          if (pixbuf)
+            {
+              item->ptr = mx_texture_cache_texture_from_pixbuf (self, pixbuf);
+              g_object_unref (pixbuf);
+            }
+
+          mx_texture_cache_add_decode_time (self,
+                                            g_get_monotonic_time () - start);
+        }
+      else
+        {
+#if defined(__ANDROID__) || defined(ANDROID)
+          ClutterAndroidApplication *application =
+            clutter_android_application_get_default ();
+          const unsigned char *buffer, *pixels;
+          int width, height, stb_pixel_format, i;
+          AAssetManager *asset_manager;
+          AAsset *asset;
+
+          /* Remove preceeding characters, the android asset manager
+             doesn't support paths starting with . or / */
+          for (i = 0; file[i] != '\0'; i++)
+            {
+              if (file[i] != '.' &&
+                  file[i] != '/')
                 break;
             }
 
@@ -442,6 +2095,9 @@ mx_texture_cache_get_item (MxTextureCache *self,
                                               &width, &height,
                                               &stb_pixel_format,
                                               4 /* STBI_rgb_alpha */);
+              mx_texture_cache_add_decode_time (self,
+                                                g_get_monotonic_time () -
+                                                start);
 
               if (pixels != NULL)
                 item->ptr = cogl_texture_new_from_data (width, height,
@@ -460,9 +2116,39 @@ mx_texture_cache_get_item (MxTextureCache *self,
             err = g_error_new (mx_texture_cache_error_quark (), 0,
                                "Could not open %s", file);
 #else
-          item->ptr = cogl_texture_new_from_file (file, COGL_TEXTURE_NONE,
-                                                  COGL_PIXEL_FORMAT_ANY,
-                                                  &err);
+          MxTextureCacheCompressed *compressed = NULL;
+
+          /* compressed images can't be scaled down */
+          if (!variant || variant->scale == priv->scale_factor)
+            compressed = mx_texture_cache_read_compressed (file);
+          if (compressed)
+            {
+              item->ptr = mx_texture_cache_upload_compressed (self,
+                                                              compressed);
+              mx_texture_cache_compressed_free (compressed);
+            }
+
+          if (!item->ptr)
+            {
+              GdkPixbuf *pixbuf;
+
+              start = g_get_monotonic_time ();
+              pixbuf = mx_texture_cache_decode_file (file,
+                                                     variant ? variant->scale
+                                                             : 1,
+                                                     priv->scale_factor,
+                                                     &err);
+              mx_texture_cache_add_decode_time (self,
+                                                g_get_monotonic_time () -
+                                                start);
+
+              if (pixbuf)
+                {
+                  item->ptr = mx_texture_cache_texture_from_pixbuf (self,
+                                                                    pixbuf);
+                  g_object_unref (pixbuf);
+                }
+            }
 #endif
         }
 
@@ -480,9 +2166,15 @@ mx_texture_cache_get_item (MxTextureCache *self,
           g_free (new_file);
           g_free (new_uri);
 
+          MX_TRACE_END (mx_texture_cache_get_item);
+
           return NULL;
         }
 
+      mx_texture_cache_item_set_texture (item, item->ptr);
+      if (variant)
+        mx_texture_cache_set_texture_scale (item->ptr, priv->scale_factor);
+
       if (created)
         add_texture_to_cache (self, uri, item);
     }
@@ -490,36 +2182,1039 @@ mx_texture_cache_get_item (MxTextureCache *self,
   g_free (new_file);
   g_free (new_uri);
 
-  return item;
+  MX_TRACE_END (mx_texture_cache_get_item);
+
+  return item;
+}
+
+/**
+ * mx_texture_cache_get_cogl_texture:
+ * @self: A #MxTextureCache
+ * @uri: A URI or path to an image file
+ *
+ * Create a #CoglHandle representing a texture of the specified image. Adds
+ * the image to the cache if the image had not been previously loaded.
+ * Subsequent calls with the same image URI/path will return the #CoglHandle of
+ * the previously loaded image with an increased reference count.
+ *
+ * Returns: (transfer none): a #CoglHandle to the cached texture
+ */
+CoglHandle
+mx_texture_cache_get_cogl_texture (MxTextureCache *self,
+                                   const gchar    *uri)
+{
+  MxTextureCacheItem *item;
+
+  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), NULL);
+  g_return_val_if_fail (uri != NULL, NULL);
+
+  item = mx_texture_cache_get_item (self, uri, TRUE);
+
+  if (item)
+    {
+      mx_texture_cache_use_item (self, item);
+      return cogl_handle_ref (item->ptr);
+    }
+  else
+    return NULL;
+}
+
+static void
+mx_texture_cache_destroy_meta_entry (gpointer data)
+{
+  MxTextureCacheMetaEntry *entry = data;
+
+  if (entry->destroy_func)
+    entry->destroy_func (entry->ident);
+
+  if (entry->texture)
+    cogl_handle_unref (entry->texture);
+
+  g_slice_free (MxTextureCacheMetaEntry, entry);
+}
+
+/* the smallest level of the image that still covers @width x @height,
+ * where a dimension of 0 or less isn't constrained */
+static guint
+mx_texture_cache_get_scaled_level (gint source_width,
+                                   gint source_height,
+                                   gint width,
+                                   gint height)
+{
+  guint level = 0;
+
+  if (width <= 0 && height <= 0)
+    return 0;
+
+  while (level < MAX_SCALED_LEVEL)
+    {
+      gint next_width = source_width >> (level + 1);
+      gint next_height = source_height >> (level + 1);
+
+      if (next_width < MAX (width, 1) || next_height < MAX (height, 1))
+        break;
+
+      level++;
+    }
+
+  return level;
+}
+
+static void
+mx_texture_cache_scale_size_prepared_cb (GdkPixbufLoader            *loader,
+                                         gint                        width,
+                                         gint                        height,
+                                         MxTextureCacheScaleRequest *request)
+{
+  request->source_width = width;
+  request->source_height = height;
+  request->level = mx_texture_cache_get_scaled_level (width, height,
+                                                      request->width,
+                                                      request->height);
+
+  /* loaders that support it (JPEG) decode at the smaller size directly */
+  if (request->level)
+    gdk_pixbuf_loader_set_size (loader,
+                                MAX (width >> request->level, 1),
+                                MAX (height >> request->level, 1));
+}
+
+/* decodes @uri at the level requested by @request, which also receives the
+ * size of the full image */
+static GdkPixbuf *
+mx_texture_cache_decode_scaled (const gchar                 *uri,
+                                const gchar                 *filename,
+                                MxTextureCacheScaleRequest  *request,
+                                GError                     **error)
+{
+  GdkPixbufLoader *loader;
+  GdkPixbuf *pixbuf = NULL;
+  GBytes *bytes = NULL;
+  gchar *contents;
+  gsize length;
+
+  if (filename)
+    {
+      if (!g_file_get_contents (filename, &contents, &length, error))
+        return NULL;
+
+      bytes = g_bytes_new_take (contents, length);
+    }
+  else
+    {
+      bytes = g_resources_lookup_data (&uri[11],
+                                       G_RESOURCE_LOOKUP_FLAGS_NONE, error);
+      if (!bytes)
+        return NULL;
+    }
+
+  loader = gdk_pixbuf_loader_new ();
+  g_signal_connect (loader, "size-prepared",
+                    G_CALLBACK (mx_texture_cache_scale_size_prepared_cb),
+                    request);
+
+  if (!gdk_pixbuf_loader_write (loader, g_bytes_get_data (bytes, NULL),
+                                g_bytes_get_size (bytes), error))
+    gdk_pixbuf_loader_close (loader, NULL);
+  else if (gdk_pixbuf_loader_close (loader, error))
+    pixbuf = g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
+
+  g_object_unref (loader);
+  g_bytes_unref (bytes);
+
+  return pixbuf;
+}
+
+/**
+ * mx_texture_cache_get_cogl_texture_at_size:
+ * @self: A #MxTextureCache
+ * @uri: A URI or path to an image file
+ * @width: the width the texture will be displayed at, or -1
+ * @height: the height the texture will be displayed at, or -1
+ *
+ * Gets a texture of the specified image that is at least @width x @height,
+ * for displaying large images at a reduced size. Rather than the exact
+ * size, the image is scaled down by a power of two, to the smallest size
+ * that still covers the requested one, so that requests for similar sizes
+ * share the same texture. The aspect ratio of the image is kept.
+ *
+ * Scaled copies are decoded at their size where the image format allows
+ * it, and are kept in the cache alongside the full image, which is not
+ * loaded for them. If the image isn't larger than twice the requested
+ * size, this returns the same texture as
+ * mx_texture_cache_get_cogl_texture().
+ *
+ * Returns: (transfer full): a #CoglHandle to the cached texture, or %NULL
+ *   if the image couldn't be loaded
+ *
+ * Since: 2.0
+ */
+CoglHandle
+mx_texture_cache_get_cogl_texture_at_size (MxTextureCache *self,
+                                           const gchar    *uri,
+                                           gint            width,
+                                           gint            height)
+{
+  MxTextureCachePrivate *priv;
+  MxTextureCacheScaleRequest request;
+  MxTextureCacheMetaEntry *entry;
+  MxTextureCacheItem *item;
+  const gchar *canonical_uri;
+  gchar *new_uri = NULL, *filename = NULL;
+  gboolean is_resource = FALSE;
+  CoglHandle texture;
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  gint64 start;
+
+  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), NULL);
+  g_return_val_if_fail (uri != NULL, NULL);
+
+  priv = TEXTURE_CACHE_PRIVATE (self);
+
+  if (width <= 0 && height <= 0)
+    return mx_texture_cache_get_cogl_texture (self, uri);
+
+  item = mx_texture_cache_get_item (self, uri, FALSE);
+
+  if (item && item->ptr && !item->width)
+    {
+      item->width = cogl_texture_get_width (item->ptr);
+      item->height = cogl_texture_get_height (item->ptr);
+    }
+
+  if (item && item->width)
+    {
+      guint level = mx_texture_cache_get_scaled_level (item->width,
+                                                       item->height,
+                                                       width, height);
+
+      if (!level)
+        return mx_texture_cache_get_cogl_texture (self, uri);
+
+      entry = item->meta ?
+        g_hash_table_lookup (item->meta, &scaled_idents[level]) : NULL;
+
+      if (entry && entry->texture)
+        {
+          priv->stats.hits++;
+          mx_texture_cache_use_item (self, item);
+
+          return cogl_handle_ref (entry->texture);
+        }
+    }
+
+  priv->stats.misses++;
+  mx_texture_cache_queue_stats_changed (self);
+
+  /* find the URI, and the file to decode unless it's a resource */
+  canonical_uri = uri;
+
+  if (g_str_has_prefix (uri, "resource://"))
+    is_resource = TRUE;
+  else if (mx_texture_cache_is_uri (uri))
+    filename = mx_texture_cache_uri_to_filename (uri);
+  else
+    {
+      canonical_uri = mx_texture_cache_path_to_uri (self, uri, &new_uri);
+      filename = g_strdup (uri);
+    }
+
+  if (!canonical_uri || (!filename && !is_resource))
+    {
+      g_free (new_uri);
+      g_free (filename);
+      return NULL;
+    }
+
+  request.width = width;
+  request.height = height;
+  request.source_width = request.source_height = 0;
+  request.level = 0;
+
+  start = g_get_monotonic_time ();
+  pixbuf = mx_texture_cache_decode_scaled (canonical_uri, filename,
+                                           &request, &error);
+  mx_texture_cache_add_decode_time (self, g_get_monotonic_time () - start);
+
+  g_free (filename);
+
+  if (!pixbuf)
+    {
+      g_warning ("Error loading image: %s", error->message);
+      g_error_free (error);
+      g_free (new_uri);
+      return NULL;
+    }
+
+  texture = mx_texture_cache_texture_from_pixbuf (self, pixbuf);
+  g_object_unref (pixbuf);
+
+  if (!texture)
+    {
+      g_free (new_uri);
+      return NULL;
+    }
+
+  if (!item)
+    {
+      item = mx_texture_cache_item_new ();
+      add_texture_to_cache (self, canonical_uri, item);
+    }
+
+  g_free (new_uri);
+
+  item->width = request.source_width;
+  item->height = request.source_height;
+
+  if (!request.level)
+    {
+      /* the image is small enough to be used as it is */
+      if (!item->ptr)
+        mx_texture_cache_item_set_texture (item, texture);
+      else
+        {
+          cogl_handle_unref (texture);
+          texture = item->ptr;
+        }
+
+      mx_texture_cache_use_item (self, item);
+
+      return cogl_handle_ref (texture);
+    }
+
+  if (!item->meta)
+    item->meta = g_hash_table_new_full (NULL, NULL, NULL,
+                                        mx_texture_cache_destroy_meta_entry);
+
+  entry = g_slice_new0 (MxTextureCacheMetaEntry);
+  entry->ident = &scaled_idents[request.level];
+  entry->texture = texture;
+
+  g_hash_table_insert (item->meta, entry->ident, entry);
+
+  mx_texture_cache_use_item (self, item);
+
+  return cogl_handle_ref (texture);
+}
+
+static void
+mx_texture_cache_remove_load (MxTextureCache     *self,
+                              MxTextureCacheLoad *load)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+
+  g_mutex_lock (&priv->loads_lock);
+  g_hash_table_remove (priv->loads, load->uri);
+  g_mutex_unlock (&priv->loads_lock);
+}
+
+static void
+mx_texture_cache_load_free (MxTextureCacheLoad *load)
+{
+  g_object_unref (load->cache);
+  g_free (load->uri);
+  g_free (load->filename);
+
+  if (load->compressed)
+    mx_texture_cache_compressed_free (load->compressed);
+  if (load->pixbuf)
+    g_object_unref (load->pixbuf);
+  if (load->error)
+    g_error_free (load->error);
+  if (load->cancellable)
+    g_object_unref (load->cancellable);
+
+  g_slice_free (MxTextureCacheLoad, load);
+}
+
+/* back in the main thread, with the image decoded */
+static gboolean
+mx_texture_cache_upload (gpointer data)
+{
+  MxTextureCacheLoad *load = data;
+  MxTextureCache *self = load->cache;
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  MxTextureCacheItem *item;
+  CoglHandle texture = NULL;
+  GList *l;
+
+  mx_texture_cache_remove_load (self, load);
+
+  if (load->pixbuf)
+    mx_texture_cache_add_decode_time (self, load->decode_time);
+
+  if (load->compressed || load->pixbuf)
+    {
+      /* the image may have been loaded synchronously in the meantime */
+      item = mx_texture_cache_get_item (self, load->uri, FALSE);
+
+      if (!item || !item->ptr)
+        {
+          if (load->compressed)
+            texture = mx_texture_cache_upload_compressed (self,
+                                                          load->compressed);
+
+          /* the driver doesn't support the compressed format */
+          if (!texture && !load->pixbuf)
+            {
+              gint64 start = g_get_monotonic_time ();
+
+              load->pixbuf = mx_texture_cache_decode_file (load->filename,
+                                                           load->source_scale,
+                                                           load->scale,
+                                                           &load->error);
+              mx_texture_cache_add_decode_time (self,
+                                                g_get_monotonic_time () -
+                                                start);
+            }
+
+          if (!texture && load->pixbuf)
+            texture = mx_texture_cache_texture_from_pixbuf (self,
+                                                            load->pixbuf);
+
+          if (texture)
+            {
+              if (load->source_scale > 1)
+                mx_texture_cache_set_texture_scale (texture, load->scale);
+
+              if (!item)
+                {
+                  item = mx_texture_cache_item_new ();
+                  mx_texture_cache_item_set_texture (item, texture);
+                  add_texture_to_cache (self, load->uri, item);
+                }
+              else
+                mx_texture_cache_item_set_texture (item, texture);
+            }
+          else if (!load->error)
+            load->error = g_error_new (mx_texture_cache_error_quark (), 0,
+                                       "Could not create a texture for %s",
+                                       load->uri);
+        }
+
+      if (item && item->ptr)
+        {
+          texture = item->ptr;
+          mx_texture_cache_use_item (self, item);
+        }
+    }
+
+  for (l = load->results; l; l = l->next)
+    {
+      GSimpleAsyncResult *simple = l->data;
+
+      if (texture)
+        g_simple_async_result_set_op_res_gpointer (simple,
+                                                   cogl_handle_ref (texture),
+                                                   cogl_handle_unref);
+      else
+        g_simple_async_result_set_from_error (simple, load->error);
+
+      g_simple_async_result_complete (simple);
+      g_object_unref (simple);
+    }
+  g_list_free (load->results);
+
+  mx_texture_cache_load_free (load);
+
+  return FALSE;
+}
+
+static gboolean
+mx_texture_cache_upload_preloads (gpointer data)
+{
+  MxTextureCache *self = g_object_ref (data);
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  MxTextureCacheLoad *load;
+  gboolean more;
+  gint64 start;
+
+  /* Like MxActorManager, work for a slice of time and let the frame be
+   * drawn before carrying on; the source has a lower priority than
+   * redraws.
+   */
+  start = g_get_monotonic_time ();
+
+  while ((load = g_queue_pop_head (&priv->preloads)))
+    {
+      load->queued = FALSE;
+
+      if (!load->results && load->cancellable &&
+          g_cancellable_is_cancelled (load->cancellable))
+        {
+          mx_texture_cache_remove_load (self, load);
+          mx_texture_cache_load_free (load);
+        }
+      else
+        mx_texture_cache_upload (load);
+
+      if (g_get_monotonic_time () - start >= PRELOAD_TIME_SLICE * 1000)
+        break;
+    }
+
+  more = !g_queue_is_empty (&priv->preloads);
+  if (!more)
+    priv->preload_source = 0;
+
+  g_object_unref (self);
+
+  return more;
+}
+
+static void mx_texture_cache_decode (gpointer data);
+
+/* back in the main thread, once the worker is done with the image */
+static void
+mx_texture_cache_decoded (gpointer data)
+{
+  MxTextureCacheLoad *load = data;
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (load->cache);
+
+  if (load->skipped)
+    {
+      load->skipped = FALSE;
+
+      /* a request for the image came after the preload was cancelled */
+      if (load->results)
+        {
+          g_object_unref (load->cancellable);
+          load->cancellable = NULL;
+          load->job_id = mx_worker_pool_push (mx_worker_pool_get_default (),
+                                              G_PRIORITY_DEFAULT,
+                                              mx_texture_cache_decode,
+                                              mx_texture_cache_decoded,
+                                              load, NULL);
+        }
+      else
+        {
+          mx_texture_cache_remove_load (load->cache, load);
+          mx_texture_cache_load_free (load);
+        }
+
+      return;
+    }
+
+  if (load->results)
+    {
+      mx_texture_cache_upload (load);
+      return;
+    }
+
+  load->queued = TRUE;
+  g_queue_push_tail (&priv->preloads, load);
+
+  if (!priv->preload_source)
+    priv->preload_source =
+      clutter_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE,
+                                     mx_texture_cache_upload_preloads,
+                                     load->cache, NULL);
+}
+
+/* finds the URI for @uri, and the file to decode unless it's a resource,
+ * along with the scale factor that file was drawn for */
+static gboolean
+mx_texture_cache_resolve (MxTextureCache  *self,
+                          const gchar     *uri,
+                          gchar          **new_uri,
+                          gchar          **filename,
+                          gint            *source_scale)
+{
+  *new_uri = *filename = NULL;
+  *source_scale = 1;
+
+  if (g_str_has_prefix (uri, "resource://"))
+    *new_uri = g_strdup (uri);
+  else if (mx_texture_cache_is_uri (uri))
+    {
+      *new_uri = g_strdup (uri);
+      *filename = mx_texture_cache_uri_to_filename (uri);
+    }
+  else
+    {
+      const MxTextureCacheVariant *variant;
+      const gchar *path_uri;
+
+      variant = mx_texture_cache_get_variant (self, uri);
+      if (variant)
+        {
+          uri = variant->filename;
+          *source_scale = variant->scale;
+        }
+
+      path_uri = mx_texture_cache_path_to_uri (self, uri, new_uri);
+      if (path_uri && !*new_uri)
+        *new_uri = g_strdup (path_uri);
+      *filename = g_strdup (uri);
+    }
+
+  if (!*new_uri || (!*filename && !g_str_has_prefix (*new_uri, "resource://")))
+    {
+      g_free (*new_uri);
+      g_free (*filename);
+      *new_uri = *filename = NULL;
+
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* starts decoding an image on a worker, taking @uri and @filename, drawn
+ * for @source_scale; loads with a @cancellable are preloads, and are
+ * decoded after the images that have been asked for. If the image is
+ * already being loaded, that load is returned instead. */
+static MxTextureCacheLoad *
+mx_texture_cache_start_load (MxTextureCache *self,
+                             gchar          *uri,
+                             gchar          *filename,
+                             gint            source_scale,
+                             GCancellable   *cancellable)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  MxTextureCacheLoad *load;
+
+  g_mutex_lock (&priv->loads_lock);
+
+  load = g_hash_table_lookup (priv->loads, uri);
+  if (load)
+    {
+      g_mutex_unlock (&priv->loads_lock);
+      g_free (uri);
+      g_free (filename);
+
+      return load;
+    }
+
+  load = g_slice_new0 (MxTextureCacheLoad);
+  load->cache = g_object_ref (self);
+  load->uri = uri;
+  load->filename = filename;
+  load->source_scale = source_scale;
+  load->scale = source_scale > 1 ? priv->scale_factor : 1;
+  if (cancellable)
+    load->cancellable = g_object_ref (cancellable);
+
+  g_hash_table_insert (priv->loads, load->uri, load);
+  load->job_id = mx_worker_pool_push (mx_worker_pool_get_default (),
+                                      cancellable ? G_PRIORITY_LOW :
+                                                    G_PRIORITY_DEFAULT,
+                                      mx_texture_cache_decode,
+                                      mx_texture_cache_decoded, load, NULL);
+
+  g_mutex_unlock (&priv->loads_lock);
+
+  return load;
+}
+
+/* runs on a worker thread, and so must not touch the cache */
+static void
+mx_texture_cache_decode (gpointer data)
+{
+  MxTextureCacheLoad *load = data;
+  gint64 start = g_get_monotonic_time ();
+
+  if (load->cancellable && g_cancellable_is_cancelled (load->cancellable))
+    load->skipped = TRUE;
+  else if (load->filename)
+    {
+      /* compressed images can't be scaled down */
+      if (load->source_scale == load->scale)
+        load->compressed = mx_texture_cache_read_compressed (load->filename);
+
+      if (!load->compressed)
+        load->pixbuf = mx_texture_cache_decode_file (load->filename,
+                                                     load->source_scale,
+                                                     load->scale,
+                                                     &load->error);
+    }
+  else
+    load->pixbuf = mx_texture_cache_decode_resource (&load->uri[11],
+                                                     &load->error);
+
+  load->decode_time = g_get_monotonic_time () - start;
+}
+
+/**
+ * mx_texture_cache_get_cogl_texture_async:
+ * @self: A #MxTextureCache
+ * @uri: A URI or path to an image file
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *   texture is ready
+ * @user_data: (closure): data to pass to @callback
+ *
+ * Asynchronous version of mx_texture_cache_get_cogl_texture(). If the
+ * image is not in the cache yet, it is decoded on a worker thread and
+ * then uploaded and added to the cache from the main loop. Requests for
+ * an image that is already being loaded share the same load.
+ *
+ * When the texture is ready, @callback is called; call
+ * mx_texture_cache_get_cogl_texture_finish() from it to get the texture.
+ *
+ * Since: 2.0
+ */
+void
+mx_texture_cache_get_cogl_texture_async (MxTextureCache      *self,
+                                         const gchar         *uri,
+                                         GCancellable        *cancellable,
+                                         GAsyncReadyCallback  callback,
+                                         gpointer             user_data)
+{
+  MxTextureCachePrivate *priv;
+  MxTextureCacheItem *item;
+  MxTextureCacheLoad *load;
+  GSimpleAsyncResult *simple;
+  gchar *new_uri, *filename;
+  gint source_scale;
+  gboolean hit;
+
+  g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
+  g_return_if_fail (uri != NULL);
+
+  priv = TEXTURE_CACHE_PRIVATE (self);
+
+  simple = g_simple_async_result_new (G_OBJECT (self), callback, user_data,
+                                      mx_texture_cache_get_cogl_texture_async);
+  g_simple_async_result_set_check_cancellable (simple, cancellable);
+
+  item = mx_texture_cache_get_item (self, uri, FALSE);
+  hit = item && item->ptr;
+
+#if defined(__ANDROID__) || defined(ANDROID)
+  /* images are read from the asset manager, which is only done
+   * synchronously */
+  if (!item || !item->ptr)
+    item = mx_texture_cache_get_item (self, uri, TRUE);
+#endif
+
+  if (item && item->ptr)
+    {
+      /* synchronous loads count themselves */
+      if (hit)
+        {
+          priv->stats.hits++;
+          mx_texture_cache_queue_stats_changed (self);
+        }
+
+      mx_texture_cache_use_item (self, item);
+      g_simple_async_result_set_op_res_gpointer (simple,
+                                                 cogl_handle_ref (item->ptr),
+                                                 cogl_handle_unref);
+      g_simple_async_result_complete_in_idle (simple);
+      g_object_unref (simple);
+      return;
+    }
+
+  priv->stats.misses++;
+  mx_texture_cache_queue_stats_changed (self);
+
+  if (!mx_texture_cache_resolve (self, uri, &new_uri, &filename,
+                                 &source_scale))
+    {
+      g_simple_async_result_set_error (simple, mx_texture_cache_error_quark (),
+                                       0, "Could not load %s", uri);
+      g_simple_async_result_complete_in_idle (simple);
+      g_object_unref (simple);
+      return;
+    }
+
+  load = mx_texture_cache_start_load (self, new_uri, filename,
+                                      source_scale, NULL);
+
+  load->results = g_list_append (load->results, simple);
+
+  /* a preload that hasn't been decoded yet catches up with the requests */
+  mx_worker_pool_set_priority (mx_worker_pool_get_default (), load->job_id,
+                               G_PRIORITY_DEFAULT);
+
+  /* a preloaded image is uploaded right away once it's needed */
+  if (load->queued)
+    {
+      load->queued = FALSE;
+      g_queue_remove (&priv->preloads, load);
+      clutter_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                     mx_texture_cache_upload, load, NULL);
+    }
+}
+
+/**
+ * mx_texture_cache_get_cogl_texture_finish:
+ * @self: A #MxTextureCache
+ * @result: the #GAsyncResult passed to the callback
+ * @error: a #GError or %NULL
+ *
+ * Finishes a request started with
+ * mx_texture_cache_get_cogl_texture_async().
+ *
+ * Returns: (transfer full): a #CoglHandle to the cached texture, or %NULL
+ *   on error
+ *
+ * Since: 2.0
+ */
+CoglHandle
+mx_texture_cache_get_cogl_texture_finish (MxTextureCache  *self,
+                                          GAsyncResult    *result,
+                                          GError         **error)
+{
+  GSimpleAsyncResult *simple;
+
+  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), NULL);
+  g_return_val_if_fail (g_simple_async_result_is_valid (result,
+                                                        G_OBJECT (self),
+                                                        mx_texture_cache_get_cogl_texture_async),
+                        NULL);
+
+  simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  if (g_simple_async_result_propagate_error (simple, error))
+    return NULL;
+
+  return cogl_handle_ref (g_simple_async_result_get_op_res_gpointer (simple));
+}
+
+/**
+ * mx_texture_cache_preload:
+ * @self: A #MxTextureCache
+ * @uris: (array zero-terminated=1): a %NULL-terminated array of URIs or
+ *   paths to image files
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ *
+ * Starts loading images that will be needed soon, for instance during a
+ * splash screen, so that they are already in the cache when they are
+ * first requested. The images are decoded on worker threads, and then
+ * uploaded from the main loop a few at a time, so that frames keep being
+ * drawn meanwhile.
+ *
+ * Images that are already in the cache or being loaded are skipped. Loads
+ * that are still pending when @cancellable is cancelled are abandoned,
+ * unless the image has been requested in the meantime.
+ *
+ * Since: 2.0
+ */
+void
+mx_texture_cache_preload (MxTextureCache  *self,
+                          const gchar    **uris,
+                          GCancellable    *cancellable)
+{
+  g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
+  g_return_if_fail (uris != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  for (; *uris; uris++)
+    {
+      MxTextureCacheItem *item;
+      gchar *new_uri, *filename;
+      gint source_scale;
+
+      item = mx_texture_cache_get_item (self, *uris, FALSE);
+      if (item && item->ptr)
+        continue;
+
+      if (!mx_texture_cache_resolve (self, *uris, &new_uri, &filename,
+                                     &source_scale))
+        {
+          g_warning (G_STRLOC ": Could not load %s", *uris);
+          continue;
+        }
+
+      /* images already being loaded are left to their load */
+      mx_texture_cache_start_load (self, new_uri, filename, source_scale,
+                                   cancellable);
+    }
+}
+
+/* The URI for @uri, a URI or an absolute path. Unlike the lookups of the
+ * main thread, this doesn't look for variants nor remember the URIs of
+ * paths, so that it can be used from any thread. */
+static gchar *
+mx_texture_cache_get_thread_uri (const gchar *uri)
+{
+  if (mx_texture_cache_is_uri (uri))
+    return g_strdup (uri);
+
+  if (g_path_is_absolute (uri))
+    return g_filename_to_uri (uri, NULL, NULL);
+
+  return NULL;
+}
+
+/**
+ * mx_texture_cache_is_cached:
+ * @self: A #MxTextureCache
+ * @uri: A URI or absolute path to an image file
+ *
+ * Checks whether the image at @uri is in the cache, as
+ * mx_texture_cache_contains() does. Unlike it, this may be called from
+ * any thread, and paths are not replaced with their variants for the
+ * scale factor of the cache.
+ *
+ * Returns: %TRUE if the image is in the cache
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_texture_cache_is_cached (MxTextureCache *self,
+                            const gchar    *uri)
+{
+  gboolean cached;
+  gchar *new_uri;
+
+  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), FALSE);
+  g_return_val_if_fail (uri != NULL, FALSE);
+
+  new_uri = mx_texture_cache_get_thread_uri (uri);
+  if (!new_uri)
+    return FALSE;
+
+  cached = mx_texture_cache_index_contains (TEXTURE_CACHE_PRIVATE (self),
+                                            new_uri);
+  g_free (new_uri);
+
+  return cached;
+}
+
+/**
+ * mx_texture_cache_is_loading:
+ * @self: A #MxTextureCache
+ * @uri: A URI or absolute path to an image file
+ *
+ * Checks whether the image at @uri is being loaded, by
+ * mx_texture_cache_get_cogl_texture_async(), mx_texture_cache_preload() or
+ * mx_texture_cache_load_in_thread(). This may be called from any thread.
+ *
+ * Returns: %TRUE if the image is being loaded
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_texture_cache_is_loading (MxTextureCache *self,
+                             const gchar    *uri)
+{
+  MxTextureCachePrivate *priv;
+  gboolean loading;
+  gchar *new_uri;
+
+  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), FALSE);
+  g_return_val_if_fail (uri != NULL, FALSE);
+
+  priv = TEXTURE_CACHE_PRIVATE (self);
+
+  new_uri = mx_texture_cache_get_thread_uri (uri);
+  if (!new_uri)
+    return FALSE;
+
+  g_mutex_lock (&priv->loads_lock);
+  loading = g_hash_table_contains (priv->loads, new_uri);
+  g_mutex_unlock (&priv->loads_lock);
+
+  g_free (new_uri);
+
+  return loading;
+}
+
+static gboolean
+mx_texture_cache_decoded_idle (gpointer data)
+{
+  mx_texture_cache_decoded (data);
+
+  return FALSE;
 }
 
 /**
- * mx_texture_cache_get_cogl_texture:
+ * mx_texture_cache_load_in_thread:
  * @self: A #MxTextureCache
- * @uri: A URI or path to an image file
+ * @uri: A URI or absolute path to an image file
+ * @error: a #GError or %NULL
  *
- * Create a #CoglHandle representing a texture of the specified image. Adds
- * the image to the cache if the image had not been previously loaded.
- * Subsequent calls with the same image URI/path will return the #CoglHandle of
- * the previously loaded image with an increased reference count.
+ * Decodes the image at @uri in the calling thread, which may be any
+ * thread, for instance a worker prefetching images. The texture is then
+ * created and added to the cache from the main loop, like those of
+ * mx_texture_cache_preload(). Requests made for the image meanwhile with
+ * mx_texture_cache_get_cogl_texture_async() share the load.
  *
- * Returns: (transfer none): a #CoglHandle to the cached texture
+ * Nothing is done if the image is already in the cache or being loaded.
+ * Paths are not replaced with their variants for the scale factor of the
+ * cache.
+ *
+ * Returns: %TRUE if the image is in the cache, being loaded or was
+ *   decoded, %FALSE if it could not be decoded
+ *
+ * Since: 2.0
  */
-CoglHandle
-mx_texture_cache_get_cogl_texture (MxTextureCache *self,
-                                   const gchar    *uri)
+gboolean
+mx_texture_cache_load_in_thread (MxTextureCache  *self,
+                                 const gchar     *uri,
+                                 GError         **error)
 {
-  MxTextureCacheItem *item;
+  MxTextureCachePrivate *priv;
+  MxTextureCacheLoad *load;
+  gchar *new_uri, *filename = NULL;
+  gboolean decoded;
 
-  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), NULL);
-  g_return_val_if_fail (uri != NULL, NULL);
+  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), FALSE);
+  g_return_val_if_fail (uri != NULL, FALSE);
 
-  item = mx_texture_cache_get_item (self, uri, TRUE);
+  priv = TEXTURE_CACHE_PRIVATE (self);
 
-  if (item)
-    return cogl_handle_ref (item->ptr);
-  else
-    return NULL;
+  new_uri = mx_texture_cache_get_thread_uri (uri);
+  if (!new_uri)
+    {
+      g_set_error (error, mx_texture_cache_error_quark (), 0,
+                   "Could not load %s", uri);
+      return FALSE;
+    }
+
+  if (mx_texture_cache_index_contains (priv, new_uri))
+    {
+      g_free (new_uri);
+      return TRUE;
+    }
+
+  if (!g_str_has_prefix (new_uri, "resource://"))
+    {
+      filename = g_filename_from_uri (new_uri, NULL, error);
+      if (!filename)
+        {
+          g_free (new_uri);
+          return FALSE;
+        }
+    }
+
+  /* claim the load, unless another thread already has */
+  g_mutex_lock (&priv->loads_lock);
+
+  if (g_hash_table_contains (priv->loads, new_uri))
+    {
+      g_mutex_unlock (&priv->loads_lock);
+      g_free (new_uri);
+      g_free (filename);
+
+      return TRUE;
+    }
+
+  load = g_slice_new0 (MxTextureCacheLoad);
+  load->cache = g_object_ref (self);
+  load->uri = new_uri;
+  load->filename = filename;
+  load->source_scale = 1;
+  load->scale = 1;
+
+  g_hash_table_insert (priv->loads, load->uri, load);
+
+  g_mutex_unlock (&priv->loads_lock);
+
+  mx_texture_cache_decode (load);
+
+  decoded = load->compressed || load->pixbuf;
+  if (!decoded && load->error)
+    g_propagate_error (error, g_error_copy (load->error));
+
+  /* the main thread owns the load from here on */
+  clutter_threads_add_idle_full (G_PRIORITY_DEFAULT,
+                                 mx_texture_cache_decoded_idle, load, NULL);
+
+  return decoded;
 }
 
 /**
@@ -548,14 +3243,18 @@ mx_texture_cache_get_meta_cogl_texture (MxTextureCache *self,
   g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), NULL);
   g_return_val_if_fail (uri != NULL, NULL);
 
-  item = mx_texture_cache_get_item (self, uri, TRUE);
+  /* the metadata doesn't need the image itself to be loaded */
+  item = mx_texture_cache_get_item (self, uri, FALSE);
 
   if (item && item->meta)
     {
       MxTextureCacheMetaEntry *entry = g_hash_table_lookup (item->meta, ident);
 
-      if (entry->texture)
-        return cogl_handle_ref (entry->texture);
+      if (entry && entry->texture)
+        {
+          mx_texture_cache_use_item (self, item);
+          return cogl_handle_ref (entry->texture);
+        }
     }
 
   return NULL;
@@ -637,43 +3336,27 @@ mx_texture_cache_insert (MxTextureCache *self,
 {
   gchar *new_uri = NULL;
   MxTextureCacheItem *item;
-  MxTextureCachePrivate *priv;
 
   g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
   g_return_if_fail (uri != NULL);
   g_return_if_fail (cogl_is_texture (texture));
 
-  priv = TEXTURE_CACHE_PRIVATE (self);
-
   /* Transform path to URI, if necessary */
-  if (!g_regex_match (priv->is_uri, uri, 0, NULL))
+  if (!mx_texture_cache_is_uri (uri))
     {
-      uri = new_uri = mx_texture_cache_filename_to_uri (uri);
-      if (!new_uri)
+      uri = mx_texture_cache_path_to_uri (self, uri, &new_uri);
+      if (!uri)
         return;
     }
 
   item = mx_texture_cache_item_new ();
-  item->ptr = cogl_handle_ref (texture);
+  mx_texture_cache_item_set_texture (item, cogl_handle_ref (texture));
   add_texture_to_cache (self, uri, item);
+  mx_texture_cache_use_item (self, item);
 
   g_free (new_uri);
 }
 
-static void
-mx_texture_cache_destroy_meta_entry (gpointer data)
-{
-  MxTextureCacheMetaEntry *entry = data;
-
-  if (entry->destroy_func)
-    entry->destroy_func (entry->ident);
-
-  if (entry->texture)
-    cogl_handle_unref (entry->texture);
-
-  g_slice_free (MxTextureCacheMetaEntry, entry);
-}
-
 /**
  * mx_texture_cache_insert_meta:
  * @self: A #MxTextureCache
@@ -699,20 +3382,17 @@ mx_texture_cache_insert_meta (MxTextureCache *self,
 {
   gchar *new_uri = NULL;
   MxTextureCacheItem *item;
-  MxTextureCachePrivate *priv;
   MxTextureCacheMetaEntry *entry;
 
   g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
   g_return_if_fail (uri != NULL);
   g_return_if_fail (cogl_is_texture (texture));
 
-  priv = TEXTURE_CACHE_PRIVATE (self);
-
   /* Transform path to URI, if necessary */
-  if (!g_regex_match (priv->is_uri, uri, 0, NULL))
+  if (!mx_texture_cache_is_uri (uri))
     {
-      uri = new_uri = mx_texture_cache_filename_to_uri (uri);
-      if (!new_uri)
+      uri = mx_texture_cache_path_to_uri (self, uri, &new_uri);
+      if (!uri)
         return;
     }
 
@@ -735,28 +3415,415 @@ mx_texture_cache_insert_meta (MxTextureCache *self,
   entry->destroy_func = destroy_func;
 
   g_hash_table_insert (item->meta, ident, entry);
+
+  mx_texture_cache_use_item (self, item);
 }
 
-void
-mx_texture_cache_load_cache (MxTextureCache *self,
-                             const gchar    *filename)
+/* the shared page file for the image @filename, which depends on the file
+ * as it is now */
+static gchar *
+mx_texture_cache_get_shared_page_path (MxTextureCache *self,
+                                       const gchar    *filename)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  GStatBuf buf;
+  gchar *key, *checksum, *name, *path;
+
+  if (g_stat (filename, &buf) != 0)
+    return NULL;
+
+  key = g_strdup_printf ("%s\n%" G_GINT64_FORMAT "\n%" G_GINT64_FORMAT,
+                         filename, (gint64) buf.st_size,
+                         (gint64) buf.st_mtime);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key, -1);
+  name = g_strconcat (checksum, ".page", NULL);
+  path = g_build_filename (priv->shared_dir, name, NULL);
+
+  g_free (name);
+  g_free (checksum);
+  g_free (key);
+
+  return path;
+}
+
+/* uploads the pixels of the shared page file @path, if it is valid */
+static CoglHandle
+mx_texture_cache_map_shared_page (MxTextureCache *self,
+                                  const gchar    *path)
+{
+  const MxTextureCachePageFileHeader *header;
+  GMappedFile *file;
+  CoglHandle texture = NULL;
+  guint32 width, height, rowstride, has_alpha;
+  guint64 size;
+
+  file = g_mapped_file_new (path, FALSE, NULL);
+  if (!file)
+    return NULL;
+
+  header = (const MxTextureCachePageFileHeader *)
+    g_mapped_file_get_contents (file);
+  size = g_mapped_file_get_length (file);
+
+  if (size < sizeof (MxTextureCachePageFileHeader) ||
+      memcmp (header->magic, MX_TEXTURE_CACHE_PAGE_FILE_MAGIC, 8) ||
+      GUINT32_FROM_LE (header->version) != MX_TEXTURE_CACHE_PAGE_FILE_VERSION)
+    goto out;
+
+  width = GUINT32_FROM_LE (header->width);
+  height = GUINT32_FROM_LE (header->height);
+  rowstride = GUINT32_FROM_LE (header->rowstride);
+  has_alpha = GUINT32_FROM_LE (header->has_alpha);
+
+  if (!width || !height || width > G_MAXINT / 4 ||
+      rowstride < width * (has_alpha ? 4 : 3) ||
+      size != sizeof (MxTextureCachePageFileHeader) +
+      (guint64) rowstride * height)
+    {
+      g_warning ("Corrupt shared texture cache page '%s'", path);
+      goto out;
+    }
+
+  /* the pixels are read from the mapping, which every process has the
+   * same copy of, straight into the texture */
+  texture = mx_texture_cache_texture_from_pixels (self, width, height,
+                                                  rowstride, has_alpha,
+                                                  (const guint8 *) (header + 1));
+
+out:
+  g_mapped_file_unref (file);
+
+  return texture;
+}
+
+/* writes the pixels of @pixbuf to the shared page file @path, through a
+ * temporary file, so that other processes never see part of it */
+static void
+mx_texture_cache_write_shared_page (const gchar *path,
+                                    GdkPixbuf   *pixbuf)
+{
+  MxTextureCachePageFileHeader header = { MX_TEXTURE_CACHE_PAGE_FILE_MAGIC, };
+  const guint8 *pixels;
+  gchar *tmp_path;
+  gint fd, rowstride, height;
+  gsize length;
+
+  tmp_path = g_strconcat (path, ".XXXXXX", NULL);
+  fd = g_mkstemp_full (tmp_path, O_WRONLY, 0644);
+  if (fd < 0)
+    {
+      g_free (tmp_path);
+      return;
+    }
+
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+
+  header.version = GUINT32_TO_LE (MX_TEXTURE_CACHE_PAGE_FILE_VERSION);
+  header.width = GUINT32_TO_LE (gdk_pixbuf_get_width (pixbuf));
+  header.height = GUINT32_TO_LE (height);
+  header.rowstride = GUINT32_TO_LE (rowstride);
+  header.has_alpha = GUINT32_TO_LE (gdk_pixbuf_get_has_alpha (pixbuf));
+
+  /* the last row of a pixbuf may be shorter than the rowstride, so it is
+   * padded out */
+  pixels = gdk_pixbuf_get_pixels_with_length (pixbuf, &length);
+
+  if (write (fd, &header, sizeof (header)) == sizeof (header) &&
+      write (fd, pixels, length) == (gssize) length &&
+      ftruncate (fd, sizeof (header) + (gsize) rowstride * height) == 0 &&
+      close (fd) == 0)
+    {
+      fd = -1;
+      if (g_rename (tmp_path, path) == 0)
+        {
+          g_free (tmp_path);
+          return;
+        }
+    }
+
+  if (fd >= 0)
+    close (fd);
+  g_unlink (tmp_path);
+  g_free (tmp_path);
+}
+
+/* Loads the atlas page @uri of a cache file through the shared directory:
+ * its decoded pixels are mapped from there if another process published
+ * them, or else the image is decoded and published for the next one */
+static CoglHandle
+mx_texture_cache_load_shared_page (MxTextureCache *self,
+                                   const gchar    *uri)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  CoglHandle texture = NULL;
+  gchar *filename, *path;
+  GdkPixbuf *pixbuf;
+  gint64 start;
+
+  filename = mx_texture_cache_uri_to_filename (uri);
+  if (!filename)
+    return NULL;
+
+  path = mx_texture_cache_get_shared_page_path (self, filename);
+  if (!path)
+    {
+      g_free (filename);
+      return NULL;
+    }
+
+  texture = mx_texture_cache_map_shared_page (self, path);
+
+  if (!texture)
+    {
+      start = g_get_monotonic_time ();
+      pixbuf = mx_texture_cache_decode_file (filename, 1, 1, NULL);
+      mx_texture_cache_add_decode_time (self, g_get_monotonic_time () - start);
+
+      if (pixbuf && gdk_pixbuf_get_bits_per_sample (pixbuf) == 8 &&
+          gdk_pixbuf_get_colorspace (pixbuf) == GDK_COLORSPACE_RGB)
+        {
+          if (g_mkdir_with_parents (priv->shared_dir, 0755) == 0)
+            mx_texture_cache_write_shared_page (path, pixbuf);
+
+          texture =
+            mx_texture_cache_texture_from_pixels (self,
+                                                  gdk_pixbuf_get_width (pixbuf),
+                                                  gdk_pixbuf_get_height (pixbuf),
+                                                  gdk_pixbuf_get_rowstride (pixbuf),
+                                                  gdk_pixbuf_get_has_alpha (pixbuf),
+                                                  gdk_pixbuf_get_pixels (pixbuf));
+        }
+
+      if (pixbuf)
+        g_object_unref (pixbuf);
+    }
+
+  g_free (path);
+  g_free (filename);
+
+  return texture;
+}
+
+/* the texture of the atlas page @uri of a cache file */
+static CoglHandle
+mx_texture_cache_get_page (MxTextureCache *self,
+                           const gchar    *uri)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  MxTextureCacheItem *item;
+  CoglHandle texture;
+
+  item = g_hash_table_lookup (priv->cache, uri);
+
+  if (!priv->shared_dir || (item && item->ptr) ||
+      !(texture = mx_texture_cache_load_shared_page (self, uri)))
+    return mx_texture_cache_get_cogl_texture (self, uri);
+
+  if (!item)
+    {
+      item = mx_texture_cache_item_new ();
+      add_texture_to_cache (self, uri, item);
+    }
+
+  mx_texture_cache_item_set_texture (item, texture);
+  mx_texture_cache_item_update (priv, item);
+
+  return cogl_handle_ref (texture);
+}
+
+static CoglHandle
+mx_texture_cache_index_lookup (MxTextureCache *self,
+                               const gchar    *uri)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  guint32 hash = mx_texture_cache_file_hash (uri);
+  GList *l;
+
+  for (l = priv->indexes; l; l = l->next)
+    {
+      MxTextureCacheIndex *index = l->data;
+      const MxTextureCacheFileEntry *entry;
+      CoglHandle page, texture;
+      guint32 i, n_steps, page_id, x, y, width, height;
+
+      if (!index->n_buckets)
+        continue;
+
+      entry = NULL;
+      i = GUINT32_FROM_LE (index->buckets[hash % index->n_buckets]);
+
+      /* the chain is bounded in case of a corrupt but valid-looking file */
+      for (n_steps = 0; i < index->n_entries && n_steps < index->n_entries;
+           n_steps++)
+        {
+          const MxTextureCacheFileEntry *e = &index->entries[i];
+
+          if (GUINT32_FROM_LE (e->hash) == hash &&
+              !strcmp (index->strings + GUINT32_FROM_LE (e->uri), uri))
+            {
+              entry = e;
+              break;
+            }
+
+          i = GUINT32_FROM_LE (e->next);
+        }
+
+      if (!entry)
+        continue;
+
+      page_id = GUINT32_FROM_LE (entry->page);
+      x = GUINT32_FROM_LE (entry->x);
+      y = GUINT32_FROM_LE (entry->y);
+      width = GUINT32_FROM_LE (entry->width);
+      height = GUINT32_FROM_LE (entry->height);
+
+      if (page_id >= index->n_pages || !index->page_uris[page_id])
+        continue;
+
+      page = mx_texture_cache_get_page (self, index->page_uris[page_id]);
+      if (!page)
+        continue;
+
+      if (!width || !height ||
+          x + width > cogl_texture_get_width (page) ||
+          y + height > cogl_texture_get_height (page))
+        {
+          g_warning (G_STRLOC ": Entry for '%s' is outside of its page",
+                     uri);
+          cogl_handle_unref (page);
+          continue;
+        }
+
+      texture = cogl_texture_new_from_sub_texture (page, x, y, width, height);
+      cogl_handle_unref (page);
+
+      if (texture)
+        priv->stats.atlas_bytes +=
+          mx_texture_cache_get_texture_bytes (texture);
+
+      return texture;
+    }
+
+  return NULL;
+}
+
+/* checks and maps a cache file in the current format, returning FALSE if
+ * it isn't one */
+static gboolean
+mx_texture_cache_load_index (MxTextureCache *self,
+                             const gchar    *filename,
+                             GMappedFile    *file)
+{
+  MxTextureCachePrivate *priv = TEXTURE_CACHE_PRIVATE (self);
+  const MxTextureCacheFileHeader *header;
+  const MxTextureCacheFilePage *pages;
+  MxTextureCacheIndex *index;
+  const gchar *contents;
+  guint32 n_pages, n_entries, n_buckets, strings_size, i;
+  guint64 size;
+  gchar *dirname;
+
+  contents = g_mapped_file_get_contents (file);
+  size = g_mapped_file_get_length (file);
+
+  if (size < sizeof (MxTextureCacheFileHeader) ||
+      memcmp (contents, MX_TEXTURE_CACHE_FILE_MAGIC, 8))
+    return FALSE;
+
+  header = (const MxTextureCacheFileHeader *) contents;
+
+  if (GUINT32_FROM_LE (header->version) != MX_TEXTURE_CACHE_FILE_VERSION)
+    {
+      g_warning ("Unsupported version of the texture cache file '%s'",
+                 filename);
+      return TRUE;
+    }
+
+  n_pages = GUINT32_FROM_LE (header->n_pages);
+  n_entries = GUINT32_FROM_LE (header->n_entries);
+  n_buckets = GUINT32_FROM_LE (header->n_buckets);
+  strings_size = GUINT32_FROM_LE (header->strings_size);
+
+  if (size != sizeof (MxTextureCacheFileHeader) +
+      (guint64) n_pages * sizeof (MxTextureCacheFilePage) +
+      (guint64) n_entries * sizeof (MxTextureCacheFileEntry) +
+      (guint64) n_buckets * sizeof (guint32) + strings_size ||
+      (n_entries && !n_buckets) ||
+      !strings_size || contents[size - 1] != '\0' ||
+      GUINT32_FROM_LE (header->checksum) !=
+      mx_texture_cache_file_checksum ((const guchar *) (header + 1),
+                                      size - sizeof (MxTextureCacheFileHeader)))
+    {
+      g_warning ("Corrupt texture cache file '%s'", filename);
+      return TRUE;
+    }
+
+  index = g_slice_new0 (MxTextureCacheIndex);
+  index->file = g_mapped_file_ref (file);
+
+  pages = (const MxTextureCacheFilePage *) (header + 1);
+  index->entries = (const MxTextureCacheFileEntry *) (pages + n_pages);
+  index->buckets = (const guint32 *) (index->entries + n_entries);
+  index->strings = (const gchar *) (index->buckets + n_buckets);
+  index->n_entries = n_entries;
+  index->n_buckets = n_buckets;
+
+  /* check the string offsets here rather than on every lookup */
+  for (i = 0; i < n_entries; i++)
+    if (GUINT32_FROM_LE (index->entries[i].uri) >= strings_size)
+      {
+        g_warning ("Corrupt texture cache file '%s'", filename);
+        mx_texture_cache_index_free (index);
+        return TRUE;
+      }
+
+  /* resolve the pages, which are the only thing allocated per file */
+  dirname = g_path_get_dirname (filename);
+  index->n_pages = n_pages;
+  index->page_uris = g_new0 (gchar *, n_pages + 1);
+
+  for (i = 0; i < n_pages; i++)
+    {
+      guint32 offset = GUINT32_FROM_LE (pages[i].path);
+      gchar *path;
+
+      if (offset >= strings_size)
+        continue;
+
+      if (g_path_is_absolute (index->strings + offset))
+        path = g_strdup (index->strings + offset);
+      else
+        path = g_build_filename (dirname, index->strings + offset, NULL);
+      index->page_uris[i] = mx_texture_cache_filename_to_uri (path);
+      g_free (path);
+    }
+  g_free (dirname);
+
+  priv->indexes = g_list_append (priv->indexes, index);
+
+  return TRUE;
+}
+
+/* files written by older versions of mx-create-image-cache, with a single
+ * page and one entry per image */
+static void
+mx_texture_cache_load_legacy_cache (MxTextureCache *self,
+                                    const gchar    *filename)
 {
   FILE *file;
-  MxTextureCacheItem *element, head;
+  MxTextureCacheFileItem element, head;
   int ret;
   CoglHandle full_texture;
   MxTextureCachePrivate *priv;
 
-  g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
-  g_return_if_fail (filename != NULL);
-
   priv = TEXTURE_CACHE_PRIVATE (self);
 
   file = fopen(filename, "rm");
   if (!file)
     return;
 
-  ret = fread (&head, sizeof(MxTextureCacheItem), 1, file);
+  ret = fread (&head, sizeof(MxTextureCacheFileItem), 1, file);
   if (ret < 0)
     {
       fclose (file);
@@ -782,42 +3849,126 @@ mx_texture_cache_load_cache (MxTextureCache *self,
 
   while (!feof (file))
     {
+      MxTextureCacheItem *item;
       gchar *uri;
 
-      element = mx_texture_cache_item_new ();
-      ret = fread (element, sizeof (MxTextureCacheItem), 1, file);
+      ret = fread (&element, sizeof (MxTextureCacheFileItem), 1, file);
 
       if (ret < 1)
         {
           /* end of file */
-          mx_texture_cache_item_free (element);
           break;
         }
 
-      uri = mx_texture_cache_filename_to_uri (element->filename);
+      uri = mx_texture_cache_filename_to_uri (element.filename);
       if (!uri)
         {
           /* Couldn't resolve path */
-          mx_texture_cache_item_free (element);
           continue;
         }
 
-      if (g_hash_table_lookup (priv->cache, uri))
-        {
-          /* URI is already in the cache.... */
-          mx_texture_cache_item_free (element);
-          g_free (uri);
-        }
-      else
+      if (!g_hash_table_lookup (priv->cache, uri))
         {
-          element->ptr = cogl_texture_new_from_sub_texture (full_texture,
-                                                            element->posX,
-                                                            element->posY,
-                                                            element->width,
-                                                            element->height);
-          g_hash_table_insert (priv->cache, uri, element);
+          /* the memory is accounted to the full texture */
+          item = mx_texture_cache_item_new ();
+          item->sub_texture = TRUE;
+          mx_texture_cache_item_set_texture (item,
+            cogl_texture_new_from_sub_texture (full_texture,
+                                               element.posX,
+                                               element.posY,
+                                               element.width,
+                                               element.height));
+          add_texture_to_cache (self, uri, item);
+          mx_texture_cache_item_update (priv, item);
         }
+
+      /* else the URI is already in the cache.... */
+      g_free (uri);
     }
 
+  cogl_handle_unref (full_texture);
   fclose (file);
 }
+
+/**
+ * mx_texture_cache_load_cache:
+ * @self: A #MxTextureCache
+ * @filename: a texture cache file
+ *
+ * Loads a texture cache file, as written by mx-css-compile, which
+ * describes where images can be found in one or more bigger images. The
+ * images are then served from those as sub-textures when they are first
+ * requested, rather than loaded individually.
+ */
+void
+mx_texture_cache_load_cache (MxTextureCache *self,
+                             const gchar    *filename)
+{
+  GMappedFile *file;
+
+  g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
+  g_return_if_fail (filename != NULL);
+
+  file = g_mapped_file_new (filename, FALSE, NULL);
+  if (!file)
+    return;
+
+  if (!mx_texture_cache_load_index (self, filename, file))
+    mx_texture_cache_load_legacy_cache (self, filename);
+
+  g_mapped_file_unref (file);
+}
+
+/**
+ * mx_texture_cache_set_shared_dir:
+ * @self: A #MxTextureCache
+ * @dir: (allow-none): a directory, or %NULL
+ *
+ * Shares the decoded atlas pages of the cache files loaded with
+ * mx_texture_cache_load_cache() with other processes through @dir. The
+ * first process to use a page decodes it and writes its pixels to a file
+ * in @dir; the others map that file read-only and upload the pixels from
+ * it, without decoding the image, so there is one copy of them in memory
+ * however many applications use the same theme. A directory on a tmpfs,
+ * such as one in $XDG_RUNTIME_DIR, keeps the files in shared memory.
+ *
+ * The pages packed at run time from individual images depend on which
+ * images each process loads, so they are not shared.
+ *
+ * The default is the value of the MX_TEXTURE_CACHE_SHARED_DIR environment
+ * variable, if it is set, and otherwise %NULL, which doesn't share pages.
+ *
+ * Since: 2.0
+ */
+void
+mx_texture_cache_set_shared_dir (MxTextureCache *self,
+                                 const gchar    *dir)
+{
+  MxTextureCachePrivate *priv;
+
+  g_return_if_fail (MX_IS_TEXTURE_CACHE (self));
+
+  priv = TEXTURE_CACHE_PRIVATE (self);
+
+  g_free (priv->shared_dir);
+  priv->shared_dir = g_strdup (dir);
+}
+
+/**
+ * mx_texture_cache_get_shared_dir:
+ * @self: A #MxTextureCache
+ *
+ * Gets the directory set with mx_texture_cache_set_shared_dir().
+ *
+ * Returns: the directory the decoded pages of cache files are shared
+ *   through, or %NULL
+ *
+ * Since: 2.0
+ */
+const gchar *
+mx_texture_cache_get_shared_dir (MxTextureCache *self)
+{
+  g_return_val_if_fail (MX_IS_TEXTURE_CACHE (self), NULL);
+
+  return TEXTURE_CACHE_PRIVATE (self)->shared_dir;
+}
@@ -29,6 +29,7 @@
 #define _MX_TEXTURE_CACHE
 
 #include <glib-object.h>
+#include <gio/gio.h>
 #include <clutter/clutter.h>
 
 G_BEGIN_DECLS
@@ -69,27 +70,127 @@ typedef struct {
 typedef struct {
   GObjectClass parent_class;
 
+  void (* stats_changed) (MxTextureCache *cache);
+
   /* padding for future expansion */
-  void (*_padding_0) (void);
   void (*_padding_1) (void);
   void (*_padding_2) (void);
   void (*_padding_3) (void);
   void (*_padding_4) (void);
 } MxTextureCacheClass;
 
+/**
+ * MxTextureCacheStats:
+ * @n_entries: the number of images in the cache
+ * @used_bytes: the texture memory held by the cache, in bytes
+ * @max_bytes: the budget set with mx_texture_cache_set_max_bytes()
+ * @hits: the number of requests for a texture that was already loaded
+ * @misses: the number of requests that had to load their texture
+ * @atlas_bytes: the size of the images loaded into, or served from, shared
+ *   atlas pages, in bytes
+ * @standalone_bytes: the size of the images loaded into textures of their
+ *   own, in bytes
+ * @n_decodes: the number of images decoded
+ * @decode_time: the total time spent decoding images, in microseconds
+ *
+ * A snapshot of the usage of a #MxTextureCache, as returned by
+ * mx_texture_cache_get_stats(). Apart from @n_entries, @used_bytes and
+ * @max_bytes, the values are totals since the cache was created.
+ *
+ * Since: 2.0
+ */
+typedef struct {
+  guint  n_entries;
+  gsize  used_bytes;
+  gsize  max_bytes;
+
+  guint  hits;
+  guint  misses;
+
+  gsize  atlas_bytes;
+  gsize  standalone_bytes;
+
+  guint  n_decodes;
+  gint64 decode_time;
+} MxTextureCacheStats;
+
+/**
+ * MxTextureCacheForeachFunc:
+ * @uri: the URI of the image
+ * @bytes: the texture memory used by the image, in bytes
+ * @in_atlas: whether the image is stored in a shared atlas page
+ * @user_data: the data passed to mx_texture_cache_foreach()
+ *
+ * The type of the function called for each image by
+ * mx_texture_cache_foreach().
+ *
+ * Since: 2.0
+ */
+typedef void (* MxTextureCacheForeachFunc) (const gchar *uri,
+                                            gsize        bytes,
+                                            gboolean     in_atlas,
+                                            gpointer     user_data);
+
+#define MX_TYPE_TEXTURE_CACHE_STATS (mx_texture_cache_stats_get_type ())
+
 GType mx_texture_cache_get_type (void);
+GType mx_texture_cache_stats_get_type (void) G_GNUC_CONST;
+
+MxTextureCacheStats *mx_texture_cache_stats_copy (const MxTextureCacheStats *stats);
+void                 mx_texture_cache_stats_free (MxTextureCacheStats       *stats);
 
 MxTextureCache* mx_texture_cache_get_default (void);
 
 CoglHandle      mx_texture_cache_get_cogl_texture (MxTextureCache *self,
                                                    const gchar    *uri);
 
+void            mx_texture_cache_get_cogl_texture_async  (MxTextureCache      *self,
+                                                          const gchar         *uri,
+                                                          GCancellable        *cancellable,
+                                                          GAsyncReadyCallback  callback,
+                                                          gpointer             user_data);
+CoglHandle      mx_texture_cache_get_cogl_texture_finish (MxTextureCache  *self,
+                                                          GAsyncResult    *result,
+                                                          GError         **error);
+
+void            mx_texture_cache_preload                 (MxTextureCache      *self,
+                                                          const gchar        **uris,
+                                                          GCancellable        *cancellable);
+
+gboolean        mx_texture_cache_is_cached               (MxTextureCache      *self,
+                                                          const gchar         *uri);
+gboolean        mx_texture_cache_is_loading              (MxTextureCache      *self,
+                                                          const gchar         *uri);
+gboolean        mx_texture_cache_load_in_thread          (MxTextureCache      *self,
+                                                          const gchar         *uri,
+                                                          GError             **error);
+
+CoglHandle      mx_texture_cache_get_cogl_texture_at_size (MxTextureCache *self,
+                                                           const gchar    *uri,
+                                                           gint            width,
+                                                           gint            height);
+
 CoglHandle      mx_texture_cache_get_meta_cogl_texture (MxTextureCache *self,
                                                         const gchar    *uri,
                                                         gpointer        ident);
 
 gint            mx_texture_cache_get_size    (MxTextureCache *self);
 
+void            mx_texture_cache_set_max_bytes  (MxTextureCache *self,
+                                                 gsize           max_bytes);
+gsize           mx_texture_cache_get_max_bytes  (MxTextureCache *self);
+gsize           mx_texture_cache_get_used_bytes (MxTextureCache *self);
+
+void            mx_texture_cache_set_scale_factor (MxTextureCache *self,
+                                                   gint            scale_factor);
+gint            mx_texture_cache_get_scale_factor (MxTextureCache *self);
+
+void            mx_texture_cache_get_stats   (MxTextureCache            *self,
+                                              MxTextureCacheStats       *stats);
+void            mx_texture_cache_foreach     (MxTextureCache            *self,
+                                              MxTextureCacheForeachFunc  func,
+                                              gpointer                   user_data);
+
 gboolean        mx_texture_cache_contains    (MxTextureCache *self,
                                               const gchar    *uri);
 
@@ -109,6 +210,10 @@ void            mx_texture_cache_insert_meta (MxTextureCache *self,
 
 void mx_texture_cache_load_cache (MxTextureCache *self,
                                   const char     *filename);
+
+void         mx_texture_cache_set_shared_dir (MxTextureCache *self,
+                                              const gchar    *dir);
+const gchar *mx_texture_cache_get_shared_dir (MxTextureCache *self);
 G_END_DECLS
 
 #endif /* _MX_TEXTURE_CACHE */
@@ -33,6 +33,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include <cogl/cogl.h>
 
 #include "mx-texture-frame.h"
@@ -40,40 +42,51 @@
 
 static CoglMaterial *template_material = NULL;
 
-static void
-mx_texture_frame_paint_texture_internal (CoglHandle  material,
-                                         CoglHandle  texture,
-                                         guint8      opacity,
-                                         gfloat      top,
-                                         gfloat      right,
-                                         gfloat      bottom,
-                                         gfloat      left,
-                                         gfloat      width,
-                                         gfloat      height)
+struct _MxTextureFrameCache
 {
-  gfloat tex_width, tex_height;
-  gfloat ex, ey;
-  gfloat tx1, ty1, tx2, ty2;
-
-  /* apply opacity */
-  cogl_material_set_color4ub (material, opacity, opacity, opacity, opacity);
-
-  /* add the texture */
-  cogl_material_set_layer (material, 0, texture);
+  CoglHandle material;
+  CoglHandle texture;
+  guint8     opacity;
+  gfloat     top, right, bottom, left;
+  gfloat     width, height;
 
-  /* set the source */
-  cogl_set_source (material);
+  /* whether the whole texture is stretched over a single rectangle */
+  gboolean   simple;
+  float      rectangles[9 * 8];
+};
 
-  tex_width  = cogl_texture_get_width (texture);
-  tex_height = cogl_texture_get_height (texture);
+/*
+ * _mx_texture_frame_get_rectangles:
+ *
+ * Fills @rectangles, of 9 * 8 floats, with the positions and texture
+ * coordinates of the nine parts of the frame, as taken by
+ * cogl_rectangles_with_texture_coords(). Returns %FALSE if the texture is
+ * simply stretched, without borders.
+ */
+gboolean
+_mx_texture_frame_get_rectangles (CoglHandle  texture,
+                                  gfloat      top,
+                                  gfloat      right,
+                                  gfloat      bottom,
+                                  gfloat      left,
+                                  gfloat      width,
+                                  gfloat      height,
+                                  float      *rectangles)
+{
+  gfloat tex_width, tex_height, scale;
+  gfloat ex, ey;
+  gfloat tx1, ty1, tx2, ty2;
 
   /* simple stretch */
   if (left == 0 && right == 0 && top == 0
       && bottom == 0)
-    {
-      cogl_rectangle (0, 0, width, height);
-      return;
-    }
+    return FALSE;
+
+  /* the borders are given in pixels of the image, whatever the scale
+   * factor its texture was loaded at */
+  scale = _mx_texture_cache_get_texture_scale (texture);
+  tex_width  = cogl_texture_get_width (texture) / scale;
+  tex_height = cogl_texture_get_height (texture) / scale;
 
   tx1 = left / tex_width;
   tx2 = (tex_width - right) / tex_width;
@@ -90,7 +103,7 @@ mx_texture_frame_paint_texture_internal (CoglHandle  material,
 
 
   {
-    float rectangles[] =
+    float frame[] =
     {
       /* top left corner */
       0, 0,
@@ -147,8 +160,30 @@ mx_texture_frame_paint_texture_internal (CoglHandle  material,
       1.0, 1.0
     };
 
-    cogl_rectangles_with_texture_coords (rectangles, 9);
+    memcpy (rectangles, frame, sizeof (frame));
   }
+
+  return TRUE;
+}
+
+static CoglHandle
+mx_texture_frame_create_material (CoglHandle texture,
+                                  guint8     opacity)
+{
+  CoglHandle material;
+
+  /* setup the template material */
+  if (!template_material)
+    template_material = cogl_material_new ();
+
+  /* create the material and apply opacity */
+  material = cogl_material_copy (template_material);
+  cogl_material_set_color4ub (material, opacity, opacity, opacity, opacity);
+
+  /* add the texture */
+  cogl_material_set_layer (material, 0, texture);
+
+  return material;
 }
 
 void
@@ -162,19 +197,96 @@ mx_texture_frame_paint_texture (CoglHandle  texture,
                                 gfloat      height)
 {
   CoglHandle material;
+  float rectangles[9 * 8];
 
-  /* setup the template material */
-  if (!template_material)
-    template_material = cogl_material_new ();
+  material = mx_texture_frame_create_material (texture, opacity);
 
-  /* create the material and apply opacity */
-  material = cogl_material_copy (template_material);
+  /* set the source */
+  cogl_set_source (material);
 
-  mx_texture_frame_paint_texture_internal (material, texture,
-                                           opacity,
-                                           top, right,
-                                           bottom, left,
-                                           width, height);
+  if (_mx_texture_frame_get_rectangles (texture, top, right, bottom, left,
+                                        width, height, rectangles))
+    cogl_rectangles_with_texture_coords (rectangles, 9);
+  else
+    cogl_rectangle (0, 0, width, height);
 
   cogl_handle_unref (material);
 }
+
+/*
+ * _mx_texture_frame_paint_cached:
+ *
+ * Paints like mx_texture_frame_paint_texture(), keeping the material and
+ * the geometry of the frame in *@cache from one paint to the next. They
+ * are only rebuilt when the texture, opacity, borders or size change.
+ * The cache is created on first use and freed with
+ * _mx_texture_frame_cache_free().
+ */
+void
+_mx_texture_frame_paint_cached (MxTextureFrameCache **cache,
+                                CoglHandle            texture,
+                                guint8                opacity,
+                                gfloat                top,
+                                gfloat                right,
+                                gfloat                bottom,
+                                gfloat                left,
+                                gfloat                width,
+                                gfloat                height)
+{
+  MxTextureFrameCache *frame = *cache;
+
+  if (!frame)
+    frame = *cache = g_slice_new0 (MxTextureFrameCache);
+
+  /* the material keeps a reference on the texture, so a different
+   * texture can not be at the same address */
+  if (frame->texture != texture || frame->opacity != opacity ||
+      !frame->material)
+    {
+      if (frame->material)
+        cogl_handle_unref (frame->material);
+
+      frame->material = mx_texture_frame_create_material (texture, opacity);
+      frame->opacity = opacity;
+
+      /* force the geometry to be updated for the new texture size */
+      frame->width = -1;
+    }
+
+  if (frame->texture != texture ||
+      frame->top != top || frame->right != right ||
+      frame->bottom != bottom || frame->left != left ||
+      frame->width != width || frame->height != height)
+    {
+      frame->texture = texture;
+      frame->top = top;
+      frame->right = right;
+      frame->bottom = bottom;
+      frame->left = left;
+      frame->width = width;
+      frame->height = height;
+
+      frame->simple =
+        !_mx_texture_frame_get_rectangles (texture, top, right, bottom, left,
+                                           width, height, frame->rectangles);
+    }
+
+  cogl_set_source (frame->material);
+
+  if (frame->simple)
+    cogl_rectangle (0, 0, width, height);
+  else
+    cogl_rectangles_with_texture_coords (frame->rectangles, 9);
+}
+
+void
+_mx_texture_frame_cache_free (MxTextureFrameCache *cache)
+{
+  if (!cache)
+    return;
+
+  if (cache->material)
+    cogl_handle_unref (cache->material);
+
+  g_slice_free (MxTextureFrameCache, cache);
+}
@@ -0,0 +1,448 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-tile-cache.c: Offscreen tiles of the rendering of scrolled content
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include "mx-tile-cache.h"
+
+/* Tiles are rendered for the visible area, and at most this many a frame
+ * for the ring of tiles around it, so that they are ready by the time they
+ * are scrolled to. Tiles further away than MX_TILE_CACHE_KEEP from the
+ * visible area are dropped. */
+#define MX_TILE_CACHE_PREFETCH 1
+#define MX_TILE_CACHE_KEEP     2
+
+typedef struct
+{
+  gint64        key;
+
+  CoglHandle    texture;
+  CoglMaterial *material;
+} MxTileCacheTile;
+
+struct _MxTileCache
+{
+  ClutterActor         *content;
+  MxTileCachePaintFunc  paint_func;
+  gpointer              user_data;
+
+  /* MxTileCacheTile, by the key of their column and row */
+  GHashTable           *tiles;
+  CoglMaterial         *template;
+
+  /* the paint opacity the tiles were rendered with */
+  guint8                opacity;
+
+  ClutterActorBox       render_area;
+};
+
+/* The caches rendering a tile, innermost first */
+static GSList *rendering = NULL;
+
+/* All the caches, for accounting */
+static GSList *caches = NULL;
+
+static gint64
+mx_tile_cache_key (gint col,
+                   gint row)
+{
+  return ((gint64) col << 32) | (guint32) row;
+}
+
+static void
+mx_tile_cache_tile_free (MxTileCacheTile *tile)
+{
+  cogl_object_unref (tile->material);
+  cogl_handle_unref (tile->texture);
+  g_slice_free (MxTileCacheTile, tile);
+}
+
+MxTileCache *
+_mx_tile_cache_new (ClutterActor         *content,
+                    MxTileCachePaintFunc  paint_func,
+                    gpointer              user_data)
+{
+  MxTileCache *cache;
+
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (content), NULL);
+  g_return_val_if_fail (paint_func != NULL, NULL);
+
+  cache = g_slice_new0 (MxTileCache);
+  cache->content = content;
+  cache->paint_func = paint_func;
+  cache->user_data = user_data;
+  cache->tiles = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL,
+                                        (GDestroyNotify)
+                                        mx_tile_cache_tile_free);
+  cache->template = cogl_material_new ();
+  cache->opacity = 0xff;
+
+  caches = g_slist_prepend (caches, cache);
+
+  return cache;
+}
+
+void
+_mx_tile_cache_free (MxTileCache *cache)
+{
+  caches = g_slist_remove (caches, cache);
+
+  g_hash_table_destroy (cache->tiles);
+  cogl_object_unref (cache->template);
+  g_slice_free (MxTileCache, cache);
+}
+
+/* the tiles of all the caches, as RGBA textures */
+gsize
+_mx_tile_cache_get_memory_usage (void)
+{
+  gsize bytes = 0;
+  GSList *l;
+
+  for (l = caches; l; l = l->next)
+    bytes += (gsize) g_hash_table_size (((MxTileCache *) l->data)->tiles) *
+      MX_TILE_CACHE_TILE_SIZE * MX_TILE_CACHE_TILE_SIZE * 4;
+
+  return bytes;
+}
+
+/* Drops the tiles of all the caches, which are rendered again as they are
+ * painted */
+void
+_mx_tile_cache_trim_memory (MxMemoryTrimLevel level)
+{
+  GSList *l;
+
+  for (l = caches; l; l = l->next)
+    _mx_tile_cache_invalidate (l->data, NULL);
+}
+
+static void
+mx_tile_cache_get_range (const ClutterActorBox *area,
+                         gint                  *first_col,
+                         gint                  *first_row,
+                         gint                  *last_col,
+                         gint                  *last_row)
+{
+  *first_col = floorf (area->x1 / MX_TILE_CACHE_TILE_SIZE);
+  *first_row = floorf (area->y1 / MX_TILE_CACHE_TILE_SIZE);
+  *last_col = ceilf (area->x2 / MX_TILE_CACHE_TILE_SIZE);
+  *last_row = ceilf (area->y2 / MX_TILE_CACHE_TILE_SIZE);
+}
+
+/* Drops the tiles that reach into @area, or all of them when @area is
+ * %NULL, so that they are rendered again when next painted. */
+void
+_mx_tile_cache_invalidate (MxTileCache           *cache,
+                           const ClutterActorBox *area)
+{
+  gint first_col, first_row, last_col, last_row, col, row;
+
+  if (!area)
+    {
+      g_hash_table_remove_all (cache->tiles);
+      return;
+    }
+
+  if (area->x2 <= area->x1 || area->y2 <= area->y1)
+    return;
+
+  mx_tile_cache_get_range (area, &first_col, &first_row, &last_col, &last_row);
+
+  /* a large area is faster to check tile by tile */
+  if ((gint64) (last_col - first_col) * (last_row - first_row) >
+      g_hash_table_size (cache->tiles))
+    {
+      GHashTableIter iter;
+      MxTileCacheTile *tile;
+
+      g_hash_table_iter_init (&iter, cache->tiles);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &tile))
+        {
+          col = tile->key >> 32;
+          row = (gint32) (tile->key & G_MAXUINT32);
+
+          if (col >= first_col && col < last_col &&
+              row >= first_row && row < last_row)
+            g_hash_table_iter_remove (&iter);
+        }
+
+      return;
+    }
+
+  for (row = first_row; row < last_row; row++)
+    for (col = first_col; col < last_col; col++)
+      {
+        gint64 key = mx_tile_cache_key (col, row);
+
+        g_hash_table_remove (cache->tiles, &key);
+      }
+}
+
+/* Drops the tiles covered by the paint volume of @leaf, when it is a
+ * descendant of the content actor of @cache. This is meant to be called
+ * from the queue_redraw implementation of the container, with the actor
+ * that queued the redraw. */
+void
+_mx_tile_cache_invalidate_actor (MxTileCache  *cache,
+                                 ClutterActor *leaf)
+{
+  ClutterActorBox area = { G_MAXFLOAT, G_MAXFLOAT, -G_MAXFLOAT, -G_MAXFLOAT };
+  const ClutterPaintVolume *volume;
+  ClutterVertex origin;
+  gfloat width, height;
+  gint i;
+
+  if (!g_hash_table_size (cache->tiles) || !leaf || leaf == cache->content ||
+      !clutter_actor_contains (cache->content, leaf))
+    return;
+
+  volume = clutter_actor_get_paint_volume (leaf);
+  if (!volume)
+    {
+      _mx_tile_cache_invalidate (cache, NULL);
+      return;
+    }
+
+  clutter_paint_volume_get_origin (volume, &origin);
+  width = clutter_paint_volume_get_width (volume);
+  height = clutter_paint_volume_get_height (volume);
+
+  for (i = 0; i < 4; i++)
+    {
+      ClutterVertex point = { origin.x + ((i & 1) ? width : 0),
+                              origin.y + ((i & 2) ? height : 0),
+                              origin.z };
+      ClutterVertex mapped;
+
+      clutter_actor_apply_relative_transform_to_point (leaf, cache->content,
+                                                       &point, &mapped);
+
+      area.x1 = MIN (area.x1, mapped.x);
+      area.y1 = MIN (area.y1, mapped.y);
+      area.x2 = MAX (area.x2, mapped.x);
+      area.y2 = MAX (area.y2, mapped.y);
+    }
+
+  _mx_tile_cache_invalidate (cache, &area);
+}
+
+static MxTileCacheTile *
+mx_tile_cache_render_tile (MxTileCache *cache,
+                           gint         col,
+                           gint         row)
+{
+  MxTileCacheTile *tile;
+  CoglHandle texture, offscreen;
+  CoglColor transparent;
+  CoglMatrix matrix;
+  ClutterActorBox area;
+
+  texture = cogl_texture_new_with_size (MX_TILE_CACHE_TILE_SIZE,
+                                        MX_TILE_CACHE_TILE_SIZE,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  if (texture == COGL_INVALID_HANDLE)
+    return NULL;
+
+  offscreen = cogl_offscreen_new_to_texture (texture);
+  if (offscreen == COGL_INVALID_HANDLE)
+    {
+      cogl_handle_unref (texture);
+      return NULL;
+    }
+
+  area.x1 = col * MX_TILE_CACHE_TILE_SIZE;
+  area.y1 = row * MX_TILE_CACHE_TILE_SIZE;
+  area.x2 = area.x1 + MX_TILE_CACHE_TILE_SIZE;
+  area.y2 = area.y1 + MX_TILE_CACHE_TILE_SIZE;
+
+  /* Push the off-screen buffer and set up an orthographic projection in
+   * which the content of the tile fills it */
+  cogl_push_framebuffer (offscreen);
+  cogl_ortho (0, MX_TILE_CACHE_TILE_SIZE, MX_TILE_CACHE_TILE_SIZE, 0, -1, 1);
+
+  cogl_matrix_init_identity (&matrix);
+  cogl_matrix_translate (&matrix, -area.x1, -area.y1, 0);
+  cogl_set_modelview_matrix (&matrix);
+
+  cogl_color_set_from_4ub (&transparent, 0, 0, 0, 0);
+  cogl_clear (&transparent, COGL_BUFFER_BIT_COLOR);
+
+  cache->render_area = area;
+  rendering = g_slist_prepend (rendering, cache);
+
+  cache->paint_func (&area, cache->user_data);
+
+  rendering = g_slist_delete_link (rendering, rendering);
+
+  cogl_pop_framebuffer ();
+  cogl_handle_unref (offscreen);
+
+  tile = g_slice_new (MxTileCacheTile);
+  tile->key = mx_tile_cache_key (col, row);
+  tile->texture = texture;
+  tile->material = cogl_material_copy (cache->template);
+  cogl_material_set_layer (tile->material, 0, texture);
+
+  g_hash_table_insert (cache->tiles, &tile->key, tile);
+
+  return tile;
+}
+
+static gboolean
+mx_tile_cache_remove_far (gpointer key,
+                          gpointer value,
+                          gpointer user_data)
+{
+  MxTileCacheTile *tile = value;
+  gint *range = user_data;
+  gint col, row;
+
+  col = tile->key >> 32;
+  row = (gint32) (tile->key & G_MAXUINT32);
+
+  return (col < range[0] || row < range[1] ||
+          col >= range[2] || row >= range[3]);
+}
+
+/* Paints @area of the content from the tiles of @cache, in the coordinates
+ * of the content, rendering the tiles that are missing. The tiles are
+ * dropped when @opacity changes, as they are rendered with it. Returns
+ * %FALSE if the tiles could not be rendered, in which case nothing was
+ * painted and the content should be painted directly. */
+gboolean
+_mx_tile_cache_paint (MxTileCache           *cache,
+                      const ClutterActorBox *area,
+                      guint8                 opacity)
+{
+  gint first_col, first_row, last_col, last_row, col, row, range[4];
+  guint prefetched;
+  gint64 key;
+
+  if (!clutter_feature_available (CLUTTER_FEATURE_OFFSCREEN) ||
+      g_slist_find (rendering, cache))
+    return FALSE;
+
+  if (area->x2 <= area->x1 || area->y2 <= area->y1)
+    return TRUE;
+
+  if (opacity != cache->opacity)
+    {
+      _mx_tile_cache_invalidate (cache, NULL);
+      cache->opacity = opacity;
+    }
+
+  mx_tile_cache_get_range (area, &first_col, &first_row, &last_col, &last_row);
+
+  /* render all the visible tiles before painting any, so that nothing has
+   * been painted when one can't be */
+  for (row = first_row; row < last_row; row++)
+    for (col = first_col; col < last_col; col++)
+      {
+        key = mx_tile_cache_key (col, row);
+
+        if (!g_hash_table_lookup (cache->tiles, &key) &&
+            !mx_tile_cache_render_tile (cache, col, row))
+          return FALSE;
+      }
+
+  for (row = first_row; row < last_row; row++)
+    for (col = first_col; col < last_col; col++)
+      {
+        MxTileCacheTile *tile;
+        gfloat x, y;
+
+        key = mx_tile_cache_key (col, row);
+        tile = g_hash_table_lookup (cache->tiles, &key);
+
+        x = col * MX_TILE_CACHE_TILE_SIZE;
+        y = row * MX_TILE_CACHE_TILE_SIZE;
+
+        cogl_set_source (tile->material);
+        cogl_rectangle (x, y,
+                        x + MX_TILE_CACHE_TILE_SIZE,
+                        y + MX_TILE_CACHE_TILE_SIZE);
+      }
+
+  /* get the ring around the visible tiles ready */
+  prefetched = 0;
+  for (row = first_row - 1; row <= last_row; row++)
+    for (col = first_col - 1; col <= last_col; col++)
+      {
+        if (prefetched >= MX_TILE_CACHE_PREFETCH)
+          break;
+
+        if (row >= first_row && row < last_row &&
+            col >= first_col && col < last_col)
+          continue;
+
+        key = mx_tile_cache_key (col, row);
+        if (!g_hash_table_lookup (cache->tiles, &key))
+          {
+            mx_tile_cache_render_tile (cache, col, row);
+            prefetched++;
+          }
+      }
+
+  range[0] = first_col - MX_TILE_CACHE_KEEP;
+  range[1] = first_row - MX_TILE_CACHE_KEEP;
+  range[2] = last_col + MX_TILE_CACHE_KEEP;
+  range[3] = last_row + MX_TILE_CACHE_KEEP;
+  g_hash_table_foreach_remove (cache->tiles, mx_tile_cache_remove_far, range);
+
+  return TRUE;
+}
+
+/* Whether a tile is being rendered. Containers that only paint the
+ * children they find visible on the stage should paint all of them then,
+ * as the tile is not where the container is on the stage. */
+gboolean
+_mx_tile_cache_is_rendering (void)
+{
+  return rendering != NULL;
+}
+
+/* Retrieves the area of the tile being rendered, when it is one of a cache
+ * of the content of @content. Scrollable containers can then paint the
+ * children in @area rather than those in the area they show. */
+gboolean
+_mx_tile_cache_get_render_area (ClutterActor    *content,
+                                ClutterActorBox *area)
+{
+  MxTileCache *cache;
+
+  if (!rendering)
+    return FALSE;
+
+  cache = rendering->data;
+  if (cache->content != content)
+    return FALSE;
+
+  *area = cache->render_area;
+
+  return TRUE;
+}
@@ -0,0 +1,72 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-tile-cache.h: Offscreen tiles of the rendering of scrolled content
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _MX_TILE_CACHE_H
+#define _MX_TILE_CACHE_H
+
+#include <clutter/clutter.h>
+#include "mx-memory.h"
+
+G_BEGIN_DECLS
+
+/*
+ * An MxTileCache keeps the rendering of the content of a scrolling
+ * container in textures of MX_TILE_CACHE_TILE_SIZE pixels, so that moving
+ * the content is a matter of drawing those at a new offset rather than
+ * painting it again.
+ *
+ * The content is in the coordinates of a "content" actor: those its
+ * children are allocated in. Painting the content is left to a function,
+ * which is called with the modelview matrix set up so that the content
+ * should be painted in those coordinates.
+ */
+
+#define MX_TILE_CACHE_TILE_SIZE 256
+
+typedef struct _MxTileCache MxTileCache;
+
+typedef void (* MxTileCachePaintFunc) (const ClutterActorBox *area,
+                                       gpointer               user_data);
+
+MxTileCache *_mx_tile_cache_new             (ClutterActor          *content,
+                                             MxTileCachePaintFunc   paint_func,
+                                             gpointer               user_data);
+void         _mx_tile_cache_free            (MxTileCache           *cache);
+
+void         _mx_tile_cache_invalidate      (MxTileCache           *cache,
+                                             const ClutterActorBox *area);
+void         _mx_tile_cache_invalidate_actor (MxTileCache          *cache,
+                                              ClutterActor         *leaf);
+
+gboolean     _mx_tile_cache_paint           (MxTileCache           *cache,
+                                             const ClutterActorBox *area,
+                                             guint8                 opacity);
+
+gboolean     _mx_tile_cache_is_rendering     (void);
+gsize        _mx_tile_cache_get_memory_usage (void);
+void         _mx_tile_cache_trim_memory      (MxMemoryTrimLevel     level);
+gboolean     _mx_tile_cache_get_render_area  (ClutterActor         *content,
+                                              ClutterActorBox      *area);
+
+G_END_DECLS
+
+#endif /* _MX_TILE_CACHE_H */
@@ -0,0 +1,251 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-timer-wheel.c: Cheap one-shot timers for widget interactions
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mx-timer-wheel.h"
+
+/* Each slot holds the timers due within a tick of a given time, modulo
+ * the span of the wheel; timers further away than that share the slots
+ * and are skipped until their turn comes round */
+#define TICK_MS 16
+#define N_SLOTS 64
+
+typedef struct
+{
+  GSource  source;
+
+  GQueue   slots[N_SLOTS];
+  guint    n_timers;
+
+  /* no timer is due before this, though restarted timers may have left
+   * it earlier than the first one actually due */
+  gint64   next_deadline;
+  /* the tick the slots were last visited up to */
+  gint64   last_tick;
+} MxTimerWheel;
+
+static MxTimerWheel *timer_wheel = NULL;
+
+static gint64
+mx_timer_wheel_now (void)
+{
+  return g_get_monotonic_time () / 1000;
+}
+
+static void
+mx_timer_wheel_update_next_deadline (MxTimerWheel *wheel)
+{
+  gint i;
+
+  wheel->next_deadline = G_MAXINT64;
+
+  if (!wheel->n_timers)
+    return;
+
+  for (i = 0; i < N_SLOTS; i++)
+    {
+      GList *l;
+
+      for (l = wheel->slots[i].head; l; l = l->next)
+        {
+          MxTimer *timer = l->data;
+
+          if (timer->deadline < wheel->next_deadline)
+            wheel->next_deadline = timer->deadline;
+        }
+    }
+}
+
+static gboolean
+mx_timer_wheel_prepare (GSource *source,
+                        gint    *timeout)
+{
+  MxTimerWheel *wheel = (MxTimerWheel *) source;
+  gint64 now;
+
+  if (!wheel->n_timers)
+    {
+      *timeout = -1;
+      return FALSE;
+    }
+
+  now = mx_timer_wheel_now ();
+  if (wheel->next_deadline <= now)
+    {
+      *timeout = 0;
+      return TRUE;
+    }
+
+  *timeout = MIN (wheel->next_deadline - now, G_MAXINT);
+
+  return FALSE;
+}
+
+static gboolean
+mx_timer_wheel_check (GSource *source)
+{
+  MxTimerWheel *wheel = (MxTimerWheel *) source;
+
+  return wheel->n_timers && wheel->next_deadline <= mx_timer_wheel_now ();
+}
+
+static gboolean
+mx_timer_wheel_dispatch (GSource     *source,
+                         GSourceFunc  callback,
+                         gpointer     user_data)
+{
+  MxTimerWheel *wheel = (MxTimerWheel *) source;
+  GQueue firing = G_QUEUE_INIT;
+  gint64 now, tick, last_tick;
+  GList *l;
+
+  now = mx_timer_wheel_now ();
+  last_tick = now / TICK_MS;
+
+  /* the slot of the last visit is visited again, as timers due later in
+   * that tick may have been added since */
+  tick = MAX (wheel->last_tick, last_tick - N_SLOTS + 1);
+  for (; tick <= last_tick; tick++)
+    {
+      GQueue *slot = &wheel->slots[tick & (N_SLOTS - 1)];
+      GList *next;
+
+      for (l = slot->head; l; l = next)
+        {
+          MxTimer *timer = l->data;
+
+          next = l->next;
+
+          if (timer->deadline > now)
+            continue;
+
+          g_queue_unlink (slot, l);
+          g_queue_push_tail_link (&firing, l);
+          timer->queue = &firing;
+        }
+    }
+
+  wheel->last_tick = last_tick;
+
+  /* callbacks may stop or restart any timer, including the ones about to
+   * fire */
+  while ((l = g_queue_pop_head_link (&firing)))
+    {
+      MxTimer *timer = l->data;
+
+      timer->queue = NULL;
+      wheel->n_timers--;
+
+      timer->func (timer->data);
+    }
+
+  mx_timer_wheel_update_next_deadline (wheel);
+
+  return TRUE;
+}
+
+static GSourceFuncs mx_timer_wheel_funcs =
+{
+  mx_timer_wheel_prepare,
+  mx_timer_wheel_check,
+  mx_timer_wheel_dispatch,
+  NULL
+};
+
+static MxTimerWheel *
+mx_timer_wheel_get (void)
+{
+  if (G_UNLIKELY (!timer_wheel))
+    {
+      GSource *source;
+      gint i;
+
+      source = g_source_new (&mx_timer_wheel_funcs, sizeof (MxTimerWheel));
+      g_source_set_name (source, "MxTimerWheel");
+
+      timer_wheel = (MxTimerWheel *) source;
+      for (i = 0; i < N_SLOTS; i++)
+        g_queue_init (&timer_wheel->slots[i]);
+      timer_wheel->next_deadline = G_MAXINT64;
+      timer_wheel->last_tick = mx_timer_wheel_now () / TICK_MS;
+
+      g_source_attach (source, NULL);
+    }
+
+  return timer_wheel;
+}
+
+void
+_mx_timer_init (MxTimer     *timer,
+                MxTimerFunc  func,
+                gpointer     data)
+{
+  timer->link.data = timer;
+  timer->link.prev = timer->link.next = NULL;
+  timer->queue = NULL;
+  timer->deadline = 0;
+
+  timer->func = func;
+  timer->data = data;
+}
+
+/* Starts @timer to fire once in @interval milliseconds, replacing the
+ * time it was due at if it was already running */
+void
+_mx_timer_start (MxTimer *timer,
+                 guint    interval)
+{
+  MxTimerWheel *wheel = mx_timer_wheel_get ();
+  GQueue *slot;
+
+  _mx_timer_stop (timer);
+
+  timer->deadline = mx_timer_wheel_now () + interval;
+
+  slot = &wheel->slots[(timer->deadline / TICK_MS) & (N_SLOTS - 1)];
+  g_queue_push_tail_link (slot, &timer->link);
+  timer->queue = slot;
+  wheel->n_timers++;
+
+  if (timer->deadline < wheel->next_deadline)
+    wheel->next_deadline = timer->deadline;
+}
+
+void
+_mx_timer_stop (MxTimer *timer)
+{
+  if (!timer->queue)
+    return;
+
+  g_queue_unlink (timer->queue, &timer->link);
+  timer->queue = NULL;
+  timer_wheel->n_timers--;
+}
+
+gboolean
+_mx_timer_is_active (MxTimer *timer)
+{
+  return timer->queue != NULL;
+}
@@ -0,0 +1,64 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-timer-wheel.h: Cheap one-shot timers for widget interactions
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _MX_TIMER_WHEEL_H
+#define _MX_TIMER_WHEEL_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * An MxTimer is a one-shot timeout that is restarted far more often than
+ * it fires, like the delay before a tooltip shows, which starts over on
+ * every motion event. Rather than a GSource each, the timers are filed
+ * in the slots of a hashed timer wheel, driven by a single GSource, so
+ * that starting, restarting and stopping one only moves it between lists.
+ *
+ * Timers are embedded in the structure they belong to, and must be
+ * stopped before it is freed. They are only used from the main thread.
+ */
+
+typedef void (* MxTimerFunc) (gpointer data);
+
+typedef struct
+{
+  /*< private >*/
+  GList        link;
+  GQueue      *queue;
+  gint64       deadline;
+
+  MxTimerFunc  func;
+  gpointer     data;
+} MxTimer;
+
+void     _mx_timer_init      (MxTimer     *timer,
+                              MxTimerFunc  func,
+                              gpointer     data);
+void     _mx_timer_start     (MxTimer     *timer,
+                              guint        interval);
+void     _mx_timer_stop      (MxTimer     *timer);
+gboolean _mx_timer_is_active (MxTimer     *timer);
+
+G_END_DECLS
+
+#endif /* _MX_TIMER_WHEEL_H */
@@ -282,6 +282,18 @@ mx_toggle_paint (ClutterActor *actor)
 }
 
 
+/* The handle is allocated at the inactive end of the toggle and moved by its
+ * translation, so that animating or dragging it only needs a redraw */
+static void
+mx_toggle_update_handle_translation (MxToggle *toggle)
+{
+  MxTogglePrivate *priv = toggle->priv;
+
+  clutter_actor_set_translation (priv->handle,
+                                 (gint) (priv->slide_length * priv->position),
+                                 0, 0);
+}
+
 static void
 mx_toggle_allocate (ClutterActor          *actor,
                     const ClutterActorBox *box,
@@ -319,14 +331,14 @@ mx_toggle_allocate (ClutterActor          *actor,
   toggle_pos = child_box.x2 - handle_w - child_box.x1;
   priv->slide_length = toggle_pos;
 
-  toggle_pos = toggle_pos * priv->position;
-
-  handle_box.x1 = (gint) (child_box.x1 + toggle_pos);
+  handle_box.x1 = (gint) child_box.x1;
   handle_box.y1 = child_box.y1;
   handle_box.x2 = handle_box.x1 + handle_w;
   handle_box.y2 = child_box.y2;
 
   clutter_actor_allocate (priv->handle, &handle_box, flags);
+
+  mx_toggle_update_handle_translation (MX_TOGGLE (actor));
 }
 
 static gboolean
@@ -428,7 +440,7 @@ mx_toggle_handle_motion_event (ClutterActor       *actor,
       else
         priv->position = 0;
 
-      clutter_actor_queue_relayout (actor);
+      mx_toggle_update_handle_translation (toggle);
     }
 
   return TRUE;
@@ -517,7 +529,7 @@ mx_toggle_update_position (ClutterTimeline *timeline,
 
   priv->position = clutter_timeline_get_progress (priv->timeline);
 
-  clutter_actor_queue_relayout (CLUTTER_ACTOR (toggle));
+  mx_toggle_update_handle_translation (toggle);
 }
 
 static void
@@ -581,6 +593,7 @@ mx_toggle_set_active (MxToggle *toggle,
       if (!CLUTTER_ACTOR_IS_MAPPED (CLUTTER_ACTOR (toggle)))
         {
           priv->position = (active) ? 1 : 0;
+          mx_toggle_update_handle_translation (toggle);
           return;
         }
 
@@ -77,6 +77,7 @@ struct _MxTooltipPrivate
   MxBorderImage   *border_image;
   ClutterActorBox  text_allocation;
   CoglHandle       border_image_texture;
+  MxTextureFrameCache *border_image_cache;
 };
 
 /* Time in milliseconds after a tooltip is hidden before disabling
@@ -402,7 +403,8 @@ mx_tooltip_paint (ClutterActor *self)
                   0);
 
   if (priv->border_image_texture)
-    mx_texture_frame_paint_texture (priv->border_image_texture,
+    _mx_texture_frame_paint_cached (&priv->border_image_cache,
+                                    priv->border_image_texture,
                                     alpha,
                                     priv->border_image->top,
                                     priv->border_image->right,
@@ -441,6 +443,9 @@ mx_tooltip_dispose (GObject *object)
       priv->border_image_texture = NULL;
     }
 
+  _mx_texture_frame_cache_free (priv->border_image_cache);
+  priv->border_image_cache = NULL;
+
   G_OBJECT_CLASS (mx_tooltip_parent_class)->dispose (object);
 }
 
@@ -724,6 +729,11 @@ mx_tooltip_set_opacity (MxTooltip *tooltip,
   clutter_actor_restore_easing_state (self);
 }
 
+static void mx_tooltip_hide_complete (ClutterActor *actor,
+                                      gchar        *name,
+                                      gboolean      is_finished,
+                                      gpointer      user_data);
+
 /**
  * mx_tooltip_show:
  * @tooltip: a #MxTooltip
@@ -733,6 +743,11 @@ mx_tooltip_set_opacity (MxTooltip *tooltip,
 void
 mx_tooltip_show (MxTooltip *tooltip)
 {
+  /* a tooltip shown again while fading out, such as the tooltip a stage
+   * shares between widgets, must not be hidden when the fade stops */
+  g_signal_handlers_disconnect_by_func (tooltip, mx_tooltip_hide_complete,
+                                        NULL);
+
   mx_tooltip_update_position (tooltip);
 
   /* finally show the tooltip... */
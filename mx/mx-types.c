@@ -28,6 +28,48 @@
 #include <string.h>
 #include "mx-private.h"
 
+/* The border-image and padding values of style sheets are interned, so
+ * that identical declarations share one instance. Interned instances are
+ * never freed nor modified: copying one returns it as is, and two of them
+ * are equal only if they are the same pointer. */
+static GHashTable *interned_values = NULL;
+static GHashTable *interned_border_images = NULL;
+static GHashTable *interned_paddings = NULL;
+
+gboolean
+_mx_value_is_interned (gconstpointer value)
+{
+  return interned_values && g_hash_table_contains (interned_values, value);
+}
+
+static gpointer
+mx_value_intern (GHashTable    **table,
+                 GHashFunc       hash_func,
+                 GEqualFunc      equal_func,
+                 gconstpointer   value,
+                 gpointer      (*dup_func) (gconstpointer))
+{
+  gpointer interned;
+
+  if (!value || _mx_value_is_interned (value))
+    return (gpointer) value;
+
+  if (G_UNLIKELY (!*table))
+    *table = g_hash_table_new (hash_func, equal_func);
+  if (G_UNLIKELY (!interned_values))
+    interned_values = g_hash_table_new (NULL, NULL);
+
+  interned = g_hash_table_lookup (*table, value);
+  if (!interned)
+    {
+      interned = dup_func (value);
+      g_hash_table_add (*table, interned);
+      g_hash_table_add (interned_values, interned);
+    }
+
+  return interned;
+}
+
 void
 mx_font_weight_set_from_string (GValue      *dest,
                                 const gchar *src)
@@ -53,13 +95,16 @@ mx_font_weight_set_from_string (GValue      *dest,
 static gpointer
 mx_padding_copy (gpointer data)
 {
+  if (_mx_value_is_interned (data))
+    return data;
+
   return g_slice_dup (MxPadding, data);
 }
 
 static void
 mx_padding_free (gpointer data)
 {
-  if (G_LIKELY (data))
+  if (G_LIKELY (data) && !_mx_value_is_interned (data))
     g_slice_free (MxPadding, data);
 }
 
@@ -114,6 +159,39 @@ mx_padding_from_string (const GValue *src,
   g_value_set_boxed (dest, &padding);
 }
 
+static guint
+mx_padding_hash (gconstpointer data)
+{
+  const MxPadding *padding = data;
+
+  return ((guint) padding->top * 31 + (guint) padding->right) * 31 +
+    ((guint) padding->bottom * 31 + (guint) padding->left);
+}
+
+static gboolean
+mx_padding_content_equal (gconstpointer a,
+                          gconstpointer b)
+{
+  const MxPadding *p1 = a, *p2 = b;
+
+  return p1->top == p2->top && p1->right == p2->right &&
+    p1->bottom == p2->bottom && p1->left == p2->left;
+}
+
+static gpointer
+mx_padding_dup (gconstpointer data)
+{
+  return g_slice_dup (MxPadding, data);
+}
+
+/* returns the shared instance of @padding, which must not be modified */
+MxPadding *
+_mx_padding_intern (const MxPadding *padding)
+{
+  return mx_value_intern (&interned_paddings, mx_padding_hash,
+                          mx_padding_content_equal, padding, mx_padding_dup);
+}
+
 GType
 mx_padding_get_type (void)
 {
@@ -142,6 +220,10 @@ mx_border_image_equal (MxBorderImage *b1, MxBorderImage *b2)
   if (!b2 && b1)
     return FALSE;
 
+  /* interned instances are shared by all equal values */
+  if (_mx_value_is_interned (b1) && _mx_value_is_interned (b2))
+    return FALSE;
+
   if (g_strcmp0 (b1->uri, b2->uri))
     return FALSE;
 
@@ -168,6 +250,9 @@ mx_border_image_copy (const MxBorderImage *border_image)
 
   g_return_val_if_fail (border_image != NULL, NULL);
 
+  if (_mx_value_is_interned (border_image))
+    return (MxBorderImage *) border_image;
+
   copy = g_slice_new0 (MxBorderImage);
   *copy = *border_image;
   copy->uri = g_strdup (border_image->uri);
@@ -178,7 +263,7 @@ mx_border_image_copy (const MxBorderImage *border_image)
 static void
 mx_border_image_free (MxBorderImage *border_image)
 {
-  if (G_LIKELY (border_image))
+  if (G_LIKELY (border_image) && !_mx_value_is_interned (border_image))
     {
       g_free (border_image->uri);
       border_image->uri = NULL;
@@ -186,6 +271,49 @@ mx_border_image_free (MxBorderImage *border_image)
     }
 }
 
+static guint
+mx_border_image_hash (gconstpointer data)
+{
+  const MxBorderImage *border_image = data;
+
+  return (border_image->uri ? g_str_hash (border_image->uri) : 0) ^
+    (((border_image->top * 31 + border_image->right) * 31 +
+      border_image->bottom) * 31 + border_image->left);
+}
+
+static gboolean
+mx_border_image_content_equal (gconstpointer a,
+                               gconstpointer b)
+{
+  const MxBorderImage *b1 = a, *b2 = b;
+
+  return !g_strcmp0 (b1->uri, b2->uri) &&
+    b1->top == b2->top && b1->right == b2->right &&
+    b1->bottom == b2->bottom && b1->left == b2->left;
+}
+
+static gpointer
+mx_border_image_dup (gconstpointer data)
+{
+  const MxBorderImage *border_image = data;
+  MxBorderImage *copy;
+
+  copy = g_slice_dup (MxBorderImage, border_image);
+  copy->uri = g_strdup (border_image->uri);
+
+  return copy;
+}
+
+/* returns the shared instance of @border_image, which must not be
+ * modified */
+MxBorderImage *
+_mx_border_image_intern (const MxBorderImage *border_image)
+{
+  return mx_value_intern (&interned_border_images, mx_border_image_hash,
+                          mx_border_image_content_equal, border_image,
+                          mx_border_image_dup);
+}
+
 void
 mx_border_image_set_from_string (GValue *dest,
                                  const gchar *str,
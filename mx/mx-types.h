@@ -58,6 +58,10 @@ GType mx_border_image_get_type (void) G_GNUC_CONST;
  * @right: right border slice width
  * @bottom: bottom border slice width
  * @left: bottom border slice width
+ *
+ * The values of border-image and background-image read from a style are
+ * shared between all the stylables with the same declaration, and must not
+ * be modified.
  */
 struct _MxBorderImage
 {
@@ -86,6 +90,9 @@ void mx_font_weight_set_from_string (GValue *value, const gchar *str);
  * @left: padding from the left
  *
  * The padding from the internal border of the parent container.
+ *
+ * As with #MxBorderImage, padding values read from a style are shared and
+ * must not be modified.
  */
 struct _MxPadding
 {
@@ -172,6 +172,59 @@ mx_allocate_align_fill (ClutterActor    *child,
                         MxAlign          y_alignment,
                         gboolean         x_fill,
                         gboolean         y_fill)
+{
+  _mx_allocate_align_fill_measured (child, childbox, x_alignment,
+                                    y_alignment, x_fill, y_fill, NULL);
+}
+
+static void
+mx_measured_size_get_width (ClutterActor         *child,
+                            const MxMeasuredSize *measured,
+                            gfloat                for_height,
+                            gfloat               *min_width,
+                            gfloat               *natural_width)
+{
+  if (measured && measured->has_width &&
+      measured->width_for_height == for_height)
+    {
+      *min_width = measured->min_width;
+      *natural_width = measured->natural_width;
+    }
+  else
+    clutter_actor_get_preferred_width (child, for_height,
+                                       min_width, natural_width);
+}
+
+static void
+mx_measured_size_get_height (ClutterActor         *child,
+                             const MxMeasuredSize *measured,
+                             gfloat                for_width,
+                             gfloat               *min_height,
+                             gfloat               *natural_height)
+{
+  if (measured && measured->has_height &&
+      measured->height_for_width == for_width)
+    {
+      *min_height = measured->min_height;
+      *natural_height = measured->natural_height;
+    }
+  else
+    clutter_actor_get_preferred_height (child, for_width,
+                                        min_height, natural_height);
+}
+
+/* As mx_allocate_align_fill(), for containers that already asked @child
+ * for a size while laying it out: when the sizes the alignment needs are
+ * for the same width or height as the ones in @measured, they are used
+ * rather than asked for again. */
+void
+_mx_allocate_align_fill_measured (ClutterActor         *child,
+                                  ClutterActorBox      *childbox,
+                                  MxAlign               x_alignment,
+                                  MxAlign               y_alignment,
+                                  gboolean              x_fill,
+                                  gboolean              y_fill,
+                                  const MxMeasuredSize *measured)
 {
   gfloat natural_width, natural_height;
   gfloat min_width, min_height;
@@ -228,34 +281,30 @@ mx_allocate_align_fill (ClutterActor    *child,
 
   if (request == CLUTTER_REQUEST_HEIGHT_FOR_WIDTH)
     {
-      clutter_actor_get_preferred_width (child, available_height,
-                                         &min_width,
-                                         &natural_width);
+      mx_measured_size_get_width (child, measured, available_height,
+                                  &min_width, &natural_width);
 
       child_width = CLAMP (natural_width, min_width, available_width);
 
       if (!y_fill)
         {
-          clutter_actor_get_preferred_height (child, child_width,
-                                              &min_height,
-                                              &natural_height);
+          mx_measured_size_get_height (child, measured, child_width,
+                                       &min_height, &natural_height);
 
           child_height = CLAMP (natural_height, min_height, available_height);
         }
     }
   else
     {
-      clutter_actor_get_preferred_height (child, available_width,
-                                          &min_height,
-                                          &natural_height);
+      mx_measured_size_get_height (child, measured, available_width,
+                                   &min_height, &natural_height);
 
       child_height = CLAMP (natural_height, min_height, available_height);
 
       if (!x_fill)
         {
-          clutter_actor_get_preferred_width (child, child_height,
-                                             &min_width,
-                                             &natural_width);
+          mx_measured_size_get_width (child, measured, child_height,
+                                      &min_width, &natural_width);
 
           child_width = CLAMP (natural_width, min_width, available_width);
         }
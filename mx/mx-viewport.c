@@ -46,7 +46,9 @@
  * Do not use #MxViewport if you need good performance as it does can not
  * be selective about the area of its child that is painted/picked. Therefore
  * if the child is very large or contains a lot of children, you will experience
- * poor performance.
+ * poor performance. For a child that seldom changes, setting
+ * #MxViewport:use-tile-cache lets scrolling draw back the rendering of the
+ * child rather than painting it again.
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -59,6 +61,7 @@
 #include "mx-adjustment.h"
 #include "mx-scrollable.h"
 #include "mx-private.h"
+#include "mx-tile-cache.h"
 
 static void scrollable_interface_init (MxScrollableIface *iface);
 
@@ -88,8 +91,12 @@ struct _MxViewportPrivate
   MxAdjustment *vadjustment;
 
   gboolean      sync_adjustments;
+  gboolean      use_tile_cache;
 
   ClutterActor *child;
+
+  /* the rendering of the child, with use-tile-cache */
+  MxTileCache  *tile_cache;
 };
 
 enum
@@ -101,7 +108,8 @@ enum
   PROP_Z_ORIGIN,
   PROP_HADJUST,
   PROP_VADJUST,
-  PROP_SYNC_ADJUST
+  PROP_SYNC_ADJUST,
+  PROP_USE_TILE_CACHE
 };
 
 static void
@@ -142,6 +150,10 @@ mx_viewport_get_property (GObject    *object,
       g_value_set_boolean (value, priv->sync_adjustments);
       break;
 
+    case PROP_USE_TILE_CACHE:
+      g_value_set_boolean (value, priv->use_tile_cache);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -196,17 +208,35 @@ mx_viewport_set_property (GObject      *object,
       mx_viewport_set_sync_adjustments (viewport, g_value_get_boolean (value));
       break;
 
+    case PROP_USE_TILE_CACHE:
+      mx_viewport_set_use_tile_cache (viewport, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
     }
 }
 
+static void
+mx_viewport_drop_tile_cache (MxViewport *viewport)
+{
+  MxViewportPrivate *priv = viewport->priv;
+
+  if (priv->tile_cache)
+    {
+      _mx_tile_cache_free (priv->tile_cache);
+      priv->tile_cache = NULL;
+    }
+}
+
 static void
 mx_viewport_dispose (GObject *gobject)
 {
   MxViewportPrivate *priv = MX_VIEWPORT (gobject)->priv;
 
+  mx_viewport_drop_tile_cache (MX_VIEWPORT (gobject));
+
   if (priv->hadjustment)
     {
       g_object_unref (priv->hadjustment);
@@ -324,6 +354,50 @@ mx_viewport_apply_transform (ClutterActor *actor,
   cogl_matrix_translate (matrix, (int) -x, (int) -y, 0);
 }
 
+static void
+mx_viewport_paint_tile (const ClutterActorBox *area,
+                        gpointer               user_data)
+{
+  MxViewportPrivate *priv = MX_VIEWPORT (user_data)->priv;
+
+  clutter_actor_paint (priv->child);
+}
+
+/* Paints the child from the tiles of its rendering, which are in the
+ * coordinates of the viewport, as is the child */
+static gboolean
+mx_viewport_paint_tiles (MxViewport *viewport)
+{
+  MxViewportPrivate *priv = viewport->priv;
+  ClutterActor *self = CLUTTER_ACTOR (viewport);
+  ClutterActorBox area;
+
+  if (!priv->use_tile_cache || !CLUTTER_ACTOR_IS_VISIBLE (priv->child))
+    return FALSE;
+
+  if (!priv->tile_cache)
+    priv->tile_cache = _mx_tile_cache_new (self, mx_viewport_paint_tile,
+                                           viewport);
+
+  /* when in a tile of a container's own cache, paint what is in it */
+  if (!_mx_tile_cache_get_render_area (self, &area))
+    {
+      gdouble x, y;
+
+      x = priv->hadjustment ? mx_adjustment_get_value (priv->hadjustment) : 0;
+      y = priv->vadjustment ? mx_adjustment_get_value (priv->vadjustment) : 0;
+
+      /* as offset by mx_viewport_apply_transform() */
+      area.x1 = (int) x;
+      area.y1 = (int) y;
+      area.x2 = area.x1 + clutter_actor_get_width (self);
+      area.y2 = area.y1 + clutter_actor_get_height (self);
+    }
+
+  return _mx_tile_cache_paint (priv->tile_cache, &area,
+                               clutter_actor_get_paint_opacity (priv->child));
+}
+
 static void
 mx_viewport_paint (ClutterActor *self)
 {
@@ -331,10 +405,35 @@ mx_viewport_paint (ClutterActor *self)
 
   CLUTTER_ACTOR_CLASS (mx_viewport_parent_class)->paint (self);
 
-  if (priv->child)
+  if (priv->child && !mx_viewport_paint_tiles (MX_VIEWPORT (self)))
     clutter_actor_paint (priv->child);
 }
 
+static void
+mx_viewport_queue_redraw (ClutterActor *self,
+                          ClutterActor *leaf)
+{
+  MxViewportPrivate *priv = MX_VIEWPORT (self)->priv;
+
+  /* Clutter does not tell the clip of the redraw, so the whole paint
+   * volume of the actor that changed is rendered again */
+  if (priv->tile_cache)
+    _mx_tile_cache_invalidate_actor (priv->tile_cache, leaf);
+
+  CLUTTER_ACTOR_CLASS (mx_viewport_parent_class)->queue_redraw (self, leaf);
+}
+
+static void
+mx_viewport_queue_relayout (ClutterActor *self)
+{
+  MxViewportPrivate *priv = MX_VIEWPORT (self)->priv;
+
+  if (priv->tile_cache)
+    _mx_tile_cache_invalidate (priv->tile_cache, NULL);
+
+  CLUTTER_ACTOR_CLASS (mx_viewport_parent_class)->queue_relayout (self);
+}
+
 static void
 mx_viewport_pick (ClutterActor       *self,
                   const ClutterColor *color)
@@ -428,6 +527,8 @@ mx_viewport_class_init (MxViewportClass *klass)
   actor_class->apply_transform = mx_viewport_apply_transform;
   actor_class->paint = mx_viewport_paint;
   actor_class->pick = mx_viewport_pick;
+  actor_class->queue_redraw = mx_viewport_queue_redraw;
+  actor_class->queue_relayout = mx_viewport_queue_relayout;
   actor_class->get_preferred_width = mx_viewport_get_preferred_width;
   actor_class->get_preferred_height = mx_viewport_get_preferred_height;
 
@@ -461,6 +562,24 @@ mx_viewport_class_init (MxViewportClass *klass)
                                 MX_PARAM_READWRITE);
   g_object_class_install_property (gobject_class, PROP_SYNC_ADJUST, pspec);
 
+  /**
+   * MxViewport:use-tile-cache:
+   *
+   * Whether to keep the rendering of the child in offscreen tiles, and
+   * paint the child from them. Scrolling then draws the tiles at a new
+   * offset, and only the tiles covering a part of the child that queued a
+   * redraw are rendered again.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("use-tile-cache",
+                                "Use tile cache",
+                                "Paint the child from cached tiles of its "
+                                "rendering",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_USE_TILE_CACHE, pspec);
+
   g_object_class_override_property (gobject_class,
                                     PROP_HADJUST,
                                     "horizontal-adjustment");
@@ -631,6 +750,8 @@ mx_viewport_actor_added (ClutterActor *container,
   if (priv->child)
     clutter_actor_remove_child (container, priv->child);
 
+  mx_viewport_drop_tile_cache (MX_VIEWPORT (container));
+
   priv->child = actor;
 }
 
@@ -641,7 +762,10 @@ mx_viewport_actor_removed (ClutterActor *container,
   MxViewportPrivate *priv = MX_VIEWPORT (container)->priv;
 
   if (priv->child == actor)
-    priv->child = NULL;
+    {
+      mx_viewport_drop_tile_cache (MX_VIEWPORT (container));
+      priv->child = NULL;
+    }
 }
 
 
@@ -759,3 +883,58 @@ mx_viewport_get_sync_adjustments (MxViewport *viewport)
   g_return_val_if_fail (MX_IS_VIEWPORT (viewport), FALSE);
   return viewport->priv->sync_adjustments;
 }
+
+/**
+ * mx_viewport_set_use_tile_cache:
+ * @viewport: A #MxViewport
+ * @use_tile_cache: %TRUE to paint the child from cached tiles
+ *
+ * Sets whether to keep the rendering of the child in offscreen tiles and
+ * paint it from those, so that scrolling does not paint the child again.
+ * This suits a large child that seldom changes, like a page of text.
+ *
+ * The tiles covering an actor in the child are rendered again when it
+ * queues a redraw, and all of them when the child is laid out again. Only
+ * the area of the viewport is painted from the tiles, so the viewport
+ * should not be showing the child outside its allocation.
+ *
+ * Since: 2.0
+ */
+void
+mx_viewport_set_use_tile_cache (MxViewport *viewport,
+                                gboolean    use_tile_cache)
+{
+  MxViewportPrivate *priv;
+
+  g_return_if_fail (MX_IS_VIEWPORT (viewport));
+
+  priv = viewport->priv;
+  if (priv->use_tile_cache != use_tile_cache)
+    {
+      priv->use_tile_cache = use_tile_cache;
+
+      if (!use_tile_cache)
+        mx_viewport_drop_tile_cache (viewport);
+
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (viewport));
+
+      g_object_notify (G_OBJECT (viewport), "use-tile-cache");
+    }
+}
+
+/**
+ * mx_viewport_get_use_tile_cache:
+ * @viewport: A #MxViewport
+ *
+ * Gets the #MxViewport:use-tile-cache property.
+ *
+ * Returns: %TRUE if the child is painted from cached tiles
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_viewport_get_use_tile_cache (MxViewport *viewport)
+{
+  g_return_val_if_fail (MX_IS_VIEWPORT (viewport), FALSE);
+  return viewport->priv->use_tile_cache;
+}
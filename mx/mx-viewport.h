@@ -89,6 +89,10 @@ void mx_viewport_set_sync_adjustments (MxViewport *viewport,
                                        gboolean    sync);
 gboolean mx_viewport_get_sync_adjustments (MxViewport *viewport);
 
+void mx_viewport_set_use_tile_cache (MxViewport *viewport,
+                                     gboolean    use_tile_cache);
+gboolean mx_viewport_get_use_tile_cache (MxViewport *viewport);
+
 G_END_DECLS
 
 #endif /* __MX_VIEWPORT_H__ */
@@ -36,6 +36,8 @@ gboolean _mx_widget_has_touch_sequence    (MxWidget             *widget,
                                            ClutterEventSequence *sequence);
 gboolean _mx_widget_has_touch_sequences   (MxWidget *widget);
 
+guint64  _mx_widget_get_style_pseudo_class_mask (MxWidget *widget);
+
 G_END_DECLS
 
 #endif /* __MX_WIDGET_PRIVATE_H__ */
@@ -44,49 +44,56 @@
 #include "mx-tooltip.h"
 #include "mx-enum-types.h"
 #include "mx-settings.h"
+#include "mx-timer-wheel.h"
 
 #include "mx-private.h"
 
 /*
  * Forward declaration for sake of MxWidgetChild
  */
-struct _MxWidgetPrivate
+/* The style properties of MxWidget, computed once for every widget type
+ * that matches the style sheet the same way and shared between all the
+ * widgets doing so. It is never modified once computed.
+ */
+typedef struct
 {
-  MxPadding     border;
-  MxPadding     padding;
-
-  MxStyle       *style;
-  gchar         *pseudo_class;
-  gchar         *style_class;
-  MxBorderImage *mx_border_image;
-  MxBorderImage *mx_background_image;
-
-  CoglHandle      border_image;
-  CoglHandle      old_border_image;
-  CoglHandle      background_image;
-  ClutterActorBox background_image_box;
-  ClutterColor   *bg_color;
-  gfloat          opacity;
-
-  guint         is_disabled : 1;
-  guint         parent_disabled : 1;
-
+  volatile gint      ref_count;
+
+  ClutterColor      *bg_color;
+  MxBorderImage     *border_image;
+  MxBorderImage     *background_image;
+  MxPadding         *padding;
+  MxPadding         *margin;
+  gfloat             opacity;
+  gfloat             width;
+  gfloat             height;
+  MxDisplayStyle     display;
+  MxVisibilityStyle  visibility;
+} MxWidgetStyle;
+
+static void mx_widget_style_unref (MxWidgetStyle *computed);
+
+/* What only some widgets ever need: tooltips, menus, long-presses, touch
+ * sequences and the state that css width, height, visibility and display
+ * override. This is allocated by mx_widget_get_extra() on first use, so
+ * that the many widgets that need none of it stay small. */
+typedef struct
+{
+  /* the tooltip of the stage, while it is showing the text of this widget,
+   * see mx_widget_claim_tooltip() */
   MxTooltip    *tooltip;
+  gchar        *tooltip_text;
   MxMenu       *menu;
 
-  guint         long_press_source;
+  /* motion restarts the tooltip timer on every event, so neither of these
+   * is a GSource of its own */
+  MxTimer       long_press_timer;
 
-  guint         tooltip_timeout;
+  MxTimer       tooltip_timer;
   guint         tooltip_delay;
 
-  guint         in_dispose;
-
   GHashTable   *sequences;
 
-  /* width/height set by css */
-  gfloat css_width;
-  gfloat css_height;
-
   /* previous size state before css width/height were applied */
   gfloat old_min_width;
   gfloat old_min_height;
@@ -103,6 +110,67 @@ struct _MxWidgetPrivate
 
   /* previous visible state if the "display" style property was set to "none" */
   gint old_visible;
+
+  /* the children the ClutterScript the widget was built from left out,
+   * until the widget is first mapped, see
+   * mx_widget_ensure_deferred_children() */
+  gchar         *deferred_children;
+  ClutterScript *deferred_script;
+} MxWidgetExtra;
+
+struct _MxWidgetPrivate
+{
+  /* what painting and layout read first */
+  MxPadding     border;
+  MxPadding     padding;
+
+  /* a copy of the background color of the computed style, valid when
+   * has_bg_color is set */
+  ClutterColor  bg_color;
+
+  guint         has_bg_color : 1;
+  guint         is_disabled : 1;
+  guint         parent_disabled : 1;
+
+  /* see mx_widget_set_cache_subtree() */
+  guint         cache_subtree : 1;
+
+  /* set while the parent paints the background color and border image
+   * along with those of the siblings, see _mx_background_batch_add() */
+  guint         background_batched : 1;
+
+  gfloat          opacity;
+
+  CoglHandle      border_image;
+  MxTextureFrameCache *border_image_cache;
+  CoglHandle      background_image;
+  ClutterActorBox background_image_box;
+
+  /* the computed style, which the pointers below belong to */
+  MxWidgetStyle *computed_style;
+  MxBorderImage *mx_border_image;
+  MxBorderImage *mx_background_image;
+
+  MxStyle       *style;
+  gchar         *pseudo_class;
+  guint64        pseudo_class_mask;
+  gchar         *style_class;
+
+  CoglHandle      old_border_image;
+  GCancellable   *border_image_cancellable;
+  GCancellable   *background_image_cancellable;
+
+  /* the redirect to restore when cache_subtree is unset */
+  ClutterOffscreenRedirect old_offscreen_redirect;
+
+  /* width/height set by css */
+  gfloat css_width;
+  gfloat css_height;
+
+  /* what MxStyle caches for the widget, see mx_widget_get_style_cache() */
+  gpointer       style_cache;
+
+  MxWidgetExtra *extra;
 };
 
 /**
@@ -132,6 +200,31 @@ struct _MxWidgetPrivate
  *
  * Actors in the Mx library should subclass #MxWidget if they plan
  * to obey to a certain #MxStyle.
+ *
+ * In a #ClutterScript definition, the children of a widget can be left out
+ * until it is first shown, by giving a file name, or the JSON definition
+ * of the children as a string, in the "deferred-children" property:
+ *
+ * |[
+ * {
+ *   "type" : "MxNotebook",
+ *   "children" : [
+ *     { "id" : "general-page", "type" : "MxBoxLayout", ... },
+ *     {
+ *       "id" : "advanced-page",
+ *       "type" : "MxBoxLayout",
+ *       "deferred-children" : "advanced-page.json"
+ *     }
+ *   ]
+ * }
+ * ]|
+ *
+ * Containers hide what isn't showing, such as the content of a collapsed
+ * #MxExpander, the pages of an #MxNotebook other than the current one and
+ * an #MxDialog that isn't open, so the children of these are only built,
+ * styled and allocated once they are needed. The
+ * #MxWidget::deferred-children-created signal is emitted then, to connect
+ * the signals of the new objects with clutter_script_connect_signals().
  */
 
 enum
@@ -149,6 +242,8 @@ enum
 
   PROP_TOOLTIP_DELAY,
 
+  PROP_CACHE_SUBTREE,
+
   LAST_PROP
 };
 
@@ -157,6 +252,7 @@ static GParamSpec *widget_properties[LAST_PROP];
 enum
 {
   LONG_PRESS,
+  DEFERRED_CHILDREN_CREATED,
 
   LAST_SIGNAL
 };
@@ -166,6 +262,7 @@ static guint widget_signals[LAST_SIGNAL] = { 0, };
 static void mx_stylable_iface_init (MxStylableIface *iface);
 static ClutterScriptableIface *parent_scriptable_iface = NULL;
 static void scriptable_iface_init (ClutterScriptableIface *iface);
+static void mx_widget_release_tooltip (MxWidget *widget);
 
 /* Length of time in milliseconds that the cursor must be held steady
    over a widget before the tooltip is displayed */
@@ -218,6 +315,10 @@ mx_widget_set_property (GObject      *gobject,
       mx_widget_set_tooltip_delay (actor, g_value_get_int (value));
       break;
 
+    case PROP_CACHE_SUBTREE:
+      mx_widget_set_cache_subtree (actor, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -263,49 +364,72 @@ mx_widget_get_property (GObject    *gobject,
       g_value_set_int (value, mx_widget_get_tooltip_delay (actor));
       break;
 
+    case PROP_CACHE_SUBTREE:
+      g_value_set_boolean (value, mx_widget_get_cache_subtree (actor));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
     }
 }
 
-static gboolean
-mx_widget_tooltip_timeout_cb (gpointer data)
+static void mx_widget_tooltip_timeout_cb (gpointer data);
+static void mx_widget_emit_long_press    (gpointer data);
+
+static MxWidgetExtra *
+mx_widget_get_extra (MxWidget *widget)
 {
-  MxWidget *self = MX_WIDGET (data);
-  MxWidgetPrivate *priv = self->priv;
+  MxWidgetPrivate *priv = widget->priv;
+  MxWidgetExtra *extra;
 
-  mx_widget_show_tooltip (self);
+  if (G_LIKELY (priv->extra))
+    return priv->extra;
 
-  priv->tooltip_timeout = 0;
+  extra = priv->extra = g_slice_new0 (MxWidgetExtra);
 
-  return FALSE;
+  _mx_timer_init (&extra->tooltip_timer,
+                  mx_widget_tooltip_timeout_cb, widget);
+  _mx_timer_init (&extra->long_press_timer,
+                  mx_widget_emit_long_press, widget);
+  extra->tooltip_delay = MX_WIDGET_TOOLTIP_TIMEOUT;
+
+  extra->old_opacity = -1;
+  extra->old_visible = -1;
+
+  return extra;
 }
 
 static void
-mx_widget_remove_tooltip_timeout (MxWidget *widget)
+mx_widget_tooltip_timeout_cb (gpointer data)
 {
-  MxWidgetPrivate *priv = widget->priv;
+  mx_widget_show_tooltip (MX_WIDGET (data));
+}
 
-  if (priv->tooltip_timeout)
-    {
-      g_source_remove (priv->tooltip_timeout);
-      priv->tooltip_timeout = 0;
-    }
+static void
+mx_widget_remove_tooltip_timeout (MxWidget *widget)
+{
+  if (widget->priv->extra)
+    _mx_timer_stop (&widget->priv->extra->tooltip_timer);
 }
 
 static void
 mx_widget_set_tooltip_timeout (MxWidget *widget)
 {
-  MxWidgetPrivate *priv = widget->priv;
-
-  /* Remove any existing tooltip timeout so that we can start again */
-  mx_widget_remove_tooltip_timeout (widget);
+  /* start again, replacing any pending timeout */
+  _mx_timer_start (&mx_widget_get_extra (widget)->tooltip_timer,
+                   mx_widget_get_tooltip_delay (widget));
+}
 
-  priv->tooltip_timeout =
-    clutter_threads_add_timeout (mx_widget_get_tooltip_delay (widget),
-                                 mx_widget_tooltip_timeout_cb,
-                                 widget);
+static void
+mx_widget_cancel_image_load (GCancellable **cancellable)
+{
+  if (*cancellable)
+    {
+      g_cancellable_cancel (*cancellable);
+      g_object_unref (*cancellable);
+      *cancellable = NULL;
+    }
 }
 
 static void
@@ -322,6 +446,9 @@ mx_widget_dispose (GObject *gobject)
       priv->style = NULL;
     }
 
+  mx_widget_cancel_image_load (&priv->border_image_cancellable);
+  mx_widget_cancel_image_load (&priv->background_image_cancellable);
+
   if (priv->border_image)
     {
       cogl_handle_unref (priv->border_image);
@@ -334,24 +461,31 @@ mx_widget_dispose (GObject *gobject)
       priv->old_border_image = NULL;
     }
 
+  _mx_texture_frame_cache_free (priv->border_image_cache);
+  priv->border_image_cache = NULL;
+
   if (priv->background_image)
     {
       cogl_handle_unref (priv->background_image);
       priv->background_image = NULL;
     }
 
-  if (priv->tooltip)
+  mx_widget_release_tooltip (MX_WIDGET (actor));
+
+  if (priv->extra && priv->extra->menu)
     {
       clutter_actor_remove_child (CLUTTER_ACTOR (actor),
-                                  CLUTTER_ACTOR (priv->tooltip));
-      priv->tooltip = NULL;
+                                  CLUTTER_ACTOR (priv->extra->menu));
+      priv->extra->menu = NULL;
     }
 
-  if (priv->menu)
+  if (priv->extra && priv->extra->deferred_script)
     {
-      clutter_actor_remove_child (CLUTTER_ACTOR (actor),
-                                  CLUTTER_ACTOR (priv->menu));
-      priv->menu = NULL;
+      MxWidgetExtra *extra = priv->extra;
+
+      g_object_remove_weak_pointer (G_OBJECT (extra->deferred_script),
+                                    (gpointer *) &extra->deferred_script);
+      extra->deferred_script = NULL;
     }
 
   G_OBJECT_CLASS (mx_widget_parent_class)->dispose (gobject);
@@ -361,31 +495,36 @@ static void
 mx_widget_finalize (GObject *gobject)
 {
   MxWidgetPrivate *priv = MX_WIDGET (gobject)->priv;
-
-  mx_widget_remove_tooltip_timeout (MX_WIDGET (gobject));
+  MxWidgetExtra *extra = priv->extra;
 
   g_free (priv->style_class);
   g_free (priv->pseudo_class);
 
-  if (priv->mx_border_image)
-    {
-      g_boxed_free (MX_TYPE_BORDER_IMAGE, priv->mx_border_image);
-      priv->mx_border_image = NULL;
-    }
+  _mx_style_free_stylable_cache (priv->style_cache);
+  priv->style_cache = NULL;
 
-  if (priv->mx_background_image)
+  if (priv->computed_style)
     {
-      g_boxed_free (MX_TYPE_BORDER_IMAGE, priv->mx_background_image);
+      mx_widget_style_unref (priv->computed_style);
+      priv->computed_style = NULL;
+      priv->mx_border_image = NULL;
       priv->mx_background_image = NULL;
     }
 
-  if (priv->sequences)
+  if (extra)
     {
-      g_hash_table_unref (priv->sequences);
-      priv->sequences = NULL;
-    }
+      _mx_timer_stop (&extra->tooltip_timer);
+      _mx_timer_stop (&extra->long_press_timer);
+
+      g_free (extra->tooltip_text);
+      g_free (extra->deferred_children);
+
+      if (extra->sequences)
+        g_hash_table_unref (extra->sequences);
 
-  clutter_color_free (priv->bg_color);
+      g_slice_free (MxWidgetExtra, extra);
+      priv->extra = NULL;
+    }
 
   G_OBJECT_CLASS (mx_widget_parent_class)->finalize (gobject);
 }
@@ -396,14 +535,17 @@ mx_widget_allocate (ClutterActor          *actor,
                     ClutterAllocationFlags flags)
 {
   MxWidgetPrivate *priv = MX_WIDGET (actor)->priv;
+  MxWidgetExtra *extra = priv->extra;
   ClutterActorClass *klass;
   ClutterActorBox frame_box = { 0, 0, box->x2 - box->x1, box->y2 - box->y1 };
 
+  _mx_frame_stats_count (MX_FRAME_STATS_RELAYOUTS);
+
   klass = CLUTTER_ACTOR_CLASS (mx_widget_parent_class);
   klass->allocate (actor, box, flags);
 
   /* update tooltip position */
-  if (priv->tooltip)
+  if (extra && extra->tooltip)
     {
       ClutterVertex verts[4];
       ClutterGeometry area;
@@ -431,15 +573,17 @@ mx_widget_allocate (ClutterActor          *actor,
       area.width = x2 - x;
       area.height = y2 - y;
 
-      mx_tooltip_set_tip_area (priv->tooltip, &area);
+      mx_tooltip_set_tip_area (extra->tooltip, &area);
     }
 
   if (priv->background_image)
     {
-      gfloat w, h;
+      gfloat w, h, scale;
 
-      w = cogl_texture_get_width (priv->background_image);
-      h = cogl_texture_get_height (priv->background_image);
+      /* variants for the scale factor are drawn at the size of the image */
+      scale = _mx_texture_cache_get_texture_scale (priv->background_image);
+      w = cogl_texture_get_width (priv->background_image) / scale;
+      h = cogl_texture_get_height (priv->background_image) / scale;
 
       /* scale the background into the allocated bounds */
       if (w > frame_box.x2 || h > frame_box.y2)
@@ -486,11 +630,14 @@ mx_widget_allocate (ClutterActor          *actor,
       priv->background_image_box = frame_box;
     }
 
-  if (priv->tooltip)
-    clutter_actor_allocate_preferred_size (CLUTTER_ACTOR (priv->tooltip),
+  if (!extra)
+    return;
+
+  if (extra->tooltip)
+    clutter_actor_allocate_preferred_size (CLUTTER_ACTOR (extra->tooltip),
                                            flags);
-  if (priv->menu)
-    clutter_actor_allocate_preferred_size (CLUTTER_ACTOR (priv->menu),
+  if (extra->menu)
+    clutter_actor_allocate_preferred_size (CLUTTER_ACTOR (extra->menu),
                                            flags);
 }
 
@@ -503,25 +650,28 @@ mx_widget_paint (ClutterActor *actor)
   gfloat width, height;
   guint alpha = clutter_actor_get_paint_opacity (actor);
 
+  _mx_frame_stats_count (MX_FRAME_STATS_PAINTED);
+
   clutter_actor_get_allocation_box (actor, &allocation);
 
   width = allocation.x2 - allocation.x1;
   height = allocation.y2 - allocation.y1;
 
   /* paint the background color first */
-  if (priv->bg_color && priv->bg_color->alpha != 0)
+  if (priv->bg_color.alpha != 0 && !priv->background_batched)
     {
-      guint tmp_alpha = alpha * priv->bg_color->alpha / 255;
+      guint tmp_alpha = alpha * priv->bg_color.alpha / 255;
 
-      cogl_set_source_color4ub (priv->bg_color->red,
-                                priv->bg_color->green,
-                                priv->bg_color->blue,
+      cogl_set_source_color4ub (priv->bg_color.red,
+                                priv->bg_color.green,
+                                priv->bg_color.blue,
                                 tmp_alpha);
       cogl_rectangle (0, 0, width, height);
     }
 
-  if (priv->border_image)
-    mx_texture_frame_paint_texture (priv->border_image,
+  if (priv->border_image && !priv->background_batched)
+    _mx_texture_frame_paint_cached (&priv->border_image_cache,
+                                    priv->border_image,
                                     alpha,
                                     priv->mx_border_image->top,
                                     priv->mx_border_image->right,
@@ -537,11 +687,260 @@ mx_widget_paint (ClutterActor *actor)
                                     priv->background_image_box.x2 - priv->background_image_box.x1,
                                     priv->background_image_box.y2 - priv->background_image_box.y1);
 
-  if (priv->tooltip)
-    clutter_actor_paint (CLUTTER_ACTOR (priv->tooltip));
+  if (!priv->extra)
+    return;
+
+  if (priv->extra->tooltip)
+    clutter_actor_paint (CLUTTER_ACTOR (priv->extra->tooltip));
+
+  if (priv->extra->menu)
+    clutter_actor_paint (CLUTTER_ACTOR (priv->extra->menu));
+}
+
+/*
+ * A background batch gathers the background colors and border images of
+ * sibling widgets, so that the container paints them with one call per
+ * color or texture before the children paint the rest of their content.
+ */
+
+typedef struct
+{
+  CoglHandle   texture;    /* NULL for background colors */
+  ClutterColor color;      /* the opacity of the texture in the alpha */
+  GArray      *rectangles;
+} MxBackgroundBatchGroup;
+
+struct _MxBackgroundBatch
+{
+  GArray *groups;
+  GSList *widgets;
+};
+
+MxBackgroundBatch *
+_mx_background_batch_new (void)
+{
+  MxBackgroundBatch *batch = g_slice_new0 (MxBackgroundBatch);
+
+  batch->groups = g_array_new (FALSE, FALSE, sizeof (MxBackgroundBatchGroup));
+
+  return batch;
+}
+
+void
+_mx_background_batch_free (MxBackgroundBatch *batch)
+{
+  if (!batch)
+    return;
+
+  _mx_background_batch_end (batch);
+  g_array_free (batch->groups, TRUE);
+
+  g_slice_free (MxBackgroundBatch, batch);
+}
+
+static GArray *
+mx_background_batch_get_rectangles (MxBackgroundBatch  *batch,
+                                    CoglHandle          texture,
+                                    const ClutterColor *color)
+{
+  MxBackgroundBatchGroup *group;
+  guint i;
+
+  for (i = 0; i < batch->groups->len; i++)
+    {
+      group = &g_array_index (batch->groups, MxBackgroundBatchGroup, i);
+
+      if (group->texture == texture &&
+          clutter_color_equal (&group->color, color))
+        return group->rectangles;
+    }
+
+  g_array_set_size (batch->groups, batch->groups->len + 1);
+  group = &g_array_index (batch->groups, MxBackgroundBatchGroup, i);
+
+  group->texture = texture ? cogl_handle_ref (texture) : NULL;
+  group->color = *color;
+  group->rectangles = g_array_new (FALSE, FALSE, sizeof (float));
 
-  if (priv->menu)
-    clutter_actor_paint (CLUTTER_ACTOR (priv->menu));
+  return group->rectangles;
+}
+
+/*
+ * _mx_background_batch_add:
+ *
+ * Takes the background color and border image of @child, a child of
+ * @container, into @batch. Until _mx_background_batch_end(), the child
+ * paints neither of them. Returns %FALSE if the child is not an #MxWidget
+ * or is painted in a way that the batch can not reproduce, such as through
+ * effects or a scale; it then paints its background itself.
+ */
+gboolean
+_mx_background_batch_add (MxBackgroundBatch *batch,
+                          ClutterActor      *container,
+                          ClutterActor      *child)
+{
+  MxWidgetPrivate *priv;
+  ClutterVertex origin = { 0, 0, 0 }, offset;
+  ClutterActorBox box;
+  ClutterColor color;
+  gfloat width, height;
+  guint8 opacity;
+
+  if (!MX_IS_WIDGET (child))
+    return FALSE;
+
+  priv = MX_WIDGET (child)->priv;
+
+  if (priv->background_batched ||
+      (!priv->border_image && !priv->bg_color.alpha))
+    return FALSE;
+
+  if (clutter_actor_is_rotated (child) || clutter_actor_is_scaled (child) ||
+      clutter_actor_has_effects (child) || clutter_actor_has_clip (child) ||
+      clutter_actor_get_offscreen_redirect (child) ||
+      clutter_actor_get_parent (child) != container)
+    return FALSE;
+
+  clutter_actor_apply_relative_transform_to_point (child, container,
+                                                   &origin, &offset);
+  clutter_actor_get_allocation_box (child, &box);
+  width = box.x2 - box.x1;
+  height = box.y2 - box.y1;
+
+  opacity = clutter_actor_get_paint_opacity (child);
+
+  if (priv->bg_color.alpha != 0)
+    {
+      float rectangle[4] = { offset.x, offset.y,
+                             offset.x + width, offset.y + height };
+
+      color = priv->bg_color;
+      color.alpha = opacity * priv->bg_color.alpha / 255;
+
+      g_array_append_vals (mx_background_batch_get_rectangles (batch, NULL,
+                                                               &color),
+                           rectangle, 4);
+    }
+
+  if (priv->border_image)
+    {
+      float rectangles[9 * 8];
+      gint i, n_rectangles = 9;
+
+      if (!_mx_texture_frame_get_rectangles (priv->border_image,
+                                             priv->mx_border_image->top,
+                                             priv->mx_border_image->right,
+                                             priv->mx_border_image->bottom,
+                                             priv->mx_border_image->left,
+                                             width, height, rectangles))
+        {
+          float stretch[8] = { 0, 0, width, height, 0.0, 0.0, 1.0, 1.0 };
+
+          memcpy (rectangles, stretch, sizeof (stretch));
+          n_rectangles = 1;
+        }
+
+      for (i = 0; i < n_rectangles; i++)
+        {
+          rectangles[i * 8] += offset.x;
+          rectangles[i * 8 + 1] += offset.y;
+          rectangles[i * 8 + 2] += offset.x;
+          rectangles[i * 8 + 3] += offset.y;
+        }
+
+      color.red = color.green = color.blue = color.alpha = opacity;
+
+      g_array_append_vals (mx_background_batch_get_rectangles (batch,
+                                                               priv->border_image,
+                                                               &color),
+                           rectangles, n_rectangles * 8);
+    }
+
+  priv->background_batched = TRUE;
+  batch->widgets = g_slist_prepend (batch->widgets, child);
+
+  return TRUE;
+}
+
+/*
+ * _mx_background_batch_paint:
+ *
+ * Paints what was added to @batch: the background colors first, then the
+ * border images, one call for each.
+ */
+void
+_mx_background_batch_paint (MxBackgroundBatch *batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->groups->len; i++)
+    {
+      MxBackgroundBatchGroup *group =
+        &g_array_index (batch->groups, MxBackgroundBatchGroup, i);
+
+      if (group->texture)
+        continue;
+
+      cogl_set_source_color4ub (group->color.red,
+                                group->color.green,
+                                group->color.blue,
+                                group->color.alpha);
+      cogl_rectangles ((float *) group->rectangles->data,
+                       group->rectangles->len / 4);
+    }
+
+  for (i = 0; i < batch->groups->len; i++)
+    {
+      MxBackgroundBatchGroup *group =
+        &g_array_index (batch->groups, MxBackgroundBatchGroup, i);
+      CoglHandle material;
+
+      if (!group->texture)
+        continue;
+
+      material = cogl_material_new ();
+      cogl_material_set_color4ub (material,
+                                  group->color.alpha, group->color.alpha,
+                                  group->color.alpha, group->color.alpha);
+      cogl_material_set_layer (material, 0, group->texture);
+
+      cogl_set_source (material);
+      cogl_rectangles_with_texture_coords ((float *) group->rectangles->data,
+                                           group->rectangles->len / 8);
+
+      cogl_handle_unref (material);
+    }
+}
+
+/*
+ * _mx_background_batch_end:
+ *
+ * Lets the widgets added to @batch paint their own backgrounds again and
+ * empties it.
+ */
+void
+_mx_background_batch_end (MxBackgroundBatch *batch)
+{
+  GSList *l;
+  guint i;
+
+  for (l = batch->widgets; l; l = l->next)
+    MX_WIDGET (l->data)->priv->background_batched = FALSE;
+
+  g_slist_free (batch->widgets);
+  batch->widgets = NULL;
+
+  for (i = 0; i < batch->groups->len; i++)
+    {
+      MxBackgroundBatchGroup *group =
+        &g_array_index (batch->groups, MxBackgroundBatchGroup, i);
+
+      if (group->texture)
+        cogl_handle_unref (group->texture);
+      g_array_free (group->rectangles, TRUE);
+    }
+
+  g_array_set_size (batch->groups, 0);
 }
 
 static void
@@ -551,9 +950,151 @@ mx_widget_pick (ClutterActor *self, const ClutterColor *color)
 
   CLUTTER_ACTOR_CLASS (mx_widget_parent_class)->pick (self, color);
 
-  if (priv->menu)
-    clutter_actor_paint (CLUTTER_ACTOR (priv->menu));
+  if (priv->extra && priv->extra->menu)
+    clutter_actor_paint (CLUTTER_ACTOR (priv->extra->menu));
+
+}
+
+static MxWidgetStyle *
+mx_widget_style_ref (MxWidgetStyle *computed)
+{
+  g_atomic_int_inc (&computed->ref_count);
+
+  return computed;
+}
+
+static void
+mx_widget_style_unref (MxWidgetStyle *computed)
+{
+  if (!g_atomic_int_dec_and_test (&computed->ref_count))
+    return;
+
+  if (computed->bg_color)
+    clutter_color_free (computed->bg_color);
+  if (computed->border_image)
+    g_boxed_free (MX_TYPE_BORDER_IMAGE, computed->border_image);
+  if (computed->background_image)
+    g_boxed_free (MX_TYPE_BORDER_IMAGE, computed->background_image);
+  if (computed->padding)
+    g_boxed_free (MX_TYPE_PADDING, computed->padding);
+  if (computed->margin)
+    g_boxed_free (MX_TYPE_PADDING, computed->margin);
+
+  g_slice_free (MxWidgetStyle, computed);
+}
+
+/* Returns a new reference to the computed style of @widget, which is the
+ * same for all widgets that match the style sheet the same way */
+static MxWidgetStyle *
+mx_widget_get_computed_style (MxWidget *widget)
+{
+  static GQuark quark = 0;
+  MxWidgetStyle *computed;
+
+  if (G_UNLIKELY (!quark))
+    quark = g_quark_from_static_string ("mx-widget-computed-style");
+
+  computed = _mx_style_lookup_computed (MX_STYLABLE (widget), quark);
+  if (computed)
+    return mx_widget_style_ref (computed);
+
+  computed = g_slice_new0 (MxWidgetStyle);
+  computed->ref_count = 1;
+  computed->opacity = -1;
+  computed->width = -1;
+  computed->height = -1;
+
+  mx_stylable_get (MX_STYLABLE (widget),
+                   "background-color", &computed->bg_color,
+                   "background-image", &computed->background_image,
+                   "border-image", &computed->border_image,
+                   "padding", &computed->padding,
+                   "opacity", &computed->opacity,
+                   "margin", &computed->margin,
+                   "width", &computed->width,
+                   "height", &computed->height,
+                   "display", &computed->display,
+                   "visibility", &computed->visibility,
+                   NULL);
+
+  _mx_style_set_computed (MX_STYLABLE (widget), quark,
+                          mx_widget_style_ref (computed),
+                          (GDestroyNotify) mx_widget_style_unref);
+
+  return computed;
+}
+
+static void
+mx_widget_image_loaded (MxWidget      *widget,
+                        GAsyncResult  *result,
+                        CoglHandle    *texture,
+                        GCancellable **cancellable)
+{
+  GError *error = NULL;
+
+  *texture =
+    mx_texture_cache_get_cogl_texture_finish (mx_texture_cache_get_default (),
+                                              result, &error);
+
+  if (*texture)
+    {
+      /* the load wasn't cancelled, so the image is still current */
+      g_object_unref (*cancellable);
+      *cancellable = NULL;
 
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (widget));
+    }
+  else
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("Error loading image: %s", error->message);
+      g_error_free (error);
+    }
+}
+
+static void
+mx_widget_border_image_loaded (GObject      *source,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+  MxWidget *widget = user_data;
+
+  mx_widget_image_loaded (widget, result, &widget->priv->border_image,
+                          &widget->priv->border_image_cancellable);
+  g_object_unref (widget);
+}
+
+static void
+mx_widget_background_image_loaded (GObject      *source,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  MxWidget *widget = user_data;
+
+  mx_widget_image_loaded (widget, result, &widget->priv->background_image,
+                          &widget->priv->background_image_cancellable);
+  g_object_unref (widget);
+}
+
+/* Returns the texture for @uri if it is already cached. Otherwise the image
+ * is loaded in the background and NULL is returned, so that nothing is
+ * drawn in its place until @callback sets it. */
+static CoglHandle
+mx_widget_load_image (MxWidget             *widget,
+                      const gchar          *uri,
+                      GCancellable        **cancellable,
+                      GAsyncReadyCallback   callback)
+{
+  MxTextureCache *texture_cache = mx_texture_cache_get_default ();
+
+  if (mx_texture_cache_contains (texture_cache, uri))
+    return mx_texture_cache_get_cogl_texture (texture_cache, uri);
+
+  *cancellable = g_cancellable_new ();
+  mx_texture_cache_get_cogl_texture_async (texture_cache, uri, *cancellable,
+                                           callback, g_object_ref (widget));
+
+  return NULL;
 }
 
 static void
@@ -561,53 +1102,55 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
 {
   MxWidgetPrivate *priv = MX_WIDGET (self)->priv;
   ClutterActor *actor = (ClutterActor *) self;
-  MxBorderImage *border_image = NULL, *background_image = NULL;
-  MxTextureCache *texture_cache = mx_texture_cache_get_default ();
-  MxPadding *padding = NULL;
-  MxPadding *margin = NULL;
+  MxBorderImage *border_image, *background_image;
+  MxPadding *padding;
+  MxPadding *margin;
   gboolean relayout_needed = FALSE;
   gboolean has_changed = FALSE;
   ClutterColor *color;
-  gfloat opacity = -1;
+  gfloat opacity;
   gboolean border_image_changed = FALSE, background_image_changed = FALSE;
-  gfloat width = -1, height = -1;
+  gfloat width, height;
   MxDisplayStyle display;
   MxVisibilityStyle visibility;
+  MxWidgetStyle *computed;
+  MX_TRACE_BEGIN (mx_widget_style_changed);
 
-  /* cache these values for use in the paint function */
-  mx_stylable_get (self,
-                   "background-color", &color,
-                   "background-image", &background_image,
-                   "border-image", &border_image,
-                   "padding", &padding,
-                   "opacity", &opacity,
-                   "margin", &margin,
-                   "width", &width,
-                   "height", &height,
-                   "display", &display,
-                   "visibility", &visibility,
-                   NULL);
+  computed = mx_widget_get_computed_style (MX_WIDGET (self));
 
-  if (color)
+  /* the computed style is shared, so if it is the one already applied then
+   * nothing changed */
+  if (computed == priv->computed_style && !(flags & MX_STYLE_CHANGED_FORCE))
     {
-      if (priv->bg_color && clutter_color_equal (color, priv->bg_color))
-        {
-          /* color is the same ... */
-          clutter_color_free (color);
-        }
-      else
-        {
-          clutter_color_free (priv->bg_color);
-          priv->bg_color = color;
-          has_changed = TRUE;
-        }
+      mx_widget_style_unref (computed);
+      MX_TRACE_END (mx_widget_style_changed);
+      return;
     }
-  else
-  if (priv->bg_color)
+
+  color = computed->bg_color;
+  background_image = computed->background_image;
+  border_image = computed->border_image;
+  padding = computed->padding;
+  opacity = computed->opacity;
+  margin = computed->margin;
+  width = computed->width;
+  height = computed->height;
+  display = computed->display;
+  visibility = computed->visibility;
+
+  /* cache these values for use in the paint function */
+  if ((color != NULL) != priv->has_bg_color ||
+      (color && !clutter_color_equal (color, &priv->bg_color)))
     {
-      clutter_color_free (priv->bg_color);
-      priv->bg_color = NULL;
       has_changed = TRUE;
+
+      /* unset colors are kept transparent, so that painting only needs to
+       * look at the alpha */
+      priv->has_bg_color = (color != NULL);
+      if (color)
+        priv->bg_color = *color;
+      else
+        priv->bg_color.alpha = 0;
     }
 
   if ((opacity >= 0) && (priv->opacity != opacity))
@@ -625,11 +1168,13 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
         {
           /* store the old state before setting the css height */
 
+          MxWidgetExtra *extra = mx_widget_get_extra (MX_WIDGET (self));
+
           g_object_get (self,
-                        "min-height", &priv->old_min_height,
-                        "min-height-set", &priv->old_min_height_set,
-                        "natural-height", &priv->old_nat_height,
-                        "natural-height-set", &priv->old_nat_height_set,
+                        "min-height", &extra->old_min_height,
+                        "min-height-set", &extra->old_min_height_set,
+                        "natural-height", &extra->old_nat_height,
+                        "natural-height-set", &extra->old_nat_height_set,
                         NULL);
         }
       clutter_actor_set_height (CLUTTER_ACTOR (self), height);
@@ -639,11 +1184,13 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
       /* no css height to set and css height was previously set, so restore the
        * saved state */
 
+      MxWidgetExtra *extra = priv->extra;
+
       g_object_set (self,
-                    "min-height", priv->old_min_height,
-                    "min-height-set", priv->old_min_height_set,
-                    "natural-height", priv->old_nat_height,
-                    "natural-height-set", priv->old_nat_height_set,
+                    "min-height", extra->old_min_height,
+                    "min-height-set", extra->old_min_height_set,
+                    "natural-height", extra->old_nat_height,
+                    "natural-height-set", extra->old_nat_height_set,
                     NULL);
     }
   /* store the css height set (-1 means not set) */
@@ -658,11 +1205,13 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
         {
           /* store the old state before setting the css width */
 
+          MxWidgetExtra *extra = mx_widget_get_extra (MX_WIDGET (self));
+
           g_object_get (self,
-                        "min-width", &priv->old_min_width,
-                        "min-width-set", &priv->old_min_width_set,
-                        "natural-width", &priv->old_nat_width,
-                        "natural-width-set", &priv->old_nat_width_set,
+                        "min-width", &extra->old_min_width,
+                        "min-width-set", &extra->old_min_width_set,
+                        "natural-width", &extra->old_nat_width,
+                        "natural-width-set", &extra->old_nat_width_set,
                         NULL);
         }
       clutter_actor_set_width (CLUTTER_ACTOR (self), width);
@@ -672,11 +1221,13 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
       /* no css width to set and css width was previously set, so restore the
        * saved state */
 
+      MxWidgetExtra *extra = priv->extra;
+
       g_object_set (self,
-                    "min-width", priv->old_min_width,
-                    "min-width-set", priv->old_min_width_set,
-                    "natural-width", priv->old_nat_width,
-                    "natural-width-set", priv->old_nat_width_set,
+                    "min-width", extra->old_min_width,
+                    "min-width-set", extra->old_min_width_set,
+                    "natural-width", extra->old_nat_width,
+                    "natural-width-set", extra->old_nat_width_set,
                     NULL);
     }
   /* store the css width set (-1 means not set) */
@@ -697,7 +1248,6 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
         }
 
       priv->padding = *padding;
-      g_boxed_free (MX_TYPE_PADDING, padding);
     }
 
   if (margin)
@@ -710,8 +1260,6 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
       clutter_margin.bottom = margin->bottom;
 
       clutter_actor_set_margin (CLUTTER_ACTOR (self), &clutter_margin);
-
-      g_boxed_free (MX_TYPE_PADDING, margin);
     }
 
 
@@ -724,6 +1272,9 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
                                                  border_image);
 
   /* remove the old border-image if it has changed */
+  if (border_image_changed)
+    mx_widget_cancel_image_load (&priv->border_image_cancellable);
+
   if (border_image_changed && priv->border_image)
     {
       cogl_handle_unref (priv->border_image);
@@ -734,27 +1285,16 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
   /* apply the new border-image, as long as there is a valid URI */
   if (border_image_changed && border_image && border_image->uri)
     {
-      priv->border_image = mx_texture_cache_get_cogl_texture (texture_cache,
-                                                              border_image->uri);
+      priv->border_image =
+        mx_widget_load_image (MX_WIDGET (self), border_image->uri,
+                              &priv->border_image_cancellable,
+                              mx_widget_border_image_loaded);
 
       has_changed = TRUE;
       relayout_needed = TRUE;
     }
 
-  /* if the border-image has changed, free the old one and store the new one */
-  if (border_image_changed)
-    {
-      if (priv->mx_border_image)
-        g_boxed_free (MX_TYPE_BORDER_IMAGE, priv->mx_border_image);
-
-      priv->mx_border_image = border_image;
-    }
-  else
-    {
-      /* If it's not changed just free the one we've requested */
-      if (border_image)
-        g_boxed_free (MX_TYPE_BORDER_IMAGE, border_image);
-    }
+  priv->mx_border_image = border_image;
 
   /*
    * background-image property
@@ -765,6 +1305,9 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
                                                      background_image);
 
   /* remove the old background-image if it has changed */
+  if (background_image_changed)
+    mx_widget_cancel_image_load (&priv->background_image_cancellable);
+
   if (background_image_changed && priv->background_image)
     {
       cogl_handle_unref (priv->background_image);
@@ -775,33 +1318,29 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
   /* apply the new background-image, as long as there is a valid URI */
   if (background_image_changed && background_image && background_image->uri)
     {
-      priv->background_image = mx_texture_cache_get_cogl_texture (texture_cache,
-                                                                  background_image->uri);
+      priv->background_image =
+        mx_widget_load_image (MX_WIDGET (self), background_image->uri,
+                              &priv->background_image_cancellable,
+                              mx_widget_background_image_loaded);
 
       has_changed = TRUE;
       relayout_needed = TRUE;
     }
 
-  /* if the background-image has changed, free the old one and store the new one */
-  if (background_image_changed)
-    {
-      if (priv->mx_background_image)
-        g_boxed_free (MX_TYPE_BORDER_IMAGE, priv->mx_background_image);
+  priv->mx_background_image = background_image;
 
-      priv->mx_background_image = background_image;
-    }
-  else
-    {
-      /* If it's not changed just free the one we've requested */
-      if (background_image)
-        g_boxed_free (MX_TYPE_BORDER_IMAGE, background_image);
-    }
+  /* the previous computed style is no longer referenced */
+  if (priv->computed_style)
+    mx_widget_style_unref (priv->computed_style);
+  priv->computed_style = computed;
 
   /* visibility */
   if (visibility == MX_VISIBILITY_STYLE_HIDDEN)
     {
-      if (priv->old_opacity == -1)
-        priv->old_opacity = clutter_actor_get_opacity (actor);
+      MxWidgetExtra *extra = mx_widget_get_extra (MX_WIDGET (self));
+
+      if (extra->old_opacity == -1)
+        extra->old_opacity = clutter_actor_get_opacity (actor);
 
       clutter_actor_set_opacity (actor, 0);
     }
@@ -809,33 +1348,35 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
     {
       /* if visibility has been set previously, restore the old opacity or set
        * it to the current css opacity value */
-      if (priv->old_opacity > -1)
+      if (priv->extra && priv->extra->old_opacity > -1)
         {
           if (opacity < 0)
-            clutter_actor_set_opacity (actor, priv->old_opacity);
+            clutter_actor_set_opacity (actor, priv->extra->old_opacity);
           else
             clutter_actor_set_opacity (actor, opacity * 255);
 
-          priv->old_opacity = -1;
+          priv->extra->old_opacity = -1;
         }
     }
 
   /* display */
   if (display == MX_DISPLAY_STYLE_NONE)
     {
-      if (priv->old_visible == -1)
-        priv->old_visible = (CLUTTER_ACTOR_IS_VISIBLE (actor)) ? 1 : 0;
+      MxWidgetExtra *extra = mx_widget_get_extra (MX_WIDGET (self));
+
+      if (extra->old_visible == -1)
+        extra->old_visible = (CLUTTER_ACTOR_IS_VISIBLE (actor)) ? 1 : 0;
 
       clutter_actor_hide (actor);
     }
-  else
+  else if (priv->extra)
     {
       /* if display has been set to none previously and the actor was visible
        * when it was set, show the actor again */
-      if (priv->old_visible == 1)
+      if (priv->extra->old_visible == 1)
         clutter_actor_show (actor);
 
-      priv->old_visible = -1;
+      priv->extra->old_visible = -1;
     }
 
   /* If there are any properties above that need to cause a relayout thay
@@ -848,6 +1389,8 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
       else
         clutter_actor_queue_redraw ((ClutterActor *) self);
     }
+
+  MX_TRACE_END (mx_widget_style_changed);
 }
 
 static gboolean
@@ -891,9 +1434,10 @@ mx_widget_motion (ClutterActor       *actor,
                   ClutterMotionEvent *event)
 {
   MxWidget *widget = MX_WIDGET (actor);
-  MxWidgetPrivate *priv = widget->priv;
+  MxWidgetExtra *extra = widget->priv->extra;
 
-  if (priv->tooltip && !CLUTTER_ACTOR_IS_VISIBLE (priv->tooltip))
+  if (extra && extra->tooltip_text &&
+      !(extra->tooltip && CLUTTER_ACTOR_IS_VISIBLE (extra->tooltip)))
     {
       /* If tooltips are in browse mode then display the tooltip immediately */
       if (mx_tooltip_is_in_browse_mode ())
@@ -905,16 +1449,13 @@ mx_widget_motion (ClutterActor       *actor,
   return FALSE;
 }
 
-static gboolean
-mx_widget_emit_long_press (MxWidget *widget)
+static void
+mx_widget_emit_long_press (gpointer data)
 {
   gboolean result;
 
-  g_signal_emit (widget, widget_signals[LONG_PRESS], 0,
+  g_signal_emit (data, widget_signals[LONG_PRESS], 0,
                  0.0, 0.0, MX_LONG_PRESS_ACTION, &result);
-  widget->priv->long_press_source = 0;
-
-  return FALSE;
 }
 
 /**
@@ -928,7 +1469,6 @@ void
 mx_widget_long_press_query (MxWidget           *widget,
                             ClutterEvent       *event)
 {
-  MxWidgetPrivate *priv = widget->priv;
   gboolean query_result = FALSE;
   MxSettings *settings = mx_settings_get_default ();
   guint timeout;
@@ -955,9 +1495,7 @@ mx_widget_long_press_query (MxWidget           *widget,
     }
 
   if (query_result)
-    priv->long_press_source = g_timeout_add (timeout,
-                                             (GSourceFunc) mx_widget_emit_long_press,
-                                             widget);
+    _mx_timer_start (&mx_widget_get_extra (widget)->long_press_timer, timeout);
 }
 
 /**
@@ -970,14 +1508,13 @@ mx_widget_long_press_query (MxWidget           *widget,
 void
 mx_widget_long_press_cancel (MxWidget *widget)
 {
-  MxWidgetPrivate *priv = widget->priv;
+  MxWidgetExtra *extra = widget->priv->extra;
 
-  if (priv->long_press_source)
+  if (extra && _mx_timer_is_active (&extra->long_press_timer))
     {
       gboolean result;
 
-      g_source_remove (priv->long_press_source);
-      priv->long_press_source = 0;
+      _mx_timer_stop (&extra->long_press_timer);
       g_signal_emit (widget, widget_signals[LONG_PRESS], 0,
                      0.0, 0.0, MX_LONG_PRESS_CANCEL, &result);
     }
@@ -1080,8 +1617,8 @@ mx_widget_hide (ClutterActor *actor)
 }
 
 static void
-_mx_widget_propagate_disabled (ClutterActor *container,
-                               gboolean      disabled)
+mx_widget_propagate_disabled_internal (ClutterActor *container,
+                                       gboolean      disabled)
 {
   ClutterActorIter iter;
   ClutterActor *child;
@@ -1096,10 +1633,12 @@ _mx_widget_propagate_disabled (ClutterActor *container,
 
           child_priv->parent_disabled = disabled;
 
-          /* emit the "notify" signal for the "disabled" property */
-          g_object_notify_by_pspec (G_OBJECT (container),
-                                    widget_properties[PROP_DISABLED]);
-
+          /* If this child has already been disabled explicitly, it stays
+           * disabled, and we don't need to recurse through its children
+           * to set the 'parent_disabled' flag, as it'll already be set.
+           */
+          if (child_priv->is_disabled)
+            continue;
 
           if (disabled)
             mx_stylable_style_pseudo_class_add (MX_STYLABLE (child),
@@ -1108,18 +1647,27 @@ _mx_widget_propagate_disabled (ClutterActor *container,
             mx_stylable_style_pseudo_class_remove (MX_STYLABLE (child),
                                                    "disabled");
 
-          /* If this child has already been disabled explicitly,
-           * we don't need to recurse through its children to set
-           * the 'parent_disabled' flag, as it'll already be set.
-           */
-          if (child_priv->is_disabled)
-            continue;
+          /* emit the "notify" signal for the "disabled" property */
+          g_object_notify_by_pspec (G_OBJECT (child),
+                                    widget_properties[PROP_DISABLED]);
         }
 
-      _mx_widget_propagate_disabled (child, disabled);
+      mx_widget_propagate_disabled_internal (child, disabled);
     }
 }
 
+/* The pseudo-class changes of the whole subtree go in one style update
+ * batch, so that each widget is restyled once, rather than once for its
+ * own change and again for those of its ancestors */
+static void
+_mx_widget_propagate_disabled (ClutterActor *container,
+                               gboolean      disabled)
+{
+  mx_stylable_begin_update ();
+  mx_widget_propagate_disabled_internal (container, disabled);
+  mx_stylable_end_update ();
+}
+
 static void
 mx_widget_parent_set (ClutterActor *actor,
                       ClutterActor *old_parent)
@@ -1153,17 +1701,75 @@ mx_widget_parent_set (ClutterActor *actor,
     }
 }
 
+/* Adds the paint volume of @child, painted from mx_widget_paint() wherever
+ * it is placed, to @volume */
+static gboolean
+mx_widget_union_child_volume (ClutterActor       *actor,
+                              ClutterActor       *child,
+                              ClutterPaintVolume *volume)
+{
+  const ClutterPaintVolume *child_volume;
+
+  if (!child || !CLUTTER_ACTOR_IS_VISIBLE (child))
+    return TRUE;
+
+  child_volume = clutter_actor_get_transformed_paint_volume (child, actor);
+  if (!child_volume)
+    return FALSE;
+
+  clutter_paint_volume_union (volume, child_volume);
+
+  return TRUE;
+}
+
 static gboolean
 mx_widget_get_paint_volume (ClutterActor       *actor,
                             ClutterPaintVolume *volume)
 {
+  MxWidgetPrivate *priv = MX_WIDGET (actor)->priv;
+
   /* the allocation of scrollable widgets cannot be used as the paint volume
    * because it does not account for any transformations applied during
    * scrolling */
   if (MX_IS_SCROLLABLE (actor))
     return FALSE;
 
-  return clutter_paint_volume_set_from_allocation (volume, actor);
+  if (!clutter_paint_volume_set_from_allocation (volume, actor))
+    return FALSE;
+
+  /* the tooltip and the menu usually reach out of the allocation; leaving
+   * them out would leave their pixels behind in clipped redraws */
+  if (!priv->extra)
+    return TRUE;
+
+  return mx_widget_union_child_volume (actor,
+                                       CLUTTER_ACTOR (priv->extra->tooltip),
+                                       volume) &&
+         mx_widget_union_child_volume (actor,
+                                       CLUTTER_ACTOR (priv->extra->menu),
+                                       volume);
+}
+
+static void
+mx_widget_map (ClutterActor *actor)
+{
+  MxWidgetPrivate *priv = MX_WIDGET (actor)->priv;
+
+  /* deferred children are added before chaining up, which maps them along
+   * with the others */
+  if (priv->extra && priv->extra->deferred_children)
+    {
+      GError *error = NULL;
+
+      if (!mx_widget_ensure_deferred_children (MX_WIDGET (actor), &error))
+        {
+          g_warning ("Could not build the deferred children of %s: %s",
+                     G_OBJECT_TYPE_NAME (actor), error->message);
+          g_error_free (error);
+        }
+    }
+
+  CLUTTER_ACTOR_CLASS (mx_widget_parent_class)->map (actor);
 }
 
 static void
@@ -1191,6 +1797,7 @@ mx_widget_class_init (MxWidgetClass *klass)
   actor_class->touch_event = mx_widget_touch_event;
 
   actor_class->hide = mx_widget_hide;
+  actor_class->map = mx_widget_map;
   actor_class->parent_set = mx_widget_parent_set;
 
   actor_class->get_paint_volume = mx_widget_get_paint_volume;
@@ -1258,6 +1865,27 @@ mx_widget_class_init (MxWidgetClass *klass)
   g_object_class_install_property (gobject_class, PROP_TOOLTIP_DELAY,
                                    widget_properties[PROP_TOOLTIP_DELAY]);
 
+  /**
+   * MxWidget:cache-subtree:
+   *
+   * Whether to keep the rendering of the widget and its children in an
+   * offscreen texture, painted again only when something inside the widget
+   * queues a redraw, such as a style change. Painting the widget otherwise
+   * costs a single textured rectangle, which suits complex widgets that
+   * rarely change, at the cost of the memory of the texture.
+   *
+   * Since: 2.0
+   */
+  widget_properties[PROP_CACHE_SUBTREE] =
+    g_param_spec_boolean ("cache-subtree",
+                          "Cache subtree",
+                          "Whether to keep the rendering of the widget "
+                          "and its children in a texture",
+                          FALSE,
+                          MX_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_CACHE_SUBTREE,
+                                   widget_properties[PROP_CACHE_SUBTREE]);
+
   /**
    * MxWidget::long-press:
    * @widget: the object that received the signal
@@ -1275,6 +1903,25 @@ mx_widget_class_init (MxWidgetClass *klass)
                   G_TYPE_BOOLEAN, 3, G_TYPE_FLOAT, G_TYPE_FLOAT,
                   MX_TYPE_LONG_PRESS_ACTION);
 
+  /**
+   * MxWidget::deferred-children-created:
+   * @widget: the object that received the signal
+   *
+   * Emitted once the children given in the "deferred-children" property of
+   * the #ClutterScript definition of @widget have been created and added
+   * to it, see mx_widget_ensure_deferred_children().
+   *
+   * Since: 2.0
+   */
+  widget_signals[DEFERRED_CHILDREN_CREATED] =
+    g_signal_new ("deferred-children-created",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
+
 }
 
 static MxStyle *
@@ -1331,6 +1978,8 @@ _mx_stylable_set_style_pseudo_class (MxStylable  *actor,
     {
       g_free (priv->pseudo_class);
       priv->pseudo_class = g_strdup (pseudo_class);
+      priv->pseudo_class_mask = _mx_stylable_pseudo_class_to_mask (pseudo_class,
+                                                                   NULL);
 
       g_object_notify_by_pspec (G_OBJECT (actor),
                                 widget_properties[PROP_STYLE_PSEUDO_CLASS]);
@@ -1350,6 +1999,18 @@ _mx_widget_get_style_class (MxStylable *actor)
   return ((MxWidget *) actor)->priv->style_class;
 }
 
+guint64
+_mx_widget_get_style_pseudo_class_mask (MxWidget *widget)
+{
+  return widget->priv->pseudo_class_mask;
+}
+
+
+static gpointer *
+mx_widget_get_style_cache (MxStylable *stylable)
+{
+  return &MX_WIDGET (stylable)->priv->style_cache;
+}
 
 static void
 mx_stylable_iface_init (MxStylableIface *iface)
@@ -1507,6 +2168,8 @@ mx_stylable_iface_init (MxStylableIface *iface)
       iface->set_style_pseudo_class = _mx_stylable_set_style_pseudo_class;
       iface->get_style_class = _mx_widget_get_style_class;
       iface->set_style_class = _mx_widget_set_style_class;
+
+      iface->get_style_cache = mx_widget_get_style_cache;
     }
 }
 
@@ -1518,9 +2181,6 @@ mx_widget_init (MxWidget *actor)
   actor->priv->css_width = -1;
   actor->priv->css_height = -1;
 
-  actor->priv->old_opacity = -1;
-  actor->priv->old_visible = -1;
-
   /* set the default style */
   mx_stylable_set_style (MX_STYLABLE (actor), mx_style_get_default ());
 
@@ -1559,7 +2219,7 @@ ClutterColor *
 mx_widget_get_background_color (MxWidget *actor)
 {
   MxWidgetPrivate *priv = MX_WIDGET (actor)->priv;
-  return priv->bg_color;
+  return priv->has_bg_color ? &priv->bg_color : NULL;
 }
 
 /**
@@ -1581,6 +2241,79 @@ mx_widget_get_padding (MxWidget  *widget,
   *padding = widget->priv->padding;
 }
 
+/* Widgets share one tooltip per stage: the widget showing its text holds
+ * it as a child, so that it is positioned and painted as before, and the
+ * next widget to show a tooltip takes it over. */
+static GQuark
+mx_widget_tooltip_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (G_UNLIKELY (!quark))
+    quark = g_quark_from_static_string ("mx-widget-stage-tooltip");
+
+  return quark;
+}
+
+static void
+mx_widget_release_tooltip (MxWidget *widget)
+{
+  MxWidgetExtra *extra = widget->priv->extra;
+  ClutterActor *tooltip;
+
+  if (!extra || !extra->tooltip)
+    return;
+
+  tooltip = CLUTTER_ACTOR (extra->tooltip);
+  extra->tooltip = NULL;
+
+  /* the next widget fades it in from transparent; the stage keeps a
+   * reference on it */
+  clutter_actor_set_opacity (tooltip, 0);
+  clutter_actor_hide (tooltip);
+  clutter_actor_remove_child (CLUTTER_ACTOR (widget), tooltip);
+}
+
+static gboolean
+mx_widget_claim_tooltip (MxWidget *widget)
+{
+  MxWidgetExtra *extra = widget->priv->extra;
+  ClutterActor *stage, *tooltip, *owner;
+
+  if (!extra || !extra->tooltip_text)
+    return FALSE;
+
+  if (!extra->tooltip)
+    {
+      stage = clutter_actor_get_stage (CLUTTER_ACTOR (widget));
+      if (!stage)
+        return FALSE;
+
+      tooltip = g_object_get_qdata (G_OBJECT (stage),
+                                    mx_widget_tooltip_quark ());
+      if (!tooltip)
+        {
+          tooltip = g_object_new (MX_TYPE_TOOLTIP, NULL);
+          g_object_set_qdata_full (G_OBJECT (stage),
+                                   mx_widget_tooltip_quark (),
+                                   g_object_ref_sink (tooltip),
+                                   g_object_unref);
+        }
+
+      owner = clutter_actor_get_parent (tooltip);
+      if (MX_IS_WIDGET (owner))
+        mx_widget_release_tooltip (MX_WIDGET (owner));
+
+      clutter_actor_add_child (CLUTTER_ACTOR (widget), tooltip);
+      extra->tooltip = MX_TOOLTIP (tooltip);
+    }
+
+  if (g_strcmp0 (mx_tooltip_get_text (extra->tooltip), extra->tooltip_text))
+    mx_tooltip_set_text (extra->tooltip, extra->tooltip_text);
+
+  return TRUE;
+}
+
 static void
 mx_widget_set_has_tooltip (MxWidget *widget,
                            gboolean  has_tooltip)
@@ -1598,22 +2331,13 @@ mx_widget_set_has_tooltip (MxWidget *widget,
     {
       clutter_actor_set_reactive (actor, TRUE);
 
-      if (!priv->tooltip)
-        {
-          priv->tooltip = g_object_new (MX_TYPE_TOOLTIP, NULL);
-          clutter_actor_add_child (actor, CLUTTER_ACTOR (priv->tooltip));
-          if (mx_stylable_style_pseudo_class_contains (MX_STYLABLE (widget), "hover"))
-            mx_widget_show_tooltip (widget);
-        }
+      if (mx_stylable_style_pseudo_class_contains (MX_STYLABLE (widget),
+                                                   "hover"))
+        mx_widget_show_tooltip (widget);
     }
   else
     {
-      if (priv->tooltip)
-        {
-          clutter_actor_remove_child (actor, CLUTTER_ACTOR (priv->tooltip));
-          priv->tooltip = NULL;
-        }
-
+      mx_widget_release_tooltip (widget);
       mx_widget_remove_tooltip_timeout (widget);
     }
 }
@@ -1633,30 +2357,31 @@ void
 mx_widget_set_tooltip_text (MxWidget    *widget,
                             const gchar *text)
 {
-  MxWidgetPrivate *priv;
+  MxWidgetExtra *extra;
   const gchar *old_text;
+  gboolean had_text;
 
   g_return_if_fail (MX_IS_WIDGET (widget));
 
-  priv = widget->priv;
-
-  if (priv->tooltip)
-    old_text = mx_tooltip_get_text (priv->tooltip);
-  else
-    old_text = NULL;
+  old_text = mx_widget_get_tooltip_text (widget);
 
   /* Don't do anything if the text hasn't changed */
   if ((text == old_text) ||
       (text && old_text && g_str_equal (text, old_text)))
     return;
 
+  had_text = (old_text != NULL);
+
+  extra = mx_widget_get_extra (widget);
+  g_free (extra->tooltip_text);
+  extra->tooltip_text = g_strdup (text);
+
   if (text == NULL)
     mx_widget_set_has_tooltip (widget, FALSE);
-  else
+  else if (!had_text)
     mx_widget_set_has_tooltip (widget, TRUE);
-
-  if (priv->tooltip)
-    mx_tooltip_set_text (priv->tooltip, text);
+  else if (extra->tooltip)
+    mx_tooltip_set_text (extra->tooltip, text);
 
   g_object_notify_by_pspec (G_OBJECT (widget),
                             widget_properties[PROP_TOOLTIP_TEXT]);
@@ -1673,15 +2398,12 @@ mx_widget_set_tooltip_text (MxWidget    *widget,
 const gchar*
 mx_widget_get_tooltip_text (MxWidget *widget)
 {
-  MxWidgetPrivate *priv;
-
   g_return_val_if_fail (MX_IS_WIDGET (widget), NULL);
-  priv = widget->priv;
 
-  if (!priv->tooltip)
+  if (!widget->priv->extra)
     return NULL;
 
-  return mx_tooltip_get_text (widget->priv->tooltip);
+  return widget->priv->extra->tooltip_text;
 }
 
 /**
@@ -1730,10 +2452,10 @@ mx_widget_show_tooltip (MxWidget *widget)
   area.height = y2 - y;
 
 
-  if (widget->priv->tooltip)
+  if (mx_widget_claim_tooltip (widget))
     {
-      mx_tooltip_set_tip_area (widget->priv->tooltip, &area);
-      mx_tooltip_show (widget->priv->tooltip);
+      mx_tooltip_set_tip_area (widget->priv->extra->tooltip, &area);
+      mx_tooltip_show (widget->priv->extra->tooltip);
     }
 }
 
@@ -1751,8 +2473,8 @@ mx_widget_hide_tooltip (MxWidget *widget)
 
   mx_widget_remove_tooltip_timeout (widget);
 
-  if (widget->priv->tooltip)
-    mx_tooltip_hide (widget->priv->tooltip);
+  if (widget->priv->extra && widget->priv->extra->tooltip)
+    mx_tooltip_hide (widget->priv->extra->tooltip);
 }
 
 /**
@@ -1792,17 +2514,17 @@ void
 mx_widget_set_menu (MxWidget *widget,
                     MxMenu   *menu)
 {
-  MxWidgetPrivate *priv = widget->priv;
+  MxWidgetExtra *extra = widget->priv->extra;
 
-  if (priv->menu)
+  if (extra && extra->menu)
     {
-      clutter_actor_destroy (CLUTTER_ACTOR (priv->menu));
-      priv->menu = NULL;
+      clutter_actor_destroy (CLUTTER_ACTOR (extra->menu));
+      extra->menu = NULL;
     }
 
   if (menu)
     {
-      priv->menu = menu;
+      mx_widget_get_extra (widget)->menu = menu;
       clutter_actor_add_child (CLUTTER_ACTOR (widget), CLUTTER_ACTOR (menu));
     }
 
@@ -1820,7 +2542,7 @@ mx_widget_set_menu (MxWidget *widget,
 MxMenu *
 mx_widget_get_menu (MxWidget *widget)
 {
-  return widget->priv->menu;
+  return widget->priv->extra ? widget->priv->extra->menu : NULL;
 }
 
 /**
@@ -1845,22 +2567,24 @@ mx_widget_set_disabled (MxWidget *widget,
     {
       priv->is_disabled = disabled;
 
+      /* Propagate the disabled state to our children, if necessary; the
+       * change of pseudo-class restyles the widget, in the same batch as
+       * its children */
+      mx_stylable_begin_update ();
+
+      /* a widget whose parent is disabled stays disabled */
       if (disabled)
         mx_stylable_style_pseudo_class_add (MX_STYLABLE (widget), "disabled");
-      else
+      else if (!priv->parent_disabled)
         mx_stylable_style_pseudo_class_remove (MX_STYLABLE (widget), "disabled");
 
-      /* Propagate the disabled state to our children, if necessary */
       if (!priv->parent_disabled)
         _mx_widget_propagate_disabled ((ClutterActor*) widget, disabled);
 
-      /* when a widget is disabled, get_style_pseudo_class will always return
-       * "disabled" */
+      mx_stylable_end_update ();
 
       clutter_actor_queue_relayout (CLUTTER_ACTOR (widget));
 
-      mx_stylable_style_changed (MX_STYLABLE (widget), 0);
-
       g_object_notify_by_pspec (G_OBJECT (widget),
                                 widget_properties[PROP_DISABLED]);
     }
@@ -1892,9 +2616,9 @@ mx_widget_set_tooltip_delay (MxWidget *widget,
 {
   g_return_if_fail (MX_IS_WIDGET (widget));
 
-  if (widget->priv->tooltip_delay != delay)
+  if (mx_widget_get_tooltip_delay (widget) != delay)
     {
-      widget->priv->tooltip_delay = delay;
+      mx_widget_get_extra (widget)->tooltip_delay = delay;
       g_object_notify_by_pspec (G_OBJECT (widget),
                                 widget_properties[PROP_TOOLTIP_DELAY]);
     }
@@ -1913,7 +2637,108 @@ mx_widget_get_tooltip_delay (MxWidget *widget)
 {
   g_return_val_if_fail (MX_IS_WIDGET (widget), 0);
 
-  return widget->priv->tooltip_delay;
+  if (!widget->priv->extra)
+    return MX_WIDGET_TOOLTIP_TIMEOUT;
+
+  return widget->priv->extra->tooltip_delay;
+}
+
+/**
+ * mx_widget_set_cache_subtree:
+ * @widget: an #MxWidget
+ * @cache: %TRUE to keep the rendering of @widget in a texture
+ *
+ * Sets the value of the #MxWidget:cache-subtree property.
+ *
+ * The texture is the offscreen redirection of #ClutterActor, which Clutter
+ * only paints again when a redraw is queued on the widget or one of its
+ * children, so any change that would show, including style changes,
+ * updates it.
+ *
+ * Since: 2.0
+ */
+void
+mx_widget_set_cache_subtree (MxWidget *widget,
+                             gboolean  cache)
+{
+  MxWidgetPrivate *priv;
+  ClutterActor *actor;
+
+  g_return_if_fail (MX_IS_WIDGET (widget));
+
+  priv = widget->priv;
+  actor = CLUTTER_ACTOR (widget);
+
+  if (priv->cache_subtree == cache)
+    return;
+
+  priv->cache_subtree = cache;
+
+  if (cache)
+    {
+      priv->old_offscreen_redirect =
+        clutter_actor_get_offscreen_redirect (actor);
+      clutter_actor_set_offscreen_redirect (actor,
+                                            CLUTTER_OFFSCREEN_REDIRECT_ALWAYS);
+    }
+  else
+    clutter_actor_set_offscreen_redirect (actor,
+                                          priv->old_offscreen_redirect);
+
+  g_object_notify_by_pspec (G_OBJECT (widget),
+                            widget_properties[PROP_CACHE_SUBTREE]);
+}
+
+/**
+ * mx_widget_get_cache_subtree:
+ * @widget: an #MxWidget
+ *
+ * Gets the value of the #MxWidget:cache-subtree property.
+ *
+ * Returns: %TRUE if the rendering of @widget is kept in a texture
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_widget_get_cache_subtree (MxWidget *widget)
+{
+  g_return_val_if_fail (MX_IS_WIDGET (widget), FALSE);
+
+  return widget->priv->cache_subtree;
+}
+
+/* The definition of the deferred children is kept as the string it is
+ * given in; were it JSON objects, ClutterScript would build them along
+ * with the rest */
+static gboolean
+widget_scriptable_parse_custom_node (ClutterScriptable *scriptable,
+                                     ClutterScript     *script,
+                                     GValue            *value,
+                                     const gchar       *name,
+                                     const JsonNode    *node)
+{
+  if (strcmp (name, "deferred-children") == 0)
+    {
+      if (JSON_NODE_TYPE (node) != JSON_NODE_VALUE ||
+          json_node_get_value_type (node) != G_TYPE_STRING)
+        {
+          g_warning ("The deferred-children of a %s must be a file name "
+                     "or a string of JSON data",
+                     G_OBJECT_TYPE_NAME (scriptable));
+          return FALSE;
+        }
+
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_string (value, json_node_get_string (node));
+
+      return TRUE;
+    }
+
+  if (parent_scriptable_iface->parse_custom_node)
+    return parent_scriptable_iface->parse_custom_node (scriptable, script,
+                                                       value, name, node);
+
+  return FALSE;
 }
 
 /* Support translateable strings from JSON */
@@ -1925,6 +2750,23 @@ widget_scriptable_set_custom_property (ClutterScriptable *scriptable,
 {
   GParamSpec *pspec;
 
+  if (strcmp (name, "deferred-children") == 0)
+    {
+      MxWidgetExtra *extra = mx_widget_get_extra (MX_WIDGET (scriptable));
+
+      g_free (extra->deferred_children);
+      extra->deferred_children = g_value_dup_string (value);
+
+      if (extra->deferred_script)
+        g_object_remove_weak_pointer (G_OBJECT (extra->deferred_script),
+                                      (gpointer *) &extra->deferred_script);
+      extra->deferred_script = script;
+      g_object_add_weak_pointer (G_OBJECT (script),
+                                 (gpointer *) &extra->deferred_script);
+
+      return;
+    }
+
   pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (scriptable), name);
 
   if (pspec && pspec->flags & MX_PARAM_TRANSLATEABLE &&
@@ -1952,50 +2794,245 @@ scriptable_iface_init (ClutterScriptableIface *iface)
     parent_scriptable_iface = g_type_default_interface_peek
                                           (CLUTTER_TYPE_SCRIPTABLE);
 
+  iface->parse_custom_node = widget_scriptable_parse_custom_node;
   iface->set_custom_property = widget_scriptable_set_custom_property;
 }
 
+/* Reads the definition of the deferred children, giving each of the
+ * objects at the top an id to find it by once it is built */
+static gchar *
+mx_widget_load_deferred_children (ClutterScript  *script,
+                                  const gchar    *deferred,
+                                  gchar        ***ids,
+                                  GError        **error)
+{
+  static guint next_id = 0;
+  JsonGenerator *generator;
+  JsonParser *parser;
+  JsonArray *array;
+  JsonNode *root;
+  GPtrArray *found;
+  gboolean loaded;
+  gchar *data;
+  guint i, length;
+
+  parser = json_parser_new ();
+
+  while (g_ascii_isspace (*deferred))
+    deferred++;
+
+  if (*deferred == '[' || *deferred == '{')
+    loaded = json_parser_load_from_data (parser, deferred, -1, error);
+  else
+    {
+      gchar *path = clutter_script_lookup_filename (script, deferred);
+
+      loaded = FALSE;
+      if (!path)
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT,
+                     "Could not find the file '%s'", deferred);
+      else
+        {
+          loaded = json_parser_load_from_file (parser, path, error);
+          g_free (path);
+        }
+    }
+
+  if (!loaded)
+    {
+      g_object_unref (parser);
+      return NULL;
+    }
+
+  root = json_parser_get_root (parser);
+  if (root && JSON_NODE_TYPE (root) == JSON_NODE_OBJECT)
+    {
+      array = json_array_new ();
+      json_array_add_element (array, json_node_copy (root));
+      root = json_node_new (JSON_NODE_ARRAY);
+      json_node_take_array (root, array);
+    }
+  else if (root && JSON_NODE_TYPE (root) == JSON_NODE_ARRAY)
+    root = json_node_copy (root);
+  else
+    {
+      g_set_error (error, CLUTTER_SCRIPT_ERROR,
+                   CLUTTER_SCRIPT_ERROR_INVALID_VALUE,
+                   "Deferred children must be an object or an array");
+      g_object_unref (parser);
+      return NULL;
+    }
+  g_object_unref (parser);
+
+  array = json_node_get_array (root);
+  length = json_array_get_length (array);
+  found = g_ptr_array_new ();
+
+  for (i = 0; i < length; i++)
+    {
+      JsonNode *element = json_array_get_element (array, i);
+      JsonObject *object;
+      const gchar *id;
+
+      if (JSON_NODE_TYPE (element) != JSON_NODE_OBJECT)
+        continue;
+
+      object = json_node_get_object (element);
+      if (!json_object_has_member (object, "type"))
+        continue;
+
+      if (!json_object_has_member (object, "id"))
+        {
+          gchar *new_id = g_strdup_printf ("mx-deferred-%u", next_id++);
+
+          json_object_set_string_member (object, "id", new_id);
+          g_free (new_id);
+        }
+
+      id = json_object_get_string_member (object, "id");
+      g_ptr_array_add (found, g_strdup (id));
+    }
+
+  g_ptr_array_add (found, NULL);
+  *ids = (gchar **) g_ptr_array_free (found, FALSE);
+
+  generator = json_generator_new ();
+  json_generator_set_root (generator, root);
+  data = json_generator_to_data (generator, NULL);
+  g_object_unref (generator);
+  json_node_free (root);
+
+  return data;
+}
+
+/**
+ * mx_widget_ensure_deferred_children:
+ * @widget: an #MxWidget
+ * @error: a pointer to a #GError, or %NULL
+ *
+ * Builds the children given in the "deferred-children" property of the
+ * #ClutterScript definition of @widget, and adds them to it. This happens
+ * when @widget is first mapped; this function is for when the children
+ * are needed before then, for instance to look them up with
+ * clutter_script_get_object(). It does nothing if there are none left to
+ * build.
+ *
+ * The objects are added to the #ClutterScript @widget was built from, so
+ * their ids can be looked up in it.
+ *
+ * Returns: %FALSE if the definition of the children couldn't be loaded
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_widget_ensure_deferred_children (MxWidget  *widget,
+                                    GError   **error)
+{
+  MxWidgetExtra *extra;
+  ClutterScript *script;
+  GError *err = NULL;
+  gchar *deferred, *data, **ids = NULL;
+  guint i;
+
+  g_return_val_if_fail (MX_IS_WIDGET (widget), FALSE);
+
+  extra = widget->priv->extra;
+  if (!extra || !extra->deferred_children)
+    return TRUE;
+
+  /* taken first, so that this is done once even if it fails */
+  deferred = extra->deferred_children;
+  extra->deferred_children = NULL;
+
+  /* a script that has gone away still has its file names resolved
+   * through the search path */
+  script = extra->deferred_script;
+  if (script)
+    {
+      g_object_remove_weak_pointer (G_OBJECT (script),
+                                    (gpointer *) &extra->deferred_script);
+      extra->deferred_script = NULL;
+      g_object_ref (script);
+    }
+  else
+    script = clutter_script_new ();
+
+  data = mx_widget_load_deferred_children (script, deferred, &ids, &err);
+  g_free (deferred);
+
+  if (data && clutter_script_load_from_data (script, data, -1, &err))
+    {
+      for (i = 0; ids[i]; i++)
+        {
+          GObject *object;
+
+          /* added the way ClutterScript adds children, so that
+           * containers keeping lists of their own, such as MxNotebook,
+           * see them */
+          object = clutter_script_get_object (script, ids[i]);
+          if (CLUTTER_IS_ACTOR (object))
+            clutter_container_add_actor (CLUTTER_CONTAINER (widget),
+                                         CLUTTER_ACTOR (object));
+        }
+
+      g_signal_emit (widget, widget_signals[DEFERRED_CHILDREN_CREATED], 0);
+    }
+
+  g_free (data);
+  g_strfreev (ids);
+  g_object_unref (script);
+
+  if (err)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
 void
 _mx_widget_add_touch_sequence (MxWidget             *widget,
                                ClutterEventSequence *sequence)
 {
-  MxWidgetPrivate *priv = widget->priv;
+  MxWidgetExtra *extra;
 
   if (sequence == NULL)
     return;
 
-  if (!priv->sequences)
-    priv->sequences = g_hash_table_new_full (g_direct_hash,
-                                             g_direct_equal,
-                                             NULL, NULL);
+  extra = mx_widget_get_extra (widget);
+  if (!extra->sequences)
+    extra->sequences = g_hash_table_new_full (g_direct_hash,
+                                              g_direct_equal,
+                                              NULL, NULL);
 
-  g_hash_table_add (priv->sequences, sequence);
+  g_hash_table_add (extra->sequences, sequence);
 }
 
 void
 _mx_widget_remove_touch_sequence (MxWidget             *widget,
                                   ClutterEventSequence *sequence)
 {
-  MxWidgetPrivate *priv = widget->priv;
+  MxWidgetExtra *extra = widget->priv->extra;
 
   if (sequence == NULL)
     return;
 
-  if (priv->sequences)
-    g_hash_table_remove (priv->sequences, sequence);
+  if (extra && extra->sequences)
+    g_hash_table_remove (extra->sequences, sequence);
 }
 
 gboolean
 _mx_widget_has_touch_sequence (MxWidget             *widget,
                                ClutterEventSequence *sequence)
 {
-  MxWidgetPrivate *priv = widget->priv;
+  MxWidgetExtra *extra = widget->priv->extra;
 
   if (sequence == NULL)
     return TRUE;
 
-  if (priv->sequences)
-    return g_hash_table_contains (priv->sequences, sequence);
+  if (extra && extra->sequences)
+    return g_hash_table_contains (extra->sequences, sequence);
 
   return FALSE;
 }
@@ -2003,12 +3040,66 @@ _mx_widget_has_touch_sequence (MxWidget             *widget,
 gboolean
 _mx_widget_has_touch_sequences (MxWidget *widget)
 {
+  MxWidgetExtra *extra = widget->priv->extra;
 
-  MxWidgetPrivate *priv = widget->priv;
-
-  if (priv->sequences)
-    return g_hash_table_size (priv->sequences) != 0;
+  if (extra && extra->sequences)
+    return g_hash_table_size (extra->sequences) != 0;
 
   return FALSE;
 
 }
+
+/* The snapshot is rendered at the first paint of the clone, rather than
+ * when it is created, as rendering needs to happen while painting. It is
+ * rendered at the allocation of the widget, as clutter_actor_paint()
+ * applies the transformation of the widget */
+static void
+mx_widget_dnd_clone_paint (ClutterActor *clone,
+                           ClutterActor *source)
+{
+  CoglHandle texture;
+  gfloat width, height;
+
+  texture = g_object_get_data (G_OBJECT (clone), "mx-dnd-snapshot");
+  if (!texture)
+    {
+      ClutterActorBox box;
+
+      clutter_actor_get_allocation_box (source, &box);
+      texture = _mx_render_to_texture (&box,
+                                       (MxRenderFunc) clutter_actor_paint,
+                                       source);
+      if (!texture)
+        return;
+
+      g_object_set_data_full (G_OBJECT (clone), "mx-dnd-snapshot", texture,
+                              (GDestroyNotify) cogl_handle_unref);
+    }
+
+  clutter_actor_get_size (clone, &width, &height);
+  _mx_paint_texture_with_opacity (texture,
+                                  clutter_actor_get_paint_opacity (clone),
+                                  0, 0, width, height);
+}
+
+/* Creates an actor that paints @widget as it was when the actor was first
+ * painted, from a texture, so that dragging it around costs a textured
+ * rectangle a frame instead of painting the widget again */
+ClutterActor *
+_mx_widget_get_dnd_clone (MxWidget *widget)
+{
+  ClutterActor *clone;
+  gfloat width, height;
+
+  g_return_val_if_fail (MX_IS_WIDGET (widget), NULL);
+
+  clone = clutter_actor_new ();
+  clutter_actor_get_size (CLUTTER_ACTOR (widget), &width, &height);
+  clutter_actor_set_size (clone, width, height);
+
+  g_signal_connect_object (clone, "paint",
+                           G_CALLBACK (mx_widget_dnd_clone_paint),
+                           widget, 0);
+
+  return clone;
+}
@@ -122,6 +122,13 @@ void mx_widget_long_press_cancel (MxWidget           *widget);
 void   mx_widget_set_tooltip_delay (MxWidget *widget, guint delay);
 guint  mx_widget_get_tooltip_delay (MxWidget *widget);
 
+void     mx_widget_set_cache_subtree (MxWidget *widget,
+                                      gboolean  cache);
+gboolean mx_widget_get_cache_subtree (MxWidget *widget);
+
+gboolean mx_widget_ensure_deferred_children (MxWidget  *widget,
+                                             GError   **error);
+
 /* Only to be used by sub-classes of MxWidget */
 ClutterColor *mx_widget_get_background_color (MxWidget  *actor);
 CoglHandle    mx_widget_get_background_texture (MxWidget *actor);
@@ -39,6 +39,12 @@
 #include "config.h"
 #endif
 
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib/gstdio.h>
+
 #include "mx-window.h"
 #include "mx-native-window.h"
 #include "mx-toolbar.h"
@@ -65,7 +71,10 @@ struct _MxWindowPrivate
   guint has_toolbar   : 1;
   guint small_screen  : 1;
   guint fullscreen    : 1;
-  guint rotate_size   : 1;
+  guint cross_fade    : 1;
+  guint collect_stats : 1;
+  guint painted       : 1;
+  guint has_opaque_region : 1;
 
   gchar      *icon_name;
   CoglHandle  icon_texture;
@@ -76,11 +85,30 @@ struct _MxWindowPrivate
   ClutterActor *resize_grip;
   ClutterActor *debug_actor;
 
+  /* with MX_DEBUG=redraws, the actors that queued a redraw since the last
+   * frame, with why, and the number of the frame */
+  GHashTable   *debug_redraws;
+  guint         debug_frame;
+
+  /* where the child is laid out, and the part of the window last told to
+   * be opaque, if has_opaque_region is set */
+  ClutterActorBox   child_box;
+  ClutterActorBox   opaque_region;
+
   MxWindowRotation  rotation;
   ClutterTimeline  *rotation_timeline;
   gfloat            start_angle;
   gfloat            end_angle;
   gfloat            angle;
+  CoglHandle        rotation_snapshot;
+
+  /* what this window spent in the frame being collected, the rest is
+   * gathered in frame_stats_pending */
+  MxFrameStats      frame_stats;
+  gint64            paint_start;
+  gint64            pick_start;
+  guint             frame_start_id;
+  guint             frame_end_id;
 };
 
 #define WINDOW_PRIVATE(o) \
@@ -102,18 +130,27 @@ enum
   PROP_CHILD,
   PROP_WINDOW_ROTATION,
   PROP_WINDOW_ROTATION_TIMELINE,
-  PROP_WINDOW_ROTATION_ANGLE
+  PROP_WINDOW_ROTATION_ANGLE,
+  PROP_WINDOW_ROTATION_CROSS_FADE
 };
 
 enum
 {
   DESTROY,
+  FRAME_STATS,
 
   LAST_SIGNAL
 };
 
 static guint signals[LAST_SIGNAL] = { 0, };
 
+/* the number of windows collecting frame statistics, and what was spent
+ * outside of the phases the windows time themselves since the last
+ * statistics were reported */
+static guint frame_stats_collectors = 0;
+static MxFrameStats frame_stats_pending = { 0, };
+static guint frame_stats_depth[MX_FRAME_STATS_N_TIMES] = { 0, };
+
 static void
 mx_window_get_property (GObject    *object,
                         guint       property_id,
@@ -173,6 +210,10 @@ mx_window_get_property (GObject    *object,
       g_value_set_float (value, priv->angle);
       break;
 
+    case PROP_WINDOW_ROTATION_CROSS_FADE:
+      g_value_set_boolean (value, priv->cross_fade);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -232,6 +273,11 @@ mx_window_set_property (GObject      *object,
       mx_window_set_window_rotation (window, g_value_get_enum (value));
       break;
 
+    case PROP_WINDOW_ROTATION_CROSS_FADE:
+      mx_window_set_window_rotation_cross_fade (window,
+                                                g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -243,6 +289,24 @@ mx_window_dispose (GObject *object)
   MxWindow *self = MX_WINDOW (object);
   MxWindowPrivate *priv = self->priv;
 
+  if (priv->frame_start_id)
+    {
+      clutter_threads_remove_repaint_func (priv->frame_start_id);
+      priv->frame_start_id = 0;
+    }
+
+  if (priv->frame_end_id)
+    {
+      clutter_threads_remove_repaint_func (priv->frame_end_id);
+      priv->frame_end_id = 0;
+    }
+
+  if (priv->collect_stats)
+    {
+      priv->collect_stats = FALSE;
+      frame_stats_collectors--;
+    }
+
   if (priv->icon_texture)
     {
       cogl_handle_unref (priv->icon_texture);
@@ -280,6 +344,12 @@ mx_window_dispose (GObject *object)
       priv->rotation_timeline = NULL;
     }
 
+  if (priv->rotation_snapshot)
+    {
+      cogl_handle_unref (priv->rotation_snapshot);
+      priv->rotation_snapshot = NULL;
+    }
+
   G_OBJECT_CLASS (mx_window_parent_class)->dispose (object);
 }
 
@@ -290,47 +360,38 @@ mx_window_finalize (GObject *object)
 
   g_free (priv->icon_name);
 
+  if (priv->debug_redraws)
+    g_hash_table_destroy (priv->debug_redraws);
+
   G_OBJECT_CLASS (mx_window_parent_class)->finalize (object);
 }
 
+/* The size of the window content is that of the target rotation, also
+ * while the rotation is animated: the content is laid out once and only its
+ * rotation angle changes from frame to frame. */
 static void
 mx_window_get_size (MxWindow *window, gfloat *width, gfloat *height)
 {
-  gfloat stage_width, stage_height, scale, angle;
+  gfloat stage_width, stage_height;
   MxWindowPrivate *priv = window->priv;
 
   clutter_actor_get_size (priv->stage, &stage_width, &stage_height);
 
-  /* Normalise the angle */
-  angle = priv->angle;
-  while (angle < 0)
-    angle += 360.f;
-  while (angle >= 360.f)
-    angle -= 360.f;
-
-  /* Interpolate between width and height depending on rotation */
-  if (!clutter_timeline_is_playing (priv->rotation_timeline) ||
-      priv->rotate_size)
+  if ((priv->rotation == MX_WINDOW_ROTATION_0) ||
+      (priv->rotation == MX_WINDOW_ROTATION_180))
     {
-      if (angle <= 90.f)
-        scale = angle / 90.f;
-      else if (angle <= 180.f)
-        scale = 1.f - (angle - 90.f) / 90.f;
-      else if (angle <= 270.f)
-        scale = (angle - 180.f) / 90.f;
-      else
-        scale = 1.f - (angle - 270.f) / 90.f;
+      if (width)
+        *width = stage_width;
+      if (height)
+        *height = stage_height;
     }
-  else if ((priv->rotation == MX_WINDOW_ROTATION_0) ||
-           (priv->rotation == MX_WINDOW_ROTATION_180))
-    scale = 0;
   else
-    scale = 1;
-
-  if (width)
-    *width = (scale * stage_height) + ((1.f - scale) * stage_width);
-  if (height)
-    *height = (scale * stage_width) + ((1.f - scale) * stage_height);
+    {
+      if (width)
+        *width = stage_height;
+      if (height)
+        *height = stage_width;
+    }
 }
 
 static void
@@ -462,6 +523,204 @@ debug_captured_event (ClutterActor *actor,
   return FALSE;
 }
 
+/* With MX_RECORD_EVENTS set to a file name, the pointer, touch and scroll
+ * events of every window are written to it, one per line, for the input
+ * benchmarks in tests/bench to replay:
+ *
+ *   <time> <type> <x> <y> <modifiers> <detail...>
+ *
+ * where the detail is the button and click count of button events, the
+ * direction and deltas of scroll events and a number for the sequence of
+ * touch events. */
+static FILE       *record_file = NULL;
+static GHashTable *record_sequences = NULL;
+
+static gboolean
+record_captured_event (ClutterActor *actor,
+                       ClutterEvent *event,
+                       gpointer      data)
+{
+  gchar x[G_ASCII_DTOSTR_BUF_SIZE], y[G_ASCII_DTOSTR_BUF_SIZE];
+  gchar dx[G_ASCII_DTOSTR_BUF_SIZE], dy[G_ASCII_DTOSTR_BUF_SIZE];
+  ClutterEventSequence *sequence;
+  const gchar *type;
+  gdouble delta_x, delta_y;
+  gfloat event_x, event_y;
+  guint id;
+
+  switch (clutter_event_type (event))
+    {
+    case CLUTTER_MOTION:
+      type = "motion";
+      break;
+    case CLUTTER_BUTTON_PRESS:
+      type = "press";
+      break;
+    case CLUTTER_BUTTON_RELEASE:
+      type = "release";
+      break;
+    case CLUTTER_SCROLL:
+      type = "scroll";
+      break;
+    case CLUTTER_TOUCH_BEGIN:
+      type = "touch-begin";
+      break;
+    case CLUTTER_TOUCH_UPDATE:
+      type = "touch-update";
+      break;
+    case CLUTTER_TOUCH_END:
+      type = "touch-end";
+      break;
+    case CLUTTER_TOUCH_CANCEL:
+      type = "touch-cancel";
+      break;
+    default:
+      return FALSE;
+    }
+
+  clutter_event_get_coords (event, &event_x, &event_y);
+  g_ascii_formatd (x, sizeof (x), "%.2f", event_x);
+  g_ascii_formatd (y, sizeof (y), "%.2f", event_y);
+
+  fprintf (record_file, "%u %s %s %s %u", clutter_event_get_time (event),
+           type, x, y, (guint) clutter_event_get_state (event));
+
+  switch (clutter_event_type (event))
+    {
+    case CLUTTER_BUTTON_PRESS:
+    case CLUTTER_BUTTON_RELEASE:
+      fprintf (record_file, " %u %u", clutter_event_get_button (event),
+               clutter_event_get_click_count (event));
+      break;
+
+    case CLUTTER_SCROLL:
+      delta_x = delta_y = 0;
+      if (clutter_event_get_scroll_direction (event) == CLUTTER_SCROLL_SMOOTH)
+        clutter_event_get_scroll_delta (event, &delta_x, &delta_y);
+      g_ascii_formatd (dx, sizeof (dx), "%.3f", delta_x);
+      g_ascii_formatd (dy, sizeof (dy), "%.3f", delta_y);
+      fprintf (record_file, " %u %s %s",
+               clutter_event_get_scroll_direction (event), dx, dy);
+      break;
+
+    case CLUTTER_TOUCH_BEGIN:
+    case CLUTTER_TOUCH_UPDATE:
+    case CLUTTER_TOUCH_END:
+    case CLUTTER_TOUCH_CANCEL:
+      /* sequences are only told apart, so they are numbered as they come */
+      sequence = clutter_event_get_event_sequence (event);
+      id = GPOINTER_TO_UINT (g_hash_table_lookup (record_sequences, sequence));
+      if (!id)
+        {
+          id = g_hash_table_size (record_sequences) + 1;
+          g_hash_table_insert (record_sequences, sequence,
+                               GUINT_TO_POINTER (id));
+        }
+      fprintf (record_file, " %u", id);
+
+      if (clutter_event_type (event) == CLUTTER_TOUCH_END ||
+          clutter_event_type (event) == CLUTTER_TOUCH_CANCEL)
+        g_hash_table_remove (record_sequences, sequence);
+      break;
+
+    default:
+      break;
+    }
+
+  fputc ('\n', record_file);
+  fflush (record_file);
+
+  return FALSE;
+}
+
+static gboolean
+record_events_init (void)
+{
+  static gboolean initialized = FALSE;
+  const gchar *filename;
+
+  if (initialized)
+    return record_file != NULL;
+
+  initialized = TRUE;
+
+  filename = g_getenv ("MX_RECORD_EVENTS");
+  if (!filename || !*filename)
+    return FALSE;
+
+  record_file = g_fopen (filename, "w");
+  if (!record_file)
+    {
+      g_warning ("Could not open '%s' to record events to: %s",
+                 filename, g_strerror (errno));
+      return FALSE;
+    }
+
+  record_sequences = g_hash_table_new (NULL, NULL);
+  fprintf (record_file, "# mx-events 1\n");
+
+  return TRUE;
+}
+
+/* Records the actors that queue redraws, as the stage is told of each one;
+ * the actor may be gone by the time of the frame, so it is described now */
+static void
+debug_queue_redraw_cb (ClutterActor *stage,
+                       ClutterActor *origin,
+                       MxWindow     *window)
+{
+  MxWindowPrivate *priv = window->priv;
+  const gchar *reason, *name;
+
+  if (g_hash_table_lookup (priv->debug_redraws, origin))
+    return;
+
+  reason = _mx_debug_redraw_reason_get ();
+  name = clutter_actor_get_name (origin);
+
+  g_hash_table_insert (priv->debug_redraws, origin,
+                       g_strdup_printf ("%s%s%s%s (%s)",
+                                        G_OBJECT_TYPE_NAME (origin),
+                                        name ? " \"" : "",
+                                        name ? name : "",
+                                        name ? "\"" : "",
+                                        reason ? reason : "other"));
+}
+
+/* Tints the part of the stage that was redrawn, in a color that changes
+ * from frame to frame, so that the parts redrawn in every frame flicker,
+ * and lists the actors that asked for the frame */
+static void
+debug_paint_redraws (ClutterActor *stage,
+                     MxWindow     *window)
+{
+  static const guint8 colors[][3] = {
+    { 0xff, 0x00, 0x00 }, { 0x00, 0xff, 0x00 }, { 0x00, 0x00, 0xff }
+  };
+  MxWindowPrivate *priv = window->priv;
+  cairo_rectangle_int_t clip;
+  GHashTableIter iter;
+  gpointer value;
+  guint color;
+
+  clutter_stage_get_redraw_clip_bounds (CLUTTER_STAGE (stage), &clip);
+
+  color = priv->debug_frame++ % G_N_ELEMENTS (colors);
+  cogl_set_source_color4ub (colors[color][0], colors[color][1],
+                            colors[color][2], 0x40);
+  cogl_rectangle (clip.x, clip.y, clip.x + clip.width, clip.y + clip.height);
+
+  g_message ("[REDRAWS] frame %u: %d,%d %dx%d, queued by %u actor%s",
+             priv->debug_frame, clip.x, clip.y, clip.width, clip.height,
+             g_hash_table_size (priv->debug_redraws),
+             g_hash_table_size (priv->debug_redraws) == 1 ? "" : "s");
+
+  g_hash_table_iter_init (&iter, priv->debug_redraws);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    g_message ("[REDRAWS]   %s", (const gchar *) value);
+
+  g_hash_table_remove_all (priv->debug_redraws);
+}
 
 static void
 mx_window_post_paint_cb (ClutterActor *actor, MxWindow *window)
@@ -470,6 +729,31 @@ mx_window_post_paint_cb (ClutterActor *actor, MxWindow *window)
 
   MxWindowPrivate *priv = window->priv;
 
+  clutter_actor_get_size (actor, &stage_width, &stage_height);
+
+  /* Fade out the rendering of the window before the rotation started,
+   * turning it along with the content */
+  if (priv->rotation_snapshot)
+    {
+      gfloat progress =
+        clutter_timeline_get_progress (priv->rotation_timeline);
+      guint8 opacity = (guint8)((1.f - progress) * 255.f);
+
+      cogl_push_matrix ();
+
+      cogl_translate (stage_width / 2.f, stage_height / 2.f, 0);
+      cogl_rotate (priv->angle - priv->start_angle, 0, 0, 1);
+      cogl_translate (-stage_width / 2.f, -stage_height / 2.f, 0);
+
+      _mx_paint_texture_with_opacity (priv->rotation_snapshot, opacity,
+                                      0, 0, stage_width, stage_height);
+
+      cogl_pop_matrix ();
+    }
+
+  if (priv->debug_redraws)
+    debug_paint_redraws (actor, window);
+
   /* If we're in small-screen or fullscreen mode, or we don't have the toolbar,
    * we don't want a frame or a resize handle.
    */
@@ -477,7 +761,6 @@ mx_window_post_paint_cb (ClutterActor *actor, MxWindow *window)
     return;
 
   mx_window_get_size (window, &width, &height);
-  clutter_actor_get_size (actor, &stage_width, &stage_height);
 
   cogl_push_matrix ();
 
@@ -505,6 +788,230 @@ mx_window_post_paint_cb (ClutterActor *actor, MxWindow *window)
     debug_paint (actor, window);
 }
 
+/* Frame statistics. Each frame starts in a pre-paint function, which is
+ * where the window decides whether it collects statistics, and ends in a
+ * post-paint function, which reports them if the stage was painted. The
+ * stage is laid out between the pre-paint functions and its paint, and is
+ * picked when events are handled, in between frames. */
+static gboolean
+mx_window_frame_start_cb (gpointer data)
+{
+  MxWindow *window = data;
+  MxWindowPrivate *priv = window->priv;
+  gboolean collect;
+
+  collect = g_signal_has_handler_pending (window, signals[FRAME_STATS], 0,
+                                          TRUE);
+  if (collect != priv->collect_stats)
+    {
+      priv->collect_stats = collect;
+
+      if (collect)
+        frame_stats_collectors++;
+      else
+        frame_stats_collectors--;
+
+      priv->frame_stats.pick_time = 0;
+    }
+
+  if (collect)
+    priv->frame_stats.frame_time = g_get_monotonic_time ();
+
+  return TRUE;
+}
+
+static void
+mx_window_paint_start_cb (ClutterActor *actor,
+                          MxWindow     *window)
+{
+  MxWindowPrivate *priv = window->priv;
+
+  if (!priv->collect_stats)
+    return;
+
+  priv->paint_start = g_get_monotonic_time ();
+
+  if (priv->frame_stats.frame_time)
+    priv->frame_stats.layout_time =
+      priv->paint_start - priv->frame_stats.frame_time;
+}
+
+static void
+mx_window_paint_end_cb (ClutterActor *actor,
+                        MxWindow     *window)
+{
+  MxWindowPrivate *priv = window->priv;
+
+  if (!priv->collect_stats || !priv->paint_start)
+    return;
+
+  priv->frame_stats.paint_time += g_get_monotonic_time () - priv->paint_start;
+  priv->paint_start = 0;
+  priv->painted = TRUE;
+}
+
+static void
+mx_window_pick_start_cb (ClutterActor *actor,
+                         ClutterColor *color,
+                         MxWindow     *window)
+{
+  if (window->priv->collect_stats)
+    window->priv->pick_start = g_get_monotonic_time ();
+}
+
+static void
+mx_window_pick_end_cb (ClutterActor *actor,
+                       ClutterColor *color,
+                       MxWindow     *window)
+{
+  MxWindowPrivate *priv = window->priv;
+
+  if (!priv->collect_stats || !priv->pick_start)
+    return;
+
+  priv->frame_stats.pick_time += g_get_monotonic_time () - priv->pick_start;
+  priv->pick_start = 0;
+}
+
+static gboolean
+mx_window_frame_end_cb (gpointer data)
+{
+  MxWindow *window = data;
+  MxWindowPrivate *priv = window->priv;
+  MxFrameStats stats;
+
+  if (!priv->collect_stats || !priv->painted)
+    return TRUE;
+
+  stats = frame_stats_pending;
+  stats.frame_time = priv->frame_stats.frame_time;
+  stats.layout_time = priv->frame_stats.layout_time;
+  stats.paint_time = priv->frame_stats.paint_time;
+  stats.pick_time = priv->frame_stats.pick_time;
+
+  memset (&frame_stats_pending, 0, sizeof (MxFrameStats));
+  memset (&priv->frame_stats, 0, sizeof (MxFrameStats));
+  priv->painted = FALSE;
+
+  g_signal_emit (window, signals[FRAME_STATS], 0, &stats);
+
+  return TRUE;
+}
+
+/* Times a phase of the frame, if any window collects statistics. Nested
+ * calls for the same phase are only timed once, by the outermost one. */
+gint64
+_mx_frame_stats_begin (MxFrameStatsTime time)
+{
+  if (frame_stats_depth[time]++ || !frame_stats_collectors)
+    return 0;
+
+  return g_get_monotonic_time ();
+}
+
+void
+_mx_frame_stats_end (MxFrameStatsTime time,
+                     gint64           start)
+{
+  gint64 elapsed;
+
+  frame_stats_depth[time]--;
+
+  if (!start || !frame_stats_collectors)
+    return;
+
+  elapsed = g_get_monotonic_time () - start;
+
+  switch (time)
+    {
+    case MX_FRAME_STATS_STYLE:
+      frame_stats_pending.style_time += elapsed;
+      break;
+
+    case MX_FRAME_STATS_ACTOR_MANAGER:
+      frame_stats_pending.actor_manager_time += elapsed;
+      break;
+
+    case MX_FRAME_STATS_TEXTURE_UPLOAD:
+      frame_stats_pending.texture_upload_time += elapsed;
+      break;
+
+    default:
+      break;
+    }
+}
+
+void
+_mx_frame_stats_count (MxFrameStatsCount count)
+{
+  if (!frame_stats_collectors)
+    return;
+
+  switch (count)
+    {
+    case MX_FRAME_STATS_RESTYLED:
+      frame_stats_pending.n_restyled++;
+      break;
+
+    case MX_FRAME_STATS_RELAYOUTS:
+      frame_stats_pending.n_relayouts++;
+      break;
+
+    case MX_FRAME_STATS_PAINTED:
+      frame_stats_pending.n_painted++;
+      break;
+    }
+}
+
+/**
+ * mx_frame_stats_copy:
+ * @stats: a #MxFrameStats
+ *
+ * Makes a copy of @stats.
+ *
+ * Returns: (transfer full): a newly allocated #MxFrameStats, to be freed
+ *   with mx_frame_stats_free()
+ *
+ * Since: 2.0
+ */
+MxFrameStats *
+mx_frame_stats_copy (const MxFrameStats *stats)
+{
+  g_return_val_if_fail (stats != NULL, NULL);
+
+  return g_slice_dup (MxFrameStats, stats);
+}
+
+/**
+ * mx_frame_stats_free:
+ * @stats: a #MxFrameStats
+ *
+ * Frees a #MxFrameStats allocated with mx_frame_stats_copy().
+ *
+ * Since: 2.0
+ */
+void
+mx_frame_stats_free (MxFrameStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  g_slice_free (MxFrameStats, stats);
+}
+
+GType
+mx_frame_stats_get_type (void)
+{
+  static GType our_type = 0;
+
+  if (G_UNLIKELY (our_type == 0))
+    our_type =
+      g_boxed_type_register_static (g_intern_static_string ("MxFrameStats"),
+                                    (GBoxedCopyFunc) mx_frame_stats_copy,
+                                    (GBoxedFreeFunc) mx_frame_stats_free);
+
+  return our_type;
+}
+
 static void
 mx_window_allocation_changed_cb (ClutterActor           *actor,
                                  ClutterActorBox        *box,
@@ -583,8 +1090,15 @@ mx_window_allocation_changed_cb (ClutterActor           *actor,
       clutter_actor_set_pivot_point (priv->child,
                                      (width / 2.f - padding.left) / clutter_actor_get_width (priv->child),
                                      (height / 2.f - padding.top - toolbar_height) / clutter_actor_get_height (priv->child));
+
+      priv->child_box.x1 = padding.left + x;
+      priv->child_box.y1 = toolbar_height + padding.top + y;
+      priv->child_box.x2 = x + width - padding.right;
+      priv->child_box.y2 = y + height - padding.bottom;
     }
 
+  mx_window_update_opaque_region (window);
+
   if (priv->resize_grip)
     {
       clutter_actor_get_preferred_size (priv->resize_grip,
@@ -596,6 +1110,63 @@ mx_window_allocation_changed_cb (ClutterActor           *actor,
     }
 }
 
+/* Tells the compositor which part of the window is opaque, so that it can
+ * skip blending it, or scan it out directly when it covers the screen:
+ * all of it when the stage has no alpha channel, or else the child, when
+ * its background is opaque and it isn't faded or rotated */
+static void
+mx_window_update_opaque_region (MxWindow *self)
+{
+  MxWindowPrivate *priv = self->priv;
+  ClutterActorBox region = { 0, };
+  gboolean has_region = FALSE;
+
+  if (!priv->native_window || !priv->stage)
+    return;
+
+  if (!clutter_stage_get_use_alpha (CLUTTER_STAGE (priv->stage)))
+    {
+      clutter_actor_get_size (priv->stage, &region.x2, &region.y2);
+      has_region = TRUE;
+    }
+  else if (priv->child && MX_IS_WIDGET (priv->child) &&
+           CLUTTER_ACTOR_IS_VISIBLE (priv->child) &&
+           clutter_actor_get_opacity (priv->child) == 0xff &&
+           ((gint) priv->angle) % 360 == 0)
+    {
+      ClutterColor *color;
+
+      color = mx_widget_get_background_color (MX_WIDGET (priv->child));
+      if (color && color->alpha == 0xff)
+        {
+          /* only the whole pixels the child covers */
+          region.x1 = ceilf (priv->child_box.x1);
+          region.y1 = ceilf (priv->child_box.y1);
+          region.x2 = floorf (priv->child_box.x2);
+          region.y2 = floorf (priv->child_box.y2);
+          has_region = region.x2 > region.x1 && region.y2 > region.y1;
+        }
+    }
+
+  if (has_region == priv->has_opaque_region &&
+      (!has_region || clutter_actor_box_equal (&region, &priv->opaque_region)))
+    return;
+
+  priv->has_opaque_region = has_region;
+  priv->opaque_region = region;
+
+  _mx_native_window_set_opaque_region (priv->native_window,
+                                       has_region ? &region : NULL);
+}
+
+static void
+mx_window_child_style_changed_cb (MxWidget *child,
+                                  guint     flags,
+                                  MxWindow *self)
+{
+  mx_window_update_opaque_region (self);
+}
+
 static void
 mx_window_reallocate (MxWindow *self)
 {
@@ -606,6 +1177,64 @@ mx_window_reallocate (MxWindow *self)
   mx_window_allocation_changed_cb (priv->stage, &box, 0, self);
 }
 
+/* Turns the content to the current angle of the rotation, without laying
+ * it out again */
+static void
+mx_window_update_rotation (MxWindow *self)
+{
+  MxWindowPrivate *priv = self->priv;
+
+  if (priv->has_toolbar && priv->toolbar)
+    clutter_actor_set_rotation_angle (priv->toolbar, CLUTTER_Z_AXIS,
+                                      priv->angle);
+
+  if (priv->child)
+    clutter_actor_set_rotation_angle (priv->child, CLUTTER_Z_AXIS,
+                                      priv->angle);
+
+  mx_window_update_opaque_region (self);
+
+  /* The frame and the snapshot are painted by the stage */
+  clutter_actor_queue_redraw (priv->stage);
+}
+
+static void
+mx_window_paint_content (gpointer user_data)
+{
+  MxWindowPrivate *priv = MX_WINDOW (user_data)->priv;
+
+  if (priv->child && CLUTTER_ACTOR_IS_VISIBLE (priv->child))
+    clutter_actor_paint (priv->child);
+  if (priv->has_toolbar && priv->toolbar &&
+      CLUTTER_ACTOR_IS_VISIBLE (priv->toolbar))
+    clutter_actor_paint (priv->toolbar);
+}
+
+/* Renders the stage as it is, before the content is laid out for a new
+ * rotation, so that it can be faded out as the rotation is animated */
+static void
+mx_window_take_rotation_snapshot (MxWindow *self)
+{
+  MxWindowPrivate *priv = self->priv;
+  ClutterActorBox area;
+
+  if (priv->rotation_snapshot)
+    {
+      cogl_handle_unref (priv->rotation_snapshot);
+      priv->rotation_snapshot = NULL;
+    }
+
+  if (!CLUTTER_ACTOR_IS_MAPPED (priv->stage))
+    return;
+
+  area.x1 = area.y1 = 0;
+  clutter_actor_get_size (priv->stage, &area.x2, &area.y2);
+
+  clutter_stage_ensure_current (CLUTTER_STAGE (priv->stage));
+  priv->rotation_snapshot =
+    _mx_render_to_texture (&area, mx_window_paint_content, self);
+}
+
 static void
 mx_window_fullscreen_set_cb (ClutterStage *stage,
                              GParamSpec   *pspec,
@@ -741,8 +1370,16 @@ mx_window_constructed (GObject *object)
   g_object_add_weak_pointer (G_OBJECT (priv->resize_grip),
                              (gpointer *)&priv->resize_grip);
 
+  g_signal_connect (priv->stage, "paint",
+                    G_CALLBACK (mx_window_paint_start_cb), object);
   g_signal_connect_after (priv->stage, "paint",
                           G_CALLBACK (mx_window_post_paint_cb), object);
+  g_signal_connect_after (priv->stage, "paint",
+                          G_CALLBACK (mx_window_paint_end_cb), object);
+  g_signal_connect (priv->stage, "pick",
+                    G_CALLBACK (mx_window_pick_start_cb), object);
+  g_signal_connect_after (priv->stage, "pick",
+                          G_CALLBACK (mx_window_pick_end_cb), object);
   g_signal_connect (priv->stage, "allocation-changed",
                     G_CALLBACK (mx_window_allocation_changed_cb), object);
   g_signal_connect (priv->stage, "notify::fullscreen-set",
@@ -762,8 +1399,28 @@ mx_window_constructed (GObject *object)
     g_signal_connect (priv->stage, "captured-event",
                       G_CALLBACK (debug_captured_event), object);
 
+  if (record_events_init ())
+    g_signal_connect (priv->stage, "captured-event",
+                      G_CALLBACK (record_captured_event), NULL);
+
+  if (_mx_debug (MX_DEBUG_REDRAWS))
+    {
+      priv->debug_redraws = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+      g_signal_connect (priv->stage, "queue-redraw",
+                        G_CALLBACK (debug_queue_redraw_cb), object);
+    }
+
   g_object_set (G_OBJECT (priv->stage), "use-alpha", TRUE, NULL);
 
+  priv->frame_start_id =
+    clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+                                           mx_window_frame_start_cb,
+                                           object, NULL);
+  priv->frame_end_id =
+    clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                           mx_window_frame_end_cb,
+                                           object, NULL);
+
 #ifdef HAVE_X11
   priv->native_window = _mx_window_x11_new (self);
 #endif
@@ -880,6 +1537,24 @@ mx_window_class_init (MxWindowClass *klass)
   g_object_class_install_property (object_class, PROP_WINDOW_ROTATION_ANGLE,
                                    pspec);
 
+  /**
+   * MxWindow:window-rotation-cross-fade:
+   *
+   * Whether to fade out the rendering of the window as it was before a
+   * rotation, while the rotation is animated.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_boolean ("window-rotation-cross-fade",
+                                "Window rotation cross-fade",
+                                "Whether to cross-fade between the old and "
+                                "new layouts while rotating the window.",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class,
+                                   PROP_WINDOW_ROTATION_CROSS_FADE,
+                                   pspec);
+
   /**
    * MxWindow::destroy:
    * @window: the object that received the signal
@@ -894,6 +1569,33 @@ mx_window_class_init (MxWindowClass *klass)
                                    _mx_marshal_VOID__VOID,
                                    G_TYPE_NONE, 0);
 
+  /**
+   * MxWindow::frame-stats:
+   * @window: the object that received the signal
+   * @stats: what the frame was spent on
+   *
+   * Emitted after each frame in which the stage of @window was painted,
+   * with the time spent in the phases of the frame and the amount of work
+   * done in them. Statistics are only collected while a handler is
+   * connected to this signal, from the frame after it is connected.
+   *
+   * The style, #MxActorManager and texture upload times, as well as the
+   * counts, are those of all the windows, since the previous statistics
+   * were reported by any window. Times are in microseconds, and are the
+   * time spent by the CPU: the GPU may still be rendering the frame.
+   *
+   * Since: 2.0
+   */
+  signals[FRAME_STATS] =
+    g_signal_new ("frame-stats",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (MxWindowClass, frame_stats),
+                  NULL, NULL,
+                  _mx_marshal_VOID__BOXED,
+                  G_TYPE_NONE, 1,
+                  MX_TYPE_FRAME_STATS | G_SIGNAL_TYPE_STATIC_SCOPE);
+
   window_quark = g_quark_from_static_string ("mx-window");
 }
 
@@ -906,7 +1608,7 @@ mx_window_rotation_new_frame_cb (ClutterTimeline *timeline,
   gfloat alpha = clutter_timeline_get_progress (priv->rotation_timeline);
 
   priv->angle = (alpha * priv->end_angle) + ((1.f - alpha) * priv->start_angle);
-  mx_window_reallocate (self);
+  mx_window_update_rotation (self);
   g_object_notify (G_OBJECT (self), "window-rotation-angle");
 }
 
@@ -922,9 +1624,13 @@ mx_window_rotation_completed_cb (ClutterTimeline *timeline,
   while (priv->angle < 0.f)
     priv->angle += 360.f;
 
-  priv->rotate_size = FALSE;
+  if (priv->rotation_snapshot)
+    {
+      cogl_handle_unref (priv->rotation_snapshot);
+      priv->rotation_snapshot = NULL;
+    }
 
-  mx_window_reallocate (self);
+  mx_window_update_rotation (self);
   g_object_notify (G_OBJECT (self), "window-rotation-angle");
 }
 
@@ -966,6 +1672,19 @@ _mx_window_get_resize_grip (MxWindow *window)
   return window->priv->resize_grip;
 }
 
+/* Returns the time between the frames presented by the window system, in
+ * microseconds, or 0 when the backend doesn't report it */
+gint64
+_mx_window_get_frame_interval (MxWindow *window)
+{
+  g_return_val_if_fail (MX_IS_WINDOW (window), 0);
+
+  if (!window->priv->native_window)
+    return 0;
+
+  return _mx_native_window_get_frame_interval (window->priv->native_window);
+}
+
 /**
  * mx_window_new:
  *
@@ -1036,12 +1755,25 @@ mx_window_set_child (MxWindow     *window,
     return;
 
   if (priv->child)
-    clutter_actor_remove_child (priv->stage, priv->child);
+    {
+      if (MX_IS_WIDGET (priv->child))
+        g_signal_handlers_disconnect_by_func (priv->child,
+                                              mx_window_child_style_changed_cb,
+                                              window);
+      clutter_actor_remove_child (priv->stage, priv->child);
+    }
 
   if (actor)
     {
       priv->child = actor;
       clutter_actor_add_child (priv->stage, priv->child);
+
+      /* the background of the child tells which part of the window is
+       * opaque */
+      if (MX_IS_WIDGET (actor))
+        g_signal_connect (actor, "style-changed",
+                          G_CALLBACK (mx_window_child_style_changed_cb),
+                          window);
     }
 
   mx_window_reallocate (window);
@@ -1578,16 +2310,8 @@ mx_window_set_window_rotation (MxWindow         *window,
   if (priv->rotation == rotation)
     return;
 
-  if (((priv->rotation == MX_WINDOW_ROTATION_0) ||
-       (priv->rotation == MX_WINDOW_ROTATION_180)) &&
-      ((rotation == MX_WINDOW_ROTATION_90) ||
-       (rotation == MX_WINDOW_ROTATION_270)))
-    priv->rotate_size = TRUE;
-  else if (((priv->rotation == MX_WINDOW_ROTATION_90) ||
-            (priv->rotation == MX_WINDOW_ROTATION_270)) &&
-           ((rotation == MX_WINDOW_ROTATION_0) ||
-            (rotation == MX_WINDOW_ROTATION_180)))
-    priv->rotate_size = TRUE;
+  if (priv->cross_fade)
+    mx_window_take_rotation_snapshot (window);
 
   priv->rotation = rotation;
 
@@ -1618,6 +2342,10 @@ mx_window_set_window_rotation (MxWindow         *window,
   clutter_timeline_set_duration (priv->rotation_timeline, msecs);
   clutter_timeline_start (priv->rotation_timeline);
 
+  /* Lay the content out for the new rotation once; the animation only
+   * turns it */
+  mx_window_reallocate (window);
+
   g_object_notify (G_OBJECT (window), "window-rotation");
 }
 
@@ -1638,6 +2366,51 @@ mx_window_get_window_rotation (MxWindow *window)
   return window->priv->rotation;
 }
 
+/**
+ * mx_window_set_window_rotation_cross_fade:
+ * @window: A #MxWindow
+ * @cross_fade: %TRUE to cross-fade between the layouts when rotating
+ *
+ * Sets whether a rotation of the window cross-fades between a snapshot of
+ * the window as it was laid out before the rotation and the window laid
+ * out for the new rotation.
+ *
+ * Since: 2.0
+ */
+void
+mx_window_set_window_rotation_cross_fade (MxWindow *window,
+                                          gboolean  cross_fade)
+{
+  MxWindowPrivate *priv;
+
+  g_return_if_fail (MX_IS_WINDOW (window));
+
+  priv = window->priv;
+  if (priv->cross_fade != cross_fade)
+    {
+      priv->cross_fade = cross_fade;
+      g_object_notify (G_OBJECT (window), "window-rotation-cross-fade");
+    }
+}
+
+/**
+ * mx_window_get_window_rotation_cross_fade:
+ * @window: A #MxWindow
+ *
+ * Retrieves whether a rotation of the window cross-fades between the old
+ * and new layouts. See mx_window_set_window_rotation_cross_fade().
+ *
+ * Returns: %TRUE if rotations cross-fade
+ *
+ * Since: 2.0
+ */
+gboolean
+mx_window_get_window_rotation_cross_fade (MxWindow *window)
+{
+  g_return_val_if_fail (MX_IS_WINDOW (window), FALSE);
+  return window->priv->cross_fade;
+}
+
 /**
  * mx_window_show:
  * @window: A #MxWindow
@@ -68,6 +68,47 @@ typedef struct _MxWindow MxWindow;
 typedef struct _MxWindowClass MxWindowClass;
 typedef struct _MxWindowPrivate MxWindowPrivate;
 
+/**
+ * MxFrameStats:
+ * @frame_time: the monotonic time at which the frame started, in
+ *   microseconds
+ * @style_time: the time spent restyling
+ * @layout_time: the time spent laying out the stage
+ * @paint_time: the time spent painting the stage
+ * @pick_time: the time spent picking the stage to find the actors under
+ *   the pointer
+ * @actor_manager_time: the time spent in #MxActorManager operations
+ * @texture_upload_time: the time spent uploading images into textures
+ * @n_restyled: the number of stylables restyled
+ * @n_relayouts: the number of widgets allocated
+ * @n_painted: the number of widgets painted
+ *
+ * What a frame of a #MxWindow was spent on, as reported by the
+ * #MxWindow::frame-stats signal. Times are in microseconds.
+ *
+ * Since: 2.0
+ */
+typedef struct {
+  gint64 frame_time;
+
+  gint64 style_time;
+  gint64 layout_time;
+  gint64 paint_time;
+  gint64 pick_time;
+  gint64 actor_manager_time;
+  gint64 texture_upload_time;
+
+  guint  n_restyled;
+  guint  n_relayouts;
+  guint  n_painted;
+} MxFrameStats;
+
+#define MX_TYPE_FRAME_STATS (mx_frame_stats_get_type ())
+
+GType         mx_frame_stats_get_type (void) G_GNUC_CONST;
+MxFrameStats *mx_frame_stats_copy     (const MxFrameStats *stats);
+void          mx_frame_stats_free     (MxFrameStats       *stats);
+
 struct _MxWindow
 {
   GObject parent;
@@ -80,10 +121,11 @@ struct _MxWindowClass
   GObjectClass parent_class;
 
   /* signals, not vfuncs */
-  void (*destroy)             (MxWindow *window);
+  void (*destroy)             (MxWindow           *window);
+  void (*frame_stats)         (MxWindow           *window,
+                               const MxFrameStats *stats);
 
   /* padding for future expansion */
-  void (*_padding_0) (void);
   void (*_padding_1) (void);
   void (*_padding_2) (void);
   void (*_padding_3) (void);
@@ -138,6 +180,10 @@ void             mx_window_set_window_rotation (MxWindow         *window,
                                                 MxWindowRotation  rotation);
 MxWindowRotation mx_window_get_window_rotation (MxWindow         *window);
 
+void     mx_window_set_window_rotation_cross_fade (MxWindow *window,
+                                                   gboolean  cross_fade);
+gboolean mx_window_get_window_rotation_cross_fade (MxWindow *window);
+
 void mx_window_show (MxWindow *window);
 void mx_window_hide (MxWindow *window);
 
@@ -0,0 +1,441 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-worker-pool.c: Threads shared by the toolkit for background work
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/**
+ * SECTION:mx-worker-pool
+ * @short_description: Threads shared by the toolkit for background work
+ *
+ * #MxWorkerPool is the set of threads Mx decodes images and parses style
+ * sheets on, when these are loaded asynchronously. Having a single pool
+ * bounds the number of threads the toolkit uses, which an application
+ * that has threads of its own can lower with
+ * mx_worker_pool_set_max_threads().
+ *
+ * Jobs are run in order of priority, then in the order they were pushed,
+ * and each is completed by a function called in the main loop.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <unistd.h>
+#include <clutter/clutter.h>
+
+#include "mx-worker-pool.h"
+#include "mx-private.h"
+
+G_DEFINE_TYPE (MxWorkerPool, mx_worker_pool, G_TYPE_OBJECT)
+
+#define WORKER_POOL_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_WORKER_POOL, MxWorkerPoolPrivate))
+
+typedef struct
+{
+  MxWorkerPool *pool;
+  guint         id;
+
+  /* read by the threads while sorting, so accessed atomically */
+  gint          priority;
+  guint         sequence;
+
+  MxWorkerFunc  func;
+  MxWorkerFunc  complete_func;
+  gpointer      user_data;
+  GCancellable *cancellable;
+} MxWorkerJob;
+
+struct _MxWorkerPoolPrivate
+{
+  GThreadPool *threads;
+  gint         max_threads;
+
+  /* jobs that haven't started yet, by id, for mx_worker_pool_set_priority() */
+  GMutex       mutex;
+  GHashTable  *queued;
+
+  guint        next_id;
+  guint        sequence;
+  guint        sort_source;
+};
+
+enum
+{
+  PROP_0,
+
+  PROP_MAX_THREADS
+};
+
+static MxWorkerPool *mx_worker_pool_singleton = NULL;
+
+static gint
+mx_worker_pool_get_n_processors (void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+  return MAX (1, sysconf (_SC_NPROCESSORS_ONLN));
+#else
+  /* FIXME: add more OSs */
+  return 1;
+#endif
+}
+
+static void
+mx_worker_pool_set_property (GObject      *object,
+                             guint         prop_id,
+                             const GValue *value,
+                             GParamSpec   *pspec)
+{
+  MxWorkerPool *pool = MX_WORKER_POOL (object);
+
+  switch (prop_id)
+    {
+    case PROP_MAX_THREADS:
+      mx_worker_pool_set_max_threads (pool, g_value_get_int (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+mx_worker_pool_get_property (GObject    *object,
+                             guint       prop_id,
+                             GValue     *value,
+                             GParamSpec *pspec)
+{
+  MxWorkerPool *pool = MX_WORKER_POOL (object);
+
+  switch (prop_id)
+    {
+    case PROP_MAX_THREADS:
+      g_value_set_int (value, pool->priv->max_threads);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+mx_worker_pool_finalize (GObject *object)
+{
+  MxWorkerPoolPrivate *priv = MX_WORKER_POOL (object)->priv;
+
+  if (priv->threads)
+    g_thread_pool_free (priv->threads, FALSE, TRUE);
+
+  if (priv->sort_source)
+    g_source_remove (priv->sort_source);
+
+  g_hash_table_destroy (priv->queued);
+  g_mutex_clear (&priv->mutex);
+
+  G_OBJECT_CLASS (mx_worker_pool_parent_class)->finalize (object);
+}
+
+static void
+mx_worker_pool_class_init (MxWorkerPoolClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GParamSpec *pspec;
+
+  g_type_class_add_private (klass, sizeof (MxWorkerPoolPrivate));
+
+  object_class->set_property = mx_worker_pool_set_property;
+  object_class->get_property = mx_worker_pool_get_property;
+  object_class->finalize = mx_worker_pool_finalize;
+
+  /**
+   * MxWorkerPool:max-threads:
+   *
+   * The maximum number of jobs run at the same time. This defaults to the
+   * number of processors.
+   *
+   * Since: 2.0
+   */
+  pspec = g_param_spec_int ("max-threads",
+                            "Maximum threads",
+                            "The maximum number of threads to run jobs on",
+                            1, G_MAXINT, 1,
+                            MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_MAX_THREADS, pspec);
+}
+
+static void
+mx_worker_pool_init (MxWorkerPool *self)
+{
+  MxWorkerPoolPrivate *priv = self->priv = WORKER_POOL_PRIVATE (self);
+
+  priv->max_threads = mx_worker_pool_get_n_processors ();
+
+  g_mutex_init (&priv->mutex);
+  priv->queued = g_hash_table_new (NULL, NULL);
+  priv->next_id = 1;
+}
+
+/**
+ * mx_worker_pool_get_default:
+ *
+ * Returns the worker pool used by Mx. This is owned by Mx and should not be
+ * unreferenced or freed.
+ *
+ * Returns: (transfer none): a #MxWorkerPool
+ *
+ * Since: 2.0
+ */
+MxWorkerPool *
+mx_worker_pool_get_default (void)
+{
+  if (G_UNLIKELY (mx_worker_pool_singleton == NULL))
+    mx_worker_pool_singleton = g_object_new (MX_TYPE_WORKER_POOL, NULL);
+
+  return mx_worker_pool_singleton;
+}
+
+/**
+ * mx_worker_pool_set_max_threads:
+ * @pool: A #MxWorkerPool
+ * @max_threads: the maximum number of jobs to run at once
+ *
+ * Sets the maximum number of jobs run at the same time, and so the
+ * maximum number of threads used by @pool.
+ *
+ * Since: 2.0
+ */
+void
+mx_worker_pool_set_max_threads (MxWorkerPool *pool,
+                                gint          max_threads)
+{
+  MxWorkerPoolPrivate *priv;
+
+  g_return_if_fail (MX_IS_WORKER_POOL (pool));
+  g_return_if_fail (max_threads > 0);
+
+  priv = pool->priv;
+
+  if (priv->max_threads != max_threads)
+    {
+      priv->max_threads = max_threads;
+
+      if (priv->threads)
+        g_thread_pool_set_max_threads (priv->threads, max_threads, NULL);
+
+      g_object_notify (G_OBJECT (pool), "max-threads");
+    }
+}
+
+/**
+ * mx_worker_pool_get_max_threads:
+ * @pool: A #MxWorkerPool
+ *
+ * Gets the maximum number of jobs run at the same time.
+ *
+ * Returns: the maximum number of threads used by @pool
+ *
+ * Since: 2.0
+ */
+gint
+mx_worker_pool_get_max_threads (MxWorkerPool *pool)
+{
+  g_return_val_if_fail (MX_IS_WORKER_POOL (pool), 0);
+
+  return pool->priv->max_threads;
+}
+
+static gint
+mx_worker_pool_compare_jobs (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      user_data)
+{
+  MxWorkerJob *job_a = (MxWorkerJob *) a;
+  MxWorkerJob *job_b = (MxWorkerJob *) b;
+  gint priority_a = g_atomic_int_get (&job_a->priority);
+  gint priority_b = g_atomic_int_get (&job_b->priority);
+
+  if (priority_a != priority_b)
+    return priority_a < priority_b ? -1 : 1;
+
+  /* the sequence wraps around, so compare the difference */
+  return (gint) (job_a->sequence - job_b->sequence);
+}
+
+/* back in the main loop, once the job has run */
+static gboolean
+mx_worker_pool_complete (gpointer data)
+{
+  MxWorkerJob *job = data;
+
+  if (job->complete_func)
+    job->complete_func (job->user_data);
+
+  if (job->cancellable)
+    g_object_unref (job->cancellable);
+  g_object_unref (job->pool);
+  g_slice_free (MxWorkerJob, job);
+
+  return FALSE;
+}
+
+static void
+mx_worker_pool_run (gpointer data,
+                    gpointer user_data)
+{
+  MxWorkerJob *job = data;
+  MxWorkerPoolPrivate *priv = job->pool->priv;
+
+  /* the priority doesn't matter anymore */
+  g_mutex_lock (&priv->mutex);
+  g_hash_table_remove (priv->queued, GUINT_TO_POINTER (job->id));
+  g_mutex_unlock (&priv->mutex);
+
+  if (!job->cancellable || !g_cancellable_is_cancelled (job->cancellable))
+    job->func (job->user_data);
+
+  clutter_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                 mx_worker_pool_complete, job, NULL);
+}
+
+/**
+ * mx_worker_pool_push:
+ * @pool: A #MxWorkerPool
+ * @priority: the priority of the job; lower values run first
+ * @func: (scope notified): the function to run on a worker thread
+ * @complete_func: (allow-none) (scope notified): the function to call
+ *   in the main loop once @func has run
+ * @user_data: (closure): data to pass to @func and @complete_func
+ * @cancellable: (allow-none): a #GCancellable or %NULL
+ *
+ * Queues a job to run @func on one of the threads of @pool. @func must
+ * not touch any actors or textures; @complete_func is where the result is
+ * used. If @cancellable is cancelled before the job starts, @func is not
+ * called. @complete_func is always called, so that it can free
+ * @user_data.
+ *
+ * Jobs with the same priority run in the order they were pushed; the
+ * G_PRIORITY_* values can be used.
+ *
+ * Returns: the id of the job, for mx_worker_pool_set_priority()
+ *
+ * Since: 2.0
+ */
+guint
+mx_worker_pool_push (MxWorkerPool *pool,
+                     gint          priority,
+                     MxWorkerFunc  func,
+                     MxWorkerFunc  complete_func,
+                     gpointer      user_data,
+                     GCancellable *cancellable)
+{
+  MxWorkerPoolPrivate *priv;
+  MxWorkerJob *job;
+
+  g_return_val_if_fail (MX_IS_WORKER_POOL (pool), 0);
+  g_return_val_if_fail (func != NULL, 0);
+
+  priv = pool->priv;
+
+  if (!priv->threads)
+    {
+      priv->threads = g_thread_pool_new (mx_worker_pool_run, NULL,
+                                         priv->max_threads, FALSE, NULL);
+      g_thread_pool_set_sort_function (priv->threads,
+                                       mx_worker_pool_compare_jobs, NULL);
+    }
+
+  job = g_slice_new0 (MxWorkerJob);
+  job->pool = g_object_ref (pool);
+  job->priority = priority;
+  job->sequence = priv->sequence++;
+  job->func = func;
+  job->complete_func = complete_func;
+  job->user_data = user_data;
+  if (cancellable)
+    job->cancellable = g_object_ref (cancellable);
+
+  /* 0 is never a valid id */
+  job->id = priv->next_id++;
+  if (G_UNLIKELY (priv->next_id == 0))
+    priv->next_id = 1;
+
+  g_mutex_lock (&priv->mutex);
+  g_hash_table_insert (priv->queued, GUINT_TO_POINTER (job->id), job);
+  g_mutex_unlock (&priv->mutex);
+
+  g_thread_pool_push (priv->threads, job, NULL);
+
+  return job->id;
+}
+
+static gboolean
+mx_worker_pool_sort_cb (gpointer data)
+{
+  MxWorkerPoolPrivate *priv = MX_WORKER_POOL (data)->priv;
+
+  priv->sort_source = 0;
+
+  /* Setting the sort function again re-sorts the queue */
+  g_thread_pool_set_sort_function (priv->threads,
+                                   mx_worker_pool_compare_jobs, NULL);
+
+  return FALSE;
+}
+
+/**
+ * mx_worker_pool_set_priority:
+ * @pool: A #MxWorkerPool
+ * @job_id: the id returned by mx_worker_pool_push()
+ * @priority: the new priority of the job
+ *
+ * Changes the priority of a job that hasn't started yet. This does nothing
+ * if the job has started already.
+ *
+ * Since: 2.0
+ */
+void
+mx_worker_pool_set_priority (MxWorkerPool *pool,
+                             guint         job_id,
+                             gint          priority)
+{
+  MxWorkerPoolPrivate *priv;
+  MxWorkerJob *job;
+  gboolean changed = FALSE;
+
+  g_return_if_fail (MX_IS_WORKER_POOL (pool));
+
+  priv = pool->priv;
+
+  g_mutex_lock (&priv->mutex);
+  job = g_hash_table_lookup (priv->queued, GUINT_TO_POINTER (job_id));
+  if (job && g_atomic_int_get (&job->priority) != priority)
+    {
+      g_atomic_int_set (&job->priority, priority);
+      changed = TRUE;
+    }
+  g_mutex_unlock (&priv->mutex);
+
+  /* Many priorities change together when scrolling, so re-sort once */
+  if (changed && !priv->sort_source)
+    priv->sort_source =
+      clutter_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                     mx_worker_pool_sort_cb, pool, NULL);
+}
@@ -0,0 +1,113 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-worker-pool.h: Threads shared by the toolkit for background work
+ *
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#if !defined(MX_H_INSIDE) && !defined(MX_COMPILATION)
+#error "Only <mx/mx.h> can be included directly.h"
+#endif
+
+#ifndef _MX_WORKER_POOL
+#define _MX_WORKER_POOL
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define MX_TYPE_WORKER_POOL mx_worker_pool_get_type()
+
+#define MX_WORKER_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+  MX_TYPE_WORKER_POOL, MxWorkerPool))
+
+#define MX_WORKER_POOL_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), \
+  MX_TYPE_WORKER_POOL, MxWorkerPoolClass))
+
+#define MX_IS_WORKER_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+  MX_TYPE_WORKER_POOL))
+
+#define MX_IS_WORKER_POOL_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+  MX_TYPE_WORKER_POOL))
+
+#define MX_WORKER_POOL_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+  MX_TYPE_WORKER_POOL, MxWorkerPoolClass))
+
+typedef struct _MxWorkerPoolPrivate MxWorkerPoolPrivate;
+
+/**
+ * MxWorkerPool:
+ *
+ * The contents of this structure are private and should only be accessed
+ * through the public API.
+ */
+typedef struct {
+  /*< private >*/
+  GObject parent;
+
+  MxWorkerPoolPrivate *priv;
+} MxWorkerPool;
+
+typedef struct {
+  GObjectClass parent_class;
+
+  /* padding for future expansion */
+  void (*_padding_0) (void);
+  void (*_padding_1) (void);
+  void (*_padding_2) (void);
+  void (*_padding_3) (void);
+} MxWorkerPoolClass;
+
+/**
+ * MxWorkerFunc:
+ * @user_data: the data passed to mx_worker_pool_push()
+ *
+ * The type of the functions given to mx_worker_pool_push(), both for the
+ * work done on a worker thread and for its completion in the main loop.
+ *
+ * Since: 2.0
+ */
+typedef void (* MxWorkerFunc) (gpointer user_data);
+
+GType mx_worker_pool_get_type (void);
+
+MxWorkerPool *mx_worker_pool_get_default     (void);
+
+void          mx_worker_pool_set_max_threads (MxWorkerPool *pool,
+                                              gint          max_threads);
+gint          mx_worker_pool_get_max_threads (MxWorkerPool *pool);
+
+guint         mx_worker_pool_push            (MxWorkerPool *pool,
+                                              gint          priority,
+                                              MxWorkerFunc  func,
+                                              MxWorkerFunc  complete_func,
+                                              gpointer      user_data,
+                                              GCancellable *cancellable);
+void          mx_worker_pool_set_priority    (MxWorkerPool *pool,
+                                              guint         job_id,
+                                              gint          priority);
+
+G_END_DECLS
+
+#endif /* _MX_WORKER_POOL */
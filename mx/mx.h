@@ -51,12 +51,15 @@
 #include <mx/mx-icon-theme.h>
 #include <mx/mx-icon.h>
 #include <mx/mx-image.h>
+#include <mx/mx-image-decoder.h>
 #include <mx/mx-item-factory.h>
 #include <mx/mx-item-view.h>
 #include <mx/mx-list-view.h>
 #include <mx/mx-label.h>
 #include <mx/mx-notebook.h>
+#include <mx/mx-offscreen-renderer.h>
 #include <mx/mx-path-bar.h>
+#include <mx/mx-memory.h>
 #include <mx/mx-menu.h>
 #include <mx/mx-progress-bar.h>
 #include <mx/mx-scroll-bar.h>
@@ -82,6 +85,7 @@
 #include <mx/mx-viewport.h>
 #include <mx/mx-widget.h>
 #include <mx/mx-window.h>
+#include <mx/mx-worker-pool.h>
 
 #undef MX_H_INSIDE
 
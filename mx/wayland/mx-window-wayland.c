@@ -33,9 +33,19 @@ G_DEFINE_TYPE_WITH_CODE (MxWindowWayland, mx_window_wayland, G_TYPE_OBJECT,
 #define WINDOW_WAYLAND_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_WINDOW_WAYLAND, MxWindowWaylandPrivate))
 
+/* Frame callbacks further apart than this mean that we stopped painting,
+ * not that the compositor is presenting slowly */
+#define MAX_FRAME_INTERVAL 100000
+
 struct _MxWindowWaylandPrivate
 {
   MxWindow *window;
+
+  ClutterStage      *stage;
+  gulong             paint_handler;
+  struct wl_callback *frame_callback;
+  guint32            last_frame_time;
+  gint64             frame_interval;
 };
 
 enum
@@ -45,10 +55,16 @@ enum
   PROP_WINDOW
 };
 
+static gint64
+mx_window_wayland_get_frame_interval (MxNativeWindow *window)
+{
+  return MX_WINDOW_WAYLAND (window)->priv->frame_interval;
+}
+
 static void
 mx_native_window_iface_init (MxNativeWindowIface *iface)
 {
-
+  iface->get_frame_interval = mx_window_wayland_get_frame_interval;
 }
 
 
@@ -87,6 +103,22 @@ mx_window_wayland_set_property (GObject      *object,
 static void
 mx_window_wayland_dispose (GObject *object)
 {
+  MxWindowWaylandPrivate *priv = MX_WINDOW_WAYLAND (object)->priv;
+
+  if (priv->frame_callback)
+    {
+      wl_callback_destroy (priv->frame_callback);
+      priv->frame_callback = NULL;
+    }
+
+  if (priv->stage)
+    {
+      g_signal_handler_disconnect (priv->stage, priv->paint_handler);
+      g_object_remove_weak_pointer (G_OBJECT (priv->stage),
+                                    (gpointer *)&priv->stage);
+      priv->stage = NULL;
+    }
+
   G_OBJECT_CLASS (mx_window_wayland_parent_class)->dispose (object);
 }
 
@@ -103,6 +135,60 @@ struct wl_input_device *
 clutter_input_device_wayland_get_input_device (ClutterInputDevice *device);
 
 
+static void
+_frame_callback_done (void               *data,
+                      struct wl_callback *callback,
+                      uint32_t            time)
+{
+  MxWindowWayland *window = data;
+  MxWindowWaylandPrivate *priv = window->priv;
+  gint64 interval;
+
+  wl_callback_destroy (callback);
+  priv->frame_callback = NULL;
+
+  /* The time is the compositor's, in milliseconds, so only the difference
+   * between two frames is of use. It is smoothed, as frames that took
+   * longer to paint than the deadline show up as missed vblanks.
+   */
+  interval = (gint64)(guint32)(time - priv->last_frame_time) * 1000;
+  if (priv->last_frame_time && interval > 0 && interval < MAX_FRAME_INTERVAL)
+    {
+      if (priv->frame_interval)
+        priv->frame_interval = (priv->frame_interval * 3 + interval) / 4;
+      else
+        priv->frame_interval = interval;
+    }
+
+  priv->last_frame_time = time;
+}
+
+static const struct wl_callback_listener frame_listener =
+{
+  _frame_callback_done
+};
+
+static void
+_stage_paint_cb (ClutterActor    *stage,
+                 MxWindowWayland *window)
+{
+  MxWindowWaylandPrivate *priv = window->priv;
+  struct wl_surface *surface;
+
+  /* Only one frame is followed at a time; the request is part of the
+   * commit that presents what is being painted.
+   */
+  if (priv->frame_callback)
+    return;
+
+  surface = clutter_wayland_stage_get_wl_surface (CLUTTER_STAGE (stage));
+  if (!surface)
+    return;
+
+  priv->frame_callback = wl_surface_frame (surface);
+  wl_callback_add_listener (priv->frame_callback, &frame_listener, window);
+}
+
 static gboolean
 _resize_grip_button_press_event_cb (ClutterActor    *actor,
                                     ClutterEvent    *event,
@@ -164,6 +250,16 @@ mx_window_wayland_constructed (GObject *object)
                     "button-press-event",
                     (GCallback)_resize_grip_button_press_event_cb,
                     window_wayland);
+
+  /* Follow when the compositor presents our frames */
+  priv->stage = mx_window_get_clutter_stage (priv->window);
+  g_object_add_weak_pointer (G_OBJECT (priv->stage),
+                             (gpointer *)&priv->stage);
+  priv->paint_handler =
+    g_signal_connect_after (priv->stage,
+                            "paint",
+                            (GCallback)_stage_paint_cb,
+                            window_wayland);
 }
 
 static void
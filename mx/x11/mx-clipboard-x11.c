@@ -42,6 +42,10 @@ G_DEFINE_TYPE (MxClipboard, mx_clipboard, G_TYPE_OBJECT)
 #define CLIPBOARD_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_CLIPBOARD, MxClipboardPrivate))
 
+/* Seconds to wait for a requestor to take the next part of an INCR
+ * transfer before giving up on it */
+#define INCR_TIMEOUT 5
+
 struct _MxClipboardPrivate
 {
   Window clipboard_window;
@@ -49,6 +53,9 @@ struct _MxClipboardPrivate
 
   Atom  *supported_targets;
   gint   n_targets;
+
+  gsize   max_chunk;
+  GSList *transfers;
 };
 
 typedef struct _EventFilterData EventFilterData;
@@ -57,11 +64,124 @@ struct _EventFilterData
   MxClipboard            *clipboard;
   MxClipboardCallbackFunc callback;
   gpointer                user_data;
+
+  /* Set while receiving with the INCR protocol */
+  GString                *incr;
+  Atom                    property;
 };
 
+/* The text being sent with the INCR protocol to one requestor */
+typedef struct
+{
+  MxClipboard *clipboard;
+
+  Window       requestor;
+  Atom         property;
+  Atom         target;
+
+  gchar       *data;
+  gsize        length;
+  gsize        offset;
+
+  guint        timeout_id;
+} MxClipboardTransfer;
+
+/* A range of request serials whose errors are ignored */
+typedef struct
+{
+  gulong start;
+  gulong end;
+} MxClipboardIgnored;
+
 static Atom __atom_clip = None;
 static Atom __utf8_string = None;
 static Atom __atom_targets = None;
+static Atom __atom_incr = None;
+
+static XErrorHandler old_error_handler = NULL;
+static GSList *ignored_errors = NULL;
+
+/* Requestors may go away at any time, but waiting for the server to tell
+ * us whether a request failed would block. So, like GDK does, errors are
+ * ignored based on the serial of the request that caused them.
+ */
+static int
+mx_clipboard_error_handler (Display     *dpy,
+                            XErrorEvent *error)
+{
+  GSList *l;
+
+  for (l = ignored_errors; l; l = l->next)
+    {
+      MxClipboardIgnored *ignored = l->data;
+
+      if (error->serial >= ignored->start && error->serial <= ignored->end)
+        return 0;
+    }
+
+  return old_error_handler ? old_error_handler (dpy, error) : 0;
+}
+
+static gulong
+mx_clipboard_ignore_errors_begin (Display *dpy)
+{
+  gulong processed = LastKnownRequestProcessed (dpy);
+  GSList *l, *next;
+
+  /* Forget the ranges the server is done with */
+  for (l = ignored_errors; l; l = next)
+    {
+      MxClipboardIgnored *ignored = l->data;
+
+      next = l->next;
+      if (ignored->end < processed)
+        {
+          g_free (ignored);
+          ignored_errors = g_slist_delete_link (ignored_errors, l);
+        }
+    }
+
+  return NextRequest (dpy);
+}
+
+static void
+mx_clipboard_ignore_errors_end (Display *dpy,
+                                gulong   start)
+{
+  MxClipboardIgnored *ignored;
+  gulong end = NextRequest (dpy) - 1;
+
+  if (end < start)
+    return;
+
+  ignored = g_new (MxClipboardIgnored, 1);
+  ignored->start = start;
+  ignored->end = end;
+  ignored_errors = g_slist_prepend (ignored_errors, ignored);
+}
+
+static void
+mx_clipboard_transfer_free (MxClipboardTransfer *transfer)
+{
+  MxClipboardPrivate *priv = transfer->clipboard->priv;
+
+  priv->transfers = g_slist_remove (priv->transfers, transfer);
+
+  if (transfer->timeout_id)
+    g_source_remove (transfer->timeout_id);
+
+  g_free (transfer->data);
+  g_free (transfer);
+}
+
+static gboolean
+mx_clipboard_transfer_timeout_cb (MxClipboardTransfer *transfer)
+{
+  transfer->timeout_id = 0;
+  mx_clipboard_transfer_free (transfer);
+
+  return FALSE;
+}
 
 static void
 mx_clipboard_get_property (GObject    *object,
@@ -107,72 +227,211 @@ mx_clipboard_finalize (GObject *object)
   priv->supported_targets = NULL;
   priv->n_targets = 0;
 
+  while (priv->transfers)
+    mx_clipboard_transfer_free (priv->transfers->data);
+
   G_OBJECT_CLASS (mx_clipboard_parent_class)->finalize (object);
 }
 
+static void
+mx_clipboard_send_notify (XSelectionRequestEvent *req_event,
+                          Atom                    property)
+{
+  XSelectionEvent notify_event;
+
+  notify_event.type = SelectionNotify;
+  notify_event.display = req_event->display;
+  notify_event.requestor = req_event->requestor;
+  notify_event.selection = req_event->selection;
+  notify_event.target = req_event->target;
+  notify_event.time = req_event->time;
+  notify_event.property = property;
+
+  XSendEvent (req_event->display, req_event->requestor, False, 0,
+              (XEvent *) &notify_event);
+}
+
+static void
+mx_clipboard_start_transfer (MxClipboard            *clipboard,
+                             XSelectionRequestEvent *req_event,
+                             Atom                    property)
+{
+  MxClipboardPrivate *priv = clipboard->priv;
+  MxClipboardTransfer *transfer;
+  long length;
+  GSList *l;
+
+  /* A requestor asking again starts over */
+  for (l = priv->transfers; l; l = l->next)
+    {
+      transfer = l->data;
+      if (transfer->requestor == req_event->requestor &&
+          transfer->property == property)
+        {
+          mx_clipboard_transfer_free (transfer);
+          break;
+        }
+    }
+
+  transfer = g_new0 (MxClipboardTransfer, 1);
+  transfer->clipboard = clipboard;
+  transfer->requestor = req_event->requestor;
+  transfer->property = property;
+  transfer->target = req_event->target;
+  transfer->length = strlen (priv->clipboard_text);
+  transfer->data = g_strndup (priv->clipboard_text, transfer->length);
+  transfer->timeout_id =
+    g_timeout_add_seconds (INCR_TIMEOUT,
+                           (GSourceFunc) mx_clipboard_transfer_timeout_cb,
+                           transfer);
+  priv->transfers = g_slist_prepend (priv->transfers, transfer);
+
+  /* The requestor deletes the property each time it has read a part */
+  XSelectInput (req_event->display, req_event->requestor,
+                PropertyChangeMask);
+
+  length = transfer->length;
+  XChangeProperty (req_event->display,
+                   req_event->requestor,
+                   property,
+                   __atom_incr,
+                   32,
+                   PropModeReplace,
+                   (guchar*) &length,
+                   1);
+}
+
+static ClutterX11FilterReturn
+mx_clipboard_continue_transfer (MxClipboard    *clipboard,
+                                XPropertyEvent *prop_event)
+{
+  MxClipboardTransfer *transfer = NULL;
+  gulong serial;
+  gsize chunk;
+  GSList *l;
+
+  if (prop_event->state != PropertyDelete)
+    return CLUTTER_X11_FILTER_CONTINUE;
+
+  for (l = clipboard->priv->transfers; l; l = l->next)
+    {
+      MxClipboardTransfer *t = l->data;
+
+      if (t->requestor == prop_event->window &&
+          t->property == prop_event->atom)
+        {
+          transfer = t;
+          break;
+        }
+    }
+
+  if (!transfer)
+    return CLUTTER_X11_FILTER_CONTINUE;
+
+  chunk = MIN (transfer->length - transfer->offset,
+               clipboard->priv->max_chunk);
+
+  serial = mx_clipboard_ignore_errors_begin (prop_event->display);
+
+  /* The last part is empty, to mark the end of the transfer */
+  XChangeProperty (prop_event->display,
+                   transfer->requestor,
+                   transfer->property,
+                   transfer->target,
+                   8,
+                   PropModeReplace,
+                   (guchar*) transfer->data + transfer->offset,
+                   chunk);
+
+  if (chunk)
+    {
+      transfer->offset += chunk;
+
+      g_source_remove (transfer->timeout_id);
+      transfer->timeout_id =
+        g_timeout_add_seconds (INCR_TIMEOUT,
+                               (GSourceFunc) mx_clipboard_transfer_timeout_cb,
+                               transfer);
+    }
+  else
+    {
+      XSelectInput (prop_event->display, transfer->requestor, NoEventMask);
+      mx_clipboard_transfer_free (transfer);
+    }
+
+  mx_clipboard_ignore_errors_end (prop_event->display, serial);
+  XFlush (prop_event->display);
+
+  return CLUTTER_X11_FILTER_REMOVE;
+}
+
 static ClutterX11FilterReturn
 mx_clipboard_provider (XEvent       *xev,
                        ClutterEvent *cev,
                        MxClipboard  *clipboard)
 {
-  XSelectionEvent notify_event;
+  MxClipboardPrivate *priv = clipboard->priv;
   XSelectionRequestEvent *req_event;
+  Atom property;
+  gulong serial;
+
+  if (xev->type == PropertyNotify)
+    return mx_clipboard_continue_transfer (clipboard, &xev->xproperty);
 
   if (xev->type != SelectionRequest)
     return CLUTTER_X11_FILTER_CONTINUE;
 
   req_event = &xev->xselectionrequest;
 
-  clutter_x11_trap_x_errors ();
+  if (req_event->owner != priv->clipboard_window)
+    return CLUTTER_X11_FILTER_CONTINUE;
+
+  /* Obsolete requestors don't give a property */
+  if (req_event->property == None)
+    property = req_event->target;
+  else
+    property = req_event->property;
+
+  serial = mx_clipboard_ignore_errors_begin (req_event->display);
 
   if (req_event->target == __atom_targets)
     {
       XChangeProperty (req_event->display,
                        req_event->requestor,
-                       req_event->property,
+                       property,
                        XA_ATOM,
                        32,
                        PropModeReplace,
-                       (guchar*) clipboard->priv->supported_targets,
-                       clipboard->priv->n_targets);
+                       (guchar*) priv->supported_targets,
+                       priv->n_targets);
     }
-  else
+  else if (req_event->target == __utf8_string && priv->clipboard_text)
     {
-      if (!clipboard->priv->clipboard_text)
-        {
-          g_warning ("Clipboard request received, but no text available");
-          return CLUTTER_X11_FILTER_REMOVE;
-        }
-
-      XChangeProperty (req_event->display,
-                       req_event->requestor,
-                       req_event->property,
-                       req_event->target,
-                       8,
-                       PropModeReplace,
-                       (guchar*) clipboard->priv->clipboard_text,
-                       strlen (clipboard->priv->clipboard_text));
+      gsize length = strlen (priv->clipboard_text);
+
+      if (length > priv->max_chunk)
+        mx_clipboard_start_transfer (clipboard, req_event, property);
+      else
+        XChangeProperty (req_event->display,
+                         req_event->requestor,
+                         property,
+                         req_event->target,
+                         8,
+                         PropModeReplace,
+                         (guchar*) priv->clipboard_text,
+                         length);
     }
-
-  notify_event.type = SelectionNotify;
-  notify_event.display = req_event->display;
-  notify_event.requestor = req_event->requestor;
-  notify_event.selection = req_event->selection;
-  notify_event.target = req_event->target;
-  notify_event.time = req_event->time;
-
-  if (req_event->property == None)
-    notify_event.property = req_event->target;
   else
-    notify_event.property = req_event->property;
+    {
+      /* Refuse the conversion */
+      property = None;
+    }
 
   /* notify the requestor that they have a copy of the selection */
-  XSendEvent (req_event->display, req_event->requestor, False, 0,
-              (XEvent *) &notify_event);
-  /* Make it happen non async */
-  XSync (clutter_x11_get_default_display(), FALSE);
+  mx_clipboard_send_notify (req_event, property);
 
-  clutter_x11_untrap_x_errors (); /* FIXME: Warn here on fail ? */
+  mx_clipboard_ignore_errors_end (req_event->display, serial);
+  XFlush (req_event->display);
 
   return CLUTTER_X11_FILTER_REMOVE;
 }
@@ -196,6 +455,7 @@ mx_clipboard_init (MxClipboard *self)
 {
   Display *dpy;
   MxClipboardPrivate *priv;
+  long max_request;
 
   priv = self->priv = CLIPBOARD_PRIVATE (self);
 
@@ -206,15 +466,31 @@ mx_clipboard_init (MxClipboard *self)
 
   dpy = clutter_x11_get_default_display ();
 
-  /* Only create once */
+  /* We read the INCR parts from property changes on our window */
+  XSelectInput (dpy, priv->clipboard_window, PropertyChangeMask);
+
+  /* Only create once, and in a single round-trip */
   if (__atom_clip == None)
-    __atom_clip = XInternAtom (dpy, "CLIPBOARD", 0);
+    {
+      static char *names[] = { "CLIPBOARD", "UTF8_STRING", "TARGETS",
+                               "INCR" };
+      Atom atoms[G_N_ELEMENTS (names)];
 
-  if (__utf8_string == None)
-    __utf8_string = XInternAtom (dpy, "UTF8_STRING", 0);
+      XInternAtoms (dpy, names, G_N_ELEMENTS (names), False, atoms);
 
-  if (__atom_targets == None)
-    __atom_targets = XInternAtom (dpy, "TARGETS", 0);
+      __atom_clip = atoms[0];
+      __utf8_string = atoms[1];
+      __atom_targets = atoms[2];
+      __atom_incr = atoms[3];
+
+      old_error_handler = XSetErrorHandler (mx_clipboard_error_handler);
+    }
+
+  /* Anything larger than a request is sent with the INCR protocol */
+  max_request = XExtendedMaxRequestSize (dpy);
+  if (!max_request)
+    max_request = XMaxRequestSize (dpy);
+  priv->max_chunk = max_request * 4 - 100;
 
   priv->n_targets = 2;
   priv->supported_targets = g_new (Atom, priv->n_targets);
@@ -226,37 +502,71 @@ mx_clipboard_init (MxClipboard *self)
                           self);
 }
 
+static ClutterX11FilterReturn
+mx_clipboard_x11_event_filter (XEvent          *xev,
+                               ClutterEvent    *cev,
+                               EventFilterData *filter_data);
+
+static ClutterX11FilterReturn
+mx_clipboard_x11_finish (EventFilterData *filter_data,
+                         const gchar     *text)
+{
+  filter_data->callback (filter_data->clipboard, text,
+                         filter_data->user_data);
+
+  clutter_x11_remove_filter
+                          ((ClutterX11FilterFunc) mx_clipboard_x11_event_filter,
+                          filter_data);
+
+  if (filter_data->incr)
+    g_string_free (filter_data->incr, TRUE);
+  g_free (filter_data);
+
+  return CLUTTER_X11_FILTER_REMOVE;
+}
+
 static ClutterX11FilterReturn
 mx_clipboard_x11_event_filter (XEvent          *xev,
                                ClutterEvent    *cev,
                                EventFilterData *filter_data)
 {
-  Atom actual_type;
+  Atom actual_type, property;
   int actual_format, result;
   unsigned long nitems, bytes_after;
   unsigned char *data = NULL;
+  Window window = filter_data->clipboard->priv->clipboard_window;
+  ClutterX11FilterReturn retval;
 
-  if(xev->type != SelectionNotify)
-    return CLUTTER_X11_FILTER_CONTINUE;
-
-  if (xev->xselection.property == None)
+  if (filter_data->incr)
     {
-      /* clipboard empty */
-      filter_data->callback (filter_data->clipboard,
-                             NULL,
-                             filter_data->user_data);
-
-      clutter_x11_remove_filter ((ClutterX11FilterFunc) mx_clipboard_x11_event_filter,
-                                 filter_data);
-      g_free (filter_data);
-      return CLUTTER_X11_FILTER_REMOVE;
+      /* A part of an INCR transfer is ready */
+      if (xev->type != PropertyNotify ||
+          xev->xproperty.window != window ||
+          xev->xproperty.atom != filter_data->property ||
+          xev->xproperty.state != PropertyNewValue)
+        return CLUTTER_X11_FILTER_CONTINUE;
+
+      property = filter_data->property;
     }
+  else
+    {
+      if (xev->type != SelectionNotify ||
+          xev->xselection.requestor != window)
+        return CLUTTER_X11_FILTER_CONTINUE;
+
+      if (xev->xselection.property == None)
+        {
+          /* clipboard empty */
+          return mx_clipboard_x11_finish (filter_data, NULL);
+        }
 
-  clutter_x11_trap_x_errors ();
+      property = xev->xselection.property;
+    }
 
-  result = XGetWindowProperty (xev->xselection.display,
-                               xev->xselection.requestor,
-                               xev->xselection.property,
+  /* Deleting the property asks for the next part of an INCR transfer */
+  result = XGetWindowProperty (xev->xany.display,
+                               window,
+                               property,
                                0L, G_MAXINT,
                                True,
                                AnyPropertyType,
@@ -266,25 +576,40 @@ mx_clipboard_x11_event_filter (XEvent          *xev,
                                &bytes_after,
                                &data);
 
-  if (clutter_x11_untrap_x_errors () || result != Success)
+  if (result != Success)
     {
       /* FIXME: handle failure better */
       g_warning ("Clipboard: prop retrival failed");
+      return mx_clipboard_x11_finish (filter_data, NULL);
     }
 
-  filter_data->callback (filter_data->clipboard, (char*) data,
-                         filter_data->user_data);
-
-  clutter_x11_remove_filter
-                          ((ClutterX11FilterFunc) mx_clipboard_x11_event_filter,
-                          filter_data);
-
-  g_free (filter_data);
+  if (filter_data->incr)
+    {
+      if (nitems)
+        {
+          g_string_append_len (filter_data->incr, (gchar *) data, nitems);
+          retval = CLUTTER_X11_FILTER_REMOVE;
+        }
+      else
+        {
+          /* An empty part ends the transfer */
+          retval = mx_clipboard_x11_finish (filter_data,
+                                            filter_data->incr->str);
+        }
+    }
+  else if (actual_type == __atom_incr)
+    {
+      filter_data->incr = g_string_new (NULL);
+      filter_data->property = property;
+      retval = CLUTTER_X11_FILTER_REMOVE;
+    }
+  else
+    retval = mx_clipboard_x11_finish (filter_data, (char*) data);
 
   if (data)
     XFree (data);
 
-  return CLUTTER_X11_FILTER_REMOVE;
+  return retval;
 }
 
 /**
@@ -340,15 +665,11 @@ mx_clipboard_get_text (MxClipboard            *clipboard,
 
   dpy = clutter_x11_get_default_display ();
 
-  clutter_x11_trap_x_errors (); /* safety on */
-
   XConvertSelection (dpy,
                      __atom_clip,
                      __utf8_string, __utf8_string,
                      clipboard->priv->clipboard_window,
                      CurrentTime);
-
-  clutter_x11_untrap_x_errors ();
 }
 
 /**
@@ -378,10 +699,5 @@ mx_clipboard_set_text (MxClipboard *clipboard,
   /* tell X we own the clipboard selection */
   dpy = clutter_x11_get_default_display ();
 
-  clutter_x11_trap_x_errors ();
-
   XSetSelectionOwner (dpy, __atom_clip, priv->clipboard_window, CurrentTime);
-  XSync (dpy, FALSE);
-
-  clutter_x11_untrap_x_errors ();
 }
@@ -71,6 +71,7 @@ struct _MxSettingsX11Private
   guint  long_press_timeout;
   guint  small_screen : 1;
   guint  atoms_init   : 1;
+  guint  font_changed : 1;
 
   XSettingsClient *client;
   Atom             atoms[G_N_ELEMENTS(mx_settings_atoms)];
@@ -86,6 +87,8 @@ static ClutterX11FilterReturn
 mx_settings_x11_event_filter (XEvent       *xev,
                               ClutterEvent *cev,
                               void         *data);
+static void
+mx_settings_x11_flush_font_changed (MxSettingsX11 *self);
 
 
 static gboolean
@@ -216,9 +219,12 @@ mx_settings_x11_constructed (GObject *object)
   Display *dpy;
   Window root_win;
   XWindowAttributes attr;
+  gint64 start;
 
   MxSettingsX11 *self = MX_SETTINGS_X11 (object);
 
+  start = _mx_startup_trace_begin ();
+
   /* setup xsettings client */
   /* This needs to be done after the construction of the object
    * to prevent recursion because creating a new xsettings client will
@@ -232,6 +238,7 @@ mx_settings_x11_constructed (GObject *object)
                                              xsettings_notify_func,
                                              NULL,
                                              self);
+  mx_settings_x11_flush_font_changed (self);
 
   /* Add X property change notifications to the event mask */
   root_win = clutter_x11_get_root_window ();
@@ -239,6 +246,8 @@ mx_settings_x11_constructed (GObject *object)
     XSelectInput (dpy, root_win, attr.your_event_mask | PropertyChangeMask);
 
   clutter_x11_add_filter (mx_settings_x11_event_filter, self);
+
+  _mx_startup_trace_end ("settings", start);
 }
 
 static void
@@ -304,12 +313,26 @@ xsettings_notify_func (const char       *name,
           _mx_settings_provider_setting_changed (MX_SETTINGS_PROVIDER (cb_data),
                                                  MX_SETTINGS_FONT_NAME);
 
-          g_signal_emit_by_name (mx_style_get_default (), "changed", 0, NULL);
+          /* the style is told once the whole event has been read */
+          priv->font_changed = TRUE;
         }
     }
 
 }
 
+/* Restyles once for the font changes seen since the last call */
+static void
+mx_settings_x11_flush_font_changed (MxSettingsX11 *self)
+{
+  MxSettingsX11Private *priv = self->priv;
+
+  if (priv->font_changed)
+    {
+      priv->font_changed = FALSE;
+      g_signal_emit_by_name (mx_style_get_default (), "changed", 0, NULL);
+    }
+}
+
 static void
 mx_settings_x11_refresh_wm_props (MxSettingsX11 *self)
 {
@@ -450,6 +473,7 @@ mx_settings_x11_event_filter (XEvent       *xev,
                               void         *data)
 {
   Window root_win;
+  Bool handled;
 
   MxSettingsX11 *self = MX_SETTINGS_X11 (data);
   MxSettingsX11Private *priv = self->priv;
@@ -486,7 +510,22 @@ mx_settings_x11_event_filter (XEvent       *xev,
       break;
     }
 
-  if (xsettings_client_process_event (priv->client, xev))
+  /* These are the only events that can change the XSettings; only notify
+   * once for all the settings they change.
+   */
+  if (xev->type == PropertyNotify || xev->type == ClientMessage ||
+      xev->type == DestroyNotify)
+    {
+      g_object_freeze_notify (G_OBJECT (priv->settings));
+      handled = xsettings_client_process_event (priv->client, xev);
+      g_object_thaw_notify (G_OBJECT (priv->settings));
+
+      mx_settings_x11_flush_font_changed (self);
+    }
+  else
+    handled = False;
+
+  if (handled)
     return CLUTTER_X11_FILTER_REMOVE;
   else
     return CLUTTER_X11_FILTER_CONTINUE;
@@ -46,6 +46,10 @@ G_DEFINE_TYPE_WITH_CODE (MxWindowX11, _mx_window_x11, G_TYPE_OBJECT,
 #define WINDOW_X11_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_WINDOW_X11, MxWindowX11Private))
 
+/* From the EWMH specification */
+#define _NET_WM_MOVERESIZE_SIZE_BOTTOMRIGHT 4
+#define _NET_WM_MOVERESIZE_MOVE             8
+
 struct _MxWindowX11Private
 {
   MxWindow *window;
@@ -55,9 +59,17 @@ struct _MxWindowX11Private
   guint width_set     : 1;
   guint height_set    : 1;
   guint icon_changed  : 1;
+  guint has_root_xy   : 1;
 
   ClutterInputDevice  *is_moving;
 
+  gint  rr_event_base;
+  gint  screen_width;
+  gint  screen_height;
+
+  gint  root_x;
+  gint  root_y;
+
   gfloat     last_width;
   gfloat     last_height;
   gfloat     natural_width;
@@ -69,6 +81,16 @@ struct _MxWindowX11Private
   gint  drag_win_y_start;
   guint drag_width_start;
   guint drag_height_start;
+  gfloat drag_stage_x_start;
+  gfloat drag_stage_y_start;
+
+  gfloat resize_width;
+  gfloat resize_height;
+  guint  resize_id;
+
+  /* the part of the window that is opaque, if has_opaque_region is set */
+  guint           has_opaque_region : 1;
+  ClutterActorBox opaque_region;
 };
 
 enum
@@ -224,6 +246,96 @@ typedef struct {
     unsigned long status;
 } PropMotifWmHints;
 
+/* The _NET_WM_ICON data of a texture, which is kept with the texture.
+ * Textures are shared by all the windows, as their stages render with the
+ * one Cogl context of the backend and the texture cache hands out the same
+ * texture for the same icon, so the icon is only read back from the GPU
+ * once however many windows use it. */
+typedef struct
+{
+  gulong *data;
+  gint    n_items;
+} MxWindowX11Icon;
+
+static CoglUserDataKey icon_key;
+
+static void
+mx_window_x11_icon_free (gpointer data)
+{
+  MxWindowX11Icon *icon = data;
+
+  g_free (icon->data);
+  g_slice_free (MxWindowX11Icon, icon);
+}
+
+static MxWindowX11Icon *
+mx_window_x11_get_icon (CoglHandle texture)
+{
+  MxWindowX11Icon *icon;
+  guint width, height;
+  gulong *data;
+  gint size;
+
+  icon = cogl_object_get_user_data ((CoglObject *) texture, &icon_key);
+  if (icon)
+    return icon;
+
+  /* Get window icon size */
+  width = cogl_texture_get_width (texture);
+  height = cogl_texture_get_height (texture);
+  size = cogl_texture_get_data (texture,
+                                MX_WINDOW_X11_GET_TEXTURE_DATA_FORMAT,
+                                width * 4,
+                                NULL);
+  if (size != width * height * 4)
+    {
+      g_warning ("Unable to get texture data in "
+                 "correct format for window icon");
+      return NULL;
+    }
+
+  data = g_new (gulong, width * height + 2);
+  data[0] = width;
+  data[1] = height;
+
+  /* Get the window icon */
+  if (cogl_texture_get_data (texture,
+                             MX_WINDOW_X11_GET_TEXTURE_DATA_FORMAT,
+                             width * 4,
+                             (guint8 *) (data + 2)) != size)
+    {
+      g_warning ("Size mismatch when retrieving texture data "
+                 "for window icon");
+      g_free (data);
+      return NULL;
+    }
+
+  /* For some inexplicable reason XChangeProperty always takes
+   * an array of longs when the format == 32 even on 64-bit
+   * architectures where sizeof(long) != 32. Therefore we need
+   * to pointlessly pad each 32-bit value with an extra 4
+   * bytes so that libX11 can remove them again to send the
+   * request. We can do this in-place if we start from the
+   * end */
+  if (sizeof (gulong) != 4)
+    {
+      const guint32 *src = (guint32 *) (data + 2) + width * height;
+      gulong *dst = data + 2 + width * height;
+
+      while (dst > data + 2)
+        *(--dst) = *(--src);
+    }
+
+  icon = g_slice_new (MxWindowX11Icon);
+  icon->data = data;
+  icon->n_items = (width * height) + 2;
+
+  cogl_object_set_user_data ((CoglObject *) texture, &icon_key, icon,
+                             mx_window_x11_icon_free);
+
+  return icon;
+}
+
 static void
 mx_window_x11_set_wm_hints (MxWindowX11 *self)
 {
@@ -287,9 +399,7 @@ mx_window_x11_set_wm_hints (MxWindowX11 *self)
 
   if ((icon_name || texture) && net_wm_icon)
     {
-      guint width, height;
-      gulong *data;
-      gint size;
+      MxWindowX11Icon *icon;
 
       /* Lookup icon for program name if there's no texture set */
       if (!texture)
@@ -307,59 +417,85 @@ mx_window_x11_set_wm_hints (MxWindowX11 *self)
             }
         }
 
-      /* Get window icon size */
-      width = cogl_texture_get_width (texture);
-      height = cogl_texture_get_height (texture);
-      size = cogl_texture_get_data (texture,
-                                    MX_WINDOW_X11_GET_TEXTURE_DATA_FORMAT,
-                                    width * 4,
-                                    NULL);
-      if (size != width * height * 4)
-        {
-          g_warning ("Unable to get texture data in "
-                     "correct format for window icon");
-          cogl_handle_unref (texture);
-          return;
-        }
+      icon = mx_window_x11_get_icon (texture);
 
-      data = g_new (gulong, width * height + 2);
-      data[0] = width;
-      data[1] = height;
+      /* Set the property */
+      if (icon)
+        XChangeProperty (dpy, win, net_wm_icon, XA_CARDINAL,
+                         32, PropModeReplace, (unsigned char *) icon->data,
+                         icon->n_items);
 
-      /* Get the window icon */
-      if (cogl_texture_get_data (texture,
-                                 MX_WINDOW_X11_GET_TEXTURE_DATA_FORMAT,
-                                 width * 4,
-                                 (guint8 *) (data + 2)) == size)
-        {
-          /* For some inexplicable reason XChangeProperty always takes
-           * an array of longs when the format == 32 even on 64-bit
-           * architectures where sizeof(long) != 32. Therefore we need
-           * to pointlessly pad each 32-bit value with an extra 4
-           * bytes so that libX11 can remove them again to send the
-           * request. We can do this in-place if we start from the
-           * end */
-          if (sizeof (gulong) != 4)
-            {
-              const guint32 *src = (guint32 *) (data + 2) + width * height;
-              gulong *dst = data + 2 + width * height;
+      cogl_handle_unref (texture);
+    }
+}
 
-              while (dst > data + 2)
-                *(--dst) = *(--src);
-            }
+/* Sets the hints that let a compositor skip blending the opaque part of
+ * the window, and not composite it at all when it is fullscreen, so that
+ * it can be scanned out directly */
+static void
+mx_window_x11_set_compositor_hints (MxWindowX11 *self)
+{
+  MxWindowX11Private *priv = self->priv;
+  ClutterStage *stage;
+  gulong bypass;
+  Display *dpy;
+  Window win;
 
-          /* Set the property */
-          XChangeProperty (dpy, win, net_wm_icon, XA_CARDINAL,
-                           32, PropModeReplace, (unsigned char *) data,
-                           (width * height) + 2);
-        }
-      else
-        g_warning ("Size mismatch when retrieving texture data "
-                   "for window icon");
+  static Atom net_wm_opaque_region = None;
+  static Atom net_wm_bypass_compositor = None;
 
-      cogl_handle_unref (texture);
-      g_free (data);
+  stage = mx_window_get_clutter_stage (priv->window);
+  if (!stage)
+    return;
+
+  /* set again when the stage is mapped */
+  win = clutter_x11_get_stage_window (stage);
+  if (win == None)
+    return;
+
+  dpy = clutter_x11_get_default_display ();
+
+  if (!net_wm_opaque_region)
+    {
+      net_wm_opaque_region =
+        XInternAtom (dpy, "_NET_WM_OPAQUE_REGION", False);
+      net_wm_bypass_compositor =
+        XInternAtom (dpy, "_NET_WM_BYPASS_COMPOSITOR", False);
     }
+
+  if (priv->has_opaque_region)
+    {
+      gulong region[4];
+
+      region[0] = priv->opaque_region.x1;
+      region[1] = priv->opaque_region.y1;
+      region[2] = priv->opaque_region.x2 - priv->opaque_region.x1;
+      region[3] = priv->opaque_region.y2 - priv->opaque_region.y1;
+
+      XChangeProperty (dpy, win, net_wm_opaque_region, XA_CARDINAL,
+                       32, PropModeReplace, (unsigned char *) region, 4);
+    }
+  else
+    XDeleteProperty (dpy, win, net_wm_opaque_region);
+
+  /* 1 asks for composition to be bypassed, 0 leaves it to the
+   * compositor */
+  bypass = clutter_stage_get_fullscreen (stage) ? 1 : 0;
+  XChangeProperty (dpy, win, net_wm_bypass_compositor, XA_CARDINAL,
+                   32, PropModeReplace, (unsigned char *) &bypass, 1);
+}
+
+static void
+mx_window_x11_set_opaque_region (MxNativeWindow        *window,
+                                 const ClutterActorBox *region)
+{
+  MxWindowX11 *self = MX_WINDOW_X11 (window);
+
+  self->priv->has_opaque_region = (region != NULL);
+  if (region)
+    self->priv->opaque_region = *region;
+
+  mx_window_x11_set_compositor_hints (self);
 }
 
 static void
@@ -368,7 +504,10 @@ mx_window_x11_mapped_notify_cb (ClutterActor *actor,
                                 MxWindowX11  *self)
 {
   if (CLUTTER_ACTOR_IS_MAPPED (actor))
-    mx_window_x11_set_wm_hints (self);
+    {
+      mx_window_x11_set_wm_hints (self);
+      mx_window_x11_set_compositor_hints (self);
+    }
 }
 
 static void
@@ -380,6 +519,196 @@ mx_window_x11_has_toolbar_notify_cb (MxWindow    *window,
     mx_window_x11_set_wm_hints (self);
 }
 
+/* The screen size is kept until RandR says that it changed, see
+ * mx_window_x11_event_filter() */
+static void
+mx_window_x11_get_screen_size (MxWindowX11 *self,
+                               gint        *width,
+                               gint        *height)
+{
+  MxWindowX11Private *priv = self->priv;
+
+  if (!priv->screen_width || !priv->screen_height)
+    {
+      Display *dpy = clutter_x11_get_default_display ();
+      int screen = clutter_x11_get_default_screen ();
+
+      priv->screen_width = DisplayWidth (dpy, screen);
+      priv->screen_height = DisplayHeight (dpy, screen);
+    }
+
+  *width = priv->screen_width;
+  *height = priv->screen_height;
+}
+
+static ClutterX11FilterReturn
+mx_window_x11_event_filter (XEvent       *xev,
+                            ClutterEvent *cev,
+                            gpointer      data)
+{
+  MxWindowX11 *self = MX_WINDOW_X11 (data);
+  MxWindowX11Private *priv = self->priv;
+  ClutterStage *stage;
+
+  if ((priv->rr_event_base >= 0) &&
+      (xev->type == priv->rr_event_base + RRScreenChangeNotify))
+    {
+      XRRUpdateConfiguration (xev);
+      priv->screen_width = priv->screen_height = 0;
+      return CLUTTER_X11_FILTER_CONTINUE;
+    }
+
+  if ((xev->type != ButtonPress) && (xev->type != MotionNotify))
+    return CLUTTER_X11_FILTER_CONTINUE;
+
+  stage = mx_window_get_clutter_stage (priv->window);
+  if (!stage || (xev->xany.window != clutter_x11_get_stage_window (stage)))
+    return CLUTTER_X11_FILTER_CONTINUE;
+
+  /* Keep the root coordinates of the last pointer event, so that moving
+   * the window doesn't need to ask the server where the pointer is. This
+   * is only known for core events, XI2 events are left to Clutter.
+   */
+  if (xev->type == ButtonPress)
+    {
+      priv->root_x = xev->xbutton.x_root;
+      priv->root_y = xev->xbutton.y_root;
+    }
+  else
+    {
+      priv->root_x = xev->xmotion.x_root;
+      priv->root_y = xev->xmotion.y_root;
+    }
+  priv->has_root_xy = TRUE;
+
+  return CLUTTER_X11_FILTER_CONTINUE;
+}
+
+static void
+mx_window_x11_get_root_pointer (MxWindowX11 *self,
+                                Window       win,
+                                gint         stage_x,
+                                gint         stage_y,
+                                gint        *x,
+                                gint        *y)
+{
+  MxWindowX11Private *priv = self->priv;
+  Display *dpy;
+  Window child;
+
+  if (priv->has_root_xy)
+    {
+      *x = priv->root_x;
+      *y = priv->root_y;
+      return;
+    }
+
+  dpy = clutter_x11_get_default_display ();
+  XTranslateCoordinates (dpy, win, clutter_x11_get_root_window (),
+                         stage_x, stage_y, x, y, &child);
+}
+
+static gboolean
+mx_window_x11_wm_supports (Display *dpy,
+                           Atom     atom)
+{
+  unsigned long n_atoms, bytes_after;
+  Atom type, *atoms = NULL;
+  gboolean supported;
+  int format;
+  guint i;
+
+  if (XGetWindowProperty (dpy, clutter_x11_get_root_window (),
+                          XInternAtom (dpy, "_NET_SUPPORTED", False),
+                          0, G_MAXLONG, False, XA_ATOM,
+                          &type, &format, &n_atoms, &bytes_after,
+                          (guchar **)&atoms) != Success)
+    return FALSE;
+
+  supported = FALSE;
+  if ((type == XA_ATOM) && (format == 32))
+    {
+      for (i = 0; i < n_atoms; i++)
+        if (atoms[i] == atom)
+          {
+            supported = TRUE;
+            break;
+          }
+    }
+
+  if (atoms)
+    XFree (atoms);
+
+  return supported;
+}
+
+/* Hands the move/resize started by @event to the window manager, which
+ * knows about struts, snapping and the rest, and saves us moving the
+ * window one step behind the pointer.
+ */
+static gboolean
+mx_window_x11_wm_moveresize (MxWindowX11  *self,
+                             ClutterEvent *event,
+                             Window        win)
+{
+  XClientMessageEvent xclient;
+  MxWindowX11Private *priv;
+  Atom moveresize;
+  Display *dpy;
+  gfloat x, y;
+  gint root_x, root_y;
+
+  priv = self->priv;
+  dpy = clutter_x11_get_default_display ();
+
+  moveresize = XInternAtom (dpy, "_NET_WM_MOVERESIZE", False);
+  if (!mx_window_x11_wm_supports (dpy, moveresize))
+    return FALSE;
+
+  clutter_event_get_coords (event, &x, &y);
+  mx_window_x11_get_root_pointer (self, win, x, y, &root_x, &root_y);
+
+  /* The window manager needs to grab the pointer itself */
+  XUngrabPointer (dpy, clutter_event_get_time (event));
+
+  memset (&xclient, 0, sizeof (xclient));
+  xclient.type = ClientMessage;
+  xclient.window = win;
+  xclient.message_type = moveresize;
+  xclient.format = 32;
+  xclient.data.l[0] = root_x;
+  xclient.data.l[1] = root_y;
+  xclient.data.l[2] = priv->is_resizing ?
+    _NET_WM_MOVERESIZE_SIZE_BOTTOMRIGHT : _NET_WM_MOVERESIZE_MOVE;
+  xclient.data.l[3] = clutter_event_get_button (event);
+  xclient.data.l[4] = 1;
+
+  XSendEvent (dpy,
+              clutter_x11_get_root_window (),
+              False,
+              SubstructureRedirectMask | SubstructureNotifyMask,
+              (XEvent *)&xclient);
+
+  return TRUE;
+}
+
+static gboolean
+mx_window_x11_flush_resize (gpointer data)
+{
+  MxWindowX11 *self = MX_WINDOW_X11 (data);
+  MxWindowX11Private *priv = self->priv;
+  ClutterStage *stage;
+
+  priv->resize_id = 0;
+
+  stage = mx_window_get_clutter_stage (priv->window);
+  if (stage)
+    clutter_actor_set_size (CLUTTER_ACTOR (stage),
+                            priv->resize_width, priv->resize_height);
+
+  return FALSE;
+}
+
 static void
 mx_window_x11_allocation_changed_cb (ClutterActor           *actor,
                                      ClutterActorBox        *box,
@@ -415,16 +744,10 @@ mx_window_x11_allocation_changed_cb (ClutterActor           *actor,
 
       if (mx_window_get_small_screen (window))
         {
-          XRRScreenResources *res;
-
-          res = XRRGetScreenResourcesCurrent (dpy, win);
+          gint screen_width, screen_height;
 
-          XMoveResizeWindow (dpy, win,
-                             0, 0,
-                             res->modes[res->nmode].width,
-                             res->modes[res->nmode].height);
-
-          XRRFreeScreenResources (res);
+          mx_window_x11_get_screen_size (self, &screen_width, &screen_height);
+          XMoveResizeWindow (dpy, win, 0, 0, screen_width, screen_height);
         }
       else
         {
@@ -463,9 +786,9 @@ mx_window_x11_button_press_event_cb (ClutterActor *actor,
                                      ClutterEvent *event,
                                      MxWindowX11  *self)
 {
-  unsigned int width, height, border_width, depth, mask;
-  Window win, root, child;
-  int x, y, win_x, win_y;
+  unsigned int width, height, border_width, depth;
+  Window win, root;
+  int x, y;
   MxWindowX11Private *priv;
   Display *dpy;
 
@@ -483,14 +806,17 @@ mx_window_x11_button_press_event_cb (ClutterActor *actor,
   if (clutter_event_get_button (event) != 1)
     return FALSE;
 
-  priv->is_moving = clutter_event_get_device (event);
-
   win = clutter_x11_get_stage_window (CLUTTER_STAGE (actor));
   dpy = clutter_x11_get_default_display ();
 
   if (win == None)
     return FALSE;
 
+  if (mx_window_x11_wm_moveresize (self, event, win))
+    return TRUE;
+
+  priv->is_moving = clutter_event_get_device (event);
+
   /* Get the initial width/height */
   XGetGeometry (dpy, win, &root, &x, &y, &width, &height,
                 &border_width, &depth);
@@ -501,7 +827,12 @@ mx_window_x11_button_press_event_cb (ClutterActor *actor,
   priv->drag_height_start = height;
 
   /* Get the initial cursor position */
-  XQueryPointer (dpy, root, &root, &child, &x, &y, &win_x, &win_y, &mask);
+  clutter_event_get_coords (event, &priv->drag_stage_x_start,
+                            &priv->drag_stage_y_start);
+  mx_window_x11_get_root_pointer (self, win,
+                                  priv->drag_stage_x_start,
+                                  priv->drag_stage_y_start,
+                                  &x, &y);
 
   priv->drag_x_start = x;
   priv->drag_y_start = y;
@@ -635,7 +966,6 @@ mx_window_x11_motion_event_cb (ClutterActor *actor,
   Window win, root_win, root, child;
   Display *dpy;
   gfloat event_x, event_y;
-  gfloat height, width;
 
   priv = self->priv;
 
@@ -662,43 +992,60 @@ mx_window_x11_motion_event_cb (ClutterActor *actor,
   if (win == None)
     return FALSE;
 
-  clutter_actor_get_size (actor, &width, &height);
-
   clutter_event_get_coords (event, &event_x, &event_y);
-  x = (int) event_x;
-  y = (int) event_y;
-
-  /* Move/resize the window if we're dragging */
-  offsetx = priv->drag_x_start;
-  offsety = priv->drag_y_start;
-
-  root_win = clutter_x11_get_root_window ();
-  XQueryPointer (dpy, root_win, &root, &child, &x, &y, &winx, &winy, &mask);
 
   if (priv->is_resizing)
     {
-      XRRScreenResources *res;
+      gint screen_width, screen_height;
       gfloat min_width, min_height;
 
       mx_window_x11_get_size (self, &min_width, &min_height, NULL, NULL);
 
-      x = MAX (priv->drag_width_start + (x - priv->drag_x_start), min_width);
-      y = MAX (priv->drag_height_start + (y - priv->drag_y_start), min_height);
+      /* The window doesn't move while resizing, so the stage coordinates
+       * give the distance the pointer travelled.
+       */
+      x = MAX (priv->drag_width_start +
+               (event_x - priv->drag_stage_x_start), min_width);
+      y = MAX (priv->drag_height_start +
+               (event_y - priv->drag_stage_y_start), min_height);
 
-      res = XRRGetScreenResourcesCurrent (dpy, win);
-      width = res->modes[res->nmode].width;
-      height = res->modes[res->nmode].height;
-      XRRFreeScreenResources (res);
+      mx_window_x11_get_screen_size (self, &screen_width, &screen_height);
 
-      width = MIN (x, width - priv->drag_win_x_start);
-      height = MIN (y, height - priv->drag_win_y_start);
+      priv->resize_width = MIN (x, screen_width - priv->drag_win_x_start);
+      priv->resize_height = MIN (y, screen_height - priv->drag_win_y_start);
 
-      clutter_actor_set_size (actor, width, height);
+      /* Resize at most once a frame */
+      if (!priv->resize_id)
+        {
+          priv->resize_id =
+            clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+                                                   mx_window_x11_flush_resize,
+                                                   self, NULL);
+          clutter_actor_queue_redraw (actor);
+        }
+
+      return TRUE;
+    }
+
+  /* Move the window if we're dragging */
+  offsetx = priv->drag_x_start;
+  offsety = priv->drag_y_start;
+
+  if (priv->has_root_xy)
+    {
+      x = priv->root_x;
+      y = priv->root_y;
     }
   else
-    XMoveWindow (dpy, win,
-                 MAX (0, priv->drag_win_x_start + x - offsetx),
-                 MAX (0, priv->drag_win_y_start + y - offsety));
+    {
+      root_win = clutter_x11_get_root_window ();
+      XQueryPointer (dpy, root_win, &root, &child, &x, &y, &winx, &winy,
+                     &mask);
+    }
+
+  XMoveWindow (dpy, win,
+               MAX (0, priv->drag_win_x_start + x - offsetx),
+               MAX (0, priv->drag_win_y_start + y - offsety));
 
   return TRUE;
 }
@@ -736,6 +1083,8 @@ mx_window_x11_fullscreen_set_cb (ClutterStage *stage,
   if (!clutter_stage_get_fullscreen (stage) &&
       mx_window_get_small_screen (priv->window))
     priv->has_mapped = FALSE;
+
+  mx_window_x11_set_compositor_hints (self);
 }
 
 static void
@@ -785,7 +1134,6 @@ mx_window_x11_notify_small_screen_cb (MxWindow    *window,
       if (!mx_window_get_fullscreen (priv->window))
         {
           int width, height;
-          XRRScreenResources *res;
 
           clutter_actor_get_size (CLUTTER_ACTOR (stage),
                                   &priv->last_width,
@@ -796,10 +1144,7 @@ mx_window_x11_notify_small_screen_cb (MxWindow    *window,
            * our small-screen mode won't give the user controls to
            * modify the window, and if it does, just let them.
            */
-          res = XRRGetScreenResourcesCurrent (dpy, win);
-          width = res->modes[res->nmode].width;
-          height = res->modes[res->nmode].height;
-          XRRFreeScreenResources (res);
+          mx_window_x11_get_screen_size (self, &width, &height);
 
           XMoveResizeWindow (dpy, win, 0, 0, width, height);
         }
@@ -844,12 +1189,26 @@ static void
 mx_window_x11_constructed (GObject *object)
 {
   ClutterStage *stage;
+  Display *dpy;
+  int rr_error_base;
 
   MxWindowX11 *self = MX_WINDOW_X11 (object);
   MxWindowX11Private *priv = self->priv;
 
   stage = mx_window_get_clutter_stage (priv->window);
 
+  /* Follow screen size changes, rather than asking for the screen
+   * resources every time the size is needed.
+   */
+  dpy = clutter_x11_get_default_display ();
+  if (XRRQueryExtension (dpy, &priv->rr_event_base, &rr_error_base))
+    XRRSelectInput (dpy, clutter_x11_get_root_window (),
+                    RRScreenChangeNotifyMask);
+  else
+    priv->rr_event_base = -1;
+
+  clutter_x11_add_filter (mx_window_x11_event_filter, self);
+
   g_signal_connect (stage, "notify::mapped",
                     G_CALLBACK (mx_window_x11_mapped_notify_cb), self);
   g_signal_connect (stage, "allocation-changed",
@@ -881,6 +1240,23 @@ mx_window_x11_constructed (GObject *object)
                     G_CALLBACK (mx_window_x11_has_toolbar_notify_cb), self);
 }
 
+static void
+mx_window_x11_dispose (GObject *object)
+{
+  MxWindowX11 *self = MX_WINDOW_X11 (object);
+  MxWindowX11Private *priv = self->priv;
+
+  clutter_x11_remove_filter (mx_window_x11_event_filter, self);
+
+  if (priv->resize_id)
+    {
+      clutter_threads_remove_repaint_func (priv->resize_id);
+      priv->resize_id = 0;
+    }
+
+  G_OBJECT_CLASS (_mx_window_x11_parent_class)->dispose (object);
+}
+
 static void
 mx_window_x11_get_position (MxNativeWindow *self, gint *x, gint *y)
 {
@@ -1014,6 +1390,7 @@ _mx_window_x11_class_init (MxWindowX11Class *klass)
   object_class->get_property = mx_window_x11_get_property;
   object_class->set_property = mx_window_x11_set_property;
   object_class->constructed = mx_window_x11_constructed;
+  object_class->dispose = mx_window_x11_dispose;
 
   g_object_class_override_property (object_class, PROP_WINDOW, "window");
 }
@@ -1030,6 +1407,7 @@ mx_native_window_iface_init (MxNativeWindowIface *iface)
       iface->get_position = mx_window_x11_get_position;
       iface->set_position = mx_window_x11_set_position;
       iface->present = mx_window_x11_present;
+      iface->set_opaque_region = mx_window_x11_set_opaque_region;
     }
 }
 
@@ -1039,6 +1417,7 @@ _mx_window_x11_init (MxWindowX11 *self)
   MxWindowX11Private *priv = self->priv = WINDOW_X11_PRIVATE (self);
 
   priv->icon_changed = TRUE;
+  priv->rr_event_base = -1;
 }
 
 MxNativeWindow *
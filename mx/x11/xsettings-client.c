@@ -48,6 +48,8 @@ struct _XSettingsClient
   Atom xsettings_atom;
 
   XSettingsList *settings;
+  CARD32 serial;
+  Bool have_serial;
 };
 
 static void
@@ -181,6 +183,34 @@ fetch_card8 (XSettingsBuffer *buffer,
 
 #define XSETTINGS_PAD(n,m) ((n + m - 1) & (~(m-1)))
 
+/* Reads the serial of the property, which the manager changes along with
+ * any of the settings */
+static XSettingsResult
+parse_serial (unsigned char *data,
+	      size_t         len,
+	      CARD32        *serial)
+{
+  XSettingsBuffer buffer;
+  XSettingsResult result;
+
+  local_byte_order = xsettings_byte_order ();
+
+  buffer.pos = buffer.data = data;
+  buffer.len = len;
+
+  result = fetch_card8 (&buffer, (unsigned char *)&buffer.byte_order);
+  if (result != XSETTINGS_SUCCESS)
+    return result;
+
+  if (buffer.byte_order != MSBFirst &&
+      buffer.byte_order != LSBFirst)
+    return XSETTINGS_FAILED;
+
+  buffer.pos += 3;
+
+  return fetch_card32 (&buffer, serial);
+}
+
 static XSettingsList *
 parse_settings (unsigned char *data,
 		size_t         len)
@@ -372,6 +402,7 @@ read_settings (XSettingsClient *client)
   int (*old_handler) (Display *, XErrorEvent *);
 
   XSettingsList *old_list = client->settings;
+  CARD32 serial;
 
   client->settings = NULL;
 
@@ -394,13 +425,28 @@ read_settings (XSettingsClient *client)
 	    {
 	      fprintf (stderr, "Invalid format for XSETTINGS property %d", format);
 	    }
+	  else if (parse_serial (data, n_items, &serial) == XSETTINGS_SUCCESS &&
+		   client->have_serial && serial == client->serial)
+	    {
+	      /* Nothing changed, keep the settings we have */
+	      XFree (data);
+	      client->settings = old_list;
+	      return;
+	    }
 	  else
-	    client->settings = parse_settings (data, n_items);
+	    {
+	      client->settings = parse_settings (data, n_items);
+	      client->serial = serial;
+	      client->have_serial = client->settings != NULL;
+	    }
 
 	  XFree (data);
 	}
     }
 
+  if (!client->settings)
+    client->have_serial = False;
+
   notify_changes (client, old_list);
   xsettings_list_free (old_list);
 }
@@ -427,6 +473,9 @@ check_manager_window (XSettingsClient *client)
   else
     XGrabServer (client->display);
 
+  /* A new manager has its own serials */
+  client->have_serial = False;
+
   client->manager_window = XGetSelectionOwner (client->display,
 					       client->selection_atom);
   if (client->manager_window)
@@ -497,6 +546,8 @@ xsettings_client_new_with_grab_funcs (Display             *display,
 
   client->manager_window = None;
   client->settings = NULL;
+  client->serial = 0;
+  client->have_serial = False;
 
   sprintf(buffer, "_XSETTINGS_S%d", screen);
   atom_names[0] = buffer;
@@ -598,7 +649,8 @@ xsettings_client_process_event (XSettingsClient *client,
           /* let GDK do its cleanup */
 	  return False;
 	}
-      else if (xev->xany.type == PropertyNotify)
+      else if (xev->xany.type == PropertyNotify &&
+	       xev->xproperty.atom == client->xsettings_atom)
 	{
 	  read_settings (client);
 	  return True;
@@ -0,0 +1,316 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* The allocations made per frame once scrolling or hovering has settled,
+ * split by what the frame is doing: handling the input, styling, laying
+ * out and painting. Each is reported as the number of allocations and
+ * bytes per frame:
+ *
+ *   alloc.<scene>.<phase>        <allocations>  count
+ *   alloc.<scene>.<phase>.bytes  <bytes>        count
+ *
+ * Budgets are set as BENCH_ALLOC_BUDGETS=<name>=<allocations>[,...], for
+ * instance "alloc.scroll.frame=200,alloc.hover.frame=50"; the benchmark
+ * fails if a result goes over its budget. */
+
+#define N_ROWS     2000
+#define N_BUTTONS  200
+#define N_COLUMNS  10
+
+/* frames run before counting, so that caches are filled */
+#define N_WARMUP   60
+#define N_FRAMES   300
+
+typedef enum
+{
+  PHASE_INPUT,
+  PHASE_STYLE,
+  PHASE_LAYOUT,
+  PHASE_PAINT,
+
+  N_PHASES
+} Phase;
+
+static const gchar *phase_names[N_PHASES] = {
+  "input", "style", "layout", "paint"
+};
+
+typedef struct
+{
+  const gchar     *name;
+  BenchAllocCount  phases[N_PHASES];
+  BenchAllocCount  last;
+  Phase            phase;
+  gboolean         counting;
+} AllocFrames;
+
+static GHashTable *budgets = NULL;
+static gboolean over_budget = FALSE;
+
+static void
+load_budgets (void)
+{
+  const gchar *env;
+  gchar **entries;
+  gint i;
+
+  budgets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  env = g_getenv ("BENCH_ALLOC_BUDGETS");
+  if (!env)
+    return;
+
+  entries = g_strsplit (env, ",", -1);
+  for (i = 0; entries[i]; i++)
+    {
+      gchar *equals = strchr (entries[i], '=');
+
+      if (!equals)
+        {
+          g_printerr ("Ignoring allocation budget '%s'\n", entries[i]);
+          continue;
+        }
+
+      *equals = '\0';
+      g_hash_table_insert (budgets, g_strdup (g_strstrip (entries[i])),
+                           GUINT_TO_POINTER (strtoul (equals + 1, NULL, 10)));
+    }
+  g_strfreev (entries);
+}
+
+static void
+report (const gchar *name,
+        guint64      n_allocs,
+        guint64      n_bytes)
+{
+  gchar *bytes_name;
+  gpointer budget;
+
+  bench_report_count (name, n_allocs);
+
+  bytes_name = g_strconcat (name, ".bytes", NULL);
+  bench_report_count (bytes_name, n_bytes);
+  g_free (bytes_name);
+
+  if (g_hash_table_lookup_extended (budgets, name, NULL, &budget) &&
+      n_allocs > GPOINTER_TO_UINT (budget))
+    {
+      g_printerr ("%s: %" G_GUINT64_FORMAT " allocations per frame, over "
+                  "the budget of %u\n", name, n_allocs,
+                  GPOINTER_TO_UINT (budget));
+      over_budget = TRUE;
+    }
+}
+
+/* Charges the allocations since the last phase began to it, and starts
+ * @phase */
+static void
+frames_enter (AllocFrames *frames,
+              Phase        phase)
+{
+  BenchAllocCount now;
+
+  bench_alloc_get_count (&now);
+
+  if (frames->counting)
+    {
+      frames->phases[frames->phase].n_allocs +=
+        now.n_allocs - frames->last.n_allocs;
+      frames->phases[frames->phase].n_bytes +=
+        now.n_bytes - frames->last.n_bytes;
+    }
+
+  frames->phase = phase;
+
+  /* what the counting itself allocates isn't charged */
+  bench_alloc_get_count (&frames->last);
+}
+
+static void
+frames_report (AllocFrames *frames)
+{
+  guint64 total_allocs = 0, total_bytes = 0;
+  gchar *name;
+  gint i;
+
+  for (i = 0; i < N_PHASES; i++)
+    {
+      name = g_strdup_printf ("alloc.%s.%s", frames->name, phase_names[i]);
+      report (name, frames->phases[i].n_allocs / N_FRAMES,
+              frames->phases[i].n_bytes / N_FRAMES);
+      g_free (name);
+
+      total_allocs += frames->phases[i].n_allocs;
+      total_bytes += frames->phases[i].n_bytes;
+    }
+
+  name = g_strdup_printf ("alloc.%s.frame", frames->name);
+  report (name, total_allocs / N_FRAMES, total_bytes / N_FRAMES);
+  g_free (name);
+}
+
+/* Scrolling a long list by a few pixels a frame */
+static void
+bench_scroll (void)
+{
+  ClutterActor *stage, *scroll, *box;
+  AllocFrames frames = { "scroll", };
+  MxAdjustment *vadjustment;
+  gfloat width, height;
+  gdouble value, range;
+  gint i;
+
+  stage = bench_get_stage ();
+  clutter_actor_get_size (stage, &width, &height);
+
+  scroll = mx_kinetic_scroll_view_new ();
+  clutter_actor_set_size (scroll, width, height);
+  clutter_actor_add_child (stage, scroll);
+
+  box = mx_box_layout_new_with_orientation (MX_ORIENTATION_VERTICAL);
+  clutter_actor_add_child (scroll, box);
+
+  for (i = 0; i < N_ROWS; i++)
+    {
+      gchar *text = g_strdup_printf ("Row %d", i);
+
+      clutter_actor_add_child (box, mx_label_new_with_text (text));
+
+      g_free (text);
+    }
+
+  bench_relayout (stage, width, height);
+  mx_scrollable_get_adjustments (MX_SCROLLABLE (box), NULL, &vadjustment);
+  range = mx_adjustment_get_upper (vadjustment) -
+          mx_adjustment_get_page_size (vadjustment);
+  value = 0;
+
+  frames_enter (&frames, PHASE_INPUT);
+  for (i = 0; i < N_WARMUP + N_FRAMES; i++)
+    {
+      frames.counting = i >= N_WARMUP;
+
+      value += 3;
+      if (value > range)
+        value -= range;
+      mx_adjustment_set_value (vadjustment, value);
+
+      /* styles are applied as rows are laid out into view */
+      frames_enter (&frames, PHASE_LAYOUT);
+      bench_relayout (stage, width, height);
+
+      frames_enter (&frames, PHASE_PAINT);
+      bench_paint (scroll);
+
+      frames_enter (&frames, PHASE_INPUT);
+    }
+
+  frames_report (&frames);
+
+  clutter_actor_destroy (scroll);
+}
+
+/* Moving the pointer over a grid of buttons, one button a frame */
+static void
+bench_hover (void)
+{
+  ClutterActor *stage, *grid, *previous = NULL;
+  AllocFrames frames = { "hover", };
+  gfloat width, height;
+  gint i;
+
+  stage = bench_get_stage ();
+  clutter_actor_get_size (stage, &width, &height);
+
+  grid = mx_grid_new ();
+  mx_grid_set_max_stride (MX_GRID (grid), N_COLUMNS);
+  clutter_actor_set_size (grid, width, height);
+  clutter_actor_add_child (stage, grid);
+
+  for (i = 0; i < N_BUTTONS; i++)
+    {
+      gchar *text = g_strdup_printf ("Button %d", i);
+
+      clutter_actor_add_child (grid, mx_button_new_with_label (text));
+
+      g_free (text);
+    }
+
+  bench_relayout (stage, width, height);
+
+  frames_enter (&frames, PHASE_INPUT);
+  for (i = 0; i < N_WARMUP + N_FRAMES; i++)
+    {
+      ClutterActor *button;
+
+      frames.counting = i >= N_WARMUP;
+
+      button = clutter_actor_get_child_at_index (grid, i % N_BUTTONS);
+
+      /* what entering and leaving a widget does */
+      frames_enter (&frames, PHASE_STYLE);
+      if (previous)
+        mx_stylable_style_pseudo_class_remove (MX_STYLABLE (previous),
+                                               "hover");
+      mx_stylable_style_pseudo_class_add (MX_STYLABLE (button), "hover");
+      previous = button;
+
+      frames_enter (&frames, PHASE_LAYOUT);
+      bench_relayout (stage, width, height);
+
+      frames_enter (&frames, PHASE_PAINT);
+      bench_paint (grid);
+
+      frames_enter (&frames, PHASE_INPUT);
+    }
+
+  frames_report (&frames);
+
+  clutter_actor_destroy (grid);
+}
+
+int
+main (int argc, char **argv)
+{
+  BenchAllocCount count;
+
+  /* for GLib versions where slices don't come from malloc() already */
+  g_setenv ("G_SLICE", "always-malloc", TRUE);
+
+  if (!bench_alloc_get_count (&count))
+    {
+      g_printerr ("Allocations can't be counted on this system\n");
+      return 0;
+    }
+
+  bench_init (&argc, &argv);
+  load_budgets ();
+
+  bench_scroll ();
+  bench_hover ();
+
+  clutter_actor_destroy (bench_get_stage ());
+  g_hash_table_destroy (budgets);
+
+  return over_budget ? 1 : 0;
+}
@@ -0,0 +1,432 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Events are delivered, and frames drawn, at this interval; made up
+ * gestures move the pointer twice as often, as most mice report */
+#define FRAME_INTERVAL  16
+#define MOTION_INTERVAL 8
+
+/* the time left between made up gestures, so that they aren't taken as
+ * double clicks or as the continuation of a fling */
+#define GESTURE_GAP     500
+
+typedef struct
+{
+  /* milliseconds since the first event */
+  guint32             time;
+  ClutterEventType    type;
+  gfloat              x;
+  gfloat              y;
+  ClutterModifierType state;
+
+  /* the button, the scroll direction or the touch sequence */
+  guint               detail;
+  guint               click_count;
+  gdouble             delta_x;
+  gdouble             delta_y;
+} BenchEvent;
+
+struct _BenchEvents
+{
+  GArray *events;
+};
+
+typedef struct
+{
+  BenchEvents        *events;
+  guint               next;
+
+  ClutterActor       *stage;
+  ClutterInputDevice *device;
+  gint64              start;
+  guint32             time_base;
+
+  guint               settle_frames;
+  gint64              frame_start;
+  GArray             *frame_times;
+  GMainLoop          *loop;
+} BenchReplay;
+
+static const struct
+{
+  const gchar      *name;
+  ClutterEventType  type;
+} event_types[] = {
+  { "motion", CLUTTER_MOTION },
+  { "press", CLUTTER_BUTTON_PRESS },
+  { "release", CLUTTER_BUTTON_RELEASE },
+  { "scroll", CLUTTER_SCROLL },
+  { "touch-begin", CLUTTER_TOUCH_BEGIN },
+  { "touch-update", CLUTTER_TOUCH_UPDATE },
+  { "touch-end", CLUTTER_TOUCH_END },
+  { "touch-cancel", CLUTTER_TOUCH_CANCEL }
+};
+
+BenchEvents *
+bench_events_new (void)
+{
+  BenchEvents *events = g_slice_new (BenchEvents);
+
+  events->events = g_array_new (FALSE, TRUE, sizeof (BenchEvent));
+
+  return events;
+}
+
+void
+bench_events_free (BenchEvents *events)
+{
+  g_array_free (events->events, TRUE);
+  g_slice_free (BenchEvents, events);
+}
+
+static gboolean
+bench_events_parse_line (const gchar *line,
+                         BenchEvent  *event)
+{
+  gchar **fields;
+  guint i, n_fields;
+  gboolean retval = FALSE;
+
+  fields = g_strsplit_set (line, " \t", -1);
+  n_fields = g_strv_length (fields);
+  if (n_fields < 5)
+    goto out;
+
+  for (i = 0; i < G_N_ELEMENTS (event_types); i++)
+    if (strcmp (fields[1], event_types[i].name) == 0)
+      break;
+  if (i == G_N_ELEMENTS (event_types))
+    goto out;
+
+  memset (event, 0, sizeof (BenchEvent));
+  event->time = strtoul (fields[0], NULL, 10);
+  event->type = event_types[i].type;
+  event->x = g_ascii_strtod (fields[2], NULL);
+  event->y = g_ascii_strtod (fields[3], NULL);
+  event->state = strtoul (fields[4], NULL, 10);
+
+  if (n_fields > 5)
+    event->detail = strtoul (fields[5], NULL, 10);
+  if (n_fields > 6 && event->type == CLUTTER_SCROLL)
+    event->delta_x = g_ascii_strtod (fields[6], NULL);
+  else if (n_fields > 6)
+    event->click_count = strtoul (fields[6], NULL, 10);
+  if (n_fields > 7)
+    event->delta_y = g_ascii_strtod (fields[7], NULL);
+
+  retval = TRUE;
+
+out:
+  g_strfreev (fields);
+
+  return retval;
+}
+
+/* Loads events recorded with MX_RECORD_EVENTS; see record_captured_event()
+ * in mx/mx-window.c for the format */
+BenchEvents *
+bench_events_load (const gchar  *filename,
+                   GError      **error)
+{
+  BenchEvents *events;
+  gchar *contents;
+  gchar **lines;
+  guint32 first_time = 0;
+  gint i;
+
+  if (!g_file_get_contents (filename, &contents, NULL, error))
+    return NULL;
+
+  events = bench_events_new ();
+
+  lines = g_strsplit (contents, "\n", -1);
+  for (i = 0; lines[i]; i++)
+    {
+      BenchEvent event;
+
+      if (lines[i][0] == '#' || lines[i][0] == '\0')
+        continue;
+
+      if (!bench_events_parse_line (lines[i], &event))
+        {
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                       "%s:%d: not an event", filename, i + 1);
+          bench_events_free (events);
+          events = NULL;
+          break;
+        }
+
+      if (events->events->len == 0)
+        first_time = event.time;
+      event.time -= first_time;
+
+      g_array_append_val (events->events, event);
+    }
+
+  g_strfreev (lines);
+  g_free (contents);
+
+  return events;
+}
+
+static guint32
+bench_events_get_end (BenchEvents *events)
+{
+  if (!events->events->len)
+    return 0;
+
+  return g_array_index (events->events, BenchEvent,
+                        events->events->len - 1).time + GESTURE_GAP;
+}
+
+static void
+bench_events_add (BenchEvents      *events,
+                  guint32           time,
+                  ClutterEventType  type,
+                  gfloat            x,
+                  gfloat            y,
+                  guint             detail)
+{
+  BenchEvent event = { 0, };
+
+  event.time = time;
+  event.type = type;
+  event.x = x;
+  event.y = y;
+  event.detail = detail;
+
+  if (type == CLUTTER_BUTTON_PRESS || type == CLUTTER_BUTTON_RELEASE)
+    event.click_count = 1;
+  if (type == CLUTTER_MOTION || type == CLUTTER_BUTTON_RELEASE)
+    event.state = CLUTTER_BUTTON1_MASK;
+
+  g_array_append_val (events->events, event);
+}
+
+/* Adds a press at (@x1, @y1), moving at an even speed to (@x2, @y2) in
+ * @duration milliseconds, where it is released, with the first button or
+ * with a finger */
+void
+bench_events_add_drag (BenchEvents *events,
+                       gboolean     touch,
+                       gfloat       x1,
+                       gfloat       y1,
+                       gfloat       x2,
+                       gfloat       y2,
+                       guint        duration)
+{
+  guint32 start, t;
+
+  start = bench_events_get_end (events);
+
+  bench_events_add (events, start,
+                    touch ? CLUTTER_TOUCH_BEGIN : CLUTTER_BUTTON_PRESS,
+                    x1, y1, 1);
+
+  for (t = MOTION_INTERVAL; t < duration; t += MOTION_INTERVAL)
+    bench_events_add (events, start + t,
+                      touch ? CLUTTER_TOUCH_UPDATE : CLUTTER_MOTION,
+                      x1 + (x2 - x1) * t / duration,
+                      y1 + (y2 - y1) * t / duration,
+                      touch ? 1 : 0);
+
+  bench_events_add (events, start + duration,
+                    touch ? CLUTTER_TOUCH_UPDATE : CLUTTER_MOTION,
+                    x2, y2, touch ? 1 : 0);
+  bench_events_add (events, start + duration,
+                    touch ? CLUTTER_TOUCH_END : CLUTTER_BUTTON_RELEASE,
+                    x2, y2, 1);
+}
+
+/* Adds @n_steps smooth scroll events at (@x, @y), one a frame, each
+ * scrolling by @delta_y */
+void
+bench_events_add_wheel (BenchEvents *events,
+                        gfloat       x,
+                        gfloat       y,
+                        gdouble      delta_y,
+                        guint        n_steps)
+{
+  guint32 start;
+  guint i;
+
+  start = bench_events_get_end (events);
+
+  for (i = 0; i < n_steps; i++)
+    {
+      BenchEvent event = { 0, };
+
+      event.time = start + i * FRAME_INTERVAL;
+      event.type = CLUTTER_SCROLL;
+      event.x = x;
+      event.y = y;
+      event.detail = CLUTTER_SCROLL_SMOOTH;
+      event.delta_y = delta_y;
+
+      g_array_append_val (events->events, event);
+    }
+}
+
+static void
+bench_replay_deliver (BenchReplay      *replay,
+                      const BenchEvent *bench_event)
+{
+  ClutterEvent *event;
+
+  event = clutter_event_new (bench_event->type);
+  clutter_event_set_stage (event, CLUTTER_STAGE (replay->stage));
+  clutter_event_set_device (event, replay->device);
+  clutter_event_set_source_device (event, replay->device);
+  clutter_event_set_time (event, replay->time_base + bench_event->time);
+  clutter_event_set_coords (event, bench_event->x, bench_event->y);
+  clutter_event_set_state (event, bench_event->state);
+
+  switch (bench_event->type)
+    {
+    case CLUTTER_BUTTON_PRESS:
+    case CLUTTER_BUTTON_RELEASE:
+      clutter_event_set_button (event, bench_event->detail);
+      event->button.click_count = bench_event->click_count;
+      break;
+
+    case CLUTTER_SCROLL:
+      clutter_event_set_scroll_direction (event, bench_event->detail);
+      if (bench_event->detail == CLUTTER_SCROLL_SMOOTH)
+        clutter_event_set_scroll_delta (event, bench_event->delta_x,
+                                        bench_event->delta_y);
+      break;
+
+    case CLUTTER_TOUCH_BEGIN:
+    case CLUTTER_TOUCH_UPDATE:
+    case CLUTTER_TOUCH_END:
+    case CLUTTER_TOUCH_CANCEL:
+      /* sequences are opaque, and only compared */
+      event->touch.sequence = GUINT_TO_POINTER (bench_event->detail);
+      break;
+
+    default:
+      break;
+    }
+
+  /* events are queued on the stage, to be handled at the start of the
+   * next frame, as those from the window system are */
+  clutter_do_event (event);
+  clutter_event_free (event);
+}
+
+static gboolean
+bench_replay_tick_cb (gpointer data)
+{
+  BenchReplay *replay = data;
+  GArray *events = replay->events->events;
+  gint64 elapsed;
+
+  elapsed = (g_get_monotonic_time () - replay->start) / 1000;
+
+  replay->frame_start = g_get_monotonic_time ();
+
+  while (replay->next < events->len &&
+         g_array_index (events, BenchEvent, replay->next).time <= elapsed)
+    bench_replay_deliver (replay, &g_array_index (events, BenchEvent,
+                                                  replay->next++));
+
+  /* every tick is a frame, so that animations started by the events, like
+   * the deceleration of a fling, are measured too */
+  clutter_actor_queue_redraw (replay->stage);
+
+  if (replay->next < events->len)
+    return TRUE;
+
+  if (replay->settle_frames--)
+    return TRUE;
+
+  g_main_loop_quit (replay->loop);
+
+  return FALSE;
+}
+
+static gboolean
+bench_replay_post_paint_cb (gpointer data)
+{
+  BenchReplay *replay = data;
+  gint64 frame_time;
+
+  if (!replay->frame_start)
+    return TRUE;
+
+  frame_time = g_get_monotonic_time () - replay->frame_start;
+  g_array_append_val (replay->frame_times, frame_time);
+  replay->frame_start = 0;
+
+  return TRUE;
+}
+
+/* Replays @events against the benchmark stage, followed by @settle_frames
+ * frames without events, and reports the distribution of the frame times
+ * as @name. The stage is painted on screen rather than offscreen, as the
+ * frames are those of the master clock, so the benchmarks that replay
+ * events turn off the wait for the vertical blank. */
+void
+bench_events_replay (BenchEvents *events,
+                     const gchar *name,
+                     guint        settle_frames)
+{
+  ClutterDeviceManager *manager;
+  BenchReplay replay = { 0, };
+  guint repaint_id;
+
+  manager = clutter_device_manager_get_default ();
+
+  replay.events = events;
+  replay.stage = bench_get_stage ();
+  replay.device =
+    clutter_device_manager_get_core_device (manager, CLUTTER_POINTER_DEVICE);
+  replay.settle_frames = settle_frames;
+  replay.frame_times = g_array_new (FALSE, FALSE, sizeof (gint64));
+  replay.loop = g_main_loop_new (NULL, FALSE);
+
+  /* let the stage draw its first frame before anything is measured */
+  clutter_stage_ensure_redraw (CLUTTER_STAGE (replay.stage));
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+
+  repaint_id =
+    clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                           bench_replay_post_paint_cb,
+                                           &replay, NULL);
+
+  replay.start = g_get_monotonic_time ();
+  replay.time_base = clutter_get_current_event_time ();
+  if (!replay.time_base)
+    replay.time_base = replay.start / 1000;
+
+  g_timeout_add (FRAME_INTERVAL, bench_replay_tick_cb, &replay);
+  g_main_loop_run (replay.loop);
+
+  clutter_threads_remove_repaint_func (repaint_id);
+
+  bench_report_frames (name, replay.frame_times);
+
+  g_array_free (replay.frame_times, TRUE);
+  g_main_loop_unref (replay.loop);
+}
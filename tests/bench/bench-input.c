@@ -0,0 +1,396 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* The time of the frames of widgets driven by the pointer: scrolling,
+ * flinging, dragging and sliding. Each scene replays made up gestures; run
+ * as
+ *
+ *   bench-input <scene> <file>
+ *
+ * to replay events recorded with MX_RECORD_EVENTS=<file> instead. */
+
+#define N_ROWS        2000
+
+/* frames left for decelerations and the like to finish */
+#define SETTLE_FRAMES 60
+
+/* A widget that follows the pointer while it is dragged */
+
+typedef struct
+{
+  MxWidget      parent;
+
+  guint         threshold;
+  MxDragAxis    axis;
+  ClutterActor *drag_actor;
+  gboolean      enabled;
+} BenchDraggable;
+
+typedef struct
+{
+  MxWidgetClass parent_class;
+} BenchDraggableClass;
+
+enum
+{
+  PROP_0,
+
+  PROP_DRAG_THRESHOLD,
+  PROP_AXIS,
+  PROP_DRAG_ACTOR,
+  PROP_DRAG_ENABLED
+};
+
+static void bench_draggable_iface_init (MxDraggableIface *iface);
+
+static GType bench_draggable_get_type (void);
+
+G_DEFINE_TYPE_WITH_CODE (BenchDraggable, bench_draggable, MX_TYPE_WIDGET,
+                         G_IMPLEMENT_INTERFACE (MX_TYPE_DRAGGABLE,
+                                                bench_draggable_iface_init))
+
+static void
+bench_draggable_drag_begin (MxDraggable         *draggable,
+                            gfloat               event_x,
+                            gfloat               event_y,
+                            gint                 event_button,
+                            ClutterModifierType  modifiers)
+{
+  clutter_actor_set_opacity (CLUTTER_ACTOR (draggable), 224);
+}
+
+static void
+bench_draggable_drag_motion (MxDraggable *draggable,
+                             gfloat       delta_x,
+                             gfloat       delta_y)
+{
+  clutter_actor_move_by (CLUTTER_ACTOR (draggable), delta_x, delta_y);
+}
+
+static void
+bench_draggable_drag_end (MxDraggable *draggable,
+                          gfloat       event_x,
+                          gfloat       event_y)
+{
+  clutter_actor_set_opacity (CLUTTER_ACTOR (draggable), 255);
+}
+
+static void
+bench_draggable_iface_init (MxDraggableIface *iface)
+{
+  iface->drag_begin = bench_draggable_drag_begin;
+  iface->drag_motion = bench_draggable_drag_motion;
+  iface->drag_end = bench_draggable_drag_end;
+}
+
+static void
+bench_draggable_set_property (GObject      *object,
+                              guint         prop_id,
+                              const GValue *value,
+                              GParamSpec   *pspec)
+{
+  BenchDraggable *self = (BenchDraggable *) object;
+
+  switch (prop_id)
+    {
+    case PROP_DRAG_THRESHOLD:
+      self->threshold = g_value_get_uint (value);
+      break;
+
+    case PROP_AXIS:
+      self->axis = g_value_get_enum (value);
+      break;
+
+    case PROP_DRAG_ACTOR:
+      self->drag_actor = g_value_get_object (value);
+      break;
+
+    case PROP_DRAG_ENABLED:
+      self->enabled = g_value_get_boolean (value);
+      if (self->enabled)
+        mx_draggable_enable (MX_DRAGGABLE (object));
+      else
+        mx_draggable_disable (MX_DRAGGABLE (object));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+bench_draggable_get_property (GObject    *object,
+                              guint       prop_id,
+                              GValue     *value,
+                              GParamSpec *pspec)
+{
+  BenchDraggable *self = (BenchDraggable *) object;
+
+  switch (prop_id)
+    {
+    case PROP_DRAG_THRESHOLD:
+      g_value_set_uint (value, self->threshold);
+      break;
+
+    case PROP_AXIS:
+      g_value_set_enum (value, self->axis);
+      break;
+
+    case PROP_DRAG_ACTOR:
+      g_value_set_object (value, self->drag_actor);
+      break;
+
+    case PROP_DRAG_ENABLED:
+      g_value_set_boolean (value, self->enabled);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+bench_draggable_class_init (BenchDraggableClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->set_property = bench_draggable_set_property;
+  object_class->get_property = bench_draggable_get_property;
+
+  g_object_class_override_property (object_class, PROP_DRAG_THRESHOLD,
+                                    "drag-threshold");
+  g_object_class_override_property (object_class, PROP_AXIS, "axis");
+  g_object_class_override_property (object_class, PROP_DRAG_ACTOR,
+                                    "drag-actor");
+  g_object_class_override_property (object_class, PROP_DRAG_ENABLED,
+                                    "drag-enabled");
+}
+
+static void
+bench_draggable_init (BenchDraggable *self)
+{
+  ClutterColor color = { 0x80, 0x80, 0xc0, 0xff };
+
+  clutter_actor_set_background_color (CLUTTER_ACTOR (self), &color);
+  clutter_actor_set_reactive (CLUTTER_ACTOR (self), TRUE);
+}
+
+/* The scenes, and the gestures made up for them */
+
+static void
+add_rows (ClutterActor *scroll)
+{
+  ClutterActor *box;
+  gint i;
+
+  box = mx_box_layout_new_with_orientation (MX_ORIENTATION_VERTICAL);
+  clutter_actor_add_child (scroll, box);
+
+  for (i = 0; i < N_ROWS; i++)
+    {
+      gchar *text = g_strdup_printf ("Row %d", i);
+
+      clutter_actor_add_child (box, mx_label_new_with_text (text));
+
+      g_free (text);
+    }
+}
+
+static ClutterActor *
+create_kinetic_scroll (void)
+{
+  ClutterActor *stage = bench_get_stage (), *scroll;
+
+  scroll = mx_kinetic_scroll_view_new ();
+  clutter_actor_set_size (scroll, clutter_actor_get_width (stage),
+                          clutter_actor_get_height (stage));
+  add_rows (scroll);
+  clutter_actor_add_child (stage, scroll);
+
+  return scroll;
+}
+
+static ClutterActor *
+create_scroll_view (void)
+{
+  ClutterActor *stage = bench_get_stage (), *scroll;
+
+  scroll = mx_scroll_view_new ();
+  clutter_actor_set_size (scroll, clutter_actor_get_width (stage),
+                          clutter_actor_get_height (stage));
+  add_rows (scroll);
+  clutter_actor_add_child (stage, scroll);
+
+  return scroll;
+}
+
+static ClutterActor *
+create_draggable (void)
+{
+  ClutterActor *draggable;
+
+  draggable = g_object_new (bench_draggable_get_type (), NULL);
+  clutter_actor_set_size (draggable, 100, 100);
+  clutter_actor_set_position (draggable, 100, 100);
+  clutter_actor_add_child (bench_get_stage (), draggable);
+
+  g_object_set (draggable, "drag-enabled", TRUE, NULL);
+
+  return draggable;
+}
+
+static ClutterActor *
+create_slider (void)
+{
+  ClutterActor *slider;
+
+  slider = mx_slider_new ();
+  clutter_actor_set_width (slider, 600);
+  clutter_actor_set_position (slider, 100, 100);
+  clutter_actor_add_child (bench_get_stage (), slider);
+
+  return slider;
+}
+
+static void
+add_kinetic_scroll_events (BenchEvents  *events,
+                           ClutterActor *actor)
+{
+  /* a slow drag, then flings with the mouse and with a finger */
+  bench_events_add_drag (events, FALSE, 400, 500, 400, 100, 1000);
+  bench_events_add_drag (events, FALSE, 400, 500, 400, 100, 100);
+  bench_events_add_drag (events, TRUE, 400, 500, 400, 100, 100);
+}
+
+static void
+add_scroll_view_events (BenchEvents  *events,
+                        ClutterActor *actor)
+{
+  bench_events_add_wheel (events, 400, 300, 1, 120);
+  bench_events_add_wheel (events, 400, 300, -1, 120);
+}
+
+static void
+add_draggable_events (BenchEvents  *events,
+                      ClutterActor *actor)
+{
+  bench_events_add_drag (events, FALSE, 150, 150, 650, 450, 1000);
+}
+
+static void
+add_slider_events (BenchEvents  *events,
+                   ClutterActor *actor)
+{
+  gfloat y = 100 + clutter_actor_get_height (actor) / 2;
+
+  bench_events_add_drag (events, FALSE, 105, y, 695, y, 1000);
+}
+
+static const struct
+{
+  const gchar    *name;
+  ClutterActor *(* create) (void);
+  void          (* add_events) (BenchEvents  *events,
+                                ClutterActor *actor);
+} scenes[] = {
+  { "kinetic-scroll", create_kinetic_scroll, add_kinetic_scroll_events },
+  { "scroll-view", create_scroll_view, add_scroll_view_events },
+  { "draggable", create_draggable, add_draggable_events },
+  { "slider", create_slider, add_slider_events }
+};
+
+static void
+run_scene (guint        scene,
+           BenchEvents *events)
+{
+  ClutterActor *actor;
+  gchar *name;
+
+  name = g_strdup_printf ("input.%s.frame", scenes[scene].name);
+
+  actor = scenes[scene].create ();
+
+  if (events)
+    bench_events_replay (events, name, SETTLE_FRAMES);
+  else
+    {
+      events = bench_events_new ();
+      scenes[scene].add_events (events, actor);
+      bench_events_replay (events, name, SETTLE_FRAMES);
+      bench_events_free (events);
+    }
+
+  clutter_actor_destroy (actor);
+
+  g_free (name);
+}
+
+int
+main (int argc, char **argv)
+{
+  guint i;
+
+  /* frames are drawn when the events are delivered, not when the display
+   * is ready for them */
+  g_setenv ("CLUTTER_VBLANK", "none", FALSE);
+  g_setenv ("CLUTTER_DEFAULT_FPS", "1000", FALSE);
+
+  bench_init (&argc, &argv);
+
+  if (argc == 3)
+    {
+      BenchEvents *events;
+      GError *error = NULL;
+
+      for (i = 0; i < G_N_ELEMENTS (scenes); i++)
+        if (strcmp (argv[1], scenes[i].name) == 0)
+          break;
+
+      if (i == G_N_ELEMENTS (scenes))
+        {
+          g_printerr ("Unknown scene '%s'\n", argv[1]);
+          return 1;
+        }
+
+      events = bench_events_load (argv[2], &error);
+      if (!events)
+        {
+          g_printerr ("Failed to load events: %s\n", error->message);
+          g_error_free (error);
+          return 1;
+        }
+
+      run_scene (i, events);
+
+      bench_events_free (events);
+    }
+  else
+    {
+      for (i = 0; i < G_N_ELEMENTS (scenes); i++)
+        run_scene (i, NULL);
+    }
+
+  clutter_actor_destroy (bench_get_stage ());
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+#include "bench.h"
+
+/* MxItemView population and row updates */
+
+#define N_ROWS    2000
+#define N_APPENDS 500
+#define N_PASSES  5
+
+static ClutterModel *
+make_model (gint n_rows)
+{
+  ClutterModel *model;
+  gint i;
+
+  model = clutter_list_model_new (1, G_TYPE_STRING, "text");
+
+  for (i = 0; i < n_rows; i++)
+    {
+      gchar *text = g_strdup_printf ("Row %d", i);
+
+      clutter_model_append (model, 0, text, -1);
+
+      g_free (text);
+    }
+
+  return model;
+}
+
+static ClutterActor *
+make_view (void)
+{
+  ClutterActor *view;
+
+  view = mx_item_view_new ();
+  g_object_ref_sink (view);
+
+  mx_item_view_set_item_type (MX_ITEM_VIEW (view), MX_TYPE_LABEL);
+  mx_item_view_add_attribute (MX_ITEM_VIEW (view), "text", 0);
+  mx_item_view_set_progressive (MX_ITEM_VIEW (view), FALSE);
+
+  return view;
+}
+
+static void
+bench_populate (void)
+{
+  ClutterModel *model;
+  ClutterActor *view;
+  BenchTimer timer;
+  gint i;
+
+  model = make_model (N_ROWS);
+  view = make_view ();
+
+  bench_timer_start (&timer, "item-view.populate-2k", N_PASSES);
+  for (i = 0; i < N_PASSES; i++)
+    {
+      mx_item_view_set_model (MX_ITEM_VIEW (view), model);
+      mx_item_view_set_model (MX_ITEM_VIEW (view), NULL);
+    }
+  bench_timer_stop (&timer);
+
+  clutter_actor_destroy (view);
+  g_object_unref (view);
+  g_object_unref (model);
+}
+
+static void
+bench_append (void)
+{
+  ClutterModel *model;
+  ClutterActor *view;
+  BenchTimer timer;
+  gint i;
+
+  model = make_model (N_ROWS);
+  view = make_view ();
+  mx_item_view_set_model (MX_ITEM_VIEW (view), model);
+
+  bench_timer_start (&timer, "item-view.append", N_APPENDS);
+  for (i = 0; i < N_APPENDS; i++)
+    clutter_model_append (model, 0, "Appended row", -1);
+  bench_timer_stop (&timer);
+
+  clutter_actor_destroy (view);
+  g_object_unref (view);
+  g_object_unref (model);
+}
+
+static void
+bench_update (void)
+{
+  ClutterModel *model;
+  ClutterActor *view;
+  BenchTimer timer;
+  gint i, pass;
+
+  model = make_model (N_ROWS);
+  view = make_view ();
+  mx_item_view_set_model (MX_ITEM_VIEW (view), model);
+
+  bench_timer_start (&timer, "item-view.update-row", N_PASSES * N_ROWS);
+  for (pass = 0; pass < N_PASSES; pass++)
+    for (i = 0; i < N_ROWS; i++)
+      {
+        ClutterModelIter *iter = clutter_model_get_iter_at_row (model, i);
+        gchar *text = g_strdup_printf ("Row %d, pass %d", i, pass);
+
+        clutter_model_iter_set (iter, 0, text, -1);
+
+        g_free (text);
+        g_object_unref (iter);
+      }
+  bench_timer_stop (&timer);
+
+  clutter_actor_destroy (view);
+  g_object_unref (view);
+  g_object_unref (model);
+}
+
+int
+main (int argc, char **argv)
+{
+  bench_init (&argc, &argv);
+
+  bench_populate ();
+  bench_append ();
+  bench_update ();
+
+  return 0;
+}
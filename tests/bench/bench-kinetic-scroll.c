@@ -0,0 +1,99 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+#include "bench.h"
+
+/* The cost of a frame of an MxKineticScrollView over a long list: moving
+ * the adjustment, laying out what needs it and painting */
+
+#define N_ROWS   2000
+#define N_FRAMES 300
+
+static void
+run_frames (const gchar  *name,
+            ClutterActor *scroll,
+            MxAdjustment *vadjustment,
+            gdouble       step)
+{
+  gfloat width, height;
+  BenchTimer timer;
+  gdouble value, range;
+  gint i;
+
+  clutter_actor_get_size (bench_get_stage (), &width, &height);
+
+  range = mx_adjustment_get_upper (vadjustment) -
+          mx_adjustment_get_page_size (vadjustment);
+  value = mx_adjustment_get_value (vadjustment);
+
+  bench_timer_start (&timer, name, N_FRAMES);
+  for (i = 0; i < N_FRAMES; i++)
+    {
+      value += step;
+      if (value > range)
+        value -= range;
+
+      mx_adjustment_set_value (vadjustment, value);
+
+      bench_relayout (bench_get_stage (), width, height);
+      bench_paint (scroll);
+    }
+  bench_timer_stop (&timer);
+}
+
+int
+main (int argc, char **argv)
+{
+  ClutterActor *stage, *scroll, *box;
+  MxAdjustment *vadjustment;
+  gfloat width, height;
+  gint i;
+
+  bench_init (&argc, &argv);
+
+  stage = bench_get_stage ();
+  clutter_actor_get_size (stage, &width, &height);
+
+  scroll = mx_kinetic_scroll_view_new ();
+  clutter_actor_set_size (scroll, width, height);
+  clutter_actor_add_child (stage, scroll);
+
+  box = mx_box_layout_new_with_orientation (MX_ORIENTATION_VERTICAL);
+  clutter_actor_add_child (scroll, box);
+
+  for (i = 0; i < N_ROWS; i++)
+    {
+      gchar *text = g_strdup_printf ("Row %d", i);
+
+      clutter_actor_add_child (box, mx_label_new_with_text (text));
+
+      g_free (text);
+    }
+
+  bench_relayout (stage, width, height);
+  mx_scrollable_get_adjustments (MX_SCROLLABLE (box), NULL, &vadjustment);
+
+  /* a frame where nothing moves, then slow and fast scrolling */
+  run_frames ("kinetic-scroll.frame.still", scroll, vadjustment, 0);
+  run_frames ("kinetic-scroll.frame.slow", scroll, vadjustment, 2);
+  run_frames ("kinetic-scroll.frame.fast", scroll, vadjustment, 60);
+
+  clutter_actor_destroy (stage);
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+#include "bench.h"
+
+/* Box, grid and table layout over many children */
+
+#define N_CHILDREN 10000
+#define N_COLUMNS  100
+#define N_LAYOUTS  20
+
+static ClutterActor *
+make_child (gint i)
+{
+  ClutterActor *child = clutter_actor_new ();
+
+  clutter_actor_set_size (child, 40 + (i % 20), 20 + (i % 10));
+
+  return child;
+}
+
+/* Lays @container out at alternating widths, so that each pass has to
+ * measure and allocate every child again */
+static void
+bench_container (const gchar  *name,
+                 ClutterActor *container)
+{
+  BenchTimer timer;
+  gchar *full_name;
+  gint i;
+
+  full_name = g_strconcat ("layout.", name, ".10k", NULL);
+
+  bench_timer_start (&timer, full_name, N_LAYOUTS);
+  for (i = 0; i < N_LAYOUTS; i++)
+    {
+      gfloat width = 800 + (i % 2), height;
+
+      clutter_actor_get_preferred_height (container, width, NULL, &height);
+      bench_relayout (container, width, height);
+    }
+  bench_timer_stop (&timer);
+
+  g_free (full_name);
+}
+
+static void
+bench_box (void)
+{
+  ClutterActor *box;
+  BenchTimer timer;
+  gint i;
+
+  box = mx_box_layout_new_with_orientation (MX_ORIENTATION_VERTICAL);
+  g_object_ref_sink (box);
+
+  bench_timer_start (&timer, "layout.box.add-10k", 1);
+  for (i = 0; i < N_CHILDREN; i++)
+    clutter_actor_add_child (box, make_child (i));
+  bench_timer_stop (&timer);
+
+  bench_container ("box", box);
+
+  clutter_actor_destroy (box);
+  g_object_unref (box);
+}
+
+static void
+bench_grid (void)
+{
+  ClutterActor *grid;
+  BenchTimer timer;
+  gint i;
+
+  grid = mx_grid_new ();
+  g_object_ref_sink (grid);
+
+  bench_timer_start (&timer, "layout.grid.add-10k", 1);
+  for (i = 0; i < N_CHILDREN; i++)
+    clutter_actor_add_child (grid, make_child (i));
+  bench_timer_stop (&timer);
+
+  bench_container ("grid", grid);
+
+  clutter_actor_destroy (grid);
+  g_object_unref (grid);
+}
+
+static void
+bench_table (void)
+{
+  ClutterActor *table;
+  BenchTimer timer;
+  gint i;
+
+  table = mx_table_new ();
+  g_object_ref_sink (table);
+
+  bench_timer_start (&timer, "layout.table.add-10k", 1);
+  for (i = 0; i < N_CHILDREN; i++)
+    mx_table_insert_actor (MX_TABLE (table), make_child (i),
+                           i / N_COLUMNS, i % N_COLUMNS);
+  bench_timer_stop (&timer);
+
+  bench_container ("table", table);
+
+  clutter_actor_destroy (table);
+  g_object_unref (table);
+}
+
+int
+main (int argc, char **argv)
+{
+  bench_init (&argc, &argv);
+
+  bench_box ();
+  bench_grid ();
+  bench_table ();
+
+  return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+#include "bench.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+/* Counts the allocations of the whole process, for the benchmarks linked
+ * with this file. GLib no longer lets its allocator be replaced with
+ * g_mem_set_vtable(), so malloc() itself is wrapped, which only works
+ * where the C library lets a program define it, as glibc does. Memory
+ * allocated on the worker threads is counted too. */
+
+#ifdef __GLIBC__
+
+extern void *__libc_malloc   (size_t size);
+extern void *__libc_calloc   (size_t n_members,
+                              size_t size);
+extern void *__libc_realloc  (void  *ptr,
+                              size_t size);
+extern void *__libc_memalign (size_t alignment,
+                              size_t size);
+extern void  __libc_free     (void  *ptr);
+
+static volatile gsize n_allocs = 0;
+static volatile gsize n_bytes = 0;
+
+static inline void
+bench_malloc_count (size_t size)
+{
+  __sync_fetch_and_add (&n_allocs, 1);
+  __sync_fetch_and_add (&n_bytes, size);
+}
+
+void *
+malloc (size_t size)
+{
+  bench_malloc_count (size);
+
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n_members,
+        size_t size)
+{
+  bench_malloc_count (n_members * size);
+
+  return __libc_calloc (n_members, size);
+}
+
+/* growing a block is counted as an allocation of its new size, as it may
+ * well copy it */
+void *
+realloc (void   *ptr,
+         size_t  size)
+{
+  bench_malloc_count (size);
+
+  return __libc_realloc (ptr, size);
+}
+
+void *
+memalign (size_t alignment,
+          size_t size)
+{
+  bench_malloc_count (size);
+
+  return __libc_memalign (alignment, size);
+}
+
+int
+posix_memalign (void   **ptr,
+                size_t   alignment,
+                size_t   size)
+{
+  void *mem;
+
+  bench_malloc_count (size);
+
+  mem = __libc_memalign (alignment, size);
+  if (!mem)
+    return ENOMEM;
+
+  *ptr = mem;
+
+  return 0;
+}
+
+void *
+aligned_alloc (size_t alignment,
+               size_t size)
+{
+  bench_malloc_count (size);
+
+  return __libc_memalign (alignment, size);
+}
+
+void
+free (void *ptr)
+{
+  __libc_free (ptr);
+}
+
+gboolean
+bench_alloc_get_count (BenchAllocCount *count)
+{
+  count->n_allocs = n_allocs;
+  count->n_bytes = n_bytes;
+
+  return TRUE;
+}
+
+#else
+
+gboolean
+bench_alloc_get_count (BenchAllocCount *count)
+{
+  count->n_allocs = 0;
+  count->n_bytes = 0;
+
+  return FALSE;
+}
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+
+/* CSS matching and style cache churn over a synthetic style sheet */
+
+#define N_RULES   2000
+#define N_WIDGETS 500
+
+static gchar *
+make_style_sheet (void)
+{
+  GString *sheet = g_string_new (NULL);
+  gint i;
+
+  for (i = 0; i < N_RULES; i++)
+    {
+      switch (i % 4)
+        {
+        case 0:
+          g_string_append_printf (sheet,
+                                  "MxButton.bench-%d { color: #%06x; }\n",
+                                  i, (i * 2654435761u) & 0xffffff);
+          break;
+
+        case 1:
+          g_string_append_printf (sheet,
+                                  "MxButton#bench-%d { color: #%06x; }\n",
+                                  i, (i * 40503u) & 0xffffff);
+          break;
+
+        case 2:
+          g_string_append_printf (sheet,
+                                  ".bench-%d:hover "
+                                  "{ background-color: #%06x; }\n",
+                                  i, (i * 69069u) & 0xffffff);
+          break;
+
+        default:
+          g_string_append_printf (sheet,
+                                  "MxBoxLayout .bench-%d MxButton "
+                                  "{ padding: %dpx; }\n",
+                                  i, i % 16);
+          break;
+        }
+    }
+
+  return g_string_free (sheet, FALSE);
+}
+
+static ClutterActor *
+make_widgets (MxStyle       *style,
+              ClutterActor **widgets)
+{
+  ClutterActor *box;
+  gint i;
+
+  box = mx_box_layout_new ();
+  mx_stylable_set_style (MX_STYLABLE (box), style);
+
+  for (i = 0; i < N_WIDGETS; i++)
+    {
+      gchar *name = g_strdup_printf ("bench-%d", (i * 7) % N_RULES);
+
+      widgets[i] = mx_button_new ();
+      clutter_actor_set_name (widgets[i], name);
+      mx_stylable_set_style (MX_STYLABLE (widgets[i]), style);
+      mx_stylable_set_style_class (MX_STYLABLE (widgets[i]), name);
+      clutter_actor_add_child (box, widgets[i]);
+
+      g_free (name);
+    }
+
+  return box;
+}
+
+static void
+get_colors (MxStyle      *style,
+            ClutterActor *widget)
+{
+  ClutterColor *color = NULL, *background = NULL;
+
+  mx_style_get (style, MX_STYLABLE (widget),
+                "color", &color,
+                "background-color", &background,
+                NULL);
+
+  if (color)
+    clutter_color_free (color);
+  if (background)
+    clutter_color_free (background);
+}
+
+static void
+report_cache_stats (MxStyle     *style,
+                    const gchar *prefix)
+{
+  guint hits, misses, evictions;
+  gchar *name;
+
+  mx_style_get_cache_stats (style, &hits, &misses, &evictions);
+
+  name = g_strconcat (prefix, ".hits", NULL);
+  bench_report_count (name, hits);
+  g_free (name);
+
+  name = g_strconcat (prefix, ".misses", NULL);
+  bench_report_count (name, misses);
+  g_free (name);
+
+  name = g_strconcat (prefix, ".evictions", NULL);
+  bench_report_count (name, evictions);
+  g_free (name);
+}
+
+/* With room for a single matched style, every look-up of a widget other
+ * than the previous one matches the sheet again */
+static void
+bench_css_match (const gchar *sheet)
+{
+  ClutterActor *widgets[N_WIDGETS], *box;
+  BenchTimer timer;
+  GError *error = NULL;
+  MxStyle *style;
+  gint i, pass;
+
+  style = mx_style_new ();
+  mx_style_set_load_default (style, FALSE);
+
+  bench_timer_start (&timer, "css-load.2000-rules", 1);
+  if (!mx_style_load_from_data (style, "bench", sheet, &error))
+    {
+      g_printerr ("Failed to load the style sheet: %s\n", error->message);
+      exit (1);
+    }
+  bench_timer_stop (&timer);
+
+  box = make_widgets (style, widgets);
+  mx_style_set_cache_size (style, 1);
+
+  bench_timer_start (&timer, "css-match.2000-rules", 10 * N_WIDGETS);
+  for (pass = 0; pass < 10; pass++)
+    for (i = 0; i < N_WIDGETS; i++)
+      get_colors (style, widgets[i]);
+  bench_timer_stop (&timer);
+
+  report_cache_stats (style, "css-match");
+
+  clutter_actor_destroy (box);
+  g_object_unref (style);
+}
+
+/* Hovers widgets in turn, with the default cache size, so that matched
+ * styles are looked up, added and evicted as the pseudo classes change */
+static void
+bench_style_cache_churn (const gchar *sheet)
+{
+  ClutterActor *widgets[N_WIDGETS], *box;
+  BenchTimer timer;
+  MxStyle *style;
+  gint i, pass;
+
+  style = mx_style_new ();
+  mx_style_set_load_default (style, FALSE);
+  mx_style_load_from_data (style, "bench", sheet, NULL);
+
+  box = make_widgets (style, widgets);
+
+  bench_timer_start (&timer, "style-cache-churn", 20 * N_WIDGETS);
+  for (pass = 0; pass < 20; pass++)
+    for (i = 0; i < N_WIDGETS; i++)
+      {
+        mx_stylable_set_style_pseudo_class (MX_STYLABLE (widgets[i]),
+                                            (pass + i) % 2 ? "hover" : NULL);
+        get_colors (style, widgets[i]);
+      }
+  bench_timer_stop (&timer);
+
+  report_cache_stats (style, "style-cache-churn");
+
+  clutter_actor_destroy (box);
+  g_object_unref (style);
+}
+
+int
+main (int argc, char **argv)
+{
+  gchar *sheet;
+
+  bench_init (&argc, &argv);
+
+  sheet = make_style_sheet ();
+
+  bench_css_match (sheet);
+  bench_style_cache_churn (sheet);
+
+  g_free (sheet);
+
+  return 0;
+}
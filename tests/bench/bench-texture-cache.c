@@ -0,0 +1,161 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+#include <glib/gstdio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+/* MxTextureCache and MxImage decoding throughput over generated images */
+
+#define N_IMAGES   50
+#define IMAGE_SIZE 256
+#define N_HITS     100
+
+static gchar *
+make_image (const gchar *dir,
+            gint         i)
+{
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  guchar *pixels;
+  gint x, y, rowstride;
+  gchar *name, *path;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8,
+                           IMAGE_SIZE, IMAGE_SIZE);
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+  /* a gradient that differs between images, so that they do not compress
+   * to nothing */
+  for (y = 0; y < IMAGE_SIZE; y++)
+    for (x = 0; x < IMAGE_SIZE; x++)
+      {
+        guchar *p = pixels + y * rowstride + x * 4;
+
+        p[0] = x + i;
+        p[1] = y * 3 + i;
+        p[2] = (x ^ y) + i * 5;
+        p[3] = 0xff - (x / 2);
+      }
+
+  name = g_strdup_printf ("image-%d.png", i);
+  path = g_build_filename (dir, name, NULL);
+  g_free (name);
+
+  if (!gdk_pixbuf_save (pixbuf, path, "png", &error, NULL))
+    {
+      g_printerr ("Failed to write %s: %s\n", path, error->message);
+      exit (1);
+    }
+
+  g_object_unref (pixbuf);
+
+  return path;
+}
+
+static void
+bench_texture_cache (gchar **paths)
+{
+  MxTextureCacheStats stats;
+  MxTextureCache *cache;
+  BenchTimer timer;
+  gint i, pass;
+
+  cache = mx_texture_cache_get_default ();
+
+  bench_timer_start (&timer, "texture-cache.load", N_IMAGES);
+  for (i = 0; i < N_IMAGES; i++)
+    mx_texture_cache_get_cogl_texture (cache, paths[i]);
+  bench_timer_stop (&timer);
+
+  bench_timer_start (&timer, "texture-cache.hit", N_HITS * N_IMAGES);
+  for (pass = 0; pass < N_HITS; pass++)
+    for (i = 0; i < N_IMAGES; i++)
+      mx_texture_cache_get_cogl_texture (cache, paths[i]);
+  bench_timer_stop (&timer);
+
+  mx_texture_cache_get_stats (cache, &stats);
+  bench_report_count ("texture-cache.hits", stats.hits);
+  bench_report_count ("texture-cache.misses", stats.misses);
+  bench_report_count ("texture-cache.decodes", stats.n_decodes);
+  bench_report_count ("texture-cache.decode-time-us", stats.decode_time);
+  bench_report_count ("texture-cache.used-bytes", stats.used_bytes);
+}
+
+static void
+bench_image_decode (gchar **paths)
+{
+  ClutterActor *image;
+  BenchTimer timer;
+  gint i;
+
+  image = mx_image_new ();
+  g_object_ref_sink (image);
+
+  bench_timer_start (&timer, "image.decode", N_IMAGES);
+  for (i = 0; i < N_IMAGES; i++)
+    mx_image_set_from_file (MX_IMAGE (image), paths[i], NULL);
+  bench_timer_stop (&timer);
+
+  bench_timer_start (&timer, "image.decode-at-size", N_IMAGES);
+  for (i = 0; i < N_IMAGES; i++)
+    mx_image_set_from_file_at_size (MX_IMAGE (image), paths[i],
+                                    IMAGE_SIZE / 4, IMAGE_SIZE / 4, NULL);
+  bench_timer_stop (&timer);
+
+  clutter_actor_destroy (image);
+  g_object_unref (image);
+}
+
+int
+main (int argc, char **argv)
+{
+  gchar *paths[N_IMAGES];
+  GError *error = NULL;
+  gchar *dir;
+  gint i;
+
+  bench_init (&argc, &argv);
+
+  dir = g_dir_make_tmp ("mx-bench-XXXXXX", &error);
+  if (!dir)
+    {
+      g_printerr ("Failed to create a directory: %s\n", error->message);
+      return 1;
+    }
+
+  for (i = 0; i < N_IMAGES; i++)
+    paths[i] = make_image (dir, i);
+
+  bench_texture_cache (paths);
+  bench_image_decode (paths);
+
+  for (i = 0; i < N_IMAGES; i++)
+    {
+      g_unlink (paths[i]);
+      g_free (paths[i]);
+    }
+
+  g_rmdir (dir);
+  g_free (dir);
+
+  return 0;
+}
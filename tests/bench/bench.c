@@ -0,0 +1,176 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+#include "bench.h"
+
+#include <stdlib.h>
+
+#define BENCH_STAGE_WIDTH  800
+#define BENCH_STAGE_HEIGHT 600
+
+static ClutterActor *stage = NULL;
+static CoglHandle offscreen = COGL_INVALID_HANDLE;
+
+void
+bench_init (int    *argc,
+            char ***argv)
+{
+  if (clutter_init (argc, argv) != CLUTTER_INIT_SUCCESS)
+    {
+      g_printerr ("Failed to initialise Clutter\n");
+      exit (1);
+    }
+}
+
+void
+bench_timer_start (BenchTimer  *timer,
+                   const gchar *name,
+                   guint        iterations)
+{
+  timer->name = name;
+  timer->iterations = MAX (iterations, 1);
+  timer->start = g_get_monotonic_time ();
+}
+
+void
+bench_timer_stop (BenchTimer *timer)
+{
+  gint64 elapsed = g_get_monotonic_time () - timer->start;
+
+  g_print ("%s\t%u\t%.3f\n", timer->name, timer->iterations,
+           (gdouble) elapsed / timer->iterations);
+}
+
+void
+bench_report_count (const gchar *name,
+                    guint64      value)
+{
+  g_print ("%s\t%" G_GUINT64_FORMAT "\tcount\n", name, value);
+}
+
+static gint
+compare_frame_times (gconstpointer a,
+                     gconstpointer b)
+{
+  gint64 time_a = *(const gint64 *) a;
+  gint64 time_b = *(const gint64 *) b;
+
+  return (time_a > time_b) - (time_a < time_b);
+}
+
+/* Prints the median, the 90th and 99th percentiles and the longest of
+ * @frame_times, in microseconds; @frame_times is sorted */
+void
+bench_report_frames (const gchar *name,
+                     GArray      *frame_times)
+{
+  static const struct { const gchar *suffix; guint percentile; } ranks[] = {
+    { "p50", 50 }, { "p90", 90 }, { "p99", 99 }, { "max", 100 }
+  };
+  guint i;
+
+  if (!frame_times->len)
+    return;
+
+  g_array_sort (frame_times, compare_frame_times);
+
+  for (i = 0; i < G_N_ELEMENTS (ranks); i++)
+    {
+      guint rank = (frame_times->len - 1) * ranks[i].percentile / 100;
+
+      g_print ("%s.%s\t%u\t%.3f\n", name, ranks[i].suffix, frame_times->len,
+               (gdouble) g_array_index (frame_times, gint64, rank));
+    }
+}
+
+/* The stage is only needed by the benchmarks that paint, as actors have to
+ * be mapped to be painted; what they paint goes to an offscreen buffer
+ * rather than to the stage window, so that the results do not depend on
+ * the window system or on the swap interval. */
+ClutterActor *
+bench_get_stage (void)
+{
+  if (!stage)
+    {
+      stage = clutter_stage_new ();
+      clutter_actor_set_size (stage, BENCH_STAGE_WIDTH, BENCH_STAGE_HEIGHT);
+      clutter_actor_show (stage);
+    }
+
+  return stage;
+}
+
+/* Lays @actor out at the given size right away, rather than when the stage
+ * is next painted. As with any allocation, nothing is done if neither the
+ * size nor the layout of @actor changed. */
+void
+bench_relayout (ClutterActor *actor,
+                gfloat        width,
+                gfloat        height)
+{
+  ClutterActorBox box = { 0, 0, width, height };
+
+  clutter_actor_allocate (actor, &box, CLUTTER_ALLOCATION_NONE);
+}
+
+/* Paints @actor into the offscreen buffer and waits for the rendering to
+ * finish */
+void
+bench_paint (ClutterActor *actor)
+{
+  CoglColor transparent;
+  CoglMatrix matrix;
+  guint8 pixel[4];
+
+  clutter_stage_ensure_current (CLUTTER_STAGE (bench_get_stage ()));
+
+  if (offscreen == COGL_INVALID_HANDLE)
+    {
+      CoglHandle texture;
+
+      texture = cogl_texture_new_with_size (BENCH_STAGE_WIDTH,
+                                            BENCH_STAGE_HEIGHT,
+                                            COGL_TEXTURE_NO_SLICING,
+                                            COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+      offscreen = cogl_offscreen_new_to_texture (texture);
+      cogl_handle_unref (texture);
+
+      if (offscreen == COGL_INVALID_HANDLE)
+        {
+          g_printerr ("Failed to create an offscreen buffer\n");
+          exit (1);
+        }
+    }
+
+  cogl_push_framebuffer (offscreen);
+  cogl_ortho (0, BENCH_STAGE_WIDTH, BENCH_STAGE_HEIGHT, 0, -1, 1);
+
+  cogl_matrix_init_identity (&matrix);
+  cogl_set_modelview_matrix (&matrix);
+
+  cogl_color_set_from_4ub (&transparent, 0, 0, 0, 0);
+  cogl_clear (&transparent, COGL_BUFFER_BIT_COLOR);
+
+  clutter_actor_paint (actor);
+
+  /* reading back a pixel waits for the GPU to be done with the frame */
+  cogl_read_pixels (0, 0, 1, 1, COGL_READ_PIXELS_COLOR_BUFFER,
+                    COGL_PIXEL_FORMAT_RGBA_8888_PRE, pixel);
+
+  cogl_pop_framebuffer ();
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2013 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <mx/mx.h>
+
+/*
+ * Helpers shared by the benchmarks. Each benchmark prints one line per
+ * result on stdout, with tab-separated fields:
+ *
+ *   <benchmark>  <iterations>  <microseconds per iteration>
+ *
+ * and counters, such as cache hits, as:
+ *
+ *   <benchmark>  <value>  count
+ *
+ * Distributions of frame times are printed as one result per percentile,
+ * with the number of frames as the iterations:
+ *
+ *   <benchmark>.p50  <frames>  <microseconds>
+ *
+ * Nothing else is printed on stdout, so that the output of "make bench"
+ * can be compared between runs.
+ */
+
+typedef struct
+{
+  const gchar *name;
+  guint        iterations;
+  gint64       start;
+} BenchTimer;
+
+void          bench_init         (int          *argc,
+                                  char       ***argv);
+
+void          bench_timer_start  (BenchTimer   *timer,
+                                  const gchar  *name,
+                                  guint         iterations);
+void          bench_timer_stop   (BenchTimer   *timer);
+
+void          bench_report_count (const gchar  *name,
+                                  guint64       value);
+void          bench_report_frames (const gchar  *name,
+                                   GArray       *frame_times);
+
+ClutterActor *bench_get_stage    (void);
+void          bench_relayout     (ClutterActor *actor,
+                                  gfloat        width,
+                                  gfloat        height);
+void          bench_paint        (ClutterActor *actor);
+
+/*
+ * The number and size of the memory allocations made so far, for the
+ * benchmarks linked with bench-malloc.c. bench_alloc_get_count() returns
+ * FALSE where they can't be counted.
+ */
+
+typedef struct
+{
+  guint64 n_allocs;
+  guint64 n_bytes;
+} BenchAllocCount;
+
+gboolean      bench_alloc_get_count  (BenchAllocCount *count);
+
+/*
+ * Input events to replay against the stage, either recorded from an
+ * application run with MX_RECORD_EVENTS=<file> or made up by the
+ * benchmarks. They are replayed in real time, as widgets measure the
+ * speed of the pointer with the clock, and the time of each frame is
+ * measured from when its events are delivered until it has been painted.
+ */
+
+typedef struct _BenchEvents BenchEvents;
+
+BenchEvents  *bench_events_new       (void);
+BenchEvents  *bench_events_load      (const gchar  *filename,
+                                      GError      **error);
+void          bench_events_free      (BenchEvents  *events);
+
+void          bench_events_add_drag  (BenchEvents  *events,
+                                      gboolean      touch,
+                                      gfloat        x1,
+                                      gfloat        y1,
+                                      gfloat        x2,
+                                      gfloat        y2,
+                                      guint         duration);
+void          bench_events_add_wheel (BenchEvents  *events,
+                                      gfloat        x,
+                                      gfloat        y,
+                                      gdouble       delta_y,
+                                      guint         n_steps);
+
+void          bench_events_replay    (BenchEvents  *events,
+                                      const gchar  *name,
+                                      guint         settle_frames);
+
+#endif /* _BENCH_H */
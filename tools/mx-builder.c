@@ -19,10 +19,17 @@
  */
 #include <mx/mx.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define MIN_INSPECTOR_WIDTH 300
 #define MIN_TREE_WIDTH 200
 
+/* frames shown in the performance graph, and how often the performance
+ * panel is updated, in milliseconds */
+#define PERF_N_FRAMES 100
+#define PERF_REFRESH_INTERVAL 500
+#define PERF_N_TOP 5
+
 
 
 typedef struct
@@ -33,12 +40,41 @@ typedef struct
   ClutterActor *selected_widget;
   ClutterActor *combobox;
   ClutterActor *status;
+  ClutterActor *cache_stats;
+
+  MxWindow     *window;
+  ClutterActor *perf_panel;
+  ClutterActor *perf_graph;
+  ClutterActor *perf_frame;
+  ClutterActor *perf_widgets;
+  ClutterActor *perf_selectors;
 
   MxButtonGroup *group;
 
   guint  paint_overlay;
+
+  /* the statistics of the last frames, as a ring */
+  MxFrameStats frames[PERF_N_FRAMES];
+  guint        frame_index;
+  guint        n_frames;
+
+  guint  frame_stats_handler;
+  guint  heat_map_handler;
+  guint  perf_refresh_source;
 } MxBuilder;
 
+/* what a widget of the preview cost since the performance panel was
+ * shown; paint times include the children of the widget */
+typedef struct
+{
+  gint64 paint_start;
+  gint64 paint_time;
+  guint  n_paints;
+  guint  n_restyles;
+} MxBuilderWidgetCost;
+
+static const gchar *widget_cost_key = "builder-widget-cost";
+
 static void mx_builder_set_selected_widget (MxBuilder *builder, ClutterActor *widget);
 
 typedef GType (*TypeFunc) ();
@@ -742,6 +778,463 @@ mx_builder_frame_paint (ClutterActor *actor)
       }
 }
 
+static void
+mx_builder_cache_stats_changed (MxTextureCache *cache,
+                                MxBuilder      *builder)
+{
+  MxTextureCacheStats stats;
+  guint n_requests;
+  gchar *text;
+
+  mx_texture_cache_get_stats (cache, &stats);
+  n_requests = stats.hits + stats.misses;
+
+  text = g_strdup_printf ("Texture cache: %u images, %" G_GSIZE_FORMAT
+                          " KiB (atlas %" G_GSIZE_FORMAT " KiB, standalone %"
+                          G_GSIZE_FORMAT " KiB), %u%% hits, "
+                          "%.1f ms decoding %u images",
+                          stats.n_entries, stats.used_bytes / 1024,
+                          stats.atlas_bytes / 1024,
+                          stats.standalone_bytes / 1024,
+                          n_requests ? stats.hits * 100 / n_requests : 0,
+                          stats.decode_time / 1000.0, stats.n_decodes);
+  mx_label_set_text (MX_LABEL (builder->cache_stats), text);
+  g_free (text);
+}
+
+static void
+mx_builder_widget_paint_start (ClutterActor        *widget,
+                               MxBuilderWidgetCost *cost)
+{
+  cost->paint_start = g_get_monotonic_time ();
+}
+
+static void
+mx_builder_widget_paint_end (ClutterActor        *widget,
+                             MxBuilderWidgetCost *cost)
+{
+  if (!cost->paint_start)
+    return;
+
+  cost->paint_time += g_get_monotonic_time () - cost->paint_start;
+  cost->paint_start = 0;
+  cost->n_paints++;
+}
+
+static void
+mx_builder_widget_style_changed (MxStylable          *stylable,
+                                 MxStyleChangedFlags  flags,
+                                 MxBuilderWidgetCost *cost)
+{
+  cost->n_restyles++;
+}
+
+/* Starts measuring the widgets of the preview that aren't measured yet, as
+ * widgets may have been added since the last time, and resets the costs of
+ * the others if @reset is set */
+static void
+mx_builder_track_widgets (ClutterActor *actor,
+                          gboolean      reset)
+{
+  ClutterActorIter iter;
+  ClutterActor *child;
+
+  clutter_actor_iter_init (&iter, actor);
+  while (clutter_actor_iter_next (&iter, &child))
+    {
+      MxBuilderWidgetCost *cost;
+
+      cost = g_object_get_data (G_OBJECT (child), widget_cost_key);
+
+      if (!cost)
+        {
+          cost = g_new0 (MxBuilderWidgetCost, 1);
+          g_object_set_data_full (G_OBJECT (child), widget_cost_key, cost,
+                                  g_free);
+
+          g_signal_connect (child, "paint",
+                            G_CALLBACK (mx_builder_widget_paint_start), cost);
+          g_signal_connect_after (child, "paint",
+                                  G_CALLBACK (mx_builder_widget_paint_end),
+                                  cost);
+          if (MX_IS_STYLABLE (child))
+            g_signal_connect (child, "style-changed",
+                              G_CALLBACK (mx_builder_widget_style_changed),
+                              cost);
+        }
+      else if (reset)
+        memset (cost, 0, sizeof (MxBuilderWidgetCost));
+
+      mx_builder_track_widgets (child, reset);
+    }
+}
+
+static void
+mx_builder_find_costs (ClutterActor *actor,
+                       GPtrArray    *widgets,
+                       gint64       *max_paint_time,
+                       guint        *max_restyles)
+{
+  ClutterActorIter iter;
+  ClutterActor *child;
+
+  clutter_actor_iter_init (&iter, actor);
+  while (clutter_actor_iter_next (&iter, &child))
+    {
+      MxBuilderWidgetCost *cost;
+
+      cost = g_object_get_data (G_OBJECT (child), widget_cost_key);
+
+      if (cost && CLUTTER_ACTOR_IS_MAPPED (child))
+        {
+          g_ptr_array_add (widgets, child);
+          *max_paint_time = MAX (*max_paint_time, cost->paint_time);
+          *max_restyles = MAX (*max_restyles, cost->n_restyles);
+        }
+
+      mx_builder_find_costs (child, widgets, max_paint_time, max_restyles);
+    }
+}
+
+/* Covers each widget of the preview in red as much as it cost to paint,
+ * compared to the most expensive one, and outlines it in yellow as much as
+ * it was restyled */
+static void
+mx_builder_heat_map_paint (ClutterActor *frame,
+                           MxBuilder    *builder)
+{
+  gfloat frame_x, frame_y;
+  gint64 max_paint_time = 0;
+  guint max_restyles = 0;
+  GPtrArray *widgets;
+  guint i;
+
+  widgets = g_ptr_array_new ();
+  mx_builder_find_costs (frame, widgets, &max_paint_time, &max_restyles);
+
+  clutter_actor_get_transformed_position (frame, &frame_x, &frame_y);
+
+  for (i = 0; i < widgets->len; i++)
+    {
+      ClutterActor *widget = g_ptr_array_index (widgets, i);
+      MxBuilderWidgetCost *cost;
+      gfloat x, y, width, height;
+
+      cost = g_object_get_data (G_OBJECT (widget), widget_cost_key);
+
+      clutter_actor_get_transformed_position (widget, &x, &y);
+      clutter_actor_get_transformed_size (widget, &width, &height);
+      x -= frame_x;
+      y -= frame_y;
+
+      if (max_paint_time && cost->paint_time)
+        {
+          cogl_set_source_color4f (0.8, 0, 0,
+                                   0.6 * cost->paint_time / max_paint_time);
+          cogl_rectangle (x, y, x + width, y + height);
+        }
+
+      if (max_restyles && cost->n_restyles)
+        {
+          cogl_set_source_color4f (0.99, 0.91, 0.31,
+                                   (gfloat) cost->n_restyles / max_restyles);
+          cogl_path_rectangle (x + 1, y + 1, x + width - 1, y + height - 1);
+          cogl_path_stroke ();
+        }
+    }
+
+  g_ptr_array_free (widgets, TRUE);
+}
+
+static gint
+mx_builder_compare_paint_time (gconstpointer a,
+                               gconstpointer b)
+{
+  MxBuilderWidgetCost *cost_a, *cost_b;
+
+  cost_a = g_object_get_data (*(GObject **) a, widget_cost_key);
+  cost_b = g_object_get_data (*(GObject **) b, widget_cost_key);
+
+  if (cost_a->paint_time != cost_b->paint_time)
+    return (cost_a->paint_time < cost_b->paint_time) ? 1 : -1;
+
+  return (gint) cost_b->n_restyles - (gint) cost_a->n_restyles;
+}
+
+static void
+mx_builder_frame_stats_cb (MxWindow           *window,
+                           const MxFrameStats *stats,
+                           MxBuilder          *builder)
+{
+  builder->frames[builder->frame_index] = *stats;
+  builder->frame_index = (builder->frame_index + 1) % PERF_N_FRAMES;
+  builder->n_frames = MIN (builder->n_frames + 1, PERF_N_FRAMES);
+}
+
+/* the phases of a frame as stacked in the graph, bottom first */
+static const struct
+{
+  const gchar *name;
+  const gchar *color;
+  guint8       red, green, blue;
+} perf_phases[] = {
+  { "style", "#3465a4", 0x34, 0x65, 0xa4 },
+  { "layout", "#73d216", 0x73, 0xd2, 0x16 },
+  { "paint", "#f57900", 0xf5, 0x79, 0x00 },
+  { "pick", "#75507b", 0x75, 0x50, 0x7b },
+  { "actors", "#edd400", 0xed, 0xd4, 0x00 },
+  { "upload", "#cc0000", 0xcc, 0x00, 0x00 }
+};
+
+static void
+mx_builder_get_phase_times (const MxFrameStats *stats,
+                            gint64             *times)
+{
+  times[0] = stats->style_time;
+  times[1] = stats->layout_time;
+  times[2] = stats->paint_time;
+  times[3] = stats->pick_time;
+  times[4] = stats->actor_manager_time;
+  times[5] = stats->texture_upload_time;
+}
+
+/* Graphs the phase times of the last frames, with the budget of a 60Hz
+ * frame as a line across */
+static void
+mx_builder_perf_graph_paint (ClutterActor *graph,
+                             MxBuilder    *builder)
+{
+  gfloat width, height, bar_width, scale;
+  guint i, j;
+
+  clutter_actor_get_size (graph, &width, &height);
+
+  cogl_set_source_color4ub (0x2e, 0x34, 0x36, 0xff);
+  cogl_rectangle (0, 0, width, height);
+
+  /* the graph goes up to two 60Hz frames */
+  scale = height / (2 * G_USEC_PER_SEC / 60.0);
+  bar_width = width / PERF_N_FRAMES;
+
+  for (i = 0; i < builder->n_frames; i++)
+    {
+      const MxFrameStats *stats;
+      gint64 times[G_N_ELEMENTS (perf_phases)];
+      gfloat x, y;
+
+      /* oldest first */
+      stats = &builder->frames[(builder->frame_index + PERF_N_FRAMES -
+                                builder->n_frames + i) % PERF_N_FRAMES];
+      mx_builder_get_phase_times (stats, times);
+
+      x = i * bar_width;
+      y = height;
+
+      for (j = 0; j < G_N_ELEMENTS (perf_phases) && y > 0; j++)
+        {
+          gfloat bar_height = MIN (times[j] * scale, y);
+
+          cogl_set_source_color4ub (perf_phases[j].red,
+                                    perf_phases[j].green,
+                                    perf_phases[j].blue, 0xff);
+          cogl_rectangle (x, y - bar_height, x + bar_width, y);
+          y -= bar_height;
+        }
+    }
+
+  cogl_set_source_color4ub (0xee, 0xee, 0xec, 0x80);
+  cogl_path_line (0, height / 2, width, height / 2);
+  cogl_path_stroke ();
+}
+
+static void
+mx_builder_perf_update (MxBuilder *builder)
+{
+  gint64 max_paint_time = 0;
+  guint max_restyles = 0;
+  GPtrArray *widgets;
+  GString *text;
+  gchar **selectors;
+  guint i;
+
+  /* the last frame */
+  if (builder->n_frames)
+    {
+      const MxFrameStats *stats;
+      gint64 times[G_N_ELEMENTS (perf_phases)];
+
+      stats = &builder->frames[(builder->frame_index + PERF_N_FRAMES - 1) %
+                               PERF_N_FRAMES];
+      mx_builder_get_phase_times (stats, times);
+
+      text = g_string_new ("<b>Last frame</b>\n");
+      for (i = 0; i < G_N_ELEMENTS (perf_phases); i++)
+        g_string_append_printf (text, "<span color=\"%s\">%s</span> %.2f ms  ",
+                                perf_phases[i].color, perf_phases[i].name,
+                                times[i] / 1000.0);
+      g_string_append_printf (text, "\n%u restyled, %u allocated, "
+                              "%u painted", stats->n_restyled,
+                              stats->n_relayouts, stats->n_painted);
+
+      mx_label_set_text (MX_LABEL (builder->perf_frame), text->str);
+      g_string_free (text, TRUE);
+    }
+
+  /* the most expensive widgets */
+  mx_builder_track_widgets (builder->frame, FALSE);
+
+  widgets = g_ptr_array_new ();
+  mx_builder_find_costs (builder->frame, widgets, &max_paint_time,
+                         &max_restyles);
+  g_ptr_array_sort (widgets, mx_builder_compare_paint_time);
+
+  text = g_string_new ("<b>Most expensive widgets</b>");
+  for (i = 0; i < MIN (widgets->len, PERF_N_TOP); i++)
+    {
+      ClutterActor *widget = g_ptr_array_index (widgets, i);
+      MxBuilderWidgetCost *cost;
+      const gchar *name;
+      gchar *line;
+
+      cost = g_object_get_data (G_OBJECT (widget), widget_cost_key);
+      name = clutter_actor_get_name (widget);
+
+      line = g_markup_printf_escaped ("\n%s%s%s: %.2f ms in %u paints, "
+                                      "%u restyles",
+                                      G_OBJECT_TYPE_NAME (widget),
+                                      name ? "#" : "", name ? name : "",
+                                      cost->paint_time / 1000.0,
+                                      cost->n_paints, cost->n_restyles);
+      g_string_append (text, line);
+      g_free (line);
+    }
+  g_ptr_array_free (widgets, TRUE);
+
+  mx_label_set_text (MX_LABEL (builder->perf_widgets), text->str);
+  g_string_free (text, TRUE);
+
+  /* the most expensive selectors */
+  selectors = mx_style_get_selector_profile (mx_style_get_default (),
+                                             PERF_N_TOP);
+
+  text = g_string_new ("<b>Most expensive selectors</b>");
+  if (!selectors[0])
+    g_string_append (text, "\nRun with MX_DEBUG=css-profile to profile "
+                     "selectors");
+  for (i = 0; selectors[i]; i++)
+    {
+      gchar *escaped = g_markup_escape_text (g_strstrip (selectors[i]), -1);
+
+      g_string_append_printf (text, "\n%s", escaped);
+      g_free (escaped);
+    }
+  g_strfreev (selectors);
+
+  mx_label_set_text (MX_LABEL (builder->perf_selectors), text->str);
+  g_string_free (text, TRUE);
+
+  clutter_actor_queue_redraw (builder->perf_graph);
+  clutter_actor_queue_redraw (builder->frame);
+}
+
+static gboolean
+mx_builder_perf_refresh_cb (gpointer data)
+{
+  mx_builder_perf_update (data);
+
+  return TRUE;
+}
+
+static void
+mx_builder_perf_toggled (MxButton   *button,
+                         GParamSpec *pspec,
+                         MxBuilder  *builder)
+{
+  if (mx_button_get_toggled (button))
+    {
+      builder->n_frames = 0;
+      builder->frame_index = 0;
+      mx_builder_track_widgets (builder->frame, TRUE);
+
+      builder->frame_stats_handler =
+        g_signal_connect (builder->window, "frame-stats",
+                          G_CALLBACK (mx_builder_frame_stats_cb), builder);
+      builder->heat_map_handler =
+        g_signal_connect_after (builder->frame, "paint",
+                                G_CALLBACK (mx_builder_heat_map_paint),
+                                builder);
+      builder->perf_refresh_source =
+        g_timeout_add (PERF_REFRESH_INTERVAL, mx_builder_perf_refresh_cb,
+                       builder);
+
+      mx_builder_perf_update (builder);
+      clutter_actor_show (builder->perf_panel);
+    }
+  else
+    {
+      g_signal_handler_disconnect (builder->window,
+                                   builder->frame_stats_handler);
+      g_signal_handler_disconnect (builder->frame, builder->heat_map_handler);
+      g_source_remove (builder->perf_refresh_source);
+      builder->frame_stats_handler = 0;
+      builder->heat_map_handler = 0;
+      builder->perf_refresh_source = 0;
+
+      clutter_actor_hide (builder->perf_panel);
+      clutter_actor_queue_redraw (builder->frame);
+    }
+}
+
+static ClutterActor *
+mx_builder_create_perf_panel (MxBuilder *builder)
+{
+  ClutterActor **labels[] = { &builder->perf_frame, &builder->perf_widgets,
+                              &builder->perf_selectors };
+  ClutterActor *vbox, *label;
+  GString *legend;
+  guint i;
+
+  vbox = mx_box_layout_new_with_orientation (MX_ORIENTATION_VERTICAL);
+  mx_box_layout_set_spacing (MX_BOX_LAYOUT (vbox), 6);
+  clutter_actor_set_width (vbox, MIN_INSPECTOR_WIDTH);
+
+  label = mx_label_new_with_text ("<b>Performance</b>");
+  mx_label_set_use_markup (MX_LABEL (label), TRUE);
+  clutter_actor_add_child (vbox, label);
+
+  builder->perf_graph = clutter_actor_new ();
+  clutter_actor_set_size (builder->perf_graph, MIN_INSPECTOR_WIDTH, 120);
+  g_signal_connect (builder->perf_graph, "paint",
+                    G_CALLBACK (mx_builder_perf_graph_paint), builder);
+  clutter_actor_add_child (vbox, builder->perf_graph);
+
+  legend = g_string_new (NULL);
+  for (i = 0; i < G_N_ELEMENTS (perf_phases); i++)
+    g_string_append_printf (legend, "<span color=\"%s\">%s</span>  ",
+                            perf_phases[i].color, perf_phases[i].name);
+  label = mx_label_new_with_text (legend->str);
+  mx_label_set_use_markup (MX_LABEL (label), TRUE);
+  clutter_actor_add_child (vbox, label);
+  g_string_free (legend, TRUE);
+
+  for (i = 0; i < G_N_ELEMENTS (labels); i++)
+    {
+      *labels[i] = mx_label_new ();
+      mx_label_set_use_markup (MX_LABEL (*labels[i]), TRUE);
+      mx_label_set_line_wrap (MX_LABEL (*labels[i]), TRUE);
+      clutter_actor_add_child (vbox, *labels[i]);
+    }
+
+  builder->cache_stats = mx_label_new ();
+  mx_label_set_line_wrap (MX_LABEL (builder->cache_stats), TRUE);
+  clutter_actor_add_child (vbox, builder->cache_stats);
+  g_signal_connect (mx_texture_cache_get_default (), "stats-changed",
+                    G_CALLBACK (mx_builder_cache_stats_changed), builder);
+  mx_builder_cache_stats_changed (mx_texture_cache_get_default (), builder);
+
+  return vbox;
+}
+
 static void
 mx_builder_application_activate (GApplication *app,
                                  MxBuilder    *builder)
@@ -773,6 +1266,7 @@ mx_builder_application_activate (GApplication *app,
    mx_toggle_get_type (),
   };
 
+  builder->window = window;
   mx_window_show (window);
 
   mx_window_set_child (window, hbox);
@@ -800,6 +1294,10 @@ mx_builder_application_activate (GApplication *app,
   builder->inspector = mx_box_layout_new_with_orientation (MX_ORIENTATION_VERTICAL);
   clutter_actor_insert_child_at_index (hbox, builder->inspector, 2);
 
+  builder->perf_panel = mx_builder_create_perf_panel (builder);
+  clutter_actor_hide (builder->perf_panel);
+  clutter_actor_insert_child_at_index (hbox, builder->perf_panel, 3);
+
 
   toolbar = mx_window_get_toolbar (window);
   toolbar_hbox = mx_box_layout_new ();
@@ -836,6 +1334,12 @@ mx_builder_application_activate (GApplication *app,
   g_signal_connect_swapped (button, "clicked",
                             G_CALLBACK (mx_builder_save_widgets), builder);
 
+  button = mx_button_new_with_label ("Performance");
+  mx_button_set_is_toggle (MX_BUTTON (button), TRUE);
+  clutter_actor_insert_child_at_index (toolbar_hbox, button, -1);
+  g_signal_connect (button, "notify::toggled",
+                    G_CALLBACK (mx_builder_perf_toggled), builder);
+
   mx_builder_set_selected_widget (builder, builder->frame);
 
   builder->group = mx_button_group_new ();
@@ -0,0 +1,447 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * mx-css-compile: compile style sheets ahead of time
+ *
+ * Every style sheet given on the command line is written out next to its
+ * source (or into --output) with the ".mxcss" suffix, ready for
+ * mx_style_load_from_compiled_file().
+ *
+ * With --atlas, the images referenced from the style sheets, and any other
+ * images given on the command line, are also packed into a single image,
+ * along with a cache file that mx_texture_cache_load_cache() maps to
+ * serve the individual images from it (see mx/mx-texture-cache-file.h).
+ */
+
+#include <mx/mx.h>
+#include <mx/mx-texture-cache-file.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define ATLAS_PADDING 1
+
+typedef struct
+{
+  gchar     *filename;
+  GdkPixbuf *pixbuf;
+  gint       x, y;
+} MxCssCompileImage;
+
+static gchar *output_dir = NULL;
+static gchar *atlas = NULL;
+static gint atlas_width = 1024;
+static gchar **files = NULL;
+
+static GOptionEntry entries[] =
+{
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_dir,
+    "Directory to write the compiled style sheets to", "DIR" },
+  { "atlas", 'a', 0, G_OPTION_ARG_FILENAME, &atlas,
+    "Pack the images into PREFIX.png and PREFIX.cache", "PREFIX" },
+  { "atlas-width", 'w', 0, G_OPTION_ARG_INT, &atlas_width,
+    "Width of the texture atlas (default: 1024)", "WIDTH" },
+  { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &files,
+    NULL, "FILE.css... [IMAGE...]" },
+  { NULL }
+};
+
+static gchar *
+mx_css_compile_absolute_path (const gchar *path)
+{
+  gchar *cwd, *absolute;
+
+  if (g_path_is_absolute (path))
+    return g_strdup (path);
+
+  cwd = g_get_current_dir ();
+  absolute = g_build_filename (cwd, path, NULL);
+  g_free (cwd);
+
+  return absolute;
+}
+
+static void
+mx_css_compile_add_image (GHashTable  *images,
+                          const gchar *filename)
+{
+  gchar *absolute = mx_css_compile_absolute_path (filename);
+
+  if (!g_hash_table_lookup (images, absolute))
+    g_hash_table_insert (images, absolute, absolute);
+  else
+    g_free (absolute);
+}
+
+/* find the images referenced with url() in a style sheet, relative to the
+ * directory of the style sheet, as MxStyle resolves them */
+static void
+mx_css_compile_find_images (const gchar *filename,
+                            GHashTable  *images)
+{
+  GMatchInfo *match_info;
+  GRegex *regex;
+  gchar *contents, *dirname;
+
+  if (!g_file_get_contents (filename, &contents, NULL, NULL))
+    return;
+
+  regex = g_regex_new ("url\\(\\s*['\"]?([^'\")]+?)['\"]?\\s*\\)", 0, 0,
+                       NULL);
+  dirname = g_path_get_dirname (filename);
+
+  g_regex_match (regex, contents, 0, &match_info);
+  while (g_match_info_matches (match_info))
+    {
+      gchar *url, *path;
+
+      url = g_match_info_fetch (match_info, 1);
+
+      /* resources and other URIs can't be packed */
+      if (!strstr (url, "://"))
+        {
+          path = g_build_filename (dirname, url, NULL);
+          if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
+            mx_css_compile_add_image (images, path);
+          else
+            g_printerr ("%s: image '%s' not found\n", filename, url);
+          g_free (path);
+        }
+
+      g_free (url);
+      g_match_info_next (match_info, NULL);
+    }
+
+  g_match_info_free (match_info);
+  g_regex_unref (regex);
+  g_free (dirname);
+  g_free (contents);
+}
+
+static gint
+mx_css_compile_compare_height (gconstpointer a,
+                               gconstpointer b)
+{
+  const MxCssCompileImage *image_a = a;
+  const MxCssCompileImage *image_b = b;
+
+  return gdk_pixbuf_get_height (image_b->pixbuf) -
+    gdk_pixbuf_get_height (image_a->pixbuf);
+}
+
+/* writes the index of the images in the atlas, in the format described in
+ * mx-texture-cache-file.h */
+static gboolean
+mx_css_compile_write_cache (const gchar *cache,
+                            const gchar *png,
+                            gint         width,
+                            gint         height,
+                            GList       *images)
+{
+  MxTextureCacheFileHeader header;
+  MxTextureCacheFilePage page;
+  MxTextureCacheFileEntry *entries;
+  guint32 *buckets;
+  GString *strings;
+  GByteArray *data;
+  GError *error = NULL;
+  guint n_entries, n_buckets, i;
+  gchar *basename;
+  gboolean result;
+  GList *l;
+
+  n_entries = g_list_length (images);
+  n_buckets = MAX (n_entries, 1);
+
+  entries = g_new0 (MxTextureCacheFileEntry, n_entries);
+  buckets = g_new (guint32, n_buckets);
+  for (i = 0; i < n_buckets; i++)
+    buckets[i] = GUINT32_TO_LE (MX_TEXTURE_CACHE_FILE_NONE);
+
+  strings = g_string_new (NULL);
+
+  /* the page is looked up next to the cache file */
+  basename = g_path_get_basename (png);
+  page.path = GUINT32_TO_LE (strings->len);
+  page.width = GUINT32_TO_LE (width);
+  page.height = GUINT32_TO_LE (height);
+  g_string_append_len (strings, basename, strlen (basename) + 1);
+  g_free (basename);
+
+  for (i = 0, l = images; l; l = l->next)
+    {
+      MxCssCompileImage *image = l->data;
+      guint32 hash, bucket;
+      gchar *uri;
+
+      uri = g_filename_to_uri (image->filename, NULL, &error);
+      if (!uri)
+        {
+          g_printerr ("%s\n", error->message);
+          g_clear_error (&error);
+          continue;
+        }
+
+      hash = mx_texture_cache_file_hash (uri);
+      bucket = hash % n_buckets;
+
+      entries[i].uri = GUINT32_TO_LE (strings->len);
+      entries[i].hash = GUINT32_TO_LE (hash);
+      entries[i].next = buckets[bucket];
+      entries[i].page = 0;
+      entries[i].x = GUINT32_TO_LE (image->x);
+      entries[i].y = GUINT32_TO_LE (image->y);
+      entries[i].width = GUINT32_TO_LE (gdk_pixbuf_get_width (image->pixbuf));
+      entries[i].height =
+        GUINT32_TO_LE (gdk_pixbuf_get_height (image->pixbuf));
+      buckets[bucket] = GUINT32_TO_LE (i);
+
+      g_string_append_len (strings, uri, strlen (uri) + 1);
+      g_free (uri);
+      i++;
+    }
+  n_entries = i;
+
+  data = g_byte_array_new ();
+
+  memset (&header, 0, sizeof (header));
+  g_byte_array_append (data, (guint8 *) &header, sizeof (header));
+  g_byte_array_append (data, (guint8 *) &page, sizeof (page));
+  g_byte_array_append (data, (guint8 *) entries,
+                       n_entries * sizeof (MxTextureCacheFileEntry));
+  g_byte_array_append (data, (guint8 *) buckets, n_buckets * sizeof (guint32));
+  g_byte_array_append (data, (guint8 *) strings->str, strings->len);
+
+  memcpy (header.magic, MX_TEXTURE_CACHE_FILE_MAGIC, sizeof (header.magic));
+  header.version = GUINT32_TO_LE (MX_TEXTURE_CACHE_FILE_VERSION);
+  header.n_pages = GUINT32_TO_LE (1);
+  header.n_entries = GUINT32_TO_LE (n_entries);
+  header.n_buckets = GUINT32_TO_LE (n_buckets);
+  header.strings_size = GUINT32_TO_LE (strings->len);
+  header.checksum =
+    GUINT32_TO_LE (mx_texture_cache_file_checksum (data->data + sizeof (header),
+                                                   data->len - sizeof (header)));
+  memcpy (data->data, &header, sizeof (header));
+
+  result = g_file_set_contents (cache, (gchar *) data->data, data->len,
+                                &error);
+  if (!result)
+    {
+      g_printerr ("%s\n", error->message);
+      g_clear_error (&error);
+    }
+
+  g_byte_array_unref (data);
+  g_string_free (strings, TRUE);
+  g_free (buckets);
+  g_free (entries);
+
+  return result;
+}
+
+static gboolean
+mx_css_compile_write_atlas (GHashTable *images)
+{
+  GList *list = NULL, *l;
+  GHashTableIter iter;
+  gpointer filename;
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  gchar *png, *cache;
+  gint x, y, row_height, height;
+  gboolean result = TRUE;
+
+  g_hash_table_iter_init (&iter, images);
+  while (g_hash_table_iter_next (&iter, &filename, NULL))
+    {
+      MxCssCompileImage *image;
+
+      pixbuf = gdk_pixbuf_new_from_file (filename, &error);
+      if (!pixbuf)
+        {
+          g_printerr ("%s\n", error->message);
+          g_clear_error (&error);
+          continue;
+        }
+
+      if (gdk_pixbuf_get_width (pixbuf) > atlas_width)
+        {
+          g_printerr ("%s: wider than the atlas, skipping\n",
+                      (gchar *) filename);
+          g_object_unref (pixbuf);
+          continue;
+        }
+
+      image = g_slice_new0 (MxCssCompileImage);
+      image->filename = filename;
+      image->pixbuf = pixbuf;
+      list = g_list_prepend (list, image);
+    }
+
+  /* pack the images into shelves, tallest first */
+  list = g_list_sort (list, mx_css_compile_compare_height);
+
+  x = y = row_height = 0;
+  for (l = list; l; l = l->next)
+    {
+      MxCssCompileImage *image = l->data;
+      gint width = gdk_pixbuf_get_width (image->pixbuf);
+
+      if (x + width > atlas_width)
+        {
+          x = 0;
+          y += row_height + ATLAS_PADDING;
+          row_height = 0;
+        }
+
+      image->x = x;
+      image->y = y;
+
+      x += width + ATLAS_PADDING;
+      row_height = MAX (row_height, gdk_pixbuf_get_height (image->pixbuf));
+    }
+  height = MAX (y + row_height, 1);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, atlas_width, height);
+  gdk_pixbuf_fill (pixbuf, 0);
+
+  for (l = list; l; l = l->next)
+    {
+      MxCssCompileImage *image = l->data;
+      GdkPixbuf *source = image->pixbuf;
+
+      if (!gdk_pixbuf_get_has_alpha (source))
+        source = gdk_pixbuf_add_alpha (image->pixbuf, FALSE, 0, 0, 0);
+      else
+        g_object_ref (source);
+
+      gdk_pixbuf_copy_area (source, 0, 0,
+                            gdk_pixbuf_get_width (source),
+                            gdk_pixbuf_get_height (source),
+                            pixbuf, image->x, image->y);
+      g_object_unref (source);
+    }
+
+  png = g_strconcat (atlas, ".png", NULL);
+  cache = g_strconcat (atlas, ".cache", NULL);
+
+  if (!gdk_pixbuf_save (pixbuf, png, "png", &error, NULL))
+    {
+      g_printerr ("%s\n", error->message);
+      g_clear_error (&error);
+      result = FALSE;
+      goto out;
+    }
+
+  if (!mx_css_compile_write_cache (cache, png, atlas_width, height, list))
+    result = FALSE;
+
+out:
+  for (l = list; l; l = l->next)
+    {
+      MxCssCompileImage *image = l->data;
+
+      g_object_unref (image->pixbuf);
+      g_slice_free (MxCssCompileImage, image);
+    }
+  g_list_free (list);
+
+  g_object_unref (pixbuf);
+  g_free (png);
+  g_free (cache);
+
+  return result;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GHashTable *images;
+  GError *error = NULL;
+  gint i, status = EXIT_SUCCESS;
+
+  context = g_option_context_new ("- compile style sheets for Mx");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (!files)
+    {
+      gchar *help = g_option_context_get_help (context, TRUE, NULL);
+      g_printerr ("%s", help);
+      g_free (help);
+      return EXIT_FAILURE;
+    }
+
+  g_option_context_free (context);
+
+  images = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  for (i = 0; files[i]; i++)
+    {
+      gchar *output, *basename;
+
+      if (!g_str_has_suffix (files[i], ".css"))
+        {
+          mx_css_compile_add_image (images, files[i]);
+          continue;
+        }
+
+      if (output_dir)
+        {
+          basename = g_path_get_basename (files[i]);
+          output = g_strconcat (output_dir, G_DIR_SEPARATOR_S, basename, NULL);
+          g_free (basename);
+        }
+      else
+        output = g_strdup (files[i]);
+
+      /* replace ".css" with ".mxcss" */
+      output[strlen (output) - 4] = '\0';
+      basename = output;
+      output = g_strconcat (basename, ".mxcss", NULL);
+      g_free (basename);
+
+      if (!mx_style_compile_file (files[i], output, &error))
+        {
+          g_printerr ("%s\n", error->message);
+          g_clear_error (&error);
+          status = EXIT_FAILURE;
+        }
+
+      g_free (output);
+
+      if (atlas)
+        mx_css_compile_find_images (files[i], images);
+    }
+
+  if (atlas && !mx_css_compile_write_atlas (images))
+    status = EXIT_FAILURE;
+
+  g_hash_table_destroy (images);
+
+  return status;
+}